@@ -405,6 +405,53 @@ else()
 endif()
 
 
+#
+# Storage of synapse permanences in Connections: 32 (float, default), 16 or 8 bit fixed point.
+# Smaller types save memory, but quantize the permanences. See htm/algorithms/Connections.hpp
+#
+set(HTM_PERMANENCE_BITS "32" CACHE STRING "Bits per stored synapse permanence: 32, 16 or 8")
+if(NOT "${HTM_PERMANENCE_BITS}" STREQUAL "32")
+	if(NOT "${HTM_PERMANENCE_BITS}" STREQUAL "16" AND NOT "${HTM_PERMANENCE_BITS}" STREQUAL "8")
+		message(FATAL_ERROR "HTM_PERMANENCE_BITS must be 32, 16 or 8, not ${HTM_PERMANENCE_BITS}")
+	endif()
+	list(APPEND COMMON_COMPILER_DEFINITIONS -DNTA_PERMANENCE_BITS=${HTM_PERMANENCE_BITS})
+endif()
+
+#
+# Compile out the ConnectionsEventHandler dispatch in Connections; subscribe() throws then.
+#
+option(HTM_CONNECTIONS_NO_EVENTS "Disable Connections event handlers (Connections::subscribe)" OFF)
+if(HTM_CONNECTIONS_NO_EVENTS)
+	list(APPEND COMMON_COMPILER_DEFINITIONS -DNTA_CONNECTIONS_NO_EVENTS)
+endif()
+
+#
+# Compile out the stage timers and event counters of the algorithms (AlgorithmStats).
+#
+option(HTM_NO_ALGORITHM_STATS "Remove the AlgorithmStats instrumentation of SpatialPooler and TemporalMemory" OFF)
+if(HTM_NO_ALGORITHM_STATS)
+	list(APPEND COMMON_COMPILER_DEFINITIONS -DNTA_NO_ALGORITHM_STATS)
+endif()
+
+
+#
+# The most verbose log level compiled in, the NTA_DEBUG (3), NTA_INFO and NTA_WARN (2)
+# statements of the levels above are removed. See htm/utils/Log.hpp
+#
+set(HTM_LOG_COMPILED_LEVEL "3" CACHE STRING "Most verbose compiled in log level: 0 (None) to 3 (Verbose)")
+if(NOT "${HTM_LOG_COMPILED_LEVEL}" STREQUAL "3")
+	list(APPEND COMMON_COMPILER_DEFINITIONS -DNTA_LOG_COMPILED_LEVEL=${HTM_LOG_COMPILED_LEVEL})
+endif()
+
+#
+# Compile in the NTA_PROFILE_SCOPE timers (htm/utils/Profiler.hpp).
+#
+option(HTM_PROFILE "Enable the NTA_PROFILE_SCOPE instrumentation, read with Profiler::getEntries()" OFF)
+if(HTM_PROFILE)
+	list(APPEND COMMON_COMPILER_DEFINITIONS -DNTA_PROFILE)
+endif()
+
+
 #
 # Provide a string variant of the COMMON_COMPILER_DEFINITIONS list
 #
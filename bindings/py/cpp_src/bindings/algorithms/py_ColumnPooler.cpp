@@ -0,0 +1,253 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * PyBind11 bindings for ColumnPooler class
+ */
+
+#include <bindings/suppress_register.hpp>  //include before pybind11.h
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <htm/algorithms/ColumnPooler.hpp>
+
+namespace py = pybind11;
+using namespace htm;
+
+namespace htm_ext
+{
+  namespace {
+    // Sets the SDR to the indices of a sequence or a numpy array, which need
+    // not be sorted.
+    void setIndices(SDR &sdr, const py::object &indices, const char *name)
+    {
+      const auto array = py::array_t<UInt32, py::array::c_style | py::array::forcecast>::ensure(indices);
+      if( !array ) {
+        throw std::invalid_argument(std::string(name) + " must be a sequence of indices.");
+      }
+      if( array.ndim() > 1 ) {
+        throw std::invalid_argument(std::string(name) + " must be one dimensional.");
+      }
+      const auto data = array.data();
+      SDR_sparse_t sparse(data, data + array.size());
+      if( !std::is_sorted(sparse.begin(), sparse.end()) ) {
+        std::sort(sparse.begin(), sparse.end());
+      }
+      sparse.erase(std::unique(sparse.begin(), sparse.end()), sparse.end());
+      if( !sparse.empty() && sparse.back() >= sdr.size ) {
+        throw std::invalid_argument(std::string(name) + ": index " + std::to_string(sparse.back())
+                                    + " out of range, size " + std::to_string(sdr.size) + ".");
+      }
+      sdr.setSparse(sparse);
+    }
+
+    py::array_t<UInt32> toArray(const std::vector<CellIdx> &cells)
+    {
+      return py::array_t<UInt32>(cells.size(), cells.data());
+    }
+
+    std::vector<CellIdx> cellsOrAll(const py::object &cells, UInt numCells)
+    {
+      std::vector<CellIdx> result;
+      if( cells.is_none() ) {
+        result.resize(numCells);
+        for(CellIdx c = 0u; c < numCells; c++) result[c] = c;
+      }
+      else {
+        const auto array = py::array_t<UInt32, py::array::c_style | py::array::forcecast>::ensure(cells);
+        if( !array ) {
+          throw std::invalid_argument("cells must be a sequence of cell indices.");
+        }
+        result.assign(array.data(), array.data() + array.size());
+      }
+      return result;
+    }
+  }
+
+  void init_ColumnPooler(py::module& m)
+  {
+    py::class_<ColumnPooler> py_ColumnPooler(m, "ColumnPooler",
+R"(The object layer (L2) of a cortical column.  This is the C++ implementation of
+htm.advanced.algorithms.column_pooler.ColumnPooler, with the same parameters and
+methods.  Cells count their lateral support on their own distal segments.)");
+
+    // maxSdrSize and minSdrSize are None for sdrSize, as in the python version.
+    py_ColumnPooler.def(py::init([](UInt inputWidth, const std::vector<UInt> &lateralInputWidths,
+                                    UInt cellCount, UInt sdrSize, bool onlineLearning,
+                                    const py::object &maxSdrSize, const py::object &minSdrSize,
+                                    Permanence synPermProximalInc, Permanence synPermProximalDec,
+                                    Permanence initialProximalPermanence, Int sampleSizeProximal,
+                                    UInt minThresholdProximal, Permanence connectedPermanenceProximal,
+                                    UInt predictedInhibitionThreshold,
+                                    Permanence synPermDistalInc, Permanence synPermDistalDec,
+                                    Permanence initialDistalPermanence, Int sampleSizeDistal,
+                                    UInt activationThresholdDistal, Permanence connectedPermanenceDistal,
+                                    Real inertiaFactor, Int seed) {
+            return new ColumnPooler(inputWidth, lateralInputWidths, cellCount, sdrSize, onlineLearning,
+                                    maxSdrSize.is_none() ? -1 : maxSdrSize.cast<Int>(),
+                                    minSdrSize.is_none() ? -1 : minSdrSize.cast<Int>(),
+                                    synPermProximalInc, synPermProximalDec, initialProximalPermanence,
+                                    sampleSizeProximal, minThresholdProximal, connectedPermanenceProximal,
+                                    predictedInhibitionThreshold,
+                                    synPermDistalInc, synPermDistalDec, initialDistalPermanence,
+                                    sampleSizeDistal, activationThresholdDistal, connectedPermanenceDistal,
+                                    inertiaFactor, seed); }),
+        py::arg("inputWidth"),
+        py::arg("lateralInputWidths") = std::vector<UInt>{},
+        py::arg("cellCount") = 4096u,
+        py::arg("sdrSize") = 40u,
+        py::arg("onlineLearning") = false,
+        py::arg("maxSdrSize") = py::none(),
+        py::arg("minSdrSize") = py::none(),
+        py::arg("synPermProximalInc") = 0.1f,
+        py::arg("synPermProximalDec") = 0.001f,
+        py::arg("initialProximalPermanence") = 0.6f,
+        py::arg("sampleSizeProximal") = 20,
+        py::arg("minThresholdProximal") = 10u,
+        py::arg("connectedPermanenceProximal") = 0.50f,
+        py::arg("predictedInhibitionThreshold") = 20u,
+        py::arg("synPermDistalInc") = 0.1f,
+        py::arg("synPermDistalDec") = 0.001f,
+        py::arg("initialDistalPermanence") = 0.6f,
+        py::arg("sampleSizeDistal") = 20,
+        py::arg("activationThresholdDistal") = 13u,
+        py::arg("connectedPermanenceDistal") = 0.50f,
+        py::arg("inertiaFactor") = 1.0f,
+        py::arg("seed") = 42);
+
+    py_ColumnPooler.def("compute",
+        [](ColumnPooler &self, const py::object &feedforwardInput, const py::sequence &lateralInputs,
+           const py::object &feedforwardGrowthCandidates, bool learn, const py::object &predictedInput)
+        {
+            const auto &widths = self.getLateralInputWidths();
+            if( py::len(lateralInputs) > widths.size() ) {
+                throw std::invalid_argument("Too many lateralInputs.");
+            }
+            SDR feedforward({ self.numberOfInputs() });
+            setIndices(feedforward, feedforwardInput, "feedforwardInput");
+            std::vector<SDR> lateral;
+            for(size_t i = 0u; i < py::len(lateralInputs); i++) {
+                lateral.emplace_back(std::vector<UInt>{ widths[i] });
+                setIndices(lateral.back(), lateralInputs[i], "lateralInputs");
+            }
+            SDR growthCandidates({ self.numberOfInputs() });
+            if( feedforwardGrowthCandidates.is_none() ) {
+                growthCandidates.setSparse(feedforward.getSparse());
+            }
+            else {
+                setIndices(growthCandidates, feedforwardGrowthCandidates, "feedforwardGrowthCandidates");
+            }
+            std::unique_ptr<SDR> predicted;
+            if( !predictedInput.is_none() ) {
+                predicted.reset(new SDR({ self.numberOfInputs() }));
+                setIndices(*predicted, predictedInput, "predictedInput");
+            }
+
+            py::gil_scoped_release release;
+            self.compute(feedforward, lateral, growthCandidates, learn, predicted.get());
+        },
+R"(Runs one time step of the column pooler algorithm.
+
+Argument feedforwardInput, indices of the active feedforward input bits.
+
+Argument lateralInputs, for each lateral input the indices of its active bits.
+
+Argument feedforwardGrowthCandidates, indices of the feedforward input bits
+which active cells may grow new synapses to.  If None, feedforwardInput.
+
+Argument learn, if True we are learning a new object.
+
+Argument predictedInput, indices of the predicted cells of the input layer.)",
+        py::arg("feedforwardInput"),
+        py::arg("lateralInputs") = py::tuple(),
+        py::arg("feedforwardGrowthCandidates") = py::none(),
+        py::arg("learn") = true,
+        py::arg("predictedInput") = py::none());
+
+    py_ColumnPooler.def("getActiveCells", [](const ColumnPooler &self) { return toArray(self.getActiveCells()); },
+        "Returns the sorted indices of the active cells.");
+
+    py_ColumnPooler.def("reset", &ColumnPooler::reset,
+        "Clears the active cells.  When learning, the next compute learns a new object.");
+
+    py_ColumnPooler.def("numberOfInputs", &ColumnPooler::numberOfInputs);
+    py_ColumnPooler.def("numberOfCells", &ColumnPooler::numberOfCells);
+    py_ColumnPooler.def("getUseInertia", &ColumnPooler::getUseInertia);
+    py_ColumnPooler.def("setUseInertia", &ColumnPooler::setUseInertia, py::arg("useInertia"));
+
+    py_ColumnPooler.def("numberOfProximalSynapses",
+        [](const ColumnPooler &self, const py::object &cells) {
+            return cells.is_none() ? self.numberOfProximalSynapses()
+                                   : self.numberOfProximalSynapses(cellsOrAll(cells, self.numberOfCells())); },
+        py::arg("cells") = py::none());
+
+    py_ColumnPooler.def("numberOfConnectedProximalSynapses",
+        [](const ColumnPooler &self, const py::object &cells) {
+            return self.numberOfConnectedProximalSynapses(cellsOrAll(cells, self.numberOfCells())); },
+        py::arg("cells") = py::none());
+
+    py_ColumnPooler.def("numberOfDistalSegments",
+        [](const ColumnPooler &self, const py::object &cells) {
+            return self.numberOfDistalSegments(cellsOrAll(cells, self.numberOfCells())); },
+        py::arg("cells") = py::none());
+
+    py_ColumnPooler.def("numberOfDistalSynapses",
+        [](const ColumnPooler &self, const py::object &cells) {
+            return self.numberOfDistalSynapses(cellsOrAll(cells, self.numberOfCells())); },
+        py::arg("cells") = py::none());
+
+    py_ColumnPooler.def("numberOfConnectedDistalSynapses",
+        [](const ColumnPooler &self, const py::object &cells) {
+            return self.numberOfConnectedDistalSynapses(cellsOrAll(cells, self.numberOfCells())); },
+        py::arg("cells") = py::none());
+
+    // The Connections are copied, as in the python version they are for inspection.
+    py_ColumnPooler.def_property_readonly("proximalPermanences",
+        [](const ColumnPooler &self) { return self.getProximalConnections(); });
+    py_ColumnPooler.def_property_readonly("internalDistalPermanences",
+        [](const ColumnPooler &self) { return self.getInternalDistalConnections(); });
+    py_ColumnPooler.def_property_readonly("distalPermanences",
+        [](const ColumnPooler &self) {
+            std::vector<Connections> distal;
+            for(UInt i = 0u; i < self.getLateralInputWidths().size(); i++) {
+                distal.push_back(self.getLateralDistalConnections(i));
+            }
+            return distal; });
+
+    py_ColumnPooler.def("__eq__", [](const ColumnPooler &self, const ColumnPooler &other) { return self == other; });
+
+    py_ColumnPooler.def(py::pickle(
+        [](const ColumnPooler &self) {   // Save
+            std::stringstream buf;
+            self.save( buf );
+            return py::bytes( buf.str() );
+        },
+        [](const py::bytes &data) {      // Load
+            std::stringstream buf( data.cast<std::string>() );
+            auto pooler = new ColumnPooler();
+            pooler->load( buf );
+            return pooler;
+        } ));
+  }
+} // namespace htm_ext
@@ -30,6 +30,8 @@
 
 #include <htm/algorithms/Connections.hpp>
 
+#include "bindings/engine/py_utils.hpp"
+
 namespace py = pybind11;
 using namespace htm;
 
@@ -40,10 +42,19 @@ namespace htm_ext
     py::class_<Connections> py_Connections(m, "Connections",
 R"(Compatibility Warning: This classes API is unstable and may change without warning.)");
 
-    py_Connections.def(py::init<UInt, Permanence, bool>(),
+    py::enum_<Connections::SegmentPruning>(py_Connections, "SegmentPruning")
+      .value("LRU",    Connections::SegmentPruning::LRU)
+      .value("OLDEST", Connections::SegmentPruning::OLDEST)
+      .value("RANDOM", Connections::SegmentPruning::RANDOM)
+      .export_values();
+
+    py_Connections.def(py::init<UInt, Permanence, bool, Connections::SegmentPruning>(),
         py::arg("numCells"),
         py::arg("connectedThreshold"),
-        py::arg("timeseries") = false);
+        py::arg("timeseries") = false,
+        py::arg("segmentPruning") = Connections::SegmentPruning::LRU);
+
+    py_Connections.def_property_readonly("segmentPruning", &Connections::getSegmentPruning);
 
     py_Connections.def_property_readonly("connectedThreshold", &Connections::getConnectedThreshold);
 
@@ -61,6 +72,12 @@ R"(Compatibility Warning: This classes API is unstable and may change without wa
         py::arg("presynaticCell"),
         py::arg("permanence"));
 
+    py_Connections.def("growSynapses", &Connections::growSynapses,
+        py::arg("segment"),
+        py::arg("candidates"),
+        py::arg("permanence"),
+        py::arg("maxNew"));
+
     py_Connections.def("destroySynapse", &Connections::destroySynapse);
 
     py_Connections.def("updateSynapsePermanence", &Connections::updateSynapsePermanence,
@@ -79,20 +96,67 @@ R"(Compatibility Warning: This classes API is unstable and may change without wa
 
     py_Connections.def("permanenceForSynapse",
         [](Connections &self, Synapse idx) {
-            auto &synData = self.dataForSynapse( idx );
+            const auto synData = self.dataForSynapse( idx );
             return synData.permanence; });
 
     py_Connections.def("presynapticCellForSynapse",
         [](Connections &self, Synapse idx) {
-            auto &synData = self.dataForSynapse( idx );
+            const auto synData = self.dataForSynapse( idx );
             return synData.presynapticCell; });
 
     py_Connections.def("getSegment", &Connections::getSegment);
 
     py_Connections.def("segmentFlatListLength", &Connections::segmentFlatListLength);
 
+    py_Connections.def("compact", &Connections::compact,
+R"(Remove the storage of destroyed segments and synapses. Invalidates all Segment and Synapse handles.)");
+
+    py_Connections.def("defragment", &Connections::defragment,
+R"(Make the segments of each cell and the synapses of each segment contiguous, and remove the storage of destroyed ones.
+Invalidates all Segment and Synapse handles. Returns the new index of each old segment, the max uint32 for destroyed ones.)");
+
     py_Connections.def("synapsesForPresynapticCell", &Connections::synapsesForPresynapticCell);
 
+    py_Connections.def("presynapticAdjacency",
+        [](const Connections &self) {
+            auto offsets      = new std::vector<Synapse>();
+            auto synapses     = new std::vector<Synapse>();
+            auto numConnected = new std::vector<Synapse>();
+            self.presynapticAdjacency(*offsets, *synapses, *numConnected);
+            // Hand the buffers over to numpy, without copying.
+            const auto wrap = [](std::vector<Synapse> *vec) {
+                auto destructor = py::capsule( vec, [](void *dataPtr) {
+                    delete reinterpret_cast<std::vector<Synapse>*>(dataPtr); });
+                return py::array(vec->size(), vec->data(), destructor);
+            };
+            return py::make_tuple(wrap(offsets), wrap(synapses), wrap(numConnected));
+        },
+R"(Returns the synapses of every presynaptic cell as compressed sparse rows, a tuple of numpy arrays:
+    offsets: the synapses of cell c are synapses[offsets[c] : offsets[c+1]]
+    synapses
+    numConnected: the first numConnected[c] synapses of cell c are connected, the rest are potential)");
+
+    py_Connections.def("exportSegments",
+        [](const Connections &self) {
+            std::vector<CellIdx> segmentCells, presynapticCells;
+            std::vector<Synapse> offsets;
+            std::vector<Permanence> permanences;
+            self.exportSegments(segmentCells, offsets, presynapticCells, permanences);
+            return py::make_tuple(py::array(segmentCells.size(), segmentCells.data()),
+                                  py::array(offsets.size(), offsets.data()),
+                                  py::array(presynapticCells.size(), presynapticCells.data()),
+                                  py::array(permanences.size(), permanences.data()));
+        },
+R"(Returns all segments and synapses as compressed sparse rows, a tuple of numpy arrays:
+    segmentCells: the cell of each segment
+    offsets: the synapses of segment i are [offsets[i] : offsets[i+1]] of
+    presynapticCells
+    permanences)");
+
+    py_Connections.def("importSegments", &Connections::importSegments,
+        py::arg("segmentCells"), py::arg("offsets"), py::arg("presynapticCells"), py::arg("permanences"),
+R"(Replaces all segments and synapses by the rows of exportSegments, in bulk.)");
+
     py_Connections.def("reset", &Connections::reset);
 
     py_Connections.def("computeActivity",
@@ -129,6 +193,22 @@ R"(Returns pair of:
     numActiveConnectedSynapsesForSegment
     numActivePotentialSynapsesForSegment)");
 
+    py_Connections.def("setCompactPresynapticIndex", &Connections::setCompactPresynapticIndex,
+R"(Enable the compacted (CSR) presynaptic index, which speeds up computeActivity
+when the connections do not change between compute cycles.)");
+
+    py_Connections.def("getCompactPresynapticIndex", &Connections::getCompactPresynapticIndex);
+
+    py_Connections.def("setNumThreads", &Connections::setNumThreads,
+R"(Number of threads used by computeActivity, including the calling thread. 0 means all hardware threads.)");
+
+    py_Connections.def("getNumThreads", &Connections::getNumThreads);
+
+    py_Connections.def("setIncrementalActivity", &Connections::setIncrementalActivity,
+R"(Compute the activity incrementally from the change of the active cells, while the synapses do not change.)");
+
+    py_Connections.def("getIncrementalActivity", &Connections::getIncrementalActivity);
+
     py_Connections.def("adaptSegment", &Connections::adaptSegment,
       py::arg("segment"),
       py::arg("inputs"),
@@ -138,6 +218,17 @@ R"(Returns pair of:
       py::arg("segmentThreshold") = 0
 		    );
 
+    py_Connections.def("adaptSegments",
+      (void (Connections::*)(const std::vector<Segment>&, const SDR&, const Permanence, const Permanence, const bool, const UInt))
+        &Connections::adaptSegments,
+      py::arg("segments"),
+      py::arg("inputs"),
+      py::arg("increment"),
+      py::arg("decrement"),
+      py::arg("pruneZeroSynapses") = false,
+      py::arg("segmentThreshold") = 0
+		    );
+
     py_Connections.def("raisePermanencesToThreshold", &Connections::raisePermanencesToThreshold);
 
     py_Connections.def("synapseCompetition", &Connections::synapseCompetition);
@@ -182,6 +273,24 @@ R"(Returns pair of:
             return C;
         } ));
 
+    // pickle protocol 5, with the flat archive as out-of-band buffer, @see reduce_ex
+    py_Connections.def("__reduce_ex__",
+        [](const py::object &self, int protocol) {
+            const Connections &C = self.cast<const Connections &>();
+            return reduce_ex( self, protocol, [&C](std::vector<char> &buffer) {
+                FlatWriter out( buffer, "HTMCONNS", Connections::FLAT_VERSION );
+                C.saveFlat( out );
+            }); });
+
+    py_Connections.def_static("_fromBuffer",
+        [](const py::buffer &buffer) {
+            const BufferBytes bytes( buffer );
+            auto C = new Connections();
+            py::gil_scoped_release release;
+            FlatReader in( bytes.data(), bytes.size(), "HTMCONNS", Connections::FLAT_VERSION );
+            C->loadFlat( in );
+            return C; } );
+
     py_Connections.def("save",
         [](const Connections &self) {
             std::stringstream buf;
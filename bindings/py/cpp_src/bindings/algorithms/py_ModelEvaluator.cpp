@@ -0,0 +1,160 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * PyBind11 bindings for ModelEvaluator class
+ */
+
+#include <bindings/suppress_register.hpp>  //include before pybind11.h
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+
+#include <stdexcept>
+
+#include <htm/algorithms/ModelEvaluator.hpp>
+
+#include "bindings/engine/py_utils.hpp"
+
+namespace py = pybind11;
+using namespace htm;
+
+namespace htm_ext
+{
+  namespace {
+    // A list of SDRs, or a batch (@see from_batch) of the given dimensions.
+    std::vector<SDR> toRecords(const py::object &inputs, const py::object &dimensions)
+    {
+      if( dimensions.is_none() ) {
+        return inputs.cast<std::vector<SDR>>();
+      }
+      return from_batch(inputs, dimensions.cast<std::vector<UInt>>());
+    }
+
+    template<typename T>
+    std::vector<T> optionalVector(const py::object &values)
+    {
+      return values.is_none() ? std::vector<T>{} : values.cast<std::vector<T>>();
+    }
+
+    // A SpatialPooler, a TemporalMemory, or a tuple (SpatialPooler or None, TemporalMemory or None).
+    ModelEvaluator::Model toModel(const py::handle &model)
+    {
+      if( py::isinstance<SpatialPooler>(model) ) {
+        return ModelEvaluator::Model(model.cast<SpatialPooler*>(), nullptr);
+      }
+      if( py::isinstance<TemporalMemory>(model) ) {
+        return ModelEvaluator::Model(nullptr, model.cast<TemporalMemory*>());
+      }
+      if( py::isinstance<py::tuple>(model) and py::len(model) == 2u ) {
+        const auto pair = model.cast<py::tuple>();
+        return ModelEvaluator::Model(pair[0].is_none() ? nullptr : pair[0].cast<SpatialPooler*>(),
+                                     pair[1].is_none() ? nullptr : pair[1].cast<TemporalMemory*>());
+      }
+      throw std::invalid_argument("A model is a SpatialPooler, a TemporalMemory, or a tuple (sp, tm).");
+    }
+  }
+
+  void init_ModelEvaluator(py::module& m)
+  {
+    py::class_<ModelEvaluator> py_Evaluator(m, "ModelEvaluator",
+R"(Trains and scores many models on one dataset in parallel, eg. for parameter
+searches.  The dataset is encoded once and shared by all models, each model runs
+on its own thread without the GIL.
+
+A model is a SpatialPooler, a TemporalMemory, or a tuple (SpatialPooler,
+TemporalMemory) where the TM learns the SP output.  Each model is trained on the
+training data, then scored on the test data, or on the last training pass
+without test data:
+  anomaly  - the mean anomaly of the TM, 0 without TM.
+  accuracy - the fraction of correctly classified test records, by an
+             SDRClassifier trained on the model output.  0 without labels.
+
+Example Usage:
+    evaluator = ModelEvaluator()
+    evaluator.setTrainingData( trainImages, trainLabels )
+    evaluator.setTestData( testImages, testLabels )
+    models = [ SpatialPooler( **params ) for params in parameterSets ]
+    scores = [ s.accuracy for s in evaluator.evaluate( models ) ])");
+
+    py::class_<ModelEvaluator::Score>(py_Evaluator, "Score")
+      .def_readonly("anomaly", &ModelEvaluator::Score::anomaly)
+      .def_readonly("accuracy", &ModelEvaluator::Score::accuracy)
+      .def("__repr__", [](const ModelEvaluator::Score &self) {
+          return "Score(anomaly=" + std::to_string(self.anomaly)
+                 + ", accuracy=" + std::to_string(self.accuracy) + ")"; });
+
+    py_Evaluator.def(py::init<UInt>(),
+        py::arg("numThreads") = 0u,
+        "Argument numThreads is the number of models evaluated at once, 0 for one per core.");
+
+    const char *setDataDoc =
+R"(Sets (copies) a dataset.
+
+Argument inputs, a list of SDRs, or with dimensions a batch of records: either a
+2D array with one dense record per row, or a tuple (offsets, indices) of the
+sparse records.
+
+Argument labels, optional, the category of each record.
+
+Argument resets, optional, True for the records which start a new sequence.
+
+Argument dimensions, the dimensions of the records of a batch.)";
+
+    py_Evaluator.def("setTrainingData",
+        [](ModelEvaluator &self, const py::object &inputs, const py::object &labels,
+           const py::object &resets, const py::object &dimensions) {
+            self.setTrainingData(toRecords(inputs, dimensions),
+                                 optionalVector<UInt>(labels), optionalVector<bool>(resets)); },
+        setDataDoc,
+        py::arg("inputs"),
+        py::arg("labels") = py::none(),
+        py::arg("resets") = py::none(),
+        py::arg("dimensions") = py::none());
+
+    py_Evaluator.def("setTestData",
+        [](ModelEvaluator &self, const py::object &inputs, const py::object &labels,
+           const py::object &resets, const py::object &dimensions) {
+            self.setTestData(toRecords(inputs, dimensions),
+                             optionalVector<UInt>(labels), optionalVector<bool>(resets)); },
+        setDataDoc,
+        py::arg("inputs"),
+        py::arg("labels") = py::none(),
+        py::arg("resets") = py::none(),
+        py::arg("dimensions") = py::none());
+
+    py_Evaluator.def_property_readonly("trainingSize", &ModelEvaluator::trainingSize);
+    py_Evaluator.def_property_readonly("testSize", &ModelEvaluator::testSize);
+
+    py_Evaluator.def("evaluate",
+        [](ModelEvaluator &self, const py::iterable &models, UInt epochs) {
+            std::vector<ModelEvaluator::Model> all;
+            for( const auto &model : models ) {
+                all.push_back( toModel(model) );
+            }
+            // The python objects of the models are kept alive by the argument.
+            py::gil_scoped_release release;
+            return self.evaluate(all, epochs);
+        },
+R"(Trains and scores the models in parallel, returns one Score per model.
+The models must be distinct objects, they are modified by the training.
+
+Argument epochs, the number of passes over the training data.)",
+        py::arg("models"),
+        py::arg("epochs") = 1u);
+  }
+} // namespace htm_ext
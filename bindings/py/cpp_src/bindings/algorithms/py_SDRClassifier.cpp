@@ -25,6 +25,7 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include <htm/algorithms/KNNClassifier.hpp>
 #include <htm/algorithms/SDRClassifier.hpp>
 
 namespace htm_ext
@@ -89,7 +90,7 @@ Returns the Probablility Distribution Function (PDF) of the categories.
 The PDF is a list of probablilities which sums to 1.  Each index in this list is
 a category label, and each value is the likelihood of the that category.
 Use "numpy.argmax" to find the category with the greatest probablility.)",
-
+            py::call_guard<py::gil_scoped_release>(),
             py::arg("pattern"));
 
         py_Classifier.def("learn", &Classifier::learn,
@@ -99,11 +100,13 @@ Argument pattern is the SDR containing the active input bits.
 
 Argument classification is the current category or bucket index.
 This may also be a list for when the input has multiple categories.)",
+                py::call_guard<py::gil_scoped_release>(),
                 py::arg("pattern"),
                 py::arg("classification"));
 
         py_Classifier.def("learn", [](Classifier &self, const SDR &pattern, UInt categoryIdx)
             { self.learn( pattern, {categoryIdx} ); },
+                py::call_guard<py::gil_scoped_release>(),
                 py::arg("pattern"),
                 py::arg("classification"));
 
@@ -166,6 +169,7 @@ Argument pattern is the SDR containing the active input bits.
 
 Returns a dictionary whos keys are prediction steps, and values are PDFs.
 See help(Classifier.infer) for details about PDFs.)",
+            py::call_guard<py::gil_scoped_release>(),
             py::arg("pattern"));
 
         py_Predictor.def("learn", &Predictor::learn,
@@ -178,16 +182,69 @@ Argument pattern is the SDR containing the active input bits.
 
 Argument classification is the current category or bucket index.
 This may also be a list for when the input has multiple categories.)",
+            py::call_guard<py::gil_scoped_release>(),
             py::arg("recordNum"),
             py::arg("pattern"),
             py::arg("classification"));
 
         py_Predictor.def("learn", [](Predictor &self, UInt recordNum, const SDR &pattern, UInt categoryIdx)
             { self.learn( recordNum, pattern, {categoryIdx} ); },
+                py::call_guard<py::gil_scoped_release>(),
                 py::arg("recordNum"),
                 py::arg("pattern"),
                 py::arg("classification"));
 
         // TODO: Pickle support
+
+
+        py::class_<KNNClassifier> py_KNNClassifier(m, "KNNClassifier",
+R"(The KNN Classifier stores labeled SDRs and classifies a pattern by the votes
+of the k stored SDRs with the largest overlap with it.  The stored SDRs are
+kept in an inverted index, so inference only touches the stored SDRs which
+share an active bit with the pattern.
+
+Example Usage:
+    knn = KNNClassifier( k = 3 )
+    knn.learn( patternA, 0 )
+    knn.learn( patternB, 1 )
+    numpy.argmax( knn.infer( noisyPatternA ) )  ->  0)");
+
+        py_KNNClassifier.def(py::init<UInt, UInt, UInt, UInt>(),
+R"(Argument k is the number of neighbours which vote.
+Argument numBands is the number of MinHash bands for approximate inference,
+0 for exact inference.
+Argument rowsPerBand is the number of min-hashes per band.
+Argument minOverlap is the minimum overlap of a neighbour with the pattern.)",
+            py::arg("k") = 1u,
+            py::arg("numBands") = 0u,
+            py::arg("rowsPerBand") = 4u,
+            py::arg("minOverlap") = 1u);
+
+        py_KNNClassifier.def("learn", &KNNClassifier::learn,
+R"(Store the pattern with its category.)",
+            py::call_guard<py::gil_scoped_release>(),
+            py::arg("pattern"),
+            py::arg("classification"));
+
+        py_KNNClassifier.def("infer", [](const KNNClassifier &self, const SDR &pattern)
+            { return self.infer( pattern ); },
+R"(The votes of the nearest neighbours per category, normalized to sum to 1.)",
+            py::call_guard<py::gil_scoped_release>(),
+            py::arg("pattern"));
+
+        py_KNNClassifier.def("infer", [](const KNNClassifier &self, const vector<SDR> &patterns)
+            { vector<PDF> pdfs; self.infer( patterns, pdfs ); return pdfs; },
+R"(infer() of a list of patterns, returns a list of PDFs.)",
+            py::call_guard<py::gil_scoped_release>(),
+            py::arg("patterns"));
+
+        py_KNNClassifier.def("getNeighbors", &KNNClassifier::getNeighbors,
+R"(The nearest neighbours of the pattern: a list of (pattern index, overlap).)",
+            py::arg("pattern"));
+
+        py_KNNClassifier.def("getCategory", &KNNClassifier::getCategory);
+        py_KNNClassifier.def_property_readonly("numPatterns", &KNNClassifier::numPatterns);
+        py_KNNClassifier.def_property("exact", &KNNClassifier::getExact, &KNNClassifier::setExact,
+            "Use exact inference even if numBands > 0.");
     }
 } // namespace htm_ext
@@ -30,6 +30,7 @@ PyBind11 bindings for SpatialPooler class
 #include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
+#include <htm/algorithms/EdgeExporter.hpp>
 #include <htm/algorithms/SpatialPooler.hpp>
 #include <htm/types/Sdr.hpp>
 
@@ -233,6 +234,32 @@ Argument wrapAround boolean value that determines whether or not inputs
         py_SpatialPooler.def("setSpVerbosity", &SpatialPooler::setSpVerbosity);
         py_SpatialPooler.def("getWrapAround", &SpatialPooler::getWrapAround);
         py_SpatialPooler.def("setWrapAround", &SpatialPooler::setWrapAround);
+        py_SpatialPooler.def("setNumThreads", &SpatialPooler::setNumThreads,
+R"(Number of threads used by compute for the overlaps, including the calling thread.
+0 means all hardware threads. Results are identical to the single threaded SP.)");
+        py_SpatialPooler.def("getNumThreads", &SpatialPooler::getNumThreads);
+        py_SpatialPooler.def("setImplicitPotential", &SpatialPooler::setImplicitPotential, py::arg("floor"),
+R"(Memory-lean mode: only the synapses of permanence >= floor are stored, the
+potential pools are regenerated from (seed, column) when learning needs them.
+Only before the SP learns, it replaces the potential pools and permanences.)");
+        py_SpatialPooler.def("getImplicitPotential", &SpatialPooler::getImplicitPotential);
+        py_SpatialPooler.def("exportSynapses",
+            [](const SpatialPooler &self) {
+                vector<CellIdx> segmentCells, presynapticCells;
+                vector<Synapse> offsets;
+                vector<Permanence> permanences;
+                self.exportSynapses(segmentCells, offsets, presynapticCells, permanences);
+                return py::make_tuple(py::array(segmentCells.size(), segmentCells.data()),
+                                      py::array(offsets.size(), offsets.data()),
+                                      py::array(presynapticCells.size(), presynapticCells.data()),
+                                      py::array(permanences.size(), permanences.data()));
+            },
+R"(Returns the synapses of all columns as compressed sparse rows, a tuple of numpy
+arrays (segmentCells, offsets, presynapticCells, permanences), @see
+Connections.exportSegments.)");
+        py_SpatialPooler.def("importSynapses", &SpatialPooler::importSynapses,
+            py::arg("segmentCells"), py::arg("offsets"), py::arg("presynapticCells"), py::arg("permanences"),
+R"(Replaces the synapses of all columns by the rows of exportSynapses, in bulk.)");
         py_SpatialPooler.def("getUpdatePeriod", &SpatialPooler::getUpdatePeriod);
         py_SpatialPooler.def("setUpdatePeriod", &SpatialPooler::setUpdatePeriod);
         py_SpatialPooler.def("getSynPermActiveInc", &SpatialPooler::getSynPermActiveInc);
@@ -276,7 +303,11 @@ Argument wrapAround boolean value that determines whether or not inputs
         // compute
         py_SpatialPooler.def("compute", [](SpatialPooler& self, const SDR& input, const bool learn, SDR& output)
             { 
-	      const auto& overlaps = self.compute( input, learn, output ); 
+	      std::vector<SynapseIdx> overlaps;
+	      {
+	        py::gil_scoped_release release;
+	        overlaps = self.compute( input, learn, output );
+	      }
 	      return py::array_t<SynapseIdx>( overlaps.size(), overlaps.data());  
 	    },
 R"(
@@ -307,6 +338,41 @@ Argument output An SDR representing the winning columns after
         py::arg("output")
         ); 
 
+        py_SpatialPooler.def("computeBatch", [](SpatialPooler& self, const py::object& inputs, const bool learn)
+            {
+              auto batch = from_batch( inputs, self.getInputDimensions() );
+              std::vector<SDR> outputs;
+              {
+                py::gil_scoped_release release;
+                if( learn ) {
+                  outputs.resize( batch.size() );
+                  for( size_t i = 0u; i < batch.size(); i++ ) {
+                    outputs[i].initialize( self.getColumnDimensions() );
+                    self.compute( batch[i], true, outputs[i] );
+                  }
+                }
+                else {
+                  self.compute( batch, outputs );
+                }
+              }
+              return to_sparse_batch( outputs );
+            },
+R"(
+Runs compute over a batch of inputs in one call, without a python SDR per
+record.  The result is the same as calling compute for each input in order.
+
+Argument inputs Either a 2D NumPy array with one row of dense input per
+        record, or the tuple (offsets, indices) of NumPy arrays, where the
+        active input bits of record i are indices[offsets[i] : offsets[i + 1]].
+
+Argument learn Whether learning is performed for each record.
+
+Returns the tuple (offsets, indices) of NumPy arrays with the active columns
+        of each record.
+)",
+        py::arg("inputs"),
+        py::arg("learn") = false);
+
         // setBoostFactors
         py_SpatialPooler.def("setBoostFactors", [](SpatialPooler& self, py::array& x)
         {
@@ -462,7 +528,31 @@ Argument output An SDR representing the winning columns after
 	    */
             return sp;
         }));
-				
 
+        // pickle protocol 5, with the flat archive as out-of-band buffer, @see reduce_ex
+        py_SpatialPooler.def("__reduce_ex__", [](const py::object &self, int protocol) {
+            const SpatialPooler &sp = self.cast<const SpatialPooler &>();
+            return reduce_ex(self, protocol, [&sp](std::vector<char> &buffer) {
+                FlatWriter out(buffer, "HTMSPOOL", SpatialPooler::FLAT_VERSION);
+                sp.saveFlat(out);
+            });
+        });
+        py_SpatialPooler.def_static("_fromBuffer", [](const py::buffer &buffer) {
+            const BufferBytes bytes(buffer);
+            std::unique_ptr<SpatialPooler> sp(new SpatialPooler());
+            py::gil_scoped_release release;
+            FlatReader in(bytes.data(), bytes.size(), "HTMSPOOL", SpatialPooler::FLAT_VERSION);
+            sp->loadFlat(in);
+            return sp;
+        });
+
+        // After the TemporalMemory and the Classifier, @see algorithm_module.cpp
+        m.def("exportEdgeModel",
+            [](const std::string &path, const SpatialPooler *sp, const TemporalMemory *tm, const Classifier *classifier) {
+                EdgeExporter(sp, tm, classifier).save(path);
+            },
+            py::arg("path"), py::arg("sp") = nullptr, py::arg("tm") = nullptr, py::arg("classifier") = nullptr,
+R"(Exports the trained sp -> tm -> classifier pipeline (any may be None) for the
+embeddable inference runtime, see htm/edge/EdgeRuntime.hpp.)");
     }
 } // namespace htm_ext
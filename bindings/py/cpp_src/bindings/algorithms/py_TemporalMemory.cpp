@@ -168,6 +168,17 @@ Argument anomalyMode (optional, default ANMode::RAW) selects mode for `TM.anomal
     py_HTM.def("getMaxSynapsesPerSegment", &TemporalMemory::getMaxSynapsesPerSegment);
     py_HTM.def("getCheckInputs", &TemporalMemory::getCheckInputs);
 
+    py_HTM.def("setNumThreads", &TemporalMemory::setNumThreads,
+R"(Number of threads used by compute, including the calling thread. 0 means all hardware threads.
+Results are identical to the single threaded TM.)");
+    py_HTM.def("getNumThreads", &TemporalMemory::getNumThreads);
+
+    py_HTM.def("setSeparateExternalConnections", &TemporalMemory::setSeparateExternalConnections,
+R"(Keep the synapses to the external predictive inputs in a second Connections
+(TM.externalConnections), so that each presynaptic index holds only its own inputs.
+Must be set before the TM grew any synapses.)");
+    py_HTM.def("getSeparateExternalConnections", &TemporalMemory::getSeparateExternalConnections);
+
         py_HTM.def("printParameters",
             [](const HTM_t& self)
                 { self.printParameters( std::cout ); },
@@ -229,6 +240,27 @@ Argument anomalyMode (optional, default ANMode::RAW) selects mode for `TM.anomal
         }
         ));
 
+        // pickle protocol 5, with the binary archive as out-of-band buffer, @see reduce_ex
+        py_HTM.def("__reduce_ex__", [](const py::object &self, int protocol)
+        {
+            const HTM_t &tm = self.cast<const HTM_t &>();
+            return reduce_ex(self, protocol, [&tm](std::vector<char> &buffer) {
+                VectorStreamBuf buf(buffer);
+                std::ostream os(&buf);
+                tm.save(os);
+            });
+        });
+        py_HTM.def_static("_fromBuffer", [](const py::buffer &buffer)
+        {
+            const BufferBytes bytes(buffer);
+            std::unique_ptr<TemporalMemory> tm(new TemporalMemory());
+            py::gil_scoped_release release;
+            MemoryStreamBuf buf(bytes.data(), bytes.size());
+            std::istream is(&buf);
+            tm->load(is);
+            return tm;
+        });
+
 
         py_HTM.def("activateCells", [](HTM_t& self, const SDR& activeColumns, bool learn)
         {
@@ -236,10 +268,116 @@ Argument anomalyMode (optional, default ANMode::RAW) selects mode for `TM.anomal
         },
 R"(Calculate the active cells, using the current active columns and
 dendrite segments.  Grow and reinforce synapses.)"
+            , py::call_guard<py::gil_scoped_release>()
             , py::arg("activeColumns"), py::arg("learn") = true);
 
+        py::class_<TMState> py_TMState(m, "TMState",
+R"(Cell state of one input stream, held outside of the TemporalMemory. See TemporalMemory.computeBatch.)");
+        py_TMState.def(py::init<>());
+        py_TMState.def_readwrite("activeCells", &TMState::activeCells);
+        py_TMState.def_readwrite("winnerCells", &TMState::winnerCells);
+        py_TMState.def_readwrite("anomaly",     &TMState::anomaly);
+
+        py::class_<TMStateSnapshot, TMState> py_TMStateSnapshot(m, "TMStateSnapshot",
+R"(Activity state of a TemporalMemory without its connections. See TemporalMemory.snapshot.)");
+        py_TMStateSnapshot.def(py::init<>());
+        py_TMStateSnapshot.def_readonly("segmentsValid", &TMStateSnapshot::segmentsValid);
+
+        py_HTM.def("snapshot", &HTM_t::snapshot,
+R"(Capture the activity state for what-if inference. Run speculative compute(learn=False)
+steps, then restore(snapshot) to continue with the live model. Connections are not copied.)");
+        py_HTM.def("restore", &HTM_t::restore, py::arg("snapshot"));
+
+        py_HTM.def("computeBatch", [](HTM_t& self, const std::vector<SDR> &activeColumns, std::vector<TMState> states)
+            {
+                {
+                    py::gil_scoped_release release;
+                    self.computeBatch(activeColumns, states);
+                }
+                return states;
+            },
+R"(Inference (learn=false) over many independent input streams sharing this TM.
+Runs compute(activeColumns[i], False) on the cell state states[i], the TM's own
+state is left unchanged. Returns the updated states.)",
+                py::arg("activeColumns"),
+                py::arg("states"));
+
+        // The optional reset flags of a batch, one per record.
+        const auto resetFlags = [](const py::object &resets, size_t size)
+            {
+                std::vector<bool> resetBefore( size, false );
+                if( !resets.is_none() ) {
+                    const auto flags = resets.cast<py::array_t<bool, py::array::c_style | py::array::forcecast>>();
+                    if( static_cast<size_t>(flags.size()) != size )
+                        {throw std::invalid_argument("resets must have one flag per record.");}
+                    std::copy( flags.data(), flags.data() + flags.size(), resetBefore.begin() );
+                }
+                return resetBefore;
+            };
+
+        py_HTM.def("run", [resetFlags](HTM_t& self, const py::object &activeColumns, bool learn, const py::object &resets)
+            {
+                auto batch = from_batch( activeColumns, self.getColumnDimensions() );
+                const auto resetBefore = resetFlags( resets, batch.size() );
+                auto dims = self.getColumnDimensions();
+                dims.push_back( static_cast<UInt32>(self.getCellsPerColumn()) );
+
+                std::vector<SDR> cells( batch.size() );
+                py::array_t<Real> anomaly( batch.size() );
+                Real *anomalyData = anomaly.mutable_data();
+                {
+                    py::gil_scoped_release release;
+                    for( size_t i = 0u; i < batch.size(); i++ ) {
+                        if( resetBefore[i] ) {
+                            self.reset();
+                        }
+                        self.compute( batch[i], learn );
+                        cells[i].initialize( dims );
+                        self.getActiveCells( cells[i] );
+                        anomalyData[i] = self.anomaly;
+                    }
+                }
+                const auto active = to_sparse_batch( cells );
+                return py::make_tuple( active.first, active.second, anomaly );
+            },
+R"(Runs compute over a sequence of records in one call, without a python SDR per
+record.
+
+Argument activeColumns is either a 2D NumPy array with one row of dense active
+    columns per record, or the tuple (offsets, indices) of NumPy arrays, where
+    the active columns of record i are indices[offsets[i] : offsets[i + 1]].
+
+Argument learn Whether or not learning is enabled.
+
+Argument resets (optional) Array of one flag per record; the TM is reset before
+    each flagged record, ie. at the start of each sequence.
+
+Returns the tuple (offsets, indices, anomaly): the active cells of each record
+    as a sparse batch, and the anomaly of each record.)",
+                py::arg("activeColumns"),
+                py::arg("learn") = true,
+                py::arg("resets") = py::none());
+
+        py_HTM.def("learnSequences", [resetFlags](HTM_t& self, const py::object &activeColumns, const py::object &resets)
+            {
+                const auto batch = from_batch( activeColumns, self.getColumnDimensions() );
+                const auto resetBefore = resetFlags( resets, batch.size() );
+                py::gil_scoped_release release;
+                self.learnSequences( batch, resetBefore );
+            },
+R"(Offline training: learns the same as compute(x, True) for each record, but
+skips the anomaly and the output of each record. TM.anomaly is -1 afterwards.
+
+Argument activeColumns is a batch of records, in the forms of run().
+
+Argument resets (optional) Array of one flag per record; the TM is reset before
+    each flagged record, ie. at the start of each sequence.)",
+                py::arg("activeColumns"),
+                py::arg("resets") = py::none());
+
         py_HTM.def("compute", [](HTM_t& self, const SDR &activeColumns, bool learn)
             { self.compute(activeColumns, learn); },
+                py::call_guard<py::gil_scoped_release>(),
                 py::arg("activeColumns"),
                 py::arg("learn") = true);
 
@@ -267,11 +405,16 @@ Argument externalPredictiveInputsWinners
     inputs are considered active.
     externalPredictiveInputsWinners must be a subset of externalPredictiveInputsActive.
 )",
+                py::call_guard<py::gil_scoped_release>(),
                 py::arg("activeColumns"),
                 py::arg("learn") = true,
                 py::arg("externalPredictiveInputsActive"),
                 py::arg("externalPredictiveInputsWinners"));
 
+        py_HTM.def("fork", &HTM_t::fork,
+R"(A copy of this TM for evaluating a variant, eg. another permanenceIncrement.
+The synapses are shared until either TM changes them, so forking a large model is cheap.)");
+
         py_HTM.def("reset", &HTM_t::reset,
 R"(Indicates the start of a new sequence.
 Resets sequence state of the TM.)");
@@ -289,6 +432,7 @@ Resets sequence state of the TM.)");
             SDR externalPredictiveInputs({ self.externalPredictiveInputs });
             self.activateDendrites(learn, externalPredictiveInputs, externalPredictiveInputs);
         },
+            py::call_guard<py::gil_scoped_release>(),
             py::arg("learn"));
 
         py_HTM.def("activateDendrites",
@@ -313,6 +457,7 @@ Argument externalPredictiveInputsWinners
     externalPredictiveInputsWinners must be a subset of externalPredictiveInputsActive.
 
 See TM.compute() for details of the parameters.)",
+            py::call_guard<py::gil_scoped_release>(),
             py::arg("learn"),
             py::arg("externalPredictiveInputsActive"),
             py::arg("externalPredictiveInputsWinners"));
@@ -387,6 +532,10 @@ R"(Internal Connections object. Danger!
 Modifying this may detrimentally effect the TM.
 The Connections class API is subject to change.)");
 
+        py_HTM.def_property_readonly("externalConnections", [](const HTM_t &self)
+            { return self.externalConnections; },
+R"(Connections of the external predictive inputs, see setSeparateExternalConnections.)");
+
         py_HTM.def_property_readonly("externalPredictiveInputs", [](const HTM_t &self)
             { return self.externalPredictiveInputs; },
 R"()");
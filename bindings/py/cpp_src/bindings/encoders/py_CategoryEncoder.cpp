@@ -0,0 +1,128 @@
+/* ----------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * ---------------------------------------------------------------------- */
+
+#include <bindings/suppress_register.hpp>  //include before pybind11.h
+#include <pybind11/pybind11.h>
+#include <pybind11/iostream.h>
+#include <pybind11/numpy.h>
+
+#include <htm/encoders/CategoryEncoder.hpp>
+
+#include "bindings/engine/py_utils.hpp"
+
+namespace py = pybind11;
+
+using namespace htm;
+using namespace std;
+
+namespace htm_ext
+{
+    void init_CategoryEncoder(py::module& m)
+    {
+        py::class_<CategoryEncoder_Parameters> py_CategoryEncoder_args(m, "CategoryEncoder_Parameters",
+R"(Parameters for the CategoryEncoder
+
+Members "activeBits" & "sparsity" are mutually exclusive, specify exactly one
+of them.)");
+
+        py_CategoryEncoder_args.def(py::init<>());
+
+        py_CategoryEncoder_args.def_readwrite("size", &CategoryEncoder_Parameters::size,
+R"(Member "size" is the total number of bits in the encoded output SDR.)");
+
+        py_CategoryEncoder_args.def_readwrite("sparsity", &CategoryEncoder_Parameters::sparsity,
+R"(Member "sparsity" is the fraction of bits in the encoded output which this
+encoder will activate. This is an alternative way to specify the member
+"activeBits".)");
+
+        py_CategoryEncoder_args.def_readwrite("activeBits", &CategoryEncoder_Parameters::activeBits,
+R"(Member "activeBits" is the number of true bits in the encoded output SDR.)");
+
+        py_CategoryEncoder_args.def_readwrite("seed", &CategoryEncoder_Parameters::seed,
+R"(Member "seed" forces different encoders to produce different outputs, even if
+the inputs and all other parameters are the same.  Two encoders with the same
+seed, parameters, and input will produce identical outputs.
+
+The seed 0 is special.  Seed 0 is replaced with a random number.)");
+
+
+        py::class_<CategoryEncoder> py_CategoryEncoder(m, "CategoryEncoder",
+R"(Encodes a category, an unsigned integer or a string, as activeBits hashed
+positions.
+
+For categorical fields with millions of values, such as user IDs.  The
+encoder holds no state per category, its memory does not depend on the number
+of categories.  Each category gets exactly activeBits distinct bits, different
+categories only overlap by chance collisions of the hash.)");
+        py_CategoryEncoder.def(py::init<CategoryEncoder_Parameters>());
+
+        py_CategoryEncoder.def_property_readonly("parameters",
+            [](CategoryEncoder &self) { return self.parameters; },
+R"(Contains the parameter structure which this encoder uses internally. All
+fields are filled in automatically.)");
+
+        py_CategoryEncoder.def_property_readonly("dimensions",
+            [](CategoryEncoder &self) { return self.dimensions; });
+        py_CategoryEncoder.def_property_readonly("size",
+            [](CategoryEncoder &self) { return self.size; });
+
+        py_CategoryEncoder.def("encode", [](CategoryEncoder &self, UInt64 category) {
+            auto sdr = new SDR({self.size});
+            self.encode(category, *sdr);
+            return sdr;
+        },
+            py::call_guard<py::gil_scoped_release>());
+
+        py_CategoryEncoder.def("encode", [](CategoryEncoder &self, const std::string &category) {
+            auto sdr = new SDR({self.size});
+            self.encode(category, *sdr);
+            return sdr;
+        });
+
+        py_CategoryEncoder.def("encodeBatch", [](CategoryEncoder &self, py::array_t<UInt64, py::array::c_style | py::array::forcecast> categories) {
+            const UInt64 *data = categories.data();
+            const size_t n = static_cast<size_t>(categories.size());
+            vector<SDR> outputs;
+            {
+                py::gil_scoped_release release;
+                self.encodeBatch(data, n, outputs);
+            }
+            return to_sparse_batch(outputs);
+        },
+R"(Encode all categories of a NumPy array in one call.
+Returns the tuple (offsets, indices) of NumPy arrays: the active bits of the
+encoding of categories[i] are indices[offsets[i] : offsets[i + 1]].)",
+            py::arg("categories"));
+
+        py_CategoryEncoder.def_static("categoryOf", &CategoryEncoder::categoryOf,
+R"(The 64 bit category of a string, which encode(string) encodes.)");
+
+        // pickle
+        py_CategoryEncoder.def(py::pickle(
+          [](const CategoryEncoder& self) {
+            std::stringstream ss;
+            self.save(ss);
+            return py::bytes( ss.str() );
+          },
+          [](py::bytes &s) {
+            std::stringstream ss( s.cast<std::string>() );
+            std::unique_ptr<CategoryEncoder> self(new CategoryEncoder());
+            self->load(ss);
+            return self;
+        }));
+    }
+}
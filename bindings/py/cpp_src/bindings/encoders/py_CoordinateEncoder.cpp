@@ -0,0 +1,121 @@
+/* ----------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2014, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * ---------------------------------------------------------------------- */
+
+#include <bindings/suppress_register.hpp>  //include before pybind11.h
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <htm/encoders/CoordinateEncoder.hpp>
+
+namespace py = pybind11;
+
+using namespace htm;
+using namespace std;
+
+namespace htm_ext
+{
+    void init_CoordinateEncoder(py::module& m)
+    {
+        py::class_<CoordinateEncoderParameters> py_CE_args(m, "CoordinateEncoderParameters",
+R"(Parameters for the CoordinateEncoder
+
+Members "activeBits" & "sparsity" are mutually exclusive, specify exactly one
+of them.)");
+
+        py_CE_args.def(py::init<>());
+
+        py_CE_args.def_readwrite("size", &CoordinateEncoderParameters::size,
+R"(Member "size" is the total number of bits in the encoded output SDR.)");
+
+        py_CE_args.def_readwrite("activeBits", &CoordinateEncoderParameters::activeBits,
+R"(Member "activeBits" is the number of true bits in the encoded output SDR,
+barring hash collisions.)");
+
+        py_CE_args.def_readwrite("sparsity", &CoordinateEncoderParameters::sparsity,
+R"(Member "sparsity" is the fraction of bits in the encoded output which this
+encoder will activate. This is an alternative way to specify the member
+"activeBits".)");
+
+        py_CE_args.def_readwrite("radius", &CoordinateEncoderParameters::radius,
+R"(Member "radius" of the neighborhood of a coordinate, in each dimension.  Can
+also be given with every coordinate.)");
+
+
+        py::class_<CoordinateEncoder> py_CE(m, "CoordinateEncoder",
+R"(Encodes a coordinate in an N-dimensional integer space.
+
+Given a coordinate and a radius around it, the CoordinateEncoder hashes every
+coordinate in the neighborhood, picks the "activeBits" coordinates with the
+highest hashes and activates one bit for each of them.  Nearby coordinates
+share most of their neighborhoods, and so most of their active bits.)");
+        py_CE.def(py::init<CoordinateEncoderParameters>());
+
+        py_CE.def_property_readonly("parameters",
+            [](CoordinateEncoder &self) { return self.parameters; },
+R"(Contains the parameter structure which this encoder uses internally. All
+fields are filled in automatically.)");
+
+        py_CE.def_property_readonly("dimensions",
+            [](CoordinateEncoder &self) { return self.dimensions; });
+        py_CE.def_property_readonly("size",
+            [](CoordinateEncoder &self) { return self.size; });
+
+        py_CE.def("encode",
+            [](CoordinateEncoder &self, const vector<Int> &coordinate, SDR &output) {
+                self.encode(coordinate, output);
+            },
+R"(Encode a coordinate with the radius of the parameters.)",
+            py::call_guard<py::gil_scoped_release>());
+
+        py_CE.def("encode",
+            [](CoordinateEncoder &self, const vector<Int> &coordinate, UInt radius, SDR &output) {
+                self.encode(coordinate, radius, output);
+            },
+R"(Encode a coordinate with its own radius.)",
+            py::call_guard<py::gil_scoped_release>());
+
+        py_CE.def("encode", [](CoordinateEncoder &self, const vector<Int> &coordinate) {
+            auto sdr = new SDR({self.size});
+            self.encode(coordinate, *sdr);
+            return sdr;
+        },
+            py::call_guard<py::gil_scoped_release>());
+
+        py_CE.def("encodeBatch", [](CoordinateEncoder &self, const vector<vector<Int>> &coordinates) {
+            vector<SDR> outputs;
+            self.encodeBatch(coordinates.data(), coordinates.size(), outputs);
+            return outputs;
+        },
+R"(Encode a list of coordinates with the radius of the parameters, returns a
+list of SDRs.)",
+            py::call_guard<py::gil_scoped_release>());
+
+        // pickle
+        py_CE.def(py::pickle(
+          [](const CoordinateEncoder& self) {
+            std::stringstream ss;
+            self.save(ss);
+            return py::bytes( ss.str() );
+          },
+          [](py::bytes &s) {
+            std::stringstream ss( s.cast<std::string>() );
+            std::unique_ptr<CoordinateEncoder> self(new CoordinateEncoder());
+            self->load(ss);
+            return self;
+        }));
+    }
+}
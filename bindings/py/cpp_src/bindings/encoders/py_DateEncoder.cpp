@@ -154,12 +154,14 @@ fields are filled in.)");
         self.encode( time_point, *output );
         return output; },
 R"(Encodes a .py datetime.datetime into an SDR structure. )", 
-      py::return_value_policy::take_ownership);
+      py::return_value_policy::take_ownership,
+      py::call_guard<py::gil_scoped_release>());
       
       py_DateEnc.def("encode", [](DateEncoder &self, std::chrono::system_clock::time_point time_point, SDR* output) {
         self.encode( time_point, *output );
         return output; },
-R"(Encodes a .py datetime.datetime into an SDR structure. )");
+R"(Encodes a .py datetime.datetime into an SDR structure. )",
+      py::call_guard<py::gil_scoped_release>());
   }
 
 }
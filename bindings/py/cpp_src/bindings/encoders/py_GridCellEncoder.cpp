@@ -0,0 +1,112 @@
+/* ----------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2019, David McDougall
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * ---------------------------------------------------------------------- */
+
+#include <bindings/suppress_register.hpp>  //include before pybind11.h
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <htm/encoders/GridCellEncoder.hpp>
+
+namespace py = pybind11;
+
+using namespace htm;
+using namespace std;
+
+namespace htm_ext
+{
+    void init_GridCellEncoder(py::module& m)
+    {
+        py::class_<GridCellEncoderParameters> py_GC_args(m, "GridCellEncoderParameters",
+R"(Parameters for the GridCellEncoder)");
+
+        py_GC_args.def(py::init<>());
+
+        py_GC_args.def_readwrite("size", &GridCellEncoderParameters::size,
+R"(Member "size" is the total number of bits in the encoded output SDR.)");
+
+        py_GC_args.def_readwrite("sparsity", &GridCellEncoderParameters::sparsity,
+R"(Member "sparsity" is the fraction of bits in the encoded output which this
+encoder will activate, in every module.)");
+
+        py_GC_args.def_readwrite("periods", &GridCellEncoderParameters::periods,
+R"(Member "periods" is a list of distances.  The period of a module is the
+distance between the centers of a grid cells receptive fields.  The length of
+this list defines the number of distinct modules.  Periods must be at least 4.)");
+
+        py_GC_args.def_readwrite("seed", &GridCellEncoderParameters::seed,
+R"(Member "seed" controls the pseudo-random-number-generator which this encoder
+uses.  This encoder produces deterministic output.
+
+The seed 0 is special.  Seed 0 is replaced with a random number.)");
+
+
+        py::class_<GridCellEncoder> py_GC(m, "GridCellEncoder",
+R"(Encodes a 2-D coordinate as plausible grid cell activity.
+
+The output SDR is divided into modules.  Each module is a distinct group of
+cells with a common grid spacing and orientation.  Different modules have
+different spacings & orientations.
+
+To inspect this run:
+$ python -m htm.encoders.grid_cell_encoder --help)");
+        py_GC.def(py::init<GridCellEncoderParameters>());
+
+        py_GC.def_property_readonly("parameters",
+            [](GridCellEncoder &self) { return self.parameters; },
+R"(Contains the parameter structure which this encoder uses internally. All
+fields are filled in automatically.)");
+
+        py_GC.def_property_readonly("dimensions",
+            [](GridCellEncoder &self) { return self.dimensions; });
+        py_GC.def_property_readonly("size",
+            [](GridCellEncoder &self) { return self.size; });
+
+        py_GC.def("encode", &GridCellEncoder::encode,
+R"(Encode a location, a pair of coordinates [X, Y].  Locations with a NaN
+coordinate encode to no active bits.)",
+            py::call_guard<py::gil_scoped_release>());
+
+        py_GC.def("encode", [](GridCellEncoder &self, const vector<Real64> &location) {
+            auto sdr = new SDR({self.size});
+            self.encode(location, *sdr);
+            return sdr;
+        },
+            py::call_guard<py::gil_scoped_release>());
+
+        py_GC.def("encodeBatch", [](GridCellEncoder &self, const vector<vector<Real64>> &locations) {
+            vector<SDR> outputs;
+            self.encodeBatch(locations.data(), locations.size(), outputs);
+            return outputs;
+        },
+R"(Encode a list of locations, returns a list of SDRs.)",
+            py::call_guard<py::gil_scoped_release>());
+
+        // pickle
+        py_GC.def(py::pickle(
+          [](const GridCellEncoder& self) {
+            std::stringstream ss;
+            self.save(ss);
+            return py::bytes( ss.str() );
+          },
+          [](py::bytes &s) {
+            std::stringstream ss( s.cast<std::string>() );
+            std::unique_ptr<GridCellEncoder> self(new GridCellEncoder());
+            self->load(ss);
+            return self;
+        }));
+    }
+}
@@ -18,9 +18,12 @@
 #include <bindings/suppress_register.hpp>  //include before pybind11.h
 #include <pybind11/pybind11.h>
 #include <pybind11/iostream.h>
+#include <pybind11/numpy.h>
 
 #include <htm/encoders/RandomDistributedScalarEncoder.hpp>
 
+#include "bindings/engine/py_utils.hpp"
+
 namespace py = pybind11;
 
 using namespace htm;
@@ -108,13 +111,30 @@ fields are filled in automatically.)");
         py_RDSE.def_property_readonly("size",
             [](RDSE &self) { return self.size; });
 
-        py_RDSE.def("encode", &RDSE::encode, R"()");
+        py_RDSE.def("encode", &RDSE::encode, R"()",
+            py::call_guard<py::gil_scoped_release>());
 
         py_RDSE.def("encode", [](RDSE &self, Real64 value) {
             auto sdr = new SDR({self.size});
             self.encode(value, *sdr);
             return sdr;
-        });
+        },
+            py::call_guard<py::gil_scoped_release>());
+
+        py_RDSE.def("encodeBatch", [](RDSE &self, py::array_t<Real64, py::array::c_style | py::array::forcecast> values) {
+            const Real64 *data = values.data();
+            const size_t n = static_cast<size_t>(values.size());
+            vector<SDR> outputs;
+            {
+                py::gil_scoped_release release;
+                self.encodeBatch(data, n, outputs);
+            }
+            return to_sparse_batch(outputs);
+        },
+R"(Encode all values of a NumPy array in one call.
+Returns the tuple (offsets, indices) of NumPy arrays: the active bits of the
+encoding of values[i] are indices[offsets[i] : offsets[i + 1]].)",
+            py::arg("values"));
 
 
 	// Serialization
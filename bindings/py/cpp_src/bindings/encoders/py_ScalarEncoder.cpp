@@ -24,6 +24,8 @@ namespace py = pybind11;
 #include <htm/encoders/ScalarEncoder.hpp>
 #include <htm/types/Sdr.hpp>
 
+#include "bindings/engine/py_utils.hpp"
+
 namespace htm_ext
 {
   using namespace htm;
@@ -115,12 +117,29 @@ fields are filled in automatically.)");
     py_ScalarEnc.def_property_readonly("size",
         [](const ScalarEncoder &self) { return self.size; });
 
-    py_ScalarEnc.def("encode", &ScalarEncoder::encode, R"()");
+    py_ScalarEnc.def("encode", &ScalarEncoder::encode, R"()",
+        py::call_guard<py::gil_scoped_release>());
 
     py_ScalarEnc.def("encode", [](ScalarEncoder &self, htm::Real64 value) {
         auto output = new SDR( self.dimensions );
         self.encode( value, *output );
         return output; },
-R"()");
+R"()",
+        py::call_guard<py::gil_scoped_release>());
+
+    py_ScalarEnc.def("encodeBatch", [](ScalarEncoder &self,
+                                       py::array_t<htm::Real64, py::array::c_style | py::array::forcecast> values) {
+        const htm::Real64 *data = values.data();
+        const size_t n = static_cast<size_t>(values.size());
+        std::vector<SDR> outputs;
+        {
+            py::gil_scoped_release release;
+            self.encodeBatch( data, n, outputs );
+        }
+        return to_sparse_batch( outputs ); },
+R"(Encode all values of a NumPy array in one call.
+Returns the tuple (offsets, indices) of NumPy arrays: the active bits of the
+encoding of values[i] are indices[offsets[i] : offsets[i + 1]].)",
+        py::arg("values"));
   }
 }
@@ -90,6 +90,16 @@ List of tokens to discard when passed in to `encode()`. Terms in the
 strings to discard.
 )");
 
+    py_SimHashDocumentEncoderParameters.def_readwrite("fastHash",
+      &SimHashDocumentEncoderParameters::fastHash,
+R"(
+Hash the tokens with a fast non-cryptographic 64 bit hash, extended to `size`
+bits, instead of SHA3+SHAKE256.
+  If True: Encoding is much faster, especially for long documents. The
+    encodings differ from those made with the default hash.
+  If False (default): Tokens are hashed with SHA3+SHAKE256.
+)");
+
     py_SimHashDocumentEncoderParameters.def_readwrite("frequencyCeiling",
       &SimHashDocumentEncoderParameters::frequencyCeiling,
 R"(
@@ -233,10 +243,12 @@ This is the total number of bits in the encoded output SDR.
     //  1. Explain
     py_SimHashDocumentEncoder.def("encode", // alt: simple string. Define 1st!
       (void (SimHashDocumentEncoder::*)(std::string, htm::SDR &))
-        &SimHashDocumentEncoder::encode);
+        &SimHashDocumentEncoder::encode,
+        py::call_guard<py::gil_scoped_release>());
     py_SimHashDocumentEncoder.def("encode", // main: list.
       (void (SimHashDocumentEncoder::*)(std::vector<std::string>, htm::SDR &))
-        &SimHashDocumentEncoder::encode);
+        &SimHashDocumentEncoder::encode,
+        py::call_guard<py::gil_scoped_release>());
     //  2. Details
     py_SimHashDocumentEncoder.def("encode", // alt: simple string. Define 1st!
       [](SimHashDocumentEncoder &self, std::string value) {
@@ -249,7 +261,8 @@ Encode (Alternate calling style: Simple string method).
 Simple alternate calling pattern using only a single longer string. Takes input
 as a long python string, which will automatically be tokenized (split on
 whitespace). Ex: "alpha bravo delta echo".
-)");
+)",
+        py::call_guard<py::gil_scoped_release>());
     py_SimHashDocumentEncoder.def("encode", // main: list.
       [](SimHashDocumentEncoder &self, std::vector<std::string> value) {
         auto output = new SDR({ self.size });
@@ -270,6 +283,39 @@ Documents can contain any number of tokens > 0. Token order in the document is
   ignored and does not effect the output encoding. Tokens in the `vocabulary`
   will be weighted, while others may be encoded depending on the
   `encodeOrphans` param. Tokens in the `exclude` list will always be discarded.
+)",
+        py::call_guard<py::gil_scoped_release>());
+
+    /**
+     * Streaming
+     */
+    py_SimHashDocumentEncoder.def("addToken", &SimHashDocumentEncoder::addToken,
+R"(
+Add a token to the streaming window. The encoder keeps the sum of the tokens in
+its window, so that a sliding window is not encoded again for each token.
+The window is not serialized.
+)");
+    py_SimHashDocumentEncoder.def("removeToken", &SimHashDocumentEncoder::removeToken,
+R"(
+Remove one occurrence of a token from the streaming window.
+)");
+    py_SimHashDocumentEncoder.def("clearTokens", &SimHashDocumentEncoder::clearTokens,
+R"(
+Remove all tokens from the streaming window.
+)");
+    py_SimHashDocumentEncoder.def_property_readonly("numTokens",
+      &SimHashDocumentEncoder::getNumTokens,
+R"(
+Number of tokens in the streaming window.
+)");
+    py_SimHashDocumentEncoder.def("encodeTokens",
+      [](SimHashDocumentEncoder &self) {
+        auto output = new SDR({ self.size });
+        self.encodeTokens( *output );
+        return output;
+      },
+R"(
+Encode the tokens in the streaming window, same as encode() of the window.
 )");
 
     /**
@@ -43,6 +43,8 @@ PyBind11 bindings for Engine classes
 #include <plugin/PyBindRegion.hpp>
 #include <plugin/RegisteredRegionImplPy.hpp>
 
+#include "bindings/engine/py_utils.hpp"
+
 namespace py = pybind11;
 using namespace htm;
 
@@ -297,6 +299,8 @@ namespace htm_ext
             .def("getParameterArray", &Region::getParameterArray);
 
         py_Region.def("getParameterArrayCount", &Region::getParameterArrayCount);
+        py_Region.def("setAffinity", &Region::setAffinity, py::arg("cores"))
+            .def("getAffinity", &Region::getAffinity);
 
         py_Region.def("setParameterInt32", &Region::setParameterInt32)
             .def("setParameterUInt32", &Region::setParameterUInt32)
@@ -440,9 +444,87 @@ namespace htm_ext
             .def("getMinEnabledPhase", &htm::Network::getMinPhase)
             .def("getMaxEnabledPhase", &htm::Network::getMaxPhase)
             .def("setPhases",          &htm::Network::setPhases)
-            .def("run",                &htm::Network::run);
+            .def("run",                &htm::Network::run, py::call_guard<py::gil_scoped_release>())
+            .def("runWithDeadline",    &htm::Network::runWithDeadline, py::arg("budget"), py::arg("n") = 1,
+                                       py::call_guard<py::gil_scoped_release>())
+            .def("setLearnDutyCycle",  &htm::Network::setLearnDutyCycle, py::arg("region"), py::arg("every"),
+                                       py::arg("anomalyThreshold") = -1.0f, py::arg("anomalyRegion") = "")
+            .def("setNumThreads",      &htm::Network::setNumThreads, py::arg("numThreads"))
+            .def("getNumThreads",      &htm::Network::getNumThreads)
+            .def("setAffinity",        &htm::Network::setAffinity, py::arg("cores"))
+            .def("getAffinity",        &htm::Network::getAffinity)
+            .def("setNumaNode",        &htm::Network::setNumaNode, py::arg("node"))
+            .def("runBatch", [](htm::Network &net, const std::string &source, const Array &records,
+                                const std::vector<std::string> &outputs) {
+                    std::vector<Array> results;
+                    {
+                        py::gil_scoped_release release;
+                        net.runBatch(source, records, outputs, results);
+                    }
+                    return results;
+                }, "Run once per record of records, fed into the source output. Returns the collected outputs.",
+                py::arg("source"), py::arg("records"), py::arg("outputs"))
+            .def("setPipelined",       &htm::Network::setPipelined, py::arg("pipelined"))
+            .def("isPipelined",        &htm::Network::isPipelined);
+
+        // An asyncio future of Network::runAsync().  The executor thread
+        // resolves it through loop.call_soon_threadsafe(), and drops its
+        // references to the python objects while it holds the GIL.
+        struct PendingRun {
+            py::object network;
+            py::object loop;
+            py::object future;
+        };
+        py_Network.def("run_async", [](py::object self, int n, py::object loop) {
+                if( loop.is_none() )
+                    loop = py::module::import("asyncio").attr("get_event_loop")();
+                auto pending = std::make_shared<PendingRun>();
+                pending->network = self;
+                pending->loop    = loop;
+                pending->future  = loop.attr("create_future")();
+                py::object future = pending->future;
+                Network &net = self.cast<Network &>();
+                {
+                    py::gil_scoped_release release;
+                    net.runAsync(n, [pending](std::exception_ptr error) {
+                        std::string message;
+                        if( error != nullptr ) {
+                            try { std::rethrow_exception(error); }
+                            catch( const std::exception &e ) { message = e.what(); }
+                            catch( ... ) { message = "unknown error"; }
+                        }
+                        py::gil_scoped_acquire acquire;
+                        py::object future = std::move(pending->future);
+                        const bool failed = error != nullptr;
+                        auto resolve = py::cpp_function([future, failed, message]() {
+                            if( future.attr("done")().cast<bool>() )
+                                return; // cancelled
+                            if( failed )
+                                future.attr("set_exception")(py::module::import("builtins").attr("RuntimeError")(message));
+                            else
+                                future.attr("set_result")(py::none());
+                        });
+                        try {
+                            pending->loop.attr("call_soon_threadsafe")(resolve);
+                        } catch( const py::error_already_set & ) {
+                            // the loop is closed, nobody awaits the run
+                        }
+                        pending->loop    = py::object();
+                        pending->network = py::object();
+                    });
+                }
+                return future;
+            },
+R"(Run the network n times on the C++ executor shared by all networks, without
+blocking the caller or holding the GIL.  Returns an asyncio future of the
+run, a RuntimeError if it failed.  The network must not be changed or run
+until the future is done.
+
+    await net.run_async(10)
+)",
+            py::arg("n") = 1, py::arg("loop") = py::none());
 
-        py_Network.def("initialize", &htm::Network::initialize);
+        py_Network.def("initialize", &htm::Network::initialize, py::call_guard<py::gil_scoped_release>());
 
         py_Network.def("save",      &htm::Network::save)
             .def("load",            &htm::Network::load)
@@ -463,6 +545,24 @@ namespace htm_ext
                 return self;  
         }));
 
+        // pickle protocol 5, with the binary archive as out-of-band buffer, @see reduce_ex
+        py_Network.def("__reduce_ex__", [](const py::object &self, int protocol) {
+                const Network &net = self.cast<const Network &>();
+                return reduce_ex(self, protocol, [&net](std::vector<char> &buffer) {
+                    VectorStreamBuf buf(buffer);
+                    std::ostream os(&buf);
+                    net.save(os);
+                });
+            });
+        py_Network.def_static("_fromBuffer", [](const py::buffer &buffer) {
+                const BufferBytes bytes(buffer);
+                MemoryStreamBuf buf(bytes.data(), bytes.size());
+                std::istream is(&buf);
+                Network self;
+                self.load(is);
+                return self;
+            });
+
         py_Network.def("link", &htm::Network::link
             , "Defines a link between regions"
             , py::arg("srcName"), py::arg("destName")
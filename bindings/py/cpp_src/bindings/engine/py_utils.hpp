@@ -24,10 +24,20 @@ Utility functions for PyBind11 bindings
 */
 
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <streambuf>
+#include <utility>
+#include <vector>
+
 #include <bindings/suppress_register.hpp>  //include before pybind11.h
 #include <pybind11/pybind11.h>
 #include <pybind11/numpy.h>
 
+#include <htm/types/Sdr.hpp>
+
 namespace py = pybind11;
 
 namespace htm_ext {
@@ -51,6 +61,190 @@ namespace htm_ext {
         );
     }
 
+    /**
+     * Batches of SDRs as NumPy arrays, without a python SDR object per record.
+     *
+     * A sparse batch is the tuple (offsets, indices): the active bits of
+     * record i are indices[offsets[i] : offsets[i + 1]].
+     * A dense batch is a 2D array, with one row of dense values per record.
+     */
+    using SparseBatch = std::pair<py::array_t<htm::UInt64>, py::array_t<htm::UInt32>>;
+
+    inline SparseBatch to_sparse_batch(const std::vector<htm::SDR> &sdrs)
+    {
+        py::array_t<htm::UInt64> offsets( sdrs.size() + 1u );
+        auto off = offsets.mutable_data();
+        off[0] = 0u;
+        for( size_t i = 0u; i < sdrs.size(); i++ ) {
+            off[i + 1u] = off[i] + sdrs[i].getSum();
+        }
+        py::array_t<htm::UInt32> indices( static_cast<size_t>(off[sdrs.size()]) );
+        auto idx = indices.mutable_data();
+        for( const auto &sdr : sdrs ) {
+            const auto &sparse = sdr.getSparse();
+            idx = std::copy( sparse.begin(), sparse.end(), idx );
+        }
+        return SparseBatch( offsets, indices );
+    }
+
+    // Reads either form of batch into SDRs of the given dimensions.
+    inline std::vector<htm::SDR> from_batch(const py::object &batch, const std::vector<htm::UInt> &dimensions)
+    {
+        std::vector<htm::SDR> sdrs;
+        if( py::isinstance<py::tuple>(batch) ) {
+            const auto pair = batch.cast<py::tuple>();
+            if( pair.size() != 2u )
+                {throw std::invalid_argument("A sparse batch is the tuple (offsets, indices).");}
+            const auto offsets = pair[0].cast<py::array_t<htm::UInt64, py::array::c_style | py::array::forcecast>>();
+            const auto indices = pair[1].cast<py::array_t<htm::UInt32, py::array::c_style | py::array::forcecast>>();
+            if( offsets.ndim() != 1 || offsets.size() < 1 || offsets.at(0) != 0u ||
+                offsets.at(offsets.size() - 1) != static_cast<htm::UInt64>(indices.size()) )
+                {throw std::invalid_argument("Batch offsets must start at 0 and end at the number of indices.");}
+
+            const auto off = offsets.data();
+            const auto idx = indices.data();
+            sdrs.resize( static_cast<size_t>(offsets.size() - 1) );
+            for( size_t i = 0u; i < sdrs.size(); i++ ) {
+                if( off[i + 1u] < off[i] )
+                    {throw std::invalid_argument("Batch offsets must not decrease.");}
+                htm::SDR_sparse_t sparse( idx + off[i], idx + off[i + 1u] );
+                std::sort( sparse.begin(), sparse.end() );
+                sparse.erase( std::unique( sparse.begin(), sparse.end() ), sparse.end() );
+                sdrs[i].initialize( dimensions );
+                if( !sparse.empty() && sparse.back() >= sdrs[i].size )
+                    {throw std::invalid_argument("Batch index out of bounds of the SDR.");}
+                sdrs[i].setSparse( sparse );
+            }
+        }
+        else {
+            const auto rows = batch.cast<py::array_t<htm::Byte, py::array::c_style | py::array::forcecast>>();
+            size_t size = 1u;
+            for( const auto dim : dimensions ) {
+                size *= dim;
+            }
+            if( rows.ndim() != 2 || static_cast<size_t>(rows.shape(1)) != size )
+                {throw std::invalid_argument("A dense batch is a 2D array, one row of the SDR size per record.");}
+
+            sdrs.resize( static_cast<size_t>(rows.shape(0)) );
+            for( size_t i = 0u; i < sdrs.size(); i++ ) {
+                sdrs[i].initialize( dimensions );
+                sdrs[i].setDense( rows.data() + i * size );
+            }
+        }
+        return sdrs;
+    }
+
+    /**
+     * Pickle protocol 5 (PEP 574) out-of-band buffers, for large models.
+     *
+     * With protocol 5 __reduce_ex__ returns the saved state as one
+     * pickle.PickleBuffer, over a NumPy array which owns the bytes.  So
+     * pickle.dumps(model, protocol=5, buffer_callback=...) does not copy the
+     * state into the pickle stream, and the receiver loads the model in
+     * place from the memory the buffer arrives in, eg. shared memory:
+     *
+     *     buffers = []
+     *     data = pickle.dumps(tm, protocol=5, buffer_callback=buffers.append)
+     *     # ... send data, place the buffers in shared memory ...
+     *     tm = pickle.loads(data, buffers=[shm.buf for shm in ...])
+     *
+     * The older protocols keep the __getstate__ / __setstate__ pickling.
+     */
+
+    // A std::streambuf which appends to a vector, a std::string without the copy.
+    class VectorStreamBuf : public std::streambuf
+    {
+    public:
+        explicit VectorStreamBuf(std::vector<char> &buffer) : buffer_(buffer) {}
+
+    protected:
+        int_type overflow(int_type c) override
+        {
+            if( !traits_type::eq_int_type(c, traits_type::eof()) )
+                buffer_.push_back(traits_type::to_char_type(c));
+            return traits_type::not_eof(c);
+        }
+        std::streamsize xsputn(const char *s, std::streamsize n) override
+        {
+            buffer_.insert(buffer_.end(), s, s + n);
+            return n;
+        }
+
+    private:
+        std::vector<char> &buffer_;
+    };
+
+    // A std::streambuf which reads a buffer in place.
+    class MemoryStreamBuf : public std::streambuf
+    {
+    public:
+        MemoryStreamBuf(const char *data, size_t size)
+        {
+            char *begin = const_cast<char *>(data);
+            setg(begin, begin, begin + size);
+        }
+    };
+
+    // A NumPy array of bytes which takes over the buffer, without a copy.
+    inline py::array_t<std::uint8_t> to_array(std::vector<char> &&buffer)
+    {
+        auto owner = new std::vector<char>(std::move(buffer));
+        py::capsule free(owner, [](void *p) { delete static_cast<std::vector<char> *>(p); });
+        return py::array_t<std::uint8_t>( static_cast<py::ssize_t>(owner->size()),
+                                          reinterpret_cast<const std::uint8_t *>(owner->data()), free );
+    }
+
+    /**
+     * The bytes of a contiguous buffer, aligned to 8 bytes as FlatReader
+     * requires.  A buffer which is not aligned is copied.
+     */
+    class BufferBytes
+    {
+    public:
+        explicit BufferBytes(const py::buffer &buffer) : info_(buffer.request())
+        {
+            if( info_.ndim > 1 || (info_.ndim == 1 && info_.strides[0] != info_.itemsize) )
+                {throw std::invalid_argument("The pickled buffer is not contiguous.");}
+            data_ = static_cast<const char *>(info_.ptr);
+            size_ = static_cast<size_t>(info_.size * info_.itemsize);
+            if( reinterpret_cast<std::uintptr_t>(data_) % sizeof(htm::UInt64) != 0u ) {
+                copy_.resize((size_ + sizeof(htm::UInt64) - 1u) / sizeof(htm::UInt64));
+                std::memcpy(copy_.data(), data_, size_);
+                data_ = reinterpret_cast<const char *>(copy_.data());
+            }
+        }
+        const char *data() const { return data_; }
+        size_t size() const { return size_; }
+
+    private:
+        py::buffer_info info_;
+        const char *data_;
+        size_t size_;
+        std::vector<htm::UInt64> copy_;
+    };
+
+    /**
+     * __reduce_ex__ of a class with the static method `_fromBuffer(buffer)`.
+     * @param save writes the state of the object into a std::vector<char>.
+     *
+     * The functions of pybind11 can not be pickled by reference, so the
+     * reduction calls operator.methodcaller("_fromBuffer", buffer) on the
+     * class, which pickles as the class, the name and the buffer.
+     */
+    template<typename Save>
+    py::object reduce_ex(const py::object &self, int protocol, Save save)
+    {
+        if( protocol < 5 )
+            {return py::module::import("builtins").attr("object").attr("__reduce_ex__")(self, protocol);}
+        std::vector<char> buffer;
+        {
+            py::gil_scoped_release release;
+            save(buffer);
+        }
+        const auto pickleBuffer = py::module::import("pickle").attr("PickleBuffer")(to_array(std::move(buffer)));
+        const auto load = py::module::import("operator").attr("methodcaller")("_fromBuffer", pickleBuffer);
+        return py::make_tuple(load, py::make_tuple(self.attr("__class__")));
+    }
 
 } // namespace htm_ext
 
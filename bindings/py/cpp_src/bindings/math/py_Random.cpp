@@ -45,6 +45,8 @@ namespace htm_ext {
               .def("getUInt32", &Random_t::getUInt32, py::arg("max") = (htm::UInt32)-1l)
               .def("getReal64", &Random_t::getReal64)
 	      .def("getSeed", &Random_t::getSeed)
+              .def("split", &Random_t::split, py::arg("streamId"),
+                   "Returns the counter-based substream streamId, which depends only on the seed and streamId.")
               .def("max", &Random_t::max)
               .def("min", &Random_t::min)
               .def("__eq__", [](Random_t const & self, Random_t const & other) { return self == other; }, py::is_operator()); //operator==
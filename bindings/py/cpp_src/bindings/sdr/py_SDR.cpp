@@ -151,21 +151,30 @@ current value.)");
                 }
                 return py::array(self->dimensions, strides, self->getDense().data(), destructor);
             },
-            [](SDR &self, py::array_t<Byte> dense) {
-                py::buffer_info buf = dense.request();
-                if( buf.ndim == 1 ) {
-                    NTA_CHECK( (UInt) buf.shape[0] == self.size )
-                        << "Bad input array size! expected " << self.size << ", got " << buf.shape[0];
+            [](SDR &self, const py::object &value) {
+                // Read C-contiguous one byte arrays (bool, int8, uint8) in
+                // place, other types and layouts are converted once.
+                auto dense = py::array::ensure( value );
+                NTA_CHECK( dense ) << "Dense data must be an array of numbers.";
+                const char kind = dense.dtype().kind();
+                if( dense.itemsize() != sizeof(Byte) || (kind != 'b' && kind != 'i' && kind != 'u') ||
+                    !dense.attr("flags").attr("c_contiguous").cast<bool>() ) {
+                    dense = py::array_t<Byte, py::array::c_style | py::array::forcecast>::ensure( dense );
+                    NTA_CHECK( dense ) << "Dense data must be an array of numbers.";
                 }
-                else if( (UInt) buf.ndim == self.dimensions.size() ) {
+                if( dense.ndim() == 1 ) {
+                    NTA_CHECK( (UInt) dense.shape(0) == self.size )
+                        << "Bad input array size! expected " << self.size << ", got " << dense.shape(0);
+                }
+                else if( (UInt) dense.ndim() == self.dimensions.size() ) {
                     for(auto dim = 0u; dim < self.dimensions.size(); dim++) {
-                        NTA_CHECK( (UInt) buf.shape[dim] == self.dimensions[dim] );
+                        NTA_CHECK( (UInt) dense.shape(dim) == self.dimensions[dim] );
                     }
                 }
                 else {
                     NTA_THROW << "Invalid input dimensions!";
                 }
-                Byte *data = (Byte*) buf.ptr;
+                const Byte *data = static_cast<const Byte*>( dense.data() );
                 if( data == self.getDense().data() )
                     // We got our own data back, set inplace instead of copying.
                     self.setDense( self.getDense() );
@@ -185,23 +194,46 @@ date.  If you did't copy this data, then SDR won't copy either.)");
                         delete reinterpret_cast<shared_ptr<SDR>*>(keepAlive); });
                 return py::array(self->getSum(), self->getSparse().data(), destructor);
             },
-            [](SDR &self, SDR_sparse_t data) {
-                NTA_CHECK( data.size() <= self.size );
-                // Sort data and check for duplicates.
-                if( ! is_sorted( data.begin(), data.end() ))
-                    sort( data.begin(), data.end() );
+            [](SDR &self, py::array_t<ElemSparse, py::array::c_style | py::array::forcecast> data) {
+                NTA_CHECK( data.ndim() == 1 ) << "Sparse data must be a flat list of indices.";
+                const UInt num = (UInt) data.size();
+                NTA_CHECK( num <= self.size );
+                const ElemSparse *begin = data.data();
+                if( !data.owndata() && begin == self.getSparse().data() && num == self.getSum() ) {
+                    // We got our own data back, it is already valid.
+                    self.setSparseInplace();
+                    return;
+                }
+                // Copy sorted data straight from the numpy buffer, otherwise
+                // sort a copy of it.  Both check for duplicates.
+                bool ascending = true;
+                for( UInt i = 1u; i < num && ascending; i++ ) {
+                    ascending = begin[i - 1u] < begin[i];
+                }
+                if( ascending ) {
+                    NTA_CHECK( num == 0u || begin[num - 1u] < self.size )
+                        << "Index out of bounds of the SDR!";
+                    self.setSparse( begin, num );
+                    return;
+                }
+                SDR_sparse_t sorted( begin, begin + num );
+                sort( sorted.begin(), sorted.end() );
                 UInt previous = -1;
-                for( const UInt idx : data ) {
+                for( const UInt idx : sorted ) {
                     NTA_CHECK( idx != previous )
                         << "Sparse data must not contain duplicates!";
                     previous = idx;
                 }
-                self.setSparse( data ); },
+                NTA_CHECK( sorted.back() < self.size )
+                    << "Index out of bounds of the SDR!";
+                self.setSparse( sorted ); },
 R"(A numpy array containing the indices of only the true values in the SDR.
 These are indices into the flattened SDR. This format allows for quickly
 accessing all of the true bits in the SDR.
 
-Sparse data must contain no duplicates.)");
+Sparse data must contain no duplicates.  Assigning a sorted, C-contiguous
+numpy array of uint32 copies its buffer in one pass, without converting each
+element; assigning this SDR's own sparse array back copies nothing.)");
 
         py_SDR.def_property("coordinates",
             [](shared_ptr<SDR> self) {
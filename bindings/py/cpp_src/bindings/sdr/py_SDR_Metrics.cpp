@@ -49,6 +49,18 @@ average is used instead of an exponential moving average.)");
         py_Helper.def_property_readonly( "dimensions",
             [](const MetricsHelper_ &self){ return self.dimensions; },
                 "Shape of the SDR data source.");
+        py_Helper.def( "setSampleRate", &MetricsHelper_::setSampleRate,
+R"(Measure only one out of every rate data, eg. 10 measures every tenth
+assignment to the SDR.  The period counts the measured data.)", py::arg("rate"));
+        py_Helper.def( "setAsync", &MetricsHelper_::setAsync,
+R"(In asynchronous mode the SDR callback only copies the active bits into a
+queue, and a background thread updates this metric.  Data which arrives while
+maxQueue data are waiting is dropped.  Call flush() before reading the results.)",
+            py::arg("async"), py::arg("maxQueue") = 1024u);
+        py_Helper.def( "flush", &MetricsHelper_::flush,
+            "Waits until the background thread measured all queued data.");
+        py_Helper.def_property_readonly( "dropped", &MetricsHelper_::getDropped,
+            "Number of data dropped because the queue was full.");
 
         // =====================================================================
         // SDR SPARSITY
@@ -263,6 +275,15 @@ Metrics was constructed with dimensions and NOT an SDR.
 
 Argument sdr is data source, its dimensions must be the same as this Metric's
 dimensions.)", py::arg("sdr"));
+        py_Metrics.def( "setSampleRate", &Metrics::setSampleRate,
+            "Measure only one out of every rate data.", py::arg("rate"));
+        py_Metrics.def( "setAsync", &Metrics::setAsync,
+            "Measure the data on a background thread, call flush() before reading the results.",
+            py::arg("async"), py::arg("maxQueue") = 1024u);
+        py_Metrics.def( "flush", &Metrics::flush,
+            "Waits until the background thread measured all queued data.");
+        py_Metrics.def_property_readonly( "dropped", &Metrics::getDropped,
+            "Number of data dropped because the queue was full.");
         py_Metrics.def_property_readonly("dimensions",
             [](const Metrics &self) { return self.dimensions; });
         py_Metrics.def_property_readonly("sparsity",
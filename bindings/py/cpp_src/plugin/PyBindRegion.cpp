@@ -415,6 +415,7 @@ namespace py = pybind11;
     template<typename T>
     T PyBindRegion::getParameterT(const std::string & name, Int64 index)
     {
+        py::gil_scoped_acquire gil;
         try
         {
             py::args args = py::make_tuple(name, index);
@@ -438,6 +439,7 @@ namespace py = pybind11;
                << "module " << module_ << "; Parameter '" << name 
                << "' does not have ReadWriteAccess. Cannot be set.";
 
+        py::gil_scoped_acquire gil;
         try
         {
             py::args args = py::make_tuple(name, index, value);
@@ -534,24 +536,28 @@ namespace py = pybind11;
 
     void PyBindRegion::getParameterArray(const std::string& name, Int64 index, Array & a)
     {
+        py::gil_scoped_acquire gil;
         auto args = py::make_tuple(name, index, create_numpy_view(a));
         node_.attr("getParameterArray")(*args);
     }
 
     void PyBindRegion::setParameterArray(const std::string& name, Int64 index, const Array & a)
     {
+        py::gil_scoped_acquire gil;
         auto args = py::make_tuple(name, index, create_numpy_view(a));
         node_.attr("setParameterArray")(*args);
     }
 
     std::string PyBindRegion::getParameterString(const std::string& name, Int64 index)
     {
+        py::gil_scoped_acquire gil;
         py::args args = py::make_tuple(name, index);
         return node_.attr("setParameter")(*args).cast<std::string>();
     }
 
     void PyBindRegion::setParameterString(const std::string& name, Int64 index, const std::string& value)
     {
+        py::gil_scoped_acquire gil;
         py::args args = py::make_tuple(name, index, value);
         node_.attr("setParameter")(*args);
     }
@@ -560,6 +566,7 @@ namespace py = pybind11;
 
     size_t PyBindRegion::getParameterArrayCount(const std::string& name, Int64 index)
     {
+        py::gil_scoped_acquire gil;
         py::args args = py::make_tuple(name, index);
         return node_.attr("getParameterArrayCount")(*args).cast<size_t>();
     }
@@ -571,6 +578,7 @@ namespace py = pybind11;
 
     size_t PyBindRegion::getNodeOutputElementCount(const std::string& outputName) const
     {
+        py::gil_scoped_acquire gil;
         py::args args = py::make_tuple(outputName);
         return (size_t)node_.attr("getOutputElementCount")(*args).cast<int>();
     }
@@ -580,6 +588,7 @@ namespace py = pybind11;
 
     std::string PyBindRegion::executeCommand(const std::vector<std::string>& args, Int64 index)
     {
+        py::gil_scoped_acquire gil;
         //py::Tuple t(args.size() - 1);
         //for (size_t i = 1; i < args.size(); ++i)
         //{
@@ -595,54 +604,74 @@ namespace py = pybind11;
         return s;
     }
 
-    void PyBindRegion::compute()
+    void PyBindRegion::prepareViews_()
     {
         const Spec& ns = nodeSpec_;
-
-        // Prepare the inputs dict
-        py::dict inputs;
         for (size_t i = 0; i < ns.inputs.getCount(); ++i)
         {
             const std::pair<std::string, InputSpec> & p = ns.inputs.getByIndex(i);
-
-            // Get the corresponding input buffer
-            auto inp = region_->getInput(p.first);
-            NTA_CHECK(inp);
-
-            // Set pa to point to the original input array
-            const htm::Array * pa = &(inp->getData());
-
-            // Skip unlinked inputs of size 0
-    		    if (pa->getCount() == 0)
+            PortView port;
+            port.name = py::str(p.first);
+            port.input = region_->getInput(p.first);
+            NTA_CHECK(port.input);
+            inputViews_.push_back(port);
+        }
+        for (size_t i = 0; i < ns.outputs.getCount(); ++i)
+        {
+            const std::pair<std::string, OutputSpec> & p = ns.outputs.getByIndex(i);
+            PortView port;
+            port.name = py::str(p.first);
+            port.output = region_->getOutput(p.first);
+            // Skip optional outputs
+            if (!port.output)
                 continue;
+            outputViews_.push_back(port);
+        }
+        viewsReady_ = true;
+    }
 
-
-            // Create a numpy array from pa, which wil be either
-            // the original input array or a stored input array copy
-            // (if a splitter map is needed)
-            inputs[p.first.c_str()] = create_numpy_view(*pa);
+    const py::object &PyBindRegion::refreshView_(PortView &port, const Array &data)
+    {
+        if (!port.view || data.getBuffer() != port.buffer || data.getCount() != port.count
+                       || data.getType() != port.type)
+        {
+            port.view = create_numpy_view(data);
+            port.buffer = data.getBuffer();
+            port.count = data.getCount();
+            port.type = data.getType();
         }
+        return port.view;
+    }
 
-        // Prepare the outputs dict
-        py::dict outputs;
+    void PyBindRegion::compute()
+    {
+        // Network.run releases the GIL, and may run this on a worker thread.
+        py::gil_scoped_acquire gil;
+        if (!viewsReady_)
+            prepareViews_();
 
-        for (size_t i = 0; i < ns.outputs.getCount(); ++i)
+        // The items are set again each iteration, in case the python code
+        // replaced them, but the dicts and views are reused.
+        for (auto &port : inputViews_)
         {
-            // Get the current OutputSpec object
-            const std::pair<std::string, OutputSpec> & p = ns.outputs.getByIndex(i);
+            const htm::Array &data = port.input->getData();
 
-            // Get the corresponding output buffer
-            auto out = region_->getOutput(p.first);
-            // Skip optional outputs
-            if (!out)
+            // Skip unlinked inputs of size 0
+            if (data.getCount() == 0)
+            {
+                if (inputs_.contains(port.name))
+                    PyDict_DelItem(inputs_.ptr(), port.name.ptr());
                 continue;
+            }
+            inputs_[port.name] = refreshView_(port, data);
+        }
 
-            const Array & data = out->getData();
-            outputs[p.first.c_str()] = create_numpy_view(data);
+        for (auto &port : outputViews_)
+        {
+            outputs_[port.name] = refreshView_(port, port.output->getData());
         }
 
-        py::args args = py::make_tuple(inputs, outputs);
-        node_.attr("guardedCompute")(*args);
+        node_.attr("guardedCompute")(inputs_, outputs_);
     }
 
 
@@ -943,6 +972,7 @@ namespace py = pybind11;
 
     void PyBindRegion::initialize()
     {
+        py::gil_scoped_acquire gil;
         node_.attr("initialize")();
     }
 
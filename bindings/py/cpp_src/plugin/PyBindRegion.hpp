@@ -28,6 +28,9 @@ Definition of the PyBindRegion class.  The base class for all Python Region impl
 #include <bindings/suppress_register.hpp>  //include before pybind11.h
 #include <pybind11/pybind11.h>
 
+#include <memory>
+#include <vector>
+
 #include <htm/types/Types.hpp>
 #include <htm/engine/RegionImpl.hpp>
 #include <htm/engine/Spec.hpp>
@@ -140,6 +143,26 @@ namespace htm
 
         Spec nodeSpec_;   // locally cached version of spec.
 
+        // The arguments of compute() are kept across iterations, a numpy view
+        // is rebuilt only when the buffer behind it was reallocated.
+        struct PortView {
+            pybind11::str name;
+            std::shared_ptr<Input> input;
+            std::shared_ptr<Output> output;
+            const void *buffer = nullptr;
+            size_t count = 0u;
+            NTA_BasicType type = NTA_BasicType_Last;
+            pybind11::object view;
+        };
+        std::vector<PortView> inputViews_;
+        std::vector<PortView> outputViews_;
+        pybind11::dict inputs_;
+        pybind11::dict outputs_;
+        bool viewsReady_ = false;
+
+        void prepareViews_();
+        static const pybind11::object &refreshView_(PortView &port, const Array &data);
+
         std::string pickleSerialize() const;
         std::string extraSerialize() const;
 				void pickleDeserialize(std::string p);
@@ -0,0 +1,66 @@
+# ----------------------------------------------------------------------
+# HTM Community Edition of NuPIC
+# Copyright (C) 2020, Numenta, Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+# See the GNU Affero Public License for more details.
+#
+# You should have received a copy of the GNU Affero Public License
+# along with this program.  If not, see http://www.gnu.org/licenses.
+# ----------------------------------------------------------------------
+
+import unittest
+import pickle
+
+import numpy as np
+
+from htm.bindings.algorithms import ColumnPooler
+
+
+class ColumnPoolerTest(unittest.TestCase):
+
+  def testLearnAndRecall(self):
+    pooler = ColumnPooler(inputWidth=1024, lateralInputWidths=[2048])
+    featureA = np.arange(0, 30, dtype=np.uint32)
+    featureB = list(range(130, 100, -1))    # Unsorted lists work too.
+    lateral = np.arange(0, 40, dtype=np.uint32)
+
+    pooler.compute(featureA, [lateral], learn=True)
+    pooler.compute(featureB, [lateral], learn=True)
+    representation = pooler.getActiveCells()
+    self.assertEqual(len(representation), 40)
+    self.assertEqual(representation.dtype, np.uint32)
+    self.assertEqual(pooler.numberOfProximalSynapses(), 40 * 40)
+    self.assertEqual(pooler.numberOfConnectedProximalSynapses(representation), 40 * 40)
+    self.assertEqual(pooler.numberOfDistalSegments(), 2 * 40)
+
+    pooler.reset()
+    pooler.compute(featureA, learn=False)
+    np.testing.assert_array_equal(pooler.getActiveCells(), representation)
+
+    segments = pooler.proximalPermanences.segmentsForCell(int(representation[0]))
+    self.assertEqual(len(segments), 1)
+
+  def testBadInput(self):
+    pooler = ColumnPooler(inputWidth=100)
+    with self.assertRaises(ValueError):
+      pooler.compute([100])
+    with self.assertRaises(ValueError):
+      pooler.compute([1, 2, 3], [[1, 2, 3]])
+
+  def testPickle(self):
+    pooler = ColumnPooler(inputWidth=1024, cellCount=2048, sdrSize=30, maxSdrSize=None)
+    pooler.compute(np.arange(0, 30, dtype=np.uint32))
+    clone = pickle.loads(pickle.dumps(pooler))
+    self.assertEqual(pooler, clone)
+    np.testing.assert_array_equal(pooler.getActiveCells(), clone.getActiveCells())
+
+
+if __name__ == "__main__":
+  unittest.main()
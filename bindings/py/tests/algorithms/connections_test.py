@@ -38,6 +38,22 @@ class ConnectionsTest(unittest.TestCase):
     return set([connections.presynapticCellForSynapse(synapse) for synapse in connections.synapsesForSegment(segment) 
                 if connections.permanenceForSynapse(synapse) >= threshold])
 
+  @pytest.mark.skipif(sys.version_info < (3, 8), reason="Pickle protocol 5 is new in python 3.8")
+  def testPickleOutOfBand(self):
+    """Pickle protocol 5, the flat archive in an out-of-band buffer."""
+    connections = Connections(NUM_CELLS, 0.51)
+    for cell in range(NUM_CELLS):
+      segment = connections.createSegment(cell, 1)
+      connections.createSynapse(segment, (cell + 1) % NUM_CELLS, 0.6)
+
+    buffers = []
+    data = pickle.dumps(connections, protocol=5, buffer_callback=buffers.append)
+    self.assertEqual(len(buffers), 1)
+    clone = pickle.loads(data, buffers=buffers)
+    self.assertEqual(clone.numSegments(), connections.numSegments())
+    self.assertEqual(clone.numSynapses(), connections.numSynapses())
+    self.assertEqual(str(clone), str(connections))
+
   def testAdaptShouldNotRemoveSegments(self):
     """
     Test that connections are generated on predefined segments.
@@ -448,6 +464,21 @@ class ConnectionsTest(unittest.TestCase):
     self.assertEqual(co.numSegments(), 0, "segment should have been removed")
     with pytest.raises(RuntimeError):
       n2 = co.numConnectedSynapses(seg)
+
+  def testPresynapticAdjacency(self):
+    co = Connections(NUM_CELLS, 0.51)
+    seg1 = co.createSegment(1, 20)
+    seg2 = co.createSegment(2, 20)
+    syn1 = co.createSynapse(seg1, 5, 0.6)
+    syn2 = co.createSynapse(seg2, 5, 0.4)
+    syn3 = co.createSynapse(seg2, 3, 0.6)
+
+    offsets, synapses, numConnected = co.presynapticAdjacency()
+    self.assertEqual(list(offsets), [0, 0, 0, 0, 1, 1, 3])
+    self.assertEqual(list(numConnected), [0, 0, 0, 1, 0, 1])
+    self.assertEqual(list(synapses[offsets[5]:offsets[6]]), [syn1, syn2], "connected first")
+    self.assertEqual(list(synapses[offsets[3]:offsets[4]]), [syn3])
+    self.assertEqual(sorted(synapses[offsets[5]:offsets[6]]), sorted(co.synapsesForPresynapticCell(5)))
     
 
 
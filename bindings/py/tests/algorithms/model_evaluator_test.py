@@ -0,0 +1,72 @@
+# ----------------------------------------------------------------------
+# HTM Community Edition of NuPIC
+# Copyright (C) 2020, Numenta, Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+# See the GNU Affero Public License for more details.
+#
+# You should have received a copy of the GNU Affero Public License
+# along with this program.  If not, see http://www.gnu.org/licenses.
+# ----------------------------------------------------------------------
+
+import unittest
+
+import numpy as np
+
+from htm.bindings.sdr import SDR
+from htm.bindings.algorithms import ModelEvaluator, SpatialPooler, TemporalMemory
+
+
+class ModelEvaluatorTest(unittest.TestCase):
+
+  def testEvaluateSpatialPoolers(self):
+    np.random.seed(42)
+    prototypes = np.random.random((4, 200)) < 0.1
+    labels = np.arange(60, dtype=np.uint32) % 4
+    rows = prototypes[labels]
+
+    evaluator = ModelEvaluator(numThreads=4)
+    evaluator.setTrainingData(rows[:40], labels[:40], dimensions=[200])
+    evaluator.setTestData(rows[40:], labels[40:], dimensions=[200])
+    self.assertEqual(evaluator.trainingSize, 40)
+    self.assertEqual(evaluator.testSize, 20)
+
+    models = [SpatialPooler([200], [256], localAreaDensity=density)
+                for density in (0.02, 0.05, 0.1)]
+    scores = evaluator.evaluate(models)
+    self.assertEqual(len(scores), 3)
+    for score in scores:
+      self.assertGreater(score.accuracy, 0.8)
+      self.assertEqual(score.anomaly, 0)
+
+    with self.assertRaises(RuntimeError):
+      evaluator.evaluate([models[0], models[0]])
+    with self.assertRaises(ValueError):
+      evaluator.evaluate([42])
+
+  def testEvaluateTemporalMemory(self):
+    sequence = []
+    for i in range(5):
+      sdr = SDR([64])
+      sdr.randomize(0.1)
+      sequence.append(sdr)
+
+    evaluator = ModelEvaluator(numThreads=2)
+    evaluator.setTrainingData(sequence * 20, resets=[i % 5 == 0 for i in range(100)])
+
+    tms = [TemporalMemory([64], cellsPerColumn=4, activationThreshold=3, initialPermanence=0.5,
+                          connectedPermanence=0.5, minThreshold=2, maxNewSynapseCount=6)
+            for _ in range(2)]
+    scores = evaluator.evaluate([(None, tm) for tm in tms])
+    for score in scores:
+      self.assertLess(score.anomaly, 0.5)
+
+
+if __name__ == "__main__":
+  unittest.main()
@@ -20,6 +20,7 @@ import pytest
 import sys
 import tempfile
 import os
+import threading
 
 from htm.bindings.sdr import SDR
 from htm.algorithms import SpatialPooler as SP
@@ -38,6 +39,49 @@ class SpatialPoolerTest(unittest.TestCase):
     assert( active.getSum() > 0 )
 
 
+  def testComputeBatch(self):
+    """ computeBatch matches compute per record, for both forms of batch. """
+    inputs = [ SDR( 100 ).randomize( .05 ) for i in range(10) ]
+    offsets = np.cumsum( [0] + [ x.getSum() for x in inputs ] )
+    indices = np.concatenate([ x.sparse for x in inputs ])
+    dense = np.array([ x.dense for x in inputs ])
+    for learn in [ False, True ]:
+      sp = SP( [100], [200], stimulusThreshold = 1, seed = 3 )
+      expected = SP( [100], [200], stimulusThreshold = 1, seed = 3 )
+      out_offsets, out_indices = sp.computeBatch( (offsets, indices), learn )
+      for i, x in enumerate( inputs ):
+        active = SDR( 200 )
+        expected.compute( x, learn, active )
+        assert( list(out_indices[out_offsets[i] : out_offsets[i+1]]) == list(active.sparse) )
+
+    sp = SP( [100], [200], stimulusThreshold = 1, seed = 3 )
+    dense_offsets, dense_indices = sp.computeBatch( dense )
+    sparse_offsets, sparse_indices = sp.computeBatch( (offsets, indices) )
+    assert( list(dense_offsets) == list(sparse_offsets) )
+    assert( list(dense_indices) == list(sparse_indices) )
+
+
+  def testComputeThreads(self):
+    """ compute releases the GIL, independent models may run in threads. """
+    inputs = [ SDR( 100 ).randomize( .05 ) for i in range(20) ]
+    def run( sp, outputs ):
+      for x in inputs:
+        active = SDR( 100 )
+        sp.compute( x, True, active )
+        outputs.append( list(active.sparse) )
+
+    expected = []
+    run( SP( [100], [100], stimulusThreshold = 1, seed = 7 ), expected )
+    results = [ [] for i in range(4) ]
+    threads = [ threading.Thread( target = run,
+                  args = (SP( [100], [100], stimulusThreshold = 1, seed = 7 ), out) )
+                for out in results ]
+    for t in threads: t.start()
+    for t in threads: t.join()
+    for out in results:
+      assert( out == expected )
+
+
   def _runGetPermanenceTrial(self, float_type):
     """ 
     Check that getPermanence() returns values for a given float_type. 
@@ -203,6 +247,30 @@ class SpatialPoolerTest(unittest.TestCase):
     f.close();
     self.assertEqual(str(sp), str(sp3),  "File I/O SpatialPooler pickle/unpickle failed.")
 
+  @pytest.mark.skipif(sys.version_info < (3, 8), reason="Pickle protocol 5 is new in python 3.8")
+  def testPickleOutOfBand(self):
+    """Pickle protocol 5, the flat archive in an out-of-band buffer."""
+    inputs = SDR( 100 ).randomize( .05 )
+    active = SDR( 100 )
+    sp = SP( inputs.dimensions, active.dimensions, stimulusThreshold = 1 )
+    for _ in range(10):
+      sp.compute( inputs, True, active )
+
+    buffers = []
+    data = pickle.dumps(sp, protocol=5, buffer_callback=buffers.append)
+    self.assertEqual(len(buffers), 1)
+    sp2 = pickle.loads(data, buffers=buffers)
+    self.assertEqual(str(sp), str(sp2))
+    sp.compute( inputs, False, active )
+    active2 = SDR( active.dimensions )
+    sp2.compute( inputs, False, active2 )
+    self.assertEqual(active, active2)
+
+    # A buffer which is not aligned is copied.
+    unaligned = bytearray(1) + buffers[0].raw()
+    sp3 = pickle.loads(data, buffers=[memoryview(unaligned)[1:]])
+    self.assertEqual(str(sp), str(sp3))
+
     
 
   def testNupicSpatialPoolerSavingToString(self):
@@ -60,6 +60,44 @@ class TemporalMemoryBindingsTest(unittest.TestCase):
     self.assertTrue( active.getSum() > 0 )
 
 
+  def testRun(self):
+    """ run over a batch of records matches compute per record. """
+    sequence = [ SDR( 100 ).randomize( .05 ) for i in range(10) ]
+    dense = np.array([ x.dense for x in sequence ])
+    resets = np.zeros( len(sequence), dtype=bool )
+    resets[5] = True
+
+    tm = TM( [100], seed = 5 )
+    offsets, indices, anomaly = tm.run( dense, True, resets )
+
+    expected = TM( [100], seed = 5 )
+    for i, x in enumerate( sequence ):
+      if resets[i]:
+        expected.reset()
+      expected.compute( x, True )
+      self.assertEqual( list(indices[offsets[i] : offsets[i+1]]), list(expected.getActiveCells().sparse) )
+      self.assertAlmostEqual( anomaly[i], expected.anomaly )
+
+
+  def testLearnSequences(self):
+    """ learnSequences learns the same as compute per record. """
+    sequence = [ SDR( 100 ).randomize( .05 ) for i in range(10) ]
+    dense = np.array([ x.dense for x in sequence ])
+    resets = np.zeros( len(sequence), dtype=bool )
+    resets[5] = True
+
+    tm = TM( [100], seed = 5 )
+    tm.learnSequences( dense, resets )
+
+    expected = TM( [100], seed = 5 )
+    for i, x in enumerate( sequence ):
+      if resets[i]:
+        expected.reset()
+      expected.compute( x, True )
+    self.assertEqual( list(tm.getActiveCells().sparse), list(expected.getActiveCells().sparse) )
+    self.assertEqual( tm.connections.numSynapses(), expected.connections.numSynapses() )
+
+
   def testPerformanceLarge(self):
     LARGE = 9000
     ITERS = 100 # This is lowered for unittest. Try 1000, 5000,...
@@ -98,6 +136,26 @@ class TemporalMemoryBindingsTest(unittest.TestCase):
     self.assertEqual(tm.numberOfCells(), tm2.numberOfCells(),
                      "Simple NuPIC TemporalMemory pickle/unpickle failed.")
 
+  @pytest.mark.skipif(sys.version_info < (3, 8), reason="Pickle protocol 5 is new in python 3.8")
+  def testPickleOutOfBand(self):
+    """Pickle protocol 5, the state in an out-of-band buffer."""
+    inputs = SDR( 100 ).randomize( .05 )
+    tm = TM( inputs.dimensions )
+    for _ in range(10):
+      tm.compute( inputs, True )
+
+    buffers = []
+    data = pickle.dumps(tm, protocol=5, buffer_callback=buffers.append)
+    self.assertEqual(len(buffers), 1)
+    self.assertLess(len(data), 1000, "the state is not in the pickle stream")
+    tm2 = pickle.loads(data, buffers=[bytearray(b.raw()) for b in buffers])
+    self.assertEqual(str(tm), str(tm2))
+
+    # In band, and the unchanged older protocols.
+    for protocol in [5, 4]:
+      tm3 = pickle.loads(pickle.dumps(tm, protocol=protocol))
+      self.assertEqual(str(tm), str(tm3))
+
 
   @pytest.mark.skip(reason="Fails with rapidjson internal assertion -- indicates a bad serialization")
   def testNupicTemporalMemorySavingToString(self):
@@ -0,0 +1,246 @@
+# ----------------------------------------------------------------------
+# HTM Community Edition of NuPIC
+# Copyright (C) 2020, Numenta, Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+# See the GNU Affero Public License for more details.
+#
+# You should have received a copy of the GNU Affero Public License
+# along with this program.  If not, see http://www.gnu.org/licenses.
+# ----------------------------------------------------------------------
+
+"""
+Overhead of the Python bindings: the time per call of common operations from
+Python, next to the time of the same operation in C++, measured by the C++
+benchmarks (src/test/benchmarks, the executable 'benchmarks').  Every Python
+case does the work of its C++ benchmark, so the difference is the cost of
+crossing pybind11: argument conversion, the GIL, copies into numpy, and for
+the PyRegion the calls from the engine back into Python.
+
+Run from the root of the repository, after building:
+
+    python bindings/py/tests/benchmarks/binding_overhead.py
+    python bindings/py/tests/benchmarks/binding_overhead.py --cpp build/Release/bin/benchmarks --json overhead.json
+
+Without the C++ executable only the Python times are reported.
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import timeit
+
+from htm.bindings.algorithms import SpatialPooler, TemporalMemory
+from htm.bindings.encoders import ScalarEncoder, ScalarEncoderParameters
+from htm.bindings.regions.PyRegion import PyRegion
+from htm.bindings.sdr import SDR
+import htm.bindings.engine_internal as engine
+
+REPO_DIR = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", "..", "..", ".."))
+DEFAULT_CPP = os.path.join(REPO_DIR, "build", "Release", "bin", "benchmarks")
+
+
+class NullRegion(PyRegion):
+  """
+  A region which does nothing, for the cost of calling into a PyRegion.
+  """
+  def __init__(self, *args, **kwargs): pass
+  def initialize(self): pass
+  def compute(self, inputs, outputs): pass
+  def getOutputElementCount(self, name): return 1
+
+  @classmethod
+  def getSpec(cls):
+    return {
+      "description": NullRegion.__doc__,
+      "inputs": {},
+      "outputs": {
+        "out": {
+          "description": "Unused",
+          "dataType": "Real64",
+          "isDefaultOutput": True,
+          "required": False,
+          "count": 1
+        },
+      },
+      "parameters": {}
+    }
+
+
+# Each case: (name, the C++ benchmark doing the same work or None, setup).
+# setup() returns the function to time, it is called once per iteration.
+
+def sdrDense():
+  sdr = SDR(1024)
+  sdr.randomize(0.02, 42)
+  return lambda: sdr.dense
+
+def sdrSparseToDense():
+  sdr = SDR(1024)
+  sdr.randomize(0.02, 42)
+  sparse = sdr.sparse.copy()
+  def call():
+    sdr.sparse = sparse
+    return sdr.dense
+  return call
+
+def sdrDenseToSparse():
+  sdr = SDR(1024)
+  sdr.randomize(0.02, 42)
+  dense = sdr.dense.copy()
+  def call():
+    sdr.dense = dense
+    return sdr.sparse
+  return call
+
+def scalarEncoder():
+  p = ScalarEncoderParameters()
+  p.minimum = 0.0
+  p.maximum = 100.0
+  p.size = 1000
+  p.activeBits = p.size // 50
+  encoder = ScalarEncoder(p)
+  output = SDR(encoder.dimensions)
+  x = [0.0]
+  def call():
+    encoder.encode(x[0], output)
+    x[0] = x[0] + 0.37 if x[0] < 100.0 else 0.0
+  return call
+
+def spatialPooler():
+  sp = SpatialPooler(inputDimensions=[1024], columnDimensions=[1024], potentialRadius=1024,
+                     potentialPct=0.5, globalInhibition=True, localAreaDensity=0.02)
+  inputs = [SDR(1024).randomize(0.05, 42 + i) for i in range(16)]
+  active = SDR(1024)
+  i = [0]
+  def call():
+    sp.compute(inputs[i[0] % len(inputs)], False, active)
+    i[0] += 1
+  return call
+
+def temporalMemory():
+  tm = TemporalMemory(columnDimensions=[1024], cellsPerColumn=8)
+  sequence = [SDR(1024).randomize(0.02, 42 + i) for i in range(32)]
+  i = [0]
+  def call():
+    tm.compute(sequence[i[0] % len(sequence)], True)
+    i[0] += 1
+  return call
+
+def networkRun():
+  net = engine.Network()
+  net.addRegion("encoder", "RDSEEncoderRegion", "{size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}")
+  net.addRegion("sp", "SPRegion", "{columnCount: 64, globalInhibition: true}")
+  net.addRegion("tm", "TMRegion", "{cellsPerColumn: 8, orColumnOutputs: true}")
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn")
+  net.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn")
+  net.initialize()
+  encoder = net.getRegion("encoder")
+  x = [0.0]
+  def call():
+    encoder.setParameterReal64("sensedValue", x[0])
+    net.run(1)
+    x[0] += 0.01
+  return call
+
+def encoderNetwork(pyRegion):
+  net = engine.Network()
+  net.addRegion("encoder", "ScalarEncoderRegion", "{size: 100, activeBits: 10, minValue: 0, maxValue: 100}")
+  if pyRegion:
+    engine.Network.registerPyRegion(NullRegion.__module__, NullRegion.__name__)
+    net.addRegion("null", "py." + NullRegion.__name__, "")
+  net.initialize()
+  return lambda: net.run(1)
+
+CASES = [
+  ("SDR.dense",                       None,                                 sdrDense),
+  ("SDR.sparse= then .dense",         "BM_SDR_SparseToDense/1024/20",       sdrSparseToDense),
+  ("SDR.dense= then .sparse",         "BM_SDR_DenseToSparse/1024/20",       sdrDenseToSparse),
+  ("ScalarEncoder.encode",            "BM_ScalarEncoder/1000",              scalarEncoder),
+  ("SpatialPooler.compute",           "BM_SpatialPooler_Global/1024/0",     spatialPooler),
+  ("TemporalMemory.compute",          "BM_TemporalMemory_Compute/1024/8",   temporalMemory),
+  ("Network.run(1) encoder/SP/TM",    "BM_Network_Run/64",                  networkRun),
+  ("Network.run(1) encoder",          "BM_Network_RunEncoder",              lambda: encoderNetwork(False)),
+  ("Network.run(1) encoder+PyRegion", "BM_Network_RunEncoder",              lambda: encoderNetwork(True)),
+]
+
+
+def timePython(setup, minTime=0.2, repeat=5):
+  """ Returns the best time per call in microseconds. """
+  call = setup()
+  timer = timeit.Timer(call)
+  number, elapsed = timer.autorange()
+  number = max(1, int(number * minTime / max(elapsed, 1e-9)))
+  return min(timer.repeat(repeat=repeat, number=number)) / number * 1e6
+
+
+def timeCpp(executable, names):
+  """ Runs the C++ benchmarks @names, returns their time per iteration in microseconds by name. """
+  names = sorted(set(n for n in names if n))
+  if not executable or not os.path.isfile(executable) or not names:
+    return {}
+  regex = "^(" + "|".join(names) + ")$"
+  out = subprocess.check_output([executable, "--benchmark_filter=" + regex,
+                                 "--benchmark_format=json"])
+  scale = {"ns": 1e-3, "us": 1.0, "ms": 1e3, "s": 1e6}
+  times = {}
+  for b in json.loads(out.decode("utf-8"))["benchmarks"]:
+    if b.get("run_type", "iteration") == "iteration":
+      times[b["name"]] = b["real_time"] * scale[b["time_unit"]]
+  return times
+
+
+def run(cases=CASES, cpp=DEFAULT_CPP, minTime=0.2, repeat=5):
+  """ Returns a list of dicts: case, cpp benchmark, python_us, cpp_us, overhead_us. """
+  cppTimes = timeCpp(cpp, [c[1] for c in cases])
+  results = []
+  for name, benchmark, setup in cases:
+    python = timePython(setup, minTime, repeat)
+    native = cppTimes.get(benchmark)
+    results.append({
+      "case": name,
+      "cpp_benchmark": benchmark,
+      "python_us": python,
+      "cpp_us": native,
+      "overhead_us": None if native is None else python - native,
+    })
+  return results
+
+
+def report(results, out=sys.stdout):
+  fmt = "{:<34} {:>12} {:>12} {:>12} {:>8}\n"
+  out.write(fmt.format("case", "python us", "c++ us", "overhead us", "ratio"))
+  for r in results:
+    num = lambda v: "-" if v is None else "{:.3f}".format(v)
+    ratio = "-" if not r["cpp_us"] else "{:.1f}x".format(r["python_us"] / r["cpp_us"])
+    out.write(fmt.format(r["case"], num(r["python_us"]), num(r["cpp_us"]), num(r["overhead_us"]), ratio))
+
+
+def main(argv=None):
+  parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument("--cpp", default=DEFAULT_CPP, help="the C++ benchmarks executable")
+  parser.add_argument("--filter", default="", help="only the cases whose name contains this")
+  parser.add_argument("--min-time", type=float, default=0.2, help="seconds per repetition")
+  parser.add_argument("--json", help="also write the results to this file")
+  args = parser.parse_args(argv)
+
+  cases = [c for c in CASES if args.filter in c[0]]
+  if not os.path.isfile(args.cpp):
+    sys.stderr.write("No C++ benchmarks at {}, only timing Python.\n".format(args.cpp))
+  results = run(cases, args.cpp, args.min_time)
+  report(results)
+  if args.json:
+    with open(args.json, "w") as f:
+      json.dump(results, f, indent=2)
+
+
+if __name__ == "__main__":
+  main()
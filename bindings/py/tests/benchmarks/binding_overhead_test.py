@@ -0,0 +1,46 @@
+# ----------------------------------------------------------------------
+# HTM Community Edition of NuPIC
+# Copyright (C) 2020, Numenta, Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+# See the GNU Affero Public License for more details.
+#
+# You should have received a copy of the GNU Affero Public License
+# along with this program.  If not, see http://www.gnu.org/licenses.
+# ----------------------------------------------------------------------
+
+""" Keeps the binding overhead benchmarks runnable, it does not time anything. """
+
+import io
+import unittest
+
+import binding_overhead
+
+
+class BindingOverheadTest(unittest.TestCase):
+
+  def testCasesRun(self):
+    for name, benchmark, setup in binding_overhead.CASES:
+      call = setup()
+      for _ in range(3):
+        call()
+
+  def testReport(self):
+    results = binding_overhead.run(binding_overhead.CASES[:2], cpp=None, minTime=0.001, repeat=1)
+    self.assertEqual(2, len(results))
+    for r in results:
+      self.assertGreater(r["python_us"], 0.0)
+      self.assertIsNone(r["cpp_us"])
+    out = io.StringIO()
+    binding_overhead.report(results, out)
+    self.assertIn("SDR.dense", out.getvalue())
+
+
+if __name__ == "__main__":
+  unittest.main()
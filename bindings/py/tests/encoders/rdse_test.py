@@ -241,6 +241,20 @@ class RDSE_Test(unittest.TestCase):
         print( A )
         assert( A == GOLD )
 
+    def testEncodeBatch(self):
+        """ encodeBatch returns the encodings of all values as (offsets, indices). """
+        P = RDSE_Parameters()
+        P.size       = 1000
+        P.sparsity   = .05
+        P.resolution = .5
+        P.seed       = 1
+        R = RDSE( P )
+        values = np.array([ 0, 1.5, -3, 1000 ])
+        offsets, indices = R.encodeBatch( values )
+        assert( len(offsets) == len(values) + 1 )
+        for i, x in enumerate( values ):
+            assert( list(indices[offsets[i] : offsets[i+1]]) == list(R.encode( x ).sparse) )
+
     def testSeed(self):
         P = RDSE_Parameters()
         P.size     = 1000
@@ -108,6 +108,21 @@ class TestNupicRandom(unittest.TestCase):
     self.assertNotEqual(test2, test4,
                         "NuPIC random gave the same result twice.")
 
+  def testSplit(self):
+    r = Random(42)
+    s1 = r.split(3)
+    test1 = [s1.getUInt32() for _ in range(10)]
+    r.getUInt32()
+    s2 = r.split(3)
+    test2 = [s2.getUInt32() for _ in range(10)]
+    self.assertEqual(test1, test2, "Substreams must not depend on the generator state.")
+    self.assertNotEqual(test1, [r.split(4).getUInt32() for _ in range(10)])
+
+    s3 = pickle.loads(pickle.dumps(s1))
+    self.assertEqual([s1.getUInt32() for _ in range(10)],
+                     [s3.getUInt32() for _ in range(10)])
+
+
   def testSample(self):
     r = Random(42)
     population = numpy.array([1, 2, 3, 4], dtype="uint32")
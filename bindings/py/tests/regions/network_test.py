@@ -93,6 +93,16 @@ class LinkRegion(PyRegion):
       "parameters": { }
     }
 
+class ReplacingRegion(LinkRegion):
+  """
+  Test region which replaces the items of the dicts that compute() gets
+  """
+  def compute(self, inputs, outputs):
+    for key in inputs:
+      outputs[key][:] = inputs[key]
+      inputs[key] = None
+      outputs[key] = None
+
 class NetworkTest(unittest.TestCase):
 
   def setUp(self):
@@ -286,6 +296,26 @@ class NetworkTest(unittest.TestCase):
     output = r_to.getOutputArray("UInt32")
     self.assertTrue(np.array_equal(output, TEST_DATA))
 
+  def testPyRegionComputeViews(self):
+    """
+    The inputs and outputs dicts and their numpy views are reused by every
+    compute, they must show the data of the current iteration.
+    """
+    engine.Network.registerPyRegion(ReplacingRegion.__module__, ReplacingRegion.__name__)
+
+    network = engine.Network()
+    r_from = network.addRegion("from", "py.LinkRegion", "")
+    r_to = network.addRegion("to", "py.ReplacingRegion", "")
+    network.link("from", "to", "", "", "UInt32", "UInt32")
+    network.initialize()
+
+    for i in range(4):
+      data = np.array(TEST_DATA) * (i + 1)
+      r_from.setInputArray("UInt32", data)
+      network.run(1)
+      output = np.array(r_to.getOutputArray("UInt32"))
+      self.assertTrue(np.array_equal(output, data), "iteration %d: %s" % (i, output))
+
     
 
   def testBuiltInRegions(self):
@@ -380,3 +410,34 @@ class NetworkTest(unittest.TestCase):
     self.assertEqual(s1, s2,  "Simple Network pickle/unpickle failed.")
 
 
+
+  @pytest.mark.skipif(sys.version_info < (3, 7), reason="asyncio.get_running_loop is new in python 3.7")
+  def testRunAsync(self):
+    """
+    Network.run_async() from an asyncio event loop, several networks at once.
+    """
+    import asyncio
+
+    def build():
+      net = engine.Network()
+      net.addRegion("level1", "TestNode", "{dim: [2]}")
+      net.addRegion("level2", "TestNode", "")
+      net.link("level1", "level2")
+      net.initialize()
+      return net
+
+    serial = build()
+    serial.run(5)
+    nets = [build() for _ in range(8)]
+
+    async def runAll():
+      await asyncio.gather(*[net.run_async(5, asyncio.get_running_loop()) for net in nets])
+
+    loop = asyncio.new_event_loop()
+    try:
+      loop.run_until_complete(runAll())
+    finally:
+      loop.close()
+    expected = serial.getRegion("level2").getOutputArray("bottomUpOut")
+    for net in nets:
+      self.assertTrue(np.array_equal(expected, net.getRegion("level2").getOutputArray("bottomUpOut")))
@@ -170,6 +170,27 @@ class SdrTest(unittest.TestCase):
         else:
             self.fail()
 
+    def testSparseNumpy(self):
+        A = SDR( 100 )
+        A.sparse = np.array([ 3, 7, 50 ], dtype=np.uint32)
+        assert( list(A.sparse) == [3, 7, 50] )
+        A.sparse = np.array([ 50, 3, 7 ], dtype=np.int64)
+        assert( list(A.sparse) == [3, 7, 50] )
+        A.sparse = A.sparse
+        assert( list(A.sparse) == [3, 7, 50] )
+        A.sparse = A.sparse[1:]
+        assert( list(A.sparse) == [7, 50] )
+        for bad in ([ 3, 3 ], [ 1, 100 ], [ 100, 1 ]):
+            with self.assertRaises( RuntimeError ):
+                A.sparse = np.array( bad, dtype=np.uint32 )
+
+        dense = np.zeros( 100, dtype=bool )
+        dense[[ 4, 8 ]] = True
+        A.dense = dense
+        assert( list(A.sparse) == [4, 8] )
+        A.dense = np.arange( 200 ).reshape( 2, 100 )[1] % 2
+        assert( A.getSum() == 50 )
+
     def testCoordinates(self):
         A = SDR((103,))
         B = SDR((100, 100, 1))
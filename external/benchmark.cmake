@@ -0,0 +1,50 @@
+# -----------------------------------------------------------------------------
+# HTM Community Edition of NuPIC
+# Copyright (C) 2020, Numenta, Inc.
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU Affero Public License version 3 as
+# published by the Free Software Foundation.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+# See the GNU Affero Public License for more details.
+#
+# You should have received a copy of the GNU Affero Public License
+# along with this program.  If not, see http://www.gnu.org/licenses.
+# -----------------------------------------------------------------------------
+#
+# This will load google/benchmark, for the 'benchmarks' target.
+# exports 'benchmark' as a target
+#
+
+if(EXISTS "${REPOSITORY_DIR}/build/ThirdParty/share/benchmark.tar.gz")
+    set(URL "${REPOSITORY_DIR}/build/ThirdParty/share/benchmark.tar.gz")
+else()
+    set(URL https://github.com/google/benchmark/archive/v1.5.2.tar.gz)
+endif()
+
+#
+# Build benchmark lib
+#
+message(STATUS "Obtaining benchmark")
+include(DownloadProject/DownloadProject.cmake)
+download_project(PROJ benchmark
+	PREFIX ${EP_BASE}/benchmark
+	URL ${URL}
+	UPDATE_DISCONNECTED 1
+	QUIET
+	)
+set(BENCHMARK_ENABLE_TESTING      OFF CACHE BOOL "prevents building the benchmark tests"  FORCE)
+set(BENCHMARK_ENABLE_GTEST_TESTS  OFF CACHE BOOL "prevents building the benchmark gtests" FORCE)
+set(BENCHMARK_ENABLE_INSTALL      OFF CACHE BOOL "prevents installing benchmark"          FORCE)
+add_subdirectory(${benchmark_SOURCE_DIR} ${benchmark_BINARY_DIR})
+
+if(MSVC)
+  set(benchmark_LIBRARIES ${benchmark_BINARY_DIR}/src/$<$<CONFIG:Release>:Release>$<$<CONFIG:Debug>:Debug>/${CMAKE_STATIC_LIBRARY_PREFIX}benchmark${CMAKE_STATIC_LIBRARY_SUFFIX})
+else()
+  set(benchmark_LIBRARIES ${benchmark_BINARY_DIR}/src/${CMAKE_STATIC_LIBRARY_PREFIX}benchmark${CMAKE_STATIC_LIBRARY_SUFFIX})
+endif()
+FILE(APPEND "${EXPORT_FILE_NAME}" "benchmark_INCLUDE_DIRS@@@${benchmark_SOURCE_DIR}/include\n")
+FILE(APPEND "${EXPORT_FILE_NAME}" "benchmark_LIBRARIES@@@${benchmark_LIBRARIES}\n")
@@ -21,7 +21,9 @@ import numpy
 import inspect
 
 from htm.bindings.regions.PyRegion import PyRegion
-from htm.advanced.algorithms.column_pooler import ColumnPooler
+from htm.bindings.algorithms import ColumnPooler
+# The python reference implementation, it documents the constructor arguments.
+from htm.advanced.algorithms.column_pooler import ColumnPooler as ColumnPoolerReference
 
 
 def getConstructorArguments():
@@ -29,7 +31,7 @@ def getConstructorArguments():
     Return constructor argument associated with ColumnPooler.
     @return defaults (list)     a list of args and default values for each argument
     """
-    argspec = inspect.getargspec(ColumnPooler.__init__)
+    argspec = inspect.getargspec(ColumnPoolerReference.__init__)
     return argspec.args[1:], argspec.defaults
 
 
@@ -22,6 +22,8 @@ import itertools
 
 import numpy as np
 from htm.bindings.math import Random
+from htm.bindings.encoders import CoordinateEncoder as CoordinateEncoder_
+from htm.bindings.encoders import CoordinateEncoderParameters
 
 
 class CoordinateEncoder():
@@ -49,6 +51,8 @@ class CoordinateEncoder():
     5. This results in a final SDR with exactly W bits active (barring chance hash
          collisions).
 
+    The encoding is computed by the C++ htm.bindings.encoders.CoordinateEncoder,
+    the helper methods of this class are the python reference of its hashes.
     """
 
     def __init__(self, w=21, n=1000, name=None, verbosity=0):
@@ -66,6 +70,11 @@ class CoordinateEncoder():
         self.verbosity = verbosity
         self.encoders = None
 
+        parameters = CoordinateEncoderParameters()
+        parameters.size = n
+        parameters.activeBits = w
+        self._encoder = CoordinateEncoder_(parameters)
+
         if name is None:
             name = "[%s:%s]" % (self.n, self.w)
         self.name = name
@@ -120,13 +129,7 @@ class CoordinateEncoder():
 
         assert isinstance(radius, int), ("Expected integer radius, got: {} ({})".format(radius, type(radius)))
 
-        neighbors = self._neighbors(coordinate, radius)
-        winners = self._topWCoordinates(neighbors, self.w)
-
-        bitFn = lambda coordinate: self._bitForCoordinate(coordinate, self.n)
-        indices = np.array([bitFn(w) for w in winners])
-
-        output.sparse = list(set(indices))
+        self._encoder.encode([int(v) for v in coordinate], radius, output)
 
 
     @staticmethod
@@ -15,11 +15,10 @@
 # ------------------------------------------------------------------------------
 
 import numpy as np
-import math
-import hexy
 
 from htm.bindings.sdr import SDR
-from htm.bindings.math import Random
+from htm.bindings.encoders import GridCellEncoder as GridCellEncoder_
+from htm.bindings.encoders import GridCellEncoderParameters
 
 class GridCellEncoder:
     """
@@ -28,6 +27,8 @@ class GridCellEncoder:
     cells with a common grid spacing and orientation.  Different modules have
     different spacings & orientations.
 
+    The encoding is computed by the C++ htm.bindings.encoders.GridCellEncoder.
+
     For example usage and to inspect the output of this encoder run:
     $ python3 -m htm.encoders.grid_cell_encoder
     """
@@ -59,23 +60,12 @@ class GridCellEncoder:
         assert(self.sparsity >= 0)
         assert(self.sparsity <= 1)
 
-        # Assign each module a range of cells in the output SDR.
-        partitions       = np.linspace(0, self.size, num=len(self.periods) + 1)
-        partitions       = list(zip(partitions, partitions[1:]))
-        self.partitions_ = [(int(round(start)), int(round(stop)))
-                                        for start, stop in partitions]
-
-        # Assign each module a random offset and orientation.
-        rng            = np.random.RandomState(seed = Random(seed).getUInt32())
-        self.offsets_  = rng.uniform(0, max(self.periods)*9, size=(self.size, 2))
-        self.angles_   = []
-        self.rot_mats_ = []
-        for period in self.periods:
-            angle = rng.uniform() * 2 * math.pi
-            self.angles_.append(angle)
-            c, s = math.cos(angle), math.sin(angle)
-            R    = np.array(((c,-s), (s, c)))
-            self.rot_mats_.append(R)
+        parameters          = GridCellEncoderParameters()
+        parameters.size     = self.size
+        parameters.sparsity = self.sparsity
+        parameters.periods  = list(self.periods)
+        parameters.seed     = seed
+        self.encoder_       = GridCellEncoder_(parameters)
 
     def reset(self):
         """ Does nothing, GridCellEncoder holds no state. """
@@ -92,38 +82,14 @@ class GridCellEncoder:
 
         Returns grid_cells, an SDR object.  This will be created if not given.
         """
-        location = list(location)
+        location = [float(x) for x in location]
         assert(len(location) == 2)
         if grid_cells is None:
             grid_cells = SDR((self.size,))
         else:
             assert(isinstance(grid_cells, SDR))
             assert(grid_cells.dimensions == [self.size])
-        if any(math.isnan(x) for x in location):
-            grid_cells.zero()
-            return grid_cells
-
-        # Find the distance from the location to each grid cells nearest
-        # receptive field center.
-        # Convert the units of location to hex grid with angle 0, scale 1, offset 0.
-        displacement = location - self.offsets_
-        radius       = np.empty(self.size)
-        for mod_idx in range(len(self.partitions_)):
-            start, stop = self.partitions_[mod_idx]
-            R           = self.rot_mats_[mod_idx]
-            displacement[start:stop] = R.dot(displacement[start:stop].T).T
-            radius[start:stop] = self.periods[mod_idx] / 2
-        # Convert into and out of hexagonal coordinates, which rounds to the
-        # nearest hexagons center.
-        nearest = hexy.cube_to_pixel(hexy.pixel_to_cube(displacement, radius), radius)
-        # Find the distance between the location and the RF center.
-        distances = np.hypot(*(nearest - displacement).T)
-        # Activate the closest grid cells in each module.
-        index = []
-        for start, stop in self.partitions_:
-            z = int(round(self.sparsity * (stop - start)))
-            index.extend( np.argpartition(distances[start : stop], z)[:z] + start )
-        grid_cells.sparse = index
+        self.encoder_.encode(location, grid_cells)
         return grid_cells
 
 
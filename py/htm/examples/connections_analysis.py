@@ -26,6 +26,7 @@ def main(connections, show=True):
     segmentsPerCell( connections, show=False)
     potentialSynapsesPerSegment( connections, show=False)
     connectedSynapsesPerSegment( connections, show=False)
+    synapsesPerPresynapticCell( connections, show=False)
     permanences( connections, show=False)
     if show:
         plt.show()
@@ -78,6 +79,20 @@ def connectedSynapsesPerSegment(connections, show=True):
         plt.show()
 
 
+def synapsesPerPresynapticCell(connections, show=True):
+    # Histogram of outgoing synapses per presynaptic cell, from the CSR export
+    offsets, synapses, numConnected = connections.presynapticAdjacency()
+    potential = np.diff( offsets ) - numConnected
+    plt.figure("Histogram of Synapses per Presynaptic Cell")
+    plt.hist( [numConnected, potential], bins = 50, label = ["connected", "potential"] )
+    plt.legend()
+    plt.title("Histogram of Synapses per Presynaptic Cell")
+    plt.ylabel("Number of Presynaptic Cells")
+    plt.xlabel("Number of Synapses")
+    if show:
+        plt.show()
+
+
 def permanences(connections, show=True):
     # Histogram of synapse permanences
     # Draw vertical line at the connected synapse permanece threshold
@@ -22,7 +22,7 @@ import sys
 # fetch datasets from www.openML.org/ 
 from sklearn.datasets import fetch_openml
 
-from htm.bindings.algorithms import SpatialPooler, Classifier
+from htm.bindings.algorithms import SpatialPooler, Classifier, ModelEvaluator
 from htm.bindings.sdr import SDR, Metrics
 
 
@@ -79,20 +79,9 @@ default_parameters = {
 }
 
 
-def main(parameters=default_parameters, argv=None, verbose=True):
-
-    # Load data.
-    train_labels, train_images, test_labels, test_images = load_ds('mnist_784', 10000, shape=[28,28]) # HTM: ~95.6%
-    #train_labels, train_images, test_labels, test_images = load_ds('Fashion-MNIST', 10000, shape=[28,28]) # HTM baseline: ~83%
-
-    training_data = list(zip(train_images, train_labels))
-    test_data     = list(zip(test_images, test_labels))
-    random.shuffle(training_data)
-
-    # Setup the AI.
-    enc = SDR(train_images[0].shape)
-    sp = SpatialPooler(
-        inputDimensions            = enc.dimensions,
+def make_sp(parameters, input_dimensions, seed, verbosity=0):
+    return SpatialPooler(
+        inputDimensions            = input_dimensions,
         columnDimensions           = parameters['columnDimensions'],
         potentialRadius            = parameters['potentialRadius'],
         potentialPct               = parameters['potentialPct'],
@@ -105,9 +94,24 @@ def main(parameters=default_parameters, argv=None, verbose=True):
         minPctOverlapDutyCycle     = parameters['minPctOverlapDutyCycle'],
         dutyCyclePeriod            = int(round(parameters['dutyCyclePeriod'])),
         boostStrength              = parameters['boostStrength'],
-        seed                       = 0, # this is important, 0="random" seed which changes on each invocation
-        spVerbosity                = 99,
+        seed                       = seed, # this is important, 0="random" seed which changes on each invocation
+        spVerbosity                = verbosity,
         wrapAround                 = False)
+
+
+def main(parameters=default_parameters, argv=None, verbose=True):
+
+    # Load data.
+    train_labels, train_images, test_labels, test_images = load_ds('mnist_784', 10000, shape=[28,28]) # HTM: ~95.6%
+    #train_labels, train_images, test_labels, test_images = load_ds('Fashion-MNIST', 10000, shape=[28,28]) # HTM baseline: ~83%
+
+    training_data = list(zip(train_images, train_labels))
+    test_data     = list(zip(test_images, test_labels))
+    random.shuffle(training_data)
+
+    # Setup the AI.
+    enc = SDR(train_images[0].shape)
+    sp = make_sp(parameters, enc.dimensions, seed=0, verbosity=99)
     columns = SDR( sp.getColumnDimensions() )
     columns_stats = Metrics( columns, 99999999 )
     sdrc = Classifier()
@@ -134,6 +138,41 @@ def main(parameters=default_parameters, argv=None, verbose=True):
     print('Score:', 100 * score, '%')
     return score
 
+
+# The encoded dataset, shared by all the batches of main_batch().
+_evaluator = None
+
+def main_batch(parameters, argv=None, verbose=True):
+    """
+    Evaluates a list of parameter sets at once, for the parameter optimization
+    (see py/htm/optimization/ae.py).  The dataset is loaded and encoded once,
+    then the models of each batch are trained and tested in parallel, on all
+    cores.  Returns the list of scores.
+    """
+    global _evaluator
+    if _evaluator is None:
+        train_labels, train_images, test_labels, test_images = load_ds('mnist_784', 10000, shape=[28,28])
+        permutation = np.random.permutation(len(train_images))
+        train_labels, train_images = train_labels[permutation], train_images[permutation]
+
+        # Encode all images at once, one dense row per image, as encode() does.
+        def encode_all(images):
+            rows = images.reshape(len(images), -1)
+            return rows >= np.mean(rows, axis=1, keepdims=True)
+
+        dimensions = list(train_images[0].shape)
+        _evaluator = ModelEvaluator()
+        _evaluator.setTrainingData(encode_all(train_images), train_labels.astype(np.uint32), dimensions=dimensions)
+        _evaluator.setTestData(encode_all(test_images), test_labels.astype(np.uint32), dimensions=dimensions)
+
+    models = [make_sp(p, [28, 28], seed=0) for p in parameters]
+    scores = [s.accuracy for s in _evaluator.evaluate(models)]
+    if verbose:
+        for p, score in zip(parameters, scores):
+            print(p, 'Score:', 100 * score, '%')
+    return scores
+
+
 # baseline: without SP (only Classifier = logistic regression): 90.1%
 # kNN: ~97%
 # human: ~98%
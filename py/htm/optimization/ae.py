@@ -465,6 +465,37 @@ class Laboratory:
                     self.method.collect_results( X.parameters, trial.score )
                     self.save()     # Write the updated Lab Report to file.
 
+    def run_batch(self, batch_size):
+        """
+        Main loop of the AE program for experiments which define the function
+        `main_batch(parameters, argv=None, verbose=True)`.  It evaluates a list
+        of parameter sets at once and returns a list of scores (or exceptions),
+        eg. with htm.bindings.algorithms.ModelEvaluator which runs the models on
+        all cores.  The batch runs in this process, so the experiment module and
+        its dataset are loaded only once.
+        """
+        while True:
+            batch = [self.get_experiment( self.method.suggest_parameters() )
+                        for _ in range(batch_size)]
+            try:
+                scores = self.module.main_batch(
+                            parameters = [X.parameters for X in batch],
+                            argv       = self.argv[1:],
+                            verbose    = self.verbose)
+                assert( len(scores) == len(batch) )
+            except Exception as err:
+                scores = [err] * len(batch)
+
+            for X, score in zip(batch, scores):
+                X.attempts += 1
+                if not isinstance(score, Exception):
+                    X.scores.append( score )
+                else:
+                    print("Parameters", str( X.parameters ))
+                    print("%s:"%(type(score).__name__), score)
+                self.method.collect_results( X.parameters, score )
+            self.save()     # Write the updated Lab Report to file.
+
 
 class Worker(Process):
     """
@@ -646,6 +677,11 @@ if __name__ == '__main__':
     else:
         ae.method = selected_method[0]( ae, args )
 
+        if hasattr(ae.module, 'main_batch'):
+            ae.run_batch( batch_size = args.processes )
+            print("Exit.")
+            sys.exit()
+
         giga = 2**30
         if args.memory_limit is not None:
             memory_limit = int(args.memory_limit * giga)
@@ -44,7 +44,8 @@ Real64 BenchmarkHelloSPTP::run(UInt EPOCHS, bool useSPlocal, bool useSPglobal, b
 EPOCHS = 2; // make test faster in Debug
 #endif
 
-#if defined __aarch64__ || defined __arm__
+// The gold outputs are those of float permanences, @see NTA_PERMANENCE_BITS
+#if defined __aarch64__ || defined __arm__ || (defined NTA_PERMANENCE_BITS && NTA_PERMANENCE_BITS != 32)
 #undef _ARCH_DETERMINISTIC
 #else
 #define _ARCH_DETERMINISTIC
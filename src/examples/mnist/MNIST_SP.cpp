@@ -28,13 +28,32 @@
  *
  * Note: If you omit the num_images param, it'll run at full MNIST train dataset (default). 
  * You can use the 1st arg to make the training shorter. 
+ *
+ * Benchmark mode:
+ * ./bin/mnist_sp [num_images] --benchmark [--threads=N] [--batch=N]
+ *
+ * Skips the baseline and reports the samples/s of the training and of the
+ * inference over the test set, each with a breakdown of the time per phase
+ * (encode, SP overlap, inhibition, learn, classifier).  The inference runs
+ * twice:
+ *  - batched, SpatialPooler::compute(inputs, outputs) over batches of N
+ *    images (default 1000) with N threads for the overlaps,
+ *  - threaded, the frozen SP and the classifier on N threads (default 1,
+ *    0 = all hardware threads), each with its own slice of the test set.
+ * Both must give the same score.
  */
 
+#include <algorithm>
 #include <cstdint> //uint8_t
+#include <iomanip>
 #include <iostream>
 #include <fstream>      // std::ofstream
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#include <htm/algorithms/FrozenSpatialPooler.hpp>
 #include <htm/algorithms/SpatialPooler.hpp>
 #include <htm/algorithms/SDRClassifier.hpp>
 #include <htm/utils/SdrMetrics.hpp>
@@ -78,6 +97,30 @@ class MNIST {
   public:
     UInt verbosity = 1;
     const UInt train_dataset_iterations = 1u; //epochs somewhat help, at linear time
+    bool benchmark = false; //report samples/s and the time per phase
+
+    // seconds per phase, in order
+    typedef vector<pair<string, Real64>> Phases;
+
+// Prints the throughput and the share of each phase in @param seconds of wall time.
+static void report(const string &name, const size_t samples, const Real64 seconds, const Phases &phases) {
+  cout << name << ": " << samples << " samples in " << seconds << " s, "
+       << (seconds > 0.0 ? samples / seconds : 0.0) << " samples/s" << endl;
+  for(const auto &phase : phases) {
+    cout << "    " << left << setw(12) << phase.first << right << setw(10) << phase.second << " s";
+    if(seconds > 0.0) cout << "  (" << setw(5) << fixed << setprecision(1) << 100.0 * phase.second / seconds << "%)";
+    cout << defaultfloat << setprecision(6) << endl;
+  }
+}
+
+// The SP stages timed by its AlgorithmStats, in seconds.
+Real64 spSeconds(const string &timer) const {
+  const auto &stats = sp.getStats();
+  for(size_t i = 0; i < stats.numTimers(); i++) {
+    if(stats.getTimerName(i) == timer) return stats.getSeconds(i);
+  }
+  return 0.0;
+}
 
 
 void setup() {
@@ -131,6 +174,9 @@ void train(const bool skipSP=false, const UInt maxSamples=0 /* 0=unlimited, or l
   Metrics inputStats(input,    1402);
   Metrics columnStats(columns, 1402);
 
+  sp.getStats().reset();
+  sp.getStats().enable(benchmark);
+  Timer tEncode, tClassifier;
   Timer tTrain(true);
 
   UInt sample = 0;
@@ -139,7 +185,7 @@ void train(const bool skipSP=false, const UInt maxSamples=0 /* 0=unlimited, or l
     // Shuffle the training data.
     vector<UInt> index( dataset.training_labels.size() );
     for (UInt i=0; i<dataset.training_labels.size(); i++) {
-      index.push_back(i);
+      index[i] = i;
     }
     Random().shuffle( index.begin(), index.end() );
 
@@ -149,10 +195,14 @@ void train(const bool skipSP=false, const UInt maxSamples=0 /* 0=unlimited, or l
       const UInt label  = dataset.training_labels.at(idx);
 
       // Compute & Train
+      if(benchmark) tEncode.start();
       input.setDense( image );
+      if(benchmark) tEncode.stop();
       if(not skipSP) 
         sp.compute(input, true, columns);
+      if(benchmark) tClassifier.start();
       clsr.learn( skipSP ? input : columns, {label} );
+      if(benchmark) tClassifier.stop();
       if( verbosity && (++i % 1000 == 0) ) cout << "." << flush;
       sample++;
       if(maxSamples > 0 and sample >= maxSamples) {
@@ -170,6 +220,14 @@ void train(const bool skipSP=false, const UInt maxSamples=0 /* 0=unlimited, or l
   
   tTrain.stop();
   cout << "MNIST train time: " << tTrain.getElapsed() << endl; 
+  if(benchmark) {
+    report("train", sample, tTrain.getElapsed(), {
+      {"encode",     tEncode.getElapsed()},
+      {"overlap",    spSeconds("overlap")},
+      {"inhibition", spSeconds("inhibition")},
+      {"learn",      spSeconds("adapt") + spSeconds("dutyCycles") + spSeconds("boost")},
+      {"classifier", tClassifier.getElapsed()}});
+  }
 
   // Save the connections to file for postmortem analysis.
   ofstream dump("mnist_sp_learned.connections", ofstream::binary | ofstream::trunc | ofstream::out);
@@ -183,18 +241,22 @@ void test(const bool skipSP=false) {
   UInt n_samples = 0;
   if(verbosity)
     cout << "Testing for " << dataset.test_labels.size() << " cycles ..." << endl;
+  // Compute, the SP does not learn here so the whole test set is one batch
+  vector<SDR> inputs(dataset.test_labels.size(), input);
   for(UInt i = 0; i < dataset.test_labels.size(); i++) {
-    // Get the input & label
-    const auto image  = dataset.test_images.at(i);
-    const UInt label  = dataset.test_labels.at(i);
+    inputs[i].setDense( dataset.test_images.at(i) );
+  }
+  vector<SDR> outputs;
+  if(not skipSP) {
+    sp.compute(inputs, outputs);
+    if(not outputs.empty()) columns = outputs.back();
+  }
 
-    // Compute
-    input.setDense( image );
-    if(not skipSP) 
-      sp.compute(input, false, columns);
+  for(UInt i = 0; i < dataset.test_labels.size(); i++) {
+    const UInt label  = dataset.test_labels.at(i);
 
     // Check results
-    if( argmax( clsr.infer( skipSP ? input : columns ) ) == label)
+    if( argmax( clsr.infer( skipSP ? inputs[i] : outputs[i] ) ) == label)
         score += 1;
     n_samples += 1;
     if( verbosity && i % 1000 == 0 ) cout << "." << flush;
@@ -205,15 +267,156 @@ void test(const bool skipSP=false) {
   cout << "SDR example: " << columns << endl;
 }
 
+
+size_t numTestImages() const { return dataset.test_labels.size(); }
+
+
+/**
+ *  Benchmark of the inference over the test set with SpatialPooler::compute
+ *  of batches of @param batchSize images, the overlaps on @param numThreads.
+ *  @returns the number of correct classifications.
+ */
+UInt testBatched(const UInt batchSize, const UInt numThreads) {
+  const size_t numImages = dataset.test_labels.size();
+  sp.setNumThreads(numThreads);
+  sp.getStats().reset();
+  sp.getStats().enable(true);
+  Timer tEncode, tClassifier;
+  Timer tTest(true);
+
+  UInt score = 0;
+  vector<SDR> inputs;
+  vector<SDR> outputs;
+  PDF pdf;
+  for(size_t begin = 0; begin < numImages; begin += batchSize) {
+    const size_t end = std::min(numImages, begin + batchSize);
+    tEncode.start();
+    inputs.resize(end - begin, input);
+    for(size_t i = begin; i < end; i++) {
+      inputs[i - begin].setDense( dataset.test_images[i] );
+    }
+    tEncode.stop();
+
+    sp.compute(inputs, outputs);
+
+    tClassifier.start();
+    for(size_t i = begin; i < end; i++) {
+      clsr.infer( outputs[i - begin], pdf );
+      score += argmax( pdf ) == dataset.test_labels[i];
+    }
+    tClassifier.stop();
+  }
+  tTest.stop();
+
+  report("infer batched (batch " + to_string(batchSize) + ", " + to_string(numThreads) + " threads)",
+         numImages, tTest.getElapsed(), {
+      {"encode",     tEncode.getElapsed()},
+      {"overlap",    spSeconds("overlap")},
+      {"inhibition", spSeconds("inhibition")},
+      {"classifier", tClassifier.getElapsed()}});
+  sp.setNumThreads(1u);
+  return score;
+}
+
+
+/**
+ *  Benchmark of the inference over the test set on @param numThreads
+ *  threads, which share the frozen SP and the classifier.  The phases are
+ *  summed over the threads, so they can exceed the elapsed time.
+ *  @returns the number of correct classifications.
+ */
+UInt testThreaded(UInt numThreads) {
+  if(numThreads == 0u) numThreads = std::max(1u, std::thread::hardware_concurrency());
+  const size_t numImages = dataset.test_labels.size();
+  const FrozenSpatialPooler frozen = sp.freeze();
+
+  struct Worker {
+    UInt score = 0;
+    Timer tEncode, tSP, tClassifier;
+  };
+  vector<Worker> workers(numThreads);
+  const auto work = [&](const UInt t) {
+    Worker &w = workers[t];
+    FrozenSpatialPooler::Scratch scratch;
+    SDR image(input.dimensions);
+    SDR active(columns.dimensions);
+    PDF pdf;
+    // Contiguous slices, so each thread walks its own part of the dataset.
+    const size_t begin = numImages * t / numThreads;
+    const size_t end   = numImages * (t + 1u) / numThreads;
+    for(size_t i = begin; i < end; i++) {
+      w.tEncode.start();
+      image.setDense( dataset.test_images[i] );
+      w.tEncode.stop();
+      w.tSP.start();
+      frozen.compute(image, active, scratch);
+      w.tSP.stop();
+      w.tClassifier.start();
+      clsr.infer( active, pdf );
+      w.score += argmax( pdf ) == dataset.test_labels[i];
+      w.tClassifier.stop();
+    }
+  };
+
+  Timer tTest(true);
+  vector<std::thread> threads;
+  for(UInt t = 1u; t < numThreads; t++) {
+    threads.emplace_back(work, t);
+  }
+  work(0u);
+  for(auto &thread : threads) thread.join();
+  tTest.stop();
+
+  UInt score = 0;
+  Real64 encode = 0.0, spatial = 0.0, classifier = 0.0;
+  for(const auto &w : workers) {
+    score      += w.score;
+    encode     += w.tEncode.getElapsed();
+    spatial    += w.tSP.getElapsed();
+    classifier += w.tClassifier.getElapsed();
+  }
+  report("infer threaded (frozen SP, " + to_string(numThreads) + " threads)", numImages, tTest.getElapsed(), {
+      {"encode",     encode},
+      {"overlap+inh", spatial},
+      {"classifier", classifier}});
+  return score;
+}
+
 };  // End class MNIST
 
 int main(int argc, char **argv) {
   MNIST m;
-  m.setup();
   UInt maxSamples=0;
-  if(argc > 1) {
-    maxSamples=static_cast<UInt>(stoi(argv[1]));
+  UInt numThreads=1;
+  UInt batchSize=1000;
+  for(int i = 1; i < argc; i++) {
+    const string arg = argv[i];
+    if(arg == "--benchmark") {
+      m.benchmark = true;
+    } else if(arg.compare(0, 10, "--threads=") == 0) {
+      numThreads = static_cast<UInt>(stoi(arg.substr(10)));
+    } else if(arg.compare(0, 8, "--batch=") == 0) {
+      batchSize = std::max(1u, static_cast<UInt>(stoi(arg.substr(8))));
+    } else {
+      maxSamples=static_cast<UInt>(stoi(arg));
+    }
   }
+  m.setup();
+
+  if(m.benchmark) {
+    cout << "===========BENCHMARK: Spatial Pooler==========" << endl;
+    m.verbosity = 0;
+    m.train(false, maxSamples);
+    const UInt batched  = m.testBatched(batchSize, numThreads);
+    const UInt threaded = m.testThreaded(numThreads);
+    cout << "Score: " << 100.0 * batched / m.numTestImages() << "%" << endl;
+    if(batched != threaded) {
+      cout << "ERROR: the threaded inference scored " << threaded << ", the batched " << batched << endl;
+      return 1;
+    }
+    return 0;
+  }
+
   cout << "===========BASELINE: no SP====================" << endl;
   m.train(true, maxSamples); //skip SP learning
   m.test(true);
@@ -0,0 +1,65 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+// Framing of the POST /pipeline message, shared by the server and the clients.
+//
+// The body of the request is a sequence of frames, one per operation:
+//      <4 byte little endian length> <METHOD> <path>[?<query>]\n<body>
+// for example "PUT /network/1/region/encoder/param/sensedValue?data=0.5\n".
+// The body of the response has one frame per operation, in the same order,
+// holding the response that the operation would get on its own.
+
+#ifndef NTA_REST_PIPELINE_HPP
+#define NTA_REST_PIPELINE_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace rest_pipeline {
+
+inline void appendFrame(std::string &out, const std::string &frame) {
+  uint32_t len = static_cast<uint32_t>(frame.size());
+  for (int i = 0; i < 4; i++) {
+    out.push_back(static_cast<char>(len & 0xFFu));
+    len >>= 8;
+  }
+  out += frame;
+}
+
+// Appends the frame of an operation.
+inline void appendOperation(std::string &out, const std::string &method,
+                            const std::string &target, const std::string &body = "") {
+  appendFrame(out, method + " " + target + "\n" + body);
+}
+
+// Reads the frame at @offset and advances it, returns false at the end or on a truncated frame.
+inline bool nextFrame(const std::string &in, size_t &offset, std::string &frame) {
+  if (in.size() - offset < 4u)
+    return false;
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(in.data() + offset);
+  const size_t len = static_cast<size_t>(p[0]) | (static_cast<size_t>(p[1]) << 8) |
+                     (static_cast<size_t>(p[2]) << 16) | (static_cast<size_t>(p[3]) << 24);
+  if (in.size() - offset - 4u < len)
+    return false;
+  frame = in.substr(offset + 4u, len);
+  offset += 4u + len;
+  return true;
+}
+
+} // namespace rest_pipeline
+
+#endif // NTA_REST_PIPELINE_HPP
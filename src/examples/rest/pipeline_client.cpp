@@ -0,0 +1,131 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+// A client of rest_server measuring the throughput of the same records sent
+//   1) with a request per operation (PUT sensedValue, GET run, GET output), and
+//   2) pipelined, with many operations per POST /pipeline request.
+//
+// Usage:  ./rest_pipeline_client [records [ops_per_request [ip_address [port]]]]
+
+#include <httplib.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include <htm/ntypes/Value.hpp>
+#include <examples/rest/pipeline.hpp>
+
+#define DEFAULT_PORT 8050
+#define DEFAULT_HOST "127.0.0.1"
+
+static std::string createNetwork(httplib::Client &client) {
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 1000, sparsity: 0.02, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 2048, globalInhibition: true}}},
+       {addRegion: {name: "tm", type: "TMRegion", params: {cellsPerColumn: 8}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}},
+       {addLink:   {src: "sp.bottomUpOut", dest: "tm.bottomUpIn"}}
+    ]})";
+  auto res = client.Post("/network", config, "application/json");
+  if (!res || res->status / 100 != 2 || res->body.find("\"err\"") != std::string::npos)
+    return "";
+  htm::Value vm;
+  vm.parse(res->body);
+  return vm["result"].str();
+}
+
+static std::string record(const std::string &id, size_t i) {
+  char message[200];
+  std::snprintf(message, sizeof(message), "/network/%s/region/encoder/param/sensedValue?data=%.04f",
+                id.c_str(), std::sin(0.01 * static_cast<double>(i)));
+  return message;
+}
+
+int main(int argc, char **argv) {
+  size_t records = 1000u;
+  size_t perRequest = 300u;
+  std::string serverHost = DEFAULT_HOST;
+  int port = DEFAULT_PORT;
+  if (argc > 1) records = std::stoul(argv[1]);
+  if (argc > 2) perRequest = std::stoul(argv[2]);
+  if (argc > 3) serverHost = argv[3];
+  if (argc > 4) port = std::stoi(argv[4]);
+
+  httplib::Client client(serverHost.c_str(), port);
+  client.set_timeout_sec(300);
+  std::string id1 = createNetwork(client);
+  std::string id2 = createNetwork(client);
+  if (id1.empty() || id2.empty()) {
+    std::cerr << "Network configuration failed." << std::endl;
+    return 1;
+  }
+  const std::string run1 = "/network/" + id1 + "/run";
+  const std::string anomaly1 = "/network/" + id1 + "/region/tm/output/anomaly";
+  const std::string run2 = "/network/" + id2 + "/run";
+  const std::string anomaly2 = "/network/" + id2 + "/region/tm/output/anomaly";
+
+  // 1) A request per operation.
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < records; i++) {
+    auto res = client.Put(record(id1, i).c_str(), httplib::Params());
+    if (res) res = client.Get(run1.c_str());
+    if (res) res = client.Get(anomaly1.c_str());
+    if (!res) {
+      std::cerr << "Request failed." << std::endl;
+      return 1;
+    }
+  }
+  const double single = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  // 2) Pipelined, perRequest operations per request.
+  start = std::chrono::steady_clock::now();
+  std::string last;
+  for (size_t i = 0; i < records;) {
+    std::string body;
+    for (size_t ops = 0; i < records && ops + 3u <= perRequest; i++, ops += 3u) {
+      rest_pipeline::appendOperation(body, "PUT", record(id2, i));
+      rest_pipeline::appendOperation(body, "GET", run2);
+      rest_pipeline::appendOperation(body, "GET", anomaly2);
+    }
+    auto res = client.Post("/pipeline", body, "application/octet-stream");
+    if (!res || res->status / 100 != 2) {
+      std::cerr << "Pipeline request failed." << std::endl;
+      return 1;
+    }
+    size_t offset = 0u;
+    while (rest_pipeline::nextFrame(res->body, offset, last)) {
+      if (last.find("\"err\"") != std::string::npos) {
+        std::cerr << last << std::endl;
+        return 1;
+      }
+    }
+  }
+  const double pipelined = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << records << " records, 3 operations each" << std::endl;
+  std::cout << "  request per operation: " << single << " s, " << records / single << " records/s" << std::endl;
+  std::cout << "  pipelined (" << perRequest << " operations per request): " << pipelined << " s, "
+            << records / pipelined << " records/s" << std::endl;
+  std::cout << "  last anomaly: " << last;
+
+  client.Delete(("/network/" + id1 + "/ALL").c_str());
+  client.Delete(("/network/" + id2 + "/ALL").c_str());
+  return 0;
+}
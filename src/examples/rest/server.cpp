@@ -72,10 +72,14 @@ int main(int argc, char** argv) {
   if(argc == 2) {
     port = std::stoi(argv[1]);
   }
-  else if(argc == 3) {
+  else if(argc >= 3) {
     port = std::stoi(argv[1]);
     net_interface = argv[2];
   }
+  if(argc == 5) {
+    // <memory budget in MB> <directory for the evicted networks>
+    RESTapi::getInstance()->set_memory_budget(std::stoul(argv[3]) * 1024u * 1024u, argv[4]);
+  }
 
   RESTserver  server;
  
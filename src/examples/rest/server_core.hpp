@@ -44,6 +44,11 @@
 //       Get the value of a region's input. Returns a JSON encoded array.
 //  GET  /network/<id>/region/<region name>/output/<output name>
 //       Get the value of a region's output. Returns a JSON encoded array.
+//
+//       The inputs and outputs can also be sent in binary, see Array::toBinary().
+//       The PUT sets the header "Content-Type: application/octet-stream" and the
+//       GETs set "Accept: application/octet-stream".  Errors are still JSON; a
+//       binary PUT which fails (eg. a malformed body) has the status 400.
 //  DELETE /network/<id>/region/<region name>
 //       Deletes a region. Must not be in any links.
 //  DELETE /network/<id>/link/<source_name>/<dest_name>
@@ -52,11 +57,33 @@
 //       Deletes the entire Network object
 //  GET  /network/<id>/run?iterations=<iterations>
 //       Execute all regions in phase order. Repeat <iterations> times.
+//  POST /network/<id>/batch
+//       Feed a matrix of records, one iteration per record, and return the
+//       requested outputs of each iteration.  The JSON batch is in the body.
+//  GET  /network/<id>/subscribe?outputs=<region>.<output>,...
+//       Stream the outputs at the end of every iteration of the following runs,
+//       one JSON object per line, as a chunked response.  The subscription ends
+//       when the client closes the connection or the Network object is deleted.
 //  GET  /network/<id>/region/<region name>/command?data=<command>
 //       Execute a predefined command on a region. <command> must start with the
 //       command name followed by the arguments.
 //       The data could also be in the body.
 //
+//  GET  /network/<id>/trace/start?capacity=<events>
+//  GET  /network/<id>/trace/stop
+//  GET  /network/<id>/trace/get
+//       Record a timeline of the following runs, and get it in the Chrome Trace
+//       Event JSON format, for chrome://tracing or the Perfetto UI.
+//
+//  POST /pipeline
+//       Execute a sequence of the operations above in one request, without a
+//       round trip per operation.  The body and the response are length prefixed
+//       frames, see pipeline.hpp.  Supported are the PUT and GET of param and
+//       input, GET output, run and command, and POST batch.
+//
+//  GET  /metrics
+//       The counters of all Network objects in the Prometheus text format.
+//
 //  GET  /hi
 //       Respond with "Hello World\n" as a way to check client to server connection.
 //  GET  /stop
@@ -67,6 +94,7 @@
 #include <cstdio>
 #include <htm/engine/Network.hpp>
 #include <htm/engine/RESTapi.hpp>
+#include <examples/rest/pipeline.hpp>
 #include <httplib.h>
 #include <iomanip>
 #include <sstream>
@@ -178,12 +206,19 @@ public:
       std::string id = flds[2];
       std::string region_name = flds[4];
       std::string input_name = flds[6];
+      RESTapi *interface = RESTapi::getInstance();
+      if (is_binary(req.get_header_value("Content-Type"))) {
+        std::string result = interface->put_input_binary_request(id, region_name, input_name, req.body);
+        if (result.compare(0, 7, "{\"err\":") == 0)
+          res.status = 400;
+        res.set_content(result + "\n", "application/json");
+        return;
+      }
       std::string data = res.body;
       auto ix = req.params.find("data");
       if (ix != req.params.end())
         data = ix->second;
 
-      RESTapi *interface = RESTapi::getInstance();
       std::string result = interface->put_input_request(id, region_name, input_name, data);
       res.set_content(result + "\n", "application/json");
     });
@@ -197,6 +232,14 @@ public:
       std::string input_name = flds[6];
 
       RESTapi *interface = RESTapi::getInstance();
+      if (is_binary(req.get_header_value("Accept"))) {
+        std::string result;
+        if (interface->get_input_binary_request(id, region_name, input_name, result))
+          res.set_content(result, "application/octet-stream");
+        else
+          res.set_content(result + "\n", "application/json");
+        return;
+      }
       std::string result = interface->get_input_request(id, region_name, input_name);
       res.set_content(result + "\n", "application/json");
     });
@@ -210,6 +253,14 @@ public:
       std::string output_name = flds[6];
 
       RESTapi *interface = RESTapi::getInstance();
+      if (is_binary(req.get_header_value("Accept"))) {
+        std::string result;
+        if (interface->get_output_binary_request(id, region_name, output_name, result))
+          res.set_content(result, "application/octet-stream");
+        else
+          res.set_content(result + "\n", "application/json");
+        return;
+      }
       std::string result = interface->get_output_request(id, region_name, output_name);
       res.set_content(result + "\n", "application/json");
     });
@@ -266,6 +317,93 @@ public:
       res.set_content(result + "\n", "application/json");
     });
 
+    // POST /network/<id>/run?iterations=<iterations>&async=1
+    //    As GET run.  With async=1 the run is queued as a job and the job id
+    //    is returned at once; follow it with GET /job/<job id>.
+    svr.Post("/network/.*/run", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+      std::string iterations = "1";
+      auto ix = req.params.find("iterations");
+      if (ix != req.params.end())
+        iterations = ix->second;
+      ix = req.params.find("async");
+      bool async = ix != req.params.end() && (ix->second == "1" || ix->second == "true");
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = async ? interface->run_async_request(id, iterations)
+                                 : interface->run_request(id, iterations);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    // GET /job/<job id>
+    //    The state and progress of an asynchronous run.
+    svr.Get("/job/.*", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->job_status_request(flds[2]);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    // DELETE /job/<job id>
+    //    Cancel an asynchronous run.
+    svr.Delete("/job/.*", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->job_cancel_request(flds[2]);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    // POST /network/<id>/batch
+    //    Set the columns of each record, run one iteration and capture the outputs,
+    //    for all records in the body.  See RESTapi::batch_request() for the syntax.
+    //    Alternatively, the data could be in a parameter.
+    svr.Post("/network/.*/batch", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+      std::string data = req.body;
+      auto ix = req.params.find("data");
+      if (ix != req.params.end())
+        data = ix->second;
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->batch_request(id, data);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    // GET /network/<id>/subscribe?outputs=<region>.<output>,...
+    //    Push the outputs after every iteration, one JSON object per line:
+    //       {"iteration": <n>, "<region>.<output>": [ <array> ], ...}
+    //    The response is chunked and stays open until the client disconnects.
+    svr.Get("/network/.*/subscribe", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+      std::string outputs;
+      auto ix = req.params.find("outputs");
+      if (ix != req.params.end())
+        outputs = ix->second;
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string subscription;
+      if (!interface->subscribe_request(id, outputs, subscription)) {
+        res.set_content(subscription + "\n", "application/json");
+        return;
+      }
+      res.set_header("Content-Type", "application/x-ndjson");
+      res.set_chunked_content_provider(
+          [subscription](size_t /*offset*/, DataSink &sink) {
+            // Wait briefly for an event, so that the server can stop.
+            std::string event;
+            if (!RESTapi::getInstance()->next_event(subscription, event, 100u)) {
+              sink.done();
+            } else if (!event.empty()) {
+              event += "\n";
+              sink.write(event.data(), event.size());
+            }
+          },
+          [subscription]() { RESTapi::getInstance()->unsubscribe_request(subscription); });
+    });
+
     //  GET  /network/<id>/region/<region name>/command?data=<command>
     //       Execute a predefined command on a region. <command> must start with the
     //       command name followed by the arguments.
@@ -284,6 +422,68 @@ public:
       res.set_content(result + "\n", "application/json");
     });
 
+    //  PUT  /network/<id>/region/<region name>/learn?every=<N>&anomaly=<threshold>&source=<region>
+    //       Set the learn duty cycle of a region: learn every Nth iteration,
+    //       or when the anomaly output of the source region is at least the
+    //       threshold.  All are optional, every=1 without anomaly removes it.
+    svr.Put("/network/.*/region/.*/learn", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+      std::string region_name = flds[4];
+      std::string every, anomaly, source;
+      auto ix = req.params.find("every");
+      if (ix != req.params.end())
+        every = ix->second;
+      ix = req.params.find("anomaly");
+      if (ix != req.params.end())
+        anomaly = ix->second;
+      ix = req.params.find("source");
+      if (ix != req.params.end())
+        source = ix->second;
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->learn_request(id, region_name, every, anomaly, source);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    //  GET  /network/<id>/trace/<action>?capacity=<events>
+    //       Start or stop recording a timeline of the runs, or get the trace.
+    //       The capacity is optional, only for start.
+    svr.Get("/network/.*/trace/.*", [](const Request &req, Response &res) {
+      std::vector<std::string> flds = Path::split(req.path, '/');
+      std::string id = flds[2];
+      std::string action = flds[4];
+      std::string capacity;
+      auto ix = req.params.find("capacity");
+      if (ix != req.params.end())
+        capacity = ix->second;
+
+      RESTapi *interface = RESTapi::getInstance();
+      std::string result = interface->trace_request(id, action, capacity);
+      res.set_content(result + "\n", "application/json");
+    });
+
+    //  POST /pipeline
+    //    Execute the operations of the frames in the body, in order.
+    //    Returns a frame with the response of each operation.
+    svr.Post("/pipeline", [&](const Request &req, Response &res) {
+      std::string response, frame;
+      size_t offset = 0u;
+      while (rest_pipeline::nextFrame(req.body, offset, frame)) {
+        rest_pipeline::appendFrame(response, dispatch(frame) + "\n");
+      }
+      if (offset != req.body.size())
+        rest_pipeline::appendFrame(response, "{\"err\": \"Truncated pipeline frame.\"}\n");
+      res.set_content(response, "application/octet-stream");
+    });
+
+    //  GET /metrics
+    //    The metrics of all networks, for a Prometheus scrape.
+    svr.Get("/metrics", [](const Request & /*req*/, Response &res) {
+      RESTapi *interface = RESTapi::getInstance();
+      res.set_content(interface->metrics_request(), "text/plain; version=0.0.4");
+    });
+
     //  GET /stop
     //    Halt the server.
     svr.Get("/stop", [&](const Request & /*req*/, Response & /*res*/) { svr.stop(); });
@@ -297,6 +497,71 @@ public:
     });
   }
 
+  // Execute one operation of a pipeline; "<METHOD> <path>[?<query>]\n<body>".
+  // Mirrors the handlers above.
+  std::string dispatch(const std::string &frame) {
+    size_t eol = frame.find('\n');
+    std::string line = frame.substr(0, eol);
+    std::string body = (eol == std::string::npos) ? "" : frame.substr(eol + 1);
+    size_t sp = line.find(' ');
+    std::string method = line.substr(0, sp);
+    std::string target = (sp == std::string::npos) ? "" : line.substr(sp + 1);
+    Params params;
+    size_t q = target.find('?');
+    if (q != std::string::npos) {
+      detail::parse_query_text(target.substr(q + 1), params);
+      target = target.substr(0, q);
+    }
+    std::string data = body;
+    auto ix = params.find("data");
+    if (ix != params.end())
+      data = ix->second;
+
+    RESTapi *interface = RESTapi::getInstance();
+    std::vector<std::string> flds = Path::split(target, '/');
+    if (flds.size() >= 4 && flds[1] == "network") {
+      const std::string &id = flds[2];
+      if (flds.size() == 7 && flds[3] == "region") {
+        if (method == "PUT" && flds[5] == "param")
+          return interface->put_param_request(id, flds[4], flds[6], data);
+        if (method == "GET" && flds[5] == "param")
+          return interface->get_param_request(id, flds[4], flds[6]);
+        if (method == "PUT" && flds[5] == "input")
+          return interface->put_input_request(id, flds[4], flds[6], data);
+        if (method == "GET" && flds[5] == "input")
+          return interface->get_input_request(id, flds[4], flds[6]);
+        if (method == "GET" && flds[5] == "output")
+          return interface->get_output_request(id, flds[4], flds[6]);
+      }
+      if (flds.size() == 6 && flds[3] == "region" && flds[5] == "command" && method == "GET")
+        return interface->command_request(id, flds[4], data);
+      if (flds.size() == 6 && flds[3] == "region" && flds[5] == "learn" && method == "PUT") {
+        const auto param = [&params](const char *name) {
+          auto it = params.find(name);
+          return it != params.end() ? it->second : std::string();
+        };
+        return interface->learn_request(id, flds[4], param("every"), param("anomaly"), param("source"));
+      }
+      if (flds.size() == 4 && flds[3] == "run" && (method == "GET" || method == "POST")) {
+        auto it = params.find("iterations");
+        std::string iterations = (it != params.end()) ? it->second : "1";
+        it = params.find("async");
+        if (method == "POST" && it != params.end() && (it->second == "1" || it->second == "true"))
+          return interface->run_async_request(id, iterations);
+        return interface->run_request(id, iterations);
+      }
+      if (flds.size() == 4 && flds[3] == "batch" && method == "POST")
+        return interface->batch_request(id, data);
+    }
+    if (flds.size() == 3 && flds[1] == "job") {
+      if (method == "GET")
+        return interface->job_status_request(flds[2]);
+      if (method == "DELETE")
+        return interface->job_cancel_request(flds[2]);
+    }
+    return "{\"err\": " + Value::json_string("Not supported in a pipeline: " + line) + "}";
+  }
+
   // How to perform logging.
   inline void set_logger(httplib::Logger logger) { svr.set_logger(logger); }
 
@@ -328,6 +593,11 @@ public:
     return escaped.str();
   }
 
+  // The client asks for, or sends, the binary format of Array::toBinary().
+  static inline bool is_binary(const std::string &mediaType) {
+    return mediaType.find("application/octet-stream") != std::string::npos;
+  }
+
   inline bool is_running() { return svr.is_running(); }
   inline void stop() { svr.stop(); }
 
@@ -0,0 +1,303 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Thread scaling of the parallel kernels and of a whole Network: runs each
+ * with 1 .. max-threads threads on the same seeded input, and reports the
+ * speedup and the efficiency (speedup / threads) against 1 thread, and
+ * whether the outputs are identical to those of 1 thread (a digest of all
+ * outputs of all records).
+ *
+ * Usage: thread_scaling [--kernels=connections,sp,tm,predictor,network]
+ *          [--max-threads=0] [--records=200] [--columns=2048] [--cells=32]
+ *          [--chains=8] [--format=json|csv]
+ *
+ * --max-threads=0 sweeps up to the hardware threads.  The kernels:
+ *   connections  Connections::computeActivity of a TM sized Connections
+ *   sp           SpatialPooler::compute, learning
+ *   tm           TemporalMemory::compute, learning a SequenceGenerator stream
+ *   predictor    Predictor::learn and infer, 8 steps
+ *   network      Network::run of `chains` encoder -> SP -> TM chains
+ * The report goes to stdout, as JSON (the default) or CSV.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/algorithms/SDRClassifier.hpp>
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+#include <htm/utils/SequenceGenerator.hpp>
+
+using namespace htm;
+
+namespace {
+
+// FNV-1a of the outputs, equal digests mean identical outputs.
+struct Digest {
+  UInt64 hash = 14695981039346656037ull;
+  void add(const void *data, const size_t size) {
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0u; i < size; i++) {
+      hash ^= p[i];
+      hash *= 1099511628211ull;
+    }
+  }
+  template <typename T> void add(const std::vector<T> &v) { add(v.data(), v.size() * sizeof(T)); }
+};
+
+struct Sizes {
+  UInt records;
+  UInt columns;
+  UInt cells;
+  UInt chains;
+};
+
+struct Run {
+  double seconds;
+  UInt64 digest;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double since(const Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::vector<SDR> randomInputs(const UInt size, const Real sparsity, const UInt records) {
+  Random rng(42);
+  std::vector<SDR> inputs(records, SDR({size}));
+  for (auto &input : inputs)
+    input.randomize(sparsity, rng, true);
+  return inputs;
+}
+
+Run runConnections(const UInt threads, const Sizes &s) {
+  const UInt numCells = s.columns * s.cells;
+  Connections connections(numCells);
+  Random rng(42);
+  for (CellIdx cell = 0u; cell < numCells; cell++) {
+    for (UInt i = 0u; i < 2u; i++) {
+      const Segment segment = connections.createSegment(cell);
+      for (UInt j = 0u; j < 32u; j++)
+        connections.createSynapse(segment, rng.getUInt32(numCells), static_cast<Permanence>(rng.getReal64()));
+    }
+  }
+  connections.setNumThreads(threads);
+  const auto inputs = randomInputs(numCells, 0.02f, s.records);
+
+  Digest digest;
+  std::vector<SynapseIdx> potential(connections.numSegments());
+  const auto start = Clock::now();
+  for (const auto &input : inputs) {
+    const auto connected = connections.computeActivity(potential, input.getSparse(), false);
+    digest.add(connected);
+    digest.add(potential);
+  }
+  return {since(start), digest.hash};
+}
+
+Run runSpatialPooler(const UInt threads, const Sizes &s) {
+  SpatialPooler sp({1000u}, {s.columns}, 1000u);
+  sp.setNumThreads(threads);
+  const auto inputs = randomInputs(1000u, 0.05f, s.records);
+
+  Digest digest;
+  SDR columns({s.columns});
+  const auto start = Clock::now();
+  for (const auto &input : inputs) {
+    sp.compute(input, true, columns);
+    digest.add(columns.getSparse());
+  }
+  return {since(start), digest.hash};
+}
+
+Run runTemporalMemory(const UInt threads, const Sizes &s) {
+  TemporalMemory tm({s.columns}, s.cells);
+  tm.setNumThreads(threads);
+  SequenceGeneratorParameters p;
+  p.dimensions = {s.columns};
+  p.branching  = 0.3f;
+  p.noise      = 0.02f;
+  SequenceGenerator generator(p);
+  std::vector<SDR> inputs;
+  std::vector<bool> resets;
+  generator.generate(s.records, inputs, resets);
+
+  Digest digest;
+  const auto start = Clock::now();
+  for (size_t i = 0u; i < inputs.size(); i++) {
+    if (resets[i])
+      tm.reset();
+    tm.compute(inputs[i], true);
+    digest.add(tm.getActiveCells());
+    digest.add(&tm.anomaly, sizeof(tm.anomaly));
+  }
+  return {since(start), digest.hash};
+}
+
+Run runPredictor(const UInt threads, const Sizes &s) {
+  Predictor predictor({1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u});
+  predictor.setNumThreads(threads);
+  const auto inputs = randomInputs(s.columns * s.cells, 0.02f, s.records);
+
+  Digest digest;
+  Predictions predictions;
+  const auto start = Clock::now();
+  for (UInt i = 0u; i < s.records; i++) {
+    predictor.learn(i, inputs[i], {i % 100u});
+    predictor.infer(inputs[i], predictions);
+    for (UInt step = 1u; step <= 8u; step++)
+      digest.add(predictions[step]);
+  }
+  return {since(start), digest.hash};
+}
+
+Run runNetwork(const UInt threads, const Sizes &s) {
+  Network net;
+  std::vector<std::shared_ptr<Region>> encoders, tms;
+  for (UInt c = 0u; c < s.chains; c++) {
+    const std::string p = "c" + std::to_string(c) + "_";
+    encoders.push_back(net.addRegion(p + "encoder", "RDSEEncoderRegion",
+                                     "{size: 1000, sparsity: 0.02, radius: 0.03, seed: 2019}"));
+    net.addRegion(p + "sp", "SPRegion", "{columnCount: " + std::to_string(s.columns) + ", globalInhibition: true}");
+    tms.push_back(net.addRegion(p + "tm", "TMRegion", "{cellsPerColumn: " + std::to_string(s.cells) + "}"));
+    net.link(p + "encoder", p + "sp", "", "", "encoded", "bottomUpIn");
+    net.link(p + "sp", p + "tm", "", "", "bottomUpOut", "bottomUpIn");
+  }
+  net.setNumThreads(threads);
+  net.initialize();
+
+  Digest digest;
+  const auto start = Clock::now();
+  for (UInt r = 0u; r < s.records; r++) {
+    for (size_t c = 0u; c < encoders.size(); c++)
+      encoders[c]->setParameterReal64("sensedValue", std::sin(0.01 * r + static_cast<double>(c)));
+    net.run(1);
+    for (const auto &tm : tms)
+      digest.add(tm->getOutputData("bottomUpOut").getSDR().getSparse());
+  }
+  return {since(start), digest.hash};
+}
+
+std::vector<std::string> split(const std::string &list) {
+  std::vector<std::string> items;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      items.push_back(item);
+  return items;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::map<std::string, std::string> args = {
+      {"kernels", "connections,sp,tm,predictor,network"}, {"max-threads", "0"}, {"records", "200"},
+      {"columns", "2048"}, {"cells", "32"}, {"chains", "8"}, {"format", "json"}};
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos || args.count(arg.substr(2, eq - 2)) == 0) {
+      std::cerr << "Unknown argument " << arg << ", see the top of scaling.cpp for the usage.\n";
+      return 1;
+    }
+    args[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+  }
+  const UInt hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+  int maxThreads = std::atoi(args["max-threads"].c_str());
+  if (maxThreads == 0)
+    maxThreads = static_cast<int>(hardwareThreads);
+  const Sizes sizes = {static_cast<UInt>(std::atoi(args["records"].c_str())),
+                       static_cast<UInt>(std::atoi(args["columns"].c_str())),
+                       static_cast<UInt>(std::atoi(args["cells"].c_str())),
+                       static_cast<UInt>(std::atoi(args["chains"].c_str()))};
+  const bool csv = args["format"] == "csv";
+  if (maxThreads < 1 || sizes.records < 1u || sizes.columns < 1u || sizes.cells < 1u || sizes.chains < 1u ||
+      (!csv && args["format"] != "json")) {
+    std::cerr << "The sizes must be positive, the format json or csv.\n";
+    return 1;
+  }
+
+  const std::map<std::string, std::function<Run(UInt, const Sizes &)>> kernels = {
+      {"connections", runConnections}, {"sp", runSpatialPooler}, {"tm", runTemporalMemory},
+      {"predictor", runPredictor},     {"network", runNetwork}};
+  const auto names = split(args["kernels"]);
+  for (const auto &name : names) {
+    if (kernels.count(name) == 0u) {
+      std::cerr << "Unknown kernel " << name << ".\n";
+      return 1;
+    }
+  }
+
+  bool allDeterministic = true;
+  try {
+    std::cout << std::setprecision(6);
+    if (csv)
+      std::cout << "kernel,threads,seconds,speedup,efficiency,deterministic\n";
+    else
+      std::cout << "{\"hardware_threads\": " << hardwareThreads << ", \"records\": " << sizes.records
+                << ", \"columns\": " << sizes.columns << ", \"cells\": " << sizes.cells
+                << ", \"chains\": " << sizes.chains << ",\n \"results\": [";
+    bool first = true;
+    for (const auto &name : names) {
+      Run serial = {0.0, 0u};
+      for (int t = 1; t <= maxThreads; t++) {
+        const Run run = kernels.at(name)(static_cast<UInt>(t), sizes);
+        if (t == 1)
+          serial = run;
+        const double speedup = serial.seconds / run.seconds;
+        const bool deterministic = run.digest == serial.digest;
+        allDeterministic = allDeterministic && deterministic;
+        if (csv) {
+          std::cout << name << "," << t << "," << run.seconds << "," << speedup << ","
+                    << speedup / t << "," << (deterministic ? "true" : "false") << "\n";
+        } else {
+          std::cout << (first ? "\n  " : ",\n  ") << "{\"kernel\": \"" << name << "\", \"threads\": " << t
+                    << ", \"seconds\": " << run.seconds << ", \"speedup\": " << speedup
+                    << ", \"efficiency\": " << speedup / t
+                    << ", \"deterministic\": " << (deterministic ? "true" : "false") << "}";
+        }
+        std::cout.flush();
+        first = false;
+      }
+    }
+    if (!csv)
+      std::cout << "\n ],\n \"deterministic\": " << (allDeterministic ? "true" : "false") << "}\n";
+  } catch (const std::exception &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+  // A run which is not identical to 1 thread fails, eg. in CI.
+  return allDeterministic ? 0 : 2;
+}
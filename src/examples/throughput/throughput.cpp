@@ -0,0 +1,193 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * End to end throughput of a Network: encoder -> SP -> TM -> Classifier,
+ * with the anomaly likelihood of the TM anomaly, as an application runs it.
+ * Reports the records per second, the latency percentiles of a record and
+ * the peak resident memory; for comparing scheduler and link changes.
+ *
+ * Usage: network_throughput [--topology=single|multi] [--chains=40]
+ *          [--columns=2048] [--cells=32] [--records=2000] [--warmup=100]
+ *          [--threads=1] [--capture=FILE | --replay=FILE]
+ *
+ * The multi topology has `chains` independent encoder -> SP -> TM ->
+ * Classifier chains in one Network.  Common production sizes are
+ * --columns=2048 --cells=32 (the default) and --columns=65536.
+ *
+ * --capture records the encoder outputs of the warmup and the records with
+ * Watcher::watchSources(), --replay runs the Network on such a log instead,
+ * with a ReplayRegion in place of each encoder.  A capture of a production
+ * Network replays the same way, so a new release is benchmarked on the
+ * exact production workload.  The replay loops if it has fewer records.
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <htm/algorithms/AnomalyLikelihood.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Watcher.hpp>
+#include <htm/utils/LatencyHistogram.hpp>
+
+#include <examples/throughput/throughput_network.hpp>
+
+using namespace htm;
+
+namespace {
+
+// Peak resident set size of this process, in bytes.
+size_t peakResidentBytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return static_cast<size_t>(counters.PeakWorkingSetSize);
+  return 0u;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0u;
+#if defined(__APPLE__)
+  return static_cast<size_t>(usage.ru_maxrss); // bytes
+#else
+  return static_cast<size_t>(usage.ru_maxrss) * 1024u; // kilobytes
+#endif
+#endif
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  std::map<std::string, std::string> args = {
+      {"topology", "single"}, {"chains", "40"},   {"columns", "2048"}, {"cells", "32"},
+      {"records", "2000"},    {"warmup", "100"},  {"threads", "1"},
+      {"capture", ""},        {"replay", ""}};
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const size_t eq = arg.find('=');
+    if (arg.compare(0, 2, "--") != 0 || eq == std::string::npos || args.count(arg.substr(2, eq - 2)) == 0) {
+      std::cerr << "Unknown argument " << arg << ", see the top of throughput.cpp for the usage.\n";
+      return 1;
+    }
+    args[arg.substr(2, eq - 2)] = arg.substr(eq + 1);
+  }
+  const bool multi = args["topology"] == "multi";
+  const int chains = multi ? std::atoi(args["chains"].c_str()) : 1;
+  const int columns = std::atoi(args["columns"].c_str());
+  const int cells = std::atoi(args["cells"].c_str());
+  const int records = std::atoi(args["records"].c_str());
+  const int warmup = std::atoi(args["warmup"].c_str());
+  const int threads = std::atoi(args["threads"].c_str());
+  const std::string capture = args["capture"];
+  const std::string replay = args["replay"];
+  if (chains < 1 || columns < 1 || cells < 1 || records < 1 || warmup < 0 || threads < 0) {
+    std::cerr << "The sizes must be positive.\n";
+    return 1;
+  }
+  if (!capture.empty() && !replay.empty()) {
+    std::cerr << "Capture or replay, not both.\n";
+    return 1;
+  }
+
+  try {
+    std::vector<std::string> prefixes;
+    for (int c = 0; c < chains; c++)
+      prefixes.push_back(multi ? "c" + std::to_string(c) + "_" : "");
+
+    Network net;
+    const auto startBuild = std::chrono::steady_clock::now();
+    net.configure(throughput::networkConfig(prefixes, columns, cells, replay));
+    net.setNumThreads(static_cast<UInt>(threads));
+    net.initialize();
+    const std::chrono::duration<double> buildTime = std::chrono::steady_clock::now() - startBuild;
+
+    std::vector<std::shared_ptr<Region>> encoders, tms;
+    std::vector<AnomalyLikelihood> likelihoods(prefixes.size());
+    for (const auto &p : prefixes) {
+      encoders.push_back(net.getRegion(p + "encoder"));
+      tms.push_back(net.getRegion(p + "tm"));
+    }
+
+    std::unique_ptr<Watcher> watcher;
+    if (!capture.empty()) {
+      watcher.reset(new Watcher(capture, true));
+      watcher->watchSources(net);
+      watcher->attachToNetwork(net);
+    }
+
+    std::cout << "Network: " << chains << " chain(s) of " << (replay.empty() ? "RDSE" : "Replay")
+              << " -> SP(" << columns << ") -> TM("
+              << columns << " x " << cells << ") -> Classifier, " << threads << " thread(s)\n"
+              << "Built in " << std::fixed << std::setprecision(3) << buildTime.count() << " s\n";
+
+    // One record is one value per chain, and one iteration of the Network.
+    LatencyHistogram latency;
+    Real anomalyLikelihood = 0.0f;
+    const auto startRun = std::chrono::steady_clock::now();
+    for (int r = -warmup; r < records; r++) {
+      const auto start = std::chrono::steady_clock::now();
+      for (size_t c = 0; c < encoders.size() && replay.empty(); c++)
+        encoders[c]->setParameterReal64("sensedValue", std::sin(0.01 * r + static_cast<double>(c)));
+      net.run(1);
+      for (size_t c = 0; c < tms.size(); c++) {
+        const Real anomaly = reinterpret_cast<const Real *>(tms[c]->getOutputData("anomaly").getBuffer())[0];
+        anomalyLikelihood = likelihoods[c].anomalyProbability(anomaly);
+      }
+      const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      if (r >= 0)
+        latency.add(elapsed.count());
+    }
+    const std::chrono::duration<double> runTime = std::chrono::steady_clock::now() - startRun;
+    if (watcher) {
+      watcher->detachFromNetwork(net);
+      watcher.reset(); // flushes the log
+      std::cout << "Captured:     " << capture << "\n";
+    }
+
+    std::cout << std::setprecision(1)
+              << "Records:      " << records << " (+" << warmup << " warmup), last anomaly likelihood "
+              << std::setprecision(3) << anomalyLikelihood << "\n"
+              << std::setprecision(1)
+              << "Throughput:   " << records / latency.getTotal() << " records/s ("
+              << records * chains / latency.getTotal() << " chain records/s)\n"
+              << std::setprecision(3)
+              << "Latency (ms): p50 " << 1000.0 * latency.percentile(0.50)
+              << "  p90 " << 1000.0 * latency.percentile(0.90)
+              << "  p99 " << 1000.0 * latency.percentile(0.99)
+              << "  max " << 1000.0 * latency.getMax() << "\n"
+              << "Peak RSS:     " << std::setprecision(1) << peakResidentBytes() / (1024.0 * 1024.0) << " MiB\n"
+              << "Wall time:    " << std::setprecision(3) << runTime.count() << " s\n";
+  } catch (const std::exception &e) {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
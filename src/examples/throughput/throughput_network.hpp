@@ -0,0 +1,78 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+// The Network of the network_throughput benchmark, shared by throughput.cpp
+// and its unit test.
+
+#ifndef NTA_THROUGHPUT_NETWORK_HPP
+#define NTA_THROUGHPUT_NETWORK_HPP
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace throughput {
+
+// The configuration of Network::configure(), one chain "<prefix>encoder" ->
+// "<prefix>sp" -> "<prefix>tm" -> "<prefix>classifier" per prefix.  With a
+// `replay` file the encoders are ReplayRegions of their recorded outputs.
+inline std::string networkConfig(const std::vector<std::string> &prefixes, int columns, int cells,
+                                 const std::string &replay) {
+  const std::string encoded = replay.empty() ? "encoded" : "dataOut";
+  const std::string bucket = replay.empty() ? "bucket" : "values";
+  std::stringstream ss;
+  ss << "network:\n";
+  for (const auto &p : prefixes) {
+    ss << "  - addRegion:\n"
+       << "      name: " << p << "encoder\n";
+    if (replay.empty())
+      ss << "      type: RDSEEncoderRegion\n"
+         << "      params: {size: 1000, sparsity: 0.02, radius: 0.03, seed: 2019}\n";
+    else
+      ss << "      type: ReplayRegion\n"
+         << "      params: {file: \"" << replay << "\", source: " << p << "encoder}\n";
+    ss << "  - addRegion:\n"
+       << "      name: " << p << "sp\n"
+       << "      type: SPRegion\n"
+       << "      params: {columnCount: " << columns << ", globalInhibition: true}\n"
+       << "  - addRegion:\n"
+       << "      name: " << p << "tm\n"
+       << "      type: TMRegion\n"
+       << "      params: {cellsPerColumn: " << cells << "}\n"
+       << "  - addRegion:\n"
+       << "      name: " << p << "classifier\n"
+       << "      type: ClassifierRegion\n"
+       << "      params: {learn: true}\n"
+       << "  - addLink:\n"
+       << "      src: " << p << "encoder." << encoded << "\n"
+       << "      dest: " << p << "sp.bottomUpIn\n"
+       << "  - addLink:\n"
+       << "      src: " << p << "sp.bottomUpOut\n"
+       << "      dest: " << p << "tm.bottomUpIn\n"
+       << "  - addLink:\n"
+       << "      src: " << p << "tm.bottomUpOut\n"
+       << "      dest: " << p << "classifier.pattern\n"
+       << "  - addLink:\n"
+       << "      src: " << p << "encoder." << bucket << "\n"
+       << "      dest: " << p << "classifier.bucket\n";
+  }
+  return ss.str();
+}
+
+} // namespace throughput
+
+#endif // NTA_THROUGHPUT_NETWORK_HPP
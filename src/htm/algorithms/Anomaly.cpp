@@ -34,12 +34,22 @@ Real computeRawAnomalyScore(const SDR& active,
   }
 
   // Calculate and return percent of active columns that were not predicted.
-  SDR both(active.dimensions);
-  both.intersection(active, predicted);
+  const UInt both = active.getOverlap(predicted);
 
-  const Real score = (active.getSum() - both.getSum()) / static_cast<Real>(active.getSum());
+  const Real score = (active.getSum() - both) / static_cast<Real>(active.getSum());
   NTA_ASSERT(score >= 0.0f and score <= 1.0f) << "Anomaly score out of bounds!";
   return score;
 }
 
+
+void computeRawAnomalyScores(const vector<SDR>& active,
+                             const vector<SDR>& predicted,
+                             vector<Real>& scores) {
+  NTA_CHECK(active.size() == predicted.size()) << "computeRawAnomalyScores: a predicted SDR is required for each active SDR.";
+  scores.resize(active.size());
+  for (size_t i = 0; i < active.size(); i++) {
+    scores[i] = computeRawAnomalyScore(active[i], predicted[i]);
+  }
+}
+
 } // End namespace
@@ -18,6 +18,8 @@
 #ifndef HTM_ALGORITHMS_ANOMALY_HPP
 #define HTM_ALGORITHMS_ANOMALY_HPP
 
+#include <vector>
+
 #include <htm/types/Types.hpp>
 #include <htm/types/Sdr.hpp> // sdr::SDR
 
@@ -38,6 +40,17 @@ namespace htm {
 Real32 computeRawAnomalyScore(const SDR& active, 
                               const SDR& predicted);
 
+/**
+ * Computes the raw anomaly scores of many streams at once,
+ * scores[i] = computeRawAnomalyScore(active[i], predicted[i]).
+ *
+ * @param scores: output, resized to the number of streams.  Reusing the
+ *                same vector avoids allocations.
+ */
+void computeRawAnomalyScores(const std::vector<SDR>& active,
+                             const std::vector<SDR>& predicted,
+                             std::vector<Real32>& scores);
+
 } //end-ns
 
 #endif // HTM_ALGORITHMS_ANOMALY_HPP
@@ -1,7 +1,6 @@
 #include <htm/algorithms/AnomalyLikelihood.hpp>
 
-#include <iostream>
-#include <numeric> //accumulate, inner_product
+#include <algorithm> // copy, fill, min, max
 
 #include <htm/utils/Log.hpp> // NTA_CHECK
 
@@ -10,10 +9,8 @@ using namespace htm;
 
 namespace htm {
 
-static Real compute_mean(const vector<Real>& v); //forward declaration
-static Real compute_var(const vector<Real>& v, Real mean);
-static UInt calcSkipRecords_(UInt numIngested, UInt windowSize, UInt learningPeriod);
-
+const Real AnomalyLikelihood::THRESHOLD_MEAN     = 0.03f;
+const Real AnomalyLikelihood::THRESHOLD_VARIANCE = 0.0003f;
 
 AnomalyLikelihood::AnomalyLikelihood(UInt learningPeriod, UInt estimationSamples, UInt historicWindowSize, UInt reestimationPeriod, UInt aggregationWindow) :
     learningPeriod(learningPeriod),
@@ -49,8 +46,19 @@ Real AnomalyLikelihood::anomalyProbability(Real anomalyScore, int timestamp) {
 
     // store into relevant variables
     this->runningRawAnomalyScores_.append(anomalyScore);
-    auto newAvg = this->averagedAnomaly_.compute(anomalyScore);
-    this->runningAverageAnomalies_.append(newAvg);
+    const Real newAvg = this->averagedAnomaly_.compute(anomalyScore);
+    // Update the running statistics, the records of the learning period are
+    // not part of the estimated distribution.
+    const UInt record = this->iteration_; //index of the new record
+    Real dropped;
+    if (this->runningAverageAnomalies_.append(newAvg, &dropped)) {
+      if (record - runningAverageAnomalies_.maxCapacity >= this->learningPeriod) {
+        averageStats_.remove(dropped);
+      }
+    }
+    if (record >= this->learningPeriod) {
+      averageStats_.add(newAvg);
+    }
     this->iteration_++;
 
     // We ignore the first probationaryPeriod data points - as we cannot reliably compute distribution statistics for estimating likelihood
@@ -59,19 +67,13 @@ Real AnomalyLikelihood::anomalyProbability(Real anomalyScore, int timestamp) {
       return DEFAULT_ANOMALY;
     } //else {
 
-    const auto anomalies = this->runningAverageAnomalies_.getData();
-
       // On a rolling basis we re-estimate the distribution
       if ((timeElapsed >= initialTimestamp_ + reestimationPeriod)   || distribution_.name == "unknown" ) {
-        auto numSkipRecords = calcSkipRecords_(this->iteration_, (UInt)this->runningAverageAnomalies_.size(), this->learningPeriod); //FIXME this erase (numSkipRecords) is a problem when we use sliding window (as opposed to vector)! - should we skip only once on beginning, or on each call of this fn?
-        estimateAnomalyLikelihoods_(anomalies, numSkipRecords);  // called to update this->distribution_;
+        estimateDistribution_();  // updates this->distribution_;
         if  (timeElapsed >= initialTimestamp_ + reestimationPeriod)  { initialTimestamp_ = -1; } //reset init T
       }
 
-    const auto likelihoods = updateAnomalyLikelihoods_(anomalies);
-
-      NTA_ASSERT(likelihoods.size() > 0);
-      likelihood = 1.0f - likelihoods[0];
+      likelihood = 1.0f - tailProbability_(newAvg);
       NTA_ASSERT(likelihood >= 0.0 && likelihood <= 1.0);
 
     this->runningLikelihoods_.append(likelihood);
@@ -82,40 +84,6 @@ Real AnomalyLikelihood::anomalyProbability(Real anomalyScore, int timestamp) {
     }
 
 
-/**
-#
-# USAGE FOR LOW-LEVEL FUNCTIONS
-# -----------------------------
-#
-# There are two primary interface routines:
-#
-# estimateAnomalyLikelihoods_: batch routine, called initially and once in a
-#                                while
-# updateAnomalyLikelihoods: online routine, called for every new data point
-#
-# 1. Initially::
-#
-#    likelihoods, avgRecordList, estimatorParams = \
-# estimateAnomalyLikelihoods_(metric_data)
-#
-# 2. Whenever you get new data::
-#
-#    likelihoods, avgRecordList, estimatorParams = \
-# updateAnomalyLikelihoods(data2, estimatorParams)
-#
-# 3. And again (make sure you use the new estimatorParams returned in the above
-#   call to updateAnomalyLikelihoods!)::
-#
-#    likelihoods, avgRecordList, estimatorParams = \
-# updateAnomalyLikelihoods(data3, estimatorParams)
-#
-# 4. Every once in a while update estimator with a lot of recent data::
-#
-#    likelihoods, avgRecordList, estimatorParams = \
-# estimateAnomalyLikelihoods_(lots_of_metric_data)
-#
-**/
-
 Real AnomalyLikelihood::tailProbability_(Real x) const {
      NTA_CHECK(distribution_.name != "unknown" && distribution_.stdev > 0);
 
@@ -133,10 +101,17 @@ Real AnomalyLikelihood::tailProbability_(Real x) const {
 }
 
 
-DistributionParams AnomalyLikelihood::estimateNormal_(const vector<Real>& anomalyScores, bool performLowerBoundCheck) {
-    auto mean = compute_mean(anomalyScores);
-    auto var = compute_var(anomalyScores, mean);
-  DistributionParams params = DistributionParams("normal", mean, var, 0.0);
+void AnomalyLikelihood::estimateDistribution_() {
+  if (averageStats_.n == 0u) {
+    this->distribution_ =  DistributionParams("normal", 0.5, 1e6, 1e3); //null distribution
+  } else {
+    this->distribution_ = estimateNormal_((Real)averageStats_.mean, (Real)averageStats_.variance());
+  }
+}
+
+
+DistributionParams AnomalyLikelihood::estimateNormal_(Real mean, Real variance, bool performLowerBoundCheck) const {
+  DistributionParams params = DistributionParams("normal", mean, variance, 0.0);
 
   if (performLowerBoundCheck) {
     /* Handle edge case of almost no deviations and super low anomaly scores. We
@@ -163,172 +138,286 @@ DistributionParams AnomalyLikelihood::estimateNormal_(const vector<Real>& anomal
   return params;
 }
 
-  /**
-  Filter the list of raw (pre-filtered) likelihoods so that we only preserve
-  sharp increases in likelihood. 'likelihoods' can be a numpy array of floats or
-  a list of floats.
-
-  :returns: A new list of floats likelihoods containing the filtered values.
-  **/
-static vector<Real> filterLikelihoods_(const vector<Real>& likelihoods, Real redThreshold=0.99999, Real yellowThreshold=0.999){ //TODO make the redThreshold params of AnomalyLikelihood constructor()
-  redThreshold    = 1.0f - redThreshold;  //TODO maybe we could use the true meaning already in the parameters
-  yellowThreshold = 1.0f - yellowThreshold;
-
-  NTA_CHECK(redThreshold > 0.0 && redThreshold < 1.0);
-  NTA_CHECK(yellowThreshold > 0.0 && yellowThreshold < 1.0);
-  NTA_CHECK(yellowThreshold >= redThreshold);
-
-  NTA_ASSERT(likelihoods.size() >= 1);
-  // The first value is untouched
-  vector<Real> filteredLikelihoods(likelihoods);
-
-  for (size_t i=1; i< likelihoods.size(); i++) {
-    // value is in the redzone & so was previous
-    if (likelihoods[i] <= redThreshold && filteredLikelihoods[i-1] <= redThreshold) { //TODO review the (original) IFs
-      filteredLikelihoods[i] = yellowThreshold;
+
+void AnomalyLikelihood::rebuildAverageStats_() {
+  averageStats_.clear();
+  const auto size = (UInt)runningAverageAnomalies_.size();
+  const UInt oldest = iteration_ - size; //index of the oldest record in the window
+  for (UInt i = 0; i < size; i++) {
+    if (oldest + i >= learningPeriod) {
+      averageStats_.add(runningAverageAnomalies_[i]);
     }
   }
+}
+
 
-  NTA_ASSERT(filteredLikelihoods.size()==likelihoods.size());
-  return filteredLikelihoods;
+bool AnomalyLikelihood::operator==(const AnomalyLikelihood &a) const {
+  if (learningPeriod != a.learningPeriod) return false;
+  if (reestimationPeriod != a.reestimationPeriod) return false;
+  if (probationaryPeriod != a.probationaryPeriod) return false;
+  if (distribution_.name != a.distribution_.name) return false;
+  if (distribution_.mean != a.distribution_.mean) return false;
+  if (distribution_.variance != a.distribution_.variance) return false;
+  if (distribution_.stdev != a.distribution_.stdev) return false;
+  if (iteration_ != a.iteration_) return false;
+  if (lastTimestamp_ != a.lastTimestamp_) return false;
+  if (initialTimestamp_ != a.initialTimestamp_) return false;
+  if (averagedAnomaly_ != a.averagedAnomaly_) return false;
+  if (runningLikelihoods_ != a.runningLikelihoods_) return false;
+  if (runningRawAnomalyScores_ != a.runningRawAnomalyScores_) return false;
+  return true;
 }
 
 
-vector<Real>  AnomalyLikelihood::updateAnomalyLikelihoods_(const vector<Real>& anomalyScores, UInt verbosity) {
-  if (verbosity > 3) {
-    cout << "In updateAnomalyLikelihoods."<< endl;
-    cout << "Number of anomaly scores: "<<  anomalyScores.size() << endl;
-//    cout << "First 20:", anomalyScores[0:min(20, len(anomalyScores))])
-    cout << "Params: name=" <<  distribution_.name << " mean="<<distribution_.mean <<" var="<<distribution_.variance <<" stdev="<<distribution_.stdev <<endl;
-  }
+/******************************************************************************/
 
- NTA_CHECK(anomalyScores.size() > 0); // "Must have at least one anomalyScore"
+AnomalyLikelihoodBatch::AnomalyLikelihoodBatch(UInt numStreams, UInt learningPeriod, UInt estimationSamples, UInt historicWindowSize, UInt reestimationPeriod, UInt aggregationWindow) :
+    learningPeriod(learningPeriod),
+    reestimationPeriod(reestimationPeriod),
+    probationaryPeriod(learningPeriod+estimationSamples),
+    historicWindowSize(historicWindowSize),
+    aggregationWindow(aggregationWindow),
+    numStreams_(numStreams),
+    aggregated_((size_t)numStreams * aggregationWindow, 0.0f),
+    aggregatedTotal_(numStreams, 0.0f),
+    averages_((size_t)numStreams * historicWindowSize, 0.0f),
+    statsMean_(numStreams, 0.0),
+    statsM2_(numStreams, 0.0),
+    distributionMean_(numStreams, 0.0f),
+    distributionStdev_(numStreams, 0.0f)
+    {
+        NTA_CHECK(numStreams > 0u);
+        NTA_CHECK(historicWindowSize >= estimationSamples);
+        NTA_CHECK(aggregationWindow > 0u && aggregationWindow < reestimationPeriod && reestimationPeriod < historicWindowSize);
+    }
 
-  // Compute moving averages of these new scores using the previous values
-  // as well as likelihood for these scores using the old estimator
-  vector<Real> likelihoods;
-  likelihoods.reserve(runningAverageAnomalies_.size());
-  for (size_t i = 0; i < runningAverageAnomalies_.size(); i++) { //TODO we could use transform() here (? or would it be less clear?)
-    auto newAverage = runningAverageAnomalies_[(UInt)i];
-    likelihoods.push_back(tailProbability_(newAverage));
-  }
 
-/*
-  // Filter the likelihood values. First we prepend the historical likelihoods
-  // to the current set. Then we filter the values.  We peel off the likelihoods
-  // to return and the last windowSize values to store for later.
-  UInt toCrop = min((UInt)this->averagedAnomaly_.getMaxWindowSize(), (UInt)runningLikelihoods_.size());
-  this->runningLikelihoods_.insert(runningLikelihoods_.end() - toCrop, likelihoods.begin(),likelihoods.end()); //append & crop //We only update runningLikelihoods in the main loop, not here
-*/
-  auto filteredLikelihoods = filterLikelihoods_(likelihoods);
-
-  if (verbosity > 3) {
-    cout << "Number of likelihoods:"<< likelihoods.size() << endl;
-//    print("First 20 likelihoods:", likelihoods[0:min(20, len(likelihoods))])
-    cout << "Leaving updateAnomalyLikelihoods."<< endl;
-  }
+void AnomalyLikelihoodBatch::anomalyProbability(const vector<Real> &anomalyScores, vector<Real> &likelihoods) {
+    NTA_CHECK(anomalyScores.size() == numStreams_) << "AnomalyLikelihoodBatch: expected " << numStreams_ << " scores.";
+    const size_t n = numStreams_;
+    likelihoods.resize(n);
+    for (size_t s = 0; s < n; s++) {
+      NTA_CHECK(not std::isnan(anomalyScores[s]));
+    }
+
+    //time handling, by iteration:
+    const int timestamp = this->iteration_;
+    if(initialTimestamp_ == -1) {
+      initialTimestamp_ = timestamp;
+    }
+    const UInt timeElapsed = (UInt)(timestamp - initialTimestamp_);
+    const UInt record = this->iteration_; //index of the new record
+
+    // Moving average of the raw scores, @see MovingAverage::compute.
+    // The averages are kept in the output until the likelihoods are computed.
+    const Real *score = anomalyScores.data();
+    Real *average = likelihoods.data();
+    Real *window  = aggregated_.data() + slot_(aggregationWindow) * n;
+    Real *total   = aggregatedTotal_.data();
+    if (record >= aggregationWindow) {
+      for (size_t s = 0; s < n; s++) total[s] -= window[s];
+    }
+    const Real count = static_cast<Real>(std::min(record + 1u, aggregationWindow)); //values in the window
+    for (size_t s = 0; s < n; s++) {
+      total[s]  += score[s];
+      window[s]  = score[s];
+      average[s] = total[s] / count;
+    }
+
+    // Window of averaged scores and their running statistics,
+    // @see AnomalyLikelihood::RunningStats
+    Real *averages = averages_.data() + slot_(historicWindowSize) * n;
+    Real64 *mean = statsMean_.data();
+    Real64 *m2   = statsM2_.data();
+    if (record >= historicWindowSize && record - historicWindowSize >= learningPeriod) {
+      NTA_ASSERT(statsCount_ > 0u);
+      if (statsCount_ == 1u) {
+        std::fill(statsMean_.begin(), statsMean_.end(), 0.0);
+        std::fill(statsM2_.begin(),   statsM2_.end(),   0.0);
+      } else {
+        const Real64 cnt = (Real64)statsCount_;
+        for (size_t s = 0; s < n; s++) {
+          const Real64 x = averages[s];
+          const Real64 oldMean = mean[s];
+          mean[s] = (mean[s] * cnt - x) / (cnt - 1.0);
+          m2[s]  -= (x - oldMean) * (x - mean[s]);
+          m2[s]   = m2[s] < 0.0 ? 0.0 : m2[s]; //rounding
+        }
+      }
+      statsCount_--;
+    }
+    std::copy(average, average + n, averages);
+    if (record >= learningPeriod) {
+      statsCount_++;
+      const Real64 cnt = (Real64)statsCount_;
+      for (size_t s = 0; s < n; s++) {
+        const Real64 x = average[s];
+        const Real64 delta = x - mean[s];
+        mean[s] += delta / cnt;
+        m2[s]   += delta * (x - mean[s]);
+      }
+    }
+    this->iteration_++;
+
+    // We ignore the first probationaryPeriod data points
+    if (timeElapsed < this->probationaryPeriod) {
+      std::fill(likelihoods.begin(), likelihoods.end(), 0.5f);
+      return;
+    }
 
-  return filteredLikelihoods;
+    // On a rolling basis we re-estimate the distribution
+    const bool periodic = timeElapsed >= initialTimestamp_ + reestimationPeriod;
+    if (periodic || not distributionKnown_) {
+      estimateDistribution_();
+      if (periodic) { initialTimestamp_ = -1; } //reset init T
+    }
+
+    // Tail probability, @see AnomalyLikelihood::tailProbability_.  The branch
+    // is a select, so that the loop vectorizes apart from erfc.
+    const Real *distMean  = distributionMean_.data();
+    const Real *distStdev = distributionStdev_.data();
+    for (size_t s = 0; s < n; s++) {
+      const Real x  = average[s];
+      const Real xp = x < distMean[s] ? 2 * distMean[s] - x : x;
+      const Real z  = (xp - distMean[s]) / distStdev[s];
+      likelihoods[s] = 1.0f - (Real)(0.5 * std::erfc(z/1.4142));
+    }
 }
 
 
-vector<Real> AnomalyLikelihood::estimateAnomalyLikelihoods_(const vector<Real>& anomalyScores, UInt skipRecords, UInt verbosity) { //FIXME averagingWindow not used, I guess it's not a sliding window, but aggregating window (discrete steps)!
-  if (verbosity > 1) {
-    cout << "In estimateAnomalyLikelihoods_."<<endl;
-    cout << "Number of anomaly scores:" <<  anomalyScores.size() << endl;
-    cout << "Skip records="<<  skipRecords << endl;
-//    print("First 20:", anomalyScores[0:min(20, len(anomalyScores))])
+void AnomalyLikelihoodBatch::estimateDistribution_() {
+  distributionKnown_ = true;
+  if (statsCount_ == 0u) { //null distribution
+    std::fill(distributionMean_.begin(),  distributionMean_.end(),  0.5f);
+    std::fill(distributionStdev_.begin(), distributionStdev_.end(), 1e3f);
+    return;
   }
+  const Real64 cnt = (Real64)statsCount_;
+  for (size_t s = 0; s < numStreams_; s++) {
+    const Real mean     = (Real)statsMean_[s];
+    const Real variance = (Real)(statsM2_[s] / cnt);
+    // the lower bounds of AnomalyLikelihood::estimateNormal_()
+    distributionMean_[s]  = std::max(mean, AnomalyLikelihood::THRESHOLD_MEAN);
+    distributionStdev_[s] = std::sqrt(std::max(variance, AnomalyLikelihood::THRESHOLD_VARIANCE));
+  }
+}
 
-  NTA_CHECK(anomalyScores.size() > 0); // "Must have at least one anomalyScore"
-  auto dataValues = anomalyScores; //FIXME the "data" should be anomaly scores, or raw values?
 
-  // Estimate the distribution of anomaly scores based on aggregated records
-  if (dataValues.size()  <= skipRecords) {
-    this->distribution_ =  DistributionParams("normal", 0.5, 1e6, 1e3); //null distribution
-  } else {
-    dataValues.erase(dataValues.begin(), dataValues.begin() + skipRecords);// remove first skipRecords
-    this->distribution_ = estimateNormal_(dataValues);
-  }
+bool AnomalyLikelihoodBatch::operator==(const AnomalyLikelihoodBatch &a) const {
+  return learningPeriod     == a.learningPeriod &&
+         reestimationPeriod == a.reestimationPeriod &&
+         probationaryPeriod == a.probationaryPeriod &&
+         numStreams_        == a.numStreams_ &&
+         iteration_         == a.iteration_ &&
+         initialTimestamp_  == a.initialTimestamp_ &&
+         distributionKnown_ == a.distributionKnown_ &&
+         aggregated_        == a.aggregated_ &&
+         aggregatedTotal_   == a.aggregatedTotal_ &&
+         averages_          == a.averages_ &&
+         statsCount_        == a.statsCount_ &&
+         statsMean_         == a.statsMean_ &&
+         statsM2_           == a.statsM2_ &&
+         distributionMean_  == a.distributionMean_ &&
+         distributionStdev_ == a.distributionStdev_;
+}
 
-  // Estimate likelihoods based on this distribution
-  vector<Real> likelihoods;
-  likelihoods.reserve(dataValues.size());
-  for (auto s : dataValues) {
-    likelihoods.push_back(tailProbability_(s));
-  }
-  // Filter likelihood values
-  auto filteredLikelihoods = filterLikelihoods_(likelihoods);
 
+/******************************************************************************/
 
-/*  if verbosity > 1:
-    print("Discovered params=")
-    print(params)
-    print("Number of likelihoods:", len(likelihoods))
-    print("First 20 likelihoods:", (
-      filteredLikelihoods[0:min(20, len(filteredLikelihoods))] ))
-    print("leaving estimateAnomalyLikelihoods_")
-*/
+AnomalyLikelihoodSketch::AnomalyLikelihoodSketch(UInt learningPeriod, UInt estimationSamples, UInt historicWindowSize, UInt reestimationPeriod, UInt aggregationWindow, UInt sketchSize) :
+    learningPeriod(learningPeriod),
+    reestimationPeriod(reestimationPeriod),
+    probationaryPeriod(learningPeriod+estimationSamples),
+    historicWindowSize(historicWindowSize),
+    averagedAnomaly_(aggregationWindow),
+    current_(sketchSize),
+    previous_(sketchSize)
+    {
+        NTA_CHECK(historicWindowSize >= estimationSamples);
+        NTA_CHECK(aggregationWindow > 0u && aggregationWindow < reestimationPeriod && reestimationPeriod < historicWindowSize);
+    }
 
-  return filteredLikelihoods;
-}
 
+Real AnomalyLikelihoodSketch::anomalyProbability(Real anomalyScore) {
+    NTA_CHECK(not std::isnan(anomalyScore));
+    const Real newAvg = averagedAnomaly_.compute(anomalyScore);
+    const UInt record = iteration_++; //index of the new record
 
-/// HELPER methods (only used internaly in this cpp file)
-static Real compute_mean(const vector<Real>& v)  { //TODO do we have a (more comp. stable) implementation of mean/variance?
-  NTA_ASSERT(v.size() > 0); //avoid division by zero!
-    Real sum = (Real)(std::accumulate(v.begin(), v.end(), 0.0));
-    return sum / v.size();
-}
+    if (record >= learningPeriod) {
+      if (current_.getCount() == historicWindowSize) {
+        std::swap(previous_, current_);
+        current_.clear();
+      }
+      current_.update(newAvg);
+    }
 
+    // We ignore the first probationaryPeriod data points
+    if (record < probationaryPeriod) {
+      return DEFAULT_ANOMALY;
+    }
 
-static Real compute_var(const vector<Real>& v, Real mean)  {
-  NTA_ASSERT(v.size() > 0); //avoid division by zero!
-    Real sq_sum = (Real)(std::inner_product(v.begin(), v.end(), v.begin(), 0.0));
-    return (sq_sum / v.size()) - (mean * mean);
+    // On a rolling basis we re-estimate the distribution
+    if ((record - probationaryPeriod) % reestimationPeriod == 0u || not estimated_) {
+      estimateDistribution_();
+    }
+    if (estimateValues_.empty()) {
+      return DEFAULT_ANOMALY;
+    }
+
+    // The mid-rank of the new average.
+    const auto upper = std::upper_bound(estimateValues_.cbegin(), estimateValues_.cend(), newAvg);
+    const size_t i = static_cast<size_t>(upper - estimateValues_.cbegin()); //values [0, i) are <= newAvg
+    const Real64 atOrBelow = i == 0u ? 0.0 : estimateCdf_[i - 1u];
+    Real64 rank = atOrBelow;
+    if (i > 0u && estimateValues_[i - 1u] == newAvg) {
+      const Real64 below = i == 1u ? 0.0 : estimateCdf_[i - 2u];
+      rank = (below + atOrBelow) / 2.0;
+    }
+    const Real likelihood = static_cast<Real>(rank);
+    NTA_ASSERT(likelihood >= 0.0f && likelihood <= 1.0f);
+    return likelihood;
 }
 
 
-static UInt calcSkipRecords_(UInt numIngested, UInt windowSize, UInt learningPeriod)  {
-    /** Return the value of skipRecords for passing to estimateAnomalyLikelihoods
-
-    If `windowSize` is very large (bigger than the amount of data) then this
-    could just return `learningPeriod`. But when some values have fallen out of
-    the historical sliding window of anomaly records, then we have to take those
-    into account as well so we return the `learningPeriod` minus the number
-    shifted out.
-
-    @param numIngested - (int) number of data points that have been added to the
-      sliding window of historical data points.
-    @param windowSize - (int) size of sliding window of historical data points.
-    @param learningPeriod - (int) the number of iterations required for the
-      algorithm to learn the basic patterns in the dataset and for the anomaly
-      score to 'settle down'.
-    **/
-    int diff = numIngested - (int)windowSize;
-    UInt numShiftedOut = max(0, diff);
-    return min(numIngested, max((UInt)0, learningPeriod - numShiftedOut));
+QuantileSketch AnomalyLikelihoodSketch::getSketch() const {
+  QuantileSketch history = previous_;
+  history.merge(current_);
+  return history;
 }
 
 
+void AnomalyLikelihoodSketch::estimateDistribution_() {
+  estimated_ = true;
+  estimateValues_.clear();
+  estimateCdf_.clear();
+  const QuantileSketch history = getSketch();
+  if (history.getCount() == 0u) return;
+
+  std::vector<std::pair<Real, UInt64>> view;
+  history.sortedView(view);
+  const Real64 total = static_cast<Real64>(history.getCount());
+  UInt64 atOrBelow = 0u;
+  for (size_t i = 0u; i < view.size(); i++) {
+    atOrBelow += view[i].second;
+    if (i + 1u < view.size() && view[i + 1u].first == view[i].first) continue;
+    estimateValues_.push_back(view[i].first);
+    estimateCdf_.push_back(static_cast<Real64>(atOrBelow) / total);
+  }
+}
 
 
-bool AnomalyLikelihood::operator==(const AnomalyLikelihood &a) const {
-  if (learningPeriod != a.learningPeriod) return false;
-  if (reestimationPeriod != a.reestimationPeriod) return false;
-  if (probationaryPeriod != a.probationaryPeriod) return false;
-  if (distribution_.name != a.distribution_.name) return false;
-  if (distribution_.mean != a.distribution_.mean) return false;
-  if (distribution_.variance != a.distribution_.variance) return false;
-  if (distribution_.stdev != a.distribution_.stdev) return false;
-  if (iteration_ != a.iteration_) return false;
-  if (lastTimestamp_ != a.lastTimestamp_) return false;
-  if (initialTimestamp_ != a.initialTimestamp_) return false;
-  if (averagedAnomaly_ != a.averagedAnomaly_) return false;
-  if (runningLikelihoods_ != a.runningLikelihoods_) return false;
-  if (runningRawAnomalyScores_ != a.runningRawAnomalyScores_) return false;
-  return true;
+bool AnomalyLikelihoodSketch::operator==(const AnomalyLikelihoodSketch &a) const {
+  return learningPeriod     == a.learningPeriod &&
+         reestimationPeriod == a.reestimationPeriod &&
+         probationaryPeriod == a.probationaryPeriod &&
+         historicWindowSize == a.historicWindowSize &&
+         iteration_         == a.iteration_ &&
+         averagedAnomaly_   == a.averagedAnomaly_ &&
+         current_           == a.current_ &&
+         previous_          == a.previous_ &&
+         estimateValues_    == a.estimateValues_ &&
+         estimateCdf_       == a.estimateCdf_ &&
+         estimated_         == a.estimated_;
 }
 
-
 } //ns
@@ -4,6 +4,7 @@
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/utils/MovingAverage.hpp>
+#include <htm/utils/QuantileSketch.hpp>
 #include <htm/utils/SlidingWindow.hpp>
 #include <htm/utils/Log.hpp>
 
@@ -84,10 +85,10 @@ class AnomalyLikelihood : public Serializable {
       intervals.
 
     @param reestimationPeriod - (int) how often we re-estimate the Gaussian
-      distribution. The ideal is to re-estimate every iteration but this is a
-      performance hit. In general the system is not very sensitive to this
-      number as long as it is small relative to the total number of records
-      processed.
+      distribution. The mean and variance of the window are kept up to date
+      on every record, so a re-estimation is cheap (O(1)). In general the
+      system is not very sensitive to this number as long as it is small
+      relative to the total number of records processed.
 
   **/
     AnomalyLikelihood(UInt learningPeriod=288, UInt estimationSamples=100, UInt historicWindowSize=8640, UInt reestimationPeriod=100, UInt aggregationWindow=10);
@@ -154,6 +155,7 @@ class AnomalyLikelihood : public Serializable {
     ar(CEREAL_NVP(runningLikelihoods_));
     ar(CEREAL_NVP(runningRawAnomalyScores_));
     ar(CEREAL_NVP(runningAverageAnomalies_));
+    rebuildAverageStats_();
     // Note: learningPeriod, reestimationPeriod, probationaryPeriod already set by constructor.
   }
 
@@ -174,8 +176,8 @@ class AnomalyLikelihood : public Serializable {
      * minimal thresholds of standard distribution, if values get lower (rounding err, constant values)
      * we round to these minimal defaults
      */
-    const Real THRESHOLD_MEAN = 0.03f;
-    const Real THRESHOLD_VARIANCE = 0.0003f;
+    static const Real THRESHOLD_MEAN;     //0.03, also of AnomalyLikelihoodBatch
+    static const Real THRESHOLD_VARIANCE; //0.0003
 
     const UInt learningPeriod; //these 3 are from constructor
     const UInt reestimationPeriod;
@@ -184,42 +186,6 @@ class AnomalyLikelihood : public Serializable {
   private:
     //methods:
 
-  /**
-  Given a series of anomaly scores, compute the likelihood for each score. This
-  function should be called once on a bunch of historical anomaly scores for an
-  initial estimate of the distribution. It should be called again every so often
-  (say every 50 records) to update the estimate.
-
-  :param anomalyScores: a list of anomaly scores
-
-                        For best results, the list should be between 1000
-                        and 10,000 records
-  :param averagingWindow: integer number of records to average over
-  :param skipRecords: integer specifying number of records to skip when
-                      estimating distributions. If skip records are >=
-                      len(anomalyScores), a very broad distribution is returned
-                      that makes everything pretty likely.
-  :param verbosity: integer controlling extent of printouts for debugging
-
-                      0 = none
-                      1 = occasional information
-                      2 = print every record
-
-  :returns: vector of lilelihoods: , one for each aggregated point
-  **/
-    vector<Real> estimateAnomalyLikelihoods_(const vector<Real>& anomalyScores, UInt skipRecords=0, UInt verbosity=0);
-
-
-  /**
-  Compute updated probabilities for anomalyScores using the given params.
-  :param anomalyScores: a list of records. Each record is a list with the
-  :param verbosity: integer controlling extent of printouts for debugging
-  :type verbosity: UInt
-  :returns: a vector of likelihoods, one for each aggregated point
-  **/
-    vector<Real>  updateAnomalyLikelihoods_(const vector<Real>& anomalyScores, UInt verbosity=0);
-
-
  /**
   Given the normal distribution specified by the mean and standard deviation
   in distributionParams (the distribution is an instance member of the class),
@@ -232,14 +198,56 @@ class AnomalyLikelihood : public Serializable {
 
 
   /**
-  :param anomalyScores: vector of (raw) anomaly scores
+  Re-estimate distribution_ from the running statistics of the averaged
+  anomaly scores, in O(1).  The records of the learning period are skipped.
+  If no records are left, a very broad distribution is used that makes
+  everything pretty likely.
+  **/
+    void estimateDistribution_();
+
+
+  /**
+  :param mean, variance: of the (averaged) anomaly scores
   :param performLowerBoundCheck (bool)
-  :returns: A DistributionParams (struct) containing the parameters of a normal distribution based on
-      the ``anomalyScores``.
+  :returns: A DistributionParams (struct) containing the parameters of a normal distribution.
+  **/
+    DistributionParams estimateNormal_(Real mean, Real variance, bool performLowerBoundCheck=true) const;
+
+
+  /**
+  Recompute averageStats_ from runningAverageAnomalies_, after deserialization.
   **/
-    DistributionParams estimateNormal_(const vector<Real>& anomalyScores, bool performLowerBoundCheck=true);
+    void rebuildAverageStats_();
 
 
+  /**
+   Running mean & variance (Welford's algorithm) of a window of values;
+   values leaving the window are removed again.
+   **/
+  struct RunningStats {
+    UInt64 n = 0u;
+    Real64 mean = 0.0;
+    Real64 m2 = 0.0; //sum of squared differences from the mean
+
+    void clear() { n = 0u; mean = 0.0; m2 = 0.0; }
+    void add(const Real64 x) {
+      n++;
+      const Real64 delta = x - mean;
+      mean += delta / (Real64)n;
+      m2   += delta * (x - mean);
+    }
+    void remove(const Real64 x) {
+      NTA_ASSERT(n > 0u);
+      if(n == 1u) { clear(); return; }
+      const Real64 oldMean = mean;
+      mean = (mean * (Real64)n - x) / (Real64)(n - 1u);
+      m2  -= (x - oldMean) * (x - mean);
+      if(m2 < 0.0) m2 = 0.0; //rounding
+      n--;
+    }
+    Real64 variance() const { return n == 0u ? 0.0 : m2 / (Real64)n; }
+  };
+
     //private variables
     DistributionParams distribution_ ={ "unknown", 0.0, 0.0, 0.0}; //distribution passed around the class
 
@@ -252,6 +260,223 @@ class AnomalyLikelihood : public Serializable {
     htm::SlidingWindow<Real> runningRawAnomalyScores_;
     htm::SlidingWindow<Real> runningAverageAnomalies_; //sliding window of running averages of anomaly scores
 
+    // Statistics of the averaged anomalies in runningAverageAnomalies_,
+    // without the records of the learning period.  Derived, not serialized.
+    RunningStats averageStats_;
+
+};
+
+
+/**
+ AnomalyLikelihoodBatch - the anomaly likelihood of many streams at once.
+
+ Computes the same likelihoods as one AnomalyLikelihood per stream, all
+ streams get one record per call of anomalyProbability().  The state is
+ kept as arrays over the streams (moving averages, windows of averaged
+ scores, running mean & variance and distribution parameters), stored
+ slot by slot, so every step of the update is a loop over contiguous
+ memory that the compiler vectorizes.  Timestamps are not supported, the
+ records are timed by iteration.
+
+ Unlike AnomalyLikelihood, the windows of raw scores and of likelihoods are
+ not kept, they are not needed for the computation.
+
+ Example Usage:
+    AnomalyLikelihoodBatch batch( numStreams );
+    std::vector<Real> scores( numStreams ), likelihoods;
+    for(...) {
+      for( stream... ) scores[stream] = computeRawAnomalyScore( ... );
+      batch.anomalyProbability( scores, likelihoods );
+    }
+**/
+class AnomalyLikelihoodBatch : public Serializable {
+  public:
+    /**
+     @param numStreams - number of streams.
+     For the other parameters, @see AnomalyLikelihood.
+    **/
+    AnomalyLikelihoodBatch(UInt numStreams, UInt learningPeriod=288, UInt estimationSamples=100, UInt historicWindowSize=8640, UInt reestimationPeriod=100, UInt aggregationWindow=10);
+
+    UInt numStreams() const { return numStreams_; }
+
+    /**
+     Compute the anomaly likelihood of every stream.
+
+     @param anomalyScores - the current anomaly score of each stream.
+     @param likelihoods - output, the likelihood of each stream, resized
+       to numStreams().
+    **/
+    void anomalyProbability(const std::vector<Real> &anomalyScores, std::vector<Real> &likelihoods);
+
+    CerealAdapter;
+    template<class Archive>
+    void save_ar(Archive & ar) const {
+      ar(CEREAL_NVP(numStreams_),
+         CEREAL_NVP(iteration_),
+         CEREAL_NVP(initialTimestamp_),
+         CEREAL_NVP(distributionKnown_),
+         CEREAL_NVP(aggregated_),
+         CEREAL_NVP(aggregatedTotal_),
+         CEREAL_NVP(averages_),
+         CEREAL_NVP(statsCount_),
+         CEREAL_NVP(statsMean_),
+         CEREAL_NVP(statsM2_),
+         CEREAL_NVP(distributionMean_),
+         CEREAL_NVP(distributionStdev_));
+    }
+    template<class Archive>
+    void load_ar(Archive & ar) {
+      ar(CEREAL_NVP(numStreams_),
+         CEREAL_NVP(iteration_),
+         CEREAL_NVP(initialTimestamp_),
+         CEREAL_NVP(distributionKnown_),
+         CEREAL_NVP(aggregated_),
+         CEREAL_NVP(aggregatedTotal_),
+         CEREAL_NVP(averages_),
+         CEREAL_NVP(statsCount_),
+         CEREAL_NVP(statsMean_),
+         CEREAL_NVP(statsM2_),
+         CEREAL_NVP(distributionMean_),
+         CEREAL_NVP(distributionStdev_));
+      // Note: the periods and window sizes are already set by the constructor.
+      NTA_CHECK(aggregated_.size() == (size_t)numStreams_ * aggregationWindow and
+                averages_.size()   == (size_t)numStreams_ * historicWindowSize)
+        << "AnomalyLikelihoodBatch: the archive has other window sizes.";
+    }
+
+    bool operator==(const AnomalyLikelihoodBatch &a) const;
+    inline bool operator!=(const AnomalyLikelihoodBatch &a) const
+      { return not ((*this) == a); }
+
+    const UInt learningPeriod; //from constructor
+    const UInt reestimationPeriod;
+    const UInt probationaryPeriod;
+    const UInt historicWindowSize;
+    const UInt aggregationWindow;
+
+  private:
+    // Window slot of the current record.
+    size_t slot_(UInt window) const { return iteration_ % window; }
+
+    void estimateDistribution_();
+
+    UInt numStreams_;
+    UInt iteration_ = 0u;
+    int initialTimestamp_ = -1;
+    bool distributionKnown_ = false;
+
+    // Per stream arrays, windows are indexed [ slot * numStreams_ + stream ].
+    std::vector<Real>   aggregated_;       //window of raw scores, for the moving average
+    std::vector<Real>   aggregatedTotal_;
+    std::vector<Real>   averages_;         //window of averaged scores
+    UInt64              statsCount_ = 0u;  //running statistics of the averages, @see AnomalyLikelihood::RunningStats
+    std::vector<Real64> statsMean_;
+    std::vector<Real64> statsM2_;
+    std::vector<Real>   distributionMean_;
+    std::vector<Real>   distributionStdev_;
+};
+
+
+/**
+ AnomalyLikelihoodSketch - the anomaly likelihood from the distribution of
+ the averaged anomaly scores themselves, instead of a fitted normal
+ distribution.
+
+ The averaged scores go into quantile sketches (@see QuantileSketch), and
+ the likelihood of a score is its mid-rank in the history: the fraction of
+ the past averaged scores below it, plus half of those equal to it.  This
+ follows any shape of distribution, eg. the many exact zeros of a well
+ predicted stream, and needs bounded memory: two sketches of about
+ 3 * sketchSize values, and a table of the estimate of the same size.
+
+ The history is the last historicWindowSize to 2 * historicWindowSize
+ records: a sketch covers historicWindowSize records, then it replaces the
+ previous one and a new sketch starts.  Every reestimationPeriod records
+ both are merged into the sorted table of the estimate, so the likelihood
+ of a record is a binary search.
+
+ The likelihood is 0.5 for the first learningPeriod + estimationSamples
+ records, the records of the learning period are not part of the history.
+ Timestamps are not supported, the records are timed by iteration.
+
+ Example Usage:
+    AnomalyLikelihoodSketch likelihood;
+    for(...) {
+      const Real l = likelihood.anomalyProbability( tm.anomaly );
+    }
+    // a baseline of many streams
+    QuantileSketch fleet;
+    for( const auto &stream : streams ) fleet.merge( stream.getSketch() );
+    fleet.cdf( averagedScore );
+**/
+class AnomalyLikelihoodSketch : public Serializable {
+  public:
+    /**
+     @param sketchSize - the k of the QuantileSketch, the rank error is about
+       1.7 / sketchSize.
+     For the other parameters, @see AnomalyLikelihood.
+    **/
+    AnomalyLikelihoodSketch(UInt learningPeriod=288, UInt estimationSamples=100, UInt historicWindowSize=8640, UInt reestimationPeriod=100, UInt aggregationWindow=10, UInt sketchSize=200);
+
+    /**
+     Compute the likelihood of the current anomaly score, in [0, 1].
+    **/
+    Real anomalyProbability(Real anomalyScore);
+
+    /**
+     @returns the sketch of the averaged scores in the history, eg. for
+       merging the history of many streams.
+    **/
+    QuantileSketch getSketch() const;
+
+    CerealAdapter;
+    template<class Archive>
+    void save_ar(Archive & ar) const {
+      ar(CEREAL_NVP(iteration_),
+         CEREAL_NVP(averagedAnomaly_),
+         CEREAL_NVP(current_),
+         CEREAL_NVP(previous_),
+         CEREAL_NVP(estimateValues_),
+         CEREAL_NVP(estimateCdf_),
+         CEREAL_NVP(estimated_));
+    }
+    template<class Archive>
+    void load_ar(Archive & ar) {
+      ar(CEREAL_NVP(iteration_),
+         CEREAL_NVP(averagedAnomaly_),
+         CEREAL_NVP(current_),
+         CEREAL_NVP(previous_),
+         CEREAL_NVP(estimateValues_),
+         CEREAL_NVP(estimateCdf_),
+         CEREAL_NVP(estimated_));
+      // Note: the periods and window sizes are already set by the constructor.
+    }
+
+    bool operator==(const AnomalyLikelihoodSketch &a) const;
+    inline bool operator!=(const AnomalyLikelihoodSketch &a) const
+      { return not ((*this) == a); }
+
+    // returned until the system is burned-in, @see AnomalyLikelihood
+    const Real DEFAULT_ANOMALY = 0.5f;
+
+    const UInt learningPeriod; //from constructor
+    const UInt reestimationPeriod;
+    const UInt probationaryPeriod;
+    const UInt historicWindowSize;
+
+  private:
+    // Merge the history into the table of the estimate.
+    void estimateDistribution_();
+
+    UInt iteration_ = 0u;
+    htm::MovingAverage averagedAnomaly_;
+    QuantileSketch current_;  // the records since the last rotation
+    QuantileSketch previous_; // the historicWindowSize records before
+    // The estimate: the distinct values of the history, sorted, and the
+    // fraction of the history at or below each.
+    std::vector<Real>   estimateValues_;
+    std::vector<Real64> estimateCdf_;
+    bool estimated_ = false;
 };
 
 } //end-ns
@@ -0,0 +1,487 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of ColumnPooler
+ */
+
+#include <algorithm>
+#include <iterator>
+
+#include <htm/algorithms/ColumnPooler.hpp>
+
+using std::vector;
+using namespace htm;
+
+
+ColumnPooler::ColumnPooler(UInt inputWidth,
+                           const vector<UInt> &lateralInputWidths,
+                           UInt cellCount,
+                           UInt sdrSize,
+                           bool onlineLearning,
+                           Int maxSdrSize,
+                           Int minSdrSize,
+                           Permanence synPermProximalInc,
+                           Permanence synPermProximalDec,
+                           Permanence initialProximalPermanence,
+                           Int sampleSizeProximal,
+                           UInt minThresholdProximal,
+                           Permanence connectedPermanenceProximal,
+                           UInt predictedInhibitionThreshold,
+                           Permanence synPermDistalInc,
+                           Permanence synPermDistalDec,
+                           Permanence initialDistalPermanence,
+                           Int sampleSizeDistal,
+                           UInt activationThresholdDistal,
+                           Permanence connectedPermanenceDistal,
+                           Real inertiaFactor,
+                           Int seed) {
+  NTA_CHECK(inputWidth > 0u) << "ColumnPooler: inputWidth must be > 0";
+  NTA_CHECK(cellCount > 0u) << "ColumnPooler: cellCount must be > 0";
+  NTA_CHECK(sdrSize <= cellCount) << "ColumnPooler: sdrSize must be <= cellCount";
+  NTA_CHECK(sampleSizeProximal >= -1) << "ColumnPooler: sampleSizeProximal must be >= -1";
+  NTA_CHECK(sampleSizeDistal >= -1) << "ColumnPooler: sampleSizeDistal must be >= -1";
+  NTA_CHECK(inertiaFactor >= 0.0f) << "ColumnPooler: inertiaFactor must be >= 0";
+
+  inputWidth_         = inputWidth;
+  lateralInputWidths_ = lateralInputWidths;
+  cellCount_          = cellCount;
+  sdrSize_            = sdrSize;
+  onlineLearning_     = onlineLearning;
+  maxSdrSize_         = maxSdrSize < 0 ? sdrSize : static_cast<UInt>(maxSdrSize);
+  minSdrSize_         = minSdrSize < 0 ? sdrSize : static_cast<UInt>(minSdrSize);
+
+  synPermProximalInc_           = synPermProximalInc;
+  synPermProximalDec_           = synPermProximalDec;
+  initialProximalPermanence_    = initialProximalPermanence;
+  sampleSizeProximal_           = sampleSizeProximal;
+  minThresholdProximal_         = minThresholdProximal;
+  predictedInhibitionThreshold_ = predictedInhibitionThreshold;
+
+  synPermDistalInc_          = synPermDistalInc;
+  synPermDistalDec_          = synPermDistalDec;
+  initialDistalPermanence_   = initialDistalPermanence;
+  sampleSizeDistal_          = sampleSizeDistal;
+  activationThresholdDistal_ = activationThresholdDistal;
+  inertiaFactor_             = inertiaFactor;
+  useInertia_                = true;
+
+  activeCells_.clear();
+  proximal_.initialize(cellCount, connectedPermanenceProximal, false);
+  internalDistal_.initialize(cellCount, connectedPermanenceDistal, false);
+  distal_.clear();
+  distal_.reserve(lateralInputWidths.size());
+  for(size_t i = 0u; i < lateralInputWidths.size(); i++) {
+    distal_.emplace_back(cellCount, connectedPermanenceDistal, false);
+  }
+  rng_ = Random(static_cast<UInt64>(seed));
+}
+
+
+void ColumnPooler::compute(const SDR &feedforwardInput,
+                           const vector<SDR> &lateralInputs,
+                           bool learn) {
+  compute(feedforwardInput, lateralInputs, feedforwardInput, learn);
+}
+
+
+void ColumnPooler::compute(const SDR &feedforwardInput,
+                           const vector<SDR> &lateralInputs,
+                           const SDR &feedforwardGrowthCandidates,
+                           bool learn,
+                           const SDR *predictedInput) {
+  NTA_CHECK(feedforwardInput.size == inputWidth_)
+    << "ColumnPooler: feedforwardInput has size " << feedforwardInput.size
+    << ", expected " << inputWidth_;
+  NTA_CHECK(feedforwardGrowthCandidates.size == inputWidth_)
+    << "ColumnPooler: feedforwardGrowthCandidates has size " << feedforwardGrowthCandidates.size
+    << ", expected " << inputWidth_;
+  NTA_CHECK(lateralInputs.size() <= lateralInputWidths_.size())
+    << "ColumnPooler: got " << lateralInputs.size() << " lateral inputs, expected at most "
+    << lateralInputWidths_.size();
+  for(size_t i = 0u; i < lateralInputs.size(); i++) {
+    NTA_CHECK(lateralInputs[i].size == lateralInputWidths_[i])
+      << "ColumnPooler: lateral input " << i << " has size " << lateralInputs[i].size
+      << ", expected " << lateralInputWidths_[i];
+  }
+
+  const auto &growthCandidates = feedforwardGrowthCandidates.getSparse();
+
+  if( not learn ) {
+    computeInferenceMode_(feedforwardInput, lateralInputs);
+  }
+  else if( not onlineLearning_ ) {
+    computeLearningMode_(feedforwardInput, lateralInputs, growthCandidates);
+  }
+  else if( predictedInput != nullptr and
+           predictedInput->getSum() > predictedInhibitionThreshold_ ) {
+    NTA_CHECK(predictedInput->size == inputWidth_)
+      << "ColumnPooler: predictedInput has size " << predictedInput->size
+      << ", expected " << inputWidth_;
+    SDR predictedActiveInput({ inputWidth_ });
+    predictedActiveInput.intersection(feedforwardInput, *predictedInput);
+    computeInferenceMode_(predictedActiveInput, lateralInputs);
+    computeLearningMode_(predictedActiveInput, lateralInputs, growthCandidates);
+  }
+  else if( activeCells_.size() < minSdrSize_ or activeCells_.size() > maxSdrSize_ ) {
+    // Without a single representation, try to infer one before learning.
+    computeInferenceMode_(feedforwardInput, lateralInputs);
+    computeLearningMode_(feedforwardInput, lateralInputs, growthCandidates);
+  }
+  else {
+    // A single representation is active, extend it.
+    computeLearningMode_(feedforwardInput, lateralInputs, growthCandidates);
+  }
+}
+
+
+void ColumnPooler::computeLearningMode_(const SDR &feedforwardInput,
+                                        const vector<SDR> &lateralInputs,
+                                        const SDR_sparse_t &feedforwardGrowthCandidates) {
+  const vector<CellIdx> prevActiveCells = activeCells_;
+
+  // Too few active cells, this is a new object: pick a random representation.
+  // This is the only way new object representations are created.
+  if( activeCells_.size() < minSdrSize_ ) {
+    const auto cells = rng_.sampleIndices(cellCount_, sdrSize_);
+    activeCells_.assign(cells.begin(), cells.end());
+  }
+
+  // A union of objects is active, don't learn.
+  if( activeCells_.size() > maxSdrSize_ ) return;
+
+  if( feedforwardInput.getSum() == 0u ) return;
+
+  learn_(proximal_, feedforwardInput, feedforwardGrowthCandidates, sampleSizeProximal_,
+         initialProximalPermanence_, synPermProximalInc_, synPermProximalDec_);
+
+  for(size_t i = 0u; i < lateralInputs.size(); i++) {
+    const auto &lateralInput = lateralInputs[i];
+    if( lateralInput.getSum() == 0u ) continue;
+    learn_(distal_[i], lateralInput, lateralInput.getSparse(), sampleSizeDistal_,
+           initialDistalPermanence_, synPermDistalInc_, synPermDistalDec_);
+  }
+
+  if( not prevActiveCells.empty() ) {
+    SDR prevActive({ cellCount_ });
+    prevActive.setSparse(prevActiveCells);
+    learn_(internalDistal_, prevActive, prevActiveCells, sampleSizeDistal_,
+           initialDistalPermanence_, synPermDistalInc_, synPermDistalDec_);
+  }
+}
+
+
+void ColumnPooler::computeInferenceMode_(const SDR &feedforwardInput,
+                                         const vector<SDR> &lateralInputs) {
+  const vector<CellIdx> prevActiveCells = activeCells_;
+
+  // The cells with feedforward support, sorted.
+  vector<CellIdx> feedforwardSupportedCells =
+    activeSegmentCells_(proximal_, feedforwardInput.getSparse(), minThresholdProximal_);
+  std::sort(feedforwardSupportedCells.begin(), feedforwardSupportedCells.end());
+  feedforwardSupportedCells.erase(
+    std::unique(feedforwardSupportedCells.begin(), feedforwardSupportedCells.end()),
+    feedforwardSupportedCells.end());
+
+  // The number of active distal segments on each cell.
+  vector<UInt> numActiveSegmentsByCell(cellCount_, 0u);
+  for(const auto cell : activeSegmentCells_(internalDistal_, prevActiveCells, activationThresholdDistal_)) {
+    numActiveSegmentsByCell[cell]++;
+  }
+  for(size_t i = 0u; i < lateralInputs.size(); i++) {
+    for(const auto cell : activeSegmentCells_(distal_[i], lateralInputs[i].getSparse(), activationThresholdDistal_)) {
+      numActiveSegmentsByCell[cell]++;
+    }
+  }
+
+  // chosen[c] marks the chosen cells, numChosen counts them.
+  vector<bool> chosen(cellCount_, false);
+  size_t numChosen = 0u;
+
+  // First, activate the feedforward supported cells with the most lateral
+  // support, in groups of descending support, until the quorum is reached.
+  // Cells without lateral support are left out.
+  UInt ttop = 0u;
+  for(const auto cell : feedforwardSupportedCells) {
+    ttop = std::max(ttop, numActiveSegmentsByCell[cell]);
+  }
+  while( ttop > 0u and numChosen < sdrSize_ ) {
+    for(const auto cell : feedforwardSupportedCells) {
+      if( numActiveSegmentsByCell[cell] >= ttop and not chosen[cell] ) {
+        chosen[cell] = true;
+        numChosen++;
+      }
+    }
+    ttop--;
+  }
+
+  // Below the quorum, add the previously active cells (inertia).
+  if( numChosen < sdrSize_ and useInertia_ ) {
+    vector<CellIdx> prevCells;
+    for(const auto cell : prevActiveCells) {
+      if( not chosen[cell] ) prevCells.push_back(cell);
+    }
+    const auto inertialCap = static_cast<size_t>(static_cast<Real>(prevCells.size()) * inertiaFactor_);
+    if( inertialCap > 0u ) {
+      // Order by descending lateral support, which really helps.  Ties are in
+      // descending cell order, as numpy's reversed argsort.
+      std::stable_sort(prevCells.begin(), prevCells.end(),
+        [&](const CellIdx a, const CellIdx b) {
+          return numActiveSegmentsByCell[a] < numActiveSegmentsByCell[b]; });
+      std::reverse(prevCells.begin(), prevCells.end());
+      // Limit the number of previously active cells to force a decay, even
+      // below the quorum.
+      if( prevCells.size() > inertialCap ) prevCells.resize(inertialCap);
+
+      // Activate them in groups of descending lateral support, until either
+      // the quorum is reached or there are no cells left.
+      Int top = static_cast<Int>(numActiveSegmentsByCell[prevCells.front()]);
+      while( top >= 0 and numChosen < sdrSize_ ) {
+        for(const auto cell : prevCells) {
+          if( static_cast<Int>(numActiveSegmentsByCell[cell]) >= top and not chosen[cell] ) {
+            chosen[cell] = true;
+            numChosen++;
+          }
+        }
+        top--;
+      }
+    }
+  }
+
+  // Below the quorum, add feedforward supported cells without lateral support.
+  vector<CellIdx> selected;
+  if( numChosen < sdrSize_ ) {
+    const size_t discrepancy = sdrSize_ - numChosen;
+    vector<CellIdx> remainingFFcells;
+    for(const auto cell : feedforwardSupportedCells) {
+      if( not chosen[cell] ) remainingFFcells.push_back(cell);
+    }
+    // Inhibit cells proportionally to the number of cells already chosen: if
+    // ~0 were chosen activate ~all the feedforward supported cells, if ~sdrSize
+    // were chosen activate very few.  Activate at least 'discrepancy' cells,
+    // if available.
+    size_t n = (remainingFFcells.size() * discrepancy) / sdrSize_;
+    n = std::max(n, discrepancy);
+    n = std::min(n, remainingFFcells.size());
+
+    if( remainingFFcells.size() > n ) {
+      rng_.partialShuffle(remainingFFcells.begin(), remainingFFcells.end(), static_cast<UInt>(n));
+      remainingFFcells.resize(n);
+    }
+    selected.swap(remainingFFcells);
+  }
+
+  activeCells_.clear();
+  for(CellIdx cell = 0u; cell < cellCount_; cell++) {
+    if( chosen[cell] ) activeCells_.push_back(cell);
+  }
+  activeCells_.insert(activeCells_.end(), selected.begin(), selected.end());
+  std::sort(activeCells_.begin(), activeCells_.end());
+}
+
+
+void ColumnPooler::learn_(Connections &connections,
+                          const SDR &activeInput,
+                          const SDR_sparse_t &growthCandidates,
+                          Int sampleSize,
+                          Permanence initialPermanence,
+                          Permanence increment,
+                          Permanence decrement) {
+  const auto &activeSparse = activeInput.getSparse();
+  vector<CellIdx> presynaptic;
+  vector<CellIdx> newCells;
+
+  for(const auto cell : activeCells_) {
+    // One segment per cell.
+    const Segment segment = connections.numSegments(cell) == 0u
+      ? connections.createSegment(cell, 1u)
+      : connections.segmentsForCell(cell)[0];
+
+    connections.adaptSegment(segment, activeInput, increment, decrement, false);
+
+    presynaptic.clear();
+    for(const auto synapse : connections.synapsesForSegment(segment)) {
+      presynaptic.push_back(connections.presynapticCellForSynapse(synapse));
+    }
+    std::sort(presynaptic.begin(), presynaptic.end());
+
+    newCells.clear();
+    if( sampleSize == -1 ) {
+      std::set_difference(growthCandidates.begin(), growthCandidates.end(),
+                          presynaptic.begin(), presynaptic.end(),
+                          std::back_inserter(newCells));
+    }
+    else {
+      Int existing = 0;
+      auto p = presynaptic.begin();
+      for(const auto bit : activeSparse) {
+        p = std::lower_bound(p, presynaptic.end(), bit);
+        if( p == presynaptic.end() ) break;
+        if( *p == bit ) existing++;
+      }
+      const Int effectiveSampleSize = sampleSize - existing;
+      if( effectiveSampleSize > 0 ) {
+        std::set_difference(growthCandidates.begin(), growthCandidates.end(),
+                            presynaptic.begin(), presynaptic.end(),
+                            std::back_inserter(newCells));
+        if( static_cast<size_t>(effectiveSampleSize) < newCells.size() ) {
+          rng_.partialShuffle(newCells.begin(), newCells.end(), static_cast<UInt>(effectiveSampleSize));
+          newCells.resize(static_cast<size_t>(effectiveSampleSize));
+        }
+      }
+    }
+
+    for(const auto presynapticCell : newCells) {
+      connections.createSynapse(segment, presynapticCell, initialPermanence);
+    }
+  }
+}
+
+
+vector<CellIdx> ColumnPooler::activeSegmentCells_(Connections &connections,
+                                                  const SDR_sparse_t &activeInput,
+                                                  UInt threshold) {
+  vector<CellIdx> cells;
+  if( connections.numSegments() == 0u ) return cells;
+  const auto overlaps = connections.computeActivity(activeInput, false);
+  for(Segment segment = 0u; segment < overlaps.size(); segment++) {
+    if( overlaps[segment] >= threshold and connections.numSynapses(segment) > 0u ) {
+      cells.push_back(connections.cellForSegment(segment));
+    }
+  }
+  return cells;
+}
+
+
+void ColumnPooler::getActiveCells(SDR &activeCells) const {
+  NTA_CHECK(activeCells.size == cellCount_)
+    << "ColumnPooler: activeCells has size " << activeCells.size << ", expected " << cellCount_;
+  activeCells.setSparse(activeCells_);
+}
+
+
+namespace {
+  // Sums `count(connections, segment)` over the segments of the given cells,
+  // or of all cells if cells is null.
+  template<typename Count>
+  size_t sumOverSegments_(const Connections &connections, const vector<CellIdx> *cells, Count count) {
+    size_t n = 0u;
+    const auto numCells = static_cast<CellIdx>(connections.numCells());
+    const auto visit = [&](const CellIdx cell) {
+      NTA_CHECK(cell < numCells) << "ColumnPooler: cell " << cell << " out of range";
+      for(const auto segment : connections.segmentsForCell(cell)) {
+        n += count(connections, segment);
+      }
+    };
+    if( cells == nullptr ) {
+      for(CellIdx cell = 0u; cell < numCells; cell++) visit(cell);
+    }
+    else {
+      for(const auto cell : *cells) visit(cell);
+    }
+    return n;
+  }
+
+  // Same, over the internal and all lateral distal connections.
+  template<typename Count>
+  size_t sumOverDistalSegments_(const Connections &internalDistal, const vector<Connections> &distal,
+                                const vector<CellIdx> *cells, Count count) {
+    size_t n = sumOverSegments_(internalDistal, cells, count);
+    for(const auto &connections : distal) {
+      n += sumOverSegments_(connections, cells, count);
+    }
+    return n;
+  }
+
+  size_t countSynapses_(const Connections &connections, const Segment segment) {
+    return connections.numSynapses(segment);
+  }
+
+  size_t countConnected_(const Connections &connections, const Segment segment) {
+    return connections.dataForSegment(segment).numConnected;
+  }
+
+  size_t countNonEmpty_(const Connections &connections, const Segment segment) {
+    return connections.numSynapses(segment) > 0u ? 1u : 0u;
+  }
+}
+
+
+size_t ColumnPooler::numberOfProximalSynapses(const vector<CellIdx> &cells) const {
+  return sumOverSegments_(proximal_, &cells, countSynapses_);
+}
+
+size_t ColumnPooler::numberOfConnectedProximalSynapses(const vector<CellIdx> &cells) const {
+  return sumOverSegments_(proximal_, &cells, countConnected_);
+}
+
+size_t ColumnPooler::numberOfConnectedProximalSynapses() const {
+  return sumOverSegments_(proximal_, nullptr, countConnected_);
+}
+
+size_t ColumnPooler::numberOfDistalSynapses(const vector<CellIdx> &cells) const {
+  return sumOverDistalSegments_(internalDistal_, distal_, &cells, countSynapses_);
+}
+
+size_t ColumnPooler::numberOfDistalSynapses() const {
+  return sumOverDistalSegments_(internalDistal_, distal_, nullptr, countSynapses_);
+}
+
+size_t ColumnPooler::numberOfConnectedDistalSynapses(const vector<CellIdx> &cells) const {
+  return sumOverDistalSegments_(internalDistal_, distal_, &cells, countConnected_);
+}
+
+size_t ColumnPooler::numberOfConnectedDistalSynapses() const {
+  return sumOverDistalSegments_(internalDistal_, distal_, nullptr, countConnected_);
+}
+
+size_t ColumnPooler::numberOfDistalSegments(const vector<CellIdx> &cells) const {
+  return sumOverDistalSegments_(internalDistal_, distal_, &cells, countNonEmpty_);
+}
+
+size_t ColumnPooler::numberOfDistalSegments() const {
+  return sumOverDistalSegments_(internalDistal_, distal_, nullptr, countNonEmpty_);
+}
+
+
+bool ColumnPooler::operator==(const ColumnPooler &other) const {
+  return inputWidth_                   == other.inputWidth_ and
+         lateralInputWidths_           == other.lateralInputWidths_ and
+         cellCount_                    == other.cellCount_ and
+         sdrSize_                      == other.sdrSize_ and
+         onlineLearning_               == other.onlineLearning_ and
+         maxSdrSize_                   == other.maxSdrSize_ and
+         minSdrSize_                   == other.minSdrSize_ and
+         synPermProximalInc_           == other.synPermProximalInc_ and
+         synPermProximalDec_           == other.synPermProximalDec_ and
+         initialProximalPermanence_    == other.initialProximalPermanence_ and
+         sampleSizeProximal_           == other.sampleSizeProximal_ and
+         minThresholdProximal_         == other.minThresholdProximal_ and
+         predictedInhibitionThreshold_ == other.predictedInhibitionThreshold_ and
+         synPermDistalInc_             == other.synPermDistalInc_ and
+         synPermDistalDec_             == other.synPermDistalDec_ and
+         initialDistalPermanence_      == other.initialDistalPermanence_ and
+         sampleSizeDistal_             == other.sampleSizeDistal_ and
+         activationThresholdDistal_    == other.activationThresholdDistal_ and
+         inertiaFactor_                == other.inertiaFactor_ and
+         useInertia_                   == other.useInertia_ and
+         activeCells_                  == other.activeCells_ and
+         proximal_                     == other.proximal_ and
+         internalDistal_               == other.internalDistal_ and
+         distal_                       == other.distal_ and
+         rng_                          == other.rng_;
+}
@@ -0,0 +1,310 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ColumnPooler class in C++
+ */
+
+#ifndef NTA_COLUMN_POOLER_HPP
+#define NTA_COLUMN_POOLER_HPP
+
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace htm {
+
+/**
+ * ColumnPooler - the object layer (L2) of a cortical column.
+ *
+ * @b Description
+ * Learns a stable representation, a fixed set of `sdrSize` cells, for each
+ * object the column senses, and recognizes the object from a few of its
+ * features, together with the lateral input of the other columns sensing it.
+ *
+ * Each cell has one proximal segment on the feedforward input, one distal
+ * segment on the previously active cells of this layer, and one distal
+ * segment on each lateral input.
+ *
+ * This is the C++ port of htm.advanced.algorithms.column_pooler.ColumnPooler,
+ * with the same parameters and the same results for the same random seed,
+ * except where noted at compute().
+ *
+ * Example Usage:
+ *    ColumnPooler pooler( 1024u, {4096u} );
+ *    SDR feature({ 1024u }), lateral({ 4096u });
+ *    pooler.compute( feature, {lateral}, true );   // learn the object
+ *    pooler.reset();                              // next object
+ *    pooler.getActiveCells();
+ */
+class ColumnPooler : public Serializable
+{
+public:
+  ColumnPooler() {}
+
+  /**
+   * @param inputWidth  The number of bits in the feedforward input.
+   * @param lateralInputWidths  The number of bits in each lateral input.
+   * @param cellCount   The number of cells in this layer.
+   * @param sdrSize     The number of active cells in an object SDR.
+   * @param onlineLearning  Whether to learn in online mode, see compute().
+   * @param maxSdrSize  The maximum number of active cells for learning, more
+   *        active cells is a union of objects which is not learned.  Negative
+   *        for sdrSize.
+   * @param minSdrSize  The minimum number of active cells for learning, with
+   *        fewer a new object representation is created.  Negative for sdrSize.
+   *
+   * @param synPermProximalInc  Permanence increment for proximal synapses.
+   * @param synPermProximalDec  Permanence decrement for proximal synapses.
+   * @param initialProximalPermanence  Initial permanence of proximal synapses.
+   * @param sampleSizeProximal  Number of proximal synapses a cell grows to each
+   *        feedforward pattern, or -1 to connect to every active bit.
+   * @param minThresholdProximal  Number of active connected synapses for a
+   *        cell to have feedforward support.
+   * @param connectedPermanenceProximal  Permanence of connected proximal synapses.
+   * @param predictedInhibitionThreshold  How much predicted input must be
+   *        present for inhibitory behavior, only with onlineLearning.
+   *
+   * @param synPermDistalInc  Permanence increment for distal synapses.
+   * @param synPermDistalDec  Permanence decrement for distal synapses.
+   * @param initialDistalPermanence  Initial permanence of distal synapses.
+   * @param sampleSizeDistal  Number of distal synapses a cell grows to each
+   *        lateral pattern, or -1 to connect to every active bit.
+   * @param activationThresholdDistal  Number of active connected synapses
+   *        which activate a distal segment.
+   * @param connectedPermanenceDistal  Permanence of connected distal synapses.
+   * @param inertiaFactor  The proportion of previously active cells which stay
+   *        active in the next step, in the absence of inhibition.
+   *
+   * @param seed  Random number generator seed.
+   */
+  ColumnPooler(UInt inputWidth,
+               const std::vector<UInt> &lateralInputWidths = {},
+               UInt cellCount = 4096u,
+               UInt sdrSize = 40u,
+               bool onlineLearning = false,
+               Int maxSdrSize = -1,
+               Int minSdrSize = -1,
+
+               Permanence synPermProximalInc = 0.1f,
+               Permanence synPermProximalDec = 0.001f,
+               Permanence initialProximalPermanence = 0.6f,
+               Int sampleSizeProximal = 20,
+               UInt minThresholdProximal = 10u,
+               Permanence connectedPermanenceProximal = 0.5f,
+               UInt predictedInhibitionThreshold = 20u,
+
+               Permanence synPermDistalInc = 0.1f,
+               Permanence synPermDistalDec = 0.001f,
+               Permanence initialDistalPermanence = 0.6f,
+               Int sampleSizeDistal = 20,
+               UInt activationThresholdDistal = 13u,
+               Permanence connectedPermanenceDistal = 0.5f,
+               Real inertiaFactor = 1.0f,
+
+               Int seed = 42);
+
+  /**
+   * Runs one time step of the column pooler algorithm.
+   *
+   * @param feedforwardInput  Active feedforward input bits.
+   * @param lateralInputs     The active bits of each lateral input.
+   * @param feedforwardGrowthCandidates  Feedforward input bits which active
+   *        cells may grow new synapses to, eg. the predicted active cells of
+   *        the input layer.
+   * @param learn  Whether to learn the current object.
+   * @param predictedInput  Optional, the predicted cells of the input layer.
+   *        With onlineLearning, if more than predictedInhibitionThreshold of
+   *        them are given only the predicted feedforward input is used.
+   *
+   * Unlike the python version, the lateral support of a cell is counted on
+   * the distal segments of that cell, the python version looked their cells
+   * up in the proximal connections.
+   */
+  void compute(const SDR &feedforwardInput,
+               const std::vector<SDR> &lateralInputs,
+               const SDR &feedforwardGrowthCandidates,
+               bool learn = true,
+               const SDR *predictedInput = nullptr);
+
+  // Same, growing synapses to all of the feedforward input.
+  void compute(const SDR &feedforwardInput,
+               const std::vector<SDR> &lateralInputs = {},
+               bool learn = true);
+
+  /**
+   * Clears the active cells.  When learning, the next compute() learns a new
+   * object.
+   */
+  void reset() { activeCells_.clear(); }
+
+  // The sorted indices of the active cells.
+  const std::vector<CellIdx> &getActiveCells() const { return activeCells_; }
+  void getActiveCells(SDR &activeCells) const;
+
+  UInt numberOfInputs() const { return inputWidth_; }
+  UInt numberOfCells() const { return cellCount_; }
+  const std::vector<UInt> &getLateralInputWidths() const { return lateralInputWidths_; }
+  UInt getSdrSize() const { return sdrSize_; }
+
+  /**
+   * Whether a fraction of the previously active cells stays active in the
+   * next step unless inhibited, @see inertiaFactor.
+   */
+  bool getUseInertia() const { return useInertia_; }
+  void setUseInertia(bool useInertia) { useInertia_ = useInertia; }
+
+  /**
+   * The number of synapses of the given cells, all cells if none are given.
+   * Distal counts are the sum of the internal and the lateral segments.
+   */
+  size_t numberOfProximalSynapses(const std::vector<CellIdx> &cells) const;
+  size_t numberOfProximalSynapses() const { return proximal_.numSynapses(); }
+  size_t numberOfConnectedProximalSynapses(const std::vector<CellIdx> &cells) const;
+  size_t numberOfConnectedProximalSynapses() const;
+  size_t numberOfDistalSynapses(const std::vector<CellIdx> &cells) const;
+  size_t numberOfDistalSynapses() const;
+  size_t numberOfConnectedDistalSynapses(const std::vector<CellIdx> &cells) const;
+  size_t numberOfConnectedDistalSynapses() const;
+
+  // The number of distal segments which have at least one synapse.
+  size_t numberOfDistalSegments(const std::vector<CellIdx> &cells) const;
+  size_t numberOfDistalSegments() const;
+
+  const Connections &getProximalConnections() const { return proximal_; }
+  const Connections &getInternalDistalConnections() const { return internalDistal_; }
+  const Connections &getLateralDistalConnections(UInt i) const { return distal_.at(i); }
+
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(inputWidth_),
+       CEREAL_NVP(lateralInputWidths_),
+       CEREAL_NVP(cellCount_),
+       CEREAL_NVP(sdrSize_),
+       CEREAL_NVP(onlineLearning_),
+       CEREAL_NVP(maxSdrSize_),
+       CEREAL_NVP(minSdrSize_),
+       CEREAL_NVP(synPermProximalInc_),
+       CEREAL_NVP(synPermProximalDec_),
+       CEREAL_NVP(initialProximalPermanence_),
+       CEREAL_NVP(sampleSizeProximal_),
+       CEREAL_NVP(minThresholdProximal_),
+       CEREAL_NVP(predictedInhibitionThreshold_),
+       CEREAL_NVP(synPermDistalInc_),
+       CEREAL_NVP(synPermDistalDec_),
+       CEREAL_NVP(initialDistalPermanence_),
+       CEREAL_NVP(sampleSizeDistal_),
+       CEREAL_NVP(activationThresholdDistal_),
+       CEREAL_NVP(inertiaFactor_),
+       CEREAL_NVP(useInertia_),
+       CEREAL_NVP(activeCells_),
+       CEREAL_NVP(proximal_),
+       CEREAL_NVP(internalDistal_),
+       CEREAL_NVP(distal_),
+       CEREAL_NVP(rng_));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(CEREAL_NVP(inputWidth_),
+       CEREAL_NVP(lateralInputWidths_),
+       CEREAL_NVP(cellCount_),
+       CEREAL_NVP(sdrSize_),
+       CEREAL_NVP(onlineLearning_),
+       CEREAL_NVP(maxSdrSize_),
+       CEREAL_NVP(minSdrSize_),
+       CEREAL_NVP(synPermProximalInc_),
+       CEREAL_NVP(synPermProximalDec_),
+       CEREAL_NVP(initialProximalPermanence_),
+       CEREAL_NVP(sampleSizeProximal_),
+       CEREAL_NVP(minThresholdProximal_),
+       CEREAL_NVP(predictedInhibitionThreshold_),
+       CEREAL_NVP(synPermDistalInc_),
+       CEREAL_NVP(synPermDistalDec_),
+       CEREAL_NVP(initialDistalPermanence_),
+       CEREAL_NVP(sampleSizeDistal_),
+       CEREAL_NVP(activationThresholdDistal_),
+       CEREAL_NVP(inertiaFactor_),
+       CEREAL_NVP(useInertia_),
+       CEREAL_NVP(activeCells_),
+       CEREAL_NVP(proximal_),
+       CEREAL_NVP(internalDistal_),
+       CEREAL_NVP(distal_),
+       CEREAL_NVP(rng_));
+  }
+
+  bool operator==(const ColumnPooler &other) const;
+  inline bool operator!=(const ColumnPooler &other) const { return not (*this == other); }
+
+private:
+  void computeInferenceMode_(const SDR &feedforwardInput, const std::vector<SDR> &lateralInputs);
+  void computeLearningMode_(const SDR &feedforwardInput, const std::vector<SDR> &lateralInputs,
+                            const SDR_sparse_t &feedforwardGrowthCandidates);
+
+  /**
+   * For each active cell, reinforce the active synapses of its segment,
+   * punish the inactive ones, and grow synapses to (a sample of) the growth
+   * candidates the segment does not connect to yet.
+   */
+  void learn_(Connections &connections, const SDR &activeInput,
+              const SDR_sparse_t &growthCandidates, Int sampleSize,
+              Permanence initialPermanence, Permanence increment, Permanence decrement);
+
+  // The cells of the segments with at least threshold active connected synapses.
+  static std::vector<CellIdx> activeSegmentCells_(Connections &connections,
+                                                  const SDR_sparse_t &activeInput,
+                                                  UInt threshold);
+
+  UInt inputWidth_ = 0u;
+  std::vector<UInt> lateralInputWidths_;
+  UInt cellCount_ = 0u;
+  UInt sdrSize_ = 0u;
+  bool onlineLearning_ = false;
+  UInt maxSdrSize_ = 0u;
+  UInt minSdrSize_ = 0u;
+
+  Permanence synPermProximalInc_ = 0.0f;
+  Permanence synPermProximalDec_ = 0.0f;
+  Permanence initialProximalPermanence_ = 0.0f;
+  Int sampleSizeProximal_ = 0;
+  UInt minThresholdProximal_ = 0u;
+  UInt predictedInhibitionThreshold_ = 0u;
+
+  Permanence synPermDistalInc_ = 0.0f;
+  Permanence synPermDistalDec_ = 0.0f;
+  Permanence initialDistalPermanence_ = 0.0f;
+  Int sampleSizeDistal_ = 0;
+  UInt activationThresholdDistal_ = 0u;
+  Real inertiaFactor_ = 1.0f;
+  bool useInertia_ = true;
+
+  std::vector<CellIdx> activeCells_;
+
+  Connections proximal_;
+  Connections internalDistal_;
+  std::vector<Connections> distal_;  // one per lateral input
+
+  Random rng_;
+};
+
+} // end namespace htm
+
+#endif // NTA_COLUMN_POOLER_HPP
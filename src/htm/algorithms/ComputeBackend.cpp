@@ -0,0 +1,260 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of ComputeBackend
+ */
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+#include <htm/algorithms/ComputeBackend.hpp>
+#include <htm/utils/Log.hpp>
+#include <htm/utils/ThreadPool.hpp>
+
+using std::string;
+using std::vector;
+using namespace htm;
+
+
+void ComputeBackend::update(const Connections &connections, const bool potential) {
+  const UInt64 version = connections.structureVersion();
+  const size_t segments = connections.segmentFlatListLength();
+  // Segments without synapses do not change the version, but the outputs
+  // must cover them too.
+  if( version == version_ and segments == segments_ and (potential_ or not potential) ) {
+    return;
+  }
+  upload_(connections, potential);
+  version_   = version;
+  segments_  = segments;
+  potential_ = potential;
+}
+
+
+namespace {
+
+/**
+ * The built in backend.  The synapses are stored by segment (CSR), each row
+ * holds the presynaptic cells of the connected synapses first, then of the
+ * other potential synapses.  The active cells are expanded into a dense mask
+ * so all segments are counted independently, in parallel ranges, with no
+ * atomics nor partial counts to sum up.
+ */
+class CpuBackend : public ComputeBackend
+{
+public:
+  explicit CpuBackend(const UInt numThreads) {
+    const size_t threads = numThreads == 0u ? ThreadPool::hardwareConcurrency() : numThreads;
+    if( threads > 1u ) pool_.reset(new ThreadPool(threads - 1u)); //the calling thread works too
+  }
+
+  string name() const override { return "cpu"; }
+
+  void overlaps(const vector<CellIdx> &active,
+                vector<SynapseIdx> &connected,
+                vector<SynapseIdx> *potential) override {
+    NTA_CHECK(potential == nullptr or hasPotential_)
+      << "ComputeBackend: the potential synapses were not uploaded.";
+    const size_t numSegments = connectedEnd_.size();
+    activeMask_.assign(numPresynaptic_, 0u);
+    for(const auto cell : active) {
+      if( cell < numPresynaptic_ ) activeMask_[cell] = 1u;
+    }
+    connected.resize(numSegments);
+    if( potential != nullptr ) potential->resize(numSegments);
+
+    parallel_(numSegments, [&](const size_t begin, const size_t end, size_t) {
+      for(size_t segment = begin; segment < end; segment++) {
+        const size_t connectedEnd = connectedEnd_[segment];
+        UInt count = 0u;
+        for(size_t i = rowOffsets_[segment]; i < connectedEnd; i++) {
+          count += activeMask_[presynaptic_[i]];
+        }
+        connected[segment] = static_cast<SynapseIdx>(count);
+        if( potential == nullptr ) continue;
+        for(size_t i = connectedEnd; i < rowOffsets_[segment + 1u]; i++) {
+          count += activeMask_[presynaptic_[i]];
+        }
+        (*potential)[segment] = static_cast<SynapseIdx>(count);
+      }
+    });
+  }
+
+  void topK(const vector<Real> &scores, const UInt k, const Real minScore,
+            vector<UInt> &winners) override {
+    winners.clear();
+    if( k == 0u ) return;
+    const auto compare = [&scores](const UInt a, const UInt b) {
+      return scores[a] == scores[b] ? a > b : scores[a] > scores[b];
+    };
+    // The k best of each range, then the k best of those.
+    const auto select = [&](vector<UInt> &candidates) {
+      if( candidates.size() <= k ) return;
+      std::nth_element(candidates.begin(), candidates.begin() + k, candidates.end(), compare);
+      candidates.resize(k);
+    };
+    parallelChunks_(scores.size(), [&](const size_t begin, const size_t end, vector<UInt> &out) {
+      for(size_t i = begin; i < end; i++) {
+        if( scores[i] >= minScore ) out.push_back(static_cast<UInt>(i));
+      }
+      select(out);
+    }, winners);
+    select(winners);
+    std::sort(winners.begin(), winners.end(), compare);
+  }
+
+  void threshold(const vector<SynapseIdx> &counts, const SynapseIdx threshold,
+                 vector<UInt> &selected) override {
+    selected.clear();
+    parallelChunks_(counts.size(), [&](const size_t begin, const size_t end, vector<UInt> &out) {
+      for(size_t i = begin; i < end; i++) {
+        if( counts[i] >= threshold ) out.push_back(static_cast<UInt>(i));
+      }
+    }, selected);
+  }
+
+protected:
+  void upload_(const Connections &connections, const bool potential) override {
+    const Permanence connectedThreshold = connections.getConnectedThreshold();
+    const size_t numSegments = connections.segmentFlatListLength();
+    const CellIdx numCells = static_cast<CellIdx>(connections.numCells());
+
+    rowOffsets_.assign(numSegments + 1u, 0u);
+    numPresynaptic_ = 0u;
+    for(CellIdx cell = 0u; cell < numCells; cell++) {
+      for(const auto segment : connections.segmentsForCell(cell)) {
+        size_t rowSize = 0u;
+        for(const auto synapse : connections.synapsesForSegment(segment)) {
+          if( not potential and connections.permanenceForSynapse(synapse) < connectedThreshold ) continue;
+          numPresynaptic_ = std::max<size_t>(numPresynaptic_, connections.presynapticCellForSynapse(synapse) + 1u);
+          rowSize++;
+        }
+        rowOffsets_[segment + 1u] = rowSize;
+      }
+    }
+    for(size_t segment = 0u; segment < numSegments; segment++) {
+      rowOffsets_[segment + 1u] += rowOffsets_[segment];
+    }
+
+    presynaptic_.resize(rowOffsets_.back());
+    connectedEnd_.assign(rowOffsets_.begin(), rowOffsets_.end() - 1u);
+    for(CellIdx cell = 0u; cell < numCells; cell++) {
+      for(const auto segment : connections.segmentsForCell(cell)) {
+        size_t &next = connectedEnd_[segment];
+        size_t last = rowOffsets_[segment + 1u];
+        for(const auto synapse : connections.synapsesForSegment(segment)) {
+          const auto presyn = connections.presynapticCellForSynapse(synapse);
+          if( connections.permanenceForSynapse(synapse) >= connectedThreshold ) {
+            presynaptic_[next++] = presyn;
+          } else if( potential ) {
+            presynaptic_[--last] = presyn;
+          }
+        }
+      }
+    }
+    hasPotential_ = potential;
+  }
+
+private:
+  // Smaller problems run on the calling thread.
+  static const size_t MIN_PARALLEL = 4096u;
+
+  void parallel_(const size_t n, const std::function<void(size_t, size_t, size_t)> &fn) {
+    if( pool_ and n >= MIN_PARALLEL ) {
+      pool_->parallelFor(n, fn);
+    } else {
+      fn(0u, n, 0u);
+    }
+  }
+
+  // Runs `fn(begin, end, out)` on ranges of [0, n) and appends the outputs of
+  // all ranges to `result`, in the order of the ranges.
+  void parallelChunks_(const size_t n,
+                       const std::function<void(size_t, size_t, vector<UInt>&)> &fn,
+                       vector<UInt> &result) {
+    if( not pool_ or n < MIN_PARALLEL ) {
+      fn(0u, n, result);
+      return;
+    }
+    chunks_.resize(pool_->numChunks(n));
+    pool_->parallelFor(n, [&](const size_t begin, const size_t end, const size_t chunk) {
+      chunks_[chunk].clear();
+      fn(begin, end, chunks_[chunk]);
+    });
+    for(const auto &chunk : chunks_) {
+      result.insert(result.end(), chunk.begin(), chunk.end());
+    }
+  }
+
+  std::unique_ptr<ThreadPool> pool_; // null for a single thread
+  vector<size_t>  rowOffsets_;    // row of segment s is [rowOffsets_[s], rowOffsets_[s+1])
+  vector<size_t>  connectedEnd_;  // end of the connected synapses of each row
+  vector<CellIdx> presynaptic_;
+  size_t          numPresynaptic_ = 0u;
+  bool            hasPotential_ = false;
+  vector<Byte>    activeMask_;     // scratch
+  vector<vector<UInt>> chunks_;   // scratch
+};
+
+const size_t CpuBackend::MIN_PARALLEL;
+
+
+std::mutex &registryMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<string, ComputeBackend::Factory> &registry() {
+  static std::map<string, ComputeBackend::Factory> backends = {
+    { "cpu", [](const UInt numThreads) -> std::shared_ptr<ComputeBackend> {
+        return std::make_shared<CpuBackend>(numThreads); } },
+  };
+  return backends;
+}
+
+} // end anonymous namespace
+
+
+void ComputeBackend::registerBackend(const string &name, const Factory &factory) {
+  NTA_CHECK(factory) << "ComputeBackend: empty factory for backend '" << name << "'.";
+  std::lock_guard<std::mutex> lock(registryMutex());
+  registry()[name] = factory;
+}
+
+
+std::shared_ptr<ComputeBackend> ComputeBackend::create(const string &name, const UInt numThreads) {
+  Factory factory;
+  {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    const auto found = registry().find(name);
+    NTA_CHECK(found != registry().end()) << "ComputeBackend: unknown backend '" << name << "'.";
+    factory = found->second;
+  }
+  return factory(numThreads);
+}
+
+
+vector<string> ComputeBackend::available() {
+  std::lock_guard<std::mutex> lock(registryMutex());
+  vector<string> names;
+  for(const auto &backend : registry()) {
+    names.push_back(backend.first);
+  }
+  return names;
+}
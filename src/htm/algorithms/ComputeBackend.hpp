@@ -0,0 +1,149 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ComputeBackend class in C++
+ */
+
+#ifndef NTA_COMPUTE_BACKEND_HPP
+#define NTA_COMPUTE_BACKEND_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * ComputeBackend - the data parallel kernels of the inference step.
+ *
+ * @b Description
+ * The overlap count (active synapses per segment), the top-k selection of
+ * the global inhibition and the thresholding of the counts are independent
+ * per segment or column.  A backend implements them on some hardware and
+ * keeps its own copy of the synapses (eg. in device memory), which is only
+ * re-uploaded when the synapse structure changed
+ * (@see Connections::structureVersion).
+ *
+ * The SpatialPooler and the TemporalMemory use a backend for inference
+ * (learn == false) once it is set with `setComputeBackend()`, the results are
+ * identical to the built in computation.  Learning always runs in the
+ * Connections.
+ *
+ * Backends are created by name from a registry.  The built in "cpu" backend
+ * keeps the synapses as a segment major CSR and processes the segments in
+ * parallel on a thread pool.  Other backends (eg. a GPU) register a factory
+ * with `registerBackend()`, before they are created.
+ *
+ * A backend holds the synapses of one Connections at a time, sharing it
+ * between models is correct but re-uploads on every switch.  It must not be
+ * used by multiple threads at once.
+ *
+ * Example Usage:
+ *    sp.setComputeBackend( ComputeBackend::create("cpu", 4u) );
+ *    sp.compute( input, false, active );
+ */
+class ComputeBackend
+{
+public:
+  using Factory = std::function<std::shared_ptr<ComputeBackend>(UInt numThreads)>;
+
+  virtual ~ComputeBackend() {}
+
+  /**
+   * @returns the name the backend is registered with.
+   */
+  virtual std::string name() const = 0;
+
+  /**
+   * Uploads the synapses of `connections`, unless they are already uploaded
+   * and unchanged since.
+   *
+   * @param potential If true, the potential (connected or not) synapses are
+   * uploaded too, so `overlaps()` can count them.
+   */
+  void update(const Connections &connections, const bool potential = false);
+
+  /**
+   * Counts the active synapses of each segment of the uploaded connections,
+   * same as `Connections::computeActivity`.  Active cells which are not a
+   * presynaptic cell of any synapse are ignored.
+   *
+   * @param active The active presynaptic cells.
+   * @param connected Output, the number of active connected synapses per
+   *        segment, resized to the `segmentFlatListLength()`.
+   * @param potential Optional output, same for the potential synapses.
+   *        Requires an `update(connections, true)`.
+   */
+  virtual void overlaps(const std::vector<CellIdx> &active,
+                        std::vector<SynapseIdx> &connected,
+                        std::vector<SynapseIdx> *potential = nullptr) = 0;
+
+  /**
+   * Selects the `k` largest scores which are at least `minScore`.
+   *
+   * @param winners Output, the indices of the winners sorted by decreasing
+   *        score, equal scores by decreasing index.  Same as the global
+   *        inhibition of the SpatialPooler.
+   */
+  virtual void topK(const std::vector<Real> &scores, const UInt k, const Real minScore,
+                    std::vector<UInt> &winners) = 0;
+
+  /**
+   * Selects the counts which are at least `threshold`.
+   *
+   * @param selected Output, the indices in increasing order.
+   */
+  virtual void threshold(const std::vector<SynapseIdx> &counts, const SynapseIdx threshold,
+                         std::vector<UInt> &selected) = 0;
+
+  /**
+   * Registers (or replaces) a backend factory.
+   */
+  static void registerBackend(const std::string &name, const Factory &factory);
+
+  /**
+   * Creates a registered backend.
+   *
+   * @param numThreads Number of threads used by the backend, including the
+   *        calling thread.  Default 1, use 0 for all hardware threads.
+   *        Device backends may ignore it.
+   */
+  static std::shared_ptr<ComputeBackend> create(const std::string &name, const UInt numThreads = 1u);
+
+  /**
+   * @returns the names of the registered backends, sorted.
+   */
+  static std::vector<std::string> available();
+
+protected:
+  // Copies the synapses of the connections, @see update().
+  virtual void upload_(const Connections &connections, const bool potential) = 0;
+
+private:
+  UInt64 version_   = 0u; // 0 means nothing uploaded
+  size_t segments_  = 0u;
+  bool   potential_ = false;
+};
+
+} // end namespace htm
+
+#endif // NTA_COMPUTE_BACKEND_HPP
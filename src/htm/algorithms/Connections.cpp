@@ -20,11 +20,14 @@
  */
 
 #include <algorithm> // nth_element
+#include <atomic>
 #include <climits>
 #include <iomanip>
 #include <iostream>
+#include <iterator> // back_inserter
 
 #include <htm/algorithms/Connections.hpp>
+#include <htm/utils/Profiler.hpp>
 
 using std::endl;
 using std::string;
@@ -33,12 +36,15 @@ using namespace htm;
 
 Connections::Connections(const CellIdx numCells, 
 		         const Permanence connectedThreshold, 
-			 const bool timeseries) {
-  initialize(numCells, connectedThreshold, timeseries);
+			 const bool timeseries,
+			 const SegmentPruning segmentPruning) {
+  initialize(numCells, connectedThreshold, timeseries, segmentPruning);
 }
 
-void Connections::initialize(CellIdx numCells, Permanence connectedThreshold, bool timeseries) {
+void Connections::initialize(CellIdx numCells, Permanence connectedThreshold, bool timeseries,
+                             const SegmentPruning segmentPruning) {
   cells_ = vector<CellData>(numCells);
+  segmentPruning_ = segmentPruning;
   segments_.clear();
   synapses_.clear();
   potentialSynapsesForPresynapticCell_.clear();
@@ -46,9 +52,21 @@ void Connections::initialize(CellIdx numCells, Permanence connectedThreshold, bo
   potentialSegmentsForPresynapticCell_.clear();
   connectedSegmentsForPresynapticCell_.clear();
   eventHandlers_.clear();
+  destroyedSegments_ = 0;
+  destroyedSynapses_ = 0;
+  freeSegments_.clear();
+  pendingFreeSegments_.clear();
+  freeSynapses_.clear();
+  pendingEmptyPresynaptic_.clear();
+  structureChanged_();
+  clearDirty_();
+  allDirty_ = deltaTracking_;
   NTA_CHECK(connectedThreshold >= minPermanence);
   NTA_CHECK(connectedThreshold <= maxPermanence);
   connectedThreshold_ = connectedThreshold - htm::Epsilon;
+  connectedThresholdStored_ = Codec::threshold(connectedThreshold_);
+  NTA_CHECK(connectedThresholdStored_ > Codec::encode(minPermanence) or std::is_floating_point<PermanenceStorage>::value)
+    << "connectedThreshold " << connectedThreshold << " is below the resolution of the permanence storage.";
   iteration_ = 0;
 
   nextEventToken_ = 0;
@@ -58,14 +76,21 @@ void Connections::initialize(CellIdx numCells, Permanence connectedThreshold, bo
 }
 
 UInt32 Connections::subscribe(ConnectionsEventHandler *handler) {
+#ifdef NTA_CONNECTIONS_NO_EVENTS
+  delete handler;
+  NTA_THROW << "Connections::subscribe: event handlers are disabled in this build (NTA_CONNECTIONS_NO_EVENTS).";
+#endif
   UInt32 token = nextEventToken_++;
-  eventHandlers_[token] = handler;
+  eventHandlers_.emplace_back(token, handler);
   return token;
 }
 
 void Connections::unsubscribe(UInt32 token) {
-  delete eventHandlers_.at(token);
-  eventHandlers_.erase(token);
+  const auto handler = std::find_if(eventHandlers_.begin(), eventHandlers_.end(),
+      [token](const std::pair<UInt32, ConnectionsEventHandler*> &h) { return h.first == token; });
+  NTA_CHECK(handler != eventHandlers_.end()) << "Connections::unsubscribe: unknown token " << token;
+  delete handler->second;
+  eventHandlers_.erase(handler);
 }
 
 
@@ -74,6 +99,24 @@ void Connections::pruneLRUSegment_(const CellIdx& cell) {
 #ifdef NTA_ASSERTIONS_ON
   const auto numBefore = destroyCandidates.size();
 #endif
+  if(destroyCandidates.empty()) return;
+
+  if(segmentPruning_ == SegmentPruning::OLDEST) {
+    destroySegment(destroyCandidates.front()); //segments on a cell are kept in order of creation
+    NTA_ASSERT(destroyCandidates.size() < numBefore) << "A segment should have been pruned, but wasn't!";
+    return;
+  }
+  if(segmentPruning_ == SegmentPruning::RANDOM) {
+    // hash of the state, so the choice is reproducible (also after save/load)
+    UInt64 h = (static_cast<UInt64>(iteration_) << 32u) ^ (static_cast<UInt64>(cell) * 0x9E3779B97F4A7C15ull) ^ nextSegmentOrdinal_;
+    h ^= h >> 33u;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33u;
+    destroySegment(destroyCandidates[h % destroyCandidates.size()]);
+    NTA_ASSERT(destroyCandidates.size() < numBefore) << "A segment should have been pruned, but wasn't!";
+    return;
+  }
+
   const auto compareSegmentsByLRU = [&](const Segment a, const Segment b) {
     if(dataForSegment(a).lastUsed == dataForSegment(b).lastUsed) {
       return a < b; //needed for deterministic sort
@@ -107,18 +150,28 @@ Segment Connections::createSegment(const CellIdx cell,
   NTA_ASSERT(numSegments(cell) <= maxSegmentsPerCell);
 
   //proceed to create a new segment
-  NTA_CHECK(segments_.size() < std::numeric_limits<Segment>::max()) << "Add segment failed: Range of Segment (data-type) insufficinet size."
+  const SegmentData& segmentData = SegmentData(cell, nextSegmentOrdinal_++, iteration_);
+  Segment segment;
+  if( not freeSegments_.empty() ) { //reuse the slot of a destroyed segment
+    segment = freeSegments_.back();
+    freeSegments_.pop_back();
+    segments_[segment] = segmentData;
+    NTA_ASSERT(destroyedSegments_ > 0);
+    destroyedSegments_--;
+  }
+  else {
+    NTA_CHECK(segments_.size() < std::numeric_limits<Segment>::max()) << "Add segment failed: Range of Segment (data-type) insufficinet size."
 	    << (size_t)segments_.size() << " < " << (size_t)std::numeric_limits<Segment>::max();
-  const Segment segment = static_cast<Segment>(segments_.size());
-  const SegmentData& segmentData = SegmentData(cell, iteration_, nextSegmentOrdinal_++);
-  segments_.push_back(segmentData);
+    segment = static_cast<Segment>(segments_.size());
+    segments_.push_back(segmentData);
+  }
 
   CellData &cellData = cells_[cell];
   cellData.segments.push_back(segment); //assign the new segment to its mother-cell
+  markSegment_(segment);
+  markCell_(cell);
 
-  for (auto h : eventHandlers_) {
-    h.second->onCreateSegment(segment);
-  }
+  notify_([&](ConnectionsEventHandler *h) { h->onCreateSegment(segment); });
 
   return segment;
 }
@@ -139,7 +192,7 @@ Synapse Connections::createSynapse(Segment segment,
   // Synapses are supposed to have binary effects (0 or 1) but duplicate synapses give
   // them (synapses 0/1) varying levels of strength.
   for (const Synapse& syn : synapsesForSegment(segment)) {
-    const CellIdx existingPresynapticCell = dataForSynapse(syn).presynapticCell; //TODO 1; add way to get all presynaptic cells for segment (fast)
+    const CellIdx existingPresynapticCell = synapses_.presynapticCell[syn];
     if (presynapticCell == existingPresynapticCell) {
       //synapse (connecting to this presyn cell) already exists on the segment; don't create a new one, exit early and return the existing
       NTA_ASSERT(synapseExists_(syn));
@@ -149,22 +202,49 @@ Synapse Connections::createSynapse(Segment segment,
       //3. create a duplicit new synapse -- NO. This is the only choice that is incorrect! HTM works on binary synapses, duplicates would break that.
       //4. update to the max of the permanences (default)
 
-      auto& synData = synapses_[syn];
-      if(permanence > synData.permanence) updateSynapsePermanence(syn, permanence);
+      if(permanence > permanenceForSynapse(syn)) updateSynapsePermanence(syn, permanence);
       return syn;
     }
   } //else: the new synapse is not duplicit, so keep creating it. 
 
+  return createSynapseUnchecked_(segment, presynapticCell, permanence);
+}
 
 
-  // Get an index into the synapses_ list, for the new synapse to reside at.
-  NTA_ASSERT(synapses_.size() < std::numeric_limits<Synapse>::max()) << "Add synapse failed: Range of Synapse (data-type) insufficient size."
-	    << synapses_.size() << " < " << (size_t)std::numeric_limits<Synapse>::max();
-  const Synapse synapse = static_cast<Synapse>(synapses_.size()); //TODO work on cache locality. Have all Synapse, SynapseData on Segment in continuous mem block ?
-  synapses_.emplace_back(SynapseData());
+size_t Connections::growSynapses(const Segment segment,
+                                 const vector<CellIdx> &candidates,
+                                 const Permanence permanence,
+                                 const size_t maxNew) {
+  if( maxNew == 0u or candidates.empty() ) return 0u;
 
+  // The presynaptic cells already on the segment, sorted for the lookups.
+  auto &existing = growExisting_; //reused scratch
+  existing.clear();
+  for (const Synapse syn : synapsesForSegment(segment)) {
+    existing.emplace_back(synapses_.presynapticCell[syn], syn);
+  }
+  std::sort(existing.begin(), existing.end());
+
+  size_t created = 0u;
+  for (const CellIdx cell : candidates) {
+    const auto it = std::lower_bound(existing.cbegin(), existing.cend(), std::make_pair(cell, Synapse(0u)));
+    if (it != existing.cend() and it->first == cell) {
+      // same as createSynapse() on an existing synapse
+      if(permanence > permanenceForSynapse(it->second)) updateSynapsePermanence(it->second, permanence);
+      continue;
+    }
+    createSynapseUnchecked_(segment, cell, permanence);
+    if (++created == maxNew) break;
+  }
+  return created;
+}
+
+
+Synapse Connections::createSynapseUnchecked_(const Segment segment,
+                                             const CellIdx presynapticCell,
+                                             const Permanence permanence) {
   // Fill in the new synapse's data
-  SynapseData &synapseData    = synapses_[synapse];
+  SynapseData synapseData;
   synapseData.presynapticCell = presynapticCell;
   synapseData.segment         = segment;
   synapseData.id              = nextSynapseOrdinal_++; //TODO move these to SynData constructor
@@ -172,16 +252,45 @@ Synapse Connections::createSynapse(Segment segment,
   synapseData.permanence           = connectedThreshold_ - 1.0f;
   synapseData.presynapticMapIndex_ = 
     (Synapse)potentialSynapsesForPresynapticCell_[presynapticCell].size();
+
+  // Get an index into the synapses_ list, for the new synapse to reside at.
+  // Slots of destroyed synapses are reused first.
+  Synapse synapse;
+  if( not freeSynapses_.empty() ) {
+    synapse = freeSynapses_.back();
+    freeSynapses_.pop_back();
+    synapses_.set(synapse, synapseData);
+    NTA_ASSERT(destroyedSynapses_ > 0);
+    destroyedSynapses_--;
+    // forget the timeseries history of the former synapse in this slot
+    if( timeseries_ ) {
+      const auto found = std::lower_bound(previousUpdated_.cbegin(), previousUpdated_.cend(), synapse);
+      if( found != previousUpdated_.cend() and *found == synapse ) {
+        previousUpdates_[found - previousUpdated_.cbegin()] = minPermanence;
+      }
+      if( not currentUpdated_.empty() ) { //overrides an earlier update of this step
+        currentUpdated_.push_back(synapse);
+        currentUpdates_.push_back(minPermanence);
+      }
+    }
+  }
+  else {
+    NTA_ASSERT(synapses_.size() < std::numeric_limits<Synapse>::max()) << "Add synapse failed: Range of Synapse (data-type) insufficient size."
+	    << synapses_.size() << " < " << (size_t)std::numeric_limits<Synapse>::max();
+    synapse = static_cast<Synapse>(synapses_.size()); //TODO work on cache locality. Have all Synapse, SynapseData on Segment in continuous mem block ?
+    synapses_.push_back(synapseData);
+  }
   potentialSynapsesForPresynapticCell_[presynapticCell].push_back(synapse);
   potentialSegmentsForPresynapticCell_[presynapticCell].push_back(segment);
+  structureChanged_();
+  markSegment_(segment);
+  markPresynaptic_(presynapticCell);
 
   SegmentData &segmentData = segments_[segment];
   segmentData.synapses.push_back(synapse);
 
 
-  for (auto h : eventHandlers_) {
-    h.second->onCreateSynapse(synapse);
-  }
+  notify_([&](ConnectionsEventHandler *h) { h->onCreateSynapse(synapse); });
 
   updateSynapsePermanence(synapse, permanence);
 
@@ -204,20 +313,19 @@ bool Connections::synapseExists_(const Synapse synapse, bool fast) const {
 #endif
   if(!fast) {
   //proper but slow method to check for valid, existing synapse
-  const SynapseData &synapseData = synapses_[synapse];
   const vector<Synapse> &synapsesOnSegment =
-      segments_[synapseData.segment].synapses;
+      segments_[synapses_.segment[synapse]].synapses;
   const bool found = (std::find(synapsesOnSegment.begin(), synapsesOnSegment.end(), synapse) != synapsesOnSegment.end());
   //validate the fast & slow methods for same result:
 #ifdef NTA_ASSERTIONS_ON
-  const bool removed = synapses_[synapse].permanence == -1;
+  const bool removed = synapses_.permanence[synapse] == Codec::removed();
   NTA_ASSERT( (removed and not found) or (not removed and found) );
 #endif
   return found;
 
   } else {
   //quick method. Relies on hack in destroySynapse() where we set synapseData.permanence == -1
-  return synapses_[synapse].permanence != -1;
+  return synapses_.permanence[synapse] != Codec::removed();
   }
 }
 
@@ -235,7 +343,7 @@ void Connections::removeSynapseFromPresynapticMap_(
   NTA_ASSERT( preSynapses.size() == preSegments.size() );
 
   const auto move = preSynapses.back();
-  synapses_[move].presynapticMapIndex_ = index;
+  synapses_.presynapticMapIndex.ref(move) = index;
   preSynapses[index] = move;
   preSynapses.pop_back();
 
@@ -247,9 +355,8 @@ void Connections::removeSynapseFromPresynapticMap_(
 void Connections::destroySegment(const Segment segment) {
   if(not segmentExists_(segment)) return;
 
-  for (auto h : eventHandlers_) {
-    h.second->onDestroySegment(segment);
-  }
+  notify_([&](ConnectionsEventHandler *h) { h->onDestroySegment(segment); });
+  markSegment_(segment);
 
   SegmentData &segmentData = segments_[segment];
 
@@ -265,63 +372,140 @@ void Connections::destroySegment(const Segment segment) {
   NTA_ASSERT(*segmentOnCell == segment);
 
   cellData.segments.erase(segmentOnCell);
+  markCell_(segmentData.cell);
   destroyedSegments_++;
+  // The slot is recycled only at the next learning computeActivity(), callers (TM) may
+  // still hold lists of segments from the current step.
+  pendingFreeSegments_.push_back(segment);
 
   NTA_ASSERT(not segmentExists_(segment));
 }
 
 
 void Connections::destroySynapse(const Synapse synapse) {
+  destroySynapse_(synapse, true);
+}
+
+
+void Connections::destroySynapse_(const Synapse synapse, const bool eraseFromSegment) {
   if(not synapseExists_(synapse, true)) return;
 
-  for (auto h : eventHandlers_) {
-    h.second->onDestroySynapse(synapse);
+  if( eraseFromSegment ) { //else destroySynapses_() has notified
+    notify_([&](ConnectionsEventHandler *h) { h->onDestroySynapse(synapse); });
   }
 
-  SynapseData& synapseData = synapses_[synapse]; //like dataForSynapse() but here we need writeable access
-  SegmentData &segmentData = segments_[synapseData.segment];
-  const auto   presynCell  = synapseData.presynapticCell;
+  SegmentData &segmentData = segments_[synapses_.segment[synapse]];
+  const auto   presynCell  = synapses_.presynapticCell[synapse];
+  markSegment_(synapses_.segment[synapse]);
+  markSynapse_(synapse);
+  markPresynaptic_(presynCell);
 
-  if( synapseData.permanence >= connectedThreshold_ ) {
+  if( synapses_.permanence[synapse] >= connectedThresholdStored_ ) {
     segmentData.numConnected--;
 
     removeSynapseFromPresynapticMap_(
-      synapseData.presynapticMapIndex_,
+      synapses_.presynapticMapIndex[synapse],
       connectedSynapsesForPresynapticCell_.at( presynCell ),
       connectedSegmentsForPresynapticCell_.at( presynCell ));
 
     if( connectedSynapsesForPresynapticCell_.at( presynCell ).empty() ){
-      connectedSynapsesForPresynapticCell_.erase( presynCell );
-      connectedSegmentsForPresynapticCell_.erase( presynCell );
+      if( deferMaintenance_ ) {
+        pendingEmptyPresynaptic_.emplace_back(presynCell, true);
+      }
+      else {
+        connectedSynapsesForPresynapticCell_.erase( presynCell );
+        connectedSegmentsForPresynapticCell_.erase( presynCell );
+      }
     }
   }
   else {
     removeSynapseFromPresynapticMap_(
-      synapseData.presynapticMapIndex_,
+      synapses_.presynapticMapIndex[synapse],
       potentialSynapsesForPresynapticCell_.at( presynCell ),
       potentialSegmentsForPresynapticCell_.at( presynCell ));
 
     if( potentialSynapsesForPresynapticCell_.at( presynCell ).empty() ){
-      potentialSynapsesForPresynapticCell_.erase( presynCell );
-      potentialSegmentsForPresynapticCell_.erase( presynCell );
+      if( deferMaintenance_ ) {
+        pendingEmptyPresynaptic_.emplace_back(presynCell, false);
+      }
+      else {
+        potentialSynapsesForPresynapticCell_.erase( presynCell );
+        potentialSegmentsForPresynapticCell_.erase( presynCell );
+      }
     }
   }
-  
-  const auto synapseOnSegment = std::lower_bound(segmentData.synapses.cbegin(), 
-		                          segmentData.synapses.cend(),
-					  synapse,
-					  [&](const Synapse a, const Synapse b) -> bool { return dataForSynapse(a).id < dataForSynapse(b).id;}
-					  ); 
 
-  NTA_ASSERT(synapseOnSegment != segmentData.synapses.cend());
-  NTA_ASSERT(*synapseOnSegment == synapse);
+  if( eraseFromSegment ) {
+    const auto synapseOnSegment = std::lower_bound(segmentData.synapses.cbegin(),
+                                                   segmentData.synapses.cend(),
+                                                   synapse,
+                                                   [&](const Synapse a, const Synapse b) -> bool { return synapses_.id[a] < synapses_.id[b];}
+                                                   );
 
-  segmentData.synapses.erase(synapseOnSegment);
-  //Note: dataForSynapse(synapse) are not deleted, unfortunately. And are still accessible. 
+    NTA_ASSERT(synapseOnSegment != segmentData.synapses.cend());
+    NTA_ASSERT(*synapseOnSegment == synapse);
+
+    segmentData.synapses.erase(synapseOnSegment);
+  }
+  structureChanged_();
+  //Note: dataForSynapse(synapse) are not deleted, the slot is recycled by the next createSynapse().
   //To mark them as "removed", we set SynapseData.permanence = -1, this can be used for a quick check later
-  synapseData.permanence = -1; //marking as "removed"
+  synapses_.permanence.ref(synapse) = Codec::removed(); //marking as "removed"
   destroyedSynapses_++;
-  NTA_ASSERT(not synapseExists_(synapse));
+  freeSynapses_.push_back(synapse);
+  NTA_ASSERT(not eraseFromSegment or not synapseExists_(synapse));
+}
+
+
+void Connections::destroySynapses_(const Synapse *begin, const Synapse *end) {
+  const auto removed = [&](const Synapse syn) { return synapses_.permanence[syn] == Codec::removed(); };
+  // The synapses come grouped by segment, a segment seen again is just compacted again.
+  // The handlers of a run are notified while its segment is still intact, then the
+  // run is destroyed, then the segment's list is compacted: no handler sees a destroyed
+  // synapse in a segment's list.
+  for(auto run = begin; run != end; ) {
+    const Segment segment = synapses_.segment[*run];
+    auto runEnd = run;
+    while( runEnd != end and synapses_.segment[*runEnd] == segment ) runEnd++;
+
+    for(auto syn = run; syn != runEnd; syn++) {
+      if( not removed(*syn) ) notify_([&](ConnectionsEventHandler *h) { h->onDestroySynapse(*syn); });
+    }
+    for(auto syn = run; syn != runEnd; syn++) {
+      if( not removed(*syn) ) destroySynapse_(*syn, false);
+    }
+    auto &synapses = segments_[segment].synapses;
+    synapses.erase(std::remove_if(synapses.begin(), synapses.end(), removed), synapses.end());
+    run = runEnd;
+  }
+}
+
+
+void Connections::setDeferredMaintenance(const bool enable, const UInt interval) {
+  deferMaintenance_    = enable;
+  maintenanceInterval_ = enable ? interval : 0u;
+  if( not enable ) applyMaintenance();
+}
+
+
+void Connections::applyMaintenance() {
+  erasePendingEmptyPresynaptic_();
+  maintenanceDue_ = false;
+}
+
+
+void Connections::erasePendingEmptyPresynaptic_() const {
+  for(const auto &entry : pendingEmptyPresynaptic_) {
+    const CellIdx presynCell = entry.first;
+    auto &synapses = entry.second ? connectedSynapsesForPresynapticCell_ : potentialSynapsesForPresynapticCell_;
+    auto &segments = entry.second ? connectedSegmentsForPresynapticCell_ : potentialSegmentsForPresynapticCell_;
+    const auto found = synapses.find(presynCell);
+    // the cell may have been queued twice, or regrown synapses since
+    if( found == synapses.end() or not found->second.empty() ) continue;
+    synapses.erase(found);
+    segments.erase(presynCell);
+  }
+  pendingEmptyPresynaptic_.clear();
 }
 
 
@@ -330,34 +514,43 @@ void Connections::updateSynapsePermanence(const Synapse synapse,
   permanence = std::min(permanence, maxPermanence );
   permanence = std::max(permanence, minPermanence );
 
-  auto &synData = synapses_[synapse];
-  
-  const bool before = synData.permanence >= connectedThreshold_;
-  const bool after  = permanence         >= connectedThreshold_;
+  const PermanenceStorage newPermanence = Codec::encode(permanence);
+
+  const bool before = synapses_.permanence[synapse] >= connectedThresholdStored_;
+  const bool after  = newPermanence >= connectedThresholdStored_;
 
   // update the permanence
-  synData.permanence = permanence;
+  synapses_.permanence.ref(synapse) = newPermanence;
+  markSegment_(synapses_.segment[synapse]);
 
   if( before == after ) { //no change in dis/connected status
       return;
   }
-    const auto &presyn    = synData.presynapticCell;
+  updateConnectedState_(synapse, after);
+}
+
+
+void Connections::updateConnectedState_(const Synapse synapse, const bool connected) {
+    structureChanged_();
+    const auto presyn     = synapses_.presynapticCell[synapse];
+    markPresynaptic_(presyn);
     auto &potentialPresyn = potentialSynapsesForPresynapticCell_[presyn];
     auto &potentialPreseg = potentialSegmentsForPresynapticCell_[presyn];
     auto &connectedPresyn = connectedSynapsesForPresynapticCell_[presyn];
     auto &connectedPreseg = connectedSegmentsForPresynapticCell_[presyn];
-    const auto &segment   = synData.segment;
+    const auto segment    = synapses_.segment[synapse];
+    Synapse &presynapticMapIndex = synapses_.presynapticMapIndex.ref(synapse);
     auto &segmentData     = segments_[segment];
     
-    if( after ) { //connect
+    if( connected ) { //connect
       segmentData.numConnected++;
 
       // Remove this synapse from presynaptic potential synapses.
-      removeSynapseFromPresynapticMap_( synData.presynapticMapIndex_,
+      removeSynapseFromPresynapticMap_( presynapticMapIndex,
                                         potentialPresyn, potentialPreseg );
 
       // Add this synapse to the presynaptic connected synapses.
-      synData.presynapticMapIndex_ = (Synapse)connectedPresyn.size();
+      presynapticMapIndex = (Synapse)connectedPresyn.size();
       connectedPresyn.push_back( synapse );
       connectedPreseg.push_back( segment );
     }
@@ -365,18 +558,16 @@ void Connections::updateSynapsePermanence(const Synapse synapse,
       segmentData.numConnected--;
 
       // Remove this synapse from presynaptic connected synapses.
-      removeSynapseFromPresynapticMap_( synData.presynapticMapIndex_,
+      removeSynapseFromPresynapticMap_( presynapticMapIndex,
                                         connectedPresyn, connectedPreseg );
 
       // Add this synapse to the presynaptic connected synapses.
-      synData.presynapticMapIndex_ = (Synapse)potentialPresyn.size();
+      presynapticMapIndex = (Synapse)potentialPresyn.size();
       potentialPresyn.push_back( synapse );
       potentialPreseg.push_back( segment );
     }
 
-    for (auto h : eventHandlers_) { //TODO handle callbacks in performance-critical method only in Debug?
-      h.second->onUpdateSynapsePermanence(synapse, permanence);
-    }
+    notify_([&](ConnectionsEventHandler *h) { h->onUpdateSynapsePermanence(synapse, Codec::decode(synapses_.permanence[synapse])); });
 }
 
 
@@ -399,6 +590,74 @@ bool Connections::compareSegments(const Segment a, const Segment b) const {
 }
 
 
+void Connections::sortSegments(vector<Segment> &segments) {
+  const size_t n = segments.size();
+  if( n < 2u ) return;
+
+  // key = (cell, SegmentData.id, flat index) packed from the high to the low bits
+  const auto bitsFor = [](UInt64 maxValue) {
+    UInt bits = 0u;
+    while( maxValue > 0u ) { bits++; maxValue >>= 1u; }
+    return bits;
+  };
+  CellIdx maxCell = 0u;
+  Segment maxId = 0u;
+  for(const auto segment : segments) {
+    maxCell = std::max(maxCell, segments_[segment].cell);
+    maxId   = std::max(maxId,   segments_[segment].id);
+  }
+  const UInt segmentBits = bitsFor(segments_.size());
+  const UInt idBits      = bitsFor(maxId);
+  const UInt keyBits     = segmentBits + idBits + bitsFor(maxCell);
+  if( keyBits > 64u ) { //does not fit a key, plain comparison sort
+    std::sort(segments.begin(), segments.end(), [&](const Segment a, const Segment b) {
+      return compareSegments(a, b) or (not compareSegments(b, a) and a < b);
+    });
+    return;
+  }
+
+  auto &keys = sortKeys_;
+  keys.resize(n);
+  for(size_t i = 0u; i < n; i++) {
+    const SegmentData &data = segments_[segments[i]];
+    const UInt64 key = (((static_cast<UInt64>(data.cell) << idBits) | data.id) << segmentBits) | segments[i];
+    keys[i] = { key, segments[i] };
+  }
+
+  constexpr size_t minRadixSort = 256u; //below this, a comparison sort on the keys is faster
+  if( n < minRadixSort ) {
+    std::sort(keys.begin(), keys.end());
+  }
+  else { // LSD radix sort, 11 bits per pass
+    constexpr UInt digitBits = 11u;
+    constexpr size_t numBuckets = size_t(1u) << digitBits;
+    size_t offsets[numBuckets];
+    auto &tmp = sortKeysTmp_;
+    tmp.resize(n);
+    for(UInt shift = 0u; shift < keyBits; shift += digitBits) {
+      std::fill(offsets, offsets + numBuckets, 0u);
+      for(const auto &key : keys) {
+        offsets[(key.first >> shift) & (numBuckets - 1u)]++;
+      }
+      size_t sum = 0u;
+      for(auto &offset : offsets) {
+        const size_t count = offset;
+        offset = sum;
+        sum += count;
+      }
+      for(const auto &key : keys) {
+        tmp[offsets[(key.first >> shift) & (numBuckets - 1u)]++] = key;
+      }
+      keys.swap(tmp);
+    }
+  }
+
+  for(size_t i = 0u; i < n; i++) {
+    segments[i] = keys[i].second;
+  }
+}
+
+
 vector<Synapse> Connections::synapsesForPresynapticCell(const CellIdx presynapticCell) const {
   vector<Synapse> all;
 
@@ -416,36 +675,531 @@ vector<Synapse> Connections::synapsesForPresynapticCell(const CellIdx presynapti
 }
 
 
+std::pair<Connections::SynapseSpan, Connections::SynapseSpan>
+Connections::synapseSpansForPresynapticCell(const CellIdx presynapticCell) const {
+  const auto span = [presynapticCell](const decltype(connectedSynapsesForPresynapticCell_) &map) -> SynapseSpan {
+    const auto it = map.find(presynapticCell);
+    if( it == map.end() ) return SynapseSpan{nullptr, nullptr};
+    const Synapse *data = it->second.data();
+    return SynapseSpan{data, data + it->second.size()};
+  };
+  return std::make_pair(span(connectedSynapsesForPresynapticCell_),
+                        span(potentialSynapsesForPresynapticCell_));
+}
+
+
+void Connections::presynapticAdjacency(vector<Synapse> &offsets,
+                                       vector<Synapse> &synapses,
+                                       vector<Synapse> &numConnected) const {
+  size_t numPresyn = 0u;
+  for(const auto &cellSyns : potentialSynapsesForPresynapticCell_) {
+    numPresyn = std::max(numPresyn, (size_t)cellSyns.first + 1u);
+  }
+  for(const auto &cellSyns : connectedSynapsesForPresynapticCell_) {
+    numPresyn = std::max(numPresyn, (size_t)cellSyns.first + 1u);
+  }
+
+  offsets.assign(numPresyn + 1u, 0u);
+  numConnected.assign(numPresyn, 0u);
+  for(const auto &cellSyns : connectedSynapsesForPresynapticCell_) {
+    numConnected[cellSyns.first] = static_cast<Synapse>(cellSyns.second.size());
+    offsets[cellSyns.first + 1u] += static_cast<Synapse>(cellSyns.second.size());
+  }
+  for(const auto &cellSyns : potentialSynapsesForPresynapticCell_) {
+    offsets[cellSyns.first + 1u] += static_cast<Synapse>(cellSyns.second.size());
+  }
+  for(size_t i = 1u; i <= numPresyn; i++) {
+    offsets[i] += offsets[i - 1u];
+  }
+
+  synapses.resize(offsets.back());
+  for(CellIdx cell = 0u; cell < numPresyn; cell++) {
+    const auto spans = synapseSpansForPresynapticCell(cell);
+    auto out = std::copy(spans.first.begin(), spans.first.end(), synapses.begin() + offsets[cell]);
+    std::copy(spans.second.begin(), spans.second.end(), out);
+  }
+}
+
+
+void Connections::exportSegments(vector<CellIdx> &segmentCells,
+                                 vector<Synapse> &offsets,
+                                 vector<CellIdx> &presynapticCells,
+                                 vector<Permanence> &permanences) const {
+  segmentCells.clear();
+  segmentCells.reserve(numSegments());
+  offsets.assign(1u, 0u);
+  offsets.reserve(numSegments() + 1u);
+  presynapticCells.clear();
+  presynapticCells.reserve(numSynapses());
+  permanences.clear();
+  permanences.reserve(numSynapses());
+  for(CellIdx cell = 0u; cell < cells_.size(); cell++) {
+    for(const Segment seg : cells_[cell].segments) {
+      segmentCells.push_back(cell);
+      for(const Synapse syn : segments_[seg].synapses) {
+        presynapticCells.push_back(synapses_.presynapticCell[syn]);
+        permanences.push_back(Codec::decode(synapses_.permanence[syn]));
+      }
+      offsets.push_back(static_cast<Synapse>(presynapticCells.size()));
+    }
+  }
+}
+
+
+void Connections::importSegments(const vector<CellIdx> &segmentCells,
+                                 const vector<Synapse> &offsets,
+                                 const vector<CellIdx> &presynapticCells,
+                                 const vector<Permanence> &permanences) {
+  const size_t numSegs = segmentCells.size();
+  const size_t numSyns = presynapticCells.size();
+  NTA_CHECK(offsets.size() == numSegs + 1u and offsets.front() == 0u and offsets.back() == numSyns)
+    << "Connections::importSegments: expected " << numSegs + 1u << " offsets from 0 to " << numSyns;
+  NTA_CHECK(permanences.size() == numSyns)
+    << "Connections::importSegments: " << permanences.size() << " permanences for " << numSyns << " synapses";
+  NTA_CHECK(numSegs < std::numeric_limits<Segment>::max() and numSyns < std::numeric_limits<Synapse>::max())
+    << "Connections::importSegments: too many segments or synapses";
+  vector<CellIdx> presyn; //the cells of one segment, sorted
+  for(size_t seg = 0u; seg < numSegs; seg++) {
+    NTA_CHECK(segmentCells[seg] < cells_.size())
+      << "Connections::importSegments: segment " << seg << " on cell " << segmentCells[seg] << " out of range";
+    NTA_CHECK(offsets[seg] <= offsets[seg + 1u]) << "Connections::importSegments: offsets must not decrease";
+    presyn.assign(presynapticCells.cbegin() + offsets[seg], presynapticCells.cbegin() + offsets[seg + 1u]);
+    std::sort(presyn.begin(), presyn.end());
+    NTA_CHECK(std::adjacent_find(presyn.cbegin(), presyn.cend()) == presyn.cend())
+      << "Connections::importSegments: segment " << seg << " has duplicate presynaptic cells";
+  }
+  for(const auto permanence : permanences) {
+    NTA_CHECK(permanence >= minPermanence and permanence <= maxPermanence)
+      << "Connections::importSegments: permanence " << permanence << " not in [0, 1]";
+  }
+
+  // Replace the state, the settings and the subscribers stay.
+  for(auto &cellData : cells_) cellData.segments.clear();
+  segments_.clear();
+  segments_.reserve(numSegs);
+  synapses_.clear();
+  destroyedSegments_ = 0;
+  destroyedSynapses_ = 0;
+  freeSegments_.clear();
+  pendingFreeSegments_.clear();
+  freeSynapses_.clear();
+  pendingEmptyPresynaptic_.clear();
+  previousUpdated_.clear();
+  previousUpdates_.clear();
+  currentUpdated_.clear();
+  currentUpdates_.clear();
+
+  // The rows of the presynaptic maps, reserved before they are filled.
+  std::unordered_map<CellIdx, std::pair<Synapse, Synapse>> rowSizes; //connected, potential
+  for(size_t syn = 0u; syn < numSyns; syn++) {
+    auto &sizes = rowSizes[presynapticCells[syn]];
+    if( Codec::encode(permanences[syn]) >= connectedThresholdStored_ ) sizes.first++;
+    else sizes.second++;
+  }
+  potentialSynapsesForPresynapticCell_.clear();
+  connectedSynapsesForPresynapticCell_.clear();
+  potentialSegmentsForPresynapticCell_.clear();
+  connectedSegmentsForPresynapticCell_.clear();
+  for(const auto &row : rowSizes) {
+    if( row.second.first > 0u ) {
+      connectedSynapsesForPresynapticCell_[row.first].reserve(row.second.first);
+      connectedSegmentsForPresynapticCell_[row.first].reserve(row.second.first);
+    }
+    if( row.second.second > 0u ) {
+      potentialSynapsesForPresynapticCell_[row.first].reserve(row.second.second);
+      potentialSegmentsForPresynapticCell_[row.first].reserve(row.second.second);
+    }
+  }
+
+  for(size_t seg = 0u; seg < numSegs; seg++) {
+    const Segment segment = static_cast<Segment>(seg);
+    segments_.emplace_back(segmentCells[seg], nextSegmentOrdinal_++, iteration_);
+    cells_[segmentCells[seg]].segments.push_back(segment);
+    SegmentData &segmentData = segments_.back();
+    segmentData.synapses.reserve(offsets[seg + 1u] - offsets[seg]);
+    for(Synapse syn = offsets[seg]; syn < offsets[seg + 1u]; syn++) {
+      const CellIdx presynCell = presynapticCells[syn];
+      const bool connected = Codec::encode(permanences[syn]) >= connectedThresholdStored_;
+      auto &presynSynapses = connected ? connectedSynapsesForPresynapticCell_[presynCell]
+                                       : potentialSynapsesForPresynapticCell_[presynCell];
+      auto &presynSegments = connected ? connectedSegmentsForPresynapticCell_[presynCell]
+                                       : potentialSegmentsForPresynapticCell_[presynCell];
+      SynapseData synapseData;
+      synapseData.presynapticCell      = presynCell;
+      synapseData.permanence           = permanences[syn];
+      synapseData.segment              = segment;
+      synapseData.presynapticMapIndex_ = static_cast<Synapse>(presynSynapses.size());
+      synapseData.id                   = nextSynapseOrdinal_++;
+      synapses_.push_back(synapseData);
+      presynSynapses.push_back(syn);
+      presynSegments.push_back(segment);
+      segmentData.synapses.push_back(syn);
+      if( connected ) segmentData.numConnected++;
+    }
+  }
+
+  structureChanged_();
+  clearDirty_();
+  allDirty_ = deltaTracking_;
+  notify_([&](ConnectionsEventHandler *h) {
+    for(Segment seg = 0u; seg < numSegs; seg++) h->onCreateSegment(seg);
+    for(Synapse syn = 0u; syn < numSyns; syn++) h->onCreateSynapse(syn);
+  });
+}
+
+
 void Connections::reset() noexcept
 {
   if( not timeseries_ ) {
     NTA_WARN << "Connections::reset() called with timeseries=false.";
   }
+  previousUpdated_.clear();
+  previousUpdates_.clear();
+  currentUpdated_.clear();
+  currentUpdates_.clear();
+}
+
+
+Permanence Connections::previousUpdate_(const Synapse synapse) const {
+  const auto found = std::lower_bound(previousUpdated_.cbegin(), previousUpdated_.cend(), synapse);
+  if( found == previousUpdated_.cend() or *found != synapse ) return minPermanence;
+  return previousUpdates_[found - previousUpdated_.cbegin()];
+}
+
+
+void Connections::recordUpdates_(const vector<std::pair<Synapse, Permanence>> &updates) {
+  for(const auto &update : updates) {
+    currentUpdated_.push_back(update.first);
+    currentUpdates_.push_back(update.second);
+  }
+}
+
+
+void Connections::rotateUpdates_() {
+  // Sort the updates of this step by synapse, keeping the last update of each.
+  auto &keys = rotateScratch_;
+  keys.clear();
+  for(size_t i = 0; i < currentUpdated_.size(); i++) {
+    keys.emplace_back((static_cast<UInt64>(currentUpdated_[i]) << 32u) | i, currentUpdates_[i]);
+  }
+  std::sort(keys.begin(), keys.end(),
+            [](const std::pair<UInt64, Permanence> &a, const std::pair<UInt64, Permanence> &b) { return a.first < b.first; });
+  previousUpdated_.clear();
   previousUpdates_.clear();
+  for(size_t i = 0; i < keys.size(); i++) {
+    if( i + 1u < keys.size() and (keys[i + 1u].first >> 32u) == (keys[i].first >> 32u) ) continue;
+    if( keys[i].second == minPermanence ) continue; //same as no entry
+    previousUpdated_.push_back(static_cast<Synapse>(keys[i].first >> 32u));
+    previousUpdates_.push_back(keys[i].second);
+  }
+  currentUpdated_.clear();
   currentUpdates_.clear();
 }
 
 vector<SynapseIdx> Connections::computeActivity(const vector<CellIdx> &activePresynapticCells, const bool learn) {
+  return computeActivity(activePresynapticCells, learn, nullptr);
+}
 
+
+vector<SynapseIdx> Connections::computeActivity(const vector<CellIdx> &activePresynapticCells,
+                                                const bool learn,
+                                                const ReduceFn &reduced) {
+  NTA_PROFILE_SCOPE("Connections.computeActivity");
+  prepareComputeActivity_(learn);
+  if( incremental_ ) {
+    updateIncrementalCounts_(activePresynapticCells, false);
+    if( reduced ) reduced(incrementalConnected_, 0u, incrementalConnected_.size());
+    return incrementalConnected_;
+  }
+
+  // Iterate through all connected synapses.
   vector<SynapseIdx> numActiveConnectedSynapsesForSegment(segments_.size(), 0);
-  if(learn) iteration_++;
+  countActiveSynapses_(activePresynapticCells, true, numActiveConnectedSynapsesForSegment,
+                       reduced ? &reduced : nullptr);
+  return numActiveConnectedSynapsesForSegment;
+}
+
+
+void Connections::computeActivity(const vector<vector<CellIdx>> &batch,
+                                  vector<vector<SynapseIdx>> &numActiveConnectedSynapsesForSegment) {
+  // same bookkeeping as one inference computeActivity() per input
+  for(size_t i = 0u; i < batch.size(); i++) {
+    prepareComputeActivity_(false);
+  }
+  auto &counts = numActiveConnectedSynapsesForSegment;
+  counts.resize(batch.size());
+
+  const auto countInputs = [&](const size_t begin, const size_t end, const size_t chunk) {
+    // (presynaptic cell, input) of all the active cells, grouped by the cell
+    auto &active = batchActive_[chunk];
+    active.clear();
+    for(size_t i = begin; i < end; i++) {
+      counts[i].assign(segments_.size(), 0u);
+      for(const auto cell : batch[i]) {
+        active.emplace_back(cell, static_cast<UInt>(i));
+      }
+    }
+    std::sort(active.begin(), active.end());
+
+    const size_t numPresyn = compactIndex_ ? connectedOffsetsForPresynapticCell_.size() - 1u : 0u;
+    for(size_t a = 0u; a < active.size(); ) {
+      const CellIdx cell = active[a].first;
+      size_t stop = a + 1u;
+      while( stop < active.size() and active[stop].first == cell ) stop++;
+
+      const Segment *segments = nullptr;
+      size_t numSegments = 0u;
+      if( compactIndex_ ) {
+        if( cell < numPresyn ) {
+          segments    = connectedSegmentsFlat_.data() + connectedOffsetsForPresynapticCell_[cell];
+          numSegments = connectedOffsetsForPresynapticCell_[cell + 1u] - connectedOffsetsForPresynapticCell_[cell];
+        }
+      }
+      else {
+        const auto found = connectedSegmentsForPresynapticCell_.find(cell);
+        if( found != connectedSegmentsForPresynapticCell_.end() ) {
+          segments    = found->second.data();
+          numSegments = found->second.size();
+        }
+      }
+
+      for(; a < stop; a++) {
+        SynapseIdx *out = counts[active[a].second].data();
+        for(size_t s = 0u; s < numSegments; s++) {
+          out[segments[s]]++;
+        }
+      }
+    }
+  };
+
+  if( threadPool_ == nullptr or batch.size() < 2u ) {
+    batchActive_.resize(std::max<size_t>(batchActive_.size(), 1u));
+    countInputs(0u, batch.size(), 0u);
+    return;
+  }
+  ThreadPool &pool = *threadPool_;
+  batchActive_.resize(std::max(batchActive_.size(), pool.numChunks(batch.size())));
+  pool.parallelFor(batch.size(), countInputs);
+}
+
+
+void Connections::prepareComputeActivity_(const bool learn) {
+  if(learn) {
+    // inference leaves the slots alone, so it has no effect on later learning
+    releasePendingSegments_();
+    iteration_++;
+    if( maintenanceInterval_ > 0u and iteration_ % maintenanceInterval_ == 0u ) maintenanceDue_ = true;
+    if( maintenanceDue_ and not holdMaintenance_ ) applyMaintenance();
+  }
 
   if( timeseries_ ) {
     // Before each cycle of computation move the currentUpdates to the previous
-    // updates, and zero the currentUpdates in preparation for learning.
-    previousUpdates_.swap( currentUpdates_ );
-    currentUpdates_.clear();
+    // updates, and clear the currentUpdates in preparation for learning.
+    rotateUpdates_();
   }
 
-  // Iterate through all connected synapses.
-  for (const auto& cell : activePresynapticCells) {
-    if (connectedSegmentsForPresynapticCell_.count(cell)) {
-      for(const auto& segment : connectedSegmentsForPresynapticCell_.at(cell)) {
-        ++numActiveConnectedSynapsesForSegment[segment];
+  if( compactIndex_ and compactIndexDirty_ ) rebuildCompactIndex_();
+}
+
+
+void Connections::setIncrementalActivity(const bool enable) {
+  incremental_ = enable;
+  incrementalDirty_ = true;
+  incrementalActive_.clear();
+  incrementalConnected_.clear();
+  incrementalPotential_.clear();
+  incrementalRecounted_ = true;
+}
+
+
+bool Connections::incrementalChangedSegments(vector<Segment> &segments) const {
+  segments.clear();
+  if( not incremental_ or incrementalRecounted_ ) return false;
+  for(const auto *cells : {&turnedOn_, &turnedOff_}) {
+    for(const auto cell : *cells) {
+      const auto found = connectedSegmentsForPresynapticCell_.find(cell);
+      if( found != connectedSegmentsForPresynapticCell_.end() ) {
+        segments.insert(segments.end(), found->second.cbegin(), found->second.cend());
       }
     }
   }
-  return numActiveConnectedSynapsesForSegment;
+  return true;
+}
+
+
+/**
+ * Brings the incremental counts up to date with the new active cells. If the
+ * synapses did not change since the last call, only the cells which turned
+ * on/off are processed, otherwise everything is recounted.
+ */
+void Connections::updateIncrementalCounts_(const vector<CellIdx> &activePresynapticCells, const bool potential) {
+  vector<CellIdx> active(activePresynapticCells);
+  if( not std::is_sorted(active.cbegin(), active.cend()) ) {
+    std::sort(active.begin(), active.end());
+  }
+
+  const bool recount = incrementalDirty_ or incrementalConnected_.size() != segments_.size();
+  incrementalRecounted_ = recount;
+  if( recount ) {
+    incrementalConnected_.assign(segments_.size(), 0u);
+    countActiveSynapses_(active, true, incrementalConnected_);
+    incrementalPotential_.clear();
+  }
+  else {
+    turnedOn_.clear();
+    turnedOff_.clear();
+    std::set_difference(active.cbegin(), active.cend(),
+                        incrementalActive_.cbegin(), incrementalActive_.cend(), std::back_inserter(turnedOn_));
+    std::set_difference(incrementalActive_.cbegin(), incrementalActive_.cend(),
+                        active.cbegin(), active.cend(), std::back_inserter(turnedOff_));
+    countActiveSynapses_(turnedOn_,  0u, turnedOn_.size(),  true, incrementalConnected_.data());
+    countActiveSynapses_(turnedOff_, 0u, turnedOff_.size(), true, incrementalConnected_.data(), true);
+  }
+
+  if( potential ) { //counts of the potential, not connected, synapses
+    if( incrementalPotential_.size() != segments_.size() ) {
+      incrementalPotential_.assign(segments_.size(), 0u);
+      countActiveSynapses_(active, false, incrementalPotential_);
+    }
+    else {
+      countActiveSynapses_(turnedOn_,  0u, turnedOn_.size(),  false, incrementalPotential_.data());
+      countActiveSynapses_(turnedOff_, 0u, turnedOff_.size(), false, incrementalPotential_.data(), true);
+    }
+  }
+  else {
+    incrementalPotential_.clear(); //not kept up to date
+  }
+
+  incrementalActive_.swap(active);
+  incrementalDirty_ = false;
+}
+
+
+UInt64 Connections::structureVersion() const {
+  static std::atomic<UInt64> nextVersion(1u);
+  if( structureVersionDirty_ ) {
+    structureVersion_ = nextVersion++;
+    structureVersionDirty_ = false;
+  }
+  return structureVersion_;
+}
+
+
+void Connections::setNumThreads(const UInt numThreads) {
+  numThreads_ = numThreads == 0u ? static_cast<UInt>(ThreadPool::hardwareConcurrency()) : numThreads;
+  if( numThreads_ > 1u ) {
+    threadPool_ = std::make_shared<ThreadPool>(numThreads_ - 1u); //the calling thread works too
+  } else {
+    threadPool_.reset();
+  }
+  partialCounts_.clear();
+}
+
+
+void Connections::countActiveSynapses_(const vector<CellIdx> &activePresynapticCells,
+                                       const bool connected,
+                                       vector<SynapseIdx> &counts,
+                                       const ReduceFn *reduced) {
+  NTA_ASSERT(counts.size() == segments_.size());
+  constexpr size_t minCellsPerThread = 32u; //below this, threading overhead dominates
+  const size_t maxChunks = std::min<size_t>(numThreads_, activePresynapticCells.size() / minCellsPerThread);
+  if( threadPool_ == nullptr or maxChunks < 2u ) {
+    countActiveSynapses_(activePresynapticCells, 0u, activePresynapticCells.size(), connected, counts.data());
+    if( reduced != nullptr ) (*reduced)(counts, 0u, counts.size());
+    return;
+  }
+
+  // Each thread counts its share of the active cells into its own partial vector,
+  ThreadPool &pool = *threadPool_;
+  const size_t chunks = pool.numChunks(activePresynapticCells.size(), maxChunks);
+  partialCounts_.resize(std::max(partialCounts_.size(), chunks));
+  pool.parallelFor(activePresynapticCells.size(), [&](size_t begin, size_t end, size_t chunk) {
+    auto &partial = partialCounts_[chunk];
+    partial.assign(counts.size(), 0u);
+    countActiveSynapses_(activePresynapticCells, begin, end, connected, partial.data());
+  }, maxChunks);
+
+  // then the partial counts are summed up, each thread reduces a range of segments.
+  pool.parallelFor(counts.size(), [&](size_t begin, size_t end, size_t) {
+    SynapseIdx *out = counts.data();
+    for(size_t c = 0u; c < chunks; c++) {
+      const SynapseIdx *partial = partialCounts_[c].data();
+      for(size_t i = begin; i < end; i++) {
+        out[i] += partial[i];
+      }
+    }
+    if( reduced != nullptr ) (*reduced)(counts, begin, end);
+  });
+}
+
+
+void Connections::countActiveSynapses_(const vector<CellIdx> &activePresynapticCells,
+                                       const size_t begin, const size_t end,
+                                       const bool connected,
+                                       SynapseIdx *counts,
+                                       const bool subtract) const {
+  // with `subtract` add -1, which is the maximum SynapseIdx in modulo arithmetic
+  const SynapseIdx delta = subtract ? std::numeric_limits<SynapseIdx>::max() : 1u;
+  if( compactIndex_ ) {
+    NTA_ASSERT(not compactIndexDirty_);
+    const auto &offsets = connected ? connectedOffsetsForPresynapticCell_ : potentialOffsetsForPresynapticCell_;
+    const auto &flat    = connected ? connectedSegmentsFlat_ : potentialSegmentsFlat_;
+    const size_t numPresyn = offsets.size() - 1u;
+    for(size_t c = begin; c < end; c++) {
+      const auto cell = activePresynapticCells[c];
+      if (cell >= numPresyn) continue;
+      const auto stop = offsets[cell + 1u];
+      for(auto i = offsets[cell]; i < stop; ++i) {
+        counts[flat[i]] += delta;
+      }
+    }
+    return;
+  }
+
+  const auto &presynapticMap = connected ? connectedSegmentsForPresynapticCell_ : potentialSegmentsForPresynapticCell_;
+  for(size_t c = begin; c < end; c++) {
+    const auto found = presynapticMap.find(activePresynapticCells[c]);
+    if (found != presynapticMap.end()) {
+      for(const auto& segment : found->second) {
+        counts[segment] += delta;
+      }
+    }
+  }
+}
+
+
+/**
+ * Flattens the presynaptic segment maps into offsets + contiguous segment
+ * arrays (CSR), indexed directly by presynaptic cell. Used by computeActivity.
+ */
+void Connections::rebuildCompactIndex_() {
+  const auto flatten = [](const decltype(connectedSegmentsForPresynapticCell_) &map, const size_t numPresyn,
+                          vector<Synapse> &offsets, ResourceVector<Segment> &flat) {
+    offsets.assign(numPresyn + 1u, 0u);
+    for(const auto &cellSegs : map) {
+      offsets[cellSegs.first + 1u] = static_cast<Synapse>(cellSegs.second.size());
+    }
+    for(size_t i = 1u; i <= numPresyn; i++) {
+      offsets[i] += offsets[i - 1u];
+    }
+    flat.resize(offsets.back());
+    for(const auto &cellSegs : map) {
+      std::copy(cellSegs.second.cbegin(), cellSegs.second.cend(), flat.begin() + offsets[cellSegs.first]);
+    }
+  };
+
+  size_t numPresyn = 0u;
+  for(const auto &cellSegs : potentialSegmentsForPresynapticCell_) {
+    numPresyn = std::max(numPresyn, (size_t)cellSegs.first + 1u);
+  }
+  for(const auto &cellSegs : connectedSegmentsForPresynapticCell_) {
+    numPresyn = std::max(numPresyn, (size_t)cellSegs.first + 1u);
+  }
+  flatten(connectedSegmentsForPresynapticCell_, numPresyn,
+          connectedOffsetsForPresynapticCell_, connectedSegmentsFlat_);
+  flatten(potentialSegmentsForPresynapticCell_, numPresyn,
+          potentialOffsetsForPresynapticCell_, potentialSegmentsFlat_);
+  compactIndexDirty_ = false;
 }
 
 
@@ -455,6 +1209,15 @@ vector<SynapseIdx> Connections::computeActivity(
     const bool learn) {
   NTA_ASSERT(numActivePotentialSynapsesForSegment.size() == segments_.size());
 
+  if( incremental_ ) {
+    prepareComputeActivity_(learn);
+    updateIncrementalCounts_(activePresynapticCells, true);
+    for(size_t i = 0u; i < segments_.size(); i++) {
+      numActivePotentialSynapsesForSegment[i] = incrementalConnected_[i] + incrementalPotential_[i];
+    }
+    return incrementalConnected_;
+  }
+
   // Iterate through all connected synapses.
   const vector<SynapseIdx>& numActiveConnectedSynapsesForSegment = computeActivity( activePresynapticCells, learn );
   NTA_ASSERT(numActiveConnectedSynapsesForSegment.size() == segments_.size());
@@ -464,14 +1227,85 @@ vector<SynapseIdx> Connections::computeActivity(
              numActiveConnectedSynapsesForSegment.end(),
              numActivePotentialSynapsesForSegment.begin());
 
-  for (const auto& cell : activePresynapticCells) {
-    if (potentialSegmentsForPresynapticCell_.count(cell)) {
-      for(const auto& segment : potentialSegmentsForPresynapticCell_.at(cell)) {
-        ++numActivePotentialSynapsesForSegment[segment];
+  countActiveSynapses_(activePresynapticCells, false, numActivePotentialSynapsesForSegment);
+  return numActiveConnectedSynapsesForSegment;
+}
+
+
+void Connections::computeActivity(vector<SynapseIdx> &numActiveConnectedSynapsesForSegment,
+                                  vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
+                                  vector<Segment>    &touchedSegments,
+                                  const vector<CellIdx> &activePresynapticCells,
+                                  const bool learn,
+                                  const bool potentialSynapses) {
+  NTA_PROFILE_SCOPE("Connections.computeActivity");
+  prepareComputeActivity_(learn);
+  incrementalDirty_ = true; //the incremental counts are bypassed
+
+  auto &connected = numActiveConnectedSynapsesForSegment;
+  auto &potential = numActivePotentialSynapsesForSegment;
+  const size_t length = segments_.size();
+  if( connected.size() != potential.size() ) {
+    connected.assign(length, 0u);
+    potential.assign(length, 0u);
+  }
+  else {
+    // Only the segments touched by the last call can be non-zero.
+    for(const auto segment : touchedSegments) {
+      if( segment < connected.size() ) {
+        connected[segment] = 0u;
+        potential[segment] = 0u;
+      }
+    }
+    connected.resize(length, 0u);
+    potential.resize(length, 0u);
+  }
+  touchedSegments.clear();
+
+  if( not potentialSynapses ) {
+    // the connected counts take the place of the potential ones to track the touched segments
+    countTouchedSegments_(activePresynapticCells, true, nullptr, connected.data(), touchedSegments);
+    return;
+  }
+  countTouchedSegments_(activePresynapticCells, true,  connected.data(), potential.data(), touchedSegments);
+  countTouchedSegments_(activePresynapticCells, false, nullptr,          potential.data(), touchedSegments);
+}
+
+
+void Connections::countTouchedSegments_(const vector<CellIdx> &activePresynapticCells,
+                                        const bool connectedSynapses,
+                                        SynapseIdx *connected,
+                                        SynapseIdx *potential,
+                                        vector<Segment> &touchedSegments) const {
+  const auto count = [&](const Segment segment) {
+    if( potential[segment]++ == 0u ) touchedSegments.push_back(segment);
+    if( connected != nullptr ) connected[segment]++;
+  };
+
+  if( compactIndex_ ) {
+    NTA_ASSERT(not compactIndexDirty_);
+    const auto &offsets = connectedSynapses ? connectedOffsetsForPresynapticCell_ : potentialOffsetsForPresynapticCell_;
+    const auto &flat    = connectedSynapses ? connectedSegmentsFlat_ : potentialSegmentsFlat_;
+    const size_t numPresyn = offsets.size() - 1u;
+    for(const auto cell : activePresynapticCells) {
+      if (cell >= numPresyn) continue;
+      const auto stop = offsets[cell + 1u];
+      for(auto i = offsets[cell]; i < stop; ++i) {
+        count(flat[i]);
+      }
+    }
+    return;
+  }
+
+  const auto &presynapticMap = connectedSynapses ? connectedSegmentsForPresynapticCell_ : potentialSegmentsForPresynapticCell_;
+  for(const auto cell : activePresynapticCells) {
+    const auto found = presynapticMap.find(cell);
+    if (found != presynapticMap.end()) {
+      for(const auto& segment : found->second) {
+        count(segment);
       }
     }
   }
-  return numActiveConnectedSynapsesForSegment;
 }
 
 
@@ -479,60 +1313,240 @@ void Connections::adaptSegment(const Segment segment,
                                const SDR &inputs,
                                const Permanence increment,
                                const Permanence decrement, 
-			       const bool pruneZeroSynapses, 
+			       const bool pruneZeroSynapses,
 			       const UInt segmentThreshold)
 {
-  const auto &inputArray = inputs.getDense();
+  adaptSegments_(&segment, &segment + 1, inputs.getSparse(), inputs.size,
+                 increment, decrement, pruneZeroSynapses, segmentThreshold);
+}
 
-  if( timeseries_ ) {
-    previousUpdates_.resize( synapses_.size(), minPermanence );
-    currentUpdates_.resize(  synapses_.size(), minPermanence );
+
+void Connections::adaptSegment(const Segment segment,
+                               const SparseSDR &inputs,
+                               const Permanence increment,
+                               const Permanence decrement,
+                               const bool pruneZeroSynapses,
+                               const UInt segmentThreshold)
+{
+  adaptSegments_(&segment, &segment + 1, inputs.getSparse(), inputs.size,
+                 increment, decrement, pruneZeroSynapses, segmentThreshold);
+}
+
+
+void Connections::adaptSegments(const vector<Segment> &segments,
+                                const SDR &inputs,
+                                const Permanence increment,
+                                const Permanence decrement,
+                                const bool pruneZeroSynapses,
+                                const UInt segmentThreshold)
+{
+  adaptSegments_(segments.data(), segments.data() + segments.size(), inputs.getSparse(), inputs.size,
+                 increment, decrement, pruneZeroSynapses, segmentThreshold);
+}
+
+
+void Connections::adaptSegments(vector<Segment>::const_iterator begin,
+                                vector<Segment>::const_iterator end,
+                                const SDR &inputs,
+                                const Permanence increment,
+                                const Permanence decrement,
+                                const bool pruneZeroSynapses,
+                                const UInt segmentThreshold)
+{
+  if(begin == end) return;
+  const Segment *first = &*begin;
+  adaptSegments_(first, first + (end - begin), inputs.getSparse(), inputs.size,
+                 increment, decrement, pruneZeroSynapses, segmentThreshold);
+}
+
+
+void Connections::adaptSegments(vector<Segment>::const_iterator begin,
+                                vector<Segment>::const_iterator end,
+                                const SparseSDR &inputs,
+                                const Permanence increment,
+                                const Permanence decrement,
+                                const bool pruneZeroSynapses,
+                                const UInt segmentThreshold)
+{
+  if(begin == end) return;
+  const Segment *first = &*begin;
+  adaptSegments_(first, first + (end - begin), inputs.getSparse(), inputs.size,
+                 increment, decrement, pruneZeroSynapses, segmentThreshold);
+}
+
+
+void Connections::adaptSegments_(const Segment *begin,
+                                 const Segment *end,
+                                 const SDR_sparse_t &inputs,
+                                 const UInt inputSize,
+                                 const Permanence increment,
+                                 const Permanence decrement,
+                                 const bool pruneZeroSynapses,
+                                 const UInt segmentThreshold)
+{
+  NTA_PROFILE_SCOPE("Connections.adaptSegments");
+  updatePermanences_(begin, end, adaptInput_(inputs, inputSize), increment, decrement, pruneZeroSynapses,
+                     adaptFlipped_, adaptDestroyLater_, adaptUpdates_);
+  recordUpdates_(adaptUpdates_);
+  applyAdaptation_(begin, end, adaptFlipped_, adaptDestroyLater_, pruneZeroSynapses, segmentThreshold);
+}
+
+
+const SDR_dense_t &Connections::adaptInput_(const SDR_sparse_t &active, const UInt size) {
+  if( adaptInputDense_.size() != size ) {
+    adaptInputDense_.assign(size, 0u);
+    adaptInputSparse_.clear();
   }
+  else if( active == adaptInputSparse_ ) {
+    return adaptInputDense_; //same input as the last call, eg. the TM adapts column by column
+  }
+  for(const auto cell : adaptInputSparse_) adaptInputDense_[cell] = 0u;
+  for(const auto cell : active)            adaptInputDense_[cell] = 1u;
+  adaptInputSparse_.assign(active.cbegin(), active.cend());
+  return adaptInputDense_;
+}
 
-  vector<Synapse> destroyLater;
-  for(const auto synapse: synapsesForSegment(segment)) {
-      const SynapseData &synapseData = dataForSynapse(synapse);
 
-      Permanence update;
-      if( inputArray[synapseData.presynapticCell] ) {
-        update = increment;
-      } else {
-        update = -decrement;
-      }
+void Connections::adaptPermanences(vector<PendingAdaptation> &pending,
+                                   const SDR &inputs,
+                                   const bool pruneZeroSynapses)
+{
+  adaptPermanences_(pending, inputs.getSparse(), inputs.size, pruneZeroSynapses);
+}
 
-    //prune permanences that reached zero
-    if (pruneZeroSynapses and 
-        synapseData.permanence + update < htm::minPermanence + htm::Epsilon) { //new value will disconnect the synapse
-      destroyLater.push_back(synapse);
-      prunedSyns_++; //for statistics
-      continue;
+
+void Connections::adaptPermanences(vector<PendingAdaptation> &pending,
+                                   const SparseSDR &inputs,
+                                   const bool pruneZeroSynapses)
+{
+  adaptPermanences_(pending, inputs.getSparse(), inputs.size, pruneZeroSynapses);
+}
+
+
+void Connections::adaptPermanences_(vector<PendingAdaptation> &pending,
+                                    const SDR_sparse_t &inputs,
+                                    const UInt inputSize,
+                                    const bool pruneZeroSynapses)
+{
+  const auto &inputArray = adaptInput_(inputs, inputSize); //converted here, the threads only read it
+
+  const auto update = [&](size_t begin, size_t end, size_t) {
+    for(size_t i = begin; i < end; i++) {
+      auto &item = pending[i];
+      const Segment *first = item.segments.data();
+      updatePermanences_(first, first + item.segments.size(), inputArray,
+                         item.increment, item.decrement, pruneZeroSynapses,
+                         item.flipped, item.destroy, item.updates);
     }
+  };
+  if( threadPool_ == nullptr or pending.size() < 2u ) {
+    update(0u, pending.size(), 0u);
+  } else {
+    // Copy the permanences shared with a fork here, the threads write disjoint
+    // synapses but may share their chunks.
+    if( synapses_.permanence.numSharedChunks() > 0u ) {
+      for(const auto &item : pending) {
+        for(const auto segment : item.segments) {
+          for(const auto synapse : segments_[segment].synapses) synapses_.permanence.unshare(synapse);
+        }
+      }
+    }
+    threadPool_->parallelFor(pending.size(), update, numThreads_);
+  }
+  for(const auto &item : pending) recordUpdates_(item.updates);
+}
+
 
-    //update synapse, but for TS only if changed
-    if(timeseries_) {
-      if( update != previousUpdates_[synapse] ) {
-        updateSynapsePermanence(synapse, synapseData.permanence + update);
+void Connections::applyAdaptation(const PendingAdaptation &item,
+                                  const bool pruneZeroSynapses,
+                                  const UInt segmentThreshold)
+{
+  const Segment *first = item.segments.data();
+  applyAdaptation_(first, first + item.segments.size(), item.flipped, item.destroy,
+                   pruneZeroSynapses, segmentThreshold);
+}
+
+
+void Connections::updatePermanences_(const Segment *begin,
+                                     const Segment *end,
+                                     const SDR_dense_t &inputArray,
+                                     const Permanence increment,
+                                     const Permanence decrement,
+                                     const bool pruneZeroSynapses,
+                                     vector<Synapse> &flipped,
+                                     vector<Synapse> &destroyLater,
+                                     vector<std::pair<Synapse, Permanence>> &updates)
+{
+  // Changes of the connected state are only recorded, the presynaptic maps
+  // are updated later by applyAdaptation_().
+  flipped.clear();
+  destroyLater.clear();
+  updates.clear();
+  const auto &presynapticCell = synapses_.presynapticCell;
+  auto       &permanences     = synapses_.permanence;
+  for(auto segment = begin; segment != end; segment++) {
+    for(const auto synapse: segments_[*segment].synapses) {
+      NTA_ASSERT(synapseExists_(synapse, true));
+      const Permanence permanence = Codec::decode(permanences[synapse]);
+      const Permanence update     = inputArray[presynapticCell[synapse]] ? increment : -decrement;
+
+      //prune permanences that reached zero
+      if (pruneZeroSynapses and 
+          permanence + update < htm::minPermanence + htm::Epsilon) { //new value will disconnect the synapse
+        destroyLater.push_back(synapse);
+        continue;
       }
-      currentUpdates_[ synapse ] = update;
-    } else {
-      updateSynapsePermanence(synapse, synapseData.permanence + update);
+
+      //update synapse, but for TS only if changed
+      if(timeseries_) {
+        updates.emplace_back(synapse, update);
+        if(update == previousUpdate_(synapse)) continue;
+      }
+
+      const Permanence newPermanence = std::min(std::max(permanence + update, minPermanence), maxPermanence);
+      const PermanenceStorage stored = Codec::encode(newPermanence);
+      if( (permanences[synapse] >= connectedThresholdStored_) != (stored >= connectedThresholdStored_) ) {
+        flipped.push_back(synapse);
+      }
+      if( stored != permanences[synapse] ) permanences.ref(synapse) = stored;
     }
   }
+}
+
+
+void Connections::applyAdaptation_(const Segment *begin,
+                                   const Segment *end,
+                                   const vector<Synapse> &flipped,
+                                   const vector<Synapse> &destroyLater,
+                                   const bool pruneZeroSynapses,
+                                   const UInt segmentThreshold)
+{
+  if( deltaTracking_ ) {
+    for(auto segment = begin; segment != end; segment++) markSegment_(*segment);
+  }
 
-  //destroy synapses accumulated for pruning
-  for(const auto pruneSyn : destroyLater) {
-    destroySynapse(pruneSyn);
+  // maintain the presynaptic maps
+  for(const auto synapse : flipped) {
+    updateConnectedState_(synapse, synapses_.permanence[synapse] >= connectedThresholdStored_);
   }
 
+  // destroy synapses accumulated for pruning
+  destroySynapses_(destroyLater.data(), destroyLater.data() + destroyLater.size());
+  prunedSyns_ += static_cast<Synapse>(destroyLater.size()); //for statistics
+
   //destroy segment if it has too few synapses left -> will never be able to connect again
   #ifdef NTA_ASSERTIONS_ON
   if(segmentThreshold > 0) {
     NTA_ASSERT(pruneZeroSynapses) << "Setting segmentThreshold only makes sense when pruneZeroSynapses is allowed.";
   }
   #endif
-  if(pruneZeroSynapses and synapsesForSegment(segment).size() < segmentThreshold) { 
-    destroySegment(segment);
-    prunedSegs_++; //statistics
+  if(pruneZeroSynapses) {
+    for(auto segment = begin; segment != end; segment++) {
+      if(synapsesForSegment(*segment).size() < segmentThreshold and segmentExists_(*segment)) {
+        destroySegment(*segment);
+        prunedSegs_++; //statistics
+      }
+    }
   }
 }
 
@@ -577,14 +1591,15 @@ void Connections::raisePermanencesToThreshold(
   // will be at least N synapses connected.
 
   // Threshold is ensured to be >=1 by condition at very beginning if(thresh == 0)... 
+  markSegment_(segment); //the synapses are reordered
   auto minPermSynPtr = synapses.begin() + threshold - 1;
 
   const auto permanencesGreater = [&](const Synapse &A, const Synapse &B)
-    { return synapses_[A].permanence > synapses_[B].permanence; };
+    { return synapses_.permanence[A] > synapses_.permanence[B]; };
   // Do a partial sort, it's faster than a full sort.
   std::nth_element(synapses.begin(), minPermSynPtr, synapses.end(), permanencesGreater);
 
-  const Real increment = connectedThreshold_ - synapses_[ *minPermSynPtr ].permanence;
+  const Real increment = connectedThreshold_ - Codec::decode(synapses_.permanence[ *minPermSynPtr ]);
   if( increment <= 0 ) // If minPermSynPtr is already connected then ...
     return;            // Enough synapses are already connected.
 
@@ -633,7 +1648,7 @@ void Connections::synapseCompetition(
 
   vector<Permanence> permanences; permanences.reserve( segData.synapses.size() );
   for( Synapse syn : segData.synapses )
-    permanences.push_back( synapses_[syn].permanence );
+    permanences.push_back( Codec::decode(synapses_.permanence[syn]) );
 
   // Do a partial sort, it's faster than a full sort.
   auto minPermPtr = permanences.begin() + (segData.synapses.size() - 1 - desiredConnected);
@@ -649,7 +1664,7 @@ void Connections::synapseCompetition(
 void Connections::bumpSegment(const Segment segment, const Permanence delta) {
   // TODO: vectorize?
   for( const auto syn : synapsesForSegment(segment) ) {
-    updateSynapsePermanence(syn, synapses_[syn].permanence + delta);
+    updateSynapsePermanence(syn, Codec::decode(synapses_.permanence[syn]) + delta);
   }
 }
 
@@ -660,9 +1675,10 @@ void Connections::destroyMinPermanenceSynapses(
                               const vector<CellIdx> &excludeCells)
 {
   // Don't destroy any cells that are in excludeCells.
-  vector<Synapse> destroyCandidates;
+  auto &destroyCandidates = destroyCandidates_; //reused scratch
+  destroyCandidates.clear();
   for( Synapse synapse : synapsesForSegment(segment)) {
-    const CellIdx presynapticCell = dataForSynapse(synapse).presynapticCell;
+    const CellIdx presynapticCell = presynapticCellForSynapse(synapse);
 
     if( not std::binary_search(excludeCells.cbegin(), excludeCells.cend(), presynapticCell)) {
       destroyCandidates.push_back(synapse);
@@ -670,10 +1686,10 @@ void Connections::destroyMinPermanenceSynapses(
   }
 
   const auto comparePermanences = [&](const Synapse A, const Synapse B) {
-    const Permanence A_perm = dataForSynapse(A).permanence;
-    const Permanence B_perm = dataForSynapse(B).permanence;
+    const PermanenceStorage A_perm = synapses_.permanence[A];
+    const PermanenceStorage B_perm = synapses_.permanence[B];
     if( A_perm == B_perm ) {
-      return A < B;
+      return synapses_.id[A] < synapses_.id[B]; //older first, slots may be reused
     }
     else {
       return A_perm < B_perm;
@@ -682,9 +1698,678 @@ void Connections::destroyMinPermanenceSynapses(
   std::sort(destroyCandidates.begin(), destroyCandidates.end(), comparePermanences);
 
   const size_t destroy = std::min( nDestroy, destroyCandidates.size() );
-  for(size_t i = 0; i < destroy; i++) {
-    destroySynapse( destroyCandidates[i] );
+  destroySynapses_(destroyCandidates.data(), destroyCandidates.data() + destroy);
+}
+
+
+void Connections::rebuildFreeLists_() {
+  freeSegments_.clear();
+  pendingFreeSegments_.clear();
+  freeSynapses_.clear();
+  vector<bool> onCell(segments_.size(), false);
+  for(const auto &cellData : cells_) {
+    for(const auto segment : cellData.segments) onCell[segment] = true;
+  }
+  for(Segment segment = 0; segment < segments_.size(); segment++) {
+    if( not onCell[segment] ) freeSegments_.push_back(segment);
+  }
+  for(Synapse synapse = 0; synapse < synapses_.size(); synapse++) {
+    if( synapses_.permanence[synapse] == Codec::removed() ) freeSynapses_.push_back(synapse);
+  }
+}
+
+
+void Connections::sparseUpdates_(vector<Synapse> &updated, vector<Permanence> &updates) {
+  updated.clear();
+  size_t kept = 0u;
+  for(Synapse synapse = 0; synapse < updates.size(); synapse++) {
+    if( updates[synapse] == minPermanence ) continue; //same as no entry
+    updated.push_back(synapse);
+    updates[kept++] = updates[synapse];
   }
+  updates.resize(kept);
+}
+
+
+void Connections::releasePendingSegments_() {
+  freeSegments_.insert(freeSegments_.end(), pendingFreeSegments_.cbegin(), pendingFreeSegments_.cend());
+  pendingFreeSegments_.clear();
+}
+
+
+void Connections::compact() {
+  renumber_(false);
+}
+
+
+vector<Segment> Connections::defragment() {
+  return renumber_(true);
+}
+
+
+vector<Segment> Connections::renumber_(const bool byCell) {
+  // The live segments & synapses, in their new order.
+  vector<Segment> segmentOrder;
+  segmentOrder.reserve(numSegments());
+  if( byCell ) {
+    // A cell's segments keep their relative order, so do ties broken by the
+    // flat index (eg. LRU pruning).
+    for(const auto &cellData : cells_) {
+      const size_t first = segmentOrder.size();
+      segmentOrder.insert(segmentOrder.end(), cellData.segments.cbegin(), cellData.segments.cend());
+      std::sort(segmentOrder.begin() + first, segmentOrder.end());
+    }
+  } else {
+    vector<bool> segmentAlive(segments_.size(), false);
+    for(const auto &cellData : cells_) {
+      for(const Segment seg : cellData.segments) segmentAlive[seg] = true;
+    }
+    for(Segment seg = 0; seg < segments_.size(); seg++) {
+      if(segmentAlive[seg]) segmentOrder.push_back(seg);
+    }
+  }
+  vector<Synapse> synapseOrder;
+  synapseOrder.reserve(numSynapses());
+  for(const Segment seg : segmentOrder) {
+    const auto &segSynapses = segments_[seg].synapses;
+    synapseOrder.insert(synapseOrder.end(), segSynapses.cbegin(), segSynapses.cend());
+  }
+  if( not byCell ) std::sort(synapseOrder.begin(), synapseOrder.end());
+
+  // Renumber them.
+  vector<Segment> newSegment(segments_.size(), std::numeric_limits<Segment>::max());
+  vector<SegmentData> segments;
+  segments.reserve(segmentOrder.size());
+  for(const Segment seg : segmentOrder) {
+    newSegment[seg] = static_cast<Segment>(segments.size());
+    segments.push_back(std::move(segments_[seg]));
+  }
+
+  vector<Synapse> newSynapse(synapses_.size(), 0);
+  SynapseArrays synapses(synapses_.resource());
+  for(const Synapse syn : synapseOrder) {
+    newSynapse[syn] = static_cast<Synapse>(synapses.size());
+    SynapseData synData = synapses_.get(syn);
+    synData.segment = newSegment[synData.segment];
+    synapses.push_back(synData);
+  }
+
+  // The timeseries updates of the remaining synapses, under their new index.
+  const auto renumberUpdates = [&](vector<Synapse> &updated, vector<Permanence> &updates, const bool sorted) {
+    vector<std::pair<Synapse, Permanence>> kept;
+    for(size_t i = 0; i < updated.size(); i++) {
+      if( synapses_.permanence[updated[i]] == Codec::removed() ) continue;
+      kept.emplace_back(newSynapse[updated[i]], updates[i]);
+    }
+    if( sorted ) std::sort(kept.begin(), kept.end());
+    updated.clear();
+    updates.clear();
+    for(const auto &update : kept) {
+      updated.push_back(update.first);
+      updates.push_back(update.second);
+    }
+  };
+  renumberUpdates(previousUpdated_, previousUpdates_, true);
+  renumberUpdates(currentUpdated_,  currentUpdates_,  false);
+
+  for(auto &cellData : cells_) {
+    for(auto &seg : cellData.segments) seg = newSegment[seg];
+  }
+  for(auto &segData : segments) {
+    for(auto &syn : segData.synapses) syn = newSynapse[syn];
+  }
+  segments_ = std::move(segments);
+  synapses_ = std::move(synapses);
+
+  // Rebuild the presynaptic maps.
+  potentialSynapsesForPresynapticCell_.clear();
+  connectedSynapsesForPresynapticCell_.clear();
+  potentialSegmentsForPresynapticCell_.clear();
+  connectedSegmentsForPresynapticCell_.clear();
+  for(Synapse syn = 0; syn < synapses_.size(); syn++) {
+    const CellIdx presynCell = synapses_.presynapticCell[syn];
+    const bool connected = synapses_.permanence[syn] >= connectedThresholdStored_;
+    auto &presynSynapses = connected ? connectedSynapsesForPresynapticCell_[presynCell]
+                                     : potentialSynapsesForPresynapticCell_[presynCell];
+    auto &presynSegments = connected ? connectedSegmentsForPresynapticCell_[presynCell]
+                                     : potentialSegmentsForPresynapticCell_[presynCell];
+    synapses_.presynapticMapIndex.ref(syn) = static_cast<Synapse>(presynSynapses.size());
+    presynSynapses.push_back(syn);
+    presynSegments.push_back(synapses_.segment[syn]);
+  }
+
+  destroyedSegments_ = 0;
+  destroyedSynapses_ = 0;
+  freeSegments_.clear();
+  pendingFreeSegments_.clear();
+  freeSynapses_.clear();
+  pendingEmptyPresynaptic_.clear();
+  structureChanged_();
+  clearDirty_();
+  allDirty_ = deltaTracking_;
+  return newSegment;
+}
+
+
+template<typename T, typename A>
+static size_t vectorBytes(const vector<T, A> &v) { return v.capacity() * sizeof(T); }
+
+// The buckets, and one node per key with the vector it holds.
+template<typename Map>
+static size_t mapBytes(const Map &map) {
+  size_t bytes = map.bucket_count() * sizeof(void*);
+  for(const auto &item : map) {
+    bytes += sizeof(item) + sizeof(void*) + vectorBytes(item.second);
+  }
+  return bytes;
+}
+
+void Connections::setMemoryResource(MemoryResource *resource) {
+  synapses_.setResource(resource);
+  connectedSegmentsFlat_ = ResourceVector<Segment>(resource);
+  potentialSegmentsFlat_ = ResourceVector<Segment>(resource);
+  compactIndexDirty_ = true;
+}
+
+
+Connections Connections::fork() const {
+  Connections child(*this);
+  child.eventHandlers_.clear();
+  if( numThreads_ > 1u ) child.setNumThreads(numThreads_);
+  return child;
+}
+
+
+size_t Connections::memoryUsage() const {
+  size_t bytes = vectorBytes(cells_) + vectorBytes(segments_);
+  for(const auto &cellData : cells_) {
+    bytes += vectorBytes(cellData.segments);
+  }
+  for(const auto &segData : segments_) {
+    bytes += vectorBytes(segData.synapses);
+  }
+  bytes += synapses_.presynapticCell.memoryUsage() + synapses_.permanence.memoryUsage() +
+           synapses_.segment.memoryUsage() + synapses_.presynapticMapIndex.memoryUsage() +
+           synapses_.id.memoryUsage();
+  bytes += vectorBytes(freeSegments_) + vectorBytes(pendingFreeSegments_) + vectorBytes(freeSynapses_);
+  bytes += mapBytes(potentialSynapsesForPresynapticCell_) + mapBytes(connectedSynapsesForPresynapticCell_) +
+           mapBytes(potentialSegmentsForPresynapticCell_) + mapBytes(connectedSegmentsForPresynapticCell_);
+  bytes += vectorBytes(connectedOffsetsForPresynapticCell_) + vectorBytes(connectedSegmentsFlat_) +
+           vectorBytes(potentialOffsetsForPresynapticCell_) + vectorBytes(potentialSegmentsFlat_);
+  bytes += vectorBytes(incrementalActive_) + vectorBytes(incrementalConnected_) +
+           vectorBytes(incrementalPotential_);
+  bytes += vectorBytes(previousUpdated_) + vectorBytes(previousUpdates_);
+  bytes += vectorBytes(currentUpdated_) + vectorBytes(currentUpdates_);
+  for(const auto &counts : partialCounts_) {
+    bytes += vectorBytes(counts);
+  }
+  return bytes;
+}
+
+
+// A CowArray as one flat array, chunk by chunk.
+template<typename T>
+static void saveArray(FlatWriter &out, const CowArray<T> &values) {
+  out.beginArray<T>(values.size());
+  values.forEachChunk([&out](const T *chunk, const size_t count) { out.append(chunk, count); });
+}
+
+template<typename T>
+static void loadArray(FlatReader &in, CowArray<T> &values) {
+  size_t count;
+  const T *data = in.view<T>(count);
+  values.assign(data, data + count);
+}
+
+
+// The lists of a vector of items as CSR: offsets[i] .. offsets[i+1] into values.
+template<typename Item, typename T>
+static void saveLists(FlatWriter &out, const vector<Item> &items, vector<T> Item::*list) {
+  vector<UInt64> offsets(1u, 0u);
+  vector<T> values;
+  for(const auto &item : items) {
+    const auto &l = item.*list;
+    values.insert(values.end(), l.cbegin(), l.cend());
+    offsets.push_back(values.size());
+  }
+  out.array(offsets);
+  out.array(values);
+}
+
+template<typename Item, typename T>
+static void loadLists(FlatReader &in, vector<Item> &items, vector<T> Item::*list) {
+  size_t numOffsets, numValues;
+  const UInt64 *offsets = in.view<UInt64>(numOffsets);
+  const T *values = in.view<T>(numValues);
+  NTA_CHECK(numOffsets == items.size() + 1u and offsets[numOffsets - 1u] == numValues)
+    << "Connections::loadFlat: corrupt lists";
+  for(size_t i = 0u; i < items.size(); i++) {
+    NTA_CHECK(offsets[i] <= offsets[i + 1u]) << "Connections::loadFlat: corrupt lists";
+    (items[i].*list).assign(values + offsets[i], values + offsets[i + 1u]);
+  }
+}
+
+// A presynaptic map as CSR: keys, offsets, values.
+template<typename Map>
+static void saveMap(FlatWriter &out, const Map &map) {
+  using T = typename Map::mapped_type::value_type;
+  vector<CellIdx> keys;
+  vector<UInt64> offsets(1u, 0u);
+  vector<T> values;
+  keys.reserve(map.size());
+  offsets.reserve(map.size() + 1u);
+  for(const auto &item : map) {
+    keys.push_back(item.first);
+    values.insert(values.end(), item.second.cbegin(), item.second.cend());
+    offsets.push_back(values.size());
+  }
+  out.array(keys);
+  out.array(offsets);
+  out.array(values);
+}
+
+template<typename Map>
+static void loadMap(FlatReader &in, Map &map) {
+  using T = typename Map::mapped_type::value_type;
+  size_t numKeys, numOffsets, numValues;
+  const CellIdx *keys = in.view<CellIdx>(numKeys);
+  const UInt64 *offsets = in.view<UInt64>(numOffsets);
+  const T *values = in.view<T>(numValues);
+  NTA_CHECK(numOffsets == numKeys + 1u and offsets[numKeys] == numValues)
+    << "Connections::loadFlat: corrupt presynaptic map";
+  map.clear();
+  map.reserve(numKeys);
+  for(size_t i = 0u; i < numKeys; i++) {
+    NTA_CHECK(offsets[i] <= offsets[i + 1u]) << "Connections::loadFlat: corrupt presynaptic map";
+    map[keys[i]].assign(values + offsets[i], values + offsets[i + 1u]);
+  }
+}
+
+void Connections::saveFlat(const std::string &path) const {
+  FlatWriter out(path, "HTMCONNS", FLAT_VERSION);
+  saveFlat(out);
+  out.close();
+}
+
+void Connections::loadFlat(const std::string &path) {
+  FlatReader in(path, "HTMCONNS", FLAT_VERSION);
+  loadFlat(in);
+}
+
+void Connections::saveFlat(FlatWriter &out) const {
+  out.scalar(static_cast<UInt32>(sizeof(PermanenceStorage)));
+  out.scalar(connectedThreshold_);
+  out.scalar(iteration_);
+  out.scalar(static_cast<UInt64>(cells_.size()));
+  out.scalar(static_cast<UInt64>(destroyedSynapses_));
+  out.scalar(static_cast<UInt64>(destroyedSegments_));
+  out.scalar(nextSegmentOrdinal_);
+  out.scalar(nextSynapseOrdinal_);
+  out.scalar(timeseries_);
+  out.scalar(prunedSyns_);
+  out.scalar(prunedSegs_);
+  out.scalar(segmentPruning_);
+
+  saveLists(out, cells_, &CellData::segments);
+
+  const size_t numSegments = segments_.size();
+  vector<CellIdx> segmentCell(numSegments);
+  vector<SynapseIdx> numConnected(numSegments);
+  vector<UInt32> lastUsed(numSegments);
+  vector<Segment> id(numSegments);
+  for(size_t seg = 0u; seg < numSegments; seg++) {
+    segmentCell[seg]  = segments_[seg].cell;
+    numConnected[seg] = segments_[seg].numConnected;
+    lastUsed[seg]     = segments_[seg].lastUsed;
+    id[seg]           = segments_[seg].id;
+  }
+  out.array(segmentCell);
+  out.array(numConnected);
+  out.array(lastUsed);
+  out.array(id);
+  saveLists(out, segments_, &SegmentData::synapses);
+
+  saveArray(out, synapses_.presynapticCell);
+  saveArray(out, synapses_.permanence);
+  saveArray(out, synapses_.segment);
+  saveArray(out, synapses_.presynapticMapIndex);
+  saveArray(out, synapses_.id);
+
+  saveMap(out, potentialSynapsesForPresynapticCell_);
+  saveMap(out, connectedSynapsesForPresynapticCell_);
+  saveMap(out, potentialSegmentsForPresynapticCell_);
+  saveMap(out, connectedSegmentsForPresynapticCell_);
+
+  out.array(previousUpdated_);
+  out.array(previousUpdates_);
+  out.array(currentUpdated_);
+  out.array(currentUpdates_);
+  out.array(freeSegments_);
+  out.array(pendingFreeSegments_);
+  out.array(freeSynapses_);
+}
+
+void Connections::loadFlat(FlatReader &in) {
+  NTA_CHECK(in.scalar<UInt32>() == sizeof(PermanenceStorage))
+    << "Connections::loadFlat: the archive was written with another permanence storage type.";
+  connectedThreshold_ = in.scalar<Permanence>();
+  connectedThresholdStored_ = Codec::threshold(connectedThreshold_);
+  iteration_ = in.scalar<UInt32>();
+  const auto numCells = in.scalar<UInt64>();
+  destroyedSynapses_ = static_cast<size_t>(in.scalar<UInt64>());
+  destroyedSegments_ = static_cast<size_t>(in.scalar<UInt64>());
+  nextSegmentOrdinal_ = in.scalar<Segment>();
+  nextSynapseOrdinal_ = in.scalar<Synapse>();
+  timeseries_ = in.scalar<bool>();
+  prunedSyns_ = in.scalar<Synapse>();
+  prunedSegs_ = in.scalar<Segment>();
+  segmentPruning_ = in.scalar<SegmentPruning>();
+  pendingEmptyPresynaptic_.clear();
+
+  cells_.assign(static_cast<size_t>(numCells), CellData());
+  loadLists(in, cells_, &CellData::segments);
+
+  vector<CellIdx> segmentCell;
+  vector<SynapseIdx> numConnected;
+  vector<UInt32> lastUsed;
+  vector<Segment> id;
+  in.array(segmentCell);
+  in.array(numConnected);
+  in.array(lastUsed);
+  in.array(id);
+  const size_t numSegments = segmentCell.size();
+  NTA_CHECK(numConnected.size() == numSegments and lastUsed.size() == numSegments and id.size() == numSegments)
+    << "Connections::loadFlat: corrupt segments";
+  segments_.clear();
+  segments_.reserve(numSegments);
+  for(size_t seg = 0u; seg < numSegments; seg++) {
+    segments_.emplace_back(segmentCell[seg], id[seg], lastUsed[seg]);
+    segments_.back().numConnected = numConnected[seg];
+  }
+  loadLists(in, segments_, &SegmentData::synapses);
+
+  loadArray(in, synapses_.presynapticCell);
+  loadArray(in, synapses_.permanence);
+  loadArray(in, synapses_.segment);
+  loadArray(in, synapses_.presynapticMapIndex);
+  loadArray(in, synapses_.id);
+  const size_t numSynapses = synapses_.size();
+  NTA_CHECK(synapses_.presynapticCell.size() == numSynapses and synapses_.segment.size() == numSynapses and
+            synapses_.presynapticMapIndex.size() == numSynapses and synapses_.id.size() == numSynapses)
+    << "Connections::loadFlat: corrupt synapses";
+
+  loadMap(in, potentialSynapsesForPresynapticCell_);
+  loadMap(in, connectedSynapsesForPresynapticCell_);
+  loadMap(in, potentialSegmentsForPresynapticCell_);
+  loadMap(in, connectedSegmentsForPresynapticCell_);
+
+  in.array(previousUpdated_);
+  in.array(previousUpdates_);
+  in.array(currentUpdated_);
+  in.array(currentUpdates_);
+  in.array(freeSegments_);
+  in.array(pendingFreeSegments_);
+  in.array(freeSynapses_);
+  structureChanged_();
+  clearDirty_();
+}
+
+
+// Some entries of a presynaptic map: present flags, offsets, values.
+template<typename Map>
+static void saveEntries(FlatWriter &out, const vector<CellIdx> &keys, const Map &map) {
+  using T = typename Map::mapped_type::value_type;
+  vector<UInt8> present;
+  vector<UInt64> offsets(1u, 0u);
+  vector<T> values;
+  for(const auto key : keys) {
+    const auto it = map.find(key);
+    present.push_back(it != map.end());
+    if( it != map.end() ) values.insert(values.end(), it->second.cbegin(), it->second.cend());
+    offsets.push_back(values.size());
+  }
+  out.array(present);
+  out.array(offsets);
+  out.array(values);
+}
+
+template<typename Map>
+static void loadEntries(FlatReader &in, const vector<CellIdx> &keys, Map &map) {
+  using T = typename Map::mapped_type::value_type;
+  size_t numPresent, numOffsets, numValues;
+  const UInt8 *present = in.view<UInt8>(numPresent);
+  const UInt64 *offsets = in.view<UInt64>(numOffsets);
+  const T *values = in.view<T>(numValues);
+  NTA_CHECK(numPresent == keys.size() and numOffsets == keys.size() + 1u and offsets[keys.size()] == numValues)
+    << "Connections::applyDelta: corrupt presynaptic map";
+  for(size_t i = 0u; i < keys.size(); i++) {
+    NTA_CHECK(offsets[i] <= offsets[i + 1u]) << "Connections::applyDelta: corrupt presynaptic map";
+    if( present[i] ) map[keys[i]].assign(values + offsets[i], values + offsets[i + 1u]);
+    else             map.erase(keys[i]);
+  }
+}
+
+void Connections::setDeltaTracking(const bool enable) {
+  deltaTracking_ = enable;
+  clearDirty_();
+}
+
+void Connections::saveDelta(const std::string &path) {
+  FlatWriter out(path, "HTMCDELT", FLAT_VERSION);
+  saveDelta(out);
+  out.close();
+}
+
+void Connections::applyDelta(const std::string &path) {
+  FlatReader in(path, "HTMCDELT", FLAT_VERSION);
+  applyDelta(in);
+}
+
+void Connections::saveDelta(FlatWriter &out) {
+  NTA_CHECK(deltaTracking_) << "Connections::saveDelta: delta tracking is not enabled.";
+  out.scalar(allDirty_);
+  if( allDirty_ ) {
+    saveFlat(out);
+    clearDirty_();
+    return;
+  }
+  out.scalar(static_cast<UInt32>(sizeof(PermanenceStorage)));
+  out.scalar(iteration_);
+  out.scalar(static_cast<UInt64>(cells_.size()));
+  out.scalar(static_cast<UInt64>(segments_.size()));
+  out.scalar(static_cast<UInt64>(synapses_.size()));
+  out.scalar(static_cast<UInt64>(destroyedSynapses_));
+  out.scalar(static_cast<UInt64>(destroyedSegments_));
+  out.scalar(nextSegmentOrdinal_);
+  out.scalar(nextSynapseOrdinal_);
+  out.scalar(prunedSyns_);
+  out.scalar(prunedSegs_);
+
+  // The changed segments, with all their synapses.
+  vector<Segment> segments(dirtySegments_.list.cbegin(), dirtySegments_.list.cend());
+  std::sort(segments.begin(), segments.end());
+  vector<SegmentData> segmentData;
+  segmentData.reserve(segments.size());
+  vector<Synapse> synapses(dirtySynapses_.list.cbegin(), dirtySynapses_.list.cend());
+  for(const auto segment : segments) {
+    segmentData.push_back(segments_[segment]);
+    synapses.insert(synapses.end(), segments_[segment].synapses.cbegin(), segments_[segment].synapses.cend());
+  }
+  vector<CellIdx> segmentCell;
+  vector<SynapseIdx> numConnected;
+  vector<UInt32> lastUsed;
+  vector<Segment> id;
+  for(const auto &data : segmentData) {
+    segmentCell.push_back(data.cell);
+    numConnected.push_back(data.numConnected);
+    lastUsed.push_back(data.lastUsed);
+    id.push_back(data.id);
+  }
+  out.array(segments);
+  out.array(segmentCell);
+  out.array(numConnected);
+  out.array(lastUsed);
+  out.array(id);
+  saveLists(out, segmentData, &SegmentData::synapses);
+
+  // The synapse slots of those segments, and the destroyed ones.
+  std::sort(synapses.begin(), synapses.end());
+  synapses.erase(std::unique(synapses.begin(), synapses.end()), synapses.end());
+  SynapseArrays synapseData;
+  for(const auto synapse : synapses) {
+    synapseData.presynapticCell.push_back(synapses_.presynapticCell[synapse]);
+    synapseData.permanence.push_back(synapses_.permanence[synapse]);
+    synapseData.segment.push_back(synapses_.segment[synapse]);
+    synapseData.presynapticMapIndex.push_back(synapses_.presynapticMapIndex[synapse]);
+    synapseData.id.push_back(synapses_.id[synapse]);
+  }
+  out.array(synapses);
+  saveArray(out, synapseData.presynapticCell);
+  saveArray(out, synapseData.permanence);
+  saveArray(out, synapseData.segment);
+  saveArray(out, synapseData.presynapticMapIndex);
+  saveArray(out, synapseData.id);
+
+  // The changed segment lists of the cells.
+  vector<CellIdx> cells(dirtyCells_.list.cbegin(), dirtyCells_.list.cend());
+  std::sort(cells.begin(), cells.end());
+  vector<CellData> cellData;
+  cellData.reserve(cells.size());
+  for(const auto cell : cells) cellData.push_back(cells_[cell]);
+  out.array(cells);
+  saveLists(out, cellData, &CellData::segments);
+
+  // The changed presynaptic map entries.
+  vector<CellIdx> presynaptic(dirtyPresynaptic_.list.cbegin(), dirtyPresynaptic_.list.cend());
+  std::sort(presynaptic.begin(), presynaptic.end());
+  out.array(presynaptic);
+  saveEntries(out, presynaptic, potentialSynapsesForPresynapticCell_);
+  saveEntries(out, presynaptic, connectedSynapsesForPresynapticCell_);
+  saveEntries(out, presynaptic, potentialSegmentsForPresynapticCell_);
+  saveEntries(out, presynaptic, connectedSegmentsForPresynapticCell_);
+
+  out.array(freeSegments_);
+  out.array(pendingFreeSegments_);
+  out.array(freeSynapses_);
+  out.array(previousUpdated_);
+  out.array(previousUpdates_);
+  out.array(currentUpdated_);
+  out.array(currentUpdates_);
+  clearDirty_();
+}
+
+void Connections::applyDelta(FlatReader &in) {
+  if( in.scalar<bool>() ) { //a full copy
+    loadFlat(in);
+    return;
+  }
+  NTA_CHECK(in.scalar<UInt32>() == sizeof(PermanenceStorage))
+    << "Connections::applyDelta: the delta was written with another permanence storage type.";
+  const auto iteration = in.scalar<UInt32>();
+  NTA_CHECK(in.scalar<UInt64>() == cells_.size())
+    << "Connections::applyDelta: the delta does not belong to these Connections.";
+  const auto numSegments = static_cast<size_t>(in.scalar<UInt64>());
+  const auto numSynapses = static_cast<size_t>(in.scalar<UInt64>());
+  NTA_CHECK(numSegments >= segments_.size() and numSynapses >= synapses_.size())
+    << "Connections::applyDelta: the delta does not belong to these Connections.";
+  iteration_ = iteration;
+  destroyedSynapses_  = static_cast<size_t>(in.scalar<UInt64>());
+  destroyedSegments_  = static_cast<size_t>(in.scalar<UInt64>());
+  nextSegmentOrdinal_ = in.scalar<Segment>();
+  nextSynapseOrdinal_ = in.scalar<Synapse>();
+  prunedSyns_ = in.scalar<Synapse>();
+  prunedSegs_ = in.scalar<Segment>();
+
+  vector<Segment> segments;
+  vector<CellIdx> segmentCell;
+  vector<SynapseIdx> numConnected;
+  vector<UInt32> lastUsed;
+  vector<Segment> id;
+  in.array(segments);
+  in.array(segmentCell);
+  in.array(numConnected);
+  in.array(lastUsed);
+  in.array(id);
+  NTA_CHECK(segmentCell.size() == segments.size() and numConnected.size() == segments.size() and
+            lastUsed.size() == segments.size() and id.size() == segments.size())
+    << "Connections::applyDelta: corrupt segments";
+  vector<SegmentData> segmentData;
+  segmentData.reserve(segments.size());
+  for(size_t i = 0u; i < segments.size(); i++) {
+    segmentData.emplace_back(segmentCell[i], id[i], lastUsed[i]);
+    segmentData.back().numConnected = numConnected[i];
+  }
+  loadLists(in, segmentData, &SegmentData::synapses);
+  segments_.resize(numSegments);
+  for(size_t i = 0u; i < segments.size(); i++) {
+    NTA_CHECK(segments[i] < numSegments) << "Connections::applyDelta: corrupt segments";
+    segments_[segments[i]] = std::move(segmentData[i]);
+  }
+
+  vector<Synapse> synapses;
+  SynapseArrays synapseData;
+  in.array(synapses);
+  loadArray(in, synapseData.presynapticCell);
+  loadArray(in, synapseData.permanence);
+  loadArray(in, synapseData.segment);
+  loadArray(in, synapseData.presynapticMapIndex);
+  loadArray(in, synapseData.id);
+  NTA_CHECK(synapseData.presynapticCell.size() == synapses.size() and synapseData.permanence.size() == synapses.size() and
+            synapseData.segment.size() == synapses.size() and synapseData.presynapticMapIndex.size() == synapses.size() and
+            synapseData.id.size() == synapses.size())
+    << "Connections::applyDelta: corrupt synapses";
+  synapses_.presynapticCell.resize(numSynapses);
+  synapses_.permanence.resize(numSynapses);
+  synapses_.segment.resize(numSynapses);
+  synapses_.presynapticMapIndex.resize(numSynapses);
+  synapses_.id.resize(numSynapses);
+  for(size_t i = 0u; i < synapses.size(); i++) {
+    const Synapse synapse = synapses[i];
+    NTA_CHECK(synapse < numSynapses) << "Connections::applyDelta: corrupt synapses";
+    synapses_.presynapticCell.ref(synapse)     = synapseData.presynapticCell[i];
+    synapses_.permanence.ref(synapse)          = synapseData.permanence[i];
+    synapses_.segment.ref(synapse)             = synapseData.segment[i];
+    synapses_.presynapticMapIndex.ref(synapse) = synapseData.presynapticMapIndex[i];
+    synapses_.id.ref(synapse)                  = synapseData.id[i];
+  }
+
+  vector<CellIdx> cells;
+  in.array(cells);
+  vector<CellData> cellData(cells.size());
+  loadLists(in, cellData, &CellData::segments);
+  for(size_t i = 0u; i < cells.size(); i++) {
+    NTA_CHECK(cells[i] < cells_.size()) << "Connections::applyDelta: corrupt cells";
+    cells_[cells[i]].segments = std::move(cellData[i].segments);
+  }
+
+  vector<CellIdx> presynaptic;
+  in.array(presynaptic);
+  loadEntries(in, presynaptic, potentialSynapsesForPresynapticCell_);
+  loadEntries(in, presynaptic, connectedSynapsesForPresynapticCell_);
+  loadEntries(in, presynaptic, potentialSegmentsForPresynapticCell_);
+  loadEntries(in, presynaptic, connectedSegmentsForPresynapticCell_);
+
+  // The synapses of unchanged segments may have moved within the changed entries.
+  for(const auto cell : presynaptic) {
+    for(const auto map : {&potentialSynapsesForPresynapticCell_, &connectedSynapsesForPresynapticCell_}) {
+      const auto it = map->find(cell);
+      if( it == map->end() ) continue;
+      for(size_t pos = 0u; pos < it->second.size(); pos++) {
+        NTA_CHECK(it->second[pos] < numSynapses) << "Connections::applyDelta: corrupt presynaptic map";
+        synapses_.presynapticMapIndex.ref(it->second[pos]) = static_cast<Synapse>(pos);
+      }
+    }
+  }
+
+  in.array(freeSegments_);
+  in.array(pendingFreeSegments_);
+  in.array(freeSynapses_);
+  in.array(previousUpdated_);
+  in.array(previousUpdates_);
+  in.array(currentUpdated_);
+  in.array(currentUpdates_);
+  structureChanged_();
+  clearDirty_();
 }
 
 
@@ -731,10 +2416,10 @@ std::ostream& operator<< (std::ostream& stream, const Connections& self)
       connectedMean += segData.numConnected;
 
       for( const auto syn : segData.synapses ) {
-        const auto &synData = self.dataForSynapse( syn );
-        if( synData.permanence <= minPermanence + Epsilon )
+        const auto permanence = self.permanenceForSynapse( syn );
+        if( permanence <= minPermanence + Epsilon )
           { synapsesDead++; }
-        else if( synData.permanence >= maxPermanence - Epsilon )
+        else if( permanence >= maxPermanence - Epsilon )
           { synapsesSaturated++; }
       }
     }
@@ -764,6 +2449,9 @@ std::ostream& operator<< (std::ostream& stream, const Connections& self)
 
 
 bool Connections::operator==(const Connections &o) const {
+  // the emptied presynaptic entries kept by the deferred maintenance are not state
+  erasePendingEmptyPresynaptic_();
+  o.erasePendingEmptyPresynaptic_();
   try {
   NTA_CHECK (cells_.size() == o.cells_.size()) << "Connections equals: cells_" << cells_.size() << " vs. " << o.cells_.size();
   NTA_CHECK (cells_ == o.cells_) << "Connections equals: cells_" << cells_.size() << " vs. " << o.cells_.size();
@@ -803,9 +2491,16 @@ bool Connections::operator==(const Connections &o) const {
   NTA_CHECK (nextSynapseOrdinal_ == o.nextSynapseOrdinal_ ) << "Connections equals: nextSynapseOrdinal_";
 
   NTA_CHECK (timeseries_ == o.timeseries_ ) << "Connections equals: timeseries_";
+  NTA_CHECK (segmentPruning_ == o.segmentPruning_ ) << "Connections equals: segmentPruning_";
+  NTA_CHECK (previousUpdated_ == o.previousUpdated_ ) << "Connections equals: previousUpdated_";
   NTA_CHECK (previousUpdates_ == o.previousUpdates_ ) << "Connections equals: previousUpdates_";
+  NTA_CHECK (currentUpdated_ == o.currentUpdated_ ) << "Connections equals: currentUpdated_";
   NTA_CHECK (currentUpdates_ == o.currentUpdates_ ) << "Connections equals: currentUpdates_";
 
+  NTA_CHECK (freeSegments_ == o.freeSegments_ ) << "Connections equals: freeSegments_";
+  NTA_CHECK (pendingFreeSegments_ == o.pendingFreeSegments_ ) << "Connections equals: pendingFreeSegments_";
+  NTA_CHECK (freeSynapses_ == o.freeSynapses_ ) << "Connections equals: freeSynapses_";
+
   NTA_CHECK (prunedSyns_ == o.prunedSyns_ ) << "Connections equals: prunedSyns_";
   NTA_CHECK (prunedSegs_ == o.prunedSegs_ ) << "Connections equals: prunedSegs_";
 
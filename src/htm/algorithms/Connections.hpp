@@ -22,17 +22,26 @@
 #ifndef NTA_CONNECTIONS_HPP
 #define NTA_CONNECTIONS_HPP
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 #include <map>
 #include <unordered_map>
 #include <set>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include <deque>
+#include <functional>
 
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Sdr.hpp>
+#include <htm/types/SparseSdr.hpp>
+#include <htm/utils/CowArray.hpp>
+#include <htm/utils/FlatArchive.hpp>
+#include <htm/utils/MemoryResource.hpp>
+#include <htm/utils/ThreadPool.hpp>
 
 namespace htm {
 
@@ -46,6 +55,64 @@ using Permanence= Real32; //TODO experiment with half aka float16
 constexpr const Permanence minPermanence = 0.0f;
 constexpr const Permanence maxPermanence = 1.0f;
 
+/**
+ * Type used by Connections to store the permanences of synapses.
+ *
+ * By default permanences are stored as Real32.  Building with
+ * `NTA_PERMANENCE_BITS` set to 16 or 8 (cmake -DHTM_PERMANENCE_BITS=16) stores
+ * them as fixed point numbers, which takes 2x resp. 4x less memory.  The
+ * permanences are then quantized to steps of 1/65534 resp. 1/254, so
+ * increments smaller than a step have no effect.  The API always uses
+ * (floating point) Permanence; the serialized format is the same for all
+ * storage types.
+ */
+#if defined(NTA_PERMANENCE_BITS) && (NTA_PERMANENCE_BITS == 8)
+using PermanenceStorage = uint8_t;
+#elif defined(NTA_PERMANENCE_BITS) && (NTA_PERMANENCE_BITS == 16)
+using PermanenceStorage = UInt16;
+#else
+using PermanenceStorage = Permanence;
+#endif
+
+/**
+ * Conversion between Permanence and its storage type.
+ * The stored values are ordered as the permanences they represent.
+ */
+template<typename T, bool isFloat = std::is_floating_point<T>::value>
+struct PermanenceCodec {
+  // Floating point storage, no conversion.
+  static constexpr T removed() { return static_cast<T>(-1); } //marks destroyed synapses
+  static constexpr Permanence step() { return 0.0f; } //not quantized
+  static T encode(const Permanence permanence) { return static_cast<T>(permanence); }
+  static Permanence decode(const T stored) { return static_cast<Permanence>(stored); }
+  static T threshold(const Permanence connectedThreshold) { return static_cast<T>(connectedThreshold); }
+};
+
+template<typename T>
+struct PermanenceCodec<T, false> {
+  // Fixed point storage, the largest value marks destroyed synapses.
+  static constexpr T removed() { return std::numeric_limits<T>::max(); }
+  static constexpr Permanence scale() {
+    return static_cast<Permanence>(std::numeric_limits<T>::max() - 1);
+  }
+  // the quantization step of the stored permanences
+  static constexpr Permanence step() { return 1.0f / scale(); }
+  static T encode(Permanence permanence) {
+    permanence = std::min(std::max(permanence, minPermanence), maxPermanence);
+    return static_cast<T>(permanence * scale() + 0.5f);
+  }
+  static Permanence decode(const T stored) { return static_cast<Permanence>(stored) / scale(); }
+  // @returns the smallest stored value with decode(value) >= connectedThreshold
+  static T threshold(const Permanence connectedThreshold) {
+    if(connectedThreshold <= minPermanence) return 0;
+    if(connectedThreshold > maxPermanence)  return removed();
+    auto stored = static_cast<T>(std::ceil(connectedThreshold * scale()));
+    while(stored > 0 and decode(static_cast<T>(stored - 1)) >= connectedThreshold) stored--;
+    while(decode(stored) < connectedThreshold) stored++;
+    return stored;
+  }
+};
+
 
 
 /**
@@ -272,7 +339,22 @@ public:
 class Connections : public Serializable
  {
 public:
-  static const UInt16 VERSION = 2;
+  /**
+   * The version of the archive.  Version 2 is the layout before the archive
+   * was versioned, without the free lists, the synapses of the permanence
+   * updates and the segment pruning.
+   */
+  static const UInt16 VERSION = 3;
+
+  /**
+   * How `createSegment` chooses the segment to destroy, when the cell already
+   * has `maxSegmentsPerCell` segments.
+   *  - LRU: the least recently used segment (min `SegmentData.lastUsed`). Scans all segments of the cell.
+   *  - OLDEST: the first created segment on the cell, O(1).
+   *  - RANDOM: a pseudo random segment, O(1). Deterministic, it depends only on
+   *    the state of the Connections.
+   */
+  enum class SegmentPruning { LRU = 0, OLDEST = 1, RANDOM = 2 };
 
   /**
    * Connections empty constructor.
@@ -297,7 +379,8 @@ public:
    */
   Connections(const CellIdx numCells, 
 	      const Permanence connectedThreshold = 0.5f,
-              const bool timeseries = false);
+              const bool timeseries = false,
+              const SegmentPruning segmentPruning = SegmentPruning::LRU);
 
   virtual ~Connections() {} 
 
@@ -308,10 +391,15 @@ public:
    * @param connectedThreshold Permanence threshold for synapses connecting or
    *                           disconnecting.
    * @param timeseries         See constructor.
+   * @param segmentPruning     Which segment `createSegment` removes from a full cell,
+   *                           see SegmentPruning. Default LRU.
    */
   void initialize(const CellIdx numCells, 
 		  const Permanence connectedThreshold = 0.5f,
-                  const bool timeseries = false);
+                  const bool timeseries = false,
+                  const SegmentPruning segmentPruning = SegmentPruning::LRU);
+
+  SegmentPruning getSegmentPruning() const noexcept { return segmentPruning_; }
 
   /**
    * Creates a segment on the specified cell.
@@ -320,7 +408,7 @@ public:
    *
    * @param maxSegmetsPerCell Optional. Enforce limit on maximum number of segments that can be
    * created on a Cell. If the limit is exceeded, call `destroySegment` to remove least used segments 
-   * (ordered by LRU `SegmentData.lastUsed`). Default value is numeric_limits::max() of the data-type, 
+   * (ordered by LRU `SegmentData.lastUsed`, or as set by SegmentPruning). Default value is numeric_limits::max() of the data-type, 
    * so effectively disabled. 
    *
    * @retval Unique ID of the created segment `seg`. Use `dataForSegment(seg)` to obtain the segment's data. 
@@ -361,8 +449,30 @@ public:
                         const CellIdx presynapticCell,
                         Permanence permanence);
 
+  /**
+   * Grows up to `maxNew` new synapses on the segment, to the candidate cells
+   * in the given order.  Candidates already synapsed on by the segment are
+   * skipped (and handled as in `createSynapse()`), so the result equals
+   * calling `createSynapse()` for each candidate until `maxNew` synapses were
+   * added.  The duplicate check is done once for all candidates, it costs
+   * O((numSynapses + candidates) * log(numSynapses)) instead of
+   * O(numSynapses * candidates).
+   *
+   * @param segment    Segment to grow synapses on.
+   * @param candidates Presynaptic cells, must not contain duplicates.
+   * @param permanence Initial permanence of the new synapses.
+   * @param maxNew     Maximum number of synapses to create.
+   *
+   * @return number of synapses created.
+   */
+  size_t growSynapses(const Segment segment,
+                      const std::vector<CellIdx> &candidates,
+                      const Permanence permanence,
+                      const size_t maxNew);
+
   /**
    * Destroys segment.
+   * Its slot is reused by a createSegment() after the next computeActivity(learn=true).
    *
    * @param segment Segment to destroy.
    */
@@ -370,6 +480,7 @@ public:
 
   /**
    * Destroys synapse.
+   * Its slot is reused by the next createSynapse().
    *
    * @param synapse Synapse to destroy.
    * @throws if synapse does not exist (ie already removed)
@@ -437,7 +548,7 @@ public:
    * @retval Segment that this synapse is on.
    */
   Segment segmentForSynapse(const Synapse synapse) const {
-    return synapses_[synapse].segment;
+    return synapses_.segment[synapse];
   }
 
   /**
@@ -453,19 +564,41 @@ public:
   }
   SegmentData& dataForSegment(const Segment segment) { //editable access, needed by SP
     NTA_CHECK(segmentExists_(segment));
+    markSegment_(segment);
     return segments_[segment];
   }
 
   /**
    * Gets the data for a synapse.
    *
+   * Note: synapses are stored internally as structure-of-arrays, so this
+   * returns a copy (snapshot) of the synapse's fields, not a reference into
+   * Connections. Prefer `permanenceForSynapse()` & `presynapticCellForSynapse()`
+   * in performance critical code.
+   *
    * @param synapse Synapse to get data for.
    *
    * @retval Synapse data.
    */
-  inline const SynapseData& dataForSynapse(const Synapse synapse) const {
+  inline SynapseData dataForSynapse(const Synapse synapse) const {
     NTA_CHECK(synapseExists_(synapse, true));
-    return synapses_[synapse];
+    return synapses_.get(synapse);
+  }
+
+  /**
+   * Gets the permanence of a synapse.
+   */
+  inline Permanence permanenceForSynapse(const Synapse synapse) const {
+    NTA_ASSERT(synapseExists_(synapse, true));
+    return Codec::decode(synapses_.permanence[synapse]);
+  }
+
+  /**
+   * Gets the presynaptic cell of a synapse.
+   */
+  inline CellIdx presynapticCellForSynapse(const Synapse synapse) const {
+    NTA_ASSERT(synapseExists_(synapse, true));
+    return synapses_.presynapticCell[synapse];
   }
 
   /**
@@ -499,6 +632,17 @@ public:
    */
   bool compareSegments(const Segment a, const Segment b) const;
 
+  /**
+   * Sort the segments in the order of compareSegments(), in linear time.
+   * Segments which compareSegments() considers equal are ordered by their
+   * flat index, so the result is fully deterministic.  The sort keys of the
+   * segments are packed into integers and radix sorted, so there are no
+   * lookups during the sort.
+   *
+   * @param segments Existing segments, sorted in place.
+   */
+  void sortSegments(std::vector<Segment> &segments);
+
   /**
    * Returns the synapses for the source cell that they synapse on.
    *
@@ -508,6 +652,73 @@ public:
    */
   std::vector<Synapse> synapsesForPresynapticCell(const CellIdx presynapticCell) const;
 
+  /**
+   * A view of consecutive synapses, without copying them.  Valid until the
+   * synapses of the presynaptic cell change.
+   */
+  struct SynapseSpan {
+    const Synapse *first;
+    const Synapse *last;
+    const Synapse *begin() const { return first; }
+    const Synapse *end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+    const Synapse &operator[](size_t i) const { return first[i]; }
+  };
+
+  /**
+   * Zero-copy version of synapsesForPresynapticCell: the connected synapses
+   * of the source cell followed by its potential (unconnected) synapses.
+   *
+   * @param presynapticCell Source cell index
+   *
+   * @return pair of spans (connected, potential), either may be empty
+   */
+  std::pair<SynapseSpan, SynapseSpan> synapseSpansForPresynapticCell(const CellIdx presynapticCell) const;
+
+  /**
+   * Exports the synapses of every presynaptic cell as compressed sparse rows.
+   * The synapses of cell `c` are synapses[ offsets[c] .. offsets[c+1] ), of
+   * which the first numConnected[c] are connected.  There is one row per
+   * cell up to the highest presynaptic cell with synapses.
+   *
+   * @param offsets      Output, row offsets, one more than the number of rows.
+   * @param synapses     Output, synapse indices.
+   * @param numConnected Output, number of connected synapses per row.
+   */
+  void presynapticAdjacency(std::vector<Synapse> &offsets,
+                            std::vector<Synapse> &synapses,
+                            std::vector<Synapse> &numConnected) const;
+
+  /**
+   * Bulk export of all segments and synapses as compressed sparse rows, one
+   * row per segment: segment i is on cell segmentCells[i], its synapses are
+   * [ offsets[i] .. offsets[i+1] ) of presynapticCells & permanences.  The
+   * segments are in the order of their cells, the synapses in the order of
+   * synapsesForSegment(), so importSegments() of the result rebuilds equal
+   * connectivity.
+   */
+  void exportSegments(std::vector<CellIdx> &segmentCells,
+                      std::vector<Synapse> &offsets,
+                      std::vector<CellIdx> &presynapticCells,
+                      std::vector<Permanence> &permanences) const;
+
+  /**
+   * Bulk import, the inverse of exportSegments(): replaces all segments and
+   * synapses by the given rows, eg. a model trained elsewhere.  The storage
+   * is reserved once and the presynaptic maps are built in a single pass,
+   * which is much faster than createSegment() & createSynapse() for each.
+   * The settings and the event subscribers are kept, the timeseries
+   * updates are cleared.  Segment & Synapse handles are invalidated.
+   *
+   * @throws if the rows are malformed, a cell is out of range, a permanence
+   * is not in [0, 1], or a segment has duplicate presynaptic cells.
+   */
+  void importSegments(const std::vector<CellIdx> &segmentCells,
+                      const std::vector<Synapse> &offsets,
+                      const std::vector<CellIdx> &presynapticCells,
+                      const std::vector<Permanence> &permanences);
+
   /**
    * For use with time-series datasets.
    */
@@ -541,6 +752,143 @@ public:
   std::vector<SynapseIdx> computeActivity(const std::vector<CellIdx> &activePresynapticCells, 
 		                          const bool learn = true);
 
+  /**
+   * computeActivity() which also hands the final counts to
+   * `reduced(counts, begin, end)`, once for each range [begin, end) of
+   * segments.  The ranges are disjoint and cover all segments.  With threads
+   * (@see setNumThreads) each range is handed over by the thread which summed
+   * up its partial counts, right after that, so the caller can derive values
+   * per segment in the same parallel pass, while the counts are in the cache
+   * (eg. the boosted overlaps of the SpatialPooler).  `reduced` must only
+   * write data of its own range.
+   */
+  using ReduceFn = std::function<void(const std::vector<SynapseIdx> &counts, size_t begin, size_t end)>;
+  std::vector<SynapseIdx> computeActivity(const std::vector<CellIdx> &activePresynapticCells,
+                                          const bool learn,
+                                          const ReduceFn &reduced);
+
+  /**
+   * Inference computeActivity() for a batch of inputs, eg. a whole dataset.
+   * The counts are the same as those of `computeActivity(batch[i], false)`
+   * for each input.
+   *
+   * The active cells of the batch are grouped by presynaptic cell, so the
+   * segments of each cell are looked up once for all the inputs in which it
+   * is active.  With threads (@see setNumThreads) the inputs are partitioned
+   * across the threads.  Does not use the incremental counts
+   * (@see setIncrementalActivity).
+   *
+   * @param batch Active presynaptic cells of each input.
+   *
+   * @param numActiveConnectedSynapsesForSegment Output, resized to the batch
+   * size; the connected synapse counts per segment of each input.
+   */
+  void computeActivity(const std::vector<std::vector<CellIdx>> &batch,
+                       std::vector<std::vector<SynapseIdx>> &numActiveConnectedSynapsesForSegment);
+
+  /**
+   * Sparse variant of `computeActivity`, for callers which only need the
+   * segments that received any input.  The counts are written into caller
+   * owned buffers which are reused across calls: only the entries of the
+   * segments touched by the previous call are reset, so the cost scales with
+   * the number of active synapses instead of the number of segments.
+   *
+   * @param numActiveConnectedSynapsesForSegment
+   * @param numActivePotentialSynapsesForSegment
+   * Output counts per segment, resized to getSegmentFlatVectorLength().  All
+   * entries of segments not in `touchedSegments` are zero.
+   *
+   * @param touchedSegments In: the segments touched by the previous call on
+   * the same buffers, all other entries of the buffers must be zero (eg.
+   * empty buffers).  Out: the segments with at least one active potential
+   * synapse, unsorted.
+   *
+   * @param activePresynapticCells Active cells in the input.
+   *
+   * @param bool learn : enable learning updates (default true)
+   *
+   * @param potentialSynapses If false, only the connected synapses are
+   * counted: the potential counts stay zero and `touchedSegments` are the
+   * segments with at least one active connected synapse.  Default true.
+   *
+   * The buffers must not be modified by the caller in between calls.  This
+   * path always runs on the calling thread and does not use the incremental
+   * counts (@see setIncrementalActivity).
+   */
+  void computeActivity(std::vector<SynapseIdx> &numActiveConnectedSynapsesForSegment,
+                       std::vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
+                       std::vector<Segment>    &touchedSegments,
+                       const std::vector<CellIdx> &activePresynapticCells,
+                       const bool learn = true,
+                       const bool potentialSynapses = true);
+
+  /**
+   * Enable/disable the compacted presynaptic index used by `computeActivity`.
+   *
+   * When enabled, the presynaptic -> segments maps are mirrored into a flat
+   * CSR layout (offsets indexed by presynaptic cell + one contiguous segment
+   * array), so `computeActivity` becomes a linear scan over contiguous memory
+   * with no hash lookups. The index is rebuilt lazily on the next call to
+   * `computeActivity` after any structural change (synapse created, destroyed,
+   * or crossing the connected threshold), so it pays off when the connections
+   * are stable between compute cycles, ie. inference or infrequent learning.
+   *
+   * Default false. This is a runtime setting, it is not serialized.
+   */
+  void setCompactPresynapticIndex(const bool enable) {
+    compactIndex_ = enable;
+    compactIndexDirty_ = true;
+  }
+  bool getCompactPresynapticIndex() const noexcept { return compactIndex_; }
+
+  /**
+   * Set the number of threads used by `computeActivity`.
+   *
+   * With more than one thread the active presynaptic cells are partitioned
+   * across a thread pool, each thread counts into its own partial vector and
+   * the partial counts are then summed up (also in parallel, over ranges of
+   * segments).  This pays off for large Connections (~1M segments) with many
+   * active inputs; small inputs are always processed on the calling thread.
+   * Results are identical to the single threaded computation.
+   *
+   * @param numThreads Number of threads including the calling thread.
+   *        Default 1 (no threading). Use 0 for all hardware threads.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setNumThreads(const UInt numThreads);
+  UInt getNumThreads() const noexcept { return numThreads_; }
+
+  /**
+   * Enable/disable incremental computation of the segment activity.
+   *
+   * When enabled, Connections keeps the active presynaptic cells and the
+   * counts of the last `computeActivity` call.  If no synapse was created,
+   * destroyed, or crossed the connected threshold since then, the next call
+   * only processes the cells which turned on or off, so the cost scales with
+   * the change of the input instead of its density.  This pays off for
+   * inference on slowly changing inputs; after any structural change (eg.
+   * learning) the counts are fully recomputed.  Results are identical to the
+   * non-incremental computation.
+   *
+   * Default false. This is a runtime setting, it is not serialized.
+   */
+  void setIncrementalActivity(const bool enable);
+  bool getIncrementalActivity() const noexcept { return incremental_; }
+
+  /**
+   * The segments whose connected count may have changed in the last
+   * incremental `computeActivity` call (@see setIncrementalActivity): those of
+   * the cells which turned on or off, possibly with duplicates.  Call it
+   * right after `computeActivity`, before any change of the synapses.
+   *
+   * @param segments Output, the changed segments.
+   *
+   * @returns false if the last call recounted all the segments (or was not
+   * incremental), then `segments` is empty and any count may have changed.
+   */
+  bool incrementalChangedSegments(std::vector<Segment> &segments) const;
+
   /**
    * The primary method in charge of learning.   Adapts the permanence values of
    * the synapses based on the input SDR.  Learning is applied to a single
@@ -567,6 +915,91 @@ public:
 		    const bool pruneZeroSynapses = false,
 		    const UInt segmentThreshold = 0);
 
+  // Same, for the callback-free SparseSDR scratch inputs of the algorithms.
+  void adaptSegment(const Segment segment,
+                    const SparseSDR &inputs,
+                    const Permanence increment,
+                    const Permanence decrement,
+                    const bool pruneZeroSynapses = false,
+                    const UInt segmentThreshold = 0);
+
+  /**
+   * Batch version of adaptSegment(), applies the same learning to many
+   * segments.  It fetches the dense input once, reuses scratch buffers and
+   * updates the presynaptic maps in one pass after all permanences changed.
+   * The result equals calling adaptSegment() for each segment, except for
+   * the order in which destroyed synapses are recycled.
+   *
+   * @param segments  The segments to learn on, must not contain duplicates.
+   * For the other params @see adaptSegment().
+   */
+  void adaptSegments(const std::vector<Segment> &segments,
+                     const SDR &inputs,
+                     const Permanence increment,
+                     const Permanence decrement,
+                     const bool pruneZeroSynapses = false,
+                     const UInt segmentThreshold = 0);
+
+  void adaptSegments(std::vector<Segment>::const_iterator begin,
+                     std::vector<Segment>::const_iterator end,
+                     const SDR &inputs,
+                     const Permanence increment,
+                     const Permanence decrement,
+                     const bool pruneZeroSynapses = false,
+                     const UInt segmentThreshold = 0);
+
+  void adaptSegments(std::vector<Segment>::const_iterator begin,
+                     std::vector<Segment>::const_iterator end,
+                     const SparseSDR &inputs,
+                     const Permanence increment,
+                     const Permanence decrement,
+                     const bool pruneZeroSynapses = false,
+                     const UInt segmentThreshold = 0);
+
+  /**
+   * One learning step of a group of segments, for the two phase form of
+   * adaptSegments() used by parallel learning.  The caller fills in the
+   * segments and the increment/decrement, adaptPermanences() records the
+   * structural changes which applyAdaptation() carries out later.
+   */
+  struct PendingAdaptation {
+    std::vector<Segment> segments;
+    Permanence increment = 0.0f;
+    Permanence decrement = 0.0f;
+    // filled by adaptPermanences()
+    std::vector<Synapse> flipped; //crossed the connected threshold
+    std::vector<Synapse> destroy; //to be pruned
+    std::vector<std::pair<Synapse, Permanence>> updates; //with timeseries
+  };
+
+  /**
+   * First phase of the two phase adaptSegments(): updates only the
+   * permanences of the segments of all `pending` items, the presynaptic maps
+   * and the synapse & segment lists are left untouched.  The items are
+   * processed in parallel (@see setNumThreads) and the results do not depend
+   * on the number of threads.  The segments of all items must be distinct.
+   *
+   * Calling applyAdaptation() on each item afterwards gives the same result
+   * as calling adaptSegments() on each item, in the same order, provided the
+   * segments were not modified in between.
+   */
+  void adaptPermanences(std::vector<PendingAdaptation> &pending,
+                        const SDR &inputs,
+                        const bool pruneZeroSynapses = false);
+
+  void adaptPermanences(std::vector<PendingAdaptation> &pending,
+                        const SparseSDR &inputs,
+                        const bool pruneZeroSynapses = false);
+
+  /**
+   * Second phase of the two phase adaptSegments(): updates the presynaptic
+   * maps, prunes the synapses and segments recorded for the item.  Not thread
+   * safe.  For the params @see adaptSegment().
+   */
+  void applyAdaptation(const PendingAdaptation &item,
+                       const bool pruneZeroSynapses = false,
+                       const UInt segmentThreshold = 0);
+
   /**
    * Ensures a minimum number of connected synapses.  This raises permance
    * values until the desired number of synapses have permanences above the
@@ -632,6 +1065,170 @@ public:
 		                    const size_t nDestroy,
                                     const SDR_sparse_t &excludeCells = {});
 
+  /**
+   * Remove the storage of all destroyed segments and synapses.
+   *
+   * Connections reuse the slots of destroyed synapses and segments, so the
+   * storage is bounded by the peak number of live ones.  This method releases
+   * the remaining unused slots: segments and synapses are renumbered densely
+   * (keeping their relative order) and the presynaptic maps are rebuilt.
+   * Afterwards `segmentFlatListLength() == numSegments()`.
+   *
+   * WARNING: This invalidates all Segment and Synapse handles held by the
+   * caller, eg. TemporalMemory's active & matching segments.  Call it between
+   * compute cycles, or after TM.reset().
+   */
+  void compact();
+
+  /**
+   * Reorder the storage so that each cell's segments, and each segment's
+   * synapses, are contiguous.  Segments are created and synapses grown in
+   * the order of learning, so after a long run the data of one cell or one
+   * segment is scattered over the arrays; adaptSegment(), growSynapses() and
+   * the TemporalMemory's per-cell loops then touch fewer cache lines.
+   * Like compact(), this also releases the destroyed segments and synapses.
+   *
+   * The order of the segments in segmentsForCell() and of the synapses in
+   * synapsesForSegment() is unchanged, and so are the results of learning.
+   *
+   * WARNING: This invalidates all Segment and Synapse handles held by the
+   * caller, same as compact().
+   *
+   * @returns The remap table of the segments: the new flat index of each old
+   * flat index, or std::numeric_limits<Segment>::max() for destroyed ones.
+   */
+  std::vector<Segment> defragment();
+
+  /**
+   * Defer the clean-up of the presynaptic maps to a quiet point.
+   *
+   * Destroying the last synapse from a presynaptic cell erases the cell's
+   * entry from the presynaptic maps, which frees a hash node, and the next
+   * synapse grown to that cell allocates it again.  Learning prunes and
+   * grows synapses to the same cells all the time, so with deferred
+   * maintenance destroySynapse() leaves the emptied entries in place and
+   * queues them, and applyMaintenance() erases those which are still empty.
+   * The synapse is removed from its segment and from the presynaptic lists
+   * at once, so the results of computeActivity() and of learning are the
+   * same in both modes.  save_ar() and operator== erase the pending entries
+   * first, so neither depends on the mode either.
+   *
+   * Maintenance does not run on a background thread: computeActivity()
+   * reads the maps without locks.
+   *
+   * @param enable Disabling applies the pending maintenance.
+   * @param interval If > 0, applyMaintenance() runs at the start of every
+   * `interval`-th learning computeActivity().  Default 0: only when called.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setDeferredMaintenance(const bool enable, const UInt interval = 0u);
+  bool getDeferredMaintenance() const noexcept { return deferMaintenance_; }
+
+  /**
+   * Hold the periodic applyMaintenance() of setDeferredMaintenance(), eg.
+   * in a step with a deadline.  A maintenance which fell due while held
+   * runs at the first learning computeActivity() after the release.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void holdMaintenance(const bool hold) noexcept { holdMaintenance_ = hold; }
+
+  /**
+   * Apply the maintenance queued by destroySynapse() with deferred
+   * maintenance (@see setDeferredMaintenance).  Does not invalidate any
+   * Segment or Synapse handles; for that see compact().
+   */
+  void applyMaintenance();
+
+  /**
+   * @returns the number of queued presynaptic map entries.
+   */
+  size_t numPendingMaintenance() const noexcept { return pendingEmptyPresynaptic_.size(); }
+
+  /**
+   * Estimate the heap memory held by this Connections, in bytes.  Counts the
+   * allocated capacity of the cells, segments, synapses and the presynaptic
+   * indexes, including the storage of destroyed segments & synapses which
+   * `compact()` would release.
+   */
+  size_t memoryUsage() const;
+
+  /**
+   * Allocate the synapse arrays, which hold most of a large model, and the
+   * compacted presynaptic index (@see setCompactPresynapticIndex) from
+   * `resource`, eg. a MonotonicResource over a hugepage or shared memory
+   * mapping.  Existing synapses are moved over.  Null selects the heap
+   * (MemoryResource::defaultResource()).
+   *
+   * The resource must outlive this Connections, and copies of it which keep
+   * using the resource.  This is a runtime setting, it is not serialized.
+   */
+  void setMemoryResource(MemoryResource *resource);
+  MemoryResource *getMemoryResource() const noexcept { return synapses_.resource(); }
+
+  /**
+   * A copy for evaluating a variant of the model, eg. with other learning
+   * parameters.  The synapse arrays are stored in chunks (@see CowArray)
+   * which the fork shares with this Connections until one of them writes to
+   * a chunk, so forking a large model and running it costs memory in
+   * proportion to the synapses it changes.  The segment lists and the
+   * presynaptic maps are copied.
+   *
+   * Unlike a plain copy, which also shares the chunks, the fork has its own
+   * thread pool and no event handlers, so it can run concurrently with this
+   * Connections.  Forking must not run concurrently with changes to this
+   * Connections.
+   */
+  Connections fork() const;
+
+  /**
+   * Save to / load from a flat binary file.
+   *
+   * Unlike the cereal archives of Serializable, the flat file stores the
+   * cells, segments, synapses and the presynaptic maps as contiguous arrays
+   * (the lists of each cell, segment and presynaptic cell in CSR form), and
+   * is loaded from a read-only memory mapping of the file with a bulk copy
+   * of each array.  This makes loading large models about as fast as
+   * reading the file.
+   *
+   * The file is versioned (FLAT_VERSION) and written in the byte order of
+   * the machine; it can only be loaded by a build with the same permanence
+   * storage type (@see PermanenceStorage).  Use Serializable for portable
+   * archives.
+   */
+  void saveFlat(const std::string &path) const;
+  void loadFlat(const std::string &path);
+  void saveFlat(FlatWriter &out) const;
+  void loadFlat(FlatReader &in);
+  static const UInt32 FLAT_VERSION = 2u;
+
+  /**
+   * Delta checkpoints.
+   *
+   * With delta tracking enabled the Connections record which segments,
+   * synapse slots and presynaptic cells changed.  saveDelta() writes only
+   * those (plus the small global state and the free lists) and starts a new
+   * delta, so the size of a delta scales with the learning activity since
+   * the previous one.  applyDelta() applies a delta on top of the state it
+   * was taken from, ie. restore the full checkpoint (Serializable or
+   * loadFlat) and then apply the deltas taken after it, in order.
+   *
+   * Enable tracking right after saving a full checkpoint, enabling it starts
+   * an empty delta.  compact() and initialize() change every index, the next
+   * delta is then a full copy.  With timeseries the update history of the
+   * last two steps is written whole.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setDeltaTracking(bool enable);
+  bool getDeltaTracking() const noexcept { return deltaTracking_; }
+  size_t numDirtySegments() const noexcept { return dirtySegments_.list.size(); }
+  void saveDelta(const std::string &path);
+  void applyDelta(const std::string &path);
+  void saveDelta(FlatWriter &out);
+  void applyDelta(FlatReader &in);
+
   /**
    * Print diagnostic info
    */
@@ -642,11 +1239,18 @@ public:
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
+    erasePendingEmptyPresynaptic_(); //the archive is the same with & without deferred maintenance
+    saveArchiveVersion(ar, ARCHIVE_MARKER, VERSION);
     ar(CEREAL_NVP(connectedThreshold_));
     ar(CEREAL_NVP(iteration_));
     ar(CEREAL_NVP(cells_));
     ar(CEREAL_NVP(segments_));
-    ar(CEREAL_NVP(synapses_));
+    std::vector<SynapseData> synapses; //keep the array-of-structs format in the archive
+    synapses.reserve(synapses_.size());
+    for(Synapse syn = 0; syn < synapses_.size(); syn++) {
+      synapses.push_back(synapses_.get(syn));
+    }
+    ar(cereal::make_nvp("synapses_", synapses));
 
     ar(CEREAL_NVP(destroyedSynapses_));
     ar(CEREAL_NVP(destroyedSegments_));
@@ -660,22 +1264,37 @@ public:
     ar(CEREAL_NVP(nextSynapseOrdinal_));
 
     ar(CEREAL_NVP(timeseries_));
+    ar(CEREAL_NVP(previousUpdated_));
     ar(CEREAL_NVP(previousUpdates_));
+    ar(CEREAL_NVP(currentUpdated_));
     ar(CEREAL_NVP(currentUpdates_));
 
     ar(CEREAL_NVP(prunedSyns_));
     ar(CEREAL_NVP(prunedSegs_));
+
+    ar(CEREAL_NVP(freeSegments_));
+    ar(CEREAL_NVP(pendingFreeSegments_));
+    ar(CEREAL_NVP(freeSynapses_));
+    ar(CEREAL_NVP(segmentPruning_));
   }
 
   template<class Archive>
   void load_ar(Archive & ar) {
-    ar(CEREAL_NVP(connectedThreshold_));
+    const UInt32 version = loadArchiveVersion(ar, "connectedThreshold_", connectedThreshold_, ARCHIVE_MARKER, 2u);
+    NTA_CHECK(version <= VERSION) << "Connections: unknown archive version " << version;
+    connectedThresholdStored_ = Codec::threshold(connectedThreshold_);
     ar(CEREAL_NVP(iteration_));
     //!initialize(numCells, connectedThreshold_); //initialize Connections //Note: we actually don't call Connections
     //initialize() as all the members are de/serialized. 
     ar(CEREAL_NVP(cells_));
     ar(CEREAL_NVP(segments_));
-    ar(CEREAL_NVP(synapses_));
+    std::vector<SynapseData> synapses;
+    ar(cereal::make_nvp("synapses_", synapses));
+    synapses_.clear();
+    for(const auto &synData : synapses) {
+      synapses_.push_back(synData);
+      if(synData.permanence == -1.0f) synapses_.permanence.ref(synapses_.size() - 1u) = Codec::removed(); //destroyed synapse
+    }
 
     ar(CEREAL_NVP(destroyedSynapses_));
     ar(CEREAL_NVP(destroyedSegments_));
@@ -689,11 +1308,35 @@ public:
     ar(CEREAL_NVP(nextSynapseOrdinal_));
 
     ar(CEREAL_NVP(timeseries_));
-    ar(CEREAL_NVP(previousUpdates_));
-    ar(CEREAL_NVP(currentUpdates_));
+    if( version >= 3u ) {
+      ar(CEREAL_NVP(previousUpdated_));
+      ar(CEREAL_NVP(previousUpdates_));
+      ar(CEREAL_NVP(currentUpdated_));
+      ar(CEREAL_NVP(currentUpdates_));
+    }
+    else { //the updates of all synapses, minPermanence if none
+      ar(CEREAL_NVP(previousUpdates_));
+      ar(CEREAL_NVP(currentUpdates_));
+      sparseUpdates_(previousUpdated_, previousUpdates_);
+      sparseUpdates_(currentUpdated_,  currentUpdates_);
+    }
 
     ar(CEREAL_NVP(prunedSyns_));
     ar(CEREAL_NVP(prunedSegs_));
+
+    if( version >= 3u ) {
+      ar(CEREAL_NVP(freeSegments_));
+      ar(CEREAL_NVP(pendingFreeSegments_));
+      ar(CEREAL_NVP(freeSynapses_));
+      ar(CEREAL_NVP(segmentPruning_));
+    }
+    else {
+      rebuildFreeLists_();
+      segmentPruning_ = SegmentPruning::LRU;
+    }
+    pendingEmptyPresynaptic_.clear();
+    structureChanged_();
+    clearDirty_();
   }
 
   /**
@@ -705,6 +1348,15 @@ public:
 
   constexpr Permanence getConnectedThreshold() const noexcept { return connectedThreshold_; }
 
+  /**
+   * A version number of the synapse structure.  It changes whenever a
+   * synapse is created, destroyed, or crosses the connected threshold, and
+   * is unique among all Connections objects, so caches derived from the
+   * synapses (eg. of a ComputeBackend) can tell if they are still up to date.
+   * Permanence changes which do not cross the threshold keep the version.
+   */
+  UInt64 structureVersion() const;
+
   /**
    * Gets the number of segments.
    *
@@ -743,6 +1395,12 @@ public:
 	  return segments_[segment].synapses.size(); 
   }
 
+  /**
+   * The number of synapses and segments which adaptSegment() pruned, in total.
+   */
+  size_t numPrunedSynapses() const { return prunedSyns_; }
+  size_t numPrunedSegments() const { return prunedSegs_; }
+
   /**
    * Comparison operator.
    */
@@ -758,6 +1416,9 @@ public:
    * while this instance is still using it. It will be deleted on
    * `unsubscribe`.
    *
+   * Builds with NTA_CONNECTIONS_NO_EVENTS (cmake -DHTM_CONNECTIONS_NO_EVENTS=ON)
+   * compile the event dispatch out; subscribe() then deletes the handler and throws.
+   *
    * @param handler
    * An object implementing the ConnectionsEventHandler interface
    *
@@ -794,8 +1455,7 @@ protected:
    * @param fast - bool, default false. If false, run the slow, proper check that is always correct. 
    *   If true, we use a "hack" for speed, where destroySynapse sets synapseData.permanence=-1,
    *   so we can check and compare alter, if ==-1 then synapse is "removed". 
-   *   The problem is that synapseData are never truly removed. 
-   *   #TODO instead of vector<SynapseData> synapses_, try map<Synapse, SynapseData>, that way, we can properly remove (and check).
+   *   The slot of a removed synapse stays "removed" until createSynapse() reuses it.
    *
    * @retval True if synapse is valid (not removed, it's still in its segment's synapse list)
    */
@@ -821,36 +1481,303 @@ protected:
                               std::vector<Segment> &segmentsForPresynapticCell);
 
   /** 
-   *  Remove least recently used Segment from cell. 
+   *  Remove a Segment from a full cell, the least recently used one by default. 
+   *  @see SegmentPruning
    */
   void pruneLRUSegment_(const CellIdx& cell);
 
+  /**
+   * Move the synapse between the connected and potential presynaptic maps,
+   * after its permanence crossed the connected threshold.
+   */
+  void updateConnectedState_(const Synapse synapse, const bool connected);
+
+  void adaptSegments_(const Segment *begin,
+                      const Segment *end,
+                      const SDR_sparse_t &inputs,
+                      const UInt inputSize,
+                      const Permanence increment,
+                      const Permanence decrement,
+                      const bool pruneZeroSynapses,
+                      const UInt segmentThreshold);
+  void adaptPermanences_(std::vector<PendingAdaptation> &pending,
+                         const SDR_sparse_t &inputs,
+                         const UInt inputSize,
+                         const bool pruneZeroSynapses);
+
+  // The inputs of adaptSegments_() as a dense array, without converting the
+  // whole SDR: adaptInputDense_ is kept between calls and only the cells which
+  // turned on/off are written. Not serialized.
+  const SDR_dense_t &adaptInput_(const SDR_sparse_t &active, const UInt size);
+  SDR_dense_t adaptInputDense_;
+  std::vector<CellIdx> adaptInputSparse_; //the active cells in adaptInputDense_
+
+  // Phases of adaptSegments_(). updatePermanences_ only writes to the synapses
+  // of the given segments, so it may run concurrently for disjoint segments.
+  void updatePermanences_(const Segment *begin,
+                          const Segment *end,
+                          const SDR_dense_t &inputArray,
+                          const Permanence increment,
+                          const Permanence decrement,
+                          const bool pruneZeroSynapses,
+                          std::vector<Synapse> &flipped,
+                          std::vector<Synapse> &destroyLater,
+                          std::vector<std::pair<Synapse, Permanence>> &updates);
+  void applyAdaptation_(const Segment *begin,
+                        const Segment *end,
+                        const std::vector<Synapse> &flipped,
+                        const std::vector<Synapse> &destroyLater,
+                        const bool pruneZeroSynapses,
+                        const UInt segmentThreshold);
+
 private:
   std::vector<CellData>    cells_;
+  SegmentPruning           segmentPruning_ = SegmentPruning::LRU;
   std::vector<SegmentData> segments_;
   size_t                   destroyedSegments_ = 0;
-  std::vector<SynapseData> synapses_;
+  // Slots of destroyed segments, reused by createSegment().  Segments destroyed
+  // during the current step wait in `pendingFreeSegments_` until the next
+  // learning computeActivity(), so handles held by the caller stay valid within a step.
+  std::vector<Segment>     freeSegments_;
+  std::vector<Segment>     pendingFreeSegments_;
+  void releasePendingSegments_();
+  // The free lists of an archive without them, from the destroyed slots.
+  void rebuildFreeLists_();
+  // The updated synapses of an archive with the updates of all synapses.
+  static void sparseUpdates_(std::vector<Synapse> &updated, std::vector<Permanence> &updates);
+  // The first field of versioned archives, an impossible connectedThreshold_.
+  static constexpr Permanence ARCHIVE_MARKER = -1.0f;
+  // destroySynapse(), optionally without erasing the synapse from its segment's list.
+  void destroySynapse_(const Synapse synapse, const bool eraseFromSegment);
+  // destroySynapse() of many synapses, each segment's list is compacted once.
+  void destroySynapses_(const Synapse *begin, const Synapse *end);
+  // deferred maintenance, @see setDeferredMaintenance()
+  bool deferMaintenance_ = false;
+  UInt maintenanceInterval_ = 0u;
+  bool holdMaintenance_ = false;
+  bool maintenanceDue_ = false;
+  // (presynaptic cell, connected map) of the emptied entries
+  mutable std::vector<std::pair<CellIdx, bool>> pendingEmptyPresynaptic_;
+  // applyMaintenance() without the schedule, for the const save_ar() & operator==.
+  void erasePendingEmptyPresynaptic_() const;
+  // compact() & defragment(), @returns the new index of each segment.
+  std::vector<Segment> renumber_(const bool byCell);
+  // createSynapse() without the check for an existing synapse to the cell
+  Synapse createSynapseUnchecked_(const Segment segment,
+                                  const CellIdx presynapticCell,
+                                  const Permanence permanence);
+
+  /**
+   * Synapse data stored as structure-of-arrays, indexed by Synapse.
+   * The hot loops (adaptSegment, bumpSegment, raisePermanencesToThreshold, ...)
+   * only touch `permanence` and `presynapticCell`, so they do not pull the
+   * cold fields into the cache.  `get()` assembles a SynapseData.
+   */
+  using Codec = PermanenceCodec<PermanenceStorage>;
+
+  struct SynapseArrays {
+    CowArray<CellIdx>    presynapticCell;
+    CowArray<PermanenceStorage> permanence; //@see PermanenceCodec
+    CowArray<Segment>    segment;
+    CowArray<Synapse>    presynapticMapIndex;
+    CowArray<Synapse>    id;
+
+    explicit SynapseArrays(MemoryResource *resource = nullptr)
+      : presynapticCell(resource), permanence(resource), segment(resource),
+        presynapticMapIndex(resource), id(resource) {}
+
+    size_t size() const noexcept { return permanence.size(); }
+    MemoryResource *resource() const noexcept { return permanence.resource(); }
+
+    void setResource(MemoryResource *resource) {
+      presynapticCell.setResource(resource);
+      permanence.setResource(resource);
+      segment.setResource(resource);
+      presynapticMapIndex.setResource(resource);
+      id.setResource(resource);
+    }
+
+    void clear() {
+      presynapticCell.clear();
+      permanence.clear();
+      segment.clear();
+      presynapticMapIndex.clear();
+      id.clear();
+    }
+
+    void push_back(const SynapseData &data) {
+      presynapticCell.push_back(data.presynapticCell);
+      permanence.push_back(Codec::encode(data.permanence));
+      segment.push_back(data.segment);
+      presynapticMapIndex.push_back(data.presynapticMapIndex_);
+      id.push_back(data.id);
+    }
+
+    void set(const Synapse synapse, const SynapseData &data) {
+      presynapticCell.ref(synapse)     = data.presynapticCell;
+      permanence.ref(synapse)          = Codec::encode(data.permanence);
+      segment.ref(synapse)             = data.segment;
+      presynapticMapIndex.ref(synapse) = data.presynapticMapIndex_;
+      id.ref(synapse)                  = data.id;
+    }
+
+    SynapseData get(const Synapse synapse) const {
+      SynapseData data;
+      data.presynapticCell      = presynapticCell[synapse];
+      data.permanence           = permanence[synapse] == Codec::removed() ? -1.0f : Codec::decode(permanence[synapse]);
+      data.segment              = segment[synapse];
+      data.presynapticMapIndex_ = presynapticMapIndex[synapse];
+      data.id                   = id[synapse];
+      return data;
+    }
+
+    bool operator==(const SynapseArrays &o) const {
+      return presynapticCell == o.presynapticCell and permanence == o.permanence and
+             segment == o.segment and presynapticMapIndex == o.presynapticMapIndex and
+             id == o.id;
+    }
+  };
+  SynapseArrays            synapses_;
+  PermanenceStorage        connectedThresholdStored_; //connectedThreshold_ in storage type, for fast compares
   size_t                   destroyedSynapses_ = 0;
+  std::vector<Synapse>     freeSynapses_; //slots of destroyed synapses, reused by createSynapse()
   Permanence               connectedThreshold_; //TODO make const
   UInt32 iteration_ = 0;
 
   // Extra bookkeeping for faster computing of segment activity.
  
   struct identity { constexpr size_t operator()( const CellIdx t ) const noexcept { return t; };   };	//TODO in c++20 use std::identity 
-
-  std::unordered_map<CellIdx, std::vector<Synapse>, identity> potentialSynapsesForPresynapticCell_;
-  std::unordered_map<CellIdx, std::vector<Synapse>, identity> connectedSynapsesForPresynapticCell_;
-  std::unordered_map<CellIdx, std::vector<Segment>, identity> potentialSegmentsForPresynapticCell_;
-  std::unordered_map<CellIdx, std::vector<Segment>, identity> connectedSegmentsForPresynapticCell_;
+  // mutable: the const save_ar() & operator== erase the entries emptied by deferred maintenance
+
+  mutable std::unordered_map<CellIdx, std::vector<Synapse>, identity> potentialSynapsesForPresynapticCell_;
+  mutable std::unordered_map<CellIdx, std::vector<Synapse>, identity> connectedSynapsesForPresynapticCell_;
+  mutable std::unordered_map<CellIdx, std::vector<Segment>, identity> potentialSegmentsForPresynapticCell_;
+  mutable std::unordered_map<CellIdx, std::vector<Segment>, identity> connectedSegmentsForPresynapticCell_;
+
+  // Compacted (CSR) copy of the presynaptic segment maps above, used by computeActivity.
+  // Segments for presynaptic cell `c` are flat[ offsets[c] .. offsets[c+1] ).
+  // @see setCompactPresynapticIndex()
+  bool compactIndex_ = false;
+  bool compactIndexDirty_ = true;
+  std::vector<Synapse> connectedOffsetsForPresynapticCell_;
+  ResourceVector<Segment> connectedSegmentsFlat_;
+  std::vector<Synapse> potentialOffsetsForPresynapticCell_;
+  ResourceVector<Segment> potentialSegmentsFlat_;
+  void rebuildCompactIndex_();
+
+  // Adds the number of active (connected or potential) synapses per segment to `counts`,
+  // then calls `reduced` (if any) on the final counts, @see computeActivity().
+  void countActiveSynapses_(const std::vector<CellIdx> &activePresynapticCells,
+                            const bool connected,
+                            std::vector<SynapseIdx> &counts,
+                            const ReduceFn *reduced = nullptr);
+  void countActiveSynapses_(const std::vector<CellIdx> &activePresynapticCells,
+                            const size_t begin, const size_t end,
+                            const bool connected,
+                            SynapseIdx *counts,
+                            const bool subtract = false) const;
+
+  // Sparse counting for the touched-segments computeActivity(). Adds to
+  // `potential` and, if `connected` is not null, to `connected`.
+  void countTouchedSegments_(const std::vector<CellIdx> &activePresynapticCells,
+                             const bool connectedSynapses,
+                             SynapseIdx *connected,
+                             SynapseIdx *potential,
+                             std::vector<Segment> &touchedSegments) const;
+
+  // Common start of all computeActivity() overloads.
+  void prepareComputeActivity_(const bool learn);
+
+  // Marks the synapse structure (presynaptic maps) as changed, invalidates the caches.
+  void structureChanged_() {
+    compactIndexDirty_ = true;
+    incrementalDirty_  = true;
+    structureVersionDirty_ = true;
+  }
+  // @see structureVersion(), a new version is drawn lazily after changes.
+  mutable bool   structureVersionDirty_ = true;
+  mutable UInt64 structureVersion_ = 0u;
+
+  // Incremental computeActivity, @see setIncrementalActivity()
+  bool incremental_ = false;
+  bool incrementalDirty_ = true;
+  std::vector<CellIdx> incrementalActive_; //sorted active cells of the last call
+  std::vector<SynapseIdx> incrementalConnected_;
+  std::vector<SynapseIdx> incrementalPotential_; //only potential, not connected synapses. Empty if not up to date.
+  std::vector<CellIdx> turnedOn_, turnedOff_; //cells changed by the last call
+  bool incrementalRecounted_ = true; //the last call recounted everything
+  void updateIncrementalCounts_(const std::vector<CellIdx> &activePresynapticCells, const bool potential);
+
+  // Multithreaded computeActivity, @see setNumThreads()
+  UInt numThreads_ = 1u;
+  std::shared_ptr<ThreadPool> threadPool_;
+  std::vector<std::vector<SynapseIdx>> partialCounts_; //scratch, one per thread
+  std::vector<std::vector<std::pair<CellIdx, UInt>>> batchActive_; //scratch, one per thread
+
+  // scratch for adaptSegments_()
+  std::vector<Synapse> adaptFlipped_;
+  std::vector<Synapse> adaptDestroyLater_;
+  // scratch for destroyMinPermanenceSynapses()
+  std::vector<Synapse> destroyCandidates_;
+  // scratch for growSynapses(), (presynaptic cell, synapse) of the segment
+  std::vector<std::pair<CellIdx, Synapse>> growExisting_;
+  // scratch for sortSegments(), (key, segment) pairs
+  std::vector<std::pair<UInt64, Segment>> sortKeys_, sortKeysTmp_;
 
   Segment nextSegmentOrdinal_ = 0;
   Synapse nextSynapseOrdinal_ = 0;
 
-  // These three members should be used when working with highly correlated
-  // data. The vectors store the permanence changes made by adaptSegment.
+  // These members should be used when working with highly correlated
+  // data. They store the permanence changes made by adaptSegment, sparse:
+  // the updates of the previous step sorted by synapse, and those of the
+  // current step in the order they were made (the last one of a synapse
+  // counts).  A synapse without an entry had the update minPermanence.
   bool timeseries_;
+  std::vector<Synapse>    previousUpdated_;
   std::vector<Permanence> previousUpdates_;
+  std::vector<Synapse>    currentUpdated_;
   std::vector<Permanence> currentUpdates_;
+  // the update of a synapse in the previous step
+  Permanence previousUpdate_(const Synapse synapse) const;
+  void recordUpdates_(const std::vector<std::pair<Synapse, Permanence>> &updates);
+  // at the start of a step: the current updates become the previous ones
+  void rotateUpdates_();
+  std::vector<std::pair<Synapse, Permanence>> adaptUpdates_; //scratch for adaptSegments_()
+  std::vector<std::pair<UInt64, Permanence>> rotateScratch_;  //scratch for rotateUpdates_()
+
+  // Delta checkpoints, @see setDeltaTracking()
+  struct DirtySet_ {
+    std::vector<UInt8>  flag;
+    std::vector<UInt32> list;
+    void mark(const UInt32 index) {
+      if( index >= flag.size() ) flag.resize(index + 1u, 0u);
+      if( flag[index] == 0u ) {
+        flag[index] = 1u;
+        list.push_back(index);
+      }
+    }
+    void clear() {
+      for(const auto index : list) flag[index] = 0u;
+      list.clear();
+    }
+  };
+  bool deltaTracking_ = false;
+  bool allDirty_ = false; //the indexes changed, the next delta is a full copy
+  DirtySet_ dirtySegments_;
+  DirtySet_ dirtySynapses_;    //destroyed synapse slots, the others are covered by their segment
+  DirtySet_ dirtyPresynaptic_; //presynaptic cells whose presynaptic maps changed
+  DirtySet_ dirtyCells_;       //cells whose lists of segments changed
+  void markSegment_(const Segment segment) { if( deltaTracking_ ) dirtySegments_.mark(segment); }
+  void markSynapse_(const Synapse synapse) { if( deltaTracking_ ) dirtySynapses_.mark(synapse); }
+  void markPresynaptic_(const CellIdx cell) { if( deltaTracking_ ) dirtyPresynaptic_.mark(cell); }
+  void markCell_(const CellIdx cell) { if( deltaTracking_ ) dirtyCells_.mark(cell); }
+  void clearDirty_() {
+    dirtySegments_.clear();
+    dirtySynapses_.clear();
+    dirtyPresynaptic_.clear();
+    dirtyCells_.clear();
+    allDirty_ = false;
+  }
 
   //for prune statistics
   Synapse prunedSyns_ = 0; //how many synapses have been removed?
@@ -858,7 +1785,18 @@ private:
 
   //for listeners //TODO listeners are not serialized, nor included in equals ==
   UInt32 nextEventToken_;
-  std::map<UInt32, ConnectionsEventHandler *> eventHandlers_;
+  std::vector<std::pair<UInt32, ConnectionsEventHandler *>> eventHandlers_; //flat, usually empty
+
+  // Call `f(handler)` for each subscribed handler.  Compiled out with NTA_CONNECTIONS_NO_EVENTS.
+  template<typename F>
+  inline void notify_(const F &f) const {
+#ifndef NTA_CONNECTIONS_NO_EVENTS
+    if(eventHandlers_.empty()) return; //fast path, nobody listens
+    for(const auto &h : eventHandlers_) f(h.second);
+#else
+    UNUSED(f);
+#endif
+  }
 }; // end class Connections
 
 } // end namespace htm
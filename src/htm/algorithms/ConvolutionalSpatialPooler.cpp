@@ -0,0 +1,307 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of ConvolutionalSpatialPooler
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <htm/algorithms/ConvolutionalSpatialPooler.hpp>
+
+using std::vector;
+using namespace htm;
+
+
+ConvolutionalSpatialPooler::ConvolutionalSpatialPooler(
+    const vector<UInt> &inputDimensions,
+    const vector<UInt> &kernelDimensions,
+    const UInt stride,
+    const UInt numPrototypes,
+    const Real potentialPct,
+    const Real localAreaDensity,
+    const UInt stimulusThreshold,
+    const Real synPermInactiveDec,
+    const Real synPermActiveInc,
+    const Real synPermConnected,
+    const UInt dutyCyclePeriod,
+    const Real boostStrength,
+    const Int seed)
+  : inputDimensions_(inputDimensions),
+    kernelDimensions_(kernelDimensions),
+    stride_(stride),
+    numPrototypes_(numPrototypes),
+    localAreaDensity_(localAreaDensity),
+    stimulusThreshold_(stimulusThreshold),
+    synPermInactiveDec_(synPermInactiveDec),
+    synPermActiveInc_(synPermActiveInc),
+    synPermConnected_(synPermConnected),
+    dutyCyclePeriod_(dutyCyclePeriod),
+    boostStrength_(boostStrength),
+    rng_(seed) {
+  NTA_CHECK(inputDimensions_.size() == 2u or inputDimensions_.size() == 3u)
+    << "ConvolutionalSpatialPooler: input dimensions must be {height, width[, channels]}.";
+  NTA_CHECK(kernelDimensions_.size() == 2u)
+    << "ConvolutionalSpatialPooler: kernel dimensions must be {height, width}.";
+  NTA_CHECK(potentialPct > 0.0f and potentialPct <= 1.0f);
+  NTA_CHECK(localAreaDensity > 0.0f and localAreaDensity <= 0.5f);
+  NTA_CHECK(dutyCyclePeriod > 0u);
+
+  const UInt channels = inputDimensions_.size() == 3u ? inputDimensions_[2] : 1u;
+  const UInt area = kernelDimensions_[0] * kernelDimensions_[1] * channels;
+  const UInt numPotential = std::max(1u, static_cast<UInt>(std::round(potentialPct * area)));
+  vector<UInt> kernel(area);
+  std::iota(kernel.begin(), kernel.end(), 0u);
+  vector<UInt> pool;
+  prototypeOffsets_.push_back(0u);
+  for(UInt p = 0u; p < numPrototypes_; p++) {
+    rng_.sample(kernel, numPotential, pool);
+    std::sort(pool.begin(), pool.end());
+    for(const auto k : pool) {
+      kernelIndex_.push_back(k);
+      // Same as SpatialPooler::initSynapses_, half of them start connected.
+      permanences_.push_back(rng_.getReal64() <= 0.5 ? rng_.realRange(synPermConnected_, maxPermanence)
+                                                    : rng_.realRange(minPermanence, synPermConnected_));
+    }
+    prototypeOffsets_.push_back(static_cast<UInt>(kernelIndex_.size()));
+  }
+  activeDutyCycles_.assign(numPrototypes_, 0.0f);
+  boostFactors_.assign(numPrototypes_, 1.0f);
+
+  initialize_();
+}
+
+
+void ConvolutionalSpatialPooler::initialize_() {
+  NTA_CHECK(inputDimensions_.size() == 2u or inputDimensions_.size() == 3u);
+  NTA_CHECK(kernelDimensions_.size() == 2u);
+  NTA_CHECK(stride_ > 0u) << "ConvolutionalSpatialPooler: stride must be positive.";
+  NTA_CHECK(numPrototypes_ > 0u);
+  const UInt height = inputDimensions_[0];
+  const UInt width  = inputDimensions_[1];
+  const UInt channels = inputDimensions_.size() == 3u ? inputDimensions_[2] : 1u;
+  const UInt kh = kernelDimensions_[0];
+  const UInt kw = kernelDimensions_[1];
+  NTA_CHECK(kh > 0u and kw > 0u and kh <= height and kw <= width)
+    << "ConvolutionalSpatialPooler: the kernel must fit in the input.";
+
+  columnDimensions_ = { (height - kh) / stride_ + 1u, (width - kw) / stride_ + 1u, numPrototypes_ };
+  numInputs_  = height * width * channels;
+  numColumns_ = columnDimensions_[0] * columnDimensions_[1] * numPrototypes_;
+  channels_   = channels;
+  kernelArea_ = kh * kw * channels;
+  NTA_CHECK(prototypeOffsets_.size() == numPrototypes_ + 1u);
+  NTA_CHECK(kernelIndex_.size() == permanences_.size());
+  NTA_CHECK(activeDutyCycles_.size() == numPrototypes_ and boostFactors_.size() == numPrototypes_);
+
+  kernelInputOffset_.resize(kernelArea_);
+  for(UInt ky = 0u; ky < kh; ky++) {
+    for(UInt kx = 0u; kx < kw; kx++) {
+      for(UInt c = 0u; c < channels; c++) {
+        kernelInputOffset_[(ky * kw + kx) * channels + c] = (ky * width + kx) * channels + c;
+      }
+    }
+  }
+  rebuildConnected_();
+}
+
+
+void ConvolutionalSpatialPooler::rebuildConnected_() {
+  connectedOffsets_.assign(kernelArea_ + 1u, 0u);
+  for(size_t i = 0u; i < permanences_.size(); i++) {
+    if( permanences_[i] >= synPermConnected_ - htm::Epsilon ) {
+      connectedOffsets_[kernelIndex_[i] + 1u]++;
+    }
+  }
+  std::partial_sum(connectedOffsets_.begin(), connectedOffsets_.end(), connectedOffsets_.begin());
+  connectedPrototypes_.resize(connectedOffsets_.back());
+  vector<UInt> next(connectedOffsets_.begin(), connectedOffsets_.end() - 1);
+  for(UInt p = 0u; p < numPrototypes_; p++) {
+    for(UInt i = prototypeOffsets_[p]; i < prototypeOffsets_[p + 1u]; i++) {
+      if( permanences_[i] >= synPermConnected_ - htm::Epsilon ) {
+        connectedPrototypes_[next[kernelIndex_[i]]++] = p;
+      }
+    }
+  }
+}
+
+
+void ConvolutionalSpatialPooler::compute(const SDR &input, const bool learn, SDR &active) {
+  input.reshape( inputDimensions_ );
+  active.reshape( columnDimensions_ );
+  if( learn ) iteration_++;
+
+  calculateOverlaps_(input);
+
+  vector<Real> boosted(numColumns_);
+  for(UInt column = 0u; column < numColumns_; column++) {
+    boosted[column] = overlaps_[column] * boostFactors_[column % numPrototypes_];
+  }
+
+  vector<UInt> activeColumns;
+  inhibitColumns_(boosted, activeColumns);
+  std::sort(activeColumns.begin(), activeColumns.end());
+
+  if( learn ) {
+    adaptPrototypes_(input, activeColumns);
+    updateDutyCyclesAndBoost_(activeColumns);
+  }
+  active.setSparse(activeColumns);
+}
+
+
+/**
+ * Each active input bit (y, x, c) is at kernel offset (y - oy * stride,
+ * x - ox * stride, c) of every position (oy, ox) whose window covers it; the
+ * prototypes connected at that offset get one more overlap at that position.
+ */
+void ConvolutionalSpatialPooler::calculateOverlaps_(const SDR &input) {
+  const UInt width    = inputDimensions_[1];
+  const UInt channels = channels_;
+  const UInt kh = kernelDimensions_[0];
+  const UInt kw = kernelDimensions_[1];
+  const UInt outHeight = columnDimensions_[0];
+  const UInt outWidth  = columnDimensions_[1];
+
+  overlaps_.assign(numColumns_, 0u);
+  for(const auto bit : input.getSparse()) {
+    const UInt c = bit % channels;
+    const UInt x = (bit / channels) % width;
+    const UInt y = bit / (channels * width);
+    // positions with oy * stride <= y < oy * stride + kh
+    const UInt oyBegin = y + 1u > kh ? (y + 1u - kh + stride_ - 1u) / stride_ : 0u;
+    const UInt oyEnd   = std::min(outHeight, y / stride_ + 1u);
+    const UInt oxBegin = x + 1u > kw ? (x + 1u - kw + stride_ - 1u) / stride_ : 0u;
+    const UInt oxEnd   = std::min(outWidth, x / stride_ + 1u);
+    for(UInt oy = oyBegin; oy < oyEnd; oy++) {
+      for(UInt ox = oxBegin; ox < oxEnd; ox++) {
+        const UInt k = ((y - oy * stride_) * kw + (x - ox * stride_)) * channels + c;
+        SynapseIdx *out = overlaps_.data() + (oy * outWidth + ox) * numPrototypes_;
+        const UInt stop = connectedOffsets_[k + 1u];
+        for(UInt i = connectedOffsets_[k]; i < stop; i++) {
+          out[connectedPrototypes_[i]]++;
+        }
+      }
+    }
+  }
+}
+
+
+// Same as SpatialPooler::inhibitColumnsGlobal_
+void ConvolutionalSpatialPooler::inhibitColumns_(const vector<Real> &overlaps,
+                                                 vector<UInt> &activeColumns) const {
+  const UInt numDesired = (UInt)(localAreaDensity_ * numColumns_);
+  NTA_CHECK(numDesired > 0) << "Not enough columns (" << numColumns_ << ") "
+                            << "for desired density (" << localAreaDensity_ << ").";
+  activeColumns.resize(numColumns_);
+  std::iota(activeColumns.begin(), activeColumns.end(), 0u);
+  std::nth_element(activeColumns.begin(), activeColumns.begin() + numDesired, activeColumns.end(),
+    [&overlaps](const UInt a, const UInt b) {
+      return (overlaps[a] == overlaps[b]) ? a > b : overlaps[a] > overlaps[b]; });
+  activeColumns.resize(numDesired);
+  // Remove sub-threshold winners
+  activeColumns.erase(std::remove_if(activeColumns.begin(), activeColumns.end(),
+    [&](const UInt c) { return overlaps[c] < stimulusThreshold_; }), activeColumns.end());
+}
+
+
+/**
+ * The update of a prototype is the mean of the SpatialPooler's update over
+ * the positions where it is active, so its learning rate does not depend on
+ * how often it wins within one image.
+ */
+void ConvolutionalSpatialPooler::adaptPrototypes_(const SDR &input, const vector<UInt> &activeColumns) {
+  const auto &dense   = input.getDense();
+  const UInt width    = inputDimensions_[1];
+  const UInt channels = channels_;
+  const UInt outWidth = columnDimensions_[1];
+
+  vector<Real> delta(permanences_.size(), 0.0f);
+  vector<UInt> numPositions(numPrototypes_, 0u);
+  for(const auto column : activeColumns) {
+    const UInt p = column % numPrototypes_;
+    const UInt position = column / numPrototypes_;
+    const UInt corner = ((position / outWidth) * stride_ * width + (position % outWidth) * stride_) * channels;
+    numPositions[p]++;
+    for(UInt i = prototypeOffsets_[p]; i < prototypeOffsets_[p + 1u]; i++) {
+      delta[i] += dense[corner + kernelInputOffset_[kernelIndex_[i]]] ? synPermActiveInc_ : -synPermInactiveDec_;
+    }
+  }
+
+  for(UInt p = 0u; p < numPrototypes_; p++) {
+    if( numPositions[p] == 0u ) continue;
+    for(UInt i = prototypeOffsets_[p]; i < prototypeOffsets_[p + 1u]; i++) {
+      const Real perm = permanences_[i] + delta[i] / numPositions[p];
+      permanences_[i] = std::min(maxPermanence, std::max(minPermanence, perm));
+    }
+  }
+  rebuildConnected_();
+}
+
+
+void ConvolutionalSpatialPooler::updateDutyCyclesAndBoost_(const vector<UInt> &activeColumns) {
+  const UInt period = std::min(dutyCyclePeriod_, iteration_);
+  const UInt numPositions = columnDimensions_[0] * columnDimensions_[1];
+  vector<UInt> count(numPrototypes_, 0u);
+  for(const auto column : activeColumns) {
+    count[column % numPrototypes_]++;
+  }
+  // Exponential moving average of the fraction of the positions where each
+  // prototype is active, @see SpatialPooler::updateDutyCyclesHelper_
+  for(UInt p = 0u; p < numPrototypes_; p++) {
+    const Real value = static_cast<Real>(count[p]) / numPositions;
+    activeDutyCycles_[p] = (activeDutyCycles_[p] * (period - 1) + value) / period;
+  }
+
+  if( boostStrength_ < htm::Epsilon ) return; //skip for disabled boosting
+  for(UInt p = 0u; p < numPrototypes_; p++) {
+    boostFactors_[p] = std::exp((localAreaDensity_ - activeDutyCycles_[p]) * boostStrength_);
+  }
+}
+
+
+void ConvolutionalSpatialPooler::getPermanence(const UInt prototype, vector<Real> &permanences) const {
+  NTA_CHECK(prototype < numPrototypes_) << "Invalid prototype " << prototype;
+  permanences.assign(kernelArea_, 0.0f);
+  for(UInt i = prototypeOffsets_[prototype]; i < prototypeOffsets_[prototype + 1u]; i++) {
+    permanences[kernelIndex_[i]] = permanences_[i];
+  }
+}
+
+
+bool ConvolutionalSpatialPooler::operator==(const ConvolutionalSpatialPooler &o) const {
+  return inputDimensions_    == o.inputDimensions_    and
+         kernelDimensions_   == o.kernelDimensions_   and
+         stride_             == o.stride_             and
+         numPrototypes_      == o.numPrototypes_      and
+         localAreaDensity_   == o.localAreaDensity_   and
+         stimulusThreshold_  == o.stimulusThreshold_  and
+         synPermInactiveDec_ == o.synPermInactiveDec_ and
+         synPermActiveInc_   == o.synPermActiveInc_   and
+         synPermConnected_   == o.synPermConnected_   and
+         dutyCyclePeriod_    == o.dutyCyclePeriod_    and
+         boostStrength_      == o.boostStrength_      and
+         iteration_          == o.iteration_          and
+         prototypeOffsets_   == o.prototypeOffsets_   and
+         kernelIndex_        == o.kernelIndex_        and
+         permanences_        == o.permanences_        and
+         activeDutyCycles_   == o.activeDutyCycles_   and
+         boostFactors_       == o.boostFactors_       and
+         rng_                == o.rng_;
+}
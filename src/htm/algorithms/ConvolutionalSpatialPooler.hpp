@@ -0,0 +1,227 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ConvolutionalSpatialPooler class in C++
+ */
+
+#ifndef NTA_CONVOLUTIONAL_SPATIAL_POOLER_HPP
+#define NTA_CONVOLUTIONAL_SPATIAL_POOLER_HPP
+
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace htm {
+
+/**
+ * ConvolutionalSpatialPooler - a spatial pooler whose columns share their
+ * synapses across the positions of an image (weight sharing).
+ *
+ * @b Description
+ * The input is an image of dimensions {height, width} or {height, width,
+ * channels}.  A kernel of {kernelHeight, kernelWidth} slides over it with
+ * the given stride, and at every position there is one column per
+ * prototype, so the column dimensions are {outHeight, outWidth,
+ * numPrototypes}.  All columns of a prototype use the same potential pool
+ * and permanences, relative to their position: the model stores
+ * numPrototypes x kernel area synapses, instead of one potential pool per
+ * column like the SpatialPooler.
+ *
+ * Overlaps are computed from the active input bits: each one is looked up in
+ * the connected synapses of the kernel offsets it falls on, at every
+ * position whose window covers it.
+ *
+ * Learning adapts each prototype once per compute, by the mean of the
+ * SpatialPooler's Hebbian update (synPermActiveInc / synPermInactiveDec) over
+ * the positions where it won.  Boosting is per prototype, from the fraction
+ * of the positions where it is active.  Inhibition is global.
+ */
+class ConvolutionalSpatialPooler : public Serializable
+{
+public:
+  ConvolutionalSpatialPooler() {}
+
+  /**
+   * @param inputDimensions {height, width} or {height, width, channels}.
+   * @param kernelDimensions {height, width} of the receptive field.
+   * @param stride Step of the kernel, in pixels, along both axes.
+   * @param numPrototypes Number of columns (shared synapse sets) per position.
+   * @param potentialPct Fraction of the kernel in the potential pool of a prototype.
+   * @param localAreaDensity Fraction of the columns which are active.
+   * @param stimulusThreshold Minimum overlap of an active column.
+   * @param synPermInactiveDec Permanence decrement for inactive inputs.
+   * @param synPermActiveInc Permanence increment for active inputs.
+   * @param synPermConnected Connected permanence threshold.
+   * @param dutyCyclePeriod Period of the duty cycle moving averages.
+   * @param boostStrength Boosting of the prototypes, 0 to disable.
+   * @param seed Seed of the random generator.
+   */
+  ConvolutionalSpatialPooler(const std::vector<UInt> &inputDimensions,
+                             const std::vector<UInt> &kernelDimensions,
+                             UInt stride = 1u,
+                             UInt numPrototypes = 32u,
+                             Real potentialPct = 0.5f,
+                             Real localAreaDensity = 0.05f,
+                             UInt stimulusThreshold = 0u,
+                             Real synPermInactiveDec = 0.008f,
+                             Real synPermActiveInc = 0.05f,
+                             Real synPermConnected = 0.1f,
+                             UInt dutyCyclePeriod = 1000u,
+                             Real boostStrength = 0.0f,
+                             Int seed = 1);
+
+  virtual ~ConvolutionalSpatialPooler() {}
+
+  /**
+   * @param input SDR with the input dimensions.
+   * @param learn Adapt the prototypes and the boost factors.
+   * @param active Output, the active columns.
+   */
+  void compute(const SDR &input, bool learn, SDR &active);
+
+  const std::vector<UInt> &getInputDimensions() const noexcept { return inputDimensions_; }
+  const std::vector<UInt> &getColumnDimensions() const noexcept { return columnDimensions_; }
+  UInt getNumInputs() const noexcept { return numInputs_; }
+  UInt getNumColumns() const noexcept { return numColumns_; }
+  UInt getNumPrototypes() const noexcept { return numPrototypes_; }
+
+  /**
+   * @returns the number of (shared) synapses, of all the prototypes.
+   */
+  size_t numSynapses() const noexcept { return permanences_.size(); }
+
+  /**
+   * @param prototype Prototype index.
+   * @param permanences Output, the permanences of the prototype over the
+   * kernel {kernelHeight, kernelWidth, channels}, 0 outside the potential pool.
+   */
+  void getPermanence(UInt prototype, std::vector<Real> &permanences) const;
+
+  /**
+   * @returns the overlaps of the columns in the last compute, before boosting.
+   */
+  const std::vector<SynapseIdx> &getOverlaps() const noexcept { return overlaps_; }
+
+  const std::vector<Real> &getBoostFactors() const noexcept { return boostFactors_; }
+  const std::vector<Real> &getActiveDutyCycles() const noexcept { return activeDutyCycles_; }
+
+  bool operator==(const ConvolutionalSpatialPooler &other) const;
+  inline bool operator!=(const ConvolutionalSpatialPooler &other) const { return !operator==(other); }
+
+  // Serialization
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(inputDimensions_),
+       CEREAL_NVP(kernelDimensions_),
+       CEREAL_NVP(stride_),
+       CEREAL_NVP(numPrototypes_),
+       CEREAL_NVP(localAreaDensity_),
+       CEREAL_NVP(stimulusThreshold_),
+       CEREAL_NVP(synPermInactiveDec_),
+       CEREAL_NVP(synPermActiveInc_),
+       CEREAL_NVP(synPermConnected_),
+       CEREAL_NVP(dutyCyclePeriod_),
+       CEREAL_NVP(boostStrength_),
+       CEREAL_NVP(iteration_),
+       CEREAL_NVP(prototypeOffsets_),
+       CEREAL_NVP(kernelIndex_),
+       CEREAL_NVP(permanences_),
+       CEREAL_NVP(activeDutyCycles_),
+       CEREAL_NVP(boostFactors_),
+       CEREAL_NVP(rng_));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(CEREAL_NVP(inputDimensions_),
+       CEREAL_NVP(kernelDimensions_),
+       CEREAL_NVP(stride_),
+       CEREAL_NVP(numPrototypes_),
+       CEREAL_NVP(localAreaDensity_),
+       CEREAL_NVP(stimulusThreshold_),
+       CEREAL_NVP(synPermInactiveDec_),
+       CEREAL_NVP(synPermActiveInc_),
+       CEREAL_NVP(synPermConnected_),
+       CEREAL_NVP(dutyCyclePeriod_),
+       CEREAL_NVP(boostStrength_),
+       CEREAL_NVP(iteration_),
+       CEREAL_NVP(prototypeOffsets_),
+       CEREAL_NVP(kernelIndex_),
+       CEREAL_NVP(permanences_),
+       CEREAL_NVP(activeDutyCycles_),
+       CEREAL_NVP(boostFactors_),
+       CEREAL_NVP(rng_));
+    initialize_();
+  }
+
+private:
+  // Derived state, not serialized: the geometry & the connected synapses.
+  void initialize_();
+  void rebuildConnected_();
+
+  void calculateOverlaps_(const SDR &input);
+  void inhibitColumns_(const std::vector<Real> &overlaps, std::vector<UInt> &active) const;
+  void adaptPrototypes_(const SDR &input, const std::vector<UInt> &active);
+  void updateDutyCyclesAndBoost_(const std::vector<UInt> &active);
+
+  std::vector<UInt> inputDimensions_;  //{height, width[, channels]}
+  std::vector<UInt> kernelDimensions_; //{height, width}
+  UInt stride_ = 1u;
+  UInt numPrototypes_ = 0u;
+  Real localAreaDensity_ = 0.0f;
+  UInt stimulusThreshold_ = 0u;
+  Real synPermInactiveDec_ = 0.0f;
+  Real synPermActiveInc_ = 0.0f;
+  Real synPermConnected_ = 0.0f;
+  UInt dutyCyclePeriod_ = 1u;
+  Real boostStrength_ = 0.0f;
+  UInt iteration_ = 0u;
+
+  // potential pools: the synapses of prototype p are
+  // [ prototypeOffsets_[p] .. prototypeOffsets_[p+1] ), each one at kernel
+  // offset kernelIndex_[i] = (ky * kernelWidth + kx) * channels + c.
+  std::vector<UInt> prototypeOffsets_;
+  std::vector<UInt> kernelIndex_;
+  std::vector<Real> permanences_;
+
+  std::vector<Real> activeDutyCycles_; //per prototype
+  std::vector<Real> boostFactors_;     //per prototype
+
+  Random rng_;
+
+  // derived
+  std::vector<UInt> columnDimensions_; //{outHeight, outWidth, numPrototypes}
+  UInt numInputs_ = 0u;
+  UInt numColumns_ = 0u;
+  UInt channels_ = 1u;
+  UInt kernelArea_ = 0u;               //kernel height * width * channels
+  std::vector<UInt> kernelInputOffset_; //kernel offset -> input offset from the window corner
+  // connected synapses: the prototypes connected at kernel offset k are
+  // connectedPrototypes_[ connectedOffsets_[k] .. connectedOffsets_[k+1] )
+  std::vector<UInt> connectedOffsets_;
+  std::vector<UInt> connectedPrototypes_;
+  std::vector<SynapseIdx> overlaps_;
+};
+
+} // end namespace htm
+
+#endif // NTA_CONVOLUTIONAL_SPATIAL_POOLER_HPP
@@ -0,0 +1,192 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of EdgeExporter
+ */
+
+#include <limits>
+#include <numeric>
+
+#include <htm/algorithms/EdgeExporter.hpp>
+#include <htm/algorithms/FrozenSpatialPooler.hpp>
+#include <htm/edge/EdgeRuntime.hpp>
+#include <htm/utils/FlatArchive.hpp>
+
+using std::vector;
+using namespace htm;
+
+
+EdgeExporter::EdgeExporter(const SpatialPooler *sp, const TemporalMemory *tm, const Classifier *classifier)
+  : sp_(sp), tm_(tm), classifier_(classifier) {
+  NTA_CHECK(sp != nullptr or tm != nullptr or classifier != nullptr) << "EdgeExporter: nothing to export.";
+}
+
+
+void EdgeExporter::save(const std::string &path) const {
+  FlatWriter out(path, edge::MODEL_TAG, edge::MODEL_VERSION);
+  save_(out);
+  out.close();
+}
+
+
+void EdgeExporter::save(vector<char> &buffer) const {
+  buffer.clear();
+  FlatWriter out(buffer, edge::MODEL_TAG, edge::MODEL_VERSION);
+  save_(out);
+}
+
+
+void EdgeExporter::save_(FlatWriter &out) const {
+  static_assert(edge::MODEL_BYTE_ORDER == FLAT_BYTE_ORDER and edge::MODEL_ALIGNMENT == FLAT_ALIGNMENT,
+                "EdgeExporter: the runtime reads flat archives");
+  // The stages must fit together, as edge::Model::load checks.
+  if( sp_ != nullptr and tm_ != nullptr ) {
+    NTA_CHECK(sp_->getNumColumns() == tm_->numberOfColumns())
+      << "EdgeExporter: the SP has " << sp_->getNumColumns() << " columns, the TM " << tm_->numberOfColumns();
+  }
+  if( classifier_ != nullptr and (sp_ != nullptr or tm_ != nullptr) ) {
+    const size_t inputs = tm_ != nullptr ? tm_->numberOfCells() : sp_->getNumColumns();
+    NTA_CHECK(classifier_->dimensions_ == inputs)
+      << "EdgeExporter: the classifier has " << classifier_->dimensions_ << " inputs, expected " << inputs;
+  }
+
+  UInt32 flags = 0u;
+  if( sp_ != nullptr )         flags |= edge::HAS_SPATIAL_POOLER;
+  if( tm_ != nullptr )         flags |= edge::HAS_TEMPORAL_MEMORY;
+  if( classifier_ != nullptr ) flags |= edge::HAS_CLASSIFIER;
+  out.scalar(flags);
+  if( sp_ != nullptr )         saveSpatialPooler_(out);
+  if( tm_ != nullptr )         saveTemporalMemory_(out);
+  if( classifier_ != nullptr ) saveClassifier_(out);
+}
+
+
+void EdgeExporter::saveSpatialPooler_(FlatWriter &out) const {
+  const FrozenSpatialPooler frozen(*sp_);
+  const UInt numDesired = static_cast<UInt>(frozen.density_ * frozen.numColumns_);
+  NTA_CHECK(not frozen.globalInhibition_ or numDesired > 0u)
+    << "EdgeExporter: not enough columns (" << frozen.numColumns_ << ") for the density " << frozen.density_;
+  out.scalar(static_cast<UInt32>(frozen.numInputs_));
+  out.scalar(static_cast<UInt32>(frozen.numColumns_));
+  out.scalar(static_cast<UInt32>(frozen.stimulusThreshold_));
+  out.scalar(static_cast<UInt32>(frozen.globalInhibition_));
+  out.scalar(static_cast<UInt32>(numDesired));
+  out.array(frozen.inputOffsets_);
+  out.array(frozen.inputColumns_);
+  out.array(frozen.boostFactors_);
+
+  // The local inhibition: the neighborhoods and how many of them win, @see
+  // FrozenSpatialPooler::inhibitColumnsLocal_
+  vector<UInt> neighborOffsets, neighbors, numActive;
+  if( not frozen.globalInhibition_ ) {
+    neighborOffsets.reserve(frozen.numColumns_ + 1u);
+    neighborOffsets.push_back(0u);
+    numActive.reserve(frozen.numColumns_);
+    for(UInt column = 0u; column < frozen.numColumns_; column++) {
+      frozen.neighborhood_.appendNeighbors(column, neighbors);
+      const UInt size = static_cast<UInt>(neighbors.size()) - neighborOffsets.back();
+      const UInt numNeighbors = frozen.wrapAround_ ? frozen.numNeighborsWrap_ : size - 1u;
+      numActive.push_back(static_cast<UInt>(0.5f + (frozen.density_ * (numNeighbors + 1))));
+      neighborOffsets.push_back(static_cast<UInt>(neighbors.size()));
+    }
+  }
+  out.array(neighborOffsets);
+  out.array(neighbors);
+  out.array(numActive);
+}
+
+
+void EdgeExporter::saveTemporalMemory_(FlatWriter &out) const {
+  const TemporalMemory &tm = *tm_;
+  NTA_CHECK(tm.externalPredictiveInputs_ == 0u)
+    << "EdgeExporter: the external predictive inputs of the TM are not supported.";
+  NTA_CHECK(tm.activationThreshold_ > 0u) << "EdgeExporter: the TM activation threshold must be positive.";
+  const Connections &connections = tm.connections_;
+  const Permanence threshold = connections.getConnectedThreshold();
+  const CellIdx numCells = static_cast<CellIdx>(tm.numberOfCells());
+
+  // Keep the segments which can become active, numbered in the order of their cells.
+  vector<UInt> segmentCells;
+  vector<UInt> offsets(numCells + 1u, 0u);
+  const auto connectedSynapses = [&](const Segment segment, vector<CellIdx> &presynaptic) {
+    presynaptic.clear();
+    for(const auto syn : connections.synapsesForSegment(segment)) {
+      if( connections.permanenceForSynapse(syn) >= threshold ) {
+        presynaptic.push_back(connections.presynapticCellForSynapse(syn));
+      }
+    }
+    return presynaptic.size() >= tm.activationThreshold_;
+  };
+  vector<CellIdx> presynaptic;
+  for(CellIdx cell = 0u; cell < numCells; cell++) {
+    for(const auto segment : connections.segmentsForCell(cell)) {
+      if( not connectedSynapses(segment, presynaptic) ) continue;
+      NTA_CHECK(presynaptic.size() <= std::numeric_limits<UInt16>::max())
+        << "EdgeExporter: too many synapses on a segment.";
+      segmentCells.push_back(cell);
+      for(const auto presyn : presynaptic) offsets[presyn + 1u]++;
+    }
+  }
+  std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  // Invert into presynaptic cell -> segments.
+  vector<UInt> cellSegments(offsets.back());
+  vector<UInt> next(offsets.begin(), offsets.end() - 1);
+  UInt index = 0u;
+  for(CellIdx cell = 0u; cell < numCells; cell++) {
+    for(const auto segment : connections.segmentsForCell(cell)) {
+      if( not connectedSynapses(segment, presynaptic) ) continue;
+      for(const auto presyn : presynaptic) cellSegments[next[presyn]++] = index;
+      index++;
+    }
+  }
+
+  out.scalar(static_cast<UInt32>(tm.numberOfColumns()));
+  out.scalar(static_cast<UInt32>(tm.getCellsPerColumn()));
+  out.scalar(static_cast<UInt32>(tm.activationThreshold_));
+  out.scalar(static_cast<UInt32>(segmentCells.size()));
+  out.array(offsets);
+  out.array(cellSegments);
+  out.array(segmentCells);
+}
+
+
+void EdgeExporter::saveClassifier_(FlatWriter &out) const {
+  const Classifier &cls = *classifier_;
+  NTA_CHECK(cls.dimensions_ > 0u and cls.numCategories_ > 0u)
+    << "EdgeExporter: the classifier has not learned.";
+  // Only the rows with a weight, the rest infer nothing.
+  vector<UInt> rowOf(cls.dimensions_, edge::NO_ROW);
+  vector<Real32> weights;
+  UInt numRows = 0u;
+  for(UInt bit = 0u; bit < cls.dimensions_; bit++) {
+    bool learned = false;
+    for(UInt category = 0u; category < cls.numCategories_ and not learned; category++) {
+      learned = cls.weightOf_(bit, category) != 0.0;
+    }
+    if( not learned ) continue;
+    rowOf[bit] = numRows++;
+    for(UInt category = 0u; category < cls.numCategories_; category++) {
+      weights.push_back(static_cast<Real32>(cls.weightOf_(bit, category)));
+    }
+  }
+  out.scalar(static_cast<UInt32>(cls.dimensions_));
+  out.scalar(static_cast<UInt32>(cls.numCategories_));
+  out.array(rowOf);
+  out.array(weights);
+}
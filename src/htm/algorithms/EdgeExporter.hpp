@@ -0,0 +1,85 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the EdgeExporter class in C++
+ */
+
+#ifndef NTA_EDGE_EXPORTER_HPP
+#define NTA_EDGE_EXPORTER_HPP
+
+#include <string>
+#include <vector>
+
+#include <htm/algorithms/SDRClassifier.hpp>
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+
+namespace htm {
+
+class FlatWriter;
+
+/**
+ * EdgeExporter - exports trained models to the embeddable inference
+ * runtime, @see htm/edge/EdgeRuntime.hpp.
+ *
+ * @b Description
+ * The model is a pipeline SpatialPooler -> TemporalMemory -> Classifier,
+ * any of which may be missing, reduced to what inference needs and written
+ * as one compact flat archive of 32 bit words:
+ *  - the SpatialPooler as its FrozenSpatialPooler: the connected synapses
+ *    from each input to its columns, the boost factors, and for the local
+ *    inhibition the neighborhood and the number of winners of each column,
+ *  - the TemporalMemory as the connected synapses from each cell to the
+ *    segments; segments which can never become active (less connected
+ *    synapses than the activation threshold) are dropped,
+ *  - the Classifier as the rows of the input bits it has learned, in
+ *    single precision.
+ * The archive is read in place by edge::Model::load, eg. from flash.
+ *
+ * Not supported: external predictive inputs of the TemporalMemory, an
+ * activation threshold of 0.  The anomaly of the runtime is always the raw
+ * anomaly, whatever the anomaly mode of the TemporalMemory.
+ */
+class EdgeExporter {
+public:
+  /**
+   * @param sp, tm, classifier The stages, nullptr if missing.  They must
+   *        outlive the exporter, which exports their state at save().
+   *        The classifier reads the active cells of the tm, or else the
+   *        active columns of the sp.
+   */
+  EdgeExporter(const SpatialPooler *sp, const TemporalMemory *tm = nullptr,
+               const Classifier *classifier = nullptr);
+
+  void save(const std::string &path) const;
+  void save(std::vector<char> &buffer) const;
+
+private:
+  void save_(FlatWriter &out) const;
+  void saveSpatialPooler_(FlatWriter &out) const;
+  void saveTemporalMemory_(FlatWriter &out) const;
+  void saveClassifier_(FlatWriter &out) const;
+
+  const SpatialPooler *sp_;
+  const TemporalMemory *tm_;
+  const Classifier *classifier_;
+};
+
+} // end namespace htm
+
+#endif // NTA_EDGE_EXPORTER_HPP
@@ -0,0 +1,280 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of FrozenSpatialPooler
+ */
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <numeric>
+
+#include <htm/algorithms/FrozenSpatialPooler.hpp>
+#include <htm/utils/Topology.hpp>
+
+using std::vector;
+using namespace htm;
+
+
+FrozenSpatialPooler::FrozenSpatialPooler(const SpatialPooler &sp) {
+  inputDimensions_   = sp.inputDimensions_;
+  columnDimensions_  = sp.columnDimensions_;
+  stimulusThreshold_ = sp.stimulusThreshold_;
+  density_           = sp.inhibitionDensity_();
+  globalInhibition_  = sp.isGlobalInhibition_();
+  inhibitionRadius_  = sp.inhibitionRadius_;
+  wrapAround_        = sp.wrapAround_;
+  if( sp.boostStrength_ >= htm::Epsilon ) { //otherwise the SP does not boost
+    boostFactors_ = sp.boostFactors_;
+  }
+
+  // Invert the connected synapses of the columns into input -> columns.
+  const Connections &connections = sp.connections_;
+  const Permanence threshold = connections.getConnectedThreshold();
+  inputOffsets_.assign(sp.numInputs_ + 1u, 0u);
+  for(UInt column = 0; column < sp.numColumns_; column++) {
+    for(const auto syn : connections.synapsesForSegment(column)) {
+      if( connections.permanenceForSynapse(syn) >= threshold ) {
+        inputOffsets_[connections.presynapticCellForSynapse(syn) + 1u]++;
+      }
+    }
+  }
+  std::partial_sum(inputOffsets_.begin(), inputOffsets_.end(), inputOffsets_.begin());
+  inputColumns_.resize(inputOffsets_.back());
+  vector<UInt> next(inputOffsets_.begin(), inputOffsets_.end() - 1);
+  for(UInt column = 0; column < sp.numColumns_; column++) {
+    for(const auto syn : connections.synapsesForSegment(column)) {
+      if( connections.permanenceForSynapse(syn) >= threshold ) {
+        inputColumns_[next[connections.presynapticCellForSynapse(syn)]++] = column;
+      }
+    }
+  }
+
+  initialize_();
+}
+
+
+void FrozenSpatialPooler::initialize_() {
+  numInputs_  = 1u;
+  for(const auto dim : inputDimensions_)  numInputs_  *= dim;
+  numColumns_ = 1u;
+  for(const auto dim : columnDimensions_) numColumns_ *= dim;
+  NTA_CHECK(inputOffsets_.size() == numInputs_ + 1u);
+  NTA_CHECK(boostFactors_.empty() or boostFactors_.size() == numColumns_);
+
+  neighborOffsets_.clear();
+  neighbors_.clear();
+  if( globalInhibition_ ) return;
+  neighborhood_ = NeighborhoodTable(inhibitionRadius_, columnDimensions_, wrapAround_);
+
+  // In wrapAround, number of neighbors is solely a function of the
+  // inhibition radius and the dimensions, @see SpatialPooler::inhibitColumnsLocal_
+  const UInt diam = 2 * inhibitionRadius_ + 1;
+  size_t area = 1u;
+  for(const auto dim : columnDimensions_) {
+    area *= std::min(diam, dim);
+  }
+  numNeighborsWrap_ = static_cast<UInt>(area) - 1u;
+  if( area * numColumns_ > SpatialPooler::MAX_NEIGHBOR_TABLE ) {
+    return; //too large, enumerated per column in compute
+  }
+
+  neighborOffsets_.reserve(numColumns_ + 1u);
+  neighborOffsets_.push_back(0u);
+  for(UInt column = 0; column < numColumns_; column++) {
+    neighborhood_.appendNeighbors(column, neighbors_);
+    neighborOffsets_.push_back(static_cast<UInt>(neighbors_.size()));
+  }
+}
+
+
+void FrozenSpatialPooler::compute(const SDR &input, SDR &active) const {
+  Scratch scratch;
+  compute(input, active, scratch);
+}
+
+
+void FrozenSpatialPooler::compute(const SDR &input, SDR &active, Scratch &scratch) const {
+  input.reshape(  inputDimensions_ );
+  active.reshape( columnDimensions_ );
+
+  auto &overlaps = scratch.overlaps;
+  overlaps.assign(numColumns_, 0u);
+  for(const auto bit : input.getSparse()) {
+    const auto stop = inputOffsets_[bit + 1u];
+    for(auto i = inputOffsets_[bit]; i < stop; i++) {
+      overlaps[inputColumns_[i]]++;
+    }
+  }
+
+  auto &boosted = scratch.boosted;
+  boosted.resize(numColumns_);
+  if( boostFactors_.empty() ) {
+    std::copy(overlaps.begin(), overlaps.end(), boosted.begin());
+  } else {
+    for(UInt i = 0; i < numColumns_; i++) {
+      boosted[i] = overlaps[i] * boostFactors_[i];
+    }
+  }
+
+  auto &activeColumns = scratch.active;
+  activeColumns.clear();
+  if( globalInhibition_ ) {
+    inhibitColumnsGlobal_(boosted, activeColumns);
+  } else {
+    inhibitColumnsLocal_(boosted, activeColumns, scratch);
+  }
+  std::sort(activeColumns.begin(), activeColumns.end());
+  active.setSparse(activeColumns);
+}
+
+
+void FrozenSpatialPooler::inhibitColumnsGlobal_(const vector<Real> &overlaps,
+                                                vector<UInt> &activeColumns) const {
+  const UInt numDesired = (UInt)(density_ * numColumns_);
+  NTA_CHECK(numDesired > 0) << "Not enough columns (" << numColumns_ << ") "
+                            << "for desired density (" << density_ << ").";
+  activeColumns.resize(numColumns_);
+  std::iota(activeColumns.begin(), activeColumns.end(), 0u);
+  std::nth_element(activeColumns.begin(), activeColumns.begin() + numDesired, activeColumns.end(),
+    [&overlaps](const UInt a, const UInt b) {
+      return (overlaps[a] == overlaps[b]) ? a > b : overlaps[a] > overlaps[b]; });
+  activeColumns.resize(numDesired);
+  // Remove sub-threshold winners
+  activeColumns.erase(std::remove_if(activeColumns.begin(), activeColumns.end(),
+    [&](const UInt c) { return overlaps[c] < stimulusThreshold_; }), activeColumns.end());
+}
+
+
+void FrozenSpatialPooler::inhibitColumnsLocal_(const vector<Real> &overlaps,
+                                               vector<UInt> &activeColumns,
+                                               Scratch &working) const {
+  // Tie-breaking: when overlaps are equal, columns that have already been
+  // selected are treated as "bigger".
+  auto &activeColumnsDense = working.activeDense;
+  activeColumnsDense.assign(numColumns_, false);
+  const bool cached = not neighborOffsets_.empty();
+  auto &scratch = working.neighbors;
+
+  for(UInt column = 0; column < numColumns_; column++) {
+    if( overlaps[column] < stimulusThreshold_ ) {
+      continue;
+    }
+
+    const UInt *begin, *end;
+    if( cached ) {
+      begin = neighbors_.data() + neighborOffsets_[column];
+      end   = neighbors_.data() + neighborOffsets_[column + 1u];
+    } else {
+      scratch.clear();
+      neighborhood_.appendNeighbors(column, scratch);
+      begin = scratch.data();
+      end   = begin + scratch.size();
+    }
+
+    const UInt numNeighbors = wrapAround_ ? numNeighborsWrap_ : static_cast<UInt>(end - begin) - 1u;
+    const UInt numActive = (UInt)(0.5f + (density_ * (numNeighbors + 1)));
+    UInt numBigger = 0;
+    for(auto it = begin; it != end; it++) {
+      const UInt neighbor = *it;
+      if( neighbor == column ) {
+        continue;
+      }
+      const Real difference = overlaps[neighbor] - overlaps[column];
+      if( difference > 0 || (difference == 0 && activeColumnsDense[neighbor]) ) {
+        numBigger++;
+        if( numBigger >= numActive ) { break; }
+      }
+    }
+
+    if( numBigger < numActive ) {
+      activeColumns.push_back(column);
+      activeColumnsDense[column] = true;
+    }
+  }
+}
+
+
+bool FrozenSpatialPooler::operator==(const FrozenSpatialPooler &o) const {
+  return inputDimensions_   == o.inputDimensions_   and
+         columnDimensions_  == o.columnDimensions_  and
+         stimulusThreshold_ == o.stimulusThreshold_ and
+         density_           == o.density_           and
+         globalInhibition_  == o.globalInhibition_  and
+         inhibitionRadius_  == o.inhibitionRadius_  and
+         wrapAround_        == o.wrapAround_        and
+         boostFactors_      == o.boostFactors_      and
+         inputOffsets_      == o.inputOffsets_      and
+         inputColumns_      == o.inputColumns_;
+}
+
+
+size_t FrozenSpatialPooler::memoryUsage() const {
+  return sizeof(*this) +
+         boostFactors_.capacity()    * sizeof(Real) +
+         (inputOffsets_.capacity()   + inputColumns_.capacity() +
+          neighborOffsets_.capacity() + neighbors_.capacity()) * sizeof(UInt);
+}
+
+
+namespace {
+
+std::mutex &sharedMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::map<std::string, std::shared_ptr<const FrozenSpatialPooler>> &sharedModels() {
+  static std::map<std::string, std::shared_ptr<const FrozenSpatialPooler>> models;
+  return models;
+}
+
+} // end anonymous namespace
+
+
+void FrozenSpatialPooler::share(const std::string &name, std::shared_ptr<const FrozenSpatialPooler> model) {
+  NTA_CHECK(!name.empty()) << "FrozenSpatialPooler::share: empty name.";
+  NTA_CHECK(model) << "FrozenSpatialPooler::share: no model for '" << name << "'.";
+  std::lock_guard<std::mutex> lock(sharedMutex());
+  sharedModels()[name] = std::move(model);
+}
+
+
+std::shared_ptr<const FrozenSpatialPooler> FrozenSpatialPooler::shared(const std::string &name) {
+  std::lock_guard<std::mutex> lock(sharedMutex());
+  const auto found = sharedModels().find(name);
+  NTA_CHECK(found != sharedModels().end())
+    << "FrozenSpatialPooler: no model is shared as '" << name << "'.";
+  return found->second;
+}
+
+
+bool FrozenSpatialPooler::unshare(const std::string &name) {
+  std::lock_guard<std::mutex> lock(sharedMutex());
+  return sharedModels().erase(name) > 0u;
+}
+
+
+vector<std::string> FrozenSpatialPooler::sharedNames() {
+  std::lock_guard<std::mutex> lock(sharedMutex());
+  vector<std::string> names;
+  for(const auto &model : sharedModels()) {
+    names.push_back(model.first);
+  }
+  return names;
+}
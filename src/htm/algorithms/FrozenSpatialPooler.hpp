@@ -0,0 +1,204 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the FrozenSpatialPooler class in C++
+ */
+
+#ifndef NTA_FROZEN_SPATIAL_POOLER_HPP
+#define NTA_FROZEN_SPATIAL_POOLER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * FrozenSpatialPooler - a trained SpatialPooler reduced to inference.
+ *
+ * @b Description
+ * Created by SpatialPooler::freeze() (or the constructor), after the
+ * training is done.  It keeps only what `SpatialPooler::compute(input,
+ * learn=false, active)` needs:
+ *  - the connected synapses as a read-only CSR table from each input bit to
+ *    the columns it is connected to (4 bytes per connected synapse),
+ *  - the boost factors, if boosting is enabled,
+ *  - the inhibition parameters, resolved for the frozen inhibition radius.
+ * The potential (not connected) synapses, the duty cycles and the random
+ * generator are dropped.
+ *
+ * `compute` gives the same active columns as the SpatialPooler it was made
+ * from with learning off.  It is const and uses no shared scratch, so one
+ * FrozenSpatialPooler can be used by many threads at once.
+ *
+ * It serializes on its own, eg. to load it into inference workers.
+ *
+ * A FrozenSpatialPooler can be shared by name in a process wide registry,
+ * `share()`, so that the SPRegions of many networks use one copy of the
+ * model (@see the SPRegion parameter "sharedModel").  The regions compute
+ * concurrently, each with its own Scratch.
+ */
+class FrozenSpatialPooler : public Serializable
+{
+  friend class EdgeExporter;
+
+public:
+  FrozenSpatialPooler() {}
+
+  /**
+   * Freeze the current state of @param sp.
+   */
+  explicit FrozenSpatialPooler(const SpatialPooler &sp);
+
+  virtual ~FrozenSpatialPooler() {}
+
+  /**
+   * The working memory of one caller of compute(), reused between its calls
+   * so they don't allocate.
+   */
+  struct Scratch {
+    std::vector<SynapseIdx> overlaps;
+    std::vector<Real>       boosted;
+    std::vector<UInt>       active;
+    std::vector<bool>       activeDense;
+    std::vector<UInt>       neighbors;
+  };
+
+  /**
+   * Same as SpatialPooler::compute(input, false, active).
+   *
+   * @param input SDR with the dimensions of the input.
+   * @param active Output, the active columns.
+   */
+  void compute(const SDR &input, SDR &active) const;
+
+  /**
+   * Same, with the caller's @param scratch.  A Scratch must not be used by
+   * two threads at once.
+   */
+  void compute(const SDR &input, SDR &active, Scratch &scratch) const;
+
+  const std::vector<UInt> &getInputDimensions() const noexcept { return inputDimensions_; }
+  const std::vector<UInt> &getColumnDimensions() const noexcept { return columnDimensions_; }
+  UInt getNumInputs() const noexcept { return numInputs_; }
+  UInt getNumColumns() const noexcept { return numColumns_; }
+  size_t numConnectedSynapses() const noexcept { return inputColumns_.size(); }
+
+  /**
+   * @returns the bytes of the model, excluding any Scratch.
+   */
+  size_t memoryUsage() const;
+
+  /**
+   * Registers (or replaces) @param model under @param name.  The registry
+   * keeps the model until it is unshared; the users of a replaced or
+   * unshared model keep their reference to it.
+   */
+  static void share(const std::string &name, std::shared_ptr<const FrozenSpatialPooler> model);
+
+  /**
+   * @returns the model shared under @param name.  Throws if there is none.
+   */
+  static std::shared_ptr<const FrozenSpatialPooler> shared(const std::string &name);
+
+  /**
+   * Removes @param name from the registry.  @returns false if it was not
+   * shared.
+   */
+  static bool unshare(const std::string &name);
+
+  /**
+   * @returns the names of the shared models, sorted.
+   */
+  static std::vector<std::string> sharedNames();
+
+  bool operator==(const FrozenSpatialPooler &other) const;
+  inline bool operator!=(const FrozenSpatialPooler &other) const { return !operator==(other); }
+
+  // Serialization
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(inputDimensions_),
+       CEREAL_NVP(columnDimensions_),
+       CEREAL_NVP(stimulusThreshold_),
+       CEREAL_NVP(density_),
+       CEREAL_NVP(globalInhibition_),
+       CEREAL_NVP(inhibitionRadius_),
+       CEREAL_NVP(wrapAround_),
+       CEREAL_NVP(boostFactors_),
+       CEREAL_NVP(inputOffsets_),
+       CEREAL_NVP(inputColumns_));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(CEREAL_NVP(inputDimensions_),
+       CEREAL_NVP(columnDimensions_),
+       CEREAL_NVP(stimulusThreshold_),
+       CEREAL_NVP(density_),
+       CEREAL_NVP(globalInhibition_),
+       CEREAL_NVP(inhibitionRadius_),
+       CEREAL_NVP(wrapAround_),
+       CEREAL_NVP(boostFactors_),
+       CEREAL_NVP(inputOffsets_),
+       CEREAL_NVP(inputColumns_));
+    initialize_();
+  }
+
+private:
+  // Derived state, not serialized: sizes & the neighborhoods of the columns.
+  void initialize_();
+
+  // Same as SpatialPooler::inhibitColumnsGlobal_ / inhibitColumnsLocal_
+  void inhibitColumnsGlobal_(const std::vector<Real> &overlaps, std::vector<UInt> &active) const;
+  void inhibitColumnsLocal_(const std::vector<Real> &overlaps, std::vector<UInt> &active,
+                            Scratch &scratch) const;
+
+  std::vector<UInt> inputDimensions_;
+  std::vector<UInt> columnDimensions_;
+  UInt numInputs_  = 0u;
+  UInt numColumns_ = 0u;
+
+  UInt stimulusThreshold_ = 0u;
+  Real density_ = 0.0f;
+  bool globalInhibition_ = true; //resolved, @see SpatialPooler::isGlobalInhibition_
+  UInt inhibitionRadius_ = 0u;
+  bool wrapAround_ = true;
+  std::vector<Real> boostFactors_; //empty if boosting is off
+
+  // connected synapses: the columns of input bit i are
+  // inputColumns_[inputOffsets_[i] .. inputOffsets_[i+1])
+  std::vector<UInt> inputOffsets_;
+  std::vector<UInt> inputColumns_;
+
+  // local inhibition: the neighborhood (including the column itself) of
+  // column c is neighbors_[neighborOffsets_[c] .. neighborOffsets_[c+1])
+  std::vector<UInt> neighborOffsets_;
+  std::vector<UInt> neighbors_;
+  UInt numNeighborsWrap_ = 0u;
+  NeighborhoodTable neighborhood_; //enumerates the neighborhoods
+};
+
+} // end namespace htm
+
+#endif // NTA_FROZEN_SPATIAL_POOLER_HPP
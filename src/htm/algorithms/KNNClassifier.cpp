@@ -0,0 +1,105 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the KNNClassifier class
+ */
+
+#include <algorithm>
+
+#include <htm/algorithms/KNNClassifier.hpp>
+
+using namespace std;
+
+namespace htm {
+
+KNNClassifier::KNNClassifier(const UInt k, const UInt numBands, const UInt rowsPerBand,
+                             const UInt minOverlap)
+  { initialize(k, numBands, rowsPerBand, minOverlap); }
+
+
+void KNNClassifier::initialize(const UInt k, const UInt numBands, const UInt rowsPerBand,
+                               const UInt minOverlap) {
+  NTA_CHECK(k > 0u) << "KNNClassifier: k must be > 0";
+  NTA_CHECK(numBands == 0u or rowsPerBand > 0u) << "KNNClassifier: rowsPerBand must be > 0";
+  k_             = k;
+  numBands_      = numBands;
+  rowsPerBand_   = rowsPerBand;
+  minOverlap_    = minOverlap;
+  numCategories_ = 0u;
+  labels_.clear();
+  index_ = SDRIndex();
+}
+
+
+void KNNClassifier::learn(const SDR &pattern, const UInt category) {
+  if( labels_.empty() ) {
+    index_.initialize(pattern.dimensions, numBands_, rowsPerBand_);
+  }
+  NTA_CHECK(pattern.size == index_.getSize())
+      << "KNNClassifier: the pattern has " << pattern.size << " bits, expected " << index_.getSize();
+  index_.add(pattern);
+  labels_.push_back(category);
+  numCategories_ = max(numCategories_, category + 1u);
+}
+
+
+vector<SDRIndex::Match> KNNClassifier::getNeighbors(const SDR &pattern) const {
+  if( labels_.empty() ) return {};
+  return exact_ or numBands_ == 0u ? index_.search(pattern, k_, minOverlap_)
+                    : index_.searchApproximate(pattern, k_, minOverlap_);
+}
+
+
+PDF KNNClassifier::infer(const SDR &pattern) const {
+  PDF probabilities;
+  infer(pattern, probabilities);
+  return probabilities;
+}
+
+
+void KNNClassifier::infer(const SDR &pattern, PDF &probabilities) const {
+  probabilities.assign(numCategories_, 0.0);
+  const auto neighbors = getNeighbors(pattern);
+  if( neighbors.empty() ) return;
+  const Real64 vote = 1.0 / static_cast<Real64>(neighbors.size());
+  for( const auto &neighbor : neighbors ) {
+    probabilities[labels_[neighbor.first]] += vote;
+  }
+}
+
+
+void KNNClassifier::infer(const vector<SDR> &patterns, vector<PDF> &probabilities) const {
+  probabilities.resize(patterns.size());
+  for( size_t i = 0u; i < patterns.size(); i++ ) {
+    infer(patterns[i], probabilities[i]);
+  }
+}
+
+
+size_t KNNClassifier::memoryUsage() const {
+  return labels_.capacity() * sizeof(UInt) + index_.memoryUsage();
+}
+
+
+bool KNNClassifier::operator==(const KNNClassifier &other) const {
+  return k_ == other.k_ and numBands_ == other.numBands_ and rowsPerBand_ == other.rowsPerBand_ and
+         minOverlap_ == other.minOverlap_ and numCategories_ == other.numCategories_ and
+         labels_ == other.labels_ and index_ == other.index_;
+}
+
+} // end namespace htm
@@ -0,0 +1,174 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the KNNClassifier class
+ */
+
+#ifndef NTA_KNN_CLASSIFIER_HPP
+#define NTA_KNN_CLASSIFIER_HPP
+
+#include <vector>
+
+#include <htm/algorithms/SDRClassifier.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/SdrIndex.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * The KNN Classifier stores labeled SDRs and classifies a pattern by the
+ * votes of the k stored SDRs with the largest overlap with it.
+ *
+ * The stored SDRs are kept in an SDRIndex, so the overlaps are counted over
+ * the posting lists of the active bits of the pattern: the cost of infer()
+ * scales with the active bits times the length of their posting lists, not
+ * with the number of stored SDRs.  With numBands > 0 the index also buckets
+ * the SDRs by MinHash banding and infer() only ranks the SDRs which share a
+ * bucket with the pattern, @see SDRIndex::searchApproximate().
+ *
+ * Unlike the Classifier, learning is exact after one example and does not
+ * generalize beyond the overlap of the stored SDRs.
+ *
+ * Example Usage:
+ *    KNNClassifier knn( 3u );
+ *    knn.learn( patternA, Category::A );
+ *    knn.learn( patternB, Category::B );
+ *    argmax( knn.infer( noisyPatternA ) )  ->  Category::A
+ */
+class KNNClassifier : public Serializable
+{
+public:
+  /**
+   * @param k Number of neighbours which vote.
+   * @param numBands Number of MinHash bands of approximate inference, 0 for
+   *                 exact inference.
+   * @param rowsPerBand Number of min-hashes per band.
+   * @param minOverlap Minimum overlap of a neighbour with the pattern.
+   */
+  KNNClassifier(UInt k = 1u, UInt numBands = 0u, UInt rowsPerBand = 4u, UInt minOverlap = 1u);
+
+  /**
+   * For use when deserializing.
+   */
+  void initialize(UInt k, UInt numBands = 0u, UInt rowsPerBand = 4u, UInt minOverlap = 1u);
+
+  UInt getK() const noexcept { return k_; }
+  UInt getMinOverlap() const noexcept { return minOverlap_; }
+  UInt getNumBands() const noexcept { return numBands_; }
+  UInt getRowsPerBand() const noexcept { return rowsPerBand_; }
+
+  /** Number of stored patterns. */
+  size_t numPatterns() const noexcept { return labels_.size(); }
+
+  /**
+   * Store the pattern with its category.  All patterns must have the
+   * dimensions of the first one.
+   */
+  void learn(const SDR &pattern, UInt category);
+
+  /**
+   * The votes of the nearest neighbours per category, normalized to sum to 1.
+   *
+   * @param pattern: The SDR containing the active input bits.
+   * @returns: The PDF of the categories, indexed by the category label.
+   *           Or empty array ([]) if learn() was never called.  All zeros
+   *           if no stored pattern has minOverlap with the pattern.
+   */
+  PDF infer(const SDR &pattern) const;
+
+  /**
+   * Same as infer(pattern), the PDF is written into @param probabilities
+   * whose memory is reused.
+   */
+  void infer(const SDR &pattern, PDF &probabilities) const;
+
+  /**
+   * infer() of a batch of patterns, eg. a test set.  The PDFs are written
+   * into @param probabilities, which is resized to the batch size and whose
+   * memory is reused.
+   */
+  void infer(const std::vector<SDR> &patterns, std::vector<PDF> &probabilities) const;
+
+  /**
+   * The nearest neighbours of the pattern: (pattern index, overlap), the
+   * largest overlap first.
+   */
+  std::vector<SDRIndex::Match> getNeighbors(const SDR &pattern) const;
+
+  /** The category of a stored pattern. */
+  UInt getCategory(UInt patternIndex) const { return labels_.at(patternIndex); }
+
+  /**
+   * Use exact inference even if numBands > 0, eg. to measure the recall of
+   * the approximate inference.
+   * This is a runtime setting, it is not serialized.
+   */
+  void setExact(bool exact) { exact_ = exact; }
+  bool getExact() const noexcept { return exact_; }
+
+  /**
+   * Estimate the heap memory held by the stored patterns, in bytes.
+   */
+  size_t memoryUsage() const;
+
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive & ar) const
+  {
+    ar(cereal::make_nvp("k",             k_),
+       cereal::make_nvp("numBands",      numBands_),
+       cereal::make_nvp("rowsPerBand",   rowsPerBand_),
+       cereal::make_nvp("minOverlap",    minOverlap_),
+       cereal::make_nvp("numCategories", numCategories_),
+       cereal::make_nvp("labels",        labels_),
+       cereal::make_nvp("index",         index_));
+  }
+
+  template<class Archive>
+  void load_ar(Archive & ar)
+  {
+    ar(cereal::make_nvp("k",             k_),
+       cereal::make_nvp("numBands",      numBands_),
+       cereal::make_nvp("rowsPerBand",   rowsPerBand_),
+       cereal::make_nvp("minOverlap",    minOverlap_),
+       cereal::make_nvp("numCategories", numCategories_),
+       cereal::make_nvp("labels",        labels_),
+       cereal::make_nvp("index",         index_));
+    NTA_CHECK(labels_.size() == index_.numEntries());
+  }
+
+  bool operator==(const KNNClassifier &other) const;
+  inline bool operator!=(const KNNClassifier &other) const { return not operator==(other); }
+
+private:
+  UInt k_;
+  UInt numBands_;
+  UInt rowsPerBand_;
+  UInt minOverlap_;
+  bool exact_ = false;
+
+  UInt numCategories_;
+  std::vector<UInt> labels_; // per stored pattern
+  SDRIndex index_;
+};
+
+} // end namespace htm
+
+#endif // NTA_KNN_CLASSIFIER_HPP
@@ -0,0 +1,169 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of ModelEvaluator
+ */
+
+#include <exception>
+#include <set>
+
+#include <htm/algorithms/ModelEvaluator.hpp>
+#include <htm/algorithms/SDRClassifier.hpp>
+
+using std::vector;
+using namespace htm;
+
+
+ModelEvaluator::ModelEvaluator(UInt numThreads) {
+  const size_t threads = numThreads == 0u ? ThreadPool::hardwareConcurrency() : numThreads;
+  // The calling thread runs models too.
+  if( threads > 1u ) pool_.reset(new ThreadPool(threads - 1u));
+}
+
+
+void ModelEvaluator::setData_(Dataset &data, const vector<SDR> &inputs,
+                              const vector<UInt> &labels, const vector<bool> &resets) {
+  NTA_CHECK(labels.empty() or labels.size() == inputs.size())
+    << "ModelEvaluator: " << labels.size() << " labels for " << inputs.size() << " records.";
+  NTA_CHECK(resets.empty() or resets.size() == inputs.size())
+    << "ModelEvaluator: " << resets.size() << " resets for " << inputs.size() << " records.";
+  for(size_t i = 1u; i < inputs.size(); i++) {
+    NTA_CHECK(inputs[i].dimensions == inputs[0].dimensions)
+      << "ModelEvaluator: the records must have the same dimensions.";
+  }
+  data.inputs.clear();
+  data.inputs.reserve(inputs.size());
+  for(const auto &input : inputs) {
+    data.inputs.emplace_back(input);
+    // The records are read by all threads at once, so fill the SDR's lazily
+    // computed formats now.
+    const auto &sdr = data.inputs.back();
+    sdr.getSparse();
+    sdr.getDense();
+    sdr.getDenseBits();
+  }
+  data.labels = labels;
+  data.resets = resets;
+}
+
+
+void ModelEvaluator::setTrainingData(const vector<SDR> &inputs,
+                                     const vector<UInt> &labels,
+                                     const vector<bool> &resets) {
+  setData_(train_, inputs, labels, resets);
+}
+
+
+void ModelEvaluator::setTestData(const vector<SDR> &inputs,
+                                 const vector<UInt> &labels,
+                                 const vector<bool> &resets) {
+  setData_(test_, inputs, labels, resets);
+}
+
+
+ModelEvaluator::Score ModelEvaluator::evaluate(const Model &model, UInt epochs) const {
+  NTA_CHECK(model.sp != nullptr or model.tm != nullptr) << "ModelEvaluator: empty model.";
+  NTA_CHECK(not train_.inputs.empty() or not test_.inputs.empty()) << "ModelEvaluator: no data.";
+
+  SDR columns( model.sp != nullptr ? model.sp->getColumnDimensions() : vector<UInt>{ 1u } );
+  SDR cells( model.tm != nullptr ? vector<UInt>{ static_cast<UInt>(model.tm->numberOfCells()) }
+                                 : vector<UInt>{ 1u } );
+
+  // Runs one record, @returns the model output.
+  const auto run = [&](const Dataset &data, size_t i, bool learn) -> const SDR & {
+    const SDR *output = &data.inputs[i];
+    if( model.sp != nullptr ) {
+      model.sp->compute(*output, learn, columns);
+      output = &columns;
+    }
+    if( model.tm != nullptr ) {
+      if( not data.resets.empty() and data.resets[i] ) model.tm->reset();
+      model.tm->compute(*output, learn);
+      model.tm->getActiveCells(cells);
+      output = &cells;
+    }
+    return *output;
+  };
+
+  const bool classify = not train_.labels.empty() and not train_.inputs.empty();
+  Classifier classifier;
+  Score score;
+  Real64 anomaly = 0.0;
+
+  if( model.tm != nullptr ) model.tm->reset();
+  for(UInt epoch = 0u; epoch < epochs; epoch++) {
+    const bool lastEpoch = epoch + 1u == epochs;
+    anomaly = 0.0;
+    for(size_t i = 0u; i < train_.inputs.size(); i++) {
+      const SDR &output = run(train_, i, true);
+      if( model.tm != nullptr ) anomaly += model.tm->anomaly;
+      if( classify and lastEpoch ) classifier.learn(output, { train_.labels[i] });
+    }
+  }
+
+  if( test_.inputs.empty() ) {
+    if( model.tm != nullptr and not train_.inputs.empty() ) {
+      score.anomaly = static_cast<Real>(anomaly / train_.inputs.size());
+    }
+    return score;
+  }
+
+  if( model.tm != nullptr ) model.tm->reset();
+  anomaly = 0.0;
+  size_t correct = 0u;
+  const bool scoreAccuracy = classify and not test_.labels.empty();
+  for(size_t i = 0u; i < test_.inputs.size(); i++) {
+    const SDR &output = run(test_, i, false);
+    if( model.tm != nullptr ) anomaly += model.tm->anomaly;
+    if( scoreAccuracy and argmax(classifier.infer(output)) == test_.labels[i] ) correct++;
+  }
+  if( model.tm != nullptr ) score.anomaly = static_cast<Real>(anomaly / test_.inputs.size());
+  if( scoreAccuracy ) score.accuracy = static_cast<Real>(correct) / test_.inputs.size();
+  return score;
+}
+
+
+vector<ModelEvaluator::Score> ModelEvaluator::evaluate(const vector<Model> &models, UInt epochs) {
+  std::set<const void*> used;
+  for(const auto &model : models) {
+    NTA_CHECK(model.sp == nullptr or used.insert(model.sp).second)
+      << "ModelEvaluator: a SpatialPooler is used by more than one model.";
+    NTA_CHECK(model.tm == nullptr or used.insert(model.tm).second)
+      << "ModelEvaluator: a TemporalMemory is used by more than one model.";
+  }
+
+  vector<Score> scores(models.size());
+  vector<std::exception_ptr> errors(models.size());
+  const auto evaluateRange = [&](size_t begin, size_t end, size_t) {
+    for(size_t i = begin; i < end; i++) {
+      try {
+        scores[i] = evaluate(models[i], epochs);
+      }
+      catch(...) {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+  // One chunk per model, so the fast models don't wait for the slow ones.
+  if( pool_ ) pool_->parallelFor(models.size(), evaluateRange, models.size());
+  else evaluateRange(0u, models.size(), 0u);
+  for(const auto &error : errors) {
+    if( error ) std::rethrow_exception(error);
+  }
+  return scores;
+}
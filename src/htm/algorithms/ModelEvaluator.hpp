@@ -0,0 +1,131 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ModelEvaluator class in C++
+ */
+
+#ifndef NTA_MODEL_EVALUATOR_HPP
+#define NTA_MODEL_EVALUATOR_HPP
+
+#include <memory>
+#include <vector>
+
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/ThreadPool.hpp>
+
+namespace htm {
+
+/**
+ * ModelEvaluator - trains and scores many models on one dataset in parallel.
+ *
+ * @b Description
+ * Made for parameter searches: the dataset is encoded once and shared by all
+ * models, which are eg. SpatialPoolers and TemporalMemories with different
+ * parameters.  Each model runs on its own thread, so the throughput of a
+ * search scales with the number of cores.
+ *
+ * A model is a SpatialPooler, a TemporalMemory, or an SP followed by a TM.
+ * Each model is trained on the training data (for `epochs` passes), then
+ * scored on the test data, or on the last training pass without test data:
+ *  - `anomaly` is the mean anomaly of the TM over the scored records,
+ *  - `accuracy` is the fraction of test records whose label an SDRClassifier,
+ *    trained on the model output of the labeled training records, predicts.
+ *
+ * The models are used by one thread each and must be distinct objects.
+ *
+ * Example Usage:
+ *    ModelEvaluator evaluator;
+ *    evaluator.setTrainingData( trainImages, trainLabels );
+ *    evaluator.setTestData( testImages, testLabels );
+ *    vector<ModelEvaluator::Model> models;
+ *    for( auto &sp : spatialPoolers ) models.push_back({ &sp, nullptr });
+ *    auto scores = evaluator.evaluate( models );
+ */
+class ModelEvaluator
+{
+public:
+  struct Model {
+    Model(SpatialPooler *spatialPooler = nullptr, TemporalMemory *temporalMemory = nullptr)
+      : sp(spatialPooler), tm(temporalMemory) {}
+
+    SpatialPooler  *sp;  // optional
+    TemporalMemory *tm;  // optional, its input is the SP output, else the data
+  };
+
+  struct Score {
+    Real anomaly  = 0.0f;  // mean TM anomaly, 0 without TM
+    Real accuracy = 0.0f;  // fraction of correctly classified records, 0 without labels
+  };
+
+  /**
+   * @param numThreads  Number of models evaluated at once, 0 for one per core.
+   */
+  explicit ModelEvaluator(UInt numThreads = 0u);
+
+  /**
+   * Sets (copies) a dataset.
+   *
+   * @param inputs  The encoded records, all with the same dimensions.
+   * @param labels  Optional, the category of each record for the accuracy.
+   * @param resets  Optional, true for the records which start a new sequence,
+   *                the TM is reset before them.
+   */
+  void setTrainingData(const std::vector<SDR> &inputs,
+                       const std::vector<UInt> &labels = {},
+                       const std::vector<bool> &resets = {});
+  void setTestData(const std::vector<SDR> &inputs,
+                   const std::vector<UInt> &labels = {},
+                   const std::vector<bool> &resets = {});
+
+  size_t trainingSize() const { return train_.inputs.size(); }
+  size_t testSize() const { return test_.inputs.size(); }
+
+  /**
+   * Trains and scores the models, in parallel.  Exceptions of a model are
+   * re-thrown after all models finished.
+   *
+   * @param models  The models, they are modified by training.
+   * @param epochs  The number of passes over the training data.
+   * @returns one score per model.
+   */
+  std::vector<Score> evaluate(const std::vector<Model> &models, UInt epochs = 1u);
+
+  // Same, for one model on the calling thread.
+  Score evaluate(const Model &model, UInt epochs = 1u) const;
+
+private:
+  struct Dataset {
+    std::vector<SDR>  inputs;
+    std::vector<UInt> labels;
+    std::vector<bool> resets;
+  };
+
+  static void setData_(Dataset &data, const std::vector<SDR> &inputs,
+                       const std::vector<UInt> &labels, const std::vector<bool> &resets);
+
+  Dataset train_;
+  Dataset test_;
+  std::unique_ptr<ThreadPool> pool_;  // null for a single thread
+};
+
+} // end namespace htm
+
+#endif // NTA_MODEL_EVALUATOR_HPP
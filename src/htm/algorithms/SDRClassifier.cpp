@@ -16,10 +16,11 @@
  * along with this program.  If not, see http://www.gnu.org/licenses.
  * --------------------------------------------------------------------- */
 
-#include <cmath> // exp
-#include <numeric> // accumulate
+#include <cmath> // exp, fabs
+#include <algorithm> // copy_n, max_element
 
 #include <htm/algorithms/SDRClassifier.hpp>
+#include <htm/os/CpuFeatures.hpp>
 #include <htm/utils/Log.hpp>
 
 using namespace htm;
@@ -31,6 +32,117 @@ UInt htm::argmax( const PDF & data )
 
 /******************************************************************************/
 
+namespace {
+  // The row of an input bit, @see Classifier::rowOf_.
+  inline size_t rowOf(const vector<UInt> &rows, const UInt bit)
+    { return rows.empty() ? bit : rows[bit]; }
+
+  // Adds the rows of the active bits to the accumulators.  The inner loop runs
+  // over contiguous memory, which the compiler vectorizes.  The body is
+  // compiled once per SIMD level, @see CpuFeatures.
+  #define NTA_ACCUMULATE_ROWS_BODY                                         \
+    for( size_t b = 0u; b < numBits; b++ ) {                               \
+      const size_t r = rows == nullptr ? bits[b] : rows[bits[b]];          \
+      if( r == Classifier::NO_ROW ) continue; /* all zeros */              \
+      const Weight *row = weights + r * stride;                            \
+      for( size_t i = 0u; i < n; i++ ) {                                   \
+        acc[i] += row[i];                                                  \
+      }                                                                    \
+    }
+
+  template<typename Weight>
+  using AccumulateRowsKernel = void (*)(const Weight *weights, size_t stride, const UInt *rows,
+                                        const UInt *bits, size_t numBits, Real64 *acc, size_t n);
+
+  template<typename Weight>
+  void accumulateRowsScalar(const Weight *weights, const size_t stride, const UInt *rows,
+                            const UInt *bits, const size_t numBits, Real64 *acc, const size_t n)
+    { NTA_ACCUMULATE_ROWS_BODY }
+
+#if NTA_SIMD_DISPATCH
+  template<typename Weight> NTA_TARGET_AVX2
+  void accumulateRowsAVX2(const Weight *weights, const size_t stride, const UInt *rows,
+                          const UInt *bits, const size_t numBits, Real64 *acc, const size_t n)
+    { NTA_ACCUMULATE_ROWS_BODY }
+
+  template<typename Weight> NTA_TARGET_AVX512
+  void accumulateRowsAVX512(const Weight *weights, const size_t stride, const UInt *rows,
+                            const UInt *bits, const size_t numBits, Real64 *acc, const size_t n)
+    { NTA_ACCUMULATE_ROWS_BODY }
+#endif
+  #undef NTA_ACCUMULATE_ROWS_BODY
+
+  template<typename Weight>
+  const KernelTable<AccumulateRowsKernel<Weight>> &accumulateRowsKernels() {
+#if NTA_SIMD_DISPATCH
+    static const KernelTable<AccumulateRowsKernel<Weight>> table(
+        accumulateRowsScalar<Weight>, accumulateRowsAVX2<Weight>, accumulateRowsAVX512<Weight>);
+#else
+    static const KernelTable<AccumulateRowsKernel<Weight>> table(accumulateRowsScalar<Weight>);
+#endif
+    return table;
+  }
+
+  template<typename Weight>
+  void accumulateRows(const vector<Weight> &weights, const size_t stride, const vector<UInt> &rows,
+                      const SDR_sparse_t &bits, PDF &accumulators) {
+    accumulateRowsKernels<Weight>().get()(
+        weights.data(), stride, rows.empty() ? nullptr : rows.data(),
+        bits.data(), bits.size(), accumulators.data(), accumulators.size());
+  }
+
+  template<typename Weight>
+  void updateRows(vector<Weight> &weights, const size_t stride, const vector<UInt> &rows,
+                  const SDR_sparse_t &bits, const vector<Real64> &error, const Real alpha) {
+    const Real64 *err = error.data();
+    const size_t n = error.size();
+    for( const auto bit : bits ) {
+      Weight *row = weights.data() + rowOf( rows, bit ) * stride;
+      for( size_t i = 0u; i < n; i++ ) {
+        row[i] += static_cast<Weight>(alpha * err[i]);
+      }
+    }
+  }
+
+  // Like updateRows, only for the given categories.
+  template<typename Weight>
+  void updateRowsSparse(vector<Weight> &weights, const size_t stride, const vector<UInt> &rows,
+                        const SDR_sparse_t &bits, const vector<Real64> &error,
+                        const vector<UInt> &categories, const Real alpha) {
+    for( const auto bit : bits ) {
+      Weight *row = weights.data() + rowOf( rows, bit ) * stride;
+      for( const auto i : categories ) {
+        row[i] += static_cast<Weight>(alpha * error[i]);
+      }
+    }
+  }
+
+  // Copies the matrix to rows of newStride elements, the new columns are zero.
+  template<typename Weight>
+  void restride(vector<Weight> &weights, const size_t rows, const size_t oldStride,
+                const size_t newStride) {
+    vector<Weight> grown( rows * newStride, static_cast<Weight>(0) );
+    for( size_t r = 0u; r < rows and oldStride > 0u; r++ ) {
+      std::copy_n( weights.cbegin() + r * oldStride, oldStride, grown.begin() + r * newStride );
+    }
+    weights.swap( grown );
+  }
+
+  // Moves the rows to a row per input bit, the bits without a row get zeros.
+  template<typename Weight>
+  void scatterRows(vector<Weight> &weights, const size_t stride, const vector<UInt> &rows) {
+    vector<Weight> dense( rows.size() * stride, static_cast<Weight>(0) );
+    for( size_t bit = 0u; bit < rows.size(); bit++ ) {
+      if( rows[bit] == Classifier::NO_ROW ) continue;
+      std::copy_n( weights.cbegin() + rows[bit] * stride, stride, dense.begin() + bit * stride );
+    }
+    weights.swap( dense );
+  }
+} // end anonymous namespace
+
+
+const UInt Classifier::NO_ROW;
+
 Classifier::Classifier(const Real alpha)
   { initialize( alpha ); }
 
@@ -40,31 +152,137 @@ void Classifier::initialize(const Real alpha)
   alpha_ = alpha;
   dimensions_ = 0;
   numCategories_ = 0u;
+  stride_ = 0u;
+  numRows_ = 0u;
+  rowOf_.clear();
   weights_.clear();
+  weights32_.clear();
+}
+
+
+void Classifier::setSinglePrecision(const bool singlePrecision)
+{
+  if( singlePrecision == singlePrecision_ ) return;
+  if( singlePrecision ) {
+    weights32_.resize( weights_.size() );
+    for( size_t i = 0u; i < weights_.size(); i++ ) {
+      weights32_[i] = static_cast<Real32>( weights_[i] );
+    }
+    vector<Real64>().swap( weights_ );
+  }
+  else {
+    weights_.assign( weights32_.cbegin(), weights32_.cend() );
+    vector<Real32>().swap( weights32_ );
+  }
+  singlePrecision_ = singlePrecision;
+}
+
+
+size_t Classifier::memoryUsage() const
+{
+  return weights_.capacity() * sizeof(Real64) + weights32_.capacity() * sizeof(Real32) +
+         rowOf_.capacity() * sizeof(UInt);
+}
+
+
+void Classifier::setSparseUpdate(const Real64 errorThreshold, const UInt fullUpdatePeriod)
+{
+  NTA_CHECK( errorThreshold >= 0.0 ) << "Classifier: errorThreshold must not be negative.";
+  NTA_CHECK( fullUpdatePeriod > 0u ) << "Classifier: fullUpdatePeriod must be positive.";
+  errorThreshold_   = errorThreshold;
+  fullUpdatePeriod_ = fullUpdatePeriod;
+  learnIteration_   = 0u;
+}
+
+
+void Classifier::setWeights_(const vector<vector<Real64>> &weights)
+{
+  NTA_CHECK( weights.size() == dimensions_ ) << "Classifier: corrupt weights.";
+  stride_ = numCategories_;
+  // Only the input bits with a weight get a row.
+  rowOf_.assign( dimensions_, NO_ROW );
+  numRows_ = 0u;
+  for( size_t bit = 0u; bit < weights.size(); bit++ ) {
+    NTA_CHECK( weights[bit].size() == numCategories_ ) << "Classifier: corrupt weights.";
+    if( std::any_of( weights[bit].cbegin(), weights[bit].cend(), [](Real64 w) { return w != 0.0; } )) {
+      rowOf_[bit] = numRows_++;
+    }
+  }
+  vector<Real64> flat( static_cast<size_t>(numRows_) * stride_ );
+  for( size_t bit = 0u; bit < weights.size(); bit++ ) {
+    if( rowOf_[bit] == NO_ROW ) continue;
+    std::copy( weights[bit].cbegin(), weights[bit].cend(), flat.begin() + rowOf_[bit] * stride_ );
+  }
+  weights32_.clear();
+  weights_.swap( flat );
+  const bool singlePrecision = singlePrecision_;
+  singlePrecision_ = false;
+  allocateRows_( {} ); // switches to a row per bit if dense
+  singlePrecision_ = singlePrecision;
+  if( singlePrecision_ ) {
+    singlePrecision_ = false;
+    setSinglePrecision( true );
+  }
+}
+
+
+void Classifier::allocateRows_(const SDR_sparse_t &bits)
+{
+  if( rowOf_.empty() ) return;
+  const UInt numRows = numRows_;
+  for( const auto bit : bits ) {
+    if( rowOf_[bit] == NO_ROW ) {
+      rowOf_[bit] = numRows_++;
+    }
+  }
+  if( numRows_ != numRows ) {
+    const size_t size = static_cast<size_t>(numRows_) * stride_;
+    if( singlePrecision_ ) {
+      weights32_.resize( size, 0.0f );
+    } else {
+      weights_.resize( size, 0.0 );
+    }
+  }
+  if( 2u * static_cast<size_t>(numRows_) >= dimensions_ ) {
+    if( singlePrecision_ ) {
+      scatterRows( weights32_, stride_, rowOf_ );
+    } else {
+      scatterRows( weights_,   stride_, rowOf_ );
+    }
+    numRows_ = dimensions_;
+    vector<UInt>().swap( rowOf_ );
+  }
 }
 
 
 PDF Classifier::infer(const SDR & pattern) const {
+  PDF probabilities;
+  infer( pattern, probabilities );
+  return probabilities;
+}
+
+
+void Classifier::infer(const SDR & pattern, PDF & probabilities) const {
   // Check input dimensions, or if this is the first time the Classifier is used and dimensions
   // are unset, return zeroes.
   NTA_CHECK(pattern.size > 0) << "No Data pased to Classifier. Pattern is empty.";
   if (dimensions_ == 0) {
     NTA_WARN << "Classifier: must call `learn` before `infer`.";
-    return PDF(numCategories_, std::nan("")); //empty array []
+    probabilities.assign(numCategories_, std::nan("")); //empty array []
+    return;
   }
   NTA_ASSERT(pattern.size == dimensions_) << "Input SDR does not match previously seen size!";
 
   // Accumulate feed forward input.
-  PDF probabilities( numCategories_, 0.0f );
-  for( const auto bit : pattern.getSparse() ) {
-    for( size_t i = 0; i < numCategories_; i++ ) {
-      probabilities[i] += weights_[bit][i];
-    }
+  probabilities.assign( numCategories_, 0.0f );
+  if( singlePrecision_ ) {
+    accumulateRows( weights32_, stride_, rowOf_, pattern.getSparse(), probabilities );
+  } else {
+    accumulateRows( weights_,   stride_, rowOf_, pattern.getSparse(), probabilities );
   }
 
   // Convert from accumulated votes to probability density function.
   softmax( probabilities.begin(), probabilities.end() );
-  return probabilities;
 }
 
 
@@ -74,10 +292,8 @@ void Classifier::learn(const SDR &pattern, const vector<UInt> &categoryIdxList)
   // so we set the dimensions to that of the input `pattern`
   if( dimensions_ == 0 ) {
     dimensions_ = pattern.size;
-    while( weights_.size() < pattern.size ) {
-      const auto initialEmptyWeights = PDF( numCategories_, 0.0f );
-      weights_.push_back( initialEmptyWeights );
-    }
+    rowOf_.assign( dimensions_, NO_ROW );
+    numRows_ = 0u;
   }
   NTA_CHECK(pattern.size > 0) << "No Data passed to Classifier. Pattern is empty.";
   NTA_ASSERT(pattern.size == dimensions_) << "Input SDR does not match previously seen size!";
@@ -86,20 +302,40 @@ void Classifier::learn(const SDR &pattern, const vector<UInt> &categoryIdxList)
   const auto maxCategoryIdx = *max_element(categoryIdxList.cbegin(), categoryIdxList.cend());
   if( maxCategoryIdx >= numCategories_ ) {
     numCategories_ = maxCategoryIdx + 1;
-    for( auto & vec : weights_ ) {
-      while( vec.size() < numCategories_ ) {
-        vec.push_back( 0.0f );
+    if( numCategories_ > stride_ ) {
+      const UInt stride = std::max( numCategories_, 2u * stride_ );
+      if( singlePrecision_ ) {
+        restride( weights32_, numRows_, stride_, stride );
+      } else {
+        restride( weights_,   numRows_, stride_, stride );
       }
+      stride_ = stride;
     }
   }
 
   // Compute errors and update weights.
   const auto& error = calculateError_(categoryIdxList, pattern);
-  for( const auto& bit : pattern.getSparse() ) {
-    for(size_t i = 0u; i < numCategories_; i++) {
-      weights_[bit][i] += alpha_ * error[i];
+  allocateRows_( pattern.getSparse() );
+  const bool fullUpdate = errorThreshold_ <= 0.0 or learnIteration_ % fullUpdatePeriod_ == 0u;
+  learnIteration_++;
+  if( not fullUpdate ) {
+    updateCategories_.clear();
+    for( UInt i = 0u; i < error.size(); i++ ) {
+      if( std::fabs( error[i] ) >= errorThreshold_ ) {
+        updateCategories_.push_back( i );
+      }
+    }
+    if( singlePrecision_ ) {
+      updateRowsSparse( weights32_, stride_, rowOf_, pattern.getSparse(), error, updateCategories_, alpha_ );
+    } else {
+      updateRowsSparse( weights_,   stride_, rowOf_, pattern.getSparse(), error, updateCategories_, alpha_ );
     }
   }
+  else if( singlePrecision_ ) {
+    updateRows( weights32_, stride_, rowOf_, pattern.getSparse(), error, alpha_ );
+  } else {
+    updateRows( weights_,   stride_, rowOf_, pattern.getSparse(), error, alpha_ );
+  }
 }
 
 
@@ -126,15 +362,19 @@ void htm::softmax(PDF::iterator begin, PDF::iterator end) {
   if( begin == end ) {
     return;
   }
-  const auto maxVal = *max_element(begin, end);
-  for (auto itr = begin; itr != end; ++itr) {
-    *itr = std::exp(*itr - maxVal); // x[i] = e ^ (x[i] - maxVal)
-  }
+  Real64 *x = &*begin;
+  const size_t n = static_cast<size_t>(end - begin);
+  const auto maxVal = *max_element(x, x + n);
   // Sum of all elements raised to exp(elem) each.
-  const Real sum = (Real) std::accumulate(begin, end, 0.0);
+  Real64 total = 0.0;
+  for (size_t i = 0u; i < n; i++) {
+    x[i] = std::exp(x[i] - maxVal); // x[i] = e ^ (x[i] - maxVal)
+    total += x[i];
+  }
+  const Real sum = (Real) total;
   NTA_ASSERT(sum > 0.0f);
-  for (auto itr = begin; itr != end; ++itr) {
-    *itr /= sum;
+  for (size_t i = 0u; i < n; i++) {
+    x[i] /= sum;
   }
 }
 
@@ -143,11 +383,10 @@ bool Classifier::operator==(const Classifier &other) const {
   if (alpha_ != other.alpha_) return false;
   if (dimensions_ != other.dimensions_) return false; 
   if (numCategories_ != other.numCategories_) return false;
-  if (weights_.size() != other.weights_.size()) return false;
-  for (size_t i = 0; i < weights_.size();  i++) {
-    if (weights_[i].size() != other.weights_[i].size()) return false;
-    for (size_t j = 0; j < weights_[i].size(); j++) {
-      if (weights_[i][j] != other.weights_[i][j]) return false;
+  // The strides may differ, compare the categories in use.
+  for (size_t bit = 0; bit < dimensions_; bit++) {
+    for (size_t i = 0; i < numCategories_; i++) {
+      if (weightOf_(bit, i) != other.weightOf_(bit, i)) return false;
     }
   }
   return true;
@@ -171,25 +410,72 @@ void Predictor::initialize(const vector<UInt> &steps, const Real alpha)
     classifiers_.emplace( step, alpha );
   }
 
+  //steps_ are sorted, so steps_.back() is the "oldest/deepest" N-th step (ie 10 of [1,2,10])
+  patternHistory_.clear();
+  patternHistory_.reserve( historyCapacity_() );
+  recordNumHistory_.assign( historyCapacity_(), 0u );
   reset();
 }
 
 
 void Predictor::reset() {
+  historyBegin_ = 0u;
+  historySize_  = 0u;
+}
+
+
+void Predictor::setHistory_(const SDRStore &patterns, const vector<UInt> &recordNums)
+{
+  NTA_CHECK( not steps_.empty() ) << "Predictor: no steps.";
+  NTA_CHECK( patterns.numSDRs() == recordNums.size() and
+             recordNums.size() <= historyCapacity_() ) << "Predictor: corrupt history.";
   patternHistory_.clear();
-  recordNumHistory_.clear();
+  patternHistory_.reserve( historyCapacity_() );
+  recordNumHistory_.assign( historyCapacity_(), 0u );
+  for( size_t i = 0u; i < recordNums.size(); i++ ) {
+    patternHistory_.emplace_back( patterns.getDimensions() );
+    patterns.get( i, patternHistory_.back() );
+    recordNumHistory_[i] = recordNums[i];
+  }
+  historyBegin_ = 0u;
+  historySize_  = recordNums.size();
 }
 
 
 Predictions Predictor::infer(const SDR &pattern) const {
   Predictions result;
-  for( const auto step : steps_ ) {
-    result.insert({step, classifiers_.at(step).infer( pattern )});
-  }
+  infer( pattern, result );
   return result;
 }
 
 
+void Predictor::infer(const SDR &pattern, Predictions &result) const {
+  // The map is set up here, the threads below only modify its PDFs.
+  bool sameSteps = result.size() == steps_.size();
+  for( size_t i = 0u; i < steps_.size() and sameSteps; i++ ) {
+    sameSteps = result.count( steps_[i] ) > 0u;
+  }
+  if( not sameSteps ) {
+    result.clear();
+    for( const auto step : steps_ ) {
+      result[step];
+    }
+  }
+
+  pattern.getSparse(); // computed once, before the threads read it
+  const auto inferStep = [&](const size_t begin, const size_t end, size_t) {
+    for( size_t i = begin; i < end; i++ ) {
+      classifiers_.at( steps_[i] ).infer( pattern, result.at( steps_[i] ));
+    }
+  };
+  if( threadPool_ == nullptr or steps_.size() < 2u ) {
+    inferStep( 0u, steps_.size(), 0u );
+  } else {
+    threadPool_->parallelFor( steps_.size(), inferStep, numThreads_ );
+  }
+}
+
+
 void Predictor::learn(const UInt recordNum, //TODO make recordNum optional, autoincrement as steps 
 		      const SDR &pattern,
                       const std::vector<UInt> &bucketIdxList)
@@ -197,33 +483,80 @@ void Predictor::learn(const UInt recordNum, //TODO make recordNum optional, auto
   checkMonotonic_(recordNum);
 
   // Update pattern history if this is a new record.
-  const UInt lastRecordNum = recordNumHistory_.empty() ? 0 : recordNumHistory_.back();
-  if (recordNumHistory_.size() == 0u || recordNum > lastRecordNum) {
-    patternHistory_.emplace_back( pattern );
-    recordNumHistory_.push_back(recordNum);
-    if (patternHistory_.size() > steps_.back() + 1u) { //steps_ are sorted, so steps_.back() is the "oldest/deepest" N-th step (ie 10 of [1,2,10])
-      patternHistory_.pop_front();
-      recordNumHistory_.pop_front();
+  const auto capacity = historyCapacity_();
+  if( historySize_ == 0u || recordNum > recordNumHistory_[historySlot_( historySize_ - 1u )] ) {
+    size_t slot;
+    if( historySize_ == capacity ) {
+      // Overwrite the oldest pattern, its buffers are reused for the new one.
+      slot = historyBegin_;
+      historyBegin_ = (historyBegin_ + 1u) % capacity;
+    }
+    else {
+      slot = historySlot_( historySize_ );
+      historySize_++;
+    }
+    if( slot == patternHistory_.size() ) { //the ring grows until it is full
+      patternHistory_.emplace_back( pattern.dimensions );
+    }
+    SDR &entry = patternHistory_[slot];
+    if( entry.size != pattern.size ) {
+      entry.initialize( pattern.dimensions );
     }
+    entry.setSDR( pattern );
+    recordNumHistory_[slot] = recordNum;
   }
 
   // Iterate through all recently given inputs, starting from the furthest in the past.
-  auto pastPattern   = patternHistory_.begin();
-  auto pastRecordNum = recordNumHistory_.begin();
-  for( ; pastRecordNum != recordNumHistory_.cend(); pastPattern++, pastRecordNum++ )
+  // Each step has its own classifier, so the updates are independent.
+  learnTasks_.clear();
+  for( size_t age = 0u; age < historySize_; age++ )
   {
-    const UInt nSteps = recordNum - *pastRecordNum;
+    const auto slot = historySlot_( age );
+    const UInt nSteps = recordNum - recordNumHistory_[slot];
 
-    // Update weights.
     if( binary_search( steps_.begin(), steps_.end(), nSteps )) {
-      classifiers_.at(nSteps).learn( *pastPattern, bucketIdxList );
+      learnTasks_.emplace_back( &classifiers_.at(nSteps), &patternHistory_[slot] );
     }
   }
+
+  // Update weights.
+  const auto learnStep = [&](const size_t begin, const size_t end, size_t) {
+    for( size_t i = begin; i < end; i++ ) {
+      learnTasks_[i].first->learn( *learnTasks_[i].second, bucketIdxList );
+    }
+  };
+  if( threadPool_ == nullptr or learnTasks_.size() < 2u ) {
+    learnStep( 0u, learnTasks_.size(), 0u );
+  } else {
+    threadPool_->parallelFor( learnTasks_.size(), learnStep, numThreads_ );
+  }
+}
+
+
+void Predictor::setNumThreads(const UInt numThreads) {
+  numThreads_ = numThreads == 0u ? static_cast<UInt>(ThreadPool::hardwareConcurrency()) : numThreads;
+  if( numThreads_ > 1u ) {
+    threadPool_ = std::make_shared<ThreadPool>(numThreads_ - 1u); //the calling thread works too
+  } else {
+    threadPool_.reset();
+  }
+}
+
+
+size_t Predictor::memoryUsage() const {
+  size_t bytes = recordNumHistory_.capacity() * sizeof(UInt);
+  for( const auto &pattern : patternHistory_ ) {
+    bytes += pattern.getSparse().capacity() * sizeof(ElemSparse);
+  }
+  for( const auto &step : classifiers_ ) {
+    bytes += sizeof(step) + step.second.memoryUsage();
+  }
+  return bytes;
 }
 
 
 void Predictor::checkMonotonic_(const UInt recordNum) const {
   // Ensure that recordNum increases monotonically.
-  const UInt lastRecordNum = recordNumHistory_.empty() ? 0 : recordNumHistory_.back();
+  const UInt lastRecordNum = historySize_ == 0u ? 0 : recordNumHistory_[historySlot_( historySize_ - 1u )];
   NTA_CHECK(recordNum >= lastRecordNum) << "The record number must increase monotonically.";
 }
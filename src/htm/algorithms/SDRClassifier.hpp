@@ -37,12 +37,16 @@
 #define NTA_SDR_CLASSIFIER_HPP
 
 #include <deque>
+#include <limits>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
 #include <htm/types/Types.hpp>
 #include <htm/types/Sdr.hpp>
+#include <htm/types/SdrStore.hpp>
 #include <htm/types/Serializable.hpp>
+#include <htm/utils/ThreadPool.hpp>
 
 namespace htm {
 
@@ -105,6 +109,8 @@ UInt argmax( const PDF & data );
  */
 class Classifier : public Serializable
 {
+  friend class EdgeExporter;
+
 public:
   /**
    * Constructor.
@@ -132,6 +138,12 @@ public:
    */
   PDF infer(const SDR & pattern) const;
 
+  /**
+   * Same as infer(pattern), the PDF is written into @param probabilities
+   * whose memory is reused.
+   */
+  void infer(const SDR & pattern, PDF & probabilities) const;
+
   /**
    * Learn from example data.
    *
@@ -140,38 +152,118 @@ public:
    */
   void learn(const SDR & pattern, const std::vector<UInt> & categoryIdxList);
 
+  /**
+   * Store the weights as Real32 instead of Real64.  This halves the memory
+   * of the weight matrix and the memory traffic of infer() and learn(), at
+   * the cost of precision: results differ slightly from the default.
+   * The weights are converted when the setting changes.
+   *
+   * This is a runtime setting, it is not serialized.  Archives always hold
+   * Real64 weights.
+   */
+  void setSinglePrecision(bool singlePrecision);
+  bool getSinglePrecision() const { return singlePrecision_; }
+
+  /**
+   * Estimate the heap memory held by the weights, in bytes.
+   */
+  size_t memoryUsage() const;
+
+  /**
+   * Sparse learning updates.  A converged model predicts most categories with
+   * a tiny error, updating their weights changes little.  With this setting,
+   * learn() only updates the categories whose absolute error is at least
+   * @param errorThreshold, and does a full update of all categories every
+   * @param fullUpdatePeriod calls to learn() (the first call is a full
+   * update).  The cost of the update then scales with the number of relevant
+   * categories instead of the number of categories.
+   *
+   * An errorThreshold of 0 (the default) disables sparse updates.
+   * This is a runtime setting, it is not serialized.
+   */
+  void setSparseUpdate(Real64 errorThreshold, UInt fullUpdatePeriod = 10u);
+
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const
   {
+    // The archive keeps the layout weights[ input-bit ][ category-index ].
+    std::vector<std::vector<Real64>> weights( dimensions_ );
+    for( size_t bit = 0u; bit < weights.size(); bit++ ) {
+      weights[bit].resize( numCategories_ );
+      for( size_t i = 0u; i < numCategories_; i++ ) {
+        weights[bit][i] = weightOf_( bit, i );
+      }
+    }
     ar(cereal::make_nvp("alpha",         alpha_),
        cereal::make_nvp("dimensions",    dimensions_),
        cereal::make_nvp("numCategories", numCategories_),
-       cereal::make_nvp("weights",       weights_));
+       cereal::make_nvp("weights",       weights));
   }
 
   template<class Archive>
   void load_ar(Archive & ar) {
+    std::vector<std::vector<Real64>> weights;
     ar(cereal::make_nvp("alpha", alpha_), 
        cereal::make_nvp("dimensions", dimensions_),
        cereal::make_nvp("numCategories", numCategories_), 
-       cereal::make_nvp("weights", weights_));
+       cereal::make_nvp("weights", weights));
+    setWeights_( weights );
   }
 
   bool operator==(const Classifier &other) const;
   bool operator!=(const Classifier &other) const { return !operator==(other); }
 
+  // The row of an input bit which has no weights yet, @see rowOf_.
+  static const UInt NO_ROW = 0xFFFFFFFFu;
+
 private:
   Real alpha_;
   UInt dimensions_;
   UInt numCategories_;
 
   /**
-   * 2D map used to store the data.
-   * Use as: weights_[ input-bit ][ category-index ]
-   * Real64 (not just Real) so the computations do not lose precision.
+   * Weight matrix, one contiguous row per input bit:
+   *    weights_[ row * stride_ + category-index ]
+   * Rows are contiguous so that infer() and learn() add whole rows in a
+   * vectorizable loop.  stride_ >= numCategories_ grows geometrically, so
+   * that adding categories one by one does not copy the matrix every time.
+   * Real64 (not just Real) so the computations do not lose precision,
+   * unless singlePrecision_ is set, then weights32_ holds the matrix and
+   * weights_ is empty.
+   *
+   * Sparse rows: the weights of an input bit are zero until the bit is
+   * active in learn(), so while few bits were ever active only those have a
+   * row, allocated on the first activation: rowOf_[ input-bit ] is the row
+   * or NO_ROW.  Once half of the bits have a row, the matrix switches to a
+   * row per input bit, row == input-bit, and rowOf_ is empty.
    */
-  std::vector<std::vector<Real64>> weights_;
+  UInt stride_ = 0u;
+  UInt numRows_ = 0u;
+  std::vector<UInt> rowOf_;
+  std::vector<Real64> weights_;
+  std::vector<Real32> weights32_;
+  bool singlePrecision_ = false;
+
+  Real64 errorThreshold_ = 0.0;
+  UInt fullUpdatePeriod_ = 1u;
+  UInt learnIteration_ = 0u;
+  std::vector<UInt> updateCategories_; //reused scratch
+
+  Real64 weight_(const size_t index) const
+    { return singlePrecision_ ? weights32_[index] : weights_[index]; }
+
+  // The weight of an input bit for a category, 0 if the bit has no row.
+  Real64 weightOf_(const size_t bit, const size_t category) const {
+    const size_t row = rowOf_.empty() ? bit : rowOf_[bit];
+    return row == NO_ROW ? 0.0 : weight_( row * stride_ + category );
+  }
+
+  // Gives the active bits rows, and switches to a row per bit when dense.
+  void allocateRows_(const SDR_sparse_t &bits);
+
+  // Replaces the weights with the nested vectors of an archive.
+  void setWeights_(const std::vector<std::vector<Real64>> &weights);
 
   // Helper function to compute the error signal for learning.
   std::vector<Real64> calculateError_(const std::vector<UInt> &bucketIdxList,
@@ -268,6 +360,13 @@ public:
    */
   Predictions infer(const SDR &pattern) const;
 
+  /**
+   * Same as infer(pattern), the predictions are written into @param result.
+   * Reusing the same result across calls keeps its map entries and PDFs, so
+   * this does not allocate once the result has been filled.
+   */
+  void infer(const SDR &pattern, Predictions &result) const;
+
   /**
    * Learn from example data.
    *
@@ -280,32 +379,106 @@ public:
 	     const SDR &pattern,
              const std::vector<UInt> &bucketIdxList);
 
+  /**
+   * Set the number of threads used to run the classifiers of the different
+   * steps concurrently in infer() and learn(), including the calling thread.
+   * All steps share one thread pool.  Default 1, use 0 for all hardware
+   * threads.  Results are identical to the single threaded computation.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setNumThreads(const UInt numThreads);
+  UInt getNumThreads() const noexcept { return numThreads_; }
+
+  /**
+   * Estimate the heap memory held by the classifiers and the pattern
+   * history, in bytes.
+   */
+  size_t memoryUsage() const;
+
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const
   {
+    // The history is written oldest first, as one contiguous SDRStore.
+    SDRStore patternHistory;
+    std::vector<UInt> recordNumHistory;
+    if( historySize_ > 0u ) {
+      patternHistory.initialize( patternHistory_[historyBegin_].dimensions );
+      for( size_t age = 0u; age < historySize_; age++ ) {
+        patternHistory.add( patternHistory_[historySlot_( age )] );
+        recordNumHistory.push_back( recordNumHistory_[historySlot_( age )] );
+      }
+    }
+    saveArchiveVersion( ar, archiveMarker_(), 2u );
     ar(cereal::make_nvp("steps",            steps_),
-       cereal::make_nvp("patternHistory",   patternHistory_),
-       cereal::make_nvp("recordNumHistory", recordNumHistory_),
+       cereal::make_nvp("patternHistory",   patternHistory),
+       cereal::make_nvp("recordNumHistory", recordNumHistory),
        cereal::make_nvp("classifiers",      classifiers_));
   }
 
   template<class Archive>
-  void load_ar(Archive & ar)
-    { ar( steps_, patternHistory_, recordNumHistory_, classifiers_ ); }
+  void load_ar(Archive & ar) {
+    const UInt32 version = loadArchiveVersion( ar, "steps", steps_, archiveMarker_(), 1u );
+    SDRStore patternHistory;
+    std::vector<UInt> recordNumHistory;
+    if( version >= 2u ) {
+      ar(cereal::make_nvp("patternHistory",   patternHistory),
+         cereal::make_nvp("recordNumHistory", recordNumHistory));
+    }
+    else { //the history as deques, oldest first
+      std::deque<SDR>  patterns;
+      std::deque<UInt> recordNums;
+      ar(cereal::make_nvp("patternHistory",   patterns),
+         cereal::make_nvp("recordNumHistory", recordNums));
+      if( not patterns.empty() ) {
+        patternHistory.initialize( patterns.front().dimensions );
+        for( const auto &pattern : patterns ) {
+          patternHistory.add( pattern );
+        }
+      }
+      recordNumHistory.assign( recordNums.begin(), recordNums.end() );
+    }
+    ar(cereal::make_nvp("classifiers", classifiers_));
+    setHistory_( patternHistory, recordNumHistory );
+  }
 
 private:
   // The list of prediction steps to learn and infer.
   std::vector<UInt> steps_;
 
-  // Stores the input pattern history, starting with the previous input.
-  std::deque<SDR>  patternHistory_;
-  std::deque<UInt> recordNumHistory_;
+  /**
+   * Stores the recent input patterns and their record numbers, in a ring of
+   * steps_.back() + 1 slots.  The oldest entry is in slot historyBegin_.
+   * The SDRs are added by learn() until the ring is full, so every SDR has
+   * the dimensions of the patterns.  Each slot keeps its SDR, whose sparse
+   * buffer is reused when a new pattern overwrites the slot, so learn() does
+   * not allocate once the buffers have grown.
+   */
+  std::vector<SDR>  patternHistory_;
+  std::vector<UInt> recordNumHistory_;
+  size_t historyBegin_ = 0u;
+  size_t historySize_  = 0u;
+
+  size_t historyCapacity_() const
+    { return steps_.empty() ? 0u : steps_.back() + 1u; }
+  size_t historySlot_(const size_t age) const
+    { return (historyBegin_ + age) % historyCapacity_(); }
+  // The first field of the versioned archive, steps are never this.
+  static std::vector<UInt> archiveMarker_()
+    { return { std::numeric_limits<UInt>::max() }; }
+
+  void setHistory_(const SDRStore &patterns, const std::vector<UInt> &recordNums);
   void checkMonotonic_(UInt recordNum) const;
 
   // One per prediction step
   std::unordered_map<UInt, Classifier> classifiers_;
 
+  // Multithreaded infer & learn, @see setNumThreads()
+  UInt numThreads_ = 1u;
+  std::shared_ptr<ThreadPool> threadPool_;
+  std::vector<std::pair<Classifier*, const SDR*>> learnTasks_; //reused scratch
+
 };      // End of Predictor class
 
 }       // End of namespace htm
@@ -0,0 +1,247 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of ShardedConnections
+ */
+
+#include <algorithm>
+
+#include <htm/algorithms/ShardedConnections.hpp>
+
+using std::vector;
+using namespace htm;
+
+
+ShardedConnections::ShardedConnections(const CellIdx numCells,
+                                       const UInt numShards,
+                                       const Permanence connectedThreshold,
+                                       const bool timeseries) {
+  initialize(numCells, numShards, connectedThreshold, timeseries);
+}
+
+
+void ShardedConnections::initialize(const CellIdx numCells,
+                                    const UInt numShards,
+                                    const Permanence connectedThreshold,
+                                    const bool timeseries) {
+  NTA_CHECK(numShards > 0u) << "ShardedConnections: numShards must be > 0";
+  NTA_CHECK(numShards <= std::max<CellIdx>(numCells, 1u)) << "ShardedConnections: more shards than cells.";
+  numCells_      = numCells;
+  cellsPerShard_ = (numCells + numShards - 1u) / numShards;
+  if(cellsPerShard_ == 0u) cellsPerShard_ = 1u;
+
+  shards_.clear();
+  shards_.reserve(numShards);
+  for(UInt s = 0u; s < numShards; s++) {
+    const CellIdx first = std::min<CellIdx>(s * cellsPerShard_, numCells);
+    const CellIdx last  = std::min<CellIdx>(first + cellsPerShard_, numCells);
+    shards_.emplace_back(last - first, connectedThreshold, timeseries);
+  }
+}
+
+
+void ShardedConnections::setNumThreads(const UInt numThreads) {
+  numThreads_ = numThreads == 0u ? static_cast<UInt>(ThreadPool::hardwareConcurrency()) : numThreads;
+  if( numThreads_ > 1u ) {
+    threadPool_ = std::make_shared<ThreadPool>(numThreads_ - 1u); //the calling thread works too
+  } else {
+    threadPool_.reset();
+  }
+}
+
+
+void ShardedConnections::forEachShard_(const std::function<void(UInt)> &fn) {
+  if( threadPool_ == nullptr or shards_.size() < 2u ) {
+    for(UInt s = 0u; s < numShards(); s++) fn(s);
+    return;
+  }
+  threadPool_->parallelFor(shards_.size(), [&](size_t begin, size_t end, size_t) {
+    for(size_t s = begin; s < end; s++) fn(static_cast<UInt>(s));
+  });
+}
+
+
+Segment ShardedConnections::createSegment(const CellIdx cell, const SegmentIdx maxSegmentsPerCell) {
+  NTA_CHECK(cell < numCells_);
+  const UInt s = shardForCell(cell);
+  const Segment local = shards_[s].createSegment(cell - firstCell_(s), maxSegmentsPerCell);
+  return toGlobal_(local, s);
+}
+
+
+Synapse ShardedConnections::createSynapse(const Segment segment,
+                                          const CellIdx presynapticCell,
+                                          const Permanence permanence) {
+  const UInt s = shardOf_(segment);
+  const Synapse local = shards_[s].createSynapse(localOf_(segment), presynapticCell, permanence);
+  return toGlobal_(local, s);
+}
+
+
+void ShardedConnections::destroySegment(const Segment segment) {
+  shards_[shardOf_(segment)].destroySegment(localOf_(segment));
+}
+
+
+void ShardedConnections::destroySynapse(const Synapse synapse) {
+  shards_[shardOf_(synapse)].destroySynapse(localOf_(synapse));
+}
+
+
+void ShardedConnections::updateSynapsePermanence(const Synapse synapse, const Permanence permanence) {
+  shards_[shardOf_(synapse)].updateSynapsePermanence(localOf_(synapse), permanence);
+}
+
+
+vector<Segment> ShardedConnections::segmentsForCell(const CellIdx cell) const {
+  NTA_CHECK(cell < numCells_);
+  const UInt s = shardForCell(cell);
+  vector<Segment> segments(shards_[s].segmentsForCell(cell - firstCell_(s)));
+  for(auto &seg : segments) seg = toGlobal_(seg, s);
+  return segments;
+}
+
+
+vector<Synapse> ShardedConnections::synapsesForSegment(const Segment segment) const {
+  const UInt s = shardOf_(segment);
+  vector<Synapse> synapses(shards_[s].synapsesForSegment(localOf_(segment)));
+  for(auto &syn : synapses) syn = toGlobal_(syn, s);
+  return synapses;
+}
+
+
+CellIdx ShardedConnections::cellForSegment(const Segment segment) const {
+  const UInt s = shardOf_(segment);
+  return shards_[s].cellForSegment(localOf_(segment)) + firstCell_(s);
+}
+
+
+Segment ShardedConnections::segmentForSynapse(const Synapse synapse) const {
+  const UInt s = shardOf_(synapse);
+  return toGlobal_(shards_[s].segmentForSynapse(localOf_(synapse)), s);
+}
+
+
+Permanence ShardedConnections::permanenceForSynapse(const Synapse synapse) const {
+  return shards_[shardOf_(synapse)].permanenceForSynapse(localOf_(synapse));
+}
+
+
+CellIdx ShardedConnections::presynapticCellForSynapse(const Synapse synapse) const {
+  return shards_[shardOf_(synapse)].presynapticCellForSynapse(localOf_(synapse));
+}
+
+
+vector<SynapseIdx> ShardedConnections::computeActivity(const vector<CellIdx> &activePresynapticCells,
+                                                       const bool learn) {
+  connectedScratch_.resize(shards_.size());
+  forEachShard_([&](UInt s) {
+    connectedScratch_[s] = shards_[s].computeActivity(activePresynapticCells, learn);
+  });
+
+  // merge into the global segment numbering
+  const UInt n = numShards();
+  vector<SynapseIdx> numActiveConnectedSynapsesForSegment(segmentFlatListLength(), 0u);
+  for(UInt s = 0u; s < n; s++) {
+    const auto &local = connectedScratch_[s];
+    for(size_t l = 0u; l < local.size(); l++) {
+      numActiveConnectedSynapsesForSegment[l * n + s] = local[l];
+    }
+  }
+  return numActiveConnectedSynapsesForSegment;
+}
+
+
+vector<SynapseIdx> ShardedConnections::computeActivity(vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
+                                                       const vector<CellIdx> &activePresynapticCells,
+                                                       const bool learn) {
+  const size_t length = segmentFlatListLength();
+  NTA_ASSERT(numActivePotentialSynapsesForSegment.size() == length);
+
+  connectedScratch_.resize(shards_.size());
+  potentialScratch_.resize(shards_.size());
+  forEachShard_([&](UInt s) {
+    potentialScratch_[s].assign(shards_[s].segmentFlatListLength(), 0u);
+    connectedScratch_[s] = shards_[s].computeActivity(potentialScratch_[s], activePresynapticCells, learn);
+  });
+
+  const UInt n = numShards();
+  vector<SynapseIdx> numActiveConnectedSynapsesForSegment(length, 0u);
+  std::fill(numActivePotentialSynapsesForSegment.begin(), numActivePotentialSynapsesForSegment.end(), 0u);
+  for(UInt s = 0u; s < n; s++) {
+    const auto &connected = connectedScratch_[s];
+    const auto &potential = potentialScratch_[s];
+    for(size_t l = 0u; l < connected.size(); l++) {
+      numActiveConnectedSynapsesForSegment[l * n + s] = connected[l];
+      numActivePotentialSynapsesForSegment[l * n + s] = potential[l];
+    }
+  }
+  return numActiveConnectedSynapsesForSegment;
+}
+
+
+void ShardedConnections::adaptSegments(const vector<Segment> &segments,
+                                       const SDR &inputs,
+                                       const Permanence increment,
+                                       const Permanence decrement,
+                                       const bool pruneZeroSynapses,
+                                       const UInt segmentThreshold) {
+  segmentsScratch_.resize(shards_.size());
+  for(auto &local : segmentsScratch_) local.clear();
+  for(const auto seg : segments) {
+    segmentsScratch_[shardOf_(seg)].push_back(localOf_(seg));
+  }
+  inputs.getDense(); //materialize the dense cache once, before the threads read it
+  forEachShard_([&](UInt s) {
+    shards_[s].adaptSegments(segmentsScratch_[s], inputs, increment, decrement,
+                             pruneZeroSynapses, segmentThreshold);
+  });
+}
+
+
+void ShardedConnections::reset() {
+  for(auto &shard : shards_) shard.reset();
+}
+
+
+size_t ShardedConnections::numSegments() const {
+  size_t sum = 0u;
+  for(const auto &shard : shards_) sum += shard.numSegments();
+  return sum;
+}
+
+
+size_t ShardedConnections::numSynapses() const {
+  size_t sum = 0u;
+  for(const auto &shard : shards_) sum += shard.numSynapses();
+  return sum;
+}
+
+
+size_t ShardedConnections::segmentFlatListLength() const {
+  size_t longest = 0u;
+  for(const auto &shard : shards_) longest = std::max(longest, shard.segmentFlatListLength());
+  return longest * shards_.size();
+}
+
+
+bool ShardedConnections::operator==(const ShardedConnections &other) const {
+  return numCells_ == other.numCells_ and
+         cellsPerShard_ == other.cellsPerShard_ and
+         shards_ == other.shards_;
+}
@@ -0,0 +1,182 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ShardedConnections class in C++
+ */
+
+#ifndef NTA_SHARDED_CONNECTIONS_HPP
+#define NTA_SHARDED_CONNECTIONS_HPP
+
+#include <memory>
+#include <vector>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/ThreadPool.hpp>
+
+namespace htm {
+
+/**
+ * ShardedConnections - Connections partitioned by (postsynaptic) cell.
+ *
+ * @b Description
+ * The cells are split into `numShards` contiguous ranges, each range is an
+ * independent Connections object with its own segments, synapses and
+ * presynaptic index.  Presynaptic cells are global and not partitioned.
+ *
+ * `computeActivity` and `adaptSegments` work on all shards in parallel and
+ * each shard is only touched by one thread during the call.  On NUMA machines
+ * run one thread per node (eg. numShards == number of nodes) and bind them
+ * with the OS tools (numactl, taskset), so a shard's memory stays local to
+ * the cores working on it.
+ *
+ * Segment and Synapse handles are global: a shard's local handle `l` of
+ * shard `s` is `l * numShards + s`.  This is stable while the shards grow,
+ * so vectors indexed by Segment have `segmentFlatListLength()` entries as
+ * with Connections.
+ */
+class ShardedConnections : public Serializable
+{
+public:
+  ShardedConnections() {}
+
+  /**
+   * @param numCells           Number of cells, partitioned among the shards.
+   * @param numShards          Number of shards, >= 1.
+   * @param connectedThreshold Permanence threshold for connected synapses.
+   * @param timeseries         @see Connections
+   */
+  ShardedConnections(const CellIdx numCells,
+                     const UInt numShards,
+                     const Permanence connectedThreshold = 0.5f,
+                     const bool timeseries = false);
+
+  virtual ~ShardedConnections() {}
+
+  void initialize(const CellIdx numCells,
+                  const UInt numShards,
+                  const Permanence connectedThreshold = 0.5f,
+                  const bool timeseries = false);
+
+  /**
+   * Set the number of threads used to process the shards in parallel,
+   * including the calling thread.  Default 1, use 0 for all hardware threads.
+   * This is a runtime setting, it is not serialized.
+   */
+  void setNumThreads(const UInt numThreads);
+  UInt getNumThreads() const noexcept { return numThreads_; }
+
+  // Structure, the same semantics as in Connections but with global handles.
+  Segment createSegment(const CellIdx cell,
+                        const SegmentIdx maxSegmentsPerCell = std::numeric_limits<SegmentIdx>::max());
+  Synapse createSynapse(const Segment segment,
+                        const CellIdx presynapticCell,
+                        const Permanence permanence);
+  void destroySegment(const Segment segment);
+  void destroySynapse(const Synapse synapse);
+  void updateSynapsePermanence(const Synapse synapse, const Permanence permanence);
+
+  std::vector<Segment> segmentsForCell(const CellIdx cell) const;
+  std::vector<Synapse> synapsesForSegment(const Segment segment) const;
+  CellIdx cellForSegment(const Segment segment) const;
+  Segment segmentForSynapse(const Synapse synapse) const;
+  Permanence permanenceForSynapse(const Synapse synapse) const;
+  CellIdx presynapticCellForSynapse(const Synapse synapse) const;
+
+  /**
+   * Compute the segment excitations of all shards, @see Connections::computeActivity().
+   *
+   * @returns numActiveConnectedSynapsesForSegment, indexed by global Segment.
+   */
+  std::vector<SynapseIdx> computeActivity(const std::vector<CellIdx> &activePresynapticCells,
+                                          const bool learn = true);
+
+  std::vector<SynapseIdx> computeActivity(std::vector<SynapseIdx> &numActivePotentialSynapsesForSegment,
+                                          const std::vector<CellIdx> &activePresynapticCells,
+                                          const bool learn = true);
+
+  /**
+   * Learning on many segments, the segments of each shard are processed in
+   * parallel.  @see Connections::adaptSegments().
+   */
+  void adaptSegments(const std::vector<Segment> &segments,
+                     const SDR &inputs,
+                     const Permanence increment,
+                     const Permanence decrement,
+                     const bool pruneZeroSynapses = false,
+                     const UInt segmentThreshold = 0);
+
+  void reset();
+
+  size_t numCells() const noexcept { return numCells_; }
+  size_t numSegments() const;
+  size_t numSynapses() const;
+  size_t segmentFlatListLength() const;
+
+  UInt numShards() const noexcept { return static_cast<UInt>(shards_.size()); }
+  UInt shardForCell(const CellIdx cell) const {
+    NTA_ASSERT(cell < numCells_);
+    return cell / cellsPerShard_;
+  }
+  const Connections &shard(const UInt s) const { return shards_.at(s); }
+
+  bool operator==(const ShardedConnections &other) const;
+  inline bool operator!=(const ShardedConnections &other) const { return !operator==(other); }
+
+  // Serialization
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(numCells_),
+       CEREAL_NVP(cellsPerShard_),
+       CEREAL_NVP(shards_));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(CEREAL_NVP(numCells_),
+       CEREAL_NVP(cellsPerShard_),
+       CEREAL_NVP(shards_));
+  }
+
+private:
+  // global <-> local handles
+  UInt32 toGlobal_(const UInt32 local, const UInt s) const noexcept {
+    return local * numShards() + s;
+  }
+  UInt shardOf_(const UInt32 global) const noexcept { return global % numShards(); }
+  UInt32 localOf_(const UInt32 global) const noexcept { return global / numShards(); }
+  CellIdx firstCell_(const UInt s) const noexcept { return s * cellsPerShard_; }
+
+  // Run fn(shard) for each shard, in parallel if threads are enabled.
+  void forEachShard_(const std::function<void(UInt)> &fn);
+
+  CellIdx numCells_ = 0;
+  CellIdx cellsPerShard_ = 1;
+  std::vector<Connections> shards_;
+
+  UInt numThreads_ = 1u;
+  std::shared_ptr<ThreadPool> threadPool_;
+  std::vector<std::vector<SynapseIdx>> connectedScratch_; //one per shard
+  std::vector<std::vector<SynapseIdx>> potentialScratch_;
+  std::vector<std::vector<Segment>>    segmentsScratch_;
+};
+
+} // end namespace htm
+
+#endif // NTA_SHARDED_CONNECTIONS_HPP
@@ -23,8 +23,13 @@
 #include <algorithm>
 #include <iterator> //begin()
 #include <cmath> //fmod
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <sstream>
 
 #include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/FrozenSpatialPooler.hpp>
 #include <htm/utils/Topology.hpp>
 #include <htm/utils/VectorHelpers.hpp>
 
@@ -252,22 +257,28 @@ void SpatialPooler::getBoostFactors(Real boostFactors[]) const { //TODO make vec
 
 void SpatialPooler::setBoostFactors(Real boostFactors[]) {
   boostFactors_.assign(&boostFactors[0], &boostFactors[numColumns_]);
+  boostFixedValid_ = false;
 }
 
 void SpatialPooler::getOverlapDutyCycles(Real overlapDutyCycles[]) const {
-  copy(overlapDutyCycles_.begin(), overlapDutyCycles_.end(), overlapDutyCycles);
+  const auto now = dutyCyclesNow_(overlapDutyCycles_);
+  copy(now.begin(), now.end(), overlapDutyCycles);
 }
 
 void SpatialPooler::setOverlapDutyCycles(const Real overlapDutyCycles[]) {
+  syncDutyCycles_();
   overlapDutyCycles_.assign(&overlapDutyCycles[0],
                             &overlapDutyCycles[numColumns_]);
+  resetDutyCycleClock_();
 }
 
 void SpatialPooler::getActiveDutyCycles(Real activeDutyCycles[]) const {
-  copy(activeDutyCycles_.begin(), activeDutyCycles_.end(), activeDutyCycles);
+  const auto now = dutyCyclesNow_(activeDutyCycles_);
+  copy(now.begin(), now.end(), activeDutyCycles);
 }
 
 void SpatialPooler::setActiveDutyCycles(const Real activeDutyCycles[]) {
+  syncDutyCycles_();
   activeDutyCycles_.assign(&activeDutyCycles[0],
                            &activeDutyCycles[numColumns_]);
 }
@@ -278,22 +289,35 @@ void SpatialPooler::getMinOverlapDutyCycles(Real minOverlapDutyCycles[]) const {
 }
 
 void SpatialPooler::setMinOverlapDutyCycles(const Real minOverlapDutyCycles[]) {
+  syncDutyCycles_();
   minOverlapDutyCycles_.assign(&minOverlapDutyCycles[0],
                                &minOverlapDutyCycles[numColumns_]);
+  resetDutyCycleClock_();
 }
 
 void SpatialPooler::getPotential(UInt column, UInt potential[]) const {
   NTA_ASSERT(column < numColumns_);
   std::fill( potential, potential + numInputs_, 0 );
+  if( implicitFloor_ > 0.0f ) {
+    Random rng(1u);
+    vector<UInt> pool;
+    implicitPool_(column, rng, pool);
+    for(const auto input : pool) {
+      potential[input] = 1;
+    }
+    return;
+  }
   const auto &synapses = connections_.synapsesForSegment( column );
   for(const auto syn : synapses) {
-    const auto &synData = connections_.dataForSynapse( syn );
-    potential[synData.presynapticCell] = 1;
+    potential[connections_.presynapticCellForSynapse( syn )] = 1;
   }
 }
 
 void SpatialPooler::setPotential(UInt column, const UInt potential[]) {
   NTA_ASSERT(column < numColumns_);
+  NTA_CHECK(implicitFloor_ == 0.0f) << "SP: setPotential is not supported with implicit potential pools.";
+
+  packedValid_ = false;
 
   // Remove all existing synapses.
   const auto &synapses = connections_.synapsesForSegment( column );
@@ -301,12 +325,12 @@ void SpatialPooler::setPotential(UInt column, const UInt potential[]) {
     connections_.destroySynapse( synapses[0] );
 
   // Replace with new synapse.
-  vector<UInt> potentialDenseVec( potential, potential + numInputs_ );
-  const auto &perm = initPermanence_( potentialDenseVec, initConnectedPct_ );
+  vector<UInt> potentialPool;
   for(UInt i = 0; i < numInputs_; i++) {
     if( potential[i] )
-      connections_.createSynapse( column, i, perm[i] );
+      potentialPool.push_back( i );
   }
+  initSynapses_( column, potentialPool, initConnectedPct_ );
 }
 
 vector<Real> SpatialPooler::getPermanence(const UInt column, 
@@ -315,9 +339,9 @@ vector<Real> SpatialPooler::getPermanence(const UInt column,
   const auto &synapses = connections_.synapsesForSegment( column );
   vector<Real> permanences(numInputs_, 0.0f);
   for( const auto syn : synapses ) {
-    const auto &synData = connections_.dataForSynapse( syn );
-    if( synData.permanence >= threshold) { // there must be >= for default case 0.0 where we want all permanences
-      permanences[ synData.presynapticCell ] = synData.permanence;
+    const auto permanence = connections_.permanenceForSynapse( syn );
+    if( permanence >= threshold) { // there must be >= for default case 0.0 where we want all permanences
+      permanences[ connections_.presynapticCellForSynapse( syn ) ] = permanence;
     }
   }
   return permanences;
@@ -334,10 +358,23 @@ void SpatialPooler::setPermanence(UInt column, const Real permanences[]) {
   vector<Real> check_data(permanences, permanences + numInputs_);
 #endif
 
+  packedValid_ = false;
+  if( implicitFloor_ > 0.0f ) {
+    // the permanences of the pool which are not below the floor are explicit
+    const auto &synapses = connections_.synapsesForSegment( column );
+    while( synapses.size() > 0 )
+      connections_.destroySynapse( synapses[0] );
+    Random rng(1u);
+    implicitPool_(column, rng, poolScratch_);
+    for(const auto input : poolScratch_) {
+      if( permanences[input] >= implicitFloor_ )
+        connections_.createSynapse( static_cast<Segment>(column), static_cast<CellIdx>(input), permanences[input] );
+    }
+    return;
+  }
   const auto synapses = connections_.synapsesForSegment( column );
   for(const auto &syn : synapses) {
-    const auto &synData = connections_.dataForSynapse( syn );
-    const auto &presyn  = synData.presynapticCell;
+    const auto presyn = connections_.presynapticCellForSynapse( syn );
     connections_.updateSynapsePermanence( syn, permanences[presyn] );
 
 #ifndef NDEBUG
@@ -414,6 +451,8 @@ void SpatialPooler::initialize(
   }
 
   rng_ = Random(seed);
+  potentialSeed_ = rng_.getSeed();
+  implicitFloor_ = 0.0f;
 
   potentialRadius_ = potentialRadius > numInputs_ ? numInputs_ : potentialRadius;
   NTA_CHECK(potentialPct > 0 && potentialPct <= 1);
@@ -437,22 +476,23 @@ void SpatialPooler::initialize(
   overlapDutyCycles_.assign(numColumns_, 0); //TODO make all these sparse or rm to reduce footprint
   activeDutyCycles_.assign(numColumns_, 0);
   minOverlapDutyCycles_.assign(numColumns_, 0.0);
+  resetDutyCycleClock_();
   boostFactors_.assign(numColumns_, 1.0); //1 is neutral value for boosting
   boostedOverlaps_.resize(numColumns_);
 
   inhibitionRadius_ = 0;
+  neighborTableValid_ = false; //column dimensions might have changed
+  packedValid_ = false;
+  inhibitionBucketsValid_ = false;
+  boostFixedValid_ = false;
 
   connections_.initialize(numColumns_, synPermConnected_);
+  const NeighborhoodTable inputNeighborhood(potentialRadius_, inputDimensions_, wrapAround_);
   for (Size i = 0; i < numColumns_; ++i) {
     connections_.createSegment( static_cast<CellIdx>(i) , 1 /* max segments per cell is fixed for SP to 1 */);
 
-    // Note: initMapPotential_ & initPermanence_ return dense arrays.
-    vector<UInt> potential = initMapPotential_((UInt)i, wrapAround_);
-    vector<Real> perm = initPermanence_(potential, initConnectedPct_);
-    for(size_t presyn = 0; presyn < numInputs_; presyn++) {
-      if( potential[presyn] )
-        connections_.createSynapse( static_cast<Segment>(i), static_cast<htm::CellIdx>(presyn), perm[presyn] );
-    }
+    const vector<UInt> potential = initPotentialPool_((UInt)i, inputNeighborhood);
+    initSynapses_((UInt)i, potential, initConnectedPct_);
 
     connections_.raisePermanencesToThreshold( (Segment)i, stimulusThreshold_ );
   }
@@ -466,29 +506,80 @@ void SpatialPooler::initialize(
 }
 
 
+FrozenSpatialPooler SpatialPooler::freeze() const {
+  return FrozenSpatialPooler(*this);
+}
+
+
 const vector<SynapseIdx> SpatialPooler::compute(const SDR &input, const bool learn, SDR &active) {
   input.reshape(  inputDimensions_ );
   active.reshape( columnDimensions_ );
   updateBookeepingVars_(learn);
 
-  const auto& overlaps = connections_.computeActivity(input.getSparse(), learn);
+  NTA_STATS_COUNT(stats_, Stats_Computes, 1u);
 
-  boostOverlaps_(overlaps, boostedOverlaps_);
+  boostedOverlaps_.resize(numColumns_);
+  vector<SynapseIdx> overlaps;
+  const bool incremental = incrementalInhibition_ and not learn and not backend_ and
+                           boostStrength_ < htm::Epsilon and isGlobalInhibition_();
+  if( isFixedPointBoosting_() ) updateFixedPointBoost_();
+  {
+    NTA_STATS_TIMER(stats_, Stats_Overlap);
+    if( not learn and backend_ ) {
+      backend_->update(connections_);
+      backend_->overlaps(input.getSparse(), overlaps);
+      boostOverlaps_(overlaps, boostedOverlaps_);
+    } else if( not learn and not incremental and computeOverlapsPacked_(input, overlaps) ) {
+      NTA_STATS_COUNT(stats_, Stats_PackedOverlaps, 1u);
+      boostOverlaps_(overlaps, boostedOverlaps_);
+    } else {
+      // the boosting is fused into the (parallel) summing up of the overlaps
+      overlaps = connections_.computeActivity(input.getSparse(), learn,
+        [&](const vector<SynapseIdx> &counts, const size_t begin, const size_t end) {
+          boostOverlaps_(counts, begin, end, boostedOverlaps_);
+        });
+    }
+  }
 
-  auto &activeVector = active.getSparse();
-  inhibitColumns_(boostedOverlaps_, activeVector);
-  // Notify the active SDR that its internal data vector has changed.  Always
-  // call SDR's setter methods even if when modifying the SDR's own data
-  // inplace.
-  sort( activeVector.begin(), activeVector.end() );
-  active.setSparse( activeVector );
+  {
+    NTA_STATS_TIMER(stats_, Stats_Inhibition);
+    auto &activeVector = active.getSparse();
+    if( incremental ) {
+      updateInhibitionBuckets_(overlaps);
+      inhibitColumnsIncremental_((UInt)(inhibitionDensity_() * numColumns_), activeVector);
+    } else {
+      inhibitionBucketsValid_ = false;
+      if( isFixedPointInhibition_() ) {
+        inhibitColumnsFixedPoint_((UInt)(inhibitionDensity_() * numColumns_), activeVector);
+      } else {
+        inhibitColumns_(boostedOverlaps_, activeVector);
+      }
+    }
+    // Notify the active SDR that its internal data vector has changed.  Always
+    // call SDR's setter methods even if when modifying the SDR's own data
+    // inplace.
+    sort( activeVector.begin(), activeVector.end() );
+    active.setSparse( activeVector );
+    NTA_STATS_COUNT(stats_, Stats_ActiveColumns, active.getSum());
+  }
 
   if (learn) {
-    adaptSynapses_(input, active);
-    updateDutyCycles_(overlaps, active);
-    bumpUpWeakColumns_();
-    updateBoostFactors_();
+    packedValid_ = false;
+    {
+      NTA_STATS_TIMER(stats_, Stats_Adapt);
+      adaptSynapses_(input, active);
+    }
+    {
+      NTA_STATS_TIMER(stats_, Stats_DutyCycles);
+      updateDutyCycles_(overlaps, active);
+    }
+    {
+      NTA_STATS_TIMER(stats_, Stats_Boost);
+      bumpUpWeakColumns_();
+      updateBoostFactors_();
+    }
     if (isUpdateRound_()) {
+      NTA_STATS_TIMER(stats_, Stats_DutyCycles);
       updateInhibitionRadius_();
       updateMinDutyCycles_();
     }
@@ -498,13 +589,215 @@ const vector<SynapseIdx> SpatialPooler::compute(const SDR &input, const bool lea
 }
 
 
+void SpatialPooler::compute(const vector<SDR> &inputs, vector<SDR> &outputs) {
+  NTA_STATS_COUNT(stats_, Stats_Computes, inputs.size());
+  outputs.resize(inputs.size());
+  // The batch is processed in chunks, so the scratch stays bounded for large datasets.
+  const size_t chunk = std::max<size_t>(1u, MAX_BATCH_OVERLAPS / numColumns_);
+  for(size_t begin = 0; begin < inputs.size(); begin += chunk) {
+    const size_t end = std::min(inputs.size(), begin + chunk);
+    batchInputs_.resize(end - begin);
+    for(size_t i = begin; i < end; i++) {
+      inputs[i].reshape( inputDimensions_ );
+      batchInputs_[i - begin] = inputs[i].getSparse();
+    }
+    {
+      NTA_STATS_TIMER(stats_, Stats_Overlap);
+      connections_.computeActivity(batchInputs_, batchOverlaps_);
+    }
+
+    NTA_STATS_TIMER(stats_, Stats_Inhibition);
+    for(size_t i = begin; i < end; i++) {
+      SDR &active = outputs[i];
+      if( active.dimensions.empty() ) {
+        active.initialize( columnDimensions_ );
+      } else {
+        active.reshape( columnDimensions_ );
+      }
+      updateBookeepingVars_(false);
+      if( isFixedPointBoosting_() ) updateFixedPointBoost_();
+      boostOverlaps_(batchOverlaps_[i - begin], boostedOverlaps_);
+
+      auto &activeVector = active.getSparse();
+      if( isFixedPointInhibition_() ) {
+        inhibitColumnsFixedPoint_((UInt)(inhibitionDensity_() * numColumns_), activeVector);
+      } else {
+        inhibitColumns_(boostedOverlaps_, activeVector);
+      }
+      sort( activeVector.begin(), activeVector.end() );
+      active.setSparse( activeVector );
+      NTA_STATS_COUNT(stats_, Stats_ActiveColumns, active.getSum());
+    }
+  }
+}
+
+
+const size_t SpatialPooler::MAX_BATCH_OVERLAPS = 1u << 20;
+const size_t SpatialPooler::MAX_PACKED_SYNAPSES = 1u << 22;
+const Real   SpatialPooler::MIN_PACKED_DENSITY  = 0.05f;
+
+namespace {
+// Bit-parallel popcount, for when the CPU has no popcount instruction.
+inline UInt popcount64(UInt64 x) {
+  x = x - ((x >> 1) & 0x5555555555555555ull);
+  x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+  x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+  return static_cast<UInt>( (x * 0x0101010101010101ull) >> 56 );
+}
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  // Portable x86 builds do not enable the popcnt instruction, so the kernel
+  // is compiled twice & picked at runtime by the CPU.
+  #define NTA_PACKED_OVERLAPS_POPCNT
+  #define NTA_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+  #define NTA_ALWAYS_INLINE inline
+#endif
+
+// The overlaps of all columns, @see SpatialPooler::computeOverlapsPacked_
+template<bool HardwarePopcount>
+NTA_ALWAYS_INLINE void packedOverlaps(const UInt numColumns, const UInt64 *synapses,
+    const size_t *offsets, const UInt *firstWord, const UInt64 *input, SynapseIdx *overlaps) {
+  for(UInt column = 0; column < numColumns; column++) {
+    const UInt64 *bits = synapses + offsets[column];
+    const UInt64 *in   = input + firstWord[column];
+    const size_t words = offsets[column + 1u] - offsets[column];
+    UInt count = 0u;
+    for(size_t i = 0; i < words; i++) {
+#ifdef NTA_PACKED_OVERLAPS_POPCNT
+      if( HardwarePopcount ) {
+        count += static_cast<UInt>( __builtin_popcountll(bits[i] & in[i]) );
+        continue;
+      }
+#endif
+      count += popcount64(bits[i] & in[i]);
+    }
+    overlaps[column] = static_cast<SynapseIdx>(count);
+  }
+}
+
+void packedOverlapsGeneric(const UInt numColumns, const UInt64 *synapses, const size_t *offsets,
+                           const UInt *firstWord, const UInt64 *input, SynapseIdx *overlaps) {
+  packedOverlaps<false>(numColumns, synapses, offsets, firstWord, input, overlaps);
+}
+
+#ifdef NTA_PACKED_OVERLAPS_POPCNT
+__attribute__((target("popcnt")))
+void packedOverlapsPopcnt(const UInt numColumns, const UInt64 *synapses, const size_t *offsets,
+                          const UInt *firstWord, const UInt64 *input, SynapseIdx *overlaps) {
+  packedOverlaps<true>(numColumns, synapses, offsets, firstWord, input, overlaps);
+}
+#endif
+} // end anonymous namespace
+#undef NTA_ALWAYS_INLINE
+
+
+void SpatialPooler::updatePackedSynapses_() {
+  if( packedValid_ ) return;
+  const Permanence threshold = connections_.getConnectedThreshold();
+
+  // the span of input words of each column's connected synapses
+  packedFirstWord_.assign(numColumns_, 0u);
+  packedOffsets_.assign(numColumns_ + 1u, 0u);
+  packedNumConnected_ = 0u;
+  for(UInt column = 0; column < numColumns_; column++) {
+    UInt first = numInputs_;
+    UInt last  = 0u;
+    for(const auto syn : connections_.synapsesForSegment( column )) {
+      if( connections_.permanenceForSynapse( syn ) < threshold ) continue;
+      const UInt presyn = connections_.presynapticCellForSynapse( syn );
+      first = std::min(first, presyn);
+      last  = std::max(last,  presyn);
+      packedNumConnected_++;
+    }
+    size_t words = 0u;
+    if( first <= last ) {
+      packedFirstWord_[column] = first / 64u;
+      words = last / 64u - first / 64u + 1u;
+    }
+    packedOffsets_[column + 1u] = packedOffsets_[column] + words;
+  }
+  packedSynapses_.assign(packedOffsets_.back(), 0u);
+  for(UInt column = 0; column < numColumns_; column++) {
+    UInt64 *bits = packedSynapses_.data() + packedOffsets_[column];
+    const UInt firstBit = packedFirstWord_[column] * 64u;
+    for(const auto syn : connections_.synapsesForSegment( column )) {
+      if( connections_.permanenceForSynapse( syn ) < threshold ) continue;
+      const UInt bit = connections_.presynapticCellForSynapse( syn ) - firstBit;
+      bits[bit / 64u] |= UInt64(1u) << (bit % 64u);
+    }
+  }
+  packedValid_ = true;
+}
+
+
+bool SpatialPooler::computeOverlapsPacked_(const SDR &input, vector<SynapseIdx> &overlaps) {
+  const auto &sparse = input.getSparse();
+  const size_t numWords = (numInputs_ + 63u) / 64u;
+  // Never build the bitsets for sparse inputs, nor if they might not fit.
+  if( sparse.size() < MIN_PACKED_DENSITY * numInputs_ or
+      (size_t)numColumns_ * numWords > MAX_PACKED_SYNAPSES ) {
+    return false;
+  }
+  updatePackedSynapses_();
+
+  // The sparse kernel increments once per active connected synapse, the
+  // packed kernel does one AND + popcount per word of the bitsets.
+  const size_t sparseCost = sparse.size() * packedNumConnected_ / numInputs_;
+  const size_t packedCost = packedSynapses_.size() + numWords;
+  if( packedCost >= sparseCost ) return false;
+
+  packedInput_.assign(numWords, 0u);
+  for(const auto bit : sparse) {
+    packedInput_[bit / 64u] |= UInt64(1u) << (bit % 64u);
+  }
+
+  overlaps.resize(numColumns_);
+#ifdef NTA_PACKED_OVERLAPS_POPCNT
+  static const bool hasPopcnt = __builtin_cpu_supports("popcnt");
+  if( hasPopcnt ) {
+    packedOverlapsPopcnt(numColumns_, packedSynapses_.data(), packedOffsets_.data(),
+                         packedFirstWord_.data(), packedInput_.data(), overlaps.data());
+    return true;
+  }
+#endif
+  packedOverlapsGeneric(numColumns_, packedSynapses_.data(), packedOffsets_.data(),
+                        packedFirstWord_.data(), packedInput_.data(), overlaps.data());
+  return true;
+}
+
+
 void SpatialPooler::boostOverlaps_(const vector<SynapseIdx> &overlaps, //TODO use Eigen sparse vector here
                                    vector<Real> &boosted) const {
+  boosted.resize(numColumns_);
+  boostOverlaps_(overlaps, 0u, numColumns_, boosted);
+}
+
+
+void SpatialPooler::boostOverlaps_(const vector<SynapseIdx> &overlaps,
+                                   const size_t begin, const size_t end,
+                                   vector<Real> &boosted) const {
+  NTA_ASSERT(boosted.size() == numColumns_);
   if(boostStrength_ < htm::Epsilon) { //boost ~ 0.0, we can skip these computations, just copy the data
-    boosted.assign(overlaps.begin(), overlaps.end());
+    std::copy(overlaps.begin() + begin, overlaps.begin() + end, boosted.begin() + begin);
     return;
   }
-  for (size_t i = 0; i < numColumns_; i++) {
+  if( isFixedPointBoosting_() ) {
+    NTA_ASSERT(boostFixedValid_ and boostedFixed_.size() == numColumns_);
+    // 16 x 16 bit integer products
+    const SynapseIdx *in = overlaps.data();
+    const UInt16 *factors = boostFactorsFixed_.data();
+    UInt32 *fixed = boostedFixed_.data(); //each range is written by one thread
+    const Real unit = 1.0f / boostFixedScale_;
+    for (size_t i = begin; i < end; i++) {
+      fixed[i] = static_cast<UInt32>(in[i]) * factors[i];
+    }
+    for (size_t i = begin; i < end; i++) {
+      boosted[i] = static_cast<Real>(fixed[i]) * unit;
+    }
+    return;
+  }
+  for (size_t i = begin; i < end; i++) {
     boosted[i] = overlaps[i] * boostFactors_[i];
   }
 }
@@ -530,24 +823,25 @@ UInt SpatialPooler::initMapColumn_(UInt column) const {
 
 
 vector<UInt> SpatialPooler::initMapPotential_(UInt column, bool wrapAround) {
+  const NeighborhoodTable inputNeighborhood(potentialRadius_, inputDimensions_, wrapAround);
+  const auto selectedInputs = initPotentialPool_(column, inputNeighborhood);
+  return VectorHelpers::sparseToBinary<UInt>(selectedInputs, numInputs_);
+}
+
+
+vector<UInt> SpatialPooler::initPotentialPool_(UInt column, const NeighborhoodTable &inputNeighborhood) {
   NTA_ASSERT(column < numColumns_);
   const UInt centerInput = initMapColumn_(column);
 
   vector<UInt> columnInputs;
-  if (wrapAround) {
-    for (const auto input : WrappingNeighborhood(centerInput, potentialRadius_, inputDimensions_)) {
-      columnInputs.push_back(input);
-    }
-  } else {
-    for (const auto input : Neighborhood(centerInput, potentialRadius_, inputDimensions_)) {
-      columnInputs.push_back(input);
-    }
-  }
+  inputNeighborhood.appendNeighbors(centerInput, columnInputs);
 
   const UInt numPotential = (UInt)round(columnInputs.size() * potentialPct_);
-  const auto selectedInputs = rng_.sample<UInt>(columnInputs, numPotential);
-  const vector<UInt> potential = VectorHelpers::sparseToBinary<UInt>(selectedInputs, numInputs_);
-  return potential;
+  auto selectedInputs = rng_.sample<UInt>(columnInputs, numPotential);
+  // sorted & unique (a wrapping neighborhood larger than the input repeats inputs)
+  std::sort(selectedInputs.begin(), selectedInputs.end());
+  selectedInputs.erase(std::unique(selectedInputs.begin(), selectedInputs.end()), selectedInputs.end());
+  return selectedInputs;
 }
 
 
@@ -580,6 +874,118 @@ vector<Real> SpatialPooler::initPermanence_(const vector<UInt> &potential, //TOD
 }
 
 
+void SpatialPooler::initSynapses_(const UInt column, const vector<UInt> &potentialPool,
+                                  const Real connectedPct) {
+  NTA_ASSERT(std::is_sorted(potentialPool.cbegin(), potentialPool.cend()));
+  // same random numbers, in the same order of the inputs, as initPermanence_
+  for (const auto presyn : potentialPool) {
+    const Real perm = (rng_.getReal64() <= connectedPct) ? initPermConnected_() : initPermNonConnected_();
+    connections_.createSynapse( static_cast<Segment>(column), static_cast<CellIdx>(presyn), perm );
+  }
+}
+
+
+void SpatialPooler::setImplicitPotential(const Permanence floor) {
+  if (floor == 0.0f and implicitFloor_ == 0.0f)
+    return;
+  NTA_CHECK(floor > 0.0f and floor <= synPermConnected_)
+    << "SP: implicit potential floor " << floor << " not in (0, synPermConnected_]";
+  NTA_CHECK(iterationLearnNum_ == 0u)
+    << "SP: the implicit potential pools can only be set before the SP learns.";
+  implicitFloor_ = floor;
+  packedValid_ = false;
+
+  Random rng(1u);
+  for (UInt column = 0u; column < numColumns_; column++) {
+    const auto &synapses = connections_.synapsesForSegment( column );
+    while( synapses.size() > 0 )
+      connections_.destroySynapse( synapses[0] );
+    implicitPool_(column, rng, poolScratch_);
+    for (const auto presyn : poolScratch_) {
+      const Real perm = (rng.getReal64() <= initConnectedPct_) ? rng.realRange(synPermConnected_, maxPermanence)
+                                                               : rng.realRange(minPermanence, synPermConnected_);
+      if (perm >= implicitFloor_)
+        connections_.createSynapse( static_cast<Segment>(column), static_cast<CellIdx>(presyn), perm );
+    }
+    connections_.raisePermanencesToThreshold( (Segment)column, stimulusThreshold_ );
+  }
+  connections_.compact(); // release the slots of the implicit synapses
+}
+
+
+void SpatialPooler::importSynapses(const vector<CellIdx> &segmentCells, const vector<Synapse> &offsets,
+                                   const vector<CellIdx> &presynapticCells,
+                                   const vector<Permanence> &permanences) {
+  NTA_CHECK(implicitFloor_ == 0.0f) << "SP: importSynapses is not supported with implicit potential pools.";
+  NTA_CHECK(segmentCells.size() == numColumns_)
+    << "SP: importSynapses expects one row per column, got " << segmentCells.size() << " for " << numColumns_;
+  for (UInt column = 0u; column < numColumns_; column++) {
+    NTA_CHECK(segmentCells[column] == column) << "SP: importSynapses expects the rows in column order.";
+  }
+  for (const auto presyn : presynapticCells) {
+    NTA_CHECK(presyn < numInputs_) << "SP: importSynapses input " << presyn << " out of range " << numInputs_;
+  }
+  connections_.importSegments(segmentCells, offsets, presynapticCells, permanences);
+  packedValid_ = false;
+  inhibitionBucketsValid_ = false;
+}
+
+
+void SpatialPooler::implicitPool_(const UInt column, Random &rng, vector<UInt> &pool) const {
+  NTA_ASSERT(column < numColumns_);
+  if (potentialNeighborhood_.radius() != potentialRadius_ or
+      potentialNeighborhood_.wrapAround() != wrapAround_ or
+      potentialNeighborhood_.dimensions() != inputDimensions_) {
+    potentialNeighborhood_ = NeighborhoodTable(potentialRadius_, inputDimensions_, wrapAround_);
+  }
+  rng = Random(potentialSeed_).split(column);
+  neighborsScratch_.clear();
+  potentialNeighborhood_.appendNeighbors(initMapColumn_(column), neighborsScratch_);
+  const UInt numPotential = (UInt)round(neighborsScratch_.size() * potentialPct_);
+  rng.sample(neighborsScratch_, numPotential, pool);
+  std::sort(pool.begin(), pool.end());
+  pool.erase(std::unique(pool.begin(), pool.end()), pool.end());
+}
+
+
+void SpatialPooler::materializePool_(const UInt column, const Permanence increment,
+                                     const SDR_dense_t *active) {
+  Random rng(1u);
+  implicitPool_(column, rng, poolScratch_);
+  explicitScratch_.clear();
+  for (const auto syn : connections_.synapsesForSegment( column )) {
+    explicitScratch_.push_back( connections_.presynapticCellForSynapse( syn ) );
+  }
+  std::sort(explicitScratch_.begin(), explicitScratch_.end());
+
+  const Permanence perm = std::min(implicitFloor_ + increment, static_cast<Permanence>(maxPermanence));
+  for (const auto presyn : poolScratch_) {
+    if (active != nullptr and not (*active)[presyn])
+      continue;
+    if (std::binary_search(explicitScratch_.cbegin(), explicitScratch_.cend(), static_cast<CellIdx>(presyn)))
+      continue;
+    connections_.createSynapse( static_cast<Segment>(column), static_cast<CellIdx>(presyn), perm );
+  }
+}
+
+
+void SpatialPooler::adaptImplicitSynapses_(const SDR &input, const vector<CellIdx> &columns) {
+  const auto &dense = input.getDense();
+  for (const auto column : columns) {
+    materializePool_(column, synPermActiveInc_, &dense);
+    // the synapses which decayed below the floor become implicit
+    forgetScratch_.clear();
+    for (const auto syn : connections_.synapsesForSegment( column )) {
+      if (connections_.permanenceForSynapse( syn ) < implicitFloor_)
+        forgetScratch_.push_back( syn );
+    }
+    for (const auto syn : forgetScratch_) {
+      connections_.destroySynapse( syn );
+    }
+  }
+}
+
+
 void SpatialPooler::updateInhibitionRadius_() {
   if (globalInhibition_) {
     inhibitionRadius_ =
@@ -597,10 +1003,12 @@ void SpatialPooler::updateInhibitionRadius_() {
   Real radius = (diameter - 1) / 2.0f;
   radius = max((Real)1.0, radius);
   inhibitionRadius_ = UInt(round(radius));
+  updateNeighborTable_();
 }
 
 
 void SpatialPooler::updateMinDutyCycles_() {
+  syncDutyCycles_();
   if (globalInhibition_ ||
       inhibitionRadius_ >=
           *max_element(columnDimensions_.begin(), columnDimensions_.end())) {
@@ -608,6 +1016,7 @@ void SpatialPooler::updateMinDutyCycles_() {
   } else {
     updateMinDutyCyclesLocal_();
   }
+  resetDutyCycleClock_(); //the minimums changed
 }
 
 
@@ -621,19 +1030,13 @@ void SpatialPooler::updateMinDutyCyclesGlobal_() {
 
 
 void SpatialPooler::updateMinDutyCyclesLocal_() {
+  const bool cached = updateNeighborTable_();
+  vector<UInt> neighbors; // only used if the neighborhoods are too large to cache
   for (UInt i = 0; i < numColumns_; i++) {
-    Real maxActiveDuty = 0.0f;
     Real maxOverlapDuty = 0.0f;
-    if (wrapAround_) {
-     for(auto column : WrappingNeighborhood(i, inhibitionRadius_, columnDimensions_)) {
-      maxActiveDuty = max(maxActiveDuty, activeDutyCycles_[column]);
-      maxOverlapDuty = max(maxOverlapDuty, overlapDutyCycles_[column]);
-     }
-    } else {
-      for (auto column : Neighborhood(i, inhibitionRadius_, columnDimensions_)) {
-      maxActiveDuty = max(maxActiveDuty, activeDutyCycles_[column]);
-      maxOverlapDuty = max(maxOverlapDuty, overlapDutyCycles_[column]);
-      }
+    const auto range = neighborhood_(i, cached, neighbors);
+    for (auto it = range.first; it != range.second; it++) {
+      maxOverlapDuty = max(maxOverlapDuty, overlapDutyCycles_[*it]);
     }
 
     minOverlapDutyCycles_[i] = maxOverlapDuty * minPctOverlapDutyCycles_;
@@ -643,21 +1046,51 @@ void SpatialPooler::updateMinDutyCyclesLocal_() {
 
 void SpatialPooler::updateDutyCycles_(const vector<SynapseIdx> &overlaps,
                                       SDR &active) {
+  NTA_ASSERT(overlaps.size() == numColumns_);
+  NTA_ASSERT(active.size == numColumns_);
+  const UInt period = std::min(dutyCyclePeriod_, iterationNum_);
+  NTA_ASSERT(period > 0);
 
-  // Turn the overlaps array into an SDR. Convert directly to flat-sparse to
-  // avoid copies and  type convertions.
-  SDR newOverlap({ numColumns_ });
-  auto &overlapsSparseVec = newOverlap.getSparse();
+  // Same as updateDutyCyclesHelper_ for both duty cycles, the decay is fused
+  // into one pass over the columns, and the overlaps are used directly without
+  // an SDR. The increments stay separate loops, so that the rounding is the
+  // same as with updateDutyCyclesHelper_ (no fused multiply-add).
+  const Real decay     = (period - 1) / static_cast<Real>(period);
+  const Real increment = 1.0f / period;
+  if( lazyDutyCycles_ ) {
+    if( decay > 0.0f ) {
+      dutyCycleClock_ += std::log( static_cast<double>(decay) );
+    } else { // period 1, all the history is forgotten
+      overlapDutyCycles_.assign(numColumns_, 0.0f);
+      activeDutyCycles_.assign(numColumns_, 0.0f);
+      resetDutyCycleClock_();
+    }
+    for (UInt i = 0; i < numColumns_; i++) {
+      if( overlaps[i] != 0 ) {
+        decayDutyCycles_(i);
+        overlapDutyCycles_[i] += increment;
+        updateWeakClock_(i);
+      }
+    }
+    for(const auto idx : active.getSparse()) {
+      decayDutyCycles_(idx);
+      activeDutyCycles_[idx] += increment;
+    }
+    return;
+  }
+
+  Real *overlapDC = overlapDutyCycles_.data();
+  Real *activeDC  = activeDutyCycles_.data();
+  for (UInt i = 0; i < numColumns_; i++) {
+    overlapDC[i] *= decay;
+    activeDC[i]  *= decay;
+  }
   for (UInt i = 0; i < numColumns_; i++) {
     if( overlaps[i] != 0 )
-      overlapsSparseVec.push_back( i );
+      overlapDC[i] += increment;
   }
-  newOverlap.setSparse( overlapsSparseVec );
-
-  const UInt period = std::min(dutyCyclePeriod_, iterationNum_);
-
-  updateDutyCyclesHelper_(overlapDutyCycles_, newOverlap, period);
-  updateDutyCyclesHelper_(activeDutyCycles_, active, period);
+  for(const auto idx : active.getSparse())
+    activeDC[idx] += increment;
 }
 
 
@@ -676,21 +1109,19 @@ Real SpatialPooler::avgColumnsPerInput_() const {
 Real SpatialPooler::avgConnectedSpanForColumnND_(const UInt column) const {
   NTA_ASSERT(column < numColumns_);
 
-  //get connected synapses
-  const auto& connectedDense = getPermanence( column, synPermConnected_ + htm::Epsilon );
-
   const auto numDimensions = inputDimensions_.size();
   vector<UInt> maxCoord(numDimensions, 0);
   vector<UInt> minCoord(numDimensions, *max_element(inputDimensions_.begin(),
                                                     inputDimensions_.end()));
   const CoordinateConverterND conv(inputDimensions_);
   bool all_zero = true;
-  for(UInt i = 0; i < numInputs_; i++) {
-    if( connectedDense[i] < synPermConnected_ ) // 0.0 for empty == not-conected values
+  vector<UInt> columnCoord;
+  //iterate the connected synapses, not a dense array of all the inputs
+  for(const auto syn : connections_.synapsesForSegment( column )) {
+    if( connections_.permanenceForSynapse( syn ) < synPermConnected_ + htm::Epsilon )
       continue;
     all_zero = false;
-    vector<UInt> columnCoord;
-    conv.toCoord(i, columnCoord);
+    conv.toCoord(connections_.presynapticCellForSynapse( syn ), columnCoord);
     for (size_t j = 0; j < columnCoord.size(); j++) {
       maxCoord[j] = max(maxCoord[j], columnCoord[j]); //FIXME this computation may be flawed
       minCoord[j] = min(minCoord[j], columnCoord[j]);
@@ -709,8 +1140,12 @@ Real SpatialPooler::avgConnectedSpanForColumnND_(const UInt column) const {
 
 void SpatialPooler::adaptSynapses_(const SDR &input,
                                    const SDR &active) {
-  for(const auto &column : active.getSparse()) {
-    connections_.adaptSegment(column, input, synPermActiveInc_, synPermInactiveDec_);
+  const auto &columns = active.getSparse(); //segment == column
+  connections_.adaptSegments(columns, input, synPermActiveInc_, synPermInactiveDec_);
+  if( implicitFloor_ > 0.0f ) {
+    adaptImplicitSynapses_(input, columns);
+  }
+  for(const auto &column : columns) {
     connections_.raisePermanencesToThreshold( column, stimulusThreshold_ );
   }
 }
@@ -718,14 +1153,88 @@ void SpatialPooler::adaptSynapses_(const SDR &input,
 
 void SpatialPooler::bumpUpWeakColumns_() {
   for (size_t i = 0; i < numColumns_; i++) {
-    if (overlapDutyCycles_[i] >= minOverlapDutyCycles_[i]) {
+    if (lazyDutyCycles_ ? not (dutyCycleClock_ < weakClocks_[i])
+                        : overlapDutyCycles_[i] >= minOverlapDutyCycles_[i]) {
       continue;
     }
     connections_.bumpSegment( static_cast<Segment>(i), synPermBelowStimulusInc_ );
+    if( implicitFloor_ > 0.0f ) {
+      materializePool_( static_cast<UInt>(i), synPermBelowStimulusInc_, nullptr );
+    }
+  }
+}
+
+
+void SpatialPooler::setLazyDutyCycles(const bool enable) {
+  syncDutyCycles_();
+  lazyDutyCycles_ = enable;
+  resetDutyCycleClock_();
+}
+
+
+void SpatialPooler::decayDutyCycles_(const UInt column) {
+  const double missed = dutyCycleClock_ - dutyCycleStamps_[column];
+  if( missed == 0.0 ) return;
+  const Real decay = static_cast<Real>( std::exp(missed) );
+  overlapDutyCycles_[column] *= decay;
+  activeDutyCycles_[column]  *= decay;
+  dutyCycleStamps_[column] = dutyCycleClock_;
+}
+
+
+void SpatialPooler::syncDutyCycles_() {
+  if( not lazyDutyCycles_ ) return;
+  for (UInt i = 0; i < numColumns_; i++) {
+    decayDutyCycles_(i);
+  }
+  resetDutyCycleClock_();
+}
+
+
+void SpatialPooler::resetDutyCycleClock_() {
+  dutyCycleClock_ = 0.0;
+  if( not lazyDutyCycles_ ) {
+    dutyCycleStamps_.clear();
+    weakClocks_.clear();
+    return;
+  }
+  dutyCycleStamps_.assign(numColumns_, 0.0);
+  weakClocks_.resize(numColumns_);
+  for (UInt i = 0; i < numColumns_; i++) {
+    updateWeakClock_(i);
+  }
+}
+
+
+void SpatialPooler::updateWeakClock_(const UInt column) {
+  // overlapDutyCycle * exp(clock - stamp) < minOverlapDutyCycle
+  const double dutyCycle = overlapDutyCycles_[column];
+  const double minimum   = minOverlapDutyCycles_[column];
+  double &weakClock = weakClocks_[column];
+  if( minimum <= 0.0 ) {
+    weakClock = -std::numeric_limits<double>::infinity(); //never weak
+  } else if( dutyCycle <= 0.0 ) {
+    weakClock = std::numeric_limits<double>::infinity(); //always weak
+  } else {
+    weakClock = dutyCycleStamps_[column] + std::log(minimum / dutyCycle);
   }
 }
 
 
+vector<Real> SpatialPooler::dutyCyclesNow_(const vector<Real> &dutyCycles) const {
+  vector<Real> now(dutyCycles);
+  if( lazyDutyCycles_ ) {
+    for (UInt i = 0; i < numColumns_; i++) {
+      const double missed = dutyCycleClock_ - dutyCycleStamps_[i];
+      if( missed != 0.0 ) {
+        now[i] *= static_cast<Real>( std::exp(missed) );
+      }
+    }
+  }
+  return now;
+}
+
+
 void SpatialPooler::updateDutyCyclesHelper_(vector<Real> &dutyCycles,
                                             const SDR &newValues,
                                             const UInt period) {
@@ -749,6 +1258,14 @@ void SpatialPooler::updateDutyCyclesHelper_(vector<Real> &dutyCycles,
 
 
 void SpatialPooler::updateBoostFactors_() {
+  boostFixedValid_ = false;
+  if (boostStrength_ < htm::Epsilon) {
+    // Disabled boosting is neutral, also after setBoostStrength(0) of a
+    // trained SP.
+    std::fill(boostFactors_.begin(), boostFactors_.end(), 1.0f);
+    return;
+  }
+  syncDutyCycles_(); //reads all the duty cycles
   if (globalInhibition_) {
     updateBoostFactorsGlobal_();
   } else {
@@ -780,7 +1297,7 @@ void SpatialPooler::updateBoostFactorsGlobal_() {
   } else {
     targetDensity = localAreaDensity_;
   }
-  
+
   for (size_t i = 0; i < numColumns_; ++i) { 
     applyBoosting_(i, targetDensity, activeDutyCycles_, boostStrength_, boostFactors_);
   }
@@ -788,21 +1305,15 @@ void SpatialPooler::updateBoostFactorsGlobal_() {
 
 
 void SpatialPooler::updateBoostFactorsLocal_() {
+  const bool cached = updateNeighborTable_();
+  vector<UInt> neighbors; // only used if the neighborhoods are too large to cache
   for (UInt i = 0; i < numColumns_; ++i) {
-    UInt numNeighbors = 0u;
+    const auto range = neighborhood_(i, cached, neighbors);
     Real localActivityDensity = 0.0f;
-
-    if (wrapAround_) {
-      for(const auto neighbor: WrappingNeighborhood(i, inhibitionRadius_, columnDimensions_)) {
-        localActivityDensity += activeDutyCycles_[neighbor];
-        numNeighbors += 1;
-      }
-    } else {
-      for(const auto neighbor: Neighborhood(i, inhibitionRadius_, columnDimensions_)) {
-        localActivityDensity += activeDutyCycles_[neighbor];
-        numNeighbors += 1;
-      }
+    for (auto it = range.first; it != range.second; it++) {
+      localActivityDensity += activeDutyCycles_[*it];
     }
+    const UInt numNeighbors = static_cast<UInt>(range.second - range.first);
 
     const Real targetDensity = localActivityDensity / numNeighbors;
     applyBoosting_(i, targetDensity, activeDutyCycles_, boostStrength_, boostFactors_);
@@ -818,8 +1329,7 @@ void SpatialPooler::updateBookeepingVars_(bool learn) {
 }
 
 
-void SpatialPooler::inhibitColumns_(const vector<Real> &overlaps,
-                                    vector<CellIdx> &activeColumns) const {
+Real SpatialPooler::inhibitionDensity_() const {
   Real density = localAreaDensity_;
   if (numActiveColumnsPerInhArea_ > 0) {
     UInt inhibitionArea =
@@ -828,10 +1338,20 @@ void SpatialPooler::inhibitColumns_(const vector<Real> &overlaps,
     density = ((Real)numActiveColumnsPerInhArea_) / inhibitionArea;
     density = min(density, (Real)MAX_LOCALAREADENSITY);
   }
+  return density;
+}
 
-  if (globalInhibition_ ||
-      inhibitionRadius_ >
-          *max_element(columnDimensions_.begin(), columnDimensions_.end())) {
+
+bool SpatialPooler::isGlobalInhibition_() const {
+  return globalInhibition_ ||
+         inhibitionRadius_ > *max_element(columnDimensions_.begin(), columnDimensions_.end());
+}
+
+
+void SpatialPooler::inhibitColumns_(const vector<Real> &overlaps,
+                                    vector<CellIdx> &activeColumns) const {
+  const Real density = inhibitionDensity_();
+  if (isGlobalInhibition_()) {
     inhibitColumnsGlobal_(overlaps, density, activeColumns);
   } else {
     inhibitColumnsLocal_(overlaps, density, activeColumns);
@@ -849,6 +1369,14 @@ void SpatialPooler::inhibitColumnsGlobal_(const vector<Real> &overlaps,
   const UInt numDesired = (UInt)(density * numColumns_);
   NTA_CHECK(numDesired > 0) << "Not enough columns (" << numColumns_ << ") "
                             << "for desired density (" << density << ").";
+  if( backend_ ) {
+    backend_->topK(overlaps, numDesired, static_cast<Real>(stimulusThreshold_), activeColumns);
+    return;
+  }
+  if( inhibitColumnsCounting_(overlaps, numDesired, activeColumns) ) {
+    return;
+  }
+
   // Sort the columns by the amount of overlap.  First make a list of all of the
   // column indexes.
   activeColumns.reserve(numColumns_);
@@ -879,6 +1407,270 @@ void SpatialPooler::inhibitColumnsGlobal_(const vector<Real> &overlaps,
 }
 
 
+const UInt SpatialPooler::MAX_COUNTING_SELECT = 1u << 16;
+
+bool SpatialPooler::inhibitColumnsCounting_(const vector<Real> &overlaps,
+                                            const UInt numDesired,
+                                            vector<UInt> &activeColumns) const {
+  // Check the overlaps are integers & find the largest.
+  UInt maxOverlap = 0u;
+  for(const Real o : overlaps) {
+    if( !(o >= 0.0f and o <= (Real)MAX_COUNTING_SELECT) ) return false;
+    const UInt value = static_cast<UInt>(o);
+    if( (Real)value != o ) return false;
+    maxOverlap = max(maxOverlap, value);
+  }
+
+  auto &histogram = overlapHistogram_;
+  histogram.assign(maxOverlap + 1u, 0u);
+  for(const Real o : overlaps) {
+    histogram[static_cast<UInt>(o)]++;
+  }
+
+  // Find the smallest winning overlap. Columns above it all win, columns equal
+  // to it win only while there are places left.
+  UInt threshold = maxOverlap;
+  UInt numAbove  = 0u;
+  while( numAbove + histogram[threshold] < numDesired ) {
+    numAbove += histogram[threshold];
+    threshold--;
+  }
+  UInt numAtThreshold = numDesired - numAbove;
+
+  // Turn the histogram into the output positions, winners are sorted by
+  // decreasing overlap. Visiting the columns by decreasing index sorts the
+  // ties by decreasing index, same as the comparison in inhibitColumnsGlobal_.
+  UInt position = 0u;
+  for(UInt value = maxOverlap; value > threshold; value--) {
+    const UInt count = histogram[value];
+    histogram[value] = position;
+    position += count;
+  }
+  histogram[threshold] = position;
+
+  activeColumns.resize(numDesired);
+  for(UInt column = numColumns_; column-- > 0u; ) {
+    const UInt value = static_cast<UInt>(overlaps[column]);
+    if( value < threshold ) continue;
+    if( value == threshold ) {
+      if( numAtThreshold == 0u ) continue;
+      numAtThreshold--;
+    }
+    activeColumns[histogram[value]++] = column;
+  }
+
+  // Remove sub-threshold winners
+  while( !activeColumns.empty() &&
+         overlaps[activeColumns.back()] < stimulusThreshold_)
+      activeColumns.pop_back();
+  return true;
+}
+
+
+void SpatialPooler::setFixedPointBoosting(const bool enable) {
+  fixedPointBoosting_ = enable;
+  boostFixedValid_ = false;
+  if( not enable ) {
+    vector<UInt16>().swap(boostFactorsFixed_);
+    vector<UInt32>().swap(boostedFixed_);
+    vector<UInt>().swap(radixCandidates_);
+  }
+}
+
+
+void SpatialPooler::updateFixedPointBoost_() {
+  boostedFixed_.resize(numColumns_);
+  if( boostFixedValid_ ) return;
+  // The largest factor maps to the largest UInt16.
+  const Real maxFactor = boostFactors_.empty() ? 1.0f : *std::max_element(boostFactors_.begin(), boostFactors_.end());
+  NTA_CHECK(maxFactor > 0.0f) << "SpatialPooler: fixed point boosting needs positive boost factors.";
+  boostFixedScale_ = static_cast<Real>(std::numeric_limits<UInt16>::max()) / maxFactor;
+  boostFactorsFixed_.resize(numColumns_);
+  for(UInt i = 0; i < numColumns_; i++) {
+    const long q = std::lround(boostFactors_[i] * boostFixedScale_);
+    boostFactorsFixed_[i] = static_cast<UInt16>( boostFactors_[i] > 0.0f ? std::max(q, 1l) : 0l );
+  }
+  boostFixedValid_ = true;
+}
+
+
+void SpatialPooler::inhibitColumnsFixedPoint_(const UInt numDesired, vector<UInt> &activeColumns) const {
+  NTA_CHECK(numDesired > 0) << "Not enough columns (" << numColumns_ << ") "
+                            << "for desired density (" << inhibitionDensity_() << ").";
+  activeColumns.clear();
+  auto &candidates = radixCandidates_;
+  candidates.resize(numColumns_);
+  std::iota(candidates.begin(), candidates.end(), 0u);
+  UInt need = numDesired;
+
+  UInt histogram[256];
+  for(int shift = 24; shift >= 0 and need > 0u; shift -= 8) {
+    std::fill(histogram, histogram + 256, 0u);
+    for(const auto column : candidates) {
+      histogram[(boostedFixed_[column] >> shift) & 0xFFu]++;
+    }
+    // the digit of the need'th largest value
+    UInt digit = 255u;
+    UInt numAbove = 0u;
+    while( numAbove + histogram[digit] < need ) {
+      numAbove += histogram[digit];
+      digit--;
+    }
+    size_t numEqual = 0u;
+    for(const auto column : candidates) {
+      const UInt d = (boostedFixed_[column] >> shift) & 0xFFu;
+      if( d > digit ) {
+        activeColumns.push_back(column);
+      } else if( d == digit ) {
+        candidates[numEqual++] = column; //in increasing index order
+      }
+    }
+    candidates.resize(numEqual);
+    need -= numAbove;
+    if( need == candidates.size() ) break; //all of them win
+  }
+  // the remaining candidates have equal values, the higher indices win
+  activeColumns.insert(activeColumns.end(), candidates.end() - need, candidates.end());
+
+  // Remove sub-threshold winners
+  const UInt64 threshold = static_cast<UInt64>(std::ceil(stimulusThreshold_ * static_cast<Real64>(boostFixedScale_)));
+  activeColumns.erase(std::remove_if(activeColumns.begin(), activeColumns.end(),
+    [&](const UInt c) { return boostedFixed_[c] < threshold; }), activeColumns.end());
+}
+
+
+void SpatialPooler::setIncrementalInhibition(const bool enable) {
+  incrementalInhibition_ = enable;
+  inhibitionBucketsValid_ = false;
+  connections_.setIncrementalActivity(enable);
+  if( not enable ) {
+    vector<UInt>().swap(bucketOverlap_);
+    vector<UInt>().swap(bucketPosition_);
+    vector<vector<UInt>>().swap(inhibitionBuckets_);
+  }
+}
+
+
+void SpatialPooler::updateInhibitionBuckets_(const vector<SynapseIdx> &overlaps) {
+  NTA_ASSERT(overlaps.size() == numColumns_);
+  if( bucketOverlap_.size() != numColumns_ ) { //all the columns start at overlap 0
+    bucketOverlap_.assign(numColumns_, 0u);
+    bucketPosition_.resize(numColumns_);
+    std::iota(bucketPosition_.begin(), bucketPosition_.end(), 0u);
+    inhibitionBuckets_.assign(1u, bucketPosition_);
+    inhibitionBucketsValid_ = false;
+  }
+
+  const auto move = [&](const UInt column) {
+    const UInt overlap = overlaps[column];
+    const UInt old = bucketOverlap_[column];
+    if( overlap == old ) return;
+    auto &from = inhibitionBuckets_[old];
+    const UInt last = from.back();
+    from[bucketPosition_[column]] = last;
+    bucketPosition_[last] = bucketPosition_[column];
+    from.pop_back();
+    if( overlap >= inhibitionBuckets_.size() ) inhibitionBuckets_.resize(overlap + 1u);
+    bucketOverlap_[column]  = overlap;
+    bucketPosition_[column] = static_cast<UInt>(inhibitionBuckets_[overlap].size());
+    inhibitionBuckets_[overlap].push_back(column);
+  };
+
+  if( inhibitionBucketsValid_ and connections_.incrementalChangedSegments(changedColumns_) ) {
+    for(const auto column : changedColumns_) move(column);
+  } else {
+    for(UInt column = 0u; column < numColumns_; column++) move(column);
+  }
+  inhibitionBucketsValid_ = true;
+}
+
+
+void SpatialPooler::inhibitColumnsIncremental_(const UInt numDesired, vector<UInt> &activeColumns) const {
+  NTA_CHECK(numDesired > 0) << "Not enough columns (" << numColumns_ << ") "
+                            << "for desired density (" << inhibitionDensity_() << ").";
+  activeColumns.clear();
+  // Same as inhibitColumnsCounting_: the columns above the smallest winning
+  // overlap all win, those equal to it win by decreasing index.
+  for(size_t overlap = inhibitionBuckets_.size(); overlap-- > 0u; ) {
+    const auto &bucket = inhibitionBuckets_[overlap];
+    if( overlap < stimulusThreshold_ ) break; //remove sub-threshold winners
+    if( activeColumns.size() + bucket.size() <= numDesired ) {
+      activeColumns.insert(activeColumns.end(), bucket.begin(), bucket.end());
+      if( activeColumns.size() == numDesired ) break;
+      continue;
+    }
+    const size_t numAtThreshold = numDesired - activeColumns.size();
+    const size_t begin = activeColumns.size();
+    activeColumns.insert(activeColumns.end(), bucket.begin(), bucket.end());
+    std::nth_element(activeColumns.begin() + begin, activeColumns.begin() + begin + numAtThreshold,
+                     activeColumns.end(), std::greater<UInt>());
+    activeColumns.resize(numDesired);
+    break;
+  }
+}
+
+
+const size_t SpatialPooler::MAX_NEIGHBOR_TABLE = 1u << 24;
+
+void SpatialPooler::appendNeighbors_(const UInt column, vector<UInt> &neighbors) const {
+  NTA_ASSERT(inhibitionNeighborhood_.radius() == inhibitionRadius_ and
+             inhibitionNeighborhood_.wrapAround() == wrapAround_);
+  inhibitionNeighborhood_.appendNeighbors(column, neighbors);
+}
+
+
+std::pair<const UInt*, const UInt*> SpatialPooler::neighborhood_(const UInt column, const bool cached,
+                                                                 vector<UInt> &scratch) const {
+  if (cached) {
+    return {neighborTable_.data() + neighborOffsets_[column],
+            neighborTable_.data() + neighborOffsets_[column + 1]};
+  }
+  scratch.clear();
+  appendNeighbors_(column, scratch);
+  return {scratch.data(), scratch.data() + scratch.size()};
+}
+
+
+bool SpatialPooler::updateNeighborTable_() const {
+  if (neighborTableValid_ and neighborTableRadius_ == inhibitionRadius_ and
+      neighborTableWrap_ == wrapAround_) {
+    return true;
+  }
+  if (inhibitionNeighborhood_.radius() != inhibitionRadius_ or
+      inhibitionNeighborhood_.wrapAround() != wrapAround_ or
+      inhibitionNeighborhood_.dimensions() != columnDimensions_) {
+    inhibitionNeighborhood_ = NeighborhoodTable(inhibitionRadius_, columnDimensions_, wrapAround_);
+  }
+  neighborTableValid_ = false;
+  neighborOffsets_.clear();
+  neighborTable_.clear();
+
+  // Upper bound of the neighborhood size, the table is not built if too large.
+  size_t area = 1u;
+  const size_t diam = 2u * inhibitionRadius_ + 1u;
+  for (const auto dim : columnDimensions_) {
+    area *= std::min<size_t>(diam, dim);
+  }
+  if (area * numColumns_ > MAX_NEIGHBOR_TABLE) {
+    neighborOffsets_.shrink_to_fit();
+    neighborTable_.shrink_to_fit();
+    return false;
+  }
+
+  neighborTable_.reserve(area * numColumns_);
+  neighborOffsets_.reserve(numColumns_ + 1u);
+  neighborOffsets_.push_back(0u);
+  for (UInt column = 0; column < numColumns_; column++) {
+    appendNeighbors_(column, neighborTable_);
+    neighborOffsets_.push_back(static_cast<UInt>(neighborTable_.size()));
+  }
+  neighborTableRadius_ = inhibitionRadius_;
+  neighborTableWrap_   = wrapAround_;
+  neighborTableValid_  = true;
+  return true;
+}
+
+
 void SpatialPooler::inhibitColumnsLocal_(const vector<Real> &overlaps,
                                          Real density,
                                          vector<UInt> &activeColumns) const {
@@ -888,58 +1680,46 @@ void SpatialPooler::inhibitColumnsLocal_(const vector<Real> &overlaps,
   // selected are treated as "bigger".
   vector<bool> activeColumnsDense(numColumns_, false);
 
+  // In wrapAround, number of neighbors to be considered is solely a function
+  // of the inhibition radius, the number of dimensions, and of the size of
+  // each of those dimensions.
+  UInt numNeighborsWrap = 1;
+  const UInt diam = 2*inhibitionRadius_ + 1;
+  for (const auto dim : columnDimensions_) {
+    numNeighborsWrap *= std::min(diam, dim);
+  }
+  numNeighborsWrap -= 1;
+
+  const bool cached = updateNeighborTable_();
+  vector<UInt> neighbors; // only used if the neighborhoods are too large to cache
+
   for (UInt column = 0; column < numColumns_; column++) {
     if (overlaps[column] < stimulusThreshold_) {
       continue;
     }
 
-    UInt numNeighbors = 0;
+    const auto range = neighborhood_(column, cached, neighbors);
+    const UInt numNeighbors = wrapAround_ ? numNeighborsWrap :
+                              static_cast<UInt>(range.second - range.first) - 1u; //without the column
+    const UInt numActive = (UInt)(0.5f + (density * (numNeighbors + 1)));
     UInt numBigger = 0;
 
-
-      if (wrapAround_) {
-         numNeighbors = 0;  // In wrapAround, number of neighbors to be considered is solely a function of the inhibition radius, 
-	 // ... the number of dimensions, and of the size of each of those dimenion
-         UInt predN = 1;
-	 const UInt diam = 2*inhibitionRadius_ + 1; //the inh radius can change, that's why we recompute here
-         for (const auto dim : columnDimensions_) {
-           predN *= std::min(diam, dim);
-         }
-         predN -= 1;
-         numNeighbors = predN;
-         const UInt numActive_wrap = static_cast<UInt>(0.5f + (density * (numNeighbors + 1)));
-
-        for(const auto neighbor: WrappingNeighborhood(column, inhibitionRadius_,columnDimensions_)) { //TODO if we don't change inh radius (changes only every isUpdateRound()),
-		// then these values can be cached -> faster local inh
-          if (neighbor == column) {
-            continue;
-          }
-
-          const Real difference = overlaps[neighbor] - overlaps[column];
-          if (difference > 0 || (difference == 0 && activeColumnsDense[neighbor])) {
-            numBigger++;
-	    if (numBigger >= numActive_wrap) { break; }
-          }
-	}
-      } else {
-        for(const auto neighbor: Neighborhood(column, inhibitionRadius_, columnDimensions_)) {
-          if (neighbor == column) {
-            continue;
-          }
-          numNeighbors++;
-
-          const Real difference = overlaps[neighbor] - overlaps[column];
-          if (difference > 0 || (difference == 0 && activeColumnsDense[neighbor])) {
-            numBigger++;
-          }
-	}
+    for (auto it = range.first; it != range.second; it++) {
+      const UInt neighbor = *it;
+      if (neighbor == column) {
+        continue;
       }
-
-      const UInt numActive = (UInt)(0.5f + (density * (numNeighbors + 1)));
-      if (numBigger < numActive) {
-        activeColumns.push_back(column);
-        activeColumnsDense[column] = true;
+      const Real difference = overlaps[neighbor] - overlaps[column];
+      if (difference > 0 || (difference == 0 && activeColumnsDense[neighbor])) {
+        numBigger++;
+        if (numBigger >= numActive) { break; }
       }
+    }
+
+    if (numBigger < numActive) {
+      activeColumns.push_back(column);
+      activeColumnsDense[column] = true;
+    }
   }
 }
 
@@ -1010,6 +1790,153 @@ void SpatialPooler::printState(const vector<Real> &state, std::ostream& out) con
 }
 
 
+template<typename T>
+static size_t vectorBytes(const vector<T> &v) { return v.capacity() * sizeof(T); }
+
+size_t SpatialPooler::memoryUsage() const {
+  size_t bytes = connections.memoryUsage();
+  bytes += vectorBytes(boostFactors_) + vectorBytes(overlapDutyCycles_) +
+           vectorBytes(activeDutyCycles_) + vectorBytes(minOverlapDutyCycles_) +
+           vectorBytes(minActiveDutyCycles_) + vectorBytes(dutyCycleStamps_) +
+           vectorBytes(weakClocks_) + vectorBytes(boostedOverlaps_);
+  bytes += vectorBytes(neighborOffsets_) + vectorBytes(neighborTable_) + vectorBytes(overlapHistogram_);
+  bytes += vectorBytes(packedSynapses_) + vectorBytes(packedOffsets_) +
+           vectorBytes(packedFirstWord_) + vectorBytes(packedInput_);
+  for (const auto &v : batchInputs_)   bytes += vectorBytes(v);
+  for (const auto &v : batchOverlaps_) bytes += vectorBytes(v);
+  bytes += vectorBytes(bucketOverlap_) + vectorBytes(bucketPosition_) + vectorBytes(changedColumns_);
+  bytes += vectorBytes(boostFactorsFixed_) + vectorBytes(boostedFixed_) + vectorBytes(radixCandidates_);
+  bytes += vectorBytes(neighborsScratch_) + vectorBytes(poolScratch_) +
+           vectorBytes(explicitScratch_) + vectorBytes(forgetScratch_);
+  for (const auto &v : inhibitionBuckets_) bytes += vectorBytes(v);
+  return bytes;
+}
+
+
+void SpatialPooler::releaseCaches() {
+  neighborTableValid_ = false;
+  vector<UInt>().swap(neighborOffsets_);
+  vector<UInt>().swap(neighborTable_);
+  vector<UInt>().swap(overlapHistogram_);
+  packedValid_ = false;
+  vector<UInt64>().swap(packedSynapses_);
+  vector<size_t>().swap(packedOffsets_);
+  vector<UInt>().swap(packedFirstWord_);
+  vector<UInt64>().swap(packedInput_);
+  vector<vector<CellIdx>>().swap(batchInputs_);
+  vector<vector<SynapseIdx>>().swap(batchOverlaps_);
+  inhibitionBucketsValid_ = false;
+  vector<UInt>().swap(bucketOverlap_);
+  vector<UInt>().swap(bucketPosition_);
+  vector<vector<UInt>>().swap(inhibitionBuckets_);
+  vector<Segment>().swap(changedColumns_);
+  boostFixedValid_ = false;
+  vector<UInt16>().swap(boostFactorsFixed_);
+  vector<UInt32>().swap(boostedFixed_);
+  vector<UInt>().swap(radixCandidates_);
+}
+
+
+void SpatialPooler::saveFlat(const std::string &path) const {
+  FlatWriter out(path, "HTMSPOOL", FLAT_VERSION);
+  saveFlat(out);
+  out.close();
+}
+
+
+void SpatialPooler::loadFlat(const std::string &path) {
+  FlatReader in(path, "HTMSPOOL", FLAT_VERSION);
+  loadFlat(in);
+}
+
+
+void SpatialPooler::saveFlat(FlatWriter &out) const {
+  out.array(inputDimensions_);
+  out.array(columnDimensions_);
+  out.scalar(numInputs_);
+  out.scalar(numColumns_);
+  out.scalar(potentialRadius_);
+  out.scalar(potentialPct_);
+  out.scalar(initConnectedPct_);
+  out.scalar(globalInhibition_);
+  out.scalar(numActiveColumnsPerInhArea_);
+  out.scalar(localAreaDensity_);
+  out.scalar(stimulusThreshold_);
+  out.scalar(inhibitionRadius_);
+  out.scalar(dutyCyclePeriod_);
+  out.scalar(boostStrength_);
+  out.scalar(iterationNum_);
+  out.scalar(iterationLearnNum_);
+  out.scalar(spVerbosity_);
+  out.scalar(updatePeriod_);
+  out.scalar(synPermInactiveDec_);
+  out.scalar(synPermActiveInc_);
+  out.scalar(synPermBelowStimulusInc_);
+  out.scalar(synPermConnected_);
+  out.scalar(minPctOverlapDutyCycles_);
+  out.scalar(wrapAround_);
+  out.scalar(implicitFloor_);
+  out.scalar(potentialSeed_);
+  out.array(boostFactors_);
+  out.array(dutyCyclesNow_(overlapDutyCycles_));
+  out.array(dutyCyclesNow_(activeDutyCycles_));
+  out.array(minOverlapDutyCycles_);
+  std::stringstream rng;
+  rng_.save(rng);
+  out.string(rng.str());
+  connections_.saveFlat(out);
+}
+
+
+void SpatialPooler::loadFlat(FlatReader &in) {
+  in.array(inputDimensions_);
+  in.array(columnDimensions_);
+  numInputs_                  = in.scalar<UInt>();
+  numColumns_                 = in.scalar<UInt>();
+  potentialRadius_            = in.scalar<UInt>();
+  potentialPct_               = in.scalar<Real>();
+  initConnectedPct_           = in.scalar<Real>();
+  globalInhibition_           = in.scalar<bool>();
+  numActiveColumnsPerInhArea_ = in.scalar<Int>();
+  localAreaDensity_           = in.scalar<Real>();
+  stimulusThreshold_          = in.scalar<UInt>();
+  inhibitionRadius_           = in.scalar<UInt>();
+  dutyCyclePeriod_            = in.scalar<UInt>();
+  boostStrength_              = in.scalar<Real>();
+  iterationNum_               = in.scalar<UInt>();
+  iterationLearnNum_          = in.scalar<UInt>();
+  spVerbosity_                = in.scalar<UInt>();
+  updatePeriod_               = in.scalar<UInt>();
+  synPermInactiveDec_         = in.scalar<Real>();
+  synPermActiveInc_           = in.scalar<Real>();
+  synPermBelowStimulusInc_    = in.scalar<Real>();
+  synPermConnected_           = in.scalar<Real>();
+  minPctOverlapDutyCycles_    = in.scalar<Real>();
+  wrapAround_                 = in.scalar<bool>();
+  implicitFloor_              = in.scalar<Permanence>();
+  potentialSeed_              = in.scalar<UInt64>();
+  in.array(boostFactors_);
+  in.array(overlapDutyCycles_);
+  in.array(activeDutyCycles_);
+  in.array(minOverlapDutyCycles_);
+  std::stringstream rng(in.string());
+  rng_.load(rng);
+  connections_.loadFlat(in);
+  NTA_CHECK(boostFactors_.size() == numColumns_ and overlapDutyCycles_.size() == numColumns_ and
+            activeDutyCycles_.size() == numColumns_ and minOverlapDutyCycles_.size() == numColumns_ and
+            connections_.numCells() == numColumns_)
+    << "SpatialPooler::loadFlat: corrupt archive";
+
+  // initialize ephemeral members
+  boostedOverlaps_.resize(numColumns_);
+  neighborTableValid_ = false;
+  packedValid_ = false;
+  inhibitionBucketsValid_ = false;
+  boostFixedValid_ = false;
+  resetDutyCycleClock_();
+}
+
+
 /** equals implementation based on text serialization */
 bool SpatialPooler::operator==(const SpatialPooler& o) const{
   // Store the simple variables first.
@@ -1040,8 +1967,8 @@ bool SpatialPooler::operator==(const SpatialPooler& o) const{
   if (inputDimensions_      != o.inputDimensions_) return false;
   if (columnDimensions_     != o.columnDimensions_) return false;
   if (boostFactors_         != o.boostFactors_) return false;
-  if (overlapDutyCycles_    != o.overlapDutyCycles_) return false;
-  if (activeDutyCycles_     != o.activeDutyCycles_) return false;
+  if (dutyCyclesNow_(overlapDutyCycles_) != o.dutyCyclesNow_(o.overlapDutyCycles_)) return false;
+  if (dutyCyclesNow_(activeDutyCycles_)  != o.dutyCyclesNow_(o.activeDutyCycles_)) return false;
   if (minOverlapDutyCycles_ != o.minOverlapDutyCycles_) return false;
 
   // compare connections
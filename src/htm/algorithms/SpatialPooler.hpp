@@ -23,18 +23,24 @@
 #define NTA_spatial_pooler_HPP
 
 #include <iostream>
+#include <memory>
 #include <vector>
 #include <iomanip> // std::setprecision
+#include <htm/algorithms/ComputeBackend.hpp>
 #include <htm/algorithms/Connections.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Sdr.hpp>
+#include <htm/utils/AlgorithmStats.hpp>
+#include <htm/utils/Topology.hpp>
 
 
 namespace htm {
 
 using namespace std;
 
+class FrozenSpatialPooler;
+
 /**
  * CLA spatial pooler implementation in C++.
  *
@@ -60,6 +66,8 @@ using namespace std;
  */
 class SpatialPooler : public Serializable
 {
+  friend class FrozenSpatialPooler;
+
 public:
   SpatialPooler();
   SpatialPooler(const vector<UInt> inputDimensions, const vector<UInt> columnDimensions,
@@ -259,6 +267,30 @@ public:
    */
   virtual const vector<SynapseIdx> compute(const SDR &input, const bool learn, SDR &active);
 
+  /**
+   * Inference (learn=false) over a batch of inputs, eg. when evaluating a
+   * dataset.  The outputs are the same as those of `compute(inputs[i], false,
+   * outputs[i])` called for each input in order, including the bookkeeping
+   * (getIterationNum, getBoostedOverlaps of the last input).
+   *
+   * The overlaps of a chunk of the batch are computed in one pass over the
+   * presynaptic maps, and in parallel over the inputs if threads are enabled
+   * (@see setNumThreads, Connections::computeActivity).  Inhibition stays
+   * serial.  The chunks hold up to MAX_BATCH_OVERLAPS overlap counts, so the
+   * scratch memory does not grow with the batch.
+   *
+   * @param inputs SDRs with the dimensions of the input.
+   * @param outputs Output, resized to the number of inputs; the active
+   *        columns of each input.
+   */
+  void compute(const vector<SDR> &inputs, vector<SDR> &outputs);
+
+  /**
+   * @returns a read-only, inference-only copy of this SP, @see
+   * FrozenSpatialPooler. Include FrozenSpatialPooler.hpp to use it.
+   */
+  FrozenSpatialPooler freeze() const;
+
 
   /**
    * Get the version number of this spatial pooler.
@@ -301,9 +333,13 @@ public:
        CEREAL_NVP(synPermConnected_),
        CEREAL_NVP(minPctOverlapDutyCycles_),
        CEREAL_NVP(wrapAround_));
+    ar(CEREAL_NVP(implicitFloor_),
+       CEREAL_NVP(potentialSeed_));
     ar(CEREAL_NVP(boostFactors_));
-    ar(CEREAL_NVP(overlapDutyCycles_));
-    ar(CEREAL_NVP(activeDutyCycles_));
+    const vector<Real> overlapDutyCycles = dutyCyclesNow_(overlapDutyCycles_);
+    const vector<Real> activeDutyCycles  = dutyCyclesNow_(activeDutyCycles_);
+    ar(cereal::make_nvp("overlapDutyCycles_", overlapDutyCycles));
+    ar(cereal::make_nvp("activeDutyCycles_", activeDutyCycles));
     ar(CEREAL_NVP(minOverlapDutyCycles_));
     ar(CEREAL_NVP(connections_));
     ar(CEREAL_NVP(rng_));
@@ -335,6 +371,8 @@ public:
        CEREAL_NVP(synPermConnected_),
        CEREAL_NVP(minPctOverlapDutyCycles_),
        CEREAL_NVP(wrapAround_));
+    ar(CEREAL_NVP(implicitFloor_),
+       CEREAL_NVP(potentialSeed_));
     ar(CEREAL_NVP(boostFactors_));
     ar(CEREAL_NVP(overlapDutyCycles_));
     ar(CEREAL_NVP(activeDutyCycles_));
@@ -344,6 +382,11 @@ public:
 
     // initialize ephemeral members
     boostedOverlaps_.resize(numColumns_);
+    neighborTableValid_ = false; //column dimensions might have changed
+    packedValid_ = false;
+    inhibitionBucketsValid_ = false;
+    boostFixedValid_ = false;
+    resetDutyCycleClock_();
   }
 
   /**
@@ -775,6 +818,173 @@ public:
    */
   const vector<Real> &getBoostedOverlaps() const;
 
+  /**
+   * Set the number of threads used by compute() for the overlaps.
+   *
+   * With more than one thread, the active input bits are partitioned across
+   * the threads, each counts the overlaps into its own vector, and the
+   * vectors are summed up in parallel over ranges of columns, where the
+   * boosting of each range is done in the same pass (@see
+   * Connections::setNumThreads).  Inhibition and learning stay serial.
+   * The results are identical to the single threaded SP.
+   *
+   * @param numThreads Number of threads including the calling thread.
+   *        Default 1 (no threading). Use 0 for all hardware threads.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setNumThreads(const UInt numThreads) { connections_.setNumThreads(numThreads); }
+  UInt getNumThreads() const noexcept { return connections.getNumThreads(); }
+
+  /**
+   * Set a ComputeBackend: compute() with learn == false then counts the
+   * overlaps with the backend, and the global inhibition selects its winners
+   * with the backend.  The results are identical to the built in compute.
+   *
+   * @param backend The backend, eg. `ComputeBackend::create("cpu", 0u)`,
+   *        or nullptr (default) for the built in compute.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setComputeBackend(const std::shared_ptr<ComputeBackend> &backend) { backend_ = backend; }
+  const std::shared_ptr<ComputeBackend> &getComputeBackend() const noexcept { return backend_; }
+
+  /**
+   * Estimate the heap memory held by this SP, in bytes: the Connections,
+   * the per column state and the lazily built caches.
+   */
+  size_t memoryUsage() const;
+
+  /**
+   * Release the lazily built caches (the neighbor table of the local
+   * inhibition, the packed synapses) and the scratch buffers.  They are
+   * rebuilt when needed, so this trades some speed for memory.
+   */
+  void releaseCaches();
+
+  /**
+   * Hold the periodic maintenance of the Connections, @see
+   * Connections::holdMaintenance.
+   */
+  void holdMaintenance(const bool hold) noexcept { connections_.holdMaintenance(hold); }
+
+  /**
+   * Save to / load from a flat binary file, which loads large models much
+   * faster than the cereal archives (@see Connections::saveFlat).  The file
+   * is versioned (FLAT_VERSION) and not portable across byte orders.
+   */
+  void saveFlat(const std::string &path) const;
+  void loadFlat(const std::string &path);
+  void saveFlat(FlatWriter &out) const;
+  void loadFlat(FlatReader &in);
+  static const UInt32 FLAT_VERSION = 3u;
+
+  /**
+   * Enable/disable the lazy bookkeeping of the duty cycles.
+   *
+   * Normally each learning step decays the overlap & active duty cycles of
+   * all the columns.  In the lazy mode every column remembers when it was
+   * last updated, and is decayed in closed form, by the product of the
+   * decays it has missed, only when its value is needed: when the column
+   * has a non-zero overlap or is active, on update rounds and on reads.
+   * Weak columns (@see bumpUpWeakColumns_) are found by comparing the time
+   * against when each column's duty cycle falls below its minimum, with no
+   * write per column.  This pays off with boosting off (the default), the
+   * boosting reads all the duty cycles every learning step.
+   *
+   * The duty cycles differ from the eager ones only by the floating point
+   * rounding of the decay.
+   *
+   * This is a runtime setting, it is not serialized.  The serialized (&
+   * compared) duty cycles are always the up to date values.
+   */
+  void setLazyDutyCycles(const bool enable);
+  bool getLazyDutyCycles() const noexcept { return lazyDutyCycles_; }
+
+  /**
+   * Enable/disable the incremental global inhibition, for slowly changing
+   * inputs.
+   *
+   * The SP keeps the columns bucketed by their overlap across compute()
+   * calls.  With learning off, the overlaps are counted incrementally (@see
+   * Connections::setIncrementalActivity, which this enables too), only the
+   * columns on the synapses of the input bits which turned on or off move to
+   * another bucket, and the winners are read off the top buckets.  So the
+   * cost of the inhibition follows the change of the input, instead of a
+   * selection over all the columns.  The active columns are identical to the
+   * normal compute.
+   *
+   * It applies to the global inhibition with boosting off (the integer
+   * overlaps are the bucket keys), without a ComputeBackend; otherwise, and
+   * when learning, compute() works as usual.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setIncrementalInhibition(const bool enable);
+  bool getIncrementalInhibition() const noexcept { return incrementalInhibition_; }
+
+  /**
+   * Enable/disable the fixed point boosting.
+   *
+   * The boost factors are quantized to 16 bit integers, relative to the
+   * largest one, and the boosted overlaps are the 32 bit integer products
+   * overlap * quantized factor, which vectorize well.  The global inhibition
+   * then selects the winners among the integers by a radix select, so the
+   * active columns do not depend on the floating point rounding of the
+   * boosting.  getBoostedOverlaps() & the local inhibition see the
+   * integers converted back to the scale of the overlaps.
+   *
+   * The active columns may differ from the floating point boosting where
+   * boost factors closer than the quantization step decide.  Only has an
+   * effect while boosting is on (boostStrength > 0).
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setFixedPointBoosting(const bool enable);
+  bool getFixedPointBoosting() const noexcept { return fixedPointBoosting_; }
+
+  /**
+   * Memory-lean mode for large inputs: the potential pools are implicit.
+   *
+   * Most synapses of a column are potential but far from connected.  In
+   * this mode a column keeps only the synapses of permanence >= @param floor
+   * in the Connections; its full potential pool is regenerated from
+   * (seed, column) when learning needs it.  The implicit synapses are at
+   * the floor: when their input is active in an active column they grow by
+   * synPermActiveInc and become explicit, and the bump of a weak column
+   * makes its whole pool explicit.  Explicit synapses which decay below the
+   * floor become implicit again, their permanence is forgotten.  So the
+   * learning differs from the dense mode below the floor only, the
+   * connected synapses and the overlaps are computed as usual.
+   *
+   * Enabling it replaces the potential pools and permanences of all columns,
+   * so it is only allowed before the SP learns.  setPotential() is not
+   * supported in this mode.  The floor is serialized.
+   *
+   * @param floor In (0, synPermConnected], eg. synPermConnected / 2.  0 only
+   *        if the mode is off, a no-op.
+   */
+  void setImplicitPotential(const Permanence floor);
+  Permanence getImplicitPotential() const noexcept { return implicitFloor_; }
+
+  /**
+   * Bulk export & import of the synapses of all columns, eg. to move a model
+   * trained elsewhere in or out of the SP without a synapse-by-synapse loop.
+   * The rows are those of Connections::exportSegments(): column c is the
+   * segment c on cell c, its synapses are [ offsets[c] .. offsets[c+1] ).
+   *
+   * importSynapses() replaces the potential pools and permanences of all
+   * columns; every column must have exactly one row, in column order, and
+   * the presynaptic cells must be inputs.  The duty cycles and boost factors
+   * are kept.  Not supported with implicit potential pools.
+   */
+  void exportSynapses(vector<CellIdx> &segmentCells, vector<Synapse> &offsets,
+                      vector<CellIdx> &presynapticCells, vector<Permanence> &permanences) const {
+    connections_.exportSegments(segmentCells, offsets, presynapticCells, permanences);
+  }
+  void importSynapses(const vector<CellIdx> &segmentCells, const vector<Synapse> &offsets,
+                      const vector<CellIdx> &presynapticCells, const vector<Permanence> &permanences);
+
   ///////////////////////////////////////////////////////////
   //
   // Implementation methods. all methods below this line are
@@ -782,6 +992,25 @@ public:
 
 
   void boostOverlaps_(const vector<SynapseIdx> &overlaps, vector<Real> &boostedOverlaps) const;
+  // boosts the columns [begin, end), boostedOverlaps must have numColumns_ entries
+  void boostOverlaps_(const vector<SynapseIdx> &overlaps, const size_t begin, const size_t end,
+                      vector<Real> &boostedOverlaps) const;
+
+  /**
+   * The overlaps by the bit-packed kernel: the connected synapses of each
+   * column are a bitset over (its span of) the input space, so the overlap
+   * is an AND + popcount of 64 input bits at a time. The work does not
+   * depend on the input density, unlike iterating the presynaptic maps of
+   * the active inputs in Connections::computeActivity.
+   *
+   * @returns false (and leaves overlaps untouched) if the sparse kernel is
+   * cheaper for @param input, or the bitsets would exceed MAX_PACKED_SYNAPSES
+   * words. Rebuilds the bitsets if the synapses changed since the last call.
+   */
+  bool computeOverlapsPacked_(const SDR &input, vector<SynapseIdx> &overlaps);
+
+  // Rebuilds the bitsets of computeOverlapsPacked_, unless up to date.
+  void updatePackedSynapses_();
 
   /**
     Maps a column to its respective input index, keeping to the topology of
@@ -838,6 +1067,30 @@ public:
   */
   vector<UInt> initMapPotential_(UInt column, bool wrapAround);
 
+  /**
+   * Sparse variant of initMapPotential_, used by initialize.
+   *
+   * @returns the sorted input indices of the potential pool of the column,
+   * without the dense mask of numInputs_ entries. Consumes the same random
+   * numbers as initMapPotential_, which is built on it.
+   *
+   * @param inputNeighborhood the neighborhoods of potentialRadius_ in the
+   * input, shared by all columns.
+   */
+  vector<UInt> initPotentialPool_(UInt column, const NeighborhoodTable &inputNeighborhood);
+
+  // The potential pool of column, sorted, regenerated from its substream
+  // of potentialSeed_, @see setImplicitPotential.  Leaves rng positioned
+  // after the pool, for the initial permanences.
+  void implicitPool_(UInt column, Random &rng, vector<UInt> &pool) const;
+  // Learning of the implicit synapses of the active columns, after their
+  // explicit synapses adapted: the active inputs of the pool become
+  // explicit, synapses below the floor implicit.
+  void adaptImplicitSynapses_(const SDR &input, const vector<CellIdx> &columns);
+  // Make the implicit synapses of column explicit, at permanence
+  // implicitFloor_ + increment, for the inputs selected by active (all if null).
+  void materializePool_(UInt column, Permanence increment, const SDR_dense_t *active);
+
   /**
   Returns a randomly generated permanence value for a synapses that is
   initialized in a connected state.
@@ -878,6 +1131,13 @@ public:
   */
   vector<Real> initPermanence_(const vector<UInt> &potential, Real connectedPct);
 
+  /**
+   * Creates the synapses of a column to its sorted @param potentialPool (@see
+   * initPotentialPool_), with the same initial permanences as
+   * initPermanence_ would give for the dense pool.
+   */
+  void initSynapses_(UInt column, const vector<UInt> &potentialPool, Real connectedPct);
+
   void clip_(vector<Real> &perm) const;
 
   /**
@@ -894,6 +1154,18 @@ public:
       @param activeColumns an int array containing the indices of the active
      columns.
   */
+  /**
+   * @returns the fraction of columns to survive inhibition, derived from
+   * localAreaDensity or numActiveColumnsPerInhArea and the inhibition radius.
+   */
+  Real inhibitionDensity_() const;
+
+  /**
+   * @returns true if inhibitColumns_ uses the global inhibition, ie. global
+   * inhibition is set or the inhibition radius covers all the columns.
+   */
+  bool isGlobalInhibition_() const;
+
   void inhibitColumns_(const vector<Real> &overlaps,
                        vector<CellIdx> &activeColumns) const;
 
@@ -921,6 +1193,51 @@ public:
   void inhibitColumnsGlobal_(const vector<Real> &overlaps, Real density,
                              vector<UInt> &activeColumns) const;
 
+  /**
+   * Global inhibition by a counting select, for overlaps which are all small
+   * non-negative integers (ie. not boosted). Selects the same columns in
+   * the same order as inhibitColumnsGlobal_, without the index vector over
+   * all columns and without the comparison sort.
+   *
+   * @returns false (and leaves activeColumns untouched) if some overlap is
+   * not an integer in [0, MAX_COUNTING_SELECT].
+   */
+  bool inhibitColumnsCounting_(const vector<Real> &overlaps, UInt numDesired,
+                               vector<UInt> &activeColumns) const;
+
+  /**
+   * Moves the columns whose overlap changed to their new buckets, @see
+   * setIncrementalInhibition.  Only the columns reported by
+   * Connections::incrementalChangedSegments are checked, unless the buckets
+   * are not up to date with the previous compute.
+   */
+  void updateInhibitionBuckets_(const vector<SynapseIdx> &overlaps);
+
+  /**
+   * Global inhibition from the overlap buckets.  Selects the same columns as
+   * inhibitColumnsGlobal_ (unordered).
+   */
+  void inhibitColumnsIncremental_(UInt numDesired, vector<UInt> &activeColumns) const;
+
+  // Whether the fixed point boosting (@see setFixedPointBoosting) is in use,
+  // and its global inhibition.
+  bool isFixedPointBoosting_() const noexcept
+    { return fixedPointBoosting_ and boostStrength_ >= htm::Epsilon; }
+  bool isFixedPointInhibition_() const
+    { return isFixedPointBoosting_() and not backend_ and isGlobalInhibition_(); }
+
+  // Quantizes the boost factors, unless up to date, & sizes boostedFixed_.
+  void updateFixedPointBoost_();
+
+  /**
+   * Global inhibition of the fixed point boosted overlaps by a radix select,
+   * 8 bits per pass: each pass keeps the columns above the digit of the
+   * numDesired'th largest value, and narrows the search to the columns equal
+   * to it.  Ties go to the higher column index, same as inhibitColumnsGlobal_.
+   * The active columns are unordered.
+   */
+  void inhibitColumnsFixedPoint_(UInt numDesired, vector<UInt> &activeColumns) const;
+
   /**
      Performs local inhibition.
 
@@ -950,6 +1267,33 @@ public:
   void inhibitColumnsLocal_(const vector<Real> &overlaps, Real density,
                             vector<UInt> &activeColumns) const;
 
+  /**
+   * Appends the columns in the inhibition neighborhood of @param column to
+   * @param neighbors, in the order of the (Wrapping)Neighborhood, including
+   * the column itself. Respects wrapAround. Requires an up to date
+   * inhibitionNeighborhood_, @see updateNeighborTable_.
+   */
+  void appendNeighbors_(const UInt column, vector<UInt> &neighbors) const;
+
+  /**
+   * Builds the CSR table of the local inhibition neighborhoods
+   * (neighborOffsets_, neighborTable_) if the inhibition radius or
+   * wrapAround changed since it was last built. The radius only changes in
+   * update rounds, so the local inhibition & boosting usually reuse the table.
+   *
+   * @returns false if the table would exceed MAX_NEIGHBOR_TABLE entries,
+   * then the neighborhoods must be enumerated per column.
+   */
+  bool updateNeighborTable_() const;
+
+  /**
+   * @returns the neighborhood of @param column as range [first, second),
+   * from the table if @param cached (@see updateNeighborTable_), otherwise
+   * enumerated into @param scratch.
+   */
+  std::pair<const UInt*, const UInt*> neighborhood_(const UInt column, const bool cached,
+                                                    vector<UInt> &scratch) const;
+
   /**
       The primary method in charge of learning.
 
@@ -1080,6 +1424,18 @@ public:
   */
   void updateDutyCycles_(const vector<SynapseIdx> &overlaps, SDR &active);
 
+  // Lazy duty cycles, @see setLazyDutyCycles.
+  // Brings the duty cycles of @param column up to date.
+  void decayDutyCycles_(const UInt column);
+  // Brings all the duty cycles up to date & restarts the clock.
+  void syncDutyCycles_();
+  // Restarts the clock, for when all the duty cycles are up to date.
+  void resetDutyCycleClock_();
+  // When the overlap duty cycle of @param column falls below its minimum.
+  void updateWeakClock_(const UInt column);
+  // @returns the up to date values of @param dutyCycles.
+  vector<Real> dutyCyclesNow_(const vector<Real> &dutyCycles) const;
+
   /**
     Update the boost factors for all columns. The boost factors are used to
     increase the overlap of inactive columns to improve their chances of
@@ -1198,6 +1554,16 @@ protected:
 
   Real minPctOverlapDutyCycles_;
 
+  // Lazy duty cycles, @see setLazyDutyCycles, not serialized. The clock is
+  // the sum of the log of the decays of all learning steps (since it was last
+  // restarted). The duty cycles of column c are up to date as of the clock
+  // dutyCycleStamps_[c], its overlap duty cycle falls below the minimum when
+  // the clock passes below weakClocks_[c].
+  bool lazyDutyCycles_ = false;
+  double dutyCycleClock_ = 0.0;
+  vector<double> dutyCycleStamps_;
+  vector<double> weakClocks_;
+
   /*
    * Each mini-column is represented in the connections class by a single cell.
    * Each mini-column has a single segment.  Because all of these regularities,
@@ -1207,13 +1573,99 @@ protected:
 
   vector<Real> boostedOverlaps_;
 
+  // Neighborhoods for the local inhibition & boosting, including the column
+  // itself. The neighbors of column c are
+  // neighborTable_[neighborOffsets_[c] .. neighborOffsets_[c+1]).
+  // Built lazily by updateNeighborTable_(), not serialized.
+  mutable vector<UInt> neighborOffsets_;
+  mutable vector<UInt> neighborTable_;
+  mutable UInt neighborTableRadius_ = 0;
+  mutable bool neighborTableWrap_   = false;
+  mutable bool neighborTableValid_  = false;
+  mutable NeighborhoodTable inhibitionNeighborhood_; //offsets of the interior neighborhoods
+  static const size_t MAX_NEIGHBOR_TABLE; //max entries of neighborTable_
+  mutable vector<UInt> overlapHistogram_; //reused scratch
+  vector<vector<CellIdx>> batchInputs_; //reused scratch for the batch compute()
+  vector<vector<SynapseIdx>> batchOverlaps_; //reused scratch, one chunk of the batch
+  static const UInt MAX_COUNTING_SELECT; //max overlap for inhibitColumnsCounting_
+
+  // The connected synapses of column c as a bitset over the input words
+  // [packedFirstWord_[c], packedFirstWord_[c] + packedOffsets_[c+1] - packedOffsets_[c]),
+  // stored at packedSynapses_[packedOffsets_[c] ..). For computeOverlapsPacked_,
+  // built lazily & dropped by any change of the synapses, not serialized.
+  vector<UInt64> packedSynapses_;
+  vector<size_t> packedOffsets_;
+  vector<UInt>   packedFirstWord_;
+  size_t packedNumConnected_ = 0;
+  bool packedValid_ = false;
+  vector<UInt64> packedInput_; //reused scratch
+  static const size_t MAX_PACKED_SYNAPSES; //max words of packedSynapses_
+  static const Real   MIN_PACKED_DENSITY; //sparser inputs never use the packed kernel
+  static const size_t MAX_BATCH_OVERLAPS; //max overlap counts of a chunk of the batch compute()
 
   UInt version_;
   Random rng_;
 
+  // Implicit potential pools, @see setImplicitPotential(). 0 if off.
+  // Serialized. potentialSeed_ is the seed of rng_ at initialize().
+  Permanence implicitFloor_ = 0.0f;
+  UInt64 potentialSeed_ = 0u;
+  mutable NeighborhoodTable potentialNeighborhood_; //offsets of the potential radius in the input
+  mutable vector<UInt> neighborsScratch_; //reused
+  vector<UInt> poolScratch_; //reused
+  vector<CellIdx> explicitScratch_; //reused
+  vector<Synapse> forgetScratch_; //reused
+
+  // Not serialized, not compared, @see setComputeBackend()
+  std::shared_ptr<ComputeBackend> backend_;
+
+  // Incremental global inhibition, @see setIncrementalInhibition(). Column c
+  // is inhibitionBuckets_[ bucketOverlap_[c] ][ bucketPosition_[c] ], the
+  // bucket of overlap v holds the columns with overlap v, unordered.
+  // Not serialized, not compared.
+  bool incrementalInhibition_ = false;
+  bool inhibitionBucketsValid_ = false; //up to date with the previous compute
+  vector<UInt> bucketOverlap_;
+  vector<UInt> bucketPosition_;
+  vector<vector<UInt>> inhibitionBuckets_;
+  vector<Segment> changedColumns_; //reused scratch
+
+  // Fixed point boosting, @see setFixedPointBoosting(). Not serialized, not
+  // compared. boostedFixed_[c] = overlap of c * boostFactorsFixed_[c], which
+  // is the boosted overlap * boostFixedScale_.
+  bool fixedPointBoosting_ = false;
+  bool boostFixedValid_ = false; //up to date with boostFactors_
+  vector<UInt16> boostFactorsFixed_;
+  Real boostFixedScale_ = 1.0f;
+  mutable vector<UInt32> boostedFixed_; //written by boostOverlaps_
+  mutable vector<UInt> radixCandidates_; //reused scratch
+
+  // Not serialized, not compared.
+  AlgorithmStats stats_{{"overlap", "inhibition", "adapt", "dutyCycles", "boost"},
+                        {"computes", "packedOverlaps", "activeColumns"}};
+
 public:
   const Connections& connections = connections_; //for inspection of details in connections. Const, so users cannot break the SP internals.
   const Connections& getConnections() const { return connections_; } // as above, but for use in pybind11
+
+  /**
+   * Timers of the stages of compute(), and event counters, indexed by
+   * StatsTimer and StatsCounter.  Off until getStats().enable().
+   *   overlap      the overlaps and their boosting
+   *   inhibition   the selection of the active columns
+   *   adapt        the learning of the synapses
+   *   dutyCycles   the duty cycles, and the inhibition radius & min duty cycles
+   *                of the update rounds
+   *   boost        bumping up weak columns and updating the boost factors
+   *   computes        calls of compute()
+   *   packedOverlaps  overlaps computed by the bit-packed kernel
+   *   activeColumns   sum of the active columns
+   * @see AlgorithmStats
+   */
+  enum StatsTimer { Stats_Overlap, Stats_Inhibition, Stats_Adapt, Stats_DutyCycles, Stats_Boost };
+  enum StatsCounter { Stats_Computes, Stats_PackedOverlaps, Stats_ActiveColumns };
+  AlgorithmStats &getStats() { return stats_; }
+  const AlgorithmStats &getStats() const { return stats_; }
 };
 
 std::ostream & operator<<(std::ostream & out, const SpatialPooler &sp);
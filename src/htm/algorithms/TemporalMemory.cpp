@@ -34,6 +34,8 @@
 #include <iomanip>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <numeric> //iota
 #include <string>
 #include <vector>
 #include <set>
@@ -49,6 +51,7 @@ using namespace htm;
 
 
 static const UInt TM_VERSION = 2;
+const Segment TemporalMemory::NO_MIRROR;
 
 TemporalMemory::TemporalMemory() {}
 
@@ -77,6 +80,75 @@ TemporalMemory::TemporalMemory(
              maxSynapsesPerSegment, checkInputs, externalPredictiveInputs, anomalyMode);
 }
 
+TemporalMemory::TemporalMemory(const TemporalMemory &other)
+  : Serializable(other),
+    numColumns_(other.numColumns_),
+    columnDimensions_(other.columnDimensions_),
+    cellsPerColumn_(other.cellsPerColumn_),
+    cellsPerColumnShift_(other.cellsPerColumnShift_),
+    activationThreshold_(other.activationThreshold_),
+    minThreshold_(other.minThreshold_),
+    maxNewSynapseCount_(other.maxNewSynapseCount_),
+    checkInputs_(other.checkInputs_),
+    initialPermanence_(other.initialPermanence_),
+    connectedPermanence_(other.connectedPermanence_),
+    permanenceIncrement_(other.permanenceIncrement_),
+    permanenceDecrement_(other.permanenceDecrement_),
+    predictedSegmentDecrement_(other.predictedSegmentDecrement_),
+    externalPredictiveInputs_(other.externalPredictiveInputs_),
+    maxSegmentsPerCell_(other.maxSegmentsPerCell_),
+    maxSynapsesPerSegment_(other.maxSynapsesPerSegment_),
+    activeCells_(other.activeCells_),
+    winnerCells_(other.winnerCells_),
+    segmentsValid_(other.segmentsValid_),
+    activeSegments_(other.activeSegments_),
+    matchingSegments_(other.matchingSegments_),
+    numActiveConnectedSynapsesForSegment_(other.numActiveConnectedSynapsesForSegment_),
+    numActivePotentialSynapsesForSegment_(other.numActivePotentialSynapsesForSegment_),
+    touchedSegments_(other.touchedSegments_),
+    lazyMatching_(other.lazyMatching_),
+    matchingValid_(other.matchingValid_),
+    lazySegments_(),
+    lazyActive_(),
+    prevActiveCells_(other.prevActiveCells_),
+    prevWinnerCells_(other.prevWinnerCells_),
+    growCandidates_(),
+    columnCells_(),
+    noExternalInputs_(other.noExternalInputs_),
+    pendingAdaptations_(),
+    predictiveCells_(other.predictiveCells_),
+    predictiveCellsValid_(other.predictiveCellsValid_),
+    columnPredicted_(other.columnPredicted_),
+    predictedColumns_(other.predictedColumns_),
+    nextPending_(0u),
+    parallelLearning_(false),
+    separateExternal_(other.separateExternal_),
+    externalSegment_(other.externalSegment_),
+    basalSegment_(other.basalSegment_),
+    externalActiveCells_(other.externalActiveCells_),
+    externalWinnerCells_(other.externalWinnerCells_),
+    prevExternalActiveCells_(other.prevExternalActiveCells_),
+    prevExternalWinnerCells_(other.prevExternalWinnerCells_),
+    externalConnected_(other.externalConnected_),
+    externalPotential_(other.externalPotential_),
+    externalTouched_(other.externalTouched_),
+    growExisting_(), growCells_(), growExternal_(),
+    staleMirrors_(other.staleMirrors_),
+    destroyCandidates_(),
+    rng_(other.rng_),
+    connections_(other.connections_.fork()),
+    externalConnections_(other.externalConnections_.fork()),
+    backend_(other.backend_),
+    stats_(other.stats_),
+    tmAnomaly_(other.tmAnomaly_)
+{}
+
+TemporalMemory TemporalMemory::fork() const {
+  TemporalMemory child(*this);
+  child.backend_.reset(); //a backend is used by one thread at a time
+  return child;
+}
+
 TemporalMemory::~TemporalMemory() {}
 
 void TemporalMemory::initialize(
@@ -118,6 +190,7 @@ void TemporalMemory::initialize(
 
   
   cellsPerColumn_ = cellsPerColumn; //TODO add checks
+  initCellsPerColumnShift_();
   activationThreshold_ = activationThreshold;
   initialPermanence_ = initialPermanence;
   connectedPermanence_ = connectedPermanence;
@@ -131,6 +204,10 @@ void TemporalMemory::initialize(
 
   // Initialize member variables
   connections_ = Connections(static_cast<CellIdx>(numberOfColumns() * cellsPerColumn_), connectedPermanence_);
+  separateExternal_ = false;
+  externalConnections_ = Connections();
+  externalSegment_.clear();
+  basalSegment_.clear();
   rng_ = Random(seed);
 
   maxSegmentsPerCell_ = maxSegmentsPerCell;
@@ -144,7 +221,9 @@ void TemporalMemory::initialize(
 CellIdx TemporalMemory::getLeastUsedCell_(const CellIdx column) {
   if(cellsPerColumn_ == 1) return column;
 
-  vector<CellIdx> cells = cellsForColumn(column);
+  auto &cells = columnCells_; //reused scratch
+  cells.resize(cellsPerColumn_);
+  std::iota(cells.begin(), cells.end(), cellsPerColumn_ * column);
 
   //TODO: decide if we need to choose randomly from the "least used" cells, or if 1st is fine. 
   //In that case the line below is not needed, and this method can become const, deterministic results in tests need to be updated
@@ -164,37 +243,233 @@ void TemporalMemory::growSynapses_(
 			 const Segment& segment,
                          const SynapseIdx nDesiredNewSynapses,
                          const vector<CellIdx> &prevWinnerCells) {
-  
-  vector<CellIdx> candidates(prevWinnerCells.begin(), prevWinnerCells.end());
+  NTA_STATS_TIMER(stats_, Stats_GrowSynapses);
+
+  auto &candidates = growCandidates_; //reused scratch
+  candidates.assign(prevWinnerCells.begin(), prevWinnerCells.end());
+  if( separateExternal_ ) { // the external winners follow the cells, as in the shared Connections
+    for(const auto winner : prevExternalWinnerCells_) {
+      candidates.push_back(static_cast<CellIdx>(winner + numberOfCells()));
+    }
+  }
   NTA_ASSERT(std::is_sorted(candidates.begin(), candidates.end()));
 
   //figure the number of new synapses to grow
   const size_t nActual = std::min(static_cast<size_t>(nDesiredNewSynapses), candidates.size());
   // ..Check if we're going to surpass the maximum number of synapses.
-  Int overrun = static_cast<Int>(connections.numSynapses(segment) + nActual - maxSynapsesPerSegment_);
+  Int overrun = static_cast<Int>(numSynapses_(segment) + nActual - maxSynapsesPerSegment_);
   if (overrun > 0) {
-    connections_.destroyMinPermanenceSynapses(segment, static_cast<size_t>(overrun), prevWinnerCells);
+    if( separateExternal_ )
+      destroyMinPermanenceSynapsesSeparate_(segment, static_cast<size_t>(overrun), candidates);
+    else
+      connections_.destroyMinPermanenceSynapses(segment, static_cast<size_t>(overrun), prevWinnerCells);
   }
   // ..Recalculate in case we weren't able to destroy as many synapses as needed.
-  const size_t nActualWithMax = std::min(nActual, static_cast<size_t>(maxSynapsesPerSegment_) - connections.numSynapses(segment));
+  const size_t nActualWithMax = std::min(nActual, static_cast<size_t>(maxSynapsesPerSegment_) - numSynapses_(segment));
 
   // Pick nActual cells randomly.
   rng_.shuffle(candidates.begin(), candidates.end());
-  const size_t nDesired = connections.numSynapses(segment) + nActualWithMax; //num synapses on seg after this function (+-), see #COND
-  for (const auto syn : candidates) {
-    // #COND: this loop finishes two folds: a) we ran out of candidates (above), b) we grew the desired number of new synapses (below)
-    if(connections.numSynapses(segment) == nDesired) break;
-    connections_.createSynapse(segment, syn, initialPermanence_); //TODO createSynapse consider creating a vector of new synapses at once?
+  const size_t numBefore = stats_.isEnabled() ? numSynapses_(segment) : 0u;
+  // Stops when a) we ran out of candidates, b) we grew the desired number of new synapses.
+  // Candidates already on the segment are skipped.
+  if( separateExternal_ )
+    growSynapsesSeparate_(segment, candidates, nActualWithMax);
+  else
+    connections_.growSynapses(segment, candidates, initialPermanence_, nActualWithMax);
+  if( stats_.isEnabled() ) {
+    stats_.count(Stats_SynapsesGrown, numSynapses_(segment) - numBefore);
+  }
+}
+
+
+size_t TemporalMemory::numSynapses_(const Segment segment) const {
+  const Segment mirror = mirrorOf_(segment);
+  return connections.numSynapses(segment) +
+         (mirror == NO_MIRROR ? 0u : externalConnections.numSynapses(mirror));
+}
+
+
+Segment TemporalMemory::createMirror_(const Segment segment) {
+  NTA_ASSERT(mirrorOf_(segment) == NO_MIRROR);
+  const Segment mirror = externalConnections_.createSegment(connections.cellForSegment(segment));
+  if( segment >= externalSegment_.size() ) {
+    externalSegment_.resize(connections.segmentFlatListLength(), NO_MIRROR);
+  }
+  if( mirror >= basalSegment_.size() ) {
+    basalSegment_.resize(externalConnections.segmentFlatListLength(), NO_MIRROR);
+  }
+  externalSegment_[segment] = mirror;
+  basalSegment_[mirror]     = segment;
+  return mirror;
+}
+
+
+void TemporalMemory::destroyMirror_(const Segment segment) {
+  const Segment mirror = mirrorOf_(segment);
+  if( mirror == NO_MIRROR ) return;
+  externalConnections_.destroySegment(mirror);
+  externalSegment_[segment] = NO_MIRROR;
+  basalSegment_[mirror]     = NO_MIRROR;
+}
+
+
+void TemporalMemory::destroyStaleMirrors_(const CellIdx cell) {
+  const auto &segments = connections.segmentsForCell(cell);
+  auto &stale = staleMirrors_; //reused scratch
+  stale.clear();
+  for(const auto mirror : externalConnections.segmentsForCell(cell)) {
+    if( std::find(segments.cbegin(), segments.cend(), basalSegment_[mirror]) == segments.cend() ) {
+      stale.push_back(basalSegment_[mirror]);
+    }
+  }
+  for(const auto segment : stale) {
+    destroyMirror_(segment);
+  }
+}
+
+
+void TemporalMemory::addExternalActivity_(const bool learn) {
+  if( externalActiveCells_.empty() ) return; //nothing to add, the counts of the last call are reset by the next one
+
+  externalConnections_.computeActivity(externalConnected_,
+                                       externalPotential_,
+                                       externalTouched_,
+                                       externalActiveCells_,
+                                       learn);
+  auto &connected = numActiveConnectedSynapsesForSegment_;
+  auto &potential = numActivePotentialSynapsesForSegment_;
+  for(const auto mirror : externalTouched_) {
+    const Segment segment = basalSegment_[mirror];
+    NTA_ASSERT(segment != NO_MIRROR);
+    if( potential[segment] == 0u ) { //not touched by the cells
+      touchedSegments_.push_back(segment);
+    }
+    connected[segment] = static_cast<SynapseIdx>(connected[segment] + externalConnected_[mirror]);
+    potential[segment] = static_cast<SynapseIdx>(potential[segment] + externalPotential_[mirror]);
+  }
+}
+
+
+void TemporalMemory::adaptExternal_(vector<Segment>::const_iterator begin,
+                                    vector<Segment>::const_iterator end,
+                                    const Permanence increment,
+                                    const Permanence decrement) {
+  for(auto segment = begin; segment != end; segment++) {
+    const Segment mirror = mirrorOf_(*segment);
+    if( mirror != NO_MIRROR ) {
+      externalConnections_.adaptSegment(mirror, prevExternalActiveCells_, increment, decrement, true);
+      if( externalConnections.numSynapses(mirror) == 0u ) {
+        destroyMirror_(*segment);
+      }
+    }
+    // The pruning of Connections::adaptSegment(), for the synapses of both.
+    if( numSynapses_(*segment) < minThreshold_ ) {
+      destroyMirror_(*segment);
+      connections_.destroySegment(*segment);
+    }
+  }
+}
+
+
+void TemporalMemory::destroyMinPermanenceSynapsesSeparate_(const Segment segment,
+                                                           const size_t nDestroy,
+                                                           const vector<CellIdx> &excludeCells) {
+  // as Connections::destroyMinPermanenceSynapses(), over the segment & its mirror
+  auto &destroyCandidates = destroyCandidates_; //reused scratch
+  destroyCandidates.clear();
+  const Segment mirror = mirrorOf_(segment);
+  for(const auto external : {false, true}) {
+    if( external and mirror == NO_MIRROR ) continue;
+    const Connections &conn = external ? externalConnections : connections;
+    const CellIdx offset    = external ? static_cast<CellIdx>(numberOfCells()) : 0u;
+    for(const auto synapse : conn.synapsesForSegment(external ? mirror : segment)) {
+      const SynapseData data = conn.dataForSynapse(synapse);
+      if( not std::binary_search(excludeCells.cbegin(), excludeCells.cend(), data.presynapticCell + offset) ) {
+        destroyCandidates.emplace_back(data.permanence, external, data.id, synapse);
+      }
+    }
+  }
+  std::sort(destroyCandidates.begin(), destroyCandidates.end()); //lowest permanence first, then older first
+
+  const size_t destroy = std::min( nDestroy, destroyCandidates.size() );
+  for(size_t i = 0; i < destroy; i++) {
+    if( std::get<1>(destroyCandidates[i]) )
+      externalConnections_.destroySynapse( std::get<3>(destroyCandidates[i]) );
+    else
+      connections_.destroySynapse( std::get<3>(destroyCandidates[i]) );
   }
 }
 
 
+void TemporalMemory::growSynapsesSeparate_(const Segment segment,
+                                           const vector<CellIdx> &candidates,
+                                           const size_t maxNew) {
+  if( maxNew == 0u ) return;
+  Segment mirror = mirrorOf_(segment);
+
+  // The presynaptic cells already on the segment & its mirror.
+  auto &existing = growExisting_; //reused scratch
+  existing.clear();
+  for(const auto synapse : connections.synapsesForSegment(segment)) {
+    existing.push_back(connections.presynapticCellForSynapse(synapse));
+  }
+  if( mirror != NO_MIRROR ) {
+    for(const auto synapse : externalConnections.synapsesForSegment(mirror)) {
+      existing.push_back(static_cast<CellIdx>(externalConnections.presynapticCellForSynapse(synapse) + numberOfCells()));
+    }
+  }
+  std::sort(existing.begin(), existing.end());
+
+  // Split the candidates up to the maxNew-th new one between both Connections.
+  // The existing ones on the way are passed on as well, as growSynapses()
+  // raises their permanence like in the shared Connections.
+  auto &cells    = growCells_;
+  auto &external = growExternal_;
+  cells.clear();
+  external.clear();
+  size_t numNew = 0u;
+  for(const auto candidate : candidates) {
+    if( numNew == maxNew ) break;
+    if( not std::binary_search(existing.cbegin(), existing.cend(), candidate) ) numNew++;
+    if( candidate < numberOfCells() ) cells.push_back(candidate);
+    else external.push_back(static_cast<CellIdx>(candidate - numberOfCells()));
+  }
+
+  connections_.growSynapses(segment, cells, initialPermanence_, cells.size());
+  if( not external.empty() ) {
+    if( mirror == NO_MIRROR ) mirror = createMirror_(segment);
+    externalConnections_.growSynapses(mirror, external, initialPermanence_, external.size());
+  }
+}
+
+
+void TemporalMemory::setSeparateExternalConnections(const bool enable) {
+  if( enable == separateExternal_ ) return;
+  NTA_CHECK( not enable or externalPredictiveInputs_ > 0u )
+    << "TM.setSeparateExternalConnections: the TM has no external predictive inputs.";
+  NTA_CHECK( connections.numSynapses() == 0u and externalConnections.numSynapses() == 0u )
+    << "TM.setSeparateExternalConnections: must be set before the TM grew any synapses.";
+  separateExternal_ = enable;
+  externalConnections_ = enable ? Connections(static_cast<CellIdx>(numberOfCells()), connectedPermanence_) : Connections();
+  externalSegment_.clear();
+  basalSegment_.clear();
+  externalActiveCells_.clear();
+  externalWinnerCells_.clear();
+  prevExternalWinnerCells_.clear();
+  externalConnected_.clear();
+  externalPotential_.clear();
+  externalTouched_.clear();
+}
+
+
 void TemporalMemory::activatePredictedColumn_(
     vector<Segment>::const_iterator columnActiveSegmentsBegin,
     vector<Segment>::const_iterator columnActiveSegmentsEnd,
-    const SDR &prevActiveCells,
+    const SparseSDR &prevActiveCells,
     const vector<CellIdx> &prevWinnerCells,
     const bool learn) {
+  NTA_STATS_TIMER(stats_, Stats_PredictedColumns);
+  NTA_STATS_COUNT(stats_, Stats_NumPredictedColumns, 1u);
 
   auto activeSegment = columnActiveSegmentsBegin;
   do {
@@ -205,8 +480,8 @@ void TemporalMemory::activatePredictedColumn_(
     // This cell might have multiple active segments.
     do {
       if (learn) { 
-        connections_.adaptSegment(*activeSegment, prevActiveCells,
-                     permanenceIncrement_, permanenceDecrement_, true, minThreshold_);
+        adaptSegments_(activeSegment, activeSegment + 1, prevActiveCells,
+                       permanenceIncrement_, permanenceDecrement_);
 
         const Int32 nGrowDesired =
             static_cast<Int32>(maxNewSynapseCount_) -
@@ -225,20 +500,19 @@ void TemporalMemory::burstColumn_(
 	    const UInt column,
             vector<Segment>::const_iterator columnMatchingSegmentsBegin,
             vector<Segment>::const_iterator columnMatchingSegmentsEnd,
-            const SDR &prevActiveCells,
+            const SparseSDR &prevActiveCells,
             const vector<CellIdx> &prevWinnerCells,
             const bool learn) {
+  NTA_STATS_TIMER(stats_, Stats_BurstingColumns);
+  NTA_STATS_COUNT(stats_, Stats_NumBurstingColumns, 1u);
 
   // Calculate the active cells: active become ALL the cells in this mini-column
-  const auto newCells = cellsForColumn(column);
-  activeCells_.insert(activeCells_.end(), newCells.begin(), newCells.end());
+  const CellIdx start = cellsPerColumn_ * column;
+  for(CellIdx cell = start; cell < start + cellsPerColumn_; cell++) {
+    activeCells_.push_back(cell);
+  }
 
-  const auto bestMatchingSegment =
-      std::max_element(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd,
-                       [&](Segment a, Segment b) {
-                         return (numActivePotentialSynapsesForSegment_[a] <
-                                 numActivePotentialSynapsesForSegment_[b]);
-                       });
+  const auto bestMatchingSegment = bestMatchingSegment_(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd);
 
   const CellIdx winnerCell =
       (bestMatchingSegment != columnMatchingSegmentsEnd)
@@ -251,8 +525,8 @@ void TemporalMemory::burstColumn_(
   if (learn) {
     if (bestMatchingSegment != columnMatchingSegmentsEnd) {
       // Learn on the best matching segment.
-      connections_.adaptSegment(*bestMatchingSegment, prevActiveCells,
-                   permanenceIncrement_, permanenceDecrement_, true, minThreshold_); //TODO consolidate SP.stimulusThreshold_ & TM.minThreshold_ into Conn.stimulusThreshold ? (replacing segmentThreshold arg used in some methods in Conn) 
+      adaptSegments_(bestMatchingSegment, bestMatchingSegment + 1, prevActiveCells,
+                     permanenceIncrement_, permanenceDecrement_); //TODO consolidate SP.stimulusThreshold_ & TM.minThreshold_ into Conn.stimulusThreshold ? (replacing segmentThreshold arg used in some methods in Conn) 
 
       const Int32 nGrowDesired = maxNewSynapseCount_ - numActivePotentialSynapsesForSegment_[*bestMatchingSegment];
       if (nGrowDesired > 0) {
@@ -264,13 +538,21 @@ void TemporalMemory::burstColumn_(
 
       // Don't grow a segment that will never match.
       const UInt32 nGrowExact =
-          std::min(static_cast<UInt32>(maxNewSynapseCount_), static_cast<UInt32>(prevWinnerCells.size()));
+          std::min(static_cast<UInt32>(maxNewSynapseCount_),
+                   static_cast<UInt32>(prevWinnerCells.size() + prevExternalWinnerCells_.size()));
       if (nGrowExact > 0) {
-        const Segment segment =
-            connections_.createSegment(winnerCell, maxSegmentsPerCell_);
+        Segment segment;
+        {
+          NTA_STATS_TIMER(stats_, Stats_CreateSegment);
+          NTA_STATS_COUNT(stats_, Stats_SegmentsCreated, 1u);
+          segment = connections_.createSegment(winnerCell, maxSegmentsPerCell_);
+          if (separateExternal_) {
+            destroyStaleMirrors_(winnerCell);
+          }
+        }
 
         growSynapses_(segment, nGrowExact, prevWinnerCells);
-        NTA_ASSERT(connections.numSynapses(segment) == nGrowExact);
+        NTA_ASSERT(numSynapses_(segment) == nGrowExact);
       }
     }
   }
@@ -280,34 +562,53 @@ void TemporalMemory::burstColumn_(
 void TemporalMemory::punishPredictedColumn_(
     vector<Segment>::const_iterator columnMatchingSegmentsBegin,
     vector<Segment>::const_iterator columnMatchingSegmentsEnd,
-    const SDR &prevActiveCells) {
-  if (predictedSegmentDecrement_ > 0.0) {
-    for (auto matchingSegment = columnMatchingSegmentsBegin;
-         matchingSegment != columnMatchingSegmentsEnd; matchingSegment++) {
-      connections_.adaptSegment(*matchingSegment, prevActiveCells,
-                   -predictedSegmentDecrement_, 0.0, true, minThreshold_);
-    }
+    const SparseSDR &prevActiveCells) {
+  if (predictedSegmentDecrement_ > 0.0 and columnMatchingSegmentsBegin != columnMatchingSegmentsEnd) {
+    NTA_STATS_TIMER(stats_, Stats_PunishedColumns);
+    NTA_STATS_COUNT(stats_, Stats_NumPunishedColumns, 1u);
+    adaptSegments_(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd,
+                   prevActiveCells, -predictedSegmentDecrement_, 0.0);
   }
 }
 
-void TemporalMemory::activateCells(const SDR &activeColumns, const bool learn) {
-    NTA_CHECK(columnDimensions_.size() > 0) << "TM constructed using the default TM() constructor, which may only be used for serialization. "
-	    << "Use TM constructor where you provide at least column dimensions, eg: TM tm({32});";
 
-    NTA_CHECK( activeColumns.dimensions.size() == columnDimensions_.size() )  //this "hack" because columnDimensions_, and SDR.dimensions are vectors
-	    //of different type, so we cannot directly compare
-	    << "TM invalid input dimensions: " << activeColumns.dimensions.size() << " vs. " << columnDimensions_.size();
-    for(size_t i=0; i< columnDimensions_.size(); i++) {
-      NTA_CHECK(static_cast<size_t>(activeColumns.dimensions[i]) == static_cast<size_t>(columnDimensions_[i])) << "Dimensions must be the same.";
-    }
-    auto &sparse = activeColumns.getSparse();
+vector<Segment>::const_iterator TemporalMemory::bestMatchingSegment_(
+    vector<Segment>::const_iterator columnMatchingSegmentsBegin,
+    vector<Segment>::const_iterator columnMatchingSegmentsEnd) const {
+  return std::max_element(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd,
+                          [&](Segment a, Segment b) {
+                            return (numActivePotentialSynapsesForSegment_[a] <
+                                    numActivePotentialSynapsesForSegment_[b]);
+                          });
+}
 
-  SDR prevActiveCells({static_cast<CellIdx>(numberOfCells() + externalPredictiveInputs_)});
-  prevActiveCells.setSparse(activeCells_);
-  activeCells_.clear();
 
-  const vector<CellIdx> prevWinnerCells = std::move(winnerCells_);
+void TemporalMemory::adaptSegments_(vector<Segment>::const_iterator begin,
+                                    vector<Segment>::const_iterator end,
+                                    const SparseSDR &prevActiveCells,
+                                    const Permanence increment,
+                                    const Permanence decrement) {
+  // With separate external connections, segments are pruned by the synapses of both, in adaptExternal_().
+  const UInt segmentThreshold = separateExternal_ ? 0u : minThreshold_;
+  if( not parallelLearning_ ) {
+    connections_.adaptSegments(begin, end, prevActiveCells, increment, decrement, true, segmentThreshold);
+  }
+  else {
+    // the permanences were already updated by adaptPermanencesParallel_()
+    NTA_ASSERT(nextPending_ < pendingAdaptations_.size());
+    const auto &item = pendingAdaptations_[nextPending_++];
+    NTA_ASSERT(std::equal(begin, end, item.segments.cbegin()) and item.segments.size() == (size_t)(end - begin))
+      << "TM parallel learning: the segments differ from the first phase";
+    connections_.applyAdaptation(item, true, segmentThreshold);
+  }
+  if( separateExternal_ ) {
+    adaptExternal_(begin, end, increment, decrement);
+  }
+}
+
 
+template<typename F>
+void TemporalMemory::forEachColumn_(const SDR &activeColumns, F fn) const {
   //maps segment S to a new segment that is at start of a column where
   //S belongs. 
   //for 3 cells per columns: 
@@ -320,12 +621,12 @@ void TemporalMemory::activateCells(const SDR &activeColumns, const bool learn) {
   //CFS(s2_2) = s2_1
   //...
   const auto toColumns = [&](const Segment segment) {
-    return connections.cellForSegment(segment) / cellsPerColumn_;
+    return columnOf_(connections.cellForSegment(segment));
   };
   const auto identity = [](const ElemSparse a) {return a;}; //TODO use std::identity when c++20
 
   for (auto &&columnData : groupBy( //group by columns, and convert activeSegments & matchingSegments to cols. 
-           sparse, identity,
+           activeColumns.getSparse(), identity,
            activeSegments_,   toColumns,
            matchingSegments_, toColumns)) {
 
@@ -344,6 +645,106 @@ void TemporalMemory::activateCells(const SDR &activeColumns, const bool learn) {
 	) = columnData;
 
     const bool isActiveColumn = activeColumnsBegin != activeColumnsEnd;
+    fn(column, isActiveColumn,
+       columnActiveSegmentsBegin, columnActiveSegmentsEnd,
+       columnMatchingSegmentsBegin, columnMatchingSegmentsEnd);
+  }
+}
+
+
+void TemporalMemory::adaptPermanencesParallel_(const SDR &activeColumns, const SparseSDR &prevActiveCells) {
+  // Collect the learning segments in the order in which activateCells() visits them.
+  size_t numPending = 0u;
+  const auto add = [&](vector<Segment>::const_iterator begin, vector<Segment>::const_iterator end,
+                       const Permanence increment, const Permanence decrement) {
+    if( numPending == pendingAdaptations_.size() ) pendingAdaptations_.emplace_back();
+    auto &item = pendingAdaptations_[numPending++];
+    item.segments.assign(begin, end);
+    item.increment = increment;
+    item.decrement = decrement;
+  };
+  forEachColumn_(activeColumns, [&](const Segment column, const bool isActiveColumn,
+                                    vector<Segment>::const_iterator activeBegin, vector<Segment>::const_iterator activeEnd,
+                                    vector<Segment>::const_iterator matchingBegin, vector<Segment>::const_iterator matchingEnd) {
+    (void)column;
+    if (isActiveColumn) {
+      if (activeBegin != activeEnd) { // activatePredictedColumn_
+        for(auto segment = activeBegin; segment != activeEnd; segment++) {
+          add(segment, segment + 1, permanenceIncrement_, permanenceDecrement_);
+        }
+      } else { // burstColumn_
+        const auto best = bestMatchingSegment_(matchingBegin, matchingEnd);
+        if (best != matchingEnd) {
+          add(best, best + 1, permanenceIncrement_, permanenceDecrement_);
+        }
+      }
+    } else if (predictedSegmentDecrement_ > 0.0 and matchingBegin != matchingEnd) { // punishPredictedColumn_
+      add(matchingBegin, matchingEnd, -predictedSegmentDecrement_, 0.0f);
+    }
+  });
+  pendingAdaptations_.resize(numPending);
+
+  connections_.adaptPermanences(pendingAdaptations_, prevActiveCells, true);
+  nextPending_ = 0u;
+}
+
+void TemporalMemory::activateCells(const SDR &activeColumns, const bool learn) {
+    NTA_CHECK(columnDimensions_.size() > 0) << "TM constructed using the default TM() constructor, which may only be used for serialization. "
+	    << "Use TM constructor where you provide at least column dimensions, eg: TM tm({32});";
+
+    NTA_CHECK( activeColumns.dimensions.size() == columnDimensions_.size() )  //this "hack" because columnDimensions_, and SDR.dimensions are vectors
+	    //of different type, so we cannot directly compare
+	    << "TM invalid input dimensions: " << activeColumns.dimensions.size() << " vs. " << columnDimensions_.size();
+    for(size_t i=0; i< columnDimensions_.size(); i++) {
+      NTA_CHECK(static_cast<size_t>(activeColumns.dimensions[i]) == static_cast<size_t>(columnDimensions_[i])) << "Dimensions must be the same.";
+    }
+  NTA_STATS_TIMER(stats_, Stats_ActivateCells);
+  // Connections prunes and replaces segments & synapses while learning, the
+  // destroyed ones are counted from the totals.
+  const bool stats = stats_.isEnabled();
+  const size_t numSegments = stats ? connections_.numSegments() : 0u;
+  const size_t numSynapses = stats ? connections_.numSynapses() + externalConnections_.numSynapses() : 0u;
+  const UInt64 numCreated = stats_.getCount(Stats_SegmentsCreated);
+  const UInt64 numGrown = stats_.getCount(Stats_SynapsesGrown);
+
+  if( not matchingValid_ ) {
+    // Inference only needs the matching segments of the bursting columns.
+    completeMatching_(learn ? nullptr : &activeColumns.getSparse());
+  }
+
+  // The previous state is kept in members, so that their memory is reused.
+  const UInt numInputCells = static_cast<UInt>(numberOfCells() + externalPredictiveInputs_);
+  if( prevActiveCells_.size != numInputCells ) {
+    prevActiveCells_.initialize({numInputCells});
+  }
+  SparseSDR &prevActiveCells = prevActiveCells_;
+  prevActiveCells.setSparse(activeCells_);
+  activeCells_.clear();
+
+  prevWinnerCells_.swap(winnerCells_);
+  winnerCells_.clear();
+  const vector<CellIdx> &prevWinnerCells = prevWinnerCells_;
+
+  if( separateExternal_ ) {
+    if( prevExternalActiveCells_.size != externalPredictiveInputs_ ) {
+      prevExternalActiveCells_.initialize({externalPredictiveInputs_});
+    }
+    prevExternalActiveCells_.setSparse(externalActiveCells_);
+    externalActiveCells_.clear();
+    prevExternalWinnerCells_.swap(externalWinnerCells_);
+    externalWinnerCells_.clear();
+  }
+
+  parallelLearning_ = learn and connections.getNumThreads() > 1u;
+  if( parallelLearning_ ) {
+    adaptPermanencesParallel_(activeColumns, prevActiveCells);
+  }
+
+  forEachColumn_(activeColumns, [&](const Segment column, const bool isActiveColumn,
+                                    vector<Segment>::const_iterator columnActiveSegmentsBegin,
+                                    vector<Segment>::const_iterator columnActiveSegmentsEnd,
+                                    vector<Segment>::const_iterator columnMatchingSegmentsBegin,
+                                    vector<Segment>::const_iterator columnMatchingSegmentsEnd) {
     if (isActiveColumn) { //current active column...
       if (columnActiveSegmentsBegin != columnActiveSegmentsEnd) {
 	//...was also predicted -> learn :o)
@@ -363,8 +764,22 @@ void TemporalMemory::activateCells(const SDR &activeColumns, const bool learn) {
         punishPredictedColumn_(columnMatchingSegmentsBegin, columnMatchingSegmentsEnd, prevActiveCells);
       }
     } //else: not predicted & not active -> no activity -> does not show up at all
-  }
+  });
+  NTA_ASSERT(not parallelLearning_ or nextPending_ == pendingAdaptations_.size());
+  parallelLearning_ = false;
   segmentsValid_ = false;
+  if( not matchingValid_ ) { //only the bursting columns were completed
+    matchingSegments_.clear();
+    matchingValid_ = true;
+  }
+
+  if( stats ) {
+    const size_t created = static_cast<size_t>(stats_.getCount(Stats_SegmentsCreated) - numCreated);
+    const size_t grown = static_cast<size_t>(stats_.getCount(Stats_SynapsesGrown) - numGrown);
+    stats_.count(Stats_SegmentsDestroyed, numSegments + created - connections_.numSegments());
+    stats_.count(Stats_SynapsesDestroyed, numSynapses + grown -
+                 (connections_.numSynapses() + externalConnections_.numSynapses()));
+  }
 }
 
 
@@ -392,33 +807,64 @@ void TemporalMemory::activateDendrites(const bool learn,
 
   if( segmentsValid_ )
     return;
+  NTA_STATS_TIMER(stats_, Stats_ActivateDendrites);
 
-  for(const auto &active : externalPredictiveInputsActive.getSparse()) {
-      NTA_ASSERT( active < externalPredictiveInputs_ );
-      activeCells_.push_back( static_cast<CellIdx>(active + numberOfCells()) ); 
+  if( separateExternal_ ) {
+    const auto &active  = externalPredictiveInputsActive.getSparse();
+    const auto &winners = externalPredictiveInputsWinners.getSparse();
+    externalActiveCells_.assign(active.cbegin(), active.cend());
+    externalWinnerCells_.assign(winners.cbegin(), winners.cend());
   }
-  for(const auto &winner : externalPredictiveInputsWinners.getSparse()) {
-      NTA_ASSERT( winner < externalPredictiveInputs_ );
-      winnerCells_.push_back( static_cast<CellIdx>(winner + numberOfCells()) );
+  else {
+    for(const auto &active : externalPredictiveInputsActive.getSparse()) {
+        NTA_ASSERT( active < externalPredictiveInputs_ );
+        activeCells_.push_back( static_cast<CellIdx>(active + numberOfCells()) ); 
+    }
+    for(const auto &winner : externalPredictiveInputsWinners.getSparse()) {
+        NTA_ASSERT( winner < externalPredictiveInputs_ );
+        winnerCells_.push_back( static_cast<CellIdx>(winner + numberOfCells()) );
+    }
   }
 
-  const size_t length = connections.segmentFlatListLength();
-
-  numActivePotentialSynapsesForSegment_.assign(length, 0);
-  numActiveConnectedSynapsesForSegment_ = connections_.computeActivity(
-                              numActivePotentialSynapsesForSegment_,
-                              activeCells_,
-			      learn);
+  // Only the segments touched by an active cell are non-zero.
+  const bool lazy = lazyMatching_ and not learn and not separateExternal_ and not backend_;
+  if( backend_ and not learn and not separateExternal_ ) {
+    // The backend writes all counts, the touched segments are the non-zero ones.
+    backend_->update(connections_, true);
+    backend_->overlaps(activeCells_, numActiveConnectedSynapsesForSegment_,
+                       &numActivePotentialSynapsesForSegment_);
+    backend_->threshold(numActivePotentialSynapsesForSegment_, 1u, touchedSegments_);
+  }
+  else {
+    connections_.computeActivity(numActiveConnectedSynapsesForSegment_,
+                                 numActivePotentialSynapsesForSegment_,
+                                 touchedSegments_,
+                                 activeCells_,
+                                 learn,
+                                 /*potentialSynapses*/ not lazy);
+  }
+  if( separateExternal_ ) {
+    addExternalActivity_(learn);
+  }
+  const auto selectSegments = [&](const vector<SynapseIdx> &counts, const SynapseIdx threshold, vector<Segment> &out) {
+    out.clear();
+    if( threshold == 0u ) { //untouched segments qualify as well
+      for (size_t segment = 0; segment < counts.size(); segment++) {
+        out.push_back(static_cast<Segment>(segment));
+      }
+      return;
+    }
+    for (const auto segment : touchedSegments_) {
+      if (counts[segment] >= threshold) {
+        out.push_back(segment);
+      }
+    }
+  };
 
   // Active segments, connected synapses.
-  activeSegments_.clear();
-  for (size_t segment = 0; segment < numActiveConnectedSynapsesForSegment_.size(); segment++) {
-    if (numActiveConnectedSynapsesForSegment_[segment] >= activationThreshold_) { //TODO move to SegmentData.numConnected?
-      activeSegments_.push_back(static_cast<UInt>(segment));
-    }
-  }
-  const auto compareSegments = [&](const Segment a, const Segment b) { return connections.compareSegments(a, b); };
-  std::sort( activeSegments_.begin(), activeSegments_.end(), compareSegments); //SDR requires sorted when constructed from activeSegments_
+  selectSegments(numActiveConnectedSynapsesForSegment_, activationThreshold_, activeSegments_); //TODO move to SegmentData.numConnected?
+  activeSegmentsChanged_();
+  connections_.sortSegments(activeSegments_); //SDR requires sorted when constructed from activeSegments_
   // Update segment bookkeeping.
   if (learn) {
     for (const auto segment : activeSegments_) {
@@ -426,14 +872,14 @@ void TemporalMemory::activateDendrites(const bool learn,
     }
   }
 
-  // Matching segments, potential synapses.
-  matchingSegments_.clear();
-  for (size_t segment = 0; segment < numActivePotentialSynapsesForSegment_.size(); segment++) {
-    if (numActivePotentialSynapsesForSegment_[segment] >= minThreshold_) {
-      matchingSegments_.push_back(static_cast<UInt>(segment));
-    }
+  // Matching segments, potential synapses. Lazily, @see setLazyMatching()
+  matchingValid_ = not lazy;
+  if( lazy ) {
+    matchingSegments_.clear();
+  } else {
+    selectSegments(numActivePotentialSynapsesForSegment_, minThreshold_, matchingSegments_);
+    connections_.sortSegments(matchingSegments_);
   }
-  std::sort( matchingSegments_.begin(), matchingSegments_.end(), compareSegments);
 
   segmentsValid_ = true;
 }
@@ -463,22 +909,16 @@ void TemporalMemory::calculateAnomalyScore_(const SDR &activeColumns){
 			   } break;
 
 	case ANMode::RAW: {
-	  tmAnomaly_.anomaly_ = computeRawAnomalyScore(
-							 activeColumns,
-							 cellsToColumns( getPredictiveCells() ));
+	  tmAnomaly_.anomaly_ = rawAnomalyScore_(activeColumns);
 			  } break;
 
 	case ANMode::LIKELIHOOD: {
-	  const Real raw = computeRawAnomalyScore(
-						 activeColumns,
-						 cellsToColumns( getPredictiveCells() ));
+	  const Real raw = rawAnomalyScore_(activeColumns);
 	  tmAnomaly_.anomaly_ = tmAnomaly_.anomalyLikelihood_.anomalyProbability(raw);
 				 } break;
 
 	case ANMode::LOGLIKELIHOOD: {
-	  const Real raw = computeRawAnomalyScore(
-						 activeColumns,
-						 cellsToColumns( getPredictiveCells() ));
+	  const Real raw = rawAnomalyScore_(activeColumns);
 	  const Real like = tmAnomaly_.anomalyLikelihood_.anomalyProbability(raw);
 	  const Real log  = tmAnomaly_.anomalyLikelihood_.computeLogLikelihood(like);
 	  tmAnomaly_.anomaly_ = log;
@@ -490,17 +930,230 @@ void TemporalMemory::calculateAnomalyScore_(const SDR &activeColumns){
 
 }
 
+
+Real TemporalMemory::rawAnomalyScore_(const SDR &activeColumns) const {
+  // Same as computeRawAnomalyScore(activeColumns, cellsToColumns(getPredictiveCells())),
+  // but a lookup of the predicted columns, without temporary SDRs.
+  NTA_CHECK( segmentsValid_ )
+    << "Call TM.activateDendrites() before computing the anomaly!";
+  const auto &active = activeColumns.getSparse();
+  if( active.empty() ) return 0.0f;
+
+  NTA_ASSERT(columnPredicted_.size() == numColumns_);
+  size_t predicted = 0u;
+  for(const auto column : active) {
+    predicted += columnPredicted_[column];
+  }
+  const Real score = (active.size() - predicted) / static_cast<Real>(active.size());
+  NTA_ASSERT(score >= 0.0f and score <= 1.0f) << "Anomaly score out of bounds!";
+  return score;
+}
+
+
+void TemporalMemory::activeSegmentsChanged_() {
+  predictiveCellsValid_ = false;
+
+  if( columnPredicted_.size() != numColumns_ ) {
+    columnPredicted_.assign(numColumns_, 0u);
+  } else {
+    for(const auto column : predictedColumns_) {
+      columnPredicted_[column] = 0u;
+    }
+  }
+  predictedColumns_.clear();
+  for(const auto segment : activeSegments_) {
+    const auto column = columnOf_(connections.cellForSegment(segment));
+    if( not columnPredicted_[column] ) {
+      columnPredicted_[column] = 1u;
+      predictedColumns_.push_back(column);
+    }
+  }
+}
+
+void TemporalMemory::completeMatching_(const vector<UInt> *activeColumns) const {
+  NTA_ASSERT(not matchingValid_);
+  auto &segments = lazySegments_;
+  segments.clear();
+  const auto addColumn = [&](const UInt column) {
+    const CellIdx start = cellsPerColumn_ * column;
+    for(CellIdx cell = start; cell < start + cellsPerColumn_; cell++) {
+      const auto &cellSegments = connections.segmentsForCell(cell);
+      segments.insert(segments.end(), cellSegments.cbegin(), cellSegments.cend());
+    }
+  };
+  if( activeColumns == nullptr ) {
+    for(UInt column = 0u; column < numColumns_; column++) addColumn(column);
+  } else {
+    for(const auto column : *activeColumns) {
+      if( not columnPredicted_[column] ) addColumn(column);
+    }
+  }
+
+  // The connected counts are already known, count the active synapses of
+  // the segments, keeping the invariant of the touched segments.
+  auto &active = lazyActive_;
+  active.resize(numberOfCells() + externalPredictiveInputs_, 0u);
+  for(const auto cell : activeCells_) active[cell] = 1u;
+  auto &potential = numActivePotentialSynapsesForSegment_;
+  matchingSegments_.clear();
+  for(const auto segment : segments) {
+    UInt count = 0u;
+    for(const auto synapse : connections.synapsesForSegment(segment)) {
+      count += active[connections.presynapticCellForSynapse(synapse)];
+    }
+    if( count > 0u and numActiveConnectedSynapsesForSegment_[segment] == 0u ) {
+      touchedSegments_.push_back(segment);
+    }
+    potential[segment] = static_cast<SynapseIdx>(count);
+    if( count >= minThreshold_ ) matchingSegments_.push_back(segment);
+  }
+  for(const auto cell : activeCells_) active[cell] = 0u;
+
+  if( activeColumns == nullptr and minThreshold_ == 0u ) { //untouched segments qualify as well
+    matchingSegments_.resize(potential.size());
+    std::iota(matchingSegments_.begin(), matchingSegments_.end(), 0u);
+  }
+  // Same order as Connections::sortSegments()
+  std::sort(matchingSegments_.begin(), matchingSegments_.end(), [&](const Segment a, const Segment b) {
+    return connections.compareSegments(a, b) or (not connections.compareSegments(b, a) and a < b);
+  });
+  matchingValid_ = activeColumns == nullptr;
+}
+
+
 void TemporalMemory::compute(const SDR &activeColumns, const bool learn) {
-  SDR externalPredictiveInputsActive({ externalPredictiveInputs_ });
-  SDR externalPredictiveInputsWinners({ externalPredictiveInputs_ });
-  compute( activeColumns, learn, externalPredictiveInputsActive, externalPredictiveInputsWinners );
+  if( noExternalInputs_.size != externalPredictiveInputs_ ) {
+    noExternalInputs_.initialize({ externalPredictiveInputs_ });
+  }
+  compute( activeColumns, learn, noExternalInputs_, noExternalInputs_ );
 }
 
+void TemporalMemory::learnSequences(const vector<SDR> &sequence, const vector<bool> &resets) {
+  NTA_CHECK( resets.empty() or resets.size() == sequence.size() )
+    << "TM.learnSequences: " << resets.size() << " resets for " << sequence.size() << " records.";
+  NTA_CHECK( externalPredictiveInputs_ == 0u )
+    << "TM.learnSequences: external predictive inputs are not supported.";
+  NTA_CHECK( not segmentsValid_ )
+    << "TM.learnSequences: must not be called between TM.activateDendrites() and TM.activateCells().";
+  if( noExternalInputs_.size != externalPredictiveInputs_ ) {
+    noExternalInputs_.initialize({ externalPredictiveInputs_ });
+  }
+
+  for(size_t i = 0u; i < sequence.size(); i++) {
+    if( not resets.empty() and resets[i] ) reset();
+    activateDendrites(true, noExternalInputs_, noExternalInputs_);
+    activateCells(sequence[i], true);
+  }
+  tmAnomaly_.anomaly_ = -1.0f;
+}
+
+void TemporalMemory::computeBatch(const vector<SDR> &activeColumns, vector<TMState> &states) {
+  NTA_CHECK( activeColumns.size() == states.size() )
+    << "TM.computeBatch: need one state per input, got " << activeColumns.size() << " inputs and " << states.size() << " states.";
+  NTA_CHECK( tmAnomaly_.mode_ == ANMode::DISABLED or tmAnomaly_.mode_ == ANMode::RAW )
+    << "TM.computeBatch: anomaly likelihood is not supported, it keeps a history per stream.";
+  NTA_CHECK( externalPredictiveInputs_ == 0u )
+    << "TM.computeBatch: external predictive inputs are not supported.";
+  NTA_CHECK( not segmentsValid_ )
+    << "TM.computeBatch: must not be called between TM.activateDendrites() and TM.activateCells().";
+
+  // The TM's own state is parked in `own` meanwhile.
+  TMState own;
+  swapState_(own);
+  for(size_t i = 0u; i < states.size(); i++) {
+    swapState_(states[i]);
+    compute(activeColumns[i], false);
+    swapState_(states[i]);
+  }
+  swapState_(own);
+}
+
+
+TMStateSnapshot TemporalMemory::snapshot() const {
+  TMStateSnapshot snap;
+  snap.activeCells   = activeCells_;
+  snap.winnerCells   = winnerCells_;
+  snap.anomaly       = tmAnomaly_.anomaly_;
+  snap.segmentsValid = segmentsValid_;
+  snap.iteration     = connections.iteration();
+  snap.rng           = rng_;
+  snap.externalActiveCells = externalActiveCells_;
+  snap.externalWinnerCells = externalWinnerCells_;
+  if( segmentsValid_ ) {
+    if( not matchingValid_ ) completeMatching_();
+    snap.activeSegments   = activeSegments_;
+    snap.matchingSegments = matchingSegments_;
+    for(const auto &segments : {&snap.activeSegments, &snap.matchingSegments}) {
+      for(const auto segment : *segments) {
+        snap.segmentCounts.push_back({segment,
+                                      numActiveConnectedSynapsesForSegment_[segment],
+                                      numActivePotentialSynapsesForSegment_[segment]});
+      }
+    }
+  }
+  return snap;
+}
+
+
+void TemporalMemory::restore(const TMStateSnapshot &snap) {
+  NTA_CHECK( not snap.segmentsValid or snap.iteration == connections.iteration() )
+    << "TM.restore: the snapshot has active segments, but the connections learned since it was taken.";
+  activeCells_      = snap.activeCells;
+  winnerCells_      = snap.winnerCells;
+  tmAnomaly_.anomaly_ = snap.anomaly;
+  segmentsValid_    = snap.segmentsValid;
+  activeSegments_   = snap.activeSegments;
+  activeSegmentsChanged_();
+  matchingSegments_ = snap.matchingSegments;
+  matchingValid_    = true;
+  rng_              = snap.rng;
+  externalActiveCells_ = snap.externalActiveCells;
+  externalWinnerCells_ = snap.externalWinnerCells;
+
+  // Restore the segment counts, keeping the invariant of the sparse
+  // computeActivity(): only the touched segments have non-zero counts.
+  auto &connected = numActiveConnectedSynapsesForSegment_;
+  auto &potential = numActivePotentialSynapsesForSegment_;
+  const size_t length = connections.segmentFlatListLength();
+  if( connected.size() != potential.size() ) {
+    connected.assign(length, 0u);
+    potential.assign(length, 0u);
+  } else {
+    for(const auto segment : touchedSegments_) {
+      if( segment < connected.size() ) {
+        connected[segment] = 0u;
+        potential[segment] = 0u;
+      }
+    }
+    connected.resize(std::max(connected.size(), length), 0u);
+    potential.resize(std::max(potential.size(), length), 0u);
+  }
+  touchedSegments_.clear();
+  for(const auto &counts : snap.segmentCounts) {
+    connected[counts.segment] = counts.connected;
+    potential[counts.segment] = counts.potential;
+    touchedSegments_.push_back(counts.segment);
+  }
+}
+
+
+void TemporalMemory::swapState_(TMState &state) {
+  activeCells_.swap(state.activeCells);
+  winnerCells_.swap(state.winnerCells);
+  std::swap(tmAnomaly_.anomaly_, state.anomaly);
+  segmentsValid_ = false;
+}
+
+
 void TemporalMemory::reset(void) {
   activeCells_.clear();
   winnerCells_.clear();
+  externalActiveCells_.clear();
+  externalWinnerCells_.clear();
   activeSegments_.clear();
   matchingSegments_.clear();
+  matchingValid_ = true;
+  activeSegmentsChanged_();
   segmentsValid_ = false;
   tmAnomaly_.anomaly_ = -1.0f; //TODO reset rather to 0.5 as default (undecided) anomaly
 }
@@ -510,7 +1163,16 @@ void TemporalMemory::reset(void) {
 // ==============================
 UInt TemporalMemory::columnForCell(const CellIdx cell) const {
   NTA_ASSERT(cell < numberOfCells());
-  return cell / cellsPerColumn_;
+  return columnOf_(cell);
+}
+
+
+void TemporalMemory::initCellsPerColumnShift_() {
+  cellsPerColumnShift_ = NO_SHIFT;
+  if( cellsPerColumn_ == 0u or (cellsPerColumn_ & (cellsPerColumn_ - 1u)) != 0u ) return;
+  UInt shift = 0u;
+  while( (1u << shift) != cellsPerColumn_ ) shift++;
+  cellsPerColumnShift_ = shift;
 }
 
 
@@ -527,7 +1189,7 @@ SDR TemporalMemory::cellsToColumns(const SDR& cells) const {
   SDR cols(getColumnDimensions());
   auto& dense = cols.getDense();
   for(const auto cell : cells.getSparse()) {
-    const auto col = columnForCell(cell);
+    const auto col = columnOf_(cell);
     dense[col] = static_cast<ElemDense>(1);
   }
   cols.setDense(dense);
@@ -546,45 +1208,58 @@ vector<CellIdx> TemporalMemory::cellsForColumn(const CellIdx column) const {
   return cellsInColumn;
 }
 
-vector<CellIdx> TemporalMemory::getActiveCells() const { return activeCells_; }
+const vector<CellIdx> &TemporalMemory::getActiveCells() const { return activeCells_; }
 
 void TemporalMemory::getActiveCells(SDR &activeCells) const
 {
   UInt nbr_cells = static_cast<UInt>(numberOfCells());
   NTA_CHECK( activeCells.size == nbr_cells );
-  activeCells.setSparse( getActiveCells() );
+  activeCells.setSparse( activeCells_ );
 }
 
 
-SDR TemporalMemory::getPredictiveCells() const {
+const SDR &TemporalMemory::getPredictiveCells() const {
 
   NTA_CHECK( segmentsValid_ )
     << "Call TM.activateDendrites() before TM.getPredictiveCells()!";
 
-  auto correctDims = getColumnDimensions();
-  correctDims.push_back(static_cast<CellIdx>(getCellsPerColumn()));
-  SDR predictive(correctDims);
-
-  std::set<CellIdx> uniqueCells;
-  //uniqueCells.reserve(activeSegments_.size());
-
-  for (const auto segment : activeSegments_) {
-    const CellIdx cell = connections.cellForSegment(segment);
-    uniqueCells.insert(cell); //set keeps the cells unique
+  if( not predictiveCellsValid_ ) {
+    if( predictiveCells_.size != numberOfCells() ) {
+      auto correctDims = getColumnDimensions();
+      correctDims.push_back(static_cast<CellIdx>(getCellsPerColumn()));
+      predictiveCells_.initialize(correctDims);
+    }
+    // activeSegments_ are sorted by cell, so equal cells are adjacent
+    auto &sparse = predictiveCells_.getSparse();
+    sparse.clear();
+    for (const auto segment : activeSegments_) {
+      const CellIdx cell = connections.cellForSegment(segment);
+      if( sparse.empty() or sparse.back() != cell ) {
+        sparse.push_back(cell);
+      }
+    }
+    predictiveCells_.setSparse(sparse); //sparse is the SDR's own buffer, swapped with itself
+    predictiveCellsValid_ = true;
   }
+  return predictiveCells_;
+}
+
 
-  vector<CellIdx> predictiveCells(uniqueCells.begin(), uniqueCells.end());
-  predictive.setSparse(predictiveCells);
-  return predictive;
+void TemporalMemory::getPredictiveCells(SDR &predictiveCells) const {
+  const SDR &predictive = getPredictiveCells();
+  NTA_CHECK( predictiveCells.dimensions == predictive.dimensions )
+    << "TM.getPredictiveCells: SDR dimensions must be {column dims x cells per column}";
+  const SDR_sparse_t &cells = predictive.getSparse(); //const: copy, the non-const overload would swap
+  predictiveCells.setSparse( cells );
 }
 
 
-vector<CellIdx> TemporalMemory::getWinnerCells() const { return winnerCells_; }
+const vector<CellIdx> &TemporalMemory::getWinnerCells() const { return winnerCells_; }
 
 void TemporalMemory::getWinnerCells(SDR &winnerCells) const
 {
   NTA_CHECK( winnerCells.size == numberOfCells() );
-  winnerCells.setSparse( getWinnerCells() );
+  winnerCells.setSparse( winnerCells_ );
 }
 
 vector<Segment> TemporalMemory::getActiveSegments() const
@@ -599,6 +1274,7 @@ vector<Segment> TemporalMemory::getMatchingSegments() const
 {
   NTA_CHECK( segmentsValid_ )
     << "Call TM.activateDendrites() before TM.getActiveSegments()!";
+  if( not matchingValid_ ) completeMatching_();
 
   return matchingSegments_;
 }
@@ -644,6 +1320,129 @@ void TemporalMemory::setCheckInputs(bool checkInputs) {
   checkInputs_ = checkInputs;
 }
 
+void TemporalMemory::setNumThreads(const UInt numThreads) {
+  connections_.setNumThreads(numThreads);
+  externalConnections_.setNumThreads(numThreads);
+}
+
+size_t TemporalMemory::memoryUsage() const {
+  const auto bytes = [](const vector<SynapseIdx> &v) { return v.capacity() * sizeof(SynapseIdx); };
+  const auto segmentBytes = [](const vector<Segment> &v) { return v.capacity() * sizeof(Segment); };
+  return connections_.memoryUsage() + externalConnections_.memoryUsage() +
+         bytes(numActiveConnectedSynapsesForSegment_) + bytes(numActivePotentialSynapsesForSegment_) +
+         bytes(externalConnected_) + bytes(externalPotential_) +
+         segmentBytes(activeSegments_) + segmentBytes(matchingSegments_) +
+         segmentBytes(touchedSegments_) + segmentBytes(externalSegment_) + segmentBytes(basalSegment_);
+}
+
+// Connections::compact() keeps the relative order of the segments, so the
+// new index of a segment is the number of live segments before it.
+static vector<Segment> compactedIndex(const Connections &connections) {
+  vector<Segment> newIndex(connections.segmentFlatListLength(), std::numeric_limits<Segment>::max());
+  for(CellIdx cell = 0; cell < connections.numCells(); cell++) {
+    for(const auto segment : connections.segmentsForCell(cell)) newIndex[segment] = 0u;
+  }
+  Segment live = 0u;
+  for(auto &index : newIndex) {
+    if( index == 0u ) index = live++;
+  }
+  return newIndex;
+}
+
+
+void TemporalMemory::compact() {
+  const auto holes = [](const Connections &c) { return c.numSegments() != c.segmentFlatListLength(); };
+  if( not holes(connections_) and not (separateExternal_ and holes(externalConnections_)) ) return; //nothing to release
+
+  const vector<Segment> newIndex = compactedIndex(connections_);
+  connections_.compact();
+  if( separateExternal_ ) renumberMirrors_(newIndex, false);
+  remapSegments_(newIndex);
+}
+
+
+void TemporalMemory::defragment() {
+  const vector<Segment> newIndex = connections_.defragment();
+  if( separateExternal_ ) renumberMirrors_(newIndex, true);
+  remapSegments_(newIndex);
+}
+
+
+void TemporalMemory::renumberMirrors_(const vector<Segment> &newIndex, const bool defragment) {
+  const Segment destroyed = std::numeric_limits<Segment>::max();
+  // A mirror of a destroyed segment would have no segment after the renumbering.
+  for(Segment mirror = 0u; mirror < basalSegment_.size(); mirror++) {
+    const Segment segment = basalSegment_[mirror];
+    if( segment != NO_MIRROR and newIndex[segment] == destroyed ) destroyMirror_(segment);
+  }
+
+  vector<Segment> newMirrorIndex;
+  if( defragment ) {
+    newMirrorIndex = externalConnections_.defragment();
+  } else {
+    newMirrorIndex = compactedIndex(externalConnections_);
+    externalConnections_.compact();
+  }
+
+  vector<Segment> externalSegment(connections_.segmentFlatListLength(), NO_MIRROR);
+  vector<Segment> basalSegment(externalConnections_.segmentFlatListLength(), NO_MIRROR);
+  for(Segment mirror = 0u; mirror < basalSegment_.size(); mirror++) {
+    const Segment segment = basalSegment_[mirror];
+    if( segment == NO_MIRROR ) continue;
+    NTA_ASSERT(newMirrorIndex[mirror] != destroyed);
+    externalSegment[newIndex[segment]] = newMirrorIndex[mirror];
+    basalSegment[newMirrorIndex[mirror]] = newIndex[segment];
+  }
+  externalSegment_.swap(externalSegment);
+  basalSegment_.swap(basalSegment);
+
+  externalTouched_.clear(); //the counts of the old mirrors are recomputed from scratch
+  externalConnected_.clear();
+  externalPotential_.clear();
+}
+
+
+void TemporalMemory::remapSegments_(const vector<Segment> &newIndex) {
+  const Segment destroyed = std::numeric_limits<Segment>::max();
+  const auto renumber = [&](vector<Segment> &segments) {
+    size_t kept = 0u;
+    for(const auto segment : segments) {
+      const Segment index = newIndex[segment];
+      if( index != destroyed ) segments[kept++] = index;
+    }
+    segments.resize(kept);
+  };
+
+  // Move the counts of the touched segments, the others are zero.
+  auto &connected = numActiveConnectedSynapsesForSegment_;
+  auto &potential = numActivePotentialSynapsesForSegment_;
+  vector<std::tuple<Segment, SynapseIdx, SynapseIdx>> counts;
+  if( connected.size() == potential.size() ) {
+    for(const auto segment : touchedSegments_) {
+      if( segment >= connected.size() ) continue;
+      const Segment index = newIndex[segment];
+      if( index != destroyed ) counts.emplace_back(index, connected[segment], potential[segment]);
+      connected[segment] = 0u;
+      potential[segment] = 0u;
+    }
+  } else {
+    connected.clear();
+    potential.clear();
+  }
+  connected.resize(connections_.segmentFlatListLength(), 0u);
+  potential.resize(connections_.segmentFlatListLength(), 0u);
+  touchedSegments_.clear();
+  for(const auto &count : counts) {
+    const Segment segment = std::get<0>(count);
+    touchedSegments_.push_back(segment);
+    connected[segment] = std::get<1>(count);
+    potential[segment] = std::get<2>(count);
+  }
+  renumber(activeSegments_);
+  renumber(matchingSegments_);
+  activeSegmentsChanged_();
+}
+
 Permanence TemporalMemory::getPermanenceIncrement() const {
   return permanenceIncrement_;
 }
@@ -717,6 +1516,15 @@ bool TemporalMemory::operator==(const TemporalMemory &other) const {
     return false;
   }
 
+  if (separateExternal_ != other.separateExternal_ ||
+      externalActiveCells_ != other.externalActiveCells_ ||
+      externalWinnerCells_ != other.externalWinnerCells_ ||
+      (separateExternal_ && externalConnections != other.externalConnections)) {
+    return false;
+  }
+
+  if( not matchingValid_ ) completeMatching_();
+  if( not other.matchingValid_ ) other.completeMatching_();
   if (getComparableSegmentSet(connections, activeSegments_) !=
           getComparableSegmentSet(other.connections, other.activeSegments_) ||
       getComparableSegmentSet(connections, matchingSegments_) !=
@@ -22,13 +22,19 @@
 #ifndef NTA_TEMPORAL_MEMORY_HPP
 #define NTA_TEMPORAL_MEMORY_HPP
 
+#include <htm/algorithms/ComputeBackend.hpp>
 #include <htm/algorithms/Connections.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Sdr.hpp>
+#include <htm/types/SparseSdr.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/utils/Random.hpp>
+#include <htm/utils/AlgorithmStats.hpp>
 #include <htm/algorithms/AnomalyLikelihood.hpp>
 
+#include <limits>
+#include <memory>
+#include <tuple>
 #include <vector>
 
 
@@ -38,6 +44,46 @@ using namespace std;
 using namespace htm;
 
 
+/**
+ * State of one input stream of a TemporalMemory, held outside of the TM.
+ * @see TemporalMemory::computeBatch()
+ *
+ * A default constructed state is the same as the state after TM.reset().
+ */
+struct TMState {
+  vector<CellIdx> activeCells;
+  vector<CellIdx> winnerCells;
+  Real anomaly = -1.0f; //anomaly of the last computeBatch() of this stream
+};
+
+
+/**
+ * Snapshot of the activity state of a TemporalMemory, without the
+ * Connections.  @see TemporalMemory::snapshot(), TemporalMemory::restore()
+ *
+ * Snapshots are plain values, copying one forks the state.  The cost is
+ * O(active cells + active/matching segments), independent of the number
+ * of synapses.
+ */
+struct TMStateSnapshot : public TMState {
+  bool segmentsValid = false; //taken after activateDendrites()
+  vector<Segment> activeSegments;
+  vector<Segment> matchingSegments;
+  // active synapse counts of the active & matching segments
+  struct SegmentCounts {
+    Segment    segment;
+    SynapseIdx connected;
+    SynapseIdx potential;
+  };
+  vector<SegmentCounts> segmentCounts;
+  UInt32 iteration = 0u; //Connections::iteration() when taken
+  Random rng; //bursting columns draw from the TM's random generator, also in inference
+  // external inputs of a TM with separate external connections, taken after activateDendrites()
+  vector<CellIdx> externalActiveCells;
+  vector<CellIdx> externalWinnerCells;
+};
+
+
 /**
  * Temporal Memory implementation in C++.
  *
@@ -55,6 +101,8 @@ using namespace htm;
  */
 class TemporalMemory : public Serializable
 {
+  friend class EdgeExporter;
+
 public:
   enum class ANMode { DISABLED = 0, RAW = 1, LIKELIHOOD = 2, LOGLIKELIHOOD = 3};
   TemporalMemory();
@@ -172,6 +220,12 @@ public:
     ANMode        anomalyMode                 = ANMode::RAW
     );
 
+  /**
+   * Copies the TM, its Connections are forked (@see Connections::fork).
+   * The public references (connections, anomaly, ...) refer to the copy.
+   */
+  TemporalMemory(const TemporalMemory &other);
+
   virtual ~TemporalMemory();
 
   //----------------------------------------------------------------------
@@ -270,6 +324,55 @@ public:
   virtual void compute(const SDR &activeColumns, 
                        const bool learn = true);
 
+  /**
+   * Offline training on a dataset: the same learning as `compute(x, true)`
+   * for each record x of `sequence`, with a reset() before the records which
+   * start a new sequence.  The anomaly is not computed, TM.anomaly is -1
+   * afterwards as after reset(), and the likelihood modes' history is not
+   * updated.  Use it to train on large datasets, where the per record
+   * anomaly of compute() is thrown away.
+   *
+   * External predictive inputs are not supported.
+   *
+   * @param sequence Sorted SDRs of active columns, in order.
+   * @param resets   Optional, true for the records which start a new
+   *                 sequence, the TM is reset before them.
+   */
+  void learnSequences(const vector<SDR> &sequence, const vector<bool> &resets = {});
+
+  /**
+   * Inference (learn=false) over many independent input streams which share
+   * this trained TM.  For each i, `compute(activeColumns[i], false)` runs on
+   * the cell state `states[i]`, which is updated in place.  The streams are
+   * processed one after another against the same connections, so the
+   * synapse structures stay warm in the cache, and the states are swapped
+   * in & out without copying.  The TM's own state is left unchanged.
+   *
+   * Only for anomaly modes DISABLED and RAW, the likelihood modes keep a
+   * history which is not part of the stream state.  External predictive
+   * inputs are not supported.
+   *
+   * @param activeColumns One SDR of active columns per stream.
+   * @param states        One state per stream, same length as activeColumns.
+   */
+  void computeBatch(const vector<SDR> &activeColumns, vector<TMState> &states);
+
+  /**
+   * Capture the activity state (active & winner cells, active & matching
+   * segments, anomaly, random generator) for what-if inference: take a snapshot, run
+   * speculative `compute(..., learn=false)` steps, then `restore()` the
+   * snapshot to continue with the live model.  The Connections are shared,
+   * not copied.
+   *
+   * A snapshot with valid segments (taken between activateDendrites() and
+   * activateCells()) can only be restored while the connections did not
+   * start a new learning step (Connections::iteration()), as the segments
+   * may have changed.  The anomaly likelihood history
+   * is not part of the snapshot.
+   */
+  TMStateSnapshot snapshot() const;
+  void restore(const TMStateSnapshot &snapshot);
+
   // ==============================
   //  Helper functions
   // ==============================
@@ -316,23 +419,30 @@ public:
   /**
    * Returns the indices of the active cells.
    *
-   * @returns (std::vector<CellIdx>) Vector of indices of active cells.
+   * @returns (std::vector<CellIdx>) Vector of indices of active cells, valid
+   * until the next compute.
    */
-  vector<CellIdx> getActiveCells() const; //TODO remove
+  const vector<CellIdx> &getActiveCells() const; //TODO remove
   void getActiveCells(SDR &activeCells) const;
 
   /**
    * @return SDR with indices of the predictive cells.
    * SDR dimensions are {TM column dims x TM cells per column}
+   *
+   * The SDR is built on the first call after activateDendrites() and cached
+   * until the segments change, the reference is valid until then.  The
+   * overload copies it into a caller-owned SDR of the same dimensions.
    */
-  SDR getPredictiveCells() const;
+  const SDR &getPredictiveCells() const;
+  void getPredictiveCells(SDR &predictiveCells) const;
 
   /**
    * Returns the indices of the winner cells.
    *
-   * @returns (std::vector<CellIdx>) Vector of indices of winner cells.
+   * @returns (std::vector<CellIdx>) Vector of indices of winner cells, valid
+   * until the next compute.
    */
-  vector<CellIdx> getWinnerCells() const; //TODO remove?
+  const vector<CellIdx> &getWinnerCells() const; //TODO remove?
   void getWinnerCells(SDR &winnerCells) const;
 
   vector<Segment> getActiveSegments() const;
@@ -405,6 +515,101 @@ public:
   bool getCheckInputs() const;
   void setCheckInputs(bool);
 
+  /**
+   * Set the number of threads used by compute().
+   *
+   * With more than one thread, the Connections compute the segment activity
+   * in parallel, of the connections and of the separate external connections
+   * (@see Connections::setNumThreads), and learning runs in two phases: the
+   * permanence updates of all learning segments are computed concurrently,
+   * then the structural changes (connected state, pruning, synapse growth,
+   * new segments) are applied serially in column order.  The results are
+   * identical to the single threaded TM, for any number of threads.
+   *
+   * @param numThreads Number of threads including the calling thread.
+   *        Default 1 (no threading). Use 0 for all hardware threads.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setNumThreads(const UInt numThreads);
+  UInt getNumThreads() const noexcept { return connections_.getNumThreads(); }
+
+  /**
+   * Set a ComputeBackend: activateDendrites() with learn == false then counts
+   * the active synapses of the segments with the backend.  The results are
+   * identical to the built in compute.  Not used with separate external
+   * connections (@see getSeparateExternalConnections).
+   *
+   * @param backend The backend, eg. `ComputeBackend::create("cpu", 0u)`,
+   *        or nullptr (default) for the built in compute.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setComputeBackend(const std::shared_ptr<ComputeBackend> &backend) { backend_ = backend; }
+  const std::shared_ptr<ComputeBackend> &getComputeBackend() const noexcept { return backend_; }
+
+  /**
+   * Skip the potential synapses in inference.  With learn == false,
+   * activateDendrites() then counts only the connected synapses, which gives
+   * the active segments and the predictions.  The matching segments are
+   * computed on demand: for the bursting columns by activateCells() (to pick
+   * their winner cells), and for all segments by getMatchingSegments().
+   * The active and winner cells are identical to the default TM, but the
+   * matching segments of an inference step are not kept after
+   * activateCells().  Not used with separate external connections
+   * (@see getSeparateExternalConnections) nor with a ComputeBackend.
+   *
+   * Default false. This is a runtime setting, it is not serialized.
+   */
+  void setLazyMatching(const bool enable) { lazyMatching_ = enable; }
+  bool getLazyMatching() const noexcept { return lazyMatching_; }
+
+  /**
+   * Estimate the heap memory held by this TM, in bytes, mostly its
+   * Connections (@see Connections::memoryUsage).
+   */
+  size_t memoryUsage() const;
+
+  /**
+   * A copy of this TM for evaluating a variant, eg. with another
+   * permanenceIncrement.  The synapses are shared with this TM until either
+   * one changes them (@see Connections::fork), so forking a large trained
+   * model is cheap.  The fork has no ComputeBackend, it can run concurrently
+   * with this TM.
+   */
+  TemporalMemory fork() const;
+
+  /**
+   * Release the storage of the destroyed segments and synapses
+   * (@see Connections::compact).  Unlike Connections::compact() this keeps
+   * the active & matching segments of the TM valid, so it can be called
+   * between any two compute() calls.  Snapshots taken before are invalidated.
+   *
+   * With separate external connections (@see setSeparateExternalConnections)
+   * both Connections are compacted, and the segments keep their mirrors.
+   */
+  void compact();
+
+  /**
+   * Hold the periodic maintenance of the Connections, @see
+   * Connections::holdMaintenance.
+   */
+  void holdMaintenance(const bool hold) noexcept {
+    connections_.holdMaintenance(hold);
+    externalConnections_.holdMaintenance(hold);
+  }
+
+  /**
+   * Make the segments of each cell and the synapses of each segment
+   * contiguous in memory (@see Connections::defragment), for a better
+   * locality of learning after a long run.  Keeps the active & matching
+   * segments valid and does not change the results, same as compact().
+   *
+   * With separate external connections both Connections are defragmented,
+   * and the segments keep their mirrors.
+   */
+  void defragment();
+
   /**
    * Returns the permanence increment.
    *
@@ -443,6 +648,26 @@ public:
    */
   SynapseIdx getMaxSynapsesPerSegment() const;
 
+  /**
+   * Keep the synapses to the external predictive inputs in a second
+   * Connections (`externalConnections`), instead of appending the external
+   * inputs after the TM's own cells in `connections`.
+   *
+   * The external synapses of a segment live on a mirror segment on the same
+   * cell in `externalConnections`, which is created with the first external
+   * synapse.  The activity of a segment is the sum of both, so each
+   * presynaptic index only holds its own inputs, and the external
+   * computeActivity() is skipped when no external input is active.
+   * Learning is the same as with the shared Connections, except that
+   * synapses of equal permanence are destroyed (to make room for new ones)
+   * on the cells first, then on the external inputs.
+   *
+   * Must be set before the TM grew any synapses.  Serialized.
+   * Requires the 'externalPredictiveInputs' constructor parameter.
+   */
+  void setSeparateExternalConnections(const bool enable);
+  bool getSeparateExternalConnections() const noexcept { return separateExternal_; }
+
   /**
    * Save (serialize) / Load (deserialize) the current state of the spatial pooler
    * to the specified stream.
@@ -472,6 +697,7 @@ public:
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
+    saveArchiveVersion(ar, ARCHIVE_MARKER, ARCHIVE_VERSION);
     ar(CEREAL_NVP(numColumns_),
        CEREAL_NVP(cellsPerColumn_),
        CEREAL_NVP(activationThreshold_),
@@ -516,6 +742,7 @@ public:
       }
     }
 
+    if( not matchingValid_ ) completeMatching_();
     size_t matchSize = matchingSegments_.size();
     ar(CEREAL_NVP(matchSize));
     if (matchSize > 0) {
@@ -532,11 +759,19 @@ public:
       }
     }
 
+    ar(CEREAL_NVP(separateExternal_));
+    if (separateExternal_) {
+      ar(CEREAL_NVP(externalConnections_),
+         CEREAL_NVP(basalSegment_),
+         CEREAL_NVP(externalActiveCells_),
+         CEREAL_NVP(externalWinnerCells_));
+    }
   }
   template<class Archive>
   void load_ar(Archive & ar) {
-    ar(CEREAL_NVP(numColumns_),
-       CEREAL_NVP(cellsPerColumn_),
+    const UInt32 version = loadArchiveVersion(ar, "numColumns_", numColumns_, ARCHIVE_MARKER, 1u);
+    NTA_CHECK(version <= ARCHIVE_VERSION) << "TemporalMemory: unknown archive version " << version;
+    ar(CEREAL_NVP(cellsPerColumn_),
        CEREAL_NVP(activationThreshold_),
        CEREAL_NVP(initialPermanence_),
        CEREAL_NVP(connectedPermanence_),
@@ -558,6 +793,15 @@ public:
        CEREAL_NVP(tmAnomaly_.mode_),
        CEREAL_NVP(tmAnomaly_.anomalyLikelihood_),
        CEREAL_NVP(connections_));
+    initCellsPerColumnShift_();
+    // Only the counts of the active & matching segments are stored, these
+    // are the touched segments for the next sparse computeActivity().
+    numActiveConnectedSynapsesForSegment_.clear();
+    numActivePotentialSynapsesForSegment_.clear();
+    touchedSegments_.clear();
+    activeSegments_.clear();
+    matchingSegments_.clear();
+    matchingValid_ = true;
     
     size_t activeSize;
     ar(CEREAL_NVP(activeSize));
@@ -572,6 +816,7 @@ public:
         Segment segment = connections.getSegment(c.cell, c.idx);
         activeSegments_[i] = segment;
         numActiveConnectedSynapsesForSegment_[segment] = c.syn;
+        touchedSegments_.push_back(segment);
       }
     }
     size_t matchSize;
@@ -587,7 +832,31 @@ public:
         Segment segment = connections.getSegment(c.cell, c.idx);
         matchingSegments_[i] = segment;
         numActivePotentialSynapsesForSegment_[segment] = c.syn;
+        touchedSegments_.push_back(segment);
+      }
+    }
+    activeSegmentsChanged_();
+
+    separateExternal_ = false;
+    if (version >= 2u) ar(CEREAL_NVP(separateExternal_));
+    externalSegment_.clear();
+    basalSegment_.clear();
+    externalActiveCells_.clear();
+    externalWinnerCells_.clear();
+    externalTouched_.clear(); //the external counts are recomputed from scratch
+    externalConnected_.clear();
+    externalPotential_.clear();
+    if (separateExternal_) {
+      ar(CEREAL_NVP(externalConnections_),
+         CEREAL_NVP(basalSegment_),
+         CEREAL_NVP(externalActiveCells_),
+         CEREAL_NVP(externalWinnerCells_));
+      externalSegment_.assign(connections.segmentFlatListLength(), NO_MIRROR);
+      for (Segment mirror = 0; mirror < basalSegment_.size(); mirror++) {
+        if (basalSegment_[mirror] != NO_MIRROR) externalSegment_[basalSegment_[mirror]] = mirror;
       }
+    } else {
+      externalConnections_ = Connections();
     }
   }
 
@@ -641,34 +910,109 @@ public:
 private:
   void punishPredictedColumn_(vector<Segment>::const_iterator columnMatchingSegmentsBegin, 
 		              vector<Segment>::const_iterator columnMatchingSegmentsEnd, 
-			      const SDR& prevActiveCells);
+			      const SparseSDR &prevActiveCells);
 
   void activatePredictedColumn_(vector<Segment>::const_iterator columnActiveSegmentsBegin,
 		                vector<Segment>::const_iterator columnActiveSegmentsEnd,
-				const SDR &prevActiveCells,
+				const SparseSDR &prevActiveCells,
 				const vector<CellIdx> &prevWinnerCells,
 				const bool learn);
 
   void burstColumn_(const UInt column,
 		                    vector<Segment>::const_iterator columnMatchingSegmentsBegin,
 				    vector<Segment>::const_iterator columnMatchingSegmentsEnd,
-				    const SDR &prevActiveCells,
+				    const SparseSDR &prevActiveCells,
 				    const vector<CellIdx> &prevWinnerCells,
 				    const bool learn);
 
+
+  vector<Segment>::const_iterator bestMatchingSegment_(vector<Segment>::const_iterator columnMatchingSegmentsBegin,
+                                                       vector<Segment>::const_iterator columnMatchingSegmentsEnd) const;
+
+  // Learning on a range of segments, either adapts them directly or applies
+  // the next pending result of the parallel learning phase.
+  void adaptSegments_(vector<Segment>::const_iterator begin,
+                      vector<Segment>::const_iterator end,
+                      const SparseSDR &prevActiveCells,
+                      const Permanence increment,
+                      const Permanence decrement);
+
+  // Calls fn(column, isActive, active segments begin/end, matching segments begin/end)
+  // for each column which is active or has matching segments, in column order.
+  template<typename F>
+  void forEachColumn_(const SDR &activeColumns, F fn) const;
+
+  // First phase of the parallel learning, @see setNumThreads()
+  void adaptPermanencesParallel_(const SDR &activeColumns, const SparseSDR &prevActiveCells);
+
   void growSynapses_(const Segment& segment,
 		     const SynapseIdx nDesiredNewSynapses,
 		     const vector<CellIdx> &prevWinnerCells);
 
+  // Separate external connections, @see setSeparateExternalConnections().
+  // The external candidates are given as `external input + numberOfCells()`.
+  inline Segment mirrorOf_(const Segment segment) const {
+    return segment < externalSegment_.size() ? externalSegment_[segment] : NO_MIRROR;
+  }
+  size_t numSynapses_(const Segment segment) const; //on the segment & its mirror
+  Segment createMirror_(const Segment segment);
+  void destroyMirror_(const Segment segment);
+  // Destroys the mirrors of the segments which createSegment() pruned from the cell.
+  void destroyStaleMirrors_(const CellIdx cell);
+  void addExternalActivity_(const bool learn);
+  void adaptExternal_(vector<Segment>::const_iterator begin,
+                      vector<Segment>::const_iterator end,
+                      const Permanence increment,
+                      const Permanence decrement);
+  void destroyMinPermanenceSynapsesSeparate_(const Segment segment,
+                                             const size_t nDestroy,
+                                             const vector<CellIdx> &excludeCells);
+  void growSynapsesSeparate_(const Segment segment,
+                             const vector<CellIdx> &candidates,
+                             const size_t maxNew);
+  static const Segment NO_MIRROR = std::numeric_limits<Segment>::max();
+
   CellIdx getLeastUsedCell_(const CellIdx column);
 
   void calculateAnomalyScore_(const SDR &activeColumns);
+  Real rawAnomalyScore_(const SDR &activeColumns) const;
+  // Updates the state derived from activeSegments_: the predicted columns
+  // and the getPredictiveCells() cache.
+  void activeSegmentsChanged_();
+
+  // Counts the active potential synapses after a lazy inference and selects
+  // the matching segments, of all segments or only of the bursting columns
+  // among `activeColumns`.  Reads the active cells of activateDendrites().
+  void completeMatching_(const vector<UInt> *activeColumns = nullptr) const;
+
+  // Moves the segment state of the TM to the new flat indices after the
+  // Connections were renumbered, @see compact(), defragment().
+  void remapSegments_(const vector<Segment> &newIndex);
+  // Compacts or defragments the separate external connections after
+  // connections_ was renumbered to `newIndex`, and moves the mirrors along.
+  void renumberMirrors_(const vector<Segment> &newIndex, const bool defragment);
+
+  // Column of the cell, a shift instead of the division when
+  // cellsPerColumn is a power of two (the common 16, 32 cells).
+  inline UInt columnOf_(const CellIdx cell) const {
+    return cellsPerColumnShift_ != NO_SHIFT ? cell >> cellsPerColumnShift_
+                                            : cell / cellsPerColumn_;
+  }
+  // Sets cellsPerColumnShift_ from cellsPerColumn_.
+  void initCellsPerColumnShift_();
+  static const UInt NO_SHIFT = 0xFFu;
+  void swapState_(TMState &state);
 
 protected:
+  // Members must also be copied by the copy constructor.
   //all these could be const
   CellIdx numColumns_;
+  // The archive, version 2 adds the separate external connections.
+  static const UInt32 ARCHIVE_VERSION = 2u;
+  static const CellIdx ARCHIVE_MARKER = std::numeric_limits<CellIdx>::max(); //never numColumns_
   vector<CellIdx> columnDimensions_;
   CellIdx cellsPerColumn_;
+  UInt cellsPerColumnShift_ = NO_SHIFT; // log2(cellsPerColumn_), not serialized
   SynapseIdx activationThreshold_;
   SynapseIdx minThreshold_;
   SynapseIdx maxNewSynapseCount_;
@@ -687,9 +1031,48 @@ private:
   vector<CellIdx> winnerCells_;
   bool segmentsValid_;
   vector<Segment> activeSegments_;
-  vector<Segment> matchingSegments_;
+  // The potential counts & matching segments are completed on demand after
+  // a lazy inference, @see setLazyMatching(), completeMatching_()
+  mutable vector<Segment> matchingSegments_;
   vector<SynapseIdx> numActiveConnectedSynapsesForSegment_;
-  vector<SynapseIdx> numActivePotentialSynapsesForSegment_;
+  mutable vector<SynapseIdx> numActivePotentialSynapsesForSegment_;
+  mutable vector<Segment> touchedSegments_; //only these may have non-zero counts above, not serialized
+  bool lazyMatching_ = false; //not serialized
+  mutable bool matchingValid_ = true; //false while the potential synapses of a lazy inference are not counted
+  mutable vector<Segment> lazySegments_; //scratch for completeMatching_()
+  mutable vector<UInt8>   lazyActive_;   //scratch, the active cells as flags
+
+  // Scratch, reused by each compute() so that the steady state does not
+  // allocate. Not serialized.
+  SparseSDR prevActiveCells_; //sized lazily, callback-free as it is set every step
+  vector<CellIdx> prevWinnerCells_;
+  vector<CellIdx> growCandidates_;
+  vector<CellIdx> columnCells_;
+  SDR noExternalInputs_{vector<UInt>{0u}};
+  vector<Connections::PendingAdaptation> pendingAdaptations_; //parallel learning
+  // cache of getPredictiveCells(), invalidated whenever activeSegments_ change
+  mutable SDR predictiveCells_{vector<UInt>{0u}};
+  mutable bool predictiveCellsValid_ = false;
+  // columns with an active segment, as flags per column and as list
+  vector<uint8_t> columnPredicted_;
+  vector<CellIdx> predictedColumns_;
+  size_t nextPending_ = 0u; //cursor into pendingAdaptations_
+  bool parallelLearning_ = false; //within activateCells()
+
+  // separate external connections, @see setSeparateExternalConnections()
+  bool separateExternal_ = false;
+  vector<Segment> externalSegment_; //segment -> its mirror in externalConnections_, or NO_MIRROR
+  vector<Segment> basalSegment_;    //mirror -> its segment in connections_, or NO_MIRROR
+  vector<CellIdx> externalActiveCells_;
+  vector<CellIdx> externalWinnerCells_;
+  SparseSDR prevExternalActiveCells_; //scratch, as prevActiveCells_
+  vector<CellIdx> prevExternalWinnerCells_;
+  vector<SynapseIdx> externalConnected_; //sparse computeActivity() buffers of externalConnections_
+  vector<SynapseIdx> externalPotential_;
+  vector<Segment> externalTouched_;
+  vector<CellIdx> growExisting_, growCells_, growExternal_; //scratch for growSynapsesSeparate_()
+  vector<Segment> staleMirrors_;
+  vector<std::tuple<Permanence, bool, Synapse, Synapse>> destroyCandidates_; //(permanence, external, id, synapse)
 
   Random rng_;
 
@@ -704,9 +1087,43 @@ private:
       AnomalyLikelihood anomalyLikelihood_; //TODO provide default/customizable params here
   };
   Connections connections_;
+  Connections externalConnections_;
+  std::shared_ptr<ComputeBackend> backend_; //not serialized, not compared
+
+  // Not serialized, not compared.
+  AlgorithmStats stats_{{"activateDendrites", "activateCells", "predictedColumns",
+                         "burstingColumns", "punishedColumns", "growSynapses", "createSegment"},
+                        {"predictedColumns", "burstingColumns", "punishedColumns",
+                         "segmentsCreated", "synapsesGrown", "segmentsDestroyed",
+                         "synapsesDestroyed"}};
 
 public:
+  /**
+   * Timers of the stages of compute(), and event counters, indexed by
+   * StatsTimer and StatsCounter.  Off until getStats().enable().
+   *   activateDendrites  the segment activity
+   *   activateCells      all of activateCells(), which includes the branches:
+   *   predictedColumns   active columns with active segments
+   *   burstingColumns    active columns without active segments
+   *   punishedColumns    inactive columns with matching segments
+   *   growSynapses       growSynapses_(), part of the branches
+   *   createSegment      new segments on bursting columns, part of burstingColumns
+   * The counters count the columns of each branch, the segments and synapses
+   * created, and those destroyed: pruned by the learning, or to make room for
+   * new ones.
+   * @see AlgorithmStats
+   */
+  enum StatsTimer { Stats_ActivateDendrites, Stats_ActivateCells, Stats_PredictedColumns,
+                    Stats_BurstingColumns, Stats_PunishedColumns, Stats_GrowSynapses,
+                    Stats_CreateSegment };
+  enum StatsCounter { Stats_NumPredictedColumns, Stats_NumBurstingColumns, Stats_NumPunishedColumns,
+                      Stats_SegmentsCreated, Stats_SynapsesGrown, Stats_SegmentsDestroyed,
+                      Stats_SynapsesDestroyed };
+  AlgorithmStats &getStats() { return stats_; }
+  const AlgorithmStats &getStats() const { return stats_; }
+
   const Connections& connections = connections_; //const view of Connections for the public
+  const Connections& externalConnections = externalConnections_; //@see setSeparateExternalConnections()
 
   const UInt &externalPredictiveInputs = externalPredictiveInputs_;
 
@@ -0,0 +1,399 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the C API, @see htm/capi/htm.h
+ */
+
+#include <cstring>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include <htm/capi/htm.h>
+#include <htm/engine/Input.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+
+using namespace htm;
+
+#define HTM_C_SAME_TYPE(c, cpp) (static_cast<int>(c) == static_cast<int>(cpp))
+static_assert(HTM_C_SAME_TYPE(HTM_TYPE_BYTE, NTA_BasicType_Byte) and HTM_C_SAME_TYPE(HTM_TYPE_REAL64, NTA_BasicType_Real64) and
+              HTM_C_SAME_TYPE(HTM_TYPE_BOOL, NTA_BasicType_Bool) and HTM_C_SAME_TYPE(HTM_TYPE_SDR, NTA_BasicType_SDR) and
+              HTM_C_SAME_TYPE(HTM_TYPE_STR, NTA_BasicType_Str), "htm_type must number as NTA_BasicType");
+static_assert(sizeof(UInt) == sizeof(uint32_t), "the views point at UInt");
+
+namespace {
+
+// An input bound to a buffer of the caller, @see htm_input_bind
+struct Binding {
+  std::shared_ptr<Input> input;
+  void *buffer;
+  size_t count;               // dense elements, or the bits of a sparse binding
+  const UInt32 *sparse;       // or the active bits,
+  const size_t *sparseCount;  //   with their count
+};
+
+thread_local std::string lastError;
+
+htm_status fail(htm_status status, const std::string &message) {
+  lastError = message;
+  return status;
+}
+
+// Runs an engine call, translating its exceptions into a status.
+template <typename F> htm_status guard(F call) {
+  try {
+    call();
+    return HTM_OK;
+  } catch (const std::exception &e) {
+    return fail(HTM_ERROR, e.what());
+  } catch (...) {
+    return fail(HTM_ERROR, "unknown exception");
+  }
+}
+
+} // namespace
+
+
+struct htm_network {
+  Network net;
+  std::vector<Binding> bindings;
+
+  // The active bits of the sparse bindings, which setSparse() checks only
+  // with assertions on.  @returns the error, empty if they are valid.
+  std::string checkBindings() const {
+    for (const auto &b : bindings) {
+      if (b.sparse == nullptr) continue;
+      const std::string name = b.input->getRegion()->getName() + "." + b.input->getName();
+      const size_t count = *b.sparseCount;
+      if (count > b.count)
+        return "The SDR input " + name + " has " + std::to_string(b.count) + " bits, not " +
+               std::to_string(count) + " active bits";
+      for (size_t i = 0u; i < count; i++) {
+        if (b.sparse[i] >= b.count)
+          return "The active bit " + std::to_string(b.sparse[i]) + " of " + name + " is out of range";
+        if (i > 0u and b.sparse[i - 1u] >= b.sparse[i])
+          return "The active bits of " + name + " must be sorted and unique";
+      }
+    }
+    return "";
+  }
+
+  // Copies the bound buffers into the inputs, once per htm_network_run().
+  void prepareBindings() {
+    for (auto &b : bindings) {
+      Array &data = b.input->getData();
+      if (data.getType() == NTA_BasicType_SDR) {
+        SDR &sdr = data.getSDR();
+        if (b.sparse != nullptr) {
+          sdr.setSparse(b.sparse, static_cast<UInt>(*b.sparseCount));
+        } else {
+          sdr.setDense(static_cast<const Byte *>(b.buffer));
+        }
+      } else if (data.getBuffer() != b.buffer) {
+        // Reallocated by the engine, eg. by initialize().
+        data.setBuffer(b.buffer, b.count);
+      }
+    }
+  }
+
+  // The regions compute again at each iteration even if they are pure.
+  void touchBindings() {
+    for (auto &b : bindings) {
+      b.input->touch();
+    }
+  }
+
+  std::vector<Binding>::iterator findBinding(const Input *input) {
+    for (auto it = bindings.begin(); it != bindings.end(); ++it) {
+      if (it->input.get() == input) return it;
+    }
+    return bindings.end();
+  }
+};
+
+
+#define HTM_C_CHECK(cond) \
+  if (!(cond)) return fail(HTM_ERROR_ARGUMENT, "invalid argument: " #cond)
+
+
+static NTA_BasicType parameterType(const Region &region, const std::string &name) {
+  const auto &parameters = region.getSpec()->parameters;
+  NTA_CHECK(parameters.contains(name))
+    << "Region " << region.getName() << " has no parameter '" << name << "'";
+  return parameters.getByName(name).dataType;
+}
+
+
+// The input of a region which may be bound.
+static std::shared_ptr<Input> bindableInput(htm_network *net, const char *region, const char *input) {
+  auto in = net->net.getRegion(region)->getInput(input);
+  NTA_CHECK(in != nullptr) << "Region " << region << " has no input '" << input << "'";
+  NTA_CHECK(not in->hasIncomingLinks())
+    << "The input " << region << "." << input << " has links, it can not be bound.";
+  return in;
+}
+
+// Sizes an SDR input to @size bits, before the network is initialized.
+static void sizeSdrInput(Input &in, size_t size) {
+  if (in.isInitialized()) {
+    NTA_CHECK(size == in.getData().getSDR().size)
+      << "The SDR input " << in.getRegion()->getName() << "." << in.getName() << " has "
+      << in.getData().getSDR().size << " bits, not " << size;
+  } else {
+    in.setDimensions({static_cast<UInt>(size)});
+  }
+}
+
+static void addBinding(htm_network *net, const Binding &binding) {
+  binding.input->setBound(true);
+  const auto it = net->findBinding(binding.input.get());
+  if (it != net->bindings.end()) *it = binding;
+  else net->bindings.push_back(binding);
+}
+
+
+extern "C" {
+
+uint32_t htm_api_version(void) { return HTM_C_API_VERSION; }
+
+const char *htm_last_error(void) { return lastError.c_str(); }
+
+
+htm_status htm_network_create(htm_network **net) {
+  HTM_C_CHECK(net != nullptr);
+  *net = nullptr;
+  return guard([&] { *net = new htm_network(); });
+}
+
+htm_status htm_network_load(htm_network **net, const char *path) {
+  HTM_C_CHECK(net != nullptr and path != nullptr);
+  *net = nullptr;
+  return guard([&] {
+    std::unique_ptr<htm_network> loaded(new htm_network());
+    loaded->net.loadFromFile(path);
+    *net = loaded.release();
+  });
+}
+
+void htm_network_destroy(htm_network *net) {
+  try {
+    delete net;
+  } catch (...) {
+  }
+}
+
+htm_status htm_network_save(const htm_network *net, const char *path) {
+  HTM_C_CHECK(net != nullptr and path != nullptr);
+  return guard([&] { net->net.saveToFile(path); });
+}
+
+htm_status htm_network_configure(htm_network *net, const char *yaml) {
+  HTM_C_CHECK(net != nullptr and yaml != nullptr);
+  return guard([&] { net->net.configure(yaml); });
+}
+
+htm_status htm_network_add_region(htm_network *net, const char *name, const char *type, const char *params) {
+  HTM_C_CHECK(net != nullptr and name != nullptr and type != nullptr);
+  return guard([&] { net->net.addRegion(name, type, params != nullptr ? params : ""); });
+}
+
+htm_status htm_network_link(htm_network *net, const char *src, const char *dest,
+                            const char *src_output, const char *dest_input) {
+  HTM_C_CHECK(net != nullptr and src != nullptr and dest != nullptr);
+  return guard([&] {
+    net->net.link(src, dest, "", "", src_output != nullptr ? src_output : "",
+                  dest_input != nullptr ? dest_input : "");
+  });
+}
+
+htm_status htm_network_initialize(htm_network *net) {
+  HTM_C_CHECK(net != nullptr);
+  return guard([&] { net->net.initialize(); });
+}
+
+htm_status htm_network_run(htm_network *net, uint32_t iterations) {
+  HTM_C_CHECK(net != nullptr);
+  const std::string invalid = net->checkBindings();
+  if (not invalid.empty()) return fail(HTM_ERROR_ARGUMENT, invalid);
+  return guard([&] {
+    // The caller can not write the buffers during the run, all the iterations read the same.
+    net->prepareBindings();
+    for (uint32_t i = 0u; i < iterations; i++) {
+      net->touchBindings();
+      net->net.run(1);
+    }
+  });
+}
+
+
+htm_status htm_region_set_int64(htm_network *net, const char *region, const char *param, int64_t value) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and param != nullptr);
+  return guard([&] {
+    Region &r = *net->net.getRegion(region);
+    switch (parameterType(r, param)) {
+    case NTA_BasicType_Int32:  r.setParameterInt32(param, static_cast<Int32>(value)); break;
+    case NTA_BasicType_UInt32: r.setParameterUInt32(param, static_cast<UInt32>(value)); break;
+    case NTA_BasicType_Int64:  r.setParameterInt64(param, static_cast<Int64>(value)); break;
+    case NTA_BasicType_UInt64: r.setParameterUInt64(param, static_cast<UInt64>(value)); break;
+    default: NTA_THROW << "The parameter '" << param << "' is not an integer.";
+    }
+  });
+}
+
+htm_status htm_region_set_real64(htm_network *net, const char *region, const char *param, double value) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and param != nullptr);
+  return guard([&] {
+    Region &r = *net->net.getRegion(region);
+    switch (parameterType(r, param)) {
+    case NTA_BasicType_Real32: r.setParameterReal32(param, static_cast<Real32>(value)); break;
+    case NTA_BasicType_Real64: r.setParameterReal64(param, value); break;
+    default: NTA_THROW << "The parameter '" << param << "' is not a real.";
+    }
+  });
+}
+
+htm_status htm_region_set_bool(htm_network *net, const char *region, const char *param, int value) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and param != nullptr);
+  return guard([&] { net->net.getRegion(region)->setParameterBool(param, value != 0); });
+}
+
+htm_status htm_region_get_int64(const htm_network *net, const char *region, const char *param, int64_t *value) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and param != nullptr and value != nullptr);
+  return guard([&] {
+    const Region &r = *net->net.getRegion(region);
+    switch (parameterType(r, param)) {
+    case NTA_BasicType_Int32:  *value = r.getParameterInt32(param); break;
+    case NTA_BasicType_UInt32: *value = r.getParameterUInt32(param); break;
+    case NTA_BasicType_Int64:  *value = r.getParameterInt64(param); break;
+    case NTA_BasicType_UInt64: *value = static_cast<int64_t>(r.getParameterUInt64(param)); break;
+    default: NTA_THROW << "The parameter '" << param << "' is not an integer.";
+    }
+  });
+}
+
+htm_status htm_region_get_real64(const htm_network *net, const char *region, const char *param, double *value) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and param != nullptr and value != nullptr);
+  return guard([&] {
+    const Region &r = *net->net.getRegion(region);
+    switch (parameterType(r, param)) {
+    case NTA_BasicType_Real32: *value = r.getParameterReal32(param); break;
+    case NTA_BasicType_Real64: *value = r.getParameterReal64(param); break;
+    default: NTA_THROW << "The parameter '" << param << "' is not a real.";
+    }
+  });
+}
+
+htm_status htm_region_get_bool(const htm_network *net, const char *region, const char *param, int *value) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and param != nullptr and value != nullptr);
+  return guard([&] { *value = net->net.getRegion(region)->getParameterBool(param) ? 1 : 0; });
+}
+
+
+htm_status htm_input_bind(htm_network *net, const char *region, const char *input,
+                          void *buffer, size_t count, htm_type type) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and input != nullptr and buffer != nullptr);
+  return guard([&] {
+    auto in = bindableInput(net, region, input);
+    if (in->getDataType() == NTA_BasicType_SDR) {
+      NTA_CHECK(type == HTM_TYPE_BYTE) << "The SDR input " << region << "." << input
+                                       << " binds a dense buffer of bytes.";
+      sizeSdrInput(*in, count);
+    } else {
+      NTA_CHECK(static_cast<NTA_BasicType>(type) == in->getDataType())
+        << "The input " << region << "." << input << " is of type " << BasicType::getName(in->getDataType());
+      in->setDimensions({static_cast<UInt>(count)});
+      if (in->isInitialized()) in->getData().setBuffer(buffer, count);
+    }
+    addBinding(net, Binding{in, buffer, count, nullptr, nullptr});
+  });
+}
+
+htm_status htm_input_bind_sparse(htm_network *net, const char *region, const char *input,
+                                 const uint32_t *sparse, const size_t *count, size_t size) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and input != nullptr and sparse != nullptr and count != nullptr);
+  return guard([&] {
+    auto in = bindableInput(net, region, input);
+    NTA_CHECK(in->getDataType() == NTA_BasicType_SDR)
+      << "The input " << region << "." << input << " is not an SDR.";
+    sizeSdrInput(*in, size);
+    addBinding(net, Binding{in, nullptr, size, sparse, count});
+  });
+}
+
+htm_status htm_input_unbind(htm_network *net, const char *region, const char *input) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and input != nullptr);
+  return guard([&] {
+    auto in = net->net.getRegion(region)->getInput(input);
+    NTA_CHECK(in != nullptr) << "Region " << region << " has no input '" << input << "'";
+    const auto it = net->findBinding(in.get());
+    NTA_CHECK(it != net->bindings.end()) << "The input " << region << "." << input << " is not bound.";
+    // The engine owns the input buffer again, a copy of the last values.
+    if (in->isInitialized() and in->getDataType() != NTA_BasicType_SDR) {
+      Array &data = in->getData();
+      Array copy(data.getType());
+      copy.allocateBuffer(it->count);
+      std::memcpy(copy.getBuffer(), it->buffer, it->count * BasicType::getSize(data.getType()));
+      data = copy;
+    }
+    in->setBound(false);
+    net->bindings.erase(it);
+  });
+}
+
+
+htm_status htm_output_view(const htm_network *net, const char *region, const char *output, htm_array_view *view) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and output != nullptr and view != nullptr);
+  return guard([&] {
+    const auto r = net->net.getRegion(region);
+    const Array &data = r->getOutputData(output);
+    NTA_CHECK(data.getType() != NTA_BasicType_Str and data.getType() != NTA_BasicType_Handle)
+      << "The output " << region << "." << output << " has no view.";
+    const std::vector<UInt> *dimensions;
+    if (data.getType() == NTA_BasicType_SDR) {
+      const SDR &sdr = data.getSDR();
+      view->data = sdr.getDense().data();
+      dimensions = &sdr.dimensions;
+    } else {
+      view->data = data.getBuffer();
+      dimensions = &r->getOutput(output)->getDimensions().asVector();
+    }
+    view->count = data.getCount();
+    view->type = static_cast<htm_type>(data.getType());
+    view->dimensions = dimensions->data();
+    view->num_dimensions = dimensions->size();
+  });
+}
+
+htm_status htm_output_sparse(const htm_network *net, const char *region, const char *output, htm_sdr_view *view) {
+  HTM_C_CHECK(net != nullptr and region != nullptr and output != nullptr and view != nullptr);
+  return guard([&] {
+    const Array &data = net->net.getRegion(region)->getOutputData(output);
+    NTA_CHECK(data.getType() == NTA_BasicType_SDR)
+      << "The output " << region << "." << output << " is not an SDR.";
+    const SDR &sdr = data.getSDR();
+    const auto &sparse = sdr.getSparse();
+    view->sparse = sparse.data();
+    view->count = sparse.size();
+    view->size = sdr.size;
+  });
+}
+
+} // extern "C"
@@ -0,0 +1,182 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * The C API of the engine, for embedding htm.core in other languages
+ * (Go, Rust, Java, ...) through their foreign function interface.
+ *
+ * It is a thin layer over Network, Region and Array.  The ABI is stable:
+ * handles are opaque, the structs only grow at their end, and the numbers
+ * of the enums never change; htm_api_version() tells which version of this
+ * header the library implements.
+ *
+ * No data is serialized and nothing is allocated per call:
+ *  - An input which is not linked may be bound to a buffer the caller owns,
+ *    htm_input_bind() and htm_input_bind_sparse().  The region reads its
+ *    numeric inputs in place from that buffer at every run; the caller only
+ *    writes the next values into it between runs.  The inputs of type SDR
+ *    (eg. the bottomUpIn of an SPRegion) own their storage, so the buffer is
+ *    copied into them once at the start of each htm_network_run(), into the
+ *    storage of the previous runs; all its iterations read the same values.
+ *  - Outputs are read through borrowed views, htm_output_view() and
+ *    htm_output_sparse(), which point into the buffers of the engine.  A view
+ *    is valid until the next run, or until the network is modified.
+ *
+ *   htm_network *net;
+ *   htm_network_create(&net);
+ *   htm_network_configure(net, "{network: [...]}");
+ *   htm_input_bind(net, "sp", "bottomUpIn", encoded, 1000, HTM_TYPE_BYTE);
+ *   htm_network_initialize(net);
+ *   for (...) {
+ *     encode(value, encoded);
+ *     if (htm_network_run(net, 1) != HTM_OK) fprintf(stderr, "%s\n", htm_last_error());
+ *     htm_output_sparse(net, "tm", "bottomUpOut", &active);
+ *   }
+ *   htm_network_destroy(net);
+ *
+ * The functions return a status; on an error htm_last_error() describes it.
+ * A network may be used by one thread at a time.
+ */
+
+#ifndef NTA_HTM_C_H
+#define NTA_HTM_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(HTM_C_SHARED)
+#define HTM_C_EXPORT __declspec(dllexport)
+#elif defined(__GNUC__)
+#define HTM_C_EXPORT __attribute__((visibility("default")))
+#else
+#define HTM_C_EXPORT
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HTM_C_API_VERSION 1
+
+typedef struct htm_network htm_network;
+
+typedef enum htm_status {
+  HTM_OK = 0,
+  HTM_ERROR = 1,          /* the engine failed, see htm_last_error() */
+  HTM_ERROR_ARGUMENT = 2  /* a null or invalid argument */
+} htm_status;
+
+/* The element types, the numbers of NTA_BasicType. */
+typedef enum htm_type {
+  HTM_TYPE_BYTE = 0,
+  HTM_TYPE_INT16 = 1,
+  HTM_TYPE_UINT16 = 2,
+  HTM_TYPE_INT32 = 3,
+  HTM_TYPE_UINT32 = 4,
+  HTM_TYPE_INT64 = 5,
+  HTM_TYPE_UINT64 = 6,
+  HTM_TYPE_REAL32 = 7,
+  HTM_TYPE_REAL64 = 8,
+  HTM_TYPE_HANDLE = 9,
+  HTM_TYPE_BOOL = 10,
+  HTM_TYPE_SDR = 11,   /* dense, one byte per bit */
+  HTM_TYPE_STR = 12
+} htm_type;
+
+/* A borrowed view of an output. */
+typedef struct htm_array_view {
+  const void *data;
+  size_t count;                  /* elements */
+  htm_type type;
+  const uint32_t *dimensions;
+  size_t num_dimensions;
+} htm_array_view;
+
+/* A borrowed view of the active bits of an SDR output. */
+typedef struct htm_sdr_view {
+  const uint32_t *sparse;        /* the indices of the active bits, sorted */
+  size_t count;
+  size_t size;                   /* the bits of the SDR */
+} htm_sdr_view;
+
+HTM_C_EXPORT uint32_t htm_api_version(void);
+
+/* The message of the last error of the calling thread, "" if none. */
+HTM_C_EXPORT const char *htm_last_error(void);
+
+/* Networks */
+HTM_C_EXPORT htm_status htm_network_create(htm_network **net);
+HTM_C_EXPORT htm_status htm_network_load(htm_network **net, const char *path);
+HTM_C_EXPORT void htm_network_destroy(htm_network *net);
+HTM_C_EXPORT htm_status htm_network_save(const htm_network *net, const char *path);
+/* Adds the regions and links of a YAML/JSON description, @see Network::configure */
+HTM_C_EXPORT htm_status htm_network_configure(htm_network *net, const char *yaml);
+HTM_C_EXPORT htm_status htm_network_add_region(htm_network *net, const char *name,
+                                               const char *type, const char *params);
+HTM_C_EXPORT htm_status htm_network_link(htm_network *net, const char *src, const char *dest,
+                                         const char *src_output, const char *dest_input);
+HTM_C_EXPORT htm_status htm_network_initialize(htm_network *net);
+HTM_C_EXPORT htm_status htm_network_run(htm_network *net, uint32_t iterations);
+
+/* Parameters of the regions */
+HTM_C_EXPORT htm_status htm_region_set_int64(htm_network *net, const char *region,
+                                             const char *param, int64_t value);
+HTM_C_EXPORT htm_status htm_region_set_real64(htm_network *net, const char *region,
+                                              const char *param, double value);
+HTM_C_EXPORT htm_status htm_region_set_bool(htm_network *net, const char *region,
+                                            const char *param, int value);
+HTM_C_EXPORT htm_status htm_region_get_int64(const htm_network *net, const char *region,
+                                             const char *param, int64_t *value);
+HTM_C_EXPORT htm_status htm_region_get_real64(const htm_network *net, const char *region,
+                                              const char *param, double *value);
+HTM_C_EXPORT htm_status htm_region_get_bool(const htm_network *net, const char *region,
+                                            const char *param, int *value);
+
+/*
+ * Binds an input without links to a buffer of @count elements of @type,
+ * which the caller owns and which must outlive the binding.  The regions
+ * treat a bound input as connected, eg. an SPRegion takes its input from
+ * it, so bind before htm_network_initialize() to size the input.  The
+ * region reads the buffer at every run:
+ *  - numeric inputs in place, the type must be that of the input,
+ *  - SDR inputs copy it, a dense buffer of HTM_TYPE_BYTE with one byte per
+ *    bit, @count the size of the SDR.
+ */
+HTM_C_EXPORT htm_status htm_input_bind(htm_network *net, const char *region, const char *input,
+                                       void *buffer, size_t count, htm_type type);
+/*
+ * Binds an SDR input of @size bits to the active bits of the caller:
+ * @sparse holds @*count sorted indices, @*count is read at every run.
+ * Both must outlive the binding.  htm_network_run() returns
+ * HTM_ERROR_ARGUMENT, before any region computes, if the indices are not
+ * sorted, unique and less than @size.
+ */
+HTM_C_EXPORT htm_status htm_input_bind_sparse(htm_network *net, const char *region, const char *input,
+                                              const uint32_t *sparse, const size_t *count, size_t size);
+HTM_C_EXPORT htm_status htm_input_unbind(htm_network *net, const char *region, const char *input);
+
+/* Borrowed views, valid until the next run or modification of the network. */
+HTM_C_EXPORT htm_status htm_output_view(const htm_network *net, const char *region, const char *output,
+                                        htm_array_view *view);
+HTM_C_EXPORT htm_status htm_output_sparse(const htm_network *net, const char *region, const char *output,
+                                          htm_sdr_view *view);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NTA_HTM_C_H */
@@ -0,0 +1,474 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the embeddable inference runtime.  Only the standard
+ * library, no exceptions and no heap, @see EdgeRuntime.hpp.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <htm/edge/EdgeRuntime.hpp>
+
+namespace htm {
+namespace edge {
+
+namespace {
+
+// Reads the flat archive in place, @see htm/utils/FlatArchive.hpp.  After a
+// failure it reads nothing and ok() is false.
+class Reader {
+public:
+  Reader(const char *data, size_t size) : data_(data), size_(size) {}
+
+  bool ok() const { return ok_; }
+
+  uint32_t u32() {
+    uint32_t value = 0u;
+    const char *p = take(sizeof(value));
+    if( p != nullptr ) std::memcpy(&value, p, sizeof(value));
+    return value;
+  }
+
+  template <typename T> const T *array(size_t &count) {
+    count = 0u;
+    uint64_t n = 0u;
+    const char *p = take(sizeof(n));
+    if( p != nullptr ) std::memcpy(&n, p, sizeof(n));
+    if( u32() != sizeof(T) ) ok_ = false;
+    take((MODEL_ALIGNMENT - pos_ % MODEL_ALIGNMENT) % MODEL_ALIGNMENT);
+    if( not ok_ or n > (size_ - pos_) / sizeof(T) ) {
+      ok_ = false;
+      return nullptr;
+    }
+    count = static_cast<size_t>(n);
+    return reinterpret_cast<const T *>(take(count * sizeof(T)));
+  }
+
+  const char *take(size_t bytes) {
+    if( not ok_ or bytes > size_ - pos_ ) {
+      ok_ = false;
+      return nullptr;
+    }
+    const char *p = data_ + pos_;
+    pos_ += bytes;
+    return p;
+  }
+
+private:
+  const char *data_;
+  size_t size_;
+  size_t pos_ = 0u;
+  bool ok_ = true;
+};
+
+// A CSR table: @param count + 1 non-decreasing offsets from 0 to @param size,
+// the entries less than @param limit.
+bool validRows(const uint32_t *offsets, size_t numOffsets, size_t count,
+               const uint32_t *entries, size_t size, uint32_t limit) {
+  if( offsets == nullptr or numOffsets != count + 1u or offsets[0] != 0u or offsets[count] != size )
+    return false;
+  for( size_t i = 0u; i < count; i++ ) {
+    if( offsets[i] > offsets[i + 1u] ) return false;
+  }
+  for( size_t i = 0u; i < size; i++ ) {
+    if( entries[i] >= limit ) return false;
+  }
+  return true;
+}
+
+size_t align4(size_t bytes) { return (bytes + 3u) & ~static_cast<size_t>(3u); }
+
+} // namespace
+
+
+const char *statusString(const Status status) {
+  switch( status ) {
+    case Status::Ok:        return "ok";
+    case Status::Malformed: return "malformed model";
+    case Status::Version:   return "unsupported model version";
+    case Status::ByteOrder: return "model of the other byte order";
+    case Status::Unaligned: return "buffer not aligned to 4 bytes";
+    case Status::NotLoaded: return "not loaded";
+    case Status::Workspace: return "workspace too small";
+    case Status::Input:     return "invalid input";
+  }
+  return "unknown status";
+}
+
+
+Status Model::load(const void *data, const size_t size) {
+  *this = Model();
+  if( reinterpret_cast<uintptr_t>(data) % 4u != 0u ) return Status::Unaligned;
+  Reader in(static_cast<const char *>(data), size);
+  const char *tag = in.take(8u);
+  if( tag == nullptr or std::memcmp(tag, MODEL_TAG, 8u) != 0 ) return Status::Malformed;
+  if( in.u32() != MODEL_VERSION ) return Status::Version;
+  if( in.u32() != MODEL_BYTE_ORDER ) return Status::ByteOrder;
+  const uint32_t flags = in.u32();
+  if( flags == 0u or flags > (HAS_SPATIAL_POOLER | HAS_TEMPORAL_MEMORY | HAS_CLASSIFIER) )
+    return Status::Malformed;
+
+  size_t n1, n2, n3, n4, n5, n6;
+  uint32_t numColumns = 0u;
+  if( flags & HAS_SPATIAL_POOLER ) {
+    auto &sp = sp_;
+    sp.numInputs         = in.u32();
+    numColumns           = in.u32();
+    sp.stimulusThreshold = in.u32();
+    sp.globalInhibition  = in.u32();
+    sp.numDesired        = in.u32();
+    sp.inputOffsets      = in.array<uint32_t>(n1);
+    sp.inputColumns      = in.array<uint32_t>(n2);
+    sp.boostFactors      = in.array<float>(n3);
+    sp.neighborOffsets   = in.array<uint32_t>(n4);
+    sp.neighbors         = in.array<uint32_t>(n5);
+    sp.numActive         = in.array<uint32_t>(n6);
+    if( not in.ok() or numColumns == 0u or
+        not validRows(sp.inputOffsets, n1, sp.numInputs, sp.inputColumns, n2, numColumns) or
+        (n3 != 0u and n3 != numColumns) )
+      return Status::Malformed;
+    if( n3 == 0u ) sp.boostFactors = nullptr;
+    if( sp.globalInhibition ) {
+      if( sp.numDesired == 0u or sp.numDesired > numColumns ) return Status::Malformed;
+    } else if( not validRows(sp.neighborOffsets, n4, numColumns, sp.neighbors, n5, numColumns) or
+               n6 != numColumns ) {
+      return Status::Malformed;
+    }
+  }
+
+  if( flags & HAS_TEMPORAL_MEMORY ) {
+    auto &tm = tm_;
+    const uint32_t tmColumns = in.u32();
+    tm.cellsPerColumn      = in.u32();
+    tm.activationThreshold = in.u32();
+    tm.numSegments         = in.u32();
+    tm.cellOffsets         = in.array<uint32_t>(n1);
+    tm.cellSegments        = in.array<uint32_t>(n2);
+    tm.segmentCells        = in.array<uint32_t>(n3);
+    tm.numCells = tmColumns * tm.cellsPerColumn;
+    if( not in.ok() or tmColumns == 0u or tm.cellsPerColumn == 0u or tm.activationThreshold == 0u or
+        tm.numCells / tm.cellsPerColumn != tmColumns or
+        (numColumns != 0u and numColumns != tmColumns) or
+        not validRows(tm.cellOffsets, n1, tm.numCells, tm.cellSegments, n2, tm.numSegments) or
+        n3 != tm.numSegments )
+      return Status::Malformed;
+    for( size_t i = 0u; i < n3; i++ ) {
+      if( tm.segmentCells[i] >= tm.numCells ) return Status::Malformed;
+    }
+    numColumns = tmColumns;
+  }
+
+  if( flags & HAS_CLASSIFIER ) {
+    auto &cls = classifier_;
+    cls.numInputs     = in.u32();
+    cls.numCategories = in.u32();
+    cls.rowOf         = in.array<uint32_t>(n1);
+    cls.weights       = in.array<float>(n2);
+    if( not in.ok() or cls.numInputs == 0u or cls.numCategories == 0u or
+        n1 != cls.numInputs or n2 % cls.numCategories != 0u )
+      return Status::Malformed;
+    const size_t numRows = n2 / cls.numCategories;
+    for( size_t i = 0u; i < n1; i++ ) {
+      if( cls.rowOf[i] != NO_ROW and cls.rowOf[i] >= numRows ) return Status::Malformed;
+    }
+    // The classifier reads the output of the previous stage.
+    if( (flags & HAS_TEMPORAL_MEMORY) ? cls.numInputs != tm_.numCells
+                                      : (numColumns != 0u and cls.numInputs != numColumns) )
+      return Status::Malformed;
+  }
+
+  flags_ = flags;
+  numColumns_ = numColumns;
+  return Status::Ok;
+}
+
+
+uint32_t Model::numInputs() const {
+  if( hasSpatialPooler() )  return sp_.numInputs;
+  if( hasTemporalMemory() ) return numColumns_;
+  return classifier_.numInputs;
+}
+
+
+size_t Model::workspaceSize(uint32_t maxActiveColumns) const {
+  size_t bytes = 4u * numColumns_; //active columns
+  if( hasSpatialPooler() ) {
+    bytes += 2u * 4u * numColumns_; //overlaps & scratch
+  }
+  if( hasTemporalMemory() ) {
+    if( maxActiveColumns == 0u ) {
+      maxActiveColumns = hasSpatialPooler() and sp_.globalInhibition ? sp_.numDesired : numColumns_;
+    }
+    maxActiveColumns = std::min(maxActiveColumns, numColumns_);
+    bytes += align4(2u * static_cast<size_t>(tm_.numSegments));
+    bytes += 4u * ((static_cast<size_t>(tm_.numCells) + 31u) / 32u);
+    bytes += 4u * static_cast<size_t>(maxActiveColumns) * tm_.cellsPerColumn;
+  }
+  if( hasClassifier() ) {
+    bytes += 4u * static_cast<size_t>(classifier_.numCategories);
+  }
+  return bytes;
+}
+
+
+Status Runtime::initialize(const Model &model, void *workspace, const size_t size,
+                           uint32_t maxActiveColumns) {
+  model_ = nullptr;
+  if( not model.isLoaded() ) return Status::NotLoaded;
+  if( reinterpret_cast<uintptr_t>(workspace) % 4u != 0u ) return Status::Unaligned;
+  const size_t needed = model.workspaceSize(maxActiveColumns);
+  if( size < needed ) return Status::Workspace;
+  std::memset(workspace, 0, needed);
+
+  char *p = static_cast<char *>(workspace);
+  const auto carve = [&p](const size_t bytes) {
+    char *block = p;
+    p += align4(bytes);
+    return block;
+  };
+  const size_t numColumns = model.numColumns_;
+  activeColumns_ = reinterpret_cast<uint32_t *>(carve(4u * numColumns));
+  if( model.hasSpatialPooler() ) {
+    overlaps_ = reinterpret_cast<float *>(carve(4u * numColumns));
+    scratch_  = reinterpret_cast<uint32_t *>(carve(4u * numColumns));
+  }
+  if( model.hasTemporalMemory() ) {
+    const auto &tm = model.tm_;
+    if( maxActiveColumns == 0u ) {
+      maxActiveColumns = model.hasSpatialPooler() and model.sp_.globalInhibition ? model.sp_.numDesired
+                                                                                 : model.numColumns_;
+    }
+    maxActiveColumns_ = std::min(maxActiveColumns, model.numColumns_);
+    segmentCounts_ = reinterpret_cast<uint16_t *>(carve(2u * static_cast<size_t>(tm.numSegments)));
+    predictive_    = reinterpret_cast<uint32_t *>(carve(4u * ((static_cast<size_t>(tm.numCells) + 31u) / 32u)));
+    activeCells_   = reinterpret_cast<uint32_t *>(carve(4u * static_cast<size_t>(maxActiveColumns_) * tm.cellsPerColumn));
+  }
+  if( model.hasClassifier() ) {
+    probabilities_ = reinterpret_cast<float *>(carve(4u * static_cast<size_t>(model.classifier_.numCategories)));
+  }
+  model_ = &model;
+  reset();
+  return Status::Ok;
+}
+
+
+void Runtime::reset() {
+  numActiveColumns_ = 0u;
+  numActiveCells_ = 0u;
+  anomaly_ = 0.0f;
+  if( predictive_ != nullptr ) {
+    std::memset(predictive_, 0, 4u * ((static_cast<size_t>(model_->tm_.numCells) + 31u) / 32u));
+  }
+}
+
+
+Status Runtime::compute(const uint32_t *input, const size_t count) {
+  if( model_ == nullptr ) return Status::NotLoaded;
+  const Model &model = *model_;
+  const uint32_t numInputs = model.numInputs();
+  for( size_t i = 0u; i < count; i++ ) {
+    if( input[i] >= numInputs ) return Status::Input;
+  }
+
+  const uint32_t *next = input;
+  size_t numNext = count;
+  if( model.hasSpatialPooler() ) {
+    spatialPooler_(input, count);
+    next = activeColumns_;
+    numNext = numActiveColumns_;
+  } else if( model.hasTemporalMemory() ) {
+    for( size_t i = 1u; i < count; i++ ) {
+      if( input[i - 1u] >= input[i] ) return Status::Input; //sorted & unique
+    }
+    std::copy(input, input + count, activeColumns_);
+    numActiveColumns_ = count;
+  }
+  if( model.hasTemporalMemory() ) {
+    const Status status = temporalMemory_(next, numNext);
+    if( status != Status::Ok ) return status;
+    next = activeCells_;
+    numNext = numActiveCells_;
+  }
+  if( model.hasClassifier() ) {
+    classifier_(next, numNext);
+  }
+  return Status::Ok;
+}
+
+
+void Runtime::spatialPooler_(const uint32_t *input, const size_t count) {
+  const auto &sp = model_->sp_;
+  const uint32_t numColumns = model_->numColumns_;
+  std::fill(overlaps_, overlaps_ + numColumns, 0.0f);
+  for( size_t i = 0u; i < count; i++ ) {
+    const uint32_t bit = input[i];
+    const uint32_t stop = sp.inputOffsets[bit + 1u];
+    for( uint32_t syn = sp.inputOffsets[bit]; syn < stop; syn++ ) {
+      overlaps_[sp.inputColumns[syn]] += 1.0f;
+    }
+  }
+  if( sp.boostFactors != nullptr ) {
+    for( uint32_t column = 0u; column < numColumns; column++ ) {
+      overlaps_[column] *= sp.boostFactors[column];
+    }
+  }
+  if( sp.globalInhibition ) {
+    inhibitGlobal_();
+  } else {
+    inhibitLocal_();
+  }
+}
+
+
+// Same as FrozenSpatialPooler::inhibitColumnsGlobal_
+void Runtime::inhibitGlobal_() {
+  const auto &sp = model_->sp_;
+  const uint32_t numColumns = model_->numColumns_;
+  const float *overlaps = overlaps_;
+  for( uint32_t column = 0u; column < numColumns; column++ ) scratch_[column] = column;
+  std::nth_element(scratch_, scratch_ + sp.numDesired, scratch_ + numColumns,
+    [overlaps](const uint32_t a, const uint32_t b) {
+      return (overlaps[a] == overlaps[b]) ? a > b : overlaps[a] > overlaps[b]; });
+  numActiveColumns_ = 0u;
+  for( uint32_t i = 0u; i < sp.numDesired; i++ ) {
+    if( not (overlaps[scratch_[i]] < static_cast<float>(sp.stimulusThreshold)) ) {
+      activeColumns_[numActiveColumns_++] = scratch_[i];
+    }
+  }
+  std::sort(activeColumns_, activeColumns_ + numActiveColumns_);
+}
+
+
+// Same as FrozenSpatialPooler::inhibitColumnsLocal_, with the neighborhoods
+// and their number of winners from the model.
+void Runtime::inhibitLocal_() {
+  const auto &sp = model_->sp_;
+  const uint32_t numColumns = model_->numColumns_;
+  uint32_t *isActive = scratch_;
+  std::fill(isActive, isActive + numColumns, 0u);
+  numActiveColumns_ = 0u;
+  for( uint32_t column = 0u; column < numColumns; column++ ) {
+    if( overlaps_[column] < static_cast<float>(sp.stimulusThreshold) ) {
+      continue;
+    }
+    const uint32_t numActive = sp.numActive[column];
+    uint32_t numBigger = 0u;
+    const uint32_t stop = sp.neighborOffsets[column + 1u];
+    for( uint32_t i = sp.neighborOffsets[column]; i < stop; i++ ) {
+      const uint32_t neighbor = sp.neighbors[i];
+      if( neighbor == column ) {
+        continue;
+      }
+      const float difference = overlaps_[neighbor] - overlaps_[column];
+      if( difference > 0.0f or (difference == 0.0f and isActive[neighbor]) ) {
+        numBigger++;
+        if( numBigger >= numActive ) { break; }
+      }
+    }
+    if( numBigger < numActive ) {
+      activeColumns_[numActiveColumns_++] = column;
+      isActive[column] = 1u;
+    }
+  }
+}
+
+
+// TemporalMemory::compute(learn=false): the predictive cells of the active
+// columns become active, the other active columns burst.  Then the active
+// segments predict the cells of the next step.
+Status Runtime::temporalMemory_(const uint32_t *columns, const size_t count) {
+  const auto &tm = model_->tm_;
+  if( count > maxActiveColumns_ ) return Status::Input;
+
+  numActiveCells_ = 0u;
+  size_t predicted = 0u;
+  for( size_t i = 0u; i < count; i++ ) {
+    const uint32_t start = columns[i] * tm.cellsPerColumn;
+    const uint32_t stop = start + tm.cellsPerColumn;
+    bool isPredicted = false;
+    for( uint32_t cell = start; cell < stop; cell++ ) {
+      if( predictive_[cell / 32u] & (1u << (cell % 32u)) ) {
+        activeCells_[numActiveCells_++] = cell;
+        isPredicted = true;
+      }
+    }
+    if( isPredicted ) {
+      predicted++;
+    } else {
+      for( uint32_t cell = start; cell < stop; cell++ ) activeCells_[numActiveCells_++] = cell;
+    }
+  }
+  anomaly_ = count == 0u ? 0.0f : static_cast<float>(count - predicted) / static_cast<float>(count);
+
+  // The segment counts are 0 between the steps: count, then the first visit
+  // of a segment in the second pass reads its total and clears it.
+  std::memset(predictive_, 0, 4u * ((static_cast<size_t>(tm.numCells) + 31u) / 32u));
+  for( size_t i = 0u; i < numActiveCells_; i++ ) {
+    const uint32_t cell = activeCells_[i];
+    for( uint32_t syn = tm.cellOffsets[cell]; syn < tm.cellOffsets[cell + 1u]; syn++ ) {
+      segmentCounts_[tm.cellSegments[syn]]++;
+    }
+  }
+  for( size_t i = 0u; i < numActiveCells_; i++ ) {
+    const uint32_t cell = activeCells_[i];
+    for( uint32_t syn = tm.cellOffsets[cell]; syn < tm.cellOffsets[cell + 1u]; syn++ ) {
+      const uint32_t segment = tm.cellSegments[syn];
+      if( segmentCounts_[segment] >= tm.activationThreshold ) {
+        const uint32_t predictedCell = tm.segmentCells[segment];
+        predictive_[predictedCell / 32u] |= 1u << (predictedCell % 32u);
+      }
+      segmentCounts_[segment] = 0u;
+    }
+  }
+  return Status::Ok;
+}
+
+
+// Classifier::infer: the softmax of the summed weights of the active inputs.
+void Runtime::classifier_(const uint32_t *input, const size_t count) {
+  const auto &cls = model_->classifier_;
+  const uint32_t n = cls.numCategories;
+  float *x = probabilities_;
+  std::fill(x, x + n, 0.0f);
+  for( size_t i = 0u; i < count; i++ ) {
+    const uint32_t row = cls.rowOf[input[i]];
+    if( row == NO_ROW ) continue;
+    const float *weights = cls.weights + static_cast<size_t>(row) * n;
+    for( uint32_t c = 0u; c < n; c++ ) x[c] += weights[c];
+  }
+  const float maxValue = *std::max_element(x, x + n);
+  float total = 0.0f;
+  for( uint32_t c = 0u; c < n; c++ ) {
+    x[c] = std::exp(x[c] - maxValue);
+    total += x[c];
+  }
+  for( uint32_t c = 0u; c < n; c++ ) x[c] /= total;
+}
+
+
+uint32_t Runtime::category() const {
+  const float *x = probabilities();
+  if( x == nullptr ) return 0u;
+  const uint32_t n = model_->classifier_.numCategories;
+  return static_cast<uint32_t>(std::max_element(x, x + n) - x);
+}
+
+} // namespace edge
+} // namespace htm
@@ -0,0 +1,212 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Embeddable inference runtime for exported models, @see EdgeExporter.
+ *
+ * The runtime runs a trained SpatialPooler -> TemporalMemory -> Classifier
+ * pipeline (any of the stages may be missing) without learning.  It is
+ * self-contained: these two files only need the C++11 standard library,
+ * not the rest of htm.core, and they build without exceptions and RTTI,
+ * eg. for a microcontroller:
+ *
+ *   g++ -std=c++11 -Os -fno-exceptions -fno-rtti -c htm/edge/EdgeRuntime.cpp
+ *
+ * The runtime never allocates.  The model is read in place, from a buffer
+ * (eg. in flash) which must outlive it, and all the state lives in a
+ * workspace the caller provides, of Model::workspaceSize() bytes:
+ *
+ *   static uint32_t workspace[WORKSPACE_WORDS]; // sized for the model
+ *   htm::edge::Model model;
+ *   htm::edge::Runtime runtime;
+ *   if( model.load(modelData, modelSize) != htm::edge::Status::Ok or
+ *       runtime.initialize(model, workspace, sizeof(workspace)) != htm::edge::Status::Ok ) ...
+ *   runtime.compute(encodedBits, numEncodedBits);
+ *   category = runtime.category();
+ *
+ * The results are those of SpatialPooler::compute(learn=false),
+ * TemporalMemory::compute(learn=false) and Classifier::infer, except that
+ * the anomaly is always the raw anomaly and the classifier accumulates in
+ * single precision.  Errors are reported by a Status, not by exceptions.
+ */
+
+#ifndef NTA_EDGE_RUNTIME_HPP
+#define NTA_EDGE_RUNTIME_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace htm {
+namespace edge {
+
+// The flat archive of a model: the layout of htm/utils/FlatArchive.hpp.
+static const char MODEL_TAG[9] = "HTMEDGE1";
+static const uint32_t MODEL_VERSION = 1u;
+static const uint32_t MODEL_BYTE_ORDER = 0x01020304u;
+static const size_t MODEL_ALIGNMENT = 64u;
+
+// The stages of a model, the flags after the header.
+static const uint32_t HAS_SPATIAL_POOLER = 1u;
+static const uint32_t HAS_TEMPORAL_MEMORY = 2u;
+static const uint32_t HAS_CLASSIFIER = 4u;
+
+// A row of the classifier without weights.
+static const uint32_t NO_ROW = 0xFFFFFFFFu;
+
+enum class Status : int {
+  Ok = 0,
+  Malformed,     // not a model, truncated or inconsistent
+  Version,       // a model of another version
+  ByteOrder,     // written on a machine of the other byte order
+  Unaligned,     // the model or the workspace is not aligned to 4 bytes
+  NotLoaded,     // the model or the runtime is not initialized
+  Workspace,     // the workspace is too small
+  Input          // an input bit is out of range, or too many are active
+};
+
+const char *statusString(Status status);
+
+/**
+ * A model, read in place from a buffer written by EdgeExporter.
+ */
+class Model {
+public:
+  /**
+   * @param data The model, aligned to 4 bytes. It must outlive the Model.
+   * @param size Its size in bytes.
+   */
+  Status load(const void *data, size_t size);
+
+  bool isLoaded() const { return flags_ != 0u; }
+  bool hasSpatialPooler() const { return (flags_ & HAS_SPATIAL_POOLER) != 0u; }
+  bool hasTemporalMemory() const { return (flags_ & HAS_TEMPORAL_MEMORY) != 0u; }
+  bool hasClassifier() const { return (flags_ & HAS_CLASSIFIER) != 0u; }
+
+  // The size of the input of the first stage.
+  uint32_t numInputs() const;
+  uint32_t numColumns() const { return numColumns_; }
+  uint32_t numCells() const { return tm_.numCells; }
+  uint32_t numCategories() const { return classifier_.numCategories; }
+
+  /**
+   * The bytes of the workspace of a Runtime.  @param maxActiveColumns bounds
+   * the active columns of the temporal memory, 0 is the bound of the model:
+   * the columns the spatial pooler activates, or all columns.
+   */
+  size_t workspaceSize(uint32_t maxActiveColumns = 0u) const;
+
+private:
+  friend class Runtime;
+
+  struct SpatialPooler {
+    uint32_t numInputs = 0u;
+    uint32_t stimulusThreshold = 0u;
+    uint32_t globalInhibition = 0u;
+    uint32_t numDesired = 0u;            // the active columns of the global inhibition
+    const uint32_t *inputOffsets = nullptr; // the columns of input i are
+    const uint32_t *inputColumns = nullptr; //   inputColumns[inputOffsets[i] .. inputOffsets[i+1])
+    const float *boostFactors = nullptr;    // nullptr without boosting
+    const uint32_t *neighborOffsets = nullptr; // local inhibition, the neighborhood of
+    const uint32_t *neighbors = nullptr;       //   column c is neighbors[neighborOffsets[c] .. [c+1])
+    const uint32_t *numActive = nullptr;       //   and c wins if less than numActive[c] neighbors are bigger
+  };
+  struct TemporalMemory {
+    uint32_t cellsPerColumn = 0u;
+    uint32_t numCells = 0u;
+    uint32_t activationThreshold = 0u;
+    uint32_t numSegments = 0u;
+    const uint32_t *cellOffsets = nullptr;  // the connected synapses of presynaptic cell i are on
+    const uint32_t *cellSegments = nullptr; //   cellSegments[cellOffsets[i] .. cellOffsets[i+1])
+    const uint32_t *segmentCells = nullptr; // the cell of each segment
+  };
+  struct Classifier {
+    uint32_t numInputs = 0u;
+    uint32_t numCategories = 0u;
+    const uint32_t *rowOf = nullptr; // the row of each input, or NO_ROW
+    const float *weights = nullptr;  // weights[row * numCategories + category]
+  };
+
+  uint32_t flags_ = 0u;
+  uint32_t numColumns_ = 0u;
+  SpatialPooler sp_;
+  TemporalMemory tm_;
+  Classifier classifier_;
+};
+
+/**
+ * The inference of a Model, with its state in a workspace.
+ */
+class Runtime {
+public:
+  /**
+   * @param model A loaded model, which must outlive the runtime.
+   * @param workspace At least model.workspaceSize(maxActiveColumns) bytes,
+   *        aligned to 4 bytes.  It must outlive the runtime.
+   */
+  Status initialize(const Model &model, void *workspace, size_t size, uint32_t maxActiveColumns = 0u);
+
+  /**
+   * One step of the pipeline.  @param input The active bits of the input of
+   * the first stage: the input of the spatial pooler, the active columns of
+   * the temporal memory (sorted), or the input of the classifier.
+   */
+  Status compute(const uint32_t *input, size_t count);
+
+  // Forgets the sequence of the temporal memory, as TemporalMemory::reset().
+  void reset();
+
+  // The active columns of the spatial pooler, or the input of the temporal memory.
+  const uint32_t *activeColumns(size_t &count) const { count = numActiveColumns_; return activeColumns_; }
+  const uint32_t *activeCells(size_t &count) const { count = numActiveCells_; return activeCells_; }
+  // The raw anomaly of the last step, 0 without a temporal memory.
+  float anomaly() const { return anomaly_; }
+  // The PDF over the categories, nullptr without a classifier.
+  const float *probabilities() const { return model_ != nullptr and model_->hasClassifier() ? probabilities_ : nullptr; }
+  // The most probable category, as htm::argmax of the PDF.
+  uint32_t category() const;
+
+private:
+  void spatialPooler_(const uint32_t *input, size_t count);
+  void inhibitGlobal_();
+  void inhibitLocal_();
+  Status temporalMemory_(const uint32_t *columns, size_t count);
+  void classifier_(const uint32_t *input, size_t count);
+
+  const Model *model_ = nullptr;
+  uint32_t maxActiveColumns_ = 0u;
+
+  // spatial pooler
+  float *overlaps_ = nullptr;        // boosted, per column
+  uint32_t *scratch_ = nullptr;      // per column
+  uint32_t *activeColumns_ = nullptr;
+  size_t numActiveColumns_ = 0u;
+
+  // temporal memory
+  uint16_t *segmentCounts_ = nullptr; // active connected synapses per segment, 0 between steps
+  uint32_t *predictive_ = nullptr;    // bitset of the predictive cells
+  uint32_t *activeCells_ = nullptr;   // maxActiveColumns_ * cellsPerColumn
+  size_t numActiveCells_ = 0u;
+  float anomaly_ = 0.0f;
+
+  // classifier
+  float *probabilities_ = nullptr;
+};
+
+} // namespace edge
+} // namespace htm
+
+#endif // NTA_EDGE_RUNTIME_HPP
@@ -62,9 +62,46 @@ public:
 
     virtual void encode(DataType input, SDR &output) = 0;
 
+    /**
+     * Encode @param n values at once, outputs[i] is the encoding of values[i].
+     * @param outputs is resized to n; SDRs already there which have the
+     * dimensions of the encoder are reused.  The default calls encode() for
+     * each value, encoders override it with a faster batched computation.
+     */
+    virtual void encodeBatch(const DataType *values, size_t n, std::vector<SDR> &outputs) {
+        prepareBatch_( n, outputs );
+        for( size_t i = 0u; i < n; i++ ) {
+            encode( values[i], outputs[i] );
+        }
+    }
+
+    /**
+     * Append the encoding of @param input to @param sparse, as sorted indices
+     * plus @param offset, for writing several encodings into one SDR (@see
+     * MultiEncoder).  The default encodes into a temporary SDR, encoders
+     * override it to write their bits directly.
+     */
+    virtual void encodeSparse(DataType input, UInt offset, SDR_sparse_t &sparse) {
+        SDR output( dimensions_ );
+        encode( input, output );
+        for( const auto bit : output.getSparse() ) {
+            sparse.push_back( bit + offset );
+        }
+    }
+
     virtual ~BaseEncoder() {}
 
 protected:
+    /** Resizes @param outputs to @param n SDRs with the dimensions of the encoder. */
+    void prepareBatch_(const size_t n, std::vector<SDR> &outputs) const {
+        outputs.resize( n );
+        for( auto &sdr : outputs ) {
+            if( sdr.dimensions != dimensions_ ) {
+                sdr.initialize( dimensions_ );
+            }
+        }
+    }
+
     BaseEncoder() {}
 
     BaseEncoder(const std::vector<UInt> dimensions)
@@ -0,0 +1,138 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the CategoryEncoder
+ */
+
+#include <htm/encoders/CategoryEncoder.hpp>
+#include <htm/utils/Random.hpp>
+#include <algorithm> // sort, unique
+#include <cmath> // round
+
+using namespace std;
+using namespace htm;
+
+namespace {
+  // The finalizer of splitmix64, a fast 64 bit hash with full avalanche.
+  inline UInt64 mix64(UInt64 x)
+  {
+    x ^= x >> 30u;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27u;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31u;
+    return x;
+  }
+}
+
+CategoryEncoder::CategoryEncoder( const CategoryEncoder_Parameters &parameters )
+  { initialize( parameters ); }
+
+void CategoryEncoder::initialize( const CategoryEncoder_Parameters &parameters )
+{
+  NTA_CHECK( parameters.size > 0u );
+  BaseEncoder<UInt64>::initialize({ parameters.size });
+
+  UInt num_active_args = 0;
+  if( parameters.activeBits > 0u)   { num_active_args++; }
+  if( parameters.sparsity   > 0.0f) { num_active_args++; }
+  NTA_CHECK( num_active_args != 0u )
+      << "Missing argument, need one of: 'activeBits' or 'sparsity'.";
+  NTA_CHECK( num_active_args == 1u )
+      << "Too many arguments, choose only one of: 'activeBits' or 'sparsity'.";
+
+  args_ = parameters;
+  if( args_.sparsity > 0.0f ) {
+    NTA_CHECK( args_.sparsity <= 1.0f );
+    args_.activeBits = (UInt) round( args_.size * args_.sparsity );
+    NTA_CHECK( args_.activeBits > 0u );
+  }
+  NTA_CHECK( args_.activeBits <= args_.size / 2u )
+      << "CategoryEncoder: activeBits must be at most half of the size.";
+  // Always calculate the sparsity, to correct for rounding error.
+  args_.sparsity = (Real) args_.activeBits / args_.size;
+
+  while( args_.seed == 0u ) {
+    args_.seed = Random().getUInt32();
+  }
+}
+
+UInt64 CategoryEncoder::categoryOf(const std::string &category)
+{
+  // FNV-1a, then mixed for the avalanche which FNV lacks.
+  UInt64 hash = 0xcbf29ce484222325ull;
+  for( const char c : category ) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ull;
+  }
+  return mix64( hash );
+}
+
+void CategoryEncoder::hashCategory_(const UInt64 category, SDR_sparse_t &bits) const
+{
+  // Successive positions of a counter-based generator keyed by the category
+  // and the seed.  Duplicate positions are drawn again, so that every
+  // category has exactly activeBits bits.
+  const UInt64 key  = mix64( category ^ mix64( args_.seed ));
+  const UInt64 size = args_.size;
+  UInt64 counter = 0u;
+  bits.clear();
+  while( bits.size() < args_.activeBits ) {
+    const size_t missing = args_.activeBits - bits.size();
+    for( size_t i = 0u; i < missing; i++ ) {
+      const UInt64 hash = mix64( key + 0x9e3779b97f4a7c15ull * ++counter );
+      // Maps the upper 32 bits to [0, size) without a division.
+      bits.push_back( static_cast<UInt>(((hash >> 32u) * size) >> 32u) );
+    }
+    sort( bits.begin(), bits.end() );
+    bits.erase( unique( bits.begin(), bits.end() ), bits.end() );
+  }
+}
+
+void CategoryEncoder::encode(const UInt64 category, SDR &output)
+{
+  NTA_CHECK( output.size == size );
+  hashCategory_( category, scratch_ );
+  output.setSparse( scratch_ ); //swaps, scratch_ gets the previous buffer of the SDR
+}
+
+void CategoryEncoder::encodeSparse(const UInt64 category, const UInt offset, SDR_sparse_t &sparse)
+{
+  hashCategory_( category, scratch_ );
+  for( const auto bit : scratch_ ) {
+    sparse.push_back( bit + offset );
+  }
+}
+
+void CategoryEncoder::encodeBatch(const UInt64 *categories, const size_t n, vector<SDR> &outputs)
+{
+  prepareBatch_( n, outputs );
+  for( size_t i = 0u; i < n; i++ ) {
+    hashCategory_( categories[i], scratch_ );
+    outputs[i].setSparse( scratch_ );
+  }
+}
+
+std::ostream & htm::operator<<(std::ostream & out, const CategoryEncoder &self)
+{
+  out << "CategoryEncoder ";
+  out << "  size:       " << self.parameters.size << ",\n";
+  out << "  activeBits: " << self.parameters.activeBits << ",\n";
+  out << "  seed:       " << self.parameters.seed << std::endl;
+  return out;
+}
@@ -0,0 +1,148 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Define the CategoryEncoder
+ */
+
+#ifndef NTA_ENCODERS_CATEGORY
+#define NTA_ENCODERS_CATEGORY
+
+#include <string>
+#include <vector>
+
+#include <htm/encoders/BaseEncoder.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/**
+ * Parameters for the CategoryEncoder
+ *
+ * Members "activeBits" & "sparsity" are mutually exclusive, specify exactly one
+ * of them.
+ */
+struct CategoryEncoder_Parameters
+{
+  /**
+   * Member "size" is the total number of bits in the encoded output SDR.
+   */
+  UInt size = 0u;
+
+  /**
+   * Member "activeBits" is the number of true bits in the encoded output SDR.
+   */
+  UInt activeBits = 0u;
+
+  /**
+   * Member "sparsity" is the fraction of bits in the encoded output which this
+   * encoder will activate. This is an alternative way to specify the member
+   * "activeBits".
+   */
+  Real sparsity = 0.0f;
+
+  /**
+   * Member "seed" forces different encoders to produce different outputs, even
+   * if the inputs and all other parameters are the same.  Two encoders with the
+   * same seed, parameters, and input will produce identical outputs.
+   *
+   * The seed 0 is special.  Seed 0 is replaced with a random number.
+   */
+  UInt seed = 0u;
+};
+
+/**
+ * Encodes a category, an unsigned integer or a string, as activeBits hashed
+ * positions.
+ *
+ * Description:
+ * For categorical fields with millions of values, such as user IDs.  The
+ * positions of the active bits are computed from the category with a 64 bit
+ * hash, so the encoder holds no state per category: its memory does not
+ * depend on the number of categories.  Each category gets exactly activeBits
+ * distinct bits.  Different categories do not overlap, except for chance
+ * collisions of the hash, like the RDSE with category=true, whose buckets
+ * are limited to 32 bits.
+ *
+ * Strings are first hashed into a 64 bit category, @see categoryOf().
+ */
+class CategoryEncoder : public BaseEncoder<UInt64>
+{
+public:
+  CategoryEncoder() {}
+  CategoryEncoder( const CategoryEncoder_Parameters &parameters );
+  void initialize( const CategoryEncoder_Parameters &parameters );
+
+  const CategoryEncoder_Parameters &parameters = args_;
+
+  void encode(UInt64 category, SDR &output) override;
+
+  /** Encode the category of a string, @see categoryOf(). */
+  void encode(const std::string &category, SDR &output)
+    { encode( categoryOf( category ), output ); }
+
+  /** Same results as encode() for each category, without virtual calls. */
+  void encodeBatch(const UInt64 *categories, size_t n, std::vector<SDR> &outputs) override;
+
+  void encodeSparse(UInt64 category, UInt offset, SDR_sparse_t &sparse) override;
+
+  /**
+   * @returns the 64 bit category of a string: a hash of its bytes, which
+   * does not depend on the platform.
+   */
+  static UInt64 categoryOf(const std::string &category);
+
+  ~CategoryEncoder() override {};
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    std::string name = "CategoryEncoder";
+    ar(cereal::make_nvp("name", name));
+    ar(cereal::make_nvp("size", args_.size));
+    ar(cereal::make_nvp("activeBits", args_.activeBits));
+    ar(cereal::make_nvp("sparsity", args_.sparsity));
+    ar(cereal::make_nvp("seed", args_.seed));
+  }
+
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    std::string name;
+    ar(cereal::make_nvp("name", name));
+    NTA_CHECK(name == "CategoryEncoder");
+    ar(cereal::make_nvp("size", args_.size));
+    ar(cereal::make_nvp("activeBits", args_.activeBits));
+    ar(cereal::make_nvp("sparsity", args_.sparsity));
+    ar(cereal::make_nvp("seed", args_.seed));
+    BaseEncoder<UInt64>::initialize({ parameters.size });
+  }
+
+private:
+  CategoryEncoder_Parameters args_;
+
+  // Sorted active bits of a category.
+  void hashCategory_(UInt64 category, SDR_sparse_t &bits) const;
+
+  SDR_sparse_t scratch_; //reused scratch
+};
+
+std::ostream & operator<<(std::ostream & out, const CategoryEncoder & self);
+
+}      // End namespace htm
+#endif // End ifdef NTA_ENCODERS_CATEGORY
@@ -0,0 +1,159 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2014, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the CoordinateEncoder
+ */
+
+#include <algorithm> // nth_element, sort, unique
+#include <cmath>     // round
+#include <functional> // greater
+
+#include <hasher.hpp> // digestpp: md5 hash digest
+#include <algorithm/md5.hpp>
+
+#include <htm/encoders/CoordinateEncoder.hpp>
+
+using namespace std;
+
+namespace htm {
+
+namespace {
+  // First output of std::mt19937 seeded with @param seed, as Random(seed)
+  // draws it.  Only the words 0, 1 and 397 of the state are needed for the
+  // first output, the other 621 words and the twist of the whole state are
+  // skipped.
+  UInt32 mt19937First(const UInt32 seed) {
+    UInt32 x = seed;
+    UInt32 x1 = 0u;
+    for( UInt32 i = 1u; i <= 397u; i++ ) {
+      x = 1812433253u * (x ^ (x >> 30)) + i;
+      if( i == 1u ) x1 = x;
+    }
+    const UInt32 y = (seed & 0x80000000u) | (x1 & 0x7fffffffu);
+    UInt32 z = x ^ (y >> 1) ^ ((y & 1u) ? 0x9908b0dfu : 0u);
+    z ^= z >> 11;
+    z ^= (z << 7)  & 0x9d2c5680u;
+    z ^= (z << 15) & 0xefc60000u;
+    z ^= z >> 18;
+    return z;
+  }
+} // end anonymous namespace
+
+
+CoordinateEncoder::CoordinateEncoder(const CoordinateEncoderParameters &parameters)
+  { initialize( parameters ); }
+
+void CoordinateEncoder::initialize(const CoordinateEncoderParameters &parameters)
+{
+  NTA_CHECK( parameters.size > 0u );
+
+  UInt num_active_args = 0;
+  if( parameters.activeBits > 0u)   { num_active_args++; }
+  if( parameters.sparsity   > 0.0f) { num_active_args++; }
+  NTA_CHECK( num_active_args != 0u )
+      << "Missing argument, need one of: 'activeBits' or 'sparsity'.";
+  NTA_CHECK( num_active_args == 1u )
+      << "Too many arguments, choose only one of: 'activeBits' or 'sparsity'.";
+
+  BaseEncoder<vector<Int>>::initialize({ parameters.size });
+  args_ = parameters;
+  if( args_.sparsity > 0.0f ) {
+    NTA_CHECK( args_.sparsity <= 1.0f );
+    args_.activeBits = (UInt) round( args_.size * args_.sparsity );
+    NTA_CHECK( args_.activeBits > 0u );
+  }
+  NTA_CHECK( args_.activeBits <= args_.size );
+  args_.sparsity = (Real) args_.activeBits / args_.size;
+}
+
+UInt32 CoordinateEncoder::hashCoordinate_(const vector<Int> &coordinate)
+{
+  // The MD5 digest of the coordinate as text, ex: "2,5,-10".  The seed of
+  // the Random is the digest modulo 2^64, of which mt19937 takes the low 32
+  // bits.
+  text_.clear();
+  for( size_t i = 0u; i < coordinate.size(); i++ ) {
+    if( i > 0u ) text_ += ',';
+    text_ += to_string( coordinate[i] );
+  }
+  digestpp::md5 hasher;
+  hasher.absorb( text_ );
+  unsigned char digest[16];
+  hasher.digest( digest, sizeof(digest) );
+  const UInt32 seed = ((UInt32) digest[12] << 24) | ((UInt32) digest[13] << 16) |
+                      ((UInt32) digest[14] << 8)  |  (UInt32) digest[15];
+  return mt19937First( seed );
+}
+
+void CoordinateEncoder::encode(const vector<Int> coordinate, SDR &output)
+  { encode( coordinate, args_.radius, output ); }
+
+void CoordinateEncoder::encode(const vector<Int> &coordinate, const UInt radius, SDR &output)
+{
+  NTA_CHECK( not coordinate.empty() ) << "CoordinateEncoder: empty coordinate.";
+  NTA_CHECK( output.size == size );
+  const UInt64 side = 2ull * radius + 1ull;
+  UInt64 numNeighbors = 1u;
+  for( size_t d = 0u; d < coordinate.size(); d++ ) {
+    numNeighbors *= side;
+    NTA_CHECK( numNeighbors <= 100000000ull )
+      << "CoordinateEncoder: too many neighbors, reduce the radius.";
+  }
+
+  // Hash every coordinate in the neighborhood.  The order of a coordinate is
+  // its hash divided by the maximum, so the highest hashes have the highest
+  // orders.
+  orders_.resize( numNeighbors );
+  neighbor_.resize( coordinate.size() );
+  for( size_t d = 0u; d < coordinate.size(); d++ ) {
+    neighbor_[d] = coordinate[d] - (Int) radius;
+  }
+  for( UInt64 n = 0u; n < numNeighbors; n++ ) {
+    orders_[n] = hashCoordinate_( neighbor_ );
+    for( size_t d = coordinate.size(); d-- > 0u; ) {
+      if( neighbor_[d] < coordinate[d] + (Int) radius ) {
+        neighbor_[d]++;
+        break;
+      }
+      neighbor_[d] = coordinate[d] - (Int) radius;
+    }
+  }
+
+  // Activate the bits of the top coordinates.  Coordinates with the same
+  // hash have the same bit, ties do not change the output.
+  const size_t numWinners = min<size_t>( args_.activeBits, orders_.size() );
+  nth_element( orders_.begin(), orders_.begin() + numWinners, orders_.end(), greater<UInt32>() );
+  active_.resize( numWinners );
+  for( size_t i = 0u; i < numWinners; i++ ) {
+    active_[i] = orders_[i] % size;
+  }
+  sort( active_.begin(), active_.end() );
+  active_.erase( unique( active_.begin(), active_.end() ), active_.end() );
+  output.setSparse( active_ ); //swaps, active_ gets the previous buffer of the SDR
+}
+
+std::ostream & operator<<(std::ostream & out, const CoordinateEncoder &self)
+{
+  out << "CoordinateEncoder \n";
+  out << "  size:       " << self.parameters.size << ",\n";
+  out << "  activeBits: " << self.parameters.activeBits << ",\n";
+  out << "  radius:     " << self.parameters.radius << std::endl;
+  return out;
+}
+
+} // end namespace htm
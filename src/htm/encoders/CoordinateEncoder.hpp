@@ -0,0 +1,151 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2014, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Define the CoordinateEncoder
+ */
+
+#ifndef NTA_ENCODERS_COORDINATE
+#define NTA_ENCODERS_COORDINATE
+
+#include <string>
+#include <vector>
+
+#include <htm/encoders/BaseEncoder.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/**
+ * Parameters for the CoordinateEncoder
+ *
+ * Members "activeBits" & "sparsity" are mutually exclusive, specify exactly one
+ * of them.
+ */
+struct CoordinateEncoderParameters
+{
+  /**
+   * Member "size" is the total number of bits in the encoded output SDR.
+   */
+  UInt size = 0u;
+
+  /**
+   * Member "activeBits" is the number of true bits in the encoded output SDR,
+   * barring hash collisions.
+   */
+  UInt activeBits = 0u;
+
+  /**
+   * Member "sparsity" is the fraction of bits in the encoded output which this
+   * encoder will activate. This is an alternative way to specify the member
+   * "activeBits".
+   */
+  Real sparsity = 0.0f;
+
+  /**
+   * Member "radius" of the neighborhood of a coordinate, in each dimension.
+   * A larger radius gives coordinates which are further apart overlapping
+   * encodings.  Can also be given with every coordinate, @see encode.
+   */
+  UInt radius = 0u;
+};
+
+/**
+ * Encodes a coordinate in an N-dimensional integer space.
+ *
+ * Description:
+ * Given a coordinate and a radius around it, the CoordinateEncoder returns an
+ * SDR representation of that position:
+ *
+ * 1. Find all the coordinates around the input coordinate, within the
+ *    radius.
+ * 2. Hash every such coordinate to its "order".
+ * 3. Of these coordinates, pick the activeBits coordinates with the highest
+ *    order.
+ * 4. Hash each of these coordinates to one of the bits of the SDR, and make
+ *    the bit active.
+ *
+ * Nearby coordinates share most of their neighborhoods, and so most of their
+ * active bits.
+ *
+ * The hashes are those of the python htm.encoders.coordinate, a MD5 digest of
+ * the coordinate as text seeding a Random, the encodings are the same.
+ */
+class CoordinateEncoder : public BaseEncoder<std::vector<Int>>
+{
+public:
+  CoordinateEncoder() {}
+  CoordinateEncoder( const CoordinateEncoderParameters &parameters );
+  void initialize( const CoordinateEncoderParameters &parameters );
+
+  const CoordinateEncoderParameters &parameters = args_;
+
+  /**
+   * Encode a coordinate with the radius of the parameters.
+   */
+  void encode(const std::vector<Int> coordinate, SDR &output) override;
+
+  /**
+   * Encode a coordinate with its own @param radius.
+   */
+  void encode(const std::vector<Int> &coordinate, UInt radius, SDR &output);
+
+  ~CoordinateEncoder() override {}
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    std::string name = "CoordinateEncoder";
+    ar(cereal::make_nvp("name", name));
+    ar(cereal::make_nvp("size", args_.size));
+    ar(cereal::make_nvp("activeBits", args_.activeBits));
+    ar(cereal::make_nvp("sparsity", args_.sparsity));
+    ar(cereal::make_nvp("radius", args_.radius));
+  }
+
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    std::string name;
+    ar(cereal::make_nvp("name", name));
+    NTA_CHECK(name == "CoordinateEncoder");
+    ar(cereal::make_nvp("size", args_.size));
+    ar(cereal::make_nvp("activeBits", args_.activeBits));
+    ar(cereal::make_nvp("sparsity", args_.sparsity));
+    ar(cereal::make_nvp("radius", args_.radius));
+    BaseEncoder<std::vector<Int>>::initialize({ args_.size });
+  }
+
+private:
+  CoordinateEncoderParameters args_;
+
+  // The first draw of the Random seeded with the hash of a coordinate, it
+  // gives both the order and the bit of the coordinate.
+  UInt32 hashCoordinate_(const std::vector<Int> &coordinate);
+
+  std::vector<Int>    neighbor_; //reused scratch
+  std::string         text_;     //reused scratch
+  std::vector<UInt32> orders_;   //reused scratch
+  SDR_sparse_t        active_;   //reused scratch
+};
+
+std::ostream & operator<<(std::ostream & out, const CoordinateEncoder & self);
+
+} // end namespace htm
+#endif // NTA_ENCODERS_COORDINATE
@@ -21,6 +21,7 @@
  *  ported from htm/encoders/date.py
  */
 
+#include <algorithm> // sort()
 #include <memory> // make_shared()
 #include <time.h> // localtime(), struct tm
 #include <iostream> // cerr
@@ -35,6 +36,8 @@ namespace htm {
 
 enum bucketType {SEASON=0, DAYOFWEEK, WEEKEND, CUSTOM, HOLIDAY, TIMEOFDAY};
 
+static const std::time_t DAY_SECONDS = 86400;
+
 
 DateEncoder::DateEncoder(const DateEncoderParameters &parameters) { initialize(parameters); }
 
@@ -193,6 +196,54 @@ void DateEncoder::initialize(const DateEncoderParameters &parameters) {
 
   NTA_CHECK(size > 0u) << "DateEncoder: No parameters were provided.";
   BaseEncoder::initialize({static_cast<UInt32>(size)});
+
+  holidayYear_ = -1;
+  dayCached_ = false;
+  dayStart_ = 0;
+  lookups_.clear();
+  if (lookupTables_)
+    buildLookupTables_();
+}
+
+
+void DateEncoder::setLookupTables(bool enable) {
+  lookupTables_ = enable;
+  lookups_.clear();
+  dayCached_ = false;
+  if (lookupTables_)
+    buildLookupTables_();
+}
+
+
+void DateEncoder::buildLookupTables_() {
+  // in the order of the output
+  const std::pair<size_t, std::shared_ptr<ScalarEncoder>> attributes[] = {
+      {SEASON, seasonEncoder_},   {DAYOFWEEK, dayOfWeekEncoder_}, {WEEKEND, weekendEncoder_},
+      {CUSTOM, customDaysEncoder_}, {HOLIDAY, holidayEncoder_},   {TIMEOFDAY, timeOfDayEncoder_}};
+  UInt offset = 0u;
+  for (const auto &attribute : attributes) {
+    const auto &encoder = attribute.second;
+    if (!encoder)
+      continue;
+    const UInt activeBits = encoder->parameters.activeBits;
+    // A periodic encoder starts at bit 'size' for its maximum, which wraps to 0.
+    const UInt numBuckets = encoder->parameters.periodic ? encoder->size + 1u
+                                                         : encoder->size - activeBits + 1u;
+    Lookup lookup;
+    lookup.attribute = attribute.first;
+    lookup.encoder = encoder;
+    lookup.offset = offset;
+    lookup.bits.resize(static_cast<size_t>(numBuckets) * activeBits);
+    for (UInt start = 0u; start < numBuckets; start++) {
+      const auto row = lookup.bits.begin() + static_cast<size_t>(start) * activeBits;
+      for (UInt i = 0u; i < activeBits; i++) {
+        row[i] = (start + i) % encoder->size + offset;
+      }
+      std::sort(row, row + activeBits);
+    }
+    lookups_.push_back(std::move(lookup));
+    offset += encoder->size;
+  }
 }
 
 
@@ -205,6 +256,10 @@ void DateEncoder::encode(std::time_t input, SDR &output) {
     // If no time is given (is 0), use the current time.
     input = time(0);
   }
+  if (lookupTables_ and not args_.verbose) {
+    encodeLookup_(localTime_(input), input, output);
+    return;
+  }
   struct std::tm timeinfo = *std::localtime(&input);
   encode(timeinfo, output);
 }
@@ -212,6 +267,10 @@ void DateEncoder::encode(std::time_t input, SDR &output) {
  // from python datetime
 void DateEncoder::encode(std::chrono::system_clock::time_point time_point, SDR &output) { 
   std::time_t input = std::chrono::system_clock::to_time_t(time_point);
+  if (lookupTables_ and not args_.verbose) {
+    encodeLookup_(localTime_(input), input, output);
+    return;
+  }
   struct std::tm timeinfo = *std::localtime(&input);
   encode(timeinfo, output);
 }
@@ -220,6 +279,17 @@ void DateEncoder::encode(std::chrono::system_clock::time_point time_point, SDR &
  * encode time from struct tm 
  */
 void DateEncoder::encode(struct std::tm timeinfo, SDR &output) {
+  std::time_t input = -1;
+  if (holidayEncoder_) {
+    struct std::tm copy = timeinfo;
+    input = std::mktime(&copy);
+  }
+  if (lookupTables_ and not args_.verbose) {
+    encodeLookup_(timeinfo, input, output);
+    return;
+  }
+  computeValues_(timeinfo, input);
+
   // -------------------------------------------------------------------------
   // Encode each sub-field
   std::vector<const SDR *> sdrs;
@@ -235,23 +305,125 @@ void DateEncoder::encode(struct std::tm timeinfo, SDR &output) {
            << ((timeinfo.tm_isdst)?" dst":"") 
            << std::endl;
   
+  if (seasonEncoder_) {
+    season_output = SDR(seasonEncoder_->dimensions);
+    seasonEncoder_->encode(values_[SEASON], season_output);
+    VERBOSE << "  season: " << values_[SEASON] << " ==> " << season_output;
+    sdrs.push_back(&season_output);
+  }
+  if (dayOfWeekEncoder_) {
+    dayOfWeek_output = SDR(dayOfWeekEncoder_->dimensions);
+    dayOfWeekEncoder_->encode(values_[DAYOFWEEK], dayOfWeek_output);
+    VERBOSE << "  dayOfWeek: " << values_[DAYOFWEEK] << " ==> " << dayOfWeek_output;
+    sdrs.push_back(&dayOfWeek_output);
+  }
+  if (weekendEncoder_) {
+    weekend_output = SDR(weekendEncoder_->dimensions);
+    weekendEncoder_->encode(values_[WEEKEND], weekend_output);
+    VERBOSE << "  weekend: " << values_[WEEKEND] << " ==> " << weekend_output;
+    sdrs.push_back(&weekend_output);
+  }
+  if (customDaysEncoder_) {
+    customDay_output = SDR(customDaysEncoder_->dimensions);
+    customDaysEncoder_->encode(values_[CUSTOM], customDay_output);
+    VERBOSE << "  custom Day: " << values_[CUSTOM] << " ==> " << customDay_output;
+    sdrs.push_back(&customDay_output);
+  }
+  if (holidayEncoder_) {
+    holiday_output = SDR(holidayEncoder_->dimensions);
+    holidayEncoder_->encode(values_[HOLIDAY], holiday_output);
+    VERBOSE << "  holiday: " << values_[HOLIDAY] << " ==> " << holiday_output;
+    sdrs.push_back(&holiday_output);
+  }
+  if (timeOfDayEncoder_) {
+    timeOfDay_output = SDR(timeOfDayEncoder_->dimensions);
+    timeOfDayEncoder_->encode(values_[TIMEOFDAY], timeOfDay_output);
+    VERBOSE << "  timeOfDay: " << values_[TIMEOFDAY] << "hrs ==> " << timeOfDay_output;
+    sdrs.push_back(&timeOfDay_output);
+  }
+  if (sdrs.size() > 1)
+    output.concatenate(sdrs);
+  else
+    output = *sdrs[0];
+  VERBOSE << "  Result: ==> " << output << std::endl;
+}
+
+
+void DateEncoder::encodeSparse(std::time_t input, UInt offset, SDR_sparse_t &sparse) {
+  if (not lookupTables_ or args_.verbose) {
+    BaseEncoder<std::time_t>::encodeSparse(input, offset, sparse);
+    return;
+  }
+  if (input == 0) {
+    // If no time is given (is 0), use the current time.
+    input = time(0);
+  }
+  appendLookup_(localTime_(input), input, offset, sparse);
+}
+
+
+void DateEncoder::encodeLookup_(const struct std::tm &timeinfo, std::time_t input, SDR &output) {
+  NTA_CHECK(output.size == size) << "DateEncoder: the output must have " << size << " bits.";
+  sparse_.clear();
+  appendLookup_(timeinfo, input, 0u, sparse_);
+  output.setSparse(sparse_); // swaps, sparse_ gets the previous buffer of the SDR
+}
+
+
+void DateEncoder::appendLookup_(const struct std::tm &timeinfo, std::time_t input, UInt offset,
+                                SDR_sparse_t &sparse) {
+  computeValues_(timeinfo, input);
+  for (const auto &lookup : lookups_) {
+    UInt start;
+    if (!lookup.encoder->getStartBit(values_[lookup.attribute], start))
+      continue;
+    const UInt activeBits = lookup.encoder->parameters.activeBits;
+    const auto row = lookup.bits.cbegin() + static_cast<size_t>(start) * activeBits;
+    for (auto bit = row; bit != row + activeBits; ++bit)
+      sparse.push_back(*bit + offset);
+  }
+}
+
+
+const struct std::tm &DateEncoder::localTime_(std::time_t input) {
+  if (input >= dayStart_ and input - dayStart_ < DAY_SECONDS) {
+    if (dayCached_) {
+      const std::time_t seconds = input - dayStart_;
+      lastTime_.tm_hour = static_cast<int>(seconds / 3600);
+      lastTime_.tm_min  = static_cast<int>(seconds / 60 % 60);
+      lastTime_.tm_sec  = static_cast<int>(seconds % 60);
+    } else {
+      lastTime_ = *std::localtime(&input);
+    }
+    return lastTime_;
+  }
+
+  // New day: it is cached if it has 24 hours of the same UTC offset.
+  lastTime_ = *std::localtime(&input);
+  dayStart_ = input - (lastTime_.tm_hour * 3600 + lastTime_.tm_min * 60 + lastTime_.tm_sec);
+  std::time_t dayEnd = dayStart_ + DAY_SECONDS - 1;
+  const struct std::tm first = *std::localtime(&dayStart_);
+  const struct std::tm last  = *std::localtime(&dayEnd);
+  dayCached_ = first.tm_hour == 0  and first.tm_min == 0  and first.tm_sec == 0  and
+               last.tm_hour  == 23 and last.tm_min  == 59 and last.tm_sec  == 59 and
+               first.tm_yday == lastTime_.tm_yday and last.tm_yday  == lastTime_.tm_yday and
+               first.tm_isdst == lastTime_.tm_isdst and last.tm_isdst == lastTime_.tm_isdst;
+  return lastTime_;
+}
+
+
+void DateEncoder::computeValues_(const struct std::tm &timeinfo, std::time_t input) {
   if (seasonEncoder_) {
     // Number the days into the year starting at 0 for Jan 1.
     Real64 dayOfYear = static_cast<Real64>(timeinfo.tm_yday);
-    season_output = SDR(seasonEncoder_->dimensions);
-    seasonEncoder_->encode(dayOfYear, season_output);
+    values_[SEASON] = dayOfYear;
     buckets_[bucketMap_[SEASON]] = std::floor(dayOfYear/seasonEncoder_->parameters.radius);
-    VERBOSE << "  season: " << dayOfYear << " ==> " << season_output;
-    sdrs.push_back(&season_output);
   }
   if (dayOfWeekEncoder_) {
     // shift tm_wday so monday is 0.
     Real64 dayOfWeek = static_cast<Real64>((timeinfo.tm_wday + 6) % 7);
-    dayOfWeek_output = SDR(dayOfWeekEncoder_->dimensions);
-    dayOfWeekEncoder_->encode(dayOfWeek, dayOfWeek_output);
+    values_[DAYOFWEEK] = dayOfWeek;
     buckets_[bucketMap_[DAYOFWEEK]] = dayOfWeek - std::fmod(dayOfWeek, dayOfWeekEncoder_->parameters.radius);
-    VERBOSE << "  dayOfWeek: " << dayOfWeek << " ==> " << dayOfWeek_output;
-    sdrs.push_back(&dayOfWeek_output);
   }
   if (weekendEncoder_) {
     // Weekend is defined as: friday(5) evenng(after 6pm), saturday(6), and sunday(0)
@@ -261,81 +433,72 @@ void DateEncoder::encode(struct std::tm timeinfo, SDR &output) {
     } else {
       val = 0.0;
     }
-    weekend_output = SDR(weekendEncoder_->dimensions);
-    weekendEncoder_->encode(val, weekend_output);
+    values_[WEEKEND] = val;
     buckets_[bucketMap_[WEEKEND]] = val;
-    VERBOSE << "  weekend: " << val << " ==> " << weekend_output;
-    sdrs.push_back(&weekend_output);
   }
-
   if (customDaysEncoder_) {
     Real64 customDay = 0.0;
     if (customDays_.find(timeinfo.tm_wday) != customDays_.end()) {
         customDay = 1.0;
     }
-    customDay_output = SDR(customDaysEncoder_->dimensions);
-    customDaysEncoder_->encode(customDay, customDay_output);
+    values_[CUSTOM] = customDay;
     buckets_[bucketMap_[CUSTOM]] = customDay;
-    VERBOSE << "  custom Day: " << customDay << " ==> " << customDay_output;
-    sdrs.push_back(&customDay_output);
   }
-
   if (holidayEncoder_) {
-    // A "continuous" binary value. = 1 on the holiday itself and smooth ramp
-    //  0->1 on the day before the holiday and 1->0 on the day after the holiday.
-    // holidays is a list of holidays that occur on a fixed date every year
-    Real64 val = 0.0;
-    double SECONDS_PER_DAY = 86400.0;
-    time_t input = std::mktime(&timeinfo);
-    for (auto h : args_.holiday_dates) {
-      std::time_t hdate;
-      if (h.size() == 3) {
-        hdate = mktime(h[0], h[1], h[2]);
-      } else {
-        hdate = mktime(timeinfo.tm_year + 1900, h[0], h[1]);
-      }
-      if (input > hdate) {
-        // start of holiday is in the past.
-        std::time_t diff = input - hdate;
-        if (diff < SECONDS_PER_DAY) {
-          // return 1 on the holiday itself
-          val = 1.0;
-          break;
-        } else if (diff < SECONDS_PER_DAY * 2.0) {
-          // Next day, ramp smoothly from 1 -> 0
-          val = 1.0 + ((diff - SECONDS_PER_DAY) / SECONDS_PER_DAY);
-          break;
-        }
-      } else {
-        // start of holiday is in the future.
-        std::time_t diff = hdate - input;
-        if (diff < SECONDS_PER_DAY) {
-          // holiday starts tomarrow
-          // ramp smoothly from 0 -> 1 on the previous day
-          val = 1.0 - diff / SECONDS_PER_DAY;
-          break;
-        }
-      }
-    }
-    holiday_output = SDR(holidayEncoder_->dimensions);
-    holidayEncoder_->encode(val, holiday_output);
+    Real64 val = holidayValue_(timeinfo, input);
+    values_[HOLIDAY] = val;
     buckets_[bucketMap_[HOLIDAY]] = std::floor(val);
-    VERBOSE << "  holiday: " << val << " ==> " << holiday_output;
-    sdrs.push_back(&holiday_output);
   }
   if (timeOfDayEncoder_) {
     Real64 timeOfDay = timeinfo.tm_hour + timeinfo.tm_min / 60.0f + timeinfo.tm_sec / (60.0 * 60.0);
-    timeOfDay_output = SDR(timeOfDayEncoder_->dimensions);
-    timeOfDayEncoder_->encode(timeOfDay, timeOfDay_output);
+    values_[TIMEOFDAY] = timeOfDay;
     buckets_[bucketMap_[TIMEOFDAY]] = timeOfDay - std::fmod(timeOfDay, timeOfDayEncoder_->parameters.radius);
-    VERBOSE << "  timeOfDay: " << timeOfDay << "hrs ==> " << timeOfDay_output;
-    sdrs.push_back(&timeOfDay_output);
   }
-  if (sdrs.size() > 1)
-    output.concatenate(sdrs);
-  else
-    output = *sdrs[0];
-  VERBOSE << "  Result: ==> " << output << std::endl;
+}
+
+
+Real64 DateEncoder::holidayValue_(const struct std::tm &timeinfo, std::time_t input) {
+  // A "continuous" binary value. = 1 on the holiday itself and smooth ramp
+  //  0->1 on the day before the holiday and 1->0 on the day after the holiday.
+  // holidays is a list of holidays that occur on a fixed date every year
+  if (timeinfo.tm_year != holidayYear_) {
+    holidayYear_ = timeinfo.tm_year;
+    holidayTimes_.clear();
+    for (const auto &h : args_.holiday_dates) {
+      if (h.size() == 3) {
+        holidayTimes_.push_back(mktime(h[0], h[1], h[2]));
+      } else {
+        holidayTimes_.push_back(mktime(timeinfo.tm_year + 1900, h[0], h[1]));
+      }
+    }
+  }
+  Real64 val = 0.0;
+  double SECONDS_PER_DAY = 86400.0;
+  for (const std::time_t hdate : holidayTimes_) {
+    if (input > hdate) {
+      // start of holiday is in the past.
+      std::time_t diff = input - hdate;
+      if (diff < SECONDS_PER_DAY) {
+        // return 1 on the holiday itself
+        val = 1.0;
+        break;
+      } else if (diff < SECONDS_PER_DAY * 2.0) {
+        // Next day, ramp smoothly from 1 -> 0
+        val = 1.0 + ((diff - SECONDS_PER_DAY) / SECONDS_PER_DAY);
+        break;
+      }
+    } else {
+      // start of holiday is in the future.
+      std::time_t diff = hdate - input;
+      if (diff < SECONDS_PER_DAY) {
+        // holiday starts tomarrow
+        // ramp smoothly from 0 -> 1 on the previous day
+        val = 1.0 - diff / SECONDS_PER_DAY;
+        break;
+      }
+    }
+  }
+  return val;
 }
 
 
@@ -147,6 +147,22 @@ public:
    */
   void setVerbose(bool verbose) { args_.verbose = verbose; }
 
+  /**
+   * Lookup tables.  When enabled, the encodings of all buckets of each
+   * attribute are computed once, and encode() copies the active bits of the
+   * buckets of an input straight into the output, instead of running the
+   * ScalarEncoders and concatenating their outputs.  The local time of an
+   * input in the same day as the previous one is derived from the cached
+   * start of that day, instead of calling localtime(), except on days when
+   * daylight saving time starts or ends.
+   *
+   * The output is unchanged, but must have the dimensions of the encoder.
+   * Verbose encodings do not use the tables.  This is a runtime setting, it
+   * is not serialized.
+   */
+  void setLookupTables(bool enable);
+  bool getLookupTables() const { return lookupTables_; }
+
   /**
    * Const Access to the buckets configured with this encoder.
    * For each attribute encoded, this is the quantized value used as title in Classifier.
@@ -167,6 +183,11 @@ public:
   void encode(std::chrono::system_clock::time_point, SDR &output);  // python datetime
   void encode(struct std::tm input, SDR &output);
 
+  /**
+   * With lookup tables, writes the table rows directly (@see setLookupTables).
+   */
+  void encodeSparse(std::time_t input, UInt offset, SDR_sparse_t &sparse) override;
+
   /**
    * Serialization Facility.
    */
@@ -232,6 +253,37 @@ private:
   // Titles from the last encoding
   size_t bucketMap_[6];
   std::vector<Real64> buckets_;
+  Real64 values_[6]; // input of each attribute, of the last encoding
+
+  // Holidays in the year holidayYear_, {year,mon,day} holidays are constant.
+  int holidayYear_ = -1;
+  std::vector<std::time_t> holidayTimes_;
+
+  // Lookup tables, @see setLookupTables().  The encoding of bucket b of an
+  // attribute is bits[b * activeBits ..+ activeBits), plus the offset of
+  // the attribute in the output.
+  struct Lookup {
+    size_t attribute;
+    std::shared_ptr<ScalarEncoder> encoder;
+    UInt offset;
+    SDR_sparse_t bits;
+  };
+  bool lookupTables_ = false;
+  std::vector<Lookup> lookups_;
+  SDR_sparse_t sparse_; //reused scratch
+
+  // Local time of the last input, valid for the whole day from dayStart_
+  // if dayCached_.
+  struct std::tm lastTime_;
+  std::time_t dayStart_ = 0;
+  bool dayCached_ = false;
+
+  void buildLookupTables_();
+  const struct std::tm &localTime_(std::time_t input);
+  void computeValues_(const struct std::tm &timeinfo, std::time_t input);
+  Real64 holidayValue_(const struct std::tm &timeinfo, std::time_t input);
+  void encodeLookup_(const struct std::tm &timeinfo, std::time_t input, SDR &output);
+  void appendLookup_(const struct std::tm &timeinfo, std::time_t input, UInt offset, SDR_sparse_t &sparse);
 
 }; // end class DateEncoder
 
@@ -0,0 +1,171 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2019, David McDougall
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the GridCellEncoder
+ */
+
+#include <algorithm> // nth_element, sort
+#include <cmath>     // cos, sin, hypot, isnan, nearbyint, sqrt
+#include <random>    // mt19937
+
+#include <htm/encoders/GridCellEncoder.hpp>
+#include <htm/utils/Random.hpp>
+
+using namespace std;
+
+namespace htm {
+
+namespace {
+  const Real64 PI = 3.141592653589793; // math.pi
+
+  // Uniform real in [0, 1) with 53 bits, as numpy.random.RandomState draws it.
+  Real64 uniform53(mt19937 &gen) {
+    const UInt32 a = static_cast<UInt32>(gen()) >> 5;
+    const UInt32 b = static_cast<UInt32>(gen()) >> 6;
+    return (a * 67108864.0 + b) / 9007199254740992.0;
+  }
+
+  // Rounds cube coordinates of a hexagonal grid to the nearest hexagon.
+  void cubeRound(Real64 &x, Real64 &y, Real64 &z) {
+    const Real64 rx = nearbyint(x), ry = nearbyint(y), rz = nearbyint(z);
+    const Real64 dx = fabs(rx - x), dy = fabs(ry - y), dz = fabs(rz - z);
+    x = rx; y = ry; z = rz;
+    if( dx > dy and dx > dz ) { x = -ry - rz; }
+    else if( dy > dz )        { y = -rx - rz; }
+    else                      { z = -rx - ry; }
+  }
+} // end anonymous namespace
+
+
+GridCellEncoder::GridCellEncoder(const GridCellEncoderParameters &parameters)
+  { initialize( parameters ); }
+
+void GridCellEncoder::initialize(const GridCellEncoderParameters &parameters)
+{
+  NTA_CHECK( parameters.size > 0u );
+  NTA_CHECK( not parameters.periods.empty() ) << "GridCellEncoder needs at least one module period.";
+  NTA_CHECK( parameters.sparsity >= 0.0f );
+  NTA_CHECK( parameters.sparsity <= 1.0f );
+  for( const auto period : parameters.periods ) {
+    NTA_CHECK( period >= 4.0 ) << "GridCellEncoder: module periods must be at least 4.";
+  }
+  BaseEncoder<vector<Real64>>::initialize({ parameters.size });
+
+  args_ = parameters;
+  sort( args_.periods.begin(), args_.periods.end() );
+  while( args_.seed == 0u ) {
+    args_.seed = Random().getUInt32();
+  }
+  const size_t numModules = args_.periods.size();
+
+  // Assign each module a range of cells in the output SDR.
+  partitions_.resize( numModules + 1u );
+  activeBits_.resize( numModules );
+  const Real64 step = (Real64) args_.size / numModules;
+  for( size_t m = 0u; m < numModules; m++ ) {
+    partitions_[m] = (UInt) nearbyint( m * step );
+  }
+  partitions_[numModules] = args_.size;
+  for( size_t m = 0u; m < numModules; m++ ) {
+    activeBits_[m] = (UInt) nearbyint( args_.sparsity * (partitions_[m + 1u] - partitions_[m]) );
+  }
+
+  // Assign each cell a random offset and each module a random orientation.
+  mt19937 gen( Random( args_.seed ).getUInt32() );
+  const Real64 maxOffset = args_.periods.back() * 9.0;
+  offsets_.resize( 2u * args_.size );
+  for( auto &offset : offsets_ ) {
+    offset = maxOffset * uniform53( gen );
+  }
+  cosines_.resize( numModules );
+  sines_.resize( numModules );
+  for( size_t m = 0u; m < numModules; m++ ) {
+    const Real64 angle = uniform53( gen ) * 2.0 * PI;
+    cosines_[m] = cos( angle );
+    sines_[m]   = sin( angle );
+  }
+}
+
+void GridCellEncoder::encode(const vector<Real64> location, SDR &output)
+{
+  NTA_CHECK( location.size() == 2u ) << "GridCellEncoder: the location must have 2 coordinates.";
+  NTA_CHECK( output.size == size );
+  if( isnan(location[0]) or isnan(location[1]) ) {
+    output.zero();
+    return;
+  }
+
+  const Real64 sqrt3 = sqrt( 3.0 );
+  distances_.resize( args_.size );
+  active_.clear();
+  for( size_t m = 0u; m + 1u < partitions_.size(); m++ ) {
+    const UInt   start  = partitions_[m];
+    const UInt   stop   = partitions_[m + 1u];
+    const Real64 c      = cosines_[m];
+    const Real64 s      = sines_[m];
+    const Real64 radius = args_.periods[m] / 2.0;
+
+    // Find the distance from the location to each cells nearest receptive
+    // field center.  Rotate the displacement into the grid of the module and
+    // round it to the center of the nearest hexagon.
+    for( UInt cell = start; cell < stop; cell++ ) {
+      const Real64 x  = location[0] - offsets_[2u * cell];
+      const Real64 y  = location[1] - offsets_[2u * cell + 1u];
+      const Real64 dx = c * x + -s * y;
+      const Real64 dy = s * x +  c * y;
+
+      Real64 q = ((dx * sqrt3 / 3.0) - (dy / 3.0)) / radius;
+      Real64 r = (dy * 2.0 / 3.0) / radius;
+      Real64 h = -q - r;
+      cubeRound( q, h, r );
+      const Real64 centerX = radius * (sqrt3 * q + sqrt3 / 2.0 * r);
+      const Real64 centerY = radius * (3.0 / 2.0 * r);
+      distances_[cell] = hypot( centerX - dx, centerY - dy );
+    }
+
+    // Activate the closest grid cells in each module.
+    order_.resize( stop - start );
+    for( UInt i = 0u; i < order_.size(); i++ ) {
+      order_[i] = start + i;
+    }
+    const auto closer = [&](const UInt a, const UInt b) {
+      return distances_[a] < distances_[b] or (distances_[a] == distances_[b] and a < b);
+    };
+    const auto last = order_.begin() + activeBits_[m];
+    nth_element( order_.begin(), last, order_.end(), closer );
+    sort( order_.begin(), last );
+    active_.insert( active_.end(), order_.begin(), last );
+  }
+  output.setSparse( active_ ); //swaps, active_ gets the previous buffer of the SDR
+}
+
+std::ostream & operator<<(std::ostream & out, const GridCellEncoder &self)
+{
+  out << "GridCellEncoder \n";
+  out << "  size:     " << self.parameters.size << ",\n";
+  out << "  sparsity: " << self.parameters.sparsity << ",\n";
+  out << "  periods: ";
+  for( const auto period : self.parameters.periods ) {
+    out << " " << period;
+  }
+  out << ",\n";
+  out << "  seed:     " << self.parameters.seed << std::endl;
+  return out;
+}
+
+} // end namespace htm
@@ -0,0 +1,146 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2019, David McDougall
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Define the GridCellEncoder
+ */
+
+#ifndef NTA_ENCODERS_GRID_CELL
+#define NTA_ENCODERS_GRID_CELL
+
+#include <vector>
+
+#include <htm/encoders/BaseEncoder.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/**
+ * Parameters for the GridCellEncoder
+ */
+struct GridCellEncoderParameters
+{
+  /**
+   * Member "size" is the total number of bits in the encoded output SDR.
+   */
+  UInt size = 0u;
+
+  /**
+   * Member "sparsity" is the fraction of bits in the encoded output which this
+   * encoder will activate, in every module.
+   */
+  Real sparsity = 0.0f;
+
+  /**
+   * Member "periods" is a list of distances.  The period of a module is the
+   * distance between the centers of a grid cells receptive fields.  The
+   * length of this list defines the number of distinct modules.  Periods
+   * must be at least 4.
+   */
+  std::vector<Real64> periods;
+
+  /**
+   * Member "seed" controls the pseudo-random-number-generator which this
+   * encoder uses.  This encoder produces deterministic output.
+   *
+   * The seed 0 is special.  Seed 0 is replaced with a random number.
+   */
+  UInt seed = 0u;
+};
+
+/**
+ * Encodes a 2-D coordinate as plausible grid cell activity.
+ *
+ * Description:
+ * The output SDR is divided into modules.  Each module is a distinct group of
+ * cells with a common grid spacing and orientation.  Different modules have
+ * different spacings & orientations.  Every cell has a random offset, in each
+ * module the cells whose nearest receptive field center is closest to the
+ * location are active.
+ *
+ * The output is identical to the python htm.encoders.grid_cell_encoder with
+ * the same parameters & seed.
+ *
+ * To inspect this run:
+ * $ python -m htm.encoders.grid_cell_encoder --help
+ */
+class GridCellEncoder : public BaseEncoder<std::vector<Real64>>
+{
+public:
+  GridCellEncoder() {}
+  GridCellEncoder( const GridCellEncoderParameters &parameters );
+  void initialize( const GridCellEncoderParameters &parameters );
+
+  const GridCellEncoderParameters &parameters = args_;
+
+  /**
+   * Encode a location.
+   * @param location pair of coordinates [X, Y].  Locations with a NaN
+   * coordinate encode to no active bits.
+   * @param output SDR with the dimensions of the encoder.
+   */
+  void encode(const std::vector<Real64> location, SDR &output) override;
+
+  ~GridCellEncoder() override {}
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    std::string name = "GridCellEncoder";
+    ar(cereal::make_nvp("name", name));
+    ar(cereal::make_nvp("size", args_.size));
+    ar(cereal::make_nvp("sparsity", args_.sparsity));
+    ar(cereal::make_nvp("periods", args_.periods));
+    ar(cereal::make_nvp("seed", args_.seed));
+  }
+
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    std::string name;
+    GridCellEncoderParameters args;
+    ar(cereal::make_nvp("name", name));
+    NTA_CHECK(name == "GridCellEncoder");
+    ar(cereal::make_nvp("size", args.size));
+    ar(cereal::make_nvp("sparsity", args.sparsity));
+    ar(cereal::make_nvp("periods", args.periods));
+    ar(cereal::make_nvp("seed", args.seed));
+    initialize( args );
+  }
+
+private:
+  GridCellEncoderParameters args_;
+
+  // Module m has the cells [partitions_[m], partitions_[m+1]), of which
+  // activeBits_[m] are active.
+  std::vector<UInt>   partitions_;
+  std::vector<UInt>   activeBits_;
+  std::vector<Real64> cosines_;
+  std::vector<Real64> sines_;
+  std::vector<Real64> offsets_;    // X & Y of every cell
+
+  std::vector<Real64> distances_;  //reused scratch
+  std::vector<UInt>   order_;      //reused scratch
+  SDR_sparse_t        active_;     //reused scratch
+};
+
+std::ostream & operator<<(std::ostream & out, const GridCellEncoder & self);
+
+} // end namespace htm
+#endif // NTA_ENCODERS_GRID_CELL
@@ -0,0 +1,74 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the MultiEncoder class
+ */
+
+#include <htm/encoders/MultiEncoder.hpp>
+
+using std::vector;
+
+namespace htm {
+
+size_t MultiEncoder::addField_(Field &&field) {
+  NTA_CHECK(field.size > 0u) << "MultiEncoder: the encoder of the field is not initialized.";
+  size_ += field.size;
+  dimensions_ = { size_ };
+  fields_.push_back(std::move(field));
+  return fields_.size() - 1u;
+}
+
+
+void MultiEncoder::encode(const vector<Real64> &record, SDR &output) {
+  NTA_CHECK(record.size() == fields_.size())
+    << "MultiEncoder: the record has " << record.size() << " values, expected " << fields_.size();
+  NTA_CHECK(output.size == size_)
+    << "MultiEncoder: the output has " << output.size << " bits, expected " << size_;
+
+  sparse_.clear();
+  if( threadPool_ == nullptr ) {
+    for(size_t i = 0; i < fields_.size(); i++) {
+      fields_[i].encode(record[i], fields_[i].offset, sparse_);
+    }
+  }
+  else {
+    fieldBits_.resize(fields_.size());
+    threadPool_->parallelFor(fields_.size(), [&](size_t begin, size_t end, size_t) {
+      for(size_t i = begin; i < end; i++) {
+        fieldBits_[i].clear();
+        fields_[i].encode(record[i], fields_[i].offset, fieldBits_[i]);
+      }
+    });
+    for(const auto &bits : fieldBits_) {
+      sparse_.insert(sparse_.end(), bits.cbegin(), bits.cend());
+    }
+  }
+  output.setSparse(sparse_); //swaps, sparse_ gets the previous buffer of the SDR
+}
+
+
+void MultiEncoder::setNumThreads(const UInt numThreads) {
+  numThreads_ = numThreads == 0u ? static_cast<UInt>(ThreadPool::hardwareConcurrency()) : numThreads;
+  if( numThreads_ > 1u ) {
+    threadPool_ = std::make_shared<ThreadPool>(numThreads_ - 1u); //the calling thread works too
+  } else {
+    threadPool_.reset();
+  }
+}
+
+} // end namespace htm
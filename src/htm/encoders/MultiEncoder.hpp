@@ -0,0 +1,144 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the MultiEncoder class
+ */
+
+#ifndef NTA_ENCODERS_MULTI
+#define NTA_ENCODERS_MULTI
+
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <htm/encoders/BaseEncoder.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/ThreadPool.hpp>
+
+namespace htm {
+
+/**
+ * MultiEncoder - encodes a record of several numeric fields into one SDR.
+ *
+ * @b Description
+ * Each field has its own encoder, the encoding of the record is the
+ * concatenation of the encodings of its fields, in the order the fields
+ * were added.  Every field writes its active bits at its offset straight
+ * into the output (@see BaseEncoder::encodeSparse), there are no per field
+ * SDRs and no SDR::concatenate.
+ *
+ * The values of a record are Real64, converted to the input type of the
+ * encoder of their field, ex: a DateEncoder field takes the unix time.
+ *
+ * Example Usage:
+ *    MultiEncoder record;
+ *    record.addField( std::make_shared<ScalarEncoder>( scalarParams ) );
+ *    record.addField( std::make_shared<RandomDistributedScalarEncoder>( rdseParams ) );
+ *    record.addField( std::make_shared<DateEncoder>( dateParams ) );
+ *    SDR output( record.dimensions );
+ *    record.encode( { 3.7, 120.0, 1577836800.0 }, output );
+ *
+ * The encoders are not copied, they must not be used elsewhere while the
+ * record is encoded, and with several threads, every field needs its own
+ * encoder.  MultiEncoder is not serializable, save the field encoders.
+ */
+class MultiEncoder
+{
+public:
+  MultiEncoder() {}
+
+  /**
+   * Shape of the output SDR, the total number of bits of all fields.
+   */
+  const std::vector<UInt> &dimensions = dimensions_;
+  const UInt              &size       = size_;
+
+  /**
+   * Append a field to the record.
+   * @param encoder of the field, a BaseEncoder with a numeric input type.
+   * @returns The index of the field in the record.
+   */
+  template<typename Encoder>
+  size_t addField(const std::shared_ptr<Encoder> &encoder) {
+    NTA_CHECK(encoder != nullptr);
+    return addEncoder_(encoder, encoder.get());
+  }
+
+  size_t numFields() const noexcept { return fields_.size(); }
+
+  /** The first bit of field @param i in the output. */
+  UInt getFieldOffset(const size_t i) const { return fields_.at(i).offset; }
+
+  /** The number of bits of field @param i. */
+  UInt getFieldSize(const size_t i) const { return fields_.at(i).size; }
+
+  /**
+   * Encode a record.
+   * @param record has one value per field.
+   * @param output SDR with the dimensions of the MultiEncoder.
+   */
+  void encode(const std::vector<Real64> &record, SDR &output);
+
+  /**
+   * Set the number of threads used to encode the fields of a record
+   * concurrently, including the calling thread.  Default 1, use 0 for all
+   * hardware threads.  Results are identical to the single threaded
+   * computation.  Threads pay off for wide records or expensive encoders.
+   *
+   * This is a runtime setting.
+   */
+  void setNumThreads(UInt numThreads);
+  UInt getNumThreads() const { return numThreads_; }
+
+private:
+  struct Field {
+    std::function<void(Real64 value, UInt offset, SDR_sparse_t &sparse)> encode;
+    UInt offset;
+    UInt size;
+  };
+
+  template<typename DataType>
+  size_t addEncoder_(const std::shared_ptr<void> &owner, BaseEncoder<DataType> *encoder) {
+    static_assert(std::is_arithmetic<DataType>::value,
+                  "MultiEncoder: the fields must have numeric inputs.");
+    Field field;
+    field.offset = size_;
+    field.size   = encoder->size;
+    field.encode = [owner, encoder](Real64 value, UInt offset, SDR_sparse_t &sparse) {
+      encoder->encodeSparse(static_cast<DataType>(value), offset, sparse);
+    };
+    return addField_(std::move(field));
+  }
+
+  size_t addField_(Field &&field);
+
+  std::vector<Field> fields_;
+  std::vector<UInt>  dimensions_ {0u};
+  UInt               size_ = 0u;
+
+  UInt numThreads_ = 1u;
+  std::shared_ptr<ThreadPool> threadPool_;
+
+  SDR_sparse_t              sparse_;    //reused scratch
+  std::vector<SDR_sparse_t> fieldBits_; //reused scratch, per field with threads
+};
+
+} // end namespace htm
+#endif // NTA_ENCODERS_MULTI
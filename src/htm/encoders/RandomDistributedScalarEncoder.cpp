@@ -22,11 +22,36 @@
 #include <htm/encoders/RandomDistributedScalarEncoder.hpp>
 #include <murmurhash3/MurmurHash3.hpp>
 #include <htm/utils/Random.hpp>
-#include <algorithm> // fill
+#include <algorithm> // copy, fill, sort, unique
 
 using namespace std;
 using namespace htm;
 
+namespace {
+  inline UInt32 rotl32(const UInt32 x, const int r)
+    { return (x << r) | (x >> (32 - r)); }
+
+  // MurmurHash3_x86_32 of a single 32 bit key, equal to
+  // MurmurHash3_x86_32(&key, sizeof(key), seed).
+  // Inlined & without the loop over the blocks, a loop calling it vectorizes.
+  inline UInt32 murmur3Key32(const UInt32 key, const UInt32 seed)
+  {
+    UInt32 k1 = key * 0xcc9e2d51u;
+    k1  = rotl32(k1, 15);
+    k1 *= 0x1b873593u;
+    UInt32 h1 = seed ^ k1;
+    h1  = rotl32(h1, 13);
+    h1  = h1 * 5u + 0xe6546b64u;
+    h1 ^= 4u; //length
+    h1 ^= h1 >> 16;
+    h1 *= 0x85ebca6bu;
+    h1 ^= h1 >> 13;
+    h1 *= 0xc2b2ae35u;
+    h1 ^= h1 >> 16;
+    return h1;
+  }
+}
+
 RandomDistributedScalarEncoder::RandomDistributedScalarEncoder(
                                               const RDSE_Parameters &parameters)
   { initialize( parameters ); }
@@ -86,6 +111,35 @@ void RandomDistributedScalarEncoder::initialize( const RDSE_Parameters &paramete
   while( args_.seed == 0u ) {
     args_.seed = Random().getUInt32();
   }
+  clearCache_();
+}
+
+void RandomDistributedScalarEncoder::setCacheSize(const UInt maxBuckets)
+{
+  cacheSize_ = maxBuckets;
+  clearCache_();
+}
+
+void RandomDistributedScalarEncoder::clearCache_()
+{
+  cacheSlots_.clear();
+  cacheBuckets_.clear();
+  cacheNumBits_.clear();
+  cacheReferenced_.clear();
+  cacheBits_.clear();
+  cacheHand_ = 0u;
+}
+
+void RandomDistributedScalarEncoder::hashBucket_(const UInt index, SDR_sparse_t &bits) const
+{
+  bits.resize( args_.activeBits );
+  for(auto offset = 0u; offset < args_.activeBits; ++offset)
+  {
+    UInt hash_buffer = index + offset;
+    bits[offset] = MurmurHash3_x86_32(&hash_buffer, sizeof(hash_buffer), args_.seed) % size;
+  }
+  sort( bits.begin(), bits.end() );
+  bits.erase( unique( bits.begin(), bits.end() ), bits.end() );
 }
 
 void RandomDistributedScalarEncoder::encode(Real64 input, SDR &output)
@@ -101,10 +155,17 @@ void RandomDistributedScalarEncoder::encode(Real64 input, SDR &output)
       << "Input to category encoder must be an unsigned integer!";
   }
 
+  const UInt index = (UInt) (input / args_.resolution);
+
+  if( cacheSize_ > 0u ) {
+    const UInt slot = cacheSlot_( index );
+    output.setSparse( cacheBits_.data() + (size_t) slot * args_.activeBits, cacheNumBits_[slot] );
+    return;
+  }
+
   auto &data = output.getDense();
   fill( data.begin(), data.end(), 0u );
 
-  const UInt index = (UInt) (input / args_.resolution);
   for(auto offset = 0u; offset < args_.activeBits; ++offset)
   {
     UInt hash_buffer = index + offset;
@@ -126,6 +187,111 @@ void RandomDistributedScalarEncoder::encode(Real64 input, SDR &output)
   output.setDense( data );
 }
 
+UInt RandomDistributedScalarEncoder::cacheSlot_(const UInt index)
+{
+  const auto found = cacheSlots_.find( index );
+  UInt slot;
+  if( found != cacheSlots_.end() ) {
+    cacheHits_++;
+    slot = found->second;
+  }
+  else {
+    cacheMisses_++;
+    if( cacheBuckets_.size() < cacheSize_ ) {
+      slot = (UInt) cacheBuckets_.size();
+      cacheBuckets_.push_back( index );
+      cacheNumBits_.push_back( 0u );
+      cacheReferenced_.push_back( false );
+      cacheBits_.resize( cacheBits_.size() + args_.activeBits );
+    }
+    else {
+      // Evict the first bucket not referenced since the hand last passed it.
+      while( cacheReferenced_[cacheHand_] ) {
+        cacheReferenced_[cacheHand_] = false;
+        cacheHand_ = (cacheHand_ + 1u) % cacheSize_;
+      }
+      slot = cacheHand_;
+      cacheHand_ = (cacheHand_ + 1u) % cacheSize_;
+      cacheSlots_.erase( cacheBuckets_[slot] );
+      cacheBuckets_[slot] = index;
+    }
+    cacheSlots_[index] = slot;
+    hashBucket_( index, scratch_ );
+    copy( scratch_.begin(), scratch_.end(), cacheBits_.begin() + (size_t) slot * args_.activeBits );
+    cacheNumBits_[slot] = (UInt) scratch_.size();
+  }
+  cacheReferenced_[slot] = true;
+  return slot;
+}
+
+void RandomDistributedScalarEncoder::encodeSparse(Real64 input, const UInt offset, SDR_sparse_t &sparse)
+{
+  if( isnan(input) ) {
+    return;
+  }
+  else if( args_.category ) {
+    NTA_CHECK( input == Real64(UInt64(input)))
+      << "Input to category encoder must be an unsigned integer!";
+  }
+
+  const UInt index = (UInt) (input / args_.resolution);
+  const UInt32 *bits;
+  size_t numBits;
+  if( cacheSize_ > 0u ) {
+    const UInt slot = cacheSlot_( index );
+    bits    = cacheBits_.data() + (size_t) slot * args_.activeBits;
+    numBits = cacheNumBits_[slot];
+  }
+  else {
+    hashBucket_( index, scratch_ );
+    bits    = scratch_.data();
+    numBits = scratch_.size();
+  }
+  for( size_t i = 0u; i < numBits; ++i ) {
+    sparse.push_back( bits[i] + offset );
+  }
+}
+
+void RandomDistributedScalarEncoder::encodeBatch(const Real64 *values, const size_t n, vector<SDR> &outputs)
+{
+  if( cacheSize_ > 0u ) {
+    BaseEncoder<Real64>::encodeBatch( values, n, outputs );
+    return;
+  }
+  prepareBatch_( n, outputs );
+
+  // Check the inputs & compute all buckets.
+  batchIndices_.resize( n );
+  const Real64 resolution = args_.resolution;
+  for( size_t i = 0u; i < n; i++ ) {
+    if( args_.category and not isnan(values[i]) ) {
+      NTA_CHECK( values[i] == Real64(UInt64(values[i])))
+        << "Input to category encoder must be an unsigned integer!";
+    }
+    batchIndices_[i] = isnan(values[i]) ? 0u : (UInt) (values[i] / resolution);
+  }
+
+  const UInt32 seed = args_.seed;
+  for( size_t i = 0u; i < n; i++ ) {
+    if( isnan(values[i]) ) {
+      outputs[i].zero();
+      continue;
+    }
+    scratch_.resize( args_.activeBits );
+    UInt32 *bits = scratch_.data();
+    const UInt index = batchIndices_[i];
+    for( UInt offset = 0u; offset < args_.activeBits; ++offset ) {
+      bits[offset] = murmur3Key32( index + offset, seed );
+    }
+    for( UInt offset = 0u; offset < args_.activeBits; ++offset ) {
+      bits[offset] %= size;
+    }
+    sort( scratch_.begin(), scratch_.end() );
+    scratch_.erase( unique( scratch_.begin(), scratch_.end() ), scratch_.end() );
+    outputs[i].setSparse( scratch_ ); //swaps, scratch_ gets the previous buffer of the SDR
+  }
+}
+
 std::ostream & htm::operator<<(std::ostream & out, const RandomDistributedScalarEncoder &self)
 {
   out << "RDSE ";
@@ -22,6 +22,9 @@
 #ifndef NTA_ENCODERS_RDSE
 #define NTA_ENCODERS_RDSE
 
+#include <unordered_map>
+#include <vector>
+
 #include <htm/encoders/BaseEncoder.hpp>
 #include <htm/utils/Log.hpp>
 
@@ -120,6 +123,34 @@ public:
 
   void encode(Real64 input, SDR &output) override;
 
+  /**
+   * Same results as encode() for each value.  The buckets of all values are
+   * computed in one loop, and the hashes of the active bits with a MurmurHash3
+   * kernel specialized for 32 bit keys, which the compiler vectorizes.
+   * With the bucket cache enabled, this calls encode() for each value.
+   */
+  void encodeBatch(const Real64 *values, size_t n, std::vector<SDR> &outputs) override;
+
+  void encodeSparse(Real64 input, UInt offset, SDR_sparse_t &sparse) override;
+
+  /**
+   * Bucket cache.  Encoding an input hashes activeBits offsets of its bucket.
+   * Inputs which revisit a limited set of buckets can instead copy the active
+   * bits from a cache of the most recently used buckets.  The cache holds at
+   * most @param maxBuckets buckets, and evicts with the CLOCK policy (an
+   * approximation of least recently used).  The encoded output does not
+   * change.
+   *
+   * The value 0 (the default) disables the cache.  This is a runtime setting,
+   * the cache is not serialized.
+   */
+  void setCacheSize(UInt maxBuckets);
+  UInt getCacheSize() const { return cacheSize_; }
+
+  /** Number of encodings served from / not found in the bucket cache. */
+  UInt64 getCacheHits()   const { return cacheHits_; }
+  UInt64 getCacheMisses() const { return cacheMisses_; }
+
 
   ~RandomDistributedScalarEncoder() override {};
 
@@ -153,9 +184,31 @@ public:
     ar(cereal::make_nvp("category", args_.category));
     ar(cereal::make_nvp("seed", args_.seed));
     BaseEncoder<Real64>::initialize({ parameters.size });
+    clearCache_();
   }
 private:
   RDSE_Parameters args_;
+
+  // Sorted active bits of a bucket, without the duplicates of hash collisions.
+  void hashBucket_(UInt index, SDR_sparse_t &bits) const;
+
+  // Bucket cache, slot i holds the bucket cacheBuckets_[i] and its active
+  // bits cacheBits_[i * activeBits ..+ cacheNumBits_[i]].
+  UInt cacheSize_ = 0u;
+  std::unordered_map<UInt, UInt> cacheSlots_; // bucket -> slot
+  std::vector<UInt> cacheBuckets_;
+  std::vector<UInt> cacheNumBits_;
+  std::vector<bool> cacheReferenced_;         // CLOCK reference bits
+  SDR_sparse_t      cacheBits_;
+  UInt   cacheHand_   = 0u;
+  UInt64 cacheHits_   = 0u;
+  UInt64 cacheMisses_ = 0u;
+  SDR_sparse_t scratch_; //reused scratch
+  std::vector<UInt> batchIndices_; //reused scratch
+
+  void clearCache_();
+  // Slot of a bucket in the cache, hashes & inserts the bucket if missing.
+  UInt cacheSlot_(UInt index);
 };
 
 typedef RandomDistributedScalarEncoder RDSE;
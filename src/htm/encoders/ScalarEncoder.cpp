@@ -135,13 +135,10 @@ void ScalarEncoder::initialize(const ScalarEncoderParameters &parameters)
   BaseEncoder<Real64>::initialize({ args_.size });
 }
 
-void ScalarEncoder::encode(Real64 input, SDR &output)
+bool ScalarEncoder::prepareInput_(Real64 &input) const
 {
-  // Check inputs
-  NTA_CHECK( output.size == size );
   if( std::isnan(input) ) {
-    output.zero();
-    return;
+    return false;
   }
   else if( args_.clipInput ) {
     if( args_.periodic ) {
@@ -161,31 +158,110 @@ void ScalarEncoder::encode(Real64 input, SDR &output)
     NTA_CHECK(input >= parameters.minimum && input <= parameters.maximum)
         << "Input must be within range [minimum, maximum]! " << input << " vs [" << parameters.minimum << " , " << parameters.maximum << " ]";
   }
+  return true;
+}
 
-  UInt start = (UInt) round((input - parameters.minimum) / parameters.resolution);
+namespace {
+  // Writes the active bits starting at @param start into @param output.
+  void setActiveBits(UInt start, const ScalarEncoderParameters &parameters, SDR &output)
+  {
+    auto &sparse = output.getSparse();
+    sparse.resize( parameters.activeBits );
+    std::iota( sparse.begin(), sparse.end(), start );
+
+    if( parameters.periodic ) {
+      for( auto & bit : sparse ) {
+        if( bit >= output.size ) {
+          bit -= output.size;
+        }
+      }
+      std::sort( sparse.begin(),  sparse.end() );
+    }
+
+    output.setSparse( sparse );
+  }
+}
+
+bool ScalarEncoder::getStartBit(Real64 input, UInt &start) const
+{
+  if( not prepareInput_( input ) ) {
+    return false;
+  }
+
+  start = (UInt) round((input - parameters.minimum) / parameters.resolution);
 
   // The endpoints of the input range are inclusive, which means that the
   // maximum value may round up to an index which is outside of the SDR. Correct
   // this by pushing the endpoint (and everything which rounds to it) onto the
   // last bit in the SDR.
   if( not parameters.periodic ) {
-    start = std::min(start, output.size - parameters.activeBits);
+    start = std::min(start, size - parameters.activeBits);
   }
+  return true;
+}
 
-  auto &sparse = output.getSparse();
-  sparse.resize( parameters.activeBits );
-  std::iota( sparse.begin(), sparse.end(), start );
+void ScalarEncoder::encode(Real64 input, SDR &output)
+{
+  // Check inputs
+  NTA_CHECK( output.size == size );
+  UInt start;
+  if( not getStartBit( input, start ) ) {
+    output.zero();
+    return;
+  }
+  setActiveBits( start, parameters, output );
+}
 
-  if( parameters.periodic ) {
-    for( auto & bit : sparse ) {
-      if( bit >= output.size ) {
-        bit -= output.size;
-      }
+void ScalarEncoder::encodeSparse(Real64 input, const UInt offset, SDR_sparse_t &sparse)
+{
+  UInt start;
+  if( not getStartBit( input, start ) ) {
+    return;
+  }
+  // A periodic encoding which wraps around begins with its wrapped bits.
+  const UInt end = start + parameters.activeBits;
+  if( end > size ) {
+    for( UInt bit = 0u; bit < end - size; ++bit ) {
+      sparse.push_back( bit + offset );
+    }
+  }
+  for( UInt bit = start; bit < std::min(end, size); ++bit ) {
+    sparse.push_back( bit + offset );
+  }
+}
+
+void ScalarEncoder::encodeBatch(const Real64 *values, const size_t n, std::vector<SDR> &outputs)
+{
+  prepareBatch_( n, outputs );
+
+  // Check & clip the inputs, NaN is replaced & its output is cleared below.
+  batchInputs_.assign( values, values + n );
+  batchMissing_.clear();
+  for( size_t i = 0u; i < n; i++ ) {
+    if( not prepareInput_( batchInputs_[i] ) ) {
+      batchInputs_[i] = parameters.minimum;
+      batchMissing_.push_back( i );
     }
-    std::sort( sparse.begin(),  sparse.end() );
   }
 
-  output.setSparse( sparse );
+  // Bucket of every input, this loop has no branches or calls but round.
+  batchStarts_.resize( n );
+  const Real64 minimum    = parameters.minimum;
+  const Real64 resolution = parameters.resolution;
+  const UInt   lastStart  = parameters.periodic ? size : size - parameters.activeBits;
+  const Real64 *input = batchInputs_.data();
+  UInt *start = batchStarts_.data();
+  for( size_t i = 0u; i < n; i++ ) {
+    const UInt s = (UInt) round((input[i] - minimum) / resolution);
+    start[i] = std::min(s, lastStart);
+  }
+
+  for( size_t i = 0u; i < n; i++ ) {
+    setActiveBits( start[i], parameters, outputs[i] );
+  }
+  for( const auto i : batchMissing_ ) {
+    outputs[i].zero();
+  }
 }
 
 std::ostream & operator<<(std::ostream & out, const ScalarEncoder &self)
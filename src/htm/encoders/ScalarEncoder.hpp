@@ -130,6 +130,21 @@ namespace htm {
 
     void encode(Real64 input, SDR &output) override;
 
+    /**
+     * Same results as encode() for each value.  The inputs are checked first,
+     * then the bucket of every value is computed in one loop.
+     */
+    void encodeBatch(const Real64 *values, size_t n, std::vector<SDR> &outputs) override;
+
+    /**
+     * The encoding of @param input is the activeBits consecutive bits from
+     * @param start, wrapping around the end of the SDR if periodic.
+     * @returns false if the input is NaN, which encodes to no active bits.
+     */
+    bool getStartBit(Real64 input, UInt &start) const;
+
+    void encodeSparse(Real64 input, UInt offset, SDR_sparse_t &sparse) override;
+
 
     CerealAdapter;  // see Serializable.hpp
     // FOR Cereal Serialization
@@ -170,6 +185,13 @@ namespace htm {
 
   private:
     ScalarEncoderParameters args_;
+
+    // Checks & clips an input, @returns false for NaN.
+    bool prepareInput_(Real64 &input) const;
+
+    std::vector<Real64> batchInputs_;  //reused scratch
+    std::vector<UInt>   batchStarts_;  //reused scratch
+    std::vector<size_t> batchMissing_; //reused scratch
   };   // end class ScalarEncoder
 
   std::ostream & operator<<(std::ostream & out, const ScalarEncoder &self);
@@ -22,7 +22,6 @@
  */
 
 #include <algorithm>  // transform
-#include <bitset>     // to_string
 #include <cctype>     // tolower
 #include <climits>    // CHAR_BIT
 #include <regex>
@@ -36,6 +35,40 @@
 
 namespace htm {
 
+  namespace {
+    const UInt64 GOLDEN_GAMMA = 0x9E3779B97F4A7C15ull;
+
+    // SplitMix64 finalizer, a bijective avalanche of all 64 bits.
+    inline UInt64 mix64(UInt64 x)
+    {
+      x = (x ^ (x >> 30u)) * 0xBF58476D1CE4E5B9ull;
+      x = (x ^ (x >> 27u)) * 0x94D049BB133111EBull;
+      return x ^ (x >> 31u);
+    }
+
+    // Fast non-cryptographic 64 bit hash of a string. Reads 8 bytes per
+    // round (little endian, independent of the platform).
+    UInt64 hashString64(const std::string &str)
+    {
+      const auto data = reinterpret_cast<const unsigned char *>(str.data());
+      const size_t length = str.size();
+      UInt64 hash = mix64(length * GOLDEN_GAMMA);
+      size_t i = 0u;
+      for (; i + 8u <= length; i += 8u) {
+        UInt64 block = 0u;
+        for (size_t b = 0u; b < 8u; b++) {
+          block |= (UInt64) data[i + b] << (8u * b);
+        }
+        hash = mix64(hash ^ block) + GOLDEN_GAMMA;
+      }
+      UInt64 tail = 0u;
+      for (size_t b = 0u; i + b < length; b++) {
+        tail |= (UInt64) data[i + b] << (8u * b);
+      }
+      return mix64(hash ^ tail ^ (length << 56u));
+    }
+  } // end anonymous namespace
+
   /**
    * Constructor
    * @see SimHashDocumentEncoder.hpp
@@ -107,8 +140,25 @@ namespace htm {
 
     // Initialize parent class with finalized params
     BaseEncoder<std::vector<std::string>>::initialize({ args_.size });
+    clearCache_();
+    clearTokens();
   } // end method initialize
 
+  /**
+   * SetCacheSize
+   * @see SimHashDocumentEncoder.hpp
+   */
+  void SimHashDocumentEncoder::setCacheSize(const UInt maxTokens)
+  {
+    cacheSize_ = maxTokens;
+    clearCache_();
+  } // end method setCacheSize
+
+  void SimHashDocumentEncoder::clearCache_()
+  {
+    cache_.clear();
+  } // end method clearCache_
+
   /**
    * Encode (Main calling style)
    * @see SimHashDocumentEncoder.hpp
@@ -116,13 +166,11 @@ namespace htm {
    */
   void SimHashDocumentEncoder::encode(const std::vector<std::string> input, SDR &output)
   {
-    Eigen::MatrixXi adders(args_.size, 0u);
-    Eigen::VectorXi hashBits(args_.size);
+    Eigen::VectorXi adders = Eigen::VectorXi::Zero(args_.size);
     std::map<std::string, UInt> histogramToken = {};
     SDR result({ args_.size });
     std::vector<UInt> simBits(args_.size, 0u);
 
-    hashBits = Eigen::VectorXi::Zero(args_.size);
     result.zero();
 
     if (!input.size()) {
@@ -131,70 +179,16 @@ namespace htm {
     }
 
     for (const auto& member : input) {
-      std::string token = member;
-      UInt tokenWeight = 1;  // default weight for non-vocab and vocab-orphan
-      std::map<std::string, UInt> histogramChar = {};
-
-      // caseSensitivity
-      if (!args_.caseSensitivity) {
-        transform(token.begin(), token.end(), token.begin(), ::tolower);
-      }
-
-      // excludes
-      if (!args_.excludes.empty()) {
-        if(std::find(args_.excludes.begin(), args_.excludes.end(), token) != args_.excludes.end()) {
-          continue; // skip this excluded token
-        }
-      }
-
-      // vocabulary + encodeOrphans
-      if (args_.vocabulary.size()) {
-        if (args_.vocabulary.count(token)) {
-          tokenWeight = args_.vocabulary.at(token);  // use weight from vocab map
-        }
-        else if (!args_.encodeOrphans) {
-          continue;  // discard this non-vocab token
-        }
+      std::string token;
+      UInt tokenWeight;
+      if (!filterToken_(member, token, tokenWeight)) {
+        continue;
       }
-
       // token frequency floor and ceiling
-      histogramToken[token]++;
-      if (args_.frequencyFloor > 0 &&
-          histogramToken.at(token) <= args_.frequencyFloor) {
-        continue;  // discard under char
-      }
-      if (args_.frequencyCeiling > 0 &&
-          histogramToken.at(token) >= args_.frequencyCeiling) {
-        continue;  // discard over char
+      if (!countsOccurrence_(++histogramToken[token])) {
+        continue;
       }
-
-      // tokenSimilarity
-      if (args_.tokenSimilarity) {
-        // generate hash digest for every single character individually
-        for (const auto& letter : token) {
-          const std::string letterStr = std::string(1u, letter);
-          UInt charWeight = args_.vocabulary.count(letterStr) ?
-                            args_.vocabulary.at(letterStr) : tokenWeight;
-
-          // char frequency ceiling (only)
-          histogramChar[letterStr]++;
-          if (args_.frequencyCeiling > 0 &&
-              histogramChar.at(letterStr) >= args_.frequencyCeiling) {
-            continue;  // discard over char
-          }
-
-          // hash character
-          hashToken_(letterStr, hashBits);
-          bitsToWeightedAdder_(charWeight, hashBits);
-          addVectorToMatrix_(hashBits, adders);
-        }
-        tokenWeight = (UInt) (tokenWeight * 1.5); // try to balance token with letters
-      }
-
-      // generate hash digest for whole token string
-      hashToken_(token, hashBits);
-      bitsToWeightedAdder_(tokenWeight, hashBits);
-      addVectorToMatrix_(hashBits, adders);
+      addTokenToAdders_(token, tokenWeight, 1, adders);
     }
 
     // simhash
@@ -222,82 +216,253 @@ namespace htm {
   } // end method encode (string alternate)
 
   /**
-   * AddVectorToMatrix_
+   * AddToken
+   * @see SimHashDocumentEncoder.hpp
+   */
+  void SimHashDocumentEncoder::addToken(const std::string &token)
+  {
+    std::string key;
+    UInt weight;
+    streamSize_++;
+    if (!filterToken_(token, key, weight)) {
+      return;
+    }
+    if (countsOccurrence_(++streamCounts_[key])) {
+      addTokenToAdders_(key, weight, 1, streamAdders_);
+    }
+  } // end method addToken
+
+  /**
+   * RemoveToken
+   * @see SimHashDocumentEncoder.hpp
+   */
+  void SimHashDocumentEncoder::removeToken(const std::string &token)
+  {
+    NTA_CHECK(streamSize_ > 0u)
+      << "removeToken: the stream has no tokens.";
+    std::string key;
+    UInt weight;
+    if (!filterToken_(token, key, weight)) {
+      streamSize_--;
+      return;
+    }
+    const auto found = streamCounts_.find(key);
+    NTA_CHECK(found != streamCounts_.end())
+      << "removeToken: token '" << token << "' is not in the stream.";
+    streamSize_--;
+    if (countsOccurrence_(found->second)) {
+      addTokenToAdders_(key, weight, -1, streamAdders_);
+    }
+    if (--found->second == 0u) {
+      streamCounts_.erase(found);
+    }
+  } // end method removeToken
+
+  /**
+   * ClearTokens
+   * @see SimHashDocumentEncoder.hpp
+   */
+  void SimHashDocumentEncoder::clearTokens()
+  {
+    streamAdders_ = Eigen::VectorXi::Zero(args_.size);
+    streamCounts_.clear();
+    streamSize_ = 0u;
+  } // end method clearTokens
+
+  /**
+   * EncodeTokens
+   * @see SimHashDocumentEncoder.hpp
+   */
+  void SimHashDocumentEncoder::encodeTokens(SDR &output)
+  {
+    SDR result({ args_.size });
+    std::vector<UInt> simBits(args_.size, 0u);
+
+    result.zero();
+    if (streamSize_ > 0u) {
+      Eigen::VectorXi adders = streamAdders_;
+      simHashAdders_(adders, simBits);
+      result.setDense(simBits);
+    }
+    output.setDense(result.getDense());
+  } // end method encodeTokens
+
+  /**
+   * FilterToken_
    * @see SimHashDocumentEncoder.hpp
    */
-  void SimHashDocumentEncoder::addVectorToMatrix_(const Eigen::VectorXi vector, Eigen::MatrixXi &matrix)
+  bool SimHashDocumentEncoder::filterToken_(const std::string &member, std::string &token, UInt &weight) const
   {
-    matrix.conservativeResize(Eigen::NoChange, matrix.cols() + 1u);
-    matrix.col(matrix.cols() - 1u) = vector;
-  } // end method addVectorToMatrix_
+    token = member;
+    weight = 1;  // default weight for non-vocab and vocab-orphan
+
+    // caseSensitivity
+    if (!args_.caseSensitivity) {
+      transform(token.begin(), token.end(), token.begin(), ::tolower);
+    }
+
+    // excludes
+    if (!args_.excludes.empty()) {
+      if(std::find(args_.excludes.begin(), args_.excludes.end(), token) != args_.excludes.end()) {
+        return false; // skip this excluded token
+      }
+    }
+
+    // vocabulary + encodeOrphans
+    if (args_.vocabulary.size()) {
+      if (args_.vocabulary.count(token)) {
+        weight = args_.vocabulary.at(token);  // use weight from vocab map
+      }
+      else if (!args_.encodeOrphans) {
+        return false;  // discard this non-vocab token
+      }
+    }
+    return true;
+  } // end method filterToken_
 
   /**
-   * BitsToWeightedAdder_
+   * CountsOccurrence_
    * @see SimHashDocumentEncoder.hpp
    */
-  void SimHashDocumentEncoder::bitsToWeightedAdder_(const UInt weight, Eigen::VectorXi &vector)
+  bool SimHashDocumentEncoder::countsOccurrence_(const UInt occurrence) const
   {
-    // convert hash bit columns to int adder columns (0 => -1)
-    vector = (vector.array() == 0u).select(-1, vector);
-    // weight the adders
-    vector *= weight;
-  } // end method bitsToWeightedAdder_
+    if (args_.frequencyFloor > 0 && occurrence <= args_.frequencyFloor) {
+      return false;  // discard under floor
+    }
+    if (args_.frequencyCeiling > 0 && occurrence >= args_.frequencyCeiling) {
+      return false;  // discard over ceiling
+    }
+    return true;
+  } // end method countsOccurrence_
 
   /**
-   * bytesToBits_
+   * AddTokenToAdders_
    * @see SimHashDocumentEncoder.hpp
    */
-  void SimHashDocumentEncoder::bytesToBits_(const std::vector<unsigned char> bytes, Eigen::VectorXi &bits)
+  void SimHashDocumentEncoder::addTokenToAdders_(const std::string &token, UInt tokenWeight,
+                                                 const Int sign, Eigen::VectorXi &adders)
   {
-    UInt bitcount = 0u;
-    bits = Eigen::VectorXi::Zero(args_.size);
-
-    for (const auto& byte : bytes) {
-      for (const auto& bit : std::bitset<CHAR_BIT>(byte).to_string()) {
-        bits(bitcount) = (UInt) (bit - '0');
-        bitcount++;
-        if (bitcount >= args_.size - 1) break;
+    // tokenSimilarity
+    if (args_.tokenSimilarity) {
+      std::map<std::string, UInt> histogramChar = {};
+      // generate hash digest for every single character individually
+      for (const auto& letter : token) {
+        const std::string letterStr = std::string(1u, letter);
+        UInt charWeight = args_.vocabulary.count(letterStr) ?
+                          args_.vocabulary.at(letterStr) : tokenWeight;
+
+        // char frequency ceiling (only)
+        histogramChar[letterStr]++;
+        if (args_.frequencyCeiling > 0 &&
+            histogramChar.at(letterStr) >= args_.frequencyCeiling) {
+          continue;  // discard over char
+        }
+
+        // hash character
+        addDigestToAdders_(hashToken_(letterStr), sign * (Int) charWeight, adders);
       }
+      tokenWeight = (UInt) (tokenWeight * 1.5); // try to balance token with letters
     }
-  } // end method bytesToBits_
+
+    // generate hash digest for whole token string
+    addDigestToAdders_(hashToken_(token), sign * (Int) tokenWeight, adders);
+  } // end method addTokenToAdders_
 
   /**
-   * HashToken_
+   * AddDigestToAdders_
    * @see SimHashDocumentEncoder.hpp
    */
-  void SimHashDocumentEncoder::hashToken_(const std::string token, Eigen::VectorXi &hashBits)
+  void SimHashDocumentEncoder::addDigestToAdders_(const std::vector<UInt64> &digest,
+                                                  const Int weight,
+                                                  Eigen::VectorXi &adders) const
   {
-    digestpp::shake256 hasher;
-    std::vector<unsigned char> digest;
+    for (UInt i = 0u; i < args_.size; i++) {
+      const Int bit = (Int) ((digest[i / 64u] >> (i % 64u)) & 1u);
+      adders(i) += (2 * bit - 1) * weight; // 0 => -weight, 1 => +weight
+    }
+  } // end method addDigestToAdders_
+
+  /**
+   * DigestToken_
+   * @see SimHashDocumentEncoder.hpp
+   */
+  void SimHashDocumentEncoder::digestToken_(const std::string &token, std::vector<UInt64> &digest)
+  {
+    digest.assign((args_.size + 63u) / 64u, 0u);
+
+    if (args_.fastHash) {
+      // extend the 64 bit hash to `size` bits with a SplitMix64 sequence
+      UInt64 state = hashString64(token);
+      for (auto &word : digest) {
+        state += GOLDEN_GAMMA;
+        word = mix64(state);
+      }
+      return;
+    }
 
+    digestpp::shake256 hasher;
+    digestBytes_.clear();
     hasher.absorb(token);
-    hasher.squeeze((UInt) ((args_.size / CHAR_BIT) + 1u), back_inserter(digest));
-    bytesToBits_(digest, hashBits);
+    hasher.squeeze((UInt) ((args_.size / CHAR_BIT) + 1u), back_inserter(digestBytes_));
+
+    // Bits are read most significant first. As in earlier releases, the
+    // last bit is the first bit of the byte following bit (size - 2), or 0
+    // past the end of the digest, so the encodings are unchanged.
+    const UInt last = args_.size - 1u;
+    for (UInt i = 0u; i < last; i++) {
+      const UInt64 bit = (digestBytes_[i / CHAR_BIT] >> (CHAR_BIT - 1u - i % CHAR_BIT)) & 1u;
+      digest[i / 64u] |= bit << (i % 64u);
+    }
+    const size_t lastByte = (last - 1u) / CHAR_BIT + 1u;
+    if (lastByte < digestBytes_.size()) {
+      const UInt64 bit = (digestBytes_[lastByte] >> (CHAR_BIT - 1u)) & 1u;
+      digest[last / 64u] |= bit << (last % 64u);
+    }
+  } // end method digestToken_
+
+  /**
+   * HashToken_
+   * @see SimHashDocumentEncoder.hpp
+   */
+  const std::vector<UInt64> &SimHashDocumentEncoder::hashToken_(const std::string &token)
+  {
+    if (cacheSize_ == 0u) {
+      digestToken_(token, digestBits_);
+      return digestBits_;
+    }
+    const auto found = cache_.find(token);
+    if (found != cache_.end()) {
+      cacheHits_++;
+      return found->second;
+    }
+    cacheMisses_++;
+    if (cache_.size() >= cacheSize_) {
+      cache_.clear();
+    }
+    auto &digest = cache_[token];
+    digestToken_(token, digest);
+    return digest;
   } // end method hashToken_
 
   /**
    * SimHashAdders_
    * @see SimHashDocumentEncoder.hpp
    */
-  void SimHashDocumentEncoder::simHashAdders_(const Eigen::MatrixXi adders, std::vector<UInt> &simhash)
+  void SimHashDocumentEncoder::simHashAdders_(Eigen::VectorXi &adders, std::vector<UInt> &simhash) const
   {
     Eigen::VectorXi::Index maxIndex;  // array index of current max member
     Int minValue;                     // min value, used to neuter max vals during sparsify
-    Eigen::VectorXi sums(args_.size); // for bit sums of all hashes passed in
 
     std::fill(simhash.begin(), simhash.end(), 0u);
-    sums = Eigen::VectorXi::Zero(adders.cols());
 
-    // sum adder columns
-    sums = adders.rowwise().sum();
     // sparse simhash: top-N sums replaced with a binary 1, rest 0.
-    minValue = sums.minCoeff();
+    minValue = adders.minCoeff();
     for (UInt bit = 0u; bit < args_.activeBits; bit++) {
       // get index of current max value from vector, set bit in output
-      sums.maxCoeff(&maxIndex);
+      adders.maxCoeff(&maxIndex);
       simhash[maxIndex] = 1u;
       // neuter this max value so next iteration will get next highest max
-      sums(maxIndex) = minValue;
+      adders(maxIndex) = minValue;
     }
   } // end method simHashAdders_
 
@@ -312,6 +477,7 @@ namespace htm {
     out << "  frequencyFloor:   " << self.parameters.frequencyFloor    << ",\n";
     out << "  encodeOrphans:    " << self.parameters.encodeOrphans     << ",\n";
     out << "  excludes.size:    " << self.parameters.excludes.size()   << ",\n";
+    out << "  fastHash:         " << self.parameters.fastHash          << ",\n";
     out << "  size:             " << self.parameters.size              << ",\n";
     out << "  sparsity:         " << self.parameters.sparsity          << ",\n";
     out << "  tokenSimilarity:  " << self.parameters.tokenSimilarity   << ",\n";
@@ -26,6 +26,7 @@
 
 #include <Eigen/Dense>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <htm/encoders/BaseEncoder.hpp>
@@ -69,6 +70,16 @@ namespace htm {
      */
     std::vector<std::string> excludes = {};
 
+    /**
+     * @param :fastHash: Hash the tokens with a fast non-cryptographic 64 bit
+     *  hash, extended to `size` bits with a SplitMix64 sequence, instead of
+     *  SHA3+SHAKE256.
+     *    If True: Encoding is much faster, especially for long documents.
+     *      The encodings differ from those made with the default hash.
+     *    If False (default): Tokens are hashed with SHA3+SHAKE256.
+     */
+    bool fastHash = false;
+
     /**
      * @param :frequencyCeiling: The max number of times a token can be
      *  repeated in a document. Occurances of the token beyond this number will
@@ -193,11 +204,11 @@ namespace htm {
     /**
      * Encode (Main calling style)
      *
-     * Each token will be hashed with SHA3+SHAKE256 to get a binary digest
-     * output of desired `size`. These vectors will be stored in a matrix for
-     * the next step of processing. Weights from the `vocabulary` are added in
-     * during hashing and simhashing. After the loop, we SimHash the matrix of
-     * hashes, resulting in an output SDR. If param "tokenSimilarity" is set,
+     * Each token will be hashed with SHA3+SHAKE256 (or the fast hash, see
+     * param `fastHash`) to get a binary digest output of desired `size`. The
+     * bits of every digest are added to a vector of adders, weighted by the
+     * `vocabulary`. After the loop, we SimHash the adders, resulting in an
+     * output SDR. If param "tokenSimilarity" is set,
      * we'll also loop and hash through all the letters in the tokens.
      *
      * @param :input: Document token strings to encode, ex: {"what","is","up"}.
@@ -226,6 +237,63 @@ namespace htm {
      */
     void encode(const std::string input, SDR &output);
 
+    /**
+     * Streaming encoding
+     *
+     * For a sliding window of tokens, such as a log stream. The SimHash is a
+     * sum of weighted token digests, so the encoder keeps the sum of the
+     * tokens in its window and updates it as tokens enter and leave, at the
+     * cost of hashing one token, instead of encoding the whole window again.
+     * encodeTokens() gives the same output as encode() of the window.
+     *
+     * The window is a runtime state, it is not serialized. With tokens that
+     * recur in the stream, also enable the token cache (@see setCacheSize).
+     *
+     * @code
+     *    encoder.addToken("bravo");
+     *    encoder.addToken("delta");
+     *    encoder.encodeTokens(output); // same as encode({"bravo", "delta"})
+     *    encoder.removeToken("bravo");
+     *    encoder.encodeTokens(output); // same as encode({"delta"})
+     */
+    void addToken(const std::string &token);
+
+    /**
+     * Remove one occurrence of a token added with addToken().
+     * Throws if the token is not in the window.
+     */
+    void removeToken(const std::string &token);
+
+    /** Remove all tokens from the window. */
+    void clearTokens();
+
+    /** Number of tokens in the window. */
+    UInt getNumTokens() const { return streamSize_; }
+
+    /**
+     * Encode the tokens in the window.
+     * @param :output: Result SDR to fill with result output encoding.
+     */
+    void encodeTokens(SDR &output);
+
+    /**
+     * Token hash cache.  Every token (and letter, with `tokenSimilarity`) is
+     * hashed to `size` bits.  With the cache enabled, the digests of up to
+     * @param maxTokens distinct tokens are kept, so that tokens which recur
+     * across documents are hashed once.  When the cache is full it is
+     * emptied, and refills with the tokens in use.  A digest takes size/8
+     * bytes of memory.
+     *
+     * The value 0 (the default) disables the cache.  This is a runtime
+     * setting, the cache is not serialized.
+     */
+    void setCacheSize(UInt maxTokens);
+    UInt getCacheSize() const { return cacheSize_; }
+
+    /** Number of token digests served from / not found in the cache. */
+    UInt64 getCacheHits()   const { return cacheHits_; }
+    UInt64 getCacheMisses() const { return cacheMisses_; }
+
     /**
      * Serialization
      */
@@ -234,11 +302,13 @@ namespace htm {
     template<class Archive>
     void save_ar(Archive& ar) const {
       const std::string name = "SimHashDocumentEncoder";
+      saveArchiveVersion(ar, std::string(ARCHIVE_MARKER), ARCHIVE_VERSION);
       ar(cereal::make_nvp("name", name));
       ar(cereal::make_nvp("activeBits", args_.activeBits));
       ar(cereal::make_nvp("caseSensitivity", args_.caseSensitivity));
       ar(cereal::make_nvp("encodeOrphans", args_.encodeOrphans));
       ar(cereal::make_nvp("excludes", args_.excludes));
+      ar(cereal::make_nvp("fastHash", args_.fastHash));
       ar(cereal::make_nvp("frequencyCeiling", args_.frequencyCeiling));
       ar(cereal::make_nvp("frequencyFloor", args_.frequencyFloor));
       ar(cereal::make_nvp("size", args_.size));
@@ -250,11 +320,17 @@ namespace htm {
     template<class Archive>
     void load_ar(Archive& ar) {
       std::string name;
-      ar(cereal::make_nvp("name", name));
+      const UInt32 version = loadArchiveVersion(ar, "name", name, std::string(ARCHIVE_MARKER), 1u);
+      NTA_CHECK(version <= ARCHIVE_VERSION) << "Unknown archive version " << version;
       ar(cereal::make_nvp("activeBits", args_.activeBits));
       ar(cereal::make_nvp("caseSensitivity", args_.caseSensitivity));
       ar(cereal::make_nvp("encodeOrphans", args_.encodeOrphans));
       ar(cereal::make_nvp("excludes", args_.excludes));
+      if (version >= 2u) {
+        ar(cereal::make_nvp("fastHash", args_.fastHash));
+      } else {
+        args_.fastHash = false; // archived before the fast hash existed
+      }
       ar(cereal::make_nvp("frequencyCeiling", args_.frequencyCeiling));
       ar(cereal::make_nvp("frequencyFloor", args_.frequencyFloor));
       ar(cereal::make_nvp("size", args_.size));
@@ -262,73 +338,128 @@ namespace htm {
       ar(cereal::make_nvp("tokenSimilarity", args_.tokenSimilarity));
       ar(cereal::make_nvp("vocabulary", args_.vocabulary));
       BaseEncoder<std::vector<std::string>>::initialize({ args_.size });
+      clearCache_();
+      clearTokens();
     }
 
     ~SimHashDocumentEncoder() override {};
     // end public
 
   private:
+    // Version 2 added fastHash, version 1 is the unversioned layout.
+    static const UInt32 ARCHIVE_VERSION = 2u;
+    // Read in place of the name of an unversioned binary archive.
+    static constexpr const char *ARCHIVE_MARKER = "SimHashDocumentEncoder.archiveVersion";
+
     // Private Params
     SimHashDocumentEncoderParameters args_;
 
+    // Streaming window: sum of the token digests, and occurrences of every
+    // token (after case folding) which passed the excludes & vocabulary.
+    Eigen::VectorXi streamAdders_;
+    std::unordered_map<std::string, UInt> streamCounts_;
+    UInt streamSize_ = 0u;
+
+    // Token hash cache, token -> digest bits (@see hashToken_).
+    UInt cacheSize_ = 0u;
+    std::unordered_map<std::string, std::vector<UInt64>> cache_;
+    UInt64 cacheHits_   = 0u;
+    UInt64 cacheMisses_ = 0u;
+    std::vector<UInt64> digestBits_;         //reused scratch
+    std::vector<unsigned char> digestBytes_; //reused scratch
+
+    void clearCache_();
+
     /**
-     * AddVectorToMatrix_
+     * FilterToken_
      *
-     * @param :vector: Source eigen vector column to be attached.
-     * @param :matrix: Target eigen matrix that will be added to.
+     * Apply `caseSensitivity`, `excludes` and `vocabulary` to a token.
+     *
+     * @param :member: Source token, as passed to encode().
+     * @param :token: Set to the token to hash.
+     * @param :weight: Set to the weight of the token.
+     * @returns False if the token is discarded.
      */
-    void addVectorToMatrix_(const Eigen::VectorXi vector, Eigen::MatrixXi &matrix);
+    bool filterToken_(const std::string &member, std::string &token, UInt &weight) const;
 
     /**
-     * BitsToWeightedAdder_
+     * CountsOccurrence_
      *
-     * Take the bits from a hash, convert 0 to -1, and multiply by provided
-     *  weighting factor. For example:
-     *    In Column   = { 0, 1,  0,  0, 1,  0}
+     * @param :occurrence: The number of times a token appeared so far in the
+     *  document, including this one.
+     * @returns False if this occurrence is discarded by the frequency floor
+     *  or ceiling.
+     */
+    bool countsOccurrence_(const UInt occurrence) const;
+
+    /**
+     * AddTokenToAdders_
+     *
+     * Add the weighted digest of a token, and of its letters if
+     *  `tokenSimilarity` is set, to the adders.
+     *
+     * @param :token: Token to hash, @see filterToken_.
+     * @param :tokenWeight: Weight of the token.
+     * @param :sign: 1 to add the token, -1 to remove it.
+     * @param :adders: Target eigen vector of adders, of length `size`.
+     */
+    void addTokenToAdders_(const std::string &token, UInt tokenWeight,
+                           const Int sign, Eigen::VectorXi &adders);
+
+    /**
+     * AddDigestToAdders_
+     *
+     * Add the bits of a digest to the adders, a 1 bit adds the weight and a
+     *  0 bit subtracts it. For example:
+     *    In Digest   = { 0, 1,  0,  0, 1,  0}
      *    In Weight   = 3
-     *    Out Result  = {-3, 3, -3, -3, 3, -3}
+     *    Adders     += {-3, 3, -3, -3, 3, -3}
      *
-     * @param :weight: Weight to add to column (positive integer, usually 1).
-     * @param :vector: Target eigen vector column to add weighting to.
+     * @param :digest: Digest bits, @see hashToken_.
+     * @param :weight: Weight of the token (usually 1), negated to remove it.
+     * @param :adders: Target eigen vector of adders, of length `size`.
      */
-    void bitsToWeightedAdder_(const UInt weight, Eigen::VectorXi &vector);
+    void addDigestToAdders_(const std::vector<UInt64> &digest, const Int weight,
+                            Eigen::VectorXi &adders) const;
 
     /**
-     * BytesToBits_
+     * DigestToken_
      *
-     * Convert vector of hashed digest bytes to longer vector of bits.
+     * Hash a string into a binary digest of `size` bits, with SHA3+SHAKE256
+     *  or with the fast hash (param `fastHash`). The bits are packed into
+     *  64 bit words, bit i is (digest[i / 64] >> (i % 64)) & 1.
      *
-     * @param :bytes: Source hash (eigen byte vector) for binary conversion.
-     * @param :bits: Eigen vector to store converted binary hash digest in.
+     * @param :token: Source text to be hashed.
+     * @param :digest: Vector to store the result digest in.
      */
-    void bytesToBits_(const std::vector<unsigned char> bytes, Eigen::VectorXi &bits);
+    void digestToken_(const std::string &token, std::vector<UInt64> &digest);
 
     /**
      * HashToken_
      *
-     * Hash (SHA3+SHAKE256) a string into a byte digest.
-     * Convert the byte vector to a binary vector and set output.
+     * The digest of a string, @see digestToken_. Looks up the token cache
+     *  first, if enabled.
      *
      * @param :token: Source text to be hashed.
-     * @param :hashBits: Eigen vector to store result binary hash digest in.
+     * @returns The digest, from the cache or from scratch space. It is valid
+     *  until the next call.
      */
-    void hashToken_(const std::string token, Eigen::VectorXi &hashBits);
+    const std::vector<UInt64> &hashToken_(const std::string &token);
 
     /**
      * SimHashAdders_
      *
-     * Create a SimHash SDR from Eigen vector array (matrix) of Hash digest
-     *  bits (in slightly modified "Adder" SimHash form).
-     * Sum all these "Adder" vectors to get a type of binary histogram.
+     * Create a SimHash SDR from the sums of the weighted digest bits (in
+     *  slightly modified "Adder" SimHash form), a type of binary histogram.
      * Choose the desired number (activeBits) of max values, use their indices
      *  to set output On bits. Rest of bits are Off. We now have our result
      *  sparse SimHash. (In an ordinary dense SimHash, sums >= 0 become
      *  binary 1, the rest 0.)
      *
-     * @param :hashes: Source eigen matrix of hashes to be simhashed.
+     * @param :adders: Source eigen vector of adders, modified in place.
      * @param :simhash: Stadard vector to store dense binary simhash result in.
      */
-    void simHashAdders_(const Eigen::MatrixXi adders, std::vector<UInt> &simhash);
+    void simHashAdders_(Eigen::VectorXi &adders, std::vector<UInt> &simhash) const;
     // end private
 
   }; // end class SimHashDocumentEncoder
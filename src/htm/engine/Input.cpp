@@ -102,6 +102,25 @@ std::shared_ptr<Link> Input::findLink(const std::string &srcRegionName,
 }
 
 void Input::prepare() {
+  if (region_->isPure()) {
+    bool changed = false;
+    for (auto &link : links_) {
+      changed = link->updateSourceVersion() or changed;
+    }
+    if (not changed)
+      return;
+  }
+  version_++;
+
+  if (sparseFanIn_) {
+    // Concatenate the active bits of the sources, each at its offset.
+    sparse_.clear();
+    for (auto &elem : links_) {
+      elem->computeSparse(sparse_);
+    }
+    data_.getSDR().setSparse(sparse_);
+    return;
+  }
   // Each link copies data into its section of the overall input
   // TODO: initialization check?
   for (auto &elem : links_) {
@@ -315,9 +334,32 @@ void Input::initialize() {
     data_.zeroBuffer();
   }
 
+  sparseFanIn_ = data_.getType() == NTA_BasicType_SDR && links_.size() > 1 &&
+                 std::all_of(links_.begin(), links_.end(), [](const std::shared_ptr<Link> &link) {
+                   return link->getSrc()->getDataType() == NTA_BasicType_SDR;
+                 });
+  shareFanInBuffers();
+
   initialized_ = true;
 }
 
+void Input::shareFanInBuffers() {
+  if (links_.size() < 2)
+    return;
+  for (auto link : links_) {
+    Output *out = link->getSrc();
+    Array &from = out->getData();
+    if (link->getPropagationDelay() > 0 || out->getNumLinks() != 1 ||
+        from.getType() != data_.getType() || data_.getType() == NTA_BasicType_SDR ||
+        data_.getType() == NTA_BasicType_Str)
+      continue;
+    // Keep the current contents of the Output, then write in place.
+    const size_t offset = link->getOffset();
+    from.convertInto(data_, offset, data_.getCount());
+    from.setBufferRange(data_, offset, from.getCount());
+  }
+}
+
 void Input::uninitialize() {
   if (!initialized_)
     return;
@@ -341,6 +383,7 @@ void Input::resize() {
   }
   dim_ = {static_cast<UInt32>(count)};
   data_.allocateBuffer(count);
+  shareFanInBuffers();
 }
 
 namespace htm {
@@ -207,6 +207,22 @@ public:
    */
   bool hasIncomingLinks() { return !links_.empty(); }
 
+  /**
+   * true if the caller writes the data of this input directly, instead of
+   * links, eg. a buffer bound by the C API.  Region::hasInput() counts a
+   * bound input as connected.
+   */
+  bool isBound() const { return bound_; }
+  void setBound(bool bound) { bound_ = bound; }
+
+  /**
+   * The version of the data, incremented when prepare() or
+   * Region::setInputData() change it.  The inputs of a pure region skip
+   * the links when no source Output changed, see RegionImpl::isPure().
+   */
+  UInt64 getVersion() const { return version_; }
+  void touch() { version_++; }
+
   /**
    * Resize the input buffer.  This is called if a connected output is resized.
    */
@@ -228,6 +244,12 @@ private:
   bool initialized_;
   Dimensions dim_;
   Array data_;
+  UInt64 version_ = 0u;
+  bool bound_ = false;
+
+  // Fan-in of SDRs, concatenates the sparse indices of the sources.
+  bool sparseFanIn_ = false;
+  SDR_sparse_t sparse_;
 
   // Useful for us to know our own name
   std::string name_;
@@ -242,6 +264,14 @@ private:
    * but does not affect the links.
    */
   void uninitialize();
+
+  /*
+   * For a Fan-In, let the source Outputs which feed only this input
+   * without delay, and have the same type, use their part of the input
+   * buffer as their buffer.  The sources then write in place, and their
+   * links do not copy.
+   */
+  void shareFanInBuffers();
 };
 
 } // namespace htm
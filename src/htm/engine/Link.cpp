@@ -19,6 +19,7 @@
  * Implementation of the Link class
  */
 #include <cstring> // memcpy,memset
+#include <utility> // move
 #include <htm/engine/Input.hpp>
 #include <htm/engine/Link.hpp>
 #include <htm/engine/Output.hpp>
@@ -100,7 +101,22 @@ void Link::initialize(size_t destinationOffset, bool is_FanIn) {
   // Initialize the propagation delay buffer
   // But skip it if it already has something in it from deserialize().
   // ---
-  if (propagationDelay_ > 0 && propagationDelayBuffer_.empty()) {
+  if (propagationDelay_ > 0 && src_->getData().getType() == NTA_BasicType_SDR) {
+    // An SDR source is delayed as its active bits only, initially none.
+    // A queue from deserialize() is converted.
+    if (sparseDelayBuffer_.empty()) {
+      sparseDelayBuffer_.resize(propagationDelay_);
+      for (size_t i = 0; i < propagationDelayBuffer_.size() && i < propagationDelay_; i++) {
+        const Array &a = propagationDelayBuffer_[i];
+        if (a.getType() == NTA_BasicType_SDR)
+          sparseDelayBuffer_[i] = a.getSDR().getSparse();
+        else
+          BasicType::nonzeroIndices(a.getBuffer(), a.getType(), a.getCount(), sparseDelayBuffer_[i]);
+      }
+      propagationDelayBuffer_.clear();
+    }
+    delayedSDR_ = src_->getData().copy();
+  } else if (propagationDelay_ > 0 && propagationDelayBuffer_.empty()) {
     // Initialize delay data elements.  This must be done during initialize()
     // because the buffer size is not known prior to then.
     // front of queue will be the next value to be copied to the dest Input buffer.
@@ -177,15 +193,36 @@ Input* Link::getDest() const {
 void Link::compute() {
   NTA_CHECK(initialized_);
 
+  const bool sparseDelay = !sparseDelayBuffer_.empty();
   if (propagationDelay_) {
     // A delayed link's queue buffer size should always be number of delays.
-    NTA_CHECK(propagationDelayBuffer_.size() == (propagationDelay_));
+    NTA_CHECK((sparseDelay ? sparseDelayBuffer_.size() : propagationDelayBuffer_.size()) == (propagationDelay_));
   }
+  Array &dest = dest_->getData();
+
+  if (sparseDelay && dest.getType() == NTA_BasicType_SDR && destOffset_ == 0 &&
+      dest.getCount() == delayedSDR_.getCount()) {
+    // The delayed active bits go straight into the destination SDR.
+    const bool profiling = dest_->getRegion()->isProfiling();
+    if (profiling)
+      profile_.timer.start();
+    Tracer *tracer = dest_->getRegion()->getTracer();
+    Tracer::Scope traced(tracer, internTraceName_(tracer), Tracer::Cat_Link);
+    dest.getSDR().setSparse(sparseDelayBuffer_.front());
+    if (profiling) {
+      profile_.copies++;
+      profile_.bytes += sparseDelayBuffer_.front().size() * sizeof(UInt32);
+      profile_.timer.stop();
+    }
+    return;
+  }
+  if (sparseDelay)
+    delayedSDR_.getSDR().setSparse(sparseDelayBuffer_.front());
 
   // Copy data from source to destination. For delayed links, will copy from
   // head of circular queue; otherwise directly from source.
-  const Array &src = propagationDelay_ ? propagationDelayBuffer_.front() : src_->getData();
-  Array &dest = dest_->getData();
+  const Array &src = sparseDelay ? delayedSDR_
+                   : propagationDelay_ ? propagationDelayBuffer_.front() : src_->getData();
 
   NTA_DEBUG << "compute Link: copying " << getMoniker()
               << "; delay=" << propagationDelay_ << "; size=" << src.getCount()
@@ -196,30 +233,135 @@ void Link::compute() {
         << "Not enough room in buffer to propogate to " << destRegionName_
         << " " << destInputName_ << ". ";
 
+  const bool profiling = dest_->getRegion()->isProfiling();
+  if (profiling)
+    profile_.timer.start();
+  Tracer *tracer = dest_->getRegion()->getTracer();
+  Tracer::Scope traced(tracer, internTraceName_(tracer), Tracer::Cat_Link);
+
   if (src.getType() == dest.getType() && !is_FanIn_ && propagationDelay_==0) {
     dest = src;   // Performs a shallow copy. Data not copied but passed in shared_ptr.
+    if (profiling)
+      profile_.shared++;
+  } else if (is_FanIn_ && propagationDelay_ == 0 && src.isBufferRange(dest, destOffset_)) {
+    // The source wrote directly into its part of the destination buffer.
+    // See Input::shareFanInBuffers().
+    if (profiling)
+      profile_.shared++;
   } else {
     // we must perform a deep copy with possible type conversion.
     // It is copied into the destination Input
     // buffer at the specified offset so an Input with multiple incoming links
     // has the Output buffers appended into a single large Input buffer.
     src.convertInto(dest, destOffset_, dest.getCount());
+    if (profiling) {
+      profile_.copies++;
+      if (src.getType() != dest.getType())
+        profile_.conversions++;
+      profile_.bytes += src.getCount() * BasicType::getSize(dest.getType());
+    }
   }
+
+  if (profiling)
+    profile_.timer.stop();
+}
+
+void Link::computeSparse(SDR_sparse_t &sparse) const {
+  NTA_CHECK(initialized_);
+
+  const bool profiling = dest_->getRegion()->isProfiling();
+  if (profiling)
+    profile_.timer.start();
+  Tracer *tracer = dest_->getRegion()->getTracer();
+  Tracer::Scope traced(tracer, internTraceName_(tracer), Tracer::Cat_Link);
+  const SDR_sparse_t &active = !sparseDelayBuffer_.empty() ? sparseDelayBuffer_.front()
+                             : propagationDelay_ ? propagationDelayBuffer_.front().getSDR().getSparse()
+                             : src_->getData().getSDR().getSparse();
+  const UInt offset = static_cast<UInt>(destOffset_);
+  const size_t before = sparse.size();
+  for (const auto index : active) {
+    sparse.push_back(index + offset);
+  }
+  if (profiling) {
+    profile_.copies++;
+    profile_.bytes += (sparse.size() - before) * sizeof(UInt32);
+    profile_.timer.stop();
+  }
+}
+
+UInt32 Link::internTraceName_(Tracer *tracer) const {
+  if (tracer != nullptr and traceName_ == Tracer::NoName)
+    traceName_ = tracer->intern(getMoniker());
+  return traceName_;
+}
+
+bool Link::updateSourceVersion() {
+  const UInt64 version = src_->getVersion();
+  if (propagationDelay_ == 0u and version == srcVersion_)
+    return false;
+  srcVersion_ = version;
+  return true;
 }
 
+
 void Link::shiftBufferedData() {
-  if (propagationDelay_) {   // Source buffering is not used in 0-delay links
+  if (propagationDelay_ && !sparseDelayBuffer_.empty()) {
+    NTA_CHECK(sparseDelayBuffer_.size() == (propagationDelay_));
+    const bool profiling = dest_ != nullptr && dest_->getRegion()->isProfiling();
+    if (profiling)
+      profile_.timer.start();
+    Tracer *tracer = dest_ != nullptr ? dest_->getRegion()->getTracer() : nullptr;
+    Tracer::Scope traced(tracer, internTraceName_(tracer), Tracer::Cat_Shift);
+
+    // As below, but the slot keeps only the active bits of the source SDR;
+    // its vector is reused.
+    SDR_sparse_t recycled = std::move(sparseDelayBuffer_.front());
+    sparseDelayBuffer_.pop_front();
+    sparseDelayBuffer_.push_back(std::move(recycled));
+    const SDR_sparse_t &active = src_->getData().getSDR().getSparse();
+    sparseDelayBuffer_.back().assign(active.begin(), active.end());
+    if (profiling) {
+      profile_.bytes += active.size() * sizeof(UInt32);
+      profile_.timer.stop();
+    }
+  } else if (propagationDelay_) {   // Source buffering is not used in 0-delay links
     Array& from = src_->getData();
     NTA_CHECK(propagationDelayBuffer_.size() == (propagationDelay_));
-
-    // push a copy of the source Output buffer on the back of the queue.
-    // This must be a deep copy.
-    Array a = from.copy();
-    propagationDelayBuffer_.push_back(a);
-
-    // Pop the head of the queue
+    const bool profiling = dest_ != nullptr && dest_->getRegion()->isProfiling();
+    if (profiling)
+      profile_.timer.start();
+    Tracer *tracer = dest_ != nullptr ? dest_->getRegion()->getTracer() : nullptr;
+    Tracer::Scope traced(tracer, internTraceName_(tracer), Tracer::Cat_Shift);
+
+    // Pop the head of the queue. It was already copied to the destination,
+    // so its buffer is pushed on the back and reused; only the slot moves.
     // The top of the queue now becomes the value to copy to destination.
+    Array recycled = std::move(propagationDelayBuffer_.front());
     propagationDelayBuffer_.pop_front();
+    propagationDelayBuffer_.push_back(std::move(recycled));
+
+    // Copy the source Output buffer into the back of the queue.
+    // This must be a deep copy.
+    Array &to = propagationDelayBuffer_.back();
+    if (!to.has_buffer() || to.isInstance(from) || to.getType() != from.getType() ||
+        to.getCount() != from.getCount() ||
+        (from.getType() == NTA_BasicType_SDR &&
+         to.getSDR().dimensions != from.getSDR().dimensions)) {
+      to = from.copy();
+    } else if (from.getType() == NTA_BasicType_SDR) {
+      to.getSDR().setSDR(from.getSDR());
+    } else if (from.getType() == NTA_BasicType_Str) {
+      from.convertInto(to);
+    } else {
+      std::memcpy(to.getBuffer(), from.getBuffer(),
+                  from.getCount() * BasicType::getSize(from.getType()));
+    }
+    if (profiling) {
+      profile_.bytes += from.getType() == NTA_BasicType_SDR
+                            ? from.getSDR().getSparse().size() * sizeof(UInt32)
+                            : from.getCount() * BasicType::getSize(from.getType());
+      profile_.timer.stop();
+    }
   }
 }
 
@@ -240,9 +382,30 @@ std::deque<Array> Link::preSerialize() const {
       const Array& s = src_->getData();
       srcCount = s.getCount();
     }
-    Array a = dest_->getData().subset(destOffset_, srcCount);
-    delay.push_back(a); // our part of the current Dest Input buffer.
+    const Array &dest = dest_->getData();
+    if (dest.getType() == NTA_BasicType_SDR) {
+      // The active bits of our part of the destination SDR.
+      Array a = src_->getData().copy();
+      SDR_sparse_t active;
+      for (const auto index : dest.getSDR().getSparse()) {
+        if (index >= destOffset_ && index < destOffset_ + srcCount)
+          active.push_back(static_cast<UInt32>(index - destOffset_));
+      }
+      a.getSDR().setSparse(active);
+      delay.push_back(a);
+    } else {
+      Array a = dest.subset(destOffset_, srcCount);
+      delay.push_back(a); // our part of the current Dest Input buffer.
+    }
 
+    if (!sparseDelayBuffer_.empty()) {
+      // The same queue as Arrays, without the last slot.
+      for (size_t i = 0; i + 1 < sparseDelayBuffer_.size(); i++) {
+        Array slot = src_->getData().copy();
+        slot.getSDR().setSparse(sparseDelayBuffer_[i]);
+        delay.push_back(slot);
+      }
+    }
     for (auto itr = propagationDelayBuffer_.begin();
           itr != propagationDelayBuffer_.end(); itr++) {
       if (itr + 1 == propagationDelayBuffer_.end())
@@ -287,6 +450,12 @@ std::ostream &operator<<(std::ostream &f, const Link &link) {
 	  for (auto buf : link.propagationDelayBuffer_) {
 		  f << "    " << buf << "\n";
 	  }
+	  for (const auto &active : link.sparseDelayBuffer_) {
+		  f << "    SDR active [";
+		  for (size_t i = 0; i < active.size(); i++)
+		    f << (i ? ", " : "") << active[i];
+		  f << "]\n";
+	  }
 	  f <<   "   ]\n";
   }
   f << "}\n";
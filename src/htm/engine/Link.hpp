@@ -27,6 +27,8 @@
 
 #include <htm/ntypes/Array.hpp>
 #include <htm/ntypes/Dimensions.hpp>
+#include <htm/engine/Tracer.hpp>
+#include <htm/os/Timer.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
 
@@ -434,6 +436,7 @@ public:
   /*
    * No-op for links without delay; for delayed links, remove head element of
    * the propagation delay buffer and push back the current value from source.
+   * The delay buffer of an SDR source keeps the active bits only.
    *
    * NOTE It's intended that this method be called exactly once on all links
    * within a network at the end of every time step. Network::run calls it
@@ -450,6 +453,39 @@ public:
   const std::string toString() const;
 
   void setOffset(size_t count) { destOffset_ = count; }
+  size_t getOffset() const { return destOffset_; }
+
+  /**
+   * Append the active bits of the source SDR, moved to the offset of this
+   * link, to the sparse indices of a Fan-In of SDRs.
+   * Used instead of compute() when all sources of the Fan-In are SDRs.
+   */
+  void computeSparse(SDR_sparse_t &sparse) const;
+
+  /**
+   * Remember the version of the source Output.
+   *
+   * @returns true if the source changed since the last call, or if the link
+   * has a propagation delay, in which case the data shifts every iteration.
+   */
+  bool updateSourceVersion();
+
+  /**
+   * What the link did while the destination region was profiling,
+   * @see Region::enableProfiling().
+   */
+  struct Profile {
+    UInt64 shared = 0u;      // the source buffer was passed without a copy
+    UInt64 copies = 0u;      // deep copies into the destination Input
+    UInt64 conversions = 0u; // copies which converted the element type
+    UInt64 bytes = 0u;       // bytes written into the Input and the delay queue
+    Timer timer;             // in compute(), computeSparse(), shiftBufferedData()
+  };
+  const Profile &getProfile() const { return profile_; }
+  void resetProfile() {
+    profile_.shared = profile_.copies = profile_.conversions = profile_.bytes = 0u;
+    profile_.timer.reset(); // a Timer can not be assigned
+  }
 
   /**
    * Display and compare the link.
@@ -528,11 +564,25 @@ private:
 
   // Queue buffer for delayed source data buffering
   std::deque<Array> propagationDelayBuffer_;
+  // The queue of an SDR source instead, the active bits of each slot.  The
+  // dense buffer of a large SDR is many times the size of its active bits.
+  std::deque<SDR_sparse_t> sparseDelayBuffer_;
+  // The front of sparseDelayBuffer_ as an SDR, for compute().
+  Array delayedSDR_{NTA_BasicType_SDR};
   // Number of delay slots
   size_t propagationDelay_;
 
+  // Output::getVersion() of the source at the last updateSourceVersion()
+  UInt64 srcVersion_ = ~static_cast<UInt64>(0u);
+
   // link must be initialized before it can compute()
   bool initialized_;
+
+  mutable Profile profile_;
+
+  // The moniker, interned in the Tracer of the destination region.
+  UInt32 internTraceName_(Tracer *tracer) const;
+  mutable UInt32 traceName_ = Tracer::NoName;
 };
 
 } // namespace htm
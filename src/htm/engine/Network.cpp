@@ -19,21 +19,36 @@
 Implementation of the Network class
 */
 
+#include <algorithm> // sort, unique
+#include <chrono>
+#include <condition_variable>
+#include <cstdio> // rename
+#include <cstring> // memcpy
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 
+#include <htm/algorithms/Connections.hpp>
 #include <htm/engine/Input.hpp>
 #include <htm/engine/Link.hpp>
 #include <htm/engine/Network.hpp>
+#include <htm/engine/NetworkTemplate.hpp>
 #include <htm/engine/Output.hpp>
 #include <htm/engine/Region.hpp>
+#include <htm/engine/RegionImpl.hpp>
 #include <htm/engine/RegionImplFactory.hpp>
 #include <htm/engine/Spec.hpp>
 #include <htm/os/Directory.hpp>
 #include <htm/os/Path.hpp>
+#include <htm/os/ThreadAffinity.hpp>
 #include <htm/ntypes/BasicType.hpp>
+#include <htm/utils/ChunkFile.hpp>
 #include <htm/utils/Log.hpp>
 #include <htm/ntypes/Value.hpp>
 
@@ -56,6 +71,30 @@ Network::Network(Network &&n) noexcept {
   phaseInfo_ = std::move(n.phaseInfo_);
   callbacks_ = n.callbacks_;
   iteration_ = n.iteration_;
+  numThreads_ = n.numThreads_;
+  threadBudget_ = n.threadBudget_;
+  affinity_ = std::move(n.affinity_);
+  memoryLimit_ = n.memoryLimit_;
+  memoryCheckPeriod_ = n.memoryCheckPeriod_;
+  nextMemoryCheck_ = n.nextMemoryCheck_;
+  pipelined_ = n.pipelined_;
+  profiling_ = n.profiling_;
+  stageProfile_ = std::move(n.stageProfile_);
+  tracing_ = n.tracing_;
+  tracer_ = std::move(n.tracer_);
+  metrics_ = std::move(n.metrics_);
+  nextMetricsMemory_ = n.nextMetricsMemory_;
+  threadPool_ = std::move(n.threadPool_);
+  ioPool_ = std::move(n.ioPool_);
+  published_ = std::move(n.published_);
+  snapshot_ = std::move(n.snapshot_);
+  spareSnapshot_ = std::move(n.spareSnapshot_);
+  initialized_ = n.initialized_;
+  // The regions now belong to this network, the plan is rebuilt with them.
+  for (auto &p : regions_) {
+    p.second->network_ = this;
+  }
+  planValid_ = false;
 }
 
 Network::Network(const std::string& filename) {
@@ -84,6 +123,7 @@ Network::~Network() {
   for(auto p: regions_) {
     std::shared_ptr<Region> r = p.second;
     r->uninitialize();
+    r->setTracer(nullptr);
   }
 
   // 2. remove all links
@@ -98,50 +138,7 @@ Network::~Network() {
 
 
 void Network::configure(const std::string &yaml) {
-  ValueMap vm;
-  vm.parse(yaml);
-
-  NTA_CHECK(vm.isMap() && vm.contains("network")) << "Expected yaml string to start with 'network:'.";
-  Value &v1 = vm["network"];
-  NTA_CHECK(v1.isSequence()) << "Expected a sequence of entries starting with a command.";
-  for (size_t i = 0; i < v1.size(); i++) {
-    NTA_CHECK(v1[i].isMap()) << "Expcted a command";
-    for (auto cmd : v1[i]) {
-      if (cmd.first == "registerRegion") {
-        std::string type = cmd.second["type"].str();
-        std::string path = cmd.second["path"].str();
-        std::string classname = cmd.second["classname"].str();
-        // TODO:  
-        NTA_THROW << "For now you can only use the built-in C++ regions with the REST API.";
-      } else if (cmd.first == "addRegion") {
-        std::string name = cmd.second["name"].str();
-        std::string type = cmd.second["type"].str();
-        ValueMap params;
-        if (cmd.second.contains("params")) params = cmd.second["params"];
-        addRegion(name, type, params);
-
-        UInt32 phase = 0;
-        if (cmd.second.contains("phase")) {
-          phase = cmd.second["phase"].as<int>();
-          std::set<UInt32> phases;
-          phases.insert(phase);
-          setPhases(name, phases);
-        }
-      } else if (cmd.first == "addLink") {
-        std::string src = cmd.second["src"].str();
-        std::string dest = cmd.second["dest"].str();
-        std::vector<std::string> vsrc = Path::split(src, '.');
-        std::vector<std::string> vdest = Path::split(dest, '.');
-        int propagationDelay = 0;
-        if (cmd.second.contains("delay"))
-          propagationDelay = cmd.second["delay"].as<int>();
-        NTA_CHECK(vsrc.size() == 2) << "Expecting source domain name '.' output name.";
-        NTA_CHECK(vdest.size() == 2) << "Expecting destination domain name '.' input name.";
-
-        link(vsrc[0], vdest[0], "", "", vsrc[1], vdest[1], propagationDelay);
-      }
-    }
-  }
+  NetworkTemplate(yaml).apply(*this);
 }
 
 
@@ -153,6 +150,8 @@ std::shared_ptr<Region> Network::addRegion(const std::string &name,
   std::shared_ptr<Region> r = std::make_shared<Region>(name, nodeType, nodeParams, this);
   regions_[name] = r;
   initialized_ = false;
+  if (tracing_)
+    r->setTracer(tracer_.get());
 
 
   setDefaultPhase_(r.get());
@@ -167,6 +166,8 @@ std::shared_ptr<Region> Network::addRegion(const std::string &name,
   std::shared_ptr<Region> r = std::make_shared<Region>(name, nodeType, vm, this);
   regions_[name] = r;
   initialized_ = false;
+  if (tracing_)
+    r->setTracer(tracer_.get());
 
   setDefaultPhase_(r.get());
   return r;
@@ -177,6 +178,7 @@ std::shared_ptr<Region> Network::addRegion(std::shared_ptr<Region>& r) {
   NTA_CHECK(r != nullptr);
   r->network_ = this;
   regions_[r->getName()] = r;
+  r->setTracer(tracing_ ? tracer_.get() : nullptr);
   
   // If a region is added, initially set the phase to the default phase.
   // The phase can be changed later.
@@ -235,6 +237,7 @@ void Network::resetEnabledPhases_() {
   // min/max enabled phases based on what is in the network
   minEnabledPhase_ = getMinPhase();
   maxEnabledPhase_ = getMaxPhase();
+  planValid_ = false;
 }
 
 void Network::setPhases(const std::string &name, std::set<UInt32> &phases) {
@@ -281,6 +284,7 @@ void Network::removeRegion(const std::string &name) {
   // The incoming links are removed when the Input object is deleted.
   r->uninitialize();
   r->clearInputs();
+  r->setTracer(nullptr);
 
 
   auto phase = phaseInfo_.begin();
@@ -299,6 +303,14 @@ void Network::removeRegion(const std::string &name) {
   }
   resetEnabledPhases_();
 
+  // A removed region neither learns on a duty cycle nor provides its anomaly.
+  for (auto duty = learnDuty_.begin(); duty != learnDuty_.end();) {
+    if (duty->first == name or duty->second.anomalyRegion == name)
+      duty = learnDuty_.erase(duty);
+    else
+      duty++;
+  }
+
   // Region is deleted when the Shared_ptr goes out of scope.
   regions_.erase(itr);
   return;
@@ -352,6 +364,7 @@ std::shared_ptr<Link> Network::link(const std::string &srcRegionName,
   // Create the link itself
   auto link = std::make_shared<Link>(linkType, linkParams, srcOutput, destInput, propagationDelay);
   destInput->addLink(link, srcOutput);
+  planValid_ = false;
   return link;
 }
 
@@ -399,9 +412,161 @@ void Network::removeLink(const std::string &srcRegionName,
 
   // Finally, remove the link
   destInput->removeLink(link);
+  planValid_ = false;
 }
 
 void Network::run(int n) {
+  run_(n, nullptr, nullptr, nullptr);
+}
+
+// The executor of runAsync(), shared by all networks.
+static ThreadPool &asyncExecutor() {
+  static ThreadPool executor(0u);
+  return executor;
+}
+
+std::future<void> Network::runAsync(int n, std::function<void(std::exception_ptr)> done) {
+  return asyncExecutor().submit([this, n, done]() {
+    std::exception_ptr error;
+    try {
+      run(n);
+    } catch (...) {
+      error = std::current_exception();
+    }
+    if (done)
+      done(error);
+    if (error)
+      std::rethrow_exception(error);
+  });
+}
+
+void Network::runWithDeadline(Real64 budget, int n) {
+  NTA_CHECK(budget > 0.0) << "runWithDeadline: the budget must be positive, not " << budget;
+  deadlineBudget_ = budget;
+  const auto restore = [this]() {
+    deadlineBudget_ = 0.0;
+    for (const auto &step : plan_) {
+      step.region->setShedLevel(RegionImpl::Shed_None);
+    }
+  };
+  try {
+    run_(n, nullptr, nullptr, nullptr);
+  } catch (...) {
+    restore();
+    throw;
+  }
+  restore();
+}
+
+void Network::computeWithDeadline_() {
+  typedef std::chrono::steady_clock Clock;
+  if (stepSeconds_.size() != plan_.size()) {
+    stepSeconds_.assign(plan_.size(), 0.0);
+  }
+  Metrics &m = *metrics_;
+  const Clock::time_point start = Clock::now();
+  Clock::time_point lap = start;
+  for (size_t s = 0u; s < plan_.size(); s++) {
+    const PlanStep_ &step = plan_[s];
+    const Real64 left = deadlineBudget_ - std::chrono::duration<Real64>(lap - start).count();
+    Real64 rest = 0.0;
+    for (size_t r = s; r < plan_.size(); r++) {
+      rest += stepSeconds_[r];
+    }
+    UInt level = RegionImpl::Shed_None;
+    if (left <= 0.0 or rest > 4.0 * left)
+      level = RegionImpl::Shed_Learning;
+    else if (rest > 2.0 * left)
+      level = RegionImpl::Shed_Outputs;
+    else if (rest > left)
+      level = RegionImpl::Shed_Maintenance;
+    UInt duty = RegionImpl::Shed_None;
+    if (not learnDuty_.empty()) {
+      auto itr = learnDuty_.find(step.region->getName());
+      if (itr != learnDuty_.end())
+        duty = itr->second.level;
+    }
+    // Counted if shed for the deadline, not for the learn duty cycle.
+    switch (std::min(step.region->setShedLevel(std::max(level, duty)), level)) {
+    case RegionImpl::Shed_Maintenance: m.shedMaintenance.fetch_add(1u, std::memory_order_relaxed); break;
+    case RegionImpl::Shed_Outputs:     m.shedOutputs.fetch_add(1u, std::memory_order_relaxed); break;
+    case RegionImpl::Shed_Learning:    m.shedLearning.fetch_add(1u, std::memory_order_relaxed); break;
+    default: break;
+    }
+
+    for (const auto input : step.inputs) {
+      input->prepare();
+    }
+    step.region->compute();
+
+    const Clock::time_point now = Clock::now();
+    const Real64 seconds = std::chrono::duration<Real64>(now - lap).count();
+    stepSeconds_[s] = stepSeconds_[s] == 0.0 ? seconds : 0.8 * stepSeconds_[s] + 0.2 * seconds;
+    lap = now;
+  }
+  if (std::chrono::duration<Real64>(lap - start).count() > deadlineBudget_) {
+    m.deadlineMisses.fetch_add(1u, std::memory_order_relaxed);
+  }
+}
+
+void Network::setLearnDutyCycle(const std::string &region, UInt every,
+                                Real32 anomalyThreshold,
+                                const std::string &anomalyRegion) {
+  auto itr = regions_.find(region);
+  NTA_CHECK(itr != regions_.end()) << "setLearnDutyCycle: no region named '" << region << "'";
+  if (every == 1u and anomalyThreshold < 0.0f) {
+    if (learnDuty_.erase(region) > 0u) {
+      itr->second->setShedLevel(RegionImpl::Shed_None);
+    }
+    return;
+  }
+  NTA_CHECK(every > 0u or anomalyThreshold >= 0.0f)
+      << "setLearnDutyCycle: region '" << region << "' would never learn, set learningMode instead";
+  const std::string source = anomalyRegion.empty() ? region : anomalyRegion;
+  if (anomalyThreshold >= 0.0f) {
+    auto src = regions_.find(source);
+    NTA_CHECK(src != regions_.end()) << "setLearnDutyCycle: no region named '" << source << "'";
+    std::shared_ptr<Output> anomaly = src->second->getOutput("anomaly");
+    NTA_CHECK(anomaly != nullptr and anomaly->getDataType() == NTA_BasicType_Real32)
+        << "setLearnDutyCycle: region '" << source << "' has no Real32 anomaly output";
+  }
+  const UInt supported = itr->second->setShedLevel(RegionImpl::Shed_Learning);
+  itr->second->setShedLevel(RegionImpl::Shed_None);
+  NTA_CHECK(supported == RegionImpl::Shed_Learning)
+      << "setLearnDutyCycle: region '" << region << "' of type " << itr->second->getType()
+      << " can not skip learning";
+  learnDuty_[region] = {every, anomalyThreshold, source, RegionImpl::Shed_None};
+}
+
+void Network::applyLearnDuty_(const bool deadline) {
+  for (auto &entry : learnDuty_) {
+    LearnDuty_ &duty = entry.second;
+    bool learn = duty.every > 0u and iteration_ % duty.every == 0u;
+    if (not learn and duty.anomalyThreshold >= 0.0f) {
+      const Array &anomaly = regions_.at(duty.anomalyRegion)->getOutputData("anomaly");
+      learn = anomaly.getCount() > 0u and
+              static_cast<const Real32 *>(anomaly.getBuffer())[0] >= duty.anomalyThreshold;
+    }
+    duty.level = learn ? RegionImpl::Shed_None : RegionImpl::Shed_Learning;
+    if (not learn) {
+      metrics_->learnSkipped.fetch_add(1u, std::memory_order_relaxed);
+    }
+    // runWithDeadline() sets the level of each region as it computes.
+    if (not deadline) {
+      regions_.at(entry.first)->setShedLevel(duty.level);
+    }
+  }
+}
+
+void Network::releaseLearnDuty_() {
+  for (const auto &entry : learnDuty_) {
+    regions_.at(entry.first)->setShedLevel(RegionImpl::Shed_None);
+  }
+}
+
+void Network::run_(int n, const Region *source,
+                   const std::function<void(int)> &feed,
+                   const std::function<void(int)> &collect) {
   if (!initialized_) {
     initialize();
   }
@@ -412,38 +577,692 @@ void Network::run(int n) {
   NTA_CHECK(maxEnabledPhase_ < phaseInfo_.size())
       << "maxphase: " << maxEnabledPhase_ << " size: " << phaseInfo_.size();
 
-  for (int iter = 0; iter < n; iter++) {
-    iteration_++;
+  ScopedAffinity pinned(affinity_);
+  const auto runStart = std::chrono::steady_clock::now();
+  const UInt64 numIterations = static_cast<UInt64>(std::max(n, 0));
+  if (not planValid_ or planSource_ != source) {
+    buildPlan_(source);
+  }
+  const bool deadline = deadlineBudget_ > 0.0; // runWithDeadline(), in plan order
+  const bool learnDuty = not learnDuty_.empty(); // setLearnDutyCycle()
+
+  if (threadPool_ != nullptr and not deadline) {
+    buildSchedule_(source);
+    if (pipelineSchedule_) {
+      if (n > 0) {
+        // The iterations overlap, the whole run is one event.
+        Tracer *tracer = tracing_ ? tracer_.get() : nullptr;
+        Tracer::Scope traced(tracer, tracer ? tracer->intern("run") : Tracer::NoName,
+                             Tracer::Cat_Run, static_cast<UInt64>(n));
+        runSchedule_(static_cast<UInt64>(n));
+        iteration_ += static_cast<UInt64>(n);
+        if (not published_.empty()) {
+          publishSnapshot_();
+        }
+      }
+      updateMetrics_(numIterations, std::chrono::steady_clock::now() - runStart);
+      checkMemoryLimit_();
+      return;
+    }
+  }
+
+  // The async regions computing ahead.  Nothing observes the network
+  // between the iterations if there are no callbacks.
+  const bool prefetch = planPrefetch_ and threadPool_ == nullptr and not deadline and
+                        not learnDuty and callbacks_.getCount() == 0u and not collect;
+  std::vector<std::future<void>> prefetched(prefetch ? plan_.size() : 0u);
+  const auto computeStep = [](const PlanStep_ &step) {
+    for (const auto input : step.inputs) {
+      input->prepare();
+    }
+    step.region->compute();
+  };
+
+  // The seconds of the stages of an iteration, while profiling.
+  typedef std::chrono::steady_clock Clock;
+  const bool profiling = profiling_;
+  Real64 stages[Stage_NumStages] = {};
+  Clock::time_point iterationStart, lap;
+  const auto split = [&lap]() {
+    const Clock::time_point now = Clock::now();
+    const Real64 seconds = std::chrono::duration<Real64>(now - lap).count();
+    lap = now;
+    return seconds;
+  };
+
+  Tracer *tracer = tracing_ ? tracer_.get() : nullptr;
+  const UInt32 iterationName = tracer ? tracer->intern("iteration") : Tracer::NoName;
+
+  try {
+    for (int iter = 0; iter < n; iter++) {
+      iteration_++;
+      Tracer::Scope tracedIteration(tracer, iterationName, Tracer::Cat_Iteration, iteration_);
+
+      if (feed) {
+        feed(iter);
+      }
+      if (profiling) {
+        std::fill(stages, stages + Stage_NumStages, 0.0);
+        iterationStart = lap = Clock::now();
+      }
+
+      if (learnDuty) {
+        applyLearnDuty_(deadline);
+      }
+
+      // compute on all enabled regions in phase order
+      if (deadline) {
+        computeWithDeadline_();
+        if (profiling) stages[Stage_Compute] += split();
+      } else if (threadPool_ != nullptr) {
+        runSchedule_(1u);
+        if (profiling) stages[Stage_Compute] += split();
+      } else {
+        for (size_t s = 0u; s < plan_.size(); s++) {
+          const PlanStep_ &step = plan_[s];
+          if (prefetch and prefetched[s].valid()) {
+            prefetched[s].get(); // re-throws the exception of the compute
+            if (profiling) stages[Stage_Compute] += split();
+          } else if (profiling) {
+            for (const auto input : step.inputs) {
+              input->prepare();
+            }
+            stages[Stage_Inputs] += split();
+            step.region->compute();
+            stages[Stage_Compute] += split();
+          } else {
+            computeStep(step);
+          }
+          // The last iteration does not compute ahead, so the network is as
+          // expected when run() returns.
+          if (prefetch and iter + 1 < n) {
+            for (const auto a : step.prefetchAfter) {
+              const PlanStep_ *ahead = &plan_[a];
+              prefetched[a] = ioPool_->submit([&computeStep, ahead]() { computeStep(*ahead); });
+            }
+          }
+        }
+      }
+
+      if (collect) {
+        collect(iter);
+      }
+
+      // invoke callbacks
+      if (profiling) split();
+      for (UInt32 i = 0; i < callbacks_.getCount(); i++) {
+        const std::pair<std::string, callbackItem> &callback = callbacks_.getByIndex(i);
+        callback.second.first(this, iteration_, callback.second.second);
+      }
+      if (profiling) stages[Stage_Callbacks] = split();
+
+      // Refresh all links in the network at the end of every timestamp so that
+      // data in delayed links appears to change atomically between iterations
+      for (const auto link : planShifts_) {
+        link->shiftBufferedData();
+      }
+
+      if (profiling) {
+        stages[Stage_Shifts] = split();
+        stages[Stage_Iteration] = std::chrono::duration<Real64>(lap - iterationStart).count();
+        for (int stage = 0; stage < Stage_NumStages; stage++) {
+          stageProfile_[stage].add(stages[stage]);
+        }
+      }
+
+      if (not published_.empty()) {
+        publishSnapshot_();
+      }
+
+    } // End of outer run-loop
+  } catch (...) {
+    // Do not leave a region computing after run() returned.
+    for (auto &ahead : prefetched) {
+      if (ahead.valid()) ahead.wait();
+    }
+    if (learnDuty) {
+      releaseLearnDuty_();
+    }
+    throw;
+  }
+  if (learnDuty) {
+    releaseLearnDuty_();
+  }
+
+  updateMetrics_(numIterations, std::chrono::steady_clock::now() - runStart);
+  checkMemoryLimit_();
+}
+
+// Find the Output of "<region>.<output>".
+static std::shared_ptr<Output> findOutput(const Network &net, const std::string &name) {
+  const std::vector<std::string> args = Path::split(name, '.');
+  NTA_CHECK(args.size() == 2) << "Expected syntax <region>.<output>. Found " << name;
+  std::shared_ptr<Output> out = net.getRegion(args[0])->getOutput(args[1]);
+  NTA_CHECK(out != nullptr) << "Region " << args[0] << " has no output " << args[1];
+  return out;
+}
+
+void Network::runBatch(const std::string &source, const Array &records,
+                       const std::vector<std::string> &outputs,
+                       std::vector<Array> &results) {
+  if (!initialized_) {
+    initialize();
+  }
+  std::shared_ptr<Output> in = findOutput(*this, source);
+  NTA_CHECK(records.getType() != NTA_BasicType_SDR && records.getType() != NTA_BasicType_Str)
+      << "runBatch() records of type " << BasicType::getName(records.getType()) << " not supported.";
+  const size_t width = in->getData().getCount();
+  NTA_CHECK(width > 0u && records.getCount() > 0u && records.getCount() % width == 0u)
+      << "runBatch() expects rows of " << width << " elements for " << source
+      << ", found " << records.getCount() << " elements.";
+  const size_t numRecords = records.getCount() / width;
+
+  // Each result has a row per record, of the type of its output.  SDR results
+  // have the dimensions [numRecords, <output dimensions>].
+  std::vector<std::shared_ptr<Output>> outs;
+  std::vector<SDR_sparse_t> sparse(outputs.size());
+  results.resize(outputs.size());
+  for (size_t i = 0u; i < outputs.size(); i++) {
+    outs.push_back(findOutput(*this, outputs[i]));
+    const Array &out = outs[i]->getData();
+    if (out.getType() == NTA_BasicType_SDR) {
+      std::vector<UInt> dimensions = {static_cast<UInt>(numRecords)};
+      for (const auto d : out.getSDR().dimensions) dimensions.push_back(d);
+      if (results[i].getType() != NTA_BasicType_SDR || results[i].getCount() != numRecords * out.getCount()) {
+        results[i] = Array(NTA_BasicType_SDR);
+        results[i].allocateBuffer(dimensions);
+      }
+      sparse[i].clear();
+    } else if (results[i].getType() != out.getType() || results[i].getCount() != numRecords * out.getCount()) {
+      results[i] = Array(out.getType());
+      results[i].allocateBuffer(numRecords * out.getCount());
+    }
+  }
+
+  // The rows of the records, without copying them.
+  Array all = records;
+  Array row(records.getType());
+  const auto feed = [&](int iter) {
+    row.setBufferRange(all, static_cast<size_t>(iter) * width, width);
+    row.convertInto(in->getData());
+    in->touch();
+  };
+  const auto collect = [&](int iter) {
+    for (size_t i = 0u; i < outs.size(); i++) {
+      const Array &out = outs[i]->getData();
+      const size_t offset = static_cast<size_t>(iter) * out.getCount();
+      if (out.getType() == NTA_BasicType_SDR) {
+        for (const auto index : out.getSDR().getSparse()) {
+          sparse[i].push_back(static_cast<ElemSparse>(offset + index));
+        }
+      } else {
+        out.convertInto(results[i], offset, results[i].getCount());
+      }
+    }
+  };
+  run_(static_cast<int>(numRecords), in->getRegion(), feed, collect);
+
+  for (size_t i = 0u; i < outs.size(); i++) {
+    if (results[i].getType() == NTA_BasicType_SDR) {
+      results[i].getSDR().setSparse(sparse[i]);
+    }
+  }
+}
 
-    // compute on all enabled regions in phase order
-    for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
-      for (auto r : phaseInfo_[phase]) {
-        r->prepareInputs();
-        r->compute();
+void Network::publishOutput(const std::string &name) {
+  for (const auto &published : published_) {
+    if (published.first == name) return;
+  }
+  published_.emplace_back(name, findOutput(*this, name));
+}
+
+void Network::publishSnapshot_() {
+  // A spare which a reader still holds is left to the reader.
+  std::shared_ptr<OutputSnapshot> snapshot;
+  if (spareSnapshot_ != nullptr and spareSnapshot_.use_count() == 1) {
+    snapshot = std::move(spareSnapshot_);
+  } else {
+    snapshot = std::make_shared<OutputSnapshot>();
+  }
+  snapshot->iteration = iteration_;
+  for (const auto &published : published_) {
+    const Array &from = published.second->getData();
+    Array &to = snapshot->outputs[published.first];
+    if (to.has_buffer() and to.getType() == from.getType() and to.getCount() == from.getCount()) {
+      if (from.getType() == NTA_BasicType_SDR) {
+        to.getSDR().setSDR(from.getSDR());
+      } else if (from.getType() == NTA_BasicType_Str) {
+        from.convertInto(to);
+      } else {
+        std::memcpy(to.getBuffer(), from.getBuffer(),
+                    from.getCount() * BasicType::getSize(from.getType()));
       }
+    } else {
+      to = from.copy();
+    }
+  }
+  std::shared_ptr<const OutputSnapshot> previous = std::atomic_exchange(
+      &snapshot_, std::shared_ptr<const OutputSnapshot>(snapshot));
+  // The previous snapshot becomes the spare, unless a reader still has it.
+  spareSnapshot_ = std::const_pointer_cast<OutputSnapshot>(previous);
+}
+
+void Network::setNumThreads(UInt numThreads) {
+  numThreads_ = numThreads == 0u ? static_cast<UInt>(ThreadPool::hardwareConcurrency()) : numThreads;
+  if (numThreads_ > 1u) {
+    threadPool_ = std::make_shared<ThreadPool>(numThreads_ - 1u); // the calling thread works too
+    if (not affinity_.empty()) threadPool_->setAffinity(affinity_);
+  } else {
+    threadPool_.reset();
+  }
+  applyThreadBudget_();
+}
+
+void Network::setAffinity(const std::vector<UInt> &cores) {
+  affinity_ = ThreadAffinity::normalize(cores);
+  if (threadPool_ != nullptr) threadPool_->setAffinity(affinity_);
+  if (ioPool_ != nullptr) ioPool_->setAffinity(affinity_);
+}
+
+void Network::setNumaNode(UInt node) {
+  const std::vector<UInt> cores = ThreadAffinity::numaNodeCores(node);
+  NTA_CHECK(not cores.empty()) << "Network::setNumaNode -- the cores of NUMA node " << node << " are unknown";
+  setAffinity(cores);
+}
+
+void Network::setThreadBudget(UInt numThreads) {
+  threadBudget_ = numThreads == 0u ? static_cast<UInt>(ThreadPool::hardwareConcurrency()) : numThreads;
+  applyThreadBudget_();
+}
+
+size_t Network::memoryUsage() const {
+  size_t bytes = 0u;
+  for (const auto &p : regions_) {
+    bytes += p.second->memoryUsage();
+  }
+  return bytes;
+}
+
+void Network::setMemoryLimit(size_t bytes, UInt checkPeriod) {
+  NTA_CHECK(checkPeriod > 0u) << "setMemoryLimit: checkPeriod must be positive";
+  memoryLimit_ = bytes;
+  memoryCheckPeriod_ = checkPeriod;
+  nextMemoryCheck_ = iteration_ + checkPeriod;
+}
+
+void Network::checkMemoryLimit_() {
+  if (memoryLimit_ == 0u or iteration_ < nextMemoryCheck_)
+    return;
+  nextMemoryCheck_ = iteration_ + memoryCheckPeriod_;
+
+  std::vector<std::pair<size_t, Region *>> usage;
+  size_t total = 0u;
+  for (const auto &p : regions_) {
+    usage.emplace_back(p.second->memoryUsage(), p.second.get());
+    total += usage.back().first;
+  }
+  if (total <= memoryLimit_)
+    return;
+  std::sort(usage.begin(), usage.end(),
+            [](const std::pair<size_t, Region *> &a, const std::pair<size_t, Region *> &b) {
+              return a.first > b.first;
+            });
+  for (const auto &u : usage) {
+    u.second->reduceMemoryUsage();
+    total = total - u.first + u.second->memoryUsage();
+    if (total <= memoryLimit_)
+      return;
+  }
+  NTA_DEBUG << "Network memory usage " << total << " bytes is above the limit " << memoryLimit_;
+}
+
+const size_t Network::Metrics::NumRunBuckets;
+const Real64 Network::Metrics::RunBucketBounds[Network::Metrics::NumRunBuckets] = {
+    0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+    0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0};
+
+Network::Metrics::Metrics()
+    : iterations(0u), runs(0u), runNanoseconds(0u), segments(0u), synapses(0u),
+      prunedSegments(0u), prunedSynapses(0u), memoryBytes(0u), shedMaintenance(0u),
+      shedOutputs(0u), shedLearning(0u), deadlineMisses(0u), learnSkipped(0u) {
+  for (auto &bucket : runBuckets) {
+    bucket = 0u;
+  }
+}
+
+void Network::setMetrics(std::shared_ptr<Metrics> metrics) {
+  NTA_CHECK(metrics != nullptr);
+  metrics_ = metrics;
+  nextMetricsMemory_ = 0u;
+}
+
+void Network::updateMetrics_(const UInt64 iterations,
+                             const std::chrono::steady_clock::duration elapsed) {
+  Metrics &m = *metrics_;
+  const Real64 seconds = std::chrono::duration<Real64>(elapsed).count();
+  const size_t bucket = static_cast<size_t>(
+      std::lower_bound(Metrics::RunBucketBounds, Metrics::RunBucketBounds + Metrics::NumRunBuckets,
+                       seconds) - Metrics::RunBucketBounds);
+  m.runBuckets[bucket].fetch_add(1u, std::memory_order_relaxed);
+  m.runNanoseconds.fetch_add(static_cast<UInt64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()), std::memory_order_relaxed);
+  m.iterations.fetch_add(iterations, std::memory_order_relaxed);
+
+  UInt64 segments = 0u, synapses = 0u, prunedSegments = 0u, prunedSynapses = 0u;
+  for (const auto &r : regions_) {
+    for (const auto connections : r.second->getConnections()) {
+      segments += connections->numSegments();
+      synapses += connections->numSynapses();
+      prunedSegments += connections->numPrunedSegments();
+      prunedSynapses += connections->numPrunedSynapses();
     }
+  }
+  m.segments.store(segments, std::memory_order_relaxed);
+  m.synapses.store(synapses, std::memory_order_relaxed);
+  m.prunedSegments.store(prunedSegments, std::memory_order_relaxed);
+  m.prunedSynapses.store(prunedSynapses, std::memory_order_relaxed);
+  if (iteration_ >= nextMetricsMemory_) {
+    nextMetricsMemory_ = iteration_ + memoryCheckPeriod_;
+    m.memoryBytes.store(memoryUsage(), std::memory_order_relaxed);
+  }
+  m.runs.fetch_add(1u, std::memory_order_relaxed);
+}
+
+void Network::applyThreadBudget_() {
+  if (threadBudget_ == 0u)
+    return;
+  const UInt perRegion = std::max(1u, threadBudget_ / numThreads_);
+  for (auto p : regions_) {
+    p.second->setThreadBudget(perRegion);
+  }
+}
 
-    // invoke callbacks
-    for (UInt32 i = 0; i < callbacks_.getCount(); i++) {
-      const std::pair<std::string, callbackItem> &callback = callbacks_.getByIndex(i);
-      callback.second.first(this, iteration_, callback.second.second);
+void Network::buildPlan_(const Region *source) {
+  plan_.clear();
+  for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
+    for (auto r : phaseInfo_[phase]) {
+      if (r == source) continue; // fed by runBatch()
+      PlanStep_ step{r, {}, false, {}};
+      for (const auto &input : r->getInputs()) {
+        step.inputs.push_back(input.second.get());
+      }
+      plan_.push_back(std::move(step));
     }
+  }
 
-    // Refresh all links in the network at the end of every timestamp so that
-    // data in delayed links appears to change atomically between iterations
-    for (auto p: regions_) {
-      const std::shared_ptr<Region> r = p.second;
+  // An async region computes ahead if nothing but its readers in this plan
+  // look at its outputs, and all of them come after it.
+  planPrefetch_ = false;
+  std::map<const Region *, std::vector<size_t>> stepsOf;
+  for (size_t s = 0u; s < plan_.size(); s++) {
+    stepsOf[plan_[s].region].push_back(s);
+  }
+  for (const auto &steps : stepsOf) {
+    const Region *r = steps.first;
+    const size_t s = steps.second.front();
+    if (not r->getSpec()->async or steps.second.size() > 1u or
+        r->getType().compare(0u, 3u, "py.") == 0) // python computes hold the GIL
+      continue;
+    bool eligible = true;
+    for (const auto input : plan_[s].inputs) {
+      eligible = eligible and input->getLinks().empty();
+    }
+    size_t last = s;
+    for (const auto &output : r->getOutputs()) {
+      for (const auto &link : output.second->getLinks()) {
+        const Region *reader = link->getDest()->getRegion();
+        const auto readerSteps = stepsOf.find(reader);
+        eligible = eligible and link->getPropagationDelay() == 0u;
+        if (readerSteps == stepsOf.end())
+          continue; // not computed in this plan
+        eligible = eligible and readerSteps->second.front() > s;
+        last = std::max(last, readerSteps->second.back());
+      }
+    }
+    if (eligible) {
+      plan_[s].prefetched = true;
+      plan_[last].prefetchAfter.push_back(s);
+      planPrefetch_ = true;
+    }
+  }
+  if (planPrefetch_ and ioPool_ == nullptr) {
+    ioPool_ = std::make_shared<ThreadPool>(1u);
+    if (not affinity_.empty()) ioPool_->setAffinity(affinity_);
+  }
+  // Every delayed link shifts, also those of the disabled phases.
+  planShifts_.clear();
+  for (const auto &p : regions_) {
+    for (const auto &input : p.second->getInputs()) {
+      for (const auto &link : input.second->getLinks()) {
+        if (link->getPropagationDelay() > 0u) {
+          planShifts_.push_back(link.get());
+        }
+      }
+    }
+  }
+  planSource_ = source;
+  planValid_ = true;
+}
 
-      for (const auto &inputTuple : r->getInputs()) {
-        for (const auto pLink : inputTuple.second->getLinks()) {
-          pLink->shiftBufferedData();
+void Network::buildSchedule_(const Region *source) {
+  schedule_.clear();
+  std::map<const Region *, std::vector<size_t>> stepsOf;
+  for (UInt32 phase = minEnabledPhase_; phase <= maxEnabledPhase_; phase++) {
+    for (auto r : phaseInfo_[phase]) {
+      if (r == source) continue; // fed by runBatch()
+      stepsOf[r].push_back(schedule_.size());
+      const bool isPython = r->getType().compare(0u, 3u, "py.") == 0;
+      schedule_.push_back({r, isPython, 0u, 0u, {}, {}, {}, {}, {}, {}});
+    }
+  }
+  // Iterations overlap only if nothing observes the network between them,
+  // and every delayed link shifts inside the schedule.
+  pipelineSchedule_ = pipelined_ and callbacks_.getCount() == 0u and
+                      learnDuty_.empty() and stepsOf.size() == regions_.size();
+
+  // The later of two steps waits for the earlier one.
+  const auto order = [&](size_t a, size_t b) {
+    if (a == b) return;
+    if (b < a) std::swap(a, b);
+    schedule_[a].next.push_back(b);
+  };
+
+  for (const auto &steps : stepsOf) {
+    const size_t first = steps.second.front();
+    const size_t last = steps.second.back();
+    // A region computes once at a time, in phase order.
+    for (size_t i = 1u; i < steps.second.size(); i++) {
+      order(steps.second[i - 1u], steps.second[i]);
+    }
+    if (pipelineSchedule_) {
+      schedule_[last].nextIteration.push_back(first);
+    }
+    for (const auto &inputTuple : steps.first->getInputs()) {
+      for (const auto &link : inputTuple.second->getLinks()) {
+        const auto src = stepsOf.find(link->getSrc()->getRegion());
+        if (src == stepsOf.end()) continue; // source not in the enabled phases
+        const size_t srcFirst = src->second.front();
+        const size_t srcLast = src->second.back();
+
+        if (link->getPropagationDelay() == 0u) {
+          // A link without delay reads the output of its source region when
+          // its destination region prepares its inputs, and can share the
+          // buffer. Linked regions keep their relative order, whichever
+          // comes first, also across iterations.
+          for (const auto a : src->second) {
+            for (const auto b : steps.second) {
+              order(a, b);
+            }
+          }
+          if (pipelineSchedule_) {
+            schedule_[srcLast].nextIteration.push_back(first);
+            schedule_[last].nextIteration.push_back(srcFirst);
+          }
+        } else if (pipelineSchedule_) {
+          // A delayed link shifts its buffer once per iteration, after its
+          // destination read the front of the queue and after its source
+          // computed, before either of them computes again. The destination
+          // reads data of an older iteration, so the source can already
+          // compute the next iteration while the destination computes.
+          if (srcLast < last) {
+            // Shift in the last step of the destination, after its inputs.
+            order(srcLast, last);
+            schedule_[last].shiftAfterInputs.push_back(link.get());
+            schedule_[last].nextIterationAfterInputs.push_back(srcFirst);
+          } else {
+            // Shift in the last step of the source, after it computed.
+            if (srcLast != last) {
+              schedule_[last].nextAfterInputs.push_back(srcLast);
+            }
+            schedule_[srcLast].shiftAfterCompute.push_back(link.get());
+            schedule_[srcLast].nextIteration.push_back(first);
+          }
         }
       }
     }
+  }
 
-  } // End of outer run-loop
+  for (auto &step : schedule_) {
+    for (auto next : {&step.next, &step.nextAfterInputs, &step.nextIteration,
+                      &step.nextIterationAfterInputs}) {
+      std::sort(next->begin(), next->end());
+      next->erase(std::unique(next->begin(), next->end()), next->end());
+    }
+    for (const auto n : step.next) schedule_[n].numPrevious++;
+    for (const auto n : step.nextAfterInputs) schedule_[n].numPrevious++;
+    for (const auto n : step.nextIteration) schedule_[n].numPreviousIteration++;
+    for (const auto n : step.nextIterationAfterInputs) schedule_[n].numPreviousIteration++;
+  }
+}
 
-  return;
+void Network::runSchedule_(const UInt64 numIterations) {
+  // One compute of a step, of an iteration.
+  struct Task {
+    UInt64 iteration;
+    size_t step;
+  };
+  const size_t numSteps = schedule_.size();
+  if (numSteps == 0u) return;
+  // Iterations [first, first + window) may compute. The counts of pending
+  // steps are kept for one more iteration, which the last one releases into.
+  const UInt64 window = std::min<UInt64>(numIterations, numSteps + 1u);
+  const size_t numSlots = static_cast<size_t>(window) + 1u;
+  UInt64 first = 0u; // the oldest unfinished iteration
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<Task> ready;
+  std::vector<Task> callerReady; // steps for the calling thread
+  std::vector<size_t> numDoneOf(numSlots, 0u);
+  std::exception_ptr error;
+  size_t numRunning = 0u;
+
+  numPending_.resize(numSlots * numSteps);
+  const auto pending = [&](UInt64 iteration, size_t step) -> UInt & {
+    return numPending_[static_cast<size_t>(iteration % numSlots) * numSteps + step];
+  };
+  const auto initIteration = [&](UInt64 iteration) {
+    if (iteration >= numIterations) return;
+    numDoneOf[iteration % numSlots] = 0u;
+    for (size_t s = 0u; s < numSteps; s++) {
+      pending(iteration, s) = schedule_[s].numPrevious +
+                              (iteration > 0u ? schedule_[s].numPreviousIteration : 0u);
+    }
+  };
+  // The steps of an iteration which may now compute, and have no pending steps.
+  const auto readyIteration = [&](UInt64 iteration) {
+    if (iteration >= numIterations) return;
+    for (size_t s = 0u; s < numSteps; s++) {
+      if (pending(iteration, s) == 0u) ready.push_back({iteration, s});
+    }
+  };
+  const auto release = [&](UInt64 iteration, const std::vector<size_t> &steps) {
+    if (iteration >= numIterations) return;
+    for (const auto s : steps) {
+      if (--pending(iteration, s) == 0u and iteration < first + window) {
+        ready.push_back({iteration, s});
+      }
+    }
+  };
+
+  for (UInt64 i = 0u; i <= window; i++) initIteration(i);
+  for (UInt64 i = 0u; i < window; i++) readyIteration(i);
+
+  // Computes a step, then releases the steps waiting for it.
+  const auto compute = [&](const Task task) {
+    const ScheduleStep_ &step = schedule_[task.step];
+    std::exception_ptr failed;
+    try {
+      step.region->prepareInputs();
+      for (const auto link : step.shiftAfterInputs) {
+        link->shiftBufferedData();
+      }
+      if (not step.nextAfterInputs.empty() or not step.nextIterationAfterInputs.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        release(task.iteration, step.nextAfterInputs);
+        release(task.iteration + 1u, step.nextIterationAfterInputs);
+        cv.notify_all();
+      }
+      step.region->compute();
+      for (const auto link : step.shiftAfterCompute) {
+        link->shiftBufferedData();
+      }
+    } catch (...) {
+      failed = std::current_exception();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    numRunning--;
+    if (failed) {
+      if (not error) error = failed;
+    } else {
+      numDoneOf[task.iteration % numSlots]++;
+      release(task.iteration, step.next);
+      release(task.iteration + 1u, step.nextIteration);
+      // Recycle the slots of the finished iterations.
+      while (first < numIterations and numDoneOf[first % numSlots] == numSteps) {
+        first++;
+        initIteration(first + window);
+        readyIteration(first + window - 1u);
+      }
+    }
+    cv.notify_all();
+  };
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (first < numIterations and not (error and numRunning == 0u)) {
+    if (error) {
+      // Start no more steps, wait for the running ones.
+      ready.clear();
+      callerReady.clear();
+    }
+    // Hand the ready steps to the pool, keep one for this thread.
+    for (const auto task : ready) {
+      if (schedule_[task.step].callerOnly or callerReady.empty()) {
+        callerReady.push_back(task);
+      } else {
+        numRunning++;
+        threadPool_->submit([&compute, task]() { compute(task); });
+      }
+    }
+    ready.clear();
+    if (not callerReady.empty()) {
+      const Task task = callerReady.back();
+      callerReady.pop_back();
+      numRunning++;
+      lock.unlock();
+      compute(task);
+      lock.lock();
+    } else {
+      cv.wait(lock, [&]() {
+        return not ready.empty() or first == numIterations or (error and numRunning == 0u);
+      });
+    }
+  }
+  // Every submitted task has finished computing, see numRunning.
+  lock.unlock();
+  if (error) {
+    std::rethrow_exception(error);
+  }
 }
 
 void Network::initialize() {
@@ -475,6 +1294,7 @@ void Network::initialize() {
     std::shared_ptr<Region> r = p.second;
     r->initialize();
   }
+  applyThreadBudget_();
 
   /*
    * 3. Enable all phases in the network
@@ -548,6 +1368,7 @@ void Network::setMinEnabledPhase(UInt32 minPhase) {
               << " which is larger than the highest phase in the network - "
               << phaseInfo_.size() - 1;
   minEnabledPhase_ = minPhase;
+  planValid_ = false;
 }
 
 void Network::setMaxEnabledPhase(UInt32 maxPhase) {
@@ -556,6 +1377,7 @@ void Network::setMaxEnabledPhase(UInt32 maxPhase) {
               << " which is larger than the highest phase in the network - "
               << phaseInfo_.size() - 1;
   maxEnabledPhase_ = maxPhase;
+  planValid_ = false;
 }
 
 UInt32 Network::getMinEnabledPhase() const { return minEnabledPhase_; }
@@ -564,6 +1386,129 @@ UInt32 Network::getMaxEnabledPhase() const { return maxEnabledPhase_; }
 
 
 
+// Write to a temporary file and rename it, so the path never holds a partial checkpoint.
+static bool writeCheckpoint(const std::string &path, const std::function<void(std::ostream&)> &write,
+                            const SerializableFormat fmt) {
+  const std::string tmpPath = path + ".tmp";
+  {
+    std::ios_base::openmode mode = std::ios_base::out | std::ios_base::trunc;
+    if (fmt <= SerializableFormat::PORTABLE) mode |= std::ios_base::binary;
+    std::ofstream out(tmpPath, mode);
+    if (!out.is_open()) return false;
+    out.precision(std::numeric_limits<float>::digits10 + 1);
+    write(out);
+    out.close();
+    if (out.fail()) return false;
+  }
+#if defined(NTA_OS_WINDOWS)
+  std::remove(path.c_str()); // rename does not replace an existing file
+#endif
+  return std::rename(tmpPath.c_str(), path.c_str()) == 0;
+}
+
+std::future<void> Network::saveAsync(const std::string &path, SerializableFormat fmt) const {
+  const std::string dir = Path::getParent(path);
+  if (!dir.empty())
+    Directory::create(dir, true, true);
+
+  // Serialize on the calling thread, the network must not change meanwhile;
+  // only the file is written in the background.
+  auto snapshot = std::make_shared<std::string>();
+  {
+    std::ostringstream ss;
+    save(ss, fmt);
+    *snapshot = ss.str();
+  }
+  return std::async(std::launch::async, [snapshot, path, fmt]() {
+    const bool ok = writeCheckpoint(path, [&](std::ostream &out) {
+      out.write(snapshot->data(), static_cast<std::streamsize>(snapshot->size()));
+    }, fmt);
+    NTA_CHECK(ok) << "Network::saveAsync: can not save the network to " << path;
+  });
+}
+
+
+// Run fn(i) for each region, in parallel on the pool except for the python regions.
+static void forEachRegion(ThreadPool *pool, const std::vector<std::string> &types,
+                          const std::function<void(size_t)> &fn) {
+  std::vector<size_t> parallel;
+  for (size_t i = 0u; i < types.size(); i++) {
+    if (types[i].compare(0u, 3u, "py.") == 0)
+      fn(i); // python holds the GIL
+    else
+      parallel.push_back(i);
+  }
+  if (pool == nullptr) {
+    for (const auto i : parallel) fn(i);
+    return;
+  }
+  pool->parallelFor(parallel.size(), [&](size_t begin, size_t end, size_t) {
+    for (size_t k = begin; k < end; k++) fn(parallel[k]);
+  }, parallel.size());
+}
+
+void Network::saveToChunkedFile(const std::string &path, const bool compress) const {
+  const ChunkCodec codec = compress ? ChunkCodec::LZ : ChunkCodec::NONE;
+  std::vector<std::shared_ptr<Region>> regions;
+  std::vector<std::string> types;
+  for (const auto &p : regions_) {
+    regions.push_back(p.second);
+    types.push_back(p.second->getType());
+  }
+  std::vector<Chunk> chunks(regions.size() + 1u);
+  {
+    std::ostringstream ss(std::ios_base::out | std::ios_base::binary);
+    {
+      cereal::BinaryOutputArchive ar(ss);
+      const std::vector<std::shared_ptr<Link>> links = getLinks();
+      const std::string phases = phasesToString();
+      ar(iteration_, types, links, phases);
+    }
+    chunks[0].name = "Network";
+    chunks[0].pack(ss.str(), codec);
+  }
+  forEachRegion(threadPool_.get(), types, [&](size_t i) {
+    std::ostringstream ss(std::ios_base::out | std::ios_base::binary);
+    regions[i]->save(ss, SerializableFormat::BINARY);
+    chunks[i + 1u].name = regions[i]->getName();
+    chunks[i + 1u].pack(ss.str(), codec);
+  });
+  writeChunkFile(path, chunks);
+}
+
+void Network::loadFromChunkedFile(const std::string &path, const bool lazy) {
+  const std::vector<Chunk> chunks = readChunkFile(path);
+  NTA_CHECK(!chunks.empty() && chunks[0].name == "Network")
+      << "Network::loadFromChunkedFile: " << path << " is not a Network";
+  std::vector<std::string> types;
+  std::vector<std::shared_ptr<Link>> links;
+  std::string phases;
+  {
+    std::istringstream ss(chunks[0].unpack(), std::ios_base::in | std::ios_base::binary);
+    cereal::BinaryInputArchive ar(ss);
+    ar(iteration_, types, links, phases);
+  }
+  NTA_CHECK(types.size() + 1u == chunks.size())
+      << "Network::loadFromChunkedFile: " << path << " is corrupt";
+
+  std::vector<std::shared_ptr<Region>> regions(types.size());
+  forEachRegion(threadPool_.get(), types, [&](size_t i) {
+    regions[i] = std::make_shared<Region>(this);
+    if (lazy) {
+      regions[i]->loadLazy_(std::make_shared<const std::string>(chunks[i + 1u].unpack()));
+      return;
+    }
+    std::istringstream ss(chunks[i + 1u].unpack(), std::ios_base::in | std::ios_base::binary);
+    regions[i]->load(ss, SerializableFormat::BINARY);
+  });
+  regions_.clear();
+  for (const auto &r : regions) regions_[r->getName()] = r;
+
+  post_load(links);
+  phasesFromString(phases);
+}
+
+
 void Network::post_load(std::vector<std::shared_ptr<Link>>& links) {
     for(auto alink: links) {
       auto l = link( alink->getSrcRegionName(),
@@ -579,9 +1524,11 @@ void Network::post_load(std::vector<std::shared_ptr<Link>>& links) {
 
 void Network::post_load() {
   // Post Load operations
+  planValid_ = false;
   for(auto p: regions_) {
     std::shared_ptr<Region>& r = p.second;
     r->network_ = this;
+    r->setTracer(tracing_ ? tracer_.get() : nullptr);
     r->evaluateLinks();      // Create the input buffers.
   }
 
@@ -681,6 +1628,7 @@ void Network::phasesFromString(const std::string& phaseString) {
 
 
 void Network::enableProfiling() {
+  profiling_ = true;
   for (auto p: regions_) {
     std::shared_ptr<Region> r = p.second;
     r->enableProfiling();
@@ -688,6 +1636,7 @@ void Network::enableProfiling() {
 }
 
 void Network::disableProfiling() {
+  profiling_ = false;
   for (auto p: regions_) {
     std::shared_ptr<Region> r = p.second;
     r->disableProfiling();
@@ -695,12 +1644,84 @@ void Network::disableProfiling() {
 }
 
 void Network::resetProfiling() {
+  for (auto &stage : stageProfile_) {
+    stage.reset();
+  }
   for (auto p: regions_) {
     std::shared_ptr<Region>  r = p.second;
     r->resetProfiling();
   }
 }
 
+const LatencyHistogram &Network::getStageProfile(ProfileStage stage) const {
+  NTA_CHECK(static_cast<size_t>(stage) < stageProfile_.size()) << "getStageProfile: unknown stage " << stage;
+  return stageProfile_[stage];
+}
+
+std::string Network::getProfileReport() const {
+  static const char *stageNames[Stage_NumStages] = {"iteration", "inputs", "compute",
+                                                    "callbacks", "shifts"};
+  std::stringstream ss;
+  ss << "{\"stages\": {";
+  for (int stage = 0; stage < Stage_NumStages; stage++) {
+    ss << (stage == 0 ? "" : ", ") << "\"" << stageNames[stage] << "\": "
+       << stageProfile_[stage].toJSON();
+  }
+  ss << "},\n \"regions\": {";
+  bool first = true;
+  for (const auto &r : regions_) {
+    ss << (first ? "" : ", ") << "\"" << r.first << "\": {\"compute\": "
+       << r.second->getComputeHistogram().toJSON()
+       << ", \"execute\": " << r.second->getExecuteTimer().getElapsed() << "}";
+    first = false;
+  }
+  ss << "},\n \"links\": {";
+  first = true;
+  for (const auto &r : regions_) {
+    for (const auto &input : r.second->getInputs()) {
+      for (const auto &link : input.second->getLinks()) {
+        const Link::Profile &profile = link->getProfile();
+        ss << (first ? "" : ", ") << "\"" << link->getMoniker() << "\": {"
+           << "\"shared\": " << profile.shared << ", \"copies\": " << profile.copies
+           << ", \"conversions\": " << profile.conversions << ", \"bytes\": " << profile.bytes
+           << ", \"seconds\": " << profile.timer.getElapsed() << "}";
+        first = false;
+      }
+    }
+  }
+  ss << "}}";
+  return ss.str();
+}
+
+void Network::enableTracing(size_t capacity) {
+  if (tracer_ == nullptr)
+    tracer_.reset(new Tracer(capacity));
+  else
+    tracer_->reset(capacity);
+  tracing_ = true;
+  for (const auto &r : regions_) {
+    r.second->setTracer(tracer_.get());
+  }
+}
+
+void Network::disableTracing() {
+  tracing_ = false;
+  for (const auto &r : regions_) {
+    r.second->setTracer(nullptr);
+  }
+}
+
+std::string Network::getTrace() const {
+  return tracer_ == nullptr ? Tracer(1u).toJSON() : tracer_->toJSON();
+}
+
+void Network::saveTrace(const std::string &path) const {
+  if (tracer_ == nullptr)
+    Tracer(1u).saveToFile(path);
+  else
+    tracer_->saveToFile(path);
+}
+
   /*
    * Adds a region to the RegionImplFactory's list of packages
    */
@@ -22,19 +22,27 @@
 #ifndef NTA_NETWORK_HPP
 #define NTA_NETWORK_HPP
 
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <future>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
 
 #include <htm/engine/Region.hpp>
 #include <htm/engine/Link.hpp>
+#include <htm/engine/Tracer.hpp>
 #include <htm/ntypes/Collection.hpp>
 
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/utils/Log.hpp>
+#include <htm/utils/ThreadPool.hpp>
 
 namespace htm {
 
@@ -115,6 +123,9 @@ public:
    *    ]}
 
    *  On errors it throws an exception.
+   *
+   *  To build many networks from the same yaml, parse it once into a
+   *  NetworkTemplate and call its create().
    */
   void configure(const std::string &yaml);
 
@@ -182,6 +193,41 @@ public:
     phasesFromString(phases);
   }
 
+  /**
+   * Save the network to a file without blocking the caller for the file
+   * I/O.  The network is serialized into memory first (a brief pause, it
+   * must not run meanwhile) and written to the file on a background thread,
+   * while the caller continues to run the network.
+   *
+   * The file is written under a temporary name and renamed when complete,
+   * so `path` always holds a complete checkpoint.  Call it between runs,
+   * not while a pipelined run() is in progress.
+   *
+   * @returns a future which completes when the file is written, get()
+   *          throws if the save failed.  Destroying the future waits for
+   *          the save.
+   */
+  std::future<void> saveAsync(const std::string &path,
+                              SerializableFormat fmt = SerializableFormat::BINARY) const;
+
+  /**
+   * Save the network into a chunked file (see ChunkFile.hpp): the links
+   * and phases, and each region are independent chunks.  The regions are
+   * serialized and compressed in parallel on the threads of
+   * setNumThreads(), loadFromChunkedFile() decompresses and deserializes
+   * them in parallel.  Python regions are serialized on the calling thread.
+   *
+   * @param compress LZ compress the chunks, see lzCompress().
+   *
+   * With `lazy` the topology, Specs, dimensions and output buffers load
+   * right away, but each RegionImpl (the algorithm and its state) is
+   * deserialized from the kept chunk only on first use: the first run(),
+   * parameter access or command on the region.  Until then the region
+   * holds its decompressed archive instead.
+   */
+  void saveToChunkedFile(const std::string &path, bool compress = true) const;
+  void loadFromChunkedFile(const std::string &path, bool lazy = false);
+
   /**
    * @}
    *
@@ -372,6 +418,220 @@ public:
    */
   void run(int n);
 
+  /**
+   * Run the network without blocking the caller: run(n) is queued on an
+   * executor of hardware-concurrency threads shared by all networks, so
+   * many networks can be run concurrently without a thread per run.
+   *
+   * The network must not be changed, run or destroyed until the run is
+   * complete.
+   *
+   * @param done Optional, called on the executor thread when the run is
+   *        complete, with the exception of run() or nullptr.
+   * @returns a future which completes with the run, get() rethrows the
+   *          exception of run().
+   */
+  std::future<void> runAsync(int n, std::function<void(std::exception_ptr)> done = nullptr);
+
+  /**
+   * Run the network with a latency budget for the computes of each
+   * iteration, shedding optional work where the budget would be exceeded.
+   *
+   * The regions compute one after the other in phase order, the threads of
+   * setNumThreads() are not used.  Before each region computes, the time
+   * left in the iteration is compared with the expected time of the
+   * remaining computes, a moving average of their recent ones.  If they do
+   * not fit, the region sheds optional work (@see RegionImpl::ShedLevel):
+   * it defers the maintenance of its Connections; if they need over twice
+   * the time left it also skips its optional outputs; over four times, or
+   * once the budget is spent, it also does not learn in this iteration.
+   * The shed computes and the iterations over budget are counted in the
+   * Metrics.
+   *
+   * @param budget Seconds for the computes of each iteration, > 0.
+   * @param n Number of iterations
+   */
+  void runWithDeadline(Real64 budget, int n = 1);
+
+  /**
+   * Set the learn duty cycle of a region, to reduce the cost of learning
+   * when the machine is loaded.  The region computes every iteration, but
+   * learns only in the iterations whose number is a multiple of @param
+   * every, or when the "anomaly" output of @param anomalyRegion is at least
+   * @param anomalyThreshold.  The anomaly is the one of the previous
+   * iteration, as the region computes before the anomaly of this one is
+   * known.
+   *
+   * The region must support shedding its learning, @see
+   * RegionImpl::setShedLevel(); SPRegion and TMRegion do.  The skipped
+   * learning is counted in the Metrics.  Pipelined runs are disabled while
+   * a duty cycle is set, @see setPipelined().
+   *
+   * This is a runtime setting, it is not serialized.
+   *
+   * @param region The region name.
+   * @param every Learn every Nth iteration, 0 to learn only on anomalies.
+   *              1 without an anomalyThreshold removes the duty cycle.
+   * @param anomalyThreshold Learn when the anomaly is at least this, < 0 for
+   *                         no threshold.
+   * @param anomalyRegion The region of the "anomaly" output, a Real32.
+   *                      Empty for the region itself.
+   */
+  void setLearnDutyCycle(const std::string &region, UInt every,
+                         Real32 anomalyThreshold = -1.0f,
+                         const std::string &anomalyRegion = "");
+
+  /**
+   * Run the network once per record, in one call.
+   *
+   * Before each iteration the next row of `records` is written, with
+   * conversion, into the source Output.  The source region does not compute
+   * during runBatch(), its Output holds the record.  After each iteration
+   * the chosen Outputs are copied into a row of their result.
+   *
+   * @param source  "<region>.<output>" which receives the records.
+   * @param records The records, one row per iteration.  The number of
+   *        elements is a multiple of the element count of the source Output.
+   *        Not an SDR or String Array.
+   * @param outputs "<region>.<output>" of the Outputs to collect.
+   * @param results One Array per Output, with a row per record, of the type
+   *        of the Output.  SDR results have dimensions [numRecords, <Output
+   *        dimensions>] and are filled from the active bits.  Results of the
+   *        right type and size are reused, otherwise they are allocated.
+   */
+  void runBatch(const std::string &source, const Array &records,
+                const std::vector<std::string> &outputs,
+                std::vector<Array> &results);
+
+  /**
+   * Set the number of threads which run() uses to compute the regions,
+   * including the calling thread.  Use 0 for all hardware threads.
+   *
+   * With 1 thread (the default) the regions compute one after the other in
+   * phase order.  With more threads the regions are scheduled by their
+   * links: a region computes as soon as the regions linked to it (without
+   * propagation delay) which precede it in phase order have computed, and
+   * before the linked regions which follow it.  Independent chains of
+   * regions, ex: several encoder -> SP -> TM chains, compute concurrently.
+   * The results are the same as with 1 thread, as long as regions which are
+   * not linked do not share any state.  Python regions always compute on
+   * the calling thread.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setNumThreads(UInt numThreads);
+  UInt getNumThreads() const { return numThreads_; }
+
+  /**
+   * Set the number of cores the network may use, split between the
+   * scheduling of the regions (see setNumThreads()) and the kernels within
+   * the regions.  Each region which supports it (ex: SPRegion, TMRegion with
+   * parameter numThreads 0) gets max(1, numThreads / getNumThreads())
+   * threads.  Use 0 for all hardware threads.
+   *
+   * Without a budget (the default) the regions compute on 1 thread, unless
+   * their own numThreads parameter says otherwise.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setThreadBudget(UInt numThreads);
+  UInt getThreadBudget() const { return threadBudget_; }
+
+  /**
+   * Pin the threads which run() uses to a set of cores: the calling thread
+   * while it is in run(), and the threads of setNumThreads().  The empty set
+   * (the default) leaves the placement to the OS.  With setNumThreads(1) and
+   * a single core the whole run stays on that core, which keeps the
+   * Connections of the regions in its caches.
+   *
+   * Regions may have their own cores, @see Region::setAffinity().
+   * Nothing is pinned on platforms without support, @see ThreadAffinity.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setAffinity(const std::vector<UInt> &cores);
+  const std::vector<UInt> &getAffinity() const { return affinity_; }
+
+  /**
+   * Pin the threads of run() to the cores of a NUMA node, @see setAffinity().
+   * Throws if the cores of the node are unknown.
+   */
+  void setNumaNode(UInt node);
+
+  /**
+   * Estimate the heap memory held by the network, in bytes: the sum of
+   * Region::memoryUsage() over all regions.
+   */
+  size_t memoryUsage() const;
+
+  /**
+   * Set a soft limit on memoryUsage().  run() checks the usage every
+   * @param checkPeriod iterations, and if the network exceeds the limit, the
+   * regions release what they can without changing their results, largest
+   * region first, until the network is below the limit (ex: the TMRegion
+   * compacts the Connections of its TM, @see TemporalMemory::compact).
+   * The limit is soft: the network keeps running above it.
+   *
+   * @param bytes The limit, 0 (the default) for none.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setMemoryLimit(size_t bytes, UInt checkPeriod = 100u);
+  size_t getMemoryLimit() const { return memoryLimit_; }
+
+  /**
+   * Let run(n) with several threads overlap the iterations.
+   *
+   * A region computes iteration t+1 as soon as the regions linked to it
+   * are done with its output of iteration t.  Over a link with propagation
+   * delay the destination region reads an older output, which is kept in the
+   * delay buffer of the link, so the source region computes the next
+   * iteration while the destination region computes this one.  For a chain
+   * of regions linked with delays the throughput approaches that of the
+   * slowest region instead of the sum of all of them.  The results are the
+   * same as without pipelining.
+   *
+   * The iterations overlap only when no callbacks are registered and every
+   * region computes in the enabled phases, otherwise run() computes one
+   * iteration after the other.  The iteration count advances when run()
+   * returns.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setPipelined(bool pipelined) { pipelined_ = pipelined; }
+  bool isPipelined() const { return pipelined_; }
+
+  /**
+   * A copy of the published outputs, taken at the end of an iteration.
+   * The map is keyed by "<region>.<output>".
+   */
+  struct OutputSnapshot {
+    UInt64 iteration = 0u;
+    std::map<std::string, Array> outputs;
+  };
+
+  /**
+   * Publish an output, "<region>.<output>", in the snapshot which
+   * getOutputSnapshot() returns.  Publishing an output twice has no effect.
+   */
+  void publishOutput(const std::string &name);
+
+  /**
+   * The outputs published at the end of the last iteration of run().
+   *
+   * Other threads may call this while run() computes the next iteration:
+   * the snapshot is swapped atomically at the end of each iteration, so it
+   * is never partly written, and the readers do not block run().  The
+   * snapshot a reader holds is not modified; run() copies into a spare
+   * snapshot which no reader holds.  With setPipelined() the snapshot is
+   * taken when run() returns.
+   *
+   * @returns nullptr until an iteration ran with published outputs.
+   */
+  std::shared_ptr<const OutputSnapshot> getOutputSnapshot() const {
+    return std::atomic_load(&snapshot_);
+  }
+
   /**
    * The type of run callback function.
    *
@@ -405,7 +665,8 @@ public:
    */
 
   /**
-   * Start profiling for all regions of this network.
+   * Start profiling for all regions of this network, their links, and the
+   * stages of the iterations of run().
    */
   void enableProfiling();
 
@@ -418,6 +679,117 @@ public:
    * Reset profiling timers for all regions of this network.
    */
   void resetProfiling();
+
+  /**
+   * The stages of an iteration of run() which are profiled, each with a
+   * histogram of its time per iteration, @see getStageProfile().
+   *   Stage_Iteration   the whole iteration
+   *   Stage_Inputs      the links copying into the inputs of the regions
+   *   Stage_Compute     the compute of the regions
+   *   Stage_Callbacks   the callbacks, @see getCallbacks()
+   *   Stage_Shifts      the shift of the delayed links
+   * With threads (@see setNumThreads()) or async regions the inputs and computes
+   * overlap, their time is all counted in Stage_Compute.  Pipelined runs,
+   * whose iterations overlap, are not recorded in the stages.
+   */
+  enum ProfileStage { Stage_Iteration = 0, Stage_Inputs, Stage_Compute, Stage_Callbacks,
+                      Stage_Shifts, Stage_NumStages };
+  const LatencyHistogram &getStageProfile(ProfileStage stage) const;
+
+  /**
+   * The profile as JSON:
+   *   {"stages": {"iteration": H, "inputs": H, "compute": H, "callbacks": H, "shifts": H},
+   *    "regions": {"<region>": {"compute": H, "execute": seconds}, ...},
+   *    "links": {"<link>": {"shared": n, "copies": n, "conversions": n,
+   *                         "bytes": n, "seconds": s}, ...}}
+   * where H is @see LatencyHistogram::toJSON(), with the p50 and p99 per
+   * iteration.  Links are named by Link::getMoniker().
+   */
+  std::string getProfileReport() const;
+
+  /**
+   * @}
+   *
+   * @name Tracing
+   *
+   * @{
+   */
+
+  /**
+   * Record a timeline of the following runs: the begin and end of every
+   * iteration, region compute and link transfer, with the thread of each.
+   * The last @param capacity events are kept, the events of earlier runs
+   * are dropped.  @see Tracer
+   */
+  void enableTracing(size_t capacity = 65536u);
+
+  /**
+   * Stop recording; the trace remains until the next enableTracing().
+   */
+  void disableTracing();
+
+  bool isTracing() const { return tracing_; }
+
+  /**
+   * The trace in the Chrome Trace Event JSON format, for chrome://tracing
+   * or the Perfetto UI.  Empty of events if tracing was never enabled.
+   */
+  std::string getTrace() const;
+
+  /**
+   * Write getTrace() to the file @param path.
+   */
+  void saveTrace(const std::string &path) const;
+
+  /**
+   * @}
+   *
+   * @name Metrics
+   *
+   * @{
+   */
+
+  /**
+   * Counters of the runs of a network, for monitoring.  run() updates them
+   * at its end; they are atomics, so another thread reads them without
+   * locking the network, eg. a metrics endpoint scraping many networks.
+   * The Connections sizes are the sums over the regions, @see
+   * Region::getConnections().  The memory usage is refreshed every
+   * setMemoryCheckPeriod() iterations.
+   */
+  struct Metrics {
+    Metrics();
+
+    // The upper bounds, in seconds, of the buckets of the run latencies.
+    // The last bucket, runBuckets[NumRunBuckets], is unbounded.
+    static const size_t NumRunBuckets = 16u;
+    static const Real64 RunBucketBounds[NumRunBuckets];
+
+    std::atomic<UInt64> iterations;
+    std::atomic<UInt64> runs;
+    std::atomic<UInt64> runNanoseconds;  // the sum of the run latencies
+    std::atomic<UInt64> runBuckets[NumRunBuckets + 1u];
+    std::atomic<UInt64> segments;
+    std::atomic<UInt64> synapses;
+    std::atomic<UInt64> prunedSegments;
+    std::atomic<UInt64> prunedSynapses;
+    std::atomic<UInt64> memoryBytes;
+    // Region computes of runWithDeadline() by the level they shed.
+    std::atomic<UInt64> shedMaintenance;
+    std::atomic<UInt64> shedOutputs;
+    std::atomic<UInt64> shedLearning;
+    std::atomic<UInt64> deadlineMisses;  // iterations over the budget
+    // Region computes which did not learn for setLearnDutyCycle().
+    std::atomic<UInt64> learnSkipped;
+  };
+
+  std::shared_ptr<const Metrics> getMetrics() const { return metrics_; }
+
+  /**
+   * Update @param metrics instead, eg. to keep counting across the
+   * save and reload of a network.
+   */
+  void setMetrics(std::shared_ptr<Metrics> metrics);
 	
   /**
    * Set one of the debug levels: LogLevel_None = 0, LogLevel_Minimal, LogLevel_Normal, LogLevel_Verbose
@@ -492,6 +864,50 @@ private:
   std::string phasesToString() const;
   void phasesFromString(const std::string& phaseString);
 
+  // run(n), the source region does not compute but is fed before each
+  // iteration, and outputs are collected after each iteration, see runBatch().
+  void run_(int n, const Region *source, const std::function<void(int)> &feed,
+            const std::function<void(int)> &collect);
+
+  // One compute of a region in the plan of a single threaded run().
+  struct PlanStep_ {
+    Region *region;
+    std::vector<Input *> inputs;
+    bool prefetched;  // an async region, computed ahead on the I/O thread
+    std::vector<size_t> prefetchAfter; // async steps whose readers are done after this step
+  };
+  // Flattens the enabled phases and the delayed links, so that run() does
+  // not walk the maps of regions and inputs on every iteration.  Rebuilt
+  // after the regions, links or enabled phases change.
+  // An async region (see Spec::async) without incoming links computes its
+  // next iteration as soon as the last region reading its outputs computed.
+  void buildPlan_(const Region *source);
+
+  // One compute of a region in the schedule of run() with several threads.
+  // A region in several phases computes once per phase.
+  struct ScheduleStep_ {
+    Region *region;
+    bool callerOnly;          // python regions compute on the calling thread
+    UInt numPrevious;         // steps of this iteration which must complete first
+    UInt numPreviousIteration; // steps of the previous iteration which must complete first
+    std::vector<size_t> next; // steps which wait for this one
+    std::vector<size_t> nextAfterInputs; // steps which wait for the inputs of this one
+    std::vector<size_t> nextIteration; // steps of the next iteration which wait for this one
+    std::vector<size_t> nextIterationAfterInputs;
+    std::vector<Link *> shiftAfterInputs;  // delayed links shifted by this step
+    std::vector<Link *> shiftAfterCompute;
+  };
+  // Dependencies of the enabled phases, from the links without delay.
+  // When pipelined, also across iterations and from the delayed links.
+  void buildSchedule_(const Region *source = nullptr);
+  // Some iterations of the schedule.
+  void runSchedule_(UInt64 numIterations);
+  // Copy the published outputs and swap the snapshot.
+  void publishSnapshot_();
+  void applyThreadBudget_();
+  void checkMemoryLimit_();
+  void updateMetrics_(UInt64 iterations, std::chrono::steady_clock::duration elapsed);
+
   bool initialized_;
 	
 	/**
@@ -514,6 +930,49 @@ private:
 
   // number of elapsed iterations
   UInt64 iteration_;
+
+  std::vector<PlanStep_> plan_;
+  std::vector<Link *> planShifts_; // the links with a propagation delay
+  const Region *planSource_ = nullptr;
+  bool planValid_ = false;
+  bool planPrefetch_ = false; // some steps are prefetched
+  Real64 deadlineBudget_ = 0.0; // seconds, during runWithDeadline()
+  std::vector<Real64> stepSeconds_; // moving average of the compute of each step
+  // The computes of one iteration of runWithDeadline().
+  void computeWithDeadline_();
+  struct LearnDuty_ {
+    UInt every;
+    Real32 anomalyThreshold;
+    std::string anomalyRegion;
+    UInt level; // the shed level of the region in this iteration
+  };
+  std::map<std::string, LearnDuty_> learnDuty_; // by region, setLearnDutyCycle()
+  // Decide which regions learn in this iteration, before they compute.
+  void applyLearnDuty_(bool deadline);
+  void releaseLearnDuty_();
+  std::shared_ptr<ThreadPool> ioPool_; // computes the async regions ahead
+
+  std::vector<std::pair<std::string, std::shared_ptr<Output>>> published_;
+  std::shared_ptr<const OutputSnapshot> snapshot_; // read with std::atomic_load
+  std::shared_ptr<OutputSnapshot> spareSnapshot_;
+
+  UInt numThreads_ = 1u;
+  UInt threadBudget_ = 0u; // 0 if not set
+  std::vector<UInt> affinity_; // cores of run(), empty if not pinned
+  size_t memoryLimit_ = 0u; // 0 if not set
+  UInt memoryCheckPeriod_ = 100u;
+  UInt64 nextMemoryCheck_ = 0u; // iteration_ of the next check
+  bool pipelined_ = false;
+  bool profiling_ = false;
+  std::vector<LatencyHistogram> stageProfile_ = std::vector<LatencyHistogram>(Stage_NumStages);
+  bool tracing_ = false;
+  std::unique_ptr<Tracer> tracer_; // kept while not tracing, the regions keep its name ids
+  std::shared_ptr<Metrics> metrics_ = std::make_shared<Metrics>();
+  UInt64 nextMetricsMemory_ = 0u; // iteration_ of the next memoryUsage() for the metrics
+  bool pipelineSchedule_ = false; // the schedule_ overlaps the iterations
+  std::shared_ptr<ThreadPool> threadPool_;
+  std::vector<ScheduleStep_> schedule_;
+  std::vector<UInt> numPending_; //reused scratch
 };
 
 } // namespace htm
@@ -0,0 +1,183 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the NetworkExecutor class.
+ */
+
+#include <chrono>
+
+#include <htm/engine/NetworkExecutor.hpp>
+#include <htm/utils/Log.hpp>
+#include <htm/utils/ThreadPool.hpp>
+
+using namespace htm;
+
+
+NetworkExecutor::NetworkExecutor(size_t numThreads) {
+  if (numThreads == 0u) numThreads = ThreadPool::hardwareConcurrency();
+  home_.resize(numThreads);
+  for (size_t t = 0u; t < numThreads; t++) {
+    queues_.emplace_back(new Queue_());
+  }
+  // The thread calling run() is thread 0.
+  workers_.reserve(numThreads - 1u);
+  for (size_t t = 1u; t < numThreads; t++) {
+    workers_.emplace_back([this, t]() { workerLoop_(t); });
+  }
+}
+
+
+NetworkExecutor::~NetworkExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+
+size_t NetworkExecutor::add(std::shared_ptr<Network> network, Int affinity) {
+  NTA_CHECK(network != nullptr) << "NetworkExecutor::add: null network";
+  NTA_CHECK(affinity < static_cast<Int>(home_.size()))
+      << "NetworkExecutor::add: affinity " << affinity << " but only "
+      << home_.size() << " threads";
+  size_t thread;
+  if (affinity < 0) {
+    thread = nextHome_;
+    nextHome_ = (nextHome_ + 1u) % home_.size();
+  } else {
+    thread = static_cast<size_t>(affinity);
+  }
+  const size_t index = networks_.size();
+  networks_.push_back(std::move(network));
+  cost_.push_back(0.0);
+  home_[thread].push_back(index);
+  return index;
+}
+
+
+void NetworkExecutor::clear() {
+  networks_.clear();
+  cost_.clear();
+  for (auto &home : home_) home.clear();
+  nextHome_ = 0u;
+}
+
+
+void NetworkExecutor::makeBatches_() {
+  for (size_t t = 0u; t < home_.size(); t++) {
+    const auto &home = home_[t];
+    auto &queue = *queues_[t];
+    queue.batches.clear();
+    queue.next = 0u;
+    size_t begin = 0u;
+    Real64 cost = 0.0;
+    for (size_t i = 0u; i < home.size(); i++) {
+      const Real64 c = cost_[home[i]];
+      // A network not measured yet, or expensive, is a batch of its own.
+      if (c == 0.0 || c >= batchMicroseconds_) {
+        if (begin < i) queue.batches.push_back({begin, i});
+        queue.batches.push_back({i, i + 1u});
+        begin = i + 1u;
+        cost = 0.0;
+        continue;
+      }
+      cost += c;
+      if (cost >= batchMicroseconds_) {
+        queue.batches.push_back({begin, i + 1u});
+        begin = i + 1u;
+        cost = 0.0;
+      }
+    }
+    if (begin < home.size()) queue.batches.push_back({begin, home.size()});
+  }
+}
+
+
+void NetworkExecutor::work_(size_t thread) {
+  const size_t numThreads = queues_.size();
+  // Run the own batches first, then steal from the next threads.
+  for (size_t k = 0u; k < numThreads; k++) {
+    const size_t t = (thread + k) % numThreads;
+    auto &queue = *queues_[t];
+    for (;;) {
+      const size_t b = queue.next.fetch_add(1u);
+      if (b >= queue.batches.size()) break;
+      const Batch_ &batch = queue.batches[b];
+      for (size_t i = batch.begin; i < batch.end; i++) {
+        const size_t index = home_[t][i];
+        const auto start = std::chrono::steady_clock::now();
+        try {
+          networks_[index]->run(iterations_);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (!error_) error_ = std::current_exception();
+        }
+        const Real64 us = std::chrono::duration<Real64, std::micro>(
+                              std::chrono::steady_clock::now() - start).count();
+        // Each network runs on one thread per round, so this is race free.
+        Real64 &cost = cost_[index];
+        cost = (cost == 0.0) ? us : 0.75 * cost + 0.25 * us;
+      }
+    }
+  }
+}
+
+
+void NetworkExecutor::workerLoop_(size_t thread) {
+  UInt64 seen = 0u;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      start_.wait(lock, [this, seen]() { return stop_ || round_ != seen; });
+      if (stop_) return;
+      seen = round_;
+    }
+    work_(thread);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (--numWorking_ == 0u) done_.notify_one();
+    }
+  }
+}
+
+
+void NetworkExecutor::run(int n) {
+  if (networks_.empty()) return;
+  iterations_ = n;
+  makeBatches_();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    error_ = nullptr;
+    numWorking_ = workers_.size();
+    ++round_;
+  }
+  start_.notify_all();
+  work_(0u);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this]() { return numWorking_ == 0u; });
+  if (error_) {
+    std::exception_ptr error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
@@ -0,0 +1,159 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Interface for the NetworkExecutor class
+ */
+
+#ifndef NTA_NETWORK_EXECUTOR_HPP
+#define NTA_NETWORK_EXECUTOR_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <htm/engine/Network.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * NetworkExecutor - runs many small networks on a set of threads.
+ *
+ * @b Description
+ * Each network has a home thread, which runs it unless it is idle
+ * elsewhere, so the data of a network (ex: the Connections of its TM) stays
+ * warm in the cache of the core of that thread.  A thread which ran out of
+ * work steals batches from the other threads.
+ *
+ * Cheap networks are run in batches, so that scheduling costs little next
+ * to the work.  The cost of each network is measured on every run.
+ *
+ * A network belongs to one executor at a time, and must not be run
+ * elsewhere while the executor runs it.
+ *
+ * Example Usage:
+ *    NetworkExecutor executor(8);
+ *    for(auto &net : networks) executor.add(net);
+ *    while(...) {
+ *      // set the inputs of the networks
+ *      executor.run(1);
+ *      // read the outputs of the networks
+ *    }
+ */
+class NetworkExecutor {
+public:
+  /**
+   * @param numThreads Number of threads which run the networks, including
+   *        the thread calling run().  The value 0 means use all hardware threads.
+   */
+  explicit NetworkExecutor(size_t numThreads = 0);
+
+  ~NetworkExecutor();
+
+  NetworkExecutor(const NetworkExecutor&) = delete;
+  NetworkExecutor& operator=(const NetworkExecutor&) = delete;
+
+  /**
+   * Add a network.
+   *
+   * @param network The network to run.
+   * @param affinity The index of the home thread of the network, in
+   *        [0, getNumThreads()).  The default -1 spreads the networks
+   *        round robin.
+   *
+   * @returns the index of the network in the executor.
+   */
+  size_t add(std::shared_ptr<Network> network, Int affinity = -1);
+
+  /**
+   * Remove all the networks.
+   */
+  void clear();
+
+  /**
+   * @returns the number of networks.
+   */
+  size_t size() const { return networks_.size(); }
+
+  /**
+   * @returns the network at the index returned by add().
+   */
+  Network &getNetwork(size_t index) const { return *networks_.at(index); }
+
+  /**
+   * @returns the number of threads, including the thread calling run().
+   */
+  size_t getNumThreads() const { return workers_.size() + 1u; }
+
+  /**
+   * Networks which take less than this many microseconds per run are
+   * batched together, until a batch takes about this long.  Default 50.
+   */
+  void setBatchMicroseconds(Real64 microseconds) { batchMicroseconds_ = microseconds; }
+  Real64 getBatchMicroseconds() const { return batchMicroseconds_; }
+
+  /**
+   * Call Network::run(n) on every network, and wait until all finished.
+   * If some networks throw, the others still run and the first exception is
+   * re-thrown.
+   */
+  void run(int n);
+
+private:
+  // A range of home_[t] of the thread t, run together.
+  struct Batch_ {
+    size_t begin;
+    size_t end;
+  };
+  // The work of one thread in a run().
+  struct Queue_ {
+    std::vector<Batch_> batches;
+    std::atomic<size_t> next{0u}; // the next batch to take, by the owner or a thief
+  };
+
+  void makeBatches_();
+  void work_(size_t thread);
+  void workerLoop_(size_t thread);
+
+  // home_[t] are the indexes in networks_ of the networks of thread t.
+  std::vector<std::shared_ptr<Network>> networks_;
+  std::vector<std::vector<size_t>> home_;
+  std::vector<Real64> cost_; // microseconds per run, of each network, 0 if unknown
+  size_t nextHome_ = 0u;
+  Real64 batchMicroseconds_ = 50.0;
+
+  std::vector<std::unique_ptr<Queue_>> queues_;
+  int iterations_ = 0;
+
+  std::vector<std::thread> workers_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  UInt64 round_ = 0u;        // incremented by run(), wakes the workers
+  size_t numWorking_ = 0u;   // workers not done with the current round
+  bool stop_ = false;
+  std::exception_ptr error_;
+};
+
+} // namespace htm
+
+#endif // NTA_NETWORK_EXECUTOR_HPP
@@ -0,0 +1,117 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the NetworkTemplate class
+ */
+
+#include <set>
+
+#include <htm/engine/NetworkTemplate.hpp>
+#include <htm/engine/RegionImplFactory.hpp>
+#include <htm/os/Path.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+NetworkTemplate::NetworkTemplate(const std::string &yaml) {
+  ValueMap vm;
+  vm.parse(yaml);
+
+  NTA_CHECK(vm.isMap() && vm.contains("network")) << "Expected yaml string to start with 'network:'.";
+  Value &v1 = vm["network"];
+  NTA_CHECK(v1.isSequence()) << "Expected a sequence of entries starting with a command.";
+  for (size_t i = 0; i < v1.size(); i++) {
+    NTA_CHECK(v1[i].isMap()) << "Expcted a command";
+    for (auto cmd : v1[i]) {
+      if (cmd.first == "registerRegion") {
+        // TODO:
+        NTA_THROW << "For now you can only use the built-in C++ regions with the REST API.";
+      } else if (cmd.first == "addRegion") {
+        RegionEntry region;
+        region.name = cmd.second["name"].str();
+        region.type = cmd.second["type"].str();
+        NTA_CHECK(findRegion_(region.name) == nullptr)
+          << "Region with name '" << region.name << "' already exists in network";
+        region.spec = RegionImplFactory::getInstance().getSpec(region.type);
+        if (cmd.second.contains("params")) region.params = cmd.second["params"].copy();
+        region.hasPhase = cmd.second.contains("phase");
+        region.phase = region.hasPhase ? static_cast<UInt32>(cmd.second["phase"].as<int>()) : 0u;
+        regions_.push_back(region);
+      } else if (cmd.first == "addLink") {
+        std::vector<std::string> vsrc = Path::split(cmd.second["src"].str(), '.');
+        std::vector<std::string> vdest = Path::split(cmd.second["dest"].str(), '.');
+        NTA_CHECK(vsrc.size() == 2) << "Expecting source domain name '.' output name.";
+        NTA_CHECK(vdest.size() == 2) << "Expecting destination domain name '.' input name.";
+        LinkEntry link;
+        link.srcRegion  = vsrc[0];
+        link.srcOutput  = vsrc[1];
+        link.destRegion = vdest[0];
+        link.destInput  = vdest[1];
+        link.delay = cmd.second.contains("delay") ? static_cast<size_t>(cmd.second["delay"].as<int>()) : 0u;
+
+        // Regions which are not in the template are checked when it is applied.
+        const RegionEntry *src  = findRegion_(link.srcRegion);
+        const RegionEntry *dest = findRegion_(link.destRegion);
+        NTA_CHECK(src == nullptr || src->spec->outputs.contains(link.srcOutput))
+          << "NetworkTemplate -- output " << link.srcOutput
+          << " does not exist on region " << link.srcRegion;
+        NTA_CHECK(dest == nullptr || dest->spec->inputs.contains(link.destInput))
+          << "NetworkTemplate -- input " << link.destInput
+          << " does not exist on region " << link.destRegion;
+        links_.push_back(link);
+      }
+    }
+  }
+}
+
+
+const NetworkTemplate::RegionEntry *NetworkTemplate::findRegion_(const std::string &name) const {
+  for (const auto &region : regions_) {
+    if (region.name == name) return &region;
+  }
+  return nullptr;
+}
+
+
+Network NetworkTemplate::create(const Int seed, const bool initialize) const {
+  Network net;
+  apply(net, seed);
+  if (initialize) net.initialize();
+  return net;
+}
+
+
+void NetworkTemplate::apply(Network &net, const Int seed) const {
+  for (const auto &region : regions_) {
+    // The regions may keep their parameters, so every instance gets its own.
+    ValueMap params = region.params.copy();
+    if (seed >= 0 && region.spec->parameters.contains("seed")) {
+      params["seed"] = static_cast<int32_t>(seed);
+    }
+    net.addRegion(region.name, region.type, params);
+    if (region.hasPhase) {
+      std::set<UInt32> phases = {region.phase};
+      net.setPhases(region.name, phases);
+    }
+  }
+  for (const auto &link : links_) {
+    net.link(link.srcRegion, link.destRegion, "", "", link.srcOutput, link.destInput, link.delay);
+  }
+}
+
+} // namespace htm
@@ -0,0 +1,109 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the NetworkTemplate class
+ */
+
+#ifndef NTA_NETWORK_TEMPLATE_HPP
+#define NTA_NETWORK_TEMPLATE_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * NetworkTemplate - a network configuration which is parsed and validated
+ * once, and then stamps out any number of Networks.
+ *
+ * @b Description
+ * The yaml has the syntax of Network::configure().  The constructor parses it
+ * into a list of regions (name, type, parameters, phase) and links, looks up
+ * the Spec of every region type, and checks the links against the Specs.
+ * create() then builds a Network from the parsed lists, without parsing any
+ * yaml, so a template is the fast way to make many instances of a model,
+ * e.g. for an ensemble or for parameter sweeps in a server.
+ *
+ * Each instance may get its own seed: it replaces the "seed" parameter of
+ * every region whose Spec has one.
+ *
+ * Example:
+ *     NetworkTemplate tmpl(yaml);
+ *     std::vector<Network> ensemble;
+ *     for(Int i = 0; i < 10; i++) ensemble.push_back(tmpl.create(i, true));
+ */
+class NetworkTemplate {
+public:
+  /**
+   * @param yaml Network description, @see Network::configure().
+   * Throws if the yaml is malformed, uses an unknown region type, or links
+   * an output or input which the region type does not have.
+   */
+  explicit NetworkTemplate(const std::string &yaml);
+
+  /**
+   * Builds a new Network from the template.
+   *
+   * @param seed If >= 0, the seed of the regions which have a "seed" parameter.
+   *             Else the seeds of the yaml are used.
+   * @param initialize Also initialize the Network.
+   */
+  Network create(Int seed = -1, bool initialize = false) const;
+
+  /**
+   * Adds the regions and links of the template to an existing Network.
+   * Links may refer to regions which the Network already has.
+   * @param seed @see create().
+   */
+  void apply(Network &net, Int seed = -1) const;
+
+  size_t getRegionCount() const noexcept { return regions_.size(); }
+  size_t getLinkCount() const noexcept { return links_.size(); }
+
+private:
+  struct RegionEntry {
+    std::string name;
+    std::string type;
+    ValueMap params;
+    std::shared_ptr<Spec> spec;
+    bool hasPhase;
+    UInt32 phase;
+  };
+  struct LinkEntry {
+    std::string srcRegion;
+    std::string srcOutput;
+    std::string destRegion;
+    std::string destInput;
+    size_t delay;
+  };
+
+  const RegionEntry *findRegion_(const std::string &name) const;
+
+  std::vector<RegionEntry> regions_;
+  std::vector<LinkEntry> links_;
+};
+
+} // namespace htm
+
+#endif // NTA_NETWORK_TEMPLATE_HPP
@@ -59,6 +59,7 @@ void Output::initialize() {
     // which look at the output before compute(). NPC-60
     data_.zeroBuffer();
   }
+  version_++;
 }
 
 
@@ -157,6 +158,7 @@ void Output::resize(size_t count) {
   }
   data_ = d;
   dim_ = {static_cast<UInt32>(count)};
+  version_++;
 
   // If the output is resized then the inputs to which it is connected
   // must also be resized.  If the input is a Fan-in, the offsets into
@@ -113,6 +113,16 @@ public:
    */
   bool hasOutgoingLinks();
 
+  /**
+   * @returns the number of outgoing links.
+   */
+  size_t getNumLinks() const { return links_.size(); }
+
+  /**
+   * @returns the outgoing links.
+   */
+  const std::set<std::shared_ptr<Link>> &getLinks() const { return links_; }
+
   /**
    * Get the data of the output.
    * @returns
@@ -167,6 +177,14 @@ public:
    */
   void setDimensions(const Dimensions& dim) { dim_ = dim; }
 
+  /**
+   * The version of the data, incremented when the data is written.
+   * Region::compute() increments it for every output of the region.  Code
+   * writing into getData() directly should call touch().
+   */
+  UInt64 getVersion() const { return version_; }
+  void touch() { version_++; }
+
   /**
    *  Resize the buffer.  (does not work for SDR or Str buffers)
    *  This is used when a Region needs to change the size of an output buffer at runtime.  (See ClassifierRegion.pdf)
@@ -183,6 +201,7 @@ private:
   Region* region_;
   Dimensions dim_;
   Array data_;
+  UInt64 version_ = 0u;
   // order of links never matters, so store as a set
   // this is different from Input, where they do matter
   std::set<std::shared_ptr<Link>> links_;
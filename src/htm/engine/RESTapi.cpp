@@ -22,8 +22,21 @@ Implementation of the RESTapi class
 */
 #include <htm/engine/RESTapi.hpp>
 #include <htm/engine/Network.hpp>
+#include <htm/os/Directory.hpp>
+#include <htm/os/Path.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <sstream>
 
 const size_t ID_MAX = 9999; // maximum number of generated ids  (this is arbitrary)
+const size_t MAX_EVENTS = 1000; // maximum number of queued events per subscription  (this is arbitrary)
+const char *const SUBSCRIPTION_CALLBACK = "RESTapi.subscriptions";
+const size_t MAX_FINISHED_JOBS = 1000; // maximum number of finished jobs kept for their status  (this is arbitrary)
+const htm::UInt64 JOB_CHUNK = 10; // iterations of a job between releases of its network
 
 using namespace htm;
 
@@ -32,7 +45,16 @@ static RESTapi rest;
 static unsigned int next_id = 1;
 
 RESTapi::RESTapi() {}
-RESTapi::~RESTapi() { }
+RESTapi::~RESTapi() {
+  // The queued jobs end at once and the running ones after their chunk,
+  // then the job threads are joined.
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &job : jobs_)
+      job.second->cancel = true;
+  }
+  job_pool_.reset();
+}
 
 RESTapi* RESTapi::getInstance() { return &rest; }
 
@@ -42,9 +64,10 @@ std::string RESTapi::get_new_id_() {
   //       starting with "1" and incrementing on each use with wrap at "9999". 
   //       This will never return "0" 
   
-  std::map<std::string, ResourceContext>::iterator itr;
+  // Note: called with mutex_ held.
+  std::map<std::string, std::shared_ptr<ResourceContext>>::iterator itr;
   std::string id;
-  while (rest.resource_.size() < ID_MAX) {  // limit the total number of generated resources
+  while (resource_.size() < ID_MAX) {  // limit the total number of generated resources
     unsigned int id_nbr = next_id++;
     if (id_nbr > ID_MAX)
       id_nbr = 1; // allow integer wrap of the id without using a "0" value.
@@ -64,17 +87,38 @@ std::string RESTapi::get_new_id_() {
 
 
 
+std::shared_ptr<RESTapi::ResourceContext> RESTapi::get_context_(const std::string &id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto itr = resource_.find(id);
+  NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
+  itr->second->t = time(0);
+  itr->second->lastUse = ++use_count_;
+  return itr->second;
+}
+
 std::string RESTapi::create_network_request(const std::string &specified_id, const std::string &config) {
   try {
+    std::shared_ptr<ResourceContext> obj = std::make_shared<ResourceContext>();
+    obj->t = time(0);
+    obj->net.reset(new htm::Network);  // Allocate a Network object.
+    obj->net->setMetrics(obj->metrics);
+    obj->net->configure(config);       // without any lock, this can take a while
+
     std::string id = specified_id;
-    if (id.empty()) id = get_new_id_();
-    ResourceContext obj;
-    obj.id = id;
-    obj.t = time(0);
-    obj.net.reset(new htm::Network);  // Allocate a Network object.
-
-    obj.net->configure(config);
-    resource_[id] = obj;              // assign the resource (deleting any previous value)
+    std::shared_ptr<ResourceContext> previous;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (id.empty()) id = get_new_id_();
+      obj->id = id;
+      obj->lastUse = ++use_count_;
+      previous = resource_[id];
+      resource_[id] = obj;            // assign the resource (deleting any previous value)
+    }
+    if (previous) release_(*previous);
+    {
+      std::lock_guard<std::mutex> lock(obj->mutex);
+      enforce_budget_(*obj);
+    }
     
     return "{\"result\": " + Value::json_string(id) + "}";
   } catch (Exception& e) {
@@ -91,14 +135,14 @@ std::string RESTapi::put_input_request(const std::string &id,
                                        const std::string &input_name, 
                                        const std::string &data) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
 
     Array a;
     a.fromJSON(data);
 
-    itr->second.net->getRegion(region_name)->setInputData(input_name, a);
+    ctx->net->getRegion(region_name)->setInputData(input_name, a);
 
     return "{\"result\": \"OK\"}";
   }
@@ -111,14 +155,38 @@ std::string RESTapi::put_input_request(const std::string &id,
   }
 }
 
+std::string RESTapi::put_input_binary_request(const std::string &id,
+                                              const std::string &region_name,
+                                              const std::string &input_name,
+                                              const std::string &data) {
+  try {
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
+
+    Array a;
+    a.fromBinary(data);
+
+    ctx->net->getRegion(region_name)->setInputData(input_name, a);
+
+    return "{\"result\": \"OK\"}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
 std::string RESTapi::get_input_request(const std::string &id, 
                                        const std::string &region_name,
                                        const std::string &input_name) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
-    auto region = itr->second.net->getRegion(region_name);
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
+    auto region = ctx->net->getRegion(region_name);
     const Array &b = region->getInputData(input_name);
     std::string data = b.toJSON();
     std::string type = BasicType::getName(b.getType());
@@ -135,14 +203,34 @@ std::string RESTapi::get_input_request(const std::string &id,
   }
 }
 
+bool RESTapi::get_input_binary_request(const std::string &id,
+                                       const std::string &region_name,
+                                       const std::string &input_name,
+                                       std::string &result) {
+  try {
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
+    result = ctx->net->getRegion(region_name)->getInputData(input_name).toBinary();
+    return true;
+  } catch (Exception &e) {
+    result = "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    result = "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    result = "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+  return false;
+}
+
 std::string RESTapi::get_output_request(const std::string &id, 
                                         const std::string &region_name,
                                         const std::string &output_name) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
-    auto region = itr->second.net->getRegion(region_name);
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
+    auto region = ctx->net->getRegion(region_name);
     const Array &b = region->getOutputData(output_name);
     std::string data = b.toJSON();
     std::string type = BasicType::getName(b.getType());
@@ -158,16 +246,36 @@ std::string RESTapi::get_output_request(const std::string &id,
   }
 }
 
+bool RESTapi::get_output_binary_request(const std::string &id,
+                                       const std::string &region_name,
+                                       const std::string &output_name,
+                                       std::string &result) {
+  try {
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
+    result = ctx->net->getRegion(region_name)->getOutputData(output_name).toBinary();
+    return true;
+  } catch (Exception &e) {
+    result = "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    result = "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    result = "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+  return false;
+}
+
 std::string RESTapi::put_param_request(const std::string &id, 
                                        const std::string &region_name,
                                        const std::string &param_name, 
                                        const std::string &data) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
 
-    itr->second.net->getRegion(region_name)->setParameterJSON(param_name, data);
+    ctx->net->getRegion(region_name)->setParameterJSON(param_name, data);
 
     return "{\"result\": \"OK\"}";
   } catch (Exception &e) {
@@ -183,12 +291,12 @@ std::string RESTapi::get_param_request(const std::string &id,
                                        const std::string &region_name,
                                        const std::string &param_name) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
 
     std::string response;
-    response = itr->second.net->getRegion(region_name)->getParameterJSON(param_name, "result");
+    response = ctx->net->getRegion(region_name)->getParameterJSON(param_name, "result");
     
     return response;
   } catch (Exception &e) {
@@ -202,11 +310,17 @@ std::string RESTapi::get_param_request(const std::string &id,
 
 std::string RESTapi::delete_region_request(const std::string &id, const std::string &region_name) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
 
-    itr->second.net->removeRegion(region_name);
+    ctx->net->removeRegion(region_name);
+    for (auto duty = ctx->learnDuty.begin(); duty != ctx->learnDuty.end();) {
+      if (duty->first == region_name || duty->second.source == region_name)
+        duty = ctx->learnDuty.erase(duty);
+      else
+        duty++;
+    }
 
     return "{\"result\": \"OK\"}";
   } catch (Exception &e) {
@@ -222,9 +336,9 @@ std::string RESTapi::delete_link_request(const std::string &id,
                                          const std::string &source_name,
                                          const std::string &dest_name) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
 
     std::vector<std::string> args;
     args = Path::split(source_name, '.');
@@ -237,7 +351,7 @@ std::string RESTapi::delete_link_request(const std::string &id,
     std::string dest_region = args[0];
     std::string dest_input = args[1];
 
-    itr->second.net->removeLink(source_region, dest_region, source_output, dest_input);
+    ctx->net->removeLink(source_region, dest_region, source_output, dest_input);
 
     return "{\"result\": \"OK\"}";
   } catch (Exception &e) {
@@ -251,11 +365,16 @@ std::string RESTapi::delete_link_request(const std::string &id,
 
 std::string RESTapi::delete_network_request(const std::string &id) {
   try {
-
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-
-    resource_.erase(itr);
+    // Requests in progress on this network keep it until they are done.
+    std::shared_ptr<ResourceContext> ctx;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto itr = resource_.find(id);
+      NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
+      ctx = itr->second;
+      resource_.erase(itr);
+    }
+    release_(*ctx);
 
     return "{\"result\": \"OK\"}";
   } catch (Exception &e) {
@@ -270,15 +389,218 @@ std::string RESTapi::delete_network_request(const std::string &id) {
 
 std::string RESTapi::run_request(const std::string &id, const std::string &iterations) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
 
     int iter = 1;
     if (!iterations.empty()) {
       iter = std::strtol(iterations.c_str(), nullptr, 10);
     }
-    itr->second.net->run(iter);
+    ctx->net->run(iter);
+    enforce_budget_(*ctx);
+    return "{\"result\": \"OK\"}";
+  }
+  catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+std::string RESTapi::run_async_request(const std::string &id, const std::string &iterations) {
+  try {
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    long long iter = 1;
+    if (!iterations.empty()) {
+      iter = std::strtoll(iterations.c_str(), nullptr, 10);
+    }
+    NTA_CHECK(iter >= 0) << "Invalid number of iterations '" << iterations << "'.";
+
+    std::shared_ptr<Job> job = std::make_shared<Job>();
+    job->network = id;
+    job->context = ctx;
+    job->total = static_cast<UInt64>(iter);
+    std::lock_guard<std::mutex> lock(mutex_);
+    NTA_CHECK(ctx->jobs < jobs_per_network_)
+        << "Network '" << id << "' already has " << ctx->jobs << " unfinished jobs, try again later.";
+    ctx->jobs++;
+    job->id = std::to_string(next_job_++);
+    jobs_[job->id] = job;
+    if (!job_pool_)
+      job_pool_.reset(new ThreadPool(job_threads_));
+    job_pool_->submit([this, job]() { run_job_(*job); });
+    return "{\"result\": " + Value::json_string(job->id) + "}";
+  }
+  catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+void RESTapi::run_job_(Job &job) {
+  // The local reference keeps the network while its mutex is held,
+  // finish_job_() releases the one of the job.
+  std::shared_ptr<ResourceContext> ctx = job.context;
+  {
+    std::lock_guard<std::mutex> lock(job.mutex);
+    job.state = JobState::Running;
+  }
+  try {
+    while (job.done < job.total) {
+      if (job.cancel) {
+        finish_job_(job, JobState::Cancelled);
+        return;
+      }
+      std::lock_guard<std::mutex> lock(ctx->mutex);
+      if (ctx->released) {
+        finish_job_(job, JobState::Failed, "Network '" + job.network + "' was deleted.");
+        return;
+      }
+      load_(*ctx);
+      const UInt64 n = std::min(JOB_CHUNK, job.total - job.done);
+      ctx->net->run(static_cast<int>(n));
+      job.done += n;
+      enforce_budget_(*ctx);
+    }
+    finish_job_(job, JobState::Done);
+  } catch (Exception &e) {
+    finish_job_(job, JobState::Failed, e.getMessage());
+  } catch (std::exception &e) {
+    finish_job_(job, JobState::Failed, e.what());
+  } catch (...) {
+    finish_job_(job, JobState::Failed, "Unknown Exception.");
+  }
+}
+
+void RESTapi::finish_job_(Job &job, JobState state, const std::string &error) {
+  {
+    std::lock_guard<std::mutex> lock(job.mutex);
+    job.state = state;
+    job.error = error;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  job.context->jobs--;
+  job.context.reset();
+  finished_jobs_.push_back(job.id);
+  while (finished_jobs_.size() > MAX_FINISHED_JOBS) {
+    jobs_.erase(finished_jobs_.front());
+    finished_jobs_.pop_front();
+  }
+}
+
+std::string RESTapi::job_status_request(const std::string &job) {
+  try {
+    std::shared_ptr<Job> entry;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto itr = jobs_.find(job);
+      NTA_CHECK(itr != jobs_.end()) << "Job '" + job + "' not found.";
+      entry = itr->second;
+    }
+    static const char *const states[] = {"queued", "running", "done", "cancelled", "failed"};
+    std::lock_guard<std::mutex> lock(entry->mutex);
+    std::string result = "{\"result\": {\"job\": " + Value::json_string(entry->id) +
+                         ", \"network\": " + Value::json_string(entry->network) +
+                         ", \"state\": \"" + states[static_cast<int>(entry->state)] + "\"" +
+                         ", \"iterations\": " + std::to_string(entry->done.load()) +
+                         ", \"total\": " + std::to_string(entry->total);
+    if (!entry->error.empty())
+      result += ", \"error\": " + Value::json_string(entry->error);
+    return result + "}}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+std::string RESTapi::job_cancel_request(const std::string &job) {
+  try {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr = jobs_.find(job);
+    NTA_CHECK(itr != jobs_.end()) << "Job '" + job + "' not found.";
+    itr->second->cancel = true;
+    return "{\"result\": \"OK\"}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+void RESTapi::set_job_limits(size_t perNetwork, size_t threads) {
+  NTA_CHECK(perNetwork > 0u) << "At least one job per network is required.";
+  std::lock_guard<std::mutex> lock(mutex_);
+  jobs_per_network_ = perNetwork;
+  job_threads_ = threads;
+}
+
+std::string RESTapi::trace_request(const std::string &id, const std::string &action,
+                                   const std::string &capacity) {
+  try {
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
+
+    if (action == "start") {
+      size_t events = 65536u;
+      if (!capacity.empty()) {
+        events = static_cast<size_t>(std::strtoull(capacity.c_str(), nullptr, 10));
+      }
+      ctx->net->enableTracing(events);
+    } else if (action == "stop") {
+      ctx->net->disableTracing();
+    } else if (action == "get") {
+      return ctx->net->getTrace();
+    } else {
+      NTA_THROW << "Unknown trace action '" << action << "', expected start, stop or get.";
+    }
+    return "{\"result\": \"OK\"}";
+  }
+  catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+std::string RESTapi::learn_request(const std::string &id, const std::string &region_name,
+                                   const std::string &every, const std::string &anomaly,
+                                   const std::string &source) {
+  try {
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
+
+    ResourceContext::LearnDuty duty = {1u, -1.0f, source};
+    if (!every.empty()) {
+      char *end = nullptr;
+      const long n = std::strtol(every.c_str(), &end, 10);
+      NTA_CHECK(*end == '\0' && n >= 0) << "Invalid learn every '" << every << "'";
+      duty.every = static_cast<UInt>(n);
+    }
+    if (!anomaly.empty()) {
+      char *end = nullptr;
+      duty.anomaly = std::strtof(anomaly.c_str(), &end);
+      NTA_CHECK(*end == '\0') << "Invalid learn anomaly '" << anomaly << "'";
+    }
+    ctx->net->setLearnDutyCycle(region_name, duty.every, duty.anomaly, duty.source);
+    if (duty.every == 1u && duty.anomaly < 0.0f)
+      ctx->learnDuty.erase(region_name);
+    else
+      ctx->learnDuty[region_name] = duty;
     return "{\"result\": \"OK\"}";
   }
   catch (Exception &e) {
@@ -290,18 +612,142 @@ std::string RESTapi::run_request(const std::string &id, const std::string &itera
   }
 }
 
+// One column of a batch, a parameter or an input of a region.
+struct BatchColumn {
+  std::shared_ptr<Region> region;
+  std::string name;
+  bool isParam;
+  ParameterHandle param;
+};
+
+static std::vector<std::string> splitName(const std::string &name, const char *what) {
+  std::vector<std::string> args = Path::split(name, '.');
+  NTA_CHECK(args.size() == 2) << "Expected syntax <region>.<" << what << "> for batch. Found " << name;
+  return args;
+}
+
+static void setBatchParameter(Region &region, const ParameterHandle &param, const Value &v) {
+  switch (param.dataType) {
+  case NTA_BasicType_Int32:
+    region.setParameterInt32(param, v.as<Int32>());
+    break;
+  case NTA_BasicType_UInt32:
+    region.setParameterUInt32(param, v.as<UInt32>());
+    break;
+  case NTA_BasicType_Int64:
+    region.setParameterInt64(param, v.as<Int64>());
+    break;
+  case NTA_BasicType_UInt64:
+    region.setParameterUInt64(param, v.as<UInt64>());
+    break;
+  case NTA_BasicType_Real32:
+    region.setParameterReal32(param, v.as<Real32>());
+    break;
+  case NTA_BasicType_Real64:
+    region.setParameterReal64(param, v.as<Real64>());
+    break;
+  case NTA_BasicType_Bool:
+    region.setParameterBool(param, v.as<bool>());
+    break;
+  default:
+    NTA_THROW << "Unknow parameter type '" + std::string(BasicType::getName(param.dataType)) + "'";
+    break;
+  }
+}
+
+std::string RESTapi::batch_request(const std::string &id, const std::string &data) {
+  try {
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
+    Network &net = *ctx->net;
+
+    Value vm;
+    vm.parse(data);
+    NTA_CHECK(vm.isMap() && vm.contains("data"))
+        << "Unexpected JSON format. Expecting something like {columns: [\"encoder.sensedValue\"], "
+           "outputs: [\"tm.anomaly\"], data: [[0.1], [0.2]]}";
+
+    // Resolve the names once for the whole batch.
+    std::vector<BatchColumn> columns;
+    if (vm.contains("columns")) {
+      for (const std::string &name : vm["columns"].asVector<std::string>()) {
+        std::vector<std::string> args = splitName(name, "param or input");
+        BatchColumn col{};
+        col.region = net.getRegion(args[0]);
+        col.name = args[1];
+        col.isParam = col.region->getSpec()->parameters.contains(col.name);
+        if (col.isParam)
+          col.param = col.region->getParameterHandle(col.name);
+        else
+          NTA_CHECK(col.region->getInput(col.name) != nullptr)
+              << "Region '" << args[0] << "' has no parameter or input '" << col.name << "'";
+        columns.push_back(col);
+      }
+    }
+    std::vector<std::pair<std::shared_ptr<Region>, std::string>> outputs;
+    if (vm.contains("outputs")) {
+      for (const std::string &name : vm["outputs"].asVector<std::string>()) {
+        std::vector<std::string> args = splitName(name, "output");
+        outputs.emplace_back(net.getRegion(args[0]), args[1]);
+      }
+    }
+
+    const Value &records = vm["data"];
+    NTA_CHECK(records.isSequence()) << "The batch data must be a sequence of records.";
+    std::string result = "{\"result\": [";
+    for (size_t r = 0; r < records.size(); r++) {
+      const Value &record = records[r];
+      NTA_CHECK(record.isSequence() && record.size() == columns.size())
+          << "Record " << r << " must have one element per column; expected " << columns.size();
+      for (size_t c = 0; c < columns.size(); c++) {
+        const BatchColumn &col = columns[c];
+        if (col.isParam) {
+          setBatchParameter(*col.region, col.param, record[c]);
+        } else {
+          const Value &values = record[c];
+          NTA_CHECK(values.isSequence()) << "The value of input " << col.name << " must be a sequence.";
+          Array a(NTA_BasicType_Real64);
+          a.allocateBuffer(values.size());
+          Real64 *buf = static_cast<Real64 *>(a.getBuffer());
+          for (size_t i = 0; i < values.size(); i++)
+            buf[i] = values[i].as<Real64>();
+          col.region->setInputData(col.name, a);
+        }
+      }
+      net.run(1);
+
+      result += (r == 0) ? "[" : ", [";
+      for (size_t o = 0; o < outputs.size(); o++) {
+        if (o > 0)
+          result += ", ";
+        result += outputs[o].first->getOutputData(outputs[o].second).toJSON();
+      }
+      result += "]";
+    }
+    enforce_budget_(*ctx);
+    return result + "]}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
 std::string RESTapi::command_request(const std::string& id, 
                                      const std::string& region_name,
                                      const std::string& command) {
   try {
-    auto itr = resource_.find(id);
-    NTA_CHECK(itr != resource_.end()) << "Context for resource '" + id + "' not found.";
-    itr->second.t = time(0);
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::lock_guard<std::mutex> lock(ctx->mutex);
+    load_(*ctx);
 
     std::string response;
     std::vector<std::string> args;
     args = Path::split(command, ' ');
-    response = itr->second.net->getRegion(region_name)->executeCommand(args);
+    response = ctx->net->getRegion(region_name)->executeCommand(args);
 
     return "{\"result\": " + response + "}";
   } catch (Exception &e) {
@@ -312,3 +758,299 @@ std::string RESTapi::command_request(const std::string& id,
     return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
   }
 }
+
+
+bool RESTapi::subscribe_request(const std::string &id, const std::string &outputs, std::string &result) {
+  try {
+    std::shared_ptr<ResourceContext> ctx = get_context_(id);
+    std::shared_ptr<Subscription> sub = std::make_shared<Subscription>();
+    sub->context = ctx;
+    {
+      std::lock_guard<std::mutex> lock(ctx->mutex);
+      load_(*ctx);
+      for (const std::string &name : Path::split(outputs, ',')) {
+        std::vector<std::string> args = splitName(name, "output");
+        std::shared_ptr<Region> region = ctx->net->getRegion(args[0]);
+        NTA_CHECK(region->getOutput(args[1]) != nullptr)
+            << "Region '" << args[0] << "' has no output '" << args[1] << "'";
+        sub->outputs.emplace_back(region, args[1]);
+      }
+      NTA_CHECK(!sub->outputs.empty()) << "No outputs to subscribe to.";
+      if (ctx->subscriptions.empty())
+        ctx->net->getCallbacks().add(SUBSCRIPTION_CALLBACK, Network::callbackItem(&RESTapi::publish_, ctx.get()));
+      ctx->subscriptions.push_back(sub);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    result = std::to_string(next_subscription_++);
+    subscriptions_[result] = sub;
+    return true;
+  } catch (Exception &e) {
+    result = "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    result = "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    result = "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+  return false;
+}
+
+bool RESTapi::next_event(const std::string &subscription, std::string &event, unsigned int timeout_ms) {
+  event.clear();
+  std::shared_ptr<Subscription> sub;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto itr = subscriptions_.find(subscription);
+    if (itr == subscriptions_.end())
+      return false;
+    sub = itr->second;
+  }
+  std::unique_lock<std::mutex> lock(sub->mutex);
+  sub->ready.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                      [&sub] { return !sub->events.empty() || sub->closed; });
+  if (sub->events.empty())
+    return !sub->closed;
+  event = std::move(sub->events.front());
+  sub->events.pop_front();
+  sub->depth = sub->events.size();
+  return true;
+}
+
+std::string RESTapi::unsubscribe_request(const std::string &subscription) {
+  try {
+    std::shared_ptr<Subscription> sub;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto itr = subscriptions_.find(subscription);
+      NTA_CHECK(itr != subscriptions_.end()) << "Subscription '" + subscription + "' not found.";
+      sub = itr->second;
+      subscriptions_.erase(itr);
+    }
+    std::shared_ptr<ResourceContext> ctx = sub->context.lock();
+    if (ctx) {
+      std::lock_guard<std::mutex> lock(ctx->mutex);
+      auto &subs = ctx->subscriptions;
+      subs.erase(std::remove(subs.begin(), subs.end(), sub), subs.end());
+      if (subs.empty() && ctx->net && ctx->net->getCallbacks().contains(SUBSCRIPTION_CALLBACK))
+        ctx->net->getCallbacks().remove(SUBSCRIPTION_CALLBACK);
+    }
+    std::lock_guard<std::mutex> lock(sub->mutex);
+    sub->closed = true;
+    sub->ready.notify_all();
+    return "{\"result\": \"OK\"}";
+  } catch (Exception &e) {
+    return "{\"err\": " + Value::json_string(e.getMessage()) + "}";
+  } catch (std::exception& e) {
+    return "{\"err\": " + Value::json_string(e.what()) + "}";
+  } catch (...) {
+    return "{\"err\": " + Value::json_string("Unknown Exception.") + "}";
+  }
+}
+
+void RESTapi::publish_(Network * /*net*/, UInt64 iteration, void *context) {
+  // Called by Network::run(), so the mutex of the resource is held.
+  ResourceContext *ctx = static_cast<ResourceContext *>(context);
+  for (const auto &sub : ctx->subscriptions) {
+    std::string event = "{\"iteration\": " + std::to_string(iteration);
+    for (const auto &out : sub->outputs) {
+      event += ", " + Value::json_string(out.first->getName() + "." + out.second) + ": " +
+               out.first->getOutputData(out.second).toJSON();
+    }
+    event += "}";
+    std::lock_guard<std::mutex> lock(sub->mutex);
+    sub->events.push_back(std::move(event));
+    if (sub->events.size() > MAX_EVENTS)
+      sub->events.pop_front();
+    sub->depth = sub->events.size();
+    sub->ready.notify_all();
+  }
+}
+
+void RESTapi::release_(ResourceContext &ctx) {
+  // The subscriptions end when their remaining events are read.
+  std::lock_guard<std::mutex> lock(ctx.mutex);
+  ctx.released = true;  // ends its jobs
+  if (!ctx.file.empty()) {
+    Path::remove(ctx.file);
+    ctx.file.clear();
+  }
+  for (const auto &sub : ctx.subscriptions) {
+    std::lock_guard<std::mutex> subLock(sub->mutex);
+    sub->closed = true;
+    sub->ready.notify_all();
+  }
+  ctx.subscriptions.clear();
+  if (ctx.net && ctx.net->getCallbacks().contains(SUBSCRIPTION_CALLBACK))
+    ctx.net->getCallbacks().remove(SUBSCRIPTION_CALLBACK);
+  ctx.bytes = 0u;
+}
+
+
+void RESTapi::set_memory_budget(size_t bytes, const std::string &directory) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (bytes > 0u && !Directory::exists(directory))
+    Directory::create(directory, false, true);
+  evict_dir_ = directory;
+  budget_ = bytes;
+}
+
+// A label value of the Prometheus text format.
+static std::string metricLabel(const std::string &value) {
+  std::string escaped;
+  for (const char c : value) {
+    if (c == '\\' || c == '"') escaped += '\\';
+    if (c == '\n') { escaped += "\\n"; continue; }
+    escaped += c;
+  }
+  return escaped;
+}
+
+std::string RESTapi::metrics_request() {
+  // A snapshot of the resources and the depths of their subscription queues,
+  // without the mutex of any resource.
+  struct Sample {
+    std::string label;
+    std::shared_ptr<const Network::Metrics> metrics;
+    bool resident;
+    size_t queued;
+    size_t jobs;
+  };
+  std::vector<Sample> samples;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<const ResourceContext *, size_t> queued;
+    for (const auto &sub : subscriptions_) {
+      std::shared_ptr<ResourceContext> ctx = sub.second->context.lock();
+      if (ctx) queued[ctx.get()] += sub.second->depth;
+    }
+    for (const auto &r : resource_) {
+      samples.push_back({"{network=\"" + metricLabel(r.first) + "\"}", r.second->metrics,
+                         r.second->resident, queued[r.second.get()], r.second->jobs});
+    }
+  }
+
+  std::stringstream ss;
+  ss << std::setprecision(9);
+  ss << "# HELP htm_networks Number of Network objects.\n# TYPE htm_networks gauge\n"
+     << "htm_networks " << samples.size() << "\n";
+  const auto family = [&](const char *name, const char *type, const char *help,
+                          const std::function<UInt64(const Sample &)> &value) {
+    ss << "# HELP " << name << " " << help << "\n# TYPE " << name << " " << type << "\n";
+    for (const auto &s : samples)
+      ss << name << s.label << " " << value(s) << "\n";
+  };
+  family("htm_network_iterations_total", "counter", "Iterations run.",
+         [](const Sample &s) -> UInt64 { return s.metrics->iterations.load(); });
+  family("htm_network_segments", "gauge", "Segments of the Connections.",
+         [](const Sample &s) -> UInt64 { return s.metrics->segments.load(); });
+  family("htm_network_synapses", "gauge", "Synapses of the Connections.",
+         [](const Sample &s) -> UInt64 { return s.metrics->synapses.load(); });
+  family("htm_network_pruned_segments_total", "counter", "Segments pruned by the Connections.",
+         [](const Sample &s) -> UInt64 { return s.metrics->prunedSegments.load(); });
+  family("htm_network_pruned_synapses_total", "counter", "Synapses pruned by the Connections.",
+         [](const Sample &s) -> UInt64 { return s.metrics->prunedSynapses.load(); });
+  family("htm_network_memory_bytes", "gauge", "Estimated heap memory of the network.",
+         [](const Sample &s) -> UInt64 { return s.metrics->memoryBytes.load(); });
+  family("htm_network_shed_maintenance_total", "counter", "Region computes which deferred the Connections maintenance for a deadline.",
+         [](const Sample &s) -> UInt64 { return s.metrics->shedMaintenance.load(); });
+  family("htm_network_shed_outputs_total", "counter", "Region computes which also skipped optional outputs for a deadline.",
+         [](const Sample &s) -> UInt64 { return s.metrics->shedOutputs.load(); });
+  family("htm_network_shed_learning_total", "counter", "Region computes which also skipped learning for a deadline.",
+         [](const Sample &s) -> UInt64 { return s.metrics->shedLearning.load(); });
+  family("htm_network_learn_skipped_total", "counter", "Region computes which did not learn for the learn duty cycle.",
+         [](const Sample &s) -> UInt64 { return s.metrics->learnSkipped.load(); });
+  family("htm_network_deadline_misses_total", "counter", "Iterations over their deadline.",
+         [](const Sample &s) -> UInt64 { return s.metrics->deadlineMisses.load(); });
+  family("htm_network_resident", "gauge", "1 if the network is in memory, 0 if evicted.",
+         [](const Sample &s) -> UInt64 { return s.resident ? 1u : 0u; });
+  family("htm_network_subscription_queue_depth", "gauge", "Events queued for the subscriptions.",
+         [](const Sample &s) -> UInt64 { return s.queued; });
+  family("htm_network_jobs", "gauge", "Queued and running asynchronous runs.",
+         [](const Sample &s) -> UInt64 { return s.jobs; });
+
+  const char *run = "htm_network_run_seconds";
+  ss << "# HELP " << run << " Latency of the run requests.\n# TYPE " << run << " histogram\n";
+  for (const auto &s : samples) {
+    const Network::Metrics &m = *s.metrics;
+    const std::string network = s.label.substr(1u, s.label.size() - 2u);
+    UInt64 cumulative = 0u;
+    for (size_t b = 0u; b <= Network::Metrics::NumRunBuckets; b++) {
+      cumulative += m.runBuckets[b].load(std::memory_order_relaxed);
+      ss << run << "_bucket{" << network << ",le=\"";
+      if (b < Network::Metrics::NumRunBuckets)
+        ss << Network::Metrics::RunBucketBounds[b];
+      else
+        ss << "+Inf";
+      ss << "\"} " << cumulative << "\n";
+    }
+    ss << run << "_sum" << s.label << " " << static_cast<double>(m.runNanoseconds.load()) * 1.0e-9 << "\n"
+       << run << "_count" << s.label << " " << cumulative << "\n";
+  }
+  return ss.str();
+}
+
+void RESTapi::load_(ResourceContext &ctx) {
+  if (ctx.net)
+    return;
+  std::shared_ptr<Network> net = std::make_shared<Network>();
+  net->loadFromFile(ctx.file);
+  net->setMetrics(ctx.metrics);
+  for (const auto &duty : ctx.learnDuty) {
+    net->setLearnDutyCycle(duty.first, duty.second.every, duty.second.anomaly, duty.second.source);
+  }
+  Path::remove(ctx.file);
+  ctx.file.clear();
+  ctx.net = net;
+  ctx.resident = true;
+  enforce_budget_(ctx);
+}
+
+void RESTapi::enforce_budget_(ResourceContext &ctx) {
+  const size_t budget = budget_;
+  if (budget == 0u)
+    return;
+  ctx.bytes = ctx.net->memoryUsage();
+
+  // The other resident networks, least recently used first.
+  std::vector<std::shared_ptr<ResourceContext>> lru;
+  size_t total = 0u;
+  std::string dir;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto &r : resource_) {
+      total += r.second->bytes;
+      if (r.second.get() != &ctx && r.second->bytes > 0u)
+        lru.push_back(r.second);
+    }
+    std::sort(lru.begin(), lru.end(),
+              [](const std::shared_ptr<ResourceContext> &a, const std::shared_ptr<ResourceContext> &b) {
+                return a->lastUse < b->lastUse;
+              });
+    dir = evict_dir_;
+  }
+
+  for (const auto &victim : lru) {
+    if (total <= budget)
+      break;
+    // A network with a request in progress is not idle, skip it rather than wait.
+    std::unique_lock<std::mutex> lock(victim->mutex, std::try_to_lock);
+    if (!lock.owns_lock() || !victim->net || !victim->subscriptions.empty() ||
+        victim->jobs > 0u || victim->net->isTracing())
+      continue;
+    std::string file;
+    {
+      std::lock_guard<std::mutex> idLock(mutex_);
+      file = Path::join(dir, "network_" + std::to_string(++use_count_) + ".bin");
+    }
+    try {
+      victim->net->saveToFile(file);
+    } catch (Exception &e) {
+      NTA_WARN << "RESTapi: unable to evict network '" << victim->id << "'; " << e.getMessage();
+      continue;
+    }
+    victim->net.reset();
+    victim->resident = false;
+    victim->file = file;
+    total -= victim->bytes;
+    victim->bytes = 0u;
+  }
+}
@@ -31,6 +31,8 @@
  *       Each "network create" message will create a Network object.  Each subsequent "run"
  *       message from the same client will use the same Network object to perform operations.
  *       Multiple clients can be using the same server at the same time.
+ *       The handlers are thread safe.  Requests on the same Network object
+ *       are serialized, requests on different Network objects run in parallel.
  *
  *       For this to happen we need to know which Network object the "run" 
  *       message should apply to. Since the protocol is stateless, the "run" 
@@ -58,7 +60,13 @@
 #define NTA_REST_API_HPP
 
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <htm/engine/Network.hpp>
+#include <htm/utils/ThreadPool.hpp>
 
 namespace htm {
 
@@ -139,6 +147,16 @@ public:
                                 const std::string &input_name,
                                 const std::string &data);
 
+  /**
+   * @b Description:
+   * Same as put_input_request() but the data is an Array in the binary
+   * format of Array::toBinary(), eg. a sparse SDR, instead of JSON.
+   */
+  std::string put_input_binary_request(const std::string &id,
+                                       const std::string &region_name,
+                                       const std::string &input_name,
+                                       const std::string &data);
+
 
   /**
    * @b Description:
@@ -165,6 +183,22 @@ public:
                                 const std::string &region_name, 
                                 const std::string &input_name);
 
+  /**
+   * @b Description:
+   * Same as get_input_request() but the input array is returned in the
+   * binary format of Array::toBinary().  An SDR is sent as its dimensions
+   * and the varint delta encoded indices of its active bits.
+   *
+   * @param result  Output, the binary array on success, otherwise the JSON
+   *                encoded error message.
+   *
+   * @retval        true if @p result holds the binary array.
+   */
+  bool get_input_binary_request(const std::string &id,
+                                const std::string &region_name,
+                                const std::string &input_name,
+                                std::string &result);
+
 
 
   /**
@@ -193,6 +227,16 @@ public:
                                  const std::string &region_name, 
                                  const std::string &output_name);
 
+  /**
+   * @b Description:
+   * Same as get_output_request() but the output array is returned in the
+   * binary format of Array::toBinary(), @see get_input_binary_request().
+   */
+  bool get_output_binary_request(const std::string &id,
+                                 const std::string &region_name,
+                                 const std::string &output_name,
+                                 std::string &result);
+
 
   /**
    * @b Description:
@@ -321,9 +365,118 @@ public:
    * @retval            If success returns "OK".
    *                    Otherwise returns error message starting with "ERROR: ".
    */
-  std::string run_request(const std::string &id, 
+  std::string run_request(const std::string &id,
                           const std::string &iterations);
 
+  /**
+   * @b Description:
+   * Handler for an asynchronous "run" request message, POST run?async=1.
+   * Queues the run as a job on the job threads and returns immediately.
+   * The job runs the iterations in small chunks, releasing the Network
+   * object between them, so the other requests on it are served during
+   * a long run and a cancel takes effect within a chunk.
+   *
+   * @param id  Identifier for the resource context (a Network class instance).
+   *            Client should pass the id returned by the previous "configure"
+   *            request message.
+   *
+   * @param iterations  The number of iterations to run.  Normally this is 1, the default.
+   *
+   * @retval            If success returns the job id.
+   *                    Otherwise returns error message starting with "ERROR: ".
+   *                    The request is refused if the network already has the
+   *                    maximum number of unfinished jobs, @see set_job_limits().
+   */
+  std::string run_async_request(const std::string &id,
+                                const std::string &iterations);
+
+  /**
+   * @b Description:
+   * Handler for a GET "job" request message, the status of a job.
+   *
+   * @retval            If success returns
+   *                      {"job": <id>, "network": <id>, "state": <state>,
+   *                       "iterations": <done>, "total": <iterations>}
+   *                    where state is "queued", "running", "done", "cancelled"
+   *                    or "failed", the last with an "error" field.
+   *                    Otherwise returns error message starting with "ERROR: ".
+   */
+  std::string job_status_request(const std::string &job);
+
+  /**
+   * @b Description:
+   * Handler for a DELETE "job" request message.  Cancels a queued or running
+   * job; a running job stops after its current chunk of iterations, the
+   * iterations done are kept.  Cancelling a finished job has no effect.
+   *
+   * @retval            If success returns "OK".
+   *                    Otherwise returns error message starting with "ERROR: ".
+   */
+  std::string job_cancel_request(const std::string &job);
+
+  /**
+   * @b Description:
+   * Limits the asynchronous runs.
+   *
+   * @param perNetwork  The maximum of unfinished (queued or running) jobs of a
+   *                    network, more are refused.  Default 1.
+   * @param threads     The threads running the jobs of all networks, 0 for the
+   *                    hardware concurrency (the default).  Takes effect when
+   *                    the first job is queued.
+   */
+  void set_job_limits(size_t perNetwork, size_t threads = 0u);
+
+  /**
+   * @b Description:
+   * Handler for a POST "batch" request message.
+   * This feeds a matrix of records to the Network object, one iteration per
+   * record, and returns the requested outputs of every iteration.  It does
+   * the work of a PUT param or PUT input, a run and GET output per record in
+   * one round trip.  The names are looked up once per batch, not per record.
+   *
+   * @param id  Identifier for the resource context (a Network class instance).
+   *            Client should pass the id returned by the previous "configure"
+   *            request message.
+   *
+   * @param data  The batch in JSON format. The following is expected:
+   *                {columns: ["<region>.<name>", ...],
+   *                 outputs: ["<region>.<output>", ...],
+   *                 data: [[<record 0>], [<record 1>], ...]}
+   *              Each record has one element per column.  If the name is a
+   *              parameter of the region the element is its scalar value.
+   *              Otherwise it is an input of the region and the element is a
+   *              sequence of values.  Outputs are optional.
+   *
+   * @retval            If success returns a JSON encoded sequence with one entry per
+   *                    record, each a sequence of the output arrays in the order requested.
+   *                    Otherwise returns error message starting with "ERROR: ".
+   */
+  std::string batch_request(const std::string &id, const std::string &data);
+
+  /**
+   * @b Description:
+   * Handler for a GET "trace" request message.
+   * Records a timeline of the following runs of the Network object, the begin
+   * and end of every iteration, region compute and link transfer.
+   * A network is not evicted while tracing, see set_memory_budget().
+   *
+   * @param id  Identifier for the resource context (a Network class instance).
+   *            Client should pass the id returned by the previous "configure"
+   *            request message.
+   *
+   * @param action    "start" to record, "stop", or "get" for the trace.
+   *
+   * @param capacity  For "start", the number of events kept, the most recent.
+   *                  Optional, see Network::enableTracing().
+   *
+   * @retval            For "get", the trace in the Chrome Trace Event JSON format,
+   *                    which chrome://tracing and the Perfetto UI open.
+   *                    Otherwise if success returns "OK".
+   *                    Otherwise returns error message starting with "ERROR: ".
+   */
+  std::string trace_request(const std::string &id, const std::string &action,
+                            const std::string &capacity = "");
+
   /**
    * @b Description:
    * Execute a command on a region.
@@ -342,18 +495,186 @@ public:
    */
   std::string command_request(const std::string &id, const std::string &region_name, const std::string& command);
 
+  /**
+   * @b Description:
+   * Handler for a PUT "learn" request message, the learn duty cycle of a
+   * region, @see Network::setLearnDutyCycle().  The duty cycle is kept
+   * across an eviction of the network.
+   *
+   * @param id  Identifier for the resource context (a Network class instance).
+   *            Client should pass the id returned by the previous "configure"
+   *            request message.
+   *
+   * @param region_name  The name of the region.
+   *
+   * @param every     Learn every Nth iteration, 0 to learn only on anomalies.
+   *                  Optional, 1 by default.
+   *
+   * @param anomaly   Also learn when the anomaly is at least this.
+   *                  Optional, no threshold by default.
+   *
+   * @param source    The region of the anomaly output.  Optional, the region
+   *                  itself by default.
+   *
+   * @retval            If success returns "OK".
+   *                    Otherwise returns error message starting with "ERROR: ".
+   */
+  std::string learn_request(const std::string &id, const std::string &region_name,
+                            const std::string &every, const std::string &anomaly = "",
+                            const std::string &source = "");
+
+  /**
+   * @b Description:
+   * Handler for a GET "subscribe" request message.
+   * Registers interest in outputs of the Network object.  At the end of every
+   * iteration of a run, the outputs are queued for the subscription as one
+   * JSON object:
+   *      {"iteration": <n>, "<region>.<output>": [ <array> ], ...}
+   * The events are read with next_event().  A subscriber which does not keep up
+   * loses the oldest events.
+   *
+   * @param id  Identifier for the resource context (a Network class instance).
+   *            Client should pass the id returned by the previous "configure"
+   *            request message.
+   *
+   * @param outputs  Comma separated list of "<region>.<output>" names.
+   *
+   * @param result   Output, the subscription id on success, otherwise the
+   *                 JSON encoded error message.
+   *
+   * @retval         true if @p result holds the subscription id.
+   */
+  bool subscribe_request(const std::string &id, const std::string &outputs, std::string &result);
+
+  /**
+   * @b Description:
+   * Waits up to @p timeout_ms for the next event of a subscription.
+   *
+   * @param event  Output, the next event, or empty if there was none in time.
+   *
+   * @retval       false if the subscription has ended, because it was unsubscribed
+   *               or its Network object was deleted, and all its events were read.
+   */
+  bool next_event(const std::string &subscription, std::string &event, unsigned int timeout_ms);
+
+  /**
+   * @b Description:
+   * Ends a subscription.
+   *
+   * @retval            If success returns "OK".
+   *                    Otherwise returns error message starting with "ERROR: ".
+   */
+  std::string unsubscribe_request(const std::string &subscription);
+
+  /**
+   * @b Description:
+   * Limits the memory of the resident Network objects.  When the sum of
+   * Network::memoryUsage() exceeds @p bytes, the least recently used idle
+   * networks are saved with saveToFile() into @p directory and released.
+   * They are reloaded transparently on their next request.  Networks with
+   * subscriptions are not evicted.
+   *
+   * @param bytes      The memory budget, 0 for no limit (the default).
+   * @param directory  Where the evicted networks are kept.  It is created if needed.
+   */
+  void set_memory_budget(size_t bytes, const std::string &directory);
+
+  /**
+   * @b Description:
+   * Handler for a GET "metrics" request message.
+   * The counters of all Network objects in the Prometheus text format, each
+   * labeled with the network id: iterations, a histogram of the run latency,
+   * the sizes of the Connections, memory usage, residency and the events
+   * queued for subscriptions.  The counters are read without waiting for
+   * the requests in progress, @see Network::getMetrics().
+   *
+   * @retval            The metrics, one sample per line.
+   */
+  std::string metrics_request();
+
 
 
 private:
+  struct ResourceContext;
+
+  struct Subscription {
+    std::vector<std::pair<std::shared_ptr<Region>, std::string>> outputs;
+    std::weak_ptr<ResourceContext> context;
+    std::deque<std::string> events;  // guarded by mutex
+    std::atomic<size_t> depth{0u};   // events.size(), for the metrics
+    bool closed = false;             // guarded by mutex
+    std::mutex mutex;
+    std::condition_variable ready;
+  };
+
   struct ResourceContext {
     std::string id;               // id for the resource
-    time_t t;                     // last access time
-    std::shared_ptr<Network> net; // context for this resource instance
+    time_t t;                     // last access time, guarded by RESTapi::mutex_
+    UInt64 lastUse = 0u;          // for the LRU eviction, guarded by RESTapi::mutex_
+    std::shared_ptr<Network> net; // context for this resource instance, null if evicted
+    std::string file;             // where the evicted network is saved
+    std::atomic<size_t> bytes{0u};// memoryUsage() of the resident network
+    std::shared_ptr<Network::Metrics> metrics = std::make_shared<Network::Metrics>(); // kept across evictions
+    std::atomic<bool> resident{true};// net is not null, for the metrics
+    std::mutex mutex;             // serializes the requests on this resource
+    std::vector<std::shared_ptr<Subscription>> subscriptions; // guarded by mutex
+    std::atomic<size_t> jobs{0u}; // unfinished jobs, a network with jobs is not evicted
+    bool released = false;        // deleted, guarded by mutex
+    // The learn duty cycles, re-applied after an eviction, guarded by mutex.
+    struct LearnDuty {
+      UInt every;
+      Real32 anomaly;
+      std::string source;
+    };
+    std::map<std::string, LearnDuty> learnDuty;
+  };
+
+  enum class JobState { Queued, Running, Done, Cancelled, Failed };
+
+  struct Job {
+    std::string id;
+    std::string network;                      // the id of the resource
+    std::shared_ptr<ResourceContext> context; // until the job is finished
+    UInt64 total = 0u;
+    std::atomic<UInt64> done{0u};   // iterations
+    std::atomic<bool> cancel{false};
+    JobState state = JobState::Queued; // guarded by mutex
+    std::string error;                 // guarded by mutex
+    std::mutex mutex;
   };
 
-  // A map of open resources. 
-  std::map<std::string, ResourceContext> resource_;
-  std::string get_new_id_(); 
+  // The Network callback queueing the events of the subscriptions.
+  static void publish_(Network *net, UInt64 iteration, void *context);
+  // Ends the subscriptions and removes the eviction file of a deleted network.
+  static void release_(ResourceContext &ctx);
+  // Runs a job on a job thread.
+  void run_job_(Job &job);
+  // Records the end of a job and forgets the oldest finished jobs.
+  void finish_job_(Job &job, JobState state, const std::string &error = "");
+
+  // A map of open resources.
+  // The server calls the handlers from its thread pool.  mutex_ guards only
+  // the map, each request then holds the mutex of its resource, so requests
+  // for different Network objects run in parallel.
+  std::map<std::string, std::shared_ptr<ResourceContext>> resource_;
+  std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<Subscription>> subscriptions_; // guarded by mutex_
+  unsigned int next_subscription_ = 1u;                               // guarded by mutex_
+  UInt64 use_count_ = 0u;                                              // guarded by mutex_
+  std::atomic<size_t> budget_{0u};
+  std::string evict_dir_;                                              // guarded by mutex_
+  std::map<std::string, std::shared_ptr<Job>> jobs_;                 // guarded by mutex_
+  std::deque<std::string> finished_jobs_;                              // guarded by mutex_, oldest first
+  unsigned int next_job_ = 1u;                                         // guarded by mutex_
+  size_t jobs_per_network_ = 1u;                                       // guarded by mutex_
+  size_t job_threads_ = 0u;                                            // guarded by mutex_
+  std::unique_ptr<ThreadPool> job_pool_;                               // created with the first job
+  std::string get_new_id_();
+  std::shared_ptr<ResourceContext> get_context_(const std::string &id);
+  // With the mutex of @p ctx held: reload the network if it was evicted.
+  void load_(ResourceContext &ctx);
+  // With the mutex of @p ctx held: evict idle networks over the budget.
+  void enforce_budget_(ResourceContext &ctx);
 };
 
 } // namespace htm
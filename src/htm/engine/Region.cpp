@@ -24,9 +24,11 @@ Methods related to inputs and outputs are in Region_io.cpp
 */
 
 #include <iostream>
+#include <istream>
 #include <memory>
 #include <set>
 #include <stdexcept>
+#include <streambuf>
 #include <string>
 
 #include <htm/engine/Input.hpp>
@@ -36,8 +38,10 @@ Methods related to inputs and outputs are in Region_io.cpp
 #include <htm/engine/RegionImpl.hpp>
 #include <htm/engine/RegionImplFactory.hpp>
 #include <htm/engine/Spec.hpp>
+#include <htm/engine/Tracer.hpp>
 #include <htm/ntypes/Array.hpp>
 #include <htm/ntypes/BasicType.hpp>
+#include <htm/os/ThreadAffinity.hpp>
 #include <htm/types/Sdr.hpp>
 #include <htm/utils/Log.hpp>
 
@@ -48,14 +52,15 @@ class GenericRegisteredRegionImpl;
 // Create region from parameter spec
 Region::Region(const std::string &name, const std::string &nodeType, const std::string &nodeParams, Network *network)
     : name_(std::move(name)), type_(nodeType), initialized_(false), network_(network), profilingEnabled_(false) {
-  ValueMap vm;
-  vm.parse(nodeParams);
+  // The type and the parsed parameters are cached, for many regions alike.
+  RegionImplFactory &factory = RegionImplFactory::getInstance();
+  const auto prototype = factory.getPrototype(nodeType, nodeParams);
   // Set region spec and input/outputs before creating the RegionImpl so that the
   // Impl has access to the region info in its constructor.
-  RegionImplFactory &factory = RegionImplFactory::getInstance();
-  spec_ = factory.getSpec(nodeType);
+  spec_ = prototype->spec;
   createInputsAndOutputs_();
-  impl_.reset(factory.createRegionImpl(nodeType, vm, this));
+  impl_.reset(factory.createRegionImpl(*prototype, this));
+  impl_->bindPorts();
 }
 Region::Region(const std::string &name, const std::string &nodeType, ValueMap &vm, Network *network) {
   name_ = name;
@@ -70,6 +75,7 @@ Region::Region(const std::string &name, const std::string &nodeType, ValueMap &v
   spec_ = factory.getSpec(nodeType);
   createInputsAndOutputs_();
   impl_.reset(factory.createRegionImpl(nodeType, vm, this));
+  impl_->bindPorts();
   
   //std::cerr << "Region created " << getName() << "=" << nodeType << "\n";
   //auto outputs = getOutputs();
@@ -159,7 +165,7 @@ void Region::initialize() {
     }
   }
 
-  impl_->initialize();
+  loadedImpl_()->initialize();
   initialized_ = true;
 }
 
@@ -179,7 +185,7 @@ std::string Region::executeCommand(const std::vector<std::string> &args) {
   if (profilingEnabled_)
     executeTimer_.start();
 
-  retVal = impl_->executeCommand(args, (UInt64)(-1));
+  retVal = loadedImpl_()->executeCommand(args, (UInt64)(-1));
 
   if (profilingEnabled_)
     executeTimer_.stop();
@@ -192,13 +198,32 @@ void Region::compute() {
     NTA_THROW << "Region " << getName()
               << " unable to compute because not initialized";
 
-  if (profilingEnabled_)
-    computeTimer_.start();
-
-  impl_->compute();
+  if (loadedImpl_()->isPure()) {
+    UInt64 version = 0u;
+    for (const auto &input : inputs_) {
+      version += input.second->getVersion();
+    }
+    if (computed_ and version == inputsVersion_)
+      return;
+    inputsVersion_ = version;
+  }
+  computed_ = true;
 
-  if (profilingEnabled_)
+  ScopedAffinity pinned(affinity_);
+  Tracer::Scope traced(tracer_, traceName_, Tracer::Cat_Compute);
+  if (profilingEnabled_) {
+    const Real64 before = computeTimer_.getElapsed();
+    computeTimer_.start();
+    loadedImpl_()->compute();
     computeTimer_.stop();
+    computeHistogram_.add(computeTimer_.getElapsed() - before);
+  } else {
+    loadedImpl_()->compute();
+  }
+
+  for (const auto &output : outputs_) {
+    output.second->touch();
+  }
 
   return;
 }
@@ -215,11 +240,11 @@ void Region::evaluateLinks() {
 }
 
 size_t Region::getNodeInputElementCount(const std::string &name) {
-  size_t count = impl_->getNodeInputElementCount(name);
+  size_t count = loadedImpl_()->getNodeInputElementCount(name);
   return count;
 }
 size_t Region::getNodeOutputElementCount(const std::string &name) {
-  size_t count = impl_->getNodeOutputElementCount(name);
+  size_t count = loadedImpl_()->getNodeOutputElementCount(name);
   return count;
 }
 
@@ -227,7 +252,7 @@ size_t Region::getNodeOutputElementCount(const std::string &name) {
 Dimensions Region::askImplForInputDimensions(const std::string &name) const {
   Dimensions dim;
   try {
-    dim = impl_->askImplForInputDimensions(name);
+    dim = loadedImpl_()->askImplForInputDimensions(name);
   } catch (Exception &e) {
       NTA_THROW << "Internal error -- the dimensions for the input " << name
                 << "is unknown. : " << e.what();
@@ -237,7 +262,7 @@ Dimensions Region::askImplForInputDimensions(const std::string &name) const {
 Dimensions Region::askImplForOutputDimensions(const std::string &name) const {
   Dimensions dim;
   try {
-    dim = impl_->askImplForOutputDimensions(name);
+    dim = loadedImpl_()->askImplForOutputDimensions(name);
   } catch (Exception &e) {
       NTA_THROW << "Internal error -- the dimensions for the input " << name
                 << "is unknown. : " << e.what();
@@ -288,10 +313,10 @@ void Region::setOutputDimensions(std::string name, const Dimensions& dim) {
 // This sets a global dimension.
 void Region::setDimensions(Dimensions dim) {
   NTA_CHECK(!initialized_) << "Cannot set region dimensions after initialization.";
-  impl_->setDimensions(dim);
+  loadedImpl_()->setDimensions(dim);
 }
 Dimensions Region::getDimensions() const {
-  return impl_->getDimensions();
+  return loadedImpl_()->getDimensions();
 }
 
 
@@ -314,6 +339,18 @@ void Region::disableProfiling() { profilingEnabled_ = false; }
 void Region::resetProfiling() {
   computeTimer_.reset();
   executeTimer_.reset();
+  computeHistogram_.reset();
+  for (const auto &input : inputs_) {
+    for (const auto &link : input.second->getLinks()) {
+      link->resetProfile();
+    }
+  }
+}
+
+void Region::setTracer(Tracer *tracer) {
+  tracer_ = tracer;
+  if (tracer_ != nullptr)
+    traceName_ = tracer_->intern(name_);
 }
 
 const Timer &Region::getComputeTimer() const { return computeTimer_; }
@@ -384,9 +421,11 @@ bool Region::operator==(const Region &o) const {
     return false;
   }
 
-  if (impl_ && !o.impl_) return false;
-  if (!impl_ && o.impl_) return false;
-  if (impl_ && *impl_.get() != *o.impl_.get()) return false;
+  const RegionImpl *impl = loadedImpl_();
+  const RegionImpl *otherImpl = o.loadedImpl_();
+  if (impl && !otherImpl) return false;
+  if (!impl && otherImpl) return false;
+  if (impl && *impl != *otherImpl) return false;
 
   return true;
 }
@@ -399,7 +438,7 @@ bool Region::hasOutput(const std::string &name) const {
 }
 bool Region::hasInput(const std::string &name) const {
   auto in = getInput(name);
-  if (in) return in->hasIncomingLinks();
+  if (in) return in->hasIncomingLinks() or in->isBound();
   return false;
 }
 
@@ -433,6 +472,9 @@ const Array& Region::getOutputData(const std::string &outputName) const {
     NTA_THROW << "getOutputData -- unknown output '" << outputName
               << "' on region " << getName();
 
+  // Fill an output which compute() skipped because it has no links.
+  if (impl_ && !implPending_.load(std::memory_order_acquire))
+    impl_->produceOutput(outputName);
   const Array& data = oi->second->getData();
   return data;
 }
@@ -455,6 +497,7 @@ void Region::setInputData(const std::string &inputName, const Array& data) {
 	in->setDimensions( { (UInt)data.getCount() } );
   Array& a = in->getData();
 	data.convertInto(a);
+  in->touch();
 }
 
 void Region::prepareInputs() {
@@ -468,31 +511,31 @@ void Region::prepareInputs() {
 // setParameter
 
 void Region::setParameterInt32(const std::string &name, Int32 value) {
-  impl_->setParameterInt32(name, (Int64)-1, value);
+  loadedImpl_()->setParameterInt32(name, (Int64)-1, value);
 }
 
 void Region::setParameterUInt32(const std::string &name, UInt32 value) {
-  impl_->setParameterUInt32(name, (Int64)-1, value);
+  loadedImpl_()->setParameterUInt32(name, (Int64)-1, value);
 }
 
 void Region::setParameterInt64(const std::string &name, Int64 value) {
-  impl_->setParameterInt64(name, (Int64)-1, value);
+  loadedImpl_()->setParameterInt64(name, (Int64)-1, value);
 }
 
 void Region::setParameterUInt64(const std::string &name, UInt64 value) {
-  impl_->setParameterUInt64(name, (Int64)-1, value);
+  loadedImpl_()->setParameterUInt64(name, (Int64)-1, value);
 }
 
 void Region::setParameterReal32(const std::string &name, Real32 value) {
-  impl_->setParameterReal32(name, (Int64)-1, value);
+  loadedImpl_()->setParameterReal32(name, (Int64)-1, value);
 }
 
 void Region::setParameterReal64(const std::string &name, Real64 value) {
-  impl_->setParameterReal64(name, (Int64)-1, value);
+  loadedImpl_()->setParameterReal64(name, (Int64)-1, value);
 }
 
 void Region::setParameterBool(const std::string &name, bool value) { 
-impl_->setParameterBool(name, (Int64)-1, value); 
+loadedImpl_()->setParameterBool(name, (Int64)-1, value); 
 }
 
 void Region::setParameterJSON(const std::string &name, const std::string &value) {
@@ -535,19 +578,140 @@ void Region::setParameterJSON(const std::string &name, const std::string &value)
 
 // getParameter
 
-Int32 Region::getParameterInt32(const std::string &name) const { return impl_->getParameterInt32(name, (Int64)-1); }
+Int32 Region::getParameterInt32(const std::string &name) const { return loadedImpl_()->getParameterInt32(name, (Int64)-1); }
+
+Int64 Region::getParameterInt64(const std::string &name) const { return loadedImpl_()->getParameterInt64(name, (Int64)-1); }
 
-Int64 Region::getParameterInt64(const std::string &name) const { return impl_->getParameterInt64(name, (Int64)-1); }
+UInt32 Region::getParameterUInt32(const std::string &name) const { return loadedImpl_()->getParameterUInt32(name, (Int64)-1); }
 
-UInt32 Region::getParameterUInt32(const std::string &name) const { return impl_->getParameterUInt32(name, (Int64)-1); }
+UInt64 Region::getParameterUInt64(const std::string &name) const { return loadedImpl_()->getParameterUInt64(name, (Int64)-1); }
 
-UInt64 Region::getParameterUInt64(const std::string &name) const { return impl_->getParameterUInt64(name, (Int64)-1); }
+Real32 Region::getParameterReal32(const std::string &name) const { return loadedImpl_()->getParameterReal32(name, (Int64)-1); }
 
-Real32 Region::getParameterReal32(const std::string &name) const { return impl_->getParameterReal32(name, (Int64)-1); }
+Real64 Region::getParameterReal64(const std::string &name) const { return loadedImpl_()->getParameterReal64(name, (Int64)-1); }
 
-Real64 Region::getParameterReal64(const std::string &name) const { return impl_->getParameterReal64(name, (Int64)-1); }
+bool Region::getParameterBool(const std::string &name) const { return loadedImpl_()->getParameterBool(name, (Int64)-1); }
 
-bool Region::getParameterBool(const std::string &name) const { return impl_->getParameterBool(name, (Int64)-1); }
+bool Region::isPure() const {
+  const RegionImpl *impl = loadedImpl_();
+  return impl != nullptr && impl->isPure();
+}
+
+void Region::setAffinity(const std::vector<UInt> &cores) {
+  affinity_ = ThreadAffinity::normalize(cores);
+}
+
+void Region::setThreadBudget(UInt numThreads) { loadedImpl_()->setThreadBudget(numThreads); }
+
+void Region::reduceMemoryUsage() { loadedImpl_()->reduceMemoryUsage(); }
+
+UInt Region::setShedLevel(UInt level) { return loadedImpl_()->setShedLevel(level); }
+
+std::vector<const Connections *> Region::getConnections() const {
+  if (implPending_ or impl_ == nullptr)
+    return {};
+  return impl_->getConnections();
+}
+
+size_t Region::memoryUsage() const {
+  size_t bytes = 0u;
+  if (implPending_)
+    bytes += pendingArchive_->size(); // not loaded yet, @see loadLazy_()
+  else if (impl_ != nullptr)
+    bytes += impl_->memoryUsage();
+  for (const auto &out : outputs_) {
+    const Array &a = out.second->getData();
+    bytes += a.getCount() * BasicType::getSize(a.getType());
+  }
+  for (const auto &in : inputs_) {
+    if (!in.second->isInitialized())
+      continue;
+    const Array &a = in.second->getData();
+    bytes += a.getCount() * BasicType::getSize(a.getType());
+  }
+  return bytes;
+}
+
+ParameterHandle Region::getParameterHandle(const std::string &name) const {
+  if (!spec_->parameters.contains(name))
+    NTA_THROW << "getParameterHandle -- unknown parameter '" << name << "' on region "
+              << getName();
+  return {name, spec_->parameters.getByName(name).dataType, loadedImpl_()->resolveParameter(name)};
+}
+
+// The access by id if the region resolved the parameter, else by name.
+template <typename T>
+static T getByHandle(RegionImpl &impl, const ParameterHandle &handle, NTA_BasicType type,
+                     T (RegionImpl::*byName)(const std::string &, Int64)) {
+  T value;
+  if (handle.id >= 0 && impl.getParameterById(handle.id, type, &value))
+    return value;
+  return (impl.*byName)(handle.name, (Int64)-1);
+}
+
+template <typename T>
+static void setByHandle(RegionImpl &impl, const ParameterHandle &handle, NTA_BasicType type,
+                        T value, void (RegionImpl::*byName)(const std::string &, Int64, T)) {
+  if (handle.id >= 0 && impl.setParameterById(handle.id, type, &value))
+    return;
+  (impl.*byName)(handle.name, (Int64)-1, value);
+}
+
+Int32 Region::getParameterInt32(const ParameterHandle &handle) const {
+  return getByHandle<Int32>(*loadedImpl_(), handle, NTA_BasicType_Int32, &RegionImpl::getParameterInt32);
+}
+
+UInt32 Region::getParameterUInt32(const ParameterHandle &handle) const {
+  return getByHandle<UInt32>(*loadedImpl_(), handle, NTA_BasicType_UInt32, &RegionImpl::getParameterUInt32);
+}
+
+Int64 Region::getParameterInt64(const ParameterHandle &handle) const {
+  return getByHandle<Int64>(*loadedImpl_(), handle, NTA_BasicType_Int64, &RegionImpl::getParameterInt64);
+}
+
+UInt64 Region::getParameterUInt64(const ParameterHandle &handle) const {
+  return getByHandle<UInt64>(*loadedImpl_(), handle, NTA_BasicType_UInt64, &RegionImpl::getParameterUInt64);
+}
+
+Real32 Region::getParameterReal32(const ParameterHandle &handle) const {
+  return getByHandle<Real32>(*loadedImpl_(), handle, NTA_BasicType_Real32, &RegionImpl::getParameterReal32);
+}
+
+Real64 Region::getParameterReal64(const ParameterHandle &handle) const {
+  return getByHandle<Real64>(*loadedImpl_(), handle, NTA_BasicType_Real64, &RegionImpl::getParameterReal64);
+}
+
+bool Region::getParameterBool(const ParameterHandle &handle) const {
+  return getByHandle<bool>(*loadedImpl_(), handle, NTA_BasicType_Bool, &RegionImpl::getParameterBool);
+}
+
+void Region::setParameterInt32(const ParameterHandle &handle, Int32 value) {
+  setByHandle<Int32>(*loadedImpl_(), handle, NTA_BasicType_Int32, value, &RegionImpl::setParameterInt32);
+}
+
+void Region::setParameterUInt32(const ParameterHandle &handle, UInt32 value) {
+  setByHandle<UInt32>(*loadedImpl_(), handle, NTA_BasicType_UInt32, value, &RegionImpl::setParameterUInt32);
+}
+
+void Region::setParameterInt64(const ParameterHandle &handle, Int64 value) {
+  setByHandle<Int64>(*loadedImpl_(), handle, NTA_BasicType_Int64, value, &RegionImpl::setParameterInt64);
+}
+
+void Region::setParameterUInt64(const ParameterHandle &handle, UInt64 value) {
+  setByHandle<UInt64>(*loadedImpl_(), handle, NTA_BasicType_UInt64, value, &RegionImpl::setParameterUInt64);
+}
+
+void Region::setParameterReal32(const ParameterHandle &handle, Real32 value) {
+  setByHandle<Real32>(*loadedImpl_(), handle, NTA_BasicType_Real32, value, &RegionImpl::setParameterReal32);
+}
+
+void Region::setParameterReal64(const ParameterHandle &handle, Real64 value) {
+  setByHandle<Real64>(*loadedImpl_(), handle, NTA_BasicType_Real64, value, &RegionImpl::setParameterReal64);
+}
+
+void Region::setParameterBool(const ParameterHandle &handle, bool value) {
+  setByHandle<bool>(*loadedImpl_(), handle, NTA_BasicType_Bool, value, &RegionImpl::setParameterBool);
+}
 
 std::string Region::getParameterJSON(const std::string &name, const std::string &tag = std::string()) const {
   NTA_BasicType type = NTA_BasicType_Last; // initialize to an invalid type.
@@ -632,23 +796,23 @@ std::string Region::getParameterJSON(const std::string &name, const std::string
 // array parameters
 
 void Region::getParameterArray(const std::string &name, Array &array) const {
-  impl_->getParameterArray(name, (Int64)-1, array);
+  loadedImpl_()->getParameterArray(name, (Int64)-1, array);
 }
 
 void Region::setParameterArray(const std::string &name, const Array &array) {
-  impl_->setParameterArray(name, (Int64)-1, array);
+  loadedImpl_()->setParameterArray(name, (Int64)-1, array);
 }
 
 size_t Region::getParameterArrayCount(const std::string &name) {
-  return impl_->getParameterArrayCount(name, (Int64)-1);
+  return loadedImpl_()->getParameterArrayCount(name, (Int64)-1);
 }
 
 void Region::setParameterString(const std::string &name, const std::string &s) {
-  impl_->setParameterString(name, (Int64)-1, s);
+  loadedImpl_()->setParameterString(name, (Int64)-1, s);
 }
 
 std::string Region::getParameterString(const std::string &name) const {
-  return impl_->getParameterString(name, (Int64)-1);
+  return loadedImpl_()->getParameterString(name, (Int64)-1);
 }
 
 bool Region::isParameter(const std::string &name) const {
@@ -685,7 +849,7 @@ void Region::loadDims_(std::map<std::string,Dimensions>& outDims,
 
 void Region::getOutputBuffers_(std::map<std::string, Array>& buffers) const {
 	for (auto iter : outputs_) {
-    buffers[iter.first] = iter.second->getData();
+    buffers[iter.first] = getOutputData(iter.first);
 	}
 }
 
@@ -701,11 +865,66 @@ void Region::restoreOutputBuffers_(const std::map<std::string, Array>& buffers)
 
 
 void Region::serializeImpl(ArWrapper& arw) const{
-    impl_->cereal_adapter_save(arw);
+    loadedImpl_()->cereal_adapter_save(arw);
 }
 void Region::deserializeImpl(ArWrapper& arw) {
     RegionImplFactory &factory = RegionImplFactory::getInstance();
     impl_.reset(factory.deserializeRegionImpl(type_, arw, this));
+    impl_->bindPorts(); // the Inputs and Outputs were restored before the impl
+}
+
+// An input stream over bytes in memory, without copying them.
+namespace {
+class MemoryBuffer : public std::streambuf {
+public:
+  MemoryBuffer(const char *data, size_t size) {
+    char *begin = const_cast<char *>(data);
+    setg(begin, begin, begin + size);
+  }
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode) override {
+    char *target = (dir == std::ios_base::beg ? eback() : dir == std::ios_base::cur ? gptr() : egptr()) + off;
+    if (target < eback() || target > egptr())
+      return pos_type(off_type(-1));
+    setg(eback(), target, egptr());
+    return pos_type(target - eback());
+  }
+  pos_type seekpos(pos_type pos, std::ios_base::openmode mode) override {
+    return seekoff(off_type(pos), std::ios_base::beg, mode);
+  }
+};
+} // namespace
+
+void Region::loadLazy_(const std::shared_ptr<const std::string> &archive) {
+  MemoryBuffer buffer(archive->data(), archive->size());
+  std::istream in(&buffer);
+  bool init;
+  {
+    cereal::BinaryInputArchive ar(in);
+    loadHeader_(ar, pendingDim_, init);
+  }
+  pendingOffset_ = static_cast<size_t>(in.tellg());
+  pendingArchive_ = archive;
+  initialized_ = init;
+  implPending_.store(true, std::memory_order_release);
+}
+
+void Region::loadImpl_() const {
+  std::lock_guard<std::mutex> lock(implMutex_);
+  if (!implPending_.load(std::memory_order_relaxed))
+    return; // loaded by another thread
+  Region *self = const_cast<Region *>(this);
+  MemoryBuffer buffer(pendingArchive_->data() + pendingOffset_, pendingArchive_->size() - pendingOffset_);
+  std::istream in(&buffer);
+  {
+    cereal::BinaryInputArchive ar(in);
+    ArWrapper arw(&ar);
+    self->deserializeImpl(arw);
+  }
+  impl_->setDimensions(pendingDim_); // as load_ar() does
+  pendingArchive_.reset();
+  implPending_.store(false, std::memory_order_release);
 }
 
 std::ostream &operator<<(std::ostream &f, const Region &r) {
@@ -25,7 +25,10 @@
 #ifndef NTA_REGION_HPP
 #define NTA_REGION_HPP
 
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 #include <vector>
@@ -35,6 +38,7 @@
 #include <htm/engine/Spec.hpp>
 #include <htm/ntypes/Dimensions.hpp>
 #include <htm/os/Timer.hpp>
+#include <htm/utils/LatencyHistogram.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/ntypes/Value.hpp>
@@ -49,6 +53,18 @@ class Spec;
 class BundleIO;
 class Timer;
 class Network;
+class Tracer;
+class Connections;
+
+/**
+ * A parameter of a region, resolved once by Region::getParameterHandle()
+ * for frequent get/set calls.
+ */
+struct ParameterHandle {
+  std::string name;
+  NTA_BasicType dataType; // from the Spec
+  Int32 id;               // from RegionImpl::resolveParameter(), -1 if none
+};
 
 /**
  * Represents a set of one or more "identical" nodes in a Network.
@@ -163,6 +179,32 @@ public:
   void setParameterBool(const std::string &name, bool value);
   void setParameterJSON(const std::string &name, const std::string& value);
 
+  /**
+   * Resolve a parameter of the Spec once, so that frequent get/set calls do
+   * not look it up by name.  The handle is valid for the regions of the same
+   * type.
+   *
+   *    ParameterHandle boost = region->getParameterHandle("boostStrength");
+   *    for (...) region->setParameterReal32(boost, value);
+   */
+  ParameterHandle getParameterHandle(const std::string &name) const;
+
+  Int32 getParameterInt32(const ParameterHandle &handle) const;
+  UInt32 getParameterUInt32(const ParameterHandle &handle) const;
+  Int64 getParameterInt64(const ParameterHandle &handle) const;
+  UInt64 getParameterUInt64(const ParameterHandle &handle) const;
+  Real32 getParameterReal32(const ParameterHandle &handle) const;
+  Real64 getParameterReal64(const ParameterHandle &handle) const;
+  bool getParameterBool(const ParameterHandle &handle) const;
+
+  void setParameterInt32(const ParameterHandle &handle, Int32 value);
+  void setParameterUInt32(const ParameterHandle &handle, UInt32 value);
+  void setParameterInt64(const ParameterHandle &handle, Int64 value);
+  void setParameterUInt64(const ParameterHandle &handle, UInt64 value);
+  void setParameterReal32(const ParameterHandle &handle, Real32 value);
+  void setParameterReal64(const ParameterHandle &handle, Real64 value);
+  void setParameterBool(const ParameterHandle &handle, bool value);
+
   /**
    * Get the parameter as an @c Array value.
    *
@@ -323,6 +365,8 @@ public:
    *        Note that this is read-only.
    *        To obtain a writeable Array use
    *			  region->getOutput(name)->getData();
+   *        A region may skip computing outputs without links; this method
+   *        produces such an output first, getOutput(name)->getData() does not.
    */
   virtual const Array &getOutputData(const std::string &outputName) const;
 	
@@ -361,6 +405,17 @@ public:
    */
   void compute();
 
+  /**
+   * Pin the thread which computes this region to a set of cores, for the
+   * duration of compute(), ex: the cores of the NUMA node which holds its
+   * memory.  The thread returns to the cores of the network afterwards,
+   * @see Network::setAffinity().  The empty set (the default) does not pin.
+   *
+   * This is a runtime setting, it is not serialized.
+   */
+  void setAffinity(const std::vector<UInt> &cores);
+  const std::vector<UInt> &getAffinity() const { return affinity_; }
+
   /**
    * @}
    *
@@ -371,17 +426,21 @@ public:
    */
 
   /**
-   * Enable profiling of the compute and execute operations
+   * Enable profiling of the compute and execute operations, and of the
+   * links into this region, @see Link::getProfile().
    */
   void enableProfiling();
 
+  bool isProfiling() const { return profilingEnabled_; }
+
   /**
    * Disable profiling of the compute and execute operations
    */
   void disableProfiling();
 
   /**
-   * Reset the compute and execute timers
+   * Reset the compute and execute timers, and the profiles of the links
+   * into this region.
    */
   void resetProfiling();
 
@@ -401,6 +460,30 @@ public:
    */
   const Timer &getExecuteTimer() const;
 
+  /**
+   * The durations of the compute operations, for percentiles.
+   */
+  const LatencyHistogram &getComputeHistogram() const { return computeHistogram_; }
+
+  /**
+   * Record the computes of this region, and the transfers of the links into
+   * it, in @param tracer; nullptr to stop.  @see Network::enableTracing().
+   */
+  void setTracer(Tracer *tracer);
+  Tracer *getTracer() const { return tracer_; }
+
+  /**
+   * Estimate the heap memory held by this region, in bytes: the algorithm
+   * (ex: the Connections of a SP or TM) and the Input/Output buffers.
+   */
+  size_t memoryUsage() const;
+
+  /**
+   * The Connections of the algorithm, @see RegionImpl::getConnections().
+   * None while the region is not loaded.
+   */
+  std::vector<const Connections *> getConnections() const;
+
   bool operator==(const Region &other) const;
   inline bool operator!=(const Region &other) const {
     return !operator==(other);
@@ -424,6 +507,18 @@ public:
 
   bool isInitialized() const { return initialized_; }
 
+  // See RegionImpl::isPure()
+  bool isPure() const;
+
+  // See RegionImpl::setThreadBudget()
+  void setThreadBudget(UInt numThreads);
+
+  // See RegionImpl::reduceMemoryUsage()
+  void reduceMemoryUsage();
+
+  // See RegionImpl::setShedLevel()
+  UInt setShedLevel(UInt level);
+
   // Used by RegionImpl to get inputs/outputs
   bool hasOutput(const std::string &name) const;
   bool hasInput(const std::string &name) const;
@@ -503,6 +598,21 @@ public:
   void load_ar(Archive& ar) {
     Dimensions dim;
     bool init;
+    loadHeader_(ar, dim, init);
+
+    // deserialize the RegionImpl plugin and its algorithm
+    ArWrapper arw(&ar);
+    deserializeImpl(arw);
+
+    // set the region dimensions.
+    initialized_ = false; // setDimensions requires initialization off.
+    setDimensions(dim);
+    initialized_ = init;
+  }
+
+  // Everything of load_ar() before the RegionImpl.
+  template<class Archive>
+  void loadHeader_(Archive& ar, Dimensions &dim, bool &init) {
     ar(cereal::make_nvp("name", name_));
     ar(cereal::make_nvp("nodeType", type_));
     ar(cereal::make_nvp("initialized", init));
@@ -518,15 +628,6 @@ public:
     ar(cereal::make_nvp("outputs", buffers));
     restoreOutputBuffers_(buffers);
     loadDims_(outDims, inDims);
-
-    // deserialize the RegionImpl plugin and its algorithm
-    ArWrapper arw(&ar);
-    deserializeImpl(arw);
-
-    // set the region dimensions.
-    initialized_ = false; // setDimensions requires initialization off.
-    setDimensions(dim);
-    initialized_ = init;
   }
 
   friend class Network;  // so Network can set Network* network_; during addRegion( ).
@@ -547,10 +648,29 @@ private:
   void serializeImpl(ArWrapper& ar) const;
   void deserializeImpl(ArWrapper& ar);
 
+  /**
+   * Lazy loading, @see Network::loadFromChunkedFile().  loadLazy_() reads
+   * the region from a BINARY archive up to its RegionImpl and keeps the
+   * archive.  The RegionImpl is deserialized from it on first use, ie. the
+   * first compute(), parameter access or command.
+   */
+  void loadLazy_(const std::shared_ptr<const std::string> &archive);
+  RegionImpl *loadedImpl_() const {
+    if (implPending_.load(std::memory_order_acquire))
+      loadImpl_();
+    return impl_.get();
+  }
+  void loadImpl_() const;
+
   std::string name_;
 
-  // pointer to the "plugin"; owned by Region
-  std::shared_ptr<RegionImpl> impl_;
+  // pointer to the "plugin"; owned by Region, set by loadImpl_() after a lazy load
+  mutable std::shared_ptr<RegionImpl> impl_;
+  mutable std::atomic<bool> implPending_{false};
+  mutable std::mutex implMutex_;
+  mutable std::shared_ptr<const std::string> pendingArchive_;
+  size_t pendingOffset_ = 0u;  // of the RegionImpl in pendingArchive_
+  Dimensions pendingDim_;
   std::string type_;
   std::shared_ptr<Spec> spec_;
 
@@ -560,6 +680,9 @@ private:
   OutputMap outputs_;
   InputMap inputs_;
   bool initialized_;
+  bool computed_ = false;
+  UInt64 inputsVersion_ = 0u; // sum of the input versions at the last compute
+  std::vector<UInt> affinity_; // cores of compute(), empty if not pinned
 
   // Region contains a backpointer to network_ only to be able
   // to retrieve the containing network via getNetwork() for inspectors.
@@ -571,6 +694,9 @@ private:
   bool profilingEnabled_;
   Timer computeTimer_;
   Timer executeTimer_;
+  LatencyHistogram computeHistogram_;
+  Tracer *tracer_ = nullptr;
+  UInt32 traceName_ = 0u; // the region name, interned in tracer_
 };
 
 } // namespace htm
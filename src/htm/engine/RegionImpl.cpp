@@ -218,6 +218,14 @@ std::shared_ptr<Output> RegionImpl::getOutput(const std::string &name) const {
   NTA_CHECK(out != nullptr) << "Requested output not found: " << name;
   return out;
 }
+Input *RegionImpl::bindInput(const std::string &name) const {
+  auto in = region_->getInput(name);
+  NTA_CHECK(in != nullptr) << "Requested input not found: " << name;
+  return in.get();
+}
+
+Output *RegionImpl::bindOutput(const std::string &name) const { return getOutput(name).get(); }
+
 Dimensions RegionImpl::getInputDimensions(const std::string &name) const { return region_->getInputDimensions(name); }
 Dimensions RegionImpl::getOutputDimensions(const std::string &name) const { return region_->getOutputDimensions(name); }
 
@@ -152,6 +152,7 @@ class Input;
 class Output;
 class Array;
 class NodeSet;
+class Connections;
 
 class RegionImpl
 {
@@ -205,6 +206,15 @@ public:
                                   const std::string &s);
   virtual std::string getParameterString(const std::string &name, Int64 index);
 
+  // Access by id, used by Region::getParameterHandle().  A region may
+  // return an id >= 0 for the parameters which are set often, and then
+  // get/set them with a switch on the id, without comparing names.
+  // The value points to a variable of the given type.  Return false to
+  // fall back to the access by name.
+  virtual Int32 resolveParameter(const std::string &name) const { return -1; }
+  virtual bool getParameterById(Int32 id, NTA_BasicType type, void *value) { return false; }
+  virtual bool setParameterById(Int32 id, NTA_BasicType type, const void *value) { return false; }
+
   /* -------- Methods that must be implemented by subclasses -------- */
 
   /**
@@ -239,6 +249,56 @@ public:
   // Compute outputs from inputs and internal state
   virtual void compute() = 0;
 
+  // Called by the Region once the Inputs and Outputs of this region exist:
+  // after the constructor and after deserialization.  A region caches the
+  // Inputs and Outputs which its compute() uses (@see bindInput()), so that
+  // compute() does not look them up by name in every iteration.
+  virtual void bindPorts() {}
+
+  // compute() may skip an output which has no outgoing links, see
+  // Output::hasOutgoingLinks().  Readers other than the links, such as
+  // Region::getOutputData() and serialization, call produceOutput() first so
+  // that the region fills a skipped output from its current state.
+  virtual void produceOutput(const std::string & /*name*/) {}
+
+  // A pure region computes the same outputs from the same inputs, so its
+  // compute() is skipped when no input changed since the last compute.
+  // The inputs of a pure region also skip copying unchanged sources.
+  virtual bool isPure() const { return false; }
+
+  // The number of threads, including the calling thread, which the Network
+  // grants this region for its own parallel kernels (@see
+  // Network::setThreadBudget).  Regions without parallel kernels ignore it.
+  virtual void setThreadBudget(UInt numThreads) {}
+
+  // The optional work which a region may shed in one compute() to keep the
+  // deadline of Network::runWithDeadline().  The levels are cumulative, the
+  // least valuable work goes first.
+  enum ShedLevel : UInt {
+    Shed_None = 0u,
+    Shed_Maintenance = 1u, // defer the maintenance of the Connections
+    Shed_Outputs = 2u,     // also skip the optional outputs, produced on demand
+    Shed_Learning = 3u,    // also do not learn
+  };
+
+  // Set before each compute() under Network::runWithDeadline(), and back to
+  // Shed_None after the run.  Returns the level the region sheds, at most
+  // @p level.  Regions without optional work ignore it.
+  virtual UInt setShedLevel(UInt level) { return Shed_None; }
+
+  // Estimate of the heap memory held by the algorithm of this region, in
+  // bytes, without the Input/Output buffers which the Region counts itself.
+  virtual size_t memoryUsage() const { return 0u; }
+
+  // Called when the Network exceeds its memory limit (@see
+  // Network::setMemoryLimit).  Release what can be released without
+  // changing the results, ex: caches, storage of destroyed synapses.
+  virtual void reduceMemoryUsage() {}
+
+  // The Connections of the algorithm of this region, for their sizes in the
+  // metrics of the Network (@see Network::getMetrics).
+  virtual std::vector<const Connections *> getConnections() const { return {}; }
+
   /* -------- Methods that may be overridden by subclasses -------- */
 
   // Execute a command
@@ -328,6 +388,11 @@ protected:
 
   std::shared_ptr<Input> getInput(const std::string &name) const;
   std::shared_ptr<Output> getOutput(const std::string &name) const;
+
+  // The Input or Output to cache in bindPorts().  The Region owns it, the
+  // pointer is valid for the life of the Region.  Throws if not found.
+  Input *bindInput(const std::string &name) const;
+  Output *bindOutput(const std::string &name) const;
   Dimensions getInputDimensions(const std::string &name="") const;
   Dimensions getOutputDimensions(const std::string &name="") const;
 
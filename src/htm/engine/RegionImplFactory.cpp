@@ -35,11 +35,17 @@
 #include <htm/regions/DateEncoderRegion.hpp>
 #include <htm/regions/ScalarEncoderRegion.hpp>
 #include <htm/regions/RDSEEncoderRegion.hpp>
+#include <htm/regions/CategoryEncoderRegion.hpp>
 #include <htm/regions/FileOutputRegion.hpp>
 #include <htm/regions/FileInputRegion.hpp>
 #include <htm/regions/SPRegion.hpp>
 #include <htm/regions/TMRegion.hpp>
 #include <htm/regions/ClassifierRegion.hpp>
+#include <htm/regions/KNNClassifierRegion.hpp>
+#include <htm/regions/HTMPipelineRegion.hpp>
+#include <htm/regions/RemoteInputRegion.hpp>
+#include <htm/regions/RemoteOutputRegion.hpp>
+#include <htm/regions/ReplayRegion.hpp>
 
 
 #include <htm/utils/Log.hpp>
@@ -78,6 +84,7 @@ void RegionImplFactory::unregisterRegion(const std::string nodeType) {
   RegionImplFactory& instance = getInstance();
   if (instance.regionTypeMap.find(nodeType) != instance.regionTypeMap.end()) {
     instance.regionTypeMap.erase(nodeType);
+    clearPrototypes();
   }
 }
 
@@ -92,12 +99,18 @@ RegionImplFactory &RegionImplFactory::getInstance() {
 	  instance.addRegionType("DateEncoderRegion", new RegisteredRegionImplCpp<DateEncoderRegion>());
     instance.addRegionType("ScalarEncoderRegion", new RegisteredRegionImplCpp<ScalarEncoderRegion>());
     instance.addRegionType("RDSEEncoderRegion", new RegisteredRegionImplCpp<RDSEEncoderRegion>());
+    instance.addRegionType("CategoryEncoderRegion", new RegisteredRegionImplCpp<CategoryEncoderRegion>());
     instance.addRegionType("TestNode",           new RegisteredRegionImplCpp<TestNode>());
     instance.addRegionType("FileOutputRegion", new RegisteredRegionImplCpp<FileOutputRegion>());
     instance.addRegionType("FileInputRegion",   new RegisteredRegionImplCpp<FileInputRegion>());
     instance.addRegionType("SPRegion",           new RegisteredRegionImplCpp<SPRegion>());
     instance.addRegionType("TMRegion",           new RegisteredRegionImplCpp<TMRegion>());
     instance.addRegionType("ClassifierRegion",   new RegisteredRegionImplCpp<ClassifierRegion>());
+    instance.addRegionType("KNNClassifierRegion", new RegisteredRegionImplCpp<KNNClassifierRegion>());
+    instance.addRegionType("HTMPipelineRegion",  new RegisteredRegionImplCpp<HTMPipelineRegion>());
+    instance.addRegionType("RemoteInputRegion",  new RegisteredRegionImplCpp<RemoteInputRegion>());
+    instance.addRegionType("RemoteOutputRegion", new RegisteredRegionImplCpp<RemoteOutputRegion>());
+    instance.addRegionType("ReplayRegion",       new RegisteredRegionImplCpp<ReplayRegion>());
 
     // Renamed Regions
     instance.addRegionType("ScalarSensor", new RegisteredRegionImplCpp<ScalarEncoderRegion>());
@@ -115,6 +128,7 @@ void RegionImplFactory::addRegionType(const std::string nodeType, RegisteredRegi
 
 	std::shared_ptr<Spec> ns(reg->createSpec());
 	regionSpecMap[nodeType] = ns;
+	clearPrototypes();
 }
 
 
@@ -139,6 +153,63 @@ RegionImpl *RegionImplFactory::createRegionImpl(const std::string nodeType,
   return impl;
 }
 
+
+std::shared_ptr<const RegionImplFactory::Prototype>
+RegionImplFactory::getPrototype(const std::string &nodeType, const std::string &nodeParams) {
+  const auto key = std::make_pair(nodeType, nodeParams);
+  {
+    std::lock_guard<std::mutex> lock(prototypeMutex);
+    const auto found = prototypeMap.find(key);
+    if (found != prototypeMap.end())
+      return found->second;
+  }
+
+  auto it = regionTypeMap.find(nodeType);
+  if (it == regionTypeMap.end()) {
+    NTA_THROW << "Unregistered node type '" << nodeType << "'";
+  }
+  auto prototype = std::make_shared<Prototype>();
+  prototype->nodeType = nodeType;
+  prototype->registered = it->second;
+  prototype->spec = getSpec(nodeType);
+  prototype->params.parse(nodeParams);
+  NTA_CHECK(prototype->params.isMap() || prototype->params.isEmpty())
+    << "The parameters of a '" << nodeType << "' region must be a map, found '" << nodeParams << "'";
+  prototype->hasDim = prototype->params.contains("dim");
+  if (prototype->hasDim) {
+    prototype->dim = prototype->params["dim"].asVector<UInt32>();
+  }
+
+  std::lock_guard<std::mutex> lock(prototypeMutex);
+  if (prototypeMap.size() >= MAX_PROTOTYPES) {
+    prototypeMap.clear();
+  }
+  prototypeMap[key] = prototype;
+  return prototype;
+}
+
+
+RegionImpl *RegionImplFactory::createRegionImpl(const Prototype &prototype, Region *region) {
+  ValueMap vm = prototype.params.copy();
+  RegionImpl *impl = prototype.registered->createRegionImpl(vm, region);
+  if (prototype.hasDim) {
+    impl->setDimensions(prototype.dim);
+  }
+  return impl;
+}
+
+
+size_t RegionImplFactory::numPrototypes() {
+  std::lock_guard<std::mutex> lock(prototypeMutex);
+  return prototypeMap.size();
+}
+
+
+void RegionImplFactory::clearPrototypes() {
+  std::lock_guard<std::mutex> lock(prototypeMutex);
+  prototypeMap.clear();
+}
+
 RegionImpl *RegionImplFactory::deserializeRegionImpl(const std::string nodeType,
                                                      ArWrapper &wrapper,
                                                      Region *region) {
@@ -166,11 +237,16 @@ void RegionImplFactory::cleanup() {
   RegionImplFactory& instance = getInstance();
   instance.regionTypeMap.clear();
   instance.regionSpecMap.clear();
+  clearPrototypes();
 }
 
 // definitions for our class variables.
 std::map<const std::string, std::shared_ptr<RegisteredRegionImpl> > RegionImplFactory::regionTypeMap;
 std::map<const std::string, std::shared_ptr<Spec> > RegionImplFactory::regionSpecMap;
+std::map<std::pair<std::string, std::string>, std::shared_ptr<const RegionImplFactory::Prototype> >
+    RegionImplFactory::prototypeMap;
+std::mutex RegionImplFactory::prototypeMutex;
+const size_t RegionImplFactory::MAX_PROTOTYPES = 1024u;
 
 
 } // namespace htm
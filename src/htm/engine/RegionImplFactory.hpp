@@ -30,7 +30,11 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
+#include <htm/ntypes/Value.hpp>
 #include <htm/types/Serializable.hpp>
 
 
@@ -54,6 +58,36 @@ public:
   RegionImpl *createRegionImpl(const std::string nodeType,
                                ValueMap vm, Region *region);
 
+  /**
+   * A region type resolved together with its parsed parameters.  Regions
+   * created from a prototype skip the parsing of the parameters and the
+   * lookups of the type, @see getPrototype().
+   */
+  struct Prototype {
+    std::string nodeType;
+    std::shared_ptr<RegisteredRegionImpl> registered;
+    std::shared_ptr<Spec> spec;
+    ValueMap params;             // copied for each region, a region may keep it
+    bool hasDim = false;         // the parameter 'dim', parsed
+    std::vector<UInt32> dim;
+  };
+
+  // Returns the prototype of nodeType with the yaml/json nodeParams. It is
+  // made on the first request and cached, keyed by both strings, so the
+  // next regions with the same parameters don't parse them again.  Throws if
+  // the type is not registered or the parameters are not a map.
+  std::shared_ptr<const Prototype> getPrototype(const std::string &nodeType,
+                                                const std::string &nodeParams);
+
+  // Create a RegionImpl from a prototype; caller gets ownership.
+  RegionImpl *createRegionImpl(const Prototype &prototype, Region *region);
+
+  // The number of cached prototypes.  When MAX_PROTOTYPES is reached the
+  // cache starts over; it is also cleared when region types are registered
+  // or unregistered, and by cleanup().
+  static size_t numPrototypes();
+  static const size_t MAX_PROTOTYPES;
+
   // Create a RegionImpl from serialized state; caller gets ownership.
   RegionImpl *deserializeRegionImpl(const std::string nodeType,
                                     ArWrapper &wrapper, Region *region);
@@ -89,6 +123,11 @@ private:
   static std::map<const std::string, std::shared_ptr<Spec> > regionSpecMap;
   void addRegionType(const std::string nodeType, RegisteredRegionImpl* wrapper);
 
+  // Prototypes by (nodeType, nodeParams), @see getPrototype().
+  static std::map<std::pair<std::string, std::string>, std::shared_ptr<const Prototype> > prototypeMap;
+  static std::mutex prototypeMutex;
+  static void clearPrototypes();
+
 };
 } // namespace htm
 
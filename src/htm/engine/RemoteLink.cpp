@@ -0,0 +1,134 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the RemoteLinkSender and RemoteLinkReceiver classes
+ */
+
+#include <httplib.h>
+
+#include <chrono>
+#include <cstring> // memcpy
+
+#include <htm/engine/RemoteLink.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+static const size_t HEADER_SIZE = sizeof(UInt64) + 2u * sizeof(UInt32);
+
+RemoteLinkSender::RemoteLinkSender(const std::string &host, const UInt port, const UInt timeoutSeconds)
+    : host_(host), port_(port) {
+  client_.reset(new httplib::Client(host_.c_str(), static_cast<int>(port_)));
+  client_->set_timeout_sec(timeoutSeconds);
+}
+
+RemoteLinkSender::~RemoteLinkSender() {}
+
+void RemoteLinkSender::send(const UInt64 iteration, const SDR &data) {
+  const SDR_sparse_t &sparse = data.getSparse();
+  const UInt32 size  = static_cast<UInt32>(data.size);
+  const UInt32 count = static_cast<UInt32>(sparse.size());
+  message_.resize(HEADER_SIZE + count * sizeof(UInt32));
+  char *p = &message_[0];
+  memcpy(p, &iteration, sizeof(UInt64));                   p += sizeof(UInt64);
+  memcpy(p, &size, sizeof(UInt32));                        p += sizeof(UInt32);
+  memcpy(p, &count, sizeof(UInt32));                       p += sizeof(UInt32);
+  if (count > 0u) memcpy(p, sparse.data(), count * sizeof(UInt32));
+
+  const auto res = client_->Post("/link", message_, "application/octet-stream");
+  NTA_CHECK(res != nullptr) << "RemoteLinkSender: cannot reach " << host_ << ":" << port_;
+  NTA_CHECK(res->status / 100 == 2) << "RemoteLinkSender: " << host_ << ":" << port_
+                                    << " rejected iteration " << iteration << ", " << res->body;
+}
+
+
+RemoteLinkReceiver::RemoteLinkReceiver(const UInt port, const std::string &host) {
+  server_.reset(new httplib::Server());
+  server_->Post("/link", [this](const httplib::Request &req, httplib::Response &res) {
+    if (not accept_(req.body)) {
+      NTA_WARN << "RemoteLinkReceiver: dropped a malformed message on port " << port_;
+      res.status = 400;
+      res.set_content("malformed message", "text/plain");
+    }
+  });
+  if (port == 0u) {
+    const int bound = server_->bind_to_any_port(host.c_str());
+    NTA_CHECK(bound > 0) << "RemoteLinkReceiver: cannot listen on " << host;
+    port_ = static_cast<UInt>(bound);
+  } else {
+    NTA_CHECK(server_->bind_to_port(host.c_str(), static_cast<int>(port)))
+      << "RemoteLinkReceiver: cannot listen on " << host << ":" << port;
+    port_ = port;
+  }
+  httplib::Server *server = server_.get();
+  thread_ = std::thread([server]() { server->listen_after_bind(); });
+  // stop() only ends a running server, so the destructor needs it running.
+  for (int i = 0; i < 5000 and not server_->is_running(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  NTA_CHECK(server_->is_running()) << "RemoteLinkReceiver: the server on port " << port_ << " did not start";
+}
+
+RemoteLinkReceiver::~RemoteLinkReceiver() {
+  server_->stop();
+  if (thread_.joinable()) thread_.join();
+}
+
+bool RemoteLinkReceiver::accept_(const std::string &message) {
+  if (message.size() < HEADER_SIZE) return false;
+  UInt64 iteration;
+  Message m;
+  UInt32 count;
+  const char *p = message.data();
+  memcpy(&iteration, p, sizeof(UInt64));   p += sizeof(UInt64);
+  memcpy(&m.size, p, sizeof(UInt32));      p += sizeof(UInt32);
+  memcpy(&count, p, sizeof(UInt32));       p += sizeof(UInt32);
+  if (count > m.size or message.size() != HEADER_SIZE + count * sizeof(UInt32)) return false;
+  m.sparse.resize(count);
+  if (count > 0u) memcpy(m.sparse.data(), p, count * sizeof(UInt32));
+  // receive() hands the indices to setSparse(), which checks them only with assertions on.
+  for (UInt32 i = 0u; i < count; i++) {
+    if (m.sparse[i] >= m.size or (i > 0u and m.sparse[i - 1u] >= m.sparse[i])) return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_[iteration] = std::move(m);
+  }
+  arrived_.notify_all();
+  return true;
+}
+
+void RemoteLinkReceiver::receive(const UInt64 iteration, SDR &data, const Real64 timeoutSeconds) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  const bool arrived = arrived_.wait_for(lock, std::chrono::duration<Real64>(timeoutSeconds),
+      [this, iteration]() { return pending_.count(iteration) > 0u; });
+  NTA_CHECK(arrived) << "RemoteLinkReceiver: iteration " << iteration << " did not arrive on port "
+                     << port_ << " within " << timeoutSeconds << " seconds";
+  auto it = pending_.find(iteration);
+  NTA_CHECK(it->second.size == data.size) << "RemoteLinkReceiver: received an SDR of size "
+      << it->second.size << " for an SDR of size " << data.size;
+  data.setSparse(it->second.sparse); // takes the indices
+  pending_.erase(pending_.begin(), ++it);
+}
+
+size_t RemoteLinkReceiver::numPending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_.size();
+}
+
+} // namespace htm
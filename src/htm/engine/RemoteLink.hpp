@@ -0,0 +1,130 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the RemoteLinkSender and RemoteLinkReceiver classes
+ */
+
+#ifndef NTA_REMOTE_LINK_HPP
+#define NTA_REMOTE_LINK_HPP
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+
+namespace httplib {
+class Client;
+class Server;
+}
+
+namespace htm {
+
+/**
+ * The transport of a link between two processes, which may be on different
+ * hosts.  It carries the SDR of an Output, stamped with the iteration which
+ * computed it, over TCP (HTTP with the binary body below).
+ *
+ * In a Network the two ends are regions: a RemoteOutputRegion sends its input
+ * with a RemoteLinkSender, and a RemoteInputRegion in the other Network
+ * outputs what its RemoteLinkReceiver got.  The receiving region reads the
+ * iteration which is `propagationDelay` iterations behind its own, like a
+ * delayed Link, so with a delay of d the sending Network may run up to d
+ * iterations ahead: the stages of a hierarchy placed on different hosts
+ * compute concurrently.
+ *
+ * Message, in the byte order of the hosts: UInt64 iteration, UInt32 size,
+ * UInt32 count, followed by the count sparse indices.
+ */
+class RemoteLinkSender {
+public:
+  /**
+   * @param host Name or address of the receiving host.
+   * @param port Port of its RemoteLinkReceiver.
+   * @param timeoutSeconds Of the connection and of each message.
+   */
+  RemoteLinkSender(const std::string &host, UInt port, UInt timeoutSeconds = 60u);
+  ~RemoteLinkSender();
+
+  /**
+   * Sends the SDR computed by the given iteration.  Blocks until the
+   * receiver acknowledged it, throws if it could not be delivered.
+   */
+  void send(UInt64 iteration, const SDR &data);
+
+  const std::string &getHost() const noexcept { return host_; }
+  UInt getPort() const noexcept { return port_; }
+
+private:
+  std::string host_;
+  UInt port_;
+  std::unique_ptr<httplib::Client> client_;
+  std::string message_; // reused
+};
+
+
+class RemoteLinkReceiver {
+public:
+  /**
+   * Starts listening.
+   * @param port Port to listen on, 0 for any free port (@see getPort).
+   * @param host Address of the interface to listen on.
+   */
+  explicit RemoteLinkReceiver(UInt port = 0u, const std::string &host = "0.0.0.0");
+  ~RemoteLinkReceiver();
+
+  UInt getPort() const noexcept { return port_; }
+
+  /**
+   * Waits for the SDR of the given iteration and copies it into `data`,
+   * which must have the size of the sent SDR.  The messages of the older
+   * iterations are dropped.  A message whose indices are not sorted, unique
+   * and within its size is dropped when it arrives, and the sender gets an error.
+   *
+   * @param timeoutSeconds Throws if the SDR did not arrive in this time.
+   */
+  void receive(UInt64 iteration, SDR &data, Real64 timeoutSeconds = 60.0);
+
+  /**
+   * @returns the number of received messages which were not read yet.
+   */
+  size_t numPending() const;
+
+private:
+  bool accept_(const std::string &message);
+
+  UInt port_;
+  std::unique_ptr<httplib::Server> server_;
+  std::thread thread_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable arrived_;
+  struct Message {
+    UInt32 size;
+    SDR_sparse_t sparse;
+  };
+  std::map<UInt64, Message> pending_; // by iteration
+};
+
+} // namespace htm
+
+#endif // NTA_REMOTE_LINK_HPP
@@ -32,10 +32,11 @@ static bool startsWith_(const std::string &s, const std::string &prefix) {
 }
 
 
-Spec::Spec() : singleNodeOnly(false), description("") {}
+Spec::Spec() : singleNodeOnly(false), async(false), description("") {}
 
 bool Spec::operator==(const Spec &o) const {
-  if (singleNodeOnly != o.singleNodeOnly || description != o.description ||
+  if (singleNodeOnly != o.singleNodeOnly || async != o.async ||
+      description != o.description ||
       parameters != o.parameters || outputs != o.outputs ||
       inputs != o.inputs || commands != o.commands) {
     return false;
@@ -267,6 +268,8 @@ void Spec::parseSpec(const std::string &yaml) {
         description = category_pair.second.str();
       else if (category == "singleNodeOnly")
         singleNodeOnly = category_pair.second.as<bool>();
+      else if (category == "async")
+        async = category_pair.second.as<bool>();
       else if (category == "parameters") {
         for (auto parameter_pair : category_pair.second) {
           the_name = parameter_pair.first;
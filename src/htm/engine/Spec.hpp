@@ -139,6 +139,11 @@ public:
   // Such regions always have dimension [1]
   bool singleNodeOnly;
 
+  // The compute() of the region may block on I/O (ex: reading a file).
+  // A region without incoming links which is async computes its next
+  // iteration on an I/O thread while the rest of the network computes.
+  bool async;
+
   // Region type name
   std::string name;
 
@@ -0,0 +1,132 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the Tracer class
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+
+#include <htm/engine/Tracer.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+const UInt32 Tracer::NoName;
+
+static const char *categoryNames[Tracer::Cat_NumCategories] = {"iteration", "compute", "link",
+                                                               "shift", "run"};
+
+// A small id of the calling thread, in the order the threads first record.
+static UInt32 threadIndex() {
+  static std::atomic<UInt32> numThreads(0u);
+  thread_local const UInt32 index = numThreads++;
+  return index;
+}
+
+Tracer::Tracer(size_t capacity) : next_(0u) {
+  reset(capacity);
+}
+
+void Tracer::reset(size_t capacity) {
+  NTA_CHECK(capacity > 0u) << "Tracer: the capacity must be positive.";
+  events_.assign(capacity, Event());
+  next_ = 0u;
+  start_ = std::chrono::steady_clock::now();
+}
+
+UInt32 Tracer::intern(const std::string &name) {
+  std::lock_guard<std::mutex> lock(namesMutex_);
+  const auto found = nameIds_.find(name);
+  if (found != nameIds_.end())
+    return found->second;
+  const UInt32 id = static_cast<UInt32>(names_.size());
+  names_.push_back(name);
+  nameIds_[name] = id;
+  return id;
+}
+
+void Tracer::record_(UInt32 name, Category category, char phase, UInt64 arg) {
+  const UInt64 time = static_cast<UInt64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start_).count());
+  const UInt64 slot = next_.fetch_add(1u, std::memory_order_relaxed);
+  Event &event = events_[static_cast<size_t>(slot % events_.size())];
+  event.time = time;
+  event.arg = arg;
+  event.name = name;
+  event.thread = threadIndex();
+  event.phase = phase;
+  event.category = category;
+}
+
+size_t Tracer::getCount() const {
+  return static_cast<size_t>(std::min<UInt64>(next_, events_.size()));
+}
+
+UInt64 Tracer::getDropped() const {
+  const UInt64 recorded = next_;
+  return recorded > events_.size() ? recorded - events_.size() : 0u;
+}
+
+std::string Tracer::toJSON() const {
+  std::lock_guard<std::mutex> lock(namesMutex_);
+  const UInt64 recorded = next_;
+  const size_t count = getCount();
+
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(3);
+  ss << "{\"traceEvents\": [\n"
+     << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 0, "
+     << "\"args\": {\"name\": \"htm.core Network\"}}";
+  std::map<UInt32, size_t> depth; // the open events of each thread
+  for (UInt64 i = recorded - count; i < recorded; i++) {
+    const Event &event = events_[static_cast<size_t>(i % events_.size())];
+    if (event.phase == 'E') {
+      if (depth[event.thread] == 0u)
+        continue; // its begin was overwritten
+      depth[event.thread]--;
+    } else {
+      depth[event.thread]++;
+    }
+    const std::string name = event.name < names_.size() ? names_[event.name] : "";
+    ss << ",\n{\"name\": " << Value::json_string(name) << ", \"cat\": \""
+       << categoryNames[event.category] << "\", \"ph\": \"" << event.phase
+       << "\", \"ts\": " << static_cast<Real64>(event.time) / 1000.0
+       << ", \"pid\": 1, \"tid\": " << event.thread;
+    if (event.phase == 'B' and event.category == Cat_Iteration)
+      ss << ", \"args\": {\"iteration\": " << event.arg << "}";
+    else if (event.phase == 'B' and event.category == Cat_Run)
+      ss << ", \"args\": {\"iterations\": " << event.arg << "}";
+    ss << "}";
+  }
+  ss << "\n],\n\"displayTimeUnit\": \"ns\"}\n";
+  return ss.str();
+}
+
+void Tracer::saveToFile(const std::string &path) const {
+  std::ofstream out(path, std::ios::out | std::ios::trunc);
+  NTA_CHECK(out.is_open()) << "Tracer: cannot write " << path;
+  out << toJSON();
+  NTA_CHECK(out.good()) << "Tracer: failed writing " << path;
+}
+
+} // namespace htm
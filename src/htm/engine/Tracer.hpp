@@ -0,0 +1,145 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the Tracer class
+ */
+
+#ifndef NTA_TRACER_HPP
+#define NTA_TRACER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * Timeline of the execution of a Network: the begin and end of each region
+ * compute, link transfer and iteration, with the thread which ran it.
+ *
+ * The events are kept in a ring buffer of a fixed capacity, so a long run
+ * keeps its most recent events.  Recording is lock free and may be done
+ * from several threads; read the trace between runs.
+ * toJSON() is in the Chrome Trace Event format, which chrome://tracing and
+ * the Perfetto UI (ui.perfetto.dev) open.
+ *
+ * Example Usage:
+ *    net.enableTracing();
+ *    net.run(100);
+ *    net.saveTrace("trace.json");
+ *
+ * @see Network::enableTracing()
+ */
+class Tracer {
+public:
+  enum Category { Cat_Iteration = 0, Cat_Compute, Cat_Link, Cat_Shift, Cat_Run,
+                          Cat_NumCategories };
+
+  // The name of no event, @see intern().
+  static const UInt32 NoName = ~0u;
+
+  explicit Tracer(size_t capacity = 65536u);
+
+  /**
+   * Drop all events, and change the capacity of the ring buffer.
+   * The names remain interned.
+   */
+  void reset(size_t capacity);
+
+  /**
+   * @returns The id of @param name, for begin() and end().  Each name is
+   * stored once, callers keep the id instead of passing the name per event.
+   */
+  UInt32 intern(const std::string &name);
+
+  /**
+   * Record the begin or end of the event @param name on the calling thread.
+   * @param arg Shown as the argument of the event, eg. the iteration.
+   */
+  void begin(UInt32 name, Category category, UInt64 arg = 0u) { record_(name, category, 'B', arg); }
+  void end(UInt32 name, Category category) { record_(name, category, 'E', 0u); }
+
+  size_t getCapacity() const { return events_.size(); }
+
+  // The number of events in the buffer.
+  size_t getCount() const;
+
+  // The number of events overwritten since reset(), the oldest are dropped.
+  UInt64 getDropped() const;
+
+  /**
+   * @returns The events in the Chrome Trace Event format:
+   *   {"traceEvents": [{"name": "sp", "cat": "compute", "ph": "B", "ts": us,
+   *                     "pid": 1, "tid": n}, ...],
+   *    "displayTimeUnit": "ns"}
+   * The ends of events whose begin was dropped are omitted.
+   */
+  std::string toJSON() const;
+
+  void saveToFile(const std::string &path) const;
+
+  /**
+   * Records an event for its lifetime; does nothing without a tracer.
+   */
+  class Scope {
+  public:
+    Scope(Tracer *tracer, UInt32 name, Category category, UInt64 arg = 0u)
+        : tracer_(tracer), name_(name), category_(category) {
+      if (tracer_ != nullptr) tracer_->begin(name_, category_, arg);
+    }
+    ~Scope() {
+      if (tracer_ != nullptr) tracer_->end(name_, category_);
+    }
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    Tracer *tracer_;
+    UInt32 name_;
+    Category category_;
+  };
+
+private:
+  struct Event {
+    UInt64 time;    // nanoseconds since start_
+    UInt64 arg;
+    UInt32 name;
+    UInt32 thread;
+    char phase;     // 'B' or 'E'
+    Category category;
+  };
+
+  void record_(UInt32 name, Category category, char phase, UInt64 arg);
+
+  std::vector<Event> events_;
+  std::atomic<UInt64> next_;  // the number of events recorded since reset()
+  std::chrono::steady_clock::time_point start_;
+
+  mutable std::mutex namesMutex_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, UInt32> nameIds_;
+};
+
+} // namespace htm
+
+#endif // NTA_TRACER_HPP
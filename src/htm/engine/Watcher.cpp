@@ -19,12 +19,15 @@
  * Implementation of the Watcher class
  */
 
+#include <cstring>
 #include <exception>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <fstream>
+#include <iterator>
 
+#include <htm/engine/Input.hpp>
 #include <htm/engine/Network.hpp>
 #include <htm/engine/Output.hpp>
 #include <htm/engine/Region.hpp>
@@ -37,12 +40,20 @@
 
 namespace htm {
 
-Watcher::Watcher(std::string fileName) {
+static const char WATCHER_MAGIC[4] = {'H', 'T', 'M', 'W'};
+static const UInt32 WATCHER_VERSION = 1u;
+
+Watcher::Watcher(std::string fileName, bool binary, UInt32 sampling) {
+    NTA_CHECK(sampling > 0u) << "Watcher: sampling must be at least 1.";
     std::string d = Path::getParent(fileName);
     if (!d.empty())
       Directory::create(d);
   data_.fileName = fileName;
+  data_.sampling = sampling;
   try {
+    if (binary)
+      data_.writer.reset(new BufferedWriter(fileName, false));
+    else
       data_.outStream.open(fileName.c_str());
   } catch (std::exception &) {
       NTA_THROW << "Unable to open filename " << fileName << " for network watcher";
@@ -50,7 +61,7 @@ Watcher::Watcher(std::string fileName) {
   }
 
 Watcher::~Watcher() {
-  if (data_.outStream.is_open()) {
+  if (data_.outStream.is_open() || data_.writer) {
   	this->flushFile();
   	this->closeFile();
   }
@@ -84,13 +95,37 @@ UInt32 Watcher::watchOutput(std::string regionName,
   return watch.watchID;
 }
 
+UInt32 Watcher::watchSources(Network &net) {
+  UInt32 count = 0u;
+  Collection<std::shared_ptr<Region>> regions = net.getRegions();
+  for (auto &item : regions) {
+    const std::shared_ptr<Region> &region = item.second;
+    bool linked = false;
+    for (const auto &input : region->getInputs())
+      linked = linked || input.second->hasIncomingLinks();
+    if (linked)
+      continue;
+    for (const auto &output : region->getOutputs()) {
+      watchOutput(item.first, output.first, false); // SDRs are sparse anyway
+      count++;
+    }
+  }
+  return count;
+}
+
 // TODO: clean up, add support for uncloned arrays,
 // add support for output of a different type than Real32
 void Watcher::watcherCallback(Network *net, UInt64 iteration, void *dataIn) {
   allData &data = *(static_cast<allData *>(dataIn));
+  // iterations are numbered from 1
+  if ((iteration - 1u) % data.sampling != 0u)
+    return;
+  if (data.writer) {
+    writeBinary_(data, iteration);
+    return;
+  }
   // iterate through each watch
-  for (auto &elem : data.watches) {
-    watchData watch = elem;
+  for (const auto &watch : data.watches) {
     std::string value;
     std::stringstream out;
     if (watch.wType == parameter) {
@@ -332,6 +367,7 @@ void Watcher::watcherCallback(Network *net, UInt64 iteration, void *dataIn) {
       //  }
       //}
     } else if (watch.wType == output) {
+      watch.region->getOutputData(watch.varName); // produces a skipped output
       switch (watch.varType) {
       case NTA_BasicType_Real32: {
         Real32 *outputData = (Real32 *)(watch.array->getBuffer());
@@ -384,7 +420,121 @@ void Watcher::watcherCallback(Network *net, UInt64 iteration, void *dataIn) {
   data.outStream.flush();
 }
 
+static void appendRaw(SDR_encoded_t &out, const void *data, size_t size) {
+  const Byte *p = static_cast<const Byte *>(data);
+  out.insert(out.end(), p, p + size);
+}
+
+void Watcher::writeBinary_(allData &data, UInt64 iteration) {
+  SDR_encoded_t &out = data.record;
+  out.clear();
+  for (auto &watch : data.watches) {
+    putVarint(watch.watchID, out);
+    putVarint(iteration, out);
+
+    const ArrayBase *a = nullptr;
+    if (watch.wType == output) {
+      watch.region->getOutputData(watch.varName); // produces a skipped output
+      a = watch.array;
+    } else if (watch.layout == Sparse || watch.layout == Dense) {
+      watch.region->getParameterArray(watch.varName, watch.scratch);
+      a = &watch.scratch;
+    }
+    if (a != nullptr) {
+      NTA_CHECK(a->getType() == watch.varType)
+          << "Watcher: " << watch.regionName << "." << watch.varName << " changed type to "
+          << BasicType::getName(a->getType());
+    }
+
+    switch (watch.layout) {
+    case NoValue:
+      break;
+    case Scalar:
+      switch (watch.varType) {
+      case NTA_BasicType_Int32: {
+        Int32 p = watch.region->getParameterInt32(watch.varName);
+        appendRaw(out, &p, sizeof(p));
+        break;
+      }
+      case NTA_BasicType_UInt32: {
+        UInt32 p = watch.region->getParameterUInt32(watch.varName);
+        appendRaw(out, &p, sizeof(p));
+        break;
+      }
+      case NTA_BasicType_Int64: {
+        Int64 p = watch.region->getParameterInt64(watch.varName);
+        appendRaw(out, &p, sizeof(p));
+        break;
+      }
+      case NTA_BasicType_UInt64: {
+        UInt64 p = watch.region->getParameterUInt64(watch.varName);
+        appendRaw(out, &p, sizeof(p));
+        break;
+      }
+      case NTA_BasicType_Real32: {
+        Real32 p = watch.region->getParameterReal32(watch.varName);
+        appendRaw(out, &p, sizeof(p));
+        break;
+      }
+      case NTA_BasicType_Real64: {
+        Real64 p = watch.region->getParameterReal64(watch.varName);
+        appendRaw(out, &p, sizeof(p));
+        break;
+      }
+      default:
+        NTA_THROW << "Internal error.";
+      }
+      break;
+    case String: {
+      const std::string p = watch.region->getParameterString(watch.varName);
+      putVarint(p.size(), out);
+      appendRaw(out, p.data(), p.size());
+      break;
+    }
+    case Sparse:
+      putVarint(a->getCount(), out);
+      if (a->getType() == NTA_BasicType_SDR) {
+        encodeSparse(a->getSDR().getSparse(), out);
+      } else {
+        BasicType::nonzeroIndices(a->getBuffer(), a->getType(), a->getCount(), data.sparse);
+        encodeSparse(data.sparse, out);
+      }
+      break;
+    case Dense:
+      putVarint(a->getCount(), out);
+      appendRaw(out, a->getBuffer(), a->getCount() * BasicType::getSize(a->getType()));
+      break;
+    }
+  }
+  // One hand-off per iteration, the background thread writes the file.
+  data.writer->write(out.data(), out.size());
+}
+
+void Watcher::writeBinaryHeader_() {
+  SDR_encoded_t &out = data_.record;
+  out.clear();
+  appendRaw(out, WATCHER_MAGIC, sizeof(WATCHER_MAGIC));
+  putVarint(WATCHER_VERSION, out);
+  putVarint(data_.sampling, out);
+  putVarint(data_.watches.size(), out);
+  for (const auto &watch : data_.watches) {
+    putVarint(watch.watchID, out);
+    putVarint(watch.regionName.size(), out);
+    appendRaw(out, watch.regionName.data(), watch.regionName.size());
+    putVarint(static_cast<UInt64>(watch.nodeIndex + 1), out);
+    putVarint(watch.varName.size(), out);
+    appendRaw(out, watch.varName.data(), watch.varName.size());
+    out.push_back(static_cast<Byte>(watch.varType));
+    out.push_back(static_cast<Byte>(watch.layout));
+  }
+  data_.writer->write(out.data(), out.size());
+}
+
 void Watcher::closeFile() {
+  if (data_.writer) {
+    data_.writer->close();
+    data_.writer.reset();
+  }
   if (data_.outStream.is_open()) {
 //    data_.outStream << "Closing...\n";
     data_.outStream.flush();
@@ -393,14 +543,33 @@ void Watcher::closeFile() {
 }
 
 void Watcher::flushFile() {
+  if (data_.writer)
+    data_.writer->flush();
   if (data_.outStream.is_open())
     data_.outStream.flush();
 }
 
+// How a watch is written in the binary format.
+static Watcher::BinaryLayout binaryLayout(watcherType wType, NTA_BasicType varType, bool isArray,
+                                          Int64 nodeIndex, bool sparseOutput) {
+  if (wType == parameter && !isArray && varType != NTA_BasicType_SDR) {
+    if (nodeIndex != -1)
+      return Watcher::NoValue; // uncloned parameters are not supported
+    if (varType == NTA_BasicType_Str || varType == NTA_BasicType_Byte)
+      return Watcher::String;
+    return Watcher::Scalar;
+  }
+  NTA_CHECK(varType != NTA_BasicType_Str && varType != NTA_BasicType_Handle)
+      << "Watcher: " << BasicType::getName(varType) << " arrays are not supported in the binary format.";
+  if (varType == NTA_BasicType_SDR || sparseOutput)
+    return Watcher::Sparse;
+  return Watcher::Dense;
+}
+
 //attach Watcher to a network and do initial writing to files
 void Watcher::attachToNetwork(Network& net)
 {
-  std::ostream &out = data_.outStream;
+  std::ostream &out = data_.outStream; // not open in binary mode
   out << "Info: watchID, regionName, nodeType, nodeIndex, varName" << std::endl;
 
   // go through each watch
@@ -454,6 +623,12 @@ void Watcher::attachToNetwork(Network& net)
       NTA_THROW << "Watcher can only watch parameters or outputs.";
     }
 
+    if (data_.writer)
+      watch.layout = binaryLayout(watch.wType, watch.varType, watch.isArray,
+                                  watch.nodeIndex, watch.sparseOutput);
+    if (watch.layout == Sparse || watch.layout == Dense)
+      watch.scratch = Array(watch.varType);
+
     // add the modified watch struct to data_.watches
     allWatchData::iterator it;
     it = data_.watches.begin() + i;
@@ -462,6 +637,8 @@ void Watcher::attachToNetwork(Network& net)
   }
 
     out << "Data: watchID, iteration, paramValue" << std::endl;
+  if (data_.writer)
+    writeBinaryHeader_();
 
   // actually attach to the network
   Collection<Network::callbackItem> &callbacks = net.getCallbacks();
@@ -477,4 +654,97 @@ void Watcher::detachFromNetwork(Network &net) {
   callbackName += data_.fileName;
   callbacks.remove(callbackName);
 }
+
+
+WatcherReader::WatcherReader(const std::string &fileName) {
+  std::ifstream in(fileName.c_str(), std::ios::binary);
+  NTA_CHECK(in.is_open()) << "WatcherReader: unable to open " << fileName;
+  data_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+  NTA_CHECK(data_.size() >= sizeof(WATCHER_MAGIC) &&
+            std::memcmp(data_.data(), WATCHER_MAGIC, sizeof(WATCHER_MAGIC)) == 0)
+      << "WatcherReader: " << fileName << " is not a binary Watcher file.";
+  offset_ = sizeof(WATCHER_MAGIC);
+  const UInt64 version = getVarint(data_, offset_);
+  NTA_CHECK(version == WATCHER_VERSION) << "WatcherReader: unsupported version " << version;
+  sampling_ = static_cast<UInt32>(getVarint(data_, offset_));
+
+  auto getString = [this]() -> std::string {
+    const UInt64 size = getVarint(data_, offset_);
+    NTA_CHECK(size <= data_.size() - offset_) << "WatcherReader: truncated header.";
+    std::string s(data_.data() + offset_, static_cast<size_t>(size));
+    offset_ += static_cast<size_t>(size);
+    return s;
+  };
+  const UInt64 numWatches = getVarint(data_, offset_);
+  for (UInt64 i = 0u; i < numWatches; i++) {
+    Watch w;
+    w.watchID = static_cast<UInt32>(getVarint(data_, offset_));
+    w.regionName = getString();
+    w.nodeIndex = static_cast<Int64>(getVarint(data_, offset_)) - 1;
+    w.varName = getString();
+    NTA_CHECK(data_.size() - offset_ >= 2u) << "WatcherReader: truncated header.";
+    w.type = static_cast<NTA_BasicType>(static_cast<unsigned char>(data_[offset_++]));
+    w.layout = static_cast<Watcher::BinaryLayout>(data_[offset_++]);
+    NTA_CHECK(BasicType::isValid(w.type) && w.layout <= Watcher::Dense)
+        << "WatcherReader: corrupt header.";
+    watches_.push_back(w);
+  }
+}
+
+bool WatcherReader::next(UInt32 &watchID, UInt64 &iteration, Array &value) {
+  if (offset_ >= data_.size())
+    return false;
+  watchID = static_cast<UInt32>(getVarint(data_, offset_));
+  iteration = getVarint(data_, offset_);
+  // watch IDs are assigned 1, 2, 3, ... in the order of the watches
+  NTA_CHECK(watchID >= 1u && watchID <= watches_.size()) << "WatcherReader: unknown watch " << watchID;
+  const Watch &w = watches_[watchID - 1u];
+
+  switch (w.layout) {
+  case Watcher::NoValue:
+    value = Array(w.type);
+    break;
+  case Watcher::Scalar: {
+    const size_t size = BasicType::getSize(w.type);
+    NTA_CHECK(size <= data_.size() - offset_) << "WatcherReader: truncated record.";
+    value = Array(w.type);
+    value.allocateBuffer(1u);
+    std::memcpy(value.getBuffer(), data_.data() + offset_, size);
+    offset_ += size;
+    break;
+  }
+  case Watcher::String: {
+    const UInt64 size = getVarint(data_, offset_);
+    NTA_CHECK(size <= data_.size() - offset_) << "WatcherReader: truncated record.";
+    value = Array(NTA_BasicType_Str);
+    value.allocateBuffer(1u);
+    static_cast<std::string *>(value.getBuffer())[0].assign(data_.data() + offset_,
+                                                             static_cast<size_t>(size));
+    offset_ += static_cast<size_t>(size);
+    break;
+  }
+  case Watcher::Sparse: {
+    const UInt64 count = getVarint(data_, offset_);
+    offset_ = decodeSparse(data_, offset_, sparse_);
+    value = Array(NTA_BasicType_SDR);
+    value.allocateBuffer(static_cast<size_t>(count));
+    value.getSDR().setSparse(sparse_);
+    break;
+  }
+  case Watcher::Dense: {
+    const UInt64 count = getVarint(data_, offset_);
+    NTA_CHECK(count <= data_.size() - offset_) << "WatcherReader: truncated record.";
+    const size_t size = static_cast<size_t>(count) * BasicType::getSize(w.type);
+    NTA_CHECK(size <= data_.size() - offset_) << "WatcherReader: truncated record.";
+    value = Array(w.type);
+    value.allocateBuffer(static_cast<size_t>(count));
+    if (size > 0u)
+      std::memcpy(value.getBuffer(), data_.data() + offset_, size);
+    offset_ += size;
+    break;
+  }
+  }
+  return true;
+}
 } // namespace htm
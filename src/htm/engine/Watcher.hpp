@@ -26,8 +26,12 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <memory>
 
 #include <htm/engine/Output.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/types/SdrCodec.hpp>
+#include <htm/utils/BufferedWriter.hpp>
 
 namespace htm {
 class ArrayBase;
@@ -56,10 +60,28 @@ enum watcherType { parameter, output };
  * net.run();
  *
  * w.detachFromNetwork(net);
+ *
+ * With `binary` the watches are written in a compact binary format instead
+ * of text, by a BufferedWriter on a background thread, so the compute
+ * thread only encodes the values.  The file has a header with the watches,
+ * then a record per watch and sampled iteration.  Outputs and array
+ * parameters are written as the indices of their nonzero elements (an SDR
+ * always, others if sparseOutput) or as their raw elements.  Read it with
+ * WatcherReader.
+ *
+ * `sampling` N writes only every Nth iteration: 1, 1+N, 1+2N, ...
+ *
+ * To capture a workload, eg. of a production Network for benchmarks:
+ *
+ * Watcher w("capture.bin", true);
+ * w.watchSources(net);
+ * w.attachToNetwork(net);
+ *
+ * and replace each source region by a ReplayRegion of the file.
  */
 class Watcher {
 public:
-  Watcher(const std::string fileName);
+  Watcher(const std::string fileName, bool binary = false, UInt32 sampling = 1u);
 
   // calls flushFile() and closeFile()
   ~Watcher();
@@ -72,6 +94,15 @@ public:
   UInt32 watchOutput(std::string regionName, std::string varName,
                            bool sparseOutput = true);
 
+  /**
+   * Watches every output of the source regions of the network, those
+   * without linked inputs, for a ReplayRegion to feed the recorded workload
+   * back.  SDR outputs are written sparse, others as their raw elements.
+   * Call it after the links are added.
+   * @returns the number of watches added.
+   */
+  UInt32 watchSources(Network &net);
+
   // callback function that will be called every time network is run
   static void watcherCallback(Network *net, UInt64 iteration, void *dataIn);
 
@@ -88,6 +119,9 @@ public:
   // Flushes the Stream.
   void flushFile();
 
+  // The layout of a value in the binary format.
+  enum BinaryLayout : Byte { NoValue = 0, Scalar = 1, String = 2, Sparse = 3, Dense = 4 };
+
 private:
 
     // Contains data specific for each individual parameter
@@ -107,6 +141,8 @@ private:
         const ArrayBase *array;
         bool isArray;
         bool sparseOutput;
+        BinaryLayout layout = NoValue; // binary format only
+        Array scratch;                 // reused for array parameters
     };
 
     // Contains all data needed by the callback function.
@@ -114,14 +150,60 @@ private:
         std::ofstream outStream;
         std::string fileName;
         std::vector<watchData> watches;
+        UInt32 sampling = 1u;
+        std::unique_ptr<BufferedWriter> writer; // binary format only
+        SDR_encoded_t record;                   // reused
+        std::vector<UInt32> sparse;             // reused
     };
 
+  static void writeBinary_(allData &data, UInt64 iteration);
+  void writeBinaryHeader_();
+
   typedef std::vector<watchData> allWatchData;
 
   // private data structure
   allData data_;
 };
 
+
+/*
+ * Reads a file written by a binary Watcher.
+ *
+ *   WatcherReader r("fileName");
+ *   UInt32 watchID; UInt64 iteration; Array value;
+ *   while (r.next(watchID, iteration, value)) { ... }
+ *
+ * The value of a scalar parameter is an Array of one element, a string
+ * parameter an Array of one string, a sparse value an SDR with dimensions
+ * of the element count, a dense value an Array of its elements.
+ */
+class WatcherReader {
+public:
+  struct Watch {
+    UInt32 watchID;
+    std::string regionName;
+    std::string varName;
+    Int64 nodeIndex;
+    NTA_BasicType type;
+    Watcher::BinaryLayout layout;
+  };
+
+  explicit WatcherReader(const std::string &fileName);
+
+  const std::vector<Watch> &getWatches() const { return watches_; }
+  UInt32 getSampling() const { return sampling_; }
+
+  // Reads the next record, returns false at the end of the file.
+  bool next(UInt32 &watchID, UInt64 &iteration, Array &value);
+
+private:
+  SDR_encoded_t data_;
+  size_t offset_ = 0u;
+  UInt32 sampling_ = 1u;
+  std::vector<Watch> watches_;
+  std::vector<UInt32> sparse_; // reused
+};
+
 } // namespace htm
 
 #endif // NTA_WATCHER_HPP
@@ -102,6 +102,8 @@
 // A.getBuffer()                     -- returns a void* pointer to beginning of buffer.
 // A.setBuffer(ptr, count)           -- set un-owned buffer
 // A.setBuffer(sdr)                  -- set un-owned SDR
+// A.setBufferRange(B, offset, count) -- share a range of the buffer of B  (not SDR)
+// A.isBufferRange(B, offset)         -- returns true if A shares the range of B at offset
 // A.zeroBuffer()                    -- fills A with 0's, A retains type and size.
 // A.releaseBuffer()                 -- free everything (if owned)
 // A.getSDR()                        -- get reference to enclosed SDR
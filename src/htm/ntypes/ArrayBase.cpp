@@ -19,6 +19,7 @@
  * Implementation of the ArrayBase class
  */
 
+#include <cstdint>  // for uintptr_t
 #include <cstdlib>  // for size_t
 #include <cstring>  // for memcpy, memcmp
 #include <iostream> // for ostream
@@ -26,7 +27,10 @@
 #include <vector>
 
 #include <htm/ntypes/ArrayBase.hpp>
+#include <htm/ntypes/BufferPool.hpp>
 #include <htm/ntypes/Value.hpp>
+#include <htm/types/SdrCodec.hpp>
+#include <htm/utils/MemoryResource.hpp>
 
 #include <htm/utils/Log.hpp>
 
@@ -104,6 +108,7 @@ char *ArrayBase::allocateBuffer(size_t count) {
   // disambiguate uninitialized ArrayBases and ArrayBases initialized with
   // size zero.
   count_ = count;
+  capacity_ = count;
   if (type_ == NTA_BasicType_SDR) {
     std::vector<UInt> dimension;
     dimension.push_back((UInt)count);
@@ -113,8 +118,12 @@ char *ArrayBase::allocateBuffer(size_t count) {
     char *s = reinterpret_cast<char *>(new std::string[count_]);
     buffer_.reset(s, StrDeleter());
   } else {
-    std::shared_ptr<char> sp(new char[count_ * BasicType::getSize(type_)], std::default_delete<char[]>());
-    buffer_ = sp;
+    // Recycled through the BufferPool when the last copy drops it.
+    const size_t size = BasicType::getSize(type_);
+    const size_t bytes = count_ * size;
+    buffer_ = BufferPool::allocate(bytes);
+    capacity_ = paddedBytes(bytes) / size;
+    std::memset(buffer_.get() + bytes, 0, capacity_ * size - bytes);
   }
   return buffer_.get();
 }
@@ -125,6 +134,7 @@ char *ArrayBase::allocateBuffer(const std::vector<UInt> &dimensions) { // only f
   std::shared_ptr<char> sp(reinterpret_cast<char *>(sdr));
   buffer_ = sp;
   count_ = sdr->size;
+  capacity_ = count_;
   return buffer_.get();
 }
 
@@ -140,7 +150,7 @@ void ArrayBase::zeroBuffer() {
       for (size_t i = 0; i < count_; i++)
         ptr[i] = "";
     } else
-      std::memset(buffer_.get(), 0, count_ * BasicType::getSize(type_));
+      std::memset(buffer_.get(), 0, capacity_ * BasicType::getSize(type_));
   }
 }
 
@@ -157,19 +167,44 @@ void ArrayBase::zeroBuffer() {
 void ArrayBase::setBuffer(void *buffer, size_t count) {
   NTA_CHECK(type_ != NTA_BasicType_SDR);
   count_ = count;
+  capacity_ = count;
   buffer_ = std::shared_ptr<char>(reinterpret_cast<char *>(buffer), nonDeleter());
 }
 void ArrayBase::setBuffer(SDR &sdr) {
   type_ = NTA_BasicType_SDR;
   buffer_ = std::shared_ptr<char>(reinterpret_cast<char *>(&sdr), nonDeleter());
   count_ = sdr.size;
+  capacity_ = count_;
 }
 
 
 
+void ArrayBase::setBufferRange(ArrayBase &a, size_t offset, size_t count) {
+  NTA_CHECK(type_ == a.type_) << "setBufferRange() requires the same type.";
+  NTA_CHECK(type_ != NTA_BasicType_SDR && type_ != NTA_BasicType_Str)
+      << "setBufferRange() not valid for " << BasicType::getName(type_);
+  NTA_CHECK(a.has_buffer() && offset + count <= a.count_) << "Requested range out of range.";
+  // aliasing constructor, shares the ownership of the buffer of a.
+  buffer_ = std::shared_ptr<char>(a.buffer_, a.buffer_.get() + offset * BasicType::getSize(type_));
+  count_ = count;
+  capacity_ = count;
+}
+
+bool ArrayBase::isBufferRange(const ArrayBase &a, size_t offset) const {
+  if (a.buffer_ == nullptr || buffer_ == nullptr || type_ != a.type_ ||
+      type_ == NTA_BasicType_SDR || type_ == NTA_BasicType_Str)
+    return false;
+  return buffer_.get() == a.buffer_.get() + offset * BasicType::getSize(type_);
+}
+
 void ArrayBase::releaseBuffer() {
   buffer_.reset();
   count_ = 0;
+  capacity_ = 0;
+}
+
+bool ArrayBase::isAligned() const {
+  return reinterpret_cast<std::uintptr_t>(getBuffer()) % SIMD_ALIGNMENT == 0u;
 }
 
 void *ArrayBase::getBuffer() {
@@ -271,11 +306,35 @@ void ArrayBase::convertInto(ArrayBase &a, size_t offset, size_t maxsize) const {
   //    a.setCount(maxsize);
   //}
   NTA_CHECK(getCount() + offset <= maxsize);
+  const bool fromSDR = type_ == NTA_BasicType_SDR;
+  const bool toSDR = a.type_ == NTA_BasicType_SDR;
+  const bool fromStr = type_ == NTA_BasicType_Str;
+  const bool toStr = a.type_ == NTA_BasicType_Str;
+
+  // Sparse conversions, which do not go through the dense buffer of an SDR.
+  if (toSDR && offset == 0 && getCount() == a.getCount() && !fromStr) {
+    SDR_sparse_t sparse;
+    if (fromSDR) {
+      sparse = getSDR().getSparse();
+    } else {
+      BasicType::nonzeroIndices(getBuffer(), type_, getCount(), sparse);
+    }
+    a.getSDR().setSparse(sparse);
+    return;
+  }
   char *toPtr =  reinterpret_cast<char *>(a.getBuffer()); // char* so it has size
   if (offset)
     toPtr += (offset * BasicType::getSize(a.getType()));
+  if (fromSDR && !toSDR && !toStr) {
+    const SDR_sparse_t &sparse = getSDR().getSparse();
+    BasicType::convertSparseToArray(toPtr, a.type_, getCount(), sparse.data(), sparse.size());
+    return;
+  }
   const void *fromPtr = getBuffer();
   BasicType::convertArray(toPtr, a.type_, fromPtr, type_, getCount());
+  if (toSDR) {
+    a.RefreshCache(); // the dense buffer of the SDR was written directly.
+  }
 }
 
 bool ArrayBase::isInstance(const ArrayBase &a) const {
@@ -722,4 +781,58 @@ std::string ArrayBase::toJSON() const {
   return json.str();
 }
 
+std::string ArrayBase::toBinary() const {
+  NTA_CHECK(type_ != NTA_BasicType_Str && type_ != NTA_BasicType_Handle)
+      << "Binary format is not supported for element type " << BasicType::getName(type_);
+  SDR_encoded_t out;
+  out.push_back(static_cast<Byte>(type_));
+  if (type_ == NTA_BasicType_SDR) {
+    const SDR &sdr = getSDR();
+    putVarint(sdr.dimensions.size(), out);
+    for (const auto dim : sdr.dimensions)
+      putVarint(dim, out);
+    encodeSparse(sdr.getSparse(), out);
+  } else {
+    putVarint(count_, out);
+    const char *buf = static_cast<const char *>(getBuffer());
+    out.insert(out.end(), buf, buf + count_ * BasicType::getSize(type_));
+  }
+  return std::string(out.begin(), out.end());
+}
+
+void ArrayBase::fromBinary(const std::string &data) {
+  const SDR_encoded_t in(data.begin(), data.end());
+  NTA_CHECK(!in.empty()) << "Binary Array: no data.";
+  const auto type = static_cast<NTA_BasicType>(static_cast<unsigned char>(in[0]));
+  NTA_CHECK(BasicType::isValid(type) && type != NTA_BasicType_Str && type != NTA_BasicType_Handle)
+      << "Binary Array: unexpected element type " << static_cast<int>(type);
+  size_t offset = 1u;
+  type_ = type;
+  if (type_ == NTA_BasicType_SDR) {
+    const UInt64 numDims = getVarint(in, offset);
+    NTA_CHECK(numDims > 0u && numDims <= in.size() - offset) << "Binary Array: corrupt dimensions.";
+    std::vector<UInt> dimensions;
+    for (UInt64 i = 0u; i < numDims; i++)
+      dimensions.push_back(static_cast<UInt>(getVarint(in, offset)));
+    allocateBuffer(dimensions);
+    std::vector<UInt32> sparse;
+    offset = decodeSparse(in, offset, sparse);
+    // setSparse() checks only with assertions on, the data is from a client
+    NTA_CHECK(sparse.empty() || sparse.back() < getSDR().size) << "Binary Array: index out of range.";
+    for (size_t i = 1u; i < sparse.size(); i++)
+      NTA_CHECK(sparse[i - 1u] < sparse[i]) << "Binary Array: indices must be sorted and unique.";
+    getSDR().setSparse(sparse);
+  } else {
+    const UInt64 count = getVarint(in, offset);
+    NTA_CHECK(count <= in.size() - offset) << "Binary Array: truncated data.";
+    const size_t bytes = static_cast<size_t>(count) * BasicType::getSize(type_);
+    NTA_CHECK(bytes == in.size() - offset) << "Binary Array: expected " << count << " elements.";
+    allocateBuffer(static_cast<size_t>(count));
+    if (bytes > 0u)
+      std::memcpy(getBuffer(), in.data() + offset, bytes);
+    offset += bytes;
+  }
+  NTA_CHECK(offset == in.size()) << "Binary Array: unexpected data after the array.";
+}
+
 } // namespace htm
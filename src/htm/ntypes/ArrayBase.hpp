@@ -36,6 +36,7 @@
 #include <iostream> // for ostream, istream
 #include <string>
 #include <memory>	// for shared_ptr
+#include <type_traits>
 #include <vector>
 
 #include <htm/types/Serializable.hpp>
@@ -129,6 +130,21 @@ namespace htm
      */
     size_t getCount() const;
 
+    /**
+     * Number of elements the buffer holds, at least getCount().  The buffers
+     * of allocateBuffer() are aligned to SIMD_ALIGNMENT (@see isAligned) and
+     * padded to a multiple of SIMD_ALIGNMENT bytes, so a SIMD kernel may
+     * process whole vectors up to the capacity.  The padding is zero after
+     * allocateBuffer() and zeroBuffer().  External buffers and buffer ranges
+     * have no padding.  For SDR and String, same as getCount().
+     */
+    size_t getCapacity() const { return capacity_; }
+
+    /**
+     * Returns true if getBuffer() is aligned to SIMD_ALIGNMENT, which is
+     * always the case after allocateBuffer() of a numeric type.
+     */
+    bool isAligned() const;
 
 
     /**
@@ -151,6 +167,20 @@ namespace htm
     virtual void setBuffer(void *buffer, size_t count);
     virtual void setBuffer(SDR &sdr);
 
+    /**
+     * Use the range [offset, offset+count) of the buffer of another ArrayBase
+     * of the same type as the buffer.  Both share the ownership of the buffer,
+     * writing into this ArrayBase writes into that range of the other one.
+     * Not valid for SDR or String types.
+     */
+    void setBufferRange(ArrayBase &a, size_t offset, size_t count);
+
+    /**
+     * Determines if the buffer is the range of the buffer of the argument
+     * which starts at the offset, see setBufferRange().
+     */
+    bool isBufferRange(const ArrayBase &a, size_t offset) const;
+
 
     /**
      * Return the type of data contained in the ArrayBase object.
@@ -217,6 +247,7 @@ namespace htm
         ar(cereal::make_nvp("SDR", *sdr));
         buffer_.reset(reinterpret_cast<char*>(sdr));
         count_ = sdr->size;
+        capacity_ = count_;
       } else {
         void* ptr = getBuffer();
         size_t count = getCount();
@@ -245,6 +276,13 @@ namespace htm
     void fromJSON(const std::string &data) { return fromYAML(data); }
     std::string toJSON() const;
 
+    // Compact binary serialization, eg. for the REST wire format.
+    //    <type byte> <SDR: varint number of dims, varint dims, encodeSparse() of the indices>
+    //                <other: varint count, the elements in host byte order>
+    // String and Handle arrays are not supported.
+    std::string toBinary() const;
+    void fromBinary(const std::string &data);
+
 
     // ascii text representation
     //    [ type count ( item item item ...) ... ]
@@ -257,22 +295,60 @@ namespace htm
     // cast to/from void* as necessary
     std::shared_ptr<char> buffer_;
     size_t count_;      // number of elements in the buffer
+    size_t capacity_ = 0u; // number of elements including the padding
     NTA_BasicType type_;// type of data in this buffer
 
     // Buffer array conversion routines
     void convertInto(ArrayBase &a, size_t offset=0, size_t maxsize=0) const;
 
   private:
-    // helpers for Cereal Serialization of raw pointers to arrays
-		// copy the array to a vector and let Cereal handle it.
+    // helpers for Cereal Serialization of raw pointers to arrays.
+    // The binary archives (BINARY, PORTABLE) write numeric arrays as one
+    // block, PORTABLE swaps the bytes in bulk when the byte order differs.
+    // The block is what cereal writes for a std::vector<T>, so the format
+    // is unchanged.  The text archives copy the array to a vector and let
+    // Cereal handle it.
+    template<class Archive, class T>
+    using binary_array = std::integral_constant<bool,
+        std::is_arithmetic<T>::value and
+        cereal::traits::is_output_serializable<cereal::BinaryData<const T*>, Archive>::value>;
+    template<class Archive, class T>
+    using binary_load_array = std::integral_constant<bool,
+        std::is_arithmetic<T>::value and
+        cereal::traits::is_input_serializable<cereal::BinaryData<T*>, Archive>::value>;
+
     template<class Archive, class T>
     void save_array(Archive& ar, const T* ptr, size_t count) const {
+      save_array_(ar, ptr, count, binary_array<Archive, T>());
+    }
+
+    template<class Archive, class T>
+    void save_array_(Archive& ar, const T* ptr, size_t count, std::true_type) const {
+      ar(cereal::make_size_tag(static_cast<cereal::size_type>(count)));
+      ar(cereal::binary_data(static_cast<const T*>(ptr), count * sizeof(T)));
+    }
+
+    template<class Archive, class T>
+    void save_array_(Archive& ar, const T* ptr, size_t count, std::false_type) const {
       std::vector<T> a(ptr, ptr+count);
       ar(cereal::make_nvp("data", a));
     }
 
     template<class Archive, class T>
-    void load_array(Archive& ar, T* ptr, size_t count) {
+    void load_array(Archive& ar, T* ptr, size_t) {
+      load_array_(ar, ptr, binary_load_array<Archive, T>());
+    }
+
+    template<class Archive, class T>
+    void load_array_(Archive& ar, T*, std::true_type) {
+      cereal::size_type count;
+      ar(cereal::make_size_tag(count));
+      allocateBuffer(static_cast<size_t>(count));
+      ar(cereal::binary_data(reinterpret_cast<T*>(getBuffer()), static_cast<size_t>(count) * sizeof(T)));
+    }
+
+    template<class Archive, class T>
+    void load_array_(Archive& ar, T* ptr, std::false_type) {
       std::vector<T> a;
       ar(a);
       allocateBuffer(a.size());
@@ -15,6 +15,7 @@
  * along with this program.  If not, see http://www.gnu.org/licenses.
  * --------------------------------------------------------------------- */
 
+#include <algorithm> // fill
 #include <limits>
 #include <cerrno>
 #include <cstring> // std::strerror(errno)
@@ -827,3 +828,80 @@ void BasicType::convertArray(void *ptr1, NTA_BasicType toType, const void *ptr2,
               << " to " << BasicType::getName(toType) << " " << e.what();
   }
 }
+
+
+template <typename T>
+static void scatterOnes(void *toPtr, size_t count, const UInt32 *indices, size_t numIndices) {
+  T *ptr = static_cast<T *>(toPtr);
+  std::fill(ptr, ptr + count, static_cast<T>(0));
+  for (size_t i = 0u; i < numIndices; i++) {
+    NTA_ASSERT(indices[i] < count);
+    ptr[indices[i]] = static_cast<T>(1);
+  }
+}
+
+void BasicType::convertSparseToArray(void *toPtr, NTA_BasicType toType, size_t count,
+                                     const UInt32 *indices, size_t numIndices) {
+  switch (toType) {
+  case NTA_BasicType_Byte:   scatterOnes<Byte>(toPtr, count, indices, numIndices);   break;
+  case NTA_BasicType_Int16:  scatterOnes<Int16>(toPtr, count, indices, numIndices);  break;
+  case NTA_BasicType_UInt16: scatterOnes<UInt16>(toPtr, count, indices, numIndices); break;
+  case NTA_BasicType_Int32:  scatterOnes<Int32>(toPtr, count, indices, numIndices);  break;
+  case NTA_BasicType_UInt32: scatterOnes<UInt32>(toPtr, count, indices, numIndices); break;
+  case NTA_BasicType_Int64:  scatterOnes<Int64>(toPtr, count, indices, numIndices);  break;
+  case NTA_BasicType_UInt64: scatterOnes<UInt64>(toPtr, count, indices, numIndices); break;
+  case NTA_BasicType_Real32: scatterOnes<Real32>(toPtr, count, indices, numIndices); break;
+  case NTA_BasicType_Real64: scatterOnes<Real64>(toPtr, count, indices, numIndices); break;
+  case NTA_BasicType_Bool:   scatterOnes<bool>(toPtr, count, indices, numIndices);   break;
+  default:
+    NTA_THROW << "Could not convert sparse indices to " << BasicType::getName(toType);
+  }
+}
+
+/**
+ * Branch free scan, every index is written and kept only if its element is
+ * nonzero, so the loop does not mispredict on random data.  Runs of zero
+ * bytes are skipped 8 at a time for the 1 byte types.
+ */
+template <typename T>
+static void scanNonzero(const void *fromPtr, size_t count, std::vector<UInt32> &indices) {
+  const T *ptr = static_cast<const T *>(fromPtr);
+  indices.resize(count);
+  UInt32 *out = indices.data();
+  size_t n = 0u;
+  size_t i = 0u;
+  if (sizeof(T) == 1u) {
+    for (; i + 8u <= count; i += 8u) {
+      UInt64 word;
+      std::memcpy(&word, ptr + i, 8u);
+      if (word == 0u) continue;
+      for (size_t j = i; j < i + 8u; j++) {
+        out[n] = static_cast<UInt32>(j);
+        n += ptr[j] != static_cast<T>(0);
+      }
+    }
+  }
+  for (; i < count; i++) {
+    out[n] = static_cast<UInt32>(i);
+    n += ptr[i] != static_cast<T>(0);
+  }
+  indices.resize(n);
+}
+
+void BasicType::nonzeroIndices(const void *fromPtr, NTA_BasicType fromType, size_t count,
+                               std::vector<UInt32> &indices) {
+  switch (fromType) {
+  case NTA_BasicType_Byte:   scanNonzero<Byte>(fromPtr, count, indices);   break;
+  case NTA_BasicType_Int16:  scanNonzero<Int16>(fromPtr, count, indices);  break;
+  case NTA_BasicType_UInt16: scanNonzero<UInt16>(fromPtr, count, indices); break;
+  case NTA_BasicType_Int32:  scanNonzero<Int32>(fromPtr, count, indices);  break;
+  case NTA_BasicType_UInt32: scanNonzero<UInt32>(fromPtr, count, indices); break;
+  case NTA_BasicType_Int64:  scanNonzero<Int64>(fromPtr, count, indices);  break;
+  case NTA_BasicType_UInt64: scanNonzero<UInt64>(fromPtr, count, indices); break;
+  case NTA_BasicType_Real32: scanNonzero<Real32>(fromPtr, count, indices); break;
+  case NTA_BasicType_Real64: scanNonzero<Real64>(fromPtr, count, indices); break;
+  case NTA_BasicType_Bool:   scanNonzero<bool>(fromPtr, count, indices);   break;
+  default:
+    NTA_THROW << "Could not scan " << BasicType::getName(fromType) << " for nonzero elements";
+  }
+}
@@ -20,6 +20,7 @@
 
 #include <htm/types/Types.hpp>
 #include <string>
+#include <vector>
 
 namespace htm {
 
@@ -31,6 +32,8 @@ namespace htm {
  * - getSize()
  * - parse()
  * - convertArray()
+ * - convertSparseToArray()
+ * - nonzeroIndices()
  */
 class BasicType {
 public:
@@ -84,6 +87,24 @@ public:
   static void convertArray(void *toPtr, NTA_BasicType toType, const void *fromPtr,
                       NTA_BasicType fromType, size_t count);
 
+  /**
+   * Sparse to dense conversion, ex: from the active bits of an SDR.
+   * Fills the array of the specified type with 0's and sets the elements at
+   * the given indices to 1.  Touches the array once, and the indices once.
+   * Not valid for SDR or String types.
+   */
+  static void convertSparseToArray(void *toPtr, NTA_BasicType toType, size_t count,
+                                   const UInt32 *indices, size_t numIndices);
+
+  /**
+   * Dense to sparse conversion, ex: into the active bits of an SDR.
+   * Replaces the content of `indices` with the indices of the nonzero
+   * elements of the array, in increasing order.
+   * Not valid for SDR or String types.
+   */
+  static void nonzeroIndices(const void *fromPtr, NTA_BasicType fromType, size_t count,
+                             std::vector<UInt32> &indices);
+
 
 private:
   BasicType();
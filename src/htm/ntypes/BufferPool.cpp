@@ -0,0 +1,156 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the BufferPool class
+ */
+
+#include <atomic>
+#include <vector>
+
+#include <htm/ntypes/BufferPool.hpp>
+#include <htm/utils/MemoryResource.hpp>
+
+namespace htm {
+
+namespace {
+
+const size_t MIN_CLASS_BYTES = SIMD_ALIGNMENT;
+const size_t NUM_CLASSES = 21u; // 64 bytes to 64 MB
+
+std::atomic<UInt64> allocations(0u);
+std::atomic<UInt64> reuses(0u);
+std::atomic<UInt64> releases(0u);
+std::atomic<UInt64> cachedBytes(0u);
+std::atomic<bool> enabled(true);
+std::atomic<size_t> maxCachedBytes(64u * 1024u * 1024u);
+
+size_t classBytes(size_t sizeClass) { return MIN_CLASS_BYTES << sizeClass; }
+
+// The free lists of one thread.
+struct Cache {
+  std::vector<char *> free[NUM_CLASSES];
+  size_t bytes = 0u;
+
+  void clear() {
+    for (size_t c = 0u; c < NUM_CLASSES; c++) {
+      for (auto p : free[c]) alignedDeallocate(p);
+      free[c].clear();
+    }
+    cachedBytes -= bytes;
+    bytes = 0u;
+  }
+  ~Cache();
+};
+
+// Buffers may drop while the thread exits, after its Cache is destroyed.
+enum class CacheState : char { None, Alive, Destroyed };
+thread_local CacheState cacheState = CacheState::None;
+
+Cache::~Cache() {
+  clear();
+  cacheState = CacheState::Destroyed;
+}
+
+Cache &threadCache() {
+  thread_local Cache cache;
+  cacheState = CacheState::Alive;
+  return cache;
+}
+
+struct PoolDeleter {
+  size_t sizeClass;
+
+  void operator()(char *p) const {
+    releases++;
+    const size_t size = classBytes(sizeClass);
+    if (cacheState == CacheState::Destroyed or not enabled) {
+      alignedDeallocate(p);
+      return;
+    }
+    Cache &cache = threadCache();
+    if (cache.bytes + size > maxCachedBytes) {
+      alignedDeallocate(p);
+      return;
+    }
+    cache.free[sizeClass].push_back(p);
+    cache.bytes += size;
+    cachedBytes += size;
+  }
+};
+
+} // namespace
+
+
+std::shared_ptr<char> BufferPool::allocate(size_t bytes) {
+  size_t sizeClass = 0u;
+  while (sizeClass < NUM_CLASSES and classBytes(sizeClass) < bytes) {
+    sizeClass++;
+  }
+  if (sizeClass == NUM_CLASSES or not enabled or cacheState == CacheState::Destroyed) {
+    allocations++;
+    return std::shared_ptr<char>(static_cast<char *>(alignedAllocate(paddedBytes(bytes))),
+                                 alignedDeallocate);
+  }
+
+  Cache &cache = threadCache();
+  auto &free = cache.free[sizeClass];
+  char *p;
+  if (free.empty()) {
+    p = static_cast<char *>(alignedAllocate(classBytes(sizeClass)));
+    allocations++;
+  } else {
+    p = free.back();
+    free.pop_back();
+    cache.bytes -= classBytes(sizeClass);
+    cachedBytes -= classBytes(sizeClass);
+    reuses++;
+  }
+  return std::shared_ptr<char>(p, PoolDeleter{sizeClass});
+}
+
+
+BufferPool::Statistics BufferPool::getStatistics() {
+  Statistics stats;
+  stats.allocations = allocations;
+  stats.reuses = reuses;
+  stats.releases = releases;
+  stats.cachedBytes = cachedBytes;
+  return stats;
+}
+
+
+void BufferPool::trim() {
+  if (cacheState == CacheState::Alive) {
+    threadCache().clear();
+  }
+}
+
+
+void BufferPool::setEnabled(bool enable) {
+  enabled = enable;
+  if (not enable) trim();
+}
+
+bool BufferPool::isEnabled() { return enabled; }
+
+
+void BufferPool::setMaxCachedBytes(size_t bytes) { maxCachedBytes = bytes; }
+
+size_t BufferPool::getMaxCachedBytes() { return maxCachedBytes; }
+
+} // namespace htm
@@ -0,0 +1,90 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the BufferPool class
+ */
+
+#ifndef NTA_BUFFER_POOL_HPP
+#define NTA_BUFFER_POOL_HPP
+
+#include <memory>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * BufferPool - recycles the buffers of Array objects.
+ *
+ * @b Description
+ * The buffers are rounded up to a power of two bytes (a size class).  When
+ * the last shared_ptr to a buffer drops, the buffer goes to a free list of
+ * the thread which dropped it, and the next allocation of the same size
+ * class on that thread reuses it.  So an iteration of a Network which
+ * copies Arrays allocates nothing once the free lists are warm.
+ *
+ * Each thread caches at most getMaxCachedBytes(); beyond that, and for
+ * buffers larger than the largest size class, the memory is freed.
+ *
+ * The statistics are shared by all threads, they show whether the steady
+ * state of a program allocates:
+ *    auto before = BufferPool::getStatistics();
+ *    net.run(100);
+ *    NTA_CHECK(BufferPool::getStatistics().allocations == before.allocations);
+ */
+class BufferPool {
+public:
+  struct Statistics {
+    UInt64 allocations = 0u; // buffers allocated from the heap
+    UInt64 reuses = 0u;      // buffers taken from a free list
+    UInt64 releases = 0u;    // buffers dropped by their last owner
+    UInt64 cachedBytes = 0u; // bytes in the free lists of all threads
+  };
+
+  /**
+   * @returns a buffer of at least the given number of bytes, which returns
+   * to the pool when the last copy of the shared_ptr is destroyed.  The
+   * buffer is aligned to SIMD_ALIGNMENT and holds at least the bytes rounded
+   * up to a multiple of SIMD_ALIGNMENT.  The contents are not initialized.
+   */
+  static std::shared_ptr<char> allocate(size_t bytes);
+
+  static Statistics getStatistics();
+
+  /**
+   * Free the buffers cached by the calling thread.
+   */
+  static void trim();
+
+  /**
+   * When disabled, allocate() takes every buffer from the heap and
+   * the released buffers are freed.  Enabled by default.
+   */
+  static void setEnabled(bool enabled);
+  static bool isEnabled();
+
+  /**
+   * The limit of the bytes cached by each thread.  Default 64 MB.
+   */
+  static void setMaxCachedBytes(size_t bytes);
+  static size_t getMaxCachedBytes();
+};
+
+} // namespace htm
+
+#endif // NTA_BUFFER_POOL_HPP
@@ -0,0 +1,98 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * CpuFeatures implementation
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+
+#include <htm/os/CpuFeatures.hpp>
+#include <htm/os/Env.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+static SimdLevel detect_() {
+#if NTA_SIMD_DISPATCH
+  // Checks cpuid and that the OS saves the registers (xgetbv).
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+  if (__builtin_cpu_supports("avx2"))    return SimdLevel::AVX2;
+#endif
+  return SimdLevel::Scalar;
+}
+
+// The level of NTA_SIMD, or the highest if not set.
+static SimdLevel envLevel_() {
+  const std::string value = Env::getOption("simd");
+  if (value.empty()) return SimdLevel::AVX512;
+  return CpuFeatures::parse(value);
+}
+
+static const UInt NO_CAP = 0xFFFFFFFFu;
+static std::atomic<UInt> cap_(NO_CAP); // of setLevel()
+
+
+SimdLevel CpuFeatures::detected() {
+  static const SimdLevel level = detect_();
+  return level;
+}
+
+
+SimdLevel CpuFeatures::level() {
+  static const SimdLevel env = std::min(detected(), envLevel_());
+  const UInt cap = cap_.load(std::memory_order_relaxed);
+  if (cap == NO_CAP) return env;
+  return std::min(env, static_cast<SimdLevel>(cap));
+}
+
+
+void CpuFeatures::setLevel(const SimdLevel level) {
+  cap_.store(static_cast<UInt>(level), std::memory_order_relaxed);
+}
+
+
+void CpuFeatures::resetLevel() {
+  cap_.store(NO_CAP, std::memory_order_relaxed);
+}
+
+
+std::string CpuFeatures::name(const SimdLevel level) {
+  switch (level) {
+    case SimdLevel::Scalar: return "scalar";
+    case SimdLevel::AVX2:   return "avx2";
+    case SimdLevel::AVX512: return "avx512";
+  }
+  NTA_THROW << "CpuFeatures: unknown SimdLevel " << static_cast<UInt>(level);
+}
+
+
+SimdLevel CpuFeatures::parse(const std::string &name) {
+  std::string lower = name;
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  for (const auto level : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+    if (lower == CpuFeatures::name(level)) return level;
+  }
+  NTA_THROW << "CpuFeatures: unknown SIMD level '" << name
+            << "', expected scalar, avx2 or avx512";
+}
+
+} // namespace htm
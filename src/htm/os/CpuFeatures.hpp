@@ -0,0 +1,130 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * CpuFeatures interface
+ */
+
+#ifndef NTA_CPU_FEATURES_HPP
+#define NTA_CPU_FEATURES_HPP
+
+#include <string>
+
+#include <htm/types/Types.hpp>
+
+// Variants of a kernel for a SIMD level are compiled from the same (auto
+// vectorized) source with a target attribute, so the library is built for
+// the baseline of the fleet and still uses the wider units where present.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #define NTA_SIMD_DISPATCH 1
+  #define NTA_TARGET_AVX2   __attribute__((target("avx2")))
+  #define NTA_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+  #define NTA_SIMD_DISPATCH 0
+#endif
+
+namespace htm {
+
+/**
+ * The SIMD instruction sets a kernel may be specialized for, in increasing
+ * order.  Each level implies the ones below it.
+ */
+enum class SimdLevel : UInt {
+  Scalar = 0u, // no assumptions, the baseline of the build
+  AVX2   = 1u,
+  AVX512 = 2u, // AVX-512 F
+};
+
+/**
+ * Detection of the SIMD level of the CPU, at runtime.
+ *
+ * The CPU is queried once (cpuid, and whether the OS saves the wide
+ * registers).  The environment variable NTA_SIMD=scalar|avx2|avx512 caps
+ * the level, eg. to compare the variants of the kernels or to reproduce the
+ * results of an older machine; it can not enable a level the CPU lacks.
+ * On other architectures and compilers the level is always Scalar.
+ */
+class CpuFeatures {
+public:
+  /**
+   * @returns the best level supported by the CPU and the OS.
+   */
+  static SimdLevel detected();
+
+  /**
+   * @returns the level the kernels use: detected(), capped by NTA_SIMD and
+   * by setLevel().
+   */
+  static SimdLevel level();
+
+  /**
+   * Cap the level of the kernels, for all threads.  A level above
+   * detected() is reduced to it.  This is a runtime setting, it is not
+   * serialized.
+   */
+  static void setLevel(SimdLevel level);
+
+  /**
+   * Remove the cap of setLevel(), back to detected() capped by NTA_SIMD.
+   */
+  static void resetLevel();
+
+  static std::string name(SimdLevel level);
+
+  /**
+   * Parse the name of a level, case insensitive.
+   * @throws if the name is unknown.
+   */
+  static SimdLevel parse(const std::string &name);
+};
+
+
+/**
+ * KernelTable - the variants of a kernel, one function per SIMD level.
+ *
+ * Levels without a variant fall back to the next lower one, so the Scalar
+ * variant is required.  The lookup is an array index per call, which is
+ * negligible next to the kernels it selects.
+ *
+ * Example Usage:
+ *    static const KernelTable<void(*)(const Real*, size_t)> sumKernels(
+ *        sumScalar, sumAVX2, nullptr );
+ *    sumKernels.get()( data, n );
+ */
+template<typename Function>
+class KernelTable {
+public:
+  KernelTable(Function scalar, Function avx2 = nullptr, Function avx512 = nullptr)
+  {
+    variants_[0] = scalar;
+    variants_[1] = avx2   != nullptr ? avx2   : variants_[0];
+    variants_[2] = avx512 != nullptr ? avx512 : variants_[1];
+  }
+
+  /** @returns the variant for CpuFeatures::level(). */
+  Function get() const { return get(CpuFeatures::level()); }
+
+  /** @returns the variant for the level, or the next lower one. */
+  Function get(SimdLevel level) const { return variants_[static_cast<UInt>(level)]; }
+
+private:
+  Function variants_[3];
+};
+
+} // namespace htm
+
+#endif // NTA_CPU_FEATURES_HPP
@@ -0,0 +1,73 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * MappedFile implementation
+ */
+
+#include <htm/os/MappedFile.hpp>
+#include <htm/utils/Log.hpp>
+#include <fstream>
+#if !defined(NTA_OS_WINDOWS)
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace htm {
+
+MappedFile::MappedFile(const std::string &path) {
+#if !defined(NTA_OS_WINDOWS)
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  NTA_CHECK(fd >= 0) << "MappedFile: can not open " << path;
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    ::close(fd);
+    NTA_THROW << "MappedFile: can not stat " << path;
+  }
+  size_ = static_cast<size_t>(info.st_size);
+  if (size_ > 0u) {
+    void *address = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd); // the mapping keeps the file open
+    NTA_CHECK(address != MAP_FAILED) << "MappedFile: can not map " << path;
+    data_ = static_cast<const char *>(address);
+    mapped_ = true;
+  } else {
+    ::close(fd);
+  }
+#else
+  std::ifstream in(path, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+  NTA_CHECK(in.is_open()) << "MappedFile: can not open " << path;
+  size_ = static_cast<size_t>(in.tellg());
+  buffer_.resize(size_);
+  in.seekg(0);
+  in.read(buffer_.data(), static_cast<std::streamsize>(size_));
+  NTA_CHECK(in.good()) << "MappedFile: can not read " << path;
+  data_ = buffer_.data();
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if !defined(NTA_OS_WINDOWS)
+  if (mapped_) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+#endif
+}
+
+} // namespace htm
@@ -0,0 +1,61 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * MappedFile interface
+ */
+
+#ifndef NTA_MAPPED_FILE_HPP
+#define NTA_MAPPED_FILE_HPP
+
+#include <string>
+#include <vector>
+
+namespace htm {
+
+/**
+ * A file mapped read-only into memory.
+ *
+ * The pages are loaded on first access and shared by all the processes
+ * which map the same file.  The mapping starts at a page boundary, so data
+ * at aligned offsets in the file is aligned in memory.  On platforms without
+ * mmap the file is read into memory instead.
+ */
+class MappedFile {
+public:
+  /**
+   * Map the file.  Throws if the file can not be opened.
+   */
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const char *data_ = nullptr;
+  size_t size_ = 0u;
+  bool mapped_ = false;
+  std::vector<char> buffer_; // without mmap
+};
+
+} // namespace htm
+
+#endif // NTA_MAPPED_FILE_HPP
@@ -145,6 +145,15 @@ Size Path::getFileSize(const std::string &path) {
   return (Size)fs::file_size(path);
 }
 
+Int64 Path::getLastWriteTime(const std::string &path) {
+#ifdef USE_BOOST_FILESYSTEM
+  // boost returns a std::time_t, in seconds
+  return (Int64)fs::last_write_time(path);
+#else
+  return (Int64)fs::last_write_time(path).time_since_epoch().count();
+#endif
+}
+
 
 /**
  *  A path can be normalized by following this algorithm:  (from C++17 std::filesystem::path)
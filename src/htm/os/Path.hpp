@@ -176,6 +176,13 @@ public:
    */
   static Size getFileSize(const std::string &path);
 
+  /**
+   * An opaque stamp of the last modification of a file, which changes when
+   * the file is written, to the resolution of the filesystem library (a
+   * second with boost::filesystem).  Throws if it does not exist.
+   */
+  static Int64 getLastWriteTime(const std::string &path);
+
   /**
    * If source is a file, copy the file to the destination.
    * if a folder, copy entire folder recursivly.
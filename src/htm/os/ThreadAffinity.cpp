@@ -0,0 +1,174 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * ThreadAffinity implementation
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <htm/os/ThreadAffinity.hpp>
+#include <htm/utils/Log.hpp>
+
+#if defined(NTA_OS_LINUX)
+  #include <pthread.h>
+  #include <sched.h>
+#elif defined(NTA_OS_WINDOWS)
+  #include <windows.h>
+#endif
+
+namespace htm {
+
+#if defined(NTA_OS_LINUX)
+
+static bool setAffinity_(pthread_t thread, const std::vector<UInt> &cores) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (cores.empty()) {
+    for (int core = 0; core < CPU_SETSIZE; core++) CPU_SET(core, &set);
+  }
+  for (const auto core : cores) {
+    if (core >= static_cast<UInt>(CPU_SETSIZE)) return false;
+    CPU_SET(core, &set);
+  }
+  return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+}
+
+#elif defined(NTA_OS_WINDOWS)
+
+static bool setAffinity_(HANDLE thread, const std::vector<UInt> &cores) {
+  DWORD_PTR mask = 0u;
+  if (cores.empty()) {
+    DWORD_PTR system = 0u;
+    if (not GetProcessAffinityMask(GetCurrentProcess(), &mask, &system)) return false;
+  }
+  for (const auto core : cores) {
+    if (core >= 8u * sizeof(DWORD_PTR)) return false;
+    mask |= static_cast<DWORD_PTR>(1u) << core;
+  }
+  return SetThreadAffinityMask(thread, mask) != 0u;
+}
+
+#endif
+
+
+bool ThreadAffinity::isSupported() {
+#if defined(NTA_OS_LINUX) || defined(NTA_OS_WINDOWS)
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+bool ThreadAffinity::set(const std::vector<UInt> &cores) {
+#if defined(NTA_OS_LINUX)
+  return setAffinity_(pthread_self(), cores);
+#elif defined(NTA_OS_WINDOWS)
+  return setAffinity_(GetCurrentThread(), cores);
+#else
+  return false;
+#endif
+}
+
+
+bool ThreadAffinity::set(std::thread &thread, const std::vector<UInt> &cores) {
+#if defined(NTA_OS_LINUX) || defined(NTA_OS_WINDOWS)
+  return setAffinity_(thread.native_handle(), cores);
+#else
+  return false;
+#endif
+}
+
+
+std::vector<UInt> ThreadAffinity::get() {
+  std::vector<UInt> cores;
+#if defined(NTA_OS_LINUX)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0) {
+    for (int core = 0; core < CPU_SETSIZE; core++) {
+      if (CPU_ISSET(core, &set)) cores.push_back(static_cast<UInt>(core));
+    }
+  }
+#elif defined(NTA_OS_WINDOWS)
+  // Windows can only read the mask of a thread by replacing it.
+  DWORD_PTR process = 0u, system = 0u;
+  if (GetProcessAffinityMask(GetCurrentProcess(), &process, &system)) {
+    const DWORD_PTR mask = SetThreadAffinityMask(GetCurrentThread(), process);
+    if (mask != 0u) {
+      SetThreadAffinityMask(GetCurrentThread(), mask);
+      for (UInt core = 0u; core < 8u * sizeof(DWORD_PTR); core++) {
+        if (mask & (static_cast<DWORD_PTR>(1u) << core)) cores.push_back(core);
+      }
+    }
+  }
+#endif
+  return cores;
+}
+
+
+std::vector<UInt> ThreadAffinity::numaNodeCores(const UInt node) {
+  std::vector<UInt> cores;
+#if defined(NTA_OS_LINUX)
+  // A list of ranges, ex: "0-7,16-23"
+  std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+  std::string list;
+  if (not std::getline(file, list)) return cores;
+  std::istringstream ranges(list);
+  std::string range;
+  while (std::getline(ranges, range, ',')) {
+    if (range.empty()) continue;
+    const size_t dash = range.find('-');
+    const UInt first = static_cast<UInt>(std::stoul(range.substr(0, dash)));
+    const UInt last  = dash == std::string::npos ? first : static_cast<UInt>(std::stoul(range.substr(dash + 1u)));
+    for (UInt core = first; core <= last; core++) cores.push_back(core);
+  }
+#elif defined(NTA_OS_WINDOWS)
+  ULONGLONG mask = 0u;
+  if (node <= 0xFFu && GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask)) {
+    for (UInt core = 0u; core < 64u; core++) {
+      if (mask & (static_cast<ULONGLONG>(1u) << core)) cores.push_back(core);
+    }
+  }
+#endif
+  return normalize(cores);
+}
+
+
+std::vector<UInt> ThreadAffinity::normalize(std::vector<UInt> cores) {
+  std::sort(cores.begin(), cores.end());
+  cores.erase(std::unique(cores.begin(), cores.end()), cores.end());
+  return cores;
+}
+
+
+ScopedAffinity::ScopedAffinity(const std::vector<UInt> &cores) {
+  if (cores.empty()) return;
+  previous_ = ThreadAffinity::get();
+  if (previous_ == cores) return;
+  pinned_ = ThreadAffinity::set(cores);
+}
+
+ScopedAffinity::~ScopedAffinity() {
+  if (pinned_) ThreadAffinity::set(previous_);
+}
+
+} // namespace htm
@@ -0,0 +1,92 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * ThreadAffinity interface
+ */
+
+#ifndef NTA_THREAD_AFFINITY_HPP
+#define NTA_THREAD_AFFINITY_HPP
+
+#include <thread>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * Pinning of threads to cores.
+ *
+ * A core set is a list of the core numbers of the OS.  The empty set means
+ * all the cores, no pinning.  Supported on Linux and Windows (the first 64
+ * cores); elsewhere the setters return false and the threads stay where the
+ * OS puts them.
+ */
+class ThreadAffinity {
+public:
+  static bool isSupported();
+
+  /**
+   * Pin the calling thread to the cores.
+   * @retval true if the affinity was changed.
+   */
+  static bool set(const std::vector<UInt> &cores);
+
+  /**
+   * Pin a thread to the cores.
+   * @retval true if the affinity was changed.
+   */
+  static bool set(std::thread &thread, const std::vector<UInt> &cores);
+
+  /**
+   * @returns the sorted cores the calling thread may run on, empty if unknown.
+   */
+  static std::vector<UInt> get();
+
+  /**
+   * @returns the sorted cores of the NUMA node, empty if unknown.
+   */
+  static std::vector<UInt> numaNodeCores(UInt node);
+
+  /**
+   * Sort and remove the duplicates of a core set.
+   */
+  static std::vector<UInt> normalize(std::vector<UInt> cores);
+};
+
+/**
+ * Pins the calling thread to the cores for the lifetime of the object and
+ * then restores its affinity.  Does nothing for the empty set, or if the
+ * thread is already pinned to these cores.  The cores must be normalized.
+ */
+class ScopedAffinity {
+public:
+  explicit ScopedAffinity(const std::vector<UInt> &cores);
+  ~ScopedAffinity();
+
+  ScopedAffinity(const ScopedAffinity &) = delete;
+  ScopedAffinity &operator=(const ScopedAffinity &) = delete;
+
+private:
+  std::vector<UInt> previous_;
+  bool pinned_ = false;
+};
+
+} // namespace htm
+
+#endif // NTA_THREAD_AFFINITY_HPP
@@ -0,0 +1,52 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * TscTimer implementation
+ */
+
+#include <thread>
+
+#include <htm/os/TscTimer.hpp>
+
+namespace htm {
+
+Real64 TscTimer::ticksPerSecond() {
+#if defined(NTA_TSC_RDTSC)
+  static const Real64 rate = []() {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    const UInt64 startTicks = ticks();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    const UInt64 endTicks = ticks();
+    const Real64 seconds = std::chrono::duration<Real64>(Clock::now() - start).count();
+    return static_cast<Real64>(endTicks - startTicks) / seconds;
+  }();
+  return rate;
+#elif defined(NTA_TSC_CNTVCT)
+  static const Real64 rate = []() {
+    UInt64 frequency;
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+    return static_cast<Real64>(frequency);
+  }();
+  return rate;
+#else
+  return 1.0e9;
+#endif
+}
+
+} // namespace htm
@@ -0,0 +1,128 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * TscTimer interface
+ */
+
+#ifndef NTA_TSC_TIMER_HPP
+#define NTA_TSC_TIMER_HPP
+
+#include <chrono>
+
+#include <htm/types/Types.hpp>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  #include <intrin.h>
+  #define NTA_TSC_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+  #include <x86intrin.h>
+  #define NTA_TSC_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+  #define NTA_TSC_CNTVCT
+#endif
+
+namespace htm {
+
+/**
+ * A stopwatch on the cycle counter of the CPU, for regions of a few
+ * nanoseconds up to seconds.
+ *
+ * Reads the time stamp counter (rdtsc) on x86 and the virtual counter
+ * (cntvct_el0) on ARM64, which cost a few cycles, against the tens of
+ * nanoseconds of a std::chrono clock.  The counters of current CPUs run at
+ * a constant rate; the rate of the TSC is calibrated once against the
+ * steady_clock (10 ms, on the first call of ticksPerSecond()), the rate of
+ * cntvct is read from the CPU.  Elsewhere the ticks are the nanoseconds of
+ * the steady_clock.
+ *
+ * The counters are not serializing: the CPU may reorder a few instructions
+ * around ticks(), which is below the resolution of interest.  Ticks of
+ * different cores are comparable on current CPUs, but a thread which
+ * migrates between sockets may see small jumps.
+ *
+ * Same interface as Timer.
+ */
+class TscTimer {
+public:
+  explicit TscTimer(bool startme = false) { if (startme) start(); }
+
+  void start() {
+    if (not started_) {
+      start_ = ticks();
+      nstarts_++;
+      started_ = true;
+    }
+  }
+
+  void stop() {
+    if (started_) {
+      elapsed_ += ticks() - start_;
+      started_ = false;
+    }
+  }
+
+  /**
+   * @returns the total elapsed time in seconds, including the current run
+   * if started.
+   */
+  Real64 getElapsed() const
+    { return static_cast<Real64>(getElapsedTicks()) / ticksPerSecond(); }
+
+  UInt64 getElapsedTicks() const
+    { return elapsed_ + (started_ ? ticks() - start_ : 0u); }
+
+  void reset() {
+    elapsed_ = 0u;
+    nstarts_ = 0u;
+    started_ = false;
+  }
+
+  UInt64 getStartCount() const { return nstarts_; }
+  bool isStarted() const { return started_; }
+
+  /**
+   * @returns the counter of the CPU.
+   */
+  static inline UInt64 ticks() {
+#if defined(NTA_TSC_RDTSC)
+    return static_cast<UInt64>(__rdtsc());
+#elif defined(NTA_TSC_CNTVCT)
+    UInt64 value;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return static_cast<UInt64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+  }
+
+  /**
+   * @returns the rate of ticks().
+   */
+  static Real64 ticksPerSecond();
+
+private:
+  UInt64 start_ = 0u;
+  UInt64 elapsed_ = 0u;
+  UInt64 nstarts_ = 0u;
+  bool started_ = false;
+};
+
+} // namespace htm
+
+#endif // NTA_TSC_TIMER_HPP
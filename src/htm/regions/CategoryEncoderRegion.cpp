@@ -0,0 +1,159 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the CategoryEncoderRegion Region
+ */
+
+#include <htm/regions/CategoryEncoderRegion.hpp>
+
+#include <htm/engine/Input.hpp>
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+
+/* static */ Spec *CategoryEncoderRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "CategoryEncoderRegion",
+      parameters: {
+          size:           {type: UInt32, default: "0"},
+          activeBits:     {type: UInt32, default: "0"},
+          sparsity:       {type: Real32, default: "0.0"},
+          seed:           {type: UInt32, default: "0"},
+          sensedValue:    {description: "The category to encode, an unsigned integer. Overriden by sensedCategory and input 'values'.",
+                           type: Real64, default: "0.0", access: ReadWrite },
+          sensedCategory: {description: "The category to encode, a string. Ignored if empty. Overriden by input 'values'.",
+                           type: String, default: "", access: ReadWrite }},
+      inputs: {
+          values:         {description: "The category to encode, an unsigned integer. Overrides sensedValue & sensedCategory.",
+                           type: Real64, count: 0, isDefaultInput: yes, isRegionLevel: yes}},
+      outputs: {
+          bucket:         {description: "The encoded category. Becomes the title for this sample in Classifier.",
+                           type: Real64, count: 1, isDefaultOutput: false, isRegionLevel: false },
+          encoded:        {description: "Encoded bits.",
+                           type: SDR,    count: 0, isDefaultOutput: yes, isRegionLevel: yes }}
+  } )");
+
+  return ns;
+}
+
+
+CategoryEncoderRegion::CategoryEncoderRegion(const ValueMap &par, Region *region) : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+
+  CategoryEncoder_Parameters args;
+  args.size =       params.getScalarT<UInt32>("size");
+  args.activeBits = params.getScalarT<UInt32>("activeBits");
+  args.sparsity =   params.getScalarT<Real32>("sparsity");
+  args.seed =       params.getScalarT<UInt32>("seed");
+  encoder_.initialize(args);
+
+  sensedValue_ = params.getScalarT<Real64>("sensedValue");
+  sensedCategory_ = params.getString("sensedCategory", "");
+}
+
+CategoryEncoderRegion::CategoryEncoderRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+}
+CategoryEncoderRegion::~CategoryEncoderRegion() {}
+
+void CategoryEncoderRegion::initialize() { }
+
+Dimensions CategoryEncoderRegion::askImplForOutputDimensions(const std::string &name) {
+  if (name == "encoded")
+    return Dimensions(encoder_.dimensions);
+  if (name == "bucket")
+    return Dimensions(1u);
+  return RegionImpl::askImplForOutputDimensions(name);
+}
+
+void CategoryEncoderRegion::compute() {
+  UInt64 category;
+  if (hasInput("values")) {
+    const Array &a = getInput("values")->getData();
+    sensedValue_ = ((const Real64 *)(a.getBuffer()))[0];
+    category = static_cast<UInt64>(sensedValue_);
+    NTA_CHECK(sensedValue_ >= 0.0 && sensedValue_ == static_cast<Real64>(category))
+        << "CategoryEncoderRegion: the category must be an unsigned integer, found " << sensedValue_;
+  } else if (!sensedCategory_.empty()) {
+    category = CategoryEncoder::categoryOf(sensedCategory_);
+  } else {
+    category = static_cast<UInt64>(sensedValue_);
+    NTA_CHECK(sensedValue_ >= 0.0 && sensedValue_ == static_cast<Real64>(category))
+        << "CategoryEncoderRegion: the category must be an unsigned integer, found " << sensedValue_;
+  }
+
+  SDR &output = getOutput("encoded")->getData().getSDR();
+  encoder_.encode(category, output);
+
+  Real64 *buf = (Real64 *)getOutput("bucket")->getData().getBuffer();
+  buf[0] = static_cast<Real64>(category);
+}
+
+
+void CategoryEncoderRegion::setParameterReal64(const std::string &name, Int64 index, Real64 value) {
+  if (name == "sensedValue")  sensedValue_ = value;
+  else  RegionImpl::setParameterReal64(name, index, value);
+}
+
+void CategoryEncoderRegion::setParameterString(const std::string &name, Int64 index, const std::string &value) {
+  if (name == "sensedCategory")  sensedCategory_ = value;
+  else  RegionImpl::setParameterString(name, index, value);
+}
+
+Real64 CategoryEncoderRegion::getParameterReal64(const std::string &name, Int64 index) {
+  if (name == "sensedValue") return sensedValue_;
+  else return RegionImpl::getParameterReal64(name, index);
+}
+
+Real32 CategoryEncoderRegion::getParameterReal32(const std::string &name, Int64 index) {
+  if (name == "sparsity") return encoder_.parameters.sparsity;
+  else return RegionImpl::getParameterReal32(name, index);
+}
+
+UInt32 CategoryEncoderRegion::getParameterUInt32(const std::string &name, Int64 index) {
+  if (name == "size")            return encoder_.parameters.size;
+  else if (name == "activeBits") return encoder_.parameters.activeBits;
+  else if (name == "seed")       return encoder_.parameters.seed;
+  else return RegionImpl::getParameterUInt32(name, index);
+}
+
+std::string CategoryEncoderRegion::getParameterString(const std::string &name, Int64 index) {
+  if (name == "sensedCategory") return sensedCategory_;
+  else return RegionImpl::getParameterString(name, index);
+}
+
+bool CategoryEncoderRegion::operator==(const RegionImpl &other) const {
+  if (other.getType() != "CategoryEncoderRegion") return false;
+  const CategoryEncoderRegion &o = reinterpret_cast<const CategoryEncoderRegion&>(other);
+  return encoder_.parameters.size       == o.encoder_.parameters.size &&
+         encoder_.parameters.activeBits == o.encoder_.parameters.activeBits &&
+         encoder_.parameters.seed       == o.encoder_.parameters.seed &&
+         sensedValue_    == o.sensedValue_ &&
+         sensedCategory_ == o.sensedCategory_;
+}
+
+
+} // namespace htm
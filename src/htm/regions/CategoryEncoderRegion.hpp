@@ -0,0 +1,93 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines CategoryEncoderRegion, a Region implementation for the CategoryEncoder.
+ */
+
+#ifndef NTA_CATEGORYENCODERREGION_HPP
+#define NTA_CATEGORYENCODERREGION_HPP
+
+#include <string>
+#include <vector>
+
+#include <htm/encoders/CategoryEncoder.hpp>
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+/**
+ * A network region that encapsulates the CategoryEncoder.
+ *
+ * @b Description
+ * On each compute the region encodes the first value of the "values" input if
+ * it is linked, else the "sensedCategory" parameter if it is not empty, else
+ * the "sensedValue" parameter.  Numeric categories must be unsigned integers.
+ * The "bucket" output holds the encoded category, the title for a Classifier.
+ */
+class CategoryEncoderRegion : public RegionImpl, Serializable {
+public:
+  CategoryEncoderRegion(const ValueMap &params, Region *region);
+  CategoryEncoderRegion(ArWrapper &wrapper, Region *region);
+
+  virtual ~CategoryEncoderRegion() override;
+
+  static Spec *createSpec();
+
+  virtual Real64 getParameterReal64(const std::string &name, Int64 index = -1) override;
+  virtual Real32 getParameterReal32(const std::string &name, Int64 index = -1) override;
+  virtual UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) override;
+  virtual std::string getParameterString(const std::string &name, Int64 index = -1) override;
+  virtual void setParameterReal64(const std::string &name, Int64 index, Real64 value) override;
+  virtual void setParameterString(const std::string &name, Int64 index, const std::string &value) override;
+  virtual void initialize() override;
+
+  void compute() override;
+
+  virtual Dimensions askImplForOutputDimensions(const std::string &name) override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(CEREAL_NVP(sensedValue_));
+    ar(CEREAL_NVP(sensedCategory_));
+    ar(cereal::make_nvp("encoder", encoder_));
+  }
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(CEREAL_NVP(sensedValue_));
+    ar(CEREAL_NVP(sensedCategory_));
+    ar(cereal::make_nvp("encoder", encoder_));
+    setDimensions(Dimensions(encoder_.dimensions));
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const CategoryEncoderRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  Real64 sensedValue_;
+  std::string sensedCategory_;
+  CategoryEncoder encoder_;
+};
+} // namespace htm
+
+#endif // NTA_CATEGORYENCODERREGION_HPP
@@ -137,13 +137,19 @@ Dimensions ClassifierRegion::askImplForOutputDimensions(const std::string &name)
 
 
 
+size_t ClassifierRegion::memoryUsage() const {
+  return (classifier_ ? classifier_->memoryUsage() : 0u) + bucketList.capacity() * sizeof(Real64) +
+         bucketListMap.size() * (sizeof(std::pair<Real64, UInt32>) + 4u * sizeof(void*));
+}
+
+
 void ClassifierRegion::compute() {
-  SDR &pattern = getInput("pattern")->getData().getSDR();
+  SDR &pattern = pattern_->getData().getSDR();
   // Note: if there is no link to 'pattern' input, the 'pattern' SDR length is 0
   //       and SDRClassifier::infer() will throw an exception.
 
   if (learn_) {
-    Array &b = getInput("bucket")->getData();
+    Array &b = bucket_->getData();
     // 'bucket' is a list of quantized samples being processed for this iteration.
     // There are one of these for each encoder (or value being encoded).
     // The values might not be consecutive, or in different ranges, or different things entirely.
@@ -171,17 +177,17 @@ void ClassifierRegion::compute() {
   PDF pdf = classifier_->infer(pattern);
 
   // Adjust the buffer size to match the pdf.
-  if (getOutput("pdf")->getData().getCount() < pdf.size()) {
+  if (pdf_->getData().getCount() < pdf.size()) {
     UInt size = static_cast<UInt>(pdf.size());
-    getOutput("pdf")->resize(size);
-    getOutput("titles")->resize(size);
+    pdf_->resize(size);
+    titles_->resize(size);
   }
 
   // Populate the outputs. pdf and titles output arrays will be sorted by the title.
   // The predicted output is an index into those sorted arrays.
-  Real64 *out = reinterpret_cast<Real64 *>(getOutput("pdf")->getData().getBuffer());
-  Real64 *titles = reinterpret_cast<Real64 *>(getOutput("titles")->getData().getBuffer());
-  UInt32 *predicted = reinterpret_cast<UInt32 *>(getOutput("predicted")->getData().getBuffer());
+  Real64 *out = reinterpret_cast<Real64 *>(pdf_->getData().getBuffer());
+  Real64 *titles = reinterpret_cast<Real64 *>(titles_->getData().getBuffer());
+  UInt32 *predicted = reinterpret_cast<UInt32 *>(predicted_->getData().getBuffer());
   Real64 m = 0.0;
   size_t j = 0;
   predicted[0] = 0;
@@ -197,6 +203,14 @@ void ClassifierRegion::compute() {
   }
 }
 
+void ClassifierRegion::bindPorts() {
+  pattern_ = bindInput("pattern");
+  bucket_ = bindInput("bucket");
+  pdf_ = bindOutput("pdf");
+  titles_ = bindOutput("titles");
+  predicted_ = bindOutput("predicted");
+}
+
 
 void ClassifierRegion::setParameterBool(const std::string &name, Int64 index, bool val) {
   if (name == "learn")
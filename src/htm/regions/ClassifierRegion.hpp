@@ -60,6 +60,9 @@ public:
   virtual void initialize() override;
 
   void compute() override;
+  void bindPorts() override;
+
+  size_t memoryUsage() const override;
 
   virtual Dimensions askImplForOutputDimensions(const std::string &name) override;
 
@@ -96,6 +99,13 @@ private:
 
   std::map<Real64, UInt32> bucketListMap;  //  Map containing titles or buckets ordered by quantized values.
   std::vector<Real64> bucketList;          //  Vector of titles ordered by order in which they were first seen to match Classifier.
+
+  // The ports of compute(), @see bindPorts().
+  Input *pattern_ = nullptr;
+  Input *bucket_ = nullptr;
+  Output *pdf_ = nullptr;
+  Output *titles_ = nullptr;
+  Output *predicted_ = nullptr;
 };
 } // namespace htm
 
@@ -0,0 +1,236 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the columnar input files.
+ */
+
+#include <cstring> // memcpy
+
+#include <htm/regions/ColumnarFile.hpp>
+#include <htm/utils/FlatArchive.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+static const char   COLUMNAR_TAG[] = "HTMCOLMN";
+static const UInt32 COLUMNAR_VERSION = 1u;
+static const size_t MAX_CATEGORIES = 65536u;
+
+static size_t typeSize(const ColumnType type) {
+  switch (type) {
+  case ColumnType::REAL32:   return sizeof(Real32);
+  case ColumnType::INT32:    return sizeof(Int32);
+  case ColumnType::UINT8:    return sizeof(UInt8);
+  case ColumnType::UINT16:   return sizeof(UInt16);
+  case ColumnType::CATEGORY: return sizeof(UInt16);
+  }
+  NTA_THROW << "ColumnarFile: unknown column type " << static_cast<UInt>(type);
+}
+
+template <typename T> static void appendValue(std::vector<char> &buffer, const Real value) {
+  const T v = static_cast<T>(value);
+  const char *bytes = reinterpret_cast<const char *>(&v);
+  buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+template <typename T>
+static void writeColumn(FlatWriter &out, const std::vector<char> &buffer) {
+  out.array(reinterpret_cast<const T *>(buffer.data()), buffer.size() / sizeof(T));
+}
+
+template <typename T>
+static const void *viewColumn(FlatReader &in, const UInt64 rows, const std::string &path) {
+  size_t count;
+  const T *data = in.view<T>(count);
+  NTA_CHECK(count == rows) << "ColumnarFile: corrupt row group in " << path;
+  return data;
+}
+
+template <typename T> static Real valueAt(const void *column, const UInt64 row) {
+  return static_cast<Real>(static_cast<const T *>(column)[row]);
+}
+
+
+ColumnarWriter::ColumnarWriter(const std::string &path,
+                               const std::vector<ColumnSpec> &columns,
+                               const UInt64 rowGroupSize)
+  : columns_(columns), rowGroupSize_(rowGroupSize), buffers_(columns.size()) {
+  NTA_CHECK(!columns.empty()) << "ColumnarWriter: no columns";
+  NTA_CHECK(rowGroupSize > 0u) << "ColumnarWriter: the row group size must be > 0";
+  for (const auto &column : columns_) {
+    typeSize(column.type); // validates the type
+    NTA_CHECK(column.type == ColumnType::CATEGORY or column.categories.empty())
+        << "ColumnarWriter: column " << column.name << " is not a CATEGORY column";
+    NTA_CHECK(column.categories.size() <= MAX_CATEGORIES)
+        << "ColumnarWriter: column " << column.name << " has more than " << MAX_CATEGORIES
+        << " categories";
+  }
+
+  out_.reset(new FlatWriter(path, COLUMNAR_TAG, COLUMNAR_VERSION));
+  out_->scalar(static_cast<UInt32>(columns_.size()));
+  for (const auto &column : columns_) {
+    out_->string(column.name);
+    out_->scalar(static_cast<UInt8>(column.type));
+    if (column.type == ColumnType::CATEGORY) {
+      out_->scalar(static_cast<UInt32>(column.categories.size()));
+      for (const auto &category : column.categories)
+        out_->string(category);
+    }
+  }
+  out_->scalar(rowGroupSize_);
+}
+
+ColumnarWriter::~ColumnarWriter() {}
+
+Real ColumnarWriter::code(const size_t column, const std::string &category) const {
+  NTA_CHECK(column < columns_.size()) << "ColumnarWriter: no column " << column;
+  const auto &categories = columns_[column].categories;
+  for (size_t i = 0u; i < categories.size(); i++) {
+    if (categories[i] == category)
+      return static_cast<Real>(i);
+  }
+  NTA_THROW << "ColumnarWriter: column " << columns_[column].name << " has no category '"
+            << category << "'";
+}
+
+void ColumnarWriter::appendRow(const Real *values) {
+  NTA_CHECK(out_ != nullptr) << "ColumnarWriter: the file is closed";
+  for (size_t c = 0u; c < columns_.size(); c++) {
+    auto &buffer = buffers_[c];
+    switch (columns_[c].type) {
+    case ColumnType::REAL32:   appendValue<Real32>(buffer, values[c]); break;
+    case ColumnType::INT32:    appendValue<Int32>(buffer, values[c]); break;
+    case ColumnType::UINT8:    appendValue<UInt8>(buffer, values[c]); break;
+    case ColumnType::UINT16:   appendValue<UInt16>(buffer, values[c]); break;
+    case ColumnType::CATEGORY:
+      NTA_CHECK(values[c] >= 0.0f and values[c] < static_cast<Real>(columns_[c].categories.size()))
+          << "ColumnarWriter: " << values[c] << " is not a category code of column "
+          << columns_[c].name;
+      appendValue<UInt16>(buffer, values[c]);
+      break;
+    }
+  }
+  if (++rows_ == rowGroupSize_)
+    flush_();
+}
+
+void ColumnarWriter::flush_() {
+  if (rows_ == 0u)
+    return;
+  out_->scalar(static_cast<UInt8>(1u));
+  out_->scalar(rows_);
+  for (size_t c = 0u; c < columns_.size(); c++) {
+    switch (columns_[c].type) {
+    case ColumnType::REAL32:   writeColumn<Real32>(*out_, buffers_[c]); break;
+    case ColumnType::INT32:    writeColumn<Int32>(*out_, buffers_[c]); break;
+    case ColumnType::UINT8:    writeColumn<UInt8>(*out_, buffers_[c]); break;
+    case ColumnType::UINT16:
+    case ColumnType::CATEGORY: writeColumn<UInt16>(*out_, buffers_[c]); break;
+    }
+    buffers_[c].clear();
+  }
+  rows_ = 0u;
+}
+
+void ColumnarWriter::close() {
+  NTA_CHECK(out_ != nullptr) << "ColumnarWriter: the file is closed";
+  flush_();
+  out_->scalar(static_cast<UInt8>(0u));
+  out_->close();
+  out_.reset();
+}
+
+
+ColumnarFile::ColumnarFile(const std::string &path)
+  : path_(path), in_(new FlatReader(path, COLUMNAR_TAG, COLUMNAR_VERSION)) {
+  FlatReader &in = *in_;
+  const auto numColumns = in.scalar<UInt32>();
+  NTA_CHECK(numColumns > 0u) << "ColumnarFile: " << path << " has no columns";
+  columns_.resize(numColumns);
+  for (auto &column : columns_) {
+    column.name = in.string();
+    column.type = static_cast<ColumnType>(in.scalar<UInt8>());
+    typeSize(column.type); // validates the type
+    if (column.type == ColumnType::CATEGORY) {
+      const auto numCategories = in.scalar<UInt32>();
+      NTA_CHECK(numCategories <= MAX_CATEGORIES) << "ColumnarFile: corrupt file " << path;
+      column.categories.resize(numCategories);
+      for (auto &category : column.categories)
+        category = in.string();
+    }
+  }
+  rowGroupSize_ = in.scalar<UInt64>();
+  NTA_CHECK(rowGroupSize_ > 0u) << "ColumnarFile: corrupt file " << path;
+
+  // Collect the columns of each row group, in place in the mapped file.
+  while (in.scalar<UInt8>() != 0u) {
+    NTA_CHECK(groups_.empty() or groups_.back().rows == rowGroupSize_)
+        << "ColumnarFile: corrupt file " << path << ", only the last row group may be partial";
+    RowGroup group;
+    group.rows = in.scalar<UInt64>();
+    NTA_CHECK(group.rows > 0u and group.rows <= rowGroupSize_) << "ColumnarFile: corrupt file " << path;
+    for (const auto &column : columns_) {
+      switch (column.type) {
+      case ColumnType::REAL32:
+        group.columns.push_back(viewColumn<Real32>(in, group.rows, path));
+        break;
+      case ColumnType::INT32:
+        group.columns.push_back(viewColumn<Int32>(in, group.rows, path));
+        break;
+      case ColumnType::UINT8:
+        group.columns.push_back(viewColumn<UInt8>(in, group.rows, path));
+        break;
+      case ColumnType::UINT16:
+      case ColumnType::CATEGORY:
+        group.columns.push_back(viewColumn<UInt16>(in, group.rows, path));
+        break;
+      }
+    }
+    numRows_ += group.rows;
+    groups_.push_back(std::move(group));
+  }
+}
+
+ColumnarFile::~ColumnarFile() {}
+
+const void *ColumnarFile::columnData(const size_t group, const size_t column) const {
+  NTA_CHECK(group < groups_.size() and column < columns_.size())
+      << "ColumnarFile: no column " << column << " in row group " << group;
+  return groups_[group].columns[column];
+}
+
+void ColumnarFile::readRow(const UInt64 row, Real *out, const size_t offset, const size_t count) const {
+  NTA_CHECK(row < numRows_) << "ColumnarFile: no row " << row << " in " << path_;
+  NTA_CHECK(offset + count <= columns_.size())
+      << "ColumnarFile: columns " << offset << "+" << count << " out of range, " << path_
+      << " has " << columns_.size() << " columns";
+  const RowGroup &group = groups_[static_cast<size_t>(row / rowGroupSize_)];
+  const UInt64 r = row % rowGroupSize_;
+  for (size_t i = 0u; i < count; i++) {
+    const size_t c = offset + i;
+    switch (columns_[c].type) {
+    case ColumnType::REAL32:   out[i] = valueAt<Real32>(group.columns[c], r); break;
+    case ColumnType::INT32:    out[i] = valueAt<Int32>(group.columns[c], r); break;
+    case ColumnType::UINT8:    out[i] = valueAt<UInt8>(group.columns[c], r); break;
+    case ColumnType::UINT16:
+    case ColumnType::CATEGORY: out[i] = valueAt<UInt16>(group.columns[c], r); break;
+    }
+  }
+}
+
+} // namespace htm
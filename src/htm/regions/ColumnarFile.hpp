@@ -0,0 +1,146 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Binary columnar input files for the FileInputRegion.
+ */
+
+#ifndef NTA_COLUMNAR_FILE_HPP
+#define NTA_COLUMNAR_FILE_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+class FlatReader;
+class FlatWriter;
+
+enum class ColumnType : UInt8 {
+  REAL32 = 0,
+  INT32 = 1,
+  UINT8 = 2,
+  UINT16 = 3,
+  CATEGORY = 4 // UInt16 codes into the dictionary of the column
+};
+
+struct ColumnSpec {
+  std::string name;
+  ColumnType type = ColumnType::REAL32;
+  std::vector<std::string> categories; // the dictionary of a CATEGORY column
+
+  ColumnSpec() {}
+  ColumnSpec(const std::string &name, ColumnType type,
+             const std::vector<std::string> &categories = {})
+    : name(name), type(type), categories(categories) {}
+};
+
+/**
+ * Layout of a columnar file, a flat archive (@see FlatArchive.hpp):
+ *   header: "HTMCOLMN", version, UInt32 number of columns,
+ *           per column: name, UInt8 type, for CATEGORY columns the
+ *           UInt32 number of categories and the categories,
+ *           UInt64 rows per row group
+ *   row groups: UInt8 1, UInt64 rows, one array of the rows per column
+ *   end: UInt8 0
+ *
+ * Every row group but the last has the full number of rows, so a row is
+ * found without an index.  The columns are stored in their own types, a
+ * UInt8 column takes a quarter of the space of the text or float32 formats.
+ */
+class ColumnarWriter {
+public:
+  ColumnarWriter(const std::string &path, const std::vector<ColumnSpec> &columns,
+                 UInt64 rowGroupSize = 65536u);
+  ~ColumnarWriter();
+
+  /**
+   * Append a row of numColumns values.  The value of a CATEGORY column is
+   * its code, @see code().
+   */
+  void appendRow(const Real *values);
+
+  /**
+   * @returns the code of the category in the dictionary of the column.
+   * Throws if the column does not have the category.
+   */
+  Real code(size_t column, const std::string &category) const;
+
+  /**
+   * Write the last row group and the end of the file.
+   */
+  void close();
+
+private:
+  void flush_();
+
+  std::unique_ptr<FlatWriter> out_;
+  std::vector<ColumnSpec> columns_;
+  UInt64 rowGroupSize_;
+  UInt64 rows_ = 0u; // in the current row group
+  std::vector<std::vector<char>> buffers_; // the current row group, per column
+};
+
+/**
+ * A columnar file, mapped into memory.  The columns of the row groups are
+ * read in place, rows are converted to Real on access.
+ */
+class ColumnarFile {
+public:
+  explicit ColumnarFile(const std::string &path);
+  ~ColumnarFile();
+
+  const std::string &path() const { return path_; }
+  UInt64 numRows() const { return numRows_; }
+  size_t numColumns() const { return columns_.size(); }
+  const ColumnSpec &column(size_t c) const { return columns_[c]; }
+  UInt64 rowGroupSize() const { return rowGroupSize_; }
+  size_t numRowGroups() const { return groups_.size(); }
+
+  /**
+   * The values of a column in a row group, in the type of the column.
+   * Valid while this file exists.
+   */
+  const void *columnData(size_t group, size_t column) const;
+  UInt64 groupRows(size_t group) const { return groups_[group].rows; }
+
+  /**
+   * Copy `count` columns of the row, starting at column `offset`, to out.
+   * CATEGORY columns give the code of the category.
+   */
+  void readRow(UInt64 row, Real *out, size_t offset, size_t count) const;
+
+private:
+  struct RowGroup {
+    UInt64 rows;
+    std::vector<const void *> columns;
+  };
+
+  std::string path_;
+  std::unique_ptr<FlatReader> in_;
+  std::vector<ColumnSpec> columns_;
+  UInt64 rowGroupSize_ = 0u;
+  UInt64 numRows_ = 0u;
+  std::vector<RowGroup> groups_;
+};
+
+} // namespace htm
+
+#endif // NTA_COLUMNAR_FILE_HPP
@@ -73,6 +73,14 @@ FileInputRegion::FileInputRegion(ArWrapper &wrapper, Region *region)
       resetOut_(NTA_BasicType_Real32), filename_(""), scalingMode_("none"),
       recentFile_("") {
   cereal_adapter_load(wrapper);
+  if (!streamFile_.empty()) {
+    // Continue the stream at the vector that was just output.
+    openStream();
+    if (curVector_ >= 0) {
+      stream_->seek(static_cast<UInt64>(curVector_));
+      streamVector_ = stream_->next();
+    }
+  }
 }
 
 
@@ -107,15 +115,23 @@ void FileInputRegion::compute() {
     return;
   }
 
-  NTA_CHECK(vectorFile_.vectorCount() > 0)
-      << "FileInputRegion::compute - no data vectors in memory."
-      << "Perhaps no data file has been loaded using the 'loadFile'"
-      << " execute command.";
-
-  if (iterations_ % repeatCount_ == 0) {
-    // Get index to next vector and copy scaled vector to our output
-    curVector_++;
-    curVector_ %= vectorFile_.vectorCount();
+  if (stream_) {
+    // The stream wraps at the end of the file by itself.
+    if (iterations_ % repeatCount_ == 0 || streamVector_ == nullptr) {
+      streamVector_ = stream_->next();
+      curVector_ = static_cast<int>(stream_->position());
+    }
+  } else {
+    NTA_CHECK(vectorFile_.vectorCount() > 0)
+        << "FileInputRegion::compute - no data vectors in memory."
+        << "Perhaps no data file has been loaded using the 'loadFile'"
+        << " execute command.";
+
+    if (iterations_ % repeatCount_ == 0) {
+      // Get index to next vector and copy scaled vector to our output
+      curVector_++;
+      curVector_ %= vectorFile_.vectorCount();
+    }
   }
 
   Real *out = (Real *)dataOut_.getBuffer();
@@ -126,7 +142,10 @@ void FileInputRegion::compute() {
   if (hasCategoryOut_) {
     categoryOut_ = region_->getOutput("categoryOut")->getData();
     Real *categoryOut = reinterpret_cast<Real *>(categoryOut_.getBuffer());
-    vectorFile_.getRawVector((htm::UInt)curVector_, categoryOut, offset, 1);
+    if (stream_)
+      categoryOut[0] = streamVector_[offset];
+    else
+      vectorFile_.getRawVector((htm::UInt)curVector_, categoryOut, offset, 1);
     offset++;
 
     // trace facility
@@ -136,14 +155,20 @@ void FileInputRegion::compute() {
   if (hasResetOut_) {
     resetOut_ = region_->getOutput("resetOut")->getData();
     Real *resetOut = reinterpret_cast<Real *>(resetOut_.getBuffer());
-    vectorFile_.getRawVector((htm::UInt)curVector_, resetOut, offset, 1);
+    if (stream_)
+      resetOut[0] = streamVector_[offset];
+    else
+      vectorFile_.getRawVector((htm::UInt)curVector_, resetOut, offset, 1);
     offset++;
 
     // trace facility
     NTA_DEBUG << "compute " << *region_->getOutput("reset") << std::endl;
   }
 
-  vectorFile_.getScaledVector((htm::UInt)curVector_, out, offset, count);
+  if (stream_)
+    vectorFile_.applyScaling(streamVector_, out, offset, count);
+  else
+    vectorFile_.getScaledVector((htm::UInt)curVector_, out, offset, count);
 
   // trace facility
   NTA_DEBUG << "compute " << *region_->getOutput("dataOut") << std::endl;
@@ -163,6 +188,40 @@ inline const char *checkExtensions(const std::string &filename,
   return nullptr;
 }
 
+// The file format of a loadFile, appendFile or streamFile command, given as
+// the third argument or determined by the extension of the file.
+static UInt32 fileFormat(const std::vector<std::string> &args) {
+  const string &filename = args[1];
+  UInt32 labeled = 2; // Default format is 2
+
+  if (args.size() > 2) {
+    labeled = toUInt32(args[2]);
+  } else {
+    // Check for some common extensions.
+    const char *csvExtensions[] = {".csv", ".CSV", nullptr};
+    if (checkExtensions(filename, csvExtensions)) {
+      cout << "Reading CSV file" << endl;
+      labeled = 3; // CSV format.
+    }
+    const char *columnarExtensions[] = {".htmcol", nullptr};
+    if (checkExtensions(filename, columnarExtensions)) {
+      cout << "Reading columnar file" << endl;
+      labeled = 7; // Columnar format.
+    }
+  }
+
+  // Detect binary file format and set labeled flag to read little endian
+  // binary file
+  if (filename.substr(filename.size() - 3, 3) == "bin") {
+    cout << "Reading binary file" << endl;
+    labeled = 4;
+  }
+
+  if (labeled > (UInt32)VectorFile::maxFormat())
+    NTA_THROW << "FileInputRegion: unknown file format '" << labeled << "'";
+  return labeled;
+}
+
 //--------------------------------------------------------------------------------
 /// Execute a FileInputRegion specific command
 std::string FileInputRegion::executeCommand(const std::vector<std::string> &args, Int64 index)
@@ -174,40 +233,23 @@ std::string FileInputRegion::executeCommand(const std::vector<std::string> &args
   string command = args[0];
 
   // Process each command
-  if ((command == "loadFile") || (command == "appendFile")) {
+  if ((command == "loadFile") || (command == "appendFile") || (command == "shareFile")) {
     NTA_CHECK(argCount > 1)
         << "VectorFileSensor: no filename specified for " << command;
 
-    UInt32 labeled = 2; // Default format is 2
-
     // string filename = ReadStringFromBuffer(*buf2);
     string filename(args[1]);
     cout << "In FileInputRegion " << filename << endl;
+    UInt32 labeled = fileFormat(args);
 
-    if (argCount == 3) {
-      labeled = toUInt32(args[2]);
-    } else {
-      // Check for some common extensions.
-      const char *csvExtensions[] = {".csv", ".CSV", nullptr};
-      if (checkExtensions(filename, csvExtensions)) {
-        cout << "Reading CSV file" << endl;
-        labeled = 3; // CSV format.
-      }
-    }
-
-    // Detect binary file format and set labeled flag to read little endian
-    // binary file
-    if (filename.substr(filename.size() - 3, 3) == "bin") {
-      cout << "Reading binary file" << endl;
-      labeled = 4;
-    }
-
-    if (labeled > (UInt32)VectorFile::maxFormat())
-      NTA_THROW << "FileInputRegion: unknown file format '" << labeled << "'";
+    // The vectors in memory replace a stream.
+    stream_.reset();
+    streamVector_ = nullptr;
+    streamFile_.clear();
 
     // Read in new set of vectors
     // If the command is loadFile, we clear the list first and reset the
-    // position to the beginning
+    // position to the beginning.  shareFile replaces the list too.
     if (command == "loadFile")
       vectorFile_.clear(false);
 
@@ -225,7 +267,10 @@ std::string FileInputRegion::executeCommand(const std::vector<std::string> &args
     if (hasResetOut_)
       elementCount++;
 
-    vectorFile_.appendFile(filename, elementCount, labeled);
+    if (command == "shareFile")
+      vectorFile_.shareFile(filename, elementCount, labeled);
+    else
+      vectorFile_.appendFile(filename, elementCount, labeled);
     cout << "Read " << vectorFile_.vectorCount() << " vectors" << endl;
     // << "  in " << t.getValue() << " seconds" << endl;
 
@@ -233,13 +278,41 @@ std::string FileInputRegion::executeCommand(const std::vector<std::string> &args
     if (scalingMode_ == "standardForm")
       vectorFile_.setStandardScaling();
 
-    if (command == "loadFile")
+    if (command != "appendFile")
       seek(0);
 
 
     recentFile_ = filename;
   }
 
+  else if (command == "streamFile") {
+    NTA_CHECK(argCount > 1)
+        << "FileInputRegion: no filename specified for " << command;
+    NTA_CHECK(argCount <= 5) << "FileInputRegion: too many arguments";
+    NTA_CHECK(scalingMode_ != "standardForm")
+        << "FileInputRegion: standardForm scaling needs all vectors in memory,"
+        << " use loadFile or set the scaling vectors.";
+
+    streamFile_ = args[1];
+    streamFormat_ = fileFormat(args);
+    if (argCount > 3)
+      streamBlockRows_ = toUInt32(args[3]);
+    if (argCount > 4)
+      streamNumBlocks_ = toUInt32(args[4]);
+
+    vectorFile_.clear(false);
+    if (activeOutputCount_ == 0) {
+      // vector width not specified so use the region dimensions.
+      activeOutputCount_ = static_cast<UInt32>(dim_.getCount());
+    }
+    openStream();
+    vectorFile_.resetScaling(activeOutputCount_); // clear scaling
+
+    iterations_ = 0;
+    curVector_ = -1;
+    recentFile_ = streamFile_;
+  }
+
   else if (command == "dump") {
     std::string message;
     message = "FileInputRegion isLabeled = " + to_string(vectorFile_.isLabeled())
@@ -277,6 +350,7 @@ std::string FileInputRegion::executeCommand(const std::vector<std::string> &args
     }
 
     NTA_CHECK(argCount <= 5) << "FileInputRegion: too many arguments";
+    NTA_CHECK(!stream_) << "FileInputRegion: saveFile needs the vectors in memory, not a stream";
 
     std::ofstream f(filename.c_str());
     if (!hasEnd)
@@ -310,6 +384,17 @@ void FileInputRegion::seek(int n) {
   curVector_ %= vectorFile_.vectorCount();
 }
 
+void FileInputRegion::openStream() {
+  UInt32 elementCount = activeOutputCount_;
+  if (hasCategoryOut_)
+    elementCount++;
+  if (hasResetOut_)
+    elementCount++;
+  stream_.reset(new VectorStream(streamFile_, elementCount, streamFormat_,
+                                 streamBlockRows_, streamNumBlocks_));
+  streamVector_ = nullptr;
+}
+
 size_t FileInputRegion::getNodeOutputElementCount(const std::string &outputName) const {
   NTA_CHECK(outputName == "dataOut") << "Invalid output name: " << outputName;
   return activeOutputCount_;
@@ -355,6 +440,7 @@ Spec *FileInputRegion::createSpec() {
       "Any line containing too few elements or any text will be ignored. If "
       "there are\n"
       "more than N numbers on a line, the sensor retains only the first N.\n";
+  ns->async = true; // prefetch the next vector while the network computes
 
   ns->outputs.add("dataOut",
                   OutputSpec("Data read from file", NTA_BasicType_Real32,
@@ -502,7 +588,8 @@ Spec *FileInputRegion::createSpec() {
         " 0 - Reads in unlabeled file with first number = element count\n"
         " 1 - Reads in a labeled file with first number = element count (deprecated)\n"
         " 2 - Reads in unlabeled file without element count (default)\n"
-        " 3 - Reads in a csv file\n"));
+        " 3 - Reads in a csv file\n"
+        " 7 - Maps a binary columnar file (.htmcol)\n"));
 
   ns->commands.add( "appendFile",
       CommandSpec(
@@ -512,7 +599,27 @@ Spec *FileInputRegion::createSpec() {
         " 0 - Reads in unlabeled file with first number = element count\n"
         " 1 - Reads in a labeled file with first number = element count (deprecated)\n"
         " 2 - Reads in unlabeled file without element count (default)\n"
-        " 3 - Reads in a csv file\n"));
+        " 3 - Reads in a csv file\n"
+        " 7 - Maps a binary columnar file (.htmcol)\n"));
+
+  ns->commands.add( "shareFile",
+      CommandSpec(
+        "shareFile <filename> [file_format]\n"
+        "As loadFile, but the vectors are read once per process and shared\n"
+        "read-only with the other regions which share the same file; each\n"
+        "region keeps its own position and scaling. Nothing can be appended\n"
+        "to shared vectors. File formats are those of loadFile.\n"));
+
+  ns->commands.add( "streamFile",
+      CommandSpec(
+        "streamFile <filename> [file_format [block_rows [num_blocks]]]\n"
+        "Streams vectors from the specified file instead of loading it, for files\n"
+        "larger than memory. A background thread reads num_blocks blocks of\n"
+        "block_rows vectors ahead (default 4 blocks of 1024). Position is set to\n"
+        "zero. The standardForm scaling is not available. File formats are: \n"
+        " 2 - Reads in unlabeled file without element count (default)\n"
+        " 3 - Reads in a csv file\n"
+        " 4 - Reads in a little-endian float32 binary file (.bin)\n"));
 
   ns->commands.add( "saveFile",
        CommandSpec("saveFile filename [format [begin [end]]]\n"
@@ -548,6 +655,7 @@ UInt32 FileInputRegion::getParameterUInt32(const std::string &name, Int64 index)
 
 Int32 FileInputRegion::getParameterInt32(const std::string &name, Int64 index) {
   if (name == "position") {
+    if (stream_) return curVector_;
     if (vectorFile_.vectorCount() == 0) return -1;
     return curVector_;
   } else {
@@ -613,6 +721,14 @@ void FileInputRegion::setParameterUInt32(const std::string &name, Int64 index, U
 void FileInputRegion::setParameterInt32(const std::string &name, Int64 index, Int32 value) {
   const char *where = "setParameterInt32() FileInputRegion, parameter ";
   if (name == "position") {
+    if (stream_) {
+      NTA_CHECK(value >= 0) << where << "'position'. Requested position is negative.";
+      stream_->seek(static_cast<UInt64>(value));
+      streamVector_ = nullptr;
+      iterations_ = 0;
+      curVector_ = value - 1;
+      return;
+    }
     if (vectorFile_.vectorCount() == 0) return; // not yet initialized.
     NTA_CHECK(value >= 0 && value < static_cast<Int32>(vectorFile_.vectorCount()))
       << where << "'position'." << " Requested position is out of range. [ 0 to "
@@ -683,6 +799,7 @@ bool FileInputRegion::operator==(const RegionImpl &o) const {
   if (filename_ != other.filename_) return false;
   if (scalingMode_ != other.scalingMode_) return false;
   if (recentFile_ != other.recentFile_) return false;
+  if (streamFile_ != other.streamFile_) return false;
 
   return true;
 }
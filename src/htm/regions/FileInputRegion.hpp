@@ -27,11 +27,13 @@
 
 //----------------------------------------------------------------------
 
+#include <memory>
 #include <vector>
 
 #include <htm/engine/RegionImpl.hpp>
 #include <htm/ntypes/Array.hpp>
 #include <htm/regions/VectorFile.hpp>
+#include <htm/regions/VectorStream.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/ntypes/Value.hpp>
@@ -87,7 +89,10 @@ namespace htm {
  *
  *  Whitespace between numbers is ignored.
  *  The full list of vectors is read into memory when the loadFile command
- *  is executed.
+ *  is executed.  The streamFile command instead reads the file in blocks
+ *  ahead of compute(), with memory bounded by the size of the blocks.  The
+ *  shareFile command reads the file once per process, the regions which
+ *  replay the same file share its vectors, see VectorFile::shareFile().
  *
  */
 
@@ -302,6 +307,10 @@ public:
     ar(cereal::make_nvp("scalingMode_", scalingMode_));
     ar(cereal::make_nvp("recentFile_", recentFile_));
     ar(cereal::make_nvp("vectorFile", vectorFile_));
+    ar(cereal::make_nvp("streamFile_", streamFile_));
+    ar(cereal::make_nvp("streamFormat_", streamFormat_));
+    ar(cereal::make_nvp("streamBlockRows_", streamBlockRows_));
+    ar(cereal::make_nvp("streamNumBlocks_", streamNumBlocks_));
   }
 
   // FOR Cereal Deserialization
@@ -317,6 +326,10 @@ public:
     ar(cereal::make_nvp("scalingMode_", scalingMode_));
     ar(cereal::make_nvp("recentFile_", recentFile_));
     ar(cereal::make_nvp("vectorFile", vectorFile_));
+    ar(cereal::make_nvp("streamFile_", streamFile_));
+    ar(cereal::make_nvp("streamFormat_", streamFormat_));
+    ar(cereal::make_nvp("streamBlockRows_", streamBlockRows_));
+    ar(cereal::make_nvp("streamNumBlocks_", streamNumBlocks_));
   }	
 
 
@@ -332,6 +345,7 @@ public:
 private:
   void closeFile();
   void openFile(const std::string &filename);
+  void openStream();
 
 private:
   UInt32 repeatCount_; // Repeat count for output vectors
@@ -352,6 +366,14 @@ private:
   std::string scalingMode_;
   std::string recentFile_; // The most recently loaded or appended file
 
+  // The streamed file, if any, replaces the vectors in memory.
+  std::string streamFile_;
+  UInt32 streamFormat_ = 2;
+  UInt32 streamBlockRows_ = 1024;
+  UInt32 streamNumBlocks_ = 4;
+  std::unique_ptr<VectorStream> stream_;
+  const Real *streamVector_ = nullptr; // The vector that was just output
+
   //------------------- Utility routines and debugging support
 
   // Seek to the n'th vector in the list. n should be between 0 and
@@ -35,9 +35,20 @@
 
 namespace htm {
 
+// The encoding of an outputFormat, without the compression suffix.
+static std::string encoding(const std::string &format) {
+  const std::string suffix = "_lz";
+  if (format.size() > suffix.size() &&
+      format.compare(format.size() - suffix.size(), suffix.size(), suffix) == 0)
+    return format.substr(0, format.size() - suffix.size());
+  return format;
+}
+
 FileOutputRegion::FileOutputRegion(const ValueMap &params, Region* region)
     : RegionImpl(region), dataIn_(NTA_BasicType_Real32), filename_(""),
-      outFile_(nullptr) {
+      outputFormat_("text"), outFile_(nullptr) {
+  if (params.contains("outputFormat"))
+    setParameterString("outputFormat", -1, params.getString("outputFormat", "text"));
   if (params.contains("outputFile")) {
     std::string s = params.getString("outputFile", "");
     openFile(s);
@@ -48,12 +59,14 @@ FileOutputRegion::FileOutputRegion(const ValueMap &params, Region* region)
 
 FileOutputRegion::FileOutputRegion(ArWrapper& wrapper, Region* region)
     : RegionImpl(region), dataIn_(NTA_BasicType_Real32), filename_(""),
-      outFile_(nullptr) {
+      outputFormat_("text"), outFile_(nullptr) {
   cereal_adapter_load(wrapper);
 }
 
 
-FileOutputRegion::~FileOutputRegion() { closeFile(); }
+FileOutputRegion::~FileOutputRegion() {
+  outFile_.reset(); // the writer warns about errors, a destructor can not throw
+}
 
 void FileOutputRegion::initialize() {
   NTA_CHECK(region_ != nullptr);
@@ -83,49 +96,52 @@ void FileOutputRegion::compute() {
     return;
   }
 
-  // Ensure we can write to it
-  if (outFile_->fail()) {
-    NTA_THROW << "FileOutputRegion: There was an error writing to the file "
-              << filename_.c_str() << "\n";
-  }
-
-
+  // Write errors of the background thread are thrown by the writer.
   Real *inputVec = (Real *)(dataIn_.getBuffer());
   NTA_CHECK(inputVec != nullptr);
-  std::ofstream &outFile = *outFile_;
-  for (Size offset = 0; offset < dataIn_.getCount(); ++offset) {
-    if (offset == 0)
-      outFile << inputVec[offset];
-    else
-      outFile << "," << inputVec[offset];
+  const Size count = dataIn_.getCount();
+  const std::string enc = encoding(outputFormat_);
+  if (enc == "binary") {
+    outFile_->write(inputVec, count * sizeof(Real32));
+  } else if (enc == "sparse") {
+    sparse_.clear();
+    for (Size i = 0; i < count; ++i) {
+      if (inputVec[i] != 0.0f)
+        sparse_.push_back(static_cast<UInt32>(i));
+    }
+    const UInt32 n = static_cast<UInt32>(sparse_.size());
+    outFile_->write(&n, sizeof(n));
+    outFile_->write(sparse_.data(), sparse_.size() * sizeof(UInt32));
+  } else {
+    line_.str("");
+    for (Size offset = 0; offset < count; ++offset) {
+      if (offset == 0)
+        line_ << inputVec[offset];
+      else
+        line_ << "," << inputVec[offset];
+    }
+    line_ << "\n";
+    outFile_->write(line_.str());
   }
-  outFile << "\n";
 }
 
 void FileOutputRegion::closeFile() {
   if (outFile_) {
-    outFile_->close();
-    outFile_ = nullptr;
+    std::unique_ptr<BufferedWriter> file(std::move(outFile_));
     filename_ = "";
+    file->close();
   }
 }
 
 void FileOutputRegion::openFile(const std::string &filename) {
 
-  if (outFile_ && !outFile_->fail())
+  if (outFile_)
     closeFile();
   if (filename == "")
     return;
 
-  outFile_ = new std::ofstream(filename.c_str(), std::ios::app);
-  if (outFile_->fail())
-  {
-    delete outFile_;
-    outFile_ = nullptr;
-    NTA_THROW
-        << "FileOutputRegion::openFile -- unable to create or open file: "
-        << filename.c_str();
-  }
+  const bool compress = (encoding(outputFormat_) != outputFormat_);
+  outFile_.reset(new BufferedWriter(filename, true, compress));
   filename_ = filename;
 }
 
@@ -138,6 +154,13 @@ void FileOutputRegion::setParameterString(const std::string &paramName,
     if (outFile_)
       closeFile();
     openFile(s);
+  } else if (paramName == "outputFormat") {
+    const std::string enc = encoding(s);
+    NTA_CHECK(enc == "text" || enc == "binary" || enc == "sparse")
+        << "FileOutputRegion -- unknown outputFormat '" << s << "'";
+    NTA_CHECK(s == outputFormat_ || !outFile_)
+        << "FileOutputRegion -- close the file before changing the outputFormat";
+    outputFormat_ = s;
   } else {
     NTA_THROW << "FileOutputRegion -- Unknown string parameter " << paramName;
   }
@@ -147,6 +170,8 @@ std::string FileOutputRegion::getParameterString(const std::string &paramName,
                                                    Int64 index) {
   if (paramName == "outputFile") {
     return filename_;
+  } else if (paramName == "outputFormat") {
+    return outputFormat_;
   } else {
     NTA_THROW << "FileOutputRegion -- unknown parameter " << paramName;
   }
@@ -159,22 +184,22 @@ FileOutputRegion::executeCommand(const std::vector<std::string> &args,
   // Process the flushFile command
   if (args[0] == "flushFile") {
     // Ensure we have a valid file before flushing, otherwise fail silently.
-    if (!((outFile_ == nullptr) || (outFile_->fail()))) {
+    if (outFile_ != nullptr) {
       outFile_->flush();
     }
   } else if (args[0] == "closeFile") {
     closeFile();
   } else if (args[0] == "echo") {
     // Ensure we have a valid file before flushing, otherwise fail silently.
-    if ((outFile_ == nullptr) || (outFile_->fail())) {
+    if (outFile_ == nullptr) {
       NTA_THROW << "VectorFileEffector: echo command failed because there is "
                    "no file open";
     }
 
     for (size_t i = 1; i < args.size(); i++) {
-      *outFile_ << args[i];
+      outFile_->write(args[i]);
     }
-    *outFile_ << "\n";
+    outFile_->write("\n", 1);
   } else {
     NTA_THROW << "VectorFileEffector: Unknown execute '" << args[0] << "'";
   }
@@ -190,7 +215,8 @@ Spec *FileOutputRegion::createSpec() {
       "input vectors to a text file. The target filename is specified "
       "using the 'outputFile' parameter at run time. On each "
       "compute, the current input vector is written (but not flushed) "
-      "to the file.\n";
+      "to the file. The file is written in large blocks by a background "
+      "thread.\n";
 
   ns->inputs.add("dataIn",
               InputSpec("Data to be written to file",
@@ -215,6 +241,19 @@ Spec *FileOutputRegion::createSpec() {
                             "", // defaultValue
                             ParameterSpec::ReadWriteAccess));
 
+  ns->parameters.add("outputFormat",
+              ParameterSpec("The format of the output file: 'text' writes "
+                            "comma-separated lines, 'binary' the float32 "
+                            "elements of each vector, 'sparse' a UInt32 count and "
+                            "the UInt32 indices of the non-zero elements. The "
+                            "suffix '_lz' compresses the file in blocks. Set it "
+                            "before the outputFile.\n",
+                            NTA_BasicType_Byte,
+                            0,  // elementCount
+                            "", // constraints
+                            "text", // defaultValue
+                            ParameterSpec::ReadWriteAccess));
+
   ns->commands.add("flushFile", CommandSpec("Flush file data to disk"));
 
   ns->commands.add("closeFile",
@@ -235,6 +274,7 @@ bool FileOutputRegion::operator==(const RegionImpl &o) const {
   if (o.getType() != "FileOutputRegion") return false;
   FileOutputRegion& other = (FileOutputRegion&)o;
   if (filename_ != other.filename_) return false;
+  if (outputFormat_ != other.outputFormat_) return false;
 
   return true;
 }
@@ -27,11 +27,16 @@
 
 //----------------------------------------------------------------------
 
+#include <memory>
+#include <sstream>
+#include <vector>
+
 #include <htm/engine/RegionImpl.hpp>
 #include <htm/ntypes/Array.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
 #include <htm/ntypes/Value.hpp>
+#include <htm/utils/BufferedWriter.hpp>
 
 namespace htm {
 
@@ -41,15 +46,22 @@ namespace htm {
  *  writes them sequentially to a file.
  *
  *  The current input vector is written (but not flushed) to the file
- *  each time the effector's compute() method is called.
+ *  each time the effector's compute() method is called.  The writes are
+ *  buffered and written to the file by a background thread.
  *
- *  The file format for the file is a space-separated list of numbers, with
- *  one vector per line:
+ *  The default file format (outputFormat "text") is a comma-separated list
+ *  of numbers, with one vector per line:
  *
- *        e11 e12 e13 ... e1N
- *        e21 e22 e23 ... e2N
+ *        e11,e12,e13,...,e1N
+ *        e21,e22,e23,...,e2N
  *           :
- *        eM1 eM2 eM3 ... eMN
+ *        eM1,eM2,eM3,...,eMN
+ *
+ *  outputFormat "binary" writes the float32 elements of each vector, as
+ *  read by the FileInputRegion file format 4.  outputFormat "sparse" writes
+ *  each vector as a UInt32 count and the UInt32 indices of its non-zero
+ *  elements, for SDRs.  A suffix "_lz" compresses the file in blocks,
+ *  @see readCompressedFile().
  *
  *  VectorFileEffector implements the execute() commands as defined in the
  *  nodeSpec.
@@ -77,6 +89,7 @@ public:
   template<class Archive>
   void save_ar(Archive& ar) const {
     ar(cereal::make_nvp("outputFile", filename_));
+    ar(cereal::make_nvp("outputFormat", outputFormat_));
     ar(CEREAL_NVP(dim_));  // in base class
   }
 
@@ -84,6 +97,7 @@ public:
   template<class Archive>
   void load_ar(Archive& ar) {
     ar(cereal::make_nvp("outputFile", filename_));
+    ar(cereal::make_nvp("outputFormat", outputFormat_));
 		if (filename_ != "")
 		      openFile(filename_);
     ar(CEREAL_NVP(dim_));  // in base class
@@ -106,7 +120,10 @@ private:
 
     Array dataIn_;
     std::string filename_;          // Name of the output file
-    std::ofstream *outFile_;        // Handle to current file
+    std::string outputFormat_;      // text, binary or sparse, with optional _lz
+    std::unique_ptr<BufferedWriter> outFile_; // Handle to current file
+    std::ostringstream line_;       // a formatted text vector
+    std::vector<UInt32> sparse_;    // the indices of a sparse vector
 
   /// Disable unsupported default constructors
   FileOutputRegion(const FileOutputRegion &);
@@ -0,0 +1,327 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the HTMPipelineRegion Region
+ */
+
+#include <cmath>
+
+#include <htm/regions/HTMPipelineRegion.hpp>
+
+#include <htm/engine/Input.hpp>
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+
+/* static */ Spec *HTMPipelineRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "HTMPipelineRegion",
+      description: "RDSE encoder, Spatial Pooler and Temporal Memory computed as one region.",
+      parameters: {
+          size:        {description: "encoder: total number of bits", type: UInt32, default: "0"},
+          activeBits:  {description: "encoder: number of active bits", type: UInt32, default: "0"},
+          sparsity:    {description: "encoder: fraction of active bits, alternative to activeBits",
+                        type: Real32, default: "0.0"},
+          radius:      {description: "encoder: inputs this far apart have no overlap", type: Real32, default: "0.0"},
+          resolution:  {description: "encoder: alternative to radius", type: Real32, default: "0.0"},
+          category:    {description: "encoder: the inputs are enumerated categories", type: Bool, default: "false"},
+          columnCount: {description: "SP: number of columns", type: UInt32, default: "2048"},
+          potentialRadius: {description: "SP: 0 for the whole input", type: UInt32, default: "0"},
+          potentialPct:     {type: Real32, default: "0.5"},
+          globalInhibition: {type: Bool,   default: "true"},
+          localAreaDensity: {type: Real32, default: "0.05"},
+          stimulusThreshold:  {type: UInt32, default: "0"},
+          synPermInactiveDec: {type: Real32, default: "0.008"},
+          synPermActiveInc:   {type: Real32, default: "0.05"},
+          synPermConnected:   {type: Real32, default: "0.1"},
+          minPctOverlapDutyCycles: {type: Real32, default: "0.001"},
+          dutyCyclePeriod:  {type: UInt32, default: "1000"},
+          boostStrength:    {type: Real32, default: "0.0"},
+          cellsPerColumn:   {description: "TM: number of cells per column", type: UInt32, default: "32"},
+          activationThreshold: {type: UInt32, default: "13"},
+          initialPermanence:   {type: Real32, default: "0.21"},
+          connectedPermanence: {type: Real32, default: "0.5"},
+          minThreshold:        {type: UInt32, default: "10"},
+          maxNewSynapseCount:  {type: UInt32, default: "20"},
+          permanenceIncrement: {type: Real32, default: "0.1"},
+          permanenceDecrement: {type: Real32, default: "0.1"},
+          predictedSegmentDecrement: {type: Real32, default: "0.0"},
+          maxSegmentsPerCell:    {type: UInt32, default: "255"},
+          maxSynapsesPerSegment: {type: UInt32, default: "255"},
+          seed:        {description: "Seed of the encoder, SP and TM, -1 for random.",
+                        type: Int32, default: "1"},
+          learningMode: {description: "SP and TM learn if true",
+                        type: Bool, default: "true", access: ReadWrite },
+          anomaly:     {description: "The anomaly score of the last compute",
+                        type: Real32, default: "0.0", access: ReadOnly },
+          sensedValue: {description: "The value to encode. Overriden by input 'values'.",
+                        type: Real64, default: "0.0", access: ReadWrite }},
+      inputs: {
+          values:      {description: "Values to encode. Overrides sensedValue.",
+                        type: Real64, count: 1, isDefaultInput: yes},
+          resetIn:     {description: "A non-zero value resets the TM sequence.",
+                        type: Real32, count: 1}},
+      outputs: {
+          encoded:     {description: "Encoded bits, the input of the SP.", type: SDR, count: 0},
+          bucket:      {description: "Quantized sample based on the radius, for the Classifier.",
+                        type: Real64, count: 1},
+          columns:     {description: "Active columns of the SP, the input of the TM.", type: SDR, count: 0},
+          bottomUpOut: {description: "Active cells of the TM.",
+                        type: SDR, count: 0, isDefaultOutput: yes},
+          activeCells: {description: "Active cells of the TM.", type: SDR, count: 0},
+          predictedActiveCells: {description: "Winner cells of the TM.", type: SDR, count: 0},
+          predictiveCells: {description: "Cells predicted for the next compute.", type: SDR, count: 0},
+          anomaly:     {description: "The anomaly score of the TM.", type: Real32, count: 1}}
+  } )");
+
+  return ns;
+}
+
+
+HTMPipelineRegion::HTMPipelineRegion(const ValueMap &par, Region *region) : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  seed_ = params.getScalarT<Int32>("seed");
+  learningMode_ = params.getScalarT<bool>("learningMode");
+  sensedValue_ = params.getScalarT<Real64>("sensedValue");
+
+  RDSE_Parameters args;
+  args.size =       params.getScalarT<UInt32>("size");
+  args.activeBits = params.getScalarT<UInt32>("activeBits");
+  args.sparsity =   params.getScalarT<Real32>("sparsity");
+  args.radius =     params.getScalarT<Real32>("radius");
+  args.resolution = params.getScalarT<Real32>("resolution");
+  args.category =   params.getScalarT<bool>("category");
+  args.seed =       (seed_ < 0) ? 0u : static_cast<UInt>(seed_); // 0 is random for the RDSE
+  encoder_ = std::make_shared<RandomDistributedScalarEncoder>(args);
+
+  // The sizes of all stages are known from the parameters, so unlike the
+  // separate regions nothing waits for the links of initialize().
+  const std::vector<UInt> inputDimensions = encoder_->dimensions;
+  const std::vector<UInt> columnDimensions{params.getScalarT<UInt32>("columnCount")};
+  UInt potentialRadius = params.getScalarT<UInt32>("potentialRadius");
+  if (potentialRadius == 0u)
+    potentialRadius = static_cast<UInt>(encoder_->size);
+  sp_.reset(new SpatialPooler(
+      inputDimensions, columnDimensions, potentialRadius,
+      params.getScalarT<Real32>("potentialPct"), params.getScalarT<bool>("globalInhibition"),
+      params.getScalarT<Real32>("localAreaDensity"), 0u,
+      params.getScalarT<UInt32>("stimulusThreshold"), params.getScalarT<Real32>("synPermInactiveDec"),
+      params.getScalarT<Real32>("synPermActiveInc"), params.getScalarT<Real32>("synPermConnected"),
+      params.getScalarT<Real32>("minPctOverlapDutyCycles"), params.getScalarT<UInt32>("dutyCyclePeriod"),
+      params.getScalarT<Real32>("boostStrength"), seed_));
+
+  tm_.reset(new TemporalMemory(
+      columnDimensions, params.getScalarT<UInt32>("cellsPerColumn"),
+      params.getScalarT<UInt32>("activationThreshold"), params.getScalarT<Real32>("initialPermanence"),
+      params.getScalarT<Real32>("connectedPermanence"), params.getScalarT<UInt32>("minThreshold"),
+      params.getScalarT<UInt32>("maxNewSynapseCount"), params.getScalarT<Real32>("permanenceIncrement"),
+      params.getScalarT<Real32>("permanenceDecrement"),
+      params.getScalarT<Real32>("predictedSegmentDecrement"), seed_,
+      params.getScalarT<UInt32>("maxSegmentsPerCell"), params.getScalarT<UInt32>("maxSynapsesPerSegment")));
+}
+
+HTMPipelineRegion::HTMPipelineRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+}
+HTMPipelineRegion::~HTMPipelineRegion() {}
+
+void HTMPipelineRegion::initialize() { }
+
+Dimensions HTMPipelineRegion::askImplForOutputDimensions(const std::string &name) {
+  if (name == "encoded")
+    return Dimensions(encoder_->dimensions);
+  if (name == "columns")
+    return Dimensions(sp_->getColumnDimensions());
+  if (name == "bottomUpOut" || name == "activeCells" || name == "predictedActiveCells" ||
+      name == "predictiveCells") {
+    std::vector<UInt> cells = sp_->getColumnDimensions();
+    cells.push_back(static_cast<UInt>(tm_->getCellsPerColumn()));
+    return Dimensions(cells);
+  }
+  return RegionImpl::askImplForOutputDimensions(name);
+}
+
+std::vector<const Connections *> HTMPipelineRegion::getConnections() const {
+  return {&sp_->connections, &tm_->connections};
+}
+
+void HTMPipelineRegion::bindPorts() {
+  values_ = bindInput("values");
+  resetIn_ = bindInput("resetIn");
+  encoded_ = bindOutput("encoded");
+  bucket_ = bindOutput("bucket");
+  columns_ = bindOutput("columns");
+  bottomUpOut_ = bindOutput("bottomUpOut");
+  activeCells_ = bindOutput("activeCells");
+  predictedActiveCells_ = bindOutput("predictedActiveCells");
+  predictiveCells_ = bindOutput("predictiveCells");
+  anomaly_ = bindOutput("anomaly");
+}
+
+void HTMPipelineRegion::compute() {
+  if (values_->hasIncomingLinks())
+    sensedValue_ = reinterpret_cast<const Real64 *>(values_->getData().getBuffer())[0];
+  if (!std::isfinite(sensedValue_))
+    sensedValue_ = 0;  // prevents an exception in case of nan or inf
+
+  if (resetIn_->hasIncomingLinks()) {
+    const Array &reset = resetIn_->getData();
+    if (reset.getCount() == 1 && reinterpret_cast<const Real32 *>(reset.getBuffer())[0] != 0.0f)
+      tm_->reset();
+  }
+
+  // Each stage reads the output SDR which the previous stage computed into.
+  SDR &encoded = encoded_->getData().getSDR();
+  encoder_->encode(sensedValue_, encoded);
+  if (encoder_->parameters.radius != 0.0f) {
+    Real64 *buf = reinterpret_cast<Real64 *>(bucket_->getData().getBuffer());
+    buf[0] = sensedValue_ - std::fmod(sensedValue_, encoder_->parameters.radius);
+  }
+
+  SDR &columns = columns_->getData().getSDR();
+  sp_->compute(encoded, learningMode_, columns);
+
+  tm_->compute(columns, learningMode_);
+
+  // As in TMRegion, the cell outputs without links are produced on demand.
+  skipped_.clear();
+  produceOrSkip_(bottomUpOut_);
+  produceOrSkip_(activeCells_);
+  tm_->activateDendrites();
+  produceOrSkip_(predictedActiveCells_);
+  reinterpret_cast<Real32 *>(anomaly_->getData().getBuffer())[0] = tm_->anomaly;
+  produceOrSkip_(predictiveCells_);
+}
+
+void HTMPipelineRegion::produceOrSkip_(Output *out) {
+  if (out->hasOutgoingLinks())
+    produce_(out);
+  else
+    skipped_.push_back(out);
+}
+
+void HTMPipelineRegion::produceOutput(const std::string &name) {
+  for (auto it = skipped_.begin(); it != skipped_.end(); ++it) {
+    if ((*it)->getName() == name) {
+      Output *out = *it;
+      skipped_.erase(it);
+      produce_(out);
+      return;
+    }
+  }
+}
+
+void HTMPipelineRegion::produce_(Output *out) {
+  SDR &sdr = out->getData().getSDR();
+  if (out == bottomUpOut_ || out == activeCells_)
+    tm_->getActiveCells(sdr);
+  else if (out == predictedActiveCells_)
+    tm_->getWinnerCells(sdr);
+  else if (out == predictiveCells_)
+    sdr.setSparse(tm_->getPredictiveCells().getSparse());
+}
+
+
+void HTMPipelineRegion::setParameterReal64(const std::string &name, Int64 index, Real64 value) {
+  if (name == "sensedValue")  sensedValue_ = value;
+  else  RegionImpl::setParameterReal64(name, index, value);
+}
+void HTMPipelineRegion::setParameterBool(const std::string &name, Int64 index, bool value) {
+  if (name == "learningMode") learningMode_ = value;
+  else RegionImpl::setParameterBool(name, index, value);
+}
+
+Real64 HTMPipelineRegion::getParameterReal64(const std::string &name, Int64 index) {
+  if (name == "sensedValue") return sensedValue_;
+  else return RegionImpl::getParameterReal64(name, index);
+}
+
+Real32 HTMPipelineRegion::getParameterReal32(const std::string &name, Int64 index) {
+  if (name == "sparsity")                  return encoder_->parameters.sparsity;
+  else if (name == "radius")               return encoder_->parameters.radius;
+  else if (name == "resolution")           return encoder_->parameters.resolution;
+  else if (name == "potentialPct")         return sp_->getPotentialPct();
+  else if (name == "localAreaDensity")     return sp_->getLocalAreaDensity();
+  else if (name == "synPermInactiveDec")   return sp_->getSynPermInactiveDec();
+  else if (name == "synPermActiveInc")     return sp_->getSynPermActiveInc();
+  else if (name == "synPermConnected")     return sp_->getSynPermConnected();
+  else if (name == "minPctOverlapDutyCycles") return sp_->getMinPctOverlapDutyCycles();
+  else if (name == "boostStrength")        return sp_->getBoostStrength();
+  else if (name == "initialPermanence")    return tm_->getInitialPermanence();
+  else if (name == "connectedPermanence")  return tm_->getConnectedPermanence();
+  else if (name == "permanenceIncrement")  return tm_->getPermanenceIncrement();
+  else if (name == "permanenceDecrement")  return tm_->getPermanenceDecrement();
+  else if (name == "predictedSegmentDecrement") return tm_->getPredictedSegmentDecrement();
+  else if (name == "anomaly")              return tm_->anomaly;
+  else return RegionImpl::getParameterReal32(name, index);
+}
+
+UInt32 HTMPipelineRegion::getParameterUInt32(const std::string &name, Int64 index) {
+  if (name == "size")                       return encoder_->parameters.size;
+  else if (name == "activeBits")            return encoder_->parameters.activeBits;
+  else if (name == "columnCount")           return sp_->getNumColumns();
+  else if (name == "potentialRadius")       return sp_->getPotentialRadius();
+  else if (name == "stimulusThreshold")     return sp_->getStimulusThreshold();
+  else if (name == "dutyCyclePeriod")       return sp_->getDutyCyclePeriod();
+  else if (name == "cellsPerColumn")        return static_cast<UInt32>(tm_->getCellsPerColumn());
+  else if (name == "activationThreshold")   return tm_->getActivationThreshold();
+  else if (name == "minThreshold")          return tm_->getMinThreshold();
+  else if (name == "maxNewSynapseCount")    return tm_->getMaxNewSynapseCount();
+  else if (name == "maxSegmentsPerCell")    return tm_->getMaxSegmentsPerCell();
+  else if (name == "maxSynapsesPerSegment") return tm_->getMaxSynapsesPerSegment();
+  else return RegionImpl::getParameterUInt32(name, index);
+}
+
+Int32 HTMPipelineRegion::getParameterInt32(const std::string &name, Int64 index) {
+  if (name == "seed") return seed_;
+  else return RegionImpl::getParameterInt32(name, index);
+}
+
+bool HTMPipelineRegion::getParameterBool(const std::string &name, Int64 index) {
+  if (name == "category")              return encoder_->parameters.category;
+  else if (name == "globalInhibition") return sp_->getGlobalInhibition();
+  else if (name == "learningMode")     return learningMode_;
+  else return RegionImpl::getParameterBool(name, index);
+}
+
+bool HTMPipelineRegion::operator==(const RegionImpl &other) const {
+  if (other.getType() != "HTMPipelineRegion") return false;
+  const HTMPipelineRegion &o = reinterpret_cast<const HTMPipelineRegion&>(other);
+  if (sensedValue_ != o.sensedValue_) return false;
+  if (learningMode_ != o.learningMode_) return false;
+  if (seed_ != o.seed_) return false;
+  if (encoder_->parameters.size != o.encoder_->parameters.size) return false;
+  if (encoder_->parameters.activeBits != o.encoder_->parameters.activeBits) return false;
+  if (encoder_->parameters.radius != o.encoder_->parameters.radius) return false;
+  if (encoder_->parameters.resolution != o.encoder_->parameters.resolution) return false;
+  if (encoder_->parameters.category != o.encoder_->parameters.category) return false;
+  if (encoder_->parameters.seed != o.encoder_->parameters.seed) return false;
+  if (*sp_ != *o.sp_) return false;
+  if (*tm_ != *o.tm_) return false;
+  return true;
+}
+
+} // namespace htm
@@ -0,0 +1,137 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines HTMPipelineRegion, the RDSE encoder, SP and TM in one region.
+ */
+
+#ifndef NTA_HTM_PIPELINE_REGION_HPP
+#define NTA_HTM_PIPELINE_REGION_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+/**
+ * A network region running the canonical chain
+ *     RDSEEncoderRegion -> SPRegion -> TMRegion
+ * as one region.
+ *
+ * @b Description
+ * The region owns the RandomDistributedScalarEncoder, the SpatialPooler and
+ * the TemporalMemory.  Each stage computes directly into the SDR of the
+ * output which the next stage reads, so there are no links, no Array
+ * conversions and one compute() per record.  The outputs are those of the
+ * separate regions: encoded and bucket of the encoder, columns (the SP
+ * bottomUpOut), and bottomUpOut, activeCells, predictedActiveCells,
+ * predictiveCells and anomaly of the TM.  Like TMRegion, the TM outputs
+ * without links are produced only when they are read.
+ *
+ * Encoder parameters are those of RDSEEncoderRegion, SP parameters those of
+ * SPRegion (columnCount sets the 1D column dimensions), TM parameters those
+ * of TMRegion.  `seed` seeds all three; learningMode applies to SP and TM.
+ */
+class HTMPipelineRegion : public RegionImpl, Serializable {
+public:
+  HTMPipelineRegion(const ValueMap &params, Region *region);
+  HTMPipelineRegion(ArWrapper &wrapper, Region *region);
+
+  virtual ~HTMPipelineRegion() override;
+
+  static Spec *createSpec();
+
+  virtual Real64 getParameterReal64(const std::string &name, Int64 index = -1) override;
+  virtual Real32 getParameterReal32(const std::string &name, Int64 index = -1) override;
+  virtual UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) override;
+  virtual Int32 getParameterInt32(const std::string &name, Int64 index = -1) override;
+  virtual bool getParameterBool(const std::string &name, Int64 index = -1) override;
+  virtual void setParameterReal64(const std::string &name, Int64 index, Real64 value) override;
+  virtual void setParameterBool(const std::string &name, Int64 index, bool value) override;
+  virtual void initialize() override;
+
+  void compute() override;
+  void bindPorts() override;
+  void produceOutput(const std::string &name) override;
+
+  virtual Dimensions askImplForOutputDimensions(const std::string &name) override;
+
+  std::vector<const Connections *> getConnections() const override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(CEREAL_NVP(sensedValue_));
+    ar(CEREAL_NVP(learningMode_));
+    ar(CEREAL_NVP(seed_));
+    ar(cereal::make_nvp("encoder", encoder_));
+    ar(cereal::make_nvp("SP", sp_));
+    ar(cereal::make_nvp("TM", tm_));
+  }
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(CEREAL_NVP(sensedValue_));
+    ar(CEREAL_NVP(learningMode_));
+    ar(CEREAL_NVP(seed_));
+    ar(cereal::make_nvp("encoder", encoder_));
+    ar(cereal::make_nvp("SP", sp_));
+    ar(cereal::make_nvp("TM", tm_));
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const HTMPipelineRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  void produceOrSkip_(Output *out);
+  void produce_(Output *out);
+
+  Real64 sensedValue_ = 0.0;
+  bool learningMode_ = true;
+  Int32 seed_ = 1;
+  std::shared_ptr<RandomDistributedScalarEncoder> encoder_;
+  std::unique_ptr<SpatialPooler> sp_;
+  std::unique_ptr<TemporalMemory> tm_;
+
+  // The ports of compute(), @see bindPorts().
+  Input *values_ = nullptr;
+  Input *resetIn_ = nullptr;
+  Output *encoded_ = nullptr;
+  Output *bucket_ = nullptr;
+  Output *columns_ = nullptr;
+  Output *bottomUpOut_ = nullptr;
+  Output *activeCells_ = nullptr;
+  Output *predictedActiveCells_ = nullptr;
+  Output *predictiveCells_ = nullptr;
+  Output *anomaly_ = nullptr;
+
+  // The TM outputs without links which the last compute() skipped.
+  std::vector<Output *> skipped_;
+};
+} // namespace htm
+
+#endif // NTA_HTM_PIPELINE_REGION_HPP
@@ -0,0 +1,199 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the KNN Classifier Region.
+ *
+ * Like the ClassifierRegion, the inputs are the quantized values of the
+ * current sample ('bucket') and the pattern generated for it ('pattern').
+ * When learning, the pattern is stored once with each of the bucket values.
+ * The 'pdf' output holds the votes of the k nearest stored patterns for each
+ * title, sorted by title; 'predicted' is the index of the title with the most
+ * votes.
+ */
+
+#include <htm/regions/KNNClassifierRegion.hpp>
+
+#include <htm/engine/Input.hpp>
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+
+/* static */ Spec *KNNClassifierRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+   {name: "KNNClassifierRegion",
+    parameters: {
+      learn:       { description: "if true, it stores the pattern of each sample",
+                     type: Bool, access: ReadWrite, default: "true"},
+      k:           { description: "Number of nearest patterns which vote.",
+                     type: UInt32, default: "1"},
+      numBands:    { description: "Number of MinHash bands for approximate inference, 0 for exact inference.",
+                     type: UInt32, default: "0"},
+      rowsPerBand: { description: "Number of min-hashes per band.",
+                     type: UInt32, default: "4"},
+      minOverlap:  { description: "Minimum overlap of a voting pattern with the current pattern.",
+                     type: UInt32, default: "1"},
+      exact:       { description: "if true, inference is exact even with numBands > 0",
+                     type: Bool, access: ReadWrite, default: "false"},
+    },
+    inputs: {
+      bucket:  { description: "The quantized value of the current sample, one from each encoder if more than one, for the learn step",
+                 type: Real64, count: 0},
+      pattern: { description: "An SDR output bit pattern for a sample.  Usually the output of the SP or TM.",
+                 type: SDR, count: 0}
+    },
+    outputs: {
+      pdf:       { description: "The fraction of the votes for each category or bucket. Sorted by title.  Warning, buffer length will grow.",
+                   type: Real64, count: 0},
+      titles:    { description: "Quantized values of used samples which are the Titles corresponding to the pdf indexes. Sorted by title. Warning, buffer length will grow.",
+                   type: Real64, count: 0},
+      predicted: { description: "An index (into pdf and titles) with the most votes for the current pattern.",
+                   type: UInt32, count: 1}
+    }
+   }
+  )");
+
+  return ns;
+}
+
+
+KNNClassifierRegion::KNNClassifierRegion(const ValueMap &par, Region *region) : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  learn_ = params["learn"].as<bool>();
+  classifier_.initialize(params.getScalarT<UInt32>("k"),
+                         params.getScalarT<UInt32>("numBands"),
+                         params.getScalarT<UInt32>("rowsPerBand"),
+                         params.getScalarT<UInt32>("minOverlap"));
+  classifier_.setExact(params["exact"].as<bool>());
+}
+
+KNNClassifierRegion::KNNClassifierRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+}
+KNNClassifierRegion::~KNNClassifierRegion() {}
+
+void KNNClassifierRegion::initialize() {}
+
+
+Dimensions KNNClassifierRegion::askImplForOutputDimensions(const std::string &name) {
+  if (name == "pdf" || name == "titles" || name == "predicted") {
+    // pdf and titles grow in compute() as new titles are learned.
+    Dimensions dim1 = {1};
+    return dim1;
+  }
+  return RegionImpl::askImplForOutputDimensions(name);
+}
+
+
+size_t KNNClassifierRegion::memoryUsage() const {
+  return classifier_.memoryUsage() + bucketList_.capacity() * sizeof(Real64) +
+         bucketListMap_.size() * (sizeof(std::pair<Real64, UInt32>) + 4u * sizeof(void*));
+}
+
+
+void KNNClassifierRegion::compute() {
+  const SDR &pattern = pattern_->getData().getSDR();
+  NTA_CHECK(pattern.size > 0u) << "KNNClassifierRegion: the 'pattern' input is not linked";
+
+  if (learn_) {
+    const Array &b = bucket_->getData();
+    const Real64 *quantizedSample = reinterpret_cast<const Real64 *>(b.getBuffer());
+    for (size_t i = 0; i < b.getCount(); i++) {
+      auto it = bucketListMap_.find(quantizedSample[i]);
+      if (it == bucketListMap_.end()) {
+        const UInt32 c = static_cast<UInt32>(bucketList_.size());
+        bucketList_.push_back(quantizedSample[i]);
+        it = bucketListMap_.emplace(quantizedSample[i], c).first;
+      }
+      classifier_.learn(pattern, it->second);
+    }
+  }
+  classifier_.infer(pattern, pdf_);
+  pdf_.resize(bucketList_.size(), 0.0);
+
+  if (pdfOut_->getData().getCount() < pdf_.size()) {
+    const UInt size = static_cast<UInt>(pdf_.size());
+    pdfOut_->resize(size);
+    titles_->resize(size);
+  }
+
+  // Sorted by title, like the ClassifierRegion.
+  Real64 *out = reinterpret_cast<Real64 *>(pdfOut_->getData().getBuffer());
+  Real64 *titles = reinterpret_cast<Real64 *>(titles_->getData().getBuffer());
+  UInt32 *predicted = reinterpret_cast<UInt32 *>(predicted_->getData().getBuffer());
+  Real64 m = 0.0;
+  UInt32 j = 0u;
+  predicted[0] = 0u;
+  for (const auto &itm : bucketListMap_) {
+    const Real64 p = pdf_[itm.second];
+    if (p > m) {
+      m = p;
+      predicted[0] = j;
+    }
+    out[j] = p;
+    titles[j] = itm.first;
+    j++;
+  }
+}
+
+void KNNClassifierRegion::bindPorts() {
+  pattern_ = bindInput("pattern");
+  bucket_ = bindInput("bucket");
+  pdfOut_ = bindOutput("pdf");
+  titles_ = bindOutput("titles");
+  predicted_ = bindOutput("predicted");
+}
+
+
+UInt32 KNNClassifierRegion::getParameterUInt32(const std::string &name, Int64 index) {
+  if (name == "k")           return classifier_.getK();
+  if (name == "numBands")    return classifier_.getNumBands();
+  if (name == "rowsPerBand") return classifier_.getRowsPerBand();
+  if (name == "minOverlap")  return classifier_.getMinOverlap();
+  return RegionImpl::getParameterUInt32(name, index);
+}
+
+void KNNClassifierRegion::setParameterBool(const std::string &name, Int64 index, bool val) {
+  if (name == "learn")
+    learn_ = val;
+  else if (name == "exact")
+    classifier_.setExact(val);
+  else
+    RegionImpl::setParameterBool(name, index, val);
+}
+
+bool KNNClassifierRegion::getParameterBool(const std::string &name, Int64 index) {
+  if (name == "learn") return learn_;
+  if (name == "exact") return classifier_.getExact();
+  return RegionImpl::getParameterBool(name, index);
+}
+
+bool KNNClassifierRegion::operator==(const RegionImpl &other) const {
+  if (other.getType() != "KNNClassifierRegion") return false;
+  const KNNClassifierRegion &o = reinterpret_cast<const KNNClassifierRegion &>(other);
+  return learn_ == o.learn_ && bucketList_ == o.bucketList_ && classifier_ == o.classifier_;
+}
+
+} // namespace htm
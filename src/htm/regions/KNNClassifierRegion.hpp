@@ -0,0 +1,101 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the KNN Classifier Region.
+ */
+
+#ifndef NTA_KNNCLASSIFIERREGION_HPP
+#define NTA_KNNCLASSIFIERREGION_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <htm/algorithms/KNNClassifier.hpp>
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+
+/**
+ * A region around the KNNClassifier, a drop-in replacement for the
+ * ClassifierRegion: same inputs and outputs, @see ClassifierRegion.hpp.
+ */
+class KNNClassifierRegion : public RegionImpl, Serializable {
+public:
+  KNNClassifierRegion(const ValueMap &params, Region *region);
+  KNNClassifierRegion(ArWrapper &wrapper, Region *region);
+
+  virtual ~KNNClassifierRegion() override;
+
+  static Spec *createSpec();
+
+  virtual UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) override;
+  virtual bool getParameterBool(const std::string &name, Int64 index = -1) override;
+  virtual void setParameterBool(const std::string &name, Int64 index, bool value) override;
+
+  virtual void initialize() override;
+
+  void compute() override;
+  void bindPorts() override;
+
+  size_t memoryUsage() const override;
+
+  virtual Dimensions askImplForOutputDimensions(const std::string &name) override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive> void save_ar(Archive &ar) const {
+    ar(cereal::make_nvp("learn", learn_));
+    ar(cereal::make_nvp("bucketListMap", bucketListMap_));
+    ar(cereal::make_nvp("bucketList", bucketList_));
+    ar(cereal::make_nvp("classifier", classifier_));
+  }
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(cereal::make_nvp("learn", learn_));
+    ar(cereal::make_nvp("bucketListMap", bucketListMap_));
+    ar(cereal::make_nvp("bucketList", bucketList_));
+    ar(cereal::make_nvp("classifier", classifier_));
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const KNNClassifierRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  KNNClassifier classifier_;
+  bool learn_;
+
+  std::map<Real64, UInt32> bucketListMap_;  // category index of each title
+  std::vector<Real64> bucketList_;          // titles by category index
+  PDF pdf_;                                 // scratch of compute()
+
+  // The ports of compute(), @see bindPorts().
+  Input *pattern_ = nullptr;
+  Input *bucket_ = nullptr;
+  Output *pdfOut_ = nullptr;
+  Output *titles_ = nullptr;
+  Output *predicted_ = nullptr;
+};
+} // namespace htm
+
+#endif // NTA_KNNCLASSIFIERREGION_HPP
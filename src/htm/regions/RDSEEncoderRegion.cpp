@@ -49,16 +49,18 @@ namespace htm {
           resolution:  {type: Real32, default: "0.0"},
           category:    {type: Bool,   default: "false"},
           seed:        {type: UInt32, default: "0"},
+          channels:    {description: "number of values in the input 'values', each encoded into its own part of the output",
+                        type: UInt32, default: "1"},
           noise:       {description: "amount of noise to add to the output SDR. 0.01 is 1%",
                         type: Real32, default: "0.0", access: ReadWrite },
           sensedValue: {description: "The value to encode. Overriden by input 'values'.",
                         type: Real64, default: "0.0", access: ReadWrite }},
       inputs: {
-          values:      {description: "Values to encode. Overrides sensedValue.",
-                        type: Real64, count: 1, isDefaultInput: yes, isRegionLevel: yes}}, 
+          values:      {description: "Values to encode, one per channel. Overrides sensedValue.",
+                        type: Real64, count: 0, isDefaultInput: yes, isRegionLevel: yes}}, 
       outputs: {
-          bucket:      {description: "Quantized sample based on the radius. Becomes the title for this sample in Classifier.",
-                        type: Real64, count: 1, isDefaultOutput: false, isRegionLevel: false },
+          bucket:      {description: "Quantized sample based on the radius, one per channel. Becomes the title for this sample in Classifier.",
+                        type: Real64, count: 0, isDefaultOutput: false, isRegionLevel: false },
           encoded:     {description: "Encoded bits. Not a true Sparse Data Representation (SP does that).",
     type: SDR,    count: 0, isDefaultOutput: yes, isRegionLevel: yes }}
   } )");
@@ -84,6 +86,8 @@ RDSEEncoderRegion::RDSEEncoderRegion(const ValueMap &par, Region *region) : Regi
   encoder_ = std::make_shared<RandomDistributedScalarEncoder>(args);
   sensedValue_ = params.getScalarT<Real64>("sensedValue");
   noise_ = params.getScalarT<Real32>("noise");
+  channels_ = params.getScalarT<UInt32>("channels");
+  NTA_CHECK(channels_ > 0u) << "RDSEEncoderRegion: channels must be > 0";
 }
 
 RDSEEncoderRegion::RDSEEncoderRegion(ArWrapper &wrapper, Region *region)
@@ -97,12 +101,30 @@ void RDSEEncoderRegion::initialize() { }
 Dimensions RDSEEncoderRegion::askImplForOutputDimensions(const std::string &name) {
   if (name == "encoded") {
     // get the dimensions determined by the encoder (comes from parameters.size).
-    Dimensions encoderDim(encoder_->dimensions); // get dimensions from encoder
-    return encoderDim;
-  }  return RegionImpl::askImplForOutputDimensions(name);
+    return encodedDimensions_();
+  }
+  if (name == "bucket")
+    return Dimensions(channels_);
+  return RegionImpl::askImplForOutputDimensions(name);
+}
+
+Dimensions RDSEEncoderRegion::askImplForInputDimensions(const std::string &name) {
+  if (name == "values")
+    return Dimensions(channels_);
+  return RegionImpl::askImplForInputDimensions(name);
+}
+
+Dimensions RDSEEncoderRegion::encodedDimensions_() const {
+  if (channels_ == 1u)
+    return Dimensions(encoder_->dimensions);
+  return Dimensions(channels_ * encoder_->size);
 }
 
 void RDSEEncoderRegion::compute() {
+  if (channels_ > 1u) {
+    computeChannels_();
+    return;
+  }
   if (hasInput("values")) {
     Array &a = getInput("values")->getData();
     sensedValue_ = ((Real64 *)(a.getBuffer()))[0];
@@ -131,6 +153,28 @@ void RDSEEncoderRegion::compute() {
 }
 
 
+void RDSEEncoderRegion::computeChannels_() {
+  NTA_CHECK(hasInput("values"))
+      << "RDSEEncoderRegion: the input 'values' must be linked to encode " << channels_ << " channels";
+  const Real64 *values = (const Real64 *)getInput("values")->getData().getBuffer();
+  Real64 *buckets = (Real64 *)getOutput("bucket")->getData().getBuffer();
+  const Real64 radius = encoder_->parameters.radius;
+
+  // Each channel appends its bits at its offset, so the indices stay sorted.
+  sparse_.clear();
+  for (UInt32 c = 0u; c < channels_; c++) {
+    const Real64 value = std::isfinite(values[c]) ? values[c] : 0.0;
+    encoder_->encodeSparse(value, c * encoder_->size, sparse_);
+    if (radius != 0.0)
+      buckets[c] = value - std::fmod(value, radius);
+  }
+  SDR &output = getOutput("encoded")->getData().getSDR();
+  output.setSparse(sparse_);
+  if (noise_ != 0.0f)
+    output.addNoise(noise_, rnd_);
+}
+
+
 void RDSEEncoderRegion::setParameterReal64(const std::string &name, Int64 index, Real64 value) {
   if (name == "sensedValue")  sensedValue_ = value;
   else  RegionImpl::setParameterReal64(name, index, value);
@@ -157,6 +201,7 @@ UInt32 RDSEEncoderRegion::getParameterUInt32(const std::string &name, Int64 inde
   if (name == "size")            return encoder_->parameters.size;
   else if (name == "activeBits") return encoder_->parameters.activeBits;
   else if (name == "seed")       return encoder_->parameters.seed;
+  else if (name == "channels")   return channels_;
   else return RegionImpl::getParameterUInt32(name, index);
 }
 
@@ -183,6 +228,7 @@ bool RDSEEncoderRegion::operator==(const RegionImpl &other) const {
   if (encoder_->parameters.seed != o.encoder_->parameters.seed)
     return false;
   if (sensedValue_ != o.sensedValue_) return false;
+  if (channels_ != o.channels_) return false;
 
   return true;
 }
@@ -41,6 +41,10 @@ namespace htm {
  * API. As a network runs, the client will specify new encoder inputs by
  * setting the "sensedValue" parameter or connecting a link which provides values for "sensedValue". 
  * On each compute, the ScalarSensor will encode its "sensedValue" to output.
+ *
+ * With channels > 1 the "values" input is a vector of that many values.  All
+ * of them are encoded with the same parameters into one SDR, channel c at the
+ * offset c * size, and "bucket" holds one quantized value per channel.
  */
 class RDSEEncoderRegion : public RegionImpl, Serializable {
 public:
@@ -62,14 +66,17 @@ public:
   void compute() override;
 
   virtual Dimensions askImplForOutputDimensions(const std::string &name) override;
+  virtual Dimensions askImplForInputDimensions(const std::string &name) override;
 
   CerealAdapter;  // see Serializable.hpp
   // FOR Cereal Serialization
   template<class Archive>
   void save_ar(Archive& ar) const {
+    saveArchiveVersion(ar, realArchiveMarker(), ARCHIVE_VERSION);
     ar(CEREAL_NVP(sensedValue_));
     ar(CEREAL_NVP(noise_));
     ar(CEREAL_NVP(rnd_));
+    ar(CEREAL_NVP(channels_));
     ar(cereal::make_nvp("encoder", encoder_));
   }
   // FOR Cereal Deserialization
@@ -79,11 +86,17 @@ public:
   //       the region_ field in the Base class.
   template<class Archive>
   void load_ar(Archive& ar) {
-    ar(CEREAL_NVP(sensedValue_));
+    const UInt32 version = loadArchiveVersion(ar, "sensedValue_", sensedValue_, realArchiveMarker(), 1u);
+    NTA_CHECK(version <= ARCHIVE_VERSION) << "Unknown archive version " << version;
     ar(CEREAL_NVP(noise_));
     ar(CEREAL_NVP(rnd_));
+    if (version >= 2u) {
+      ar(CEREAL_NVP(channels_));
+    } else {
+      channels_ = 1u; // archived before the channels
+    }
     ar(cereal::make_nvp("encoder", encoder_));
-    setDimensions(encoder_->dimensions); 
+    setDimensions(encodedDimensions_());
   }
 
 
@@ -93,8 +106,16 @@ public:
   }
 
 private:
+  // Version 2 added the channels, version 1 is the unversioned layout.
+  static const UInt32 ARCHIVE_VERSION = 2u;
+
+  Dimensions encodedDimensions_() const;
+  void computeChannels_();
+
   Real64 sensedValue_;
   Real32 noise_;
+  UInt32 channels_ = 1u;  // the number of values encoded side by side
+  SDR_sparse_t sparse_;   // scratch for the encoding of all channels
   Random rnd_;
   std::shared_ptr<RandomDistributedScalarEncoder> encoder_;
 };
@@ -0,0 +1,108 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the RemoteInputRegion Region
+ */
+
+#include <htm/regions/RemoteInputRegion.hpp>
+
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+
+/* static */ Spec *RemoteInputRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "RemoteInputRegion",
+      parameters: {
+          port:             {description: "Port to listen on, 0 for any free port.",
+                             type: UInt32, default: "0"},
+          propagationDelay: {description: "Iterations which the sender may run ahead.",
+                             type: UInt32, default: "1"},
+          timeout:          {description: "Seconds to wait for the SDR of an iteration.",
+                             type: Real64, default: "60.0", access: ReadWrite}},
+      outputs: {
+          dataOut:          {description: "The SDR received for this iteration.",
+                             type: SDR, count: 0, isDefaultOutput: yes, isRegionLevel: yes}}
+  } )");
+
+  return ns;
+}
+
+
+RemoteInputRegion::RemoteInputRegion(const ValueMap &par, Region *region) : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  propagationDelay_ = params.getScalarT<UInt32>("propagationDelay");
+  timeout_ =          params.getScalarT<Real64>("timeout");
+  receiver_.reset(new RemoteLinkReceiver(params.getScalarT<UInt32>("port")));
+  port_ = receiver_->getPort();
+}
+
+RemoteInputRegion::RemoteInputRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+}
+RemoteInputRegion::~RemoteInputRegion() {}
+
+void RemoteInputRegion::initialize() {
+  NTA_CHECK(dim_.isSpecified())
+      << "RemoteInputRegion::initialize - the dimensions of the received SDR, 'dim', are required";
+}
+
+void RemoteInputRegion::compute() {
+  SDR &output = getOutput("dataOut")->getData().getSDR();
+  iteration_++;
+  if (iteration_ <= propagationDelay_) {
+    output.zero();  // nothing was sent this far back, like a delayed Link
+    return;
+  }
+  receiver_->receive(iteration_ - propagationDelay_, output, timeout_);
+}
+
+
+UInt32 RemoteInputRegion::getParameterUInt32(const std::string &name, Int64 index) {
+  if (name == "port")                  return port_;
+  else if (name == "propagationDelay") return propagationDelay_;
+  else return RegionImpl::getParameterUInt32(name, index);
+}
+
+Real64 RemoteInputRegion::getParameterReal64(const std::string &name, Int64 index) {
+  if (name == "timeout") return timeout_;
+  else return RegionImpl::getParameterReal64(name, index);
+}
+
+void RemoteInputRegion::setParameterReal64(const std::string &name, Int64 index, Real64 value) {
+  if (name == "timeout") timeout_ = value;
+  else RegionImpl::setParameterReal64(name, index, value);
+}
+
+bool RemoteInputRegion::operator==(const RegionImpl &other) const {
+  if (other.getType() != "RemoteInputRegion") return false;
+  const RemoteInputRegion &o = reinterpret_cast<const RemoteInputRegion&>(other);
+  return propagationDelay_ == o.propagationDelay_ && timeout_ == o.timeout_ &&
+         iteration_ == o.iteration_ && dim_ == o.dim_;
+}
+
+
+} // namespace htm
@@ -0,0 +1,103 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines RemoteInputRegion, the receiving end of a link from another process.
+ */
+
+#ifndef NTA_REMOTE_INPUT_REGION_HPP
+#define NTA_REMOTE_INPUT_REGION_HPP
+
+#include <memory>
+#include <string>
+
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/engine/RemoteLink.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+
+/**
+ * A region which outputs the SDRs sent by a RemoteOutputRegion in another
+ * Network, usually in another process or on another host.
+ *
+ * @b Description
+ * It listens on "port" from its creation (0 picks a free port, read it
+ * back with getParameterUInt32("port")).  The "dim" parameter gives the
+ * dimensions of the output "dataOut", which must match the sent SDR.
+ *
+ * Like a Link with a propagation delay, iteration t outputs the SDR which
+ * the sender computed in iteration t - propagationDelay, and zeros before
+ * that.  The sender may thus run up to propagationDelay iterations ahead,
+ * and the two Networks compute concurrently.  With a delay of 0 the
+ * receiver waits for the sender to compute the same iteration.  A compute
+ * throws if the SDR does not arrive within "timeout" seconds.
+ */
+class RemoteInputRegion : public RegionImpl, Serializable {
+public:
+  RemoteInputRegion(const ValueMap &params, Region *region);
+  RemoteInputRegion(ArWrapper &wrapper, Region *region);
+
+  virtual ~RemoteInputRegion() override;
+
+  static Spec *createSpec();
+
+  virtual UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) override;
+  virtual Real64 getParameterReal64(const std::string &name, Int64 index = -1) override;
+  virtual void setParameterReal64(const std::string &name, Int64 index, Real64 value) override;
+  virtual void initialize() override;
+
+  void compute() override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(CEREAL_NVP(port_));
+    ar(CEREAL_NVP(propagationDelay_));
+    ar(CEREAL_NVP(timeout_));
+    ar(CEREAL_NVP(iteration_));
+    ar(CEREAL_NVP(dim_));  // in base class
+  }
+  // FOR Cereal Deserialization
+  // Listens again on the same port.
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(CEREAL_NVP(port_));
+    ar(CEREAL_NVP(propagationDelay_));
+    ar(CEREAL_NVP(timeout_));
+    ar(CEREAL_NVP(iteration_));
+    ar(CEREAL_NVP(dim_));  // in base class
+    receiver_.reset(new RemoteLinkReceiver(port_));
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const RemoteInputRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  UInt32 port_;
+  UInt32 propagationDelay_;
+  Real64 timeout_;     // seconds
+  UInt64 iteration_ = 0u;
+  std::unique_ptr<RemoteLinkReceiver> receiver_;
+};
+} // namespace htm
+
+#endif // NTA_REMOTE_INPUT_REGION_HPP
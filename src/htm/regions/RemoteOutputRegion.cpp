@@ -0,0 +1,99 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the RemoteOutputRegion Region
+ */
+
+#include <htm/regions/RemoteOutputRegion.hpp>
+
+#include <htm/engine/Input.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+
+/* static */ Spec *RemoteOutputRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "RemoteOutputRegion",
+      parameters: {
+          host:    {description: "Host of the RemoteInputRegion to send to.",
+                    type: String, default: "localhost"},
+          port:    {description: "Port of the RemoteInputRegion to send to.",
+                    type: UInt32, default: "0"},
+          timeout: {description: "Seconds to wait for the receiver to take an iteration.",
+                    type: UInt32, default: "60"}},
+      inputs: {
+          dataIn:  {description: "The SDR to send, each iteration.",
+                    type: SDR, count: 0, isDefaultInput: yes, isRegionLevel: yes}}
+  } )");
+
+  return ns;
+}
+
+
+RemoteOutputRegion::RemoteOutputRegion(const ValueMap &par, Region *region) : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  host_ =    params.getString("host", "localhost");
+  port_ =    params.getScalarT<UInt32>("port");
+  timeout_ = params.getScalarT<UInt32>("timeout");
+  NTA_CHECK(port_ > 0u) << "RemoteOutputRegion: the port of the receiver is required";
+}
+
+RemoteOutputRegion::RemoteOutputRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+}
+RemoteOutputRegion::~RemoteOutputRegion() {}
+
+void RemoteOutputRegion::initialize() {
+  std::shared_ptr<Input> in = region_->getInput("dataIn");
+  NTA_CHECK(in != nullptr && in->hasIncomingLinks())
+      << "RemoteOutputRegion::initialize - the input 'dataIn' must be linked to the output to send";
+}
+
+void RemoteOutputRegion::compute() {
+  if (sender_ == nullptr)
+    sender_.reset(new RemoteLinkSender(host_, port_, timeout_));
+  sender_->send(++iteration_, getInput("dataIn")->getData().getSDR());
+}
+
+
+std::string RemoteOutputRegion::getParameterString(const std::string &name, Int64 index) {
+  if (name == "host") return host_;
+  else return RegionImpl::getParameterString(name, index);
+}
+
+UInt32 RemoteOutputRegion::getParameterUInt32(const std::string &name, Int64 index) {
+  if (name == "port")         return port_;
+  else if (name == "timeout") return timeout_;
+  else return RegionImpl::getParameterUInt32(name, index);
+}
+
+bool RemoteOutputRegion::operator==(const RegionImpl &other) const {
+  if (other.getType() != "RemoteOutputRegion") return false;
+  const RemoteOutputRegion &o = reinterpret_cast<const RemoteOutputRegion&>(other);
+  return host_ == o.host_ && port_ == o.port_ && timeout_ == o.timeout_ && iteration_ == o.iteration_;
+}
+
+
+} // namespace htm
@@ -0,0 +1,91 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Defines RemoteOutputRegion, the sending end of a link to another process.
+ */
+
+#ifndef NTA_REMOTE_OUTPUT_REGION_HPP
+#define NTA_REMOTE_OUTPUT_REGION_HPP
+
+#include <memory>
+#include <string>
+
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/engine/RemoteLink.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+
+/**
+ * A region which sends its input SDR to a RemoteInputRegion in another
+ * Network, usually in another process or on another host.
+ *
+ * @b Description
+ * Link the output to send into "dataIn".  Each compute sends it with the
+ * number of the iteration, to the RemoteInputRegion listening on "host" and
+ * "port", and waits until it was received.  @see RemoteLinkSender.
+ */
+class RemoteOutputRegion : public RegionImpl, Serializable {
+public:
+  RemoteOutputRegion(const ValueMap &params, Region *region);
+  RemoteOutputRegion(ArWrapper &wrapper, Region *region);
+
+  virtual ~RemoteOutputRegion() override;
+
+  static Spec *createSpec();
+
+  virtual std::string getParameterString(const std::string &name, Int64 index = -1) override;
+  virtual UInt32 getParameterUInt32(const std::string &name, Int64 index = -1) override;
+  virtual void initialize() override;
+
+  void compute() override;
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(CEREAL_NVP(host_));
+    ar(CEREAL_NVP(port_));
+    ar(CEREAL_NVP(timeout_));
+    ar(CEREAL_NVP(iteration_));
+  }
+  // FOR Cereal Deserialization
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(CEREAL_NVP(host_));
+    ar(CEREAL_NVP(port_));
+    ar(CEREAL_NVP(timeout_));
+    ar(CEREAL_NVP(iteration_));
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const RemoteOutputRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  std::string host_;
+  UInt32 port_;
+  UInt32 timeout_;     // seconds
+  UInt64 iteration_ = 0u;
+  std::unique_ptr<RemoteLinkSender> sender_; // created by the first compute
+};
+} // namespace htm
+
+#endif // NTA_REMOTE_OUTPUT_REGION_HPP
@@ -0,0 +1,220 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the ReplayRegion Region
+ */
+
+#include <algorithm>
+
+#include <htm/regions/ReplayRegion.hpp>
+
+#include <htm/engine/Output.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/engine/Spec.hpp>
+#include <htm/engine/Watcher.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+
+/* static */ Spec *ReplayRegion::createSpec() {
+  Spec *ns = new Spec();
+  ns->parseSpec(R"(
+  {name: "ReplayRegion",
+      parameters: {
+          file:        {description: "The log of a binary Watcher.",
+                        type: String, default: ""},
+          source:      {description: "The recorded region to replay, empty if the log has one region.",
+                        type: String, default: ""},
+          dataOutput:  {description: "The recorded SDR output replayed on dataOut, empty for the first one.",
+                        type: String, default: ""},
+          valueOutput: {description: "The recorded output replayed on values, empty for the first dense one.",
+                        type: String, default: ""},
+          loop:        {description: "Start over after the last record, else a compute throws.",
+                        type: Bool, default: "true", access: ReadWrite},
+          position:    {description: "The index of the next record.",
+                        type: UInt64, default: "0", access: ReadOnly}},
+      outputs: {
+          dataOut:     {description: "The recorded SDR of this iteration.",
+                        type: SDR, count: 0, isDefaultOutput: yes, isRegionLevel: yes},
+          values:      {description: "The recorded values of this iteration.",
+                        type: Real64, count: 0, isDefaultOutput: no, isRegionLevel: no}}
+  } )");
+
+  return ns;
+}
+
+
+ReplayRegion::ReplayRegion(const ValueMap &par, Region *region) : RegionImpl(region) {
+  spec_.reset(createSpec());
+  ValueMap params = ValidateParameters(par, spec_.get());
+  file_ =        params.getString("file", "");
+  source_ =      params.getString("source", "");
+  dataOutput_ =  params.getString("dataOutput", "");
+  valueOutput_ = params.getString("valueOutput", "");
+  loop_ =        params.getScalarT<bool>("loop");
+  NTA_CHECK(!file_.empty()) << "ReplayRegion: the parameter 'file' is required.";
+  load_();
+}
+
+ReplayRegion::ReplayRegion(ArWrapper &wrapper, Region *region)
+    : RegionImpl(region) {
+  cereal_adapter_load(wrapper);
+}
+ReplayRegion::~ReplayRegion() {}
+
+
+void ReplayRegion::load_() {
+  WatcherReader reader(file_);
+  NTA_CHECK(reader.getSampling() == 1u)
+      << "ReplayRegion: " << file_ << " is sampled every " << reader.getSampling()
+      << " iterations, it can not be replayed.";
+
+  // Find the watches of the source.
+  const auto &watches = reader.getWatches();
+  if (source_.empty()) {
+    for (const auto &w : watches) {
+      NTA_CHECK(source_.empty() || source_ == w.regionName)
+          << "ReplayRegion: " << file_ << " has several regions, the parameter 'source' is required.";
+      source_ = w.regionName;
+    }
+  }
+  UInt32 dataID = 0u, valueID = 0u;
+  for (const auto &w : watches) {
+    if (w.regionName != source_ || w.nodeIndex != -1)
+      continue;
+    if (dataID == 0u && (dataOutput_.empty() ? w.layout == Watcher::Sparse : w.varName == dataOutput_)) {
+      NTA_CHECK(w.layout == Watcher::Sparse)
+          << "ReplayRegion: " << source_ << "." << w.varName << " is not recorded as an SDR.";
+      dataID = w.watchID;
+      dataOutput_ = w.varName;
+    }
+    else if (valueID == 0u && (valueOutput_.empty() ? w.layout == Watcher::Dense : w.varName == valueOutput_)) {
+      NTA_CHECK(w.layout == Watcher::Dense || w.layout == Watcher::Scalar)
+          << "ReplayRegion: " << source_ << "." << w.varName << " is not recorded as values.";
+      valueID = w.watchID;
+      valueOutput_ = w.varName;
+    }
+  }
+  NTA_CHECK(dataID != 0u) << "ReplayRegion: " << file_ << " has no SDR output "
+                          << dataOutput_ << " of region '" << source_ << "'.";
+  NTA_CHECK(valueOutput_.empty() || valueID != 0u)
+      << "ReplayRegion: " << file_ << " has no output " << valueOutput_ << " of region '" << source_ << "'.";
+
+  sparse_.clear();
+  sparseBegin_.assign(1u, 0u);
+  values_.clear();
+  UInt32 watchID;
+  UInt64 iteration;
+  Array value;
+  UInt64 valueRecords = 0u;
+  while (reader.next(watchID, iteration, value)) {
+    if (watchID == dataID) {
+      const SDR &sdr = value.getSDR();
+      NTA_CHECK(sparseBegin_.size() == 1u || sdr.size == dataSize_)
+          << "ReplayRegion: " << source_ << "." << dataOutput_ << " changed size at iteration " << iteration;
+      dataSize_ = static_cast<UInt32>(sdr.size);
+      const auto &indices = sdr.getSparse();
+      sparse_.insert(sparse_.end(), indices.begin(), indices.end());
+      sparseBegin_.push_back(sparse_.size());
+    }
+    else if (watchID == valueID) {
+      NTA_CHECK(valueRecords == 0u || value.getCount() == valueCount_)
+          << "ReplayRegion: " << source_ << "." << valueOutput_ << " changed size at iteration " << iteration;
+      valueCount_ = static_cast<UInt32>(value.getCount());
+      const auto converted = value.asVector<Real64>();
+      values_.insert(values_.end(), converted.begin(), converted.end());
+      valueRecords++;
+    }
+  }
+  NTA_CHECK(size() > 0u) << "ReplayRegion: " << file_ << " has no records.";
+  NTA_CHECK(valueID == 0u || valueRecords == size())
+      << "ReplayRegion: " << file_ << " is truncated.";
+}
+
+
+Dimensions ReplayRegion::askImplForOutputDimensions(const std::string &name) {
+  if (name == "dataOut") {
+    if (dim_.isSpecified()) {
+      NTA_CHECK(dim_.getCount() == dataSize_)
+          << "ReplayRegion: 'dim' " << dim_ << " does not match the recorded size " << dataSize_;
+      return dim_;
+    }
+    return Dimensions(dataSize_);
+  }
+  if (name == "values")
+    return Dimensions(valueCount_ == 0u ? 1u : valueCount_);
+  return RegionImpl::askImplForOutputDimensions(name);
+}
+
+
+void ReplayRegion::initialize() {}
+
+
+void ReplayRegion::compute() {
+  if (position_ == size()) {
+    NTA_CHECK(loop_) << "ReplayRegion: all " << size() << " records of " << file_ << " were replayed.";
+    position_ = 0u;
+  }
+  const size_t record = static_cast<size_t>(position_++);
+
+  SDR &output = getOutput("dataOut")->getData().getSDR();
+  scratch_.assign(sparse_.begin() + sparseBegin_[record], sparse_.begin() + sparseBegin_[record + 1u]);
+  output.setSparse(scratch_); // swaps, the previous buffer comes back
+
+  if (valueCount_ > 0u) {
+    Real64 *values = reinterpret_cast<Real64 *>(getOutput("values")->getData().getBuffer());
+    std::copy(values_.begin() + record * valueCount_, values_.begin() + (record + 1u) * valueCount_, values);
+  }
+}
+
+
+UInt64 ReplayRegion::getParameterUInt64(const std::string &name, Int64 index) {
+  if (name == "position") return position_;
+  else return RegionImpl::getParameterUInt64(name, index);
+}
+
+bool ReplayRegion::getParameterBool(const std::string &name, Int64 index) {
+  if (name == "loop") return loop_;
+  else return RegionImpl::getParameterBool(name, index);
+}
+
+void ReplayRegion::setParameterBool(const std::string &name, Int64 index, bool value) {
+  if (name == "loop") loop_ = value;
+  else RegionImpl::setParameterBool(name, index, value);
+}
+
+std::string ReplayRegion::getParameterString(const std::string &name, Int64 index) {
+  if (name == "file")             return file_;
+  else if (name == "source")      return source_;
+  else if (name == "dataOutput")  return dataOutput_;
+  else if (name == "valueOutput") return valueOutput_;
+  else return RegionImpl::getParameterString(name, index);
+}
+
+bool ReplayRegion::operator==(const RegionImpl &other) const {
+  if (other.getType() != "ReplayRegion") return false;
+  const ReplayRegion &o = reinterpret_cast<const ReplayRegion&>(other);
+  return file_ == o.file_ && source_ == o.source_ && dataOutput_ == o.dataOutput_ &&
+         valueOutput_ == o.valueOutput_ && loop_ == o.loop_ && position_ == o.position_ &&
+         dim_ == o.dim_;
+}
+
+
+} // namespace htm
@@ -0,0 +1,130 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ReplayRegion class
+ */
+
+#ifndef NTA_REPLAY_REGION_HPP
+#define NTA_REPLAY_REGION_HPP
+
+#include <string>
+#include <vector>
+
+#include <htm/engine/RegionImpl.hpp>
+#include <htm/ntypes/Value.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Serializable.hpp>
+
+namespace htm {
+
+/**
+ * A region which replays the outputs of a source region recorded by a
+ * binary Watcher, see Watcher::watchSources().
+ *
+ * @b Description
+ * It stands in for the recorded region "source" of the log "file", so a
+ * Network runs on exactly the recorded workload, eg. to benchmark a new
+ * release on production traffic which can not leave its site.  The whole
+ * log is read when the region is created, a compute only copies the next
+ * record into the outputs:
+ *   dataOut - the recorded output "dataOutput" of the source, an SDR.  By
+ *             default the first output recorded as sparse indices (SDRs).
+ *   values  - the recorded output "valueOutput", as Real64.  By default the
+ *             first output recorded as raw elements (eg. the bucket of an
+ *             encoder), empty if there is none.
+ * The "dim" parameter gives the dimensions of dataOut, by default 1-D of
+ * the recorded size.
+ *
+ * The records are replayed in the order of the iterations.  After the last
+ * one the replay starts over if "loop", else a compute throws.  The log
+ * must not be sampled.
+ */
+class ReplayRegion : public RegionImpl, Serializable {
+public:
+  ReplayRegion(const ValueMap &params, Region *region);
+  ReplayRegion(ArWrapper &wrapper, Region *region);
+
+  virtual ~ReplayRegion() override;
+
+  static Spec *createSpec();
+
+  virtual UInt64 getParameterUInt64(const std::string &name, Int64 index = -1) override;
+  virtual bool getParameterBool(const std::string &name, Int64 index = -1) override;
+  virtual void setParameterBool(const std::string &name, Int64 index, bool value) override;
+  virtual std::string getParameterString(const std::string &name, Int64 index = -1) override;
+  virtual void initialize() override;
+
+  Dimensions askImplForOutputDimensions(const std::string &name) override;
+
+  void compute() override;
+
+  // The number of records in the log.
+  size_t size() const { return sparseBegin_.size() - 1u; }
+
+  CerealAdapter;  // see Serializable.hpp
+  // FOR Cereal Serialization
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(CEREAL_NVP(file_));
+    ar(CEREAL_NVP(source_));
+    ar(CEREAL_NVP(dataOutput_));
+    ar(CEREAL_NVP(valueOutput_));
+    ar(CEREAL_NVP(loop_));
+    ar(CEREAL_NVP(position_));
+    ar(CEREAL_NVP(dim_));  // in base class
+  }
+  // FOR Cereal Deserialization
+  // Reads the log again.
+  template<class Archive>
+  void load_ar(Archive& ar) {
+    ar(CEREAL_NVP(file_));
+    ar(CEREAL_NVP(source_));
+    ar(CEREAL_NVP(dataOutput_));
+    ar(CEREAL_NVP(valueOutput_));
+    ar(CEREAL_NVP(loop_));
+    ar(CEREAL_NVP(position_));
+    ar(CEREAL_NVP(dim_));  // in base class
+    load_();
+  }
+
+  bool operator==(const RegionImpl &other) const override;
+  inline bool operator!=(const ReplayRegion &other) const {
+    return !operator==(other);
+  }
+
+private:
+  void load_();
+
+  std::string file_;
+  std::string source_;
+  std::string dataOutput_;
+  std::string valueOutput_;
+  bool loop_;
+  UInt64 position_ = 0u; // the next record
+
+  // The records, read from the file.
+  UInt32 dataSize_ = 0u;
+  std::vector<UInt32> sparse_;     // the indices of all records
+  std::vector<size_t> sparseBegin_ = {0u}; // record i is [begin[i], begin[i+1])
+  UInt32 valueCount_ = 0u;
+  std::vector<Real64> values_;     // valueCount_ per record
+  SDR_sparse_t scratch_;
+};
+} // namespace htm
+
+#endif // NTA_REPLAY_REGION_HPP
@@ -16,6 +16,7 @@
  *
  * Author: David Keeney, April 2018
  * --------------------------------------------------------------------- */
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -59,6 +60,9 @@ SPRegion::SPRegion(const ValueMap &values, Region *region)
   args_.spVerbosity = values.getScalarT<UInt32>("spVerbosity", 0);
   args_.wrapAround = values.getScalarT<bool>("wrapAround", true);
   spatialImp_ = values.getString("spatialImp", "");
+  sharedModel_ = values.getString("sharedModel", "");
+  numThreads_ = values.getScalarT<UInt32>("numThreads", 0u);
+  algorithmStats_ = values.getScalarT<bool>("algorithmStats", false);
 
   // variables used by this class and not passed on to the SpatialPooler class
   args_.learningMode = (1 == values.getScalarT<UInt32>("learningMode", true));
@@ -101,7 +105,7 @@ void SPRegion::initialize() {
   // concatination of all incomming buffers.  
   std::shared_ptr<Input> in = getInput("bottomUpIn");
   NTA_CHECK(in != nullptr);
-  if (!in->hasIncomingLinks())
+  if (!in->hasIncomingLinks() && !in->isBound())
      NTA_THROW << "SPRegion::initialize - No input links were configured for this SP region.\n";
   Array &inputBuffer = in->getData();
   NTA_CHECK(inputBuffer.getType() == NTA_BasicType_SDR);
@@ -131,6 +135,18 @@ void SPRegion::initialize() {
   if (args_.potentialRadius == 0)
     args_.potentialRadius = args_.inputWidth;
 
+  if (!sharedModel_.empty()) {
+    // Inference only, with the frozen model shared under that name.
+    frozen_ = FrozenSpatialPooler::shared(sharedModel_);
+    NTA_CHECK(frozen_->getNumInputs() == args_.inputWidth)
+        << "SPRegion::initialize - The shared model '" << sharedModel_ << "' has "
+        << frozen_->getNumInputs() << " inputs, the region " << args_.inputWidth << ".";
+    NTA_CHECK(frozen_->getNumColumns() == columnCount)
+        << "SPRegion::initialize - The shared model '" << sharedModel_ << "' has "
+        << frozen_->getNumColumns() << " columns, the region " << columnCount << ".";
+    return;
+  }
+
   // instantiate a SpatialPooler.
   sp_ = std::unique_ptr<SpatialPooler>( new SpatialPooler(
       inputDimensions, columnDimensions, args_.potentialRadius,
@@ -139,29 +155,61 @@ void SPRegion::initialize() {
       args_.synPermInactiveDec, args_.synPermActiveInc, args_.synPermConnected,
       args_.minPctOverlapDutyCycles, args_.dutyCyclePeriod, args_.boostStrength,
       args_.seed, args_.spVerbosity, args_.wrapAround));
+  applyNumThreads_();
+  sp_->getStats().enable(algorithmStats_);
+}
+
+void SPRegion::setThreadBudget(UInt numThreads) {
+  threadBudget_ = numThreads;
+  applyNumThreads_();
+}
+
+void SPRegion::applyNumThreads_() {
+  const UInt numThreads = numThreads_ != 0u ? numThreads_ : threadBudget_;
+  if (sp_ && sp_->getNumThreads() != numThreads)
+    sp_->setNumThreads(numThreads);
 }
 
 
 
 void SPRegion::compute() {
-  NTA_ASSERT(sp_) << "SP not initialized";
+  NTA_ASSERT(sp_ || frozen_) << "SP not initialized";
 
   if (computeCallback_ != nullptr)
     computeCallback_(getName());
 
 
   // prepare the input
-  Array &inputBuffer  = getInput("bottomUpIn")->getData();
-  Array &outputBuffer = getOutput("bottomUpOut")->getData();
-  NTA_DEBUG  << "compute " << *getInput("bottomUpIn") << "\n";
+  Array &inputBuffer  = bottomUpIn_->getData();
+  Array &outputBuffer = bottomUpOut_->getData();
+  NTA_DEBUG  << "compute " << *bottomUpIn_ << "\n";
 
 
+  if (frozen_) {
+    frozen_->compute(inputBuffer.getSDR(), outputBuffer.getSDR(), scratch_);
+    return;
+  }
+
   // Call SpatialPooler compute
-  sp_->compute(inputBuffer.getSDR(), args_.learningMode, outputBuffer.getSDR());
+  const bool learn = args_.learningMode && shedLevel_ < Shed_Learning;
+  sp_->compute(inputBuffer.getSDR(), learn, outputBuffer.getSDR());
 
   // trace facility
-  NTA_DEBUG << "compute " << *getOutput("bottomUpOut") << "\n";
+  NTA_DEBUG << "compute " << *bottomUpOut_ << "\n";
+
+}
 
+UInt SPRegion::setShedLevel(UInt level) {
+  // The SP has no optional outputs.
+  shedLevel_ = level >= Shed_Learning ? Shed_Learning : std::min<UInt>(level, Shed_Maintenance);
+  if (sp_)
+    sp_->holdMaintenance(shedLevel_ >= Shed_Maintenance);
+  return shedLevel_;
+}
+
+void SPRegion::bindPorts() {
+  bottomUpIn_  = bindInput("bottomUpIn");
+  bottomUpOut_ = bindOutput("bottomUpOut");
 }
 
 std::string SPRegion::executeCommand(const std::vector<std::string> &args,Int64 index) {
@@ -482,6 +530,18 @@ Spec *SPRegion::createSpec() {
           "true",             // defaultValue
           ParameterSpec::ReadWriteAccess)); // access
 
+  ns->parameters.add(
+      "numThreads",
+      ParameterSpec("(uint)\n"
+          "Number of threads for the overlaps, including the calling thread. "
+          "Default ``0``, the thread budget given by the Network, "
+          "see Network::setThreadBudget(). Not serialized.",
+          NTA_BasicType_UInt32,             // type
+          1,                                // elementCount
+          "",                               // constraints
+          "0",                              // defaultValue
+          ParameterSpec::ReadWriteAccess)); // access
+
   /* ---- other parameters ----- */
   ns->parameters.add(
       "spInputNonZeros",
@@ -531,6 +591,35 @@ Spec *SPRegion::createSpec() {
           "",                              // defaultValue
           ParameterSpec::ReadOnlyAccess)); // access
 
+  ns->parameters.add("sharedModel",
+      ParameterSpec("Name of a FrozenSpatialPooler shared with FrozenSpatialPooler::share(). "
+          "If set, the region does not create a SpatialPooler, it computes (without "
+          "learning) with the shared model, which must match the input and the columnCount. "
+          "Only the name is serialized.",
+          NTA_BasicType_Byte,              // type
+          0,                               // elementCount
+          "",                              // constraints
+          "",                              // defaultValue
+          ParameterSpec::CreateAccess));   // access
+
+  ns->parameters.add("algorithmStats",
+      ParameterSpec("(bool) Collect the stage timers and event counters of the "
+          "SpatialPooler, see algorithmStatsReport. Default false. Not serialized.",
+          NTA_BasicType_Bool,              // type
+          1,                               // elementCount
+          "bool",                          // constraints
+          "false",                         // defaultValue
+          ParameterSpec::ReadWriteAccess)); // access
+
+  ns->parameters.add("algorithmStatsReport",
+      ParameterSpec("JSON of the stage timers and event counters of the SpatialPooler, "
+          "see SpatialPooler::getStats().",
+          NTA_BasicType_Byte,              // type
+          0,                               // elementCount
+          "",                              // constraints
+          "",                              // defaultValue
+          ParameterSpec::ReadOnlyAccess)); // access
+
   /* ----- inputs ------- */
   ns->inputs.add(
       "bottomUpIn",
@@ -615,6 +704,9 @@ UInt32 SPRegion::getParameterUInt32(const std::string &name, Int64 index) {
       else
         return args_.numActiveColumnsPerInhArea;
     }
+    if (name == "numThreads") {
+      return numThreads_;
+    }
     break;
   case 'p':
     if (name == "potentialRadius") {
@@ -726,6 +818,9 @@ bool SPRegion::getParameterBool(const std::string &name, Int64 index) {
     else
       return args_.wrapAround;
   }
+  if (name == "algorithmStats") {
+    return algorithmStats_;
+  }
   return this->RegionImpl::getParameterBool(name, index); // default
 }
 
@@ -765,6 +860,12 @@ std::string SPRegion::getParameterString(const std::string &name, Int64 index) {
   if (name == "spatialImp") {
     return spatialImp_;
   }
+  if (name == "sharedModel") {
+    return sharedModel_;
+  }
+  if (name == "algorithmStatsReport") {
+    return sp_ ? sp_->getStats().toJSON() : "{}";
+  }
   // "spLearningStatsStr"  not found
   return this->RegionImpl::getParameterString(name, index);
 }
@@ -793,6 +894,11 @@ void SPRegion::setParameterUInt32(const std::string &name, Int64 index,
       args_.numActiveColumnsPerInhArea = value;
       return;
     }
+    if (name == "numThreads") {
+      numThreads_ = value;
+      applyNumThreads_();
+      return;
+    }
     break;
   case 'p':
     if (name == "potentialRadius") {
@@ -900,10 +1006,97 @@ void SPRegion::setParameterBool(const std::string &name, Int64 index, bool value
     args_.wrapAround = value;
     return;
   }
+  if (name == "algorithmStats") {
+    if (sp_)
+      sp_->getStats().enable(value);
+    algorithmStats_ = value;
+    return;
+  }
 
   RegionImpl::setParameterBool(name, index, value);
 }
 
+// The parameters which are set often, for Region::getParameterHandle().
+enum SPParameterId { SP_learningMode, SP_boostStrength, SP_localAreaDensity,
+                     SP_synPermActiveInc, SP_synPermInactiveDec, SP_stimulusThreshold };
+
+Int32 SPRegion::resolveParameter(const std::string &name) const {
+  if (name == "learningMode") return SP_learningMode;
+  if (name == "boostStrength") return SP_boostStrength;
+  if (name == "localAreaDensity") return SP_localAreaDensity;
+  if (name == "synPermActiveInc") return SP_synPermActiveInc;
+  if (name == "synPermInactiveDec") return SP_synPermInactiveDec;
+  if (name == "stimulusThreshold") return SP_stimulusThreshold;
+  return -1;
+}
+
+bool SPRegion::getParameterById(Int32 id, NTA_BasicType type, void *value) {
+  if (type == NTA_BasicType_Real32) {
+    Real32 &v = *reinterpret_cast<Real32 *>(value);
+    switch (id) {
+    case SP_boostStrength:
+      v = sp_ ? sp_->getBoostStrength() : args_.boostStrength;
+      return true;
+    case SP_localAreaDensity:
+      v = sp_ ? sp_->getLocalAreaDensity() : args_.localAreaDensity;
+      return true;
+    case SP_synPermActiveInc:
+      v = sp_ ? sp_->getSynPermActiveInc() : args_.synPermActiveInc;
+      return true;
+    case SP_synPermInactiveDec:
+      v = sp_ ? sp_->getSynPermInactiveDec() : args_.synPermInactiveDec;
+      return true;
+    }
+  } else if (type == NTA_BasicType_UInt32) {
+    UInt32 &v = *reinterpret_cast<UInt32 *>(value);
+    switch (id) {
+    case SP_learningMode:
+      v = args_.learningMode;
+      return true;
+    case SP_stimulusThreshold:
+      v = sp_ ? sp_->getStimulusThreshold() : args_.stimulusThreshold;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool SPRegion::setParameterById(Int32 id, NTA_BasicType type, const void *value) {
+  if (type == NTA_BasicType_Real32) {
+    const Real32 v = *reinterpret_cast<const Real32 *>(value);
+    switch (id) {
+    case SP_boostStrength:
+      if (sp_) sp_->setBoostStrength(v);
+      args_.boostStrength = v;
+      return true;
+    case SP_localAreaDensity:
+      if (sp_) sp_->setLocalAreaDensity(v);
+      args_.localAreaDensity = v;
+      return true;
+    case SP_synPermActiveInc:
+      if (sp_) sp_->setSynPermActiveInc(v);
+      args_.synPermActiveInc = v;
+      return true;
+    case SP_synPermInactiveDec:
+      if (sp_) sp_->setSynPermInactiveDec(v);
+      args_.synPermInactiveDec = v;
+      return true;
+    }
+  } else if (type == NTA_BasicType_UInt32) {
+    const UInt32 v = *reinterpret_cast<const UInt32 *>(value);
+    switch (id) {
+    case SP_learningMode:
+      args_.learningMode = (v != 0);
+      return true;
+    case SP_stimulusThreshold:
+      if (sp_) sp_->setStimulusThreshold(v);
+      args_.stimulusThreshold = v;
+      return true;
+    }
+  }
+  return false;
+}
+
 
 
 bool SPRegion::operator==(const RegionImpl &o) const {
@@ -927,6 +1120,7 @@ bool SPRegion::operator==(const RegionImpl &o) const {
   if (args_.spVerbosity != other.args_.spVerbosity) return false;
   if (args_.wrapAround != other.args_.wrapAround) return false;
   if (args_.learningMode != other.args_.learningMode) return false;
+  if (sharedModel_ != other.sharedModel_) return false;
 
   if (dim_ != other.dim_) return false;  // from RegionImpl
   if ((sp_ && !other.sp_) || (other.sp_ && !sp_)) return false;
@@ -29,6 +29,7 @@
 #include <memory> //unique_ptr
 
 #include <htm/engine/RegionImpl.hpp>
+#include <htm/algorithms/FrozenSpatialPooler.hpp>
 #include <htm/algorithms/SpatialPooler.hpp>
 #include <htm/ntypes/Value.hpp>
 //----------------------------------------------------------------------
@@ -56,6 +57,7 @@ class SPRegion  : public RegionImpl, Serializable
 
     // Compute outputs from inputs and internal state
     void compute() override;
+    void bindPorts() override;
     std::string executeCommand(const std::vector<std::string>& args, Int64 index) override;
 
     /**
@@ -87,6 +89,7 @@ class SPRegion  : public RegionImpl, Serializable
 	    ar(cereal::make_nvp("spVerbosity", args_.spVerbosity));
 	    ar(cereal::make_nvp("wrapAround", args_.wrapAround));
 	    ar(cereal::make_nvp("learningMode", args_.learningMode));
+	    ar(cereal::make_nvp("sharedModel", sharedModel_));
 	    ar(cereal::make_nvp("init", init));
 	    if (init) {
         // Save the algorithm state
@@ -116,7 +119,12 @@ class SPRegion  : public RegionImpl, Serializable
 	    ar(cereal::make_nvp("spVerbosity", args_.spVerbosity));
 	    ar(cereal::make_nvp("wrapAround", args_.wrapAround));
 	    ar(cereal::make_nvp("learningMode", args_.learningMode));
+	    ar(cereal::make_nvp("sharedModel", sharedModel_));
 	    ar(cereal::make_nvp("init", init));
+	    if (!sharedModel_.empty()) {
+	      // Only the name is saved, the model must be shared again before loading.
+	      frozen_ = FrozenSpatialPooler::shared(sharedModel_);
+	    }
 	    if (init) {
 	      // Restore algorithm state
 	      SpatialPooler* sp = new SpatialPooler();
@@ -155,6 +163,20 @@ class SPRegion  : public RegionImpl, Serializable
     void setParameterReal32(const std::string& name, Int64 index, Real32 value) override;
     void setParameterBool(const std::string& name, Int64 index, bool value) override;
 
+    Int32 resolveParameter(const std::string &name) const override;
+    bool getParameterById(Int32 id, NTA_BasicType type, void *value) override;
+    bool setParameterById(Int32 id, NTA_BasicType type, const void *value) override;
+
+    void setThreadBudget(UInt numThreads) override;
+
+    // A shared model is not counted, it is not owned by the region.
+    size_t memoryUsage() const override { return sp_ ? sp_->memoryUsage() : 0u; }
+    void reduceMemoryUsage() override { if (sp_) sp_->releaseCaches(); }
+    UInt setShedLevel(UInt level) override;
+    std::vector<const Connections *> getConnections() const override {
+      return sp_ ? std::vector<const Connections *>{&sp_->connections} : std::vector<const Connections *>();
+    }
+
 	
 private:
     SPRegion() = delete;  // empty constructor not allowed
@@ -188,6 +210,27 @@ private:
 
     std::unique_ptr<SpatialPooler> sp_;
 
+    // Set instead of sp_ by the parameter "sharedModel": the frozen model,
+    // owned by the registry and the other regions using it.
+    std::string sharedModel_;
+    std::shared_ptr<const FrozenSpatialPooler> frozen_;
+    FrozenSpatialPooler::Scratch scratch_;   // not serialized
+
+    // The ports of compute(), @see bindPorts().
+    Input  *bottomUpIn_  = nullptr;
+    Output *bottomUpOut_ = nullptr;
+
+    // Set by Network::runWithDeadline(), not serialized.
+    UInt shedLevel_ = Shed_None;
+
+    // Threads of the SP, not serialized.  0 uses the thread budget.
+    UInt32 numThreads_ = 0u;
+    UInt32 threadBudget_ = 1u;
+    void applyNumThreads_();
+
+    // SpatialPooler::getStats() is enabled, not serialized.
+    bool algorithmStats_ = false;
+
 };
 } // namespace htm
 
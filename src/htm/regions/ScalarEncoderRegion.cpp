@@ -44,6 +44,8 @@ ScalarEncoderRegion::ScalarEncoderRegion(const ValueMap &params, Region *region)
 
   encoder_ = std::make_shared<ScalarEncoder>( params_ );
 
+  channels_ = params.getScalarT<UInt32>("channels", 1u);
+  NTA_CHECK(channels_ > 0u) << "ScalarEncoderRegion: channels must be > 0";
 
   sensedValue_ = params.getScalarT<Real64>("sensedValue", -1.0);
 }
@@ -75,7 +77,7 @@ Dimensions ScalarEncoderRegion::askImplForOutputDimensions(const std::string &na
     encoder_->initialize(params_); 
 
     // get the dimensions determined by the encoder.
-    Dimensions encDim(encoder_->dimensions); // get dimensions from encoder
+    Dimensions encDim = encodedDimensions_();
     Dimensions regionDim = getDimensions();  // get the region level dimensions.
     if (regionDim.isSpecified()) {
       // region level dimensions were explicitly specified.
@@ -88,12 +90,24 @@ Dimensions ScalarEncoderRegion::askImplForOutputDimensions(const std::string &na
     return encDim;
   } 
   else if (name == "bucket") {
-    return 1;
+    return Dimensions(channels_);
   }
   // for any other output name, let RegionImpl handle it.
   return RegionImpl::askImplForOutputDimensions(name);
 }
 
+Dimensions ScalarEncoderRegion::askImplForInputDimensions(const std::string &name) {
+  if (name == "values")
+    return Dimensions(channels_);
+  return RegionImpl::askImplForInputDimensions(name);
+}
+
+Dimensions ScalarEncoderRegion::encodedDimensions_() const {
+  if (channels_ == 1u)
+    return Dimensions(encoder_->dimensions);
+  return Dimensions(channels_ * encoder_->size);
+}
+
 std::string ScalarEncoderRegion::executeCommand(const std::vector<std::string> &args,
                                          Int64 index) {
   NTA_THROW << "ScalarEncoderRegion::executeCommand -- commands not supported";
@@ -101,15 +115,31 @@ std::string ScalarEncoderRegion::executeCommand(const std::vector<std::string> &
 
 void ScalarEncoderRegion::compute()
 {
+  SDR &output = getOutput("encoded")->getData().getSDR();
+  // create the quantized sample or bucket. This becomes the title in the ClassifierRegion.
+  Real64 *quantizedSample = (Real64*)getOutput("bucket")->getData().getBuffer();
+
+  if (channels_ > 1u) {
+    NTA_CHECK(hasInput("values"))
+        << "ScalarEncoderRegion: the input 'values' must be linked to encode " << channels_
+        << " channels";
+    const Real64 *values = (const Real64 *)getInput("values")->getData().getBuffer();
+    // Each channel appends its bits at its offset, so the indices stay sorted.
+    sparse_.clear();
+    for (UInt32 c = 0u; c < channels_; c++) {
+      encoder_->encodeSparse(values[c], c * encoder_->size, sparse_);
+      quantizedSample[c] = values[c] - std::fmod(values[c], encoder_->parameters.radius);
+    }
+    output.setSparse(sparse_);
+    NTA_DEBUG << "compute " << getOutput("encoded") << std::endl;
+    return;
+  }
+
   if (hasInput("values")) {
     Array &a = getInput("values")->getData();
     sensedValue_ = ((Real64 *)(a.getBuffer()))[0];
   }
-  SDR &output = getOutput("encoded")->getData().getSDR();
   encoder_->encode((Real64)sensedValue_, output);
-
-  // create the quantized sample or bucket. This becomes the title in the ClassifierRegion.
-  Real64 *quantizedSample = (Real64*)getOutput("bucket")->getData().getBuffer();
   quantizedSample[0] = sensedValue_ - std::fmod(sensedValue_, encoder_->parameters.radius);
 
   // trace facility
@@ -197,6 +227,15 @@ ScalarEncoderRegion::~ScalarEncoderRegion() {}
                                    "false", // defaultValue
                                    ParameterSpec::CreateAccess));
 
+  ns->parameters.add("channels",
+                     ParameterSpec("The number of values in the 'values' input, each encoded "
+                                   "with these parameters into its own part of the output.",
+                                   NTA_BasicType_UInt32,
+                                   1,   // elementCount
+                                   "",  // constraints
+                                   "1", // defaultValue
+                                   ParameterSpec::CreateAccess));
+
   ns->parameters.add("clipInput",
                     ParameterSpec(
                                   "Whether to clip inputs if they're outside [minValue, maxValue]",
@@ -208,9 +247,9 @@ ScalarEncoderRegion::~ScalarEncoderRegion() {}
 
    /* ----- inputs ------- */
   ns->inputs.add("values",
-                 InputSpec("The input values to be encoded.", // description
+                 InputSpec("The input values to be encoded, one per channel.", // description
                            NTA_BasicType_Real64,   // type
-                           1,                   // count.
+                           0,                   // count, the number of channels
                            false,                // required?
                            false,               // isRegionLevel,
                            true                 // isDefaultInput
@@ -224,9 +263,9 @@ ScalarEncoderRegion::~ScalarEncoderRegion() {}
                                         true  // isDefaultOutput
                                         ));
 
-  ns->outputs.add("bucket", OutputSpec("Quantized sensedValue for this iteration.  Becomres the title in ClassifierRegion.",
+  ns->outputs.add("bucket", OutputSpec("Quantized sensedValue for this iteration, one per channel.  Becomres the title in ClassifierRegion.",
                                        NTA_BasicType_Real64,
-                                       1,    // elementCount
+                                       0,    // elementCount, the number of channels
                                        false, // isRegionLevel
                                        false // isDefaultOutput
                                        ));
@@ -265,6 +304,8 @@ UInt32 ScalarEncoderRegion::getParameterUInt32(const std::string &name, Int64 in
   }
   else if (name == "w" || name == "activeBits") {
     return encoder_->parameters.activeBits;
+  } else if (name == "channels") {
+    return channels_;
   } else {
     return RegionImpl::getParameterUInt32(name, index);
   }
@@ -292,6 +333,7 @@ bool ScalarEncoderRegion::operator==(const RegionImpl &o) const {
   if (params_.radius != other.params_.radius) return false;
   if (params_.resolution != other.params_.resolution) return false;
   if (sensedValue_ != other.sensedValue_) return false;
+  if (channels_ != other.channels_) return false;
 
   return true;
 }
@@ -40,6 +40,10 @@ namespace htm {
  * API. As a network runs, the client will specify new encoder inputs by
  * setting the "sensedValue" parameter. On each compute, the ScalarEncoderRegion will
  * encode its "sensedValue" to output.
+ *
+ * With channels > 1 the "values" input is a vector of that many values.  All
+ * of them are encoded with the same parameters into one SDR, channel c at the
+ * offset c * size, and "bucket" holds one quantized value per channel.
  */
 class ScalarEncoderRegion : public RegionImpl, Serializable {
 public:
@@ -61,12 +65,15 @@ public:
                                      Int64 index) override;
 
   virtual Dimensions askImplForOutputDimensions(const std::string &name) override;
+  virtual Dimensions askImplForInputDimensions(const std::string &name) override;
 
   CerealAdapter;  // see Serializable.hpp
   // FOR Cereal Serialization
   template<class Archive>
   void save_ar(Archive& ar) const {
+    saveArchiveVersion(ar, realArchiveMarker(), ARCHIVE_VERSION);
     ar(CEREAL_NVP(sensedValue_));
+    ar(CEREAL_NVP(channels_));
     ar(cereal::make_nvp("minimum", params_.minimum),
        cereal::make_nvp("maximum", params_.maximum),
        cereal::make_nvp("clipInput", params_.clipInput),
@@ -85,7 +92,13 @@ public:
   //       the region_ field in the Base class.
   template<class Archive>
   void load_ar(Archive& ar) {
-    ar(CEREAL_NVP(sensedValue_));
+    const UInt32 version = loadArchiveVersion(ar, "sensedValue_", sensedValue_, realArchiveMarker(), 1u);
+    NTA_CHECK(version <= ARCHIVE_VERSION) << "Unknown archive version " << version;
+    if (version >= 2u) {
+      ar(CEREAL_NVP(channels_));
+    } else {
+      channels_ = 1u; // archived before the channels
+    }
     ar(cereal::make_nvp("minimum", params_.minimum),
        cereal::make_nvp("maximum", params_.maximum),
        cereal::make_nvp("clipInput", params_.clipInput),
@@ -97,7 +110,7 @@ public:
        cereal::make_nvp("resolution", params_.resolution),
        cereal::make_nvp("sensedValue_", sensedValue_));
     encoder_ = std::make_shared<ScalarEncoder>( params_ );
-    setDimensions(encoder_->dimensions); 
+    setDimensions(encodedDimensions_());
   }
 
 
@@ -107,7 +120,14 @@ public:
   }
 
 private:
+  // Version 2 added the channels, version 1 is the unversioned layout.
+  static const UInt32 ARCHIVE_VERSION = 2u;
+
+  Dimensions encodedDimensions_() const;
+
   Real64 sensedValue_;
+  UInt32 channels_ = 1u;  // the number of values encoded side by side
+  SDR_sparse_t sparse_;   // scratch for the encoding of all channels
   ScalarEncoderParameters params_;
 
   std::shared_ptr<ScalarEncoder> encoder_;
@@ -16,6 +16,7 @@
  *
  * Author: David Keeney, June 2018
  * --------------------------------------------------------------------- */
+#include <algorithm>
 #include <fstream>
 #include <iomanip> // setprecision() in stream
 #include <iostream>
@@ -61,6 +62,8 @@ TMRegion::TMRegion(const ValueMap &params, Region *region)
 
   // variables used by this class and not passed on
   args_.learningMode = params.getScalarT<bool>("learningMode", true);
+  numThreads_ = params.getScalarT<UInt32>("numThreads", 0u);
+  algorithmStats_ = params.getScalarT<bool>("algorithmStats", false);
 
   args_.iter = 0;
   args_.sequencePos = 0;
@@ -129,7 +132,7 @@ void TMRegion::initialize() {
   // concatination of all incomming buffers. This width sets the number
   // columns for the TM.
   std::shared_ptr<Input> in = region_->getInput("bottomUpIn");
-  if (!in || !in->hasIncomingLinks())
+  if (!in || !(in->hasIncomingLinks() || in->isBound()))
       NTA_THROW << "TMRegion::initialize - No input was provided.\n";
   NTA_ASSERT(in->getData().getType() == NTA_BasicType_SDR);
 
@@ -173,12 +176,27 @@ void TMRegion::initialize() {
       args_.predictedSegmentDecrement, args_.seed, args_.maxSegmentsPerCell,
       args_.maxSynapsesPerSegment, args_.checkInputs, args_.externalPredictiveInputs);
   tm_.reset(tm);
+  applyNumThreads_();
+  tm_->getStats().enable(algorithmStats_);
 
   args_.iter = 0;
   args_.sequencePos = 0;
 }
 
 
+void TMRegion::setThreadBudget(UInt numThreads) {
+  threadBudget_ = numThreads;
+  applyNumThreads_();
+}
+
+
+void TMRegion::applyNumThreads_() {
+  const UInt numThreads = numThreads_ != 0u ? numThreads_ : threadBudget_;
+  if (tm_ && tm_->getNumThreads() != numThreads)
+    tm_->setNumThreads(numThreads);
+}
+
+
 void TMRegion::compute() {
 
   NTA_ASSERT(tm_) << "TM not initialized";
@@ -188,8 +206,8 @@ void TMRegion::compute() {
   args_.iter++;
 
   // Handle reset signal
-  if (getInput("resetIn")->hasIncomingLinks()) {
-    Array &reset = getInput("resetIn")->getData();
+  if (resetIn_->hasIncomingLinks() || resetIn_->isBound()) {
+    Array &reset = resetIn_->getData();
     NTA_ASSERT(reset.getType() == NTA_BasicType_Real32);
     if (reset.getCount() == 1 && ((Real32 *)(reset.getBuffer()))[0] != 0) {
       tm_->reset();
@@ -199,17 +217,17 @@ void TMRegion::compute() {
 
   // Check the input buffer
   // The buffer width is the number of columns.
-  std::shared_ptr<Input> in = getInput("bottomUpIn");
+  Input *in = bottomUpIn_;
   Array &bottomUpIn = in->getData();
   NTA_ASSERT(bottomUpIn.getType() == NTA_BasicType_SDR);
   SDR& activeColumns = bottomUpIn.getSDR();
 
   // Check for 'externalPredictiveInputs' inputs
   static SDR nullSDR({0});
-  Array &externalPredictiveInputsActive = getInput("externalPredictiveInputsActive")->getData();
+  Array &externalPredictiveInputsActive = externalPredictiveInputsActive_->getData();
   SDR& externalPredictiveInputsActiveCells = (args_.externalPredictiveInputs) ? (externalPredictiveInputsActive.getSDR()) : nullSDR;
 
-  Array &externalPredictiveInputsWinners = getInput("externalPredictiveInputsWinners")->getData();
+  Array &externalPredictiveInputsWinners = externalPredictiveInputsWinners_->getData();
   SDR& externalPredictiveInputsWinnerCells = (args_.externalPredictiveInputs) ? (externalPredictiveInputsWinners.getSDR()) : nullSDR;
 
   // Trace facility
@@ -217,7 +235,8 @@ void TMRegion::compute() {
 
   // Perform Bottom up compute()
 
-  tm_->compute(activeColumns, args_.learningMode, externalPredictiveInputsActiveCells, externalPredictiveInputsWinnerCells);
+  const bool learn = args_.learningMode && shedLevel_ < Shed_Learning;
+  tm_->compute(activeColumns, learn, externalPredictiveInputsActiveCells, externalPredictiveInputsWinnerCells);
 
   args_.sequencePos++;
 
@@ -232,11 +251,57 @@ void TMRegion::compute() {
   //       - The total number of elements in the outputs must be
   //         numberOfCols * cellsPerColumn unless args_.orColumnOutputs is set.
   //
-  std::shared_ptr<Output> out;
-  out = getOutput("bottomUpOut");
-    //call Network::setLogLevel(LogLevel::LogLevel_Verbose);
-    //     to output the NTA_DEBUG statements below
-    
+  // Outputs without links are skipped, nobody reads them unless they are
+  // asked for with Region::getOutputData().  The anomaly score is cheap.
+  skipped_.clear();
+  produceOrSkip_(bottomUpOut_);
+  produceOrSkip_(activeCells_);
+  produceOrSkip_(predictedActiveCells_);
+
+  Real32* buffer = reinterpret_cast<Real32*>(anomaly_->getData().getBuffer());
+  buffer[0] = tm_->anomaly; //only the first field is valid
+  NTA_DEBUG << "compute "<< *anomaly_ << std::endl;
+
+  // The predictions are optional.  Shed, they are produced on demand and the
+  // linked inputs keep the previous ones; the next compute() activates the
+  // dendrites anyway.
+  if (shedLevel_ >= Shed_Outputs) {
+    skipped_.push_back(predictiveCells_);
+  } else {
+    tm_->activateDendrites();
+    produceOrSkip_(predictiveCells_);
+  }
+}
+
+UInt TMRegion::setShedLevel(UInt level) {
+  shedLevel_ = std::min<UInt>(level, Shed_Learning);
+  if (tm_)
+    tm_->holdMaintenance(shedLevel_ >= Shed_Maintenance);
+  return shedLevel_;
+}
+
+void TMRegion::produceOrSkip_(Output *out) {
+  if (out->hasOutgoingLinks())
+    produce_(out);
+  else
+    skipped_.push_back(out);
+}
+
+void TMRegion::produceOutput(const std::string &name) {
+  for (auto it = skipped_.begin(); it != skipped_.end(); ++it) {
+    if ((*it)->getName() == name) {
+      Output *out = *it;
+      skipped_.erase(it);
+      produce_(out);
+      return;
+    }
+  }
+}
+
+void TMRegion::produce_(Output *out) {
+  //call Network::setLogLevel(LogLevel::LogLevel_Verbose);
+  //     to output the NTA_DEBUG statements below
+  if (out == bottomUpOut_) {
     // The dimensions should already be set on output buffers.
     std::vector<UInt> out_dims = out->getDimensions().asVector(); // column dimensions (eg 10x100), makes copy.
     if (args_.orColumnOutputs)                    // if we are outputing only columns, we expect one more dimension in active cells.
@@ -248,29 +313,31 @@ void TMRegion::compute() {
       out->getData().getSDR() = tm_->cellsToColumns(active);
     else
       out->getData().getSDR() = active;
-    NTA_DEBUG << "compute " << *out << std::endl;
-  
-  out = getOutput("activeCells");
+  } else if (out == activeCells_) {
     tm_->getActiveCells(out->getData().getSDR());
-    NTA_DEBUG << "compute "<< *out << std::endl;
-  
-  out = getOutput("predictedActiveCells");
-    tm_->activateDendrites();
+  } else if (out == predictedActiveCells_) {
     tm_->getWinnerCells(out->getData().getSDR());
-    NTA_DEBUG << "compute "<< *out << std::endl;
-  
-  out = getOutput("anomaly");
-    Real32* buffer = reinterpret_cast<Real32*>(out->getData().getBuffer());
-    buffer[0] = tm_->anomaly; //only the first field is valid
-    NTA_DEBUG << "compute "<< *out << std::endl;
-  
-  out = getOutput("predictiveCells");
-    SDR predictive = tm_->getPredictiveCells();
+  } else if (out == predictiveCells_) {
+    tm_->activateDendrites();
+    const SDR &predictive = tm_->getPredictiveCells();
     if (args_.orColumnOutputs)  // output as columns
       out->getData().getSDR() = tm_->cellsToColumns(predictive);
     else
       out->getData().getSDR() = predictive;
-    NTA_DEBUG << "compute " << *out << std::endl;
+  }
+  NTA_DEBUG << "compute " << *out << std::endl;
+}
+
+void TMRegion::bindPorts() {
+  resetIn_ = bindInput("resetIn");
+  bottomUpIn_ = bindInput("bottomUpIn");
+  externalPredictiveInputsActive_ = bindInput("externalPredictiveInputsActive");
+  externalPredictiveInputsWinners_ = bindInput("externalPredictiveInputsWinners");
+  bottomUpOut_ = bindOutput("bottomUpOut");
+  activeCells_ = bindOutput("activeCells");
+  predictedActiveCells_ = bindOutput("predictedActiveCells");
+  anomaly_ = bindOutput("anomaly");
+  predictiveCells_ = bindOutput("predictiveCells");
 }
 
 
@@ -481,6 +548,37 @@ Spec *TMRegion::createSpec() {
                     "false",             // defaultValue
                     ParameterSpec::CreateAccess)); // access
 
+  ns->parameters.add(
+      "numThreads",
+      ParameterSpec("(uint) Number of threads for the segment activity, including "
+                    "the calling thread. Default 0, the thread budget given by the "
+                    "Network, see Network::setThreadBudget(). Not serialized.",
+                    NTA_BasicType_UInt32,             // type
+                    1,                                // elementCount
+                    "",                               // constraints
+                    "0",                              // defaultValue
+                    ParameterSpec::ReadWriteAccess)); // access
+
+  ns->parameters.add(
+      "algorithmStats",
+      ParameterSpec("(bool) Collect the stage timers and event counters of the "
+                    "TemporalMemory, see algorithmStatsReport. Default false. Not serialized.",
+                    NTA_BasicType_Bool,               // type
+                    1,                                // elementCount
+                    "bool",                           // constraints
+                    "false",                          // defaultValue
+                    ParameterSpec::ReadWriteAccess)); // access
+
+  ns->parameters.add(
+      "algorithmStatsReport",
+      ParameterSpec("JSON of the stage timers and event counters of the TemporalMemory, "
+                    "see TemporalMemory::getStats().",
+                    NTA_BasicType_Byte,               // type
+                    0,                                // elementCount
+                    "",                               // constraints
+                    "",                               // defaultValue
+                    ParameterSpec::ReadOnlyAccess));  // access
+
 
   ///////////// Inputs and Outputs ////////////////
   /* ----- inputs ------- */
@@ -616,6 +714,9 @@ UInt32 TMRegion::getParameterUInt32(const std::string &name, Int64 index) {
     if (name == "activeOutputCount") {
       return args_.outputWidth;
     }
+    if (name == "numThreads") {
+      return numThreads_;
+    }
     if (name == "cellsPerColumn") {
       if (tm_)
         return (UInt32)tm_->getCellsPerColumn();
@@ -723,11 +824,16 @@ bool TMRegion::getParameterBool(const std::string &name, Int64 index) {
   if (name == "learningMode")
     return args_.learningMode;
 
+  if (name == "algorithmStats")
+    return algorithmStats_;
+
   return this->RegionImpl::getParameterBool(name, index); // default
 }
 
 
 std::string TMRegion::getParameterString(const std::string &name, Int64 index) {
+  if (name == "algorithmStatsReport")
+    return tm_ ? tm_->getStats().toJSON() : "{}";
   return this->RegionImpl::getParameterString(name, index);
 }
 
@@ -751,6 +857,11 @@ void TMRegion::setParameterUInt32(const std::string &name, Int64 index, UInt32 v
     args_.minThreshold = value;
     return;
   }
+  if (name == "numThreads") {
+    numThreads_ = value;
+    applyNumThreads_();
+    return;
+  }
   RegionImpl::setParameterUInt32(name, index, value);
 }
 
@@ -815,6 +926,12 @@ void TMRegion::setParameterBool(const std::string &name, Int64 index, bool value
     args_.learningMode = value;
     return;
   }
+  if (name == "algorithmStats") {
+    if (tm_)
+      tm_->getStats().enable(value);
+    algorithmStats_ = value;
+    return;
+  }
 
   RegionImpl::setParameterBool(name, index, value);
 }
@@ -826,6 +943,70 @@ void TMRegion::setParameterString(const std::string &name, Int64 index,
 }
 
 
+// The parameters which are set often, for Region::getParameterHandle().
+enum TMParameterId { TM_learningMode, TM_anomaly, TM_permanenceIncrement,
+                     TM_permanenceDecrement, TM_predictedSegmentDecrement };
+
+Int32 TMRegion::resolveParameter(const std::string &name) const {
+  if (name == "learningMode") return TM_learningMode;
+  if (name == "anomaly") return TM_anomaly;
+  if (name == "permanenceIncrement") return TM_permanenceIncrement;
+  if (name == "permanenceDecrement") return TM_permanenceDecrement;
+  if (name == "predictedSegmentDecrement") return TM_predictedSegmentDecrement;
+  return -1;
+}
+
+
+bool TMRegion::getParameterById(Int32 id, NTA_BasicType type, void *value) {
+  if (type == NTA_BasicType_Real32) {
+    Real32 &v = *reinterpret_cast<Real32 *>(value);
+    switch (id) {
+    case TM_anomaly:
+      v = tm_ ? tm_->anomaly : -1.0f;
+      return true;
+    case TM_permanenceIncrement:
+      v = tm_ ? tm_->getPermanenceIncrement() : args_.permanenceIncrement;
+      return true;
+    case TM_permanenceDecrement:
+      v = tm_ ? tm_->getPermanenceDecrement() : args_.permanenceDecrement;
+      return true;
+    case TM_predictedSegmentDecrement:
+      v = tm_ ? tm_->getPredictedSegmentDecrement() : args_.predictedSegmentDecrement;
+      return true;
+    }
+  } else if (type == NTA_BasicType_Bool and id == TM_learningMode) {
+    *reinterpret_cast<bool *>(value) = args_.learningMode;
+    return true;
+  }
+  return false;
+}
+
+
+bool TMRegion::setParameterById(Int32 id, NTA_BasicType type, const void *value) {
+  if (type == NTA_BasicType_Real32) {
+    const Real32 v = *reinterpret_cast<const Real32 *>(value);
+    switch (id) {
+    case TM_permanenceIncrement:
+      if (tm_) tm_->setPermanenceIncrement(v);
+      args_.permanenceIncrement = v;
+      return true;
+    case TM_permanenceDecrement:
+      if (tm_) tm_->setPermanenceDecrement(v);
+      args_.permanenceDecrement = v;
+      return true;
+    case TM_predictedSegmentDecrement:
+      if (tm_) tm_->setPredictedSegmentDecrement(v);
+      args_.predictedSegmentDecrement = v;
+      return true;
+    }
+  } else if (type == NTA_BasicType_Bool and id == TM_learningMode) {
+    args_.learningMode = *reinterpret_cast<const bool *>(value);
+    return true;
+  }
+  return false;
+}
+
+
 
 bool TMRegion::operator==(const RegionImpl &o) const {
   if (o.getType() != "TMRegion") return false;
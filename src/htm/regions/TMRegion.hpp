@@ -53,6 +53,8 @@ public:
 
   // Compute outputs from inputs and internal state
   void compute() override;
+  void bindPorts() override;
+  void produceOutput(const std::string &name) override;
 
   /**
    * Inputs/Outputs are made available in initialize()
@@ -148,6 +150,19 @@ public:
   void setParameterBool(const std::string &name, Int64 index,bool value) override;
   void setParameterString(const std::string &name, Int64 index, const std::string &s) override;
 
+  Int32 resolveParameter(const std::string &name) const override;
+  bool getParameterById(Int32 id, NTA_BasicType type, void *value) override;
+  bool setParameterById(Int32 id, NTA_BasicType type, const void *value) override;
+
+  void setThreadBudget(UInt numThreads) override;
+
+  size_t memoryUsage() const override { return tm_ ? tm_->memoryUsage() : 0u; }
+  void reduceMemoryUsage() override { if (tm_) tm_->compact(); }
+  UInt setShedLevel(UInt level) override;
+  std::vector<const Connections *> getConnections() const override {
+    return tm_ ? std::vector<const Connections *>{&tm_->connections} : std::vector<const Connections *>();
+  }
+
 private:
   Dimensions columnDimensions_;
 
@@ -186,6 +201,34 @@ private:
 
   computeCallbackFunc computeCallback_;
   std::unique_ptr<TemporalMemory> tm_;
+
+  // The ports of compute(), @see bindPorts().
+  Input *resetIn_ = nullptr;
+  Input *bottomUpIn_ = nullptr;
+  Input *externalPredictiveInputsActive_ = nullptr;
+  Input *externalPredictiveInputsWinners_ = nullptr;
+  Output *bottomUpOut_ = nullptr;
+  Output *activeCells_ = nullptr;
+  Output *predictedActiveCells_ = nullptr;
+  Output *anomaly_ = nullptr;
+  Output *predictiveCells_ = nullptr;
+
+  // The outputs without links which the last compute() skipped.  They are
+  // produced on demand from the unchanged TM state, @see produceOutput().
+  std::vector<Output *> skipped_;
+  void produceOrSkip_(Output *out);
+  void produce_(Output *out);
+
+  // Set by Network::runWithDeadline(), not serialized.
+  UInt shedLevel_ = Shed_None;
+
+  // Threads of the TM, not serialized.  0 uses the thread budget.
+  UInt32 numThreads_ = 0u;
+  UInt32 threadBudget_ = 1u;
+  void applyNumThreads_();
+
+  // TemporalMemory::getStats() is enabled, not serialized.
+  bool algorithmStats_ = false;
 };
 
 } // namespace htm
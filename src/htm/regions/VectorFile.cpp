@@ -19,11 +19,15 @@
  * Implementation for VectorFile class
  */
 
+#include <algorithm> // copy
 #include <cstring> // memset
 #include <cmath>
 #include <cstdio> //fopen
 #include <iostream>
+#include <map>
 #include <math.h>
+#include <mutex>
+#include <tuple>
 #include <htm/os/Path.hpp>
 #include <htm/regions/VectorFile.hpp>
 #include <htm/utils/Log.hpp>
@@ -54,6 +58,12 @@ void VectorFile::clear(bool clearScaling) {
   }
   fileVectors_.clear();
   own_.clear();
+  columnar_.clear();
+  columnarRows_ = 0;
+  vectorWidth_ = 0;
+  shared_.reset();
+  sharedFile_.clear();
+  sharedFormat_ = 0;
 
   elementLabels_.clear();
   vectorLabels_.clear();
@@ -66,8 +76,16 @@ void VectorFile::clear(bool clearScaling) {
 //----------------------------------------------------------------------------
 void VectorFile::appendFile(const string &fileName,
                             Size expectedElementCount, UInt32 fileFormat) {
+  NTA_CHECK(!shared_)
+      << "VectorFile::appendFile - can not append to the vectors of a shared file";
+  NTA_CHECK(columnar_.empty() || fileFormat == 7)
+      << "VectorFile::appendFile - only columnar files can follow a columnar file";
   bool handled = false;
   switch (fileFormat) {
+  case 7:
+    appendColumnarFile(fileName, expectedElementCount);
+    handled = true;
+    break;
   case 4: // Little-endian.  //TODO supporting just 1 format, remove this swithch and fileFormat
     appendFloat32File(fileName, expectedElementCount);
     handled = true;
@@ -101,9 +119,11 @@ void VectorFile::appendFile(const string &fileName,
     }
   }
 
-  NTA_CHECK(fileVectors_.size() > 0)
+  NTA_CHECK(vectorCount() > 0)
       << "VectorFile::appendFile - no vectors were read in.";
 
+  vectorWidth_ = expectedElementCount;
+
   // Reset scaling only if the vector lengths changed
   if (scaleVector_.size() != expectedElementCount) {
     NTA_INFO << "appendFile - need to reset scale and offset vectors.";
@@ -112,6 +132,65 @@ void VectorFile::appendFile(const string &fileName,
 }
 
 
+//----------------------------------------------------------------------------
+// The shared files of the process, by path, format and version of the file.
+namespace {
+struct SharedKey {
+  string path;
+  Size elements;
+  UInt32 format;
+  Size size;
+  Int64 written;
+  bool operator<(const SharedKey &o) const {
+    return std::tie(path, elements, format, size, written) <
+           std::tie(o.path, o.elements, o.format, o.size, o.written);
+  }
+};
+} // namespace
+
+std::shared_ptr<const VectorFile>
+VectorFile::getSharedFile(const string &fileName, Size expectedElementCount,
+                          UInt32 fileFormat) {
+  static std::mutex mutex;
+  static std::map<SharedKey, std::weak_ptr<const VectorFile>> files;
+
+  NTA_CHECK(Path::exists(fileName))
+      << "VectorFile::getSharedFile - unable to open file: " << fileName;
+  const SharedKey key{Path::makeAbsolute(fileName), expectedElementCount, fileFormat,
+                      Path::getFileSize(fileName), Path::getLastWriteTime(fileName)};
+
+  // Loads under the lock, so that concurrent regions read a file only once.
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = files.begin(); it != files.end();) {
+    if (it->second.expired())
+      it = files.erase(it);
+    else
+      ++it;
+  }
+  auto &entry = files[key];
+  std::shared_ptr<const VectorFile> file = entry.lock();
+  if (!file) {
+    auto loaded = make_shared<VectorFile>();
+    loaded->appendFile(fileName, expectedElementCount, fileFormat);
+    file = loaded;
+    entry = file;
+  }
+  return file;
+}
+
+void VectorFile::shareFile(const string &fileName, Size expectedElementCount,
+                           UInt32 fileFormat) {
+  auto file = getSharedFile(fileName, expectedElementCount, fileFormat);
+  clear(false);
+  shared_ = file;
+  sharedFile_ = fileName;
+  sharedFormat_ = fileFormat;
+  vectorWidth_ = expectedElementCount;
+  if (scaleVector_.size() != expectedElementCount)
+    resetScaling((UInt)expectedElementCount);
+}
+
+
 //----------------------------------------------------------------------------
 // use this when loading from a file or when loading from a serialization stream.
 void VectorFile::loadVectors(std::istream& inFile, 
@@ -204,9 +283,13 @@ static bool dosEndings(std::istream &inFile) {
 
 void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
                              Int64 begin, Int64 end, const char *lineEndings) const {
+  if (shared_) {
+    shared_->saveVectors(out, nColumns, fileFormat, begin, end, lineEndings);
+    return;
+  }
   out.exceptions(ios_base::failbit | ios_base::badbit);
 
-  Size n = fileVectors_.size();
+  Size n = vectorCount();
   while (begin < 0) begin += n;
   while (end < 0)  end += n;
   NTA_CHECK(begin <= Int64(n)) << "Begin (" << begin << ") out of bounds.";
@@ -214,9 +297,10 @@ void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
   if (end < begin)
     end = begin;
 
-  // Setup iterators for the rows.
-  vector<Real *>::const_iterator i = (fileVectors_.begin() + size_t(begin));
-  auto iend = i + size_t(end - begin);
+  // The rows to write, and a buffer for rows of columnar files.
+  size_t i = size_t(begin);
+  const size_t iend = size_t(end);
+  vector<Real> scratch;
 
   switch (fileFormat) {
   case 0:
@@ -294,7 +378,7 @@ void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
         if (nColumns)
           out << sep;
       }
-      const Real *p = *i;
+      const Real *p = row_(i, scratch);
       if (nColumns) {
         const Real *pEnd = p + nColumns;
         out << *(p++);
@@ -318,7 +402,7 @@ void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
       try {
         for (; i != iend; ++i) {
           if (needConversion) {
-            const Real *p = *i;
+            const Real *p = row_(i, scratch);
             for (Size j = 0; j < nColumns; ++j)
               buffer[j] = *(p++);
           }
@@ -331,7 +415,7 @@ void VectorFile::saveVectors(ostream &out, Size nColumns, UInt32 fileFormat,
       delete[] buffer;
     } else {
       for (; i != iend; ++i)
-        out.write((char *)(*i), streamsize(rowBytes));
+        out.write((char *)row_(i, scratch), streamsize(rowBytes));
     }
     break;
   }
@@ -657,6 +741,61 @@ void VectorFile::appendIDXFile(const string &filename, int expectedElements) {
   // Don't delete block, as it is owned by fileVectors_ now.
 }
 
+std::vector<Real> VectorFile::packVectors_() const {
+  const size_t nCols = vectorWidth();
+  std::vector<Real> vectors(fileVectors_.size() * nCols);
+  for (size_t i = 0; i < fileVectors_.size(); i++)
+    std::copy(fileVectors_[i], fileVectors_[i] + nCols, vectors.begin() + i * nCols);
+  return vectors;
+}
+
+void VectorFile::unpackVectors_(const std::vector<Real> &vectors, size_t nRows,
+                                size_t nCols) {
+  NTA_CHECK(vectors.size() == nRows * nCols)
+      << "VectorFile: " << vectors.size() << " elements do not make " << nRows
+      << " vectors of " << nCols << " elements";
+  NTA_CHECK(fileVectors_.empty()) << "VectorFile: vectors are loaded already";
+  if (nRows == 0)
+    return;
+  // One block, owned by the first vector, as in appendFloat32File().
+  auto block = new Real[nRows * nCols];
+  std::copy(vectors.begin(), vectors.end(), block);
+  fileVectors_.resize(nRows);
+  own_.assign(nRows, false);
+  own_[0] = true;
+  for (size_t i = 0; i < nRows; i++)
+    fileVectors_[i] = block + i * nCols;
+}
+
+void VectorFile::appendColumnarFile(const string &filename,
+                                    Size expectedElements) {
+  NTA_CHECK(!isLabeled())
+      << "VectorFile::appendFile - a columnar file can not follow a labeled file.";
+  auto file = make_shared<ColumnarFile>(filename);
+  NTA_CHECK(file->numColumns() == expectedElements)
+      << "VectorFile::appendFile - number of columns in file (" << file->numColumns()
+      << ") does not match output element count (" << expectedElements << ")";
+  columnar_.push_back(file);
+  columnarRows_ += static_cast<size_t>(file->numRows());
+}
+
+const Real *VectorFile::row_(const size_t i, vector<Real> &scratch) const {
+  if (shared_)
+    return shared_->row_(i, scratch);
+  if (i < fileVectors_.size())
+    return fileVectors_[i];
+  size_t row = i - fileVectors_.size();
+  for (const auto &file : columnar_) {
+    if (row < file->numRows()) {
+      scratch.resize(file->numColumns());
+      file->readRow(row, scratch.data(), 0, scratch.size());
+      return scratch.data();
+    }
+    row -= static_cast<size_t>(file->numRows());
+  }
+  NTA_THROW << "Requested non-existent vector: " << i;
+}
+
 /// Reset scaling to have no effect (unitary scaling vector and zero offset
 /// vector)
 void VectorFile::resetScaling(UInt nElements) {
@@ -686,6 +825,22 @@ void VectorFile::getRawVector(const UInt v, Real *out, UInt offset,
     NTA_THROW << "Wrong offset/count: the sum " << offset << "+" << count
               << " = " << offset + count
               << ", must be smaller than element count: " << getElementCount();
+  if (shared_) {
+    const Real *vec = shared_->row_(v, rowBuffer_);
+    std::copy(vec + offset, vec + offset + count, out);
+    return;
+  }
+  // Rows of columnar files are converted in place.
+  if (v >= fileVectors_.size()) {
+    size_t row = v - fileVectors_.size();
+    for (const auto &file : columnar_) {
+      if (row < file->numRows()) {
+        file->readRow(row, out, offset, count);
+        return;
+      }
+      row -= static_cast<size_t>(file->numRows());
+    }
+  }
   // Get the pointers and copy over the vector
   Real *vec = fileVectors_[v];
   for (Size i = 0; i < count; i++)
@@ -705,10 +860,19 @@ void VectorFile::getScaledVector(const UInt v, Real *out, UInt offset,
 
   NTA_CHECK(getElementCount() <= offset + count);
 
-  // Get the pointers and copy over the vector
-  Real *vec = fileVectors_[v];
+  applyScaling(row_(v, rowBuffer_), out, offset, count);
+}
+
+/// Apply the scaling to a vector, which need not be stored in this file.
+void VectorFile::applyScaling(const Real *vec, Real *out, UInt offset,
+                              Size count) const {
+  NTA_CHECK(count <= scaleVector_.size()) << "Wrong count: " << count;
+  // A plain loop over distinct arrays, which the compiler vectorizes.
+  const Real *in = vec + offset;
+  const Real *scale = scaleVector_.data();
+  const Real *shift = offsetVector_.data();
   for (Size i = 0; i < count; i++) {
-    out[i] = scaleVector_[i] * (vec[i + offset] + offsetVector_[i]);
+    out[i] = scale[i] * (in[i] + shift[i]);
   }
 }
 
@@ -742,24 +906,36 @@ void VectorFile::setStandardScaling() {
     NTA_THROW << "Error in setting standard scaling: insufficient vectors "
                  "loaded in memory.";
 
+  // Accumulate the sums of all elements row by row, as rows of columnar
+  // files are converted one at a time.
   Size nv = vectorCount();
-  for (UInt e = 0; e < getElementCount(); e++) {
-    double sum = 0, sum2 = 0; // Accumulate sums as doubles
-
-    // First compute the mean and offset
-    for (Size i = 0; i < nv; i++)
-      sum += fileVectors_[i][e];
-    double mean = sum / nv;
-    offsetVector_[e] = (Real)(-mean);
-
-    // Now compute the squared term for stdev
-    for (Size i = 0; i < nv; i++) {
-      double s = (fileVectors_[i][e] - mean);
-      sum2 += s * s;
+  const Size ne = getElementCount();
+  vector<double> sum(ne, 0.0), sum2(ne, 0.0); // Accumulate sums as doubles
+
+  // First compute the mean and offset
+  for (Size i = 0; i < nv; i++) {
+    const Real *vec = row_(i, rowBuffer_);
+    for (Size e = 0; e < ne; e++)
+      sum[e] += vec[e];
+  }
+  vector<double> mean(ne);
+  for (Size e = 0; e < ne; e++) {
+    mean[e] = sum[e] / nv;
+    offsetVector_[e] = (Real)(-mean[e]);
+  }
+
+  // Now compute the squared term for stdev
+  for (Size i = 0; i < nv; i++) {
+    const Real *vec = row_(i, rowBuffer_);
+    for (Size e = 0; e < ne; e++) {
+      double s = (vec[e] - mean[e]);
+      sum2[e] += s * s;
     }
+  }
 
+  for (Size e = 0; e < ne; e++) {
     // Now compute the "unbiased" or "n-1" form of standard deviation
-    double stdev = sqrt(sum2 / (nv - 1));
+    double stdev = sqrt(sum2[e] / (nv - 1));
     if (fabs(stdev) < 0.00000001)
       NTA_THROW << "Error setting standard form, stdeviation is almost zero "
                    "for some component.";
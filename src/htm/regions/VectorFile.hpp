@@ -27,7 +27,9 @@
 //----------------------------------------------------------------------
 
 #include <fstream>
+#include <memory>
 #include <sstream>
+#include <htm/regions/ColumnarFile.hpp>
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
 #include <vector>
@@ -44,7 +46,7 @@ public:
   VectorFile();
   virtual ~VectorFile();
 
-  static Int32 maxFormat() { return 6; }
+  static Int32 maxFormat() { return 7; }
 
   /// Read in vectors from the given filename. All vectors are expected to
   /// have the same size (i.e. same number of elements).
@@ -60,23 +62,53 @@ public:
   ///           4        # Reads in a little-endian float32 binary file
   ///           5        # Reads in a big-endian float32 binary file
   ///           6        # Reads in a big-endian IDX binary file
+  ///           7        # Maps a binary columnar file, @see ColumnarFile.hpp
+  /// The rows of columnar files are read in place from the mapped file, so
+  /// only rows of columnar files may be appended after a columnar file.
   void appendFile(const std::string &fileName, Size expectedElementCount,
                   UInt32 fileFormat);
 
+  /// The vectors of a file, read once per process and shared read-only by
+  /// every VectorFile which shares the file, see shareFile().  The process
+  /// keeps the file while a VectorFile shares it, and reads it again if its
+  /// size or modification time changed.  Columnar files stay mapped once.
+  static std::shared_ptr<const VectorFile>
+  getSharedFile(const std::string &fileName, Size expectedElementCount,
+                UInt32 fileFormat);
+
+  /// Replace the vectors by the shared vectors of a file, see
+  /// getSharedFile().  Only the scaling belongs to this VectorFile, and no
+  /// file may be appended to shared vectors.
+  void shareFile(const std::string &fileName, Size expectedElementCount,
+                 UInt32 fileFormat);
+
+  /// Return true if the vectors are those of a shared file.
+  bool isShared() const { return shared_ != nullptr; }
+
   /// Retrieve i'th vector, apply scaling and copy result into output
   /// output must have size of at least 'count' elements
   void getScaledVector(const UInt i, Real *out, UInt offset, Size count);
 
+  /// Apply the scaling to the elements offset..offset+count of vec, the
+  /// vector of a VectorStream for example.
+  void applyScaling(const Real *vec, Real *out, UInt offset, Size count) const;
+
   /// Retrieve the i'th vector and copy into output without scaling
   /// output must have size at least 'count' elements
   void getRawVector(const UInt i, Real *out, UInt offset, Size count);
 
   /// Return the number of stored vectors
-  size_t vectorCount() const { return fileVectors_.size(); }
+  size_t vectorCount() const {
+    return shared_ ? shared_->vectorCount() : fileVectors_.size() + columnarRows_;
+  }
 
   /// Return the size of each vector (number of elements per vector)
   size_t getElementCount() const;
 
+  /// Return the number of elements stored per vector, which may exceed the
+  /// element count of the scaling by the category and reset elements.
+  size_t vectorWidth() const { return vectorWidth_ ? vectorWidth_ : scaleVector_.size(); }
+
   /// Set the scale and offset vectors to correspond to standard form
   /// Sets the offset component of each element to be -mean
   /// Sets the scale component of each element to be 1/stddev
@@ -102,6 +134,8 @@ public:
 
   // Return true iff a labeled file was read in
   inline bool isLabeled() const {
+    if (shared_)
+      return shared_->isLabeled();
     return (!(elementLabels_.empty() || vectorLabels_.empty()));
   }
 
@@ -120,32 +154,65 @@ public:
 	CerealAdapter;  // See Serializable.hpp
   template<class Archive>
 	void save_ar(Archive& ar) const { 
-	  UInt32 format = (isLabeled())?1:2;     // format (1 if labled, 2 if not)
+	  // The vectors in memory as one binary block, the paths of the
+	  // columnar files which hold the rest, and the path of a shared file,
+	  // which is shared again at load.
 		size_t nRows = fileVectors_.size();
-		Size nCols = scaleVector_.size();
-		std::stringstream ss;
-	  saveVectors(ss, nCols, format, 0, fileVectors_.size(), nullptr);
-		std::string data = ss.str();
+		size_t nCols = vectorWidth();
+		std::vector<Real> vectors = packVectors_();
+		std::vector<std::string> columnarFiles;
+		for (const auto &file : columnar_)
+		  columnarFiles.push_back(file->path());
+	  const UInt32 format = (isLabeled())?1:2; // format (1 if labled, 2 if not)
+	  saveArchiveVersion(ar, UInt32(0u), ARCHIVE_VERSION);
     ar(cereal::make_nvp("format", format),
 		   cereal::make_nvp("nRows", nRows),
-			 cereal::make_nvp("nCols", nCols),
+		   cereal::make_nvp("nCols", nCols),
 		   cereal::make_nvp("scaleVector", scaleVector_),
 		   cereal::make_nvp("offsetVector", offsetVector_),
-			 cereal::make_nvp("data", data));
+		   cereal::make_nvp("vectors", vectors),
+		   cereal::make_nvp("elementLabels", elementLabels_),
+		   cereal::make_nvp("vectorLabels", vectorLabels_),
+		   cereal::make_nvp("columnarFiles", columnarFiles),
+		   cereal::make_nvp("sharedFile", sharedFile_),
+		   cereal::make_nvp("sharedFormat", sharedFormat_));
 	}
   template<class Archive>
 	void load_ar(Archive& ar) { 
-	  UInt32 format;     // format (1 if labled, 2 if not)
 		size_t nRows;
 		size_t nCols;
-		std::string data;
-    ar( format, nRows,  nCols, scaleVector_, offsetVector_, data);
-		std::stringstream ss(data);
-	  loadVectors(ss, nRows, nCols, format);
+		std::vector<Real> vectors;
+		std::vector<std::string> columnarFiles;
+		std::string sharedFile;
+		UInt32 sharedFormat;
+		clear();
+	  UInt32 format;     // format (1 if labled, 2 if not)
+	  const UInt32 version = loadArchiveVersion(ar, "format", format, UInt32(0u), 1u);
+	  NTA_CHECK(version <= ARCHIVE_VERSION) << "Unknown archive version " << version;
+	  if (version < 2u) {
+	    // The vectors were archived as the text of saveVectors().
+		  std::string data;
+      ar(nRows, nCols, scaleVector_, offsetVector_, data);
+		  std::stringstream ss(data);
+	    loadVectors(ss, nRows, nCols, format);
+	    return;
+	  }
+    ar(nRows, nCols, scaleVector_, offsetVector_, vectors,
+		   elementLabels_, vectorLabels_, columnarFiles, sharedFile, sharedFormat);
+	  unpackVectors_(vectors, nRows, nCols);
+		for (const auto &path : columnarFiles)
+		  appendColumnarFile(path, nCols);
+		vectorWidth_ = nCols;
+		if (!sharedFile.empty())
+		  shareFile(sharedFile, nCols, sharedFormat);
 	}
 	
 
 private:
+  // Version 2 archives the vectors as a binary block, version 1 (unversioned)
+  // as the text of saveVectors().
+  static const UInt32 ARCHIVE_VERSION = 2u;
+
   std::vector<Real *> fileVectors_; // list of vectors
   std::vector<bool> own_;           // memory ownership flags
   std::vector<Real> scaleVector_;   // the scaling vector
@@ -154,6 +221,17 @@ private:
   std::vector<std::string> elementLabels_; // string denoting the meaning of each element
   std::vector<std::string> vectorLabels_; // a string label for each vector
 
+  // The columnar files, their rows follow the rows in fileVectors_.
+  std::vector<std::shared_ptr<ColumnarFile>> columnar_;
+  size_t columnarRows_ = 0;
+  std::vector<Real> rowBuffer_;     // a converted row of a columnar file
+  size_t vectorWidth_ = 0;          // elements per stored vector
+
+  // The shared vectors, which replace all of the above, see shareFile().
+  std::shared_ptr<const VectorFile> shared_;
+  std::string sharedFile_;
+  UInt32 sharedFormat_ = 0;
+
   //------------------- Utility routines
   void appendCSVFile(std::istream &inFile, Size expectedElementCount);
 
@@ -163,6 +241,16 @@ private:
   /// Read vectors from a binary IDX file.
   void appendIDXFile(const std::string &filename, int expectedElements);
   void loadVectors(std::istream &f, size_t nRows, size_t nCols, int format);
+
+  /// Map a columnar file, its columns must match the expected elements.
+  void appendColumnarFile(const std::string &filename, Size expectedElements);
+
+  /// Copy the vectors in memory into one block, and back.
+  std::vector<Real> packVectors_() const;
+  void unpackVectors_(const std::vector<Real> &vectors, size_t nRows, size_t nCols);
+
+  /// The i'th vector.  Rows of columnar files are converted into scratch.
+  const Real *row_(size_t i, std::vector<Real> &scratch) const;
 }; // end class VectorFile
 
 //----------------------------------------------------------------------
@@ -0,0 +1,209 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the VectorStream.
+ */
+
+#include <algorithm> // replace
+#include <sstream>
+
+#include <htm/os/Path.hpp>
+#include <htm/regions/VectorStream.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+VectorStream::VectorStream(const std::string &path, const Size elementCount,
+                           const UInt32 format, const Size blockRows,
+                           const Size numBlocks)
+  : path_(path), elementCount_(elementCount), format_(format), blockRows_(blockRows),
+    blocks_(numBlocks) {
+  NTA_CHECK(format == 2u || format == 3u || format == 4u)
+      << "VectorStream: file format " << format << " can not be streamed";
+  NTA_CHECK(elementCount > 0u) << "VectorStream: the element count must be > 0";
+  NTA_CHECK(blockRows > 0u && numBlocks > 0u) << "VectorStream: the ring must have rows";
+  NTA_CHECK(Path::exists(path)) << "VectorStream: unable to open file: " << path;
+  for (auto &block : blocks_)
+    block.data.resize(blockRows * elementCount);
+  binary_.resize(elementCount);
+  start_(0u);
+}
+
+VectorStream::~VectorStream() { stop_(); }
+
+
+const Real *VectorStream::next() {
+  if (current_ != NONE && row_ + 1u < blocks_[current_].rows) {
+    row_++;
+  } else {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (current_ != NONE) {
+      free_.push_back(current_); // hand the block back for reading ahead
+      current_ = NONE;
+      changed_.notify_all();
+    }
+    changed_.wait(lock, [this] { return !full_.empty() || error_ != nullptr; });
+    if (full_.empty())
+      std::rethrow_exception(error_);
+    current_ = full_.front();
+    full_.pop_front();
+    row_ = 0u;
+  }
+  const Block &block = blocks_[current_];
+  position_ = static_cast<Int64>(block.first + row_);
+  return block.data.data() + row_ * elementCount_;
+}
+
+void VectorStream::seek(const UInt64 row) {
+  stop_();
+  start_(row);
+  position_ = static_cast<Int64>(row) - 1;
+}
+
+
+void VectorStream::start_(const UInt64 row) {
+  free_.clear();
+  full_.clear();
+  for (size_t b = 0u; b < blocks_.size(); b++)
+    free_.push_back(b);
+  current_ = NONE;
+  stopping_ = false;
+  error_ = nullptr;
+  thread_ = std::thread(&VectorStream::produce_, this, row);
+}
+
+void VectorStream::stop_() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  if (thread_.joinable())
+    thread_.join();
+}
+
+void VectorStream::produce_(UInt64 row) {
+  try {
+    std::ifstream in;
+    open_(in);
+    skip_(in, row);
+    while (true) {
+      size_t b;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return stopping_ || !free_.empty(); });
+        if (stopping_)
+          return;
+        b = free_.front();
+        free_.pop_front();
+      }
+      Block &block = blocks_[b];
+      block.rows = 0u;
+      block.first = row;
+      while (block.rows < blockRows_) {
+        if (readRow_(in, block.data.data() + block.rows * elementCount_)) {
+          block.rows++;
+          row++;
+        } else if (block.rows > 0u) {
+          break; // a partial block at the end of the file
+        } else {
+          NTA_CHECK(row > 0u) << "VectorStream: no vectors in " << path_;
+          open_(in); // start over
+          row = 0u;
+          block.first = 0u;
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        full_.push_back(b);
+      }
+      changed_.notify_all();
+    }
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      error_ = std::current_exception();
+    }
+    changed_.notify_all();
+  }
+}
+
+
+void VectorStream::open_(std::ifstream &in) const {
+  if (in.is_open())
+    in.close();
+  in.clear();
+  in.open(path_, (format_ == 4u) ? (std::ios_base::in | std::ios_base::binary) : std::ios_base::in);
+  NTA_CHECK(in.is_open()) << "VectorStream: unable to open file: " << path_;
+}
+
+void VectorStream::skip_(std::ifstream &in, const UInt64 rows) {
+  if (format_ == 4u) {
+    const UInt64 rowBytes = elementCount_ * sizeof(Real32);
+    NTA_CHECK(rows * rowBytes < Path::getFileSize(path_) || rows == 0u)
+        << "VectorStream: row " << rows << " is beyond the end of " << path_;
+    in.seekg(static_cast<std::streamoff>(rows * rowBytes));
+    return;
+  }
+  std::vector<Real> scratch(elementCount_);
+  for (UInt64 i = 0u; i < rows; i++) {
+    NTA_CHECK(readRow_(in, scratch.data()))
+        << "VectorStream: row " << rows << " is beyond the end of " << path_;
+  }
+}
+
+bool VectorStream::readRow_(std::ifstream &in, Real *out) {
+  switch (format_) {
+  case 2u: {
+    for (Size i = 0u; i < elementCount_; i++) {
+      if (!(in >> out[i])) {
+        NTA_CHECK(in.eof()) << "VectorStream: improperly formatted data in " << path_;
+        return false; // an incomplete last vector is ignored, as in VectorFile
+      }
+    }
+    return true;
+  }
+  case 3u: {
+    while (std::getline(in, line_)) {
+      std::replace(line_.begin(), line_.end(), ',', ' ');
+      std::istringstream values(line_);
+      Size found = 0u;
+      while (found < elementCount_ && (values >> out[found]))
+        found++;
+      if (found == elementCount_)
+        return true;
+    }
+    return false;
+  }
+  default: {
+    in.read(reinterpret_cast<char *>(binary_.data()),
+            static_cast<std::streamsize>(elementCount_ * sizeof(Real32)));
+    const auto bytes = static_cast<size_t>(in.gcount());
+    if (bytes == 0u)
+      return false;
+    NTA_CHECK(bytes == elementCount_ * sizeof(Real32))
+        << "VectorStream: binary file " << path_ << " is not a multiple of "
+        << elementCount_ << " float32 elements";
+    for (Size i = 0u; i < elementCount_; i++)
+      out[i] = static_cast<Real>(binary_[i]);
+    return true;
+  }
+  }
+}
+
+} // namespace htm
@@ -0,0 +1,117 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Streaming of vector files with bounded memory.
+ */
+
+#ifndef NTA_VECTOR_STREAM_HPP
+#define NTA_VECTOR_STREAM_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * VectorStream reads the vectors of a file in sequence, without loading the
+ * file.  A background thread reads blocks of rows ahead into a ring of
+ * blocks, so the memory is blockRows * numBlocks vectors for files of any
+ * size.  Like the VectorFile, the stream starts over at the end of the file.
+ *
+ * Supported file formats, as in VectorFile::appendFile():
+ *   2 - unlabeled text file without element count
+ *   3 - csv file, lines with too few numbers are skipped
+ *   4 - little-endian float32 binary file
+ */
+class VectorStream {
+public:
+  VectorStream(const std::string &path, Size elementCount, UInt32 format,
+               Size blockRows = 1024u, Size numBlocks = 4u);
+  ~VectorStream();
+
+  VectorStream(const VectorStream &) = delete;
+  VectorStream &operator=(const VectorStream &) = delete;
+
+  /**
+   * @returns the next vector of elementCount elements.  Valid until the next
+   * call to next() or seek().  Rethrows the errors of the reading thread.
+   */
+  const Real *next();
+
+  /**
+   * Restart the stream so that next() returns the vector at `row`.
+   */
+  void seek(UInt64 row);
+
+  /**
+   * The index in the file of the last vector returned by next(), -1 before
+   * the first.
+   */
+  Int64 position() const { return position_; }
+
+  const std::string &path() const { return path_; }
+  UInt32 format() const { return format_; }
+  Size elementCount() const { return elementCount_; }
+
+private:
+  struct Block {
+    std::vector<Real> data;
+    Size rows = 0u;
+    UInt64 first = 0u; // index of the first row in the file
+  };
+  static const size_t NONE = static_cast<size_t>(-1);
+
+  void start_(UInt64 row);
+  void stop_();
+  void produce_(UInt64 row);
+  void open_(std::ifstream &in) const;
+  void skip_(std::ifstream &in, UInt64 rows);
+  bool readRow_(std::ifstream &in, Real *out);
+
+  const std::string path_;
+  const Size elementCount_;
+  const UInt32 format_;
+  const Size blockRows_;
+
+  std::vector<Block> blocks_;
+  std::deque<size_t> free_; // blocks to fill, owned by the reading thread
+  std::deque<size_t> full_; // blocks to read, in order
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::thread thread_;
+  bool stopping_ = false;
+  std::exception_ptr error_;
+
+  size_t current_ = NONE; // the block of the last vector
+  Size row_ = 0u;         // the last vector in the current block
+  Int64 position_ = -1;
+  std::vector<Real32> binary_; // a row of a binary file
+  std::string line_;           // a line of a csv file
+};
+
+} // namespace htm
+
+#endif // NTA_VECTOR_STREAM_HPP
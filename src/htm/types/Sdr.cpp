@@ -22,6 +22,8 @@
  */
 
 #include "htm/types/Sdr.hpp"
+#include "htm/utils/ThreadPool.hpp"
+#include "htm/utils/SortedIntersection.hpp"
 
 #include <numeric>
 #include <algorithm> // std::sort, std::accumulate
@@ -30,10 +32,77 @@ using namespace std;
 
 namespace htm {
 
+    namespace {
+        // Number of words in the dense bits of an SDR with size bits.
+        inline size_t numWords(const UInt size)
+            { return (static_cast<size_t>(size) + 63u) / 64u; }
+
+        inline UInt popcount(UInt64 x) {
+        #if defined(__GNUC__) || defined(__clang__)
+            return static_cast<UInt>( __builtin_popcountll(x) );
+        #else
+            x = x - ((x >> 1) & 0x5555555555555555ull);
+            x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+            x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+            return static_cast<UInt>( (x * 0x0101010101010101ull) >> 56 );
+        #endif
+        }
+
+        // Division by a fixed divisor as a multiplication & a shift, see
+        // Lemire et al. "Faster Remainder by Direct Computation".  Exact for
+        // all 32 bit numerators.
+        struct Divider {
+            UInt32 divisor;
+            UInt64 magic;
+
+            explicit Divider(const UInt32 d = 1u)
+                : divisor(d), magic(d > 1u ? UINT64_C(0xFFFFFFFFFFFFFFFF) / d + 1u : 0u) {}
+
+            inline UInt32 divide(const UInt32 n) const {
+            #if defined(__SIZEOF_INT128__)
+                if( magic == 0u ) return n; // divisor 1
+                __extension__ typedef unsigned __int128 UInt128;
+                return static_cast<UInt32>( (static_cast<UInt128>(magic) * n) >> 64 );
+            #else
+                return n / divisor;
+            #endif
+            }
+        };
+
+        // Below these sizes the conversions run on the calling thread only.
+        const size_t MIN_PARALLEL_COORDINATES = 1u << 16; // true bits
+        const size_t MIN_PARALLEL_CONCATENATE = 1u << 20; // bits
+
+        // Index of the lowest true bit, x must not be zero.
+        inline UInt countTrailingZeros(const UInt64 x) {
+        #if defined(__GNUC__) || defined(__clang__)
+            return static_cast<UInt>( __builtin_ctzll(x) );
+        #else
+            return popcount( (x & (~x + 1u)) - 1u );
+        #endif
+        }
+    }
+
+    bool SparseDistributedRepresentation::preferSparse_(
+                                const vector<const SDR*> &inputs, const UInt size) {
+        size_t nnz = 0u;
+        bool allBits = true;
+        for( const auto sdr : inputs ) {
+            if( not sdr->sparse_valid )
+                return false;
+            allBits = allBits and sdr->denseBits_valid;
+            nnz += sdr->sparse_.size();
+        }
+        // Getting the dense bits costs at least as much as the sorted-set
+        // operations, unless all of the dense bits are already there.
+        return not allBits or nnz < numWords(size);
+    }
+
     void SparseDistributedRepresentation::clear() const {
         dense_valid       = false;
         sparse_valid      = false;
         coordinates_valid = false;
+        denseBits_valid   = false;
     }
 
     void SparseDistributedRepresentation::do_callbacks() const {
@@ -52,6 +121,21 @@ namespace htm {
         do_callbacks();
     }
 
+    void SparseDistributedRepresentation::setDenseBitsInplace() const {
+        // Check data is valid.
+        NTA_ASSERT( denseBits_.size() == numWords(size) );
+        #ifdef NTA_ASSERTIONS_ON
+            if( size % 64u != 0u ) {
+                NTA_ASSERT( (denseBits_.back() >> (size % 64u)) == 0u )
+                    << "Dense bits beyond the size of the SDR must be zero!";
+            }
+        #endif
+        // Set the valid flags.
+        clear();
+        denseBits_valid = true;
+        do_callbacks();
+    }
+
     void SparseDistributedRepresentation::setSparseInplace() const {
         // Check data is valid.
         #ifdef NTA_ASSERTIONS_ON
@@ -74,6 +158,14 @@ namespace htm {
         do_callbacks();
     }
 
+    void SparseDistributedRepresentation::checkLoadedSparse_() const {
+        for( size_t i = 0u; i < sparse_.size(); i++ ) {
+            NTA_CHECK( sparse_[i] < size ) << "SDR: index " << sparse_[i] << " out of range in the archive.";
+            NTA_CHECK( i == 0u or sparse_[i - 1u] < sparse_[i] )
+                << "SDR: the sparse data in the archive must be sorted and contain no duplicates.";
+        }
+    }
+
     void SparseDistributedRepresentation::setCoordinatesInplace() const {
         // Check data is valid.
         #ifdef NTA_ASSERTIONS_ON
@@ -129,6 +221,7 @@ namespace htm {
 
         // Initialize the dense array storage, when it's needed.
         dense_valid = false;
+        denseBits_valid = false;
         // Initialize the flatSparse array, nothing to do.
         sparse_valid = true;
         // Initialize the index tuple.
@@ -141,6 +234,25 @@ namespace htm {
         : SparseDistributedRepresentation( value.dimensions )
         { setSDR( value ); }
 
+    SparseDistributedRepresentation::SparseDistributedRepresentation(
+                                SparseDistributedRepresentation &&value )
+        : SparseDistributedRepresentation( value.dimensions ) {
+        swapData_( value );
+        value.zero();
+    }
+
+    void SparseDistributedRepresentation::swapData_( SparseDistributedRepresentation &value ) const {
+        NTA_ASSERT( dimensions == value.dimensions );
+        dense_.swap( value.dense_ );
+        sparse_.swap( value.sparse_ );
+        coordinates_.swap( value.coordinates_ );
+        denseBits_.swap( value.denseBits_ );
+        std::swap( dense_valid,       value.dense_valid );
+        std::swap( sparse_valid,      value.sparse_valid );
+        std::swap( coordinates_valid, value.coordinates_valid );
+        std::swap( denseBits_valid,   value.denseBits_valid );
+    }
+
     SparseDistributedRepresentation::~SparseDistributedRepresentation()
         { deconstruct(); }
 
@@ -148,7 +260,7 @@ namespace htm {
     void SparseDistributedRepresentation::reshape(const vector<UInt> &dimensions) const {
         // Make sure we have the data in a format which does not care about the
         // dimensions, IE: dense or sparse but not coordinates
-        if( not dense_valid and not sparse_valid )
+        if( not dense_valid and not sparse_valid and not denseBits_valid )
             getSparse();
         coordinates_valid = false;
         coordinates_.assign( dimensions.size(), {} );
@@ -183,6 +295,29 @@ namespace htm {
         return dense_;
     }
 
+    void SparseDistributedRepresentation::setDenseBits( SDR_dense_bits_t &value ) {
+        NTA_ASSERT(value.size() == numWords(size));
+        denseBits_.swap( value );
+        setDenseBitsInplace();
+    }
+
+    SDR_dense_bits_t& SparseDistributedRepresentation::getDenseBits() const {
+        if( !denseBits_valid ) {
+            denseBits_.assign( numWords(size), 0u );
+            if( dense_valid and not sparse_valid ) {
+                // Pack the dense bytes.
+                for(UInt idx = 0; idx < size; idx++)
+                    denseBits_[idx / 64u] |= UInt64(dense_[idx] != 0) << (idx % 64u);
+            }
+            else {
+                for(const auto idx : getSparse())
+                    denseBits_[idx / 64u] |= UInt64(1u) << (idx % 64u);
+            }
+            denseBits_valid = true;
+        }
+        return denseBits_;
+    }
+
     Byte SparseDistributedRepresentation::at(const vector<UInt> &coordinates) const {
         UInt flat = 0;
         NTA_ASSERT(coordinates.size() == dimensions.size())
@@ -219,6 +354,14 @@ namespace htm {
                     sparse_.push_back(flat);
                 }
             }
+            else if( denseBits_valid ) {
+                // Convert from dense bits to flatSparse, one true bit at a time.
+                for(size_t w = 0; w < denseBits_.size(); w++) {
+                    for(UInt64 word = denseBits_[w]; word != 0u; word &= word - 1u) {
+                        sparse_.push_back( static_cast<ElemSparse>(w * 64u + countTrailingZeros(word)) );
+                    }
+                }
+            }
             else if( dense_valid ) {
                 // Convert from dense to flatSparse.
                 const auto &dense = getDense();
@@ -241,22 +384,49 @@ namespace htm {
 
     SDR_coordinate_t& SparseDistributedRepresentation::getCoordinates() const {
       if( !coordinates_valid ) {
-        // Clear out any old data.
-        for( auto& vec : coordinates_ ) {
-          vec.clear();
-        }
-        // Convert from sparse to coordinates.
-        for( auto idx : getSparse() ) {
-          for(UInt dim = (UInt)(dimensions.size() - 1); dim > 0; --dim) {
-            const auto dim_sz = dimensions[dim];
-            coordinates_[dim].push_back( idx % dim_sz );
-            idx /= dim_sz;
+        coordinatesFromSparse_( nullptr );
+      }
+      return coordinates_;
+    }
+
+    SDR_coordinate_t& SparseDistributedRepresentation::getCoordinates(ThreadPool &pool) const {
+      if( !coordinates_valid ) {
+        coordinatesFromSparse_( &pool );
+      }
+      return coordinates_;
+    }
+
+    void SparseDistributedRepresentation::coordinatesFromSparse_(ThreadPool *pool) const {
+      const auto &sparse = getSparse();
+      const size_t nnz = sparse.size();
+      const UInt numDims = (UInt) dimensions.size();
+      vector<Divider> dividers;
+      for( const auto dim : dimensions ) {
+        dividers.emplace_back( static_cast<UInt32>(dim) );
+      }
+      for( auto& vec : coordinates_ ) {
+        vec.resize( nnz );
+      }
+
+      // Convert from sparse to coordinates, the last dimension varies fastest.
+      const auto convert = [&](const size_t begin, const size_t end, size_t) {
+        for( size_t i = begin; i < end; i++ ) {
+          UInt32 idx = sparse[i];
+          for(UInt dim = numDims - 1u; dim > 0u; --dim) {
+            const auto &divider = dividers[dim];
+            const UInt32 quotient = divider.divide( idx );
+            coordinates_[dim][i] = idx - quotient * divider.divisor;
+            idx = quotient;
           }
-          coordinates_[0].push_back(idx);
+          coordinates_[0][i] = idx;
         }
-        coordinates_valid = true;
+      };
+      if( pool != nullptr and nnz >= MIN_PARALLEL_COORDINATES ) {
+        pool->parallelFor( nnz, convert );
+      } else {
+        convert( 0u, nnz, 0u );
       }
-      return coordinates_;
+      coordinates_valid = true;
     }
 
 
@@ -270,23 +440,46 @@ namespace htm {
     }
 
 
-    SparseDistributedRepresentation& SparseDistributedRepresentation::operator=(const SparseDistributedRepresentation& value) {
+    void SparseDistributedRepresentation::assignDimensions_( const SparseDistributedRepresentation &value ) {
         if( dimensions.empty() ) {
             initialize( value.dimensions );
+        } else {
+            reshape( value.dimensions );
         }
+    }
+
+
+    SparseDistributedRepresentation& SparseDistributedRepresentation::operator=(const SparseDistributedRepresentation& value) {
+        assignDimensions_( value );
         setSDR( value );
         return *this;
     }
 
 
+    SparseDistributedRepresentation& SparseDistributedRepresentation::operator=(SparseDistributedRepresentation&& value) {
+        if( &value == this ) {
+            return *this;
+        }
+        assignDimensions_( value );
+        swapData_( value );
+        do_callbacks();
+        value.zero();
+        return *this;
+    }
+
+
     UInt SparseDistributedRepresentation::getOverlap(const SparseDistributedRepresentation &sdr) const {
         NTA_ASSERT( dimensions == sdr.dimensions );
 
         UInt ovlp = 0u;
-        const auto a = this->getDense();
-        const auto b = sdr.getDense();
-        for( UInt i = 0u; i < size; i++ )
-            ovlp += a[i] && b[i];
+        if( preferSparse_({ this, &sdr }, size) ) {
+            intersectSorted( sparse_, sdr.sparse_, [&ovlp](ElemSparse) { ovlp++; });
+            return ovlp;
+        }
+        const auto &a = this->getDenseBits();
+        const auto &b = sdr.getDenseBits();
+        for( size_t i = 0u; i < a.size(); i++ )
+            ovlp += popcount( a[i] & b[i] );
         return ovlp;
     }
 
@@ -296,14 +489,25 @@ namespace htm {
         randomize( sparsity, rng );
     }
 
-    void SparseDistributedRepresentation::randomize(Real sparsity, Random &rng) {
+    void SparseDistributedRepresentation::randomize(Real sparsity, Random &rng, const bool fast) {
         NTA_ASSERT( sparsity >= 0.0f and sparsity <= 1.0f );
         UInt nbits = (UInt) std::round( size * sparsity );
 
-        SDR_sparse_t range( size );
-        iota( range.begin(), range.end(), 0u );
-        sparse_ = rng.sample( range, nbits);
-        sort( sparse_.begin(), sparse_.end() );
+        if( fast ) {
+            const auto choices = rng.sampleIndices( size, nbits );
+            sparse_.assign( choices.begin(), choices.end() );
+        }
+        else if( nbits > 0u ) {
+            // Same draws as rng.sample(), without copying the population.
+            SDR_sparse_t range( size );
+            iota( range.begin(), range.end(), 0u );
+            rng.shuffle( range.begin(), range.end() );
+            sparse_.assign( range.begin(), range.begin() + nbits );
+            sort( sparse_.begin(), sparse_.end() );
+        }
+        else {
+            sparse_.clear();
+        }
         setSparseInplace();
     }
 
@@ -313,28 +517,57 @@ namespace htm {
         addNoise( fractionNoise, rng );
     }
 
-    void SparseDistributedRepresentation::addNoise(Real fractionNoise, Random &rng) {
+    void SparseDistributedRepresentation::addNoise(Real fractionNoise, Random &rng, const bool fast) {
         NTA_ASSERT( fractionNoise >= 0. and fractionNoise <= 1. );
         NTA_CHECK( ( 1 + fractionNoise) * getSparsity() <= 1. );
 
-        const UInt num_move_bits = (UInt) std::round( fractionNoise * getSum() );
-        const auto& turn_off = rng.sample(getSparse(), num_move_bits);
-
-        auto& dns = getDense();
+        const auto &active = getSparse();
+        const UInt num_move_bits = (UInt) std::round( fractionNoise * active.size() );
+        if( num_move_bits == 0u ) {
+            setSparseInplace();
+            return;
+        }
 
-        vector<UInt> off_pop;
-        for(UInt idx = 0; idx < size; idx++) {
-            if( dns[idx] == 0 )
-                off_pop.push_back( idx );
+        // Pick the active bits to turn off, and the inactive bits to turn on.
+        // The inactive bits are addressed by their rank among the inactive
+        // bits, so that they never need to be listed.
+        vector<ElemSparse> turn_off;
+        vector<UInt> turn_on_ranks;
+        if( fast ) {
+            for(const auto i : rng.sampleIndices( (UInt) active.size(), num_move_bits ))
+                turn_off.push_back( active[i] );
+            turn_on_ranks = rng.sampleIndices( size - (UInt) active.size(), num_move_bits );
+        }
+        else {
+            // Same draws as rng.sample() of the active & of the inactive bits.
+            turn_off = rng.sample( active, num_move_bits );
+            sort( turn_off.begin(), turn_off.end() );
+            turn_on_ranks.resize( size - active.size() );
+            iota( turn_on_ranks.begin(), turn_on_ranks.end(), 0u );
+            rng.shuffle( turn_on_ranks.begin(), turn_on_ranks.end() );
+            turn_on_ranks.resize( num_move_bits );
+            sort( turn_on_ranks.begin(), turn_on_ranks.end() );
         }
-        const vector<UInt> turn_on = rng.sample(off_pop, num_move_bits);
 
-        for( auto idx : turn_on )
-            dns[ idx ] = 1;
-        for( auto idx : turn_off )
-            dns[ idx ] = 0;
+        // Rank r of the inactive bits is index r + (number of active bits
+        // below that index).
+        vector<ElemSparse> turn_on;
+        turn_on.reserve( num_move_bits );
+        size_t numBelow = 0u;
+        for(const auto rank : turn_on_ranks) {
+            while( numBelow < active.size() and active[numBelow] <= rank + numBelow )
+                numBelow++;
+            turn_on.push_back( static_cast<ElemSparse>(rank + numBelow) );
+        }
 
-        setDenseInplace();
+        SDR_sparse_t kept;
+        kept.reserve( active.size() );
+        set_difference( active.begin(), active.end(), turn_off.begin(), turn_off.end(),
+                        back_inserter( kept ));
+        SDR_sparse_t result;
+        result.reserve( active.size() );
+        merge( kept.begin(), kept.end(), turn_on.begin(), turn_on.end(), back_inserter( result ));
+        setSparse( result );
     }
 
 
@@ -373,23 +606,44 @@ namespace htm {
                 inputs.pop_back();
             }
         }
+        auto all = inputs;
+        if( inplace ) {
+            all.push_back( this );
+        }
+        if( preferSparse_(all, size) ) {
+            // Sorted-set intersections, starting from the fewest true bits.
+            std::sort( all.begin(), all.end(), [](const SDR *a, const SDR *b)
+                { return a->sparse_.size() < b->sparse_.size(); });
+            SDR_sparse_t result( all[0]->sparse_ );
+            SDR_sparse_t next;
+            for( size_t i = 1u; i < all.size() and not result.empty(); i++ ) {
+                next.clear();
+                intersectSorted( result, all[i]->sparse_,
+                                 [&next](ElemSparse idx) { next.push_back( idx ); });
+                result.swap( next );
+            }
+            sparse_.swap( result );
+            SDR::setSparseInplace();
+            return;
+        }
         if( inplace ) {
-            getDense(); // Make sure that the dense data is valid.
+            getDenseBits(); // Make sure that the dense bits are valid.
         }
         if( not inplace ) {
             // Copy one of the SDRs over to the output SDR.
-            const auto &denseIn = inputs.back()->getDense();
-            dense_.assign( denseIn.begin(), denseIn.end() );
+            const auto &bitsIn = inputs.back()->getDenseBits();
+            denseBits_.assign( bitsIn.begin(), bitsIn.end() );
             inputs.pop_back();
             // inplace = true; // Now it's an inplace operation.
         }
+        // Whole words at a time.
         for(const auto &sdr_ptr : inputs) {
-            const auto &data = sdr_ptr->getDense();
-            for(auto z = 0u; z < data.size(); ++z) {
-                dense_[z] = dense_[z] && data[z];
+            const auto &data = sdr_ptr->getDenseBits();
+            for(size_t w = 0u; w < data.size(); ++w) {
+                denseBits_[w] &= data[w];
             }
         }
-        SDR::setDenseInplace();
+        SDR::setDenseBitsInplace();
     }
 
 
@@ -411,27 +665,58 @@ namespace htm {
                 inputs.pop_back();
             }
         }
+        auto all = inputs;
+        if( inplace ) {
+            all.push_back( this );
+        }
+        if( preferSparse_(all, size) ) {
+            // Sorted-set unions, starting from the fewest true bits.
+            std::sort( all.begin(), all.end(), [](const SDR *a, const SDR *b)
+                { return a->sparse_.size() < b->sparse_.size(); });
+            SDR_sparse_t result( all[0]->sparse_ );
+            SDR_sparse_t next;
+            for( size_t i = 1u; i < all.size(); i++ ) {
+                const auto &data = all[i]->sparse_;
+                next.resize( result.size() + data.size() );
+                next.erase( std::set_union( result.begin(), result.end(),
+                                            data.begin(), data.end(), next.begin() ),
+                            next.end() );
+                result.swap( next );
+            }
+            sparse_.swap( result );
+            SDR::setSparseInplace();
+            return;
+        }
         if( inplace ) {
-            getDense(); // Make sure that the dense data is valid.
+            getDenseBits(); // Make sure that the dense bits are valid.
         }
         if( not inplace ) {
             // Copy one of the SDRs over to the output SDR.
-            const auto &denseIn = inputs.back()->getDense();
-            dense_.assign( denseIn.begin(), denseIn.end() );
+            const auto &bitsIn = inputs.back()->getDenseBits();
+            denseBits_.assign( bitsIn.begin(), bitsIn.end() );
             inputs.pop_back();
             // inplace = true; // Now it's an inplace operation.
         }
+        // Whole words at a time.
         for(const auto &sdr_ptr : inputs) {
-            const auto &data = sdr_ptr->getDense();
-            for(auto z = 0u; z < data.size(); ++z) {
-                dense_[z] = dense_[z] || data[z];
+            const auto &data = sdr_ptr->getDenseBits();
+            for(size_t w = 0u; w < data.size(); ++w) {
+                denseBits_[w] |= data[w];
             }
         }
-        SDR::setDenseInplace();
+        SDR::setDenseBitsInplace();
     }
 
 
     void SparseDistributedRepresentation::concatenate(const std::vector<const SDR*>& inputs, const UInt axis)
+        { concatenate_( inputs, axis, nullptr ); }
+
+    void SparseDistributedRepresentation::concatenate(const std::vector<const SDR*>& inputs, const UInt axis,
+                                                      ThreadPool &pool)
+        { concatenate_( inputs, axis, &pool ); }
+
+    void SparseDistributedRepresentation::concatenate_(const std::vector<const SDR*>& inputs, const UInt axis,
+                                                       ThreadPool *pool)
     {
         // Check inputs.
         NTA_CHECK( inputs.size() >= 2u )
@@ -456,32 +741,70 @@ namespace htm {
             << "Axis of concatenation dimensions do not match, inputs sum to "
             << concat_axis_size << ", output expects " << dimensions[axis] << "!";
 
-        // Setup for copying the data as rows & strides.
-        vector<ElemDense*> buffers;
-        vector<UInt>       row_lengths;
+        // The data is copied as rows & strides: a row of an input is all of its
+        // bits at one position of the dimensions before the axis.  The output
+        // is one row of each input in turn.
+        vector<UInt> row_lengths;
+        UInt output_row = 0u;
+        size_t nnz = 0u;
+        bool sparse = true;
         for( const auto &sdr : inputs ) {
-            buffers.push_back( sdr->getDense().data() );
             UInt row = 1u;
             for(UInt d = axis; d < dimensions.size(); ++d)
                 row *= sdr->dimensions[d];
             row_lengths.push_back( row );
+            output_row += row;
+            sparse = sparse and sdr->sparse_valid;
+            if( sparse ) nnz += sdr->sparse_.size();
+        }
+        const auto n_inputs = inputs.size();
+
+        if( sparse and nnz < size / 8u ) {
+            // Move each true bit to its row & column in the output.
+            SDR_sparse_t result;
+            result.reserve( nnz );
+            UInt column_offset = 0u;
+            for( UInt i = 0u; i < n_inputs; ++i ) {
+                const Divider divider( row_lengths[i] );
+                for( const auto idx : inputs[i]->sparse_ ) {
+                    const UInt32 row    = divider.divide( idx );
+                    const UInt32 column = idx - row * divider.divisor;
+                    result.push_back( row * output_row + column_offset + column );
+                }
+                column_offset += row_lengths[i];
+            }
+            if( output_row != size ) { // more than one row, interleaved
+                std::sort( result.begin(), result.end() );
+            }
+            sparse_.swap( result );
+            SDR::setSparseInplace();
+            return;
+        }
+
+        vector<ElemDense*> buffers;
+        for( const auto &sdr : inputs ) {
+            buffers.push_back( sdr->getDense().data() );
         }
 
         // Get the output buffer.
         dense_.resize( size );
-              auto dense_data  = dense_.data();
-        const auto data_end    = dense_data + size;
-        const auto n_inputs    = inputs.size();
-        while( dense_data < data_end ) {
-            // Copy one row from each input SDR.
-            for( UInt i = 0u; i < n_inputs; ++i ) {
-                const auto &buf = buffers[i];
-                const auto &row = row_lengths[i];
-                std::copy( buf, buf + row, dense_data );
-                // Increment the pointers.
-                buffers[i] += row;
-                dense_data += row;
+        const auto copy_rows = [&](const size_t begin, const size_t end, size_t) {
+            auto dense_data = dense_.data() + begin * output_row;
+            for( size_t r = begin; r < end; ++r ) {
+                // Copy one row from each input SDR.
+                for( UInt i = 0u; i < n_inputs; ++i ) {
+                    const auto row = row_lengths[i];
+                    const auto buf = buffers[i] + r * row;
+                    std::copy( buf, buf + row, dense_data );
+                    dense_data += row;
+                }
             }
+        };
+        const size_t num_rows = output_row == 0u ? 0u : size / output_row;
+        if( pool != nullptr and size >= MIN_PARALLEL_CONCATENATE ) {
+            pool->parallelFor( num_rows, copy_rows );
+        } else {
+            copy_rows( 0u, num_rows, 0u );
         }
         SDR::setDenseInplace();
     }
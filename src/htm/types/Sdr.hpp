@@ -29,6 +29,7 @@
 
 #include <htm/types/Types.hpp>
 #include <htm/types/Serializable.hpp>
+#include <htm/types/SdrCodec.hpp>
 #include <htm/utils/Random.hpp>
 
 namespace htm {
@@ -39,8 +40,11 @@ using ElemSparse       = UInt32; //must match with connections::CellIdx
 using SDR_dense_t      = std::vector<ElemDense>;
 using SDR_sparse_t     = std::vector<ElemSparse>;
 using SDR_coordinate_t = std::vector<std::vector<UInt>>;
+using SDR_dense_bits_t = std::vector<UInt64>;
 using SDR_callback_t   = std::function<void()>;
 
+class ThreadPool;
+
 /**
  * SparseDistributedRepresentation class
  * Also known as "SDR" class
@@ -71,6 +75,11 @@ using SDR_callback_t   = std::function<void()>;
  *    useful because it contains the location of each true bit inside of the
  *    SDR's dimensional space.
  *
+ *    Dense Bits Format: The dense format packed into 64 bit words, bit i of
+ *    the flattened SDR is bit (i % 64) of word (i / 64), the unused high bits
+ *    of the last word are zero.  This format is 8 times smaller than the
+ *    dense format, and the set operations and overlaps work on whole words.
+ *
  * Array Memory Layout: This class uses C-order throughout, meaning that when
  * iterating through the SDR, the last/right-most index changes fastest.
  *
@@ -136,6 +145,7 @@ protected:
     mutable SDR_dense_t      dense_;
     mutable SDR_sparse_t     sparse_;
     mutable SDR_coordinate_t coordinates_;
+    mutable SDR_dense_bits_t denseBits_;
 
     /**
      * These flags remember which data formats are up-to-date and which formats
@@ -144,6 +154,7 @@ protected:
     mutable bool dense_valid;
     mutable bool sparse_valid;
     mutable bool coordinates_valid;
+    mutable bool denseBits_valid = false;
 
 private:
     /**
@@ -159,6 +170,14 @@ private:
      */
     mutable std::vector<SDR_callback_t> destroyCallbacks;
 
+    // The compressed() archives are versioned, the plain ones keep the
+    // unversioned layout (version 1).  An SDR always has dimensions, so none
+    // is the marker of the binary archives.
+    static const UInt32 COMPRESSED_ARCHIVE_VERSION = 2u;
+
+    // load_ar() checks the indices read from an archive against the size.
+    void checkLoadedSparse_() const;
+
 protected:
     /**
      * Remove the value from this SDR by clearing all of the valid flags.  Does
@@ -193,6 +212,13 @@ protected:
      */
     virtual void setCoordinatesInplace() const;
 
+    /**
+     * Update the SDR to reflect the value currently inside of the dense bits
+     * vector. Use this method after modifying the dense bits inplace, in
+     * order to propagate any changes to the other formats.
+     */
+    virtual void setDenseBitsInplace() const;
+
     /**
      * Destroy this SDR.  Makes SDR unusable, should error or clearly fail if
      * used.  Also sends notification to all watchers via destroyCallbacks.
@@ -201,6 +227,34 @@ protected:
      */
     virtual void deconstruct();
 
+    /**
+     * Swap the data in every format & the valid flags with the given SDR,
+     * which must have the same dimensions.  Does not notify anyone.
+     */
+    void swapData_( SparseDistributedRepresentation &value ) const;
+
+    /**
+     * Take the dimensions of the given SDR, for the assignment operators.
+     * The sizes must match, unless this SDR has no dimensions yet.
+     */
+    void assignDimensions_( const SparseDistributedRepresentation &value );
+
+    /**
+     * Implementations of getCoordinates() and concatenate(), @param pool may
+     * be nullptr.
+     */
+    void coordinatesFromSparse_( ThreadPool *pool ) const;
+    void concatenate_( const std::vector<const SparseDistributedRepresentation*>& inputs,
+                       const UInt axis,
+                       ThreadPool *pool );
+
+    /**
+     * @returns true if the set operations on these SDRs should use their
+     * sorted sparse indices, false for their dense bits (whole words).
+     */
+    static bool preferSparse_(const std::vector<const SparseDistributedRepresentation*> &inputs,
+                              const UInt size);
+
 public:
     /**
      * Use this method only in conjuction with sdr.initialize() or sdr.load().
@@ -226,6 +280,15 @@ public:
      */
     SparseDistributedRepresentation( const SparseDistributedRepresentation &value );
 
+    /**
+     * Initialize this SDR with the value of the given SDR, without copying
+     * the data.  The given SDR keeps its dimensions & callbacks, its value
+     * becomes all zeros.  Callbacks are not moved.
+     *
+     * @param value An SDR to take the value of.
+     */
+    SparseDistributedRepresentation( SparseDistributedRepresentation &&value );
+
     virtual ~SparseDistributedRepresentation();
 
     /**
@@ -406,6 +469,33 @@ public:
      */
     virtual SDR_coordinate_t& getCoordinates() const;
 
+    /**
+     * Same as getCoordinates(), SDRs with many true bits are converted on the
+     * threads of @param pool.
+     */
+    SDR_coordinate_t& getCoordinates(ThreadPool &pool) const;
+
+    /**
+     * Swap a new value into the SDR, replacing the current value.  This
+     * method is fast since it copies no data.  This method modifies its
+     * argument!
+     *
+     * @param value The dense bits (@see Dense Bits Format above) to swap into
+     * the SDR, (size + 63) / 64 words.
+     * @throws The unused high bits of the last word must be zero.
+     */
+    void setDenseBits( SDR_dense_bits_t &value );
+
+    /**
+     * Gets the current value of the SDR, packed into 64 bit words.  The result
+     * of this method call is cached inside of this SDR until the SDRs value
+     * changes.  After modifying the words you MUST call sdr.setDenseBits() in
+     * order to notify the SDR that its dense bits have changed.
+     *
+     * @returns A reference to the (size + 63) / 64 words of the SDR.
+     */
+    virtual SDR_dense_bits_t& getDenseBits() const;
+
     /**
      * Deep Copy the given SDR to this SDR.  This overwrites the current value of
      * this SDR.  This SDR and the given SDR will have no shared data and they
@@ -415,8 +505,20 @@ public:
      */
     virtual void setSDR( const SparseDistributedRepresentation &value );
 
+    /**
+     * Copy the value of the given SDR into this SDR, @see setSDR.  This SDR
+     * takes the dimensions of the given SDR; the sizes must match, unless
+     * this SDR has no dimensions yet.
+     */
     SparseDistributedRepresentation& operator=(const SparseDistributedRepresentation& value);
 
+    /**
+     * Move the value of the given SDR into this SDR, without copying the data,
+     * @see the move constructor.  The dimensions are assigned as by the copy
+     * assignment.
+     */
+    SparseDistributedRepresentation& operator=(SparseDistributedRepresentation&& value);
+
     /**
      * Calculates the number of true / non-zero values in the SDR.
      *
@@ -454,10 +556,14 @@ public:
      *
      * @param rng The random number generator to draw from.  If not given, this
      * makes one using the magic seed 0.
+     *
+     * @param fast If true, draws only as many random numbers as there are true
+     * bits, @see Random::sampleIndices().  The default draws one per bit of the
+     * SDR, which gives the same SDRs as previous versions for the same rng.
      */
     void randomize(Real sparsity);
 
-    void randomize(Real sparsity, Random &rng);
+    void randomize(Real sparsity, Random &rng, bool fast = false);
 
     /**
      * Modify the SDR by moving a fraction of the active bits to different
@@ -470,10 +576,13 @@ public:
      *
      * @param rng The random number generator to draw from.  If not given, this
      * makes one using the magic seed 0.
+     *
+     * @param fast If true, draws only as many random numbers as there are bits
+     * to move, see randomize().  Neither way uses the dense format.
      */
     void addNoise(Real fractionNoise);
 
-    void addNoise(Real fractionNoise, Random &rng);
+    void addNoise(Real fractionNoise, Random &rng, bool fast = false);
 
     /**
      * Modify the SDR by setting a fraction of the bits to zero.
@@ -570,6 +679,14 @@ public:
     void concatenate(const std::vector<const SparseDistributedRepresentation*>& inputs,
                      const UInt axis = 0u);
 
+    /**
+     * Same as concatenate(inputs, axis), large dense SDRs are copied on the
+     * threads of @param pool.
+     */
+    void concatenate(const std::vector<const SparseDistributedRepresentation*>& inputs,
+                     const UInt axis,
+                     ThreadPool &pool);
+
     /**
      * Print a human readable version of the SDR.
      * Sample output:  
@@ -612,11 +729,50 @@ public:
     template<class Archive>
     void load_ar(Archive & ar)
     {
-        ar( dimensions_, sparse_ );
+        const UInt32 version = loadArchiveVersion( ar, "dimensions", dimensions_,
+                                                   std::vector<UInt>(), 1u );
+        NTA_CHECK( version <= COMPRESSED_ARCHIVE_VERSION ) << "Unknown archive version " << version;
+        if( version >= 2u ) {
+            SDR_encoded_t encoded;
+            ar( cereal::make_nvp("encoded", encoded) );
+            decodeSparse( encoded, 0u, sparse_ );
+        }
+        else {
+            ar( cereal::make_nvp("sparse", sparse_) );
+        }
         initialize( dimensions_ );
+        checkLoadedSparse_();
         setSparseInplace();
     }
 
+    /**
+     * The SDR in the delta + varint encoding, for an archive.  It is 2 - 4
+     * times smaller than the plain list of sparse indices for typical SDRs,
+     * @see encodeSparse().  The format is chosen by each save, load_ar()
+     * reads both:
+     *
+     *     ar( cereal::make_nvp("sdr", sdr.compressed()) ); // in save_ar()
+     *     ar( cereal::make_nvp("sdr", sdr) );              // in load_ar()
+     */
+    class Compressed {
+    public:
+        explicit Compressed( const SparseDistributedRepresentation &sdr ) : sdr_( sdr ) {}
+
+        template<class Archive>
+        void save_ar( Archive & ar ) const
+        {
+            SDR_encoded_t encoded;
+            encodeSparse( sdr_.getSparse(), encoded );
+            saveArchiveVersion( ar, std::vector<UInt>(), COMPRESSED_ARCHIVE_VERSION );
+            ar(cereal::make_nvp("dimensions", sdr_.dimensions_),
+               cereal::make_nvp("encoded",    encoded) );
+        }
+
+    private:
+        const SparseDistributedRepresentation &sdr_;
+    };
+    Compressed compressed() const { return Compressed( *this ); }
+
     /**
      * Callbacks notify you when this SDR's value changes.
      *
@@ -0,0 +1,166 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SDR codec
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <htm/types/SdrCodec.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Log.hpp>
+
+using std::vector;
+
+namespace htm {
+
+namespace {
+  const char   STREAM_MAGIC[4] = {'S', 'D', 'R', 'S'};
+  const UInt64 STREAM_VERSION  = 1u;
+
+  // Reads a varint byte by byte, @returns false at the end of the stream.
+  bool readVarint(std::istream &in, UInt64 &value) {
+    value = 0u;
+    for(UInt shift = 0u; shift < 64u; shift += 7u) {
+      const auto c = in.get();
+      if( c == std::char_traits<char>::eof() ) {
+        NTA_CHECK(shift == 0u) << "SDR stream: truncated data.";
+        return false;
+      }
+      value |= static_cast<UInt64>(c & 0x7F) << shift;
+      if( (c & 0x80) == 0 ) return true;
+    }
+    NTA_THROW << "SDR stream: corrupt varint.";
+  }
+} // end anonymous namespace
+
+
+void putVarint(UInt64 value, SDR_encoded_t &out) {
+  while( value >= 0x80u ) {
+    out.push_back(static_cast<Byte>((value & 0x7Fu) | 0x80u));
+    value >>= 7;
+  }
+  out.push_back(static_cast<Byte>(value));
+}
+
+UInt64 getVarint(const SDR_encoded_t &in, size_t &offset) {
+  UInt64 value = 0u;
+  for(UInt shift = 0u; shift < 64u; shift += 7u) {
+    NTA_CHECK(offset < in.size()) << "SDR codec: truncated data.";
+    const auto byte = static_cast<unsigned char>(in[offset++]);
+    value |= static_cast<UInt64>(byte & 0x7Fu) << shift;
+    if( (byte & 0x80u) == 0u ) return value;
+  }
+  NTA_THROW << "SDR codec: corrupt varint.";
+}
+
+
+void encodeSparse(const vector<UInt32> &sparse, SDR_encoded_t &encoded) {
+  putVarint(sparse.size(), encoded);
+  UInt64 next = 0u; //smallest possible value of the next index
+  for(const auto index : sparse) {
+    NTA_ASSERT(index >= next) << "SDR codec: sparse data must be sorted and contain no duplicates.";
+    putVarint(index - next, encoded);
+    next = static_cast<UInt64>(index) + 1u;
+  }
+}
+
+
+size_t decodeSparse(const SDR_encoded_t &encoded, size_t offset, vector<UInt32> &sparse) {
+  const UInt64 count = getVarint(encoded, offset);
+  // every index takes at least one byte, this guards the resize against corrupt counts
+  NTA_CHECK(count <= encoded.size() - offset) << "SDR codec: truncated data.";
+  sparse.resize(static_cast<size_t>(count));
+  UInt64 next = 0u;
+  for(auto &index : sparse) {
+    const UInt64 value = next + getVarint(encoded, offset);
+    NTA_CHECK(value <= std::numeric_limits<UInt32>::max()) << "SDR codec: index out of range.";
+    index = static_cast<UInt32>(value);
+    next  = value + 1u;
+  }
+  return offset;
+}
+
+
+SDRStreamWriter::SDRStreamWriter(std::ostream &out, const vector<UInt> &dimensions)
+  : out_(out), dimensions_(dimensions) {
+  buffer_.assign(STREAM_MAGIC, STREAM_MAGIC + sizeof(STREAM_MAGIC));
+  putVarint(STREAM_VERSION, buffer_);
+  putVarint(dimensions_.size(), buffer_);
+  for(const auto dim : dimensions_) putVarint(dim, buffer_);
+  out_.write(buffer_.data(), buffer_.size());
+  NTA_CHECK(out_.good()) << "SDR stream: write failed.";
+}
+
+
+void SDRStreamWriter::write(const SDR &sdr) {
+  NTA_CHECK(sdr.dimensions == dimensions_) << "SDR stream: the SDR has other dimensions than the stream.";
+  // Each record is prefixed by its length, so that it is read in one block.
+  SDR_encoded_t &payload = buffer_;
+  payload.clear();
+  encodeSparse(sdr.getSparse(), payload);
+  const size_t payloadSize = payload.size();
+  // the length goes behind the payload in the buffer, but is written first
+  putVarint(payloadSize, payload);
+  out_.write(payload.data() + payloadSize, payload.size() - payloadSize);
+  out_.write(payload.data(), payloadSize);
+  NTA_CHECK(out_.good()) << "SDR stream: write failed.";
+  numWritten_++;
+}
+
+
+SDRStreamReader::SDRStreamReader(std::istream &in)
+  : in_(in) {
+  char magic[sizeof(STREAM_MAGIC)];
+  in_.read(magic, sizeof(magic));
+  NTA_CHECK(in_.good() and std::equal(magic, magic + sizeof(magic), STREAM_MAGIC))
+    << "SDR stream: not an SDR stream.";
+  UInt64 version = 0u, numDims = 0u, dim = 0u;
+  NTA_CHECK(readVarint(in_, version) and version == STREAM_VERSION)
+    << "SDR stream: unsupported version " << version;
+  NTA_CHECK(readVarint(in_, numDims) and numDims > 0u) << "SDR stream: no dimensions.";
+  size_ = 1u;
+  for(UInt64 i = 0u; i < numDims; i++) {
+    NTA_CHECK(readVarint(in_, dim)) << "SDR stream: truncated header.";
+    dimensions_.push_back(static_cast<UInt>(dim));
+    size_ *= static_cast<UInt>(dim);
+  }
+}
+
+
+bool SDRStreamReader::read(SDR &sdr) {
+  UInt64 length = 0u;
+  if( not readVarint(in_, length) ) return false;
+  buffer_.resize(static_cast<size_t>(length));
+  in_.read(buffer_.data(), buffer_.size());
+  NTA_CHECK(static_cast<size_t>(in_.gcount()) == buffer_.size()) << "SDR stream: truncated data.";
+  const size_t end = decodeSparse(buffer_, 0u, sparse_);
+  NTA_CHECK(end == buffer_.size()) << "SDR stream: corrupt record.";
+  NTA_CHECK(sparse_.empty() or sparse_.back() < size_) << "SDR stream: index out of range.";
+
+  if( sdr.size == size_ and not sdr.dimensions.empty() ) {
+    sdr.reshape(dimensions_);
+  } else {
+    sdr.initialize(dimensions_);
+  }
+  sdr.setSparse(sparse_); //swaps, sparse_ gets the previous buffer of the SDR
+  return true;
+}
+
+} // end namespace htm
@@ -0,0 +1,137 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Compressed encoding of SDRs, for archives and bulk streams of SDRs.
+ */
+
+#ifndef NTA_SDR_CODEC_HPP
+#define NTA_SDR_CODEC_HPP
+
+#include <iostream>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+class SparseDistributedRepresentation;
+
+using SDR_encoded_t = std::vector<Byte>;
+
+/**
+ * Appends @param value to @param out as a LEB128 varint, @see encodeSparse().
+ */
+void putVarint(UInt64 value, SDR_encoded_t &out);
+
+/**
+ * Reads the varint at @param offset of @param in and advances the offset.
+ * @throws If the varint is truncated or corrupt.
+ */
+UInt64 getVarint(const SDR_encoded_t &in, size_t &offset);
+
+/**
+ * Delta + varint encoding of sparse indices.
+ *
+ * The encoding is the number of indices followed by the gaps between
+ * consecutive indices (the first index, then index[i] - index[i-1] - 1), each
+ * as a LEB128 varint: 7 bits per byte, the high bit set on all but the last
+ * byte of a number.  Gaps in typical SDRs (2% - 5% sparsity) fit in one or
+ * two bytes, instead of the 4 bytes of a plain index.
+ *
+ * @param sparse Sorted indices without duplicates.
+ * @param encoded Output, the encoding is appended to it.
+ */
+void encodeSparse(const std::vector<UInt32> &sparse, SDR_encoded_t &encoded);
+
+/**
+ * Inverse of encodeSparse().
+ *
+ * @param encoded Buffer with the encoding at @param offset.
+ * @param sparse Output, the decoded indices.
+ * @returns The offset in @param encoded after the decoded data.
+ * @throws If the encoding is truncated or corrupt.
+ */
+size_t decodeSparse(const SDR_encoded_t &encoded, size_t offset, std::vector<UInt32> &sparse);
+
+
+/**
+ * Writes a stream of SDRs of the same dimensions, eg. a recording of the
+ * inputs or outputs of a region.  The stream starts with a small header with
+ * the dimensions, followed by encodeSparse() of each SDR.
+ *
+ * Example Usage:
+ *    std::ofstream file("recording.sdrs", std::ios::binary);
+ *    SDRStreamWriter writer(file, {1000u});
+ *    for(...) writer.write( sdr );
+ *
+ * @see SDRStreamReader
+ */
+class SDRStreamWriter
+{
+public:
+  SDRStreamWriter(std::ostream &out, const std::vector<UInt> &dimensions);
+
+  /**
+   * Append @param sdr, which must have the dimensions of the stream.
+   */
+  void write(const SparseDistributedRepresentation &sdr);
+
+  size_t numWritten() const noexcept { return numWritten_; }
+
+private:
+  std::ostream &out_;
+  std::vector<UInt> dimensions_;
+  size_t numWritten_ = 0u;
+  SDR_encoded_t buffer_; //reused scratch
+};
+
+
+/**
+ * Reads the SDRs of a stream written by SDRStreamWriter, in order.
+ */
+class SDRStreamReader
+{
+public:
+  /**
+   * Reads the header of the stream.
+   * @throws If @param in is not an SDR stream.
+   */
+  explicit SDRStreamReader(std::istream &in);
+
+  const std::vector<UInt> &getDimensions() const noexcept { return dimensions_; }
+
+  /**
+   * Reads the next SDR of the stream into @param sdr, which is reshaped or
+   * initialized to the dimensions of the stream.
+   *
+   * @returns false at the end of the stream, @param sdr is not changed.
+   * @throws If the stream is truncated or corrupt.
+   */
+  bool read(SparseDistributedRepresentation &sdr);
+
+private:
+  std::istream &in_;
+  std::vector<UInt> dimensions_;
+  UInt size_ = 0u;
+  SDR_encoded_t buffer_; //reused scratch
+  std::vector<UInt32> sparse_; //reused scratch
+};
+
+} // end namespace htm
+
+#endif // NTA_SDR_CODEC_HPP
@@ -0,0 +1,222 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SDRIndex class
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include <htm/types/SdrIndex.hpp>
+
+using std::vector;
+
+namespace htm {
+
+namespace {
+  // The finalizer of splitmix64, a cheap hash with good avalanche.
+  inline UInt64 mix(UInt64 x) {
+    x ^= x >> 30u;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27u;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31u;
+    return x;
+  }
+} // end anonymous namespace
+
+
+void SDRIndex::initialize(const vector<UInt> &dimensions, const UInt numBands,
+                          const UInt rowsPerBand, const UInt seed) {
+  NTA_CHECK(numBands == 0u or rowsPerBand > 0u) << "SDRIndex: rowsPerBand must be > 0";
+  numBands_    = numBands;
+  rowsPerBand_ = rowsPerBand;
+  seed_        = seed;
+  store_.initialize(dimensions);
+  removed_.clear();
+  rebuild_();
+}
+
+
+UInt SDRIndex::add(const SDR &sdr) {
+  NTA_CHECK(store_.numSDRs() < std::numeric_limits<UInt>::max()) << "SDRIndex is full";
+  const UInt id = static_cast<UInt>(store_.add(sdr));
+  removed_.push_back(0u);
+  insert_(id);
+  return id;
+}
+
+
+void SDRIndex::remove(const UInt id) {
+  NTA_CHECK(id < numEntries()) << "SDRIndex: no entry " << id;
+  if( removed_[id] ) return;
+  removed_[id] = 1u;
+  numRemoved_++;
+}
+
+
+void SDRIndex::compact() {
+  rebuild_();
+}
+
+
+void SDRIndex::rebuild_() {
+  postings_.assign(store_.getSize(), vector<UInt>());
+  buckets_.assign(numBands_, std::unordered_map<UInt64, vector<UInt>>());
+  numRemoved_ = 0u;
+  for(UInt id = 0u; id < numEntries(); id++) {
+    if( removed_[id] ) numRemoved_++;
+    else insert_(id);
+  }
+  counts_.clear();
+  touched_.clear();
+}
+
+
+void SDRIndex::insert_(const UInt id) {
+  const auto entry = store_[id];
+  for(const auto bit : entry) {
+    postings_[bit].push_back(id);
+  }
+  if( numBands_ > 0u ) {
+    bandKeys_(entry.begin(), entry.end(), keys_);
+    for(UInt band = 0u; band < keys_.size(); band++) {
+      buckets_[band][keys_[band]].push_back(id);
+    }
+  }
+}
+
+
+void SDRIndex::bandKeys_(const ElemSparse *begin, const ElemSparse *end, vector<UInt64> &keys) const {
+  keys.clear();
+  if( begin == end ) return; // an empty SDR is similar to nothing
+  for(UInt band = 0u; band < numBands_; band++) {
+    UInt64 key = mix(band);
+    for(UInt row = 0u; row < rowsPerBand_; row++) {
+      // The hash function of this row: a permutation of the bits.
+      const UInt64 rowSeed = mix((static_cast<UInt64>(seed_) << 32u) + band * rowsPerBand_ + row);
+      UInt64 minHash = std::numeric_limits<UInt64>::max();
+      for(auto bit = begin; bit != end; ++bit) {
+        minHash = std::min(minHash, mix(rowSeed ^ *bit));
+      }
+      key = mix(key ^ minHash);
+    }
+    keys.push_back(key);
+  }
+}
+
+
+void SDRIndex::getOverlaps(const SDR &query, vector<UInt> &overlaps) const {
+  NTA_CHECK(query.size == store_.getSize()) << "SDRIndex: the query has " << query.size
+      << " bits, expected " << store_.getSize();
+  overlaps.assign(numEntries(), 0u);
+  UInt *counts = overlaps.data();
+  for(const auto bit : query.getSparse()) {
+    for(const auto id : postings_[bit]) {
+      counts[id]++;
+    }
+  }
+  if( numRemoved_ > 0u ) {
+    for(UInt id = 0u; id < numEntries(); id++) {
+      if( removed_[id] ) overlaps[id] = 0u;
+    }
+  }
+}
+
+
+vector<SDRIndex::Match> SDRIndex::search(const SDR &query, const size_t k, const UInt minOverlap) const {
+  NTA_CHECK(query.size == store_.getSize()) << "SDRIndex: the query has " << query.size
+      << " bits, expected " << store_.getSize();
+  counts_.resize(numEntries(), 0u);
+  UInt *counts = counts_.data();
+  for(const auto bit : query.getSparse()) {
+    for(const auto id : postings_[bit]) {
+      if( counts[id]++ == 0u ) touched_.push_back(id);
+    }
+  }
+  return select_(k, minOverlap);
+}
+
+
+vector<SDRIndex::Match> SDRIndex::searchApproximate(const SDR &query, const size_t k, const UInt minOverlap) const {
+  NTA_CHECK(numBands_ > 0u) << "SDRIndex: approximate search requires numBands > 0";
+  NTA_CHECK(query.size == store_.getSize()) << "SDRIndex: the query has " << query.size
+      << " bits, expected " << store_.getSize();
+  const auto &sparse = query.getSparse();
+  bandKeys_(sparse.data(), sparse.data() + sparse.size(), keys_);
+  counts_.resize(numEntries(), 0u);
+  // Candidates are marked by their overlap + 1, as an overlap may be 0.
+  for(UInt band = 0u; band < keys_.size(); band++) {
+    const auto bucket = buckets_[band].find(keys_[band]);
+    if( bucket == buckets_[band].end() ) continue;
+    for(const auto id : bucket->second) {
+      if( counts_[id] != 0u ) continue;
+      counts_[id] = store_[id].getOverlap(query) + 1u;
+      touched_.push_back(id);
+    }
+  }
+  for(const auto id : touched_) {
+    counts_[id]--;
+  }
+  return select_(k, minOverlap);
+}
+
+
+vector<SDRIndex::Match> SDRIndex::select_(const size_t k, const UInt minOverlap) const {
+  vector<Match> matches;
+  for(const auto id : touched_) {
+    if( counts_[id] >= minOverlap and not removed_[id] ) {
+      matches.emplace_back(id, counts_[id]);
+    }
+    counts_[id] = 0u;
+  }
+  touched_.clear();
+
+  const auto better = [](const Match &a, const Match &b) {
+    return a.second > b.second or (a.second == b.second and a.first < b.first);
+  };
+  if( matches.size() > k ) {
+    std::partial_sort(matches.begin(), matches.begin() + k, matches.end(), better);
+    matches.resize(k);
+  } else {
+    std::sort(matches.begin(), matches.end(), better);
+  }
+  return matches;
+}
+
+
+size_t SDRIndex::memoryUsage() const {
+  size_t bytes = store_.numIndices() * sizeof(ElemSparse) + numEntries() * (sizeof(size_t) + sizeof(UInt8));
+  for(const auto &postings : postings_) {
+    bytes += postings.capacity() * sizeof(UInt);
+  }
+  for(const auto &buckets : buckets_) {
+    for(const auto &bucket : buckets) {
+      bytes += sizeof(bucket) + 2u * sizeof(void*) + bucket.second.capacity() * sizeof(UInt);
+    }
+  }
+  return bytes;
+}
+
+
+bool SDRIndex::operator==(const SDRIndex &other) const {
+  return numBands_ == other.numBands_ and rowsPerBand_ == other.rowsPerBand_ and
+         seed_ == other.seed_ and store_ == other.store_ and removed_ == other.removed_;
+}
+
+} // end namespace htm
@@ -0,0 +1,197 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SDRIndex class
+ */
+
+#ifndef NTA_SDR_INDEX_HPP
+#define NTA_SDR_INDEX_HPP
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <htm/types/Sdr.hpp>
+#include <htm/types/SdrStore.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * SDRIndex - a collection of SDRs searchable by overlap, ex: the nearest
+ * neighbours of an SP output among millions of stored outputs.
+ *
+ * @b Description
+ * Every bit has a posting list of the entries which have it.  The overlaps
+ * of a query with all entries are the counts of the entries in the posting
+ * lists of its active bits, so a search touches only the entries which
+ * share a bit with the query, instead of every entry like SDR::getOverlap
+ * in a loop.  The entries themselves are kept in an SDRStore.
+ *
+ * For approximate search the index can also hash the entries into buckets
+ * by MinHash banding: an entry lands in one bucket per band, keyed by
+ * rowsPerBand min-hashes of its active bits.  Entries with a high Jaccard
+ * similarity to the query share a bucket with it in some band with high
+ * probability; searchApproximate() ranks only those candidates.  More rows
+ * per band give fewer and closer candidates, more bands a better recall.
+ *
+ * Entries get consecutive ids.  remove() only marks an entry, the searches
+ * skip it and compact() drops it from the posting lists and buckets; the
+ * ids of the other entries do not change.
+ *
+ * The searches use scratch memory of the index, so concurrent searches
+ * need one index per thread.
+ *
+ * Example Usage:
+ *    SDRIndex index({ 2048u });
+ *    for( ... ) index.add( sdr );
+ *    auto nearest = index.search( query, 10u ); // [(id, overlap)]
+ */
+class SDRIndex : public Serializable
+{
+public:
+  /** A search result: (entry id, overlap with the query). */
+  typedef std::pair<UInt, UInt> Match;
+
+  SDRIndex() {}
+
+  /**
+   * @param dimensions Of the SDRs.
+   * @param numBands Number of MinHash bands, 0 for no approximate search.
+   * @param rowsPerBand Number of min-hashes per band.
+   * @param seed Of the hash functions.
+   */
+  explicit SDRIndex(const std::vector<UInt> &dimensions,
+                    UInt numBands = 0u, UInt rowsPerBand = 4u, UInt seed = 42u)
+    { initialize(dimensions, numBands, rowsPerBand, seed); }
+
+  /**
+   * Sets the parameters and removes all entries.  @see SDRIndex().
+   */
+  void initialize(const std::vector<UInt> &dimensions,
+                  UInt numBands = 0u, UInt rowsPerBand = 4u, UInt seed = 42u);
+
+  const std::vector<UInt> &getDimensions() const noexcept { return store_.getDimensions(); }
+  UInt getSize() const noexcept { return store_.getSize(); }
+  UInt getNumBands() const noexcept { return numBands_; }
+  UInt getRowsPerBand() const noexcept { return rowsPerBand_; }
+
+  /** Number of entries, including the removed ones which were not compacted. */
+  size_t numEntries() const noexcept { return store_.numSDRs(); }
+  /** Number of entries which were not removed. */
+  size_t size() const noexcept { return numEntries() - numRemoved_; }
+
+  /**
+   * Add a copy of the SDR, which must have the dimensions of the index.
+   * @returns the id of the new entry.
+   */
+  UInt add(const SDR &sdr);
+
+  /**
+   * Remove an entry from the search results.
+   */
+  void remove(UInt id);
+  bool isRemoved(UInt id) const { return removed_[id] != 0u; }
+
+  /** The SDR of an entry, which keeps its value after remove(). */
+  SDRStore::View operator[](UInt id) const { return store_[id]; }
+
+  /**
+   * Drops the removed entries from the posting lists and the buckets.
+   */
+  void compact();
+
+  /**
+   * The overlaps of the query with all entries, 0 for the removed ones.
+   */
+  void getOverlaps(const SDR &query, std::vector<UInt> &overlaps) const;
+
+  /**
+   * Exact search.
+   *
+   * @param query SDR with the dimensions of the index.
+   * @param k Maximum number of results.
+   * @param minOverlap Minimum overlap of a result.
+   * @returns the k entries with the largest overlaps, largest first, ties
+   * by increasing id.
+   */
+  std::vector<Match> search(const SDR &query, size_t k, UInt minOverlap = 1u) const;
+
+  /**
+   * Approximate search: ranks only the entries which share a bucket with
+   * the query in at least one band.  Requires numBands > 0.
+   * @see search().
+   */
+  std::vector<Match> searchApproximate(const SDR &query, size_t k, UInt minOverlap = 1u) const;
+
+  /**
+   * Estimate the heap memory held by the entries and the index, in bytes.
+   */
+  size_t memoryUsage() const;
+
+  bool operator==(const SDRIndex &other) const;
+  inline bool operator!=(const SDRIndex &other) const { return not operator==(other); }
+
+  // Serialization, of the entries: the posting lists & buckets are rebuilt.
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(numBands_),
+       CEREAL_NVP(rowsPerBand_),
+       CEREAL_NVP(seed_),
+       CEREAL_NVP(store_),
+       CEREAL_NVP(removed_));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(CEREAL_NVP(numBands_),
+       CEREAL_NVP(rowsPerBand_),
+       CEREAL_NVP(seed_),
+       CEREAL_NVP(store_),
+       CEREAL_NVP(removed_));
+    NTA_CHECK(removed_.size() == store_.numSDRs());
+    rebuild_();
+  }
+
+private:
+  void rebuild_();
+  void insert_(UInt id);
+  void bandKeys_(const ElemSparse *begin, const ElemSparse *end, std::vector<UInt64> &keys) const;
+  std::vector<Match> select_(size_t k, UInt minOverlap) const;
+
+  UInt numBands_ = 0u;
+  UInt rowsPerBand_ = 0u;
+  UInt seed_ = 0u;
+  SDRStore store_;
+  std::vector<UInt8> removed_; // per entry
+  size_t numRemoved_ = 0u;
+
+  // derived
+  std::vector<std::vector<UInt>> postings_; // per bit, the ids in increasing order
+  std::vector<std::unordered_map<UInt64, std::vector<UInt>>> buckets_; // per band
+
+  // scratch of the searches
+  mutable std::vector<UInt> counts_;  // per entry, 0 between searches
+  mutable std::vector<UInt> touched_; // the entries with a count
+  mutable std::vector<UInt64> keys_;
+};
+
+} // end namespace htm
+
+#endif // NTA_SDR_INDEX_HPP
@@ -0,0 +1,136 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SDRStore class
+ */
+
+#include <htm/types/SdrStore.hpp>
+#include <htm/utils/SortedIntersection.hpp>
+
+using std::vector;
+
+namespace htm {
+
+namespace {
+  // Number of common values of two sorted ranges.
+  UInt countCommon(const ElemSparse *a, const ElemSparse *aEnd,
+                   const ElemSparse *b, const ElemSparse *bEnd) {
+    UInt common = 0u;
+    intersectSorted(a, aEnd, b, bEnd, [&common](ElemSparse) { common++; });
+    return common;
+  }
+} // end anonymous namespace
+
+
+UInt SDRStore::View::getOverlap(const View &other) const {
+  NTA_CHECK(size == other.size);
+  return countCommon(begin_, end_, other.begin_, other.end_);
+}
+
+
+UInt SDRStore::View::getOverlap(const SDR &sdr) const {
+  NTA_CHECK(size == sdr.size);
+  const auto &sparse = sdr.getSparse();
+  return countCommon(begin_, end_, sparse.data(), sparse.data() + sparse.size());
+}
+
+
+void SDRStore::View::copyTo(SDR &sdr) const {
+  NTA_CHECK(size == sdr.size);
+  sdr.setSparse(begin_, getSum());
+}
+
+
+void SDRStore::initialize(const vector<UInt> &dimensions) {
+  NTA_CHECK(not dimensions.empty()) << "SDRStore has no dimensions!";
+  dimensions_ = dimensions;
+  size_ = 1u;
+  for(const auto dim : dimensions_) size_ *= dim;
+  clear();
+}
+
+
+void SDRStore::reserve(const size_t numSDRs, const size_t numIndices) {
+  offsets_.reserve(numSDRs + 1u);
+  indices_.reserve(numIndices);
+}
+
+
+size_t SDRStore::add(const SDR &sdr) {
+  NTA_CHECK(sdr.size == size_) << "SDRStore: the SDR has " << sdr.size << " bits, expected " << size_;
+  const auto &sparse = sdr.getSparse();
+  indices_.insert(indices_.end(), sparse.cbegin(), sparse.cend());
+  offsets_.push_back(indices_.size());
+  return numSDRs() - 1u;
+}
+
+
+size_t SDRStore::add(const SDR_sparse_t &sparse) {
+  for(size_t i = 0; i < sparse.size(); i++) {
+    NTA_CHECK(sparse[i] < size_) << "SDRStore: index " << sparse[i] << " out of range.";
+    NTA_CHECK(i == 0u or sparse[i - 1u] < sparse[i]) << "SDRStore: sparse data must be sorted and contain no duplicates.";
+  }
+  indices_.insert(indices_.end(), sparse.cbegin(), sparse.cend());
+  offsets_.push_back(indices_.size());
+  return numSDRs() - 1u;
+}
+
+
+void SDRStore::checkArchive_() const {
+  NTA_CHECK(not offsets_.empty() and offsets_.front() == 0u and offsets_.back() == indices_.size())
+      << "SDRStore: the offsets do not span the indices.";
+  for(size_t i = 1u; i < offsets_.size(); i++) {
+    NTA_CHECK(offsets_[i - 1u] <= offsets_[i]) << "SDRStore: the offsets must be non-decreasing.";
+    for(auto idx = offsets_[i - 1u]; idx < offsets_[i]; idx++) {
+      NTA_CHECK(indices_[idx] < size_) << "SDRStore: index " << indices_[idx] << " out of range.";
+      NTA_CHECK(idx == offsets_[i - 1u] or indices_[idx - 1u] < indices_[idx])
+          << "SDRStore: sparse data must be sorted and contain no duplicates.";
+    }
+  }
+}
+
+
+void SDRStore::getOverlaps(const SDR &sdr, vector<UInt> &overlaps) const {
+  NTA_CHECK(sdr.size == size_);
+  const auto &dense = sdr.getDense();
+  overlaps.resize(numSDRs());
+  const ElemSparse *index = indices_.data();
+  for(size_t i = 0; i < overlaps.size(); i++) {
+    const ElemSparse *end = indices_.data() + offsets_[i + 1u];
+    UInt overlap = 0u;
+    for(; index != end; ++index) {
+      overlap += dense[*index] != 0;
+    }
+    overlaps[i] = overlap;
+  }
+}
+
+
+void SDRStore::clear() {
+  offsets_.assign(1u, 0u);
+  indices_.clear();
+}
+
+
+bool SDRStore::operator==(const SDRStore &other) const {
+  return dimensions_ == other.dimensions_ and
+         offsets_    == other.offsets_    and
+         indices_    == other.indices_;
+}
+
+} // end namespace htm
@@ -0,0 +1,172 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SDRStore class
+ */
+
+#ifndef NTA_SDR_STORE_HPP
+#define NTA_SDR_STORE_HPP
+
+#include <vector>
+
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * SDRStore - a large collection of SDRs with the same dimensions.
+ *
+ * @b Description
+ * The sparse indices of all SDRs are kept back to back in one vector, the
+ * SDR i is indices_[offsets_[i] .. offsets_[i+1]).  An entry costs its
+ * indices plus one offset, compared to the several vectors, the caches and
+ * the callbacks of an SDR object, and scanning the collection reads
+ * contiguous memory.
+ *
+ * Entries are appended and read through SDRStore::View, a pointer pair
+ * which can compute overlaps without converting back to an SDR.  Views are
+ * invalidated by add(), as is any reference into a std::vector.
+ *
+ * Example Usage:
+ *    SDRStore store({ 2048u });
+ *    for( ... ) store.add( sdr );
+ *    for( size_t i = 0; i < store.numSDRs(); i++ )
+ *        score[i] = store[i].getOverlap( query );
+ */
+class SDRStore : public Serializable
+{
+public:
+  /**
+   * Read-only view of one entry of the store.
+   */
+  class View {
+  public:
+    View(const ElemSparse *begin, const ElemSparse *end, const UInt size)
+      : size(size), begin_(begin), end_(end) {}
+
+    /** The number of bits of the SDR. */
+    const UInt size;
+
+    const ElemSparse *begin() const noexcept { return begin_; }
+    const ElemSparse *end()   const noexcept { return end_; }
+    UInt getSum() const noexcept { return static_cast<UInt>(end_ - begin_); }
+
+    /** Number of true bits in common, @see SDR::getOverlap(). */
+    UInt getOverlap(const View &other) const;
+    UInt getOverlap(const SDR &sdr) const;
+
+    /** Copy of the value into @param sdr, of the same size. */
+    void copyTo(SDR &sdr) const;
+
+  private:
+    const ElemSparse *begin_;
+    const ElemSparse *end_;
+  };
+
+  SDRStore() {}
+
+  explicit SDRStore(const std::vector<UInt> &dimensions) { initialize(dimensions); }
+
+  /**
+   * Sets the dimensions of the SDRs and removes all entries.
+   */
+  void initialize(const std::vector<UInt> &dimensions);
+
+  const std::vector<UInt> &getDimensions() const noexcept { return dimensions_; }
+
+  /** Number of bits of each SDR. */
+  UInt getSize() const noexcept { return size_; }
+
+  size_t numSDRs() const noexcept { return offsets_.size() - 1u; }
+
+  /** Total number of true bits of all entries. */
+  size_t numIndices() const noexcept { return indices_.size(); }
+
+  /**
+   * Preallocate memory for @param numSDRs entries with @param numIndices true
+   * bits in total.
+   */
+  void reserve(size_t numSDRs, size_t numIndices);
+
+  /**
+   * Append a copy of @param sdr, which must have the size of the store.
+   * @returns The index of the new entry.
+   */
+  size_t add(const SDR &sdr);
+
+  /**
+   * Append sorted sparse indices, without duplicates.
+   * @returns The index of the new entry.
+   */
+  size_t add(const SDR_sparse_t &sparse);
+
+  View operator[](const size_t i) const {
+    NTA_ASSERT(i < numSDRs());
+    const ElemSparse *data = indices_.data();
+    return View(data + offsets_[i], data + offsets_[i + 1u], size_);
+  }
+
+  /** Copy of entry @param i into @param sdr, @see View::copyTo(). */
+  void get(const size_t i, SDR &sdr) const { (*this)[i].copyTo(sdr); }
+
+  /**
+   * Overlap of @param sdr with every entry, in the order of the entries.
+   * Faster than calling View::getOverlap(sdr) for each entry: the SDR is
+   * converted to a dense lookup table once.
+   */
+  void getOverlaps(const SDR &sdr, std::vector<UInt> &overlaps) const;
+
+  /** Removes all entries, keeps the dimensions & the memory. */
+  void clear();
+
+  bool operator==(const SDRStore &other) const;
+  inline bool operator!=(const SDRStore &other) const { return not operator==(other); }
+
+  // Serialization
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(dimensions_),
+       CEREAL_NVP(offsets_),
+       CEREAL_NVP(indices_));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(CEREAL_NVP(dimensions_),
+       CEREAL_NVP(offsets_),
+       CEREAL_NVP(indices_));
+    size_ = 1u;
+    for(const auto dim : dimensions_) size_ *= dim;
+    checkArchive_();
+  }
+
+private:
+  // The View & the overlaps trust the entries, a loaded archive is checked once.
+  void checkArchive_() const;
+
+  std::vector<UInt> dimensions_;
+  UInt size_ = 0u;
+  std::vector<UInt64> offsets_ {0u}; //numSDRs + 1 entries
+  SDR_sparse_t indices_;
+};
+
+} // end namespace htm
+
+#endif // NTA_SDR_STORE_HPP
@@ -27,12 +27,14 @@
 #define NTA_SERIALIZABLE_HPP
 
 
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <htm/os/Directory.hpp>
 #include <htm/os/Path.hpp>
 #include <htm/utils/Log.hpp>
 #include <htm/os/ImportFilesystem.hpp>
+#include <htm/types/Types.hpp>
 
 #define CEREAL_SAVE_FUNCTION_NAME save_ar
 #define CEREAL_LOAD_FUNCTION_NAME load_ar
@@ -346,6 +348,84 @@ public:
   }
 
 
+// Versions of the archive of a class.
+//
+// The classes were archived without a version at first, so their old archives
+// start with their first field.  A class which changes its layout writes a
+// version in front of its first field, with saveArchiveVersion(), and reads it
+// back with loadArchiveVersion(), which returns the @legacy version for an
+// archive without it:
+//
+//    static const UInt32 ARCHIVE_VERSION = 2u; // 1 is the unversioned layout
+//    template<class Archive> void save_ar(Archive &ar) const {
+//      saveArchiveVersion(ar, ARCHIVE_MARKER, ARCHIVE_VERSION);
+//      ar(CEREAL_NVP(first_), CEREAL_NVP(second_), CEREAL_NVP(added_));
+//    }
+//    template<class Archive> void load_ar(Archive &ar) {
+//      const UInt32 version = loadArchiveVersion(ar, "first_", first_, ARCHIVE_MARKER, 1u);
+//      ar(CEREAL_NVP(second_));
+//      if (version >= 2u) ar(CEREAL_NVP(added_)); else added_ = 0;
+//    }
+//
+// The binary archives are not named, so they write a marker before the
+// version: a value of the type of the first field which that field never holds
+// (eg. 0 for a seed which is never 0).  The text archives (JSON, XML) look up
+// the version by its name.
+
+/** Writes the version of the archive, in front of the first field of the class. */
+template<class Archive, typename T>
+void saveArchiveVersion(Archive &ar, const T marker, const UInt32 version) {
+  if (not cereal::traits::is_text_archive<Archive>::value) {
+    ar(cereal::make_nvp("archiveMarker", marker));
+  }
+  ar(cereal::make_nvp("archiveVersion", version));
+}
+
+/**
+ * A marker for a Real64 first field: a NaN with a payload which no
+ * computation produces.
+ */
+inline Real64 realArchiveMarker() {
+  const UInt64 bits = 0x7FF8A4C8B1E5D2F7ull;
+  Real64 marker;
+  std::memcpy(&marker, &bits, sizeof(marker));
+  return marker;
+}
+
+template<typename T>
+inline bool isArchiveMarker_(const T &value, const T &marker) { return value == marker; }
+inline bool isArchiveMarker_(const float &value, const float &marker)
+  { return std::memcmp(&value, &marker, sizeof(float)) == 0; }
+inline bool isArchiveMarker_(const double &value, const double &marker)
+  { return std::memcmp(&value, &marker, sizeof(double)) == 0; }
+
+/**
+ * Reads the version of the archive and the first field of the class, named
+ * @name, into @first.  Returns @legacy for an archive written before the
+ * class was versioned.
+ */
+template<class Archive, typename T>
+UInt32 loadArchiveVersion(Archive &ar, const char *name, T &first, const T marker, const UInt32 legacy) {
+  UInt32 version = legacy;
+  if (cereal::traits::is_text_archive<Archive>::value) {
+    try {
+      ar(cereal::make_nvp("archiveVersion", version));
+    } catch (const cereal::Exception &) {
+      version = legacy; // not found, the archive has the legacy layout
+    }
+    ar(cereal::make_nvp(name, first));
+  } else {
+    ar(cereal::make_nvp(name, first));
+    if (isArchiveMarker_(first, marker)) {
+      ar(cereal::make_nvp("archiveVersion", version));
+      ar(cereal::make_nvp(name, first));
+    }
+  }
+  NTA_CHECK(version >= legacy) << "Unknown archive version " << version;
+  return version;
+}
+
+
 /**** Example of derived Serializable class
 class B : public Serializable {
 public:
@@ -0,0 +1,175 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SparseSDR class
+ */
+
+#ifndef NTA_SPARSE_SDR_HPP
+#define NTA_SPARSE_SDR_HPP
+
+#include <array>
+#include <vector>
+
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/Log.hpp>
+#include <htm/utils/SortedIntersection.hpp>
+
+namespace htm {
+
+/**
+ * SparseSDR - a lightweight SDR for the internals of the algorithms.
+ *
+ * @b Description
+ * Holds only the sparse format: there are no dense / coordinate caches, no
+ * callbacks and no serialization, and the dimensions are kept inline (up to
+ * MAX_DIMENSIONS), so the object is a single vector plus a few words.
+ * Setting its value costs no more than assigning the sparse vector.
+ *
+ * Meant for scratch SDRs which are written and read many times per
+ * compute() and never leave the algorithm, eg. the previous active cells of
+ * the TemporalMemory.  Use the SDR class for everything else, the two
+ * convert through setSDR() and copyTo().
+ *
+ * Like SDR::setSparse(), the sparse indices must be sorted and unique.
+ */
+class SparseSDR
+{
+public:
+  static const UInt MAX_DIMENSIONS = 4u;
+
+  SparseSDR() {}
+
+  /**
+   * @param dimensions The shape of the SDR, at most MAX_DIMENSIONS.
+   */
+  explicit SparseSDR(const std::vector<UInt> &dimensions) { initialize(dimensions); }
+
+  /**
+   * Copy of the shape & value of an SDR.
+   */
+  explicit SparseSDR(const SDR &sdr) { setSDR(sdr); }
+
+  /**
+   * Sets the shape of the SDR and zeroes it.
+   */
+  void initialize(const std::vector<UInt> &dimensions) {
+    NTA_CHECK(dimensions.size() <= MAX_DIMENSIONS)
+      << "SparseSDR supports at most " << static_cast<UInt>(MAX_DIMENSIONS) << " dimensions, got " << dimensions.size();
+    numDimensions_ = static_cast<UInt>(dimensions.size());
+    size = 1u;
+    for(UInt i = 0; i < numDimensions_; i++) {
+      dimensions_[i] = dimensions[i];
+      size *= dimensions[i];
+    }
+    sparse_.clear();
+  }
+
+  /** The total number of bits in the SDR. */
+  UInt size = 0u;
+
+  UInt numDimensions() const noexcept { return numDimensions_; }
+  UInt dimension(const UInt i) const { NTA_ASSERT(i < numDimensions_); return dimensions_[i]; }
+  std::vector<UInt> getDimensions() const {
+    return std::vector<UInt>(dimensions_.cbegin(), dimensions_.cbegin() + numDimensions_);
+  }
+
+  void zero() noexcept { sparse_.clear(); }
+
+  /**
+   * Copy the sparse indices into the SDR.
+   */
+  template<typename T>
+  void setSparse(const std::vector<T> &value) {
+    sparse_.assign(value.cbegin(), value.cend());
+    checkSparse_();
+  }
+
+  /**
+   * Swap the sparse indices into the SDR, @see SDR::setSparse(SDR_sparse_t&).
+   */
+  void setSparse(SDR_sparse_t &value) {
+    sparse_.swap(value);
+    checkSparse_();
+  }
+
+  const SDR_sparse_t &getSparse() const noexcept { return sparse_; }
+
+  UInt getSum() const noexcept { return static_cast<UInt>(sparse_.size()); }
+
+  /**
+   * Number of bits which are true in both SDRs, @see SDR::getOverlap().
+   */
+  UInt getOverlap(const SparseSDR &other) const {
+    NTA_CHECK(size == other.size);
+    UInt overlap = 0u;
+    intersectSorted(sparse_, other.sparse_, [&overlap](ElemSparse) { overlap++; });
+    return overlap;
+  }
+
+  /**
+   * Copy the shape & value of @param sdr.
+   */
+  void setSDR(const SDR &sdr) {
+    initialize(sdr.dimensions);
+    const auto &sparse = sdr.getSparse();
+    sparse_.assign(sparse.cbegin(), sparse.cend());
+  }
+
+  /**
+   * Copy the value into @param sdr, which must have the same size.
+   */
+  void copyTo(SDR &sdr) const {
+    NTA_CHECK(sdr.size == size);
+    sdr.setSparse(sparse_);
+  }
+
+  /**
+   * Convert to a full SDR, with the same shape & value.
+   */
+  SDR toSDR() const {
+    SDR sdr(getDimensions());
+    copyTo(sdr);
+    return sdr;
+  }
+
+  bool operator==(const SparseSDR &other) const {
+    return numDimensions_ == other.numDimensions_ and
+           std::equal(dimensions_.cbegin(), dimensions_.cbegin() + numDimensions_, other.dimensions_.cbegin()) and
+           sparse_ == other.sparse_;
+  }
+  bool operator!=(const SparseSDR &other) const { return not operator==(other); }
+
+private:
+  void checkSparse_() const {
+#ifdef NTA_ASSERTIONS_ON
+    for(size_t i = 0; i < sparse_.size(); i++) {
+      NTA_ASSERT(sparse_[i] < size) << "Index out of bounds of the SDR.";
+      NTA_ASSERT(i == 0u or sparse_[i - 1] < sparse_[i]) << "Sparse data must be sorted and contain no duplicates.";
+    }
+#endif
+  }
+
+  std::array<UInt, MAX_DIMENSIONS> dimensions_ {};
+  UInt numDimensions_ = 0u;
+  SDR_sparse_t sparse_;
+};
+
+} // end namespace htm
+
+#endif // NTA_SPARSE_SDR_HPP
@@ -46,6 +46,11 @@ namespace htm {
 #endif
 typedef char Byte;
 
+/**
+ * Represents an 8-bit unsigned integer.
+ */
+typedef unsigned char UInt8;
+
 /**
  * Represents a 16-bit signed integer.
  */
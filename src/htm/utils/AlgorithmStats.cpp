@@ -0,0 +1,73 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the AlgorithmStats class
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include <htm/os/TscTimer.hpp>
+#include <htm/utils/AlgorithmStats.hpp>
+
+namespace htm {
+
+AlgorithmStats::AlgorithmStats(std::initializer_list<const char *> timers,
+                               std::initializer_list<const char *> counters)
+    : timerNames_(timers.begin(), timers.end()), calls_(timers.size(), 0u),
+      ticks_(timers.size(), 0u), counterNames_(counters.begin(), counters.end()),
+      counts_(counters.size(), 0u) {}
+
+void AlgorithmStats::enable(bool enabled) {
+#ifdef NTA_NO_ALGORITHM_STATS
+  (void)enabled;
+#else
+  enabled_ = enabled;
+#endif
+}
+
+void AlgorithmStats::reset() {
+  std::fill(calls_.begin(), calls_.end(), 0u);
+  std::fill(ticks_.begin(), ticks_.end(), 0u);
+  std::fill(counts_.begin(), counts_.end(), 0u);
+}
+
+Real64 AlgorithmStats::getSeconds(size_t timer) const {
+  return static_cast<Real64>(ticks_[timer]) / ticksPerSecond();
+}
+
+UInt64 AlgorithmStats::ticks() { return TscTimer::ticks(); }
+
+Real64 AlgorithmStats::ticksPerSecond() { return TscTimer::ticksPerSecond(); }
+
+std::string AlgorithmStats::toJSON() const {
+  std::stringstream ss;
+  ss << "{\"timers\": {";
+  for (size_t i = 0u; i < timerNames_.size(); i++) {
+    ss << (i == 0u ? "" : ", ") << "\"" << timerNames_[i] << "\": {\"calls\": " << calls_[i]
+       << ", \"seconds\": " << (calls_[i] == 0u ? 0.0 : getSeconds(i)) << "}";
+  }
+  ss << "}, \"counters\": {";
+  for (size_t i = 0u; i < counterNames_.size(); i++) {
+    ss << (i == 0u ? "" : ", ") << "\"" << counterNames_[i] << "\": " << counts_[i];
+  }
+  ss << "}}";
+  return ss.str();
+}
+
+} // namespace htm
@@ -0,0 +1,137 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the AlgorithmStats class
+ */
+
+#ifndef NTA_ALGORITHM_STATS_HPP
+#define NTA_ALGORITHM_STATS_HPP
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * Timers and event counters of the stages inside an algorithm, eg. how much
+ * of a TemporalMemory step was growing synapses, and how many segments it
+ * created.
+ *
+ * Nothing is collected until enable(); a disabled timer costs one branch.
+ * The timers read the cycle counter of the CPU (@see TscTimer) and are
+ * converted to seconds when read.  They time the
+ * calling thread, stages run by worker threads are timed as a whole.
+ *
+ * Building with NTA_NO_ALGORITHM_STATS (cmake -DHTM_NO_ALGORITHM_STATS=ON)
+ * removes the instrumentation: the NTA_STATS_ macros expand to nothing and
+ * all timers and counters read 0.
+ *
+ * Example Usage:
+ *    enum { Stats_Inhibition };
+ *    AlgorithmStats stats_({"inhibition"}, {"segmentsCreated"});
+ *    ...
+ *    { NTA_STATS_TIMER(stats_, Stats_Inhibition);
+ *      ... }
+ *    NTA_STATS_COUNT(stats_, 0, 1u);
+ */
+class AlgorithmStats {
+public:
+  AlgorithmStats(std::initializer_list<const char *> timers,
+                 std::initializer_list<const char *> counters);
+
+  // No effect with NTA_NO_ALGORITHM_STATS.
+  void enable(bool enabled = true);
+  bool isEnabled() const { return enabled_; }
+
+  // Zero all timers and counters.
+  void reset();
+
+  size_t numTimers() const { return timerNames_.size(); }
+  const std::string &getTimerName(size_t timer) const { return timerNames_[timer]; }
+  // Times the timer ran.
+  UInt64 getCalls(size_t timer) const { return calls_[timer]; }
+  Real64 getSeconds(size_t timer) const;
+
+  size_t numCounters() const { return counterNames_.size(); }
+  const std::string &getCounterName(size_t counter) const { return counterNames_[counter]; }
+  UInt64 getCount(size_t counter) const { return counts_[counter]; }
+
+  /**
+   * @returns {"timers": {"<timer>": {"calls": n, "seconds": s}, ...},
+   *           "counters": {"<counter>": n, ...}}
+   */
+  std::string toJSON() const;
+
+  // The clock of the timers.
+  static UInt64 ticks();
+  static Real64 ticksPerSecond();
+
+  void count(size_t counter, UInt64 n) {
+    if (enabled_)
+      counts_[counter] += n;
+  }
+
+  // Times its scope, @see NTA_STATS_TIMER
+  class Timer {
+  public:
+    Timer(AlgorithmStats &stats, size_t timer)
+        : stats_(stats.enabled_ ? &stats : nullptr), timer_(timer),
+          start_(stats.enabled_ ? ticks() : 0u) {}
+    ~Timer() {
+      if (stats_ != nullptr) {
+        stats_->calls_[timer_]++;
+        stats_->ticks_[timer_] += ticks() - start_;
+      }
+    }
+    Timer(const Timer &) = delete;
+    Timer &operator=(const Timer &) = delete;
+
+  private:
+    AlgorithmStats *stats_;
+    const size_t timer_;
+    const UInt64 start_;
+  };
+
+private:
+  bool enabled_ = false;
+  std::vector<std::string> timerNames_;
+  std::vector<UInt64> calls_;
+  std::vector<UInt64> ticks_;
+  std::vector<std::string> counterNames_;
+  std::vector<UInt64> counts_;
+};
+
+} // namespace htm
+
+#define NTA_STATS_CONCAT_(a, b) a##b
+#define NTA_STATS_NAME_(line) NTA_STATS_CONCAT_(ntaStatsTimer_, line)
+
+#ifdef NTA_NO_ALGORITHM_STATS
+#define NTA_STATS_TIMER(stats, timer)
+#define NTA_STATS_COUNT(stats, counter, n)
+#else
+// Times the rest of the enclosing scope.
+#define NTA_STATS_TIMER(stats, timer) \
+  htm::AlgorithmStats::Timer NTA_STATS_NAME_(__LINE__)((stats), (timer))
+#define NTA_STATS_COUNT(stats, counter, n) (stats).count((counter), (n))
+#endif
+
+#endif // NTA_ALGORITHM_STATS_HPP
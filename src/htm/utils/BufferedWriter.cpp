@@ -0,0 +1,175 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the BufferedWriter.
+ */
+
+#include <htm/utils/BufferedWriter.hpp>
+#include <htm/utils/ChunkFile.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+static void putUInt32(std::string &out, UInt32 value) {
+  for (size_t i = 0u; i < 4u; i++) {
+    out.push_back(static_cast<char>(value & 0xFFu));
+    value >>= 8u;
+  }
+}
+
+static UInt32 getUInt32(const char *p) {
+  const auto *bytes = reinterpret_cast<const unsigned char *>(p);
+  return static_cast<UInt32>(bytes[0]) | (static_cast<UInt32>(bytes[1]) << 8u) |
+         (static_cast<UInt32>(bytes[2]) << 16u) | (static_cast<UInt32>(bytes[3]) << 24u);
+}
+
+
+BufferedWriter::BufferedWriter(const std::string &path, const bool append,
+                               const bool compress, const size_t bufferSize)
+  : path_(path), compress_(compress), bufferSize_(bufferSize) {
+  NTA_CHECK(bufferSize > 0u) << "BufferedWriter: the buffer size must be > 0";
+  NTA_CHECK(bufferSize <= 0xFFFFFFFFu || !compress)
+      << "BufferedWriter: compressed blocks are limited to 4GB";
+  out_.open(path, std::ios_base::out | std::ios_base::binary |
+                      (append ? std::ios_base::app : std::ios_base::trunc));
+  NTA_CHECK(out_.is_open()) << "BufferedWriter: unable to create or open file: " << path;
+  buffer_.reserve(bufferSize);
+  pending_.reserve(bufferSize);
+  thread_ = std::thread(&BufferedWriter::run_, this);
+}
+
+BufferedWriter::~BufferedWriter() {
+  try {
+    close();
+  } catch (const std::exception &e) {
+    NTA_WARN << "BufferedWriter: " << e.what();
+  }
+}
+
+
+void BufferedWriter::write(const void *data, const size_t size) {
+  if (!buffer_.empty() && buffer_.size() + size > bufferSize_)
+    submit_();
+  buffer_.append(static_cast<const char *>(data), size);
+}
+
+void BufferedWriter::submit_() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  changed_.wait(lock, [this] { return !hasPending_; });
+  if (error_ != nullptr)
+    std::rethrow_exception(error_);
+  NTA_CHECK(thread_.joinable()) << "BufferedWriter: " << path_ << " is closed";
+  buffer_.swap(pending_);
+  buffer_.clear();
+  hasPending_ = true;
+  changed_.notify_all();
+}
+
+void BufferedWriter::flush() {
+  if (!buffer_.empty())
+    submit_();
+  std::unique_lock<std::mutex> lock(mutex_);
+  changed_.wait(lock, [this] { return !hasPending_; });
+  if (error_ != nullptr)
+    std::rethrow_exception(error_);
+  out_.flush(); // the background thread is idle
+  NTA_CHECK(!out_.fail()) << "BufferedWriter: error writing to file " << path_;
+}
+
+void BufferedWriter::close() {
+  if (!thread_.joinable())
+    return;
+  std::exception_ptr error;
+  try {
+    flush();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  changed_.notify_all();
+  thread_.join();
+  out_.close();
+  if (error != nullptr)
+    std::rethrow_exception(error);
+  NTA_CHECK(!out_.fail()) << "BufferedWriter: error writing to file " << path_;
+}
+
+
+void BufferedWriter::run_() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    changed_.wait(lock, [this] { return hasPending_ || stopping_; });
+    if (!hasPending_)
+      return; // stopping
+    lock.unlock();
+    try {
+      writeBlock_(pending_);
+    } catch (...) {
+      lock.lock();
+      error_ = std::current_exception();
+      lock.unlock();
+    }
+    lock.lock();
+    pending_.clear();
+    hasPending_ = false;
+    changed_.notify_all();
+  }
+}
+
+void BufferedWriter::writeBlock_(const std::string &block) {
+  if (compress_) {
+    std::string stored = lzCompress(block.data(), block.size());
+    if (stored.size() >= block.size())
+      stored = block;
+    std::string header;
+    putUInt32(header, static_cast<UInt32>(block.size()));
+    putUInt32(header, static_cast<UInt32>(stored.size()));
+    out_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    out_.write(stored.data(), static_cast<std::streamsize>(stored.size()));
+  } else {
+    out_.write(block.data(), static_cast<std::streamsize>(block.size()));
+  }
+  NTA_CHECK(!out_.fail()) << "BufferedWriter: error writing to file " << path_;
+}
+
+
+std::string readCompressedFile(const std::string &path) {
+  std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+  NTA_CHECK(in.is_open()) << "readCompressedFile: can not open " << path;
+  std::string contents;
+  char header[8];
+  while (in.read(header, 8)) {
+    const UInt32 rawSize = getUInt32(header);
+    const UInt32 storedSize = getUInt32(header + 4);
+    std::string stored(storedSize, '\0');
+    in.read(&stored[0], static_cast<std::streamsize>(storedSize));
+    NTA_CHECK(in.gcount() == static_cast<std::streamsize>(storedSize))
+        << "readCompressedFile: truncated file " << path;
+    if (storedSize == rawSize)
+      contents += stored;
+    else
+      contents += lzDecompress(stored.data(), stored.size(), rawSize);
+  }
+  NTA_CHECK(in.gcount() == 0) << "readCompressedFile: truncated file " << path;
+  return contents;
+}
+
+} // namespace htm
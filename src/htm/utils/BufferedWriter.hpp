@@ -0,0 +1,97 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * A file writer which writes on a background thread.
+ */
+
+#ifndef NTA_BUFFERED_WRITER_HPP
+#define NTA_BUFFERED_WRITER_HPP
+
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * BufferedWriter collects the writes in a large buffer.  A full buffer is
+ * handed to a background thread which writes it to the file while the next
+ * buffer fills, so the caller only copies bytes.  Errors of the background
+ * thread are thrown by the next call.
+ *
+ * With `compress` every buffer is written as a block compressed with
+ * lzCompress(): UInt32 raw size, UInt32 stored size (equal to the raw size
+ * if the block did not compress), the stored bytes.  The integers are
+ * little endian.  @see readCompressedFile()
+ */
+class BufferedWriter {
+public:
+  BufferedWriter(const std::string &path, bool append = true, bool compress = false,
+                 size_t bufferSize = 1u << 20u);
+  ~BufferedWriter();
+
+  BufferedWriter(const BufferedWriter &) = delete;
+  BufferedWriter &operator=(const BufferedWriter &) = delete;
+
+  void write(const void *data, size_t size);
+  void write(const std::string &s) { write(s.data(), s.size()); }
+
+  /**
+   * Write all buffered bytes to the file and flush it.
+   */
+  void flush();
+
+  /**
+   * Flush and close the file.  Throws if any write failed.
+   */
+  void close();
+
+  const std::string &path() const { return path_; }
+
+private:
+  void submit_();
+  void run_();
+  void writeBlock_(const std::string &block);
+
+  const std::string path_;
+  const bool compress_;
+  const size_t bufferSize_;
+  std::ofstream out_;        // used by the background thread while pending
+  std::string buffer_;       // being filled
+  std::string pending_;      // being written
+  bool hasPending_ = false;
+  bool stopping_ = false;
+  std::exception_ptr error_;
+  std::mutex mutex_;
+  std::condition_variable changed_;
+  std::thread thread_;
+};
+
+/**
+ * @returns the contents of a file written by a compressing BufferedWriter.
+ */
+std::string readCompressedFile(const std::string &path);
+
+} // namespace htm
+
+#endif // NTA_BUFFERED_WRITER_HPP
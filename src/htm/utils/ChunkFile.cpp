@@ -0,0 +1,261 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the chunked container files.
+ */
+
+#include <cstdio>  // rename
+#include <cstring> // memcpy
+#include <fstream>
+#include <vector>
+
+#include <htm/os/Directory.hpp>
+#include <htm/os/Path.hpp>
+#include <htm/utils/ChunkFile.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+static const char   CHUNK_TAG[] = "HTMCHUNK";
+static const UInt32 CHUNK_VERSION = 1u;
+
+// LZ block format, @see lzCompress()
+static const size_t MIN_MATCH     = 4u;
+static const size_t LAST_LITERALS = 5u;  // the block ends with literals
+static const size_t MATCH_LIMIT   = 12u; // no match starts in the last bytes
+static const size_t MAX_OFFSET    = 65535u;
+static const UInt   HASH_BITS     = 14u;
+
+static inline UInt32 read32(const char *p) {
+  UInt32 v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline size_t hash32(const UInt32 v) {
+  return static_cast<size_t>((v * 2654435761u) >> (32u - HASH_BITS));
+}
+
+// A length of 15 or more continues in bytes of 255 and a last byte < 255.
+static inline void writeLength(std::string &out, size_t length) {
+  while (length >= 255u) {
+    out.push_back(static_cast<char>(255));
+    length -= 255u;
+  }
+  out.push_back(static_cast<char>(length));
+}
+
+static void writeSequence(std::string &out, const char *literals, const size_t numLiterals,
+                          const size_t offset, const size_t matchLength) {
+  const size_t litToken = numLiterals < 15u ? numLiterals : 15u;
+  const size_t matchCode = matchLength == 0u ? 0u : matchLength - MIN_MATCH;
+  const size_t matchToken = matchCode < 15u ? matchCode : 15u;
+  out.push_back(static_cast<char>((litToken << 4u) | matchToken));
+  if (litToken == 15u) writeLength(out, numLiterals - 15u);
+  out.append(literals, numLiterals);
+  if (matchLength == 0u) return; // the last sequence
+  out.push_back(static_cast<char>(offset & 0xFFu));
+  out.push_back(static_cast<char>(offset >> 8u));
+  if (matchToken == 15u) writeLength(out, matchCode - 15u);
+}
+
+
+std::string lzCompress(const char *data, const size_t size) {
+  std::string out;
+  out.reserve(size / 2u + 16u);
+  size_t anchor = 0u; // start of the pending literals
+  if (size > MATCH_LIMIT) {
+    std::vector<UInt32> table(size_t(1u) << HASH_BITS, 0u); // position + 1, 0 is empty
+    const size_t matchLimit = size - MATCH_LIMIT;
+    const size_t extendLimit = size - LAST_LITERALS;
+    size_t pos = 0u;
+    while (pos < matchLimit) {
+      const UInt32 v = read32(data + pos);
+      UInt32 &slot = table[hash32(v)];
+      const size_t ref = slot;
+      slot = static_cast<UInt32>(pos + 1u);
+      if (ref == 0u or pos + 1u - ref > MAX_OFFSET or read32(data + ref - 1u) != v) {
+        // skip faster through data which does not compress
+        pos += 1u + ((pos - anchor) >> 6u);
+        continue;
+      }
+      const size_t match = ref - 1u;
+      size_t length = MIN_MATCH;
+      while (pos + length < extendLimit and data[match + length] == data[pos + length]) length++;
+      writeSequence(out, data + anchor, pos - anchor, pos - match, length);
+      pos += length;
+      anchor = pos;
+    }
+  }
+  writeSequence(out, data + anchor, size - anchor, 0u, 0u);
+  return out;
+}
+
+
+std::string lzDecompress(const char *data, const size_t size, const size_t rawSize) {
+  std::string out(rawSize, '\0');
+  char *const dst = &out[0];
+  const auto *src = reinterpret_cast<const unsigned char *>(data);
+  size_t in = 0u, pos = 0u;
+  const auto readLength = [&](size_t length) {
+    if (length != 15u) return length;
+    unsigned char b;
+    do {
+      NTA_CHECK(in < size) << "lzDecompress: corrupt block";
+      b = src[in++];
+      length += b;
+    } while (b == 255u);
+    return length;
+  };
+  while (true) {
+    NTA_CHECK(in < size) << "lzDecompress: corrupt block";
+    const unsigned char token = src[in++];
+    const size_t numLiterals = readLength(token >> 4u);
+    NTA_CHECK(numLiterals <= size - in and numLiterals <= rawSize - pos) << "lzDecompress: corrupt block";
+    std::memcpy(dst + pos, src + in, numLiterals);
+    in += numLiterals;
+    pos += numLiterals;
+    if (in == size) break; // the last sequence has no match
+
+    NTA_CHECK(2u <= size - in) << "lzDecompress: corrupt block";
+    const size_t offset = size_t(src[in]) | (size_t(src[in + 1u]) << 8u);
+    in += 2u;
+    const size_t length = readLength(token & 0x0Fu) + MIN_MATCH;
+    NTA_CHECK(offset > 0u and offset <= pos and length <= rawSize - pos) << "lzDecompress: corrupt block";
+    if (offset >= length) {
+      std::memcpy(dst + pos, dst + pos - offset, length);
+    } else { // the match overlaps the output, ie. a repeated pattern
+      for (size_t i = 0u; i < length; i++) dst[pos + i] = dst[pos - offset + i];
+    }
+    pos += length;
+  }
+  NTA_CHECK(pos == rawSize) << "lzDecompress: the block has " << pos << " bytes, expected " << rawSize;
+  return out;
+}
+
+
+void Chunk::pack(const std::string &raw, const ChunkCodec codec) {
+  rawSize = raw.size();
+  this->codec = ChunkCodec::NONE;
+  if (codec == ChunkCodec::LZ) {
+    std::string compressed = lzCompress(raw.data(), raw.size());
+    if (compressed.size() < raw.size()) {
+      this->codec = ChunkCodec::LZ;
+      data = std::move(compressed);
+      return;
+    }
+  }
+  data = raw;
+}
+
+std::string Chunk::unpack() const {
+  switch (codec) {
+  case ChunkCodec::NONE:
+    NTA_CHECK(data.size() == rawSize) << "Chunk " << name << ": corrupt";
+    return data;
+  case ChunkCodec::LZ:
+    return lzDecompress(data.data(), data.size(), static_cast<size_t>(rawSize));
+  }
+  NTA_THROW << "Chunk " << name << ": unknown codec " << static_cast<UInt>(codec);
+}
+
+
+// The integers are stored little endian, so the files are portable.
+template <typename T> static void writeInt(std::ostream &out, T value) {
+  char bytes[sizeof(T)];
+  for (size_t i = 0u; i < sizeof(T); i++) {
+    bytes[i] = static_cast<char>(value & 0xFFu);
+    value = static_cast<T>(value >> 4u >> 4u);
+  }
+  out.write(bytes, sizeof(T));
+}
+
+template <typename T> static T readInt(std::istream &in, const std::string &path) {
+  unsigned char bytes[sizeof(T)];
+  in.read(reinterpret_cast<char *>(bytes), sizeof(T));
+  NTA_CHECK(in.good()) << "readChunkFile: truncated file " << path;
+  T value = 0u;
+  for (size_t i = sizeof(T); i > 0u; i--) {
+    value = static_cast<T>(value << 4u << 4u) | static_cast<T>(bytes[i - 1u]);
+  }
+  return value;
+}
+
+void writeChunkFile(const std::string &path, const std::vector<Chunk> &chunks) {
+  const std::string dir = Path::getParent(path);
+  if (!dir.empty())
+    Directory::create(dir, true, true);
+  const std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream out(tmpPath, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    NTA_CHECK(out.is_open()) << "writeChunkFile: can not open " << tmpPath;
+    out.write(CHUNK_TAG, 8);
+    writeInt(out, CHUNK_VERSION);
+    writeInt(out, static_cast<UInt32>(chunks.size()));
+    for (const auto &chunk : chunks) {
+      writeInt(out, static_cast<UInt32>(chunk.name.size()));
+      out.write(chunk.name.data(), static_cast<std::streamsize>(chunk.name.size()));
+      writeInt(out, static_cast<UInt8>(chunk.codec));
+      writeInt(out, chunk.rawSize);
+      writeInt(out, static_cast<UInt64>(chunk.data.size()));
+      out.write(chunk.data.data(), static_cast<std::streamsize>(chunk.data.size()));
+    }
+    out.close();
+    NTA_CHECK(!out.fail()) << "writeChunkFile: can not write " << tmpPath;
+  }
+#if defined(NTA_OS_WINDOWS)
+  std::remove(path.c_str()); // rename does not replace an existing file
+#endif
+  NTA_CHECK(std::rename(tmpPath.c_str(), path.c_str()) == 0) << "writeChunkFile: can not rename " << tmpPath;
+}
+
+std::vector<Chunk> readChunkFile(const std::string &path) {
+  std::ifstream in(path, std::ios_base::in | std::ios_base::binary);
+  NTA_CHECK(in.is_open()) << "readChunkFile: can not open " << path;
+  char tag[8];
+  in.read(tag, 8);
+  NTA_CHECK(in.good() and std::memcmp(tag, CHUNK_TAG, 8u) == 0) << "readChunkFile: " << path << " is not a chunked file";
+  const auto version = readInt<UInt32>(in, path);
+  NTA_CHECK(version == CHUNK_VERSION)
+      << "readChunkFile: " << path << " has version " << version << ", expected " << CHUNK_VERSION;
+  const auto start = in.tellg();
+  in.seekg(0, std::ios_base::end);
+  const auto fileSize = static_cast<UInt64>(in.tellg());
+  in.seekg(start);
+
+  const auto numChunks = readInt<UInt32>(in, path);
+  std::vector<Chunk> chunks;
+  for (UInt32 i = 0u; i < numChunks; i++) {
+    Chunk chunk;
+    const auto nameSize = readInt<UInt32>(in, path);
+    NTA_CHECK(nameSize <= fileSize) << "readChunkFile: corrupt file " << path;
+    chunk.name.resize(nameSize);
+    in.read(&chunk.name[0], nameSize);
+    chunk.codec = static_cast<ChunkCodec>(readInt<UInt8>(in, path));
+    chunk.rawSize = readInt<UInt64>(in, path);
+    const auto storedSize = readInt<UInt64>(in, path);
+    NTA_CHECK(storedSize <= fileSize) << "readChunkFile: corrupt file " << path;
+    chunk.data.resize(static_cast<size_t>(storedSize));
+    in.read(&chunk.data[0], static_cast<std::streamsize>(storedSize));
+    NTA_CHECK(in.good()) << "readChunkFile: truncated file " << path;
+    chunks.push_back(std::move(chunk));
+  }
+  return chunks;
+}
+
+} // namespace htm
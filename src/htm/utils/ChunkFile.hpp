@@ -0,0 +1,85 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Chunked container files, with optional compression of each chunk.
+ */
+
+#ifndef NTA_CHUNK_FILE_HPP
+#define NTA_CHUNK_FILE_HPP
+
+#include <string>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * LZ77 block compression in the format of an LZ4 block: sequences of
+ * literals and (offset, length) back references into the last 64KB.
+ * It needs no dictionary or entropy coder, compresses in one pass with a
+ * small hash table and decompresses at memory speed.  Serialized models
+ * compress well (zero runs, repeated indices and permanences).
+ */
+std::string lzCompress(const char *data, size_t size);
+
+/**
+ * Decompress a block of lzCompress().  Throws if the block is corrupt or
+ * does not decompress to exactly `rawSize` bytes.
+ */
+std::string lzDecompress(const char *data, size_t size, size_t rawSize);
+
+
+enum class ChunkCodec : UInt8 { NONE = 0, LZ = 1 };
+
+/**
+ * One independent section of a chunked file.  The chunks of a file are
+ * packed and unpacked independently, ie. in parallel.
+ */
+struct Chunk {
+  std::string name;
+  ChunkCodec codec = ChunkCodec::NONE;
+  UInt64 rawSize = 0u;
+  std::string data; // the stored bytes, compressed with codec
+
+  /**
+   * Store `raw`, compressed with `codec`.  Stores it uncompressed when the
+   * compression does not make it smaller.
+   */
+  void pack(const std::string &raw, ChunkCodec codec);
+
+  /**
+   * @returns the raw bytes.
+   */
+  std::string unpack() const;
+};
+
+/**
+ * Layout of a chunked file:
+ *   header: "HTMCHUNK", UInt32 version, UInt32 number of chunks
+ *   chunks: UInt32 name length, name, UInt8 codec, UInt64 raw size,
+ *           UInt64 stored size, the stored bytes
+ *
+ * The file is written under a temporary name and renamed when complete.
+ */
+void writeChunkFile(const std::string &path, const std::vector<Chunk> &chunks);
+std::vector<Chunk> readChunkFile(const std::string &path);
+
+} // namespace htm
+
+#endif // NTA_CHUNK_FILE_HPP
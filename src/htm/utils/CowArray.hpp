@@ -0,0 +1,198 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the CowArray class
+ */
+
+#ifndef NTA_COW_ARRAY_HPP
+#define NTA_COW_ARRAY_HPP
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <htm/utils/MemoryResource.hpp>
+
+namespace htm {
+
+/**
+ * CowArray - an array stored in fixed size chunks, which copies share until
+ * one of them writes to a chunk (copy-on-write pages).
+ *
+ * @b Description
+ * Copying a CowArray only copies the chunk pointers, so a fork of a large
+ * model costs memory in proportion to what the fork changes afterwards.
+ * Reading is `operator[]`, which is const; writing goes through `ref()`,
+ * which first copies a shared chunk.  Keep the writes apart from the reads
+ * so reading does not copy.
+ *
+ * The chunks are allocated from a MemoryResource (@see ResourceAllocator).
+ *
+ * Thread safety: concurrent `ref()` calls are safe for elements in chunks
+ * which are not shared (@see unshare), like a std::vector.  Forking and
+ * writing the same chunk must not run concurrently.
+ */
+template<typename T>
+class CowArray {
+  static_assert(std::is_trivially_copyable<T>::value, "CowArray: elements must be trivially copyable");
+public:
+  static const size_t CHUNK_BITS = 12u;
+  static const size_t CHUNK_SIZE = size_t(1u) << CHUNK_BITS; //elements per chunk
+
+  explicit CowArray(MemoryResource *resource = nullptr)
+    : resource_(resource == nullptr ? MemoryResource::defaultResource() : resource) {}
+
+  size_t size() const noexcept { return size_; }
+  bool empty() const noexcept { return size_ == 0u; }
+
+  const T &operator[](const size_t i) const {
+    return chunks_[i >> CHUNK_BITS]->values[i & (CHUNK_SIZE - 1u)];
+  }
+  const T &back() const { return (*this)[size_ - 1u]; }
+
+  /**
+   * Writable element, copies its chunk first if it is shared.
+   */
+  T &ref(const size_t i) {
+    return unshare_(i >> CHUNK_BITS).values[i & (CHUNK_SIZE - 1u)];
+  }
+
+  void push_back(const T &value) {
+    if( size_ == chunks_.size() * CHUNK_SIZE ) chunks_.push_back(newChunk_());
+    ref(size_++) = value;
+  }
+
+  void resize(const size_t n, const T &value = T()) {
+    const size_t numChunks = (n + CHUNK_SIZE - 1u) >> CHUNK_BITS;
+    if( n < size_ ) {
+      chunks_.resize(numChunks);
+      size_ = n;
+      return;
+    }
+    chunks_.reserve(numChunks);
+    while( chunks_.size() < numChunks ) chunks_.push_back(newChunk_());
+    for(size_t i = size_; i < n; i++) ref(i) = value;
+    size_ = n;
+  }
+
+  void clear() noexcept {
+    chunks_.clear();
+    size_ = 0u;
+  }
+
+  void assign(const T *first, const T *last) {
+    clear();
+    const size_t n = static_cast<size_t>(last - first);
+    while( size_ < n ) {
+      const size_t count = std::min(CHUNK_SIZE, n - size_);
+      chunks_.push_back(newChunk_());
+      std::copy(first + size_, first + size_ + count, chunks_.back()->values);
+      size_ += count;
+    }
+  }
+
+  /**
+   * Calls `fn(const T *values, size_t count)` on the consecutive pieces of
+   * the array, in order.
+   */
+  template<typename Fn>
+  void forEachChunk(Fn fn) const {
+    for(size_t c = 0u; c < chunks_.size(); c++) {
+      fn(chunks_[c]->values, std::min(CHUNK_SIZE, size_ - c * CHUNK_SIZE));
+    }
+  }
+
+  /**
+   * Makes the chunk of element `i` private to this array, so that writes to
+   * it may run concurrently with other (unshared) writes.
+   */
+  void unshare(const size_t i) { unshare_(i >> CHUNK_BITS); }
+
+  /**
+   * @returns the number of chunks which are shared with a copy.
+   */
+  size_t numSharedChunks() const noexcept {
+    size_t shared = 0u;
+    for(const auto &chunk : chunks_) shared += chunk.use_count() > 1 ? 1u : 0u;
+    return shared;
+  }
+
+  /**
+   * Bytes of the allocated chunks, of which the shared ones only count
+   * their part.
+   */
+  size_t memoryUsage() const noexcept {
+    double bytes = static_cast<double>(chunks_.capacity() * sizeof(chunks_[0]));
+    for(const auto &chunk : chunks_) bytes += static_cast<double>(sizeof(Chunk)) / chunk.use_count();
+    return static_cast<size_t>(bytes);
+  }
+
+  MemoryResource *resource() const noexcept { return resource_; }
+
+  /**
+   * Moves the elements to private chunks allocated from `resource`.
+   */
+  void setResource(MemoryResource *resource) {
+    resource_ = resource == nullptr ? MemoryResource::defaultResource() : resource;
+    for(auto &chunk : chunks_) {
+      chunk = std::allocate_shared<Chunk>(ResourceAllocator<Chunk>(resource_), *chunk);
+    }
+  }
+
+  bool operator==(const CowArray &other) const {
+    if( size_ != other.size_ ) return false;
+    for(size_t c = 0u; c < chunks_.size(); c++) {
+      if( chunks_[c] == other.chunks_[c] ) continue;
+      const size_t n = std::min(CHUNK_SIZE, size_ - c * CHUNK_SIZE);
+      for(size_t i = 0u; i < n; i++) {
+        if( not (chunks_[c]->values[i] == other.chunks_[c]->values[i]) ) return false;
+      }
+    }
+    return true;
+  }
+  bool operator!=(const CowArray &other) const { return not (*this == other); }
+
+private:
+  struct Chunk {
+    T values[CHUNK_SIZE];
+  };
+
+  std::shared_ptr<Chunk> newChunk_() const {
+    return std::allocate_shared<Chunk>(ResourceAllocator<Chunk>(resource_));
+  }
+
+  Chunk &unshare_(const size_t c) {
+    auto &chunk = chunks_[c];
+    if( chunk.use_count() > 1 ) {
+      chunk = std::allocate_shared<Chunk>(ResourceAllocator<Chunk>(resource_), *chunk);
+    }
+    return *chunk;
+  }
+
+  std::vector<std::shared_ptr<Chunk>> chunks_;
+  size_t size_ = 0u;
+  MemoryResource *resource_;
+};
+
+template<typename T> const size_t CowArray<T>::CHUNK_BITS;
+template<typename T> const size_t CowArray<T>::CHUNK_SIZE;
+
+} // end namespace htm
+
+#endif // NTA_COW_ARRAY_HPP
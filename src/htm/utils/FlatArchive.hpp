@@ -0,0 +1,218 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Flat binary archives, loaded from a memory mapped file or from a buffer.
+ */
+
+#ifndef NTA_FLAT_ARCHIVE_HPP
+#define NTA_FLAT_ARCHIVE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <htm/os/Directory.hpp>
+#include <htm/os/MappedFile.hpp>
+#include <htm/os/Path.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+/**
+ * Layout of a flat archive:
+ *   header: 8 bytes tag, UInt32 version, UInt32 byte order mark
+ *   scalars: the raw bytes of the value
+ *   arrays:  UInt64 count, UInt32 element size, padding up to the next
+ *            multiple of FLAT_ALIGNMENT, the elements
+ *
+ * The data is written in the byte order of the machine, a file written on a
+ * machine of the other byte order is rejected.  A flat archive is meant
+ * for fast loading of large models on the same kind of machines, use the
+ * cereal based Serializable for portable archives.
+ *
+ * An archive can also be written to and read from memory, eg. to pass a
+ * model to another process through shared memory without a file.
+ */
+static const size_t FLAT_ALIGNMENT = 64u;
+static const UInt32 FLAT_BYTE_ORDER = 0x01020304u;
+
+class FlatWriter {
+public:
+  FlatWriter(const std::string &path, const std::string &tag, UInt32 version)
+    : path_(path) {
+    NTA_CHECK(tag.size() == 8u) << "FlatWriter: the tag must have 8 characters";
+    const std::string dir = Path::getParent(path);
+    if (!dir.empty())
+      Directory::create(dir, true, true);
+    out_.open(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    NTA_CHECK(out_.is_open()) << "FlatWriter: can not open " << path;
+    write_(tag.data(), 8);
+    scalar(version);
+    scalar(FLAT_BYTE_ORDER);
+  }
+
+  // Appends the archive to @param buffer, which must outlive the writer.
+  FlatWriter(std::vector<char> &buffer, const std::string &tag, UInt32 version)
+    : path_("memory"), buffer_(&buffer) {
+    NTA_CHECK(tag.size() == 8u) << "FlatWriter: the tag must have 8 characters";
+    write_(tag.data(), 8);
+    scalar(version);
+    scalar(FLAT_BYTE_ORDER);
+  }
+
+  template <typename T> void scalar(const T &value) {
+    static_assert(std::is_trivially_copyable<T>::value, "FlatWriter: not a flat type");
+    write_(&value, sizeof(T));
+  }
+
+  template <typename T, typename A> void array(const std::vector<T, A> &values) {
+    array(values.data(), values.size());
+  }
+
+  template <typename T> void array(const T *values, size_t count) {
+    beginArray<T>(count);
+    append(values, count);
+  }
+
+  /**
+   * An array written in pieces: `beginArray` with the total count, then
+   * `append` the elements in order.
+   */
+  template <typename T> void beginArray(size_t count) {
+    static_assert(std::is_trivially_copyable<T>::value, "FlatWriter: not a flat type");
+    scalar(static_cast<UInt64>(count));
+    scalar(static_cast<UInt32>(sizeof(T)));
+    const size_t padding = (FLAT_ALIGNMENT - pos_ % FLAT_ALIGNMENT) % FLAT_ALIGNMENT;
+    const char zeros[FLAT_ALIGNMENT] = {};
+    write_(zeros, padding);
+  }
+
+  template <typename T> void append(const T *values, size_t count) {
+    write_(values, count * sizeof(T));
+  }
+
+  void string(const std::string &value) { array(value.data(), value.size()); }
+
+  void close() {
+    if (buffer_ != nullptr)
+      return;
+    out_.close();
+    NTA_CHECK(!out_.fail()) << "FlatWriter: can not write " << path_;
+  }
+
+private:
+  void write_(const void *data, size_t bytes) {
+    if (buffer_ != nullptr)
+      buffer_->insert(buffer_->end(), static_cast<const char *>(data), static_cast<const char *>(data) + bytes);
+    else
+      out_.write(static_cast<const char *>(data), static_cast<std::streamsize>(bytes));
+    pos_ += bytes;
+  }
+
+  std::string path_;
+  std::ofstream out_;
+  std::vector<char> *buffer_ = nullptr;
+  size_t pos_ = 0u;
+};
+
+class FlatReader {
+public:
+  FlatReader(const std::string &path, const std::string &tag, UInt32 version)
+    : file_(new MappedFile(path)), data_(file_->data()), size_(file_->size()), path_(path) {
+    header_(tag, version);
+  }
+
+  /**
+   * Reads the archive in the @param size bytes at @param data, which must
+   * outlive the reader.  The arrays are aligned to FLAT_ALIGNMENT relative
+   * to @param data, which must itself be aligned to 8 bytes.
+   */
+  FlatReader(const char *data, size_t size, const std::string &tag, UInt32 version)
+    : data_(data), size_(size), path_("memory") {
+    NTA_CHECK(reinterpret_cast<std::uintptr_t>(data) % sizeof(UInt64) == 0u)
+        << "FlatReader: the buffer is not aligned to 8 bytes";
+    header_(tag, version);
+  }
+
+  template <typename T> T scalar() {
+    static_assert(std::is_trivially_copyable<T>::value, "FlatReader: not a flat type");
+    T value;
+    std::memcpy(&value, take_(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  /**
+   * The elements of the next array, in place in the mapped file or buffer.
+   * Valid while this reader exists.
+   */
+  template <typename T> const T *view(size_t &count) {
+    static_assert(std::is_trivially_copyable<T>::value, "FlatReader: not a flat type");
+    const UInt64 n = scalar<UInt64>();
+    NTA_CHECK(scalar<UInt32>() == sizeof(T)) << "FlatReader: corrupt archive " << path_;
+    take_((FLAT_ALIGNMENT - pos_ % FLAT_ALIGNMENT) % FLAT_ALIGNMENT);
+    NTA_CHECK(n <= (size_ - pos_) / sizeof(T)) << "FlatReader: truncated archive " << path_;
+    count = static_cast<size_t>(n);
+    return reinterpret_cast<const T *>(take_(count * sizeof(T)));
+  }
+
+  template <typename T, typename A> void array(std::vector<T, A> &values) {
+    size_t count;
+    const T *data = view<T>(count);
+    values.assign(data, data + count);
+  }
+
+  std::string string() {
+    size_t count;
+    const char *data = view<char>(count);
+    return std::string(data, count);
+  }
+
+private:
+  void header_(const std::string &tag, UInt32 version) {
+    NTA_CHECK(size_ >= 16u && std::memcmp(data_, tag.data(), 8u) == 0)
+        << "FlatReader: " << path_ << " is not a flat " << tag << " archive";
+    pos_ = 8u;
+    const UInt32 fileVersion = scalar<UInt32>();
+    NTA_CHECK(fileVersion == version)
+        << "FlatReader: " << path_ << " has version " << fileVersion << ", expected " << version;
+    NTA_CHECK(scalar<UInt32>() == FLAT_BYTE_ORDER)
+        << "FlatReader: " << path_ << " was written on a machine of the other byte order";
+  }
+
+  const char *take_(size_t bytes) {
+    NTA_CHECK(bytes <= size_ - pos_) << "FlatReader: truncated archive " << path_;
+    const char *data = data_ + pos_;
+    pos_ += bytes;
+    return data;
+  }
+
+  std::unique_ptr<MappedFile> file_; // null for a buffer
+  const char *data_;
+  size_t size_;
+  std::string path_;
+  size_t pos_ = 0u;
+};
+
+} // namespace htm
+
+#endif // NTA_FLAT_ARCHIVE_HPP
@@ -0,0 +1,101 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the LatencyHistogram class
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+#include <htm/utils/LatencyHistogram.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace htm {
+
+// 8 buckets per power of two: bucket b < 8 holds b ns, above that the
+// 3 bits after the leading bit select the bucket within the octave.
+static const UInt SUB_BITS = 3u;
+static const UInt64 SUB_BUCKETS = 1u << SUB_BITS;
+static const size_t NUM_BUCKETS = SUB_BUCKETS + (64u - SUB_BITS) * SUB_BUCKETS;
+
+static size_t bucketOf(UInt64 ns) {
+  if (ns < SUB_BUCKETS)
+    return static_cast<size_t>(ns);
+  UInt octave = 0u; // position of the leading bit
+  for (UInt64 v = ns; v > 1u; v >>= 1u)
+    octave++;
+  const UInt shift = octave - SUB_BITS;
+  const UInt64 sub = (ns >> shift) & (SUB_BUCKETS - 1u);
+  return static_cast<size_t>(SUB_BUCKETS + shift * SUB_BUCKETS + sub);
+}
+
+// The largest duration in ns of a bucket.
+static Real64 upperBoundOf(size_t bucket) {
+  if (bucket < SUB_BUCKETS)
+    return static_cast<Real64>(bucket);
+  const size_t shift = (bucket - SUB_BUCKETS) / SUB_BUCKETS;
+  const size_t sub = (bucket - SUB_BUCKETS) % SUB_BUCKETS;
+  return std::ldexp(static_cast<Real64>(SUB_BUCKETS + sub + 1u), static_cast<int>(shift)) - 1.0;
+}
+
+
+LatencyHistogram::LatencyHistogram() : buckets_(NUM_BUCKETS, 0u) {}
+
+void LatencyHistogram::add(Real64 seconds) {
+  if (seconds < 0.0)
+    seconds = 0.0;
+  const Real64 ns = std::round(seconds * 1.0e9);
+  const UInt64 n = ns >= 1.8e19 ? std::numeric_limits<UInt64>::max() : static_cast<UInt64>(ns);
+  buckets_[bucketOf(n)]++;
+  count_++;
+  total_ += seconds;
+  max_ = std::max(max_, seconds);
+}
+
+void LatencyHistogram::reset() {
+  std::fill(buckets_.begin(), buckets_.end(), 0u);
+  count_ = 0u;
+  total_ = 0.0;
+  max_ = 0.0;
+}
+
+Real64 LatencyHistogram::percentile(Real64 p) const {
+  NTA_CHECK(p >= 0.0 && p <= 1.0) << "LatencyHistogram: percentile " << p << " not in [0, 1]";
+  if (count_ == 0u)
+    return 0.0;
+  const UInt64 rank = std::max<UInt64>(1u, static_cast<UInt64>(std::ceil(p * static_cast<Real64>(count_))));
+  UInt64 seen = 0u;
+  for (size_t b = 0u; b < buckets_.size(); b++) {
+    seen += buckets_[b];
+    if (seen >= rank)
+      return std::min(upperBoundOf(b) * 1.0e-9, max_);
+  }
+  return max_;
+}
+
+std::string LatencyHistogram::toJSON() const {
+  std::stringstream ss;
+  ss << "{\"count\": " << count_ << ", \"total\": " << total_
+     << ", \"p50\": " << percentile(0.5) << ", \"p99\": " << percentile(0.99)
+     << ", \"max\": " << max_ << "}";
+  return ss.str();
+}
+
+} // namespace htm
@@ -0,0 +1,85 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the LatencyHistogram class
+ */
+
+#ifndef NTA_LATENCY_HISTOGRAM_HPP
+#define NTA_LATENCY_HISTOGRAM_HPP
+
+#include <string>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * Distribution of durations, eg. of the iterations of a network, for
+ * percentiles like p50 and p99 which a cumulative Timer can not give.
+ *
+ * Durations are counted in logarithmic buckets of nanoseconds, 8 per
+ * power of two, so a percentile is exact below 8ns and within 12.5% above.
+ * Memory is constant, adding is a few instructions.
+ *
+ * Example Usage:
+ *    LatencyHistogram h;
+ *    for(...) h.add( seconds );
+ *    h.percentile( 0.99 );
+ */
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+
+  /**
+   * Count a duration of @param seconds.
+   */
+  void add(Real64 seconds);
+
+  void reset();
+
+  UInt64 getCount() const { return count_; }
+
+  // Sum of the durations, in seconds.
+  Real64 getTotal() const { return total_; }
+
+  // Longest duration, in seconds.
+  Real64 getMax() const { return max_; }
+
+  /**
+   * @param p The fraction of the durations, in [0, 1], eg. 0.5 for the median.
+   * @returns The duration in seconds which p of the durations do not exceed,
+   * 0 if there are none.
+   */
+  Real64 percentile(Real64 p) const;
+
+  /**
+   * @returns {"count": n, "total": s, "p50": s, "p99": s, "max": s}
+   */
+  std::string toJSON() const;
+
+private:
+  std::vector<UInt64> buckets_;
+  UInt64 count_ = 0u;
+  Real64 total_ = 0.0;
+  Real64 max_ = 0.0;
+};
+
+} // namespace htm
+
+#endif // NTA_LATENCY_HISTOGRAM_HPP
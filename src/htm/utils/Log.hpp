@@ -25,15 +25,24 @@
 
 #include <iostream>
 #include <htm/types/Exception.hpp>
+#include <htm/utils/LogSink.hpp>
+
+// The most verbose level compiled in, 0 (None) to 3 (Verbose).  The messages
+// of the levels above are removed at compile time, eg. NTA_DEBUG in the
+// per-iteration paths with -DNTA_LOG_COMPILED_LEVEL=2
+// (cmake -DHTM_LOG_COMPILED_LEVEL=2).
+#ifndef NTA_LOG_COMPILED_LEVEL
+#define NTA_LOG_COMPILED_LEVEL 3
+#endif
 
 namespace htm {
-enum class LogLevel { LogLevel_None = 0, LogLevel_Minimal=1, LogLevel_Normal=2, LogLevel_Verbose=3 };
 // change this in your class to set log level using Network.setLogLevel(level);
 extern thread_local LogLevel NTA_LOG_LEVEL; 
 
 //this code intentionally uses "if() dosomething" instead of "if() { dosomething }" 
 // as the macro expects another "<< "my clever message";
-// so it eventually becomes: `if() std::cout << "DEBUG:\t" << "users message";`
+// so it eventually becomes: `if() LogMessage(...).stream() << "users message";`
+// The message goes to the LogSink at the end of the statement.
 //
 //Expected usage: 
 //<your class>:
@@ -43,21 +52,19 @@ extern thread_local LogLevel NTA_LOG_LEVEL;
 //NTA_ERR << "You'll always see this, HAHA!";
 //NTA_THROW << "crashing for a good cause";
 
-#define NTA_DEBUG                                                \
-  if (NTA_LOG_LEVEL >= LogLevel::LogLevel_Verbose)               \
-    std::cout << "DEBUG:\t" << Path::getBasename(__FILE__) << ":" << __LINE__ << ": " 
+#define NTA_LOG_(severity, level)                                                \
+  if (NTA_LOG_COMPILED_LEVEL >= static_cast<int>(level) and NTA_LOG_LEVEL >= (level)) \
+    htm::LogMessage(severity, (level), __FILE__, __LINE__).stream()
+
+#define NTA_DEBUG NTA_LOG_("DEBUG", LogLevel::LogLevel_Verbose)
 
 // For informational messages that report status but do not indicate that
 // anything is wrong
-#define NTA_INFO                                                               \
-  if (NTA_LOG_LEVEL >= LogLevel::LogLevel_Normal)                              \
-  std::cout << "INFO:\t" << Path::getBasename(__FILE__) << ":" << __LINE__ << ": "
+#define NTA_INFO NTA_LOG_("INFO", LogLevel::LogLevel_Normal)
 
 // For messages that indicate a recoverable error or something else that it may
 // be important for the end user to know about.
-#define NTA_WARN                                                               \
-  if (NTA_LOG_LEVEL >= LogLevel::LogLevel_Normal)                              \
-  std::cout << "WARN:\t" << Path::getBasename(__FILE__) << ":" << __LINE__ << ": "
+#define NTA_WARN NTA_LOG_("WARN", LogLevel::LogLevel_Normal)
 
 // To throw an exception and make sure the exception message is logged
 // appropriately
@@ -0,0 +1,159 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the LogSink class
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+#include <htm/os/Path.hpp>
+#include <htm/utils/LogSink.hpp>
+
+namespace htm {
+
+namespace {
+
+void defaultHandler(const LogRecord &record) {
+  std::cout << LogSink::format(record) << std::endl;
+}
+
+struct Sink {
+  std::mutex control; // serializes setAsync()
+  std::mutex mutex; // guards the other members
+  std::condition_variable wake; // of the writer
+  std::condition_variable idle; // of flush()
+  std::shared_ptr<LogSink::Handler> handler = std::make_shared<LogSink::Handler>(defaultHandler);
+  std::deque<LogRecord> queue;
+  bool busy = false;  // the writer is running the handler
+  bool async = false;
+  std::thread writer;
+
+  ~Sink() {
+    std::lock_guard<std::mutex> lock(control);
+    stop();
+  }
+
+  void stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (not async) return;
+      async = false;
+    }
+    wake.notify_one();
+    writer.join();
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      wake.wait(lock, [this]() { return not queue.empty() or not async; });
+      if (queue.empty()) break; // stopped and drained
+      std::deque<LogRecord> batch;
+      batch.swap(queue);
+      const auto current = handler;
+      busy = true;
+      lock.unlock();
+      for (const auto &record : batch) (*current)(record);
+      lock.lock();
+      busy = false;
+      idle.notify_all();
+    }
+    idle.notify_all();
+  }
+};
+
+Sink &sink() {
+  static Sink instance;
+  return instance;
+}
+
+} // end anonymous namespace
+
+
+void LogSink::setHandler(Handler handler) {
+  flush();
+  Sink &s = sink();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  s.handler = std::make_shared<Handler>(handler ? std::move(handler) : Handler(defaultHandler));
+}
+
+
+void LogSink::setAsync(const bool async) {
+  Sink &s = sink();
+  std::lock_guard<std::mutex> control(s.control);
+  if (not async) {
+    s.stop();
+    return;
+  }
+  std::lock_guard<std::mutex> lock(s.mutex);
+  if (s.async) return;
+  s.async = true;
+  s.writer = std::thread([&s]() { s.run(); });
+}
+
+
+bool LogSink::isAsync() {
+  Sink &s = sink();
+  std::lock_guard<std::mutex> lock(s.mutex);
+  return s.async;
+}
+
+
+void LogSink::flush() {
+  Sink &s = sink();
+  std::unique_lock<std::mutex> lock(s.mutex);
+  s.idle.wait(lock, [&s]() { return (s.queue.empty() and not s.busy) or not s.async; });
+}
+
+
+void LogSink::post(LogRecord &&record) {
+  Sink &s = sink();
+  std::shared_ptr<Handler> current;
+  {
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.async) {
+      s.queue.push_back(std::move(record));
+      s.wake.notify_one();
+      return;
+    }
+    current = s.handler;
+  }
+  (*current)(record);
+}
+
+
+std::string LogSink::format(const LogRecord &record) {
+  std::stringstream ss;
+  ss << record.severity << ":\t" << Path::getBasename(record.file) << ":" << record.line
+     << ": " << record.message;
+  return ss.str();
+}
+
+
+LogMessage::~LogMessage() {
+  std::string message = stream_.str();
+  while (not message.empty() and message.back() == '\n') message.pop_back();
+  LogSink::post({severity_, level_, file_, line_, std::this_thread::get_id(),
+                 std::chrono::system_clock::now(), std::move(message)});
+}
+
+} // namespace htm
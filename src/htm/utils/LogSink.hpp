@@ -0,0 +1,115 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the LogSink class
+ */
+
+#ifndef NTA_LOG_SINK_HPP
+#define NTA_LOG_SINK_HPP
+
+#include <chrono>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace htm {
+
+enum class LogLevel { LogLevel_None = 0, LogLevel_Minimal=1, LogLevel_Normal=2, LogLevel_Verbose=3 };
+
+/**
+ * One message of NTA_DEBUG, NTA_INFO or NTA_WARN.
+ */
+struct LogRecord {
+  const char *severity;  // "DEBUG", "INFO" or "WARN"
+  LogLevel level;        // the log level which shows the message
+  const char *file;      // __FILE__
+  int line;
+  std::thread::id thread;
+  std::chrono::system_clock::time_point time;
+  std::string message;   // the streamed text, without a trailing newline
+};
+
+/**
+ * LogSink - where the log messages go.
+ *
+ * @b Description
+ * The handler receives every message as a LogRecord.  The default handler
+ * writes "WARN:\t<file>:<line>: <message>" lines to std::cout.
+ *
+ * By default the handler runs on the thread which logs.  With setAsync(true)
+ * the records go to a queue and a background thread runs the handler, so
+ * the compute threads only stream the message text: the prefix, the output
+ * and its locks, and whatever the handler does (eg. JSON to a collector)
+ * are off the hot path.  The order of the records is kept.
+ */
+class LogSink {
+public:
+  typedef std::function<void(const LogRecord &)> Handler;
+
+  /**
+   * Replace the handler, an empty one restores the default handler.
+   * Flushes the queue first.
+   */
+  static void setHandler(Handler handler);
+
+  /**
+   * Start or stop the background thread.  Stopping flushes the queue.
+   * This is a runtime setting, it is not serialized.
+   */
+  static void setAsync(bool async);
+  static bool isAsync();
+
+  /**
+   * Wait until the handler has received every queued record.
+   */
+  static void flush();
+
+  static void post(LogRecord &&record);
+
+  /**
+   * The text of the default handler.
+   */
+  static std::string format(const LogRecord &record);
+};
+
+/**
+ * Collects the streamed message of a log macro and posts it to the LogSink
+ * at the end of the statement.
+ */
+class LogMessage {
+public:
+  LogMessage(const char *severity, LogLevel level, const char *file, int line)
+      : severity_(severity), level_(level), file_(file), line_(line) {}
+  ~LogMessage();
+  LogMessage(const LogMessage &) = delete;
+  LogMessage &operator=(const LogMessage &) = delete;
+
+  std::ostream &stream() { return stream_; }
+
+private:
+  const char *severity_;
+  LogLevel level_;
+  const char *file_;
+  int line_;
+  std::ostringstream stream_;
+};
+
+} // namespace htm
+
+#endif // NTA_LOG_SINK_HPP
@@ -0,0 +1,95 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the memory resources
+ */
+
+#include <cstdint>
+#include <new>
+
+#include <htm/utils/Log.hpp>
+#include <htm/utils/MemoryResource.hpp>
+
+namespace htm {
+
+void *alignedAllocate(std::size_t bytes, std::size_t alignment) {
+  NTA_CHECK(alignment > 0u and (alignment & (alignment - 1u)) == 0u)
+    << "alignedAllocate: alignment " << alignment << " is not a power of two.";
+  if( alignment < sizeof(void*) ) alignment = sizeof(void*);
+  // Over allocate, and keep the pointer of operator new just before the
+  // aligned block.
+  char *raw = static_cast<char*>(::operator new(bytes + alignment + sizeof(void*)));
+  const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+  char *aligned = raw + sizeof(void*) + (alignment - start % alignment) % alignment;
+  reinterpret_cast<void**>(aligned)[-1] = raw;
+  return aligned;
+}
+
+
+void alignedDeallocate(void *p) noexcept {
+  if( p == nullptr ) return;
+  ::operator delete(static_cast<void**>(p)[-1]);
+}
+
+
+namespace {
+
+class NewDeleteResource : public MemoryResource {
+protected:
+  void *allocate_(std::size_t bytes, std::size_t alignment) override {
+    if( alignment > alignof(std::max_align_t) ) return alignedAllocate(bytes, alignment);
+    return ::operator new(bytes);
+  }
+  void deallocate_(void *p, std::size_t, std::size_t alignment) override {
+    if( alignment > alignof(std::max_align_t) ) alignedDeallocate(p);
+    else ::operator delete(p);
+  }
+  bool isEqual_(const MemoryResource &other) const noexcept override {
+    return dynamic_cast<const NewDeleteResource*>(&other) != nullptr;
+  }
+};
+
+} // end anonymous namespace
+
+
+MemoryResource *MemoryResource::defaultResource() noexcept {
+  static NewDeleteResource resource;
+  return &resource;
+}
+
+
+void *MonotonicResource::allocate_(std::size_t bytes, std::size_t alignment) {
+  const std::uintptr_t next = reinterpret_cast<std::uintptr_t>(buffer_) + used_;
+  const std::size_t padding = (alignment - next % alignment) % alignment;
+  if( buffer_ != nullptr and used_ + padding <= size_ and bytes <= size_ - used_ - padding ) {
+    void *p = buffer_ + used_ + padding;
+    used_ += padding + bytes;
+    return p;
+  }
+  if( upstream_ == nullptr ) throw std::bad_alloc();
+  return upstream_->allocate(bytes, alignment);
+}
+
+
+void MonotonicResource::deallocate_(void *p, std::size_t bytes, std::size_t alignment) {
+  const char *c = static_cast<const char*>(p);
+  if( c >= buffer_ and c < buffer_ + size_ ) return; //freed by release()
+  upstream_->deallocate(p, bytes, alignment);
+}
+
+} // end namespace htm
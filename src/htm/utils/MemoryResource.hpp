@@ -0,0 +1,211 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Polymorphic memory resources for the large arrays of a model.
+ */
+
+#ifndef NTA_MEMORY_RESOURCE_HPP
+#define NTA_MEMORY_RESOURCE_HPP
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace htm {
+
+/**
+ * The alignment and the padding of the buffers of SIMD kernels: a cache line,
+ * which is also the width of the widest (AVX-512) registers.
+ */
+const std::size_t SIMD_ALIGNMENT = 64u;
+
+/**
+ * @returns bytes rounded up to a multiple of SIMD_ALIGNMENT.
+ */
+inline std::size_t paddedBytes(std::size_t bytes) noexcept
+  { return (bytes + SIMD_ALIGNMENT - 1u) / SIMD_ALIGNMENT * SIMD_ALIGNMENT; }
+
+/**
+ * Allocate from the heap with an alignment beyond alignof(std::max_align_t).
+ * The alignment must be a power of two.  Release with alignedDeallocate().
+ * @throws std::bad_alloc
+ */
+void *alignedAllocate(std::size_t bytes, std::size_t alignment = SIMD_ALIGNMENT);
+void alignedDeallocate(void *p) noexcept;
+
+
+/**
+ * MemoryResource - where the storage of a model's arrays comes from.
+ *
+ * @b Description
+ * A small C++11 counterpart of std::pmr::memory_resource.  The containers
+ * of a model allocate through a `ResourceAllocator`, which holds a pointer to
+ * a resource chosen at runtime, so the same (non template) classes can be
+ * backed by the heap, hugepages, a NUMA local arena or a shared memory
+ * segment.
+ *
+ * The resource must outlive every container using it.
+ */
+class MemoryResource {
+public:
+  virtual ~MemoryResource() {}
+
+  void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    { return allocate_(bytes, alignment); }
+  void deallocate(void *p, std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    { deallocate_(p, bytes, alignment); }
+
+  /**
+   * Storage allocated from one resource can be released by the other.
+   */
+  bool isEqual(const MemoryResource &other) const noexcept
+    { return this == &other or isEqual_(other); }
+
+  /**
+   * The resource of the default constructed allocators: global new/delete.
+   */
+  static MemoryResource *defaultResource() noexcept;
+
+protected:
+  virtual void *allocate_(std::size_t bytes, std::size_t alignment) = 0;
+  virtual void deallocate_(void *p, std::size_t bytes, std::size_t alignment) = 0;
+  virtual bool isEqual_(const MemoryResource &) const noexcept { return false; }
+};
+
+
+/**
+ * A resource which hands out consecutive pieces of a caller provided buffer,
+ * eg. a hugepage or shared memory mapping, same as
+ * std::pmr::monotonic_buffer_resource.  Deallocation does nothing, the
+ * buffer is reused after `release()`.  When the buffer is full, allocations
+ * go to the `upstream` resource, or throw if it is null.
+ */
+class MonotonicResource : public MemoryResource {
+public:
+  MonotonicResource(void *buffer, std::size_t size,
+                    MemoryResource *upstream = MemoryResource::defaultResource())
+    : buffer_(static_cast<char*>(buffer)), size_(size), upstream_(upstream) {}
+
+  MonotonicResource(const MonotonicResource&) = delete;
+  MonotonicResource &operator=(const MonotonicResource&) = delete;
+
+  /**
+   * Bytes of the buffer in use.
+   */
+  std::size_t used() const noexcept { return used_; }
+
+  /**
+   * Start over at the beginning of the buffer.  Everything allocated from
+   * the buffer must no longer be used.
+   */
+  void release() noexcept { used_ = 0u; }
+
+protected:
+  void *allocate_(std::size_t bytes, std::size_t alignment) override;
+  void deallocate_(void *p, std::size_t bytes, std::size_t alignment) override;
+
+private:
+  char          *buffer_;
+  std::size_t    size_;
+  std::size_t    used_ = 0u;
+  MemoryResource *upstream_;
+};
+
+
+/**
+ * A standard allocator which allocates from a MemoryResource, like
+ * std::pmr::polymorphic_allocator.  Copies of a container keep the resource
+ * of the original, copy assignment keeps the resource of the target.  Unlike
+ * polymorphic_allocator, move assignment and swap take the resource along
+ * with the storage, so a container can be rebuilt in a new resource and
+ * moved into place.
+ */
+template<typename T>
+class ResourceAllocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  ResourceAllocator() noexcept : resource_(MemoryResource::defaultResource()) {}
+  ResourceAllocator(MemoryResource *resource) noexcept //implicit, like polymorphic_allocator
+    : resource_(resource == nullptr ? MemoryResource::defaultResource() : resource) {}
+  template<typename U>
+  ResourceAllocator(const ResourceAllocator<U> &other) noexcept : resource_(other.resource()) {}
+
+  T *allocate(std::size_t n)
+    { return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T))); }
+  void deallocate(T *p, std::size_t n)
+    { resource_->deallocate(p, n * sizeof(T), alignof(T)); }
+
+  MemoryResource *resource() const noexcept { return resource_; }
+
+private:
+  MemoryResource *resource_;
+};
+
+template<typename T, typename U>
+bool operator==(const ResourceAllocator<T> &a, const ResourceAllocator<U> &b) noexcept
+  { return a.resource()->isEqual(*b.resource()); }
+template<typename T, typename U>
+bool operator!=(const ResourceAllocator<T> &a, const ResourceAllocator<U> &b) noexcept
+  { return not (a == b); }
+
+template<typename T>
+using ResourceVector = std::vector<T, ResourceAllocator<T>>;
+
+
+/**
+ * A standard allocator of SIMD_ALIGNMENT aligned storage, padded to a
+ * multiple of SIMD_ALIGNMENT bytes.  A kernel may read (and write) the
+ * padding after the last element of an AlignedVector, up to its
+ * paddedSize(), so it can process whole vectors without a scalar epilogue.
+ * The padding is not initialized.
+ */
+template<typename T>
+class AlignedAllocator {
+public:
+  using value_type = T;
+
+  AlignedAllocator() noexcept {}
+  template<typename U>
+  AlignedAllocator(const AlignedAllocator<U> &) noexcept {}
+
+  T *allocate(std::size_t n)
+    { return static_cast<T*>(alignedAllocate(paddedBytes(n * sizeof(T)), SIMD_ALIGNMENT)); }
+  void deallocate(T *p, std::size_t) noexcept
+    { alignedDeallocate(p); }
+
+  /**
+   * @returns the number of elements in the storage of n elements.
+   */
+  static std::size_t paddedSize(std::size_t n) noexcept
+    { return paddedBytes(n * sizeof(T)) / sizeof(T); }
+};
+
+template<typename T, typename U>
+bool operator==(const AlignedAllocator<T> &, const AlignedAllocator<U> &) noexcept { return true; }
+template<typename T, typename U>
+bool operator!=(const AlignedAllocator<T> &, const AlignedAllocator<U> &) noexcept { return false; }
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+} // end namespace htm
+
+#endif // NTA_MEMORY_RESOURCE_HPP
@@ -29,8 +29,7 @@ using namespace htm;
 
 MovingAverage::MovingAverage(UInt wSize, const vector<Real>& historicalValues)
     : slidingWindow_(wSize, begin(historicalValues), end(historicalValues)) {
- const std::vector<Real>&  window = slidingWindow_.getData();
-  total_ = Real(accumulate(begin(window), end(window), 0.0f));
+  total_ = static_cast<Real>(slidingWindow_.sum());
 }
 
 
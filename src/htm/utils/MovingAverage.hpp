@@ -19,7 +19,7 @@
 #define HTM_UTIL_MOVING_AVERAGE_HPP
 
 #include <vector>
-#include <numeric>
+#include <utility>
 
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Types.hpp>
@@ -33,9 +33,14 @@ public:
 
   MovingAverage(UInt wSize);
 
-  inline std::vector<Real> getData() const {
+  // unordered content of the window, @see SlidingWindow::getData
+  inline const std::vector<Real>& getData() const {
     return slidingWindow_.getData(); }
 
+  // ordered content of the window, @see SlidingWindow::getSpans
+  inline std::pair<SlidingWindow<Real>::Span, SlidingWindow<Real>::Span> getSpans() const {
+    return slidingWindow_.getSpans(); }
+
   Real getCurrentAvg() const; 
 
   Real compute(Real newValue);
@@ -64,9 +69,7 @@ public:
     ar(CEREAL_NVP(wSize));          // load size of sliding window to stream, not used
     ar(CEREAL_NVP(slidingWindow_)); // load data in sliding window to stream
 
-    // calculates total_
-    const std::vector<Real>&  window = slidingWindow_.getData();
-    total_ = Real(std::accumulate(begin(window), end(window), 0.0f));
+    total_ = static_cast<Real>(slidingWindow_.sum());
   }
 
   friend class cereal::access;
@@ -82,9 +85,7 @@ public:
     construct(wSize);               // allocates slidingWindow
     ar(construct->slidingWindow_);  // populates sliding window
 
-    // calculates total_
-    const std::vector<Real>&  window = construct->slidingWindow_.getData();
-    construct->total_ = Real(std::accumulate(begin(window), end(window), 0.0f));
+    construct->total_ = static_cast<Real>(construct->slidingWindow_.sum());
   }
 
 private:
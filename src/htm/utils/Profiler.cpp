@@ -0,0 +1,101 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the Profiler class
+ */
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+#include <htm/utils/Profiler.hpp>
+
+namespace htm {
+
+namespace {
+  // The sections of all threads, never freed so they outlive the threads.
+  std::mutex &sectionsMutex() {
+    static std::mutex mutex;
+    return mutex;
+  }
+  std::vector<std::unique_ptr<ProfileSection>> &sections() {
+    static std::vector<std::unique_ptr<ProfileSection>> all;
+    return all;
+  }
+} // end anonymous namespace
+
+
+bool Profiler::isEnabled() {
+#ifdef NTA_PROFILE
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+ProfileSection *Profiler::section(const char *name) {
+  std::lock_guard<std::mutex> lock(sectionsMutex());
+  sections().emplace_back(new ProfileSection(name));
+  return sections().back().get();
+}
+
+
+std::vector<Profiler::Entry> Profiler::getEntries() {
+  std::map<std::string, std::pair<UInt64, UInt64>> sums; // name -> (calls, ticks)
+  {
+    std::lock_guard<std::mutex> lock(sectionsMutex());
+    for (const auto &section : sections()) {
+      auto &sum = sums[section->name];
+      sum.first  += section->calls.load(std::memory_order_relaxed);
+      sum.second += section->ticks.load(std::memory_order_relaxed);
+    }
+  }
+  std::vector<Entry> entries;
+  for (const auto &sum : sums) {
+    entries.push_back({sum.first, sum.second.first,
+                       static_cast<Real64>(sum.second.second) / TscTimer::ticksPerSecond()});
+  }
+  return entries;
+}
+
+
+void Profiler::reset() {
+  std::lock_guard<std::mutex> lock(sectionsMutex());
+  for (const auto &section : sections()) {
+    section->calls.store(0u, std::memory_order_relaxed);
+    section->ticks.store(0u, std::memory_order_relaxed);
+  }
+}
+
+
+std::string Profiler::toJSON() {
+  std::stringstream ss;
+  ss << "{";
+  bool first = true;
+  for (const auto &entry : getEntries()) {
+    ss << (first ? "" : ", ") << "\"" << entry.name << "\": {\"calls\": " << entry.calls
+       << ", \"seconds\": " << entry.seconds << "}";
+    first = false;
+  }
+  ss << "}";
+  return ss.str();
+}
+
+} // namespace htm
@@ -0,0 +1,145 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the Profiler class
+ */
+
+#ifndef NTA_PROFILER_HPP
+#define NTA_PROFILER_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <htm/os/TscTimer.hpp>
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * The counters of one NTA_PROFILE_SCOPE on one thread.  Only that thread
+ * writes them, so the updates need no atomic read-modify-write; they are
+ * atomic only so Profiler can read them from another thread.
+ */
+struct ProfileSection {
+  explicit ProfileSection(const char *name) : name(name) {}
+  const char *name;
+  std::atomic<UInt64> calls{0u};
+  std::atomic<UInt64> ticks{0u};
+};
+
+/**
+ * Profiler - permanent instrumentation of the inner phases of the
+ * algorithms, by name.
+ *
+ * @b Description
+ * NTA_PROFILE_SCOPE("name") times the rest of the enclosing scope on the
+ * cycle counter (@see TscTimer) and adds it to counters of the calling
+ * thread: a scope costs two reads of the counter and two stores, no locks
+ * and no shared cache lines.  The first run of a scope on a thread
+ * registers its counters with the Profiler, they outlive the thread.
+ * Profiler::getEntries() sums the counters of all threads and scopes by
+ * name.
+ *
+ * The scopes are compiled in only with NTA_PROFILE (cmake
+ * -DHTM_PROFILE=ON), otherwise NTA_PROFILE_SCOPE expands to nothing and
+ * getEntries() is empty.  Unlike AlgorithmStats, which belongs to one
+ * instance of an algorithm and can be switched on at runtime, the profiler
+ * is process wide and has no runtime switch.
+ *
+ * Example Usage:
+ *    void Connections::computeActivity(...) {
+ *      NTA_PROFILE_SCOPE("Connections.computeActivity");
+ *      ...
+ *    }
+ *    for(const auto &e : Profiler::getEntries())
+ *      cout << e.name << " " << e.calls << " " << e.seconds << endl;
+ */
+class Profiler {
+public:
+  struct Entry {
+    std::string name;
+    UInt64 calls;
+    Real64 seconds;
+  };
+
+  /**
+   * @returns true if built with NTA_PROFILE.
+   */
+  static bool isEnabled();
+
+  /**
+   * Register the counters of a scope of the calling thread, @see
+   * NTA_PROFILE_SCOPE.  The name must be a string literal.
+   */
+  static ProfileSection *section(const char *name);
+
+  /**
+   * @returns the counters of all threads, summed by name, sorted by name.
+   */
+  static std::vector<Entry> getEntries();
+
+  /**
+   * Zero all counters.  Scopes which end while reset() runs may keep their
+   * previous counts.
+   */
+  static void reset();
+
+  /**
+   * @returns {"<name>": {"calls": n, "seconds": s}, ...}
+   */
+  static std::string toJSON();
+};
+
+// Times its scope, @see NTA_PROFILE_SCOPE
+class ProfileScope {
+public:
+  explicit ProfileScope(ProfileSection &section)
+      : section_(section), start_(TscTimer::ticks()) {}
+  ~ProfileScope() {
+    const UInt64 ticks = TscTimer::ticks() - start_;
+    section_.calls.store(section_.calls.load(std::memory_order_relaxed) + 1u,
+                         std::memory_order_relaxed);
+    section_.ticks.store(section_.ticks.load(std::memory_order_relaxed) + ticks,
+                         std::memory_order_relaxed);
+  }
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+  ProfileSection &section_;
+  const UInt64 start_;
+};
+
+} // namespace htm
+
+#define NTA_PROFILE_CONCAT_(a, b) a##b
+#define NTA_PROFILE_NAME_(prefix, line) NTA_PROFILE_CONCAT_(prefix, line)
+
+#ifdef NTA_PROFILE
+// Times the rest of the enclosing scope.
+#define NTA_PROFILE_SCOPE(name)                                                          \
+  static thread_local htm::ProfileSection *NTA_PROFILE_NAME_(ntaProfileSection_, __LINE__) = \
+      htm::Profiler::section(name);                                                      \
+  htm::ProfileScope NTA_PROFILE_NAME_(ntaProfileScope_, __LINE__)(                       \
+      *NTA_PROFILE_NAME_(ntaProfileSection_, __LINE__))
+#else
+#define NTA_PROFILE_SCOPE(name)
+#endif
+
+#endif // NTA_PROFILER_HPP
@@ -0,0 +1,137 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the QuantileSketch class
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <htm/utils/Log.hpp>
+#include <htm/utils/QuantileSketch.hpp>
+
+namespace htm {
+
+QuantileSketch::QuantileSketch(const UInt k, const UInt seed)
+    : k_(k), levels_(1u), rng_(seed) {
+  NTA_CHECK(k >= 8u) << "QuantileSketch: k must be at least 8, got " << k;
+}
+
+
+void QuantileSketch::update(const Real value) {
+  NTA_CHECK(not std::isnan(value)) << "QuantileSketch: NaN value";
+  levels_[0].push_back(value);
+  count_++;
+  compress_();
+}
+
+
+void QuantileSketch::merge(const QuantileSketch &other) {
+  NTA_CHECK(k_ == other.k_) << "QuantileSketch: can not merge k=" << other.k_ << " into k=" << k_;
+  if (levels_.size() < other.levels_.size()) levels_.resize(other.levels_.size());
+  for (size_t h = 0u; h < other.levels_.size(); h++) {
+    levels_[h].insert(levels_[h].end(), other.levels_[h].cbegin(), other.levels_[h].cend());
+  }
+  count_ += other.count_;
+  compress_();
+}
+
+
+void QuantileSketch::clear() {
+  count_ = 0u;
+  levels_.assign(1u, {});
+}
+
+
+size_t QuantileSketch::numRetained() const {
+  size_t retained = 0u;
+  for (const auto &level : levels_) retained += level.size();
+  return retained;
+}
+
+
+size_t QuantileSketch::capacity_(const size_t level) const {
+  const size_t depth = levels_.size() - 1u - level; // 0 for the top level
+  const Real64 capacity = std::ceil(k_ * std::pow(2.0 / 3.0, static_cast<Real64>(depth)));
+  return std::max<size_t>(2u, static_cast<size_t>(capacity));
+}
+
+
+void QuantileSketch::compress_() {
+  while (true) {
+    size_t total = 0u;
+    for (size_t h = 0u; h < levels_.size(); h++) total += capacity_(h);
+    if (numRetained() <= total) return;
+
+    // The lowest full level moves half of its values up.
+    size_t h = 0u;
+    while (levels_[h].size() < capacity_(h)) h++;
+    if (h + 1u == levels_.size()) levels_.emplace_back();
+    auto &level = levels_[h];
+    std::sort(level.begin(), level.end());
+    const size_t odd = level.size() % 2u; // the smallest value stays if the count is odd
+    const size_t offset = rng_.getUInt32(2u);
+    auto &up = levels_[h + 1u];
+    for (size_t i = odd + offset; i < level.size(); i += 2u) up.push_back(level[i]);
+    level.resize(odd);
+  }
+}
+
+
+void QuantileSketch::sortedView(std::vector<std::pair<Real, UInt64>> &view) const {
+  view.clear();
+  for (size_t h = 0u; h < levels_.size(); h++) {
+    const UInt64 weight = UInt64(1u) << h;
+    for (const auto value : levels_[h]) view.emplace_back(value, weight);
+  }
+  std::sort(view.begin(), view.end());
+}
+
+
+Real64 QuantileSketch::cdf(const Real value) const {
+  if (count_ == 0u) return 0.0;
+  UInt64 below = 0u;
+  for (size_t h = 0u; h < levels_.size(); h++) {
+    for (const auto x : levels_[h]) {
+      if (x <= value) below += UInt64(1u) << h;
+    }
+  }
+  return static_cast<Real64>(below) / static_cast<Real64>(count_);
+}
+
+
+Real QuantileSketch::quantile(const Real64 fraction) const {
+  NTA_CHECK(fraction >= 0.0 and fraction <= 1.0) << "QuantileSketch: fraction " << fraction << " not in [0, 1]";
+  if (count_ == 0u) return 0.0f;
+  std::vector<std::pair<Real, UInt64>> view;
+  sortedView(view);
+  const Real64 target = fraction * static_cast<Real64>(count_);
+  UInt64 cumulative = 0u;
+  for (const auto &entry : view) {
+    cumulative += entry.second;
+    if (static_cast<Real64>(cumulative) >= target) return entry.first;
+  }
+  return view.back().first;
+}
+
+
+bool QuantileSketch::operator==(const QuantileSketch &other) const {
+  return k_ == other.k_ and count_ == other.count_ and levels_ == other.levels_ and rng_ == other.rng_;
+}
+
+} // namespace htm
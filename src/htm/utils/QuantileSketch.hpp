@@ -0,0 +1,127 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the QuantileSketch class
+ */
+
+#ifndef NTA_QUANTILE_SKETCH_HPP
+#define NTA_QUANTILE_SKETCH_HPP
+
+#include <utility>
+#include <vector>
+
+#include <htm/types/Serializable.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace htm {
+
+/**
+ * QuantileSketch - the approximate distribution of a stream of values in
+ * bounded memory, a KLL sketch (Karnin, Lang & Liberty, 2016.
+ * https://arxiv.org/abs/1603.05346).
+ *
+ * @b Description
+ * The values are kept in levels, a value of level h stands for 2^h values
+ * of the stream.  When a level is full it is sorted and every other value,
+ * starting at a random offset, moves up one level.  The capacity of the
+ * levels shrinks by 2/3 from the top down, so about 3 * k values are kept
+ * however long the stream, and the rank of a value is estimated within
+ * about 1.7 / k of the count (k=200: 1%).  Adding a value is amortized
+ * O(log k).
+ *
+ * Sketches with the same k merge into the sketch of both streams, eg. the
+ * sketches of many streams into a baseline of the whole fleet.
+ *
+ * Example Usage:
+ *    QuantileSketch sketch;
+ *    for(...) sketch.update( value );
+ *    sketch.quantile( 0.99 );
+ *    sketch.cdf( value );
+ */
+class QuantileSketch : public Serializable {
+public:
+  /**
+   * @param k    Accuracy parameter, at least 8.  Memory is about 3 * k values.
+   * @param seed For the random offsets of the compactions.
+   */
+  explicit QuantileSketch(UInt k = 200u, UInt seed = 42u);
+
+  void update(Real value);
+
+  /**
+   * Add the values of another sketch with the same k.
+   */
+  void merge(const QuantileSketch &other);
+
+  void clear();
+
+  UInt getK() const { return k_; }
+
+  // The number of values of the stream.
+  UInt64 getCount() const { return count_; }
+
+  // The number of values kept.
+  size_t numRetained() const;
+
+  /**
+   * @returns The estimated fraction of the values which are <= value, 0 if
+   * the sketch is empty.
+   */
+  Real64 cdf(Real value) const;
+
+  /**
+   * @param fraction In [0, 1], eg. 0.5 for the median.
+   * @returns The smallest kept value which at least `fraction` of the
+   * values do not exceed, 0 if the sketch is empty.
+   */
+  Real quantile(Real64 fraction) const;
+
+  /**
+   * The kept values, sorted, with the number of values each stands for.
+   */
+  void sortedView(std::vector<std::pair<Real, UInt64>> &view) const;
+
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive & ar) const {
+    ar(CEREAL_NVP(k_), CEREAL_NVP(count_), CEREAL_NVP(levels_), CEREAL_NVP(rng_));
+  }
+  template<class Archive>
+  void load_ar(Archive & ar) {
+    ar(CEREAL_NVP(k_), CEREAL_NVP(count_), CEREAL_NVP(levels_), CEREAL_NVP(rng_));
+  }
+
+  bool operator==(const QuantileSketch &other) const;
+  inline bool operator!=(const QuantileSketch &other) const
+      { return not ((*this) == other); }
+
+private:
+  size_t capacity_(size_t level) const;
+  // Compact levels until the values fit.
+  void compress_();
+
+  UInt k_;
+  UInt64 count_ = 0u;
+  std::vector<std::vector<Real>> levels_; // level h holds values of weight 2^h
+  Random rng_;
+};
+
+} // namespace htm
+
+#endif // NTA_QUANTILE_SKETCH_HPP
@@ -18,6 +18,8 @@
 /** @file
     Random Number Generator implementation
 */
+#include <unordered_set>
+
 #include <htm/utils/Log.hpp>
 #include <htm/utils/Random.hpp>
 
@@ -26,7 +28,9 @@ using namespace htm;
 bool Random::operator==(const Random &o) const {
   return seed_ == o.seed_ && \
 	 steps_ == o.steps_ && \
-	 gen == o.gen;
+	 counter_ == o.counter_ && \
+	 stream_ == o.stream_ && \
+	 (counter_ || gen == o.gen);
 }
 
 std::random_device rd; //HW RNG, undeterministic, platform dependant. Use only for seeding rng if random seed wanted (seed=0)
@@ -43,6 +47,85 @@ Random::Random(const UInt64 seed) {
   steps_ = 0;
 }
 
+std::vector<UInt> Random::sampleIndices(const UInt population, const UInt nChoices) {
+  NTA_CHECK(nChoices <= population) << "population size must be greater than number of choices";
+  std::vector<UInt> choices;
+  choices.reserve(nChoices);
+  if( nChoices == 0u ) return choices;
+
+  // Floyd: for each j of the last nChoices values, draw t from [0, j]; take t,
+  // or j itself if t was taken already.  Every subset is equally likely.
+  if( population / 64u <= nChoices ) {
+    // Dense selection: a bitmap, which also yields the values in order.
+    std::vector<bool> taken(population, false);
+    for(UInt j = population - nChoices; j < population; j++) {
+      const UInt t = getUInt32(static_cast<UInt32>(j + 1u));
+      taken[taken[t] ? j : t] = true;
+    }
+    for(UInt i = 0; i < population; i++) {
+      if( taken[i] ) choices.push_back(i);
+    }
+  }
+  else {
+    std::unordered_set<UInt> taken(2u * nChoices);
+    for(UInt j = population - nChoices; j < population; j++) {
+      const UInt t = getUInt32(static_cast<UInt32>(j + 1u));
+      if( taken.insert(t).second ) {
+        choices.push_back(t);
+      } else {
+        taken.insert(j);
+        choices.push_back(j);
+      }
+    }
+    std::sort(choices.begin(), choices.end());
+  }
+  return choices;
+}
+
+
+namespace {
+  // Philox4x32-10, the counter-based generator of Random123.  Encrypts the
+  // 128 bit counter with the 64 bit key, in place.
+  void philox4x32(std::array<UInt32, 4> &ctr, UInt32 key0, UInt32 key1) {
+    for(int round = 0; round < 10; round++) {
+      if( round > 0 ) {
+        key0 += 0x9E3779B9u;
+        key1 += 0xBB67AE85u;
+      }
+      const UInt64 p0 = static_cast<UInt64>(0xD2511F53u) * ctr[0];
+      const UInt64 p1 = static_cast<UInt64>(0xCD9E8D57u) * ctr[2];
+      ctr = {{ static_cast<UInt32>(p1 >> 32) ^ ctr[1] ^ key0, static_cast<UInt32>(p1),
+               static_cast<UInt32>(p0 >> 32) ^ ctr[3] ^ key1, static_cast<UInt32>(p0) }};
+    }
+  }
+
+  // SplitMix64 finalizer, a bijective hash.
+  UInt64 mix64(UInt64 x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+  }
+}
+
+void Random::generateBlock_(const UInt64 block) {
+  words_ = {{ static_cast<UInt32>(block), static_cast<UInt32>(block >> 32),
+              static_cast<UInt32>(stream_), static_cast<UInt32>(stream_ >> 32) }};
+  philox4x32(words_, static_cast<UInt32>(seed_), static_cast<UInt32>(seed_ >> 32));
+  block_ = block;
+}
+
+Random Random::split(const UInt64 streamId) const {
+  Random sub(*this);
+  sub.counter_ = true;
+  // Substreams of the seed are numbered by their id, substreams of a
+  // substream by a hash of both ids.
+  sub.stream_  = counter_ ? mix64(stream_ ^ mix64(streamId + 1u)) : streamId;
+  sub.steps_   = 0u;
+  sub.block_   = NO_BLOCK;
+  return sub;
+}
+
+
 namespace htm {
 // helper function for seeding RNGs across the plugin barrier
 UInt32 GetRandomSeed(const UInt seed) {
@@ -23,9 +23,12 @@
 #define NTA_RANDOM_HPP
 
 #include <algorithm>
+#include <array>
 #include <iterator>
+#include <limits>
 #include <random>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <htm/types/Types.hpp>
@@ -57,6 +60,15 @@ namespace htm {
  *
  * The self-seed is logged to NTA_INFO if used.
  *
+ * Counter-based substreams: split(streamId) returns an independent generator
+ * whose values are a pure function of (seed, streamId, step), computed by the
+ * Philox4x32-10 block cipher (Salmon et al., "Parallel random numbers: as easy
+ * as 1, 2, 3", SC 2011).  Parallel kernels give each work item (eg. a column or
+ * a segment) its own substream, so they need not share a generator and their
+ * results do not depend on the number of threads:
+ *       Random rng(seed);
+ *       parallelFor(n, [&](i) { Random local = rng.split(i); ... });
+ *
  * In Release mode: good self-seeds are generated by an internal global random
  * number generator, which is seeded from the system time.
  *
@@ -78,17 +90,30 @@ public:
   CerealAdapter;
   template<class Archive>
   void save_ar(Archive & ar) const {
+    saveArchiveVersion(ar, UInt64(0u), ARCHIVE_VERSION); //the seed is never 0
     ar( CEREAL_NVP(seed_),
-        CEREAL_NVP(steps_)
+        CEREAL_NVP(steps_),
+        CEREAL_NVP(counter_),
+        CEREAL_NVP(stream_)
     );  
   }
   template<class Archive>
   void load_ar(Archive & ar) {
-    ar( CEREAL_NVP(seed_), 
-	CEREAL_NVP(steps_)
-    );  
-    gen.seed(static_cast<UInt32>(seed_)); //reseed
-    gen.discard(steps_); //advance n steps
+    const UInt32 version = loadArchiveVersion(ar, "seed_", seed_, UInt64(0u), 1u);
+    ar( CEREAL_NVP(steps_) );
+    if( version >= 2u ) {
+      ar( CEREAL_NVP(counter_),
+          CEREAL_NVP(stream_) );
+    } else { //before split()
+      counter_ = false;
+      stream_  = 0u;
+    }
+    if( counter_ ) {
+      block_ = NO_BLOCK; //the position is steps_, nothing to replay
+    } else {
+      gen.seed(static_cast<UInt32>(seed_)); //reseed
+      gen.discard(steps_); //advance n steps
+    }
   }
 
   bool operator==(const Random &other) const;
@@ -101,20 +126,32 @@ public:
    */
   inline UInt32 getUInt32(const UInt32 max = MAX32) {
     NTA_ASSERT(max > 0);
-    steps_++;
-    return gen() % max; //uniform_int_distribution(gen) replaced, as is not same on all platforms! 
+    return next_() % max; //uniform_int_distribution(gen) replaced, as is not same on all platforms! 
   }
 
   /** return a double uniformly distributed on [0,1.0)
    * May not be cross-platform (but currently is to our experience)
    */
   inline Real64 getReal64() {
-    steps_++;
-    return gen() / static_cast<Real64>(max());
+    return next_() / static_cast<Real64>(max());
   }
 
+  /**
+   * Returns the counter-based substream streamId of this generator.
+   *
+   * The substream depends only on the seed (and the stream of a substream)
+   * and on streamId, not on the values drawn so far, so split(i) is the same
+   * generator whenever and on whichever thread it is called.  Substreams of
+   * different ids are independent, and splitting a substream again yields
+   * further substreams.  A substream draws one 32 bit value per step, like
+   * the default generator, but its values differ from it.
+   */
+  Random split(UInt64 streamId) const;
+
   // populate choices with a random selection of nChoices elements from
   // population. throws exception when nPopulation < nChoices
+  // Copies and shuffles the whole population, see the overload with an output
+  // buffer for small nChoices.
   // templated functions must be defined in header
   //TODO replace with std::sample in c++17 : https://en.cppreference.com/w/cpp/algorithm/sample 
   template <class T>
@@ -130,6 +167,66 @@ public:
   }
 
 
+  /**
+   * Random selection of nChoices elements of population, in random order, into
+   * output (which is cleared first, its capacity is reused).  A partial
+   * Fisher-Yates shuffle: nChoices draws, and the population is neither copied
+   * nor modified, the shuffle is tracked by the few displaced positions.  The
+   * result is the same as partialShuffle() of a copy of the population, but
+   * not the same as sample(population, nChoices), which draws once per element.
+   * @throws if population.size() < nChoices.
+   */
+  template <class T>
+  void sample(const std::vector<T>& population, UInt nChoices, std::vector<T>& output) {
+    NTA_CHECK(nChoices <= population.size()) << "population size must be greater than number of choices";
+    output.clear();
+    output.reserve(nChoices);
+    const UInt n = static_cast<UInt>(population.size());
+    std::unordered_map<UInt, UInt> displaced; // position -> index of the element now there
+    const auto at = [&displaced](UInt position) {
+      const auto it = displaced.find(position);
+      return it == displaced.end() ? position : it->second;
+    };
+    for(UInt i = 0u; i < nChoices; i++) {
+      const UInt j = i + getUInt32(n - i);
+      const UInt chosen = at(j);
+      const UInt moved  = at(i);
+      if( j != i ) displaced[j] = moved;
+      output.push_back(population[chosen]);
+    }
+  }
+
+
+  /**
+   * Moves a random selection of nChoices elements of [first, last), in random
+   * order, to the front of the range: a partial Fisher-Yates shuffle with
+   * nChoices draws.  The order of the other elements is unspecified.
+   * @throws if the range is shorter than nChoices.
+   */
+  template <class RandomIt>
+  void partialShuffle(RandomIt first, RandomIt last, UInt nChoices) {
+    const UInt n = static_cast<UInt>(last - first);
+    NTA_CHECK(nChoices <= n) << "population size must be greater than number of choices";
+    for(UInt i = 0u; i < nChoices; i++) {
+      const UInt j = i + getUInt32(n - i);
+      std::swap(first[i], first[j]);
+    }
+  }
+
+
+  /**
+   * Random selection of nChoices distinct values from [0, population), in
+   * ascending order.  Uses Robert Floyd's algorithm: nChoices random draws,
+   * the population is never built.  A sparse selection (nChoices below
+   * population / 64) keeps the taken values in a hash set, O(nChoices) memory;
+   * a denser one marks them in a bitmap of population bits, which also yields
+   * them in order.  The result is not the same as sample() of the same
+   * population, which draws once per element.
+   * @throws if population < nChoices.
+   */
+  std::vector<UInt> sampleIndices(UInt population, UInt nChoices);
+
+
   /**
    * return random from range [from, to)
    */
@@ -170,7 +267,26 @@ private:
   UInt64 seed_;
   UInt64 steps_ = 0;  //step counter, used in serialization. It is important that steps_ is in sync with number of 
   // calls to RNG
-  std::mt19937 gen; //Standard mersenne_twister_engine 64bit seeded with seed_
+  std::mt19937 gen; //Standard mersenne_twister_engine 64bit seeded with seed_, unused by substreams
+
+  // Counter-based mode (substreams of split()): value number steps_ is word
+  // steps_ % 4 of Philox4x32-10( key = seed_, counter = {steps_ / 4, stream_} ).
+  bool   counter_ = false;
+  UInt64 stream_  = 0u;
+  static const UInt32 ARCHIVE_VERSION = 2u; //1: before the substreams
+  static const UInt64 NO_BLOCK = std::numeric_limits<UInt64>::max();
+  UInt64 block_   = NO_BLOCK;  //counter of the cached words_
+  std::array<UInt32, 4> words_ {{ 0u, 0u, 0u, 0u }};
+
+  void generateBlock_(UInt64 block);
+
+  // the next 32 bit value of either mode
+  inline UInt32 next_() {
+    const UInt64 step = steps_++;
+    if( not counter_ ) return static_cast<UInt32>(gen());
+    if( step / 4u != block_ ) generateBlock_(step / 4u);
+    return words_[step % 4u];
+  }
 //  std::random_device rd; //HW random for random seed cases, undeterministic -> problems with op= and copy-constructor, therefore disabled
 
   // our reimpementation of std::shuffle, 
@@ -19,7 +19,6 @@
  */
 
 #include <cmath> // log2, isnan, NAN, INFINITY
-#include <numeric> // accumulate
 #include <regex>
 #include <htm/utils/SdrMetrics.hpp>
 
@@ -28,6 +27,91 @@ using namespace std;
 namespace htm {
 
 
+MetricsWorker_::MetricsWorker_( const vector<UInt> &dimensions,
+                                function<void(const SDR&)> consume,
+                                size_t maxQueue )
+    : consume_( consume ),
+      maxQueue_( maxQueue ),
+      scratch_( dimensions )
+{
+    thread_ = std::thread( &MetricsWorker_::run_, this );
+}
+
+MetricsWorker_::~MetricsWorker_() {
+    {
+        lock_guard<mutex> lock( mutex_ );
+        stopping_ = true;
+    }
+    changed_.notify_all();
+    thread_.join();
+}
+
+void MetricsWorker_::push( const SDR &data ) {
+    const auto &sparse = data.getSparse();
+    {
+        lock_guard<mutex> lock( mutex_ );
+        if( queue_.size() >= maxQueue_ ) {
+            dropped_++;
+            return;
+        }
+        if( free_.empty() ) {
+            queue_.emplace_back( sparse );
+        }
+        else {
+            queue_.push_back( std::move( free_.back() ));
+            free_.pop_back();
+            queue_.back().assign( sparse.begin(), sparse.end() );
+        }
+    }
+    changed_.notify_all();
+}
+
+void MetricsWorker_::flush() {
+    unique_lock<mutex> lock( mutex_ );
+    changed_.wait( lock, [this]() { return queue_.empty() and not busy_; });
+    if( error_ ) {
+        auto error = error_;
+        error_ = nullptr;
+        rethrow_exception( error );
+    }
+}
+
+UInt64 MetricsWorker_::getDropped() {
+    lock_guard<mutex> lock( mutex_ );
+    return dropped_;
+}
+
+void MetricsWorker_::run_() {
+    unique_lock<mutex> lock( mutex_ );
+    while( true ) {
+        changed_.wait( lock, [this]() { return stopping_ or not queue_.empty(); });
+        if( queue_.empty() )
+            break; // Stopping, and all data was consumed.
+        SDR_sparse_t sparse = std::move( queue_.front() );
+        queue_.pop_front();
+        busy_ = true;
+        lock.unlock();
+
+        try {
+            scratch_.setSparse( sparse ); // Swaps the buffers.
+            consume_( scratch_ );
+        }
+        catch( ... ) {
+            lock.lock();
+            error_ = current_exception();
+            lock.unlock();
+        }
+
+        lock.lock();
+        busy_ = false;
+        free_.push_back( std::move( sparse ));
+        changed_.notify_all();
+    }
+}
+
+
+/******************************************************************************/
+
 MetricsHelper_::MetricsHelper_( const vector<UInt> &dimensions, UInt period ) {
     NTA_CHECK( period > 0u );
     NTA_CHECK( dimensions.size() > 0 );
@@ -37,6 +121,9 @@ MetricsHelper_::MetricsHelper_( const vector<UInt> &dimensions, UInt period ) {
     dataSource_ = nullptr;
     callback_handle_        = -1;
     destroyCallback_handle_ = -1;
+    sampleRate_  = 1u;
+    sampleCount_ = 0u;
+    dropped_     = 0u;
 }
 
 MetricsHelper_::MetricsHelper_( const SDR &dataSource, UInt period )
@@ -44,7 +131,7 @@ MetricsHelper_::MetricsHelper_( const SDR &dataSource, UInt period )
 {
     dataSource_ = &dataSource;
     callback_handle_ = dataSource_->addCallback( [&](){
-        callback( *dataSource_, 1.0f / std::min( period_, (UInt) ++samples_ ));
+        update_( *dataSource_ );
     });
     destroyCallback_handle_ = dataSource_->addDestroyCallback( [&](){
         deconstruct();
@@ -59,17 +146,62 @@ void MetricsHelper_::deconstruct() {
     }
 }
 
+void MetricsHelper_::stopWorker_() {
+    if( worker_ ) {
+        dropped_ += worker_->getDropped();
+        worker_.reset();
+    }
+}
+
 MetricsHelper_::~MetricsHelper_() {
     deconstruct();
+    stopWorker_();
 }
 
 void MetricsHelper_::addData(const SDR &data) {
     NTA_CHECK( dataSource_ == nullptr )
         << "Method addData can only be called if this metric was NOT initialize with an SDR!";
     NTA_CHECK( dimensions_ == data.dimensions );
+    update_( data );
+}
+
+void MetricsHelper_::update_(const SDR &data) {
+    if( sampleCount_++ % sampleRate_ != 0u )
+        return;
+    if( worker_ )
+        worker_->push( data );
+    else
+        measure_( data );
+}
+
+void MetricsHelper_::measure_(const SDR &data) {
     callback( data, 1.0f / std::min( period_, (UInt) ++samples_ ));
 }
 
+void MetricsHelper_::setSampleRate(UInt rate) {
+    NTA_CHECK( rate > 0u ) << "The sample rate must be positive.";
+    sampleRate_  = rate;
+    sampleCount_ = 0u;
+}
+
+void MetricsHelper_::setAsync(bool async, size_t maxQueue) {
+    stopWorker_();
+    if( async ) {
+        NTA_CHECK( maxQueue > 0u ) << "The queue of an asynchronous metric must hold data.";
+        worker_.reset( new MetricsWorker_( dimensions_,
+            [this](const SDR &data) { measure_( data ); }, maxQueue ));
+    }
+}
+
+void MetricsHelper_::flush() const {
+    if( worker_ )
+        worker_->flush();
+}
+
+UInt64 MetricsHelper_::getDropped() const {
+    return dropped_ + (worker_ ? worker_->getDropped() : 0u);
+}
+
 
 /******************************************************************************/
 
@@ -81,6 +213,9 @@ Sparsity::Sparsity( const SDR &dataSource, UInt period )
     : MetricsHelper_( dataSource, period )
     { initialize(); }
 
+Sparsity::~Sparsity()
+    { stopWorker_(); }
+
 void Sparsity::initialize() {
     sparsity_   =  NAN;
     min_        =  INFINITY;
@@ -108,6 +243,7 @@ Real Sparsity::std() const { return std::sqrt( variance_ ); }
 
 std::ostream& operator<<(std::ostream& stream, const Sparsity &S)
 {
+    S.flush();
     return stream << "Sparsity Min/Mean/Std/Max "
         << S.min() << " / " << S.mean() << " / "
         << S.std() << " / " << S.max() << endl;
@@ -133,17 +269,36 @@ ActivationFrequency::ActivationFrequency( const SDR &dataSource,
     : MetricsHelper_( dataSource, period )
     { initialize( dataSource.size, initialValue ); }
 
+ActivationFrequency::~ActivationFrequency()
+    { stopWorker_(); }
+
 void ActivationFrequency::initialize( UInt size, Real initialValue ) {
     if( initialValue == -1 ) {
-        activationFrequency_.assign( size, 1234.567f );
+        initialValue       = 1234.567f;
         alwaysExponential_ = false;
     }
     else {
         NTA_CHECK( initialValue >= 0.0f );
         NTA_CHECK( initialValue <= 1.0f );
-        activationFrequency_.assign( size, initialValue );
         alwaysExponential_ = true;
     }
+    value_.assign( size, initialValue );
+    stamp_.assign( size, 0.0 );
+    epoch_.assign( size, 0u );
+    logTime_    = 0.0;
+    resets_     = 0u;
+    sum_        = (Real64) initialValue * size;
+    sumSquares_ = (Real64) initialValue * initialValue * size;
+    activationFrequency_.assign( size, initialValue );
+    stale_      = true;
+}
+
+Real64 ActivationFrequency::current_( UInt idx ) const {
+    if( epoch_[idx] != resets_ )
+        return 0.0;
+    if( stamp_[idx] == logTime_ )
+        return value_[idx];
+    return value_[idx] * std::exp( logTime_ - stamp_[idx] );
 }
 
 void ActivationFrequency::callback(const SDR &dataSource, Real alpha)
@@ -152,64 +307,87 @@ void ActivationFrequency::callback(const SDR &dataSource, Real alpha)
         alpha = 1.0f / period;
     }
 
-    const auto decay = 1.0f - alpha;
-    for(auto &value : activationFrequency_)
-        value *= decay;
+    // Decay all bits at once, by advancing the time of the inactive bits.
+    const Real64 decay = 1.0 - alpha;
+    if( decay <= 0.0 ) {
+        resets_++;
+        logTime_    = 0.0;
+        sum_        = 0.0;
+        sumSquares_ = 0.0;
+    }
+    else {
+        logTime_    += std::log( decay );
+        sum_        *= decay;
+        sumSquares_ *= decay * decay;
+    }
 
     const auto &sparse = dataSource.getSparse();
-    for(const auto &idx : sparse)
-        activationFrequency_[idx] += alpha;
+    for(const auto &idx : sparse) {
+        const Real64 previous = current_( idx );
+        value_[idx] = (Real) (previous + alpha);
+        stamp_[idx] = logTime_;
+        epoch_[idx] = resets_;
+        sumSquares_ += 2.0 * alpha * previous + (Real64) alpha * alpha;
+    }
+    sum_  += (Real64) alpha * sparse.size();
+    stale_ = true;
+}
+
+const vector<Real> &ActivationFrequency::refresh_() const {
+    if( stale_ ) {
+        min_        =  INFINITY;
+        max_        = -INFINITY;
+        entropySum_ =  0.0f;
+        for(UInt idx = 0u; idx < activationFrequency_.size(); idx++) {
+            const Real frequency      = (Real) current_( idx );
+            activationFrequency_[idx] = frequency;
+            min_         = std::min( min_, frequency );
+            max_         = std::max( max_, frequency );
+            entropySum_ += binary_entropy_( frequency );
+        }
+        stale_ = false;
+    }
+    return activationFrequency_;
 }
 
 Real ActivationFrequency::min() const {
-    return *std::min_element(activationFrequency_.begin(),
-                             activationFrequency_.end());
+    refresh_();
+    return min_;
 }
 
 Real ActivationFrequency::max() const {
-    return *std::max_element(activationFrequency_.begin(),
-                             activationFrequency_.end());
+    refresh_();
+    return max_;
 }
 
 Real ActivationFrequency::mean() const  {
-    const auto sum = std::accumulate( activationFrequency_.begin(),
-                                      activationFrequency_.end(),
-                                      0.0f);
-    return (Real) sum / activationFrequency_.size();
+    return (Real) (sum_ / value_.size());
 }
 
 Real ActivationFrequency::std() const {
-    const auto mean_ = mean();
-    auto sum_squares = 0.0f;
-    for(const auto &frequency : activationFrequency) {
-        const auto displacement = frequency - mean_;
-        sum_squares += displacement * displacement;
-    }
-    const auto variance = sum_squares / activationFrequency.size();
-
-    return std::sqrt( variance );
+    const Real64 mean_    = sum_ / value_.size();
+    const Real64 variance = sumSquares_ / value_.size() - mean_ * mean_;
+    return (Real) std::sqrt( std::max( variance, 0.0 ));
 }
 
-Real ActivationFrequency::binary_entropy_(const vector<Real> &frequencies) {
-    Real accumulator = 0.0f;
-    for(const auto &p  : frequencies) {
-        const auto  p_ = 1.0f - p;
-        const auto  e  = -p * std::log2( p ) - p_ * std::log2( p_ );
-        accumulator   += isnan(e) ? 0.0f : e;
-    }
-    return accumulator / frequencies.size();
+Real ActivationFrequency::binary_entropy_(Real p) {
+    const auto  p_ = 1.0f - p;
+    const auto  e  = -p * std::log2( p ) - p_ * std::log2( p_ );
+    return isnan(e) ? 0.0f : e;
 }
 
 Real ActivationFrequency::entropy() const {
-    const auto max_extropy = binary_entropy_({ mean() });
+    const auto max_extropy = binary_entropy_( mean() );
     if( max_extropy == 0.0f )
         return 0.0f;
-    return binary_entropy_( activationFrequency ) / max_extropy;
+    refresh_();
+    return entropySum_ / activationFrequency_.size() / max_extropy;
 }
 
 std::ostream& operator<< (std::ostream& stream,
                                  const ActivationFrequency &F)
 {
+    F.flush();
     stream << "Activation Frequency Min/Mean/Std/Max "
         << F.min() << " / " << F.mean() << " / "
         << F.std() << " / " << F.max() << endl;
@@ -229,6 +407,9 @@ Overlap::Overlap( const SDR &dataSource, UInt period )
       previous_( dataSource.dimensions )
     { initialize(); }
 
+Overlap::~Overlap()
+    { stopWorker_(); }
+
 void Overlap::initialize() {
     overlap_    =  NAN;
     min_        =  INFINITY;
@@ -238,8 +419,10 @@ void Overlap::initialize() {
     reset();
 }
 
-void Overlap::reset()
-    { previousValid_ = false; }
+void Overlap::reset() {
+    flush();
+    previousValid_ = false;
+}
 
 void Overlap::callback(const SDR &dataSource, Real alpha) {
     if( not previousValid_ ) {
@@ -272,6 +455,7 @@ Real Overlap::std() const { return std::sqrt( variance_ ); }
 
 std::ostream& operator<<(std::ostream& stream, const Overlap &V)
 {
+    V.flush();
     return stream << "Overlap Min/Mean/Std/Max "
         << V.min() << " / " << V.mean() << " / "
         << V.std() << " / " << V.max() << endl;
@@ -280,31 +464,55 @@ std::ostream& operator<<(std::ostream& stream, const Overlap &V)
 
 /******************************************************************************/
 
+Metrics::Dispatch_::Dispatch_( Metrics &metrics, const SDR &dataSource, UInt period )
+    : MetricsHelper_( dataSource, period ),
+      metrics_( metrics )
+      {};
+
+Metrics::Dispatch_::Dispatch_( Metrics &metrics, const vector<UInt> &dimensions, UInt period )
+    : MetricsHelper_( dimensions, period ),
+      metrics_( metrics )
+      {};
+
+Metrics::Dispatch_::~Dispatch_()
+    { stopWorker_(); }
+
+// Each metric weighs its own data, so alpha is not used.
+void Metrics::Dispatch_::callback(const SDR &dataSource, Real) {
+    metrics_.sparsity_.addData( dataSource );
+    metrics_.activationFrequency_.addData( dataSource );
+    metrics_.overlap_.addData( dataSource );
+}
+
 Metrics::Metrics( const vector<UInt> &dimensions, UInt period )
     : dimensions_( dimensions ),
       sparsity_(            dimensions, period ),
       activationFrequency_( dimensions, period ),
-      overlap_(             dimensions, period )
+      overlap_(             dimensions, period ),
+      dispatch_( *this,     dimensions, period )
       {};
 
+// The metrics are attached to the SDR through dispatch_, which can sample the
+// data or measure it on a background thread.
 Metrics::Metrics( const SDR &dataSource, UInt period )
     : dimensions_( dataSource.dimensions ),
-      sparsity_(            dataSource, period ),
-      activationFrequency_( dataSource, period ),
-      overlap_(             dataSource, period )
+      sparsity_(            dataSource.dimensions, period ),
+      activationFrequency_( dataSource.dimensions, period ),
+      overlap_(             dataSource.dimensions, period ),
+      dispatch_( *this,     dataSource, period )
       {};
 
-void Metrics::reset()
-    { overlap_.reset(); }
-
-void Metrics::addData(const SDR &data) {
-    sparsity_.addData( data );
-    activationFrequency_.addData( data );
-    overlap_.addData( data );
+void Metrics::reset() {
+    dispatch_.flush();
+    overlap_.reset();
 }
 
+void Metrics::addData(const SDR &data)
+    { dispatch_.addData( data ); }
+
 std::ostream& operator<<(std::ostream& stream, const Metrics &M)
 {
+    M.flush();
     // Introduction line:  "SDR ( dimensions )"
     stream << "SDR( ";
     for(const auto &dim : M.dimensions_)
@@ -21,17 +21,68 @@
 #ifndef SDR_METRICS_HPP
 #define SDR_METRICS_HPP
 
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <htm/types/Sdr.hpp>
 #include <htm/types/Types.hpp>
 
 namespace htm {
 
+/**
+ * Background thread of an asynchronous metric, @see MetricsHelper_::setAsync.
+ * push() copies the active bits of an SDR into a queue, and the thread calls
+ * consume with each queued SDR in order.
+ */
+class MetricsWorker_ {
+public:
+    MetricsWorker_( const std::vector<UInt> &dimensions,
+                    std::function<void(const SDR&)> consume,
+                    size_t maxQueue );
+
+    // Consumes the remaining queued data, and joins the thread.
+    ~MetricsWorker_();
+
+    MetricsWorker_(const MetricsWorker_ &) = delete;
+    MetricsWorker_ &operator=(const MetricsWorker_ &) = delete;
+
+    // Drops the datum if the queue is full.
+    void push( const SDR &data );
+
+    // Waits until all queued data is consumed.  Rethrows an error of consume.
+    void flush();
+
+    UInt64 getDropped();
+
+private:
+    void run_();
+
+    const std::function<void(const SDR&)> consume_;
+    const size_t maxQueue_;
+    SDR scratch_;
+    std::deque<SDR_sparse_t> queue_;
+    std::vector<SDR_sparse_t> free_; // recycled buffers of the queue
+    bool busy_     = false;
+    bool stopping_ = false;
+    UInt64 dropped_ = 0u;
+    std::exception_ptr error_;
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::thread thread_;
+};
+
+
 /**
  * Helper for SDR metrics trackers, including: Sparsity,
  * ActivationFrequency, and Overlap classes.
  *
- * Subclasses must override method "callback".
+ * Subclasses must override method "callback", and must call stopWorker_()
+ * in their destructor.
  */
 class MetricsHelper_ {
 public:
@@ -47,6 +98,37 @@ public:
      */
     void addData(const SDR &data);
 
+    /**
+     * Measure only one out of every @param rate data, eg. 10 measures every
+     * tenth assignment to the SDR.  The period counts the measured data.
+     * The default rate is 1, which measures all data.
+     */
+    void setSampleRate(UInt rate);
+    UInt getSampleRate() const { return sampleRate_; }
+
+    /**
+     * In asynchronous mode the SDR callback only copies the active bits into
+     * a queue, and a background thread updates this metric, so the thread
+     * which assigns the SDR (eg. a Network computing) barely waits for it.
+     * Data which arrives while @param maxQueue data are waiting is dropped,
+     * @see getDropped().
+     *
+     * Call flush() before reading the results of an asynchronous metric.
+     */
+    void setAsync(bool async, size_t maxQueue = 1024u);
+    bool isAsync() const { return worker_ != nullptr; }
+
+    /**
+     * Waits until the background thread measured all queued data.
+     * Does nothing if the metric is not asynchronous.
+     */
+    void flush() const;
+
+    /**
+     * @returns The number of data dropped because the queue was full.
+     */
+    UInt64 getDropped() const;
+
     virtual ~MetricsHelper_();
 
 private:
@@ -54,6 +136,14 @@ private:
     const SDR* dataSource_;
     UInt callback_handle_;
     UInt destroyCallback_handle_;
+    UInt   sampleRate_;
+    UInt64 sampleCount_;
+    UInt64 dropped_;     // by previous workers
+    std::unique_ptr<MetricsWorker_> worker_;
+
+    void update_( const SDR &data );
+
+    void measure_( const SDR &data );
 
 protected:
     UInt period_;
@@ -78,6 +168,10 @@ protected:
 
     void deconstruct();
 
+    // Measures the queued data and stops the background thread, which calls
+    // the subclass; so it must stop before the subclass is destroyed.
+    void stopWorker_();
+
     /**
      * Add another datum to the metric.
      *      Subclasses MUST override this method!
@@ -131,6 +225,8 @@ public:
      */
     Sparsity( const std::vector<UInt> &dimensions, UInt period );
 
+    ~Sparsity() override;
+
     const Real &sparsity = sparsity_;
 
     Real min() const;
@@ -211,7 +307,31 @@ public:
     ActivationFrequency( const std::vector<UInt> &dimensions, UInt period,
                          Real initialValue = -1 );
 
-    const std::vector<Real> &activationFrequency = activationFrequency_;
+    ~ActivationFrequency() override;
+
+    /**
+     * Read only view of the activation frequency of each bit.
+     *
+     * The decay of the inactive bits is applied lazily, so adding data costs
+     * O(active bits).  Reading the values brings every bit up to date, which
+     * is O(size) once per sample; min(), max() and entropy() share that pass.
+     */
+    class Frequencies {
+    public:
+        explicit Frequencies( const ActivationFrequency &owner ) : owner_( owner ) {}
+
+        operator const std::vector<Real> &() const { return owner_.refresh_(); }
+        Real operator[]( size_t idx ) const        { return owner_.refresh_()[idx]; }
+        const Real *data() const                   { return owner_.refresh_().data(); }
+        size_t size() const                        { return owner_.value_.size(); }
+        bool operator==( const std::vector<Real> &other ) const
+            { return owner_.refresh_() == other; }
+
+    private:
+        const ActivationFrequency &owner_;
+    };
+
+    const Frequencies activationFrequency{ *this };
 
     Real min() const;
     Real max() const;
@@ -234,12 +354,32 @@ public:
     friend std::ostream& operator<< (std::ostream &, const ActivationFrequency &);
 
 private:
-    std::vector<Real> activationFrequency_;
+    // Each bit stores its frequency as of its last activation, with the
+    // logTime_ and the resets_ at that time.  Its current frequency is
+    // value_ * exp(logTime_ - stamp_), or zero if a reset happened since.
+    std::vector<Real>   value_;
+    std::vector<Real64> stamp_;
+    std::vector<UInt>   epoch_;
+    Real64 logTime_;    // Sum of log(decay) since the last reset.
+    UInt   resets_;     // Samples with alpha == 1, which replace every bit.
+    Real64 sum_;        // Running sums of all frequencies, for mean and std.
+    Real64 sumSquares_;
     bool alwaysExponential_;
 
+    // Cache of the current frequencies, refreshed when read.
+    mutable std::vector<Real> activationFrequency_;
+    mutable bool stale_;
+    mutable Real min_;
+    mutable Real max_;
+    mutable Real entropySum_;
+
     void initialize(UInt size, Real initialValue);
 
-    static Real binary_entropy_(const std::vector<Real> &frequencies);
+    Real64 current_(UInt idx) const;
+
+    const std::vector<Real> &refresh_() const;
+
+    static Real binary_entropy_(Real frequency);
 
     void callback(const SDR &dataSource, Real alpha) override;
 };
@@ -288,6 +428,8 @@ public:
      */
     Overlap( const std::vector<UInt> &dimensions, UInt period );
 
+    ~Overlap() override;
+
     /* For use with time-series data sets. */
     void reset();
 
@@ -379,13 +521,37 @@ public:
      */
     void addData(const SDR &data);
 
+    /**
+     * Sampling and asynchronous mode of all three metrics, one background
+     * thread updates them.  @see MetricsHelper_::setAsync
+     * Call flush() before reading the results of asynchronous Metrics.
+     */
+    void setSampleRate(UInt rate)                    { dispatch_.setSampleRate( rate ); }
+    UInt getSampleRate() const                       { return dispatch_.getSampleRate(); }
+    void setAsync(bool async, size_t maxQueue = 1024u) { dispatch_.setAsync( async, maxQueue ); }
+    bool isAsync() const                             { return dispatch_.isAsync(); }
+    void flush() const                               { dispatch_.flush(); }
+    UInt64 getDropped() const                        { return dispatch_.getDropped(); }
+
     friend std::ostream& operator<<(std::ostream& stream, const Metrics &M);
 
 private:
+    // Receives the data of the SDR, and adds it to the three metrics.
+    class Dispatch_ : public MetricsHelper_ {
+    public:
+        Dispatch_( Metrics &metrics, const SDR &dataSource, UInt period );
+        Dispatch_( Metrics &metrics, const std::vector<UInt> &dimensions, UInt period );
+        ~Dispatch_() override;
+    private:
+        Metrics &metrics_;
+        void callback(const SDR &dataSource, Real alpha) override;
+    };
+
     std::vector<UInt>   dimensions_;
     Sparsity            sparsity_;
     ActivationFrequency activationFrequency_;
     Overlap             overlap_;
+    Dispatch_           dispatch_;
 };
 
 } // end namespace htm
@@ -0,0 +1,105 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the SequenceGenerator class
+ */
+
+#include <htm/utils/Log.hpp>
+#include <htm/utils/SequenceGenerator.hpp>
+
+namespace htm {
+
+SequenceGenerator::SequenceGenerator(const SequenceGeneratorParameters &parameters)
+    : parameters_(parameters), rng_(parameters.seed) {
+  const auto &p = parameters_;
+  NTA_CHECK(!p.dimensions.empty()) << "SequenceGenerator: dimensions are required.";
+  NTA_CHECK(p.sparsity > 0.0f && p.sparsity <= 1.0f) << "SequenceGenerator: sparsity " << p.sparsity << " not in (0, 1].";
+  NTA_CHECK(p.alphabetSize > 0u && p.sequenceLength > 0u) << "SequenceGenerator: empty alphabet or sequences.";
+  NTA_CHECK(p.branching >= 0.0f && p.branching <= 1.0f) << "SequenceGenerator: branching " << p.branching << " not in [0, 1].";
+  NTA_CHECK(p.repetition >= 0.0f && p.repetition <= 1.0f) << "SequenceGenerator: repetition " << p.repetition << " not in [0, 1].";
+  NTA_CHECK(p.noise >= 0.0f && p.noise <= 1.0f) << "SequenceGenerator: noise " << p.noise << " not in [0, 1].";
+  NTA_CHECK(p.numSequences > 0u || p.repetition == 0.0f) << "SequenceGenerator: no sequences to repeat.";
+
+  alphabet_.reserve(p.alphabetSize);
+  for (UInt i = 0u; i < p.alphabetSize; i++) {
+    alphabet_.emplace_back(p.dimensions);
+    alphabet_.back().randomize(p.sparsity, rng_, true);
+  }
+
+  // Build the set element by element, an element may continue an earlier
+  // sequence which has the same previous element.
+  sequences_.assign(p.numSequences, std::vector<UInt>(p.sequenceLength));
+  std::vector<UInt> candidates;
+  for (UInt s = 0u; s < p.numSequences; s++) {
+    auto &sequence = sequences_[s];
+    sequence[0] = rng_.getUInt32(p.alphabetSize);
+    for (UInt i = 1u; i < p.sequenceLength; i++) {
+      candidates.clear();
+      for (UInt earlier = 0u; earlier < s; earlier++) {
+        if (sequences_[earlier][i - 1u] == sequence[i - 1u])
+          candidates.push_back(earlier);
+      }
+      if (p.branching > 0.0f && rng_.getReal64() < p.branching) {
+        // Without a shared previous element, join any earlier sequence.
+        if (candidates.empty())
+          for (UInt earlier = 0u; earlier < s; earlier++) candidates.push_back(earlier);
+        if (!candidates.empty()) {
+          sequence[i] = sequences_[candidates[rng_.getUInt32(static_cast<UInt32>(candidates.size()))]][i];
+          continue;
+        }
+      }
+      sequence[i] = rng_.getUInt32(p.alphabetSize);
+    }
+  }
+  position_ = p.sequenceLength; // starts a sequence
+}
+
+
+bool SequenceGenerator::next(SDR &output) {
+  const auto &p = parameters_;
+  const bool start = position_ == p.sequenceLength;
+  if (start) {
+    if (p.numSequences > 0u && (p.repetition >= 1.0f || rng_.getReal64() < p.repetition)) {
+      current_ = static_cast<Int>(rng_.getUInt32(p.numSequences));
+      symbols_ = sequences_[static_cast<size_t>(current_)];
+    } else {
+      current_ = -1;
+      symbols_.resize(p.sequenceLength);
+      for (auto &symbol : symbols_) symbol = rng_.getUInt32(p.alphabetSize);
+    }
+    position_ = 0u;
+  }
+  output.setSDR(alphabet_[symbols_[position_++]]);
+  if (p.noise > 0.0f)
+    output.addNoise(p.noise, rng_, true);
+  return start;
+}
+
+
+void SequenceGenerator::generate(const size_t count, std::vector<SDR> &sdrs, std::vector<bool> &resets) {
+  sdrs.clear();
+  resets.clear();
+  sdrs.reserve(count);
+  resets.reserve(count);
+  for (size_t i = 0u; i < count; i++) {
+    sdrs.emplace_back(parameters_.dimensions);
+    resets.push_back(next(sdrs.back()));
+  }
+}
+
+} // namespace htm
@@ -0,0 +1,153 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the SequenceGenerator class
+ */
+
+#ifndef NTA_SEQUENCE_GENERATOR_HPP
+#define NTA_SEQUENCE_GENERATOR_HPP
+
+#include <vector>
+
+#include <htm/types/Sdr.hpp>
+#include <htm/types/Types.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace htm {
+
+struct SequenceGeneratorParameters
+{
+  /**
+   * Member "dimensions" of the generated SDRs.
+   */
+  std::vector<UInt> dimensions;
+
+  /**
+   * Member "sparsity" of the generated SDRs, see SDR::randomize().
+   */
+  Real sparsity = 0.02f;
+
+  /**
+   * Member "alphabetSize" is the number of distinct SDRs, the symbols which
+   * the sequences are made of.  A symbol may appear in several sequences
+   * and positions, so only its context predicts the next one.
+   */
+  UInt alphabetSize = 100u;
+
+  /**
+   * Members "numSequences" and "sequenceLength" give the set of sequences
+   * which the stream repeats.
+   */
+  UInt numSequences = 10u;
+  UInt sequenceLength = 10u;
+
+  /**
+   * Member "branching" is the probability that an element continues an
+   * earlier sequence, ie. is the element of the same position of another
+   * sequence which has the same previous element.  Sequences thus share
+   * subsequences and branch apart, like "A B C D" and "X B C Y", which a
+   * Temporal Memory can only predict with high-order context.
+   */
+  Real branching = 0.0f;
+
+  /**
+   * Member "repetition" is the probability that the next sequence of the
+   * stream is one of the set, else it is a new random sequence of symbols
+   * which is not repeated.
+   */
+  Real repetition = 1.0f;
+
+  /**
+   * Member "noise" is the fraction of the active bits of each generated SDR
+   * moved elsewhere, see SDR::addNoise().
+   */
+  Real noise = 0.0f;
+
+  UInt seed = 42u;
+};
+
+/**
+ * SequenceGenerator - a stream of SDRs with the temporal structure of real
+ * data, for benchmarks and tests of sequence learning.
+ *
+ * @b Description
+ * Random SDRs have no temporal correlation, so a Temporal Memory learns
+ * nothing from them and grows segments at the rate of an untrained model.
+ * The stream here repeats a set of sequences of symbols, with controlled
+ * repetition, branching between sequences, noise and sparsity, so the
+ * cost of learning and of predicting can be measured as it is on real
+ * data.  The stream is deterministic for a seed.
+ *
+ * Example Usage:
+ *    SequenceGeneratorParameters p;
+ *    p.dimensions = {2048u};
+ *    p.branching  = 0.2f;
+ *    SequenceGenerator gen( p );
+ *    SDR input( p.dimensions );
+ *    for(...) {
+ *      if( gen.next( input ) ) tm.reset();
+ *      tm.compute( input, true );
+ *    }
+ */
+class SequenceGenerator {
+public:
+  explicit SequenceGenerator(const SequenceGeneratorParameters &parameters);
+
+  const SequenceGeneratorParameters &getParameters() const { return parameters_; }
+
+  /**
+   * The next SDR of the stream.
+   * @returns true if it is the first element of a sequence.
+   */
+  bool next(SDR &output);
+
+  /**
+   * The next `count` SDRs, with the resets for
+   * TemporalMemory::learnSequences().
+   */
+  void generate(size_t count, std::vector<SDR> &sdrs, std::vector<bool> &resets);
+
+  // The symbols of sequence i of the set.
+  const std::vector<UInt> &getSequence(UInt i) const { return sequences_.at(i); }
+
+  // The SDR of a symbol, without noise.
+  const SDR &getSymbol(UInt symbol) const { return alphabet_.at(symbol); }
+
+  /**
+   * The index in the set of the current sequence, -1 if it is a random one,
+   * and the position of the last generated SDR in it.
+   */
+  Int getSequenceIndex() const { return current_; }
+  UInt getPosition() const { return position_ - 1u; }
+
+  // The symbol of the last generated SDR.
+  UInt getSymbolIndex() const { return symbols_[position_ - 1u]; }
+
+private:
+  SequenceGeneratorParameters parameters_;
+  Random rng_;
+  std::vector<SDR> alphabet_;
+  std::vector<std::vector<UInt>> sequences_;
+  std::vector<UInt> symbols_; // of the current sequence
+  Int current_ = -1;
+  UInt position_ = 0u;        // the next element of the current sequence
+};
+
+} // namespace htm
+
+#endif // NTA_SEQUENCE_GENERATOR_HPP
@@ -6,6 +6,7 @@
 #include <iterator>
 #include <cmath>
 #include <string>
+#include <utility>
 
 #include <htm/types/Serializable.hpp>
 #include <htm/types/Types.hpp>
@@ -24,6 +25,9 @@ class SlidingWindow : public Serializable {
   private:
     std::vector<T> buffer_;
     UInt idxNext_;
+    // running sums of the values in the window, for O(1) statistics
+    Real64 sum_ = 0.0;
+    Real64 sumSquares_ = 0.0;
 				
   public:
     SlidingWindow(UInt max_capacity, std::string id="SlidingWindow", int debug=0) : 
@@ -60,9 +64,16 @@ class SlidingWindow : public Serializable {
       if(size() < maxCapacity) {
         buffer_.push_back(newValue);
       } else {
+        const Real64 old = static_cast<Real64>(buffer_[idxNext_]);
+        sum_        -= old;
+        sumSquares_ -= old * old;
         buffer_[idxNext_] = newValue;
       }
-      idxNext_ = (idxNext_ +1 ) %maxCapacity;
+      const Real64 v = static_cast<Real64>(newValue);
+      sum_        += v;
+      sumSquares_ += v * v;
+      // wrap around without a division
+      if(++idxNext_ == maxCapacity) idxNext_ = 0;
     }
 
 
@@ -96,6 +107,47 @@ class SlidingWindow : public Serializable {
       }
 
 
+      /** A view of consecutive elements of the window, without copying
+        them.  Valid until the next append().
+      */
+      struct Span {
+        const T* first;
+        const T* last;
+        const T* begin() const { return first; }
+        const T* end() const { return last; }
+        size_t size() const { return static_cast<size_t>(last - first); }
+        const T& operator[](size_t i) const { return first[i]; }
+      };
+
+
+      /** zero-copy, ordered access to the content: the window is the
+        first span followed by the second span, from oldest to newest.
+        This handles case of |5,6;1,2,3,4| => (|1,2,3,4|, |5,6|)
+        :return pair of spans, either may be empty
+      */
+      std::pair<Span, Span> getSpans() const {
+        const T* data = buffer_.data();
+        return std::make_pair(Span{data + idxNext_, data + buffer_.size()},
+                              Span{data, data + idxNext_});
+      }
+
+
+      /** O(1) statistics of the values in the window, computed from
+        running sums (in Real64) which are updated by append().
+      */
+      Real64 sum() const { return sum_; }
+      Real64 sumOfSquares() const { return sumSquares_; }
+      Real64 mean() const {
+        return buffer_.empty() ? 0.0 : sum_ / static_cast<Real64>(buffer_.size());
+      }
+      Real64 variance() const { //population variance
+        if(buffer_.empty()) return 0.0;
+        const Real64 m = mean();
+        const Real64 var = sumSquares_ / static_cast<Real64>(buffer_.size()) - m * m;
+        return var > 0.0 ? var : 0.0; //rounding
+      }
+
+
       /** linearize method for the internal buffer; this is slower than 
         the pure getData() but ensures that the data are ordered (oldest at
         the beginning, newest at the end of the vector
@@ -103,13 +155,14 @@ class SlidingWindow : public Serializable {
         :return new linearized vector
       */
       std::vector<T> getLinearizedData() const {
+        const auto spans = getSpans();
         std::vector<T> lin;
         lin.reserve(buffer_.size());
 
         //insert the "older" part at the beginning
-        lin.insert(std::begin(lin), std::begin(buffer_) + idxNext_, std::end(buffer_));
+        lin.insert(std::end(lin), spans.first.begin(), spans.first.end());
         //append the "newer" part to the end of the constructed vect
-        lin.insert(std::end(lin), std::begin(buffer_), std::begin(buffer_) + idxNext_);
+        lin.insert(std::end(lin), spans.second.begin(), spans.second.end());
         return lin;
       }
 
@@ -117,9 +170,11 @@ class SlidingWindow : public Serializable {
       bool operator==(const SlidingWindow& r2) const {
         const bool sameSizes = (this->size() == r2.size()) && (this->maxCapacity == r2.maxCapacity);
         if(!sameSizes) return false; 
-        const std::vector<T> v1 = this->getLinearizedData(); 
-        const std::vector<T> v2 = r2.getLinearizedData();
-        return sameSizes && std::equal(v1.cbegin(), v1.cend(), v2.cbegin()); //also content must be same
+        //also content must be same, compared in order without copies
+        for(UInt i = 0; i < static_cast<UInt>(size()); i++) {
+          if(!((*this)[i] == r2[i])) return false;
+        }
+        return true;
       }
 
 
@@ -141,7 +196,8 @@ class SlidingWindow : public Serializable {
         //get last updated position, "current"+index(offset)
         //avoid calling getLinearizeData() as it involves copy()
         if (size() == maxCapacity) {
-          return buffer_[(idxNext_ + index) % maxCapacity];
+          const UInt i = idxNext_ + index;
+          return buffer_[i >= maxCapacity ? i - maxCapacity : i];
         } else {
           return buffer_[index];
         }
@@ -159,6 +215,13 @@ class SlidingWindow : public Serializable {
         std::string name; // for debugging. ID should be already set from constructor.
         ar( name, buffer_, idxNext_);
         // Note: ID, maxCapacity, DEBUG are already set from constructor.
+        sum_ = 0.0;
+        sumSquares_ = 0.0;
+        for(const auto &value : buffer_) {
+          const Real64 v = static_cast<Real64>(value);
+          sum_        += v;
+          sumSquares_ += v * v;
+        }
       }
 }; 
 } //end ns
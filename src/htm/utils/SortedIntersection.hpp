@@ -0,0 +1,81 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * ---------------------------------------------------------------------- */
+
+#ifndef NTA_SORTED_INTERSECTION_HPP
+#define NTA_SORTED_INTERSECTION_HPP
+
+#include <algorithm> // lower_bound, min
+#include <cstddef>
+#include <utility> // swap
+#include <vector>
+
+namespace htm {
+
+/**
+ * Calls emit(value) for each value in both of the sorted ranges [a, aEnd)
+ * and [b, bEnd), in increasing order.  If one range is much shorter, each of
+ * its values is searched for in the longer range by galloping (exponential
+ * then binary search), otherwise the ranges are merged without data
+ * dependent branches.
+ *
+ * This is the intersection of the sparse SDR types, eg. SDR::getOverlap().
+ */
+template<typename T, typename Emit>
+void intersectSorted(const T *a, const T *aEnd, const T *b, const T *bEnd, Emit emit) {
+  if( aEnd - a > bEnd - b ) {
+    std::swap( a, b );
+    std::swap( aEnd, bEnd );
+  }
+  const size_t shorter = aEnd - a;
+  const size_t longer  = bEnd - b;
+  if( shorter * 32u < longer ) {
+    const T *it = b;
+    for( ; a != aEnd; ++a ) {
+      const T value = *a;
+      const size_t remaining = bEnd - it;
+      size_t offset = 1u;
+      while( offset < remaining and it[offset] < value )
+        offset *= 2u;
+      it = std::lower_bound( it + offset / 2u,
+                             it + std::min(offset + 1u, remaining), value );
+      if( it == bEnd )
+        break;
+      if( *it == value ) {
+        emit( value );
+        ++it;
+      }
+    }
+    return;
+  }
+  while( a != aEnd and b != bEnd ) {
+    const T u = *a;
+    const T v = *b;
+    if( u == v )
+      emit( u );
+    a += u <= v;
+    b += v <= u;
+  }
+}
+
+template<typename T, typename Emit>
+void intersectSorted(const std::vector<T> &a, const std::vector<T> &b, Emit emit) {
+  intersectSorted( a.data(), a.data() + a.size(), b.data(), b.data() + b.size(), emit );
+}
+
+} // end namespace htm
+
+#endif // NTA_SORTED_INTERSECTION_HPP
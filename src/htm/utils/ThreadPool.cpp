@@ -0,0 +1,164 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the ThreadPool class.
+ */
+
+#include <algorithm> // std::min
+#include <chrono>
+#include <exception>
+
+#include <htm/os/ThreadAffinity.hpp>
+#include <htm/utils/ThreadPool.hpp>
+#include <htm/utils/Log.hpp>
+
+using namespace htm;
+
+
+ThreadPool::ThreadPool(size_t numThreads) {
+  if (numThreads == 0u) numThreads = hardwareConcurrency();
+  workers_.reserve(numThreads);
+  for (size_t i = 0u; i < numThreads; i++) {
+    workers_.emplace_back([this]() { workerLoop_(); });
+  }
+}
+
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+
+size_t ThreadPool::hardwareConcurrency() {
+  const auto n = std::thread::hardware_concurrency();
+  return n == 0u ? 1u : n;  // hardware_concurrency() may return 0 if unknown
+}
+
+
+std::future<void> ThreadPool::submit(std::function<void()> task) {
+  std::packaged_task<void()> packaged(std::move(task));
+  auto future = packaged.get_future();
+  if (workers_.empty()) {
+    packaged();  // no workers, run inline
+    return future;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    NTA_CHECK(not stop_) << "ThreadPool: submit() on a stopped pool.";
+    tasks_.push_back(std::move(packaged));
+  }
+  cv_.notify_one();
+  return future;
+}
+
+
+bool ThreadPool::setAffinity(const std::vector<UInt> &cores) {
+  bool pinned = true;
+  for (auto &worker : workers_) {
+    pinned = ThreadAffinity::set(worker, cores) and pinned;
+  }
+  return pinned;
+}
+
+
+size_t ThreadPool::numChunks(size_t n, size_t maxChunks) const noexcept {
+  if (maxChunks == 0u) maxChunks = workers_.size() + 1u;
+  return std::min(n, maxChunks);
+}
+
+
+void ThreadPool::parallelFor(size_t n,
+                             const std::function<void(size_t, size_t, size_t)> &fn,
+                             size_t maxChunks) {
+  const size_t chunks = numChunks(n, maxChunks);
+  if (chunks == 0u) return;
+  if (chunks == 1u) {
+    fn(0u, n, 0u);
+    return;
+  }
+
+  const size_t step = n / chunks;
+  const size_t rem  = n % chunks;  // first `rem` chunks get one extra item
+  const auto begin = [=](size_t c) { return c * step + std::min(c, rem); };
+
+  std::vector<std::future<void>> pending;
+  pending.reserve(chunks - 1u);
+  for (size_t c = 1u; c < chunks; c++) {
+    pending.push_back(submit([&fn, c, begin]() { fn(begin(c), begin(c + 1u), c); }));
+  }
+  // The queued chunks use fn and the caller's state, so wait for all of them
+  // even if this chunk throws.
+  std::exception_ptr error;
+  try {
+    fn(begin(0u), begin(1u), 0u);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  // Wait for the other chunks; help the workers meanwhile.
+  for (auto &f : pending) {
+    while (f.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      if (not runPendingTask_()) {
+        f.wait_for(std::chrono::microseconds(50));
+      }
+    }
+  }
+  for (auto &f : pending) {
+    try {
+      f.get();
+    } catch (...) {
+      if (not error) error = std::current_exception();
+    }
+  }
+  if (error) std::rethrow_exception(error);  // the first exception, in chunk order
+}
+
+
+bool ThreadPool::runPendingTask_() {
+  std::packaged_task<void()> task;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tasks_.empty()) return false;
+    task = std::move(tasks_.front());
+    tasks_.pop_front();
+  }
+  task();
+  return true;
+}
+
+
+void ThreadPool::workerLoop_() {
+  while (true) {
+    std::packaged_task<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return stop_ or not tasks_.empty(); });
+      if (tasks_.empty()) return;  // stop_ is set and the queue is drained
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
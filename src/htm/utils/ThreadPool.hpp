@@ -0,0 +1,125 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Definitions for the ThreadPool class.
+ */
+
+#ifndef HTM_UTIL_THREAD_POOL_HPP
+#define HTM_UTIL_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <htm/types/Types.hpp>
+
+namespace htm {
+
+/**
+ * ThreadPool - a fixed set of worker threads executing queued tasks.
+ *
+ * @b Description
+ * Used by the algorithms and the engine to spread work over multiple cores.
+ * A pool with zero worker threads is valid, then all work runs inline
+ * on the calling thread.
+ *
+ * Threads waiting in `parallelFor` help executing queued tasks, so nested
+ * parallel sections cannot deadlock the pool.
+ *
+ * Example Usage:
+ *    ThreadPool pool(4);
+ *    pool.parallelFor(data.size(), [&](size_t begin, size_t end, size_t chunk) {
+ *      for(size_t i = begin; i < end; i++) process(data[i]);
+ *    });
+ */
+class ThreadPool {
+public:
+  /**
+   * @param numThreads Number of worker threads. The value 0 means use
+   *        `hardwareConcurrency()` threads.
+   */
+  explicit ThreadPool(size_t numThreads = 0);
+
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  /**
+   * @returns the number of worker threads.
+   */
+  size_t size() const noexcept { return workers_.size(); }
+
+  /**
+   * @returns the number of concurrent threads supported by the machine, at least 1.
+   */
+  static size_t hardwareConcurrency();
+
+  /**
+   * Queue a task for execution by a worker thread.
+   *
+   * @returns a future which becomes ready when the task finishes.  Exceptions
+   * thrown by the task are re-thrown by `future::get()`.
+   */
+  std::future<void> submit(std::function<void()> task);
+
+  /**
+   * Split the range [0, n) into at most `maxChunks` contiguous chunks and
+   * run `fn(begin, end, chunkIndex)` on each of them in parallel.  The
+   * calling thread executes the first chunk and blocks until all chunks
+   * finished.  Chunk indices are dense in [0, numChunks(n, maxChunks)), so
+   * they can be used to index per-chunk scratch buffers.
+   *
+   * @param maxChunks default 0 means one chunk per worker plus the caller.
+   */
+  void parallelFor(size_t n,
+                   const std::function<void(size_t begin, size_t end, size_t chunk)> &fn,
+                   size_t maxChunks = 0);
+
+  /**
+   * @returns the number of chunks `parallelFor(n, fn, maxChunks)` will use.
+   */
+  size_t numChunks(size_t n, size_t maxChunks = 0) const noexcept;
+
+  /**
+   * Pin the worker threads to a set of cores, @see ThreadAffinity.
+   * The empty set unpins them.
+   * @retval true if the affinity of the workers was changed.
+   */
+  bool setAffinity(const std::vector<UInt> &cores);
+
+private:
+  // Run one queued task on the calling thread, if any. @returns true if it ran a task.
+  bool runPendingTask_();
+  void workerLoop_();
+
+  std::vector<std::thread> workers_;
+  std::deque<std::packaged_task<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stop_ = false;
+};
+
+} // end namespace htm
+#endif // HTM_UTIL_THREAD_POOL_HPP
@@ -290,3 +290,78 @@ WrappingNeighborhood::Iterator WrappingNeighborhood::begin() const {
 WrappingNeighborhood::Iterator WrappingNeighborhood::end() const {
   return {*this, /*end*/ true};
 }
+
+// ============================================================================
+// NEIGHBORHOOD TABLE
+// ============================================================================
+
+NeighborhoodTable::NeighborhoodTable()
+    : radius_(0), wrapAround_(false), corner_(0) {}
+
+NeighborhoodTable::NeighborhoodTable(UInt radius, const vector<UInt> &dimensions,
+                                     bool wrapAround)
+    : radius_(radius), wrapAround_(wrapAround), dimensions_(dimensions),
+      corner_(0) {
+  const UInt diameter = 2 * radius + 1;
+  for (const auto dim : dimensions_) {
+    if (diameter > dim) {
+      return; // No interior points, every neighborhood touches an edge.
+    }
+  }
+
+  // The hypercube in the order of the Neighborhood: the last dimension
+  // changes fastest.
+  offsets_.push_back(0);
+  UInt stride = 1;
+  vector<UInt> strides(dimensions_.size());
+  for (Int i = (Int)dimensions_.size() - 1; i >= 0; i--) {
+    strides[i] = stride;
+    stride *= dimensions_[i];
+  }
+  for (size_t i = 0; i < dimensions_.size(); i++) {
+    vector<UInt> expanded;
+    expanded.reserve(offsets_.size() * diameter);
+    for (const auto offset : offsets_) {
+      for (UInt k = 0; k < diameter; k++) {
+        expanded.push_back(offset + k * strides[i]);
+      }
+    }
+    offsets_.swap(expanded);
+    corner_ += radius * strides[i];
+  }
+}
+
+bool NeighborhoodTable::isInterior_(UInt centerIndex) const {
+  if (offsets_.empty()) {
+    return false;
+  }
+  UInt shifted = centerIndex;
+  for (Int i = (Int)dimensions_.size() - 1; i >= 0; i--) {
+    const UInt coordinate = shifted % dimensions_[i];
+    shifted = shifted / dimensions_[i];
+    if (coordinate < radius_ || coordinate + radius_ >= dimensions_[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void NeighborhoodTable::appendNeighbors(UInt centerIndex,
+                                        vector<UInt> &neighbors) const {
+  NTA_ASSERT(!dimensions_.empty());
+  if (isInterior_(centerIndex)) {
+    const UInt corner = centerIndex - corner_;
+    for (const auto offset : offsets_) {
+      neighbors.push_back(corner + offset);
+    }
+  } else if (wrapAround_) {
+    for (const auto neighbor :
+         WrappingNeighborhood(centerIndex, radius_, dimensions_)) {
+      neighbors.push_back(neighbor);
+    }
+  } else {
+    for (const auto neighbor : Neighborhood(centerIndex, radius_, dimensions_)) {
+      neighbors.push_back(neighbor);
+    }
+  }
+}
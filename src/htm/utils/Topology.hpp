@@ -268,6 +268,70 @@ private:
   const UInt radius_;
 };
 
+/**
+ * The neighborhoods of all points for one radius and coordinate system,
+ * precomputed once and shared by all points.
+ *
+ * Neighborhood and WrappingNeighborhood recompute the coordinates of every
+ * neighbor. Most points are interior points, whose neighborhood is the full
+ * hypercube and doesn't touch an edge. Their neighbors are the center plus a
+ * fixed list of index offsets, which this table computes once. Only the
+ * points near an edge are enumerated by the (Wrapping)Neighborhood.
+ *
+ * The neighbors are listed in the same order as by the (Wrapping)Neighborhood,
+ * so results which depend on the order, such as random samples of the
+ * neighborhood, don't change.
+ *
+ * Unlike the Neighborhood, this copies the dimensions.
+ *
+ * Usage:
+ *   NeighborhoodTable table(10, {100, 100}, wrapAround);
+ *   vector<UInt> neighbors;
+ *   for (UInt center = 0; center < 100 * 100; center++) {
+ *     neighbors.clear();
+ *     table.appendNeighbors(center, neighbors);
+ *     // ...
+ *   }
+ *
+ * @param radius
+ * The radius of the neighborhoods.
+ *
+ * @param dimensions
+ * The dimensions of the world.
+ *
+ * @param wrapAround
+ * Whether the neighborhoods wrap around the edges, as the
+ * WrappingNeighborhood, or are truncated, as the Neighborhood.
+ */
+class NeighborhoodTable {
+public:
+  NeighborhoodTable();
+  NeighborhoodTable(UInt radius, const std::vector<UInt> &dimensions,
+                    bool wrapAround);
+
+  /**
+   * Appends the neighborhood of centerIndex, including the center itself,
+   * to neighbors.
+   */
+  void appendNeighbors(UInt centerIndex, std::vector<UInt> &neighbors) const;
+
+  UInt radius() const { return radius_; }
+  bool wrapAround() const { return wrapAround_; }
+  const std::vector<UInt> &dimensions() const { return dimensions_; }
+
+private:
+  bool isInterior_(UInt centerIndex) const;
+
+  UInt radius_;
+  bool wrapAround_;
+  std::vector<UInt> dimensions_;
+  // The neighbors of an interior point, relative to the corner of its
+  // hypercube, which is the center minus corner_.  Empty if there are no
+  // interior points.
+  std::vector<UInt> offsets_;
+  UInt corner_;
+};
+
 } // end namespace htm
 
 #endif // NTA_TOPOLOGY_HPP
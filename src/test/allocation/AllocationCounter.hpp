@@ -0,0 +1,34 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * The allocation counter of the global operator new of the allocation_tests
+ * executable, @see AllocationTestMain.cpp.
+ */
+
+#ifndef NTA_ALLOCATION_COUNTER_HPP
+#define NTA_ALLOCATION_COUNTER_HPP
+
+#include <cstddef>
+
+// Starts counting the operator new calls of the calling thread, from 0.
+void startCountingAllocations();
+
+// Stops counting, returns the operator new calls since the start.
+size_t stopCountingAllocations();
+
+#endif // NTA_ALLOCATION_COUNTER_HPP
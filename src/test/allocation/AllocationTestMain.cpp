@@ -0,0 +1,75 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Google test main program of the allocation tests.
+ *
+ * The global operator new of this executable counts its calls on a thread
+ * which enabled counting, see AllocationCounter.hpp.  It is a separate
+ * executable so that the unit tests keep the default operator new.
+ */
+
+#include <cstdlib>
+#include <new>
+
+#include <gtest/gtest.h>
+
+#include "AllocationCounter.hpp"
+
+namespace {
+thread_local bool   counting    = false;
+thread_local size_t allocations = 0u;
+
+void *allocate(std::size_t size) noexcept {
+  if (counting)
+    allocations++;
+  return std::malloc(size == 0u ? 1u : size);
+}
+} // namespace
+
+void startCountingAllocations() {
+  allocations = 0u;
+  counting = true;
+}
+
+size_t stopCountingAllocations() {
+  counting = false;
+  return allocations;
+}
+
+void *operator new(std::size_t size) {
+  void *pointer = allocate(size);
+  if (pointer == nullptr)
+    throw std::bad_alloc();
+  return pointer;
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { std::free(pointer); }
+#if defined(__cpp_sized_deallocation)
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { std::free(pointer); }
+#endif
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,68 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Heap allocations of TemporalMemory::compute.
+ */
+
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+
+#include "AllocationCounter.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+/**
+ * After warm-up on a learned sequence, a learning compute() step must not
+ * allocate memory on the heap; all scratch memory is reused.
+ */
+TEST(TemporalMemoryAllocationTest, testComputeAllocationFree) {
+  SDR columns({200});
+  vector<SDR> pattern( 10, columns.dimensions );
+  Random rng(42);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.10f, rng );
+  }
+
+  TemporalMemory tm(columns.dimensions, /* cellsPerColumn */ 8);
+  const auto trial = [&]() {
+    tm.reset();
+    for(const auto &x : pattern) {
+      tm.compute(x, true);
+    }
+  };
+  for(int warmup = 0; warmup < 30; warmup++) trial();
+
+  startCountingAllocations();
+  trial();
+  ASSERT_EQ(stopCountingAllocations(), 0u);
+  ASSERT_LT(tm.anomaly, 0.05f) << "sequence should be learned";
+
+  // Test the test: the hook does count allocations.
+  startCountingAllocations();
+  vector<UInt> probe(10u);
+  ASSERT_EQ(stopCountingAllocations(), 1u);
+}
+
+} // namespace testing
@@ -0,0 +1,151 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Benchmarks of Connections, SpatialPooler, TemporalMemory and Classifier.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/algorithms/SDRClassifier.hpp>
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace {
+
+using namespace htm;
+
+// Connections with one segment per cell, each with synapses to random
+// presynaptic cells, like the proximal segments of a SpatialPooler.
+void makeSegments(Connections &connections, CellIdx numCells, CellIdx numInputs,
+                  UInt synapsesPerSegment, Random &rng) {
+  connections.initialize(numCells, 0.5f);
+  for (CellIdx cell = 0u; cell < numCells; cell++) {
+    const Segment segment = connections.createSegment(cell);
+    for (UInt i = 0u; i < synapsesPerSegment; i++)
+      connections.createSynapse(segment, rng.getUInt32(numInputs),
+                                static_cast<Permanence>(rng.getReal64()));
+  }
+}
+
+// Args: number of segments, synapses per segment.
+void BM_Connections_ComputeActivity(benchmark::State &state) {
+  Random rng(42u);
+  const CellIdx numInputs = 4096u;
+  Connections connections;
+  makeSegments(connections, static_cast<CellIdx>(state.range(0)), numInputs,
+               static_cast<UInt>(state.range(1)), rng);
+  SDR input({numInputs});
+  input.randomize(0.05f, rng);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(connections.computeActivity(input.getSparse(), false).data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Connections_ComputeActivity)
+    ->Args({2048, 32})->Args({2048, 256})->Args({16384, 32})->Args({65536, 32});
+
+void BM_Connections_AdaptSegment(benchmark::State &state) {
+  Random rng(42u);
+  const CellIdx numInputs = 4096u;
+  const CellIdx numSegments = 1024u;
+  Connections connections;
+  makeSegments(connections, numSegments, numInputs, static_cast<UInt>(state.range(0)), rng);
+  SDR input({numInputs});
+  input.randomize(0.05f, rng);
+  Segment segment = 0u;
+  for (auto _ : state) {
+    connections.adaptSegment(segment, input, 0.01f, 0.01f);
+    segment = (segment + 1u) % numSegments;
+  }
+}
+BENCHMARK(BM_Connections_AdaptSegment)->Arg(32)->Arg(256)->Arg(1024);
+
+// Args: number of columns, learn.
+void spatialPooler(benchmark::State &state, bool globalInhibition) {
+  Random rng(42u);
+  const UInt columns = static_cast<UInt>(state.range(0));
+  const bool learn = state.range(1) != 0;
+  SpatialPooler sp({1024u}, {columns}, /*potentialRadius*/ 1024u, /*potentialPct*/ 0.5f,
+                   globalInhibition, /*localAreaDensity*/ 0.02f);
+  std::vector<SDR> inputs(16u, SDR({1024u}));
+  for (auto &input : inputs)
+    input.randomize(0.05f, rng);
+  SDR active({columns});
+  size_t i = 0u;
+  for (auto _ : state) {
+    sp.compute(inputs[i++ % inputs.size()], learn, active);
+  }
+}
+
+void BM_SpatialPooler_Global(benchmark::State &state) { spatialPooler(state, true); }
+BENCHMARK(BM_SpatialPooler_Global)
+    ->Args({1024, 0})->Args({1024, 1})->Args({4096, 0})->Args({4096, 1});
+
+void BM_SpatialPooler_Local(benchmark::State &state) { spatialPooler(state, false); }
+BENCHMARK(BM_SpatialPooler_Local)->Args({1024, 0})->Args({1024, 1});
+
+// Args: number of columns, cells per column.
+void BM_TemporalMemory_Compute(benchmark::State &state) {
+  Random rng(42u);
+  const UInt columns = static_cast<UInt>(state.range(0));
+  TemporalMemory tm({columns}, static_cast<CellIdx>(state.range(1)));
+  // A repeating sequence, so the TM predicts after the first passes.
+  std::vector<SDR> sequence(32u, SDR({columns}));
+  for (auto &sdr : sequence)
+    sdr.randomize(0.02f, rng);
+  size_t i = 0u;
+  for (auto _ : state) {
+    tm.compute(sequence[i++ % sequence.size()], true);
+  }
+}
+BENCHMARK(BM_TemporalMemory_Compute)
+    ->Args({1024, 8})->Args({2048, 16})->Args({2048, 32})->Args({8192, 32});
+
+void BM_Classifier_Learn(benchmark::State &state) {
+  Random rng(42u);
+  const UInt size = static_cast<UInt>(state.range(0));
+  Classifier classifier;
+  SDR pattern({size});
+  pattern.randomize(0.02f, rng);
+  UInt category = 0u;
+  for (auto _ : state) {
+    classifier.learn(pattern, {category});
+    category = (category + 1u) % 10u;
+  }
+}
+BENCHMARK(BM_Classifier_Learn)->Arg(1024)->Arg(16384);
+
+void BM_Classifier_Infer(benchmark::State &state) {
+  Random rng(42u);
+  const UInt size = static_cast<UInt>(state.range(0));
+  Classifier classifier;
+  SDR pattern({size});
+  for (UInt category = 0u; category < 10u; category++) {
+    pattern.randomize(0.02f, rng);
+    classifier.learn(pattern, {category});
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(classifier.infer(pattern).data());
+  }
+}
+BENCHMARK(BM_Classifier_Infer)->Arg(1024)->Arg(16384);
+
+} // namespace
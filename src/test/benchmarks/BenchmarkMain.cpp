@@ -0,0 +1,128 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Entry point of the benchmarks executable.
+ *
+ * The benchmarks are in the *Benchmark.cpp files of this directory, one per
+ * area of the library.  For the JSON output, used for regression tracking:
+ *    benchmarks --benchmark_out=benchmarks.json --benchmark_out_format=json
+ * or `make run_benchmarks`.
+ *
+ * The global operator new of this executable counts the allocated bytes, so
+ * each benchmark also reports its peak heap memory ("max_bytes_used") and its
+ * allocations per iteration, measured on one extra iteration.  The running
+ * totals are also available to the benchmarks, see HeapCounter.hpp.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include <benchmark/benchmark.h>
+
+#include "HeapCounter.hpp"
+
+namespace {
+
+// Each block starts with its size, in a header which keeps the alignment of malloc.
+const std::size_t HeaderBytes = 16u;
+
+std::atomic<int64_t> allocatedBytes(0);
+std::atomic<int64_t> peakBytes(0);
+std::atomic<int64_t> numAllocs(0);
+std::atomic<bool>    counting(false);
+std::atomic<int64_t> totalAllocs(0);
+std::atomic<int64_t> totalBytes(0);
+
+void *allocate(std::size_t size) noexcept {
+  void *block = std::malloc(size + HeaderBytes);
+  if (block == nullptr)
+    return nullptr;
+  *static_cast<std::size_t *>(block) = size;
+  const int64_t now = allocatedBytes.fetch_add(static_cast<int64_t>(size)) + static_cast<int64_t>(size);
+  totalAllocs.fetch_add(1, std::memory_order_relaxed);
+  totalBytes.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+  if (counting.load(std::memory_order_relaxed)) {
+    numAllocs++;
+    int64_t peak = peakBytes.load();
+    while (now > peak && !peakBytes.compare_exchange_weak(peak, now)) {
+    }
+  }
+  return static_cast<char *>(block) + HeaderBytes;
+}
+
+void deallocate(void *pointer) noexcept {
+  if (pointer == nullptr)
+    return;
+  char *block = static_cast<char *>(pointer) - HeaderBytes;
+  allocatedBytes -= static_cast<int64_t>(*reinterpret_cast<std::size_t *>(block));
+  std::free(block);
+}
+
+class HeapCounter : public benchmark::MemoryManager {
+public:
+  void Start() override {
+    numAllocs = 0;
+    base_ = allocatedBytes.load();
+    peakBytes = base_;
+    counting = true;
+  }
+  void Stop(Result *result) override {
+    counting = false;
+    result->num_allocs = numAllocs.load();
+    result->max_bytes_used = peakBytes.load() - base_;
+  }
+
+private:
+  int64_t base_ = 0;
+};
+
+} // namespace
+
+HeapStats heapStats() {
+  return {totalAllocs.load(), totalBytes.load(), allocatedBytes.load()};
+}
+
+void *operator new(std::size_t size) {
+  void *pointer = allocate(size);
+  if (pointer == nullptr)
+    throw std::bad_alloc();
+  return pointer;
+}
+void *operator new[](std::size_t size) { return operator new(size); }
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return allocate(size); }
+void operator delete(void *pointer) noexcept { deallocate(pointer); }
+void operator delete[](void *pointer) noexcept { deallocate(pointer); }
+void operator delete(void *pointer, const std::nothrow_t &) noexcept { deallocate(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept { deallocate(pointer); }
+#if defined(__cpp_sized_deallocation)
+void operator delete(void *pointer, std::size_t) noexcept { deallocate(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { deallocate(pointer); }
+#endif
+
+int main(int argc, char **argv) {
+  HeapCounter heapCounter;
+  benchmark::RegisterMemoryManager(&heapCounter);
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
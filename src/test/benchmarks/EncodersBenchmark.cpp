@@ -0,0 +1,133 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Benchmarks of the encoders.
+ */
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <htm/encoders/CoordinateEncoder.hpp>
+#include <htm/encoders/DateEncoder.hpp>
+#include <htm/encoders/GridCellEncoder.hpp>
+#include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <htm/encoders/ScalarEncoder.hpp>
+#include <htm/encoders/SimHashDocumentEncoder.hpp>
+#include <htm/types/Sdr.hpp>
+
+namespace {
+
+using namespace htm;
+
+void BM_ScalarEncoder(benchmark::State &state) {
+  ScalarEncoderParameters p;
+  p.minimum = 0.0;
+  p.maximum = 100.0;
+  p.size = static_cast<UInt>(state.range(0));
+  p.activeBits = p.size / 50u;
+  ScalarEncoder encoder(p);
+  SDR output(encoder.dimensions);
+  Real64 x = 0.0;
+  for (auto _ : state) {
+    encoder.encode(x, output);
+    x = x < 100.0 ? x + 0.37 : 0.0;
+  }
+}
+BENCHMARK(BM_ScalarEncoder)->Arg(1000)->Arg(10000);
+
+void BM_RDSE(benchmark::State &state) {
+  RDSE_Parameters p;
+  p.size = static_cast<UInt>(state.range(0));
+  p.sparsity = 0.02f;
+  p.resolution = 0.1f;
+  p.seed = 42u;
+  RDSE encoder(p);
+  SDR output(encoder.dimensions);
+  Real64 x = 0.0;
+  for (auto _ : state) {
+    encoder.encode(x, output);
+    x += 0.37;
+  }
+}
+BENCHMARK(BM_RDSE)->Arg(1000)->Arg(10000);
+
+void BM_DateEncoder(benchmark::State &state) {
+  DateEncoderParameters p;
+  p.season_width = 10u;
+  p.dayOfWeek_width = 10u;
+  p.weekend_width = 10u;
+  p.timeOfDay_width = 10u;
+  DateEncoder encoder(p);
+  SDR output(encoder.dimensions);
+  std::time_t t = 1577836800; // 2020-01-01
+  for (auto _ : state) {
+    encoder.encode(t, output);
+    t += 900; // 15 minutes
+  }
+}
+BENCHMARK(BM_DateEncoder);
+
+void BM_GridCellEncoder(benchmark::State &state) {
+  GridCellEncoderParameters p;
+  p.size = static_cast<UInt>(state.range(0));
+  p.sparsity = 0.25f;
+  p.periods = {6.0, 8.5, 12.0, 17.0, 24.0};
+  p.seed = 42u;
+  GridCellEncoder encoder(p);
+  SDR output(encoder.dimensions);
+  Real64 x = 0.0;
+  for (auto _ : state) {
+    encoder.encode({x, 2.0 * x}, output);
+    x += 0.37;
+  }
+}
+BENCHMARK(BM_GridCellEncoder)->Arg(1000)->Arg(4000);
+
+void BM_CoordinateEncoder(benchmark::State &state) {
+  CoordinateEncoderParameters p;
+  p.size = 2048u;
+  p.activeBits = 40u;
+  p.radius = static_cast<UInt>(state.range(0));
+  CoordinateEncoder encoder(p);
+  SDR output(encoder.dimensions);
+  Int x = 0;
+  for (auto _ : state) {
+    encoder.encode({x, 2 * x}, output);
+    x++;
+  }
+}
+BENCHMARK(BM_CoordinateEncoder)->Arg(5)->Arg(20);
+
+void BM_SimHashDocumentEncoder(benchmark::State &state) {
+  SimHashDocumentEncoderParameters p;
+  p.size = 1000u;
+  p.activeBits = 20u;
+  p.tokenSimilarity = state.range(0) != 0;
+  SimHashDocumentEncoder encoder(p);
+  SDR output(encoder.dimensions);
+  const std::vector<std::string> document{"the", "quick", "brown", "fox", "jumps", "over",
+                                          "the", "lazy", "dog", "again", "and", "again"};
+  for (auto _ : state) {
+    encoder.encode(document, output);
+  }
+}
+BENCHMARK(BM_SimHashDocumentEncoder)->Arg(0)->Arg(1);
+
+} // namespace
@@ -0,0 +1,37 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * The heap counters of the global operator new of the benchmarks
+ * executable, @see BenchmarkMain.cpp.
+ */
+
+#ifndef NTA_BENCHMARKS_HEAP_COUNTER_HPP
+#define NTA_BENCHMARKS_HEAP_COUNTER_HPP
+
+#include <cstdint>
+
+struct HeapStats {
+  int64_t allocations;    // operator new calls since the start
+  int64_t allocatedBytes; // bytes allocated since the start
+  int64_t liveBytes;      // bytes allocated and not yet freed
+};
+
+// Of all threads.
+HeapStats heapStats();
+
+#endif // NTA_BENCHMARKS_HEAP_COUNTER_HPP
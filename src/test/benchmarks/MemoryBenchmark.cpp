@@ -0,0 +1,205 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Allocations and memory footprint of the components:
+ *   BM_Allocations_*  the heap allocations and bytes of one compute() step in
+ *                     the steady state, after a warmup.  A step which
+ *                     allocates is a candidate for reused buffers.
+ *   BM_Footprint_*    the growth of the Connections of a TM over a long run
+ *                     of novel sequences, with and without pruning of the
+ *                     segments and synapses.
+ * Run them with --benchmark_filter=Allocations|Footprint.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <htm/algorithms/SDRClassifier.hpp>
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+#include <htm/utils/SequenceGenerator.hpp>
+
+#include "HeapCounter.hpp"
+
+namespace {
+
+using namespace htm;
+
+const size_t WarmupSteps = 200u;
+
+// Runs @param step WarmupSteps times, then reports the allocations of the
+// timed steps, per step.
+template <typename Step> void countAllocations(benchmark::State &state, Step step) {
+  for (size_t i = 0u; i < WarmupSteps; i++)
+    step();
+  const HeapStats before = heapStats();
+  for (auto _ : state) {
+    step();
+  }
+  const HeapStats after = heapStats();
+  state.counters["allocsPerStep"] = benchmark::Counter(
+      static_cast<double>(after.allocations - before.allocations), benchmark::Counter::kAvgIterations);
+  state.counters["bytesPerStep"] = benchmark::Counter(
+      static_cast<double>(after.allocatedBytes - before.allocatedBytes), benchmark::Counter::kAvgIterations);
+  state.counters["liveBytesPerStep"] = benchmark::Counter(
+      static_cast<double>(after.liveBytes - before.liveBytes), benchmark::Counter::kAvgIterations);
+}
+
+std::vector<SDR> randomInputs(const UInt size, const Real sparsity, const size_t count) {
+  Random rng(42u);
+  std::vector<SDR> inputs(count, SDR({size}));
+  for (auto &input : inputs)
+    input.randomize(sparsity, rng);
+  return inputs;
+}
+
+// Args: number of columns, learn.
+void BM_Allocations_SpatialPooler(benchmark::State &state) {
+  const UInt columns = static_cast<UInt>(state.range(0));
+  const bool learn = state.range(1) != 0;
+  SpatialPooler sp({1024u}, {columns}, /*potentialRadius*/ 1024u, /*potentialPct*/ 0.5f,
+                   /*globalInhibition*/ true, /*localAreaDensity*/ 0.02f);
+  const auto inputs = randomInputs(1024u, 0.05f, 16u);
+  SDR active({columns});
+  size_t i = 0u;
+  countAllocations(state, [&]() { sp.compute(inputs[i++ % inputs.size()], learn, active); });
+}
+BENCHMARK(BM_Allocations_SpatialPooler)->Args({2048, 0})->Args({2048, 1});
+
+// Args: number of columns, learn.  The TM learns a SequenceGenerator stream,
+// which it predicts after the warmup.
+void BM_Allocations_TemporalMemory(benchmark::State &state) {
+  const UInt columns = static_cast<UInt>(state.range(0));
+  const bool learn = state.range(1) != 0;
+  TemporalMemory tm({columns}, 32u);
+  SequenceGeneratorParameters p;
+  p.dimensions = {columns};
+  SequenceGenerator generator(p);
+  SDR input({columns});
+  countAllocations(state, [&]() {
+    if (generator.next(input))
+      tm.reset();
+    tm.compute(input, learn);
+  });
+}
+BENCHMARK(BM_Allocations_TemporalMemory)->Args({2048, 0})->Args({2048, 1});
+
+// Args: size of the pattern.
+void BM_Allocations_Classifier(benchmark::State &state) {
+  const UInt size = static_cast<UInt>(state.range(0));
+  Classifier classifier;
+  const auto patterns = randomInputs(size, 0.02f, 10u);
+  PDF pdf;
+  UInt category = 0u;
+  countAllocations(state, [&]() {
+    classifier.learn(patterns[category], {category});
+    classifier.infer(patterns[category], pdf);
+    category = (category + 1u) % 10u;
+  });
+}
+BENCHMARK(BM_Allocations_Classifier)->Arg(2048)->Arg(65536);
+
+// The Predictor of 1 and 5 steps, which also keeps the history of its inputs.
+void BM_Allocations_Predictor(benchmark::State &state) {
+  const UInt size = static_cast<UInt>(state.range(0));
+  Predictor predictor({1u, 5u});
+  const auto patterns = randomInputs(size, 0.02f, 10u);
+  Predictions predictions;
+  UInt record = 0u;
+  countAllocations(state, [&]() {
+    predictor.learn(record, patterns[record % 10u], {record % 10u});
+    predictor.infer(patterns[record % 10u], predictions);
+    record++;
+  });
+}
+BENCHMARK(BM_Allocations_Predictor)->Arg(2048);
+
+// Args: number of columns.  An encoder, SP and TM, as napi_hello; the
+// difference to the components is the overhead of the Network.
+void BM_Allocations_Network(benchmark::State &state) {
+  const std::string columns = std::to_string(state.range(0));
+  Network net;
+  std::shared_ptr<Region> encoder =
+      net.addRegion("encoder", "RDSEEncoderRegion", "{size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}");
+  net.addRegion("sp", "SPRegion", "{columnCount: " + columns + ", globalInhibition: true}");
+  net.addRegion("tm", "TMRegion", "{cellsPerColumn: 8, orColumnOutputs: true}");
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+  UInt record = 0u;
+  countAllocations(state, [&]() {
+    encoder->setParameterReal64("sensedValue", static_cast<Real64>(record++ % 100u) / 100.0);
+    net.run(1);
+  });
+}
+BENCHMARK(BM_Allocations_Network)->Arg(2048);
+
+// Args: number of records, pruning.  The TM learns a stream of mostly novel
+// sequences, so without limits it grows segments and synapses for ever.
+// Pruning limits the segments per cell and the synapses per segment, which
+// destroys the least used ones.  Reports the bytes of the Connections at
+// the end, and their growth per record over the second half of the run.
+void BM_Footprint_TemporalMemory(benchmark::State &state) {
+  const size_t records = static_cast<size_t>(state.range(0));
+  const bool pruning = state.range(1) != 0;
+  const UInt columns = 2048u;
+  SequenceGeneratorParameters p;
+  p.dimensions   = {columns};
+  p.alphabetSize = 1000u;
+  p.repetition   = 0.25f;
+  SequenceGenerator generator(p);
+  std::vector<SDR> inputs;
+  std::vector<bool> resets;
+  generator.generate(records, inputs, resets);
+
+  size_t halfway = 0u, end = 0u, segments = 0u, synapses = 0u;
+  for (auto _ : state) {
+    TemporalMemory tm({columns}, 8u, 13u, 0.21f, 0.5f, 10u, 20u, 0.1f, 0.1f, 0.0f, 42,
+                      /*maxSegmentsPerCell*/ pruning ? 4u : 255u,
+                      /*maxSynapsesPerSegment*/ pruning ? 32u : 255u);
+    for (size_t i = 0u; i < records; i++) {
+      if (resets[i])
+        tm.reset();
+      tm.compute(inputs[i], true);
+      if (i + 1u == records / 2u)
+        halfway = tm.connections.memoryUsage();
+    }
+    end = tm.connections.memoryUsage();
+    segments = tm.connections.numSegments();
+    synapses = tm.connections.numSynapses();
+  }
+  state.counters["connectionsBytes"] = static_cast<double>(end);
+  state.counters["growthPerRecord"] =
+      static_cast<double>(static_cast<int64_t>(end) - static_cast<int64_t>(halfway)) /
+      static_cast<double>(records - records / 2u);
+  state.counters["segments"] = static_cast<double>(segments);
+  state.counters["synapses"] = static_cast<double>(synapses);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Footprint_TemporalMemory)
+    ->Args({5000, 0})->Args({5000, 1})->Args({20000, 0})->Args({20000, 1})
+    ->Iterations(1)->Unit(benchmark::kMillisecond);
+
+} // namespace
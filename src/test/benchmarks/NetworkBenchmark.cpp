@@ -0,0 +1,111 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Benchmarks of Network::run, and of its overhead over the algorithms, and
+ * of the creation of the regions at startup.
+ */
+
+#include <memory>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+
+namespace {
+
+using namespace htm;
+
+// An encoder, SP and TM of @param columns columns, as napi_hello.
+void buildNetwork(Network &net, int columns) {
+  const std::string cols = std::to_string(columns);
+  net.addRegion("encoder", "RDSEEncoderRegion", "{size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}");
+  net.addRegion("sp", "SPRegion", "{columnCount: " + cols + ", globalInhibition: true}");
+  net.addRegion("tm", "TMRegion", "{cellsPerColumn: 8, orColumnOutputs: true}");
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+}
+
+// Args: number of columns.  The smallest size is mostly the overhead of the
+// Network: scheduling, links and the region wrappers.
+void BM_Network_Run(benchmark::State &state) {
+  Network net;
+  buildNetwork(net, static_cast<int>(state.range(0)));
+  std::shared_ptr<Region> encoder = net.getRegion("encoder");
+  Real64 x = 0.0;
+  for (auto _ : state) {
+    encoder->setParameterReal64("sensedValue", x);
+    net.run(1);
+    x += 0.01;
+  }
+}
+BENCHMARK(BM_Network_Run)->Arg(64)->Arg(2048);
+
+// Several iterations per call of run(), amortizes the setup of run().
+void BM_Network_RunBatch(benchmark::State &state) {
+  Network net;
+  buildNetwork(net, 64);
+  const int iterations = static_cast<int>(state.range(0));
+  for (auto _ : state) {
+    net.run(iterations);
+  }
+  state.SetItemsProcessed(state.iterations() * iterations);
+}
+BENCHMARK(BM_Network_RunBatch)->Arg(1)->Arg(100);
+
+// A single small encoder, mostly the cost of Network::run(1) itself.  The
+// reference of the Python benchmarks of Network.run and of a PyRegion
+// (bindings/py/tests/benchmarks/binding_overhead.py).
+void BM_Network_RunEncoder(benchmark::State &state) {
+  Network net;
+  net.addRegion("encoder", "ScalarEncoderRegion", "{size: 100, activeBits: 10, minValue: 0, maxValue: 100}");
+  net.initialize();
+  for (auto _ : state) {
+    net.run(1);
+  }
+}
+BENCHMARK(BM_Network_RunEncoder);
+
+
+// Startup: adds state.range(0) SP regions to a new Network.  With
+// state.range(1) == 0 every region has its own seed, so its parameters are
+// parsed (a miss of the prototype cache of RegionImplFactory), else all
+// regions have the same parameters, which are parsed once.
+void BM_Network_AddRegions(benchmark::State &state) {
+  const int numRegions = static_cast<int>(state.range(0));
+  const bool shared = state.range(1) != 0;
+  const std::string params = "{columnCount: 2048, potentialRadius: 16, potentialPct: 0.5, "
+                             "globalInhibition: true, localAreaDensity: 0.02, boostStrength: 3.0, seed: ";
+  int seed = 0;
+  for (auto _ : state) {
+    std::unique_ptr<Network> net(new Network());
+    for (int i = 0; i < numRegions; i++) {
+      net->addRegion("sp" + std::to_string(i), "SPRegion",
+                     params + std::to_string(shared ? 1 : ++seed) + "}");
+    }
+    state.PauseTiming();
+    net.reset(); // the regions are destroyed, not timed
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * numRegions);
+}
+BENCHMARK(BM_Network_AddRegions)->Args({1000, 0})->Args({1000, 1});
+
+} // namespace
@@ -0,0 +1,104 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Benchmarks of SDR conversions and set operations.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace {
+
+using namespace htm;
+
+// Args: size, active bits per 1000.
+void sdrArgs(benchmark::internal::Benchmark *b) {
+  for (const int size : {1024, 16384, 262144})
+    for (const int perMille : {20, 200})
+      b->Args({size, perMille});
+}
+
+void BM_SDR_SparseToDense(benchmark::State &state) {
+  Random rng(42u);
+  SDR sdr({static_cast<UInt>(state.range(0))});
+  sdr.randomize(static_cast<Real>(state.range(1)) / 1000.0f, rng);
+  const SDR_sparse_t sparse = sdr.getSparse(); // the const overload copies
+  for (auto _ : state) {
+    sdr.setSparse(sparse);
+    benchmark::DoNotOptimize(sdr.getDense().data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SDR_SparseToDense)->Apply(sdrArgs);
+
+void BM_SDR_DenseToSparse(benchmark::State &state) {
+  Random rng(42u);
+  SDR sdr({static_cast<UInt>(state.range(0))});
+  sdr.randomize(static_cast<Real>(state.range(1)) / 1000.0f, rng);
+  const SDR_dense_t dense = sdr.getDense();
+  for (auto _ : state) {
+    sdr.setDense(dense);
+    benchmark::DoNotOptimize(sdr.getSparse().data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SDR_DenseToSparse)->Apply(sdrArgs);
+
+void BM_SDR_SparseToCoordinates(benchmark::State &state) {
+  Random rng(42u);
+  const UInt side = static_cast<UInt>(state.range(0));
+  SDR sdr({side, side});
+  sdr.randomize(static_cast<Real>(state.range(1)) / 1000.0f, rng);
+  const SDR_sparse_t sparse = sdr.getSparse(); // the const overload copies
+  for (auto _ : state) {
+    sdr.setSparse(sparse);
+    benchmark::DoNotOptimize(sdr.getCoordinates().data());
+  }
+}
+BENCHMARK(BM_SDR_SparseToCoordinates)->Args({32, 20})->Args({128, 20})->Args({512, 20});
+
+void BM_SDR_Intersection(benchmark::State &state) {
+  Random rng(42u);
+  const std::vector<UInt> dims{static_cast<UInt>(state.range(0))};
+  const Real sparsity = static_cast<Real>(state.range(1)) / 1000.0f;
+  SDR a(dims), b(dims), out(dims);
+  a.randomize(sparsity, rng);
+  b.randomize(sparsity, rng);
+  for (auto _ : state) {
+    out.intersection(a, b);
+    benchmark::DoNotOptimize(out.getSparse().data());
+  }
+}
+BENCHMARK(BM_SDR_Intersection)->Apply(sdrArgs);
+
+void BM_SDR_Overlap(benchmark::State &state) {
+  Random rng(42u);
+  const std::vector<UInt> dims{static_cast<UInt>(state.range(0))};
+  const Real sparsity = static_cast<Real>(state.range(1)) / 1000.0f;
+  SDR a(dims), b(dims);
+  a.randomize(sparsity, rng);
+  b.randomize(sparsity, rng);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a.getOverlap(b));
+  }
+}
+BENCHMARK(BM_SDR_Overlap)->Apply(sdrArgs);
+
+} // namespace
@@ -0,0 +1,194 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Benchmarks of saveToFile() and loadFromFile() of the SpatialPooler,
+ * TemporalMemory and Network, in each SerializableFormat.
+ *
+ * bytes_per_second is the throughput over the size of the file, which is
+ * reported as the "fileMB" counter; max_bytes_used is the peak heap memory
+ * of a save or load.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace {
+
+using namespace htm;
+
+const char *const FilePath = "serialization_benchmark.tmp";
+
+SerializableFormat formatArg(const benchmark::State &state) {
+  return static_cast<SerializableFormat>(state.range(0));
+}
+
+const char *formatName(SerializableFormat fmt) {
+  switch (fmt) {
+  case SerializableFormat::BINARY:   return "BINARY";
+  case SerializableFormat::PORTABLE: return "PORTABLE";
+  case SerializableFormat::JSON:     return "JSON";
+  default:                           return "XML";
+  }
+}
+
+size_t fileBytes(const std::string &path) {
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  return in ? static_cast<size_t>(in.tellg()) : 0u;
+}
+
+void report(benchmark::State &state, size_t bytes) {
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(bytes));
+  state.counters["fileMB"] = static_cast<double>(bytes) / (1024.0 * 1024.0);
+  state.SetLabel(formatName(formatArg(state)));
+}
+
+// Args: format, size.  The JSON and XML formats are slow, the large sizes
+// take seconds per iteration.
+void serializationArgs(benchmark::internal::Benchmark *b) {
+  for (int fmt = SerializableFormat::BINARY; fmt <= SerializableFormat::XML; fmt++)
+    for (const int size : {1024, 4096})
+      b->Args({fmt, size});
+  b->Unit(benchmark::kMillisecond)->UseRealTime();
+}
+
+void train(SpatialPooler &sp, UInt columns) {
+  Random rng(42u);
+  sp.initialize({1024u}, {columns});
+  SDR input({1024u}), active({columns});
+  for (int i = 0; i < 20; i++) {
+    input.randomize(0.05f, rng);
+    sp.compute(input, true, active);
+  }
+}
+
+void train(TemporalMemory &tm, UInt columns) {
+  Random rng(42u);
+  tm.initialize({columns}, 32u);
+  std::vector<SDR> sequence(50u, SDR({columns}));
+  for (auto &sdr : sequence)
+    sdr.randomize(0.02f, rng);
+  for (int pass = 0; pass < 3; pass++)
+    for (const auto &sdr : sequence)
+      tm.compute(sdr, true);
+}
+
+void BM_SpatialPooler_Save(benchmark::State &state) {
+  SpatialPooler sp;
+  train(sp, static_cast<UInt>(state.range(1)));
+  for (auto _ : state) {
+    sp.saveToFile(FilePath, formatArg(state));
+  }
+  report(state, fileBytes(FilePath));
+  std::remove(FilePath);
+}
+BENCHMARK(BM_SpatialPooler_Save)->Apply(serializationArgs);
+
+void BM_SpatialPooler_Load(benchmark::State &state) {
+  {
+    SpatialPooler trained;
+    train(trained, static_cast<UInt>(state.range(1)));
+    trained.saveToFile(FilePath, formatArg(state));
+  }
+  for (auto _ : state) {
+    SpatialPooler sp;
+    sp.loadFromFile(FilePath, formatArg(state));
+  }
+  report(state, fileBytes(FilePath));
+  std::remove(FilePath);
+}
+BENCHMARK(BM_SpatialPooler_Load)->Apply(serializationArgs);
+
+void BM_TemporalMemory_Save(benchmark::State &state) {
+  TemporalMemory tm;
+  train(tm, static_cast<UInt>(state.range(1)));
+  for (auto _ : state) {
+    tm.saveToFile(FilePath, formatArg(state));
+  }
+  report(state, fileBytes(FilePath));
+  std::remove(FilePath);
+}
+BENCHMARK(BM_TemporalMemory_Save)->Apply(serializationArgs);
+
+void BM_TemporalMemory_Load(benchmark::State &state) {
+  {
+    TemporalMemory trained;
+    train(trained, static_cast<UInt>(state.range(1)));
+    trained.saveToFile(FilePath, formatArg(state));
+  }
+  for (auto _ : state) {
+    TemporalMemory tm;
+    tm.loadFromFile(FilePath, formatArg(state));
+  }
+  report(state, fileBytes(FilePath));
+  std::remove(FilePath);
+}
+BENCHMARK(BM_TemporalMemory_Load)->Apply(serializationArgs);
+
+// An encoder -> SP -> TM Network of @param columns columns, run for a while.
+void train(Network &net, UInt columns) {
+  net.addRegion("encoder", "RDSEEncoderRegion", "{size: 1000, sparsity: 0.02, radius: 0.03, seed: 2019}");
+  net.addRegion("sp", "SPRegion", "{columnCount: " + std::to_string(columns) + ", globalInhibition: true}");
+  net.addRegion("tm", "TMRegion", "{cellsPerColumn: 32}");
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+  std::shared_ptr<Region> encoder = net.getRegion("encoder");
+  for (int i = 0; i < 100; i++) {
+    encoder->setParameterReal64("sensedValue", 0.05 * (i % 20));
+    net.run(1);
+  }
+}
+
+void BM_Network_Save(benchmark::State &state) {
+  Network net;
+  train(net, static_cast<UInt>(state.range(1)));
+  for (auto _ : state) {
+    net.saveToFile(FilePath, formatArg(state));
+  }
+  report(state, fileBytes(FilePath));
+  std::remove(FilePath);
+}
+BENCHMARK(BM_Network_Save)->Apply(serializationArgs);
+
+void BM_Network_Load(benchmark::State &state) {
+  {
+    Network net;
+    train(net, static_cast<UInt>(state.range(1)));
+    net.saveToFile(FilePath, formatArg(state));
+  }
+  for (auto _ : state) {
+    Network net;
+    net.loadFromFile(FilePath, formatArg(state));
+  }
+  report(state, fileBytes(FilePath));
+  std::remove(FilePath);
+}
+BENCHMARK(BM_Network_Load)->Apply(serializationArgs);
+
+} // namespace
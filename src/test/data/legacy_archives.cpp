@@ -0,0 +1,227 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2019, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Writes the golden legacy archives of this directory, see README.md.
+ *
+ * NOT part of the build: compile it against the sources of commit a8e205d
+ * (the tree before the archives were versioned), eg.
+ *   git archive a8e205d src external | tar -x -C /tmp/legacy
+ * and run it in src/test/data. The values it prints are the ones the tests
+ * expect after loading the archives.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#include <htm/algorithms/Connections.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <htm/encoders/ScalarEncoder.hpp>
+#include <htm/encoders/SimHashDocumentEncoder.hpp>
+#include <htm/utils/Random.hpp>
+
+using namespace htm;
+using namespace std;
+
+template<class T>
+static void write(const string &file, const T &obj) {
+  ofstream out(file, ios_base::binary);
+  cereal::BinaryOutputArchive ar(out);
+  ar(obj);
+}
+
+// The fields of the encoder regions, with their save_ar() of a8e205d.
+// (The regions themselves need a Network.)
+struct ScalarEncoderRegionFields {
+  Real64 sensedValue_;
+  ScalarEncoderParameters params_;
+
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(CEREAL_NVP(sensedValue_));
+    ar(cereal::make_nvp("minimum", params_.minimum),
+       cereal::make_nvp("maximum", params_.maximum),
+       cereal::make_nvp("clipInput", params_.clipInput),
+       cereal::make_nvp("periodic", params_.periodic),
+       cereal::make_nvp("activeBits", params_.activeBits),
+       cereal::make_nvp("sparsity", params_.sparsity),
+       cereal::make_nvp("size", params_.size),
+       cereal::make_nvp("radius", params_.radius),
+       cereal::make_nvp("resolution", params_.resolution),
+       cereal::make_nvp("sensedValue_", sensedValue_));
+  }
+};
+
+struct RDSEEncoderRegionFields {
+  Real64 sensedValue_;
+  Real32 noise_;
+  Random rnd_;
+  std::shared_ptr<RandomDistributedScalarEncoder> encoder_;
+
+  template<class Archive>
+  void save_ar(Archive& ar) const {
+    ar(CEREAL_NVP(sensedValue_));
+    ar(CEREAL_NVP(noise_));
+    ar(CEREAL_NVP(rnd_));
+    ar(cereal::make_nvp("encoder", encoder_));
+  }
+};
+
+static void print(const string &what, const vector<CellIdx> &cells) {
+  cout << what << ":";
+  for(const auto cell : cells) cout << " " << cell;
+  cout << endl;
+}
+
+int main() {
+  cout << setprecision(9);
+
+  { // Random, 5 steps after seeding
+    Random r(42);
+    for(int i = 0; i < 5; i++) r.getUInt32();
+    write("Random.v1.bin", r);
+    cout << "Random next:";
+    for(int i = 0; i < 5; i++) cout << " " << r.getUInt32();
+    cout << endl;
+  }
+
+  { // Connections with the holes of a destroyed synapse & segment
+    Connections c(8u, 0.5f);
+    const Segment s0 = c.createSegment(0);
+    const Segment s1 = c.createSegment(1);
+    const Segment s2 = c.createSegment(1);
+    c.createSynapse(s0, 4, 0.6f);
+    const Synapse gone = c.createSynapse(s0, 5, 0.4f);
+    c.createSynapse(s0, 6, 0.55f);
+    c.createSynapse(s1, 4, 0.3f);
+    c.createSynapse(s1, 7, 0.7f);
+    c.createSynapse(s2, 5, 0.5f);
+    c.computeActivity({4, 6});
+    c.destroySynapse(gone);
+    c.destroySegment(s1);
+    write("Connections.v2.bin", c);
+    for(const auto seg : {s0, s2}) {
+      cout << "Connections segment " << seg << " lastUsed " << c.dataForSegment(seg).lastUsed << ":";
+      for(const auto syn : c.synapsesForSegment(seg)) {
+        cout << " " << syn << " (" << c.dataForSynapse(syn).presynapticCell << ", "
+             << c.dataForSynapse(syn).permanence << ")";
+      }
+      cout << endl;
+    }
+  }
+
+  { // timeseries Connections, its dense updates of the last adaptSegment()
+    Connections c(8u, 0.5f, true);
+    const Segment seg = c.createSegment(0);
+    const Segment idle = c.createSegment(0);
+    for(CellIdx pre = 1; pre <= 4; pre++) c.createSynapse(seg, pre, 0.5f);
+    c.createSynapse(idle, 5, 0.5f);
+    SDR inputs({8});
+    inputs.setSparse(SDR_sparse_t{1, 2});
+    c.computeActivity(inputs.getSparse());
+    c.adaptSegment(seg, inputs, 0.1f, 0.1f);
+    write("Connections.timeseries.v2.bin", c);
+    inputs.setSparse(SDR_sparse_t{1, 3});
+    c.computeActivity(inputs.getSparse());
+    c.adaptSegment(seg, inputs, 0.1f, 0.1f);
+    cout << "Connections timeseries permanences:";
+    for(const auto syn : c.synapsesForSegment(seg)) cout << " " << c.dataForSynapse(syn).permanence;
+    cout << endl;
+  }
+
+  { // TemporalMemory, in the middle of a learned sequence
+    TemporalMemory tm({32u}, 4u, 2u, 0.21f, 0.5f, 1u, 3u, 0.1f, 0.1f, 0.0f, 42, 255u, 255u, true, 0u);
+    const vector<SDR_sparse_t> sequence = {{0, 1, 2, 3}, {8, 9, 10, 11}, {16, 17, 18, 19}, {24, 25, 26, 27}};
+    SDR columns({32u});
+    for(size_t step = 0; step < 10u * sequence.size() + 2u; step++) {
+      SDR_sparse_t active = sequence[step % sequence.size()];
+      columns.setSparse(active);
+      tm.compute(columns, true);
+    }
+    write("TemporalMemory.v1.bin", tm);
+    print("TemporalMemory active", tm.getActiveCells());
+    print("TemporalMemory winner", tm.getWinnerCells());
+    for(size_t step = 2u; step < 6u; step++) {
+      SDR_sparse_t active = sequence[step % sequence.size()];
+      columns.setSparse(active);
+      tm.compute(columns, true);
+      print("TemporalMemory next active", tm.getActiveCells());
+    }
+    // bursts, the rng picks 3 of the 4 previous winners for the new segments
+    columns.setSparse(SDR_sparse_t{4, 12, 20, 28});
+    tm.compute(columns, true);
+    cout << "TemporalMemory segments " << tm.connections.numSegments() << ", anomaly " << tm.anomaly << endl;
+    for(const auto cell : tm.getWinnerCells()) {
+      vector<CellIdx> presynaptic;
+      for(const auto syn : tm.connections.synapsesForSegment(tm.connections.segmentsForCell(cell).back())) {
+        presynaptic.push_back(tm.connections.dataForSynapse(syn).presynapticCell);
+      }
+      sort(presynaptic.begin(), presynaptic.end());
+      print("TemporalMemory novel winner " + to_string(cell) + " presynaptic", presynaptic);
+    }
+  }
+
+  { // SimHashDocumentEncoder
+    SimHashDocumentEncoderParameters params;
+    params.size = 400u;
+    params.activeBits = 21u;
+    params.tokenSimilarity = true;
+    params.excludes = {"Bravo"};
+    params.vocabulary = {{"Alpha", 3u}, {"Bravo", 1u}, {"Charlie", 2u}};
+    SimHashDocumentEncoder encoder(params);
+    write("SimHashDocumentEncoder.v1.bin", encoder);
+    SDR output({encoder.size});
+    encoder.encode({"alpha", "bravo", "charlie", "delta"}, output);
+    print("SimHashDocumentEncoder encode", output.getSparse());
+  }
+
+  { // ScalarEncoderRegion, params_ as its ValueMap constructor sets them
+    ScalarEncoderRegionFields region;
+    region.params_.minimum = 0.0;
+    region.params_.maximum = 100.0;
+    region.params_.clipInput = true;
+    region.params_.periodic = false;
+    region.params_.activeBits = 5u;
+    region.params_.size = 100u;
+    region.sensedValue_ = 42.5;
+    write("ScalarEncoderRegion.v1.bin", region);
+  }
+
+  { // RDSEEncoderRegion
+    RDSE_Parameters params;
+    params.size = 100u;
+    params.activeBits = 10u;
+    params.radius = 1.0f;
+    params.seed = 7u;
+    RDSEEncoderRegionFields region;
+    region.sensedValue_ = 3.25;
+    region.noise_ = 0.01f;
+    region.rnd_ = Random(42);
+    region.encoder_ = make_shared<RandomDistributedScalarEncoder>(params);
+    write("RDSEEncoderRegion.v1.bin", region);
+    cout << "RDSEEncoderRegion sparsity " << region.encoder_->parameters.sparsity
+         << ", resolution " << region.encoder_->parameters.resolution << endl;
+    SDR output({region.encoder_->size});
+    region.encoder_->encode(3.25, output);
+    print("RDSEEncoderRegion encode 3.25", output.getSparse());
+  }
+
+  return 0;
+}
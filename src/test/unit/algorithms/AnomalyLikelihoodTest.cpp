@@ -3,6 +3,7 @@
 
 #include "gtest/gtest.h"
 #include <htm/algorithms/AnomalyLikelihood.hpp>
+#include <htm/utils/Random.hpp>
 
 namespace testing {
 
@@ -25,6 +26,98 @@ TEST(DISABLED_AnomalyLikelihood, SelectModeLikelihood)
   ASSERT_FLOAT_EQ(likelihood, 0.1f); //TODO port likelihood tests here
 };
 
+TEST(AnomalyLikelihood, LikelihoodOfCurrentScore)
+{
+  // Small window, so that it is filled and slides during the test.
+  AnomalyLikelihood a(20, 30, 200, 50, 5);
+  Real likelihood = 0.0f;
+  for(int i = 0; i < 50; i++) {
+    likelihood = a.anomalyProbability(0.1f);
+    ASSERT_FLOAT_EQ(likelihood, a.DEFAULT_ANOMALY);
+  }
+  // Steady scores, the score is at the mean of the distribution.
+  for(int i = 0; i < 500; i++) {
+    likelihood = a.anomalyProbability(0.1f);
+  }
+  EXPECT_NEAR(likelihood, 0.5f, 0.01f);
+
+  // A sudden increase of the anomaly score is unlikely.
+  likelihood = a.anomalyProbability(1.0f);
+  EXPECT_GT(likelihood, 0.99f);
+}
+
+TEST(AnomalyLikelihood, BatchMatchesSingleStreams)
+{
+  const UInt numStreams = 5u;
+  std::vector<AnomalyLikelihood> singles(numStreams, AnomalyLikelihood(20, 30, 200, 50, 5));
+  AnomalyLikelihoodBatch batch(numStreams, 20, 30, 200, 50, 5);
+  ASSERT_EQ(batch.numStreams(), numStreams);
+
+  Random rng(17);
+  std::vector<Real> scores(numStreams), likelihoods;
+  for(int i = 0; i < 700; i++) {
+    for(UInt s = 0; s < numStreams; s++) {
+      // Streams with different levels of noise, and a spike.
+      scores[s] = (Real)rng.getReal64() * 0.1f * (Real)(s + 1u);
+      if(i == 600 and s == 2u) scores[s] = 1.0f;
+    }
+    batch.anomalyProbability(scores, likelihoods);
+    ASSERT_EQ(likelihoods.size(), numStreams);
+    for(UInt s = 0; s < numStreams; s++) {
+      ASSERT_FLOAT_EQ(likelihoods[s], singles[s].anomalyProbability(scores[s])) << "record " << i << " stream " << s;
+    }
+  }
+  EXPECT_ANY_THROW(batch.anomalyProbability(std::vector<Real>(3u, 0.0f), likelihoods));
+}
+
+TEST(AnomalyLikelihood, SketchLikelihood)
+{
+  AnomalyLikelihoodSketch a(20, 30, 200, 50, 5);
+  Random rng(17);
+  Real likelihood = 0.0f;
+  for(int i = 0; i < 50; i++) {
+    likelihood = a.anomalyProbability((Real)rng.getReal64() * 0.1f);
+    ASSERT_FLOAT_EQ(likelihood, a.DEFAULT_ANOMALY);
+  }
+  // Noisy low scores, long enough for the history to rotate.
+  for(int i = 0; i < 600; i++) {
+    likelihood = a.anomalyProbability((Real)rng.getReal64() * 0.1f);
+    ASSERT_GE(likelihood, 0.0f);
+    ASSERT_LE(likelihood, 1.0f);
+  }
+  const auto history = a.getSketch();
+  EXPECT_GE(history.getCount(), 200u);
+  EXPECT_LE(history.getCount(), 400u);
+
+  // A spike is above all of the history.
+  for(int i = 0; i < 5; i++) {
+    likelihood = a.anomalyProbability(1.0f);
+  }
+  EXPECT_FLOAT_EQ(likelihood, 1.0f);
+
+  // Constant scores sit in the middle of their own history.
+  AnomalyLikelihoodSketch b(20, 30, 200, 50, 5);
+  for(int i = 0; i < 300; i++) {
+    likelihood = b.anomalyProbability(0.0f);
+  }
+  EXPECT_FLOAT_EQ(likelihood, 0.5f);
+}
+
+TEST(AnomalyLikelihood, SketchSerialization)
+{
+  AnomalyLikelihoodSketch a(20, 30, 200, 50, 5);
+  Random rng(5);
+  for(int i = 0; i < 300; i++) {
+    a.anomalyProbability((Real)rng.getReal64());
+  }
+  AnomalyLikelihoodSketch b(20, 30, 200, 50, 5);
+  std::stringstream ss;
+  a.save(ss);
+  b.load(ss);
+  EXPECT_EQ(a, b);
+  EXPECT_FLOAT_EQ(a.anomalyProbability(0.3f), b.anomalyProbability(0.3f));
+}
+
 TEST(DISABLED_AnomalyLikelihood, SerializationLikelihood)
 {
   AnomalyLikelihood a;
@@ -69,4 +69,25 @@ TEST(ComputeRawAnomalyScore, PartialMatch) {
   ASSERT_FLOAT_EQ(computeRawAnomalyScore(active, predicted), 2.0f / 3.0f);
 };
 
+TEST(ComputeRawAnomalyScore, Batch) {
+  std::vector<SDR> active(3u, SDR({10}));
+  std::vector<SDR> predicted(3u, SDR({10}));
+  active[0].setSparse(SDR_sparse_t{1, 2, 3, 4});
+  predicted[0].setSparse(SDR_sparse_t{3, 4, 5});
+  active[1].setSparse(SDR_sparse_t{6});
+  predicted[1].setSparse(SDR_sparse_t{6});
+  // active[2] is empty
+
+  std::vector<Real> scores;
+  computeRawAnomalyScores(active, predicted, scores);
+  ASSERT_EQ(scores.size(), 3u);
+  for(size_t i = 0; i < scores.size(); i++) {
+    ASSERT_FLOAT_EQ(scores[i], computeRawAnomalyScore(active[i], predicted[i]));
+  }
+  ASSERT_FLOAT_EQ(scores[0], 0.5f);
+
+  predicted.pop_back();
+  EXPECT_ANY_THROW(computeRawAnomalyScores(active, predicted, scores));
+};
+
 }
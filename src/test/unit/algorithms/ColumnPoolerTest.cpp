@@ -0,0 +1,143 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for ColumnPooler
+ */
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <sstream>
+#include <htm/algorithms/ColumnPooler.hpp>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+// An SDR with the bits [begin, begin + count) active.
+SDR feature(UInt size, UInt begin, UInt count) {
+  SDR sdr({ size });
+  SDR_sparse_t bits;
+  for(UInt i = begin; i < begin + count; i++) bits.push_back(i);
+  sdr.setSparse(bits);
+  return sdr;
+}
+
+
+TEST(ColumnPoolerTest, testNewRepresentation) {
+  ColumnPooler pooler(1024u);
+  pooler.compute(feature(1024u, 0u, 30u));
+
+  const auto cells = pooler.getActiveCells();
+  ASSERT_EQ(cells.size(), 40u);
+  EXPECT_TRUE(is_sorted(cells.begin(), cells.end()));
+
+  // Each active cell grows sampleSizeProximal synapses to the input.
+  EXPECT_EQ(pooler.numberOfProximalSynapses(), 40u * 20u);
+  EXPECT_EQ(pooler.numberOfConnectedProximalSynapses(), 40u * 20u);
+  EXPECT_EQ(pooler.numberOfProximalSynapses(cells), 40u * 20u);
+  EXPECT_EQ(pooler.numberOfDistalSegments(), 0u);
+
+  // Learning the next feature of the same object keeps the representation.
+  pooler.compute(feature(1024u, 100u, 30u));
+  EXPECT_EQ(pooler.getActiveCells(), cells);
+  EXPECT_EQ(pooler.numberOfProximalSynapses(), 40u * 40u);
+  EXPECT_EQ(pooler.numberOfDistalSegments(), 40u);
+  EXPECT_EQ(pooler.numberOfDistalSynapses(), 40u * 20u);
+
+  // After a reset a new object gets a new representation.
+  pooler.reset();
+  EXPECT_TRUE(pooler.getActiveCells().empty());
+  pooler.compute(feature(1024u, 200u, 30u));
+  EXPECT_EQ(pooler.getActiveCells().size(), 40u);
+  EXPECT_NE(pooler.getActiveCells(), cells);
+}
+
+
+TEST(ColumnPoolerTest, testRecognizeObjects) {
+  ColumnPooler pooler(1024u);
+
+  pooler.compute(feature(1024u, 0u, 30u));
+  pooler.compute(feature(1024u, 100u, 30u));
+  const auto object1 = pooler.getActiveCells();
+  pooler.reset();
+
+  pooler.compute(feature(1024u, 200u, 30u));
+  pooler.compute(feature(1024u, 300u, 30u));
+  const auto object2 = pooler.getActiveCells();
+  pooler.reset();
+
+  // Any feature of an object recalls its whole representation.
+  pooler.compute(feature(1024u, 100u, 30u), {}, false);
+  EXPECT_EQ(pooler.getActiveCells(), object1);
+  pooler.reset();
+  pooler.compute(feature(1024u, 200u, 30u), {}, false);
+  EXPECT_EQ(pooler.getActiveCells(), object2);
+
+  // Inference does not learn.
+  EXPECT_EQ(pooler.numberOfProximalSynapses(), 2u * 40u * 40u);
+
+  // An unknown feature activates nothing.
+  pooler.reset();
+  pooler.compute(feature(1024u, 500u, 30u), {}, false);
+  EXPECT_TRUE(pooler.getActiveCells().empty());
+
+  // A sparse output SDR.
+  pooler.compute(feature(1024u, 0u, 30u), {}, false);
+  SDR active({ 4096u });
+  pooler.getActiveCells(active);
+  EXPECT_EQ(active.getSparse(), object1);
+}
+
+
+TEST(ColumnPoolerTest, testLateralInput) {
+  ColumnPooler pooler(1024u, { 2048u, 2048u });
+  const vector<SDR> lateral = { feature(2048u, 0u, 40u), feature(2048u, 1000u, 40u) };
+
+  pooler.compute(feature(1024u, 0u, 30u), lateral);
+  // One lateral segment per input on each active cell, no previous activity.
+  EXPECT_EQ(pooler.numberOfDistalSegments(), 2u * 40u);
+  EXPECT_EQ(pooler.numberOfDistalSynapses(), 2u * 40u * 20u);
+  EXPECT_EQ(pooler.numberOfConnectedDistalSynapses(), 2u * 40u * 20u);
+  EXPECT_EQ(pooler.getLateralDistalConnections(1u).numSynapses(), 40u * 20u);
+
+  EXPECT_ANY_THROW(pooler.compute(feature(1024u, 0u, 30u), { feature(100u, 0u, 10u) }));
+  EXPECT_ANY_THROW(pooler.compute(feature(100u, 0u, 30u)));
+}
+
+
+TEST(ColumnPoolerTest, testSaveLoad) {
+  ColumnPooler pooler1(1024u, { 2048u });
+  pooler1.compute(feature(1024u, 0u, 30u), { feature(2048u, 0u, 40u) });
+  pooler1.compute(feature(1024u, 100u, 30u), { feature(2048u, 0u, 40u) });
+
+  stringstream ss;
+  pooler1.save(ss);
+  ColumnPooler pooler2;
+  pooler2.load(ss);
+  EXPECT_EQ(pooler1, pooler2);
+
+  // Both continue the same way.
+  pooler1.reset();
+  pooler2.reset();
+  pooler1.compute(feature(1024u, 300u, 30u));
+  pooler2.compute(feature(1024u, 300u, 30u));
+  EXPECT_EQ(pooler1.getActiveCells(), pooler2.getActiveCells());
+}
+
+} // namespace testing
@@ -0,0 +1,191 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for ComputeBackend
+ */
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <htm/algorithms/ComputeBackend.hpp>
+#include <htm/algorithms/SpatialPooler.hpp>
+#include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+// Random segments on all cells, with presynaptic cells beyond the cells.
+static void randomConnections(Connections &connections, UInt numPresynaptic, Random &rng) {
+  for(CellIdx cell = 0u; cell < connections.numCells(); cell++) {
+    for(int i = 0; i < 3; i++) {
+      const auto segment = connections.createSegment(cell, 255u);
+      for(int s = 0; s < 20; s++) {
+        connections.createSynapse(segment, rng.getUInt32(numPresynaptic), (Permanence)rng.getReal64());
+      }
+    }
+  }
+}
+
+static vector<CellIdx> randomActive(UInt n, Real density, Random &rng) {
+  vector<CellIdx> active;
+  for(UInt i = 0u; i < n; i++) {
+    if( rng.getReal64() < density ) active.push_back(i);
+  }
+  return active;
+}
+
+
+TEST(ComputeBackendTest, testOverlapsSameAsConnections) {
+  Random rng(42);
+  Connections connections(2000u, 0.5f);
+  randomConnections(connections, 3000u, rng);
+
+  for(const UInt numThreads : { 1u, 4u }) {
+    auto backend = ComputeBackend::create("cpu", numThreads);
+    EXPECT_EQ(backend->name(), "cpu");
+    for(int iteration = 0; iteration < 5; iteration++) {
+      const auto active = randomActive(3000u, 0.3f, rng);
+      vector<SynapseIdx> potential(connections.segmentFlatListLength());
+      const auto connected = connections.computeActivity(potential, active, false);
+
+      backend->update(connections, true);
+      vector<SynapseIdx> backendConnected, backendPotential;
+      backend->overlaps(active, backendConnected, &backendPotential);
+      ASSERT_EQ(backendConnected, connected);
+      ASSERT_EQ(backendPotential, potential);
+
+      // A structural change is uploaded by the next update.
+      const auto segment = connections.createSegment(rng.getUInt32(2000u), 255u);
+      connections.createSynapse(segment, 7u, 0.9f);
+    }
+  }
+}
+
+
+TEST(ComputeBackendTest, testStructureVersion) {
+  Connections connections(10u, 0.5f);
+  const auto segment = connections.createSegment(0u, 255u);
+  const auto synapse = connections.createSynapse(segment, 5u, 0.4f);
+  const auto version = connections.structureVersion();
+  EXPECT_EQ(version, connections.structureVersion());
+
+  connections.updateSynapsePermanence(synapse, 0.45f);
+  EXPECT_EQ(version, connections.structureVersion()) << "Not connected before nor after.";
+  connections.updateSynapsePermanence(synapse, 0.6f);
+  EXPECT_NE(version, connections.structureVersion()) << "Crossed the connected threshold.";
+
+  Connections other(10u, 0.5f);
+  EXPECT_NE(other.structureVersion(), connections.structureVersion());
+}
+
+
+TEST(ComputeBackendTest, testTopKAndThreshold) {
+  Random rng(7);
+  for(const UInt numThreads : { 1u, 3u }) {
+    auto backend = ComputeBackend::create("cpu", numThreads);
+    vector<Real> scores(10000u);
+    for(auto &score : scores) score = static_cast<Real>(rng.getUInt32(20u));
+
+    vector<UInt> winners;
+    backend->topK(scores, 500u, 4.0f, winners);
+    vector<UInt> expected(scores.size());
+    for(UInt i = 0u; i < expected.size(); i++) expected[i] = i;
+    std::sort(expected.begin(), expected.end(), [&](UInt a, UInt b) {
+      return scores[a] == scores[b] ? a > b : scores[a] > scores[b]; });
+    expected.resize(500u);
+    EXPECT_EQ(winners, expected);
+
+    // Fewer scores than k pass the minimum.
+    backend->topK(scores, 500u, 19.0f, winners);
+    for(const auto winner : winners) EXPECT_EQ(scores[winner], 19.0f);
+    EXPECT_LT(winners.size(), 500u);
+
+    vector<SynapseIdx> counts(10000u);
+    for(auto &count : counts) count = static_cast<SynapseIdx>(rng.getUInt32(10u));
+    vector<UInt> selected, expectedSelected;
+    backend->threshold(counts, 7u, selected);
+    for(UInt i = 0u; i < counts.size(); i++) {
+      if( counts[i] >= 7u ) expectedSelected.push_back(i);
+    }
+    EXPECT_EQ(selected, expectedSelected);
+  }
+}
+
+
+TEST(ComputeBackendTest, testRegistry) {
+  const auto names = ComputeBackend::available();
+  EXPECT_NE(std::find(names.begin(), names.end(), "cpu"), names.end());
+  EXPECT_ANY_THROW(ComputeBackend::create("no such backend"));
+
+  // A device backend registers itself the same way.
+  ComputeBackend::registerBackend("test", [](UInt numThreads) {
+    return ComputeBackend::create("cpu", numThreads); });
+  EXPECT_EQ(ComputeBackend::create("test")->name(), "cpu");
+  const auto more = ComputeBackend::available();
+  EXPECT_NE(std::find(more.begin(), more.end(), "test"), more.end());
+}
+
+
+TEST(ComputeBackendTest, testSpatialPoolerSameResults) {
+  SpatialPooler sp({ 400u }, { 1024u });
+  SpatialPooler withBackend({ 400u }, { 1024u });
+  withBackend.setComputeBackend(ComputeBackend::create("cpu", 2u));
+  ASSERT_NE(withBackend.getComputeBackend(), nullptr);
+
+  Random rng(1);
+  SDR input({ 400u });
+  SDR active({ 1024u });
+  SDR expected({ 1024u });
+  for(int i = 0; i < 50; i++) {
+    input.randomize(0.1f, rng);
+    const bool learn = i % 5 != 4; // the backend also sees learned changes
+    const auto overlaps = sp.compute(input, learn, expected);
+    const auto backendOverlaps = withBackend.compute(input, learn, active);
+    ASSERT_EQ(active, expected);
+    ASSERT_EQ(backendOverlaps, overlaps);
+  }
+  EXPECT_EQ(withBackend, sp);
+}
+
+
+TEST(ComputeBackendTest, testTemporalMemorySameResults) {
+  TemporalMemory tm({ 64u }, 4u, /*activationThreshold*/ 3u, /*initialPermanence*/ 0.5f,
+                    /*connectedPermanence*/ 0.5f, /*minThreshold*/ 2u, /*maxNewSynapseCount*/ 6u);
+  TemporalMemory withBackend({ 64u }, 4u, 3u, 0.5f, 0.5f, 2u, 6u);
+  withBackend.setComputeBackend(ComputeBackend::create("cpu"));
+
+  Random rng(3);
+  vector<SDR> sequence(5u, SDR({ 64u }));
+  for(auto &s : sequence) s.randomize(0.1f, rng);
+  for(int repeat = 0; repeat < 6; repeat++) {
+    const bool learn = repeat < 4;
+    for(const auto &columns : sequence) {
+      tm.compute(columns, learn);
+      withBackend.compute(columns, learn);
+      ASSERT_EQ(withBackend.getActiveCells(), tm.getActiveCells());
+      ASSERT_EQ(withBackend.getActiveSegments(), tm.getActiveSegments());
+      ASSERT_EQ(withBackend.getMatchingSegments(), tm.getMatchingSegments());
+      ASSERT_EQ(withBackend.anomaly, tm.anomaly);
+    }
+  }
+  EXPECT_EQ(withBackend, tm);
+}
+
+} // namespace testing
@@ -27,6 +27,7 @@
 #include <htm/algorithms/SpatialPooler.hpp>
 #include <htm/algorithms/TemporalMemory.hpp>
 #include <htm/utils/Random.hpp>
+#include <htm/utils/SequenceGenerator.hpp>
 #include <htm/os/Timer.hpp>
 #include <htm/types/Types.hpp> // macro "UNUSED"
 #include <htm/utils/MovingAverage.hpp>
@@ -103,6 +104,45 @@ float runTemporalMemoryTest(UInt numColumns, UInt w,   int numSequences, //TODO
 
 
 
+/**
+ * TM on a stream of repeated sequences which share subsequences, with noise,
+ * as real data has: the segments grow and get reused like in an application.
+ */
+float runTemporalMemorySequencesTest(UInt numColumns, UInt w, UInt records, string label) {
+  SequenceGeneratorParameters p;
+  p.dimensions     = {numColumns};
+  p.sparsity       = w / static_cast<Real>(numColumns);
+  p.alphabetSize   = 50u;
+  p.numSequences   = 20u;
+  p.sequenceLength = 10u;
+  p.branching      = 0.3f;
+  p.repetition     = 0.9f;
+  p.noise          = 0.02f;
+  p.seed           = SEED;
+  SequenceGenerator generator(p);
+  SDR input(p.dimensions);
+
+  Timer timer(true);
+  TemporalMemory tm;
+  tm.initialize( {numColumns} );
+  MovingAverage anomaly(p.sequenceLength * p.numSequences);
+  for (UInt i = 0u; i < records; i++) {
+    if (generator.next(input))
+      tm.reset();
+    tm.compute(input, true);
+    anomaly.compute(tm.anomaly);
+  }
+  timer.stop();
+  cout << (float)timer.getElapsed() << " in " << label << ": " << records << " records, "
+       << tm.connections.numSegments() << " segments, avg anomaly " << anomaly.getCurrentAvg() << endl;
+#if defined NDEBUG && !defined(NTA_OS_WINDOWS) //the debug sizes are too small to predict
+  NTA_CHECK(anomaly.getCurrentAvg() < 0.5f) << "TM should learn the repeated sequences, but got: "
+    << anomaly.getCurrentAvg();
+#endif
+  return (float)timer.getElapsed();
+}
+
+
 float runSpatialPoolerTest(
                   UInt   numInputs,
                   Real   inputSparsity,
@@ -189,6 +229,14 @@ TEST(ConnectionsPerformanceTest, testTMLarge) {
   UNUSED(tim);
 }
 
+/**
+ * Tests Connections with a Temporal Memory learning correlated sequences.
+ */
+TEST(ConnectionsPerformanceTest, testTMSequences) {
+  auto tim = runTemporalMemorySequencesTest(COLS, W, EPOCHS * SEQ * 10u, "temporal memory (sequences)");
+  UNUSED(tim);
+}
+
 /**
  * Tests typical usage of Connections with Spatial Pooler.
  */
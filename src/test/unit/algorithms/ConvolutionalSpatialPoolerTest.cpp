@@ -0,0 +1,153 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for ConvolutionalSpatialPooler
+ */
+
+#include "gtest/gtest.h"
+#include <sstream>
+#include <htm/algorithms/ConvolutionalSpatialPooler.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+ConvolutionalSpatialPooler makeCSP(const vector<UInt> &inputDims, const UInt stride) {
+  return ConvolutionalSpatialPooler(inputDims, {5, 4}, stride, /*numPrototypes*/ 8,
+                   /*potentialPct*/ 0.5f, /*localAreaDensity*/ 0.05f, /*stimulusThreshold*/ 1u,
+                   /*synPermInactiveDec*/ 0.01f, /*synPermActiveInc*/ 0.1f, /*synPermConnected*/ 0.2f,
+                   /*dutyCyclePeriod*/ 50, /*boostStrength*/ 2.0f, /*seed*/ 5);
+}
+
+
+TEST(ConvolutionalSpatialPoolerTest, testDimensions) {
+  const auto csp = makeCSP({20, 21, 2}, 2);
+  EXPECT_EQ(20u * 21u * 2u, csp.getNumInputs());
+  EXPECT_EQ(vector<UInt>({8, 9, 8}), csp.getColumnDimensions());
+  EXPECT_EQ(8u * 9u * 8u, csp.getNumColumns());
+  EXPECT_EQ(8u * 20u, csp.numSynapses()) << "half of the 5x4x2 kernel, per prototype";
+
+  // The synapses do not grow with the image.
+  EXPECT_EQ(csp.numSynapses(), makeCSP({200, 210, 2}, 2).numSynapses());
+  EXPECT_EQ(10u * 21u, makeCSP({10, 21}, 1).getNumInputs());
+
+  EXPECT_ANY_THROW(makeCSP({3, 21}, 1)) << "kernel larger than the input";
+  EXPECT_ANY_THROW(makeCSP({20}, 1));
+}
+
+
+// The overlaps of the shifted sparse lookups equal the brute force
+// convolution of the connected synapses of the prototypes.
+TEST(ConvolutionalSpatialPoolerTest, testOverlaps) {
+  for(const UInt stride : {1u, 3u}) {
+    for(const UInt channels : {1u, 3u}) {
+      auto csp = makeCSP({17, 15, channels}, stride);
+      Random rng(1);
+      SDR input({17, 15, channels});
+      SDR active(csp.getColumnDimensions());
+      for(int i = 0; i < 5; i++) {
+        input.randomize(0.2f, rng);
+        csp.compute(input, true, active);
+        ASSERT_FALSE(active.getSparse().empty());
+      }
+      csp.compute(input, false, active);
+
+      const auto &dims = csp.getColumnDimensions();
+      const auto &dense = input.getDense();
+      vector<Real> perm;
+      for(UInt p = 0; p < csp.getNumPrototypes(); p++) {
+        csp.getPermanence(p, perm);
+        for(UInt oy = 0; oy < dims[0]; oy++) {
+          for(UInt ox = 0; ox < dims[1]; ox++) {
+            UInt expected = 0;
+            for(UInt ky = 0; ky < 5; ky++) {
+              for(UInt kx = 0; kx < 4; kx++) {
+                for(UInt c = 0; c < channels; c++) {
+                  const UInt bit = ((oy * stride + ky) * 15 + ox * stride + kx) * channels + c;
+                  if( dense[bit] and perm[(ky * 4 + kx) * channels + c] >= 0.2f - htm::Epsilon ) expected++;
+                }
+              }
+            }
+            ASSERT_EQ(expected, csp.getOverlaps()[(oy * dims[1] + ox) * dims[2] + p])
+              << "stride " << stride << " channels " << channels;
+          }
+        }
+      }
+    }
+  }
+}
+
+
+TEST(ConvolutionalSpatialPoolerTest, testLearning) {
+  auto csp = makeCSP({12, 12}, 1);
+  SDR input({12, 12});
+  SDR active(csp.getColumnDimensions());
+  // vertical bars every 4 pixels
+  vector<UInt> bars;
+  for(UInt y = 0; y < 12; y++) {
+    for(UInt x = 0; x < 12; x += 4) bars.push_back(y * 12 + x);
+  }
+  input.setSparse(bars);
+
+  csp.compute(input, false, active);
+  UInt overlapBefore = 0;
+  for(const auto c : active.getSparse()) overlapBefore += csp.getOverlaps()[c];
+
+  for(int i = 0; i < 20; i++) {
+    csp.compute(input, true, active);
+  }
+  csp.compute(input, false, active);
+  UInt overlapAfter = 0;
+  for(const auto c : active.getSparse()) overlapAfter += csp.getOverlaps()[c];
+  EXPECT_GT(overlapAfter, overlapBefore) << "the winning prototypes learned the bars";
+  EXPECT_EQ(8u * 10u, csp.numSynapses());
+
+  Real totalDuty = 0.0f;
+  for(const auto duty : csp.getActiveDutyCycles()) totalDuty += duty;
+  EXPECT_NEAR(totalDuty, (Real)active.getSum() / (8u * 9u), 0.001f)
+    << "the duty cycles add up to the active columns per position";
+}
+
+
+TEST(ConvolutionalSpatialPoolerTest, testSaveLoad) {
+  auto csp = makeCSP({16, 16, 2}, 2);
+  Random rng(7);
+  SDR input({16, 16, 2});
+  SDR active1(csp.getColumnDimensions());
+  SDR active2(csp.getColumnDimensions());
+  for(int i = 0; i < 10; i++) {
+    input.randomize(0.1f, rng);
+    csp.compute(input, true, active1);
+  }
+
+  stringstream ss;
+  csp.save(ss);
+  ConvolutionalSpatialPooler loaded;
+  loaded.load(ss);
+  ASSERT_EQ(csp, loaded);
+
+  input.randomize(0.1f, rng);
+  csp.compute(input, true, active1);
+  loaded.compute(input, true, active2);
+  ASSERT_EQ(active1, active2);
+  ASSERT_EQ(csp, loaded);
+}
+
+} // end namespace
@@ -0,0 +1,186 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for EdgeExporter and the edge runtime
+ */
+
+#include "gtest/gtest.h"
+#include <cstring>
+#include <htm/algorithms/EdgeExporter.hpp>
+#include <htm/edge/EdgeRuntime.hpp>
+#include <htm/utils/Random.hpp>
+#include <htm/utils/SequenceGenerator.hpp>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+// The model in 8 byte aligned memory, as from flash.
+vector<UInt64> exportModel(const EdgeExporter &exporter, size_t &size) {
+  vector<char> buffer;
+  exporter.save(buffer);
+  size = buffer.size();
+  vector<UInt64> aligned((size + 7u) / 8u);
+  std::memcpy(aligned.data(), buffer.data(), size);
+  return aligned;
+}
+
+
+TEST(EdgeExporterTest, testSameAsInference) {
+  SequenceGeneratorParameters p;
+  p.dimensions   = {400u};
+  p.alphabetSize = 20u;
+  p.numSequences = 3u;
+  p.sequenceLength = 6u;
+  SequenceGenerator generator(p);
+  vector<SDR> inputs;
+  vector<bool> resets;
+  generator.generate(300u, inputs, resets);
+
+  SpatialPooler sp({400u}, {256u}, /*potentialRadius*/ 400u, /*potentialPct*/ 0.5f,
+                   /*globalInhibition*/ true, /*localAreaDensity*/ 0.05f);
+  sp.setBoostStrength(2.0f);
+  TemporalMemory tm({256u}, 8u, /*activationThreshold*/ 6u, 0.21f, 0.5f, /*minThreshold*/ 4u,
+                    /*maxNewSynapseCount*/ 12u);
+  Classifier classifier;
+  SDR columns({256u});
+  SDR cells({256u * 8u});
+  for(size_t i = 0u; i < inputs.size(); i++) {
+    if( resets[i] ) tm.reset();
+    sp.compute(inputs[i], true, columns);
+    tm.compute(columns, true);
+    tm.getActiveCells(cells);
+    classifier.learn(cells, {static_cast<UInt>(i % 7u)});
+  }
+  ASSERT_GT(tm.connections.numSegments(), 0u);
+
+  size_t size;
+  const auto data = exportModel(EdgeExporter(&sp, &tm, &classifier), size);
+  edge::Model model;
+  ASSERT_EQ(edge::Status::Ok, model.load(data.data(), size));
+  EXPECT_TRUE(model.hasSpatialPooler() and model.hasTemporalMemory() and model.hasClassifier());
+  EXPECT_EQ(400u, model.numInputs());
+  EXPECT_EQ(256u * 8u, model.numCells());
+  vector<UInt32> workspace(model.workspaceSize() / 4u);
+  edge::Runtime runtime;
+  EXPECT_EQ(edge::Status::Workspace, runtime.initialize(model, workspace.data(), model.workspaceSize() - 4u));
+  ASSERT_EQ(edge::Status::Ok, runtime.initialize(model, workspace.data(), workspace.size() * 4u));
+
+  tm.reset();
+  size_t predicted = 0u;
+  for(size_t i = 0u; i < 100u; i++) {
+    if( resets[i] ) {
+      tm.reset();
+      runtime.reset();
+    }
+    sp.compute(inputs[i], false, columns);
+    tm.compute(columns, false);
+    tm.getActiveCells(cells);
+    const PDF pdf = classifier.infer(cells);
+
+    const auto &bits = inputs[i].getSparse();
+    ASSERT_EQ(edge::Status::Ok, runtime.compute(bits.data(), bits.size()));
+    size_t count;
+    const UInt32 *active = runtime.activeColumns(count);
+    ASSERT_EQ(columns.getSparse(), vector<UInt>(active, active + count)) << "step " << i;
+    active = runtime.activeCells(count);
+    ASSERT_EQ(cells.getSparse(), vector<UInt>(active, active + count)) << "step " << i;
+    ASSERT_FLOAT_EQ(tm.anomaly, runtime.anomaly());
+    predicted += tm.anomaly < 0.5f;
+    ASSERT_EQ(argmax(pdf), runtime.category());
+    for(size_t c = 0u; c < pdf.size(); c++) {
+      ASSERT_NEAR(pdf[c], runtime.probabilities()[c], 1e-4);
+    }
+  }
+  EXPECT_GT(predicted, 0u) << "the sequences are learned";
+}
+
+
+TEST(EdgeExporterTest, testLocalInhibition) {
+  for(const bool wrap : {true, false}) {
+    SpatialPooler sp({20u, 20u}, {16u, 16u}, /*potentialRadius*/ 5u, /*potentialPct*/ 0.5f,
+                     /*globalInhibition*/ false, /*localAreaDensity*/ 0.1f, /*numActiveColumnsPerInhArea*/ 0,
+                     /*stimulusThreshold*/ 2u, /*synPermInactiveDec*/ 0.01f, /*synPermActiveInc*/ 0.1f,
+                     /*synPermConnected*/ 0.1f, /*minPctOverlapDutyCycles*/ 0.001f,
+                     /*dutyCyclePeriod*/ 50, /*boostStrength*/ 0.0f, /*seed*/ 5, /*spVerbosity*/ 0, wrap);
+    Random rng(3);
+    SDR input({20u, 20u});
+    SDR columns({16u, 16u});
+    for(int i = 0; i < 50; i++) {
+      input.randomize(0.1f, rng);
+      sp.compute(input, true, columns);
+    }
+
+    size_t size;
+    const auto data = exportModel(EdgeExporter(&sp), size);
+    edge::Model model;
+    ASSERT_EQ(edge::Status::Ok, model.load(data.data(), size));
+    vector<UInt32> workspace(model.workspaceSize() / 4u);
+    edge::Runtime runtime;
+    ASSERT_EQ(edge::Status::Ok, runtime.initialize(model, workspace.data(), workspace.size() * 4u));
+    EXPECT_EQ(nullptr, runtime.probabilities());
+    for(int i = 0; i < 20; i++) {
+      input.randomize(0.1f, rng);
+      sp.compute(input, false, columns);
+      const auto &bits = input.getSparse();
+      ASSERT_EQ(edge::Status::Ok, runtime.compute(bits.data(), bits.size()));
+      size_t count;
+      const UInt32 *active = runtime.activeColumns(count);
+      ASSERT_EQ(columns.getSparse(), vector<UInt>(active, active + count));
+    }
+  }
+}
+
+
+TEST(EdgeExporterTest, testErrors) {
+  SpatialPooler sp({100u}, {64u}, 100u, 0.5f, true, 0.1f);
+  TemporalMemory tm({32u}, 4u);
+  vector<char> buffer;
+  EXPECT_ANY_THROW(EdgeExporter(&sp, &tm).save(buffer)) << "the columns differ";
+  EXPECT_ANY_THROW(EdgeExporter(nullptr));
+  Classifier unlearned;
+  EXPECT_ANY_THROW(EdgeExporter(nullptr, nullptr, &unlearned).save(buffer));
+
+  size_t size;
+  auto data = exportModel(EdgeExporter(&sp), size);
+  edge::Model model;
+  EXPECT_EQ(edge::Status::Malformed, model.load(data.data(), size - 4u)) << "truncated";
+  EXPECT_EQ(edge::Status::Unaligned, model.load(reinterpret_cast<const char *>(data.data()) + 1, size - 1u));
+  EXPECT_FALSE(model.isLoaded());
+  edge::Runtime runtime;
+  UInt32 word;
+  EXPECT_EQ(edge::Status::NotLoaded, runtime.initialize(model, &word, sizeof(word)));
+  const UInt32 bit = 0u;
+  EXPECT_EQ(edge::Status::NotLoaded, runtime.compute(&bit, 1u));
+
+  reinterpret_cast<char *>(data.data())[8] = 99; //the version
+  EXPECT_EQ(edge::Status::Version, model.load(data.data(), size));
+  reinterpret_cast<char *>(data.data())[0] = 'X';
+  EXPECT_EQ(edge::Status::Malformed, model.load(data.data(), size));
+
+  data = exportModel(EdgeExporter(&sp), size);
+  ASSERT_EQ(edge::Status::Ok, model.load(data.data(), size));
+  vector<UInt32> workspace(model.workspaceSize() / 4u);
+  ASSERT_EQ(edge::Status::Ok, runtime.initialize(model, workspace.data(), workspace.size() * 4u));
+  const UInt32 outOfRange = 100u;
+  EXPECT_EQ(edge::Status::Input, runtime.compute(&outOfRange, 1u));
+  EXPECT_STREQ("invalid input", edge::statusString(edge::Status::Input));
+}
+
+} // namespace testing
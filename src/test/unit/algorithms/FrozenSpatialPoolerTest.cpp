@@ -0,0 +1,131 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for FrozenSpatialPooler
+ */
+
+#include "gtest/gtest.h"
+#include <sstream>
+#include <thread>
+#include <htm/algorithms/FrozenSpatialPooler.hpp>
+#include <htm/utils/Random.hpp>
+#include "SpatialPoolerTestUtilities.hpp"
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+
+TEST(FrozenSpatialPoolerTest, testSameAsInference) {
+  for(const bool global : {true, false}) {
+    for(const bool wrap : {true, false}) {
+      for(const Real boost : {0.0f, 3.0f}) {
+        SpatialPooler sp = makeSmallSP(global, /*stimulusThreshold*/ 2u, /*minPctOverlapDutyCycles*/ 0.001f,
+                                       boost, /*potentialRadius*/ 5u, /*seed*/ 5, wrap);
+        trainSP(sp);
+        const FrozenSpatialPooler frozen = sp.freeze();
+        ASSERT_EQ(sp.getNumInputs(), frozen.getNumInputs());
+        ASSERT_EQ(sp.getNumColumns(), frozen.getNumColumns());
+        ASSERT_LT(frozen.numConnectedSynapses(), sp.connections.numSynapses());
+
+        Random rng(99);
+        SDR input(sp.getInputDimensions());
+        SDR expected(sp.getColumnDimensions());
+        SDR active(sp.getColumnDimensions());
+        for(int i = 0; i < 20; i++) {
+          input.randomize(0.1f, rng);
+          sp.compute(input, false, expected);
+          frozen.compute(input, active);
+          ASSERT_EQ(expected, active) << "global " << global << " wrap " << wrap << " boost " << boost;
+        }
+      }
+    }
+  }
+}
+
+
+TEST(FrozenSpatialPoolerTest, testSaveLoad) {
+  SpatialPooler sp = makeSmallSP(false, /*stimulusThreshold*/ 2u, /*minPctOverlapDutyCycles*/ 0.001f,
+                                 /*boostStrength*/ 3.0f, /*potentialRadius*/ 5u, /*seed*/ 5);
+  trainSP(sp);
+  const FrozenSpatialPooler frozen(sp);
+
+  stringstream ss;
+  frozen.save(ss);
+  FrozenSpatialPooler loaded;
+  loaded.load(ss);
+  ASSERT_EQ(frozen, loaded);
+
+  SDR input(sp.getInputDimensions());
+  SDR active1(sp.getColumnDimensions());
+  SDR active2(sp.getColumnDimensions());
+  Random rng(7);
+  input.randomize(0.1f, rng);
+  frozen.compute(input, active1);
+  loaded.compute(input, active2);
+  ASSERT_EQ(active1, active2);
+}
+
+
+TEST(FrozenSpatialPoolerTest, testSharedConcurrentCompute) {
+  SpatialPooler sp = makeSmallSP(false, /*stimulusThreshold*/ 2u, /*minPctOverlapDutyCycles*/ 0.001f,
+                                 /*boostStrength*/ 3.0f, /*potentialRadius*/ 5u, /*seed*/ 5);
+  trainSP(sp);
+  FrozenSpatialPooler::share("testShared", std::make_shared<FrozenSpatialPooler>(sp));
+  const auto frozen = FrozenSpatialPooler::shared("testShared");
+  EXPECT_EQ(frozen, FrozenSpatialPooler::shared("testShared")) << "the same instance";
+  EXPECT_GT(frozen->memoryUsage(), frozen->numConnectedSynapses() * sizeof(UInt));
+
+  Random rng(11);
+  vector<SDR> inputs(50u, SDR(sp.getInputDimensions()));
+  vector<SDR> expected(inputs.size(), SDR(sp.getColumnDimensions()));
+  for(size_t i = 0; i < inputs.size(); i++) {
+    inputs[i].randomize(0.1f, rng);
+    sp.compute(inputs[i], false, expected[i]);
+  }
+
+  // Each thread with its own scratch, reused between its calls.
+  vector<int> mismatches(4u, 0);
+  vector<std::thread> threads;
+  for(size_t t = 0; t < mismatches.size(); t++) {
+    threads.emplace_back([&, t]() {
+      FrozenSpatialPooler::Scratch scratch;
+      SDR active(sp.getColumnDimensions());
+      for(int repeat = 0; repeat < 10; repeat++) {
+        for(size_t i = 0; i < inputs.size(); i++) {
+          frozen->compute(inputs[i], active, scratch);
+          mismatches[t] += active != expected[i];
+        }
+      }
+    });
+  }
+  for(auto &thread : threads) thread.join();
+  EXPECT_EQ(vector<int>(mismatches.size(), 0), mismatches);
+
+  ASSERT_TRUE(FrozenSpatialPooler::unshare("testShared"));
+  EXPECT_FALSE(FrozenSpatialPooler::unshare("testShared"));
+  EXPECT_ANY_THROW(FrozenSpatialPooler::shared("testShared"));
+  EXPECT_EQ(0u, FrozenSpatialPooler::sharedNames().size());
+  // The users keep the model.
+  SDR active(sp.getColumnDimensions());
+  frozen->compute(inputs[0], active);
+  EXPECT_EQ(expected[0], active);
+}
+
+} // end namespace
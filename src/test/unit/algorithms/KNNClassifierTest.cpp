@@ -0,0 +1,143 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for KNNClassifier
+ */
+
+#include <sstream>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <htm/algorithms/KNNClassifier.hpp>
+#include <htm/utils/Random.hpp>
+
+using namespace std;
+using namespace htm;
+
+namespace testing {
+
+TEST(KNNClassifierTest, ExampleUsage) {
+  Random rng(42);
+  SDR a({1000u}), b({1000u});
+  a.randomize(0.02f, rng);
+  b.randomize(0.02f, rng);
+
+  KNNClassifier knn;
+  ASSERT_TRUE(knn.infer(a).empty());
+  knn.learn(a, 1u);
+  knn.learn(b, 3u);
+  ASSERT_EQ(knn.numPatterns(), 2u);
+
+  SDR noisyA(a);
+  noisyA.addNoise(0.2f, rng);
+  const PDF pdf = knn.infer(noisyA);
+  ASSERT_EQ(pdf.size(), 4u);
+  ASSERT_EQ(argmax(pdf), 1u);
+  ASSERT_EQ(pdf[1], 1.0);
+
+  // No stored pattern overlaps an empty SDR.
+  ASSERT_EQ(knn.infer(SDR({1000u})), PDF(4u, 0.0));
+  ASSERT_ANY_THROW(knn.learn(SDR({10u}), 0u));
+}
+
+TEST(KNNClassifierTest, Voting) {
+  Random rng(1);
+  SDR proto({1000u});
+  proto.randomize(0.05f, rng);
+
+  // Two close copies of category 0, three farther copies of category 1.
+  KNNClassifier knn(5u);
+  for (UInt i = 0; i < 2u; i++) {
+    SDR s(proto);
+    s.addNoise(0.1f, rng);
+    knn.learn(s, 0u);
+  }
+  for (UInt i = 0; i < 3u; i++) {
+    SDR s(proto);
+    s.addNoise(0.5f, rng);
+    knn.learn(s, 1u);
+  }
+  const PDF pdf = knn.infer(proto);
+  ASSERT_NEAR(pdf[0], 0.4, 1e-9);
+  ASSERT_NEAR(pdf[1], 0.6, 1e-9);
+
+  const auto neighbors = knn.getNeighbors(proto);
+  ASSERT_EQ(neighbors.size(), 5u);
+  ASSERT_EQ(knn.getCategory(neighbors[0].first), 0u) << "the closest first";
+  ASSERT_EQ(knn.getCategory(neighbors[1].first), 0u);
+}
+
+TEST(KNNClassifierTest, BatchAndApproximate) {
+  Random rng(2);
+  const UInt numCategories = 20u;
+  vector<SDR> protos;
+  for (UInt c = 0; c < numCategories; c++) {
+    protos.emplace_back(vector<UInt>{2000u});
+    protos.back().randomize(0.02f, rng);
+  }
+  KNNClassifier exact(3u);
+  KNNClassifier approx(3u, 16u, 2u);
+  for (UInt i = 0; i < 10u; i++) {
+    for (UInt c = 0; c < numCategories; c++) {
+      SDR s(protos[c]);
+      s.addNoise(0.1f, rng);
+      exact.learn(s, c);
+      approx.learn(s, c);
+    }
+  }
+  vector<SDR> tests;
+  for (UInt c = 0; c < numCategories; c++) {
+    tests.push_back(protos[c]);
+    tests.back().addNoise(0.2f, rng);
+  }
+
+  vector<PDF> exactPDFs, approxPDFs;
+  exact.infer(tests, exactPDFs);
+  approx.infer(tests, approxPDFs);
+  ASSERT_EQ(exactPDFs.size(), tests.size());
+  UInt agree = 0u;
+  for (UInt c = 0; c < numCategories; c++) {
+    ASSERT_EQ(exactPDFs[c], exact.infer(tests[c]));
+    ASSERT_EQ(argmax(exactPDFs[c]), c);
+    if (argmax(approxPDFs[c]) == c) agree++;
+  }
+  ASSERT_GE(agree, numCategories - 1u);
+
+  approx.setExact(true);
+  approx.infer(tests, approxPDFs);
+  ASSERT_EQ(approxPDFs, exactPDFs);
+}
+
+TEST(KNNClassifierTest, SaveLoad) {
+  Random rng(3);
+  KNNClassifier knn(2u, 4u, 3u);
+  SDR s({500u});
+  for (UInt i = 0; i < 10u; i++) {
+    s.randomize(0.05f, rng);
+    knn.learn(s, i % 3u);
+  }
+  stringstream ss;
+  knn.save(ss);
+  KNNClassifier loaded;
+  loaded.load(ss);
+  ASSERT_EQ(knn, loaded);
+  ASSERT_EQ(knn.infer(s), loaded.infer(s));
+}
+
+} // end namespace testing
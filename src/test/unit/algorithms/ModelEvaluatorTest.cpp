@@ -0,0 +1,124 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for ModelEvaluator
+ */
+
+#include "gtest/gtest.h"
+#include <htm/algorithms/ModelEvaluator.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+// Noisy copies of 4 prototypes, labeled with the prototype.
+static void makeData(UInt n, Random &rng, const vector<SDR> &prototypes, vector<SDR> &inputs, vector<UInt> &labels) {
+  for(UInt i = 0u; i < n; i++) {
+    const UInt label = i % static_cast<UInt>(prototypes.size());
+    inputs.push_back(prototypes[label]);
+    inputs.back().addNoise(0.1f, rng);
+    labels.push_back(label);
+  }
+}
+
+static SpatialPooler makeSP(Real localAreaDensity) {
+  return SpatialPooler({ 200u }, { 256u }, /*potentialRadius*/ 200u, /*potentialPct*/ 0.5f,
+                       /*globalInhibition*/ true, localAreaDensity);
+}
+
+
+TEST(ModelEvaluatorTest, testParallelSameAsSerial) {
+  Random rng(42);
+  vector<SDR> prototypes(4u, SDR({ 200u }));
+  for(auto &p : prototypes) p.randomize(0.1f, rng);
+  vector<SDR> train, test;
+  vector<UInt> trainLabels, testLabels;
+  makeData(40u, rng, prototypes, train, trainLabels);
+  makeData(20u, rng, prototypes, test, testLabels);
+
+  ModelEvaluator evaluator(3u);
+  evaluator.setTrainingData(train, trainLabels);
+  evaluator.setTestData(test, testLabels);
+  EXPECT_EQ(evaluator.trainingSize(), 40u);
+  EXPECT_EQ(evaluator.testSize(), 20u);
+
+  const vector<Real> densities = { 0.02f, 0.05f, 0.1f, 0.2f };
+  vector<SpatialPooler> parallel, serial;
+  for(const auto density : densities) {
+    parallel.push_back(makeSP(density));
+    serial.push_back(makeSP(density));
+  }
+  vector<ModelEvaluator::Model> models;
+  for(auto &sp : parallel) models.push_back({ &sp, nullptr });
+
+  const auto scores = evaluator.evaluate(models, 2u);
+  ASSERT_EQ(scores.size(), densities.size());
+  for(size_t i = 0u; i < densities.size(); i++) {
+    const auto expected = evaluator.evaluate(ModelEvaluator::Model{ &serial[i], nullptr }, 2u);
+    EXPECT_EQ(scores[i].accuracy, expected.accuracy);
+    EXPECT_EQ(parallel[i], serial[i]);
+    // The prototypes are easy to tell apart.
+    EXPECT_GT(scores[i].accuracy, 0.8f);
+    EXPECT_EQ(scores[i].anomaly, 0.0f);
+  }
+}
+
+
+TEST(ModelEvaluatorTest, testTemporalMemoryAnomaly) {
+  // A repeating sequence of 5 patterns, the TM learns to predict it.
+  Random rng(7);
+  vector<SDR> sequence(5u, SDR({ 64u }));
+  for(auto &s : sequence) s.randomize(0.1f, rng);
+  vector<SDR> train;
+  vector<bool> resets;
+  for(int repeat = 0; repeat < 20; repeat++) {
+    for(size_t i = 0u; i < sequence.size(); i++) {
+      train.push_back(sequence[i]);
+      resets.push_back(i == 0u);
+    }
+  }
+
+  ModelEvaluator evaluator(2u);
+  evaluator.setTrainingData(train, {}, resets);
+  evaluator.setTestData(vector<SDR>(sequence.begin(), sequence.end()), {}, { true, false, false, false, false });
+
+  TemporalMemory tm({ 64u }, 4u, /*activationThreshold*/ 3u, /*initialPermanence*/ 0.5f,
+                    /*connectedPermanence*/ 0.5f, /*minThreshold*/ 2u, /*maxNewSynapseCount*/ 6u);
+  const auto scores = evaluator.evaluate(vector<ModelEvaluator::Model>{ { nullptr, &tm } });
+  ASSERT_EQ(scores.size(), 1u);
+  // Only the first pattern after the reset is unexpected.
+  EXPECT_NEAR(scores[0].anomaly, 1.0f / 5.0f, 0.05f);
+  EXPECT_EQ(scores[0].accuracy, 0.0f);
+}
+
+
+TEST(ModelEvaluatorTest, testErrors) {
+  ModelEvaluator evaluator(2u);
+  EXPECT_ANY_THROW(evaluator.setTrainingData({ SDR({ 10u }) }, { 1u, 2u }));
+  EXPECT_ANY_THROW(evaluator.setTrainingData({ SDR({ 10u }), SDR({ 20u }) }));
+
+  evaluator.setTrainingData({ SDR({ 10u }) });
+  SpatialPooler sp({ 20u }, { 32u });
+  // The input dimensions don't match, the error of the model is re-thrown.
+  EXPECT_ANY_THROW(evaluator.evaluate(vector<ModelEvaluator::Model>{ { &sp, nullptr } }));
+  EXPECT_ANY_THROW(evaluator.evaluate(ModelEvaluator::Model{}));
+}
+
+} // namespace testing
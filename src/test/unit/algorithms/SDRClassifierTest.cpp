@@ -30,7 +30,9 @@
 #include <gtest/gtest.h>
 
 #include <htm/algorithms/SDRClassifier.hpp>
+#include <htm/os/CpuFeatures.hpp>
 #include <htm/utils/Log.hpp>
+#include <htm/utils/Random.hpp>
 
 using namespace std;
 using namespace htm;
@@ -91,6 +93,69 @@ TEST(SDRClassifierTest, ExampleUsagePredictor)
 }
 
 
+TEST(SDRClassifierTest, PredictorHistoryRing)
+{
+  // A long sequence wraps the history many times, with a missing record.
+  Random rng(2);
+  vector<SDR> sequence( 5u, vector<UInt>{ 400u } );
+  for( SDR & inputData : sequence ) {
+      inputData.randomize( 0.05f, rng );
+  }
+  Predictor pred( vector<UInt>{ 1, 3 }, 0.5f );
+  UInt recordNum = 0u;
+  for( UInt rep = 0u; rep < 20u; rep++ ) {
+    for( UInt i = 0u; i < sequence.size(); i++ ) {
+      pred.learn( recordNum, sequence[i], { i } );
+      recordNum += (rep == 10u and i == 2u) ? 2u : 1u; // skip a record
+    }
+  }
+  const Predictions A = pred.infer( sequence[0] );
+  ASSERT_EQ( argmax( A.at(1) ), 1u );
+  ASSERT_EQ( argmax( A.at(3) ), 3u );
+
+  // The same record number again does not add to the history.
+  pred.reset();
+  pred.learn( 100u, sequence[0], { 0u } );
+  pred.learn( 100u, sequence[0], { 0u } );
+  EXPECT_ANY_THROW( pred.learn( 99u, sequence[0], { 0u } ) );
+}
+
+
+TEST(SDRClassifierTest, PredictorThreads)
+{
+  Random rng(9);
+  vector<SDR> sequence( 30u, vector<UInt>{ 300u } );
+  for( SDR & inputData : sequence ) {
+      inputData.randomize( 0.05f, rng );
+  }
+  vector<UInt> steps;
+  for( UInt step = 1u; step <= 8u; step++ ) steps.push_back( step );
+  Predictor serial( steps, 0.2f );
+  Predictor threaded( steps, 0.2f );
+  threaded.setNumThreads( 4u );
+  ASSERT_EQ( threaded.getNumThreads(), 4u );
+  for( UInt rep = 0u; rep < 3u; rep++ ) {
+    for( UInt i = 0u; i < sequence.size(); i++ ) {
+      const UInt recordNum = rep * (UInt)sequence.size() + i;
+      serial.learn(   recordNum, sequence[i], { i % 7u } );
+      threaded.learn( recordNum, sequence[i], { i % 7u } );
+    }
+  }
+
+  // Identical results, and the reused result matches the returned one.
+  Predictions reused;
+  for( const auto &input : sequence ) {
+    const Predictions expected = serial.infer( input );
+    ASSERT_EQ( threaded.infer( input ), expected );
+    threaded.infer( input, reused );
+    ASSERT_EQ( reused, expected );
+  }
+  Predictions otherSteps{ { 100u, PDF{ 1.0 } } };
+  serial.infer( sequence[0], otherSteps );
+  ASSERT_EQ( otherSteps, serial.infer( sequence[0] ) );
+}
+
+
 TEST(SDRClassifierTest, SingleValue) {
   // Feed the same input 10 times, the corresponding probability should be
   // very high
@@ -196,6 +261,139 @@ TEST(SDRClassifierTest, MultipleCategories) {
 }
 
 
+TEST(SDRClassifierTest, GrowingCategories) {
+  // Categories added one at a time must keep the weights learned so far.
+  Classifier c(0.5f);
+  Random rng(3);
+  vector<SDR> inputs( 20u, SDR({ 200u }) );
+  for(auto &input : inputs) input.randomize( 0.05f, rng );
+  for(UInt rep = 0u; rep < 10u; rep++) {
+    for(UInt cat = 0u; cat < inputs.size(); cat++) {
+      c.learn( inputs[cat], { cat * 7u } );
+    }
+  }
+  for(UInt cat = 0u; cat < inputs.size(); cat++) {
+    const PDF result = c.infer( inputs[cat] );
+    ASSERT_EQ( result.size(), (inputs.size() - 1u) * 7u + 1u );
+    ASSERT_EQ( argmax( result ), cat * 7u );
+  }
+}
+
+
+TEST(SDRClassifierTest, SinglePrecision) {
+  Classifier c64(0.1f);
+  Classifier c32(0.1f);
+  c32.setSinglePrecision( true );
+  ASSERT_TRUE( c32.getSinglePrecision() );
+  Random rng(11);
+  SDR A({ 500u }); A.randomize( 0.04f, rng );
+  SDR B({ 500u }); B.randomize( 0.04f, rng );
+  for(UInt i = 0u; i < 50u; i++) {
+    c64.learn( A, { 1u } );
+    c32.learn( A, { 1u } );
+    c64.learn( B, { 0u, 4u } );
+    c32.learn( B, { 0u, 4u } );
+  }
+  const PDF a64 = c64.infer( A );
+  const PDF a32 = c32.infer( A );
+  ASSERT_EQ( a64.size(), a32.size() );
+  for(size_t i = 0u; i < a64.size(); i++) {
+    EXPECT_NEAR( a64[i], a32[i], 0.0001 );
+  }
+  ASSERT_EQ( argmax( a32 ), 1u );
+
+  // Switching back to Real64 keeps the (rounded) weights.
+  c32.setSinglePrecision( false );
+  ASSERT_EQ( c32.infer( A ), a32 );
+}
+
+
+TEST(SDRClassifierTest, SparseUpdate) {
+  Random rng(5);
+  SDR A({ 300u }); A.randomize( 0.05f, rng );
+  SDR B({ 300u }); B.randomize( 0.05f, rng );
+
+  // Errors are at most 1, this threshold only allows the full updates.
+  Classifier c(0.1f);
+  c.setSparseUpdate( 2.0, 3u );
+  c.learn( A, { 2u } ); // full update
+  const PDF first = c.infer( A );
+  c.learn( A, { 2u } );
+  c.learn( A, { 2u } );
+  ASSERT_EQ( c.infer( A ), first );
+  c.learn( A, { 2u } ); // full update
+  ASSERT_NE( c.infer( A ), first );
+
+  // Still learns with a realistic threshold.
+  Classifier sparse(0.1f);
+  sparse.setSparseUpdate( 0.001, 20u );
+  for(UInt i = 0u; i < 200u; i++) {
+    sparse.learn( A, { 1u } );
+    sparse.learn( B, { 6u } );
+  }
+  ASSERT_EQ( argmax( sparse.infer( A ) ), 1u );
+  ASSERT_EQ( argmax( sparse.infer( B ) ), 6u );
+
+  EXPECT_ANY_THROW( sparse.setSparseUpdate( -1.0 ) );
+  EXPECT_ANY_THROW( sparse.setSparseUpdate( 0.1, 0u ) );
+}
+
+
+TEST(SDRClassifierTest, SparseRows) {
+  // Only the input bits which were ever active have weights.
+  Random rng(7);
+  SDR A({ 1u << 16u }); A.randomize( 0.001f, rng );
+  SDR B({ 1u << 16u }); B.randomize( 0.001f, rng );
+  Classifier c(0.1f);
+  for(UInt i = 0u; i < 10u; i++) {
+    c.learn( A, { 1u } );
+    c.learn( B, { 4999u } );
+  }
+  ASSERT_EQ( argmax( c.infer( A ) ), 1u );
+  ASSERT_EQ( argmax( c.infer( B ) ), 4999u );
+  const size_t denseBytes = A.size * 5000u * sizeof(Real64);
+  ASSERT_LT( c.memoryUsage(), denseBytes / 100u );
+
+  // Bits which were never active add nothing.
+  SDR C({ A.size });
+  C.setSparse( SDR_sparse_t{ 0u, 1u, 2u } );
+  SDR AC({ A.size });
+  AC.set_union( A, C );
+  ASSERT_EQ( c.infer( AC ), c.infer( A ) );
+
+  // Switches to a row per bit once most bits are active, keeping the weights.
+  Classifier d(0.1f);
+  SDR D({ 40u });
+  for(UInt i = 0u; i < 40u; i++) {
+    D.setSparse( SDR_sparse_t{ i } );
+    d.learn( D, { i % 2u } );
+  }
+  for(UInt i = 0u; i < 40u; i++) {
+    D.setSparse( SDR_sparse_t{ i } );
+    ASSERT_EQ( argmax( d.infer( D ) ), i % 2u );
+  }
+}
+
+
+TEST(SDRClassifierTest, SimdLevels) {
+  // Every variant of the kernels gives the same result.
+  Random rng(11);
+  SDR A({ 1000u }); A.randomize( 0.05f, rng );
+  Classifier c(0.1f);
+  for(UInt i = 0u; i < 10u; i++) {
+    SDR B({ A.size }); B.randomize( 0.05f, rng );
+    c.learn( A, { 1u } );
+    c.learn( B, { 2u + i } );
+  }
+  const PDF expected = c.infer( A );
+  for(const auto level : { SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512 }) {
+    CpuFeatures::setLevel( level );
+    EXPECT_EQ( c.infer( A ), expected ) << CpuFeatures::name( level );
+  }
+  CpuFeatures::resetLevel();
+}
+
+
 TEST(SDRClassifierTest, SaveLoad) {
   vector<UInt> steps{ 1u };
   Predictor c1(steps, 0.1f);
@@ -225,6 +423,21 @@ TEST(SDRClassifierTest, SaveLoad) {
 }
 
 
+TEST(SDRClassifierTest, CopyPartialHistory) {
+  Predictor c1({ 1u, 5u }, 0.1f);
+  SDR A({ 100u }); A.randomize( 0.10f );
+  Predictor empty(c1); // the history is empty
+  c1.learn(0u, A, {2u});
+  c1.learn(1u, A, {2u});
+  Predictor c2(c1);    // 2 of the 6 slots are used
+  A.addNoise( 0.5f );
+  c1.learn(2u, A, {3u});
+  c2.learn(2u, A, {3u});
+  ASSERT_EQ(c1.infer( A ), c2.infer( A ));
+  empty.learn(0u, A, {1u});
+}
+
+
 TEST(SDRClassifierTest, testSoftmaxOverflow) {
   PDF values({ numeric_limits<Real>::max() });
   softmax(values.begin(), values.end());
@@ -0,0 +1,148 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for ShardedConnections
+ */
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <sstream>
+#include <htm/algorithms/ShardedConnections.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+// Builds the same random connections in a ShardedConnections and a Connections.
+void setupRandom(ShardedConnections &sharded, Connections &plain, Random &rng) {
+  for(CellIdx cell = 0; cell < plain.numCells(); cell++) {
+    for(int s = 0; s < 2; s++) {
+      const Segment seg1 = sharded.createSegment(cell);
+      const Segment seg2 = plain.createSegment(cell);
+      for(int i = 0; i < 15; i++) {
+        const CellIdx presyn = rng.getUInt32(200);
+        const Permanence perm = (Permanence)rng.getReal64();
+        sharded.createSynapse(seg1, presyn, perm);
+        plain.createSynapse(seg2, presyn, perm);
+      }
+    }
+  }
+}
+
+// Compares the activity by (cell, index of segment on the cell).
+void expectSameActivity(const ShardedConnections &sharded, const vector<SynapseIdx> &a,
+                        const Connections &plain, const vector<SynapseIdx> &b) {
+  ASSERT_EQ(a.size(), sharded.segmentFlatListLength());
+  for(CellIdx cell = 0; cell < plain.numCells(); cell++) {
+    const auto segs1 = sharded.segmentsForCell(cell);
+    const auto &segs2 = plain.segmentsForCell(cell);
+    ASSERT_EQ(segs1.size(), segs2.size());
+    for(size_t i = 0; i < segs1.size(); i++) {
+      ASSERT_EQ(cell, sharded.cellForSegment(segs1[i]));
+      ASSERT_EQ(a[segs1[i]], b[segs2[i]]) << "cell " << cell << " segment " << i;
+    }
+  }
+}
+
+
+TEST(ShardedConnectionsTest, testPartition) {
+  ShardedConnections sc(10u, 3u);
+  EXPECT_EQ(3u, sc.numShards());
+  EXPECT_EQ(10u, sc.numCells());
+  EXPECT_EQ(0u, sc.shardForCell(0));
+  EXPECT_EQ(0u, sc.shardForCell(3));
+  EXPECT_EQ(1u, sc.shardForCell(4));
+  EXPECT_EQ(2u, sc.shardForCell(9));
+  EXPECT_EQ(4u, sc.shard(0).numCells());
+  EXPECT_EQ(2u, sc.shard(2).numCells());
+
+  EXPECT_ANY_THROW(ShardedConnections(10u, 0u));
+  EXPECT_ANY_THROW(sc.createSegment(10u));
+
+  const Segment seg = sc.createSegment(9u);
+  EXPECT_EQ(9u, sc.cellForSegment(seg));
+  const Synapse syn = sc.createSynapse(seg, 42u, 0.6f);
+  EXPECT_EQ(seg, sc.segmentForSynapse(syn));
+  EXPECT_EQ(42u, sc.presynapticCellForSynapse(syn));
+  // the permanences are quantized in builds with NTA_PERMANENCE_BITS 16 or 8
+  const Permanence epsilon = std::max(htm::Epsilon, PermanenceCodec<PermanenceStorage>::step());
+  EXPECT_NEAR(0.6f, sc.permanenceForSynapse(syn), epsilon);
+  sc.updateSynapsePermanence(syn, 0.2f);
+  EXPECT_NEAR(0.2f, sc.permanenceForSynapse(syn), epsilon);
+  EXPECT_EQ(1u, sc.numSynapses());
+  sc.destroySynapse(syn);
+  EXPECT_EQ(0u, sc.numSynapses());
+  sc.destroySegment(seg);
+  EXPECT_EQ(0u, sc.numSegments());
+}
+
+
+TEST(ShardedConnectionsTest, testComputeActivity) {
+  for(const UInt threads : {1u, 3u}) {
+    ShardedConnections sharded(300u, 3u);
+    sharded.setNumThreads(threads);
+    Connections plain(300u);
+    Random rng(42);
+    setupRandom(sharded, plain, rng);
+    EXPECT_EQ(plain.numSegments(), sharded.numSegments());
+    EXPECT_EQ(plain.numSynapses(), sharded.numSynapses());
+
+    SDR input({200u});
+    for(int iter = 0; iter < 5; iter++) {
+      input.randomize(0.1f, rng);
+      vector<SynapseIdx> pot1(sharded.segmentFlatListLength(), 0u);
+      vector<SynapseIdx> pot2(plain.segmentFlatListLength(), 0u);
+      const auto con1 = sharded.computeActivity(pot1, input.getSparse());
+      const auto con2 = plain.computeActivity(pot2, input.getSparse());
+      expectSameActivity(sharded, con1, plain, con2);
+      expectSameActivity(sharded, pot1, plain, pot2);
+
+      // learn on every other segment
+      vector<Segment> learn1, learn2;
+      for(CellIdx cell = 0; cell < 300u; cell += 2) {
+        learn1.push_back(sharded.segmentsForCell(cell)[0]);
+        learn2.push_back(plain.segmentsForCell(cell)[0]);
+      }
+      sharded.adaptSegments(learn1, input, 0.1f, 0.05f, true, 2u);
+      plain.adaptSegments(learn2, input, 0.1f, 0.05f, true, 2u);
+      ASSERT_EQ(plain.numSynapses(), sharded.numSynapses());
+
+      const auto c1 = sharded.computeActivity(input.getSparse());
+      const auto c2 = plain.computeActivity(input.getSparse());
+      expectSameActivity(sharded, c1, plain, c2);
+    }
+  }
+}
+
+
+TEST(ShardedConnectionsTest, testSaveLoad) {
+  ShardedConnections sc1(100u, 4u), sc2;
+  Connections plain(100u);
+  Random rng(1);
+  setupRandom(sc1, plain, rng);
+
+  stringstream ss;
+  sc1.save(ss);
+  sc2.load(ss);
+  EXPECT_EQ(sc1, sc2);
+  EXPECT_EQ(4u, sc2.numShards());
+}
+
+} // namespace testing
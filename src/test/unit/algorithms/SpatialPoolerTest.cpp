@@ -20,6 +20,7 @@
  */
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <fstream>
 #include <stdio.h>
@@ -29,8 +30,11 @@
 #include <htm/algorithms/SpatialPooler.hpp>
 
 #include <htm/types/Types.hpp>
+#include <htm/utils/Topology.hpp>
+#include <htm/utils/VectorHelpers.hpp>
 #include <htm/utils/Log.hpp>
 #include <htm/os/Timer.hpp>
+#include "SpatialPoolerTestUtilities.hpp"
 
 namespace testing {
 
@@ -79,6 +83,18 @@ bool check_vector_eq(Real arr[], vector<Real> vec) {
   return true;
 }
 
+// Compares permanences, which are quantized in builds with
+// NTA_PERMANENCE_BITS 16 or 8.
+bool check_permanences_eq(Real arr[], const vector<Real> &vec) {
+  const Real tolerance = std::max(1e-5f, PermanenceCodec<PermanenceStorage>::step());
+  for (UInt i = 0; i < vec.size(); i++) {
+    if (std::abs(arr[i] - vec[i]) > tolerance) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool check_vector_eq(UInt arr1[], UInt arr2[], UInt n) {
   for (UInt i = 0; i < n; i++) {
     if (arr1[i] != arr2[i]) {
@@ -830,7 +846,7 @@ TEST(SpatialPoolerTest, testAdaptSynapses) {
   sp.adaptSynapses_(input1, activeColumns);
   for (UInt column = 0; column < numColumns; column++) {
     const auto& permArr = sp.getPermanence(column);
-    ASSERT_TRUE(check_vector_eq(truePermanences1[column], permArr));
+    ASSERT_TRUE(check_permanences_eq(truePermanences1[column], permArr));
   }
 
   UInt potentialArr2[4][8] = {{1, 1, 1, 0, 0, 0, 0, 0},
@@ -868,7 +884,7 @@ TEST(SpatialPoolerTest, testAdaptSynapses) {
   sp.adaptSynapses_(input2, activeColumns);
   for (UInt column = 0; column < numColumns; column++) {
     const auto& permArr = sp.getPermanence(column);
-    ASSERT_TRUE(check_vector_eq(truePermanences2[column], permArr));
+    ASSERT_TRUE(check_permanences_eq(truePermanences2[column], permArr));
   }
 }
 
@@ -918,8 +934,7 @@ TEST(SpatialPoolerTest, testBumpUpWeakColumns) {
 
   for (UInt i = 0; i < numColumns; i++) {
     const auto& perm = sp.getPermanence(i);
-    for(UInt z = 0; z < numInputs; z++)
-      ASSERT_FLOAT_EQ( truePermArr[i][z], perm[z] );
+    ASSERT_TRUE(check_permanences_eq(truePermArr[i], perm));
   }
 }
 
@@ -1019,6 +1034,51 @@ TEST(SpatialPoolerTest, testUpdateBoostFactors) {
   sp.getBoostFactors(resultBoostFactors4.data());
 
   ASSERT_TRUE(check_vector_eq(trueBoostFactors3, resultBoostFactors3));
+
+  // disabled boosting resets the factors
+  sp.setBoostStrength(0.0f);
+  sp.updateBoostFactors_();
+  sp.getBoostFactors(resultBoostFactors4.data());
+  ASSERT_TRUE(check_vector_eq(trueBoostFactors1, resultBoostFactors4));
+}
+
+
+/**
+ * Local boosting uses the cached neighborhoods of the inhibition, the boost
+ * factors must be exactly those from enumerating the neighborhoods.
+ */
+TEST(SpatialPoolerTest, testUpdateBoostFactorsLocalCachedNeighbors) {
+  SpatialPooler sp({12, 10}, {12, 10}, /*potentialRadius*/ 3, /*potentialPct*/ 0.5f,
+                   /*globalInhibition*/ false, /*localAreaDensity*/ 0.1f);
+  sp.setBoostStrength(3.0f);
+  const vector<UInt> dims = sp.getColumnDimensions();
+  const UInt numColumns = sp.getNumColumns();
+  Random rng(11);
+  vector<Real> dutyCycles(numColumns);
+  vector<Real> boost(numColumns);
+
+  for (const UInt radius : {1u, 4u, 1u}) {
+    for (const bool wrap : {false, true}) {
+      for (auto &dc : dutyCycles) dc = (Real)rng.getReal64() * 0.2f;
+      sp.setActiveDutyCycles(dutyCycles.data());
+      sp.setInhibitionRadius(radius);
+      sp.setWrapAround(wrap);
+      sp.updateBoostFactors_();
+      sp.getBoostFactors(boost.data());
+
+      for (UInt column = 0; column < numColumns; column++) {
+        Real density = 0.0f;
+        UInt num = 0;
+        if (wrap) {
+          for (const auto n : WrappingNeighborhood(column, radius, dims)) { density += dutyCycles[n]; num++; }
+        } else {
+          for (const auto n : Neighborhood(column, radius, dims)) { density += dutyCycles[n]; num++; }
+        }
+        ASSERT_EQ(exp((density / num - dutyCycles[column]) * 3.0f), boost[column])
+            << "radius " << radius << " wrapAround " << wrap << " column " << column;
+      }
+    }
+  }
 }
 
 
@@ -1187,6 +1247,45 @@ TEST(SpatialPoolerTest, testInhibitColumnsGlobal) {
 }
 
 
+/**
+ * Integer overlaps take the counting select path of the global inhibition,
+ * which must pick the same columns in the same order as sorting by
+ * (overlap, index), both decreasing.
+ */
+TEST(SpatialPoolerTest, testInhibitColumnsGlobalCountingSelect) {
+  SpatialPooler sp;
+  const UInt numColumns = 500;
+  setup(sp, 20, numColumns);
+  sp.setStimulusThreshold(2);
+
+  const auto reference = [&](const vector<Real> &overlaps, Real density) {
+    vector<UInt> order(numColumns);
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](UInt a, UInt b) {
+      return overlaps[a] == overlaps[b] ? a > b : overlaps[a] > overlaps[b]; });
+    order.resize((UInt)(density * numColumns));
+    while(!order.empty() && overlaps[order.back()] < 2) order.pop_back();
+    return order;
+  };
+
+  Random rng(7);
+  vector<Real> overlaps(numColumns);
+  vector<UInt> active;
+  for(const Real density : {0.002f, 0.02f, 0.1f, 0.5f, 1.0f}) {
+    for(const UInt maxOverlap : {1u, 4u, 30u}) {
+      for(auto &o : overlaps) o = (Real)rng.getUInt32(maxOverlap + 1); // many ties
+      sp.inhibitColumnsGlobal_(overlaps, density, active);
+      ASSERT_EQ(reference(overlaps, density), active) << density << " " << maxOverlap;
+    }
+  }
+  // boosted overlaps take the sorting path, same result
+  for(auto &o : overlaps) o = (Real)rng.getUInt32(10) + 0.5f;
+  overlaps[3] = 7.0f;
+  sp.inhibitColumnsGlobal_(overlaps, 0.1f, active);
+  ASSERT_EQ(reference(overlaps, 0.1f), active);
+}
+
+
 TEST(SpatialPoolerTest, testValidateGlobalInhibitionParameters) {
   // With 10 columns the minimum sparsity for global inhibition is 10%
   // Setting sparsity to 2% should throw an exception
@@ -1352,6 +1451,65 @@ TEST(SpatialPoolerTest, testInhibitColumnsLocal) {
   }
 }
 
+/**
+ * inhibitColumnsLocal_ caches the neighborhoods per inhibition radius and
+ * wrapAround. Compare against enumerating the neighborhoods directly, also
+ * when the radius and wrapAround change between calls.
+ */
+TEST(SpatialPoolerTest, testInhibitColumnsLocalCachedNeighbors) {
+  SpatialPooler sp({12, 10}, {12, 10}, /*potentialRadius*/ 3, /*potentialPct*/ 0.5f,
+                   /*globalInhibition*/ false, /*localAreaDensity*/ 0.1f);
+  const UInt stimulusThreshold = 1;
+  sp.setStimulusThreshold(stimulusThreshold);
+  const vector<UInt> dims = sp.getColumnDimensions();
+  const UInt numColumns = sp.getNumColumns();
+
+  const auto reference = [&](const vector<Real> &overlaps, Real density, UInt radius, bool wrap) {
+    vector<UInt> active;
+    vector<bool> activeDense(numColumns, false);
+    for (UInt column = 0; column < numColumns; column++) {
+      if (overlaps[column] < stimulusThreshold) continue;
+      vector<UInt> neighbors;
+      if (wrap) {
+        for (const auto n : WrappingNeighborhood(column, radius, dims)) if (n != column) neighbors.push_back(n);
+      } else {
+        for (const auto n : Neighborhood(column, radius, dims)) if (n != column) neighbors.push_back(n);
+      }
+      UInt numNeighbors = (UInt)neighbors.size();
+      if (wrap) {
+        numNeighbors = 1;
+        for (const auto dim : dims) numNeighbors *= std::min(2 * radius + 1, dim);
+        numNeighbors -= 1;
+      }
+      UInt numBigger = 0;
+      for (const auto n : neighbors) {
+        if (overlaps[n] > overlaps[column] || (overlaps[n] == overlaps[column] && activeDense[n])) numBigger++;
+      }
+      if (numBigger < (UInt)(0.5f + density * (numNeighbors + 1))) {
+        active.push_back(column);
+        activeDense[column] = true;
+      }
+    }
+    return active;
+  };
+
+  Random rng(42);
+  vector<Real> overlaps(numColumns);
+  vector<UInt> active;
+  for (const UInt radius : {1u, 3u, 1u, 7u, 2u}) {
+    for (const bool wrap : {false, true, false}) {
+      for (auto &o : overlaps) o = (Real)rng.getUInt32(6); // many ties
+      const Real density = 0.2f;
+      sp.setInhibitionRadius(radius);
+      sp.setWrapAround(wrap);
+      sp.inhibitColumnsLocal_(overlaps, density, active);
+      ASSERT_EQ(reference(overlaps, density, radius, wrap), active)
+          << "radius " << radius << " wrapAround " << wrap;
+    }
+  }
+}
+
+
 TEST(SpatialPoolerTest, testIsUpdateRound) {
   SpatialPooler sp;
   sp.setUpdatePeriod(50);
@@ -1420,7 +1578,7 @@ TEST(SpatialPoolerTest, testSetPermanence) {
     const auto& connectedArr = sp.getPermanence(i, sp.connections.getConnectedThreshold());
     sp.getConnectedCounts(connectedCountsArr);
     
-    ASSERT_TRUE(check_vector_eq(truePerm[i], permArr));
+    ASSERT_TRUE(check_permanences_eq(truePerm[i], permArr));
     ASSERT_EQ(trueConnectedCount[i], connectedCountsArr[i]);
     for(UInt j=0; j < numInputs; j++) {
       if(trueConnectedSynapses[i][j] == 0) ASSERT_EQ(connectedArr[j], 0.0f);
@@ -1657,6 +1815,30 @@ TEST(SpatialPoolerTest, testinitMapPotential2D) {
 }
 
 
+/**
+ * initialize creates the synapses from the sparse potential pools, which
+ * must be the dense masks of initMapPotential_ (same random numbers).
+ */
+TEST(SpatialPoolerTest, testInitPotentialPool) {
+  for(const bool wrap : {false, true}) {
+    SpatialPooler dense, sparse;
+    setup(dense,  {6, 12}, {2, 4});
+    setup(sparse, {6, 12}, {2, 4});
+    for(auto sp : {&dense, &sparse}) {
+      sp->setPotentialRadius(7); //larger than the input, wrapping repeats inputs
+      sp->setPotentialPct(0.5f);
+    }
+    const NeighborhoodTable inputNeighborhood(7u, {6u, 12u}, wrap);
+    for(UInt column = 0; column < 8u; column++) {
+      const auto mask = dense.initMapPotential_(column, wrap);
+      const auto pool = sparse.initPotentialPool_(column, inputNeighborhood);
+      ASSERT_TRUE(std::is_sorted(pool.begin(), pool.end()));
+      ASSERT_EQ(VectorHelpers::sparseToBinary<UInt>(pool, 72u), mask);
+    }
+  }
+}
+
+
 TEST(SpatialPoolerTest, getOverlaps) {
   SpatialPooler sp;
   const vector<UInt> inputDim = {5};
@@ -1933,6 +2115,68 @@ TEST(SpatialPoolerTest, testSaveLoad_ar) {
 
 
 
+TEST(SpatialPoolerTest, testSaveLoadFlat) {
+  const char *filename = "SpatialPoolerFlat.tmp";
+  SpatialPooler sp1({100u}, {200u}), sp2;
+  Random rng(42);
+  SDR input({100u});
+  SDR out1({200u}), out2({200u});
+  for (int i = 0; i < 20; i++) {
+    input.randomize(0.1f, rng);
+    sp1.compute(input, true, out1);
+  }
+
+  sp1.saveFlat(filename);
+  sp2.loadFlat(filename);
+  check_spatial_eq(sp1, sp2);
+  ASSERT_EQ(sp1, sp2);
+
+  // Both continue the same.
+  for (int i = 0; i < 10; i++) {
+    input.randomize(0.1f, rng);
+    sp1.compute(input, true, out1);
+    sp2.compute(input, true, out2);
+    ASSERT_EQ(out1, out2);
+  }
+
+  // A Connections flat file is not a SpatialPooler flat file.
+  sp1.getConnections().saveFlat(filename);
+  EXPECT_ANY_THROW(sp2.loadFlat(filename));
+
+  int ret = ::remove(filename);
+  ASSERT_TRUE(ret == 0) << "Failed to delete " << filename;
+}
+
+TEST(SpatialPoolerTest, testSaveLoadFlatBuffer) {
+  SpatialPooler sp1({100u}, {200u}), sp2;
+  Random rng(42);
+  SDR input({100u});
+  SDR out1({200u}), out2({200u});
+  for (int i = 0; i < 20; i++) {
+    input.randomize(0.1f, rng);
+    sp1.compute(input, true, out1);
+  }
+
+  std::vector<char> buffer;
+  FlatWriter out(buffer, "HTMSPOOL", SpatialPooler::FLAT_VERSION);
+  sp1.saveFlat(out);
+  out.close();
+  FlatReader in(buffer.data(), buffer.size(), "HTMSPOOL", SpatialPooler::FLAT_VERSION);
+  sp2.loadFlat(in);
+  ASSERT_EQ(sp1, sp2);
+  input.randomize(0.1f, rng);
+  sp1.compute(input, true, out1);
+  sp2.compute(input, true, out2);
+  ASSERT_EQ(out1, out2);
+
+  // Truncated, or of another tag.
+  EXPECT_ANY_THROW(FlatReader(buffer.data(), 8u, "HTMSPOOL", SpatialPooler::FLAT_VERSION));
+  EXPECT_ANY_THROW(FlatReader(buffer.data(), buffer.size(), "HTMCONNS", SpatialPooler::FLAT_VERSION));
+  FlatReader truncated(buffer.data(), buffer.size() / 2u, "HTMSPOOL", SpatialPooler::FLAT_VERSION);
+  EXPECT_ANY_THROW(sp2.loadFlat(truncated));
+}
+
+
 TEST(SpatialPoolerTest, testSerialization_ar) {
   Random random(10);
 
@@ -2097,7 +2341,8 @@ TEST(SpatialPoolerTest, ExactOutput) {
     sp.compute(inputs, true, columns);
   }
 
-#if defined __aarch64__ || defined __arm__
+// The gold outputs are those of float permanences, @see NTA_PERMANENCE_BITS
+#if defined __aarch64__ || defined __arm__ || (defined NTA_PERMANENCE_BITS && NTA_PERMANENCE_BITS != 32)
 #undef _ARCH_DETERMINISTIC
 #else
 #define _ARCH_DETERMINISTIC
@@ -2109,4 +2354,399 @@ TEST(SpatialPoolerTest, ExactOutput) {
 }
 
 
+TEST(SpatialPoolerTest, testParallelOverlaps) {
+  SDR inputs({ 20, 20 });
+  SDR columns({ 16, 16 });
+  SDR columnsParallel({ 16, 16 });
+  const auto makeSP = []() {
+    return makeSmallSP(/*globalInhibition*/ true, /*stimulusThreshold*/ 3u,
+                       /*minPctOverlapDutyCycles*/ 0.001f, /*boostStrength*/ 10.0f);
+  };
+  SpatialPooler serial = makeSP();
+  SpatialPooler parallel = makeSP();
+  parallel.setNumThreads(4);
+  ASSERT_EQ(4u, parallel.getNumThreads());
+
+  for(UInt i = 0; i < 200; i++) {
+    Random rng(i + 1);
+    inputs.randomize( 0.3f, rng ); //enough active bits to be split across the threads
+    const bool learn = i % 4 != 3;
+    const auto overlaps = serial.compute(inputs, learn, columns);
+    ASSERT_EQ(overlaps, parallel.compute(inputs, learn, columnsParallel));
+    ASSERT_EQ(columns, columnsParallel);
+    ASSERT_EQ(serial.getBoostedOverlaps(), parallel.getBoostedOverlaps());
+  }
+  ASSERT_EQ(serial, parallel);
+}
+
+
+/**
+ * Batch inference must give the same results as sequential learn=false calls.
+ */
+TEST(SpatialPoolerTest, testComputeBatch) {
+  for(const bool global : {true, false}) {
+    const auto makeSP = [&]() {
+      return makeSmallSP(global, /*stimulusThreshold*/ 1u,
+                         /*minPctOverlapDutyCycles*/ 0.001f, /*boostStrength*/ 2.0f);
+    };
+    SDR input({20, 20});
+    SDR columns({16, 16});
+
+    Random rng(4);
+    vector<SDR> inputs(5000, input); //more than one chunk of the batch, 4096 inputs of 256 columns
+    for(auto &in : inputs) in.randomize(0.1f, rng);
+    SpatialPooler sequential = makeSP();
+    trainSP(sequential); //learn, so boosting and permanences differ
+    vector<SDR> expected;
+    for(const auto &in : inputs) {
+      sequential.compute(in, false, columns);
+      expected.push_back(columns);
+    }
+
+    for(const UInt threads : {1u, 4u}) {
+      SpatialPooler batch = makeSP();
+      trainSP(batch);
+      batch.setNumThreads(threads);
+      vector<SDR> outputs;
+      batch.compute(inputs, outputs);
+      ASSERT_EQ(expected, outputs) << "global " << global << " threads " << threads;
+      ASSERT_EQ(sequential.getIterationNum(), batch.getIterationNum());
+      ASSERT_EQ(sequential.getBoostedOverlaps(), batch.getBoostedOverlaps());
+      ASSERT_EQ(sequential, batch);
+    }
+  }
+}
+
+
+TEST(SpatialPoolerTest, testComputeDenseInputPacked) {
+  for(const bool global : {true, false}) {
+    SpatialPooler sp = makeSmallSP(global, /*stimulusThreshold*/ 1u,
+                                   /*minPctOverlapDutyCycles*/ 0.001f, /*boostStrength*/ 2.0f,
+                                   /*potentialRadius*/ 20u);
+    SDR input({20, 20});
+    SDR columns({16, 16});
+    vector<SDR> outputs;
+    Random rng(5);
+    for(int i = 0; i < 20; i++) {
+      input.randomize(0.5f, rng);
+      // dense input, the bit-packed overlaps
+      const auto overlaps = sp.compute(input, false, columns);
+
+      const auto &dense = input.getDense();
+      for(UInt column = 0; column < sp.getNumColumns(); column++) {
+        const auto permanences = sp.getPermanence(column, sp.connections.getConnectedThreshold());
+        UInt expected = 0u;
+        for(UInt i = 0; i < sp.getNumInputs(); i++) {
+          expected += permanences[i] > 0.0f and dense[i];
+        }
+        ASSERT_EQ(expected, overlaps[column]) << "global " << global << " column " << column;
+      }
+      // the batch compute iterates the presynaptic maps
+      sp.compute({input}, outputs);
+      ASSERT_EQ(outputs[0], columns) << "global " << global;
+
+      // learning changes the synapses, the bitsets must follow
+      sp.compute(input, true, columns);
+    }
+  }
+}
+
+
+TEST(SpatialPoolerTest, testLazyDutyCycles) {
+  for(const bool global : {true, false}) {
+    const auto makeSP = [&]() {
+      return makeSmallSP(global, /*stimulusThreshold*/ 1u,
+                         /*minPctOverlapDutyCycles*/ 0.1f, /*boostStrength*/ 0.0f);
+    };
+    SpatialPooler eager = makeSP();
+    SpatialPooler lazy  = makeSP();
+    lazy.setLazyDutyCycles(true);
+    ASSERT_TRUE(lazy.getLazyDutyCycles());
+
+    SDR input({20, 20});
+    SDR eagerColumns({16, 16});
+    SDR lazyColumns({16, 16});
+    vector<Real> eagerDC(eager.getNumColumns());
+    vector<Real> lazyDC(lazy.getNumColumns());
+    Random rng(7);
+    for(int i = 0; i < 200; i++) {
+      input.randomize(0.05f, rng);
+      eager.compute(input, true, eagerColumns);
+      lazy.compute(input, true, lazyColumns);
+      ASSERT_EQ(eagerColumns, lazyColumns) << "global " << global << " iteration " << i;
+    }
+
+    eager.getOverlapDutyCycles(eagerDC.data());
+    lazy.getOverlapDutyCycles(lazyDC.data());
+    for(UInt i = 0; i < eager.getNumColumns(); i++) {
+      ASSERT_NEAR(eagerDC[i], lazyDC[i], 1e-5f);
+    }
+    eager.getActiveDutyCycles(eagerDC.data());
+    lazy.getActiveDutyCycles(lazyDC.data());
+    for(UInt i = 0; i < eager.getNumColumns(); i++) {
+      ASSERT_NEAR(eagerDC[i], lazyDC[i], 1e-5f);
+    }
+
+    // back to the eager bookkeeping, with up to date duty cycles
+    lazy.setLazyDutyCycles(false);
+    vector<Real> stillDC(lazy.getNumColumns());
+    lazy.getActiveDutyCycles(stillDC.data());
+    ASSERT_EQ(lazyDC, stillDC);
+  }
+}
+
+
+TEST(SpatialPoolerTest, testIncrementalInhibition) {
+  for(const UInt stimulusThreshold : {0u, 2u}) {
+    const auto makeSP = [&]() {
+      return makeSmallSP(/*globalInhibition*/ true, stimulusThreshold,
+                         /*minPctOverlapDutyCycles*/ 0.001f, /*boostStrength*/ 0.0f);
+    };
+    SpatialPooler full = makeSP();
+    SpatialPooler incremental = makeSP();
+    incremental.setIncrementalInhibition(true);
+    ASSERT_TRUE(incremental.getIncrementalInhibition());
+    ASSERT_TRUE(incremental.connections.getIncrementalActivity());
+
+    SDR input({20, 20});
+    SDR fullColumns({16, 16});
+    SDR incrementalColumns({16, 16});
+    Random rng(11);
+    input.randomize(0.05f, rng);
+    for(int i = 0; i < 100; i++) {
+      input.addNoise(0.1f, rng); //slowly changing input
+      const bool learn = i % 10 == 9;
+      full.compute(input, learn, fullColumns);
+      incremental.compute(input, learn, incrementalColumns);
+      ASSERT_EQ(fullColumns, incrementalColumns) << "threshold " << stimulusThreshold << " iteration " << i;
+    }
+  }
+}
+
+
+TEST(SpatialPoolerTest, testFixedPointBoosting) {
+  for(const UInt stimulusThreshold : {0u, 3u}) {
+    SpatialPooler sp({20, 20}, {16, 16}, /*potentialRadius*/ 5, /*potentialPct*/ 0.5f,
+                     /*globalInhibition*/ true, /*localAreaDensity*/ 0.1f, /*numActiveColumnsPerInhArea*/ 0,
+                     stimulusThreshold, /*synPermInactiveDec*/ 0.01f, /*synPermActiveInc*/ 0.1f,
+                     /*synPermConnected*/ 0.1f, /*minPctOverlapDutyCycles*/ 0.001f,
+                     /*dutyCyclePeriod*/ 50, /*boostStrength*/ 3.0f);
+    sp.setFixedPointBoosting(true);
+    ASSERT_TRUE(sp.getFixedPointBoosting());
+
+    SDR input({20, 20});
+    SDR columns({16, 16});
+    vector<SDR> outputs;
+    vector<Real> boostFactors(sp.getNumColumns());
+    Random rng(13);
+    for(int i = 0; i < 60; i++) {
+      input.randomize(0.05f, rng);
+      const bool learn = i < 40;
+      const auto overlaps = sp.compute(input, learn, columns);
+      if( learn ) continue;
+
+      // The boosted overlaps are the quantized products.
+      sp.getBoostFactors(boostFactors.data());
+      const Real maxFactor = *std::max_element(boostFactors.begin(), boostFactors.end());
+      const auto &boosted = sp.getBoostedOverlaps();
+      for(UInt c = 0; c < sp.getNumColumns(); c++) {
+        ASSERT_NEAR(overlaps[c] * boostFactors[c], boosted[c], overlaps[c] * maxFactor / 65535.0f + 1e-4f);
+      }
+
+      // The winners are the top of the boosted overlaps, ties to the higher index.
+      vector<UInt> expected(sp.getNumColumns());
+      std::iota(expected.begin(), expected.end(), 0u);
+      std::sort(expected.begin(), expected.end(), [&](const UInt a, const UInt b) {
+        return boosted[a] == boosted[b] ? a > b : boosted[a] > boosted[b]; });
+      expected.resize(sp.getNumColumns() / 10u);
+      expected.erase(std::remove_if(expected.begin(), expected.end(),
+        [&](const UInt c) { return boosted[c] < stimulusThreshold; }), expected.end());
+      std::sort(expected.begin(), expected.end());
+      ASSERT_EQ(expected, columns.getSparse()) << "threshold " << stimulusThreshold << " iteration " << i;
+
+      sp.compute({input}, outputs);
+      ASSERT_EQ(outputs[0], columns);
+    }
+  }
+}
+
+TEST(SpatialPoolerTest, testImplicitPotential) {
+  const auto makeSP = []() {
+    return SpatialPooler({40, 40}, {16, 16}, /*potentialRadius*/ 10, /*potentialPct*/ 0.5f,
+                   /*globalInhibition*/ true, /*localAreaDensity*/ 0.1f, /*numActiveColumnsPerInhArea*/ 0,
+                   /*stimulusThreshold*/ 1u, /*synPermInactiveDec*/ 0.01f, /*synPermActiveInc*/ 0.05f,
+                   /*synPermConnected*/ 0.2f, /*minPctOverlapDutyCycles*/ 0.1f,
+                   /*dutyCyclePeriod*/ 50, /*boostStrength*/ 0.0f, /*seed*/ 42);
+  };
+  SpatialPooler dense = makeSP();
+  SpatialPooler lean  = makeSP();
+  EXPECT_ANY_THROW(lean.setImplicitPotential(0.3f)) << "above synPermConnected";
+  lean.setImplicitPotential(0.1f);
+  EXPECT_EQ(lean.getImplicitPotential(), 0.1f);
+  EXPECT_LT(lean.connections.numSynapses(), dense.connections.numSynapses() * 3u / 4u);
+
+  // The pools are regenerated from (seed, column).
+  SpatialPooler again = makeSP();
+  again.setImplicitPotential(0.1f);
+  EXPECT_EQ(lean, again);
+
+  const auto checkExplicit = [&](const SpatialPooler &sp) {
+    vector<UInt> potential(sp.getNumInputs());
+    for(UInt column = 0; column < sp.getNumColumns(); column++) {
+      sp.getPotential(column, potential.data());
+      for(const auto syn : sp.connections.synapsesForSegment(column)) {
+        ASSERT_GE(sp.connections.permanenceForSynapse(syn), 0.1f) << "below the floor are implicit";
+        ASSERT_EQ(potential[sp.connections.presynapticCellForSynapse(syn)], 1u) << "in the pool";
+      }
+    }
+  };
+  checkExplicit(lean);
+
+  SDR input({40, 40});
+  SDR denseColumns({16, 16});
+  SDR leanColumns({16, 16});
+  Random rng(7);
+  for(int i = 0; i < 200; i++) {
+    input.randomize(0.05f, rng);
+    dense.compute(input, true, denseColumns);
+    lean.compute(input, true, leanColumns);
+    ASSERT_EQ(leanColumns.getSum(), denseColumns.getSum());
+  }
+  checkExplicit(lean);
+  EXPECT_LT(lean.connections.numSynapses(), dense.connections.numSynapses());
+  EXPECT_ANY_THROW(lean.setImplicitPotential(0.05f)) << "only before learning";
+  vector<UInt> potential(lean.getNumInputs(), 1u);
+  EXPECT_ANY_THROW(lean.setPotential(0u, potential.data()));
+
+  // The floor and the seed are serialized.
+  stringstream ss;
+  lean.save(ss);
+  SpatialPooler loaded;
+  loaded.load(ss);
+  EXPECT_EQ(lean, loaded);
+  for(int i = 0; i < 20; i++) {
+    input.randomize(0.05f, rng);
+    lean.compute(input, true, leanColumns);
+    loaded.compute(input, true, denseColumns);
+    ASSERT_EQ(leanColumns, denseColumns);
+  }
+  EXPECT_EQ(lean, loaded);
+}
+
+
+TEST(SpatialPoolerTest, testExportImportSynapses) {
+  const auto makeSP = [](const int seed) {
+    return SpatialPooler({20, 20}, {12, 12}, /*potentialRadius*/ 8, /*potentialPct*/ 0.5f,
+                   /*globalInhibition*/ true, /*localAreaDensity*/ 0.1f, /*numActiveColumnsPerInhArea*/ 0,
+                   /*stimulusThreshold*/ 1u, /*synPermInactiveDec*/ 0.01f, /*synPermActiveInc*/ 0.05f,
+                   /*synPermConnected*/ 0.2f, /*minPctOverlapDutyCycles*/ 0.1f,
+                   /*dutyCyclePeriod*/ 50, /*boostStrength*/ 0.0f, seed);
+  };
+  SpatialPooler trained = makeSP(42);
+  SDR input({20, 20});
+  SDR expected({12, 12});
+  SDR actual({12, 12});
+  Random rng(7);
+  for(int i = 0; i < 50; i++) {
+    input.randomize(0.05f, rng);
+    trained.compute(input, true, expected);
+  }
+
+  vector<CellIdx> cells, presyn;
+  vector<Synapse> offsets;
+  vector<Permanence> perms;
+  trained.exportSynapses(cells, offsets, presyn, perms);
+  ASSERT_EQ(trained.getNumColumns(), cells.size());
+  SpatialPooler imported = makeSP(1);
+  imported.importSynapses(cells, offsets, presyn, perms);
+  for(UInt column = 0; column < trained.getNumColumns(); column++) {
+    ASSERT_EQ(trained.getPermanence(column), imported.getPermanence(column)) << "column " << column;
+  }
+  for(int i = 0; i < 20; i++) {
+    input.randomize(0.05f, rng);
+    trained.compute(input, false, expected);
+    imported.compute(input, false, actual);
+    ASSERT_EQ(expected, actual);
+  }
+
+  auto badPresyn = presyn;
+  badPresyn[0] = 400;
+  EXPECT_ANY_THROW(imported.importSynapses(cells, offsets, badPresyn, perms)) << "not an input";
+  vector<CellIdx> fewer(cells.begin(), cells.end() - 1);
+  vector<Synapse> fewerOffsets(offsets.begin(), offsets.end() - 1);
+  EXPECT_ANY_THROW(imported.importSynapses(fewer, fewerOffsets, presyn, perms)) << "a row per column";
+}
+
+
+#ifndef NTA_NO_ALGORITHM_STATS
+TEST(SpatialPoolerTest, testAlgorithmStats) {
+  SpatialPooler sp({20, 20}, {16, 16}, /*potentialRadius*/ 5, /*potentialPct*/ 0.5f,
+                   /*globalInhibition*/ true, /*localAreaDensity*/ 0.1f);
+  sp.getStats().enable();
+  SDR input({20, 20});
+  SDR columns({16, 16});
+  Random rng(7);
+  UInt64 numActive = 0u;
+  for(int i = 0; i < 20; i++) {
+    input.randomize(0.05f, rng);
+    sp.compute(input, i < 10, columns);
+    numActive += columns.getSum();
+  }
+  const AlgorithmStats &stats = sp.getStats();
+  EXPECT_EQ(stats.getCount(SpatialPooler::Stats_Computes), 20u);
+  EXPECT_EQ(stats.getCount(SpatialPooler::Stats_ActiveColumns), numActive);
+  EXPECT_EQ(stats.getCalls(SpatialPooler::Stats_Overlap), 20u);
+  EXPECT_EQ(stats.getCalls(SpatialPooler::Stats_Inhibition), 20u);
+  EXPECT_EQ(stats.getCalls(SpatialPooler::Stats_Adapt), 10u);
+  EXPECT_EQ(stats.getCalls(SpatialPooler::Stats_Boost), 10u);
+  EXPECT_GE(stats.getCalls(SpatialPooler::Stats_DutyCycles), 10u);
+  EXPECT_GT(stats.getSeconds(SpatialPooler::Stats_Overlap), 0.0);
+  EXPECT_NE(stats.toJSON().find("\"inhibition\": {\"calls\": 20"), std::string::npos);
+}
+
+TEST(SpatialPoolerTest, testAlgorithmStatsBatch) {
+  SpatialPooler sp({20, 20}, {16, 16}, /*potentialRadius*/ 5, /*potentialPct*/ 0.5f,
+                   /*globalInhibition*/ true, /*localAreaDensity*/ 0.1f);
+  sp.getStats().enable();
+  vector<SDR> inputs(12, SDR({20, 20}));
+  Random rng(7);
+  for(auto &input : inputs) input.randomize(0.05f, rng);
+  vector<SDR> outputs;
+  sp.compute(inputs, outputs);
+  UInt64 numActive = 0u;
+  for(const auto &columns : outputs) numActive += columns.getSum();
+
+  // One batch: every input counts, the overlaps & inhibition are timed once.
+  const AlgorithmStats &stats = sp.getStats();
+  EXPECT_EQ(stats.getCount(SpatialPooler::Stats_Computes), 12u);
+  EXPECT_EQ(stats.getCount(SpatialPooler::Stats_ActiveColumns), numActive);
+  EXPECT_GT(numActive, 0u);
+  EXPECT_EQ(stats.getCalls(SpatialPooler::Stats_Overlap), 1u);
+  EXPECT_EQ(stats.getCalls(SpatialPooler::Stats_Inhibition), 1u);
+  EXPECT_EQ(stats.getCalls(SpatialPooler::Stats_Adapt), 0u) << "the batch does not learn";
+}
+#endif
+
+TEST(SpatialPoolerTest, testLoadResetsNeighborTable) {
+  // Local inhibition with the same radius and wrapping, other columns.
+  SpatialPooler small({12u, 12u}, {8u, 8u}, 4u, 0.5f, /*globalInhibition*/ false, 0.1f);
+  SpatialPooler large({12u, 12u}, {10u, 12u}, 4u, 0.5f, /*globalInhibition*/ false, 0.1f);
+  small.setInhibitionRadius(2u);
+  large.setInhibitionRadius(2u);
+  SDR input({12u, 12u});
+  Random rng(11);
+  input.randomize(0.1f, rng);
+  SDR smallColumns({8u, 8u});
+  SDR largeColumns({10u, 12u});
+  small.compute(input, false, smallColumns); // builds the neighbor table of 8x8 columns
+  large.compute(input, false, largeColumns);
+
+  stringstream ss;
+  large.save(ss);
+  small.load(ss);
+  SDR loadedColumns({10u, 12u});
+  small.compute(input, false, loadedColumns);
+  ASSERT_EQ(largeColumns, loadedColumns);
+}
+
 } // end anonymous namespace
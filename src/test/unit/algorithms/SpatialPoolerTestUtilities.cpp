@@ -0,0 +1,50 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2018, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "SpatialPoolerTestUtilities.hpp"
+#include <htm/utils/Random.hpp>
+
+namespace testing
+{
+
+using namespace htm;
+
+SpatialPooler makeSmallSP(const bool globalInhibition,
+                          const UInt stimulusThreshold,
+                          const Real minPctOverlapDutyCycles,
+                          const Real boostStrength,
+                          const UInt potentialRadius,
+                          const Int seed,
+                          const bool wrapAround) {
+  return SpatialPooler({20, 20}, {16, 16}, potentialRadius, /*potentialPct*/ 0.5f,
+                   globalInhibition, /*localAreaDensity*/ 0.1f, /*numActiveColumnsPerInhArea*/ 0,
+                   stimulusThreshold, /*synPermInactiveDec*/ 0.01f, /*synPermActiveInc*/ 0.1f,
+                   /*synPermConnected*/ 0.1f, minPctOverlapDutyCycles,
+                   /*dutyCyclePeriod*/ 50, boostStrength, seed, /*spVerbosity*/ 0, wrapAround);
+}
+
+void trainSP(SpatialPooler &sp) {
+  Random rng(3);
+  SDR input(sp.getInputDimensions());
+  SDR columns(sp.getColumnDimensions());
+  for(int i = 0; i < 100; i++) {
+    input.randomize(0.1f, rng);
+    sp.compute(input, true, columns);
+  }
+}
+
+} // namespace testing
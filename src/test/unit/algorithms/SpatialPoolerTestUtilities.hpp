@@ -0,0 +1,47 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2018, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/***********
+ *  Includes some routines for the tests which compare two ways of
+ *  computing the same SpatialPooler results.
+ ***********/
+#ifndef SPATIALPOOLERTESTUTILITIES_HPP
+#define SPATIALPOOLERTESTUTILITIES_HPP
+
+#include <htm/algorithms/SpatialPooler.hpp>
+
+namespace testing
+{
+
+  /**
+   * A small SpatialPooler, 20x20 inputs to 16x16 columns, with the
+   * dutyCyclePeriod of 50 so boosting kicks in within a short test.
+   */
+  htm::SpatialPooler makeSmallSP(bool globalInhibition,
+                                 htm::UInt stimulusThreshold,
+                                 htm::Real minPctOverlapDutyCycles,
+                                 htm::Real boostStrength,
+                                 htm::UInt potentialRadius = 5u,
+                                 htm::Int seed = 1,
+                                 bool wrapAround = true);
+
+  // Learn on 100 random inputs, so permanences & boost factors are not the initial ones.
+  void trainSP(htm::SpatialPooler &sp);
+
+} // namespace testing
+
+#endif // SPATIALPOOLERTESTUTILITIES_HPP
@@ -19,6 +19,7 @@
  * Implementation of unit tests for TemporalMemory
  */
 
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 
@@ -27,16 +28,20 @@
 #include <htm/utils/Log.hpp>
 
 #include <cstdio>
+#include <memory>
 
 #include "gtest/gtest.h"
 #include <htm/algorithms/TemporalMemory.hpp>
+#include <htm/algorithms/Anomaly.hpp>
 
 
 namespace testing {
 
 using namespace std;
 using namespace htm;
-const Real EPSILON  = 0.0000001f;
+// Tolerance of a permanence, the quantization step in builds with
+// NTA_PERMANENCE_BITS 16 or 8.
+const Real EPSILON  = std::max(0.0000001f, PermanenceCodec<PermanenceStorage>::step());
 
 
 TEST(TemporalMemoryTest, testInitInvalidParams) {
@@ -1339,6 +1344,17 @@ TEST(TemporalMemoryTest, testColumnForCell2D) {
   ASSERT_EQ(4095ul, tm.columnForCell(16383));
 }
 
+TEST(TemporalMemoryTest, testColumnForCellAnyCellsPerColumn) {
+  // power of two cellsPerColumn use a shift, the others a division
+  for(const CellIdx cellsPerColumn : {1u, 2u, 3u, 16u, 24u, 32u}) {
+    TemporalMemory tm;
+    tm.initialize(vector<UInt>{50}, cellsPerColumn);
+    for(CellIdx cell = 0; cell < tm.numberOfCells(); cell++) {
+      ASSERT_EQ(cell / cellsPerColumn, tm.columnForCell(cell));
+    }
+  }
+}
+
 TEST(TemporalMemoryTest, testColumnForCellInvalidCell) {
   TemporalMemory tm;
   tm.initialize(vector<UInt>{64, 64}, 4);
@@ -1565,6 +1581,59 @@ TEST(TemporalMemoryTest, testSaveArLoadAr) {
 
 }
 
+/**
+ * An archive written before the archive was versioned (see
+ * src/test/data/README.md) loads, and the TM continues its sequence exactly
+ * like the old release did, including the draws of its rng.
+ */
+TEST(TemporalMemoryTest, testLoadLegacyArchive) {
+  std::ifstream in(std::string(HTM_TEST_DATA_DIR) + "/TemporalMemory.v1.bin", std::ios_base::binary);
+  ASSERT_TRUE(in.good());
+  TemporalMemory tm;
+  tm.load(in);
+
+  EXPECT_EQ(tm.getColumnDimensions(), vector<CellIdx>({ 32u }));
+  EXPECT_EQ(tm.getCellsPerColumn(), 4u);
+  EXPECT_EQ(tm.getActivationThreshold(), 2u);
+  EXPECT_EQ(tm.getMinThreshold(), 1u);
+  EXPECT_EQ(tm.getMaxNewSynapseCount(), 3u);
+  EXPECT_FALSE(tm.getSeparateExternalConnections());
+  EXPECT_EQ(tm.connections.numSegments(), 16u);
+  EXPECT_EQ(tm.getActiveCells(), vector<CellIdx>({ 32u, 36u, 40u, 44u }));
+  EXPECT_EQ(tm.getWinnerCells(), vector<CellIdx>({ 32u, 36u, 40u, 44u }));
+
+  SDR columns({ 32u });
+  const vector<vector<CellIdx>> expectedActive = {
+      { 64u, 68u, 72u, 76u }, { 96u, 100u, 104u, 108u }, { 0u, 4u, 8u, 12u }, { 32u, 36u, 40u, 44u } };
+  for(UInt step = 2u; step < 6u; step++) {
+    SDR_sparse_t active;
+    for(UInt i = 0u; i < 4u; i++) active.push_back(8u * (step % 4u) + i);
+    columns.setSparse(active);
+    tm.compute(columns, true);
+    EXPECT_EQ(tm.getActiveCells(), expectedActive[step - 2u]) << "step " << step;
+    EXPECT_EQ(tm.anomaly, 0.0f) << "step " << step;
+  }
+
+  // A novel input bursts, the rng picks 3 of the 4 previous winners for each
+  // new segment.
+  columns.setSparse(SDR_sparse_t{ 4u, 12u, 20u, 28u });
+  tm.compute(columns, true);
+  EXPECT_EQ(tm.anomaly, 1.0f);
+  EXPECT_EQ(tm.connections.numSegments(), 20u);
+  ASSERT_EQ(tm.getWinnerCells(), vector<CellIdx>({ 16u, 48u, 80u, 112u }));
+  const vector<vector<CellIdx>> expectedPresynaptic = {
+      { 32u, 36u, 44u }, { 32u, 40u, 44u }, { 32u, 36u, 44u }, { 32u, 36u, 40u } };
+  for(size_t i = 0; i < expectedPresynaptic.size(); i++) {
+    const CellIdx cell = tm.getWinnerCells()[i];
+    vector<CellIdx> presynaptic;
+    for(const auto syn : tm.connections.synapsesForSegment(tm.connections.segmentsForCell(cell).back())) {
+      presynaptic.push_back(tm.connections.presynapticCellForSynapse(syn));
+    }
+    std::sort(presynaptic.begin(), presynaptic.end());
+    EXPECT_EQ(presynaptic, expectedPresynaptic[i]) << "cell " << cell;
+  }
+}
+
 
 /*
  * Test compute( extraActive, extraWinners )
@@ -1638,6 +1707,77 @@ TEST(TemporalMemoryTest, testExtraActive) {
   }
 }
 
+/**
+ * With the external inputs in their own Connections the TM learns the same
+ * as with the external inputs appended to the cells.
+ */
+TEST(TemporalMemoryTest, testSeparateExternalConnections) {
+  SDR columns({120});
+  vector<SDR> pattern( 10, columns.dimensions );
+  for(auto i = 0u; i < pattern.size(); i++) {
+    Random rng( i + 99u );
+    pattern[i].randomize( 0.10f, rng );
+  }
+
+  const auto makeTM = [&]() {
+    return TemporalMemory(columns.dimensions,
+      /* cellsPerColumn */               12,
+      /* activationThreshold */          13,
+      /* initialPermanence */            0.21f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 10,
+      /* maxNewSynapseCount */           20,
+      /* permanenceIncrement */          0.10f,
+      /* permanenceDecrement */          0.03f,
+      /* predictedSegmentDecrement */    0.001f,
+      /* seed */                         42,
+      /* maxSegmentsPerCell */           255,
+      /* maxSynapsesPerSegment */        255,
+      /* checkInputs */                  true,
+      /* extra */                        (UInt)(columns.size * 12u));
+  };
+  TemporalMemory shared = makeTM();
+  TemporalMemory separate = makeTM();
+  ASSERT_FALSE(separate.getSeparateExternalConnections());
+  separate.setSeparateExternalConnections(true);
+  ASSERT_TRUE(separate.getSeparateExternalConnections());
+
+  SDR extraActive({ (UInt)shared.numberOfCells() });
+  SDR extraWinners( extraActive.dimensions );
+  for(UInt trial = 0; trial < 10; trial++) {
+    shared.reset();
+    separate.reset();
+    extraActive.zero();
+    extraWinners.zero();
+    for(const auto &x : pattern) {
+      shared.compute(x, true, extraActive, extraWinners);
+      separate.compute(x, true, extraActive, extraWinners);
+      ASSERT_EQ(shared.getActiveCells(), separate.getActiveCells());
+      ASSERT_EQ(shared.getWinnerCells(), separate.getWinnerCells());
+      ASSERT_EQ(shared.anomaly, separate.anomaly);
+      extraActive.setSparse( shared.getActiveCells() );
+      extraWinners.setSparse( shared.getWinnerCells() );
+    }
+  }
+  ASSERT_LT(separate.anomaly, 0.05f);
+
+  // each Connections only holds synapses to its own inputs
+  ASSERT_GT(separate.externalConnections.numSynapses(), 0u);
+  ASSERT_EQ(shared.connections.numSynapses(),
+            separate.connections.numSynapses() + separate.externalConnections.numSynapses());
+  for(CellIdx cell = 0; cell < separate.numberOfCells(); cell++) {
+    for(const auto segment : separate.connections.segmentsForCell(cell)) {
+      for(const auto synapse : separate.connections.synapsesForSegment(segment)) {
+        ASSERT_LT(separate.connections.presynapticCellForSynapse(synapse), separate.numberOfCells());
+      }
+    }
+  }
+
+  EXPECT_ANY_THROW(separate.setSeparateExternalConnections(false)) << "has synapses already";
+  TemporalMemory noExternal(columns.dimensions);
+  EXPECT_ANY_THROW(noExternal.setSeparateExternalConnections(true));
+}
+
 TEST(TemporalMemoryTest, testEquals) {
   TemporalMemory tm({10,10});
   auto tmCopy = tm;
@@ -1662,6 +1802,605 @@ TEST(TemporalMemoryTest, testIncorrectDefaultConstructor) {
   EXPECT_NO_THROW(tmOk.compute(data2, true));
 }
 
+TEST(TemporalMemoryTest, testPredictiveCellsCached) {
+  SDR columns({200});
+  vector<SDR> pattern( 5, columns.dimensions );
+  Random rng(42);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.10f, rng );
+  }
+  TemporalMemory tm(columns.dimensions, /* cellsPerColumn */ 4);
+  SDR predictive({200, 4});
+  for(int trial = 0; trial < 10; trial++) {
+    for(const auto &x : pattern) {
+      tm.activateDendrites(true);
+      const SDR &cached = tm.getPredictiveCells();
+      ASSERT_EQ(&cached, &tm.getPredictiveCells()) << "must not rebuild until the segments change";
+      tm.getPredictiveCells(predictive);
+      ASSERT_EQ(cached, predictive);
+
+      // same as built from the active segments
+      vector<CellIdx> expected;
+      for(const auto segment : tm.getActiveSegments()) {
+        expected.push_back(tm.connections.cellForSegment(segment));
+      }
+      std::sort(expected.begin(), expected.end());
+      expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+      ASSERT_EQ(cached.getSparse(), expected);
+
+      tm.compute(x, true);
+    }
+  }
+  ASSERT_GT(predictive.getSum(), 0u);
+
+  SDR wrongDims({800});
+  tm.activateDendrites(true);
+  EXPECT_ANY_THROW(tm.getPredictiveCells(wrongDims));
+}
+
+/**
+ * The raw anomaly from the predicted columns equals the score computed from
+ * the predictive cells, also after reset() and a save/load cycle.
+ */
+TEST(TemporalMemoryTest, testRawAnomalyPredictedColumns) {
+  SDR columns({200});
+  vector<SDR> pattern( 5, columns.dimensions );
+  Random rng(42);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.10f, rng );
+  }
+  TemporalMemory tm(columns.dimensions, /* cellsPerColumn */ 4);
+  bool predicted = false;
+  for(int trial = 0; trial < 10; trial++) {
+    for(const auto &x : pattern) {
+      tm.activateDendrites(true);
+      const SDR predictive = tm.cellsToColumns(tm.getPredictiveCells());
+      predicted = predicted or predictive.getSum() > 0u;
+      const Real expected = computeRawAnomalyScore(x, predictive);
+      tm.compute(x, true);
+      ASSERT_FLOAT_EQ(tm.anomaly, expected);
+    }
+    if( trial == 5 ) tm.reset();
+  }
+  ASSERT_TRUE(predicted);
+
+  stringstream ss;
+  tm.activateDendrites(true);
+  tm.save(ss);
+  TemporalMemory tm2;
+  tm2.load(ss);
+  const Real expected = computeRawAnomalyScore(pattern[0], tm2.cellsToColumns(tm2.getPredictiveCells()));
+  tm2.compute(pattern[0], false);
+  ASSERT_FLOAT_EQ(tm2.anomaly, expected);
+}
+
+/**
+ * computeBatch() over many streams equals running a copy of the TM per stream.
+ */
+TEST(TemporalMemoryTest, testComputeBatch) {
+  SDR columns({200});
+  vector<SDR> pattern( 10, columns.dimensions );
+  Random rng(42);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.10f, rng );
+  }
+  const auto train = [&](TemporalMemory &t) {
+    for(int trial = 0; trial < 10; trial++) {
+      t.reset();
+      for(const auto &x : pattern) t.compute(x, true);
+    }
+  };
+  TemporalMemory tm(columns.dimensions, /* cellsPerColumn */ 8);
+  train(tm);
+  const auto ownActive = tm.getActiveCells();
+
+  // each stream sees the sequence with a different phase, the reference
+  // result is a separate identically trained TM per stream.
+  const size_t numStreams = 3u;
+  vector<std::unique_ptr<TemporalMemory>> copies;
+  for(size_t s = 0; s < numStreams; s++) {
+    copies.emplace_back(new TemporalMemory(columns.dimensions, /* cellsPerColumn */ 8));
+    train(*copies.back());
+    copies.back()->reset();
+  }
+  vector<TMState> states(numStreams);
+  vector<SDR> inputs(numStreams, columns.dimensions);
+  for(size_t step = 0; step < 2u * pattern.size(); step++) {
+    for(size_t s = 0; s < numStreams; s++) {
+      inputs[s] = pattern[(step + 3u * s) % pattern.size()];
+      copies[s]->compute(inputs[s], false);
+    }
+    tm.computeBatch(inputs, states);
+    for(size_t s = 0; s < numStreams; s++) {
+      ASSERT_EQ(states[s].activeCells, copies[s]->getActiveCells()) << "step " << step << " stream " << s;
+      ASSERT_EQ(states[s].winnerCells, copies[s]->getWinnerCells()) << "step " << step << " stream " << s;
+      ASSERT_EQ(states[s].anomaly, copies[s]->anomaly) << "step " << step << " stream " << s;
+    }
+  }
+  ASSERT_EQ(tm.getActiveCells(), ownActive) << "own state must not change";
+  ASSERT_LT(states[0].anomaly, 0.05f) << "stream should be predicted";
+
+  vector<TMState> wrongSize(1);
+  EXPECT_ANY_THROW(tm.computeBatch(inputs, wrongSize));
+}
+
+/**
+ * learnSequences() learns the same as compute() for each record.
+ */
+TEST(TemporalMemoryTest, testLearnSequences) {
+  SDR columns({200});
+  vector<SDR> sequence( 30, columns.dimensions );
+  vector<bool> resets( sequence.size(), false );
+  Random rng(42);
+  for(size_t i = 0; i < sequence.size(); i++) {
+    sequence[i].randomize( 0.10f, rng );
+    resets[i] = i % 10u == 0u;
+  }
+  TemporalMemory tm1(columns.dimensions, /* cellsPerColumn */ 8);
+  TemporalMemory tm2(columns.dimensions, /* cellsPerColumn */ 8);
+  for(int trial = 0; trial < 5; trial++) {
+    for(size_t i = 0; i < sequence.size(); i++) {
+      if( resets[i] ) tm1.reset();
+      tm1.compute(sequence[i], true);
+    }
+    tm2.learnSequences(sequence, resets);
+  }
+  ASSERT_EQ(tm1.connections, tm2.connections);
+  ASSERT_EQ(tm1.getActiveCells(), tm2.getActiveCells());
+  ASSERT_EQ(tm1.getWinnerCells(), tm2.getWinnerCells());
+  EXPECT_EQ(tm2.anomaly, -1.0f);
+
+  // the trained TM predicts the sequence
+  tm2.reset();
+  for(size_t i = 0; i < 10u; i++) tm2.compute(sequence[i], false);
+  EXPECT_LT(tm2.anomaly, 0.05f);
+
+  EXPECT_ANY_THROW(tm2.learnSequences(sequence, {true}));
+}
+
+/**
+ * Speculative inference from a snapshot does not disturb the live TM.
+ */
+TEST(TemporalMemoryTest, testSnapshotRestore) {
+  SDR columns({200});
+  vector<SDR> pattern( 10, columns.dimensions );
+  Random rng(7);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.10f, rng );
+  }
+  TemporalMemory live(columns.dimensions, /* cellsPerColumn */ 8);
+  TemporalMemory control(columns.dimensions, /* cellsPerColumn */ 8);
+  for(int trial = 0; trial < 10; trial++) {
+    for(auto tm : {&live, &control}) {
+      tm->reset();
+      for(const auto &x : pattern) tm->compute(x, true);
+    }
+  }
+  ASSERT_EQ(live, control);
+
+  for(size_t step = 0; step < pattern.size(); step++) {
+    const auto &x = pattern[step];
+    // snapshot after the dendrites are computed (as compute() does), with valid segments
+    live.activateDendrites(true);
+    const auto snap = live.snapshot();
+    const auto predicted = live.getPredictiveCells();
+
+    // roll out a few steps ahead
+    for(size_t ahead = 1; ahead <= 3; ahead++) {
+      live.compute(pattern[(step + ahead) % pattern.size()], false);
+    }
+    live.restore(snap);
+    ASSERT_EQ(live.getPredictiveCells(), predicted);
+
+    live.compute(x, true);
+    control.compute(x, true);
+    ASSERT_EQ(live.getActiveCells(), control.getActiveCells()) << "step " << step;
+    ASSERT_EQ(live.anomaly, control.anomaly) << "step " << step;
+  }
+  ASSERT_EQ(live, control);
+
+  // a snapshot without segments can be restored after learning
+  const auto cellsOnly = live.snapshot();
+  ASSERT_FALSE(cellsOnly.segmentsValid);
+  live.compute(pattern[0], true);
+  live.restore(cellsOnly);
+  ASSERT_EQ(live.getActiveCells(), cellsOnly.activeCells);
+
+  // but not one with segments, after the next learning step
+  live.activateDendrites(true);
+  const auto withSegments = live.snapshot();
+  live.compute(pattern[1], true);
+  live.compute(pattern[2], true);
+  EXPECT_ANY_THROW(live.restore(withSegments));
+}
+
+/**
+ * Parallel learning gives the same results as the single threaded TM.
+ */
+TEST(TemporalMemoryTest, testParallelLearning) {
+  SDR columns({500});
+  vector<SDR> pattern( 20, columns.dimensions );
+  Random rng(42);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.05f, rng );
+  }
+
+  const auto makeTM = [&]() {
+    return TemporalMemory(columns.dimensions,
+      /* cellsPerColumn */               8,
+      /* activationThreshold */          10,
+      /* initialPermanence */            0.21f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 6,
+      /* maxNewSynapseCount */           15,
+      /* permanenceIncrement */          0.10f,
+      /* permanenceDecrement */          0.05f,
+      /* predictedSegmentDecrement */    0.01f);
+  };
+  TemporalMemory serial = makeTM();
+  TemporalMemory parallel = makeTM();
+  parallel.setNumThreads(4);
+  ASSERT_EQ(parallel.getNumThreads(), 4u);
+
+  SDR input(columns.dimensions);
+  for(int trial = 0; trial < 10; trial++) {
+    for(const auto &x : pattern) {
+      input = x;
+      if(trial % 3 == 2) input.addNoise(0.2f, rng); //some bursting and punishment
+      serial.compute(input, true);
+      parallel.compute(input, true);
+      ASSERT_EQ(serial.getActiveCells(), parallel.getActiveCells());
+      ASSERT_EQ(serial.getWinnerCells(), parallel.getWinnerCells());
+      ASSERT_EQ(serial.anomaly, parallel.anomaly);
+    }
+  }
+  ASSERT_EQ(serial, parallel);
+}
+
+/**
+ * Inference with lazy matching segments gives the same cells as the default TM.
+ */
+TEST(TemporalMemoryTest, testLazyMatching) {
+  SDR columns({100});
+  vector<SDR> pattern( 10, columns.dimensions );
+  Random rng(3);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.05f, rng );
+  }
+  const auto makeTM = [&]() {
+    return TemporalMemory(columns.dimensions, /*cellsPerColumn*/ 8, /*activationThreshold*/ 3,
+                          /*initialPermanence*/ 0.5f, /*connectedPermanence*/ 0.5f,
+                          /*minThreshold*/ 2, /*maxNewSynapseCount*/ 8);
+  };
+  TemporalMemory eager = makeTM();
+  TemporalMemory lazy = makeTM();
+  lazy.setLazyMatching(true);
+  ASSERT_TRUE(lazy.getLazyMatching());
+
+  SDR input(columns.dimensions);
+  for(int trial = 0; trial < 12; trial++) {
+    const bool learn = trial % 3 != 2;
+    for(size_t i = 0; i < pattern.size(); i++) {
+      input = pattern[i];
+      if(trial % 4 == 3) input.addNoise(0.3f, rng); //some bursting columns
+      if(i == 3u) { //the matching segments are computed on demand
+        eager.activateDendrites(learn);
+        lazy.activateDendrites(learn);
+        ASSERT_EQ(eager.getActiveSegments(), lazy.getActiveSegments());
+        ASSERT_EQ(eager.getMatchingSegments(), lazy.getMatchingSegments());
+        eager.activateCells(input, learn);
+        lazy.activateCells(input, learn);
+      } else {
+        eager.compute(input, learn);
+        lazy.compute(input, learn);
+      }
+      ASSERT_EQ(eager.getActiveCells(), lazy.getActiveCells());
+      ASSERT_EQ(eager.getWinnerCells(), lazy.getWinnerCells());
+      ASSERT_EQ(eager.anomaly, lazy.anomaly);
+    }
+  }
+  // The last step learned, so the matching segments are complete on both.
+  eager.compute(pattern[0], true);
+  lazy.compute(pattern[0], true);
+  ASSERT_EQ(eager, lazy);
+}
+
+/**
+ * Compacting the Connections between compute() steps keeps the predictions.
+ */
+TEST(TemporalMemoryTest, testCompact) {
+  SDR columns({200});
+  vector<SDR> pattern( 30, columns.dimensions );
+  Random rng(42);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.05f, rng );
+  }
+  TemporalMemory tm(columns.dimensions,
+      /* cellsPerColumn */               4,
+      /* activationThreshold */          5,
+      /* initialPermanence */            0.21f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 3,
+      /* maxNewSynapseCount */           8,
+      /* permanenceIncrement */          0.10f,
+      /* permanenceDecrement */          0.05f,
+      /* predictedSegmentDecrement */    0.01f,
+      /* seed */                         42,
+      /* maxSegmentsPerCell */           2); //destroys segments
+  const size_t initialUsage = tm.memoryUsage();
+
+  const auto cellsOf = [&](const vector<Segment> &segments) {
+    vector<CellIdx> cells;
+    for(const auto segment : segments) cells.push_back(tm.connections.cellForSegment(segment));
+    return cells;
+  };
+  bool released = false;
+  SDR input(columns.dimensions);
+  for(int trial = 0; trial < 20; trial++) {
+    for(const auto &x : pattern) {
+      input = x;
+      input.addNoise(0.3f, rng);
+      tm.compute(input, true);
+      tm.activateDendrites(true);
+      const SDR predictive = tm.getPredictiveCells();
+      const auto active    = cellsOf(tm.getActiveSegments());
+      const auto matching  = cellsOf(tm.getMatchingSegments());
+      const size_t numSegments = tm.connections.numSegments();
+      released |= tm.connections.segmentFlatListLength() > numSegments;
+
+      tm.compact();
+      ASSERT_EQ(tm.connections.numSegments(), numSegments);
+      ASSERT_EQ(tm.connections.segmentFlatListLength(), numSegments);
+      ASSERT_EQ(tm.getPredictiveCells(), predictive);
+      ASSERT_EQ(cellsOf(tm.getActiveSegments()), active);
+      ASSERT_EQ(cellsOf(tm.getMatchingSegments()), matching);
+    }
+  }
+  EXPECT_TRUE(released) << "test the test: segments should be destroyed";
+  EXPECT_GT(tm.memoryUsage(), initialUsage);
+}
+
+
+TEST(TemporalMemoryTest, testDefragment) {
+  SDR columns({200});
+  vector<SDR> pattern( 30, columns.dimensions );
+  Random rng(42);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.05f, rng );
+  }
+  const auto makeTM = [&]() {
+    return TemporalMemory(columns.dimensions,
+      /* cellsPerColumn */               4,
+      /* activationThreshold */          5,
+      /* initialPermanence */            0.21f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 3,
+      /* maxNewSynapseCount */           8,
+      /* permanenceIncrement */          0.10f,
+      /* permanenceDecrement */          0.05f,
+      /* predictedSegmentDecrement */    0.01f,
+      /* seed */                         42,
+      /* maxSegmentsPerCell */           2);
+  };
+  TemporalMemory tm = makeTM();
+  TemporalMemory defragmented = makeTM();
+  const auto cellsOf = [](const TemporalMemory &model, const vector<Segment> &segments) {
+    vector<CellIdx> cells;
+    for(const auto segment : segments) cells.push_back(model.connections.cellForSegment(segment));
+    return cells;
+  };
+
+  SDR input(columns.dimensions);
+  for(int trial = 0; trial < 10; trial++) {
+    for(const auto &x : pattern) {
+      input = x;
+      input.addNoise(0.3f, rng);
+      tm.compute(input, true);
+      defragmented.compute(input, true);
+      tm.activateDendrites(true);
+      defragmented.activateDendrites(true);
+      if( trial % 3 == 0 ) defragmented.defragment();
+
+      ASSERT_EQ(defragmented.getActiveCells(), tm.getActiveCells());
+      ASSERT_EQ(defragmented.getWinnerCells(), tm.getWinnerCells());
+      ASSERT_EQ(defragmented.getPredictiveCells(), tm.getPredictiveCells());
+      ASSERT_EQ(cellsOf(defragmented, defragmented.getMatchingSegments()),
+                cellsOf(tm, tm.getMatchingSegments()));
+      ASSERT_EQ(defragmented.connections.numSynapses(), tm.connections.numSynapses());
+    }
+  }
+  defragmented.defragment();
+  const auto &connections = defragmented.connections;
+  EXPECT_EQ(connections.numSegments(), connections.segmentFlatListLength());
+  Segment next = 0;
+  for(CellIdx cell = 0; cell < connections.numCells(); cell++) {
+    // contiguous, in the order of the flat indices before
+    auto segments = connections.segmentsForCell(cell);
+    std::sort(segments.begin(), segments.end());
+    for(const auto segment : segments) {
+      ASSERT_EQ(next++, segment);
+    }
+  }
+}
+
+/**
+ * compact() and defragment() renumber the segments of both Connections with
+ * separate external connections, the segments keep their mirrors.
+ */
+TEST(TemporalMemoryTest, testCompactDefragmentSeparateExternal) {
+  SDR columns({200});
+  vector<SDR> pattern( 30, columns.dimensions );
+  Random rng(42);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.05f, rng );
+  }
+  const auto makeTM = [&]() {
+    TemporalMemory tm(columns.dimensions,
+      /* cellsPerColumn */               4,
+      /* activationThreshold */          5,
+      /* initialPermanence */            0.21f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 3,
+      /* maxNewSynapseCount */           8,
+      /* permanenceIncrement */          0.10f,
+      /* permanenceDecrement */          0.05f,
+      /* predictedSegmentDecrement */    0.01f,
+      /* seed */                         42,
+      /* maxSegmentsPerCell */           2, //destroys segments
+      /* maxSynapsesPerSegment */        255,
+      /* checkInputs */                  true,
+      /* extra */                        (UInt)(columns.size * 4u));
+    tm.setSeparateExternalConnections(true);
+    return tm;
+  };
+  TemporalMemory tm = makeTM();
+  TemporalMemory compacted = makeTM();
+  TemporalMemory defragmented = makeTM();
+
+  bool released = false;
+  SDR input(columns.dimensions);
+  SDR extraActive({ (UInt)tm.numberOfCells() });
+  SDR extraWinners( extraActive.dimensions );
+  for(int trial = 0; trial < 10; trial++) {
+    for(const auto &x : pattern) {
+      input = x;
+      input.addNoise(0.3f, rng);
+      tm.compute(input, true, extraActive, extraWinners);
+      compacted.compute(input, true, extraActive, extraWinners);
+      defragmented.compute(input, true, extraActive, extraWinners);
+      released |= compacted.externalConnections.segmentFlatListLength() >
+                  compacted.externalConnections.numSegments();
+      compacted.compact();
+      if( trial % 3 == 0 ) defragmented.defragment();
+      EXPECT_EQ(compacted.connections.segmentFlatListLength(), compacted.connections.numSegments());
+      EXPECT_EQ(compacted.externalConnections.segmentFlatListLength(),
+                compacted.externalConnections.numSegments());
+
+      for(const auto *model : {&compacted, &defragmented}) {
+        ASSERT_EQ(model->getActiveCells(), tm.getActiveCells());
+        ASSERT_EQ(model->getWinnerCells(), tm.getWinnerCells());
+        ASSERT_EQ(model->anomaly, tm.anomaly);
+        ASSERT_EQ(model->connections.numSynapses(), tm.connections.numSynapses());
+        ASSERT_EQ(model->externalConnections.numSynapses(), tm.externalConnections.numSynapses());
+      }
+      // the previous winners as external input, so the segments grow mirrors
+      extraActive.setSparse( tm.getWinnerCells() );
+      extraWinners.setSparse( tm.getWinnerCells() );
+    }
+  }
+  EXPECT_TRUE(released) << "test the test: mirrors should be destroyed";
+  ASSERT_GT(tm.externalConnections.numSynapses(), 0u);
+  for(const auto *model : {&compacted, &defragmented}) {
+    tm.activateDendrites(true, extraActive, extraWinners);
+    auto copy = *model;
+    copy.activateDendrites(true, extraActive, extraWinners);
+    EXPECT_EQ(copy.getPredictiveCells(), tm.getPredictiveCells());
+  }
+}
+
+TEST(TemporalMemoryTest, testFork) {
+  SDR columns({200});
+  vector<SDR> pattern( 30, columns.dimensions );
+  Random rng(42);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.05f, rng );
+  }
+  const auto makeTM = [&]() {
+    return TemporalMemory(columns.dimensions,
+      /* cellsPerColumn */               4,
+      /* activationThreshold */          5,
+      /* initialPermanence */            0.21f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 3,
+      /* maxNewSynapseCount */           8);
+  };
+  TemporalMemory tm = makeTM();
+  TemporalMemory control = makeTM();
+  SDR input(columns.dimensions);
+  for(int trial = 0; trial < 10; trial++) {
+    for(const auto &x : pattern) {
+      input = x;
+      input.addNoise(0.1f, rng);
+      tm.compute(input, true);
+      control.compute(input, true);
+    }
+  }
+  const size_t trainedUsage = tm.memoryUsage();
+
+  TemporalMemory variant = tm.fork();
+  EXPECT_EQ(variant, tm);
+  EXPECT_NE(&variant.connections, &tm.connections) << "the public view refers to the fork";
+  EXPECT_LT(tm.memoryUsage(), trainedUsage) << "the synapses are shared";
+
+  variant.setPermanenceIncrement(0.2f);
+  for(const auto &x : pattern) {
+    tm.compute(x, true);
+    control.compute(x, true);
+    variant.compute(x, true);
+    ASSERT_EQ(tm.getActiveCells(), control.getActiveCells()) << "the fork does not change its parent";
+  }
+  EXPECT_EQ(tm, control);
+  EXPECT_NE(variant, tm);
+}
+
+#ifndef NTA_NO_ALGORITHM_STATS
+TEST(TemporalMemoryTest, testAlgorithmStats) {
+  SDR columns({200});
+  vector<SDR> pattern( 30, columns.dimensions );
+  Random rng(42);
+  for(auto &sdr : pattern) {
+    sdr.randomize( 0.05f, rng );
+  }
+  TemporalMemory tm(columns.dimensions,
+      /* cellsPerColumn */               4,
+      /* activationThreshold */          5,
+      /* initialPermanence */            0.21f,
+      /* connectedPermanence */          0.50f,
+      /* minThreshold */                 3,
+      /* maxNewSynapseCount */           8,
+      /* permanenceIncrement */          0.10f,
+      /* permanenceDecrement */          0.05f,
+      /* predictedSegmentDecrement */    0.01f,
+      /* seed */                         42,
+      /* maxSegmentsPerCell */           2); //destroys segments
+  AlgorithmStats &stats = tm.getStats();
+  stats.enable();
+
+  UInt64 numComputes = 0u;
+  UInt64 numActiveColumns = 0u;
+  SDR input(columns.dimensions);
+  for(int trial = 0; trial < 10; trial++) {
+    for(const auto &x : pattern) {
+      input = x;
+      input.addNoise(0.3f, rng);
+      tm.compute(input, true);
+      numComputes++;
+      numActiveColumns += input.getSum();
+    }
+  }
+  EXPECT_EQ(stats.getCalls(TemporalMemory::Stats_ActivateCells), numComputes);
+  EXPECT_EQ(stats.getCalls(TemporalMemory::Stats_ActivateDendrites), numComputes);
+  EXPECT_GT(stats.getCalls(TemporalMemory::Stats_GrowSynapses), 0u);
+  EXPECT_EQ(stats.getCount(TemporalMemory::Stats_NumPredictedColumns) +
+            stats.getCount(TemporalMemory::Stats_NumBurstingColumns), numActiveColumns);
+  EXPECT_GT(stats.getCount(TemporalMemory::Stats_NumPredictedColumns), 0u);
+  EXPECT_GT(stats.getCount(TemporalMemory::Stats_NumPunishedColumns), 0u);
+
+  // Everything created and destroyed is counted.
+  EXPECT_GT(stats.getCount(TemporalMemory::Stats_SegmentsDestroyed), 0u);
+  EXPECT_EQ(stats.getCount(TemporalMemory::Stats_SegmentsCreated) -
+            stats.getCount(TemporalMemory::Stats_SegmentsDestroyed), tm.connections.numSegments());
+  EXPECT_EQ(stats.getCount(TemporalMemory::Stats_SynapsesGrown) -
+            stats.getCount(TemporalMemory::Stats_SynapsesDestroyed), tm.connections.numSynapses());
+  EXPECT_EQ(stats.getCalls(TemporalMemory::Stats_CreateSegment),
+            stats.getCount(TemporalMemory::Stats_SegmentsCreated));
+
+  stats.enable(false);
+  tm.compute(input, true);
+  EXPECT_EQ(stats.getCalls(TemporalMemory::Stats_ActivateCells), numComputes);
+}
+#endif
+
 // Uncomment these tests individually to save/load from a file.
 // This is useful for ad-hoc testing of backwards-compatibility.
 
@@ -0,0 +1,119 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Unit tests for the CategoryEncoder
+ */
+
+#include "gtest/gtest.h"
+#include <htm/types/Sdr.hpp>
+#include <htm/encoders/CategoryEncoder.hpp>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace htm;
+
+TEST(CategoryEncoder, testConstruct) {
+  CategoryEncoder_Parameters P;
+  P.size     = 1000u;
+  P.sparsity = 0.02f;
+  CategoryEncoder E( P );
+  ASSERT_EQ( E.parameters.activeBits, 20u );
+  ASSERT_NE( E.parameters.seed, 0u );
+
+  P.activeBits = 20u;
+  EXPECT_ANY_THROW( CategoryEncoder{ P } ); // both activeBits & sparsity
+  P.sparsity   = 0.0f;
+  P.activeBits = 600u;
+  EXPECT_ANY_THROW( CategoryEncoder{ P } ); // too dense
+}
+
+TEST(CategoryEncoder, testEncode) {
+  CategoryEncoder_Parameters P;
+  P.size       = 2000u;
+  P.activeBits = 40u;
+  P.seed       = 42u;
+  CategoryEncoder E( P );
+  SDR A( E.dimensions ), B( E.dimensions );
+
+  // Stable, exactly activeBits, and different categories do not overlap.
+  E.encode( 123456789012345ull, A );
+  ASSERT_EQ( A.getSum(), 40u );
+  E.encode( 123456789012345ull, B );
+  ASSERT_EQ( A, B );
+  UInt maxOverlap = 0u;
+  for( UInt64 c = 0u; c < 1000u; c++ ) {
+    E.encode( c, B );
+    ASSERT_EQ( B.getSum(), 40u );
+    maxOverlap = std::max( maxOverlap, A.getOverlap( B ));
+  }
+  ASSERT_LE( maxOverlap, 6u );
+
+  // Strings
+  E.encode( std::string("user-17"), A );
+  E.encode( CategoryEncoder::categoryOf("user-17"), B );
+  ASSERT_EQ( A, B );
+  E.encode( std::string("user-18"), B );
+  ASSERT_LE( A.getOverlap( B ), 6u );
+
+  // Another seed gives another encoding.
+  P.seed = 43u;
+  CategoryEncoder F( P );
+  F.encode( std::string("user-17"), B );
+  ASSERT_LE( A.getOverlap( B ), 6u );
+}
+
+TEST(CategoryEncoder, testEncodeBatch) {
+  CategoryEncoder_Parameters P;
+  P.size       = 500u;
+  P.activeBits = 25u;
+  P.seed       = 7u;
+  CategoryEncoder E( P );
+  std::vector<UInt64> categories = { 0u, 1u, 0xFFFFFFFFFFFFFFFFull, 99u };
+  std::vector<SDR> outputs;
+  E.encodeBatch( categories.data(), categories.size(), outputs );
+  ASSERT_EQ( outputs.size(), categories.size() );
+  SDR A( E.dimensions );
+  for( size_t i = 0u; i < categories.size(); i++ ) {
+    E.encode( categories[i], A );
+    ASSERT_EQ( outputs[i], A );
+  }
+
+  SDR_sparse_t sparse;
+  E.encodeSparse( 99u, 1000u, sparse );
+  ASSERT_EQ( sparse.size(), 25u );
+  ASSERT_EQ( sparse[0], A.getSparse()[0] + 1000u );
+}
+
+TEST(CategoryEncoder, testSerialize) {
+  CategoryEncoder_Parameters P;
+  P.size     = 1000u;
+  P.sparsity = 0.05f;
+  CategoryEncoder E1( P );
+
+  std::stringstream buf;
+  E1.save( buf );
+  SDR A( E1.dimensions );
+  E1.encode( 4444u, A );
+
+  CategoryEncoder E2;
+  E2.load( buf );
+  SDR B( E2.dimensions );
+  E2.encode( 4444u, B );
+  ASSERT_EQ( A, B );
+}
@@ -0,0 +1,134 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2014, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Unit tests for the CoordinateEncoder
+ */
+
+#include "gtest/gtest.h"
+#include <htm/types/Sdr.hpp>
+#include <htm/encoders/CoordinateEncoder.hpp>
+#include <sstream>
+#include <vector>
+
+using namespace htm;
+
+namespace {
+  CoordinateEncoderParameters params(const UInt size, const UInt activeBits) {
+    CoordinateEncoderParameters P;
+    P.size       = size;
+    P.activeBits = activeBits;
+    return P;
+  }
+}
+
+TEST(CoordinateEncoder, testConstruct) {
+  CoordinateEncoderParameters P;
+  P.size     = 1000u;
+  P.sparsity = 0.02f;
+  CoordinateEncoder C( P );
+  ASSERT_EQ( C.parameters.activeBits, 20u );
+  ASSERT_EQ( C.size, 1000u );
+
+  P.activeBits = 20u;
+  EXPECT_ANY_THROW( CoordinateEncoder{P} ); // both activeBits & sparsity
+  EXPECT_ANY_THROW( CoordinateEncoder( params( 10u, 11u ) ));
+  EXPECT_ANY_THROW( CoordinateEncoder( params( 0u, 11u ) ));
+}
+
+TEST(CoordinateEncoder, testEncode) {
+  CoordinateEncoder C( params( 33u, 3u ) );
+  SDR A( C.dimensions );
+  SDR B( C.dimensions );
+  C.encode( {100, 200}, 5u, A );
+  // Same encoding as the python htm.encoders.coordinate
+  ASSERT_EQ( A.getSparse(), SDR_sparse_t({ 18u, 30u, 31u }) );
+  C.encode( {100, 200}, 5u, B );
+  ASSERT_EQ( A, B );
+
+  CoordinateEncoder D( params( 1000u, 21u ) );
+  SDR E( D.dimensions );
+  D.encode( {7, -3, 12}, 1u, E );
+  ASSERT_EQ( E.getSparse(), SDR_sparse_t({ 7u, 33u, 78u, 160u, 175u, 262u, 335u,
+      357u, 383u, 458u, 464u, 519u, 528u, 626u, 649u, 663u, 672u, 718u, 805u, 968u, 996u }) );
+
+  // Radius 0 is the coordinate alone.
+  D.encode( {7, -3, 12}, 0u, E );
+  ASSERT_EQ( E.getSum(), 1u );
+}
+
+TEST(CoordinateEncoder, testSaturateArea) {
+  CoordinateEncoder C( params( 1999u, 25u ) );
+  SDR A( C.dimensions );
+  SDR B( C.dimensions );
+  C.encode( {0, 0}, 2u, A );
+  C.encode( {0, 1}, 2u, B );
+  ASSERT_EQ( A.getSum(), 25u );
+  ASSERT_EQ( A.getOverlap( B ), 20u );
+}
+
+TEST(CoordinateEncoder, testRelativePositions) {
+  // As you get farther from a coordinate, the overlap should decrease
+  CoordinateEncoderParameters P = params( 999u, 51u );
+  P.radius = 10u;
+  CoordinateEncoder C( P );
+  SDR A( C.dimensions );
+  SDR B( C.dimensions );
+  C.encode( {100, 200}, A );
+  UInt previous = A.getSum();
+  for( int i = 1; i <= 5; i++ ) {
+    C.encode( {100 + 2 * i, 200 + 2 * i}, B );
+    const UInt overlap = A.getOverlap( B );
+    ASSERT_LE( overlap, previous );
+    previous = overlap;
+  }
+  ASSERT_LT( previous, A.getSum() );
+}
+
+TEST(CoordinateEncoder, testEncodeBatch) {
+  CoordinateEncoderParameters P = params( 500u, 15u );
+  P.radius = 3u;
+  CoordinateEncoder C( P );
+  std::vector<std::vector<Int>> inputs;
+  for( Int i = 0; i < 20; i++ ) inputs.push_back({ i, -2 * i });
+
+  std::vector<SDR> batch;
+  C.encodeBatch( inputs.data(), inputs.size(), batch );
+  ASSERT_EQ( batch.size(), inputs.size() );
+  SDR expected( C.dimensions );
+  for( size_t i = 0; i < inputs.size(); i++ ) {
+    C.encode( inputs[i], 3u, expected );
+    ASSERT_EQ( batch[i], expected ) << "input " << i;
+  }
+}
+
+TEST(CoordinateEncoder, testSerialize) {
+  CoordinateEncoderParameters P = params( 400u, 11u );
+  P.radius = 4u;
+  CoordinateEncoder C1( P );
+  std::stringstream buf;
+  C1.save( buf );
+
+  CoordinateEncoder C2;
+  C2.load( buf );
+  ASSERT_EQ( C2.parameters.radius, 4u );
+  SDR A( C1.dimensions );
+  SDR B( C2.dimensions );
+  C1.encode( {3, 4}, A );
+  C2.encode( {3, 4}, B );
+  ASSERT_EQ( A, B );
+}
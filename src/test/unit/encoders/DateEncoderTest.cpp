@@ -249,6 +249,51 @@ TEST(DateEncoderTest, combined) {
 }
 
 
+TEST(DateEncoderTest, LookupTables) {
+  DateEncoderParameters p;
+  p.season_width = 5;
+  p.dayOfWeek_width = 2;
+  p.weekend_width = 2;
+  p.custom_width = 2;
+  p.custom_days = {"Monday", "Mon, Wed, Fri"};
+  p.holiday_width = 4;
+  p.holiday_dates = {{2020, 1, 1}, {7, 4}, {12, 25}};
+  p.timeOfDay_width = 4;
+  p.timeOfDay_radius = 0.25f;
+  DateEncoder plain(p);
+  DateEncoder fast(p);
+  ASSERT_FALSE(fast.getLookupTables());
+  fast.setLookupTables(true);
+  ASSERT_TRUE(fast.getLookupTables());
+
+  SDR expected(plain.dimensions);
+  SDR actual(fast.dimensions);
+  // A monotone stream through the holidays, then steps in both directions.
+  std::vector<time_t> inputs;
+  const time_t start = DateEncoder::mktime(2019, 12, 20);
+  for (time_t t = start; t < start + 20 * 86400; t += 17 * 60 + 3)
+    inputs.push_back(t);
+  for (time_t t = DateEncoder::mktime(2021, 1, 1); t > DateEncoder::mktime(2020, 1, 1); t -= 7 * 3600 + 13 * 60)
+    inputs.push_back(t);
+
+  for (const time_t input : inputs) {
+    plain.encode(input, expected);
+    fast.encode(input, actual);
+    ASSERT_EQ(actual, expected) << "at time " << input;
+    ASSERT_EQ(fast.buckets, plain.buckets) << "at time " << input;
+  }
+
+  // struct tm input
+  struct std::tm timeinfo = *std::localtime(&start);
+  plain.encode(timeinfo, expected);
+  fast.encode(timeinfo, actual);
+  ASSERT_EQ(actual, expected);
+
+  SDR wrongSize({fast.size + 1u});
+  EXPECT_ANY_THROW(fast.encode(start, wrongSize));
+}
+
+
 TEST(DateEncoderTest, Serialization) {
   DateEncoderParameters p;
   p.verbose = verbose;
@@ -0,0 +1,134 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2019, David McDougall
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Unit tests for the GridCellEncoder
+ */
+
+#include "gtest/gtest.h"
+#include <htm/types/Sdr.hpp>
+#include <htm/encoders/GridCellEncoder.hpp>
+#include <htm/utils/SdrMetrics.hpp>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+using namespace htm;
+
+namespace {
+  GridCellEncoderParameters params(const UInt size, const UInt seed) {
+    GridCellEncoderParameters P;
+    P.size     = size;
+    P.sparsity = 0.25f;
+    P.periods  = { 6.0, 8.5, 12.0, 17.0, 24.0 };
+    P.seed     = seed;
+    return P;
+  }
+}
+
+TEST(GridCellEncoder, testConstruct) {
+  GridCellEncoderParameters P = params( 100u, 0u );
+  P.periods = { 12.0, 6.0 };
+  GridCellEncoder G( P );
+  ASSERT_NE( G.parameters.seed, 0u );
+  ASSERT_EQ( G.parameters.periods, std::vector<Real64>({ 6.0, 12.0 }) );
+
+  P.periods = { 3.0 };
+  EXPECT_ANY_THROW( GridCellEncoder{P} );
+  P.periods.clear();
+  EXPECT_ANY_THROW( GridCellEncoder{P} );
+}
+
+TEST(GridCellEncoder, testSeed) {
+  GridCellEncoder G1( params( 1234u, 42u ) );
+  GridCellEncoder G2( params( 1234u, 43u ) );
+  GridCellEncoder G3( params( 1234u, 43u ) );
+  SDR A( G1.dimensions );
+  SDR B( G2.dimensions );
+  SDR C( G3.dimensions );
+  G1.encode( {2.0, 4.0 / 3.0}, A );
+  G2.encode( {2.0, 4.0 / 3.0}, B );
+  G3.encode( {2.0, 4.0 / 3.0}, C );
+  ASSERT_NE( A, B ); // Made from different seeds.
+  ASSERT_EQ( B, C ); // Made from different encoders with same seed.
+}
+
+TEST(GridCellEncoder, testDeterminism) {
+  // Same encoding as the python htm.encoders.grid_cell_encoder
+  GridCellEncoder G( params( 200u, 42u ) );
+  SDR A( G.dimensions );
+  G.encode( {77.0, 88.0}, A );
+  ASSERT_EQ( A.getSparse(), SDR_sparse_t({
+      8, 11, 13, 15, 16, 18, 29, 32, 37, 39, 41, 42, 45, 47, 57, 59, 69,
+      71, 72, 75, 80, 84, 88, 94, 95, 96, 99, 101, 106, 116, 121, 126,
+      128, 135, 139, 143, 149, 150, 158, 159, 160, 171, 176, 178, 182,
+      184, 188, 194, 197, 198 }) );
+}
+
+TEST(GridCellEncoder, testStatistics) {
+  GridCellEncoder G( params( 200u, 42u ) );
+  SDR A( G.dimensions );
+  Metrics M( A, 999999 );
+  for( int x = 0; x < 1000; x++ ) {
+    G.encode( {(Real64) -x, 0.0}, A );
+  }
+  ASSERT_GT( M.sparsity.min(), 0.25 - 0.02 );
+  ASSERT_LT( M.sparsity.max(), 0.25 + 0.02 );
+  ASSERT_GT( M.activationFrequency.min(), 0.25 - 0.05 );
+  ASSERT_LT( M.activationFrequency.max(), 0.25 + 0.05 );
+  ASSERT_GT( M.overlap.mean(), 0.7 );
+  ASSERT_LT( M.overlap.mean(), 0.8 );
+}
+
+TEST(GridCellEncoder, testNan) {
+  GridCellEncoder G( params( 200u, 42u ) );
+  SDR A( G.dimensions );
+  A.randomize( 0.25f );
+  G.encode( {3.0, std::nan("")}, A );
+  ASSERT_EQ( A.getSum(), 0u );
+  EXPECT_ANY_THROW( G.encode( {3.0}, A ) );
+}
+
+TEST(GridCellEncoder, testEncodeBatch) {
+  GridCellEncoder G( params( 300u, 7u ) );
+  std::vector<std::vector<Real64>> inputs;
+  for( int i = 0; i < 30; i++ ) inputs.push_back({ i * 0.7, 10.0 - i * 1.3 });
+
+  std::vector<SDR> batch;
+  G.encodeBatch( inputs.data(), inputs.size(), batch );
+  ASSERT_EQ( batch.size(), inputs.size() );
+  SDR expected( G.dimensions );
+  for( size_t i = 0; i < inputs.size(); i++ ) {
+    G.encode( inputs[i], expected );
+    ASSERT_EQ( batch[i], expected ) << "input " << i;
+  }
+}
+
+TEST(GridCellEncoder, testSerialize) {
+  GridCellEncoder G1( params( 300u, 0u ) );
+  std::stringstream buf;
+  G1.save( buf );
+
+  GridCellEncoder G2;
+  G2.load( buf );
+  ASSERT_EQ( G2.parameters.seed, G1.parameters.seed );
+  SDR A( G1.dimensions );
+  SDR B( G2.dimensions );
+  G1.encode( {12.5, -7.0}, A );
+  G2.encode( {12.5, -7.0}, B );
+  ASSERT_EQ( A, B );
+}
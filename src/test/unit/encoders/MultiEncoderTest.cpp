@@ -0,0 +1,145 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include <htm/encoders/DateEncoder.hpp>
+#include <htm/encoders/MultiEncoder.hpp>
+#include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <htm/encoders/ScalarEncoder.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+// A record of a scalar, a periodic scalar, an RDSE, an RDSE with a bucket
+// cache and two dates, the second with lookup tables.
+struct RecordFields {
+  vector<shared_ptr<ScalarEncoder>> scalars;
+  vector<shared_ptr<RandomDistributedScalarEncoder>> rdses;
+  vector<shared_ptr<DateEncoder>> dates;
+
+  RecordFields() {
+    ScalarEncoderParameters sp;
+    sp.minimum = 0.0;
+    sp.maximum = 100.0;
+    sp.size = 200u;
+    sp.activeBits = 11u;
+    scalars.push_back(make_shared<ScalarEncoder>(sp));
+    sp.periodic = true;
+    scalars.push_back(make_shared<ScalarEncoder>(sp));
+
+    RDSE_Parameters rp;
+    rp.size = 500u;
+    rp.sparsity = 0.05f;
+    rp.resolution = 1.5f;
+    rp.seed = 7u;
+    rdses.push_back(make_shared<RandomDistributedScalarEncoder>(rp));
+    rdses.push_back(make_shared<RandomDistributedScalarEncoder>(rp));
+    rdses.back()->setCacheSize(4u);
+
+    DateEncoderParameters dp;
+    dp.season_width = 5u;
+    dp.dayOfWeek_width = 2u;
+    dp.timeOfDay_width = 4u;
+    dates.push_back(make_shared<DateEncoder>(dp));
+    dates.push_back(make_shared<DateEncoder>(dp));
+    dates.back()->setLookupTables(true);
+  }
+
+  void addTo(MultiEncoder &record) const {
+    record.addField(scalars[0]);
+    record.addField(scalars[1]);
+    record.addField(rdses[0]);
+    record.addField(rdses[1]);
+    record.addField(dates[0]);
+    record.addField(dates[1]);
+  }
+
+  // The encodings of each field, concatenated.
+  void encode(const vector<Real64> &values, SDR &output) const {
+    vector<SDR> fields;
+    fields.emplace_back(scalars[0]->dimensions);
+    scalars[0]->encode(values[0], fields.back());
+    fields.emplace_back(scalars[1]->dimensions);
+    scalars[1]->encode(values[1], fields.back());
+    fields.emplace_back(rdses[0]->dimensions);
+    rdses[0]->encode(values[2], fields.back());
+    fields.emplace_back(rdses[1]->dimensions);
+    rdses[1]->encode(values[3], fields.back());
+    fields.emplace_back(dates[0]->dimensions);
+    dates[0]->encode(static_cast<time_t>(values[4]), fields.back());
+    fields.emplace_back(dates[1]->dimensions);
+    dates[1]->encode(static_cast<time_t>(values[5]), fields.back());
+    vector<const SDR*> inputs;
+    for(const auto &sdr : fields) inputs.push_back(&sdr);
+    output.concatenate(inputs);
+  }
+};
+
+
+TEST(MultiEncoderTest, MatchesConcatenate) {
+  RecordFields fields, reference;
+  MultiEncoder record;
+  ASSERT_EQ(record.numFields(), 0u);
+  fields.addTo(record);
+  ASSERT_EQ(record.numFields(), 6u);
+  ASSERT_EQ(record.getFieldOffset(0), 0u);
+  ASSERT_EQ(record.getFieldOffset(1), 200u);
+  ASSERT_EQ(record.getFieldSize(2), 500u);
+  ASSERT_EQ(record.size, 200u + 200u + 500u + 500u + 2u * fields.dates[0]->size);
+
+  Random rng(42);
+  SDR expected({ record.size });
+  SDR actual(record.dimensions);
+  for(const UInt threads : { 1u, 3u }) {
+    record.setNumThreads(threads);
+    ASSERT_EQ(record.getNumThreads(), threads);
+    for(int i = 0; i < 100; i++) {
+      const Real64 time = 1577836800.0 + 3600.0 * i;
+      vector<Real64> values = { rng.realRange(0.0f, 100.0f), rng.realRange(0.0f, 100.0f),
+                                rng.realRange(0.0f, 30.0f),  rng.realRange(0.0f, 30.0f),
+                                time, time };
+      if( i % 10 == 3 ) {
+        values[0] = NAN; // missing values encode to no bits
+        values[2] = NAN;
+      }
+      reference.encode(values, expected);
+      record.encode(values, actual);
+      ASSERT_EQ(actual, expected) << "record " << i << " with " << threads << " threads";
+    }
+  }
+}
+
+
+TEST(MultiEncoderTest, Errors) {
+  RecordFields fields;
+  MultiEncoder record;
+  fields.addTo(record);
+  SDR output(record.dimensions);
+  EXPECT_ANY_THROW(record.encode({ 1.0, 2.0 }, output));
+  SDR wrongSize({ record.size + 1u });
+  EXPECT_ANY_THROW(record.encode({ 1.0, 2.0, 3.0, 4.0, 1.0e9, 1.0e9 }, wrongSize));
+  EXPECT_ANY_THROW(record.addField(shared_ptr<ScalarEncoder>()));
+}
+
+} // end namespace testing
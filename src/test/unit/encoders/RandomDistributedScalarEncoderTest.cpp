@@ -22,6 +22,7 @@
 #include "gtest/gtest.h"
 #include <htm/types/Sdr.hpp>
 #include <htm/encoders/RandomDistributedScalarEncoder.hpp>
+#include <cmath>
 #include <string>
 #include <vector>
 
@@ -57,3 +58,61 @@ TEST(RDSE, testSerialize) {
 
   ASSERT_EQ( A, B );
 }
+
+TEST(RDSE, testBucketCache) {
+  RDSE_Parameters P;
+  P.size       = 500;
+  P.activeBits = 40;
+  P.resolution = 1.0f;
+  P.seed       = 42;
+  RDSE plain( P );
+  RDSE cached( P );
+  ASSERT_EQ( cached.getCacheSize(), 0u );
+  cached.setCacheSize( 3u );
+  ASSERT_EQ( cached.getCacheSize(), 3u );
+
+  // Revisits a few buckets, with more buckets than fit into the cache.
+  const std::vector<Real64> inputs({ 1, 2, 1, 1, 3, 2, 4, 5, 1, 2, 3, 4, 5, 5, 5, 0.5, 1.5 });
+  SDR A( plain.dimensions );
+  SDR B( cached.dimensions );
+  for( const auto input : inputs ) {
+    plain.encode( input, A );
+    cached.encode( input, B );
+    ASSERT_EQ( A, B ) << "input " << input;
+  }
+  ASSERT_EQ( cached.getCacheHits() + cached.getCacheMisses(), inputs.size() );
+  ASSERT_GT( cached.getCacheHits(), 0u );
+  ASSERT_GT( cached.getCacheMisses(), 5u ); // evictions
+
+  // NaN does not use the cache.
+  cached.encode( std::nan(""), B );
+  ASSERT_EQ( B.getSum(), 0u );
+  ASSERT_EQ( cached.getCacheHits() + cached.getCacheMisses(), inputs.size() );
+}
+
+TEST(RDSE, testEncodeBatch) {
+  RDSE_Parameters P;
+  P.size       = 2000;
+  P.activeBits = 40;
+  P.resolution = 0.25f;
+  P.seed       = 7;
+  RDSE R( P );
+  std::vector<Real64> inputs;
+  for( int i = 0; i < 200; i++ ) inputs.push_back( i * 0.37 );
+  inputs.push_back( std::nan("") );
+
+  std::vector<SDR> batch;
+  R.encodeBatch( inputs.data(), inputs.size(), batch );
+  ASSERT_EQ( batch.size(), inputs.size() );
+  SDR expected( R.dimensions );
+  for( size_t i = 0; i < inputs.size(); i++ ) {
+    R.encode( inputs[i], expected );
+    ASSERT_EQ( batch[i], expected ) << "input " << inputs[i];
+  }
+
+  // With the bucket cache.
+  R.setCacheSize( 16u );
+  std::vector<SDR> cached;
+  R.encodeBatch( inputs.data(), inputs.size(), cached );
+  ASSERT_EQ( cached, batch );
+}
@@ -25,6 +25,7 @@
 
 #include "gtest/gtest.h"
 #include <htm/encoders/ScalarEncoder.hpp>
+#include <cmath>
 #include <vector>
 
 namespace testing {
@@ -40,6 +41,8 @@ struct ScalarValueCase
 
 void doScalarValueCases(ScalarEncoder& e, std::vector<ScalarValueCase> cases)
 {
+  std::vector<Real64> inputs;
+  std::vector<SDR> expected;
   for( auto c : cases )
   {
     SDR expectedOutput( e.dimensions );
@@ -50,6 +53,16 @@ void doScalarValueCases(ScalarEncoder& e, std::vector<ScalarValueCase> cases)
     e.encode( c.input, actualOutput );
 
     EXPECT_EQ( actualOutput, expectedOutput );
+    inputs.push_back( c.input );
+    expected.push_back( expectedOutput );
+  }
+
+  // The same cases, encoded as one batch.
+  std::vector<SDR> batch;
+  e.encodeBatch( inputs.data(), inputs.size(), batch );
+  ASSERT_EQ( batch.size(), expected.size() );
+  for( size_t i = 0; i < batch.size(); i++ ) {
+    EXPECT_EQ( batch[i], expected[i] ) << "batch input " << inputs[i];
   }
 }
 
@@ -214,4 +227,27 @@ TEST(ScalarEncoder, Serialization) {
   }
 }
 
+
+TEST(ScalarEncoder, EncodeBatchMissingValues) {
+  ScalarEncoderParameters p;
+  p.size       = 50;
+  p.activeBits = 5;
+  p.minimum    = 0.0;
+  p.maximum    = 10.0;
+  ScalarEncoder e( p );
+  const std::vector<Real64> inputs({ 1.0, std::nan(""), 10.0, 3.3 });
+  std::vector<SDR> batch( 2u, SDR({ 7u }) ); // reshaped & resized
+  e.encodeBatch( inputs.data(), inputs.size(), batch );
+  ASSERT_EQ( batch.size(), inputs.size() );
+  for( size_t i = 0; i < inputs.size(); i++ ) {
+    SDR expected( e.dimensions );
+    e.encode( inputs[i], expected );
+    ASSERT_EQ( batch[i], expected );
+  }
+  ASSERT_EQ( batch[1].getSum(), 0u );
+
+  const Real64 outOfRange = 11.0;
+  EXPECT_ANY_THROW( e.encodeBatch( &outOfRange, 1u, batch ) );
+}
+
 }
@@ -21,6 +21,7 @@
  * SimHashDocumentEncoderTest.cpp
  */
 
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -262,6 +263,27 @@ namespace testing {
     ASSERT_EQ(output1.getDense(), output2.getDense());
   }
 
+  // Load an archive written before the fast hash existed, see
+  // src/test/data/README.md. It encodes like the old release did.
+  TEST(SimHashDocumentEncoder, testLoadLegacyArchive) {
+    std::ifstream in(std::string(HTM_TEST_DATA_DIR) + "/SimHashDocumentEncoder.v1.bin", std::ios_base::binary);
+    ASSERT_TRUE(in.good());
+    SimHashDocumentEncoder encoder;
+    encoder.load(in);
+
+    EXPECT_EQ(encoder.parameters.size, 400u);
+    EXPECT_EQ(encoder.parameters.activeBits, 21u);
+    EXPECT_TRUE(encoder.parameters.tokenSimilarity);
+    EXPECT_FALSE(encoder.parameters.fastHash);
+    EXPECT_EQ(encoder.parameters.excludes, std::vector<std::string>({ "bravo" }));
+    EXPECT_EQ(encoder.parameters.vocabulary.size(), 3u);
+
+    SDR output({ encoder.size });
+    encoder.encode({ "alpha", "bravo", "charlie", "delta" }, output);
+    EXPECT_EQ(output.getSparse(), SDR_sparse_t({ 38u, 41u, 64u, 66u, 98u, 105u, 115u, 117u, 118u, 140u,
+      144u, 167u, 202u, 235u, 247u, 267u, 292u, 314u, 323u, 346u, 380u }));
+  }
+
   // Test encoding with case in/sensitivity
   TEST(SimHashDocumentEncoder, testTokenCaseSensitivity) {
     // local test strings
@@ -448,4 +470,110 @@ namespace testing {
     ASSERT_LT(output1.getOverlap(output2), 65u);
   }
 
+  // Test the fast non-cryptographic hash
+  TEST(SimHashDocumentEncoder, testFastHash) {
+    SimHashDocumentEncoderParameters params;
+    params.size = 400u;
+    params.activeBits = 20u;
+    SimHashDocumentEncoder slowEncoder(params);
+    params.fastHash = true;
+    SimHashDocumentEncoder encoder(params);
+
+    SDR output1({ params.size });
+    SDR output2({ params.size });
+    SDR output3({ params.size });
+    SDR repeat({ params.size });
+    encoder.encode(testDoc1, output1);
+    encoder.encode(testDoc2, output2);
+    encoder.encode(testDoc3, output3);
+    encoder.encode(testDoc1, repeat);
+    ASSERT_EQ(output1.getSum(), params.activeBits);
+    ASSERT_EQ(output1, repeat);
+    ASSERT_GT(output1.getOverlap(output2), output1.getOverlap(output3));
+
+    SDR slow({ params.size });
+    slowEncoder.encode(testDoc1, slow);
+    ASSERT_NE(output1, slow);
+
+    // sizes which are not a multiple of the 64 bit words
+    params.size = 70u;
+    params.activeBits = 7u;
+    SimHashDocumentEncoder encoder70(params);
+    SDR output70({ params.size });
+    encoder70.encode(testDoc4, output70);
+    ASSERT_EQ(output70.getSum(), params.activeBits);
+  }
+
+  // Test the token hash cache, it must not change the encodings
+  TEST(SimHashDocumentEncoder, testTokenCache) {
+    for (const bool fastHash : { false, true }) {
+      SimHashDocumentEncoderParameters params;
+      params.size = 400u;
+      params.sparsity = 0.05f;
+      params.tokenSimilarity = true;
+      params.fastHash = fastHash;
+      SimHashDocumentEncoder plain(params);
+      SimHashDocumentEncoder cached(params);
+      ASSERT_EQ(cached.getCacheSize(), 0u);
+
+      SDR expected({ params.size });
+      SDR output({ params.size });
+      // the first cache is smaller than the working set
+      for (const UInt cacheSize : { 4u, 1000u }) {
+        cached.setCacheSize(cacheSize);
+        ASSERT_EQ(cached.getCacheSize(), cacheSize);
+        for (const auto &doc : { testDoc1, testDoc2, testDoc3, testDoc4, testDoc1 }) {
+          plain.encode(doc, expected);
+          cached.encode(doc, output);
+          ASSERT_EQ(output, expected);
+        }
+      }
+      ASSERT_GT(cached.getCacheHits(), 0u);
+      ASSERT_GT(cached.getCacheMisses(), 0u);
+    }
+  }
+
+  // Test the streaming API against encoding the whole window
+  TEST(SimHashDocumentEncoder, testStreaming) {
+    const std::vector<std::string> stream = {
+      "GET", "index", "200", "GET", "login", "302", "POST", "login", "200",
+      "GET", "index", "200", "GET", "GET", "GET", "admin", "403", "noise" };
+    const size_t window = 6u;
+
+    SimHashDocumentEncoderParameters params;
+    params.size = 400u;
+    params.activeBits = 20u;
+    params.tokenSimilarity = true;
+    params.frequencyFloor = 1u;
+    params.frequencyCeiling = 3u;
+    params.excludes = { "noise" };
+    SimHashDocumentEncoder encoder(params);
+    SimHashDocumentEncoder streaming(params);
+
+    SDR expected({ params.size });
+    SDR output({ params.size });
+    streaming.encodeTokens(output);
+    ASSERT_EQ(output.getSum(), 0u);
+
+    for (size_t t = 0u; t < stream.size(); t++) {
+      streaming.addToken(stream[t]);
+      if (t >= window) {
+        streaming.removeToken(stream[t - window]);
+      }
+      const size_t begin = t >= window ? t - window + 1u : 0u;
+      const std::vector<std::string> tokens(stream.begin() + begin, stream.begin() + t + 1u);
+      ASSERT_EQ(streaming.getNumTokens(), tokens.size());
+      encoder.encode(tokens, expected);
+      streaming.encodeTokens(output);
+      ASSERT_EQ(output, expected) << "at token " << t;
+    }
+
+    EXPECT_ANY_THROW(streaming.removeToken("missing"));
+    streaming.clearTokens();
+    ASSERT_EQ(streaming.getNumTokens(), 0u);
+    EXPECT_ANY_THROW(streaming.removeToken("GET"));
+    streaming.encodeTokens(output);
+    ASSERT_EQ(output.getSum(), 0u);
+  }
+
 } // end namespace testing
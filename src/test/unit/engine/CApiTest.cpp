@@ -0,0 +1,204 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of the C API test
+ */
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include <htm/capi/htm.h>
+#include <htm/types/Sdr.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+static const char *SP_TM = R"({network: [
+    {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 256, globalInhibition: true}}},
+    {addRegion: {name: "tm", type: "TMRegion", params: {cellsPerColumn: 4}}},
+    {addLink:   {src: "sp.bottomUpOut", dest: "tm.bottomUpIn"}}]})";
+
+
+TEST(CApiTest, DenseAndSparseInputs) {
+  EXPECT_EQ(static_cast<uint32_t>(HTM_C_API_VERSION), htm_api_version());
+  htm_network *dense, *sparse;
+  ASSERT_EQ(HTM_OK, htm_network_create(&dense));
+  ASSERT_EQ(HTM_OK, htm_network_create(&sparse));
+  ASSERT_EQ(HTM_OK, htm_network_configure(dense, SP_TM)) << htm_last_error();
+  ASSERT_EQ(HTM_OK, htm_network_configure(sparse, SP_TM)) << htm_last_error();
+
+  // The caller owns the input buffers, the networks read them at every run.
+  std::vector<Byte> bits(400u);
+  std::vector<uint32_t> active(400u);
+  size_t numActive = 0u;
+  ASSERT_EQ(HTM_OK, htm_input_bind(dense, "sp", "bottomUpIn", bits.data(), bits.size(), HTM_TYPE_BYTE))
+    << htm_last_error();
+  ASSERT_EQ(HTM_OK, htm_input_bind_sparse(sparse, "sp", "bottomUpIn", active.data(), &numActive, 400u))
+    << htm_last_error();
+  ASSERT_EQ(HTM_OK, htm_network_initialize(dense)) << htm_last_error();
+  ASSERT_EQ(HTM_OK, htm_network_initialize(sparse)) << htm_last_error();
+
+  Random rng(42);
+  SDR input({400u});
+  const void *columns = nullptr;
+  for (int i = 0; i < 10; i++) {
+    input.randomize(0.05f, rng);
+    std::copy(input.getDense().begin(), input.getDense().end(), bits.begin());
+    numActive = input.getSparse().size();
+    std::copy(input.getSparse().begin(), input.getSparse().end(), active.begin());
+    ASSERT_EQ(HTM_OK, htm_network_run(dense, 1u)) << htm_last_error();
+    ASSERT_EQ(HTM_OK, htm_network_run(sparse, 1u)) << htm_last_error();
+
+    htm_sdr_view a, b;
+    ASSERT_EQ(HTM_OK, htm_output_sparse(dense, "sp", "bottomUpOut", &a));
+    ASSERT_EQ(HTM_OK, htm_output_sparse(sparse, "sp", "bottomUpOut", &b));
+    EXPECT_EQ(256u, a.size);
+    ASSERT_GT(a.count, 0u);
+    EXPECT_EQ(std::vector<uint32_t>(a.sparse, a.sparse + a.count),
+              std::vector<uint32_t>(b.sparse, b.sparse + b.count)) << "iteration " << i;
+
+    htm_array_view view;
+    ASSERT_EQ(HTM_OK, htm_output_view(dense, "sp", "bottomUpOut", &view));
+    EXPECT_EQ(HTM_TYPE_SDR, view.type);
+    EXPECT_EQ(256u, view.count);
+    ASSERT_GE(view.num_dimensions, 1u);
+    EXPECT_EQ(256u, view.dimensions[0]);
+    const Byte *columnBits = static_cast<const Byte *>(view.data);
+    for (size_t j = 0u; j < a.count; j++) EXPECT_EQ(1, columnBits[a.sparse[j]]);
+    // The view borrows the same buffer at every run.
+    if (columns != nullptr) {
+      EXPECT_EQ(columns, view.data);
+    }
+    columns = view.data;
+
+    ASSERT_EQ(HTM_OK, htm_output_view(dense, "tm", "bottomUpOut", &view));
+    EXPECT_EQ(256u * 4u, view.count);
+  }
+  htm_network_destroy(dense);
+  htm_network_destroy(sparse);
+}
+
+
+TEST(CApiTest, NumericInput) {
+  htm_network *net;
+  ASSERT_EQ(HTM_OK, htm_network_create(&net));
+  ASSERT_EQ(HTM_OK, htm_network_add_region(net, "encoder", "ScalarEncoderRegion",
+                                           "{size: 100, activeBits: 10, minValue: 0, maxValue: 100}"))
+    << htm_last_error();
+  double value = 10.0;
+  ASSERT_EQ(HTM_OK, htm_input_bind(net, "encoder", "values", &value, 1u, HTM_TYPE_REAL64)) << htm_last_error();
+  ASSERT_EQ(HTM_OK, htm_network_initialize(net)) << htm_last_error();
+
+  ASSERT_EQ(HTM_OK, htm_network_run(net, 1u)) << htm_last_error();
+  htm_sdr_view encoded;
+  ASSERT_EQ(HTM_OK, htm_output_sparse(net, "encoder", "encoded", &encoded));
+  ASSERT_EQ(10u, encoded.count);
+  const uint32_t first = encoded.sparse[0];
+
+  // Read in place: the next value only has to be written into the buffer.
+  value = 90.0;
+  ASSERT_EQ(HTM_OK, htm_network_run(net, 1u)) << htm_last_error();
+  ASSERT_EQ(HTM_OK, htm_output_sparse(net, "encoder", "encoded", &encoded));
+  EXPECT_GT(encoded.sparse[0], first);
+  htm_array_view bucket;
+  ASSERT_EQ(HTM_OK, htm_output_view(net, "encoder", "bucket", &bucket));
+  ASSERT_EQ(HTM_TYPE_REAL64, bucket.type);
+  ASSERT_EQ(1u, bucket.count);
+  EXPECT_LE(static_cast<const double *>(bucket.data)[0], 90.0);
+
+  // Unbound, the input keeps its last value.
+  ASSERT_EQ(HTM_OK, htm_input_unbind(net, "encoder", "values")) << htm_last_error();
+  value = 10.0;
+  ASSERT_EQ(HTM_OK, htm_region_set_real64(net, "encoder", "sensedValue", 50.0)) << htm_last_error();
+  double sensed;
+  ASSERT_EQ(HTM_OK, htm_region_get_real64(net, "encoder", "sensedValue", &sensed));
+  EXPECT_EQ(50.0, sensed);
+  int64_t size;
+  ASSERT_EQ(HTM_OK, htm_region_get_int64(net, "encoder", "size", &size)) << htm_last_error();
+  EXPECT_EQ(100, size);
+  htm_network_destroy(net);
+}
+
+
+TEST(CApiTest, Errors) {
+  EXPECT_EQ(HTM_ERROR_ARGUMENT, htm_network_create(nullptr));
+  EXPECT_NE(std::string(""), htm_last_error());
+  htm_network *net;
+  ASSERT_EQ(HTM_OK, htm_network_create(&net));
+  ASSERT_EQ(HTM_OK, htm_network_configure(net, SP_TM));
+  EXPECT_EQ(HTM_ERROR, htm_network_add_region(net, "x", "NoSuchRegion", ""));
+  EXPECT_NE(std::string::npos, std::string(htm_last_error()).find("NoSuchRegion")) << htm_last_error();
+
+  std::vector<Byte> bits(400u);
+  EXPECT_EQ(HTM_ERROR, htm_input_bind(net, "tm", "bottomUpIn", bits.data(), 256u, HTM_TYPE_BYTE))
+    << "the input is linked";
+  EXPECT_EQ(HTM_ERROR, htm_input_bind(net, "sp", "bottomUpIn", bits.data(), 400u, HTM_TYPE_REAL32))
+    << "an SDR binds bytes";
+  EXPECT_EQ(HTM_ERROR, htm_input_bind(net, "nowhere", "bottomUpIn", bits.data(), 400u, HTM_TYPE_BYTE));
+  EXPECT_EQ(HTM_ERROR, htm_input_unbind(net, "sp", "bottomUpIn")) << "not bound";
+
+  ASSERT_EQ(HTM_OK, htm_input_bind(net, "sp", "bottomUpIn", bits.data(), bits.size(), HTM_TYPE_BYTE));
+  ASSERT_EQ(HTM_OK, htm_network_initialize(net)) << htm_last_error();
+  EXPECT_EQ(HTM_ERROR, htm_input_bind(net, "sp", "bottomUpIn", bits.data(), 300u, HTM_TYPE_BYTE))
+    << "the input has 400 bits";
+  htm_sdr_view view;
+  EXPECT_EQ(HTM_ERROR_ARGUMENT, htm_output_sparse(net, "sp", "bottomUpOut", nullptr));
+  EXPECT_EQ(HTM_ERROR, htm_output_sparse(net, "sp", "noSuchOutput", &view));
+  EXPECT_EQ(HTM_ERROR, htm_region_set_real64(net, "sp", "columnCount", 1.0)) << "not a real";
+  htm_network_destroy(net);
+  htm_network_destroy(nullptr);
+}
+
+
+TEST(CApiTest, InvalidActiveBits) {
+  htm_network *net;
+  ASSERT_EQ(HTM_OK, htm_network_create(&net));
+  ASSERT_EQ(HTM_OK, htm_network_configure(net, SP_TM));
+  std::vector<uint32_t> active(401u);
+  size_t numActive = 0u;
+  ASSERT_EQ(HTM_OK, htm_input_bind_sparse(net, "sp", "bottomUpIn", active.data(), &numActive, 400u));
+  ASSERT_EQ(HTM_OK, htm_network_initialize(net)) << htm_last_error();
+
+  const auto runWith = [&](const std::vector<uint32_t> &bits) {
+    std::copy(bits.begin(), bits.end(), active.begin());
+    numActive = bits.size();
+    return htm_network_run(net, 1u);
+  };
+  EXPECT_EQ(HTM_ERROR_ARGUMENT, runWith({3u, 7u, 400u})) << "out of range";
+  EXPECT_NE(std::string::npos, std::string(htm_last_error()).find("out of range")) << htm_last_error();
+  EXPECT_EQ(HTM_ERROR_ARGUMENT, runWith({7u, 3u, 9u})) << "not sorted";
+  EXPECT_EQ(HTM_ERROR_ARGUMENT, runWith({3u, 3u, 9u})) << "not unique";
+  numActive = active.size();
+  EXPECT_EQ(HTM_ERROR_ARGUMENT, htm_network_run(net, 1u)) << "more active bits than bits";
+  htm_sdr_view columns;
+  ASSERT_EQ(HTM_OK, htm_output_sparse(net, "sp", "bottomUpOut", &columns));
+  EXPECT_EQ(0u, columns.count) << "the regions did not compute";
+
+  std::vector<uint32_t> valid;
+  for (uint32_t i = 0u; i < 400u; i += 10u) valid.push_back(i);
+  EXPECT_EQ(HTM_OK, runWith(valid)) << htm_last_error();
+  ASSERT_EQ(HTM_OK, htm_output_sparse(net, "sp", "bottomUpOut", &columns));
+  EXPECT_GT(columns.count, 0u);
+  htm_network_destroy(net);
+}
+
+} // namespace testing
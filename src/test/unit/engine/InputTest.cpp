@@ -350,4 +350,52 @@ TEST(InputTest, LinkTwoRegionsOneInputFlatten) {
   ASSERT_EQ(expectedData.size(), pa->getCount());
   ASSERT_EQ(expectedData, pa->asVector<Real64>());
 }
-}
\ No newline at end of file
+}
+namespace testing {
+
+TEST(InputTest, FanInSharesSourceBuffers) {
+  Network net;
+  std::shared_ptr<Region> region1 = net.addRegion("region1", "TestNode", "{dim: [4]}");
+  std::shared_ptr<Region> region2 = net.addRegion("region2", "TestNode", "{dim: [4]}");
+  std::shared_ptr<Region> region3 = net.addRegion("region3", "TestNode", "");
+  net.link("region1", "region3");
+  net.link("region2", "region3");
+  net.initialize();
+
+  // The sources write directly into their part of the Fan-In buffer.
+  const Array &in3 = region3->getInput("bottomUpIn")->getData();
+  EXPECT_TRUE(region1->getOutputData("bottomUpOut").isBufferRange(in3, 0));
+  EXPECT_TRUE(region2->getOutputData("bottomUpOut").isBufferRange(in3, 4));
+
+  net.run(2);
+  std::vector<Real64> expectedData = {1.0, 0.0, 1.0, 2.0, 1.0, 0.0, 1.0, 2.0 };
+  ASSERT_EQ(expectedData, in3.asVector<Real64>());
+  ASSERT_EQ(region1->getOutputData("bottomUpOut").asVector<Real64>(),
+            std::vector<Real64>(expectedData.begin(), expectedData.begin() + 4));
+}
+
+TEST(InputTest, SparseFanIn) {
+  Network net;
+  std::shared_ptr<Region> encoder1 = net.addRegion("encoder1", "RDSEEncoderRegion", "{size: 100, seed: 42, activeBits: 10, radius: 1.0}");
+  std::shared_ptr<Region> encoder2 = net.addRegion("encoder2", "RDSEEncoderRegion", "{size: 50, seed: 43, activeBits: 5, radius: 1.0}");
+  std::shared_ptr<Region> sp = net.addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true}");
+  net.link("encoder1", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("encoder2", "sp", "", "", "encoded", "bottomUpIn");
+  net.initialize();
+
+  encoder1->setParameterReal64("sensedValue", 5.0);
+  encoder2->setParameterReal64("sensedValue", 7.0);
+  net.run(1);
+
+  // The active bits of the sources, concatenated at their offsets.
+  SDR_sparse_t expected = encoder1->getOutputData("encoded").getSDR().getSparse();
+  for (const auto index : encoder2->getOutputData("encoded").getSDR().getSparse()) {
+    expected.push_back(index + 100u);
+  }
+  const SDR &in = sp->getInputData("bottomUpIn").getSDR();
+  EXPECT_EQ(150u, in.size);
+  EXPECT_EQ(15u, in.getSum());
+  EXPECT_EQ(expected, in.getSparse());
+}
+
+} // namespace testing
@@ -241,6 +241,48 @@ TEST(LinkTest, DelayedLink) {
 }
 
 
+TEST(LinkTest, DelayedLinkSequence) {
+  // Run the delay queue around several times, each slot is reused.
+  class MyTestNode : public TestNode {
+  public:
+    MyTestNode(const ValueMap &params, Region *region)
+        : TestNode(params, region) {}
+
+    MyTestNode(ArWrapper &wrapper, Region *region) : TestNode(wrapper, region) {}
+
+    std::string getNodeType() { return "MyTestNode"; }
+
+    void compute() override {} // the test writes the output
+  };
+  RegionImplFactory::registerRegion("MyTestNode",
+                    new RegisteredRegionImplCpp<MyTestNode>("MyTestNode"));
+
+  Network net;
+  std::shared_ptr<Region> region1 = net.addRegion("region1", "MyTestNode", "");
+  std::shared_ptr<Region> region2 = net.addRegion("region2", "TestNode", "");
+  region1->setDimensions(Dimensions{4});
+  region2->setDimensions(Dimensions{4});
+  const UInt delay = 3u;
+  net.link("region1", "region2", "", "", "", "", delay);
+  net.initialize();
+
+  const Array &out1 = region1->getOutput("bottomUpOut")->getData();
+  const Array &in2 = region2->getInput("bottomUpIn")->getData();
+  for (UInt i = 0u; i < 4u * delay; i++) {
+    Real64 *odata = (Real64 *)(out1.getBuffer());
+    for (UInt j = 0u; j < out1.getCount(); j++)
+      odata[j] = 10.0 * (i + 1u) + j;
+    net.run(1);
+
+    const Real64 *idata = (const Real64 *)(in2.getBuffer());
+    for (UInt j = 0u; j < in2.getCount(); j++) {
+      const Real64 expected = i < delay ? 0.0 : 10.0 * (i + 1u - delay) + j;
+      ASSERT_EQ(expected, idata[j]) << "iteration " << i << ", element " << j;
+    }
+  }
+  RegionImplFactory::unregisterRegion("MyTestNode");
+}
+
 
 TEST(LinkTest, DelayedLinkSerialization) {
   // serialization test of delayed link.
@@ -745,6 +787,46 @@ private:
 
 
 
+TEST(LinkTest, DelayedSDRLink) {
+  // The queue of an SDR source keeps the active bits of each iteration.
+  Network net;
+  std::shared_ptr<Region> encoder = net.addRegion("encoder", "RDSEEncoderRegion",
+                                                  "{size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}");
+  std::shared_ptr<Region> sp = net.addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true}");
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn", 2);
+  net.initialize();
+
+  std::vector<SDR_sparse_t> encoded;
+  for (UInt i = 0u; i < 5u; i++) {
+    encoder->setParameterReal64("sensedValue", 0.1 * i);
+    net.run(1);
+    encoded.push_back(encoder->getOutputData("encoded").getSDR().getSparse());
+    const SDR &in = sp->getInputData("bottomUpIn").getSDR();
+    if (i < 2u)
+      EXPECT_EQ(in.getSum(), 0u) << "initially all 0's";
+    else
+      EXPECT_EQ(in.getSparse(), encoded[i - 2u]) << "iteration " << i;
+  }
+
+  // The queue is saved and restored.
+  std::stringstream ss;
+  net.save(ss, SerializableFormat::JSON);
+  Network net2;
+  net2.load(ss, SerializableFormat::JSON);
+  std::shared_ptr<Region> encoder2 = net2.getRegion("encoder");
+  for (UInt i = 5u; i < 8u; i++) {
+    encoder->setParameterReal64("sensedValue", 0.1 * i);
+    encoder2->setParameterReal64("sensedValue", 0.1 * i);
+    net.run(1);
+    net2.run(1);
+    encoded.push_back(encoder->getOutputData("encoded").getSDR().getSparse());
+    EXPECT_EQ(sp->getInputData("bottomUpIn").getSDR().getSparse(), encoded[i - 2u]) << "iteration " << i;
+    EXPECT_EQ(net2.getRegion("sp")->getInputData("bottomUpIn").getSDR().getSparse(), encoded[i - 2u])
+        << "restored, iteration " << i;
+  }
+}
+
+
 TEST(LinkTest, L2L4WithDelayedLinksAndPhases) {
   // This test simulates a network with L2 and L4, structured as follows:
   // o R1/R2 ("L4") are in phase 1; R3/R4 ("L2") are in phase 2;
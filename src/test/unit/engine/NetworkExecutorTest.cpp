@@ -0,0 +1,116 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of NetworkExecutor test
+ */
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+
+#include <htm/engine/NetworkExecutor.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/ntypes/Dimensions.hpp>
+#include <htm/utils/Log.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+static std::shared_ptr<Network> makeChain() {
+  auto net = std::make_shared<Network>();
+  Dimensions d;
+  d.push_back(2);
+  net->addRegion("r1", "TestNode", "")->setDimensions(d);
+  net->addRegion("r2", "TestNode", "")->setDimensions(d);
+  net->link("r1", "r2");
+  net->initialize();
+  return net;
+}
+
+static std::atomic<int> numComputes(0);
+static void countCompute(const std::string &) { numComputes++; }
+
+static void throwingCompute(const std::string &name) {
+  NTA_THROW << "compute of " << name << " failed";
+}
+
+TEST(NetworkExecutorTest, Construct) {
+  NetworkExecutor executor(3);
+  ASSERT_EQ(3u, executor.getNumThreads());
+  ASSERT_EQ(0u, executor.size());
+  executor.run(1); // nothing to do
+
+  NetworkExecutor hardware;
+  ASSERT_GE(hardware.getNumThreads(), 1u);
+
+  EXPECT_THROW(executor.add(nullptr), std::exception);
+  EXPECT_THROW(executor.add(makeChain(), 3), std::exception);
+  ASSERT_EQ(0u, executor.add(makeChain(), 2));
+  ASSERT_EQ(1u, executor.add(makeChain()));
+  ASSERT_EQ(2u, executor.size());
+  executor.clear();
+  ASSERT_EQ(0u, executor.size());
+}
+
+TEST(NetworkExecutorTest, RunAll) {
+  NetworkExecutor executor(4);
+  std::vector<std::shared_ptr<Network>> serial;
+  for (size_t i = 0u; i < 25u; i++) {
+    auto net = makeChain();
+    for (const auto &name : {"r1", "r2"}) {
+      net->getRegion(name)->setParameterUInt64("computeCallback", (UInt64)countCompute);
+    }
+    executor.add(net);
+    serial.push_back(makeChain());
+  }
+
+  // Batch every network after the first measurement.
+  executor.setBatchMicroseconds(1.0e6);
+  numComputes = 0;
+  for (int round = 0; round < 3; round++) {
+    executor.run(2);
+  }
+  ASSERT_EQ(25 * 2 * 2 * 3, numComputes.load());
+
+  // The same outputs as one by one.
+  for (size_t i = 0u; i < serial.size(); i++) {
+    serial[i]->run(6);
+    for (const auto &name : {"r1", "r2"}) {
+      EXPECT_EQ(serial[i]->getRegion(name)->getOutputData("bottomUpOut"),
+                executor.getNetwork(i).getRegion(name)->getOutputData("bottomUpOut"))
+          << "network " << i << " region " << name;
+    }
+  }
+}
+
+TEST(NetworkExecutorTest, Exception) {
+  NetworkExecutor executor(2);
+  for (size_t i = 0u; i < 4u; i++) {
+    auto net = makeChain();
+    net->getRegion("r2")->setParameterUInt64("computeCallback",
+        (UInt64)(i == 1u ? throwingCompute : countCompute));
+    executor.add(net);
+  }
+  numComputes = 0;
+  EXPECT_THROW(executor.run(1), std::exception);
+  // The other networks still ran.
+  ASSERT_EQ(3, numComputes.load());
+}
+
+} // namespace testing
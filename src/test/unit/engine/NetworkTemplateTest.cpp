@@ -0,0 +1,141 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of NetworkTemplate test
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include <htm/engine/Network.hpp>
+#include <htm/engine/NetworkTemplate.hpp>
+
+#include <examples/throughput/throughput_network.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+static const std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 400, sparsity: 0.1, radius: 0.5, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 256, globalInhibition: true, seed: 7}}},
+       {addRegion: {name: "tm", type: "TMRegion", params: {cellsPerColumn: 4}, phase: 3}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}},
+       {addLink:   {src: "sp.bottomUpOut", dest: "tm.bottomUpIn"}}
+    ]})";
+
+static void runNetwork(Network &net) {
+  for (int i = 0; i < 5; i++) {
+    net.getRegion("encoder")->setParameterReal64("sensedValue", 0.7 * i);
+    net.run(1);
+  }
+}
+
+TEST(NetworkTemplateTest, SameAsConfigure) {
+  const NetworkTemplate tmpl(config);
+  EXPECT_EQ(tmpl.getRegionCount(), 3u);
+  EXPECT_EQ(tmpl.getLinkCount(), 2u);
+
+  Network configured;
+  configured.configure(config);
+  Network created = tmpl.create();
+  EXPECT_EQ(created.getPhases("tm"), configured.getPhases("tm"));
+  EXPECT_EQ(created.getRegion("sp")->getParameterInt32("seed"), 7);
+
+  configured.initialize();
+  created.initialize();
+  runNetwork(configured);
+  runNetwork(created);
+  EXPECT_EQ(created, configured);
+}
+
+TEST(NetworkTemplateTest, Seeds) {
+  const NetworkTemplate tmpl(config);
+  std::vector<Network> ensemble;
+  // seed 0 is a random seed for the encoder
+  for (Int seed = 1; seed <= 3; seed++) {
+    ensemble.push_back(tmpl.create(seed, true));
+  }
+  for (Int seed = 1; seed <= 3; seed++) {
+    Network &net = ensemble[seed - 1];
+    EXPECT_EQ(net.getRegion("encoder")->getParameterUInt32("seed"), (UInt32)seed);
+    EXPECT_EQ(net.getRegion("sp")->getParameterInt32("seed"), seed);
+    EXPECT_EQ(net.getRegion("tm")->getParameterInt32("seed"), seed);
+    EXPECT_EQ(net.getRegion("sp")->getNetwork(), &net) << "the regions follow the moved network";
+    runNetwork(net);
+  }
+  EXPECT_NE(ensemble[0], ensemble[1]);
+
+  // The instances do not share the parameters of the template.
+  Network fresh = tmpl.create();
+  EXPECT_EQ(fresh.getRegion("sp")->getParameterInt32("seed"), 7);
+}
+
+TEST(NetworkTemplateTest, Validation) {
+  EXPECT_ANY_THROW(NetworkTemplate("{network: [{addRegion: {name: r, type: NoSuchRegion}}]}"));
+  EXPECT_ANY_THROW(NetworkTemplate(R"({network: [
+       {addRegion: {name: "sp", type: "SPRegion"}},
+       {addRegion: {name: "sp", type: "TMRegion"}}]})")) << "duplicate region name";
+  EXPECT_ANY_THROW(NetworkTemplate(R"({network: [
+       {addRegion: {name: "sp", type: "SPRegion"}},
+       {addRegion: {name: "tm", type: "TMRegion"}},
+       {addLink:   {src: "sp.noSuchOutput", dest: "tm.bottomUpIn"}}]})"));
+  EXPECT_ANY_THROW(NetworkTemplate(R"({network: [
+       {addRegion: {name: "sp", type: "SPRegion"}},
+       {addRegion: {name: "tm", type: "TMRegion"}},
+       {addLink:   {src: "sp.bottomUpOut", dest: "tm.noSuchInput"}}]})"));
+
+  // A link to a region outside of the template is resolved when it is applied.
+  const NetworkTemplate tmpl(R"({network: [
+       {addRegion: {name: "tm", type: "TMRegion"}},
+       {addLink:   {src: "sp.bottomUpOut", dest: "tm.bottomUpIn"}}]})");
+  EXPECT_ANY_THROW(tmpl.create());
+  Network net;
+  net.addRegion("sp", "SPRegion", "");
+  tmpl.apply(net);
+  EXPECT_EQ(net.getRegions().size(), 2u);
+}
+
+TEST(NetworkTemplateTest, ThroughputNetwork) {
+  // The chains of the network_throughput benchmark.
+  const std::vector<std::string> prefixes = {"c0_", "c1_"};
+  const NetworkTemplate tmpl(throughput::networkConfig(prefixes, 64, 4, ""));
+  EXPECT_EQ(tmpl.getRegionCount(), 8u);
+  EXPECT_EQ(tmpl.getLinkCount(), 8u);
+  const NetworkTemplate replay(throughput::networkConfig(prefixes, 64, 4, "capture.log"));
+  EXPECT_EQ(replay.getLinkCount(), 8u) << "the links of the ReplayRegion outputs";
+
+  Network net;
+  net.configure(throughput::networkConfig(prefixes, 64, 4, ""));
+  net.initialize();
+  for (int r = 0; r < 20; r++) {
+    for (const auto &p : prefixes)
+      net.getRegion(p + "encoder")->setParameterReal64("sensedValue", 0.1 * (r % 5));
+    net.run(1);
+    // Same inputs and seeds, the chains are independent of each other.
+    EXPECT_EQ(net.getRegion("c0_tm")->getOutputData("bottomUpOut").getSDR(),
+              net.getRegion("c1_tm")->getOutputData("bottomUpOut").getSDR()) << "record " << r;
+    EXPECT_EQ(net.getRegion("c0_classifier")->getOutputData("predicted").item<UInt32>(0),
+              net.getRegion("c1_classifier")->getOutputData("predicted").item<UInt32>(0)) << "record " << r;
+  }
+  EXPECT_GT(net.getRegion("c0_sp")->getOutputData("bottomUpOut").getSDR().getSum(), 0u);
+}
+
+} // namespace testing
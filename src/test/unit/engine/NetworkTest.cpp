@@ -21,13 +21,24 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <future>
+#include <mutex>
+#include <thread>
+
+#include <htm/algorithms/Connections.hpp>
 #include <htm/engine/Network.hpp>
 #include <htm/engine/Region.hpp>
 #include <htm/engine/Input.hpp>
 #include <htm/engine/Output.hpp>
 #include <htm/ntypes/Dimensions.hpp>
 #include <htm/engine/RegionImpl.hpp>
+#include <htm/engine/RegionImplFactory.hpp>
 #include <htm/engine/RegisteredRegionImplCpp.hpp>
+#include <htm/os/Path.hpp>
+#include <htm/regions/TestNode.hpp>
 #include <htm/utils/Log.hpp>
 
 namespace testing {
@@ -338,6 +349,402 @@ TEST(NetworkTest, Phases) {
   computeHistory.clear();
 }
 
+std::mutex parallelHistoryMutex;
+std::vector<std::string> parallelHistory;
+static void recordParallelCompute(const std::string &name) {
+  std::lock_guard<std::mutex> lock(parallelHistoryMutex);
+  parallelHistory.push_back(name);
+}
+
+TEST(NetworkTest, ParallelRun) {
+  // Two independent chains, a1 -> a2 and b1 -> b2, in phases 0 to 3.
+  Network net;
+  std::vector<std::shared_ptr<Region>> regions = {
+      net.addRegion("a1", "TestNode", ""), net.addRegion("a2", "TestNode", ""),
+      net.addRegion("b1", "TestNode", ""), net.addRegion("b2", "TestNode", "")};
+  Dimensions d;
+  d.push_back(2);
+  for (auto r : regions) {
+    r->setDimensions(d);
+  }
+  net.link("a1", "a2");
+  net.link("b1", "b2");
+  net.initialize();
+  for (auto r : regions) {
+    r->setParameterUInt64("computeCallback", (UInt64)recordParallelCompute);
+  }
+
+  ASSERT_EQ(1u, net.getNumThreads());
+  net.setNumThreads(4);
+  ASSERT_EQ(4u, net.getNumThreads());
+  net.setNumThreads(0);
+  ASSERT_GE(net.getNumThreads(), 1u);
+  net.setNumThreads(4);
+
+  parallelHistory.clear();
+  net.run(3);
+  ASSERT_EQ(12u, parallelHistory.size());
+  // Every iteration computes each region once, a linked region after its source.
+  for (size_t iter = 0; iter < 3u; iter++) {
+    const auto begin = parallelHistory.begin() + iter * 4u;
+    const auto end = begin + 4u;
+    const auto at = [&](const std::string &name) { return std::find(begin, end, name); };
+    ASSERT_NE(end, at("a1"));
+    ASSERT_NE(end, at("b1"));
+    ASSERT_LT(at("a1"), at("a2"));
+    ASSERT_LT(at("b1"), at("b2"));
+  }
+
+  // The same outputs as one after the other.
+  Network serial;
+  for (auto r : regions) {
+    serial.addRegion(r->getName(), "TestNode", "")->setDimensions(d);
+  }
+  serial.link("a1", "a2");
+  serial.link("b1", "b2");
+  serial.run(3);
+  for (auto r : regions) {
+    EXPECT_EQ(serial.getRegion(r->getName())->getOutputData("bottomUpOut"),
+              r->getOutputData("bottomUpOut")) << r->getName();
+  }
+}
+
+TEST(NetworkTest, PipelinedRun) {
+  // A chain level1 -> level2 -> level3 with delayed links, and a feedback
+  // link level3 -> level1, which overlap the iterations.
+  const auto build = [](Network &net) {
+    Dimensions d;
+    d.push_back(2);
+    for (const std::string name : {"level1", "level2", "level3"}) {
+      net.addRegion(name, "TestNode", "")->setDimensions(d);
+    }
+    net.link("level1", "level2", "", "", "", "", 1);
+    net.link("level2", "level3", "", "", "", "", 2);
+    net.link("level3", "level1", "", "", "", "", 1);
+    net.initialize();
+  };
+  Network serial;
+  build(serial);
+  Network pipelined;
+  build(pipelined);
+  ASSERT_FALSE(pipelined.isPipelined());
+  pipelined.setNumThreads(3);
+  pipelined.setPipelined(true);
+  ASSERT_TRUE(pipelined.isPipelined());
+
+  for (int n : {1, 7, 4}) {
+    serial.run(n);
+    pipelined.run(n);
+    for (const std::string name : {"level1", "level2", "level3"}) {
+      EXPECT_EQ(serial.getRegion(name)->getOutputData("bottomUpOut"),
+                pipelined.getRegion(name)->getOutputData("bottomUpOut")) << name;
+      EXPECT_EQ(serial.getRegion(name)->getInputData("bottomUpIn"),
+                pipelined.getRegion(name)->getInputData("bottomUpIn")) << name;
+    }
+  }
+}
+
+TEST(NetworkTest, ParallelRunAlgorithms) {
+  // Chains of encoder -> SP -> TM, as the thread_scaling benchmark runs them:
+  // any number of threads computes the same outputs as one.
+  const auto build = [](Network &net, UInt threads) {
+    for (const std::string p : {"a_", "b_", "c_"}) {
+      net.addRegion(p + "encoder", "RDSEEncoderRegion", "{size: 400, sparsity: 0.05, radius: 0.03, seed: 2019}");
+      net.addRegion(p + "sp", "SPRegion", "{columnCount: 128, globalInhibition: true}");
+      net.addRegion(p + "tm", "TMRegion", "{cellsPerColumn: 4}");
+      net.link(p + "encoder", p + "sp", "", "", "encoded", "bottomUpIn");
+      net.link(p + "sp", p + "tm", "", "", "bottomUpOut", "bottomUpIn");
+    }
+    net.setNumThreads(threads);
+    net.initialize();
+  };
+  Network serial, parallel2, parallel4;
+  build(serial, 1u);
+  build(parallel2, 2u);
+  build(parallel4, 4u);
+
+  for (int r = 0; r < 20; r++) {
+    for (Network *net : {&serial, &parallel2, &parallel4}) {
+      int c = 0;
+      for (const std::string p : {"a_", "b_", "c_"}) {
+        net->getRegion(p + "encoder")->setParameterReal64("sensedValue", std::sin(0.3 * r + c++));
+      }
+      net->run(1);
+    }
+    for (const std::string p : {"a_", "b_", "c_"}) {
+      const SDR &expected = serial.getRegion(p + "tm")->getOutputData("bottomUpOut").getSDR();
+      ASSERT_GT(expected.getSum(), 0u);
+      EXPECT_EQ(expected, parallel2.getRegion(p + "tm")->getOutputData("bottomUpOut").getSDR()) << p << r;
+      EXPECT_EQ(expected, parallel4.getRegion(p + "tm")->getOutputData("bottomUpOut").getSDR()) << p << r;
+    }
+  }
+}
+
+static void failCompute(const std::string &name) {
+  NTA_THROW << "compute of " << name << " failed";
+}
+
+TEST(NetworkTest, RunAsync) {
+  // Several networks run concurrently on the executor, with the same results
+  // as run().
+  const auto build = [](Network &net) {
+    net.addRegion("level1", "TestNode", "{dim: [2]}");
+    net.addRegion("level2", "TestNode", "");
+    net.link("level1", "level2");
+    net.initialize();
+  };
+  Network serial;
+  build(serial);
+  serial.run(5);
+
+  std::vector<std::unique_ptr<Network>> nets;
+  std::vector<std::future<void>> runs;
+  std::atomic<int> numDone(0);
+  for (int i = 0; i < 8; i++) {
+    nets.emplace_back(new Network());
+    build(*nets.back());
+    runs.push_back(nets.back()->runAsync(5, [&numDone](std::exception_ptr error) {
+      if (error == nullptr)
+        numDone++;
+    }));
+  }
+  for (size_t i = 0u; i < nets.size(); i++) {
+    runs[i].get();
+    EXPECT_EQ(serial.getRegion("level2")->getOutputData("bottomUpOut"),
+              nets[i]->getRegion("level2")->getOutputData("bottomUpOut"));
+  }
+  EXPECT_EQ(8, numDone.load());
+
+  // The errors of run() reach the callback and the future.
+  Network bad;
+  build(bad);
+  bad.getRegion("level2")->setParameterUInt64("computeCallback", (UInt64)failCompute);
+  std::exception_ptr reported;
+  auto failed = bad.runAsync(1, [&reported](std::exception_ptr error) { reported = error; });
+  EXPECT_ANY_THROW(failed.get());
+  EXPECT_TRUE(reported != nullptr);
+}
+
+TEST(NetworkTest, RunWithDeadline) {
+  Network net;
+  std::shared_ptr<Region> encoder = net.addRegion("encoder", "RDSEEncoderRegion",
+                                                  "{size: 400, activeBits: 20, radius: 5.0, seed: 7}");
+  net.addRegion("sp", "SPRegion", "{columnCount: 256, globalInhibition: true}");
+  std::shared_ptr<Region> tm = net.addRegion("tm", "TMRegion", "{cellsPerColumn: 4}");
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+  std::shared_ptr<const Network::Metrics> metrics = net.getMetrics();
+  EXPECT_ANY_THROW(net.runWithDeadline(0.0));
+
+  // An impossible budget: after the encoder the SP and the TM shed all
+  // optional work, so the TM does not learn.
+  for (int i = 0; i < 10; i++) {
+    encoder->setParameterReal64("sensedValue", static_cast<Real64>(i % 5));
+    net.runWithDeadline(1.0e-9);
+  }
+  EXPECT_EQ(20u, metrics->shedLearning.load());
+  EXPECT_EQ(10u, metrics->deadlineMisses.load());
+  EXPECT_EQ(0u, metrics->segments.load());
+  EXPECT_NO_THROW(tm->getOutputData("predictiveCells")) << "a shed output is produced on demand";
+
+  // A generous budget sheds nothing.
+  for (int i = 0; i < 10; i++) {
+    encoder->setParameterReal64("sensedValue", static_cast<Real64>(i % 5));
+    net.runWithDeadline(60.0);
+  }
+  EXPECT_EQ(20u, metrics->shedLearning.load());
+  EXPECT_EQ(0u, metrics->shedMaintenance.load() + metrics->shedOutputs.load());
+  EXPECT_EQ(10u, metrics->deadlineMisses.load());
+  EXPECT_GT(metrics->segments.load(), 0u);
+}
+
+TEST(NetworkTest, LearnDutyCycle) {
+  Network net;
+  std::shared_ptr<Region> encoder = net.addRegion("encoder", "RDSEEncoderRegion",
+                                                  "{size: 400, activeBits: 20, radius: 5.0, seed: 7}");
+  net.addRegion("sp", "SPRegion", "{columnCount: 256, globalInhibition: true}");
+  std::shared_ptr<Region> tm = net.addRegion("tm", "TMRegion", "{cellsPerColumn: 4}");
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+  std::shared_ptr<const Network::Metrics> metrics = net.getMetrics();
+  EXPECT_ANY_THROW(net.setLearnDutyCycle("encoder", 2u)) << "the encoder does not learn";
+  EXPECT_ANY_THROW(net.setLearnDutyCycle("sp", 0u)) << "never learns";
+  EXPECT_ANY_THROW(net.setLearnDutyCycle("sp", 1u, 0.5f, "encoder")) << "no anomaly output";
+
+  // The SP learns every 4th iteration.
+  net.setLearnDutyCycle("sp", 4u);
+  for (int i = 0; i < 8; i++) {
+    encoder->setParameterReal64("sensedValue", static_cast<Real64>(i % 5));
+    net.run(1);
+  }
+  EXPECT_EQ(6u, metrics->learnSkipped.load());
+
+  // The TM learns only after an anomaly, on novel values all the time; the
+  // first iteration depends on the anomaly of the last one above.
+  net.setLearnDutyCycle("sp", 1u);
+  net.setLearnDutyCycle("tm", 0u, 0.5f);
+  const UInt64 segments = metrics->segments.load();
+  for (int i = 0; i < 8; i++) {
+    encoder->setParameterReal64("sensedValue", 100.0 + 50.0 * i);
+    net.run(1);
+  }
+  EXPECT_LE(metrics->learnSkipped.load(), 7u);
+  EXPECT_GT(metrics->segments.load(), segments);
+
+  // A threshold above any anomaly: the TM does not learn.
+  Network quiet;
+  quiet.addRegion("encoder", "RDSEEncoderRegion", "{size: 400, activeBits: 20, radius: 5.0, seed: 7}");
+  quiet.addRegion("sp", "SPRegion", "{columnCount: 256, globalInhibition: true}");
+  quiet.addRegion("tm", "TMRegion", "{cellsPerColumn: 4}");
+  quiet.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  quiet.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  quiet.setLearnDutyCycle("tm", 0u, 2.0f);
+  quiet.run(8);
+  EXPECT_EQ(8u, quiet.getMetrics()->learnSkipped.load());
+  EXPECT_EQ(0u, quiet.getMetrics()->segments.load());
+  quiet.removeRegion("tm");
+  EXPECT_NO_THROW(quiet.run(1));
+  EXPECT_EQ(8u, quiet.getMetrics()->learnSkipped.load());
+}
+
+TEST(NetworkTest, RunBatch) {
+  // The records feed src, dst computes from them.
+  const auto build = [](Network &net) {
+    net.addRegion("src", "TestNode", "{dim: [2]}");
+    net.addRegion("dst", "TestNode", "");
+    net.link("src", "dst");
+    net.initialize();
+  };
+  Network net;
+  build(net);
+  const size_t width = net.getRegion("src")->getOutputData("bottomUpOut").getCount();
+  const size_t numRecords = 3u;
+  Array records(NTA_BasicType_Real64);
+  records.allocateBuffer(numRecords * width);
+  Real64 *values = (Real64 *)records.getBuffer();
+  for (size_t i = 0u; i < records.getCount(); i++) {
+    values[i] = 0.5 * static_cast<Real64>(i);
+  }
+  std::vector<Array> results;
+  net.runBatch("src.bottomUpOut", records, {"dst.bottomUpOut", "src.bottomUpOut"}, results);
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ(records, results[1]);
+
+  // The same as writing the records one by one, without computing src.
+  Network ref;
+  build(ref);
+  ref.setMinEnabledPhase(1);
+  Array &in = ref.getRegion("src")->getOutput("bottomUpOut")->getData();
+  const Array &out = ref.getRegion("dst")->getOutputData("bottomUpOut");
+  ASSERT_EQ(numRecords * out.getCount(), results[0].getCount());
+  for (size_t row = 0u; row < numRecords; row++) {
+    std::copy(values + row * width, values + (row + 1u) * width, (Real64 *)in.getBuffer());
+    ref.run(1);
+    EXPECT_EQ(out.asVector<Real64>(),
+              results[0].subset(row * out.getCount(), out.getCount()).asVector<Real64>()) << row;
+  }
+
+  EXPECT_THROW(net.runBatch("src", records, {}, results), std::exception);
+  EXPECT_THROW(net.runBatch("src.bottomUpOut", records.subset(0u, width + 1u), {}, results), std::exception);
+}
+
+TEST(NetworkTest, RunBatchSDR) {
+  Network net;
+  net.addRegion("encoder", "RDSEEncoderRegion", "{size: 20, activeBits: 4, radius: 1.0, seed: 1}");
+  net.initialize();
+
+  // Rows of 0/1 into the SDR output, collected back as an SDR of [3, 20].
+  Array records(NTA_BasicType_Byte);
+  records.allocateBuffer(3u * 20u);
+  records.zeroBuffer();
+  Byte *bits = (Byte *)records.getBuffer();
+  bits[1] = bits[7] = bits[20 + 19] = bits[40] = bits[45] = 1;
+  std::vector<Array> results;
+  net.runBatch("encoder.encoded", records, {"encoder.encoded"}, results);
+  ASSERT_EQ(1u, results.size());
+  const SDR &sdr = results[0].getSDR();
+  EXPECT_EQ(std::vector<UInt>({3u, 20u}), sdr.dimensions);
+  EXPECT_EQ(SDR_sparse_t({1u, 7u, 39u, 40u, 45u}), sdr.getSparse());
+}
+
+TEST(NetworkTest, MemoryUsage) {
+  Network net;
+  auto encoder = net.addRegion("encoder", "RDSEEncoderRegion", "{size: 200, sparsity: 0.1, radius: 1.0, seed: 1}");
+  auto sp = net.addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true}");
+  auto tm = net.addRegion("tm", "TMRegion", "{cellsPerColumn: 4, maxSegmentsPerCell: 2}");
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+  const size_t spBefore = sp->memoryUsage();
+  const size_t tmBefore = tm->memoryUsage();
+  EXPECT_GT(spBefore, 0u); // the SP connections are created by initialize()
+
+  const auto run = [&](int n) {
+    for (int i = 0; i < n; i++) {
+      encoder->setParameterReal64("sensedValue", static_cast<Real64>((i * 7) % 30));
+      net.run(1);
+    }
+  };
+  run(50);
+  EXPECT_GT(tm->memoryUsage(), tmBefore) << "the TM grew segments";
+  EXPECT_EQ(encoder->memoryUsage() + sp->memoryUsage() + tm->memoryUsage(), net.memoryUsage());
+
+  // Far above the limit, the regions release what they can and keep running.
+  net.setMemoryLimit(1u, 1u);
+  EXPECT_EQ(1u, net.getMemoryLimit());
+  EXPECT_NO_THROW(run(10));
+}
+
+TEST(NetworkTest, OutputSnapshot) {
+  Network net;
+  Dimensions d;
+  d.push_back(4);
+  net.addRegion("a", "TestNode", "")->setDimensions(d);
+  auto b = net.addRegion("b", "TestNode", "");
+  b->setDimensions(d);
+  net.link("a", "b");
+  EXPECT_THROW(net.publishOutput("b.nosuchoutput"), std::exception);
+  net.publishOutput("b.bottomUpOut");
+  net.publishOutput("b.bottomUpOut");
+  ASSERT_EQ(nullptr, net.getOutputSnapshot());
+
+  net.run(1);
+  auto first = net.getOutputSnapshot();
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ(1u, first->iteration);
+  ASSERT_EQ(1u, first->outputs.size());
+  EXPECT_EQ(b->getOutputData("bottomUpOut"), first->outputs.at("b.bottomUpOut"));
+  const Array kept = first->outputs.at("b.bottomUpOut").copy();
+
+  // A snapshot held by a reader does not change.
+  net.run(2);
+  auto third = net.getOutputSnapshot();
+  EXPECT_EQ(3u, third->iteration);
+  EXPECT_EQ(b->getOutputData("bottomUpOut"), third->outputs.at("b.bottomUpOut"));
+  EXPECT_EQ(kept, first->outputs.at("b.bottomUpOut"));
+  EXPECT_NE(kept, third->outputs.at("b.bottomUpOut"));
+
+  // Read while running.
+  std::atomic<bool> done(false);
+  bool ordered = true;
+  std::thread reader([&]() {
+    UInt64 last = 0u;
+    while (!done) {
+      auto snapshot = net.getOutputSnapshot();
+      ordered = ordered && snapshot->iteration >= last &&
+                snapshot->outputs.at("b.bottomUpOut").getCount() == 4u;
+      last = snapshot->iteration;
+    }
+  });
+  net.run(100);
+  done = true;
+  reader.join();
+  EXPECT_TRUE(ordered);
+  EXPECT_EQ(103u, net.getOutputSnapshot()->iteration);
+}
+
 TEST(NetworkTest, MinMaxPhase) {
   Network n;
   UInt32 minPhase = n.getMinPhase();
@@ -446,6 +853,49 @@ TEST(NetworkTest, MinMaxPhase) {
   EXPECT_STREQ("level2", computeHistory.at(5).c_str());
 }
 
+TEST(NetworkTest, RunPlanFollowsChanges) {
+  // run() keeps a flat plan of the computes & delayed links between runs,
+  // it must follow the regions and links added or removed since.
+  Network net;
+  std::shared_ptr<Region> l1 = net.addRegion("level1", "TestNode", "");
+  std::shared_ptr<Region> l2 = net.addRegion("level2", "TestNode", "");
+  l1->setDimensions(Dimensions{1});
+  l2->setDimensions(Dimensions{1});
+  net.link("level1", "level2");
+  net.initialize();
+  l1->setParameterUInt64("computeCallback", (UInt64)recordCompute);
+  l2->setParameterUInt64("computeCallback", (UInt64)recordCompute);
+  computeHistory.clear();
+  net.run(1);
+  ASSERT_EQ(std::vector<std::string>({"level1", "level2"}), computeHistory);
+
+  // a new region, fed by a delayed link
+  std::shared_ptr<Region> l3 = net.addRegion("level3", "TestNode", "");
+  net.link("level1", "level3", "", "", "", "", 1);
+  net.initialize();
+  l3->setParameterUInt64("computeCallback", (UInt64)recordCompute);
+  computeHistory.clear();
+  std::vector<Real64> previous(l1->getOutputData("bottomUpOut").getCount(), 0.0);
+  for (int i = 0; i < 3; i++) {
+    net.run(1);
+    const Array &in3 = l3->getInputData("bottomUpIn");
+    const Real64 *data3 = (const Real64 *)in3.getBuffer();
+    ASSERT_EQ(previous, std::vector<Real64>(data3, data3 + in3.getCount())) << "iteration " << i;
+    const Array &out1 = l1->getOutputData("bottomUpOut");
+    const Real64 *data1 = (const Real64 *)out1.getBuffer();
+    previous.assign(data1, data1 + out1.getCount());
+  }
+  ASSERT_EQ(std::vector<std::string>({"level1", "level2", "level3", "level1", "level2", "level3",
+                                      "level1", "level2", "level3"}),
+            computeHistory);
+
+  net.removeRegion("level2");
+  computeHistory.clear();
+  net.run(1);
+  ASSERT_EQ(std::vector<std::string>({"level1", "level3"}), computeHistory);
+  computeHistory.clear();
+}
+
 TEST(NetworkTest, Callback) {
   Network n;
   n.addRegion("level1", "TestNode", "");
@@ -510,10 +960,14 @@ TEST(NetworkTest, testEqualsOperator) {
 
 namespace htm {
 // Note: this sort-of mimics the test in network_test.py "testNetworkPickle"
+static int numLinkRegionLoads = 0;
 class LinkRegion : public RegionImpl {
 public:
   LinkRegion(const ValueMap &params, Region *region) : RegionImpl(region) { param = 52; }
-  LinkRegion(ArWrapper &wrapper, Region *region) : RegionImpl(region) { cereal_adapter_load(wrapper);}
+  LinkRegion(ArWrapper &wrapper, Region *region) : RegionImpl(region) {
+    cereal_adapter_load(wrapper);
+    numLinkRegionLoads++;
+  }
 
   void initialize() override {}
   void compute() override {
@@ -585,9 +1039,261 @@ private:
   int param;
 };
 
+// A region which declares itself pure, see RegionImpl::isPure().
+static int numPureComputes = 0;
+class PureRegion : public RegionImpl {
+public:
+  PureRegion(const ValueMap &params, Region *region) : RegionImpl(region) {}
+  PureRegion(ArWrapper &wrapper, Region *region) : RegionImpl(region) {}
+
+  void initialize() override {}
+  void compute() override {
+    numPureComputes++;
+    getInput("UInt32")->getData().convertInto(getOutput("UInt32")->getData());
+  }
+  bool isPure() const override { return true; }
+
+  CerealAdapter;
+  template <class Archive> void save_ar(Archive &ar) const {}
+  template <class Archive> void load_ar(Archive &ar) {}
+
+  static Spec *createSpec() {
+    auto ns = new Spec;
+    ns->description = "PureRegion. Copies its input, for unit tests only.";
+    ns->inputs.add("UInt32", InputSpec("UInt32 Data", NTA_BasicType_UInt32,
+                                       5, false, true, true));
+    ns->outputs.add("UInt32", OutputSpec("UInt32 Data", NTA_BasicType_UInt32,
+                                         5, true, true));
+    return ns;
+  }
+
+  bool operator==(const RegionImpl &other) const override { return true; }
+};
+
+// An async region, see Spec::async.  Outputs the number of its computes.
+static std::vector<std::thread::id> asyncComputeThreads;
+class AsyncRegion : public RegionImpl {
+public:
+  AsyncRegion(const ValueMap &params, Region *region) : RegionImpl(region) {}
+  AsyncRegion(ArWrapper &wrapper, Region *region) : RegionImpl(region) {}
+
+  void initialize() override {}
+  void compute() override {
+    asyncComputeThreads.push_back(std::this_thread::get_id());
+    Array &out = getOutput("UInt32")->getData();
+    std::fill_n(reinterpret_cast<UInt32 *>(out.getBuffer()), out.getCount(),
+                static_cast<UInt32>(asyncComputeThreads.size()));
+  }
+
+  CerealAdapter;
+  template <class Archive> void save_ar(Archive &ar) const {}
+  template <class Archive> void load_ar(Archive &ar) {}
+
+  static Spec *createSpec() {
+    auto ns = new Spec;
+    ns->description = "AsyncRegion. Counts its computes, for unit tests only.";
+    ns->async = true;
+    ns->outputs.add("UInt32", OutputSpec("UInt32 Data", NTA_BasicType_UInt32,
+                                         5, true, true));
+    return ns;
+  }
+
+  bool operator==(const RegionImpl &other) const override { return true; }
+};
+
 } // namespace htm
 
 namespace testing {
+TEST(NetworkTest, SkipUnchangedInputs) {
+  Network net;
+  net.registerRegion("PureRegion", new RegisteredRegionImplCpp<PureRegion>());
+  auto src = net.addRegion("src", "PureRegion", "");
+  auto dest = net.addRegion("dest", "PureRegion", "");
+  net.link("src", "dest");
+  net.initialize();
+
+  // Each region computes once, then its inputs do not change.
+  numPureComputes = 0;
+  net.run(3);
+  EXPECT_EQ(2, numPureComputes);
+
+  // A new input for the source changes the input of the destination.
+  Array data(NTA_BasicType_UInt32);
+  data.allocateBuffer(5);
+  data.zeroBuffer();
+  reinterpret_cast<UInt32 *>(data.getBuffer())[2] = 7u;
+  src->setInputData("UInt32", data);
+  net.run(2);
+  EXPECT_EQ(4, numPureComputes);
+  EXPECT_EQ(data, dest->getOutputData("UInt32"));
+  net.unregisterRegion("PureRegion");
+}
+
+TEST(NetworkTest, AsyncRegion) {
+  Network net;
+  net.registerRegion("AsyncRegion", new RegisteredRegionImplCpp<AsyncRegion>());
+  net.registerRegion("PureRegion", new RegisteredRegionImplCpp<PureRegion>());
+  net.addRegion("src", "AsyncRegion", "");
+  auto dest = net.addRegion("dest", "PureRegion", "");
+  net.link("src", "dest");
+  net.initialize();
+
+  // The source computes ahead on another thread, but not after the last
+  // iteration, and the destination gets the data of each iteration.
+  asyncComputeThreads.clear();
+  numPureComputes = 0;
+  net.run(4);
+  ASSERT_EQ(4u, asyncComputeThreads.size());
+  EXPECT_EQ(std::this_thread::get_id(), asyncComputeThreads.front());
+  EXPECT_NE(std::this_thread::get_id(), asyncComputeThreads.back());
+  EXPECT_EQ(4, numPureComputes);
+  const Array &out = dest->getOutputData("UInt32");
+  for (size_t i = 0u; i < out.getCount(); i++) {
+    EXPECT_EQ(4u, reinterpret_cast<const UInt32 *>(out.getBuffer())[i]);
+  }
+  net.unregisterRegion("AsyncRegion");
+  net.unregisterRegion("PureRegion");
+}
+
+static int numProfiledCallbacks = 0;
+static void countProfiledCallbacks(Network *, UInt64, void *) { numProfiledCallbacks++; }
+
+TEST(NetworkTest, Profiling) {
+  Network net;
+  net.addRegion("level1", "TestNode", "{dim: [4,2]}");
+  net.addRegion("level2", "TestNode", "");
+  net.addRegion("level3", "TestNode", "");
+  net.link("level1", "level2");
+  net.link("level2", "level3", "", "", "", "", 1);
+  net.getCallbacks().add("count", Network::callbackItem(countProfiledCallbacks, nullptr));
+  net.initialize();
+
+  net.run(2); // not profiled
+  EXPECT_EQ(0u, net.getStageProfile(Network::Stage_Iteration).getCount());
+
+  net.enableProfiling();
+  numProfiledCallbacks = 0;
+  net.run(10);
+  EXPECT_EQ(10, numProfiledCallbacks);
+  for (int stage = 0; stage < Network::Stage_NumStages; stage++) {
+    EXPECT_EQ(10u, net.getStageProfile(static_cast<Network::ProfileStage>(stage)).getCount());
+  }
+  const LatencyHistogram &iterations = net.getStageProfile(Network::Stage_Iteration);
+  EXPECT_GT(iterations.getTotal(), 0.0);
+  EXPECT_LE(iterations.percentile(0.5), iterations.percentile(0.99));
+  EXPECT_GE(iterations.getTotal(), net.getStageProfile(Network::Stage_Compute).getTotal());
+  EXPECT_EQ(10u, net.getRegion("level1")->getComputeHistogram().getCount());
+
+  // The delayed link copies into the input and into its queue.
+  const std::shared_ptr<Link> delayed = net.getRegion("level3")->getInput("bottomUpIn")->getLinks()[0];
+  EXPECT_EQ(10u, delayed->getProfile().copies);
+  EXPECT_GT(delayed->getProfile().bytes, 0u);
+  EXPECT_EQ(0u, delayed->getProfile().conversions);
+
+  const std::string report = net.getProfileReport();
+  EXPECT_NE(std::string::npos, report.find("\"callbacks\": {\"count\": 10")) << report;
+  EXPECT_NE(std::string::npos, report.find("\"level2\": {\"compute\"")) << report;
+  EXPECT_NE(std::string::npos, report.find(delayed->getMoniker())) << report;
+
+  net.disableProfiling();
+  net.run(1);
+  EXPECT_EQ(10u, iterations.getCount());
+  net.resetProfiling();
+  EXPECT_EQ(0u, iterations.getCount());
+  EXPECT_EQ(0u, delayed->getProfile().copies);
+}
+
+static size_t countOf(const std::string &text, const std::string &pattern) {
+  size_t count = 0u;
+  for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1u))
+    count++;
+  return count;
+}
+
+TEST(NetworkTest, Tracing) {
+  Network net;
+  net.addRegion("level1", "TestNode", "{dim: [4,2]}");
+  net.addRegion("level2", "TestNode", "");
+  net.addRegion("level3", "TestNode", "");
+  net.link("level1", "level2");
+  net.link("level2", "level3", "", "", "", "", 1);
+  net.initialize();
+
+  net.run(2); // not traced
+  EXPECT_FALSE(net.isTracing());
+  EXPECT_EQ(0u, countOf(net.getTrace(), "\"ph\": \"B\""));
+
+  net.enableTracing();
+  net.run(5);
+  net.disableTracing();
+  net.run(1);
+  const std::string trace = net.getTrace();
+  EXPECT_EQ(5u, countOf(trace, "\"args\": {\"iteration\": "));
+  EXPECT_NE(std::string::npos, trace.find("\"iteration\": 7}")) << trace;
+  EXPECT_EQ(10u, countOf(trace, "\"name\": \"level2\", \"cat\": \"compute\""));
+  const std::shared_ptr<Link> delayed = net.getRegion("level3")->getInput("bottomUpIn")->getLinks()[0];
+  EXPECT_EQ(10u, countOf(trace, "\"name\": \"" + delayed->getMoniker() + "\", \"cat\": \"link\""));
+  EXPECT_EQ(10u, countOf(trace, "\"name\": \"" + delayed->getMoniker() + "\", \"cat\": \"shift\""));
+  EXPECT_EQ(countOf(trace, "\"ph\": \"B\""), countOf(trace, "\"ph\": \"E\""));
+
+  // A small buffer keeps the last events.
+  net.enableTracing(16u);
+  net.run(5);
+  const std::string last = net.getTrace();
+  EXPECT_LE(countOf(last, "\"ph\": \"E\""), countOf(last, "\"ph\": \"B\""));
+  EXPECT_NE(std::string::npos, last.find("\"iteration\": 13}")) << last;
+  EXPECT_EQ(std::string::npos, last.find("\"iteration\": 9}")) << last;
+}
+
+TEST(NetworkTest, Metrics) {
+  Network net;
+  std::shared_ptr<Region> encoder = net.addRegion("encoder", "RDSEEncoderRegion",
+                                                  "{size: 400, activeBits: 20, radius: 5.0, seed: 7}");
+  net.addRegion("sp", "SPRegion", "{columnCount: 256, globalInhibition: true}");
+  net.addRegion("tm", "TMRegion", "{cellsPerColumn: 4}");
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+  net.initialize();
+
+  std::shared_ptr<const Network::Metrics> metrics = net.getMetrics();
+  EXPECT_EQ(0u, metrics->runs.load());
+  for (int i = 0; i < 10; i++) {
+    encoder->setParameterReal64("sensedValue", static_cast<Real64>(i % 5));
+    net.run(1);
+  }
+  net.run(5);
+  EXPECT_EQ(11u, metrics->runs.load());
+  EXPECT_EQ(15u, metrics->iterations.load());
+  UInt64 numRuns = 0u;
+  for (const auto &bucket : metrics->runBuckets) {
+    numRuns += bucket;
+  }
+  EXPECT_EQ(11u, numRuns);
+  EXPECT_GT(metrics->runNanoseconds.load(), 0u);
+  EXPECT_GT(metrics->memoryBytes.load(), 0u);
+
+  // The sums of the Connections of the SP and the TM.
+  UInt64 segments = 0u, synapses = 0u;
+  for (const std::string name : {"sp", "tm"}) {
+    const auto connections = net.getRegion(name)->getConnections();
+    ASSERT_EQ(1u, connections.size());
+    segments += connections[0]->numSegments();
+    synapses += connections[0]->numSynapses();
+  }
+  EXPECT_EQ(0u, net.getRegion("encoder")->getConnections().size());
+  EXPECT_GT(metrics->segments.load(), 256u);
+  EXPECT_EQ(segments, metrics->segments.load());
+  EXPECT_EQ(synapses, metrics->synapses.load());
+
+  // Continue counting into other metrics.
+  std::shared_ptr<Network::Metrics> other = std::make_shared<Network::Metrics>();
+  net.setMetrics(other);
+  net.run(2);
+  EXPECT_EQ(1u, other->runs.load());
+  EXPECT_EQ(2u, other->iterations.load());
+  EXPECT_EQ(11u, metrics->runs.load());
+}
+
 TEST(NetworkTest, SaveRestore) {
   // Note: this sort-of mimics test in network_test.py "testNetworkPickle"
   Network network;
@@ -615,4 +1321,122 @@ TEST(NetworkTest, SaveRestore) {
   ASSERT_STREQ(s1.c_str(), s2.c_str());
 }
 
+TEST(NetworkTest, SaveAsync) {
+  Network network;
+  network.registerRegion("LinkRegion", new RegisteredRegionImplCpp<LinkRegion>());
+  network.addRegion("from", "LinkRegion", "");
+  network.addRegion("to", "LinkRegion", "");
+  network.link("from", "to", "", "", "UInt32", "UInt32");
+  network.initialize();
+
+  const std::string path = "TestOutputDir/NetworkSaveAsync.stream";
+  std::future<void> done = network.saveAsync(path);
+  done.get();
+  EXPECT_FALSE(Path::exists(path + ".tmp")) << "renamed when complete";
+
+  Network network2;
+  network2.loadFromFile(path);
+  EXPECT_TRUE(network == network2);
+  std::string s1 = network.getRegion("to")->executeCommand({"HelloWorld", "26", "64"});
+  std::string s2 = network2.getRegion("to")->executeCommand({"HelloWorld", "26", "64"});
+  EXPECT_EQ(s1, s2);
+
+  EXPECT_ANY_THROW(network.saveAsync(path + "/not/a/dir/net.stream").get());
+}
+
+TEST(NetworkTest, SaveLoadChunkedFile) {
+  Network network;
+  network.registerRegion("LinkRegion", new RegisteredRegionImplCpp<LinkRegion>());
+  network.addRegion("from", "LinkRegion", "");
+  network.addRegion("to", "LinkRegion", "");
+  network.addRegion("other", "LinkRegion", "");
+  network.link("from", "to", "", "", "UInt32", "UInt32");
+  network.link("from", "other", "", "", "Real32", "Real32");
+  network.initialize();
+
+  const std::string path = "TestOutputDir/NetworkChunked.stream";
+  for (const bool compress : {true, false}) {
+    network.setNumThreads(3u); // regions are saved and loaded in parallel
+    network.saveToChunkedFile(path, compress);
+
+    Network network2;
+    network2.setNumThreads(3u);
+    network2.loadFromChunkedFile(path);
+    EXPECT_TRUE(network == network2);
+    EXPECT_EQ(3u, network2.getRegions().size());
+  }
+
+  Network network3;
+  EXPECT_ANY_THROW(network3.loadFromChunkedFile("TestOutputDir/no_such_file.stream"));
+}
+
+TEST(NetworkTest, LazyLoadChunkedFile) {
+  Network network;
+  network.registerRegion("LinkRegion", new RegisteredRegionImplCpp<LinkRegion>());
+  network.addRegion("from", "LinkRegion", "");
+  network.addRegion("to", "LinkRegion", "");
+  network.link("from", "to", "", "", "UInt32", "UInt32");
+  network.initialize();
+  const std::string path = "TestOutputDir/NetworkLazy.stream";
+  network.saveToChunkedFile(path);
+
+  numLinkRegionLoads = 0;
+  Network network2;
+  network2.loadFromChunkedFile(path, true);
+  EXPECT_EQ(0, numLinkRegionLoads) << "the RegionImpls are not loaded yet";
+  EXPECT_EQ(2u, network2.getRegions().size());
+  EXPECT_EQ(network.getRegion("from")->getOutputDimensions("UInt32"),
+            network2.getRegion("from")->getOutputDimensions("UInt32"));
+
+  // first use
+  EXPECT_EQ("Hello World says: arg1=1 arg2=2",
+            network2.getRegion("to")->executeCommand({"HelloWorld", "1", "2"}));
+  EXPECT_EQ(1, numLinkRegionLoads);
+  EXPECT_TRUE(network == network2);
+  EXPECT_EQ(2, numLinkRegionLoads);
+
+  // saving a lazily loaded network saves the same
+  network2.saveToChunkedFile(path);
+  Network network3;
+  network3.loadFromChunkedFile(path);
+  EXPECT_TRUE(network == network3);
+}
+
+
+TEST(NetworkTest, RegionPrototypes) {
+  RegionImplFactory &factory = RegionImplFactory::getInstance();
+  const std::string params = "{columnCount: 64, potentialRadius: 5}";
+  const auto prototype = factory.getPrototype("SPRegion", params);
+  EXPECT_EQ(prototype, factory.getPrototype("SPRegion", params)) << "cached";
+  EXPECT_EQ(factory.getSpec("SPRegion"), prototype->spec);
+  EXPECT_NE(prototype, factory.getPrototype("SPRegion", "{columnCount: 32}"));
+  EXPECT_NE(prototype, factory.getPrototype("TMRegion", params));
+  EXPECT_THROW(factory.getPrototype("nonexistent_nodetype", ""), std::exception);
+  EXPECT_THROW(factory.getPrototype("SPRegion", "[1, 2]"), std::exception);
+
+  // The regions made from one prototype are independent.
+  Network net;
+  auto r1 = net.addRegion("r1", "SPRegion", params);
+  auto r2 = net.addRegion("r2", "SPRegion", params);
+  EXPECT_EQ(64u, r2->getParameterUInt32("columnCount"));
+  r1->setParameterUInt32("potentialRadius", 7u);
+  EXPECT_EQ(7u, r1->getParameterUInt32("potentialRadius"));
+  EXPECT_EQ(5u, r2->getParameterUInt32("potentialRadius"));
+  EXPECT_EQ(5u, net.addRegion("r3", "SPRegion", params)->getParameterUInt32("potentialRadius"));
+
+  auto d1 = net.addRegion("d1", "TestNode", "{dim: [3, 2]}");
+  auto d2 = net.addRegion("d2", "TestNode", "{dim: [3, 2]}");
+  EXPECT_EQ(Dimensions(3u, 2u), d1->getDimensions());
+  EXPECT_EQ(d1->getDimensions(), d2->getDimensions());
+
+  // Registering a type starts over, so no prototype refers to a replaced type.
+  ASSERT_GT(RegionImplFactory::numPrototypes(), 0u);
+  net.registerRegion("PrototypeNode", new RegisteredRegionImplCpp<TestNode>());
+  EXPECT_EQ(0u, RegionImplFactory::numPrototypes());
+  net.addRegion("p1", "PrototypeNode", "");
+  EXPECT_EQ(1u, RegionImplFactory::numPrototypes());
+  net.unregisterRegion("PrototypeNode");
+  EXPECT_EQ(0u, RegionImplFactory::numPrototypes());
+}
+
 } // namespace testing
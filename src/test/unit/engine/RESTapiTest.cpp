@@ -24,6 +24,8 @@
 
 #include "gtest/gtest.h"
 
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -33,6 +35,7 @@
 
 #include <httplib.h>
 #include <examples/rest/server_core.hpp>
+#include <htm/os/Directory.hpp>
 
 namespace testing {
 
@@ -348,4 +351,458 @@ TEST_F(RESTapiTest, alternative_ids) {
 }
 
 
+TEST_F(RESTapiTest, batch) {
+  // Client thread.
+  char message[1000];
+  Value vm;
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 1024, globalInhibition: true}}},
+       {addRegion: {name: "tm", type: "TMRegion", params: {cellsPerColumn: 8}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}},
+       {addLink:   {src: "sp.bottomUpOut", dest: "tm.bottomUpIn"}}
+    ]})";
+  auto res = client->Post("/network", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string id = vm["result"].str();
+
+  // Three records in one request, the anomaly of each iteration comes back.
+  std::string batch = R"({columns: ["encoder.sensedValue"], outputs: ["tm.anomaly", "encoder.bucket"],
+                          data: [[0.01], [0.02], [0.03]]})";
+  snprintf(message, sizeof(message), "/network/%s/batch", id.c_str());
+  res = client->Post(message, batch, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << " POST batch message failed.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  ASSERT_EQ(vm["result"].size(), 3u) << "One entry per record";
+  ASSERT_EQ(vm["result"][2].size(), 2u) << "One array per output";
+  EXPECT_STREQ(vm["result"][0][0][0].c_str(), "1") << "The first anomaly score";
+
+  // The encoder saw the last record.
+  snprintf(message, sizeof(message), "/network/%s/region/encoder/param/sensedValue", id.c_str());
+  res = client->Get(message);
+  vm.parse(res->body);
+  EXPECT_NEAR(vm["result"].as<Real64>(), 0.03, 1e-9);
+
+  // Unknown names are reported, not run.
+  batch = R"({columns: ["encoder.noSuchThing"], data: [[1]]})";
+  snprintf(message, sizeof(message), "/network/%s/batch", id.c_str());
+  res = client->Post(message, batch, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << " POST batch message failed.";
+  vm.parse(res->body);
+  EXPECT_TRUE(vm.contains("err")) << "Expected an error for an unknown column.";
+}
+
+
+TEST_F(RESTapiTest, binary) {
+  // Client thread.
+  char message[1000];
+  Value vm;
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 1000, sparsity: 0.02, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 1024, globalInhibition: true}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}}
+    ]})";
+  auto res = client->Post("/network", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string id = vm["result"].str();
+  snprintf(message, sizeof(message), "/network/%s/run", id.c_str());
+  res = client->Get(message);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET run message failed.";
+
+  // The encoded SDR as JSON and as binary.
+  snprintf(message, sizeof(message), "/network/%s/region/encoder/output/encoded", id.c_str());
+  res = client->Get(message);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET output message failed.";
+  vm.parse(res->body);
+  std::vector<UInt> dense = vm["result"].asVector<UInt>();
+  const httplib::Headers binary = {{"Accept", "application/octet-stream"}};
+  res = client->Get(message, binary);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET binary output message failed.";
+  EXPECT_EQ(res->get_header_value("Content-Type"), "application/octet-stream");
+  EXPECT_LT(res->body.size(), 100u) << "The binary SDR is its active bits, not a dense JSON array.";
+  Array encoded;
+  encoded.fromBinary(res->body);
+  ASSERT_EQ(encoded.getType(), NTA_BasicType_SDR);
+  ASSERT_EQ(encoded.getCount(), dense.size());
+  for (const auto index : encoded.getSDR().getSparse())
+    EXPECT_EQ(dense[index], 1u);
+
+  // Send it back as a binary input, and read that back.
+  snprintf(message, sizeof(message), "/network/%s/region/sp/input/bottomUpIn", id.c_str());
+  res = client->Put(message, encoded.toBinary(), "application/octet-stream");
+  ASSERT_TRUE(res && res->status / 100 == 2) << " PUT binary input message failed.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  res = client->Get(message, binary);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET binary input message failed.";
+  Array input;
+  input.fromBinary(res->body);
+  EXPECT_EQ(input.getSDR().getSparse(), encoded.getSDR().getSparse());
+
+  // A binary SDR with an index past its size is rejected: type, 1 dimension of
+  // 1000 bits (varint 0xE8 0x07), 1 index at 2000 (varint 0xD0 0x0F).
+  const std::string outOfRange = {static_cast<char>(NTA_BasicType_SDR), 1, '\xE8', 7, 1, '\xD0', 15};
+  EXPECT_ANY_THROW(input.fromBinary(outOfRange));
+  res = client->Put(message, outOfRange, "application/octet-stream");
+  ASSERT_TRUE(res != nullptr) << " PUT binary input message failed.";
+  EXPECT_EQ(res->status, 400);
+  vm.parse(res->body);
+  EXPECT_TRUE(vm.contains("err")) << "Expected an error for an index out of range.";
+
+  // Errors are JSON.
+  snprintf(message, sizeof(message), "/network/%s/region/encoder/output/noSuchOutput", id.c_str());
+  res = client->Get(message, binary);
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET binary output message failed.";
+  vm.parse(res->body);
+  EXPECT_TRUE(vm.contains("err")) << "Expected an error for an unknown output.";
+}
+
+
+TEST_F(RESTapiTest, concurrent) {
+  // Two clients, each running its own Network object at the same time.
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 1024, globalInhibition: true}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}}
+    ]})";
+  std::vector<std::string> ids;
+  for (int n = 0; n < 2; n++) {
+    auto res = client->Post("/network", config, "application/json");
+    ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+    Value vm;
+    vm.parse(res->body);
+    ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+    ids.push_back(vm["result"].str());
+  }
+
+  std::vector<std::string> errors(ids.size());
+  std::vector<std::thread> clients;
+  for (size_t n = 0; n < ids.size(); n++) {
+    clients.emplace_back([&, n]() {
+      httplib::Client cli(host, port);
+      cli.set_timeout_sec(30);
+      char message[1000];
+      Value vm;
+      for (int e = 0; e < 10; e++) {
+        snprintf(message, sizeof(message), "/network/%s/region/encoder/param/sensedValue?data=%.02f",
+                 ids[n].c_str(), 0.1 * e);
+        auto res = cli.Put(message, httplib::Params());
+        snprintf(message, sizeof(message), "/network/%s/run", ids[n].c_str());
+        if (res) res = cli.Get(message);
+        if (!res) { errors[n] = "No response from server."; return; }
+        vm.parse(res->body);
+        if (vm.contains("err")) { errors[n] = vm["err"].str(); return; }
+      }
+    });
+  }
+  for (auto &t : clients)
+    t.join();
+  for (size_t n = 0; n < ids.size(); n++)
+    EXPECT_TRUE(errors[n].empty()) << "Network " << ids[n] << ": " << errors[n];
+
+  // Both networks saw all of their records.
+  for (const auto &id : ids) {
+    std::string path = "/network/" + id + "/region/encoder/param/sensedValue";
+    auto res = client->Get(path.c_str());
+    ASSERT_TRUE(res && res->status / 100 == 2) << " GET param message failed.";
+    Value vm;
+    vm.parse(res->body);
+    EXPECT_NEAR(vm["result"].as<Real64>(), 0.9, 1e-9);
+  }
+}
+
+
+TEST_F(RESTapiTest, subscribe) {
+  // Client thread.
+  char message[1000];
+  Value vm;
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}}},
+    ]})";
+  auto res = client->Post("/network", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string id = vm["result"].str();
+
+  // The events of a subscription, read directly.
+  RESTapi *interface = RESTapi::getInstance();
+  std::string subscription, event;
+  ASSERT_FALSE(interface->subscribe_request(id, "encoder.noSuchOutput", subscription));
+  ASSERT_TRUE(interface->subscribe_request(id, "encoder.bucket", subscription)) << subscription;
+  EXPECT_TRUE(interface->next_event(subscription, event, 0u));
+  EXPECT_TRUE(event.empty()) << "No iteration yet.";
+  EXPECT_STREQ(interface->run_request(id, "2").c_str(), "{\"result\": \"OK\"}");
+  for (int i = 1; i <= 2; i++) {
+    ASSERT_TRUE(interface->next_event(subscription, event, 0u));
+    vm.parse(event);
+    EXPECT_EQ(vm["iteration"].as<int>(), i);
+    EXPECT_TRUE(vm.contains("encoder.bucket"));
+  }
+  EXPECT_STREQ(interface->unsubscribe_request(subscription).c_str(), "{\"result\": \"OK\"}");
+  EXPECT_FALSE(interface->next_event(subscription, event, 0u));
+
+  // The events streamed by the server.
+  std::string received;
+  std::atomic<size_t> numReceived(0u);
+  std::thread listener([&]() {
+    httplib::Client cli(host, port);
+    cli.set_timeout_sec(30);
+    std::string path = "/network/" + id + "/subscribe?outputs=encoder.encoded,encoder.bucket";
+    cli.Get(path.c_str(), [&](const char *data, size_t len) {
+      received.append(data, len);
+      numReceived = static_cast<size_t>(std::count(received.begin(), received.end(), '\n'));
+      return numReceived < 3u; // stop after 3 events
+    });
+  });
+  // Run until the subscription is in place and 3 events were pushed.
+  snprintf(message, sizeof(message), "/network/%s/run", id.c_str());
+  for (int i = 0; i < 100; i++) {
+    res = client->Get(message);
+    ASSERT_TRUE(res && res->status / 100 == 2) << " GET run message failed.";
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    if (numReceived >= 3u) break;
+  }
+  listener.join();
+  std::vector<std::string> lines = Path::split(received, '\n');
+  ASSERT_GE(lines.size(), 3u);
+  vm.parse(lines[0]);
+  EXPECT_TRUE(vm.contains("encoder.encoded"));
+  EXPECT_TRUE(vm.contains("encoder.bucket"));
+}
+
+
+TEST_F(RESTapiTest, eviction) {
+  // A budget so small that only the network in use stays resident.
+  RESTapi *interface = RESTapi::getInstance();
+  Directory::removeTree("TestOutputDir", true);
+  interface->set_memory_budget(1u, "TestOutputDir/evicted");
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 1024, globalInhibition: true}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}}
+    ]})";
+  Value vm;
+  vm.parse(interface->create_network_request("evict1", config));
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  interface->put_param_request("evict1", "encoder", "sensedValue", "0.25");
+  EXPECT_STREQ(interface->run_request("evict1", "3").c_str(), "{\"result\": \"OK\"}");
+  std::string before = interface->get_output_request("evict1", "sp", "bottomUpOut");
+
+  // The second network evicts the first one.
+  vm.parse(interface->create_network_request("evict2", config));
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  EXPECT_STREQ(interface->run_request("evict2", "1").c_str(), "{\"result\": \"OK\"}");
+  EXPECT_FALSE(Directory::empty("TestOutputDir/evicted"));
+
+  // The first network is reloaded as it was.
+  EXPECT_EQ(interface->get_output_request("evict1", "sp", "bottomUpOut"), before);
+  vm.parse(interface->get_param_request("evict1", "encoder", "sensedValue"));
+  EXPECT_NEAR(vm["result"].as<Real64>(), 0.25, 1e-9);
+
+  interface->set_memory_budget(0u, "");
+  EXPECT_STREQ(interface->delete_network_request("evict1").c_str(), "{\"result\": \"OK\"}");
+  EXPECT_STREQ(interface->delete_network_request("evict2").c_str(), "{\"result\": \"OK\"}");
+  EXPECT_TRUE(Directory::empty("TestOutputDir/evicted"));
+  Directory::removeTree("TestOutputDir", true);
+}
+
+
+TEST_F(RESTapiTest, pipeline) {
+  // Client thread.
+  Value vm;
+
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}}},
+    ]})";
+  auto res = client->Post("/network", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string id = vm["result"].str();
+
+  // Three records and the final output in one request.
+  std::string body;
+  for (int i = 1; i <= 3; i++) {
+    rest_pipeline::appendOperation(body, "PUT", "/network/" + id + "/region/encoder/param/sensedValue?data=0." + std::to_string(i));
+    rest_pipeline::appendOperation(body, "GET", "/network/" + id + "/run");
+  }
+  rest_pipeline::appendOperation(body, "GET", "/network/" + id + "/region/encoder/param/sensedValue");
+  rest_pipeline::appendOperation(body, "DELETE", "/network/" + id + "/ALL");
+  res = client->Post("/pipeline", body, "application/octet-stream");
+  ASSERT_TRUE(res && res->status / 100 == 2) << " POST pipeline message failed.";
+
+  std::vector<std::string> responses;
+  std::string frame;
+  size_t offset = 0u;
+  while (rest_pipeline::nextFrame(res->body, offset, frame))
+    responses.push_back(frame);
+  EXPECT_EQ(offset, res->body.size());
+  ASSERT_EQ(responses.size(), 8u) << "One response per operation";
+  for (size_t i = 0; i < 6; i++) {
+    vm.parse(responses[i]);
+    EXPECT_STREQ(vm["result"].c_str(), "OK") << "Response " << i << ": " << responses[i];
+  }
+  vm.parse(responses[6]);
+  EXPECT_NEAR(vm["result"].as<Real64>(), 0.3, 1e-9);
+  vm.parse(responses[7]);
+  EXPECT_TRUE(vm.contains("err")) << "DELETE is not supported in a pipeline.";
+}
+
+
+TEST_F(RESTapiTest, trace) {
+  Value vm;
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 1024, globalInhibition: true}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}}
+    ]})";
+  auto res = client->Post("/network", config, "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST /network request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string id = vm["result"].str();
+
+  res = client->Get(("/network/" + id + "/trace/start?capacity=1000").c_str());
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET trace/start message failed.";
+  EXPECT_STREQ(res->body.c_str(), "{\"result\": \"OK\"}\n");
+  res = client->Get(("/network/" + id + "/run?iterations=3").c_str());
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET run message failed.";
+  res = client->Get(("/network/" + id + "/trace/stop").c_str());
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET trace/stop message failed.";
+
+  res = client->Get(("/network/" + id + "/trace/get").c_str());
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET trace/get message failed.";
+  EXPECT_NE(res->body.find("\"traceEvents\""), std::string::npos) << res->body;
+  EXPECT_NE(res->body.find("\"name\": \"sp\", \"cat\": \"compute\""), std::string::npos) << res->body;
+  EXPECT_NE(res->body.find("\"cat\": \"link\""), std::string::npos) << res->body;
+  EXPECT_NE(res->body.find("\"args\": {\"iteration\": 3}"), std::string::npos) << res->body;
+
+  vm.parse(RESTapi::getInstance()->trace_request(id, "pause"));
+  EXPECT_TRUE(vm.contains("err"));
+  EXPECT_STREQ(RESTapi::getInstance()->delete_network_request(id).c_str(), "{\"result\": \"OK\"}");
+}
+
+TEST_F(RESTapiTest, metrics) {
+  RESTapi *interface = RESTapi::getInstance();
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 1024, globalInhibition: true}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}}
+    ]})";
+  Value vm;
+  vm.parse(interface->create_network_request("metrics1", config));
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  EXPECT_STREQ(interface->run_request("metrics1", "3").c_str(), "{\"result\": \"OK\"}");
+  EXPECT_STREQ(interface->run_request("metrics1", "2").c_str(), "{\"result\": \"OK\"}");
+  std::string subscription;
+  ASSERT_TRUE(interface->subscribe_request("metrics1", "sp.bottomUpOut", subscription)) << subscription;
+  EXPECT_STREQ(interface->run_request("metrics1", "1").c_str(), "{\"result\": \"OK\"}");
+
+  auto res = client->Get("/metrics");
+  ASSERT_TRUE(res && res->status / 100 == 2) << " GET metrics message failed.";
+  const std::string &body = res->body;
+  EXPECT_NE(body.find("# TYPE htm_network_run_seconds histogram\n"), std::string::npos) << body;
+  EXPECT_NE(body.find("htm_network_iterations_total{network=\"metrics1\"} 6\n"), std::string::npos) << body;
+  EXPECT_NE(body.find("htm_network_run_seconds_count{network=\"metrics1\"} 3\n"), std::string::npos) << body;
+  EXPECT_NE(body.find("htm_network_run_seconds_bucket{network=\"metrics1\",le=\"+Inf\"} 3\n"), std::string::npos) << body;
+  EXPECT_NE(body.find("htm_network_segments{network=\"metrics1\"} 1024\n"), std::string::npos) << body;
+  EXPECT_NE(body.find("htm_network_resident{network=\"metrics1\"} 1\n"), std::string::npos) << body;
+  EXPECT_NE(body.find("htm_network_subscription_queue_depth{network=\"metrics1\"} 1\n"), std::string::npos) << body;
+  EXPECT_EQ(body.find("htm_network_memory_bytes{network=\"metrics1\"} 0\n"), std::string::npos) << body;
+
+  EXPECT_STREQ(interface->unsubscribe_request(subscription).c_str(), "{\"result\": \"OK\"}");
+  EXPECT_STREQ(interface->delete_network_request("metrics1").c_str(), "{\"result\": \"OK\"}");
+  EXPECT_EQ(interface->metrics_request().find("network=\"metrics1\""), std::string::npos);
+}
+
+
+// Polls the status of a job until it is in @p state, returns the last status.
+static std::string waitForJob(const std::string &job, const std::string &state) {
+  RESTapi *interface = RESTapi::getInstance();
+  std::string status;
+  for (int i = 0; i < 1000; i++) {
+    status = interface->job_status_request(job);
+    Value vm;
+    vm.parse(status);
+    if (vm.contains("err") || vm["result"]["state"].str() == state)
+      break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return status;
+}
+
+TEST_F(RESTapiTest, asyncRun) {
+  RESTapi *interface = RESTapi::getInstance();
+  interface->set_job_limits(1u);
+  std::string config = R"(
+   {network: [
+       {addRegion: {name: "encoder", type: "RDSEEncoderRegion", params: {size: 1000, sparsity: 0.2, radius: 0.03, seed: 2019}}},
+       {addRegion: {name: "sp", type: "SPRegion", params: {columnCount: 1024, globalInhibition: true}}},
+       {addLink:   {src: "encoder.encoded", dest: "sp.bottomUpIn"}}
+    ]})";
+  Value vm;
+  vm.parse(interface->create_network_request("job1", config));
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+
+  // A long run, served while it progresses, then cancelled.
+  auto res = client->Post("/network/job1/run?iterations=1000000&async=1", "", "application/json");
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to POST run request.";
+  vm.parse(res->body);
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  std::string job = vm["result"].str();
+  vm.parse(interface->run_async_request("job1", "10"));
+  EXPECT_TRUE(vm.contains("err")) << "A second job of the network is refused.";
+  vm.parse(waitForJob(job, "running"));
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  EXPECT_EQ(vm["result"]["network"].str(), "job1");
+  EXPECT_EQ(vm["result"]["total"].as<UInt64>(), 1000000u);
+  vm.parse(interface->get_output_request("job1", "sp", "bottomUpOut"));
+  EXPECT_FALSE(vm.contains("err")) << "Requests are served during the run.";
+
+  res = client->Delete(("/job/" + job).c_str());
+  ASSERT_TRUE(res && res->status / 100 == 2) << "Failed Response to DELETE job request.";
+  EXPECT_EQ(res->body, "{\"result\": \"OK\"}\n");
+  vm.parse(waitForJob(job, "cancelled"));
+  ASSERT_EQ(vm["result"]["state"].str(), "cancelled");
+  EXPECT_LT(vm["result"]["iterations"].as<UInt64>(), 1000000u);
+
+  // A short run to the end.
+  vm.parse(interface->run_async_request("job1", "25"));
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  job = vm["result"].str();
+  vm.parse(waitForJob(job, "done"));
+  ASSERT_EQ(vm["result"]["state"].str(), "done");
+  EXPECT_EQ(vm["result"]["iterations"].as<UInt64>(), 25u);
+
+  // The job of a deleted network fails.
+  vm.parse(interface->run_async_request("job1", "1000000"));
+  ASSERT_FALSE(vm.contains("err")) << "An error returned. " << vm["err"].str();
+  job = vm["result"].str();
+  EXPECT_STREQ(interface->delete_network_request("job1").c_str(), "{\"result\": \"OK\"}");
+  vm.parse(waitForJob(job, "failed"));
+  ASSERT_EQ(vm["result"]["state"].str(), "failed");
+  EXPECT_TRUE(vm["result"].contains("error"));
+
+  vm.parse(interface->job_status_request("no such job"));
+  EXPECT_TRUE(vm.contains("err"));
+}
+
 } // namespace testing
\ No newline at end of file
@@ -0,0 +1,145 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of RemoteLink test
+ */
+
+#include "gtest/gtest.h"
+#include <httplib.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <htm/engine/Network.hpp>
+#include <htm/engine/RemoteLink.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(RemoteLinkTest, Transport) {
+  RemoteLinkReceiver receiver;
+  ASSERT_GT(receiver.getPort(), 0u);
+  RemoteLinkSender sender("127.0.0.1", receiver.getPort());
+
+  Random rng(42);
+  std::vector<SDR> sent(3, SDR({10u, 20u}));
+  for (UInt64 i = 0u; i < sent.size(); i++) {
+    sent[i].randomize(0.1f, rng);
+    sender.send(i + 1u, sent[i]);
+  }
+  EXPECT_EQ(receiver.numPending(), 3u);
+
+  SDR received({10u, 20u});
+  receiver.receive(2u, received);
+  EXPECT_EQ(received, sent[1]);
+  EXPECT_EQ(receiver.numPending(), 1u) << "the older iterations are dropped";
+  receiver.receive(3u, received);
+  EXPECT_EQ(received, sent[2]);
+
+  EXPECT_ANY_THROW(receiver.receive(4u, received, 0.01)) << "timeout";
+  SDR wrongSize({10u});
+  sender.send(4u, wrongSize);
+  EXPECT_ANY_THROW(receiver.receive(4u, received));
+}
+
+TEST(RemoteLinkTest, MalformedMessage) {
+  RemoteLinkReceiver receiver;
+  httplib::Client client("127.0.0.1", static_cast<int>(receiver.getPort()));
+  // iteration, size, count, then the indices
+  const auto frame = [](UInt64 iteration, UInt32 size, const std::vector<UInt32> &sparse) {
+    const UInt32 count = static_cast<UInt32>(sparse.size());
+    std::string message(sizeof(UInt64) + 2u * sizeof(UInt32) + count * sizeof(UInt32), '\0');
+    char *p = &message[0];
+    memcpy(p, &iteration, sizeof(UInt64));  p += sizeof(UInt64);
+    memcpy(p, &size, sizeof(UInt32));       p += sizeof(UInt32);
+    memcpy(p, &count, sizeof(UInt32));      p += sizeof(UInt32);
+    if (count > 0u) memcpy(p, sparse.data(), count * sizeof(UInt32));
+    return message;
+  };
+  const std::vector<std::string> malformed = {
+    frame(1u, 10u, {3u, 12u}),                  // index out of range
+    frame(1u, 10u, {5u, 2u}),                   // not sorted
+    frame(1u, 10u, {4u, 4u}),                   // not unique
+    frame(1u, 2u,  {0u, 1u, 2u}),               // more indices than bits
+    frame(1u, 10u, {1u}).substr(0u, 17u),       // truncated
+  };
+  for (const auto &message : malformed) {
+    const auto res = client.Post("/link", message, "application/octet-stream");
+    ASSERT_TRUE(res != nullptr);
+    EXPECT_EQ(res->status, 400);
+  }
+  EXPECT_EQ(receiver.numPending(), 0u) << "malformed messages are dropped";
+
+  const auto res = client.Post("/link", frame(1u, 10u, {2u, 7u}), "application/octet-stream");
+  ASSERT_TRUE(res != nullptr);
+  EXPECT_EQ(res->status / 100, 2);
+  SDR received({10u});
+  receiver.receive(1u, received);
+  EXPECT_EQ(received.getSparse(), SDR_sparse_t({2u, 7u}));
+}
+
+// Two networks, as they would run on two hosts:
+//    encoder => RemoteOutputRegion  ~~TCP~~>  RemoteInputRegion => sp
+TEST(RemoteLinkTest, Networks) {
+  const UInt32 delay = 2u;
+  const int iterations = 20;
+
+  Network receiving;
+  auto in = receiving.addRegion("remote", "RemoteInputRegion",
+                                "{dim: [400], propagationDelay: " + std::to_string(delay) + "}");
+  receiving.addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true}");
+  receiving.link("remote", "sp", "", "", "dataOut", "bottomUpIn");
+  const UInt32 port = in->getParameterUInt32("port");
+
+  Network sending;
+  auto encoder = sending.addRegion("encoder", "RDSEEncoderRegion", "{size: 400, sparsity: 0.1, radius: 0.5, seed: 3}");
+  sending.addRegion("send", "RemoteOutputRegion", "{host: 127.0.0.1, port: " + std::to_string(port) + "}");
+  sending.link("encoder", "send", "", "", "encoded", "dataIn");
+
+  sending.initialize();
+  receiving.initialize();
+
+  // The sender runs ahead on its own thread.
+  std::vector<SDR> sent;
+  std::thread sender([&]() {
+    for (int i = 0; i < iterations; i++) {
+      encoder->setParameterReal64("sensedValue", 0.7 * i);
+      sending.run(1);
+      sent.push_back(encoder->getOutputData("encoded").getSDR());
+    }
+  });
+  std::vector<SDR> received;
+  for (int i = 0; i < iterations; i++) {
+    receiving.run(1);
+    received.push_back(in->getOutputData("dataOut").getSDR());
+  }
+  sender.join();
+
+  for (int i = 0; i < iterations; i++) {
+    if (i < (int)delay) {
+      EXPECT_EQ(received[i].getSum(), 0u) << "nothing arrived this far back";
+    } else {
+      EXPECT_EQ(received[i], sent[i - delay]) << "iteration " << i;
+    }
+  }
+}
+
+} // namespace testing
@@ -0,0 +1,100 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include <thread>
+
+#include "gtest/gtest.h"
+
+#include "htm/engine/Tracer.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+TEST(TracerTest, Events) {
+  Tracer tracer(16u);
+  const UInt32 a = tracer.intern("a");
+  const UInt32 b = tracer.intern("b \"quoted\"");
+  EXPECT_EQ(a, tracer.intern("a"));
+  EXPECT_NE(a, b);
+  {
+    Tracer::Scope outer(&tracer, a, Tracer::Cat_Iteration, 42u);
+    Tracer::Scope inner(&tracer, b, Tracer::Cat_Compute);
+  }
+  { Tracer::Scope none(nullptr, a, Tracer::Cat_Compute); }
+  EXPECT_EQ(4u, tracer.getCount());
+  EXPECT_EQ(0u, tracer.getDropped());
+
+  const std::string json = tracer.toJSON();
+  EXPECT_NE(std::string::npos, json.find("{\"name\": \"a\", \"cat\": \"iteration\", \"ph\": \"B\"")) << json;
+  EXPECT_NE(std::string::npos, json.find("\"args\": {\"iteration\": 42}")) << json;
+  EXPECT_NE(std::string::npos, json.find("{\"name\": \"b \\\"quoted\\\"\", \"cat\": \"compute\", \"ph\": \"E\"")) << json;
+  EXPECT_LT(json.find("\"ph\": \"B\""), json.find("\"ph\": \"E\""));
+}
+
+TEST(TracerTest, RingBuffer) {
+  Tracer tracer(5u);
+  const UInt32 a = tracer.intern("a");
+  for (int i = 0; i < 4; i++) {
+    tracer.begin(a, Tracer::Cat_Compute);
+    tracer.end(a, Tracer::Cat_Compute);
+  }
+  EXPECT_EQ(5u, tracer.getCapacity());
+  EXPECT_EQ(5u, tracer.getCount());
+  EXPECT_EQ(3u, tracer.getDropped());
+
+  // The oldest event kept is an end, whose begin was dropped.
+  const std::string json = tracer.toJSON();
+  size_t numBegin = 0u, numEnd = 0u;
+  for (size_t pos = json.find("\"ph\": \""); pos != std::string::npos; pos = json.find("\"ph\": \"", pos + 1u)) {
+    const char phase = json[pos + 7u];
+    if (phase == 'B') numBegin++;
+    if (phase == 'E') numEnd++;
+  }
+  EXPECT_EQ(2u, numBegin);
+  EXPECT_EQ(2u, numEnd);
+
+  tracer.reset(8u);
+  EXPECT_EQ(0u, tracer.getCount());
+  EXPECT_EQ(8u, tracer.getCapacity());
+  EXPECT_EQ(a, tracer.intern("a"));
+  EXPECT_ANY_THROW(tracer.reset(0u));
+}
+
+TEST(TracerTest, Threads) {
+  Tracer tracer(1000u);
+  const UInt32 a = tracer.intern("a");
+  std::thread other([&]() {
+    for (int i = 0; i < 100; i++) {
+      Tracer::Scope traced(&tracer, a, Tracer::Cat_Compute);
+    }
+  });
+  for (int i = 0; i < 100; i++) {
+    Tracer::Scope traced(&tracer, a, Tracer::Cat_Link);
+  }
+  other.join();
+  EXPECT_EQ(400u, tracer.getCount());
+  const std::string json = tracer.toJSON();
+  EXPECT_NE(json.find("\"cat\": \"compute\""), std::string::npos);
+  EXPECT_NE(json.find("\"cat\": \"link\""), std::string::npos);
+  // Each thread has its own tid.
+  const size_t tid = json.find("\"tid\": ", json.find("\"cat\": \"link\""));
+  const size_t otherTid = json.find("\"tid\": ", json.find("\"cat\": \"compute\""));
+  EXPECT_NE(json.substr(tid, 10u), json.substr(otherTid, 10u));
+}
+
+} // namespace testing
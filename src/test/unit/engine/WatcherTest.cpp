@@ -255,4 +255,135 @@ TEST(WatcherTest, FileTest2) {
 
   Path::remove("TestOutputDir/testfile2");
 }
+
+TEST(WatcherTest, BinaryFile) {
+  Network n;
+  n.addRegion("level1", "TestNode", "{dim: [4,2]}");
+  n.addRegion("level2", "TestNode", "");
+  n.link("level1", "level2");
+  n.initialize();
+
+  Directory::create("TestOutputDir");
+  const std::string file = "TestOutputDir/testfile.bin";
+  {
+    Watcher w(file, true, 2u);
+    w.watchParam("level1", "uint32Param");
+    w.watchParam("level1", "real64Param");
+    w.watchParam("level1", "stringParam");
+    w.watchParam("level1", "real32ArrayParam");
+    w.watchParam("level1", "int64ArrayParam", -1, false);
+    w.watchOutput("level1", "bottomUpOut");
+    w.attachToNetwork(n);
+    n.run(5);
+    w.detachFromNetwork(n);
+  } // flushed and closed
+
+  WatcherReader r(file);
+  EXPECT_EQ(r.getSampling(), 2u);
+  const auto &watches = r.getWatches();
+  ASSERT_EQ(watches.size(), 6u);
+  EXPECT_EQ(watches[0].regionName, "level1");
+  EXPECT_EQ(watches[0].varName, "uint32Param");
+  EXPECT_EQ(watches[0].nodeIndex, -1);
+  EXPECT_EQ(watches[0].layout, Watcher::Scalar);
+  EXPECT_EQ(watches[2].layout, Watcher::String);
+  EXPECT_EQ(watches[3].layout, Watcher::Sparse);
+  EXPECT_EQ(watches[4].layout, Watcher::Dense);
+  EXPECT_EQ(watches[5].varName, "bottomUpOut");
+  EXPECT_EQ(watches[5].layout, Watcher::Sparse);
+
+  UInt32 watchID;
+  UInt64 iteration;
+  Array value;
+  std::vector<UInt64> iterations;
+  while (r.next(watchID, iteration, value)) {
+    if (watchID == 1u)
+      iterations.push_back(iteration);
+    switch (watchID) {
+    case 1u:
+      EXPECT_EQ(value.asVector<UInt32>(), std::vector<UInt32>({33u}));
+      break;
+    case 2u:
+      EXPECT_EQ(value.asVector<Real64>(), std::vector<Real64>({64.1}));
+      break;
+    case 3u:
+      ASSERT_EQ(value.getCount(), 1u);
+      EXPECT_EQ(static_cast<const std::string *>(value.getBuffer())[0], "nodespec value");
+      break;
+    case 4u:
+      EXPECT_EQ(value.getSDR().size, 8u);
+      EXPECT_EQ(value.getSDR().getSparse(), SDR_sparse_t({1, 2, 3, 4, 5, 6, 7}));
+      break;
+    case 5u:
+      EXPECT_EQ(value.asVector<Int64>(), std::vector<Int64>({0, 64, 128, 192}));
+      break;
+    case 6u:
+      EXPECT_EQ(value.getSDR().size, 8u);
+      if (iteration == 1u)
+        EXPECT_EQ(value.getSDR().getSparse(), SDR_sparse_t({2, 3, 5, 6, 7}));
+      else
+        EXPECT_EQ(value.getSDR().getSparse(), SDR_sparse_t({0, 2, 3, 4, 5, 6, 7}));
+      break;
+    default:
+      FAIL() << "Unexpected watch " << watchID;
+    }
+  }
+  // sampled every 2nd iteration
+  EXPECT_EQ(iterations, std::vector<UInt64>({1u, 3u, 5u}));
+
+  Path::remove(file);
+}
+
+// Capture the source of   encoder -> sp   and replay it in another Network.
+TEST(WatcherTest, CaptureAndReplay) {
+  const int iterations = 10;
+  Directory::create("TestOutputDir");
+  const std::string file = "TestOutputDir/capture.bin";
+
+  std::vector<SDR> encoded, columns;
+  std::vector<std::vector<Real64>> buckets;
+  {
+    Network n;
+    auto encoder = n.addRegion("encoder", "RDSEEncoderRegion", "{size: 400, sparsity: 0.1, radius: 0.5, seed: 3}");
+    auto sp = n.addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true}");
+    n.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+    n.initialize();
+
+    Watcher w(file, true);
+    EXPECT_EQ(w.watchSources(n), 2u) << "encoder.bucket and encoder.encoded";
+    w.attachToNetwork(n);
+    for (int i = 0; i < iterations; i++) {
+      encoder->setParameterReal64("sensedValue", 0.7 * i);
+      n.run(1);
+      encoded.push_back(encoder->getOutputData("encoded").getSDR());
+      buckets.push_back(encoder->getOutputData("bucket").asVector<Real64>());
+      columns.push_back(sp->getOutputData("bottomUpOut").getSDR());
+    }
+    w.detachFromNetwork(n);
+  } // flushed and closed
+
+  Network n;
+  auto replay = n.addRegion("encoder", "ReplayRegion", "{file: \"" + file + "\", loop: false}");
+  auto sp = n.addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true}");
+  n.link("encoder", "sp", "", "", "dataOut", "bottomUpIn");
+  n.initialize();
+  EXPECT_EQ(replay->getParameterString("source"), "encoder");
+  EXPECT_EQ(replay->getParameterString("dataOutput"), "encoded");
+  EXPECT_EQ(replay->getParameterString("valueOutput"), "bucket");
+
+  for (int i = 0; i < iterations; i++) {
+    n.run(1);
+    EXPECT_EQ(replay->getOutputData("dataOut").getSDR(), encoded[i]) << "iteration " << i;
+    EXPECT_EQ(replay->getOutputData("values").asVector<Real64>(), buckets[i]) << "iteration " << i;
+    EXPECT_EQ(sp->getOutputData("bottomUpOut").getSDR(), columns[i]) << "the same workload, the same SP";
+  }
+  EXPECT_EQ(replay->getParameterUInt64("position"), (UInt64)iterations);
+  EXPECT_ANY_THROW(n.run(1)) << "all records were replayed";
+
+  replay->setParameterBool("loop", true);
+  n.run(1);
+  EXPECT_EQ(replay->getOutputData("dataOut").getSDR(), encoded[0]) << "starts over";
+
+  Path::remove(file);
+}
 }
\ No newline at end of file
@@ -370,4 +370,43 @@ TEST(TopologyTest, WrappingNeighborhoodDimensionOne) {
       /*radius*/ 1,
       /*expected*/ {{4, 0, 0}, {5, 0, 0}, {6, 0, 0}});
 }
+
+// ==========================================================================
+// NEIGHBORHOOD TABLE
+// ==========================================================================
+
+TEST(TopologyTest, NeighborhoodTableSameAsNeighborhood) {
+  const vector<vector<UInt>> allDimensions = {{100}, {7}, {10, 12}, {5, 6, 7}, {1, 9}};
+  for (const auto &dimensions : allDimensions) {
+    UInt size = 1u;
+    for (const auto dim : dimensions) size *= dim;
+
+    for (UInt radius = 0u; radius < 8u; radius++) {
+      for (const bool wrapAround : {false, true}) {
+        const NeighborhoodTable table(radius, dimensions, wrapAround);
+        EXPECT_EQ(radius, table.radius());
+        EXPECT_EQ(wrapAround, table.wrapAround());
+        EXPECT_EQ(dimensions, table.dimensions());
+
+        for (UInt center = 0u; center < size; center++) {
+          vector<UInt> expected;
+          if (wrapAround) {
+            for (UInt index : WrappingNeighborhood(center, radius, dimensions))
+              expected.push_back(index);
+          } else {
+            for (UInt index : Neighborhood(center, radius, dimensions))
+              expected.push_back(index);
+          }
+          vector<UInt> neighbors = {42u};
+          table.appendNeighbors(center, neighbors);
+          ASSERT_EQ(42u, neighbors[0]) << "appends";
+          ASSERT_EQ(expected, vector<UInt>(neighbors.begin() + 1, neighbors.end()))
+              << "same order as the Neighborhood, center " << center
+              << ", radius " << radius << ", wrapAround " << wrapAround;
+        }
+      }
+    }
+  }
+}
+
 } // namespace
@@ -683,7 +683,77 @@ TEST_F(ArrayTest, testArrayBaseSerialization) {
     toSparse(b, results);
     //VERBOSE << "Resulting b = " << b << std::endl;
     EXPECT_EQ(testdata, results);
+
+    // portable binary serialization
+    std::stringstream ps;
+    {
+      cereal::PortableBinaryOutputArchive portableOut_ar(ps);
+      a.save_ar(portableOut_ar);
+    }
+    Array c;
+    {
+      cereal::PortableBinaryInputArchive portableIn_ar(ps);
+      c.load_ar(portableIn_ar);
+    }
+    toSparse(c, results);
+    EXPECT_EQ(testdata, results);
+  }
+}
+
+TEST_F(ArrayTest, testBinaryBlockFormat) {
+  // The numeric arrays are written as one block, in the format of a std::vector.
+  const std::vector<Real32> data = {0.5f, -1.0f, 3.25f, 0.0f, 1e6f};
+  Array a(NTA_BasicType_Real32);
+  a.allocateBuffer(data.size());
+  std::copy(data.begin(), data.end(), reinterpret_cast<Real32 *>(a.getBuffer()));
+
+  std::stringstream actual, expected;
+  {
+    cereal::PortableBinaryOutputArchive ar(actual);
+    a.save_ar(ar);
+  }
+  {
+    cereal::PortableBinaryOutputArchive ar(expected);
+    ar(std::string("Real32"), data);
+  }
+  EXPECT_EQ(expected.str(), actual.str());
+
+  Array b;
+  {
+    cereal::PortableBinaryInputArchive ar(expected);
+    b.load_ar(ar);
   }
+  ASSERT_EQ(data.size(), b.getCount());
+  EXPECT_EQ(data, std::vector<Real32>(reinterpret_cast<const Real32 *>(b.getBuffer()),
+                                      reinterpret_cast<const Real32 *>(b.getBuffer()) + b.getCount()));
+}
+
+TEST_F(ArrayTest, testToFromBinary) {
+  // An SDR is its dimensions and the delta encoded indices.
+  Array a(NTA_BasicType_SDR);
+  a.allocateBuffer({32u, 64u});
+  a.getSDR().setSparse(SDR_sparse_t({3u, 100u, 2047u}));
+  const std::string binary = a.toBinary();
+  EXPECT_LT(binary.size(), 16u);
+  Array b;
+  b.fromBinary(binary);
+  ASSERT_EQ(b.getType(), NTA_BasicType_SDR);
+  EXPECT_EQ(b.getSDR().dimensions, a.getSDR().dimensions);
+  EXPECT_EQ(b.getSDR().getSparse(), a.getSDR().getSparse());
+
+  // Other types are copied as is.
+  std::vector<Real32> data = {1.5f, -2.0f, 0.0f};
+  Array c(NTA_BasicType_Real32, data.data(), data.size());
+  Array d;
+  d.fromBinary(c.toBinary());
+  ASSERT_EQ(d.getType(), NTA_BasicType_Real32);
+  ASSERT_EQ(d.getCount(), data.size());
+  EXPECT_EQ(data, std::vector<Real32>(reinterpret_cast<const Real32 *>(d.getBuffer()),
+                                      reinterpret_cast<const Real32 *>(d.getBuffer()) + d.getCount()));
+
+  const std::string truncated = c.toBinary().substr(0u, 5u);
+  EXPECT_ANY_THROW(d.fromBinary(truncated));
+  EXPECT_ANY_THROW(d.fromBinary(""));
 }
 
 void ArrayTest::setupArrayTests() {
@@ -591,4 +591,39 @@ TEST(BasicTypeTest, convertArray) {
                           NTA_BasicType_Bool, 8);
   ASSERT_TRUE(ca.checkArrayBool<bool>(ca.dest)) << "bool to bool conversion";
 }
+
+TEST(BasicTypeTest, convertSparseToArray) {
+  const std::vector<UInt32> indices = {1u, 4u, 9u};
+  std::vector<Real32> real(10u, 7.0f);
+  BasicType::convertSparseToArray(real.data(), NTA_BasicType_Real32, real.size(),
+                                  indices.data(), indices.size());
+  EXPECT_EQ(std::vector<Real32>({0, 1, 0, 0, 1, 0, 0, 0, 0, 1}), real);
+
+  std::vector<UInt32> uint(10u, 7u);
+  BasicType::convertSparseToArray(uint.data(), NTA_BasicType_UInt32, uint.size(),
+                                  indices.data(), indices.size());
+  EXPECT_EQ(std::vector<UInt32>({0, 1, 0, 0, 1, 0, 0, 0, 0, 1}), uint);
+
+  EXPECT_THROW(BasicType::convertSparseToArray(uint.data(), NTA_BasicType_Str, uint.size(),
+                                               indices.data(), indices.size()), std::exception);
+}
+
+TEST(BasicTypeTest, nonzeroIndices) {
+  std::vector<UInt32> indices = {5u};
+  const std::vector<Real64> real = {0.0, 0.5, -0.0, 0.0, -2.0};
+  BasicType::nonzeroIndices(real.data(), NTA_BasicType_Real64, real.size(), indices);
+  EXPECT_EQ(std::vector<UInt32>({1u, 4u}), indices);
+
+  // The 1 byte types skip runs of zeros.
+  std::vector<Byte> bytes(37u, 0);
+  bytes[3] = 1;
+  bytes[30] = -1;
+  bytes[36] = 2;
+  BasicType::nonzeroIndices(bytes.data(), NTA_BasicType_Byte, bytes.size(), indices);
+  EXPECT_EQ(std::vector<UInt32>({3u, 30u, 36u}), indices);
+
+  const std::vector<Int16> none(5u, 0);
+  BasicType::nonzeroIndices(none.data(), NTA_BasicType_Int16, none.size(), indices);
+  EXPECT_TRUE(indices.empty());
+}
 }
@@ -0,0 +1,129 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of BufferPool test
+ */
+
+#include <cstdint>
+
+#include <gtest/gtest.h>
+#include <htm/ntypes/Array.hpp>
+#include <htm/ntypes/BufferPool.hpp>
+#include <htm/utils/MemoryResource.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(BufferPoolTest, Reuse) {
+  BufferPool::trim();
+  const auto start = BufferPool::getStatistics();
+
+  char *first;
+  {
+    auto buffer = BufferPool::allocate(100u);
+    first = buffer.get();
+    auto copy = buffer; // the last copy releases the buffer
+  }
+  auto stats = BufferPool::getStatistics();
+  EXPECT_EQ(start.allocations + 1u, stats.allocations);
+  EXPECT_EQ(start.releases + 1u, stats.releases);
+  EXPECT_EQ(start.cachedBytes + 128u, stats.cachedBytes);
+
+  // Same size class.
+  auto again = BufferPool::allocate(128u);
+  EXPECT_EQ(first, again.get());
+  stats = BufferPool::getStatistics();
+  EXPECT_EQ(start.allocations + 1u, stats.allocations);
+  EXPECT_EQ(start.reuses + 1u, stats.reuses);
+  EXPECT_EQ(start.cachedBytes, stats.cachedBytes);
+
+  // Another size class.
+  auto other = BufferPool::allocate(129u);
+  EXPECT_NE(first, other.get());
+  EXPECT_EQ(start.allocations + 2u, BufferPool::getStatistics().allocations);
+}
+
+TEST(BufferPoolTest, ArrayCopiesInSteadyState) {
+  Array a(NTA_BasicType_Real32);
+  a.allocateBuffer(1000u);
+  a.zeroBuffer();
+  { Array warm = a.copy(); }
+
+  const auto start = BufferPool::getStatistics();
+  for (int i = 0; i < 10; i++) {
+    Array b = a.copy();
+    ASSERT_EQ(a, b);
+  }
+  const auto stats = BufferPool::getStatistics();
+  EXPECT_EQ(start.allocations, stats.allocations);
+  EXPECT_EQ(start.reuses + 10u, stats.reuses);
+}
+
+TEST(BufferPoolTest, Aligned) {
+  for (size_t bytes : {1u, 100u, 1000u, 100u * 1024u * 1024u}) {
+    auto buffer = BufferPool::allocate(bytes);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer.get()) % SIMD_ALIGNMENT, 0u) << bytes;
+  }
+
+  // The padding of an Array is zero, up to a multiple of SIMD_ALIGNMENT.
+  Array a(NTA_BasicType_Real32);
+  a.allocateBuffer(5u);
+  EXPECT_TRUE(a.isAligned());
+  EXPECT_EQ(a.getCount(), 5u);
+  ASSERT_EQ(a.getCapacity(), 16u);
+  const Real32 *data = reinterpret_cast<const Real32 *>(a.getBuffer());
+  for (size_t i = 5u; i < a.getCapacity(); i++) {
+    EXPECT_EQ(data[i], 0.0f);
+  }
+
+  // A range has no padding.
+  Array range(NTA_BasicType_Real32);
+  range.setBufferRange(a, 1u, 2u);
+  EXPECT_EQ(range.getCapacity(), 2u);
+  EXPECT_FALSE(range.isAligned());
+}
+
+TEST(BufferPoolTest, Limits) {
+  BufferPool::trim();
+  const size_t maxCached = BufferPool::getMaxCachedBytes();
+  BufferPool::setMaxCachedBytes(1000u);
+  auto start = BufferPool::getStatistics();
+  {
+    auto a = BufferPool::allocate(512u);
+    auto b = BufferPool::allocate(512u);
+  }
+  // Only one fits in the cache.
+  EXPECT_EQ(start.cachedBytes + 512u, BufferPool::getStatistics().cachedBytes);
+  BufferPool::trim();
+  EXPECT_EQ(start.cachedBytes, BufferPool::getStatistics().cachedBytes);
+  BufferPool::setMaxCachedBytes(maxCached);
+
+  // Disabled, nothing is reused.
+  ASSERT_TRUE(BufferPool::isEnabled());
+  BufferPool::setEnabled(false);
+  start = BufferPool::getStatistics();
+  { auto a = BufferPool::allocate(64u); }
+  { auto a = BufferPool::allocate(64u); }
+  auto stats = BufferPool::getStatistics();
+  EXPECT_EQ(start.allocations + 2u, stats.allocations);
+  EXPECT_EQ(start.reuses, stats.reuses);
+  BufferPool::setEnabled(true);
+}
+
+} // namespace testing
@@ -0,0 +1,64 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of CpuFeatures test
+ */
+
+#include "gtest/gtest.h"
+
+#include <htm/os/CpuFeatures.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(CpuFeaturesTest, Names) {
+  for (const auto level : {SimdLevel::Scalar, SimdLevel::AVX2, SimdLevel::AVX512}) {
+    EXPECT_EQ(CpuFeatures::parse(CpuFeatures::name(level)), level);
+  }
+  EXPECT_EQ(CpuFeatures::parse("AVX2"), SimdLevel::AVX2);
+  EXPECT_ANY_THROW(CpuFeatures::parse("sse9"));
+}
+
+TEST(CpuFeaturesTest, SetLevel) {
+  const SimdLevel level = CpuFeatures::level();
+  EXPECT_LE(level, CpuFeatures::detected());
+
+  CpuFeatures::setLevel(SimdLevel::Scalar);
+  EXPECT_EQ(CpuFeatures::level(), SimdLevel::Scalar);
+  CpuFeatures::setLevel(SimdLevel::AVX512);
+  EXPECT_EQ(CpuFeatures::level(), level) << "can not exceed the CPU";
+  CpuFeatures::resetLevel();
+  EXPECT_EQ(CpuFeatures::level(), level);
+}
+
+static int scalar() { return 0; }
+static int avx2()   { return 1; }
+
+TEST(CpuFeaturesTest, KernelTable) {
+  const KernelTable<int (*)()> table(scalar, avx2);
+  EXPECT_EQ(table.get(SimdLevel::Scalar)(), 0);
+  EXPECT_EQ(table.get(SimdLevel::AVX2)(), 1);
+  EXPECT_EQ(table.get(SimdLevel::AVX512)(), 1) << "falls back to the next lower level";
+
+  CpuFeatures::setLevel(SimdLevel::Scalar);
+  EXPECT_EQ(table.get()(), 0);
+  CpuFeatures::resetLevel();
+}
+
+} // namespace testing
@@ -0,0 +1,91 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of ThreadAffinity test
+ */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include <htm/engine/Network.hpp>
+#include <htm/os/ThreadAffinity.hpp>
+#include <htm/utils/ThreadPool.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(ThreadAffinityTest, Normalize) {
+  EXPECT_EQ(ThreadAffinity::normalize({3u, 1u, 3u, 0u}), std::vector<UInt>({0u, 1u, 3u}));
+  EXPECT_TRUE(ThreadAffinity::normalize({}).empty());
+}
+
+TEST(ThreadAffinityTest, PinCurrentThread) {
+  const std::vector<UInt> all = ThreadAffinity::get();
+  if (not ThreadAffinity::isSupported() or all.empty()) return;
+  const std::vector<UInt> one = {all.back()};
+
+  ASSERT_TRUE(ThreadAffinity::set(one));
+  EXPECT_EQ(ThreadAffinity::get(), one);
+  ASSERT_TRUE(ThreadAffinity::set(all));
+  EXPECT_EQ(ThreadAffinity::get(), all);
+
+  {
+    ScopedAffinity pinned(one);
+    EXPECT_EQ(ThreadAffinity::get(), one);
+  }
+  EXPECT_EQ(ThreadAffinity::get(), all) << "restored";
+  {
+    ScopedAffinity unpinned({});
+    EXPECT_EQ(ThreadAffinity::get(), all);
+  }
+}
+
+TEST(ThreadAffinityTest, ThreadPool) {
+  const std::vector<UInt> all = ThreadAffinity::get();
+  if (not ThreadAffinity::isSupported() or all.empty()) return;
+  const std::vector<UInt> one = {all.front()};
+
+  ThreadPool pool(2u);
+  ASSERT_TRUE(pool.setAffinity(one));
+  std::vector<UInt> workerCores;
+  pool.submit([&workerCores]() { workerCores = ThreadAffinity::get(); }).get();
+  EXPECT_EQ(workerCores, one);
+}
+
+TEST(ThreadAffinityTest, Network) {
+  const std::vector<UInt> all = ThreadAffinity::get();
+  if (not ThreadAffinity::isSupported() or all.empty()) return;
+
+  Network net;
+  auto r1 = net.addRegion("region1", "TestNode", "");
+  auto r2 = net.addRegion("region2", "TestNode", "");
+  net.link("region1", "region2");
+  net.setAffinity({all.back(), all.back()});
+  EXPECT_EQ(net.getAffinity(), std::vector<UInt>({all.back()}));
+  r2->setAffinity({all.front()});
+  EXPECT_EQ(r2->getAffinity(), std::vector<UInt>({all.front()}));
+  net.setNumThreads(2u);
+  net.run(3);
+  EXPECT_EQ(ThreadAffinity::get(), all) << "run() restores the calling thread";
+
+  EXPECT_ANY_THROW(net.setNumaNode(100000u));
+}
+
+} // namespace testing
@@ -0,0 +1,65 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of TscTimer test
+ */
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <htm/os/TscTimer.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(TscTimerTest, Basic) {
+  TscTimer t1;
+  ASSERT_FALSE(t1.isStarted());
+  ASSERT_EQ(t1.getElapsed(), 0.0);
+  ASSERT_EQ(t1.getStartCount(), 0u);
+
+  t1.start();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  t1.stop();
+  ASSERT_EQ(t1.getStartCount(), 1u);
+  // Loose bounds, the machine may be loaded.
+  EXPECT_GT(t1.getElapsed(), 0.015);
+  EXPECT_LT(t1.getElapsed(), 2.0);
+
+  const UInt64 ticks = t1.getElapsedTicks();
+  t1.start();
+  EXPECT_TRUE(t1.isStarted());
+  t1.stop();
+  EXPECT_GE(t1.getElapsedTicks(), ticks) << "time accumulates";
+  EXPECT_EQ(t1.getStartCount(), 2u);
+
+  t1.reset();
+  EXPECT_EQ(t1.getElapsedTicks(), 0u);
+  EXPECT_EQ(t1.getStartCount(), 0u);
+}
+
+TEST(TscTimerTest, Ticks) {
+  EXPECT_GT(TscTimer::ticksPerSecond(), 1.0e6);
+  const UInt64 a = TscTimer::ticks();
+  const UInt64 b = TscTimer::ticks();
+  EXPECT_GE(b, a);
+}
+
+} // namespace testing
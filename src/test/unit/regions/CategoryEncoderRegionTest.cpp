@@ -0,0 +1,100 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/*---------------------------------------------------------------------
+ * This is a test of the CategoryEncoderRegion module.  It does not check the
+ * CategoryEncoder itself but rather the plug-in mechanism to call it.
+ *---------------------------------------------------------------------
+ */
+#include <htm/regions/CategoryEncoderRegion.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/os/Directory.hpp>
+
+#include "gtest/gtest.h"
+#include "RegionTestUtilities.hpp"
+
+#define VERBOSE if(verbose)std::cerr << "[          ] "
+static bool verbose = false;  // turn this on to print extra stuff for debugging the test.
+
+const UInt EXPECTED_SPEC_COUNT = 6u;  // The number of parameters expected in the CategoryEncoderRegion Spec
+
+using namespace htm;
+namespace testing
+{
+
+  TEST(CategoryEncoderRegionTest, testSpecAndParameters)
+  {
+    Network net;
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "CategoryEncoderRegion", "{size: 1000, activeBits: 20}");
+    std::set<std::string> excluded = {"size", "seed", "activeBits", "sparsity"};
+    checkGetSetAgainstSpec(region1, EXPECTED_SPEC_COUNT, excluded, verbose);
+    checkInputOutputsAgainstSpec(region1, verbose);
+  }
+
+  TEST(CategoryEncoderRegionTest, testEncode)
+  {
+    Network net;
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "CategoryEncoderRegion", "{size: 1000, activeBits: 20, seed: 42}");
+    net.initialize();
+
+    CategoryEncoder_Parameters P;
+    P.size       = 1000u;
+    P.activeBits = 20u;
+    P.seed       = 42u;
+    CategoryEncoder encoder(P);
+    SDR expected(encoder.dimensions);
+
+    region1->setParameterReal64("sensedValue", 1234567.0);
+    net.run(1);
+    encoder.encode(1234567u, expected);
+    EXPECT_EQ(region1->getOutputData("encoded").getSDR(), expected);
+    EXPECT_EQ(region1->getOutputData("bucket").item<Real64>(0), 1234567.0);
+
+    region1->setParameterString("sensedCategory", "user-17");
+    net.run(1);
+    encoder.encode(std::string("user-17"), expected);
+    EXPECT_EQ(region1->getOutputData("encoded").getSDR(), expected);
+
+    region1->setParameterString("sensedCategory", "");
+    region1->setParameterReal64("sensedValue", 1.5);
+    EXPECT_ANY_THROW(net.run(1));
+  }
+
+  TEST(CategoryEncoderRegionTest, testSerialization)
+  {
+    Network net1;
+    Network net2;
+    std::shared_ptr<Region> region1 = net1.addRegion("region1", "CategoryEncoderRegion", "{size: 500, sparsity: 0.04, sensedCategory: 'abc'}");
+    net1.initialize();
+    net1.run(1);
+
+    Directory::removeTree("TestOutputDir", true);
+    std::string filename = "TestOutputDir/CategoryEncoderRegionTest.stream";
+    net1.saveToFile(filename, SerializableFormat::JSON);
+    net2.loadFromFile(filename, SerializableFormat::JSON);
+    EXPECT_TRUE(net1 == net2) << "Restored Network is not the same as the saved Network.";
+
+    std::shared_ptr<Region> region2 = net2.getRegion("region1");
+    EXPECT_EQ(region2->getParameterString("sensedCategory"), "abc");
+    net2.run(1);
+    EXPECT_EQ(region1->getOutputData("encoded").getSDR(), region2->getOutputData("encoded").getSDR());
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+} // namespace testing
@@ -45,6 +45,8 @@
 #include <htm/regions/ClassifierRegion.hpp>
 #include <htm/utils/Log.hpp>
 
+#include <sstream>
+
 #include "RegionTestUtilities.hpp"
 #include "gtest/gtest.h"
 
@@ -244,4 +246,39 @@ TEST(ClassifierRegionTest, testSerialization) {
   Directory::removeTree("TestOutputDir", true);
 }
 
+TEST(ClassifierRegionTest, restoredRegionComputes) {
+  // compute() uses the ports bound when the region is created or restored.
+  Network net1;
+  std::shared_ptr<Region> encoder1 = net1.addRegion("encoder", "RDSEEncoderRegion", "{size: 400, seed: 42, category: true, activeBits: 40}");
+  std::shared_ptr<Region> classifier1 = net1.addRegion("classifier", "ClassifierRegion", "{learn: true}");
+  net1.link("encoder", "classifier", "", "", "encoded", "pattern");
+  net1.link("encoder", "classifier", "", "", "bucket", "bucket");
+  net1.initialize();
+  for (int i = 0; i < 30; i++) {
+    encoder1->setParameterReal64("sensedValue", static_cast<Real64>(i % 3));
+    net1.run(1);
+  }
+
+  std::stringstream ss;
+  net1.save(ss);
+  Network net2;
+  net2.load(ss);
+  std::shared_ptr<Region> encoder2 = net2.getRegion("encoder");
+  std::shared_ptr<Region> classifier2 = net2.getRegion("classifier");
+  for (const Real64 category : {0.0, 1.0, 2.0}) {
+    encoder1->setParameterReal64("sensedValue", category);
+    encoder2->setParameterReal64("sensedValue", category);
+    net1.run(1);
+    net2.run(1);
+    const UInt32 predicted = classifier2->getOutputData("predicted").item<UInt32>(0);
+    EXPECT_EQ(classifier1->getOutputData("predicted").item<UInt32>(0), predicted) << category;
+    EXPECT_EQ(category, classifier2->getOutputData("titles").item<Real64>(predicted)) << category;
+    const Array &pdf1 = classifier1->getOutputData("pdf");
+    const Array &pdf2 = classifier2->getOutputData("pdf");
+    ASSERT_EQ(pdf1.getCount(), pdf2.getCount()) << category;
+    for (size_t i = 0; i < pdf1.getCount(); i++)
+      EXPECT_EQ(pdf1.item<Real64>(i), pdf2.item<Real64>(i)) << category;
+  }
+}
+
 } // namespace testing
\ No newline at end of file
@@ -0,0 +1,124 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/*---------------------------------------------------------------------
+  * This is a test of the HTMPipelineRegion.  It checks that the fused region
+  * computes the same as the chain RDSEEncoderRegion -> SPRegion -> TMRegion.
+  *---------------------------------------------------------------------
+  */
+#include <htm/regions/HTMPipelineRegion.hpp>
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/os/Directory.hpp>
+
+#include "gtest/gtest.h"
+#include "RegionTestUtilities.hpp"
+
+#define VERBOSE if(verbose)std::cerr << "[          ] "
+static bool verbose = false;  // turn this on to print extra stuff for debugging the test.
+
+using namespace htm;
+namespace testing
+{
+
+  TEST(HTMPipelineRegionTest, testInputOutputs)
+  {
+    Network net;
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "HTMPipelineRegion",
+        "{size: 100, activeBits: 10, radius: 5.0, columnCount: 64, cellsPerColumn: 4}");
+    net.initialize();
+    checkInputOutputsAgainstSpec(region1, verbose);
+    EXPECT_EQ(region1->getOutputDimensions("encoded"), Dimensions(100u));
+    EXPECT_EQ(region1->getOutputDimensions("columns"), Dimensions(64u));
+    EXPECT_EQ(region1->getOutputDimensions("activeCells"), Dimensions(64u, 4u));
+    EXPECT_EQ(region1->getParameterUInt32("cellsPerColumn"), 4u);
+  }
+
+
+  TEST(HTMPipelineRegionTest, matchesSeparateRegions)
+  {
+    const std::string spParams = "columnCount: 256, potentialRadius: 400, potentialPct: 0.5, "
+        "globalInhibition: true, localAreaDensity: 0.05, stimulusThreshold: 0, "
+        "synPermInactiveDec: 0.008, synPermActiveInc: 0.05, synPermConnected: 0.1, "
+        "minPctOverlapDutyCycles: 0.001, dutyCyclePeriod: 1000, boostStrength: 0.0";
+    Network chain;
+    std::shared_ptr<Region> encoder = chain.addRegion("encoder", "RDSEEncoderRegion",
+        "{size: 400, activeBits: 20, radius: 5.0, seed: 7}");
+    std::shared_ptr<Region> sp = chain.addRegion("sp", "SPRegion", "{" + spParams + ", seed: 7}");
+    std::shared_ptr<Region> tm = chain.addRegion("tm", "TMRegion", "{cellsPerColumn: 8, seed: 7}");
+    chain.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+    chain.link("sp", "tm", "", "", "bottomUpOut", "bottomUpIn");
+    chain.initialize();
+
+    Network fused;
+    std::shared_ptr<Region> pipeline = fused.addRegion("pipeline", "HTMPipelineRegion",
+        "{size: 400, activeBits: 20, radius: 5.0, " + spParams + ", cellsPerColumn: 8, seed: 7}");
+    fused.initialize();
+
+    for (int i = 0; i < 30; i++) {
+      const Real64 value = static_cast<Real64>((i % 10) * 5);
+      encoder->setParameterReal64("sensedValue", value);
+      pipeline->setParameterReal64("sensedValue", value);
+      chain.run(1);
+      fused.run(1);
+
+      VERBOSE << "iteration " << i << " anomaly " << pipeline->getParameterReal32("anomaly") << std::endl;
+      ASSERT_EQ(pipeline->getOutputData("encoded").getSDR().getSparse(),
+                encoder->getOutputData("encoded").getSDR().getSparse());
+      ASSERT_EQ(pipeline->getOutputData("columns").getSDR().getSparse(),
+                sp->getOutputData("bottomUpOut").getSDR().getSparse());
+      ASSERT_EQ(pipeline->getOutputData("activeCells").getSDR().getSparse(),
+                tm->getOutputData("activeCells").getSDR().getSparse());
+      ASSERT_EQ(pipeline->getOutputData("predictedActiveCells").getSDR().getSparse(),
+                tm->getOutputData("predictedActiveCells").getSDR().getSparse());
+      ASSERT_EQ(pipeline->getOutputData("predictiveCells").getSDR().getSparse(),
+                tm->getOutputData("predictiveCells").getSDR().getSparse());
+      ASSERT_FLOAT_EQ(pipeline->getParameterReal32("anomaly"), tm->getParameterReal32("anomaly"));
+    }
+    // The sequence repeats, so the TM has learned to predict it.
+    EXPECT_LT(pipeline->getParameterReal32("anomaly"), 1.0f);
+  }
+
+
+  TEST(HTMPipelineRegionTest, testSerialization)
+  {
+    Network net1;
+    std::shared_ptr<Region> region1 = net1.addRegion("region1", "HTMPipelineRegion",
+        "{size: 100, activeBits: 10, radius: 5.0, columnCount: 64, cellsPerColumn: 4}");
+    for (int i = 0; i < 10; i++) {
+      region1->setParameterReal64("sensedValue", static_cast<Real64>(i));
+      net1.run(1);
+    }
+
+    Directory::removeTree("TestOutputDir", true);
+    net1.saveToFile("TestOutputDir/htmPipelineRegionTest.stream");
+    Network net2;
+    net2.loadFromFile("TestOutputDir/htmPipelineRegionTest.stream");
+    EXPECT_TRUE(net1 == net2);
+
+    std::shared_ptr<Region> region2 = net2.getRegion("region1");
+    region1->setParameterReal64("sensedValue", 3.0);
+    region2->setParameterReal64("sensedValue", 3.0);
+    net1.run(1);
+    net2.run(1);
+    EXPECT_EQ(region1->getOutputData("activeCells").getSDR().getSparse(),
+              region2->getOutputData("activeCells").getSDR().getSparse());
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+} // namespace testing
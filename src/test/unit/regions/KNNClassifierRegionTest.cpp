@@ -0,0 +1,116 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/*---------------------------------------------------------------------
+ * This is a test of the KNNClassifierRegion module.  It does not check the
+ * KNNClassifier itself but rather the plug-in mechanism to call it.
+ *---------------------------------------------------------------------
+ */
+#include <htm/engine/Network.hpp>
+#include <htm/engine/Region.hpp>
+#include <htm/ntypes/Array.hpp>
+#include <htm/os/Directory.hpp>
+#include <htm/regions/KNNClassifierRegion.hpp>
+
+#include "RegionTestUtilities.hpp"
+#include "gtest/gtest.h"
+
+#define VERBOSE                                                                                                        \
+  if (verbose)                                                                                                         \
+  std::cerr << "[          ] "
+static bool verbose = false; // turn this on to print extra stuff for debugging the test.
+
+const UInt EXPECTED_SPEC_COUNT = 6u; // The number of parameters expected in the KNNClassifierRegion Spec
+
+using namespace htm;
+namespace testing {
+
+TEST(KNNClassifierRegionTest, testSpecAndParameters) {
+  Network net;
+  std::shared_ptr<Region> region1 = net.addRegion("region1", "KNNClassifierRegion", "{}");
+  std::set<std::string> excluded = {};
+  checkGetSetAgainstSpec(region1, EXPECTED_SPEC_COUNT, excluded, verbose);
+  checkInputOutputsAgainstSpec(region1, verbose);
+}
+
+TEST(KNNClassifierRegionTest, asCategoryDecoder) {
+  enum classifier_categories { A, B, C };
+  Network net;
+
+  std::shared_ptr<Region> encoder = net.addRegion("encoder", "RDSEEncoderRegion", "{size: 400, seed: 42, category: true, activeBits: 40}");
+  std::shared_ptr<Region> sp = net.addRegion("sp", "SPRegion", "{columnCount: 1000, globalInhibition: true}");
+  std::shared_ptr<Region> classifier = net.addRegion("classifier", "KNNClassifierRegion", "{learn: true, k: 3}");
+
+  net.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net.link("encoder", "classifier", "", "", "bucket", "bucket");
+  net.link("sp", "classifier", "", "", "bottomUpOut", "pattern");
+  net.initialize();
+
+  classifier_categories cats[] = {A, B, C};
+  for (size_t i = 0; i < 30; i++) {
+    encoder->setParameterReal64("sensedValue", (double)cats[(i % 3)]);
+    net.run(1);
+  }
+  classifier->setParameterBool("learn", false);
+
+  for (const auto cat : cats) {
+    encoder->setParameterReal64("sensedValue", static_cast<Real64>(cat));
+    net.run(1);
+    const Real64 *titles = reinterpret_cast<const Real64 *>(classifier->getOutputData("titles").getBuffer());
+    const Real64 *pdf = reinterpret_cast<const Real64 *>(classifier->getOutputData("pdf").getBuffer());
+    const UInt32 predicted = classifier->getOutputData("predicted").item<UInt32>(0);
+    EXPECT_EQ(static_cast<UInt32>(titles[predicted]), static_cast<UInt32>(cat));
+    EXPECT_EQ(pdf[predicted], 1.0);
+  }
+}
+
+TEST(KNNClassifierRegionTest, testSerialization) {
+  Network net1;
+  Network net2;
+
+  std::shared_ptr<Region> encoder1 = net1.addRegion("encoder", "RDSEEncoderRegion", "{size: 1000, seed: 42, category: true, activeBits: 40}");
+  std::shared_ptr<Region> sp1 = net1.addRegion("sp", "SPRegion", "{columnCount: 200, globalInhibition: true}");
+  std::shared_ptr<Region> classifier1 = net1.addRegion("classifier", "KNNClassifierRegion", "{k: 2, numBands: 8, rowsPerBand: 2}");
+  net1.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net1.link("encoder", "classifier", "", "", "bucket", "bucket");
+  net1.link("sp", "classifier", "", "", "bottomUpOut", "pattern");
+  net1.initialize();
+
+  for (int i = 0; i < 5; i++) {
+    encoder1->setParameterReal64("sensedValue", i);
+    net1.run(1);
+  }
+
+  std::map<std::string, std::string> parameterMap;
+  EXPECT_TRUE(captureParameters(classifier1, parameterMap)) << "Capturing parameters before save.";
+
+  Directory::removeTree("TestOutputDir", true);
+  std::string filename = "TestOutputDir/KNNClassifierRegionTest.stream";
+  net1.saveToFile(filename, SerializableFormat::JSON);
+  net2.loadFromFile(filename, SerializableFormat::JSON);
+
+  std::shared_ptr<Region> classifier2 = net2.getRegion("classifier");
+  ASSERT_EQ(classifier2->getType(), "KNNClassifierRegion");
+  EXPECT_TRUE(compareParameters(classifier2, parameterMap))
+      << "Conflict when comparing KNNClassifierRegion parameters after restore with before save.";
+  EXPECT_TRUE(net1 == net2) << "Restored Network is not the same as the saved Network.";
+
+  net2.run(2);
+  Directory::removeTree("TestOutputDir", true);
+}
+
+} // namespace testing
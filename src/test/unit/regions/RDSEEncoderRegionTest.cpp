@@ -46,13 +46,17 @@
 #include <htm/ntypes/Array.hpp>
 #include <htm/utils/Log.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+
 #include "gtest/gtest.h"
 #include "RegionTestUtilities.hpp"
 
 #define VERBOSE if(verbose)std::cerr << "[          ] "
 static bool verbose = false;  // turn this on to print extra stuff for debugging the test.
 
-const UInt EXPECTED_SPEC_COUNT =  9u;  // The number of parameters expected in the RDSERegion Spec
+const UInt EXPECTED_SPEC_COUNT =  10u;  // The number of parameters expected in the RDSERegion Spec
 
 using namespace htm;
 namespace testing 
@@ -276,5 +280,70 @@ namespace testing
     Directory::removeTree("TestOutputDir", true);
 	}
 
+  TEST(RDSEEncoderRegionTest, testChannels) {
+    // Three channels from one FileInputRegion, encoded into one SDR.
+    const std::string file = "TestOutputDir/RDSEEncoderRegionTestChannels.csv";
+    if (!Directory::exists("TestOutputDir"))
+      Directory::create("TestOutputDir", false, true);
+    std::ofstream f(file);
+    f << "0.25,0.5,-0.75\n" << "-0.5,0.0,1.0\n";
+    f.close();
+
+    Network net;
+    std::shared_ptr<Region> input = net.addRegion("input", "FileInputRegion", "{activeOutputCount: 3}");
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "RDSEEncoderRegion", "{size: 100, activeBits: 10, radius: 0.5, seed: 42, channels: 3}");
+    net.link("input", "region1", "", "", "dataOut", "values");
+    input->executeCommand({"loadFile", file});
+    net.initialize();
+    EXPECT_EQ(region1->getOutputDimensions("encoded"), Dimensions(3u * 100u));
+    EXPECT_EQ(region1->getOutputDimensions("bucket"), Dimensions(3u));
+
+    RDSE_Parameters params;
+    params.size = 100u;
+    params.activeBits = 10u;
+    params.radius = 0.5f;
+    params.seed = 42u;
+    RandomDistributedScalarEncoder encoder(params);
+    const std::vector<std::vector<Real64>> rows = {{0.25, 0.5, -0.75}, {-0.5, 0.0, 1.0}};
+    for (const auto &row : rows) {
+      net.run(1);
+      std::vector<UInt> expected;
+      for (UInt c = 0u; c < 3u; c++) {
+        SDR one({100u});
+        encoder.encode(row[c], one);
+        std::vector<UInt> bits = one.getSparse();
+        std::sort(bits.begin(), bits.end());
+        for (const auto bit : bits)
+          expected.push_back(bit + c * 100u);
+      }
+      EXPECT_EQ(region1->getOutputData("encoded").getSDR().getSparse(), expected);
+      const Real64 *bucket = reinterpret_cast<const Real64 *>(region1->getOutputData("bucket").getBuffer());
+      for (UInt c = 0u; c < 3u; c++)
+        EXPECT_DOUBLE_EQ(bucket[c], row[c] - std::fmod(row[c], 0.5));
+    }
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+  TEST(RDSEEncoderRegionTest, testLoadLegacyArchive) {
+    // Written before the channels, see src/test/data/README.md
+    std::ifstream in(std::string(HTM_TEST_DATA_DIR) + "/RDSEEncoderRegion.v1.bin", std::ios_base::binary);
+    ASSERT_TRUE(in.good());
+    cereal::BinaryInputArchive ar(in);
+    ArWrapper wrapper(&ar);
+    RDSEEncoderRegion region(wrapper, nullptr);
+
+    EXPECT_EQ(region.getParameterUInt32("channels"), 1u);
+    EXPECT_EQ(region.getDimensions(), Dimensions(100u));
+    EXPECT_EQ(region.getParameterUInt32("size"), 100u);
+    EXPECT_EQ(region.getParameterUInt32("activeBits"), 10u);
+    EXPECT_EQ(region.getParameterUInt32("seed"), 7u);
+    EXPECT_FALSE(region.getParameterBool("category"));
+    EXPECT_FLOAT_EQ(region.getParameterReal32("sparsity"), 0.1f);
+    EXPECT_FLOAT_EQ(region.getParameterReal32("radius"), 1.0f);
+    EXPECT_FLOAT_EQ(region.getParameterReal32("resolution"), 0.1f);
+    EXPECT_FLOAT_EQ(region.getParameterReal32("noise"), 0.01f);
+    EXPECT_EQ(region.getParameterReal64("sensedValue"), 3.25);
+  }
+
 
 } // namespace
\ No newline at end of file
@@ -50,6 +50,8 @@
 #include <htm/os/Timer.hpp>
 #include <htm/os/Directory.hpp>
 #include <htm/regions/SPRegion.hpp>
+#include <htm/algorithms/FrozenSpatialPooler.hpp>
+#include <htm/utils/Random.hpp>
 
 
 #include <string>
@@ -57,6 +59,7 @@
 #include <cmath> // fabs/abs
 #include <cstdlib> // exit
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 #include <fstream>
 #include <streambuf>
@@ -69,7 +72,7 @@
 static bool verbose = false;  // turn this on to print extra stuff for debugging the test.
 
 // The following string should contain a valid expected Spec length - manually verified. 
-const UInt EXPECTED_SPEC_COUNT =  22u;  // The number of parameters expected in the SPRegion Spec
+const UInt EXPECTED_SPEC_COUNT =  23u;  // The number of parameters expected in the SPRegion Spec
 
 using namespace htm;
 namespace testing 
@@ -94,6 +97,55 @@ namespace testing
 
   }
 
+  TEST(SPRegionTest, parameterHandles)
+  {
+    Network net;
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "SPRegion", "");
+
+    EXPECT_THROW(region1->getParameterHandle("doesnotexist"), std::exception);
+
+    // Resolved by the region.
+    ParameterHandle boost = region1->getParameterHandle("boostStrength");
+    EXPECT_EQ(NTA_BasicType_Real32, boost.dataType);
+    EXPECT_GE(boost.id, 0);
+    region1->setParameterReal32(boost, 2.5f);
+    EXPECT_EQ(2.5f, region1->getParameterReal32(boost));
+    EXPECT_EQ(2.5f, region1->getParameterReal32("boostStrength"));
+
+    ParameterHandle learn = region1->getParameterHandle("learningMode");
+    region1->setParameterUInt32(learn, 0u);
+    EXPECT_EQ(0u, region1->getParameterUInt32("learningMode"));
+    region1->setParameterUInt32(learn, 1u);
+    EXPECT_EQ(1u, region1->getParameterUInt32(learn));
+
+    // Falls back to the access by name.
+    ParameterHandle period = region1->getParameterHandle("dutyCyclePeriod");
+    EXPECT_LT(period.id, 0);
+    region1->setParameterUInt32(period, 123u);
+    EXPECT_EQ(123u, region1->getParameterUInt32(period));
+  }
+
+  TEST(SPRegionTest, threadBudget)
+  {
+    Network net;
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "SPRegion", "{numThreads: 3}");
+    std::shared_ptr<Region> region2 = net.addRegion("region2", "SPRegion", "");
+    EXPECT_EQ(3u, region1->getParameterUInt32("numThreads"));
+    EXPECT_EQ(0u, region2->getParameterUInt32("numThreads"));
+
+    net.setNumThreads(2u);
+    net.setThreadBudget(8u);
+    EXPECT_EQ(8u, net.getThreadBudget());
+    net.initialize();
+    // The budget is divided between the region threads and the SP kernels,
+    // the explicit numThreads of region1 wins.
+    EXPECT_EQ(3u, region1->getParameterUInt32("numThreads"));
+    EXPECT_EQ(0u, region2->getParameterUInt32("numThreads"));
+
+    region2->setParameterUInt32("numThreads", 1u);
+    EXPECT_EQ(1u, region2->getParameterUInt32("numThreads"));
+  }
+
 
 
 	TEST(SPRegionTest, initialization_with_builtin_impl)
@@ -378,6 +430,92 @@ TEST(SPRegionTest, testSerialization)
     Directory::removeTree("TestOutputDir", true);
 	}
 
+TEST(SPRegionTest, restoredRegionComputes)
+{
+  // compute() uses the ports bound when the region is created or restored.
+  Network net1;
+  std::shared_ptr<Region> encoder1 = net1.addRegion("encoder", "ScalarEncoderRegion", "{size: 100, activeBits: 10, minValue: 0, maxValue: 100}");
+  std::shared_ptr<Region> sp1 = net1.addRegion("sp", "SPRegion", "{columnCount: 64, globalInhibition: true}");
+  net1.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  net1.initialize();
+  encoder1->setParameterReal64("sensedValue", 20.0);
+  net1.run(1);
+
+  std::stringstream ss;
+  net1.save(ss);
+  Network net2;
+  net2.load(ss);
+  std::shared_ptr<Region> encoder2 = net2.getRegion("encoder");
+  std::shared_ptr<Region> sp2 = net2.getRegion("sp");
+  for (const Real64 value : {35.0, 60.0, 85.0}) {
+    encoder1->setParameterReal64("sensedValue", value);
+    encoder2->setParameterReal64("sensedValue", value);
+    net1.run(1);
+    net2.run(1);
+    const SDR &columns = sp1->getOutputData("bottomUpOut").getSDR();
+    EXPECT_GT(columns.getSum(), 0u) << value;
+    EXPECT_EQ(columns, sp2->getOutputData("bottomUpOut").getSDR()) << value;
+  }
+}
+
+TEST(SPRegionTest, sharedModel)
+{
+  SpatialPooler sp({100u}, {64u}, /*potentialRadius*/ 100u, /*potentialPct*/ 0.5f,
+                   /*globalInhibition*/ true, /*localAreaDensity*/ 0.1f);
+  SDR input({100u});
+  SDR columns({64u});
+  Random rng(5);
+  for (int i = 0; i < 50; i++) {
+    input.randomize(0.1f, rng);
+    sp.compute(input, true, columns);
+  }
+  FrozenSpatialPooler::share("SPRegionTest", std::make_shared<FrozenSpatialPooler>(sp));
+
+  // Many networks, one model.
+  const std::string encoderParams = "{size: 100, activeBits: 10, minValue: 0, maxValue: 100}";
+  Network net1, net2;
+  for (Network *net : {&net1, &net2}) {
+    net->addRegion("encoder", "ScalarEncoderRegion", encoderParams);
+    net->addRegion("sp", "SPRegion", "{columnCount: 64, sharedModel: SPRegionTest}");
+    net->link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+    net->initialize();
+  }
+  EXPECT_EQ("SPRegionTest", net1.getRegion("sp")->getParameterString("sharedModel"));
+  EXPECT_EQ(0u, net1.getRegion("sp")->memoryUsage()) << "the model is not owned by the region";
+
+  for (const Real64 value : {10.0, 45.0, 90.0}) {
+    net1.getRegion("encoder")->setParameterReal64("sensedValue", value);
+    net2.getRegion("encoder")->setParameterReal64("sensedValue", value);
+    net1.run(1);
+    net2.run(1);
+    sp.compute(net1.getRegion("encoder")->getOutputData("encoded").getSDR(), false, columns);
+    EXPECT_EQ(columns, net1.getRegion("sp")->getOutputData("bottomUpOut").getSDR()) << value;
+    EXPECT_EQ(columns, net2.getRegion("sp")->getOutputData("bottomUpOut").getSDR()) << value;
+  }
+
+  // Only the name is saved.
+  std::stringstream ss;
+  net1.save(ss);
+  Network net3;
+  net3.load(ss);
+  EXPECT_EQ("SPRegionTest", net3.getRegion("sp")->getParameterString("sharedModel"));
+  net3.getRegion("encoder")->setParameterReal64("sensedValue", 45.0);
+  net3.run(1);
+  sp.compute(net3.getRegion("encoder")->getOutputData("encoded").getSDR(), false, columns);
+  EXPECT_EQ(columns, net3.getRegion("sp")->getOutputData("bottomUpOut").getSDR());
+
+  Network net4;
+  net4.addRegion("encoder", "ScalarEncoderRegion", encoderParams);
+  net4.addRegion("sp", "SPRegion", "{columnCount: 32, sharedModel: SPRegionTest}");
+  net4.link("encoder", "sp", "", "", "encoded", "bottomUpIn");
+  EXPECT_THROW(net4.initialize(), std::exception) << "the model has 64 columns";
+
+  ASSERT_TRUE(FrozenSpatialPooler::unshare("SPRegionTest"));
+  std::stringstream ss2;
+  net1.save(ss2);
+  Network net5;
+  EXPECT_THROW(net5.load(ss2), std::exception) << "the model is not shared";
+}
 
 } // namespace
 
@@ -58,6 +58,7 @@
 #include <cstdlib> // exit
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <stdexcept>
 #include <streambuf>
 #include <string>
@@ -71,7 +72,7 @@ static bool verbose = false; // turn this on to print extra stuff for debugging
 
 // The following string should contain a valid expected Spec - manually
 // verified.
-#define EXPECTED_SPEC_COUNT 18 // The number of parameters expected in the TMRegion Spec
+#define EXPECTED_SPEC_COUNT 19 // The number of parameters expected in the TMRegion Spec
 
 using namespace htm;
 
@@ -319,6 +320,11 @@ TEST(TMRegionTest, testLinking) {
             {70, 71, 72, 73, 74 }, (UInt32)r3OutputArray.getCount());
   EXPECT_EQ(r3OutputArray, expected3outa) << r3OutputArray;
 
+  // activeCells has no link, compute() skips it until it is read.
+  EXPECT_EQ(region3->getOutput("activeCells")->getData().getSDR().getSum(), 0u);
+  const Array &activeCells = region3->getOutputData("activeCells");
+  EXPECT_EQ(activeCells.getSDR().getSparse(), r3OutputArray.getSDR().getSparse());
+
 
   VERBOSE << "   Input to FileOutputRegion "
           << region4->getInputDimensions("dataIn") << "\n";
@@ -331,6 +337,40 @@ TEST(TMRegionTest, testLinking) {
   region3->executeCommand({"closeFile"});
 }
 
+TEST(TMRegionTest, restoredRegionComputes) {
+  // compute() uses the ports bound when the region is created or restored.
+  Network net1;
+  std::shared_ptr<Region> encoder1 = net1.addRegion("encoder", "ScalarEncoderRegion",
+                                                    "{size: 48, activeBits: 6, minValue: 0, maxValue: 8}");
+  std::shared_ptr<Region> tm1 = net1.addRegion("tm", "TMRegion", "{numberOfCols: 48, cellsPerColumn: 4}");
+  net1.link("encoder", "tm", "", "", "encoded", "bottomUpIn");
+  net1.initialize();
+  for (int i = 0; i < 20; i++) {
+    encoder1->setParameterReal64("sensedValue", static_cast<Real64>(i % 4) * 2.0);
+    net1.run(1);
+  }
+
+  std::stringstream ss;
+  net1.save(ss);
+  Network net2;
+  net2.load(ss);
+  std::shared_ptr<Region> encoder2 = net2.getRegion("encoder");
+  std::shared_ptr<Region> tm2 = net2.getRegion("tm");
+  for (int i = 20; i < 24; i++) {
+    encoder1->setParameterReal64("sensedValue", static_cast<Real64>(i % 4) * 2.0);
+    encoder2->setParameterReal64("sensedValue", static_cast<Real64>(i % 4) * 2.0);
+    net1.run(1);
+    net2.run(1);
+    const SDR &active = tm1->getOutputData("activeCells").getSDR();
+    EXPECT_GT(active.getSum(), 0u) << "iteration " << i;
+    EXPECT_EQ(active, tm2->getOutputData("activeCells").getSDR()) << "iteration " << i;
+    EXPECT_EQ(tm1->getOutputData("predictiveCells").getSDR(), tm2->getOutputData("predictiveCells").getSDR())
+        << "iteration " << i;
+    EXPECT_EQ(tm1->getOutputData("anomaly").item<Real32>(0), tm2->getOutputData("anomaly").item<Real32>(0))
+        << "iteration " << i;
+  }
+}
+
 TEST(TMRegionTest, testSerialization) {
   // use default parameters the first time
   Network *net1 = new Network();
@@ -49,6 +49,10 @@
 #include <htm/os/Timer.hpp>
 #include <htm/os/Directory.hpp>
 #include <htm/regions/SPRegion.hpp>
+#include <htm/regions/ColumnarFile.hpp>
+#include <htm/regions/VectorFile.hpp>
+#include <htm/regions/VectorStream.hpp>
+#include <htm/utils/BufferedWriter.hpp>
 
 
 #include <string>
@@ -71,7 +75,7 @@
 static bool verbose = false;  // turn this on to print extra stuff for debugging the test.
 
 // The following string should contain a valid expected Spec - manually verified. 
-#define EXPECTED_EFFECTOR_SPEC_COUNT  1   // The number of parameters expected in the FileOutputRegion Spec
+#define EXPECTED_EFFECTOR_SPEC_COUNT  2   // The number of parameters expected in the FileOutputRegion Spec
 #define EXPECTED_SENSOR_SPEC_COUNT  11    // The number of parameters expected in the FileInputRegion Spec
 
 using namespace htm;
@@ -268,6 +272,321 @@ TEST(VectorFileTest, testSerialization)
 
 	}
 	
+  TEST(VectorFileTest, testSerializeVectors)
+  {
+    std::string test_input_file = "TestOutputDir/TestInput.csv";
+    std::string test_output_file = "TestOutputDir/TestOutput.csv";
+    createTestData(4, 6, test_input_file, test_output_file);
+
+    // The scaling covers fewer elements than the vectors, as with a category.
+    VectorFile vf;
+    vf.appendFile(test_input_file, 6, 3);
+    vf.resetScaling(5);
+    vf.setScale(1, 2.5f);
+    ASSERT_EQ(vf.vectorCount(), 4u);
+
+    for (auto fmt : {SerializableFormat::BINARY, SerializableFormat::JSON}) {
+      std::stringstream ss;
+      vf.save(ss, fmt);
+      VectorFile vf2;
+      vf2.load(ss, fmt);
+      ASSERT_EQ(vf2.vectorCount(), 4u);
+      ASSERT_EQ(vf2.getElementCount(), 5u);
+      Real scale, offset;
+      vf2.getScaling(1, scale, offset);
+      EXPECT_EQ(scale, 2.5f);
+      for (UInt v = 0; v < 4; v++) {
+        std::vector<Real> a(6), b(6);
+        vf.getRawVector(v, a.data(), 0, 5);
+        vf2.getRawVector(v, b.data(), 0, 5);
+        EXPECT_EQ(a, b);
+      }
+      std::stringstream s1, s2;
+      vf.saveVectors(s1, 6, 2, 0, 4);
+      vf2.saveVectors(s2, 6, 2, 0, 4);
+      EXPECT_EQ(s1.str(), s2.str()) << "the elements beyond the scaling are kept";
+    }
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+  TEST(VectorFileTest, testLoadUnversionedArchive)
+  {
+    // The layout archived before the vectors were a binary block.
+    std::stringstream ss;
+    {
+      cereal::BinaryOutputArchive ar(ss);
+      const UInt32 format = 2u;
+      const size_t nRows = 2u;
+      const size_t nCols = 3u;
+      const std::vector<Real> scaleVector(3, 1.0f);
+      const std::vector<Real> offsetVector(3, 0.0f);
+      const std::string data = "1 2 3\n4 5 6\n";
+      ar(format, nRows, nCols, scaleVector, offsetVector, data);
+    }
+    VectorFile vf;
+    vf.load(ss, SerializableFormat::BINARY);
+    ASSERT_EQ(vf.vectorCount(), 2u);
+    ASSERT_EQ(vf.getElementCount(), 3u);
+    std::vector<Real> v(3);
+    vf.getRawVector(1, v.data(), 0, 3);
+    EXPECT_EQ(v, std::vector<Real>({4.0f, 5.0f, 6.0f}));
+  }
+
+  TEST(VectorFileTest, testColumnarFile)
+  {
+    if (!Directory::exists("TestOutputDir")) Directory::create("TestOutputDir", false, true);
+    const std::string path = "TestOutputDir/TestInput.htmcol";
+    const size_t dataRows = 10;
+
+    // A row group size which leaves a partial last group.
+    ColumnarWriter writer(path, {
+        ColumnSpec("value", ColumnType::REAL32),
+        ColumnSpec("count", ColumnType::INT32),
+        ColumnSpec("flag", ColumnType::UINT8),
+        ColumnSpec("color", ColumnType::CATEGORY, {"red", "green", "blue"})}, 4u);
+    for (size_t i = 0; i < dataRows; i++) {
+      const Real row[] = {0.5f * static_cast<Real>(i), -static_cast<Real>(i),
+                          static_cast<Real>(i % 2), writer.code(3, (i % 3 == 0) ? "red" : "blue")};
+      writer.appendRow(row);
+    }
+    EXPECT_ANY_THROW(writer.code(3, "yellow"));
+    writer.close();
+
+    ColumnarFile file(path);
+    ASSERT_EQ(file.numRows(), dataRows);
+    ASSERT_EQ(file.numColumns(), 4u);
+    EXPECT_EQ(file.numRowGroups(), 3u);
+    EXPECT_EQ(file.groupRows(2), 2u);
+    EXPECT_EQ(file.column(3).categories, std::vector<std::string>({"red", "green", "blue"}));
+    const Int32 *counts = static_cast<const Int32 *>(file.columnData(1, 1));
+    EXPECT_EQ(counts[0], -4);
+
+    VectorFile vf;
+    vf.appendFile(path, 4, 7);
+    ASSERT_EQ(vf.vectorCount(), dataRows);
+    Real out[4];
+    vf.getRawVector(7, out, 0, 4);
+    EXPECT_EQ(out[0], 3.5f);
+    EXPECT_EQ(out[1], -7.0f);
+    EXPECT_EQ(out[2], 1.0f);
+    EXPECT_EQ(out[3], 2.0f); // blue
+    EXPECT_ANY_THROW(vf.appendFile("TestOutputDir/TestInput.csv", 4, 3));
+
+    // The same file through the FileInputRegion, selected by its extension.
+    Network net;
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "FileInputRegion", "{activeOutputCount: 4}");
+    region1->executeCommand({ "loadFile", path });
+    net.run(3);
+    EXPECT_EQ(region1->getParameterInt32("position"), 2);
+    Array a = region1->getOutputData("dataOut");
+    Array expected(std::vector<Real32>({ 1.0f, -2.0f, 0.0f, 2.0f }));
+    EXPECT_TRUE(a == expected);
+
+    // Standard scaling over the mapped rows.
+    Real scale, offset;
+    VectorFile scaled;
+    scaled.appendFile(path, 4, 7);
+    scaled.setStandardScaling();
+    scaled.getScaling(0, scale, offset);
+    EXPECT_NEAR(offset, -2.25f, 1e-5f);
+
+    // Serialization keeps the path of the columnar file.
+    std::stringstream ss;
+    vf.save(ss);
+    VectorFile vf2;
+    vf2.load(ss);
+    ASSERT_EQ(vf2.vectorCount(), dataRows);
+    vf2.getRawVector(7, out, 0, 4);
+    EXPECT_EQ(out[0], 3.5f);
+
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+  TEST(VectorFileTest, testStreamFile)
+  {
+    std::string test_input_file = "TestOutputDir/TestInput.csv";
+    std::string test_output_file = "TestOutputDir/TestOutput.csv";
+    size_t dataWidth = 10;
+    size_t dataRows = 10;
+    createTestData(dataRows, dataWidth, test_input_file, test_output_file);
+
+    Network net;
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "FileInputRegion", "{activeOutputCount: 10}");
+    // csv format, a ring of 2 blocks of 3 vectors.
+    region1->executeCommand({ "streamFile", test_input_file, "3", "3", "2" });
+    EXPECT_EQ(region1->getParameterInt32("position"), -1);
+    EXPECT_EQ(region1->getParameterUInt32("vectorCount"), 0u) << "nothing is loaded in memory";
+
+    net.run(1);
+    EXPECT_EQ(region1->getParameterInt32("position"), 0);
+    Array expected1(std::vector<Real32>({ 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }));
+    EXPECT_TRUE(region1->getOutputData("dataOut") == expected1);
+
+    // The stream wraps at the end of the file.
+    net.run(10);
+    EXPECT_EQ(region1->getParameterInt32("position"), 0);
+    EXPECT_TRUE(region1->getOutputData("dataOut") == expected1);
+
+    region1->setParameterInt32("position", 5);
+    net.run(1);
+    EXPECT_EQ(region1->getParameterInt32("position"), 5);
+    Array expected5(std::vector<Real32>({ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f }));
+    EXPECT_TRUE(region1->getOutputData("dataOut") == expected5);
+
+    // A restored network continues the stream.
+    std::stringstream ss;
+    net.save(ss);
+    Network net2;
+    net2.load(ss);
+    std::shared_ptr<Region> n2region1 = net2.getRegion("region1");
+    EXPECT_TRUE(*region1.get() == *n2region1.get());
+    net.run(1);
+    net2.run(1);
+    EXPECT_EQ(n2region1->getParameterInt32("position"), 6);
+    EXPECT_TRUE(region1->getOutputData("dataOut") == n2region1->getOutputData("dataOut"));
+
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+  TEST(VectorFileTest, testVectorStreamBinary)
+  {
+    if (!Directory::exists("TestOutputDir")) Directory::create("TestOutputDir", false, true);
+    const std::string path = "TestOutputDir/TestInput.bin";
+    {
+      std::ofstream f(path, std::ios_base::binary);
+      for (Real32 v = 0.0f; v < 10.0f; v++)
+        f.write(reinterpret_cast<const char *>(&v), sizeof(v));
+    }
+
+    // 5 vectors of 2 elements, through a ring smaller than the file.
+    VectorStream stream(path, 2, 4, 2, 2);
+    EXPECT_EQ(stream.position(), -1);
+    for (size_t i = 0; i < 12; i++) {
+      const Real *vec = stream.next();
+      EXPECT_EQ(stream.position(), static_cast<Int64>(i % 5));
+      EXPECT_EQ(vec[0], static_cast<Real>(2 * (i % 5)));
+      EXPECT_EQ(vec[1], static_cast<Real>(2 * (i % 5) + 1));
+    }
+
+    stream.seek(3);
+    EXPECT_EQ(stream.next()[0], 6.0f);
+    stream.seek(5);
+    EXPECT_ANY_THROW(stream.next()) << "beyond the end of the file";
+    EXPECT_ANY_THROW(VectorStream(path, 2, 1)) << "labeled files can not be streamed";
+
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+  TEST(VectorFileTest, testSharedFile)
+  {
+    std::string test_input_file = "TestOutputDir/TestInput.csv";
+    std::string test_output_file = "TestOutputDir/TestOutput.csv";
+    size_t dataWidth = 10;
+    size_t dataRows = 10;
+    createTestData(dataRows, dataWidth, test_input_file, test_output_file);
+
+    // Two consumers of one copy, each with its own scaling.
+    VectorFile a, b;
+    a.shareFile(test_input_file, dataWidth, 3);
+    b.shareFile(test_input_file, dataWidth, 3);
+    EXPECT_TRUE(a.isShared());
+    EXPECT_EQ(a.vectorCount(), dataRows);
+    auto shared = VectorFile::getSharedFile(test_input_file, dataWidth, 3);
+    EXPECT_EQ(shared.use_count(), 3) << "a, b and shared";
+    b.setScale(2, 3.0f);
+    std::vector<Real> rowA(dataWidth), rowB(dataWidth);
+    a.getScaledVector(2, rowA.data(), 0, dataWidth);
+    b.getScaledVector(2, rowB.data(), 0, dataWidth);
+    EXPECT_EQ(rowA[2], 1.0f);
+    EXPECT_EQ(rowB[2], 3.0f);
+    EXPECT_ANY_THROW(a.appendFile(test_input_file, dataWidth, 3)) << "shared vectors are read-only";
+
+    // Another format or width is another dataset.
+    EXPECT_NE(VectorFile::getSharedFile(test_input_file, 5, 3), shared);
+
+    // Regions share the file too, and keep their own position.
+    Network net;
+    std::shared_ptr<Region> region1 = net.addRegion("region1", "FileInputRegion", "{activeOutputCount: 10}");
+    std::shared_ptr<Region> region2 = net.addRegion("region2", "FileInputRegion", "{activeOutputCount: 10}");
+    region1->executeCommand({ "shareFile", test_input_file, "3" });
+    region2->executeCommand({ "shareFile", test_input_file, "3" });
+    EXPECT_EQ(shared.use_count(), 5);
+    EXPECT_EQ(region1->getParameterUInt32("vectorCount"), dataRows);
+    region2->setParameterInt32("position", 5);
+    net.run(1);
+    Array expected0(std::vector<Real32>({ 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }));
+    Array expected5(std::vector<Real32>({ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f }));
+    EXPECT_TRUE(region1->getOutputData("dataOut") == expected0);
+    EXPECT_TRUE(region2->getOutputData("dataOut") == expected5);
+
+    // A restored network shares the file again.
+    std::stringstream ss;
+    net.save(ss);
+    Network net2;
+    net2.load(ss);
+    EXPECT_EQ(shared.use_count(), 7);
+    net.run(1);
+    net2.run(1);
+    EXPECT_TRUE(region2->getOutputData("dataOut") == net2.getRegion("region2")->getOutputData("dataOut"));
+
+    // A file which changed is read again.
+    std::ofstream(test_input_file.c_str(), std::ios_base::app) << "1,1,1,1,1,1,1,1,1,1" << std::endl;
+    VectorFile c;
+    c.shareFile(test_input_file, dataWidth, 3);
+    EXPECT_EQ(c.vectorCount(), dataRows + 1u);
+    EXPECT_EQ(a.vectorCount(), dataRows);
+
+    Directory::removeTree("TestOutputDir", true);
+  }
+
+  TEST(VectorFileTest, testOutputFormats)
+  {
+    std::string test_input_file = "TestOutputDir/TestInput.csv";
+    std::string test_output_file = "TestOutputDir/TestOutput.csv";
+    size_t dataWidth = 10;
+    size_t dataRows = 10;
+    createTestData(dataRows, dataWidth, test_input_file, test_output_file);
+
+    for (std::string format : {"binary", "sparse", "sparse_lz"}) {
+      const std::string output = "TestOutputDir/TestOutput." + format;
+      Network net;
+      std::shared_ptr<Region> region1 = net.addRegion("region1", "FileInputRegion", "{activeOutputCount: 10}");
+      std::shared_ptr<Region> region3 = net.addRegion("region3", "FileOutputRegion",
+          "{outputFormat: " + format + ", outputFile: '" + output + "'}");
+      net.link("region1", "region3", "", "", "dataOut", "dataIn");
+      region1->executeCommand({ "loadFile", test_input_file });
+      EXPECT_EQ(region3->getParameterString("outputFormat"), format);
+      EXPECT_ANY_THROW(region3->setParameterString("outputFormat", "text")) << "the file is open";
+      net.run(static_cast<int>(dataRows));
+      region3->executeCommand({ "closeFile" });
+
+      std::string contents;
+      if (format == "sparse_lz") {
+        contents = readCompressedFile(output);
+      } else {
+        std::ifstream f(output, std::ios_base::binary);
+        contents.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+      }
+      if (format == "binary") {
+        // The input file format 4 reads it back.
+        ASSERT_EQ(contents.size(), dataRows * dataWidth * sizeof(Real32));
+        const Real32 *values = reinterpret_cast<const Real32 *>(contents.data());
+        for (size_t i = 0; i < dataRows; i++)
+          for (size_t j = 0; j < dataWidth; j++)
+            EXPECT_EQ(values[i * dataWidth + j], (i == j) ? 1.0f : 0.0f);
+      } else {
+        // One non-zero index per vector, on the diagonal.
+        ASSERT_EQ(contents.size(), dataRows * 2 * sizeof(UInt32));
+        const UInt32 *values = reinterpret_cast<const UInt32 *>(contents.data());
+        for (UInt32 i = 0; i < dataRows; i++) {
+          EXPECT_EQ(values[2 * i], 1u);
+          EXPECT_EQ(values[2 * i + 1], i);
+        }
+      }
+    }
+    Directory::removeTree("TestOutputDir", true);
+  }
+
 	//////////////////////////////////////////////////////////////////////////////////
 
 	static bool compareFiles(const std::string& p1, const std::string& p2) {
@@ -0,0 +1,149 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include <gtest/gtest.h>
+#include <htm/types/Sdr.hpp>
+#include <htm/types/SdrCodec.hpp>
+#include <htm/utils/Random.hpp>
+#include <sstream>
+#include <vector>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+TEST(SdrCodecTest, TestEncodeDecode) {
+    const vector<SDR_sparse_t> values({
+        {},
+        { 0 },
+        { 0, 1, 2, 3 },
+        { 5, 127, 128, 129, 16383, 16384, 100000 },
+        { 0xFFFFFFFEu, 0xFFFFFFFFu },
+    });
+    SDR_encoded_t encoded;
+    for(const auto &value : values) {
+        encodeSparse( value, encoded );
+    }
+    // Gaps below 128 take one byte.
+    SDR_encoded_t small;
+    encodeSparse( SDR_sparse_t({ 0, 1, 2, 3 }), small );
+    ASSERT_EQ( small.size(), 5u );
+
+    size_t offset = 0u;
+    SDR_sparse_t decoded;
+    for(const auto &value : values) {
+        offset = decodeSparse( encoded, offset, decoded );
+        ASSERT_EQ( decoded, value );
+    }
+    ASSERT_EQ( offset, encoded.size() );
+
+    // Truncated data
+    encoded.pop_back();
+    offset = 0u;
+    for(size_t i = 0; i < values.size() - 1u; i++) {
+        offset = decodeSparse( encoded, offset, decoded );
+    }
+    EXPECT_ANY_THROW( decodeSparse( encoded, offset, decoded ) );
+}
+
+TEST(SdrCodecTest, TestCompressionRatio) {
+    Random rng(42);
+    SDR sdr({ 2048 });
+    sdr.randomize( 0.02f, rng );
+    SDR_encoded_t encoded;
+    encodeSparse( sdr.getSparse(), encoded );
+    // 4 bytes per index uncompressed
+    ASSERT_LT( encoded.size() * 3u, sdr.getSum() * sizeof(ElemSparse) );
+}
+
+TEST(SdrCodecTest, TestStream) {
+    Random rng(7);
+    vector<SDR> recorded;
+    stringstream ss;
+    {
+        SDRStreamWriter writer( ss, { 10u, 20u } );
+        for(int i = 0; i < 50; i++) {
+            recorded.emplace_back( vector<UInt>{ 10u, 20u } );
+            recorded.back().randomize( 0.05f * (i % 4), rng );
+            writer.write( recorded.back() );
+        }
+        ASSERT_EQ( writer.numWritten(), recorded.size() );
+        SDR wrongDims({ 200u });
+        EXPECT_ANY_THROW( writer.write( wrongDims ) );
+    }
+
+    SDRStreamReader reader( ss );
+    ASSERT_EQ( reader.getDimensions(), vector<UInt>({ 10u, 20u }) );
+    SDR sdr; // initialized by the reader
+    for(const auto &expected : recorded) {
+        ASSERT_TRUE( reader.read( sdr ) );
+        ASSERT_EQ( sdr, expected );
+    }
+    ASSERT_FALSE( reader.read( sdr ) );
+
+    stringstream garbage("not an SDR stream");
+    EXPECT_ANY_THROW( SDRStreamReader reader2( garbage ) );
+}
+
+TEST(SdrCodecTest, TestSaveLoadCompressed) {
+    Random rng(1);
+    SDR a({ 30, 40 });
+    a.randomize( 0.1f, rng );
+    SDR b({ 100 });
+    b.randomize( 0.1f, rng );
+
+    stringstream plain, compressed;
+    a.save( plain );
+    {
+        cereal::BinaryOutputArchive ar( compressed );
+        ar( a.compressed(), b.compressed() );
+    }
+    ASSERT_LT( compressed.str().size(), 2u * plain.str().size() );
+
+    // Loads both formats.
+    SDR a2, b2, a3;
+    {
+        cereal::BinaryInputArchive ar( compressed );
+        ar( a2, b2 );
+    }
+    a3.load( plain );
+    ASSERT_EQ( a, a2 );
+    ASSERT_EQ( b, b2 );
+    ASSERT_EQ( a, a3 );
+}
+
+TEST(SdrCodecTest, TestLoadChecksIndices) {
+    SDR sdr({ 100 });
+    sdr.setSparse( SDR_sparse_t{ 3, 99 } );
+    stringstream ss;
+    {
+        cereal::JSONOutputArchive ar( ss );
+        ar( cereal::make_nvp("sdr", sdr.compressed()) );
+    }
+    // shrink the stored dimensions, index 99 is out of range
+    string json = ss.str();
+    const auto dims = json.find( "100", json.find( "dimensions" ));
+    ASSERT_NE( dims, string::npos );
+    json.replace( dims, 3u, "50" );
+    stringstream corrupt( json );
+    SDR loaded;
+    cereal::JSONInputArchive ar( corrupt );
+    EXPECT_ANY_THROW( ar( cereal::make_nvp("sdr", loaded) ) );
+}
+
+} // end namespace
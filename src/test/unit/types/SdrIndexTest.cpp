@@ -0,0 +1,139 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include <gtest/gtest.h>
+#include <htm/types/SdrIndex.hpp>
+#include <htm/utils/Random.hpp>
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+static vector<SDR> randomSDRs(UInt n, Random &rng) {
+    vector<SDR> sdrs;
+    for( UInt i = 0; i < n; i++ ) {
+        sdrs.emplace_back( vector<UInt>{ 1000u } );
+        sdrs.back().randomize( 0.02f, rng );
+    }
+    return sdrs;
+}
+
+TEST(SdrIndexTest, TestSearch) {
+    Random rng( 7 );
+    const auto sdrs = randomSDRs( 200u, rng );
+    SDRIndex index({ 1000u });
+    for( UInt i = 0; i < sdrs.size(); i++ ) {
+        ASSERT_EQ( index.add( sdrs[i] ), i );
+    }
+    ASSERT_EQ( index.size(), 200u );
+
+    for( int q = 0; q < 10; q++ ) {
+        SDR query( sdrs[q] );
+        query.addNoise( 0.3f, rng );
+
+        // Brute force.
+        vector<SDRIndex::Match> expected;
+        for( UInt i = 0; i < sdrs.size(); i++ ) {
+            const UInt overlap = sdrs[i].getOverlap( query );
+            if( overlap >= 2u ) expected.emplace_back( i, overlap );
+        }
+        sort( expected.begin(), expected.end(), [](const SDRIndex::Match &a, const SDRIndex::Match &b) {
+            return a.second > b.second or (a.second == b.second and a.first < b.first); });
+        expected.resize( min<size_t>( expected.size(), 5u ));
+
+        ASSERT_EQ( index.search( query, 5u, 2u ), expected );
+        ASSERT_EQ( index.search( query, 5u, 2u ).front().first, (UInt) q );
+
+        vector<UInt> overlaps;
+        index.getOverlaps( query, overlaps );
+        ASSERT_EQ( overlaps.size(), sdrs.size() );
+        for( UInt i = 0; i < sdrs.size(); i++ ) {
+            ASSERT_EQ( overlaps[i], sdrs[i].getOverlap( query ));
+        }
+    }
+    ASSERT_ANY_THROW( index.search( SDR({ 10u }), 5u ));
+    ASSERT_ANY_THROW( index.searchApproximate( sdrs[0], 5u ));
+}
+
+TEST(SdrIndexTest, TestRemove) {
+    Random rng( 8 );
+    const auto sdrs = randomSDRs( 50u, rng );
+    SDRIndex index({ 1000u });
+    for( const auto &sdr : sdrs ) index.add( sdr );
+
+    index.remove( 3u );
+    ASSERT_TRUE( index.isRemoved( 3u ));
+    ASSERT_EQ( index.size(), 49u );
+    ASSERT_EQ( index.numEntries(), 50u );
+    ASSERT_EQ( index.search( sdrs[3], 1u ).front().first != 3u, true );
+    vector<UInt> overlaps;
+    index.getOverlaps( sdrs[3], overlaps );
+    ASSERT_EQ( overlaps[3], 0u );
+
+    const auto before = index.search( sdrs[4], 10u );
+    index.compact();
+    ASSERT_EQ( index.search( sdrs[4], 10u ), before );
+    ASSERT_EQ( index.size(), 49u );
+    ASSERT_EQ( index[3u].getOverlap( sdrs[3] ), sdrs[3].getSum() ) << "the value is kept";
+
+    // New entries get new ids.
+    ASSERT_EQ( index.add( sdrs[3] ), 50u );
+    ASSERT_EQ( index.search( sdrs[3], 1u ).front(), SDRIndex::Match( 50u, sdrs[3].getSum() ));
+}
+
+TEST(SdrIndexTest, TestApproximate) {
+    Random rng( 9 );
+    const auto sdrs = randomSDRs( 500u, rng );
+    SDRIndex index({ 1000u }, 16u, 2u);
+    for( const auto &sdr : sdrs ) index.add( sdr );
+
+    UInt found = 0u;
+    for( UInt q = 0; q < 50u; q++ ) {
+        SDR query( sdrs[q] );
+        query.addNoise( 0.1f, rng );
+        const auto approx = index.searchApproximate( query, 1u );
+        if( not approx.empty() and approx.front().first == q ) found++;
+        // The overlaps of the candidates are exact.
+        for( const auto &m : index.searchApproximate( query, 10u ))
+            ASSERT_EQ( m.second, sdrs[m.first].getOverlap( query ));
+    }
+    ASSERT_GE( found, 45u );
+    ASSERT_TRUE( index.searchApproximate( SDR({ 1000u }), 10u ).empty() );
+}
+
+TEST(SdrIndexTest, TestSaveLoad) {
+    Random rng( 10 );
+    const auto sdrs = randomSDRs( 30u, rng );
+    SDRIndex index({ 1000u }, 8u, 3u, 5u);
+    for( const auto &sdr : sdrs ) index.add( sdr );
+    index.remove( 7u );
+
+    stringstream ss;
+    index.save( ss );
+    SDRIndex loaded;
+    loaded.load( ss );
+    ASSERT_EQ( index, loaded );
+    ASSERT_EQ( loaded.size(), 29u );
+    ASSERT_EQ( loaded.search( sdrs[2], 3u ), index.search( sdrs[2], 3u ));
+    ASSERT_EQ( loaded.searchApproximate( sdrs[2], 3u ), index.searchApproximate( sdrs[2], 3u ));
+}
+
+}
@@ -0,0 +1,120 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include <gtest/gtest.h>
+#include <htm/types/SdrStore.hpp>
+#include <htm/utils/Random.hpp>
+#include <sstream>
+#include <vector>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+TEST(SdrStoreTest, TestAddGet) {
+    SDRStore store({ 10, 10 });
+    ASSERT_EQ( store.getSize(), 100u );
+    ASSERT_EQ( store.numSDRs(), 0u );
+
+    Random rng( 5 );
+    vector<SDR> sdrs;
+    for( int i = 0; i < 20; i++ ) {
+        sdrs.emplace_back( vector<UInt>{ 10, 10 } );
+        sdrs.back().randomize( 0.01f * i, rng );
+        ASSERT_EQ( store.add( sdrs.back() ), (size_t) i );
+    }
+    ASSERT_EQ( store.add( SDR_sparse_t({ 3, 50, 99 }) ), 20u );
+    ASSERT_EQ( store.numSDRs(), 21u );
+
+    SDR out({ 100 });
+    for( size_t i = 0; i < sdrs.size(); i++ ) {
+        ASSERT_EQ( store[i].getSum(), sdrs[i].getSum() );
+        store.get( i, out );
+        ASSERT_EQ( out.getSparse(), sdrs[i].getSparse() );
+    }
+    ASSERT_EQ( vector<ElemSparse>( store[20].begin(), store[20].end() ), vector<ElemSparse>({ 3, 50, 99 }) );
+
+    SDR wrongSize({ 99 });
+    EXPECT_ANY_THROW( store.add( wrongSize ) );
+    EXPECT_ANY_THROW( store.add( SDR_sparse_t({ 100 }) ));
+    EXPECT_ANY_THROW( store.add( SDR_sparse_t({ 5, 5 }) ));
+    EXPECT_ANY_THROW( store.get( 0u, wrongSize ) );
+
+    store.clear();
+    ASSERT_EQ( store.numSDRs(), 0u );
+    ASSERT_EQ( store.numIndices(), 0u );
+}
+
+TEST(SdrStoreTest, TestOverlaps) {
+    Random rng( 11 );
+    SDRStore store({ 500 });
+    vector<SDR> sdrs;
+    for( int i = 0; i < 30; i++ ) {
+        sdrs.emplace_back( vector<UInt>{ 500 } );
+        sdrs.back().randomize( 0.1f, rng );
+        store.add( sdrs.back() );
+    }
+    SDR query({ 500 });
+    query.randomize( 0.2f, rng );
+    vector<UInt> overlaps;
+    store.getOverlaps( query, overlaps );
+    ASSERT_EQ( overlaps.size(), sdrs.size() );
+    for( size_t i = 0; i < sdrs.size(); i++ ) {
+        ASSERT_EQ( overlaps[i], sdrs[i].getOverlap( query ));
+        ASSERT_EQ( store[i].getOverlap( query ), overlaps[i] );
+        ASSERT_EQ( store[i].getOverlap( store[0] ), sdrs[i].getOverlap( sdrs[0] ));
+    }
+    SDR other({ 501 });
+    EXPECT_ANY_THROW( store[0].getOverlap( other ) );
+}
+
+TEST(SdrStoreTest, TestSaveLoad) {
+    Random rng( 2 );
+    SDRStore store({ 64, 2 });
+    SDR sdr({ 64, 2 });
+    for( int i = 0; i < 10; i++ ) {
+        sdr.randomize( 0.05f, rng );
+        store.add( sdr );
+    }
+    stringstream ss;
+    store.save( ss );
+    SDRStore loaded;
+    loaded.load( ss );
+    ASSERT_EQ( store, loaded );
+    ASSERT_EQ( loaded.getSize(), 128u );
+}
+
+TEST(SdrStoreTest, TestLoadChecksIndices) {
+    SDRStore store({ 64, 2 });
+    store.add( SDR_sparse_t{ 3, 127 } );
+    stringstream ss;
+    store.save( ss, JSON );
+    SDRStore loaded;
+    loaded.load( ss, JSON );
+    ASSERT_EQ( store, loaded );
+
+    // shrink the stored dimensions, index 127 is out of range
+    string json = ss.str();
+    const auto dims = json.find( "64", json.find( "dimensions_" ));
+    ASSERT_NE( dims, string::npos );
+    json.replace( dims, 2u, "32" );
+    stringstream corrupt( json );
+    EXPECT_ANY_THROW( loaded.load( corrupt, JSON ));
+}
+
+} // end namespace
@@ -16,8 +16,10 @@
 
 #include <gtest/gtest.h>
 #include <htm/types/Sdr.hpp>
+#include <htm/utils/ThreadPool.hpp>
 #include <vector>
 #include <random>
+#include <numeric>
 
 static bool verbose = false;
 #define VERBOSE if(verbose) std::cerr << "[          ]"
@@ -437,6 +439,42 @@ TEST(SdrTest, TestGetCoordinatesFromDense) {
     ASSERT_EQ( a.getCoordinates()[1].size(), 0ul );
 }
 
+TEST(SdrTest, TestDenseBits) {
+    // Bits span three words, the last one partially.
+    SDR a({10, 15});
+    a.setSparse(SDR_sparse_t({ 0u, 63u, 64u, 130u, 149u }));
+    const auto bits = a.getDenseBits();
+    ASSERT_EQ( bits.size(), 3ul );
+    ASSERT_EQ( bits[0], (UInt64(1u) << 63) | 1u );
+    ASSERT_EQ( bits[1], UInt64(1u) );
+    ASSERT_EQ( bits[2], (UInt64(1u) << 21) | (UInt64(1u) << 2) );
+
+    // From the dense bytes.
+    SDR b({10, 15});
+    SDR_dense_t dense = a.getDense();
+    b.setDense( dense );
+    ASSERT_EQ( b.getDenseBits(), bits );
+
+    // To the other formats.
+    SDR c({10, 15});
+    auto copy = bits; // setDenseBits swaps the argument
+    c.setDenseBits( copy );
+    ASSERT_EQ( c.getSparse(), a.getSparse() );
+    ASSERT_EQ( c, a );
+    copy = bits;
+    c.setDenseBits( copy );
+    ASSERT_EQ( c.getDense(), a.getDense() );
+    copy = bits;
+    c.setDenseBits( copy );
+    ASSERT_EQ( c.getCoordinates(), a.getCoordinates() );
+
+    // Zero'd SDR.
+    SDR_dense_bits_t zeros( 3u, 0u );
+    c.setDenseBits( zeros );
+    ASSERT_EQ( c.getSum(), 0u );
+    ASSERT_EQ( c.getOverlap(a), 0u );
+}
+
 TEST(SdrTest, TestAt) {
     SDR a({3, 3});
     a.setSparse(SDR_sparse_t( {4, 5, 8} ));
@@ -600,6 +638,70 @@ TEST(SdrTest, TestAddNoise) {
     }
 }
 
+TEST(SdrTest, TestRandomizeAndNoiseDraws) {
+    // The default randomize & addNoise give the same SDRs as sampling the
+    // listed population with Random::sample, as in previous versions.
+    SDR a({ 40, 25 });
+    Random rng( 9 ), ref( 9 );
+    a.randomize( 0.05f, rng );
+    vector<UInt> population( a.size );
+    iota( population.begin(), population.end(), 0u );
+    auto expected = ref.sample( population, 50u );
+    sort( expected.begin(), expected.end() );
+    ASSERT_EQ( a.getSparse(), SDR_sparse_t( expected.begin(), expected.end() ));
+
+    SDR b( a );
+    b.addNoise( 0.3f, rng );
+    auto turn_off = ref.sample( a.getSparse(), 15u );
+    vector<UInt> off_pop;
+    for( UInt i = 0; i < a.size; i++ )
+        if( a.getDense()[i] == 0 ) off_pop.push_back( i );
+    const auto turn_on = ref.sample( off_pop, 15u );
+    SDR_dense_t dense = a.getDense();
+    for( auto i : turn_on )  dense[i] = 1;
+    for( auto i : turn_off ) dense[i] = 0;
+    SDR c( a.dimensions );
+    c.setDense( dense );
+    ASSERT_EQ( b, c );
+    ASSERT_EQ( rng, ref );
+}
+
+TEST(SdrTest, TestRandomizeAndNoiseFast) {
+    SDR a({ 1000 });
+    Random rng( 3 ), rng2( 3 );
+    a.randomize( 0.02f, rng, true );
+    ASSERT_EQ( a.getSum(), 20u );
+    SDR b( a.dimensions );
+    b.randomize( 0.02f, rng2, true );
+    ASSERT_EQ( a, b );
+    a.randomize( 1.0f, rng, true );
+    ASSERT_EQ( a.getSum(), 1000u );
+    a.randomize( 0.0f, rng, true );
+    ASSERT_EQ( a.getSum(), 0u );
+
+    a.randomize( 0.10f, rng, true );
+    for( UInt x = 0; x <= 100; x += 5 ) {
+        b.setSDR( a );
+        b.addNoise( (Real)x / 100.0f, rng, true );
+        ASSERT_EQ( a.getOverlap( b ), 100 - x );
+        ASSERT_EQ( b.getSum(), 100u );
+    }
+
+    // Even activation frequency at every bit.
+    SDR af_test({ 97 });
+    vector<Real> af( af_test.size, 0 );
+    for( UInt i = 0; i < 10000; i++ ) {
+        af_test.randomize( 0.25f, rng, true );
+        for( auto idx : af_test.getSparse() )
+            af[ idx ] += 1;
+    }
+    for( auto f : af ) {
+        f = f / 10000 / 0.25f;
+        ASSERT_GT( f, 0.90f );
+        ASSERT_LT( f, 1.10f );
+    }
+}
+
 TEST(SdrTest, TestIntersectionExampleUsage) {
     // Setup 2 SDRs to hold the inputs.
     SDR A({ 10 });
@@ -658,6 +760,44 @@ TEST(SdrTest, TestUnion) {
     ASSERT_EQ( U.getSparsity(), .5 );
 }
 
+TEST(SdrTest, TestSetOperationsSparseAndBits) {
+    // The sorted-set (merge & galloping) and the word-wise kernels must agree.
+    Random rng( 42 );
+    for( const Real sparsity : { 0.0002f, 0.02f, 0.5f } ) {
+        SDR A({ 100000 });
+        SDR B( A.dimensions );
+        SDR C( A.dimensions );
+        A.randomize( 0.02f, rng );
+        B.randomize( sparsity, rng );
+        C.randomize( 0.1f, rng );
+        SDR_dense_t expectAnd( A.size ), expectOr( A.size );
+        UInt expectOverlap = 0u;
+        for( UInt i = 0; i < A.size; i++ ) {
+            expectAnd[i] = A.getDense()[i] and B.getDense()[i] and C.getDense()[i];
+            expectOr[i]  = A.getDense()[i] or  B.getDense()[i] or  C.getDense()[i];
+            expectOverlap += A.getDense()[i] and B.getDense()[i];
+        }
+        // Only the dense bits, so the word-wise kernels are used.
+        SDR Abits( A.dimensions ), Bbits( A.dimensions ), Cbits( A.dimensions );
+        auto bits = A.getDenseBits(); Abits.setDenseBits( bits );
+        bits = B.getDenseBits();      Bbits.setDenseBits( bits );
+        bits = C.getDenseBits();      Cbits.setDenseBits( bits );
+
+        for( const bool sparse : { true, false } ) {
+            const SDR &a = sparse ? A : Abits;
+            const SDR &b = sparse ? B : Bbits;
+            const SDR &c = sparse ? C : Cbits;
+            ASSERT_EQ( a.getOverlap(b), expectOverlap );
+            ASSERT_EQ( b.getOverlap(a), expectOverlap );
+            SDR X( A.dimensions );
+            X.intersection({ &a, &b, &c });
+            ASSERT_EQ( X.getDense(), expectAnd ) << "sparsity " << sparsity;
+            X.set_union({ &a, &b, &c });
+            ASSERT_EQ( X.getDense(), expectOr ) << "sparsity " << sparsity;
+        }
+    }
+}
+
 TEST(SdrTest, TestConcatenationExampleUsage) {
     SDR A({ 10 });
     SDR B({ 10 });
@@ -694,6 +834,86 @@ TEST(SdrTest, TestConcatenation) {
     ASSERT_EQ(E.getSum(), 13u);
 }
 
+TEST(SdrTest, TestConcatenationAxes) {
+    // Same result from the sparse, the dense and the parallel paths, along
+    // every axis.
+    Random rng( 8 );
+    ThreadPool pool( 3 );
+    SDR A({ 16, 24, 8 });
+    SDR B({ 16, 24, 8 });
+    for( const Real sparsity : { 0.01f, 0.5f }) {
+        A.randomize( sparsity, rng );
+        B.randomize( sparsity, rng );
+        for( UInt axis = 0; axis < 3; axis++ ) {
+            vector<UInt> dims({ 16, 24, 8 });
+            dims[axis] *= 2;
+            // Reference, from the coordinates
+            SDR_coordinate_t coords( 3 );
+            for( const auto *sdr : { &A, &B } ) {
+                const UInt shift = sdr == &A ? 0u : 16u * (axis == 0) + 24u * (axis == 1) + 8u * (axis == 2);
+                const auto &c = sdr->getCoordinates();
+                for( size_t i = 0; i < c[0].size(); i++ ) {
+                    for( UInt d = 0; d < 3; d++ )
+                        coords[d].push_back( c[d][i] + (d == axis ? shift : 0u) );
+                }
+            }
+            SDR expected( dims );
+            SDR_dense_t dense( expected.size, 0 );
+            for( size_t i = 0; i < coords[0].size(); i++ )
+                dense[ (coords[0][i] * dims[1] + coords[1][i]) * dims[2] + coords[2][i] ] = 1;
+            expected.setDense( dense );
+
+            SDR C( dims );
+            A.getSparse(); B.getSparse();
+            C.concatenate({ &A, &B }, axis );
+            ASSERT_EQ( C, expected ) << "axis " << axis;
+            SDR D( dims );
+            A.getDense(); B.getDense();
+            D.concatenate({ &A, &B }, axis, pool );
+            ASSERT_EQ( D, expected ) << "axis " << axis;
+        }
+    }
+    // Large enough to copy on the threads.
+    SDR E({ 1024, 512 });
+    SDR F({ 1024, 512 });
+    E.randomize( 0.5f, rng );
+    F.randomize( 0.5f, rng );
+    E.getDense(); F.getDense();
+    SDR serial({ 1024, 1024 });
+    SDR parallel({ 1024, 1024 });
+    serial.concatenate({ &E, &F }, 1u );
+    parallel.concatenate({ &E, &F }, 1u, pool );
+    ASSERT_EQ( serial, parallel );
+    ASSERT_EQ( serial.getSum(), E.getSum() + F.getSum() );
+}
+
+TEST(SdrTest, TestCoordinatesConversion) {
+    Random rng( 4 );
+    ThreadPool pool( 3 );
+    // Divisors of 1, powers of 2 and odd ones.
+    for( const auto &dims : vector<vector<UInt>>({ { 100000 }, { 1, 7, 1, 3 }, { 64, 33, 17, 5 }, { 3, 1024, 255 } }) ) {
+        SDR A( dims );
+        A.randomize( 0.3f, rng );
+        SDR B( dims );
+        B.setSDR( A );
+        const auto &coords = B.getCoordinates( pool );
+        ASSERT_EQ( coords.size(), dims.size() );
+        for( size_t i = 0; i < A.getSum(); i++ ) {
+            UInt idx = A.getSparse()[i];
+            for( size_t d = dims.size() - 1; d > 0; d-- ) {
+                ASSERT_EQ( coords[d][i], idx % dims[d] );
+                idx /= dims[d];
+            }
+            ASSERT_EQ( coords[0][i], idx );
+        }
+        // and back
+        SDR C( dims );
+        const SDR_coordinate_t copy = B.getCoordinates();
+        C.setCoordinates( copy );
+        ASSERT_EQ( A, C );
+    }
+}
+
 TEST(SdrTest, TestEquality) {
     vector<SDR*> test_cases;
     // Test different dimensions
@@ -883,4 +1103,44 @@ TEST(SdrTest, TestAssignmentOperator)
   EXPECT_EQ(a.dimensions, copy.dimensions);
 }
 
+TEST(SdrTest, TestMove)
+{
+  SDR a({10, 10});
+  a.setSparse<UInt>({1, 3, 5, 7});
+  const SDR expected(a);
+  const auto data = a.getSparse().data();
+
+  // The data is moved, not copied, the source is left empty.
+  SDR b( std::move(a) );
+  EXPECT_EQ(b, expected);
+  EXPECT_EQ(b.getSparse().data(), data);
+  EXPECT_EQ(a.dimensions, expected.dimensions);
+  EXPECT_EQ(a.getSum(), 0u);
+
+  UInt called = 0u;
+  SDR c({100});
+  c.addCallback( [&called](){ called++; } );
+  c = std::move(b);
+  EXPECT_EQ(called, 1u);
+  EXPECT_EQ(c.getSparse(), expected.getSparse());
+  EXPECT_EQ(c.dimensions, expected.dimensions);
+  EXPECT_EQ(b.getSum(), 0u);
+
+  SDR d; //notice the no dimensions
+  d = std::move(c);
+  EXPECT_EQ(d, expected);
+
+  // The copy and the move assignment take the same dimensions.
+  SDR copied({100});
+  SDR moved({100});
+  copied = expected;
+  moved = SDR(expected);
+  EXPECT_EQ(copied.dimensions, expected.dimensions);
+  EXPECT_EQ(moved.dimensions, copied.dimensions);
+  EXPECT_EQ(moved, copied);
+  SDR wrongSize({99});
+  EXPECT_ANY_THROW( wrongSize = expected );
+  EXPECT_ANY_THROW( wrongSize = SDR(expected) );
+}
+
 } // End namespace testing
@@ -0,0 +1,102 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for the versioned archives of Serializable
+ */
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <htm/types/Serializable.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+// A class before it was versioned.
+struct Unversioned : public Serializable {
+  UInt64 seed = 7u;
+  Real64 value = 0.5;
+
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive &ar) const {
+    ar(CEREAL_NVP(seed), CEREAL_NVP(value));
+  }
+  template<class Archive>
+  void load_ar(Archive &ar) {
+    ar(CEREAL_NVP(seed), CEREAL_NVP(value));
+  }
+};
+
+// The same class with a field added in version 2.
+struct Versioned : public Serializable {
+  UInt64 seed = 0u;
+  Real64 value = 0.0;
+  UInt32 added = 0u;
+  UInt32 loadedVersion = 0u;
+
+  CerealAdapter;
+  template<class Archive>
+  void save_ar(Archive &ar) const {
+    saveArchiveVersion(ar, UInt64(0u), 2u); // the seed is never 0
+    ar(CEREAL_NVP(seed), CEREAL_NVP(value), CEREAL_NVP(added));
+  }
+  template<class Archive>
+  void load_ar(Archive &ar) {
+    loadedVersion = loadArchiveVersion(ar, "seed", seed, UInt64(0u), 1u);
+    ar(CEREAL_NVP(value));
+    if (loadedVersion >= 2u) {
+      ar(CEREAL_NVP(added));
+    } else {
+      added = 42u;
+    }
+  }
+};
+
+
+TEST(SerializableTest, ArchiveVersion) {
+  for (const auto fmt : {SerializableFormat::BINARY, SerializableFormat::PORTABLE,
+                         SerializableFormat::JSON, SerializableFormat::XML}) {
+    Unversioned legacy;
+    legacy.seed = 13u;
+    legacy.value = 2.25;
+    std::stringstream oldArchive;
+    legacy.save(oldArchive, fmt);
+    Versioned loaded;
+    loaded.load(oldArchive, fmt);
+    EXPECT_EQ(1u, loaded.loadedVersion) << "format " << fmt;
+    EXPECT_EQ(13u, loaded.seed);
+    EXPECT_EQ(2.25, loaded.value);
+    EXPECT_EQ(42u, loaded.added) << "the default of an old archive";
+
+    Versioned current;
+    current.seed = 11u;
+    current.value = -1.5;
+    current.added = 3u;
+    std::stringstream newArchive;
+    current.save(newArchive, fmt);
+    Versioned loaded2;
+    loaded2.load(newArchive, fmt);
+    EXPECT_EQ(2u, loaded2.loadedVersion) << "format " << fmt;
+    EXPECT_EQ(11u, loaded2.seed);
+    EXPECT_EQ(-1.5, loaded2.value);
+    EXPECT_EQ(3u, loaded2.added);
+  }
+}
+
+} // namespace testing
@@ -0,0 +1,97 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include <gtest/gtest.h>
+#include <htm/types/SparseSdr.hpp>
+#include <vector>
+
+namespace testing {
+
+using namespace std;
+using namespace htm;
+
+TEST(SparseSdrTest, TestConstructor) {
+    SparseSDR a({ 3, 4, 5 });
+    ASSERT_EQ( a.size, 60u );
+    ASSERT_EQ( a.numDimensions(), 3u );
+    ASSERT_EQ( a.getDimensions(), vector<UInt>({ 3, 4, 5 }) );
+    ASSERT_EQ( a.dimension(1), 4u );
+    ASSERT_EQ( a.getSum(), 0u );
+    // Dimensions are kept inline, there is a limit.
+    EXPECT_ANY_THROW( SparseSDR({ 2, 2, 2, 2, 2 }) );
+}
+
+TEST(SparseSdrTest, TestSetSparse) {
+    SparseSDR a({ 10 });
+    // copy
+    const vector<UInt> value({ 1, 4, 8 });
+    a.setSparse( value );
+    ASSERT_EQ( a.getSparse(), SDR_sparse_t({ 1, 4, 8 }) );
+    ASSERT_EQ( a.getSum(), 3u );
+    // swap
+    SDR_sparse_t swapped({ 0, 9 });
+    a.setSparse( swapped );
+    ASSERT_EQ( a.getSparse(), SDR_sparse_t({ 0, 9 }) );
+    ASSERT_EQ( swapped, SDR_sparse_t({ 1, 4, 8 }) );
+    a.zero();
+    ASSERT_EQ( a.getSum(), 0u );
+    // initialize resets the value
+    a.setSparse( value );
+    a.initialize({ 5, 5 });
+    ASSERT_EQ( a.size, 25u );
+    ASSERT_EQ( a.getSum(), 0u );
+}
+
+TEST(SparseSdrTest, TestOverlap) {
+    SparseSDR a({ 20 });
+    SparseSDR b({ 20 });
+    a.setSparse(SDR_sparse_t({ 0, 3, 5, 7, 19 }));
+    b.setSparse(SDR_sparse_t({ 1, 3, 7, 8, 19 }));
+    ASSERT_EQ( a.getOverlap(b), 3u );
+    ASSERT_EQ( b.getOverlap(a), 3u );
+    ASSERT_EQ( a.getOverlap(a), 5u );
+    SparseSDR c({ 21 });
+    EXPECT_ANY_THROW( a.getOverlap(c) );
+}
+
+TEST(SparseSdrTest, TestConvertSDR) {
+    SDR sdr({ 4, 8 });
+    sdr.setSparse(SDR_sparse_t({ 2, 9, 31 }));
+
+    SparseSDR a( sdr );
+    ASSERT_EQ( a.size, sdr.size );
+    ASSERT_EQ( a.getDimensions(), sdr.dimensions );
+    ASSERT_EQ( a.getSparse(), sdr.getSparse() );
+
+    SDR back = a.toSDR();
+    ASSERT_EQ( back, sdr );
+
+    SparseSDR b({ 32 });
+    b.setSparse(SDR_sparse_t({ 5 }));
+    b.copyTo( back ); // same size, other shape is fine
+    ASSERT_EQ( back.getSparse(), SDR_sparse_t({ 5 }) );
+    SDR wrongSize({ 31 });
+    EXPECT_ANY_THROW( b.copyTo( wrongSize ) );
+
+    b.setSDR( sdr );
+    ASSERT_EQ( a, b );
+    b.initialize({ 32 });
+    b.setSparse( sdr.getSparse() );
+    ASSERT_NE( a, b ); // same value, different shape
+}
+
+} // end namespace
@@ -0,0 +1,70 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <chrono>
+#include <thread>
+
+#include "htm/utils/AlgorithmStats.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+TEST(AlgorithmStats, DisabledByDefault) {
+  AlgorithmStats stats({"a", "b"}, {"n"});
+  {
+    NTA_STATS_TIMER(stats, 0u);
+    NTA_STATS_COUNT(stats, 0u, 5u);
+  }
+  EXPECT_FALSE(stats.isEnabled());
+  EXPECT_EQ(stats.getCalls(0u), 0u);
+  EXPECT_EQ(stats.getCount(0u), 0u);
+  EXPECT_EQ(stats.numTimers(), 2u);
+  EXPECT_EQ(stats.getTimerName(1u), "b");
+  EXPECT_EQ(stats.numCounters(), 1u);
+  EXPECT_EQ(stats.getCounterName(0u), "n");
+}
+
+#ifndef NTA_NO_ALGORITHM_STATS
+TEST(AlgorithmStats, TimersAndCounters) {
+  AlgorithmStats stats({"sleep", "other"}, {"events"});
+  stats.enable();
+  for (int i = 0; i < 3; i++) {
+    NTA_STATS_TIMER(stats, 0u);
+    NTA_STATS_COUNT(stats, 0u, 2u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_EQ(stats.getCalls(0u), 3u);
+  EXPECT_EQ(stats.getCalls(1u), 0u);
+  EXPECT_EQ(stats.getCount(0u), 6u);
+  EXPECT_GT(stats.getSeconds(0u), 0.010);
+  EXPECT_LT(stats.getSeconds(0u), 10.0);
+
+  const std::string json = stats.toJSON();
+  EXPECT_NE(json.find("\"sleep\": {\"calls\": 3"), std::string::npos) << json;
+  EXPECT_NE(json.find("\"events\": 6"), std::string::npos) << json;
+
+  stats.reset();
+  EXPECT_EQ(stats.getCalls(0u), 0u);
+  EXPECT_EQ(stats.getCount(0u), 0u);
+  EXPECT_TRUE(stats.isEnabled());
+}
+#endif
+
+} // namespace testing
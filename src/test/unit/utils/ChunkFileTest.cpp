@@ -0,0 +1,95 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "htm/utils/ChunkFile.hpp"
+#include "htm/utils/Random.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+static void roundTrip(const std::string &raw) {
+  const std::string compressed = lzCompress(raw.data(), raw.size());
+  EXPECT_EQ(raw, lzDecompress(compressed.data(), compressed.size(), raw.size()));
+}
+
+TEST(ChunkFileTest, LzRoundTrip) {
+  roundTrip("");
+  roundTrip("a");
+  roundTrip("abcdefghijklm");
+  roundTrip(std::string(100000u, '\0'));
+
+  // repeated patterns, which overlap their back reference
+  std::string pattern;
+  for (int i = 0; i < 5000; i++) pattern += "abc" + std::to_string(i % 7);
+  roundTrip(pattern);
+
+  // data which does not compress
+  Random rng(42);
+  std::string noise(70000u, '\0');
+  for (auto &c : noise) c = static_cast<char>(rng.getUInt32(256u));
+  roundTrip(noise);
+  roundTrip(noise + pattern + noise);
+}
+
+TEST(ChunkFileTest, LzCompresses) {
+  std::vector<UInt32> indices(10000u);
+  for (size_t i = 0u; i < indices.size(); i++) indices[i] = static_cast<UInt32>(i % 100u);
+  const std::string raw(reinterpret_cast<const char *>(indices.data()), indices.size() * sizeof(UInt32));
+  const std::string compressed = lzCompress(raw.data(), raw.size());
+  EXPECT_LT(compressed.size(), raw.size() / 10u);
+}
+
+TEST(ChunkFileTest, LzCorrupt) {
+  const std::string raw(1000u, 'x');
+  std::string compressed = lzCompress(raw.data(), raw.size());
+  EXPECT_ANY_THROW(lzDecompress(compressed.data(), compressed.size(), raw.size() + 1u));
+  EXPECT_ANY_THROW(lzDecompress(compressed.data(), compressed.size() - 1u, raw.size()));
+  EXPECT_ANY_THROW(lzDecompress(compressed.data(), 0u, raw.size()));
+}
+
+TEST(ChunkFileTest, WriteRead) {
+  const std::string path = "TestOutputDir/ChunkFileTest.chunks";
+  std::vector<Chunk> chunks(3u);
+  chunks[0].name = "zeros";
+  chunks[0].pack(std::string(5000u, '\0'), ChunkCodec::LZ);
+  EXPECT_EQ(ChunkCodec::LZ, chunks[0].codec);
+  chunks[1].name = "short";
+  chunks[1].pack("abc", ChunkCodec::LZ);
+  EXPECT_EQ(ChunkCodec::NONE, chunks[1].codec) << "stored as is when it does not compress";
+  chunks[2].name = "";
+  chunks[2].pack("", ChunkCodec::NONE);
+
+  writeChunkFile(path, chunks);
+  const auto loaded = readChunkFile(path);
+  ASSERT_EQ(3u, loaded.size());
+  EXPECT_EQ("zeros", loaded[0].name);
+  EXPECT_EQ(std::string(5000u, '\0'), loaded[0].unpack());
+  EXPECT_EQ("abc", loaded[1].unpack());
+  EXPECT_EQ("", loaded[2].unpack());
+
+  EXPECT_ANY_THROW(readChunkFile("TestOutputDir/no_such.chunks"));
+  std::remove(path.c_str());
+}
+
+} // namespace testing
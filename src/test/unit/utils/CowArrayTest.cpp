@@ -0,0 +1,75 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "htm/types/Types.hpp"
+#include "htm/utils/CowArray.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+TEST(CowArray, Basics) {
+  CowArray<UInt32> a;
+  EXPECT_TRUE(a.empty());
+  const size_t n = 3u * CowArray<UInt32>::CHUNK_SIZE + 5u;
+  for(size_t i = 0u; i < n; i++) a.push_back(static_cast<UInt32>(i));
+  ASSERT_EQ(a.size(), n);
+  for(size_t i = 0u; i < n; i++) ASSERT_EQ(a[i], i);
+  EXPECT_EQ(a.back(), n - 1u);
+
+  a.resize(10u);
+  EXPECT_EQ(a.size(), 10u);
+  a.resize(20u, 7u);
+  EXPECT_EQ(a[9], 9u);
+  EXPECT_EQ(a[19], 7u);
+
+  std::vector<UInt32> values(n, 3u);
+  a.assign(values.data(), values.data() + values.size());
+  std::vector<UInt32> pieces;
+  a.forEachChunk([&](const UInt32 *chunk, size_t count) { pieces.insert(pieces.end(), chunk, chunk + count); });
+  EXPECT_EQ(pieces, values);
+}
+
+TEST(CowArray, CopyOnWrite) {
+  CowArray<UInt16> parent;
+  parent.resize(4u * CowArray<UInt16>::CHUNK_SIZE, 1u);
+  EXPECT_EQ(parent.numSharedChunks(), 0u);
+
+  CowArray<UInt16> child(parent);
+  EXPECT_EQ(child.numSharedChunks(), 4u);
+  EXPECT_EQ(child, parent);
+  EXPECT_LT(child.memoryUsage() + parent.memoryUsage(), 5u * CowArray<UInt16>::CHUNK_SIZE * sizeof(UInt16))
+    << "the copy costs (almost) nothing";
+
+  child.ref(CowArray<UInt16>::CHUNK_SIZE + 1u) = 2u;
+  EXPECT_EQ(child.numSharedChunks(), 3u) << "only the written chunk is copied";
+  EXPECT_EQ(parent.numSharedChunks(), 3u);
+  EXPECT_EQ(parent[CowArray<UInt16>::CHUNK_SIZE + 1u], 1u) << "the parent does not see the change";
+  EXPECT_EQ(child[CowArray<UInt16>::CHUNK_SIZE + 1u], 2u);
+  EXPECT_NE(child, parent);
+
+  parent.unshare(0u);
+  child.push_back(5u); //new chunk, not shared
+  EXPECT_EQ(parent.numSharedChunks(), 2u);
+  EXPECT_EQ(child.numSharedChunks(), 2u);
+}
+
+} // namespace testing
@@ -0,0 +1,76 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include "htm/types/Types.hpp"
+#include "htm/utils/LatencyHistogram.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+TEST(LatencyHistogram, Empty) {
+  LatencyHistogram h;
+  EXPECT_EQ(h.getCount(), 0u);
+  EXPECT_EQ(h.percentile(0.5), 0.0);
+  EXPECT_EQ(h.percentile(0.99), 0.0);
+  EXPECT_ANY_THROW(h.percentile(1.5));
+}
+
+TEST(LatencyHistogram, Percentiles) {
+  LatencyHistogram h;
+  // 1us .. 100us
+  for (int i = 100; i >= 1; i--) {
+    h.add(i * 1.0e-6);
+  }
+  EXPECT_EQ(h.getCount(), 100u);
+  EXPECT_NEAR(h.getTotal(), 5050.0e-6, 1.0e-9);
+  EXPECT_DOUBLE_EQ(h.getMax(), 100.0e-6);
+
+  // within the 12.5% of a bucket, never below the exact value
+  EXPECT_GE(h.percentile(0.5), 50.0e-6 * 0.999);
+  EXPECT_LE(h.percentile(0.5), 50.0e-6 * 1.125);
+  EXPECT_GE(h.percentile(0.99), 99.0e-6 * 0.999);
+  EXPECT_LE(h.percentile(0.99), 100.0e-6);
+  EXPECT_DOUBLE_EQ(h.percentile(1.0), 100.0e-6);
+  EXPECT_LE(h.percentile(0.0), 1.0e-6 * 1.125);
+
+  h.reset();
+  EXPECT_EQ(h.getCount(), 0u);
+  EXPECT_EQ(h.getMax(), 0.0);
+}
+
+TEST(LatencyHistogram, ExactSmallValues) {
+  LatencyHistogram h;
+  h.add(3.0e-9);
+  h.add(-1.0); // clamped to 0
+  EXPECT_EQ(h.getCount(), 2u);
+  EXPECT_EQ(h.percentile(0.5), 0.0);
+  EXPECT_NEAR(h.percentile(1.0), 3.0e-9, 1.0e-12);
+}
+
+TEST(LatencyHistogram, toJSON) {
+  LatencyHistogram h;
+  h.add(0.5);
+  const std::string json = h.toJSON();
+  EXPECT_NE(json.find("\"count\": 1"), std::string::npos) << json;
+  EXPECT_NE(json.find("\"p99\""), std::string::npos) << json;
+  EXPECT_NE(json.find("\"max\": 0.5"), std::string::npos) << json;
+}
+
+} // namespace testing
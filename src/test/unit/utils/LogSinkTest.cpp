@@ -0,0 +1,81 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of LogSink test
+ */
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include <htm/utils/Log.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(LogSinkTest, Records) {
+  std::vector<LogRecord> records;
+  LogSink::setHandler([&records](const LogRecord &record) { records.push_back(record); });
+  const LogLevel level = NTA_LOG_LEVEL;
+  NTA_LOG_LEVEL = LogLevel::LogLevel_Normal;
+
+  NTA_WARN << "answer " << 42 << std::endl;
+  NTA_DEBUG << "not shown at the Normal level";
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_STREQ(records[0].severity, "WARN");
+  EXPECT_EQ(records[0].level, LogLevel::LogLevel_Normal);
+  EXPECT_EQ(records[0].message, "answer 42") << "without the trailing newline";
+  EXPECT_EQ(records[0].thread, std::this_thread::get_id());
+  EXPECT_EQ(LogSink::format(records[0]).find("WARN:\tLogSinkTest.cpp:"), 0u);
+
+  NTA_LOG_LEVEL = LogLevel::LogLevel_Verbose;
+  NTA_DEBUG << "shown";
+  EXPECT_EQ(records.size(), NTA_LOG_COMPILED_LEVEL >= 3 ? 2u : 1u);
+
+  NTA_LOG_LEVEL = level;
+  LogSink::setHandler(nullptr);
+}
+
+TEST(LogSinkTest, Async) {
+  std::vector<std::string> messages;
+  std::vector<std::thread::id> threads;
+  LogSink::setHandler([&](const LogRecord &record) {
+    messages.push_back(record.message);
+    threads.push_back(std::this_thread::get_id());
+  });
+  LogSink::setAsync(true);
+  EXPECT_TRUE(LogSink::isAsync());
+  for (int i = 0; i < 100; i++) {
+    LogMessage("WARN", LogLevel::LogLevel_Normal, __FILE__, __LINE__).stream() << i;
+  }
+  LogSink::flush();
+  ASSERT_EQ(messages.size(), 100u);
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(messages[i], std::to_string(i)) << "in order";
+  }
+  EXPECT_NE(threads[0], std::this_thread::get_id()) << "the handler runs in the background";
+
+  LogMessage("WARN", LogLevel::LogLevel_Normal, __FILE__, __LINE__).stream() << "last";
+  LogSink::setAsync(false);
+  EXPECT_FALSE(LogSink::isAsync());
+  EXPECT_EQ(messages.back(), "last") << "stopping drains the queue";
+  LogSink::setHandler(nullptr);
+}
+
+} // namespace testing
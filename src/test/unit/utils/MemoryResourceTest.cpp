@@ -0,0 +1,139 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <new>
+#include <vector>
+
+#include "htm/algorithms/Connections.hpp"
+#include "htm/utils/MemoryResource.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+// Counts the bytes allocated through it.
+class CountingResource : public MemoryResource {
+public:
+  size_t allocated = 0u;
+protected:
+  void *allocate_(size_t bytes, size_t alignment) override {
+    allocated += bytes;
+    return defaultResource()->allocate(bytes, alignment);
+  }
+  void deallocate_(void *p, size_t bytes, size_t alignment) override {
+    allocated -= bytes;
+    defaultResource()->deallocate(p, bytes, alignment);
+  }
+};
+
+TEST(MemoryResource, Monotonic) {
+  alignas(8) char buffer[64];
+  MonotonicResource arena(buffer, sizeof(buffer), nullptr);
+  {
+    ResourceVector<UInt32> v(&arena);
+    v.reserve(8u);
+    v.assign(8u, 7u);
+    EXPECT_GE(static_cast<void*>(v.data()), static_cast<void*>(buffer));
+    EXPECT_LT(static_cast<void*>(v.data()), static_cast<void*>(buffer + sizeof(buffer)));
+    EXPECT_EQ(arena.used(), 32u);
+
+    ResourceVector<Real64> d(&arena);
+    d.push_back(1.0);
+    EXPECT_EQ(reinterpret_cast<size_t>(d.data()) % alignof(Real64), 0u);
+    EXPECT_THROW(v.reserve(100u), std::bad_alloc) << "no upstream resource";
+  }
+  arena.release();
+  EXPECT_EQ(arena.used(), 0u);
+
+  // Full buffer falls back to the upstream resource.
+  CountingResource upstream;
+  MonotonicResource overflow(buffer, sizeof(buffer), &upstream);
+  ResourceVector<UInt32> v(&overflow);
+  v.reserve(100u);
+  EXPECT_EQ(upstream.allocated, 400u);
+  v = ResourceVector<UInt32>(&overflow);
+  EXPECT_EQ(upstream.allocated, 0u);
+}
+
+TEST(MemoryResource, Allocator) {
+  CountingResource a, b;
+  ResourceVector<int> x(&a);
+  x.assign(10u, 1);
+  EXPECT_EQ(a.allocated, 10u * sizeof(int));
+
+  ResourceVector<int> copy(x);
+  EXPECT_EQ(copy.get_allocator().resource(), &a) << "copies keep the resource";
+  ResourceVector<int> y(&b);
+  y = x;
+  EXPECT_EQ(y.get_allocator().resource(), &b) << "copy assignment keeps the resource of the target";
+  y = std::move(copy);
+  EXPECT_EQ(y.get_allocator().resource(), &a) << "move assignment takes the storage and its resource";
+  EXPECT_EQ(b.allocated, 0u);
+
+  EXPECT_EQ(ResourceVector<int>().get_allocator().resource(), MemoryResource::defaultResource());
+  EXPECT_TRUE(ResourceAllocator<int>() == ResourceAllocator<char>(nullptr));
+  EXPECT_FALSE(ResourceAllocator<int>(&a) == ResourceAllocator<int>(&b));
+}
+
+TEST(MemoryResource, Aligned) {
+  EXPECT_EQ(paddedBytes(0u), 0u);
+  EXPECT_EQ(paddedBytes(1u), SIMD_ALIGNMENT);
+  EXPECT_EQ(paddedBytes(SIMD_ALIGNMENT + 1u), 2u * SIMD_ALIGNMENT);
+
+  for(size_t bytes : {1u, 7u, 100u, 4096u}) {
+    void *p = alignedAllocate(bytes);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % SIMD_ALIGNMENT, 0u);
+    alignedDeallocate(p);
+  }
+  void *p = MemoryResource::defaultResource()->allocate(10u, 256u);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % 256u, 0u);
+  MemoryResource::defaultResource()->deallocate(p, 10u, 256u);
+
+  AlignedVector<float> x(3u, 1.0f);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(x.data()) % SIMD_ALIGNMENT, 0u);
+  EXPECT_EQ(AlignedAllocator<float>::paddedSize(3u), 16u);
+  EXPECT_EQ(AlignedAllocator<double>::paddedSize(9u), 16u);
+}
+
+TEST(MemoryResource, Connections) {
+  CountingResource resource;
+  Connections c(100u, 0.5f);
+  const auto segment = c.createSegment(0u);
+  c.createSynapse(segment, 10u, 0.6f);
+  c.setMemoryResource(&resource);
+  EXPECT_EQ(c.getMemoryResource(), &resource);
+  EXPECT_GT(resource.allocated, 0u) << "existing synapses are moved over";
+
+  for(CellIdx cell = 20u; cell < 80u; cell++) c.createSynapse(segment, cell, 0.4f);
+  const size_t allocated = resource.allocated;
+  EXPECT_GE(allocated, 61u * (2u * sizeof(CellIdx) + sizeof(Synapse) * 2u));
+  EXPECT_EQ(c.numSynapses(), 61u);
+  c.compact();
+  c.defragment();
+  EXPECT_EQ(c.getMemoryResource(), &resource);
+  const std::vector<CellIdx> active = {10u, 20u};
+  EXPECT_EQ(c.computeActivity(active, false)[segment], 1u);
+
+  c.setMemoryResource(nullptr);
+  EXPECT_EQ(resource.allocated, 0u);
+  EXPECT_EQ(c.numSynapses(), 61u);
+}
+
+} // namespace testing
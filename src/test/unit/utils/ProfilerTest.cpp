@@ -0,0 +1,75 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of Profiler test
+ */
+
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <htm/utils/Profiler.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+static const Profiler::Entry *find(const std::vector<Profiler::Entry> &entries, const std::string &name) {
+  for (const auto &entry : entries) {
+    if (entry.name == name) return &entry;
+  }
+  return nullptr;
+}
+
+TEST(ProfilerTest, SumsThreadsByName) {
+  Profiler::reset();
+  ProfileSection *main = Profiler::section("ProfilerTest.scope");
+  { ProfileScope scope(*main); }
+  std::thread worker([]() {
+    ProfileSection *section = Profiler::section("ProfilerTest.scope");
+    for (int i = 0; i < 2; i++) { ProfileScope scope(*section); }
+  });
+  worker.join();
+
+  const auto entries = Profiler::getEntries();
+  const auto entry = find(entries, "ProfilerTest.scope");
+  ASSERT_NE(entry, nullptr);
+  EXPECT_EQ(entry->calls, 3u) << "the counters outlive the thread";
+  EXPECT_GE(entry->seconds, 0.0);
+  EXPECT_NE(Profiler::toJSON().find("\"ProfilerTest.scope\": {\"calls\": 3"), std::string::npos);
+
+  Profiler::reset();
+  EXPECT_EQ(find(Profiler::getEntries(), "ProfilerTest.scope")->calls, 0u);
+}
+
+static void profiled() {
+  NTA_PROFILE_SCOPE("ProfilerTest.macro");
+}
+
+TEST(ProfilerTest, Macro) {
+  Profiler::reset();
+  for (int i = 0; i < 5; i++) profiled();
+  const auto entry = find(Profiler::getEntries(), "ProfilerTest.macro");
+  if (Profiler::isEnabled()) {
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->calls, 5u);
+  } else {
+    EXPECT_EQ(entry, nullptr) << "compiled out";
+  }
+}
+
+} // namespace testing
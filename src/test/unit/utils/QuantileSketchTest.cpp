@@ -0,0 +1,100 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for QuantileSketch
+ */
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+#include <htm/utils/QuantileSketch.hpp>
+#include <htm/utils/Random.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+TEST(QuantileSketchTest, Empty) {
+  QuantileSketch sketch;
+  EXPECT_EQ(sketch.getCount(), 0u);
+  EXPECT_EQ(sketch.numRetained(), 0u);
+  EXPECT_EQ(sketch.cdf(1.0f), 0.0);
+  EXPECT_EQ(sketch.quantile(0.5), 0.0f);
+  EXPECT_ANY_THROW(QuantileSketch(4u));
+}
+
+TEST(QuantileSketchTest, Exact) {
+  // Below the capacity the sketch keeps every value.
+  QuantileSketch sketch;
+  for(UInt i = 1u; i <= 100u; i++) sketch.update(static_cast<Real>(i));
+  EXPECT_EQ(sketch.getCount(), 100u);
+  EXPECT_EQ(sketch.numRetained(), 100u);
+  EXPECT_DOUBLE_EQ(sketch.cdf(50.0f), 0.5);
+  EXPECT_DOUBLE_EQ(sketch.cdf(0.0f), 0.0);
+  EXPECT_DOUBLE_EQ(sketch.cdf(100.0f), 1.0);
+  EXPECT_EQ(sketch.quantile(0.5), 50.0f);
+  EXPECT_EQ(sketch.quantile(1.0), 100.0f);
+  EXPECT_ANY_THROW(sketch.quantile(1.5));
+}
+
+TEST(QuantileSketchTest, Accuracy) {
+  QuantileSketch sketch(200u);
+  Random rng(42);
+  const UInt n = 100000u;
+  for(UInt i = 0u; i < n; i++) sketch.update(static_cast<Real>(rng.getReal64()));
+  EXPECT_EQ(sketch.getCount(), n);
+  EXPECT_LT(sketch.numRetained(), 1000u);
+  for(const Real x : {0.01f, 0.1f, 0.5f, 0.9f, 0.99f}) {
+    EXPECT_NEAR(sketch.cdf(x), x, 0.02) << x;
+    EXPECT_NEAR(sketch.quantile(x), x, 0.02) << x;
+  }
+}
+
+TEST(QuantileSketchTest, Merge) {
+  QuantileSketch low, high, all;
+  Random rng(1);
+  for(UInt i = 0u; i < 20000u; i++) {
+    const Real x = static_cast<Real>(rng.getReal64());
+    (i % 2u ? low : high).update(x / 2.0f + (i % 2u ? 0.0f : 0.5f));
+  }
+  all.merge(low);
+  all.merge(high);
+  EXPECT_EQ(all.getCount(), 20000u);
+  EXPECT_LT(all.numRetained(), 1000u);
+  EXPECT_NEAR(all.cdf(0.5f), 0.5, 0.02);
+  EXPECT_NEAR(all.quantile(0.25), 0.25f, 0.02f);
+
+  QuantileSketch other(100u);
+  EXPECT_ANY_THROW(all.merge(other));
+}
+
+TEST(QuantileSketchTest, Serialization) {
+  QuantileSketch a;
+  Random rng(7);
+  for(UInt i = 0u; i < 5000u; i++) a.update(static_cast<Real>(rng.getReal64()));
+  std::stringstream ss;
+  a.save(ss);
+  QuantileSketch b;
+  b.load(ss);
+  EXPECT_EQ(a, b);
+  a.clear();
+  EXPECT_EQ(a.getCount(), 0u);
+  EXPECT_NE(a, b);
+}
+
+} // namespace testing
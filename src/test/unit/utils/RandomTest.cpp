@@ -24,6 +24,7 @@
 #include <htm/os/Env.hpp>
 #include <htm/utils/Log.hpp>
 #include <htm/os/Timer.hpp>
+#include <htm/utils/ThreadPool.hpp>
 
 #include <fstream>
 #include <sstream>
@@ -141,6 +142,24 @@ TEST(RandomTest, testSerialization) { // test serialization/deserialization usin
 }
 
 
+TEST(RandomTest, testLoadLegacyArchive) { // archive from before split(), see src/test/data/README.md
+  std::ifstream in(std::string(HTM_TEST_DATA_DIR) + "/Random.v1.bin", std::ios_base::binary);
+  ASSERT_TRUE(in.good());
+  Random r;
+  r.load(in);
+  EXPECT_EQ(r.getSeed(), 42u);
+
+  Random expected(42); // the legacy archive was saved after 5 steps
+  for (int i = 0; i < 5; i++) expected.getUInt32();
+  EXPECT_EQ(r, expected);
+
+  // The values the old release drew next.
+  for (const UInt32 next : {3348747335u, 2571218620u, 2563451924u, 670094950u, 1914837113u}) {
+    EXPECT_EQ(r.getUInt32(), next);
+  }
+}
+
+
 TEST(RandomTest, ReturnInCorrectRange) {
   // make sure that we are returning values in the correct range
   // @todo perform statistical tests
@@ -232,6 +251,87 @@ TEST(RandomTest, Sampling) {
 }
 
 
+TEST(RandomTest, SampleIntoBuffer) {
+  vector<UInt> population(1000u);
+  for(UInt i = 0; i < population.size(); i++) population[i] = 3u * i;
+  const vector<UInt> original(population);
+
+  // one draw per choice, the population is not modified
+  Random r1(5), r2(5), r3(5);
+  vector<UInt> output = { 42u, 43u };
+  r1.sample(population, 10u, output);
+  ASSERT_EQ(10u, output.size());
+  ASSERT_EQ(original, population);
+  for(int i = 0; i < 10; i++) r3.getUInt32();
+  ASSERT_EQ(r1, r3);
+
+  // same as the in-place partial shuffle
+  vector<UInt> shuffled(population);
+  r2.partialShuffle(shuffled.begin(), shuffled.end(), 10u);
+  ASSERT_EQ(output, vector<UInt>(shuffled.begin(), shuffled.begin() + 10));
+  ASSERT_EQ(r1, r2);
+
+  // distinct elements of the population
+  Random r(17);
+  r.sample(population, 1000u, output);
+  std::sort(output.begin(), output.end());
+  ASSERT_EQ(original, output);
+  r.sample(population, 0u, output);
+  ASSERT_TRUE(output.empty());
+
+  // uniform frequency of each element
+  vector<UInt> counts(20u, 0u);
+  const vector<UInt> small = { 0u, 1u, 2u, 3u, 4u, 5u, 6u, 7u, 8u, 9u,
+                               10u, 11u, 12u, 13u, 14u, 15u, 16u, 17u, 18u, 19u };
+  for(int i = 0; i < 20000; i++) {
+    r.sample(small, 3u, output);
+    for(const auto c : output) counts[c]++;
+  }
+  for(const auto count : counts) {
+    ASSERT_NEAR(3000.0, count, 200.0);
+  }
+
+  EXPECT_THROW(r.sample(small, 21u, output), Exception) << "checking for exception from population too small";
+  EXPECT_THROW(r.partialShuffle(shuffled.begin(), shuffled.begin() + 4, 5u), Exception);
+}
+
+
+TEST(RandomTest, SampleIndices) {
+  Random r(17);
+  // both the sparse (hash set) and the dense (bitmap) selection
+  for(const UInt population : {10000u, 100u}) {
+    for(const UInt n : {0u, 1u, 7u, 50u}) {
+      const auto choices = r.sampleIndices(population, n);
+      ASSERT_EQ(n, choices.size());
+      for(size_t i = 0; i < choices.size(); i++) {
+        ASSERT_LT(choices[i], population);
+        if( i > 0 ) ASSERT_LT(choices[i - 1], choices[i]) << "sorted, no duplicates";
+      }
+    }
+  }
+  const auto all = r.sampleIndices(5u, 5u);
+  ASSERT_EQ(vector<UInt>({0u, 1u, 2u, 3u, 4u}), all);
+
+  // deterministic, one draw per choice
+  Random r1(5), r2(5);
+  ASSERT_EQ(r1.sampleIndices(1000u, 10u), r2.sampleIndices(1000u, 10u));
+  Random r3(5);
+  for(int i = 0; i < 10; i++) r3.getUInt32();
+  ASSERT_EQ(r1, r3);
+
+  // uniform frequency of each value
+  vector<UInt> counts(20u, 0u);
+  for(int i = 0; i < 20000; i++) {
+    for(const auto c : r.sampleIndices(20u, 3u)) counts[c]++;
+  }
+  for(const auto count : counts) {
+    ASSERT_NEAR(3000.0, count, 200.0);
+  }
+
+  EXPECT_THROW(r.sampleIndices(4u, 5u), Exception) << "checking for exception from population too small";
+}
+
+
 TEST(RandomTest, Shuffling) {
   // tests for shuffling
   Random r(1);
@@ -265,6 +365,79 @@ TEST(RandomTest, testEqualsOperator) {
 }
 
 
+TEST(RandomTest, Split) {
+  Random r(42);
+  Random s1 = r.split(3u);
+  // Philox4x32-10 with key 42 and counter { 0, 0, 3, 0 }
+  EXPECT_EQ(173123250u,  s1.getUInt32());
+  EXPECT_EQ(1913948817u, s1.getUInt32());
+  EXPECT_EQ(3105408601u, s1.getUInt32());
+  EXPECT_EQ(2569034695u, s1.getUInt32());
+  EXPECT_EQ(r, Random(42)) << "splitting does not advance the generator";
+
+  // The substream does not depend on the state of the generator.
+  for(int i = 0; i < 100; i++) r.getUInt32();
+  Random s2 = r.split(3u);
+  Random s3 = Random(42).split(3u);
+  ASSERT_EQ(s2, s3);
+  for(int i = 0; i < 1000; i++) {
+    ASSERT_EQ(s2.getUInt32(), s3.getUInt32());
+  }
+  ASSERT_NE(s2, Random(42).split(3u)) << "different steps";
+  ASSERT_NE(Random(42).split(3u), Random(42).split(4u));
+  ASSERT_NE(Random(42).split(3u), Random(43).split(3u));
+  ASSERT_NE(Random(42).split(3u).split(0u), Random(42).split(3u));
+  ASSERT_EQ(Random(42).split(3u).split(5u), Random(42).split(3u).split(5u));
+
+  // Uniform, and the substreams are not correlated.
+  Random a = Random(7).split(0u), b = Random(7).split(1u);
+  Real64 meanA = 0.0, meanAB = 0.0;
+  const int N = 100000;
+  for(int i = 0; i < N; i++) {
+    const Real64 x = a.getReal64(), y = b.getReal64();
+    meanA  += x;
+    meanAB += x * y;
+  }
+  EXPECT_NEAR(0.5,  meanA / N, 0.01);
+  EXPECT_NEAR(0.25, meanAB / N, 0.01);
+
+  // serialization, in the middle of a block of 4 values
+  Random s4 = Random(42).split(9u);
+  for(int i = 0; i < 6; i++) s4.getUInt32();
+  std::stringstream ss;
+  s4.save(ss);
+  Random s5;
+  s5.load(ss);
+  ASSERT_EQ(s4, s5);
+  for(int i = 0; i < 10; i++) {
+    ASSERT_EQ(s4.getUInt32(), s5.getUInt32()) << "load from serialization";
+  }
+}
+
+
+TEST(RandomTest, SplitSameForAnyNumberOfThreads) {
+  // Each item draws from its own substream, so the result does not depend on
+  // which thread runs it.
+  const Random rng(1234);
+  const size_t n = 1000u;
+  const auto draw = [&](size_t numThreads) {
+    vector<UInt32> values(n);
+    ThreadPool pool(numThreads);
+    pool.parallelFor(n, [&](size_t begin, size_t end, size_t) {
+      for(size_t i = begin; i < end; i++) {
+        Random local = rng.split(i);
+        local.getUInt32();
+        values[i] = local.getUInt32(1000u);
+      }
+    });
+    return values;
+  };
+  const auto serial = draw(1u);
+  EXPECT_EQ(serial, draw(2u));
+  EXPECT_EQ(serial, draw(7u));
+}
+
+
 TEST(RandomTest, testGetUIntSpeed) {
  Random r1(42);
  UInt32 rnd;
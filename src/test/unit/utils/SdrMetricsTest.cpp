@@ -18,6 +18,7 @@
 #include <gtest/gtest.h>
 #include <htm/types/Sdr.hpp>
 #include <htm/utils/SdrMetrics.hpp>
+#include <algorithm>
 #include <vector>
 #include <random>
 
@@ -236,6 +237,49 @@ TEST(SdrMetricsTest, TestAF_Example) {
     ASSERT_NEAR( F.entropy(), 0.9182958340544896f, 0.001f );
 }
 
+/*
+ * ActivationFrequency
+ * Verify that the lazy decay matches decaying every bit at every sample.
+ */
+TEST(SdrMetricsTest, TestAF_LazyDecay) {
+    const auto size   = 500u;
+    const auto period = 100u;
+    SDR A({ size });
+    ActivationFrequency F( A, period );
+    SDR B({ size });
+    ActivationFrequency G( B, period, 0.05f );
+    vector<Real64> expectF( size );
+    vector<Real64> expectG( size, 0.05 );
+
+    Random rng( 42u );
+    for(auto i = 1u; i <= 3000u; i++) {
+        A.randomize( i < 1000u ? 0.02f : 0.10f, rng );
+        B.setSDR( A );
+        const Real64 alphaF = 1.0 / std::min( period, i );
+        const Real64 alphaG = 1.0 / period;
+        for(auto idx = 0u; idx < size; idx++) {
+            expectF[idx] *= 1.0 - alphaF;
+            expectG[idx] *= 1.0 - alphaG;
+        }
+        for(const auto idx : A.getSparse()) {
+            expectF[idx] += alphaF;
+            expectG[idx] += alphaG;
+        }
+        if( i % 500u != 0u )
+            continue;
+        Real64 sum = 0.0;
+        for(auto idx = 0u; idx < size; idx++) {
+            ASSERT_NEAR( F.activationFrequency[idx], expectF[idx], 1e-5 );
+            ASSERT_NEAR( G.activationFrequency[idx], expectG[idx], 1e-5 );
+            sum += expectF[idx];
+        }
+        ASSERT_NEAR( F.mean(), sum / size, 1e-5 );
+        const vector<Real> &frequencies = F.activationFrequency;
+        ASSERT_EQ( F.min(), *std::min_element( frequencies.begin(), frequencies.end() ));
+        ASSERT_EQ( F.max(), *std::max_element( frequencies.begin(), frequencies.end() ));
+    }
+}
+
 /*
  * ActivationFrequency
  * Verify that the longer run values of this metric are OK.
@@ -557,4 +601,73 @@ TEST(SdrMetricsTest, TestAddData) {
     ASSERT_NEAR( M.overlap.mean(),  0.5f, 0.01f );
     ASSERT_NEAR( M.activationFrequency.mean(), 0.2f, 0.01f );
 }
+
+/**
+ * Test that setSampleRate() measures one out of every N data.
+ */
+TEST(SdrMetricsTest, TestSampleRate) {
+    SDR A({ 100u });
+    Sparsity S( A, 1000u );
+    ASSERT_ANY_THROW( S.setSampleRate( 0u ));
+    S.setSampleRate( 3u );
+    ASSERT_EQ( S.getSampleRate(), 3u );
+    for(auto i = 0u; i < 9u; i++)
+        A.randomize( i % 3u == 0u ? 0.10f : 0.50f );
+    ASSERT_EQ( S.samples, 3u );
+    ASSERT_FLOAT_EQ( S.max(), 0.10f );
+
+    Metrics M( A, 1000u );
+    M.setSampleRate( 2u );
+    for(auto i = 0u; i < 10u; i++)
+        A.randomize( 0.10f );
+    ASSERT_EQ( M.sparsity.samples, 5u );
+    ASSERT_EQ( M.activationFrequency.samples, 5u );
+}
+
+/**
+ * Test that the asynchronous metrics measure the same as the synchronous.
+ */
+TEST(SdrMetricsTest, TestAsync) {
+    SDR A({ 1000u });
+    Metrics sync( A, 100u );
+    Metrics async( A, 100u );
+    async.setAsync( true, 10000u );
+    ASSERT_TRUE( async.isAsync() );
+    ActivationFrequency F( A, 100u );
+    F.setAsync( true, 10000u );
+
+    Random rng( 7u );
+    for(auto i = 0u; i < 1000u; i++) {
+        A.randomize( 0.05f, rng );
+        if( i == 500u ) {
+            async.reset();
+            sync.reset();
+        }
+    }
+    async.flush();
+    F.flush();
+    ASSERT_EQ( async.getDropped(), 0u );
+    ASSERT_EQ( async.activationFrequency.samples, 1000u );
+    ASSERT_EQ( sync.sparsity.mean(),              async.sparsity.mean() );
+    ASSERT_EQ( sync.overlap.mean(),               async.overlap.mean() );
+    ASSERT_EQ( sync.activationFrequency.entropy(), async.activationFrequency.entropy() );
+    ASSERT_EQ( sync.activationFrequency.entropy(), F.entropy() );
+    const vector<Real> &frequencies = F.activationFrequency;
+    ASSERT_EQ( async.activationFrequency.activationFrequency, frequencies );
+
+    // A full queue drops the data, instead of blocking.
+    Sparsity S( A, 100u );
+    S.setAsync( true, 1u );
+    for(auto i = 0u; i < 100u; i++)
+        A.randomize( 0.05f, rng );
+    S.flush();
+    ASSERT_EQ( S.samples + S.getDropped(), 100u );
+
+    // Back to synchronous.
+    S.setAsync( false );
+    ASSERT_FALSE( S.isAsync() );
+    const auto samples = S.samples;
+    A.randomize( 0.05f, rng );
+    ASSERT_EQ( S.samples, samples + 1u );
+}
 }
@@ -0,0 +1,135 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+/** @file
+ * Implementation of unit tests for SequenceGenerator
+ */
+
+#include <gtest/gtest.h>
+#include <htm/utils/SequenceGenerator.hpp>
+
+namespace testing {
+
+using namespace htm;
+
+static SequenceGeneratorParameters parameters() {
+  SequenceGeneratorParameters p;
+  p.dimensions     = {1000u};
+  p.sparsity       = 0.02f;
+  p.alphabetSize   = 1000u;
+  p.numSequences   = 5u;
+  p.sequenceLength = 8u;
+  return p;
+}
+
+TEST(SequenceGeneratorTest, Repetition) {
+  const auto p = parameters();
+  SequenceGenerator gen(p);
+  SDR sdr(p.dimensions);
+  for (UInt i = 0u; i < 10u * p.sequenceLength; i++) {
+    EXPECT_EQ(gen.next(sdr), i % p.sequenceLength == 0u) << "a reset starts each sequence";
+    ASSERT_GE(gen.getSequenceIndex(), 0);
+    EXPECT_EQ(gen.getPosition(), i % p.sequenceLength);
+    const UInt symbol = gen.getSequence(static_cast<UInt>(gen.getSequenceIndex()))[gen.getPosition()];
+    EXPECT_EQ(gen.getSymbolIndex(), symbol);
+    EXPECT_EQ(sdr, gen.getSymbol(symbol));
+    EXPECT_EQ(sdr.getSum(), 20u);
+  }
+}
+
+TEST(SequenceGeneratorTest, Deterministic) {
+  auto p = parameters();
+  p.branching  = 0.5f;
+  p.repetition = 0.5f;
+  p.noise      = 0.1f;
+  SequenceGenerator a(p), b(p);
+  std::vector<SDR> sdrsA, sdrsB;
+  std::vector<bool> resetsA, resetsB;
+  a.generate(100u, sdrsA, resetsA);
+  b.generate(100u, sdrsB, resetsB);
+  EXPECT_EQ(sdrsA, sdrsB);
+  EXPECT_EQ(resetsA, resetsB);
+  EXPECT_EQ(resetsA.size(), 100u);
+
+  p.seed++;
+  SequenceGenerator c(p);
+  std::vector<SDR> sdrsC;
+  c.generate(100u, sdrsC, resetsB);
+  EXPECT_NE(sdrsA, sdrsC);
+}
+
+TEST(SequenceGeneratorTest, Branching) {
+  auto p = parameters();
+  // Without branching the large alphabet makes distinct sequences.
+  SequenceGenerator distinct(p);
+  for (UInt s = 1u; s < p.numSequences; s++) {
+    for (UInt i = 1u; i < p.sequenceLength; i++)
+      EXPECT_NE(distinct.getSequence(s)[i], distinct.getSequence(0u)[i]);
+  }
+
+  // With it every element after the first continues an earlier sequence.
+  p.branching = 1.0f;
+  SequenceGenerator branched(p);
+  for (UInt s = 1u; s < p.numSequences; s++) {
+    for (UInt i = 1u; i < p.sequenceLength; i++) {
+      bool shared = false;
+      for (UInt earlier = 0u; earlier < s; earlier++)
+        shared = shared || branched.getSequence(earlier)[i] == branched.getSequence(s)[i];
+      EXPECT_TRUE(shared) << "sequence " << s << " element " << i;
+    }
+  }
+}
+
+TEST(SequenceGeneratorTest, RandomSequences) {
+  auto p = parameters();
+  p.repetition = 0.0f;
+  SequenceGenerator gen(p);
+  SDR sdr(p.dimensions);
+  for (UInt i = 0u; i < 3u * p.sequenceLength; i++) {
+    gen.next(sdr);
+    EXPECT_EQ(gen.getSequenceIndex(), -1);
+    EXPECT_EQ(sdr, gen.getSymbol(gen.getSymbolIndex()));
+  }
+}
+
+TEST(SequenceGeneratorTest, Noise) {
+  auto p = parameters();
+  p.noise = 0.25f;
+  SequenceGenerator gen(p);
+  SDR sdr(p.dimensions);
+  for (UInt i = 0u; i < 20u; i++) {
+    gen.next(sdr);
+    EXPECT_EQ(sdr.getSum(), 20u) << "noise keeps the sparsity";
+    EXPECT_EQ(sdr.getOverlap(gen.getSymbol(gen.getSymbolIndex())), 15u);
+  }
+}
+
+TEST(SequenceGeneratorTest, InvalidParameters) {
+  auto p = parameters();
+  p.dimensions.clear();
+  EXPECT_ANY_THROW(SequenceGenerator{p});
+  p = parameters();
+  p.branching = 1.5f;
+  EXPECT_ANY_THROW(SequenceGenerator{p});
+  p = parameters();
+  p.numSequences = 0u;
+  EXPECT_ANY_THROW(SequenceGenerator{p});
+  p.repetition = 0.0f;
+  EXPECT_NO_THROW(SequenceGenerator{p});
+}
+
+} // namespace testing
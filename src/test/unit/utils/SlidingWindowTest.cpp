@@ -3,7 +3,7 @@
 
 namespace testing { 
     
-using htm::util::SlidingWindow;
+using htm::SlidingWindow;
 
 
 TEST(SlidingWindow, Instance)
@@ -12,13 +12,13 @@ TEST(SlidingWindow, Instance)
   const std::vector<int> iv{1,2,3};
   const SlidingWindow<int> w2{3, std::begin(iv), std::end(iv)};
 
-    ASSERT_EQ(w.size(), 0);
+    ASSERT_EQ(w.size(), 0u);
     ASSERT_EQ(w.ID, "test");
     ASSERT_EQ(w.DEBUG, 1);
-    ASSERT_EQ(w2.size(), 3);
+    ASSERT_EQ(w2.size(), 3u);
     ASSERT_TRUE(w.maxCapacity == w2.maxCapacity ); // ==3
     w.append(4);
-    ASSERT_EQ(w.size(), 1);
+    ASSERT_EQ(w.size(), 1u);
     ASSERT_EQ(w.getData(), w.getLinearizedData());
     w.append(1);
     ASSERT_EQ(w[1], w2[0]); //==1
@@ -31,4 +31,51 @@ TEST(SlidingWindow, Instance)
     ASSERT_EQ(w, w2);
     ASSERT_NE(w.getData(), w2.getData()); // linearized data are same, but internal buffer representations are not
 }
-}
\ No newline at end of file
+
+
+TEST(SlidingWindow, Spans)
+{
+  SlidingWindow<int> w{4};
+  auto spans = w.getSpans();
+  ASSERT_EQ(spans.first.size() + spans.second.size(), 0u);
+
+  for(int i = 1; i <= 6; i++) {
+    w.append(i);
+    spans = w.getSpans();
+    // the spans are the window in order, without copies
+    std::vector<int> ordered(spans.first.begin(), spans.first.end());
+    ordered.insert(ordered.end(), spans.second.begin(), spans.second.end());
+    ASSERT_EQ(ordered, w.getLinearizedData());
+    ASSERT_EQ(spans.first.size() + spans.second.size(), w.size());
+  }
+  // |5,6;3,4| => (|3,4|, |5,6|)
+  ASSERT_EQ(spans.first.size(), 2u);
+  ASSERT_EQ(spans.first[0], 3);
+  ASSERT_EQ(spans.second[1], 6);
+}
+
+
+TEST(SlidingWindow, RunningSums)
+{
+  SlidingWindow<htm::Real> w{3};
+  ASSERT_EQ(w.sum(), 0.0);
+  ASSERT_EQ(w.mean(), 0.0);
+  ASSERT_EQ(w.variance(), 0.0);
+
+  const std::vector<htm::Real> values{1.0f, 2.0f, 3.0f, 10.0f, -4.0f, 0.5f};
+  for(size_t i = 0; i < values.size(); i++) {
+    w.append(values[i]);
+    htm::Real64 sum = 0.0, sumSquares = 0.0;
+    for(const auto v : w.getLinearizedData()) {
+      sum += v;
+      sumSquares += v * v;
+    }
+    const htm::Real64 n = static_cast<htm::Real64>(w.size());
+    ASSERT_NEAR(w.sum(), sum, 1e-9);
+    ASSERT_NEAR(w.sumOfSquares(), sumSquares, 1e-9);
+    ASSERT_NEAR(w.mean(), sum / n, 1e-9);
+    ASSERT_NEAR(w.variance(), sumSquares / n - (sum / n) * (sum / n), 1e-9);
+  }
+  ASSERT_NEAR(w.sum(), 6.5, 1e-9); // 10 - 4 + 0.5
+}
+}
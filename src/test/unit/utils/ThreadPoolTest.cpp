@@ -0,0 +1,113 @@
+/* ---------------------------------------------------------------------
+ * HTM Community Edition of NuPIC
+ * Copyright (C) 2020, Numenta, Inc.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero Public License version 3 as
+ * published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Affero Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero Public License
+ * along with this program.  If not, see http://www.gnu.org/licenses.
+ * --------------------------------------------------------------------- */
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "htm/utils/ThreadPool.hpp"
+
+namespace testing {
+
+using namespace htm;
+
+TEST(ThreadPoolTest, Submit) {
+  ThreadPool pool(2);
+  ASSERT_EQ(pool.size(), 2u);
+  std::atomic<int> sum(0);
+  std::vector<std::future<void>> futures;
+  for(int i = 1; i <= 100; i++) {
+    futures.push_back(pool.submit([&sum, i]() { sum += i; }));
+  }
+  for(auto &f : futures) f.get();
+  ASSERT_EQ(sum, 5050);
+}
+
+TEST(ThreadPoolTest, DefaultSize) {
+  ThreadPool pool(0);
+  ASSERT_GE(pool.size(), 1u) << "0 means hardware concurrency";
+}
+
+TEST(ThreadPoolTest, ParallelForCoversRange) {
+  ThreadPool pool(3);
+  std::vector<int> hits(1001, 0);
+  std::vector<int> chunkUsed(pool.numChunks(hits.size()), 0);
+  ASSERT_EQ(chunkUsed.size(), 4u);
+  pool.parallelFor(hits.size(), [&](size_t begin, size_t end, size_t chunk) {
+    chunkUsed[chunk]++;
+    for(size_t i = begin; i < end; i++) hits[i]++;
+  });
+  for(const auto h : hits) ASSERT_EQ(h, 1);
+  for(const auto c : chunkUsed) ASSERT_EQ(c, 1);
+
+  // fewer items than threads
+  std::vector<int> few(2, 0);
+  pool.parallelFor(few.size(), [&](size_t begin, size_t end, size_t) {
+    for(size_t i = begin; i < end; i++) few[i]++;
+  });
+  ASSERT_EQ(few, std::vector<int>({1, 1}));
+  pool.parallelFor(0u, [&](size_t, size_t, size_t) { FAIL(); });
+}
+
+TEST(ThreadPoolTest, NestedParallelFor) {
+  ThreadPool pool(2);
+  std::atomic<size_t> total(0);
+  pool.parallelFor(8u, [&](size_t begin, size_t end, size_t) {
+    for(size_t i = begin; i < end; i++) {
+      pool.parallelFor(100u, [&](size_t b, size_t e, size_t) { total += e - b; });
+    }
+  });
+  ASSERT_EQ(total, 800u);
+}
+
+TEST(ThreadPoolTest, Exceptions) {
+  ThreadPool pool(2);
+  auto f = pool.submit([]() { throw std::runtime_error("task failed"); });
+  EXPECT_THROW(f.get(), std::runtime_error);
+  EXPECT_THROW(pool.parallelFor(10u, [](size_t begin, size_t, size_t) {
+    if(begin > 0u) throw std::runtime_error("chunk failed");
+  }), std::runtime_error);
+}
+
+TEST(ThreadPoolTest, ExceptionInCallingThread) {
+  ThreadPool pool(3);
+  std::atomic<int> done(0);
+  // Chunk 0 runs on the calling thread, the other chunks must still complete
+  // before parallelFor rethrows.
+  EXPECT_THROW(pool.parallelFor(4u, [&done](size_t, size_t, size_t chunk) {
+    if(chunk == 0u) throw std::runtime_error("first chunk failed");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    done++;
+  }), std::runtime_error);
+  EXPECT_EQ(3, done.load());
+
+  try {
+    pool.parallelFor(4u, [](size_t, size_t, size_t chunk) {
+      throw std::runtime_error("chunk " + std::to_string(chunk));
+    });
+    FAIL();
+  } catch(const std::runtime_error &e) {
+    EXPECT_STREQ("chunk 0", e.what()) << "the first exception in chunk order";
+  }
+}
+
+} // namespace testing